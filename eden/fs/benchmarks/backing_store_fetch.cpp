@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <fmt/format.h>
+#include <folly/executors/QueuedImmediateExecutor.h>
+#include <folly/futures/Future.h>
+#include <gflags/gflags.h>
+#include <algorithm>
+#include "eden/fs/benchharness/Bench.h"
+#include "eden/fs/config/ReloadableConfig.h"
+#include "eden/fs/store/LocalStoreCachedBackingStore.h"
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/telemetry/NullStructuredLogger.h"
+#include "eden/fs/testharness/FakeBackingStore.h"
+
+DEFINE_uint64(latency_us, 50000, "Round trip of every batch of fetches");
+DEFINE_uint64(jitter_us, 5000, "Up to this much is added to each round trip");
+DEFINE_uint64(
+    bytes_per_second,
+    100 * 1024 * 1024,
+    "Bandwidth of the simulated link, 0 for unlimited");
+DEFINE_uint64(blobs, 1000, "Number of blobs fetched by every iteration");
+DEFINE_uint64(blob_size, 16 * 1024, "Size of each blob");
+
+namespace {
+
+using namespace facebook::eden;
+using Clock = std::chrono::steady_clock;
+
+/**
+ * An ObjectStore caching into a MemoryLocalStore in front of a
+ * FakeBackingStore simulating a remote server, like the ObjectStore of a
+ * mount in front of the importer.
+ */
+struct FetchPipeline {
+  explicit FetchPipeline(const FakeBackingStore::NetworkModel& model) {
+    auto rawEdenConfig = EdenConfig::createTestEdenConfig();
+    auto edenConfig = std::make_shared<ReloadableConfig>(
+        rawEdenConfig, ConfigReloadBehavior::NoReload);
+    auto localStore = std::make_shared<MemoryLocalStore>();
+    auto stats = std::make_shared<EdenStats>();
+    fakeBackingStore = std::make_shared<FakeBackingStore>();
+    objectStore = ObjectStore::create(
+        localStore,
+        std::make_shared<LocalStoreCachedBackingStore>(
+            fakeBackingStore, localStore, stats),
+        TreeCache::create(edenConfig),
+        stats,
+        &folly::QueuedImmediateExecutor::instance(),
+        std::make_shared<ProcessNameCache>(),
+        std::make_shared<NullStructuredLogger>(),
+        rawEdenConfig);
+
+    ids.reserve(FLAGS_blobs);
+    for (uint64_t i = 0; i < FLAGS_blobs; ++i) {
+      auto contents = fmt::format("{}\n", i);
+      contents.resize(std::max<size_t>(FLAGS_blob_size, contents.size()), 'x');
+      auto* blob = fakeBackingStore->putBlob(contents);
+      blob->setReady();
+      ids.push_back(blob->get().getHash());
+    }
+
+    fakeBackingStore->setNetworkModel(model);
+  }
+
+  std::shared_ptr<FakeBackingStore> fakeBackingStore;
+  std::shared_ptr<ObjectStore> objectStore;
+  std::vector<ObjectId> ids;
+};
+
+FakeBackingStore::NetworkModel getNetworkModel(
+    std::chrono::microseconds batchWindow) {
+  FakeBackingStore::NetworkModel model;
+  model.latency = std::chrono::microseconds(FLAGS_latency_us);
+  model.jitter = std::chrono::microseconds(FLAGS_jitter_us);
+  model.bytesPerSecond = FLAGS_bytes_per_second;
+  model.batchWindow = batchWindow;
+  return model;
+}
+
+/** The latency below which the given fraction of the sorted latencies are. */
+double percentile(const std::vector<Clock::duration>& sorted, double p) {
+  if (sorted.empty()) {
+    return 0.0;
+  }
+  auto index = std::min(
+      sorted.size() - 1, static_cast<size_t>(p * (sorted.size() - 1) + 0.5));
+  return std::chrono::duration<double, std::micro>{sorted[index]}.count();
+}
+
+/**
+ * Fetch every blob of a new pipeline for each iteration, keeping at most
+ * state.range(0) fetches in flight, with each batch of the simulated server
+ * open for state.range(1) microseconds.
+ *
+ * Reports the fetch throughput as items per second, and the latency of the
+ * individual fetches, in microseconds.
+ */
+void fetch_blobs(benchmark::State& state) {
+  auto concurrency = static_cast<size_t>(state.range(0));
+  auto model = getNetworkModel(std::chrono::microseconds{state.range(1)});
+  auto& context = ObjectFetchContext::getNullContext();
+  std::vector<Clock::duration> latencies;
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto pipeline = std::make_unique<FetchPipeline>(model);
+    state.ResumeTiming();
+
+    for (size_t begin = 0; begin < pipeline->ids.size(); begin += concurrency) {
+      auto end = std::min(begin + concurrency, pipeline->ids.size());
+      std::vector<folly::Future<Clock::duration>> fetches;
+      fetches.reserve(end - begin);
+      for (size_t i = begin; i < end; ++i) {
+        auto start = Clock::now();
+        fetches.push_back(
+            pipeline->objectStore->getBlob(pipeline->ids[i], context)
+                .thenValue([start](std::shared_ptr<const Blob>) {
+                  return Clock::now() - start;
+                }));
+      }
+      for (auto& result : folly::collectAll(std::move(fetches)).get()) {
+        latencies.push_back(result.value());
+      }
+    }
+
+    state.PauseTiming();
+    pipeline.reset();
+    state.ResumeTiming();
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  state.SetItemsProcessed(latencies.size());
+  state.SetBytesProcessed(latencies.size() * FLAGS_blob_size);
+  state.counters["p50_us"] = percentile(latencies, 0.5);
+  state.counters["p99_us"] = percentile(latencies, 0.99);
+  state.counters["max_us"] = percentile(latencies, 1.0);
+}
+
+void fetchArguments(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"concurrency", "batch_window_us"});
+  for (int64_t concurrency : {16, 256, 4096}) {
+    for (int64_t batchWindow : {0, 1000, 10000}) {
+      benchmark->Args({concurrency, batchWindow});
+    }
+  }
+  benchmark->Unit(benchmark::kMillisecond);
+  benchmark->UseRealTime();
+}
+
+BENCHMARK(fetch_blobs)->Apply(fetchArguments);
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
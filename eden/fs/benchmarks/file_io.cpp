@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/Exception.h>
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+#include <gflags/gflags.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "eden/fs/benchharness/Bench.h"
+
+// Measures sequential and random throughput at different request sizes and
+// thread counts. Run it against a file in an EdenFS mount to compare the
+// fuse:max-io-size, fuse:writeback-cache and fuse:async-dio settings, or the
+// nfs:iosize and nfs:max-inflight-requests ones for NFS mounts. Each thread
+// keeps one request in flight, so the thread count is the client's
+// concurrency.
+
+namespace {
+
+DEFINE_string(
+    filename,
+    "file_io.tmp",
+    "Path to which reads and writes should be issued");
+DEFINE_uint64(filesize, 64 * 1024 * 1024, "File size in bytes");
+DEFINE_bool(direct, false, "Open the file with O_DIRECT");
+
+struct TemporaryFile {
+  TemporaryFile()
+      : file{
+            FLAGS_filename,
+            O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC |
+                (FLAGS_direct ? O_DIRECT : 0)} {
+    folly::checkUnixError(ftruncate(file.fd(), FLAGS_filesize), "ftruncate");
+  }
+
+  ~TemporaryFile() {
+    folly::checkUnixError(::unlink(FLAGS_filename.c_str()));
+  }
+
+  folly::File file;
+};
+
+int getTemporaryFD() {
+  static TemporaryFile tf;
+  return tf.file.fd();
+}
+
+std::vector<char> makeBuffer(size_t size) {
+  // O_DIRECT needs a page aligned buffer, so over-allocate and use an
+  // aligned window; see alignedData().
+  return std::vector<char>(size + 4096, 'x');
+}
+
+char* alignedData(std::vector<char>& buf) {
+  auto addr = reinterpret_cast<uintptr_t>(buf.data());
+  return buf.data() + ((4096 - addr % 4096) % 4096);
+}
+
+void sequential_writes(benchmark::State& state) {
+  int fd = getTemporaryFD();
+  auto blockSize = static_cast<size_t>(state.range(0));
+  auto buf = makeBuffer(blockSize);
+  auto data = alignedData(buf);
+
+  off_t offset = 0;
+  for (auto _ : state) {
+    if (offset + blockSize > FLAGS_filesize) {
+      offset = 0;
+    }
+    folly::checkUnixError(pwrite(fd, data, blockSize, offset), "pwrite");
+    offset += blockSize;
+  }
+  state.SetBytesProcessed(state.iterations() * blockSize);
+}
+
+void sequential_reads(benchmark::State& state) {
+  int fd = getTemporaryFD();
+  auto blockSize = static_cast<size_t>(state.range(0));
+  auto buf = makeBuffer(blockSize);
+  auto data = alignedData(buf);
+
+  off_t offset = 0;
+  for (auto _ : state) {
+    if (offset + blockSize > FLAGS_filesize) {
+      offset = 0;
+    }
+    folly::checkUnixError(pread(fd, data, blockSize, offset), "pread");
+    offset += blockSize;
+  }
+  state.SetBytesProcessed(state.iterations() * blockSize);
+}
+
+/**
+ * Pregenerate block aligned offsets: std::uniform_int_distribution costs about
+ * as much CPU as the syscalls being measured.
+ */
+std::vector<off_t> makeRandomOffsets(size_t blockSize) {
+  auto blockCount = std::max<uint64_t>(FLAGS_filesize / blockSize, 1);
+  std::default_random_engine gen{std::random_device{}()};
+  std::uniform_int_distribution<uint64_t> rng{0, blockCount - 1};
+  std::vector<off_t> offsets(16 * 1024);
+  std::generate(offsets.begin(), offsets.end(), [&] {
+    return static_cast<off_t>(rng(gen) * blockSize);
+  });
+  return offsets;
+}
+
+void random_writes(benchmark::State& state) {
+  int fd = getTemporaryFD();
+  auto blockSize = static_cast<size_t>(state.range(0));
+  auto buf = makeBuffer(blockSize);
+  auto data = alignedData(buf);
+  auto offsets = makeRandomOffsets(blockSize);
+
+  size_t index = 0;
+  for (auto _ : state) {
+    auto offset = offsets[index++ % offsets.size()];
+    folly::checkUnixError(pwrite(fd, data, blockSize, offset), "pwrite");
+  }
+  state.SetBytesProcessed(state.iterations() * blockSize);
+}
+
+void random_reads(benchmark::State& state) {
+  int fd = getTemporaryFD();
+  auto blockSize = static_cast<size_t>(state.range(0));
+  auto buf = makeBuffer(blockSize);
+  auto data = alignedData(buf);
+  auto offsets = makeRandomOffsets(blockSize);
+
+  size_t index = 0;
+  for (auto _ : state) {
+    auto offset = offsets[index++ % offsets.size()];
+    folly::checkUnixError(pread(fd, data, blockSize, offset), "pread");
+  }
+  state.SetBytesProcessed(state.iterations() * blockSize);
+}
+
+// Request sizes from a page up to 4MiB, past the default nfs:iosize, and
+// enough threads to exceed the servicing thread count.
+void applyArguments(benchmark::internal::Benchmark* b) {
+  b->RangeMultiplier(4)->Range(4096, 4 * 1024 * 1024);
+  b->ThreadRange(1, 16);
+}
+
+BENCHMARK(sequential_writes)->Apply(applyArguments);
+BENCHMARK(sequential_reads)->Apply(applyArguments);
+BENCHMARK(random_writes)->Apply(applyArguments);
+BENCHMARK(random_reads)->Apply(applyArguments);
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -35,6 +35,32 @@ void immediate_future_exc(benchmark::State& state) {
   state.SetItemsProcessed(processed);
 }
 
+void immediate_future_completed_semi(benchmark::State& state) {
+  uint64_t total = 0;
+  for (auto _ : state) {
+    auto [promise, semiFut] = folly::makePromiseContract<uint64_t>();
+    ImmediateFuture<uint64_t> fut{std::move(semiFut)};
+    promise.setValue(1);
+    total += std::move(fut).thenValue([](uint64_t v) { return v + 1; }).get();
+  }
+  benchmark::DoNotOptimize(total);
+}
+
+void immediate_future_pending_chain(benchmark::State& state) {
+  uint64_t total = 0;
+  for (auto _ : state) {
+    auto [promise, semiFut] = folly::makePromiseContract<uint64_t>();
+    ImmediateFuture<uint64_t> fut{std::move(semiFut)};
+    for (int i = 0; i < 10; ++i) {
+      fut = std::move(fut).thenValue(
+          [](uint64_t v) -> ImmediateFuture<uint64_t> { return v + 1; });
+    }
+    promise.setValue(0);
+    total += std::move(fut).get();
+  }
+  benchmark::DoNotOptimize(total);
+}
+
 void folly_future(benchmark::State& state) {
   folly::Future<int> fut{0};
   for (auto _ : state) {
@@ -46,6 +72,8 @@ void folly_future(benchmark::State& state) {
 
 BENCHMARK(immediate_future);
 BENCHMARK(immediate_future_exc);
+BENCHMARK(immediate_future_completed_semi);
+BENCHMARK(immediate_future_pending_chain);
 BENCHMARK(folly_future);
 } // namespace
 
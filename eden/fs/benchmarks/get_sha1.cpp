@@ -19,6 +19,7 @@
 #include <boost/filesystem.hpp>
 
 #include <folly/File.h>
+#include <folly/FileUtil.h>
 #include <folly/container/Array.h>
 #include <folly/init/Init.h>
 #include <folly/io/async/AsyncSocket.h>
@@ -27,6 +28,7 @@
 #include <thrift/lib/cpp2/async/HeaderClientChannel.h>
 
 #include "eden/fs/benchharness/Bench.h"
+#include "eden/fs/model/Hash.h"
 #include "eden/fs/service/gen-cpp2/EdenService.h"
 
 using namespace facebook::eden;
@@ -39,8 +41,14 @@ DEFINE_string(
     "",
     "Way to get sha1s. Options are: "
     "\"thrift\" (query EdenFS's thrift interface), "
-    "\"filesystem\" (getxattr calls through the filesystem), or "
-    "\"both\" (try both and display separate results).");
+    "\"filesystem\" (getxattr calls through the filesystem), "
+    "\"local\" (read the files and hash them in this process), or "
+    "\"both\" (try thrift and filesystem and display separate results).");
+DEFINE_uint32(
+    batch,
+    1,
+    "The number of files to ask for in each getSHA1 call of the thrift "
+    "interface, which EdenFS hashes concurrently");
 
 bool shouldRecordThriftSamples(std::string& interface) {
   return interface == "both" || interface == "thrift";
@@ -50,12 +58,16 @@ bool shouldRecordFilesystemSamples(std::string& interface) {
   return interface == "both" || interface == "filesystem";
 }
 
+bool shouldRecordLocalSamples(std::string& interface) {
+  return interface == "local";
+}
+
 /**
  * Record a sample in `samples` of how long it takes to read a file's sha1 from
  * EdenFS's thrift interface.
  */
 void recordThriftSample(
-    std::string& file,
+    std::vector<std::string>& files,
     boost::filesystem::path& repo_path,
     std::unique_ptr<EdenServiceAsyncClient>& client,
     uint64_t& sample) {
@@ -63,23 +75,43 @@ void recordThriftSample(
   std::vector<SHA1Result> res;
   // see notes in recordFilesystemSample about these DoNotOptimize protecting
   // ordering here
-  benchmark::DoNotOptimize(file);
+  benchmark::DoNotOptimize(files);
   auto sync = SyncBehavior{};
-  client->sync_getSHA1(res, repo_path.native(), {file}, sync);
+  client->sync_getSHA1(res, repo_path.native(), files, sync);
   benchmark::DoNotOptimize(res);
   auto duration = std::chrono::nanoseconds(getTime() - start);
   sample =
       std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
 
-  if (UNLIKELY(res.empty())) {
-    throw std::runtime_error("No results!");
+  if (UNLIKELY(res.size() != files.size())) {
+    throw std::runtime_error("Wrong number of results!");
   }
-  if (UNLIKELY(
-          res.size() != 1 || res.at(0).getType() == SHA1Result::Type::error)) {
-    throw res.at(0).get_error();
+  for (auto& result : res) {
+    if (UNLIKELY(result.getType() == SHA1Result::Type::error)) {
+      throw result.get_error();
+    }
   }
 }
 
+/**
+ * Record a sample in `samples` of how long it takes to read a file and
+ * compute its sha1 in this process, which is the least EdenFS can do for a
+ * file that is not cached.
+ */
+void recordLocalSample(std::string& file, uint64_t& sample) {
+  std::string contents;
+  auto start = getTime();
+  benchmark::DoNotOptimize(file);
+  if (UNLIKELY(!folly::readFile(file.c_str(), contents))) {
+    throw std::system_error{std::error_code{errno, std::system_category()}};
+  }
+  auto sha1 = Hash20::sha1(contents);
+  benchmark::DoNotOptimize(sha1);
+  auto duration = std::chrono::nanoseconds(getTime() - start);
+  sample =
+      std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
 /**
  * Record a sample in `samples` of how long it takes to read a file's sha1 using
  * a call through the filesystem (getxattr).
@@ -140,6 +172,11 @@ void calculateStats(
 int main(int argc, char** argv) {
   folly::init(&argc, &argv);
 
+  if (!FLAGS_batch) {
+    std::cerr << "Must specify a nonzero batch size" << std::endl;
+    gflags::ShowUsageWithFlags(argv[0]);
+    return 1;
+  }
   if (!FLAGS_threads) {
     std::cerr << "Must specify nonzero number of threads" << std::endl;
     gflags::ShowUsageWithFlags(argv[0]);
@@ -189,7 +226,8 @@ int main(int argc, char** argv) {
     if (shouldRecordThriftSamples(FLAGS_interface)) {
       thrift_files.emplace_back(argv[i]);
     }
-    if (shouldRecordFilesystemSamples(FLAGS_interface)) {
+    if (shouldRecordFilesystemSamples(FLAGS_interface) ||
+        shouldRecordLocalSamples(FLAGS_interface)) {
       filesystem_files.emplace_back((repo_path / argv[i]).native());
     }
   }
@@ -204,12 +242,7 @@ int main(int argc, char** argv) {
   folly::test::Barrier gate{static_cast<unsigned>(nthreads)};
   std::vector<uint64_t> thrift_samples(nthreads * samples_per_thread);
   std::vector<uint64_t> filesystem_samples(nthreads * samples_per_thread);
-  // we are just going to do calculations based on the thrift_files size, so
-  // let's assert the assumption that they have the same size
-  XCHECK_EQ(
-      thrift_files.size(),
-      filesystem_files.size(),
-      "thrift and filesystem number of files must be the same");
+  const size_t nfiles = argc - 1;
   for (unsigned thread_number = 0; thread_number < nthreads; ++thread_number) {
     threads.emplace_back([thread_number,
                           &gate,
@@ -219,6 +252,7 @@ int main(int argc, char** argv) {
                           &filesystem_samples,
                           &thrift_files,
                           &filesystem_files,
+                          nfiles,
                           &interface = FLAGS_interface] {
       // The order of these variables matters, the client MUST be
       // destroyed before the event base because the client
@@ -235,22 +269,29 @@ int main(int argc, char** argv) {
         client = std::make_unique<EdenServiceAsyncClient>(std::move(channel));
       }
 
+      std::vector<std::string> batch;
       gate.wait();
       for (unsigned j = 0; j < samples_per_thread; ++j) {
-        auto files_index = j * thread_number % thrift_files.size();
+        auto files_index = j * thread_number % nfiles;
         auto samples_index = thread_number * samples_per_thread + j;
         if (shouldRecordThriftSamples(interface)) {
+          batch.clear();
+          for (unsigned k = 0; k < FLAGS_batch; ++k) {
+            batch.push_back(thrift_files[(files_index + k) % nfiles]);
+          }
           recordThriftSample(
-              thrift_files[files_index],
-              repo_path,
-              client,
-              thrift_samples[samples_index]);
+              batch, repo_path, client, thrift_samples[samples_index]);
         }
 
         if (shouldRecordFilesystemSamples(interface)) {
           recordFilesystemSample(
               filesystem_files[files_index], filesystem_samples[samples_index]);
         }
+
+        if (shouldRecordLocalSamples(interface)) {
+          recordLocalSample(
+              filesystem_files[files_index], filesystem_samples[samples_index]);
+        }
       }
     });
   }
@@ -271,5 +312,11 @@ int main(int argc, char** argv) {
     std::cout << std::endl;
   }
 
+  if (shouldRecordLocalSamples(FLAGS_interface)) {
+    std::cout << "Local Statistics: " << std::endl;
+    calculateStats(filesystem_samples, nthreads, samples_per_thread);
+    std::cout << std::endl;
+  }
+
   return 0;
 }
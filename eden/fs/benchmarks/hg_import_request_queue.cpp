@@ -52,6 +52,46 @@ void enqueue(benchmark::State& state) {
   }
 }
 
+/**
+ * Enqueue duplicates of already queued requests, each with a higher priority
+ * than the last, as happens when a prefetch is followed by reads of the same
+ * files.
+ */
+void enqueue_raising_priority(benchmark::State& state) {
+  auto rawEdenConfig = EdenConfig::createTestEdenConfig();
+  auto edenConfig = std::make_shared<ReloadableConfig>(
+      rawEdenConfig, ConfigReloadBehavior::NoReload);
+
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  constexpr size_t kQueued = 10000;
+  std::vector<HgProxyHash> proxyHashes;
+  proxyHashes.reserve(kQueued);
+  for (size_t i = 0; i < kQueued; i++) {
+    auto proxyHash = HgProxyHash{RelativePath{"some_blob"}, uniqueHash()};
+    auto hash = proxyHash.sha1();
+    queue.enqueueBlob(HgImportRequest::makeBlobImportRequest(
+        hash, proxyHash, ImportPriority{ImportPriorityKind::Low, 0}));
+    proxyHashes.push_back(std::move(proxyHash));
+  }
+
+  std::vector<std::shared_ptr<HgImportRequest>> requests;
+  requests.reserve(state.max_iterations);
+  for (size_t i = 0; i < state.max_iterations; i++) {
+    const auto& proxyHash = proxyHashes[i % kQueued];
+    requests.emplace_back(HgImportRequest::makeBlobImportRequest(
+        proxyHash.sha1(),
+        proxyHash,
+        ImportPriority{ImportPriorityKind::Low, i + 1}));
+  }
+
+  auto requestIter = requests.begin();
+  for (auto _ : state) {
+    auto& request = *requestIter++;
+    queue.enqueueBlob(std::move(request));
+  }
+}
+
 void dequeue(benchmark::State& state) {
   auto rawEdenConfig = EdenConfig::createTestEdenConfig();
   auto edenConfig = std::make_shared<ReloadableConfig>(
@@ -77,6 +117,11 @@ BENCHMARK(enqueue)
     ->Threads(16)
     ->Threads(32);
 
+BENCHMARK(enqueue_raising_priority)
+    ->Unit(benchmark::kNanosecond)
+    ->Threads(1)
+    ->Threads(8);
+
 BENCHMARK(dequeue)
     ->Unit(benchmark::kNanosecond)
     ->Threads(1)
@@ -0,0 +1,387 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <fmt/format.h>
+#include <folly/FileUtil.h>
+#include <folly/Random.h>
+#include <folly/String.h>
+#include <folly/futures/Future.h>
+#include <gflags/gflags.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <random>
+#include <thread>
+#include "eden/fs/benchharness/Bench.h"
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/store/KeySpace.h"
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/PackLocalStore.h"
+#include "eden/fs/store/RocksDbLocalStore.h"
+#include "eden/fs/store/SqliteLocalStore.h"
+#include "eden/fs/store/StoreResult.h"
+#include "eden/fs/telemetry/NullStructuredLogger.h"
+#include "eden/fs/testharness/TempFile.h"
+#include "eden/fs/utils/FaultInjector.h"
+
+DEFINE_string(
+    storePath,
+    "",
+    "Directory where the test stores are created, to measure on different "
+    "filesystem types. Defaults to the temporary directory.");
+DEFINE_uint64(operations, 10000, "Operations performed by every iteration");
+DEFINE_uint64(
+    large_blob_operations,
+    200,
+    "Operations performed by every iteration of put_large_blobs");
+DEFINE_uint64(keys, 100000, "Number of objects the read benchmarks read from");
+DEFINE_uint64(tree_size_median, 1024, "Median size of a serialized tree");
+DEFINE_uint64(small_blob_size_median, 4 * 1024, "Median size of small blobs");
+DEFINE_uint64(
+    large_blob_size_median,
+    1024 * 1024,
+    "Median size of large blobs");
+DEFINE_double(
+    size_sigma,
+    1.0,
+    "Standard deviation of the logarithm of the sizes: object sizes follow a "
+    "log-normal distribution around the medians above");
+DEFINE_uint64(seed, 1, "Seed of the generated keys, sizes and reads");
+
+/**
+ * Compares the LocalStore implementations on the operations the ObjectStore
+ * performs: getting trees, putting small and large blobs, and getting
+ * batches of objects.
+ *
+ * The first two arguments of every benchmark are the store implementation,
+ * also reported as the label of the run, and the number of threads sharing
+ * the store. Object sizes follow log-normal distributions, configured by the
+ * flags.
+ *
+ * Besides throughput, benchmarks report the p50 and p99 latency of the
+ * individual operations in microseconds, and the write benchmarks report
+ * their write amplification: the bytes the process wrote to files, including
+ * logs and compactions until the store is closed, divided by the bytes that
+ * were put. Use --benchmark_format=json or --benchmark_out for
+ * machine-readable results.
+ */
+namespace {
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+using Clock = std::chrono::steady_clock;
+
+enum class StoreType : int64_t {
+  Memory,
+  Sqlite,
+  RocksDb,
+  Pack,
+};
+
+constexpr StoreType kStoreTypes[] = {
+    StoreType::Memory,
+    StoreType::Sqlite,
+    StoreType::RocksDb,
+    StoreType::Pack,
+};
+
+const char* getStoreTypeName(StoreType type) {
+  switch (type) {
+    case StoreType::Memory:
+      return "MemoryLocalStore";
+    case StoreType::Sqlite:
+      return "SqliteLocalStore";
+    case StoreType::RocksDb:
+      return "RocksDbLocalStore";
+    case StoreType::Pack:
+      return "PackLocalStore";
+  }
+  return "unknown";
+}
+
+folly::test::TemporaryDirectory makeBenchmarkDir() {
+  if (FLAGS_storePath.empty()) {
+    return makeTempDir("eden_local_store_bench");
+  }
+  return folly::test::TemporaryDirectory{
+      "eden_local_store_bench", FLAGS_storePath};
+}
+
+/**
+ * The number of bytes the process passed to write system calls so far, or
+ * 0 where this isn't known.
+ */
+uint64_t getWrittenBytes() {
+#ifdef __linux__
+  std::string io;
+  if (!folly::readFile("/proc/self/io", io)) {
+    return 0;
+  }
+  std::vector<folly::StringPiece> lines;
+  folly::split('\n', io, lines);
+  for (auto line : lines) {
+    if (line.removePrefix("wchar: ")) {
+      return folly::to<uint64_t>(line);
+    }
+  }
+#endif
+  return 0;
+}
+
+/** A store of the benchmark's type, in a new directory. */
+struct BenchmarkStore {
+  explicit BenchmarkStore(const benchmark::State& state)
+      : type{static_cast<StoreType>(state.range(0))} {
+    auto storePath = AbsolutePath{dir.path().string()};
+    switch (type) {
+      case StoreType::Memory:
+        store = std::make_shared<MemoryLocalStore>();
+        break;
+      case StoreType::Sqlite:
+        store = std::make_shared<SqliteLocalStore>(storePath + "sqlite"_pc);
+        break;
+      case StoreType::RocksDb:
+        store = std::make_shared<RocksDbLocalStore>(
+            storePath,
+            std::make_shared<NullStructuredLogger>(),
+            &faultInjector);
+        break;
+      case StoreType::Pack:
+        store = std::make_shared<PackLocalStore>(storePath + "pack"_pc);
+        break;
+    }
+  }
+
+  StoreType type;
+  folly::test::TemporaryDirectory dir{makeBenchmarkDir()};
+  FaultInjector faultInjector{/*enabled=*/false};
+  std::shared_ptr<LocalStore> store;
+};
+
+/** Generates the keys and sizes of objects, and the keys to read. */
+class Workload {
+ public:
+  Workload(uint64_t sizeMedian, uint64_t seed)
+      : rng_{seed},
+        sizes_{std::log(static_cast<double>(sizeMedian)), FLAGS_size_sigma} {}
+
+  static std::string makeKey(uint64_t index) {
+    auto hash = Hash20::sha1(fmt::format("object {}", index));
+    return folly::StringPiece{hash.getBytes()}.str();
+  }
+
+  size_t nextSize() {
+    return std::max<size_t>(1, static_cast<size_t>(sizes_(rng_)));
+  }
+
+  uint64_t nextReadIndex() {
+    return folly::Random::rand64(FLAGS_keys, rng_);
+  }
+
+ private:
+  std::mt19937_64 rng_;
+  std::lognormal_distribution<double> sizes_;
+};
+
+/** Store FLAGS_keys objects of the given median size to read back. */
+void populate(LocalStore& store, KeySpace keySpace, uint64_t sizeMedian) {
+  Workload workload{sizeMedian, FLAGS_seed};
+  auto batch = store.beginWrite(16 * 1024 * 1024);
+  std::string value;
+  for (uint64_t i = 0; i < FLAGS_keys; ++i) {
+    value.assign(workload.nextSize(), 'x');
+    auto key = Workload::makeKey(i);
+    batch->put(
+        keySpace,
+        folly::ByteRange{folly::StringPiece{key}},
+        folly::ByteRange{folly::StringPiece{value}});
+  }
+  batch->flush();
+}
+
+/** The latency below which the given fraction of the sorted latencies are. */
+double percentile(const std::vector<Clock::duration>& sorted, double p) {
+  if (sorted.empty()) {
+    return 0.0;
+  }
+  auto index = std::min(
+      sorted.size() - 1, static_cast<size_t>(p * (sorted.size() - 1) + 0.5));
+  return std::chrono::duration<double, std::micro>{sorted[index]}.count();
+}
+
+/**
+ * Run the given number of calls of operation per iteration, spread across
+ * state.range(1) threads, and report their latencies. operation is called
+ * with the Workload of its thread and the index of the operation.
+ */
+template <typename Operation>
+void runConcurrently(
+    benchmark::State& state,
+    uint64_t sizeMedian,
+    uint64_t operations,
+    Operation operation) {
+  auto threadCount = static_cast<uint64_t>(state.range(1));
+  std::vector<Workload> workloads;
+  for (uint64_t t = 0; t < threadCount; ++t) {
+    workloads.emplace_back(sizeMedian, FLAGS_seed + 1 + t);
+  }
+  std::vector<std::vector<Clock::duration>> latencies(threadCount);
+  uint64_t nextIndex = 0;
+
+  for (auto _ : state) {
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < threadCount; ++t) {
+      auto begin = nextIndex + operations * t / threadCount;
+      auto end = nextIndex + operations * (t + 1) / threadCount;
+      threads.emplace_back([&, t, begin, end] {
+        for (auto i = begin; i < end; ++i) {
+          auto start = Clock::now();
+          operation(workloads[t], i);
+          latencies[t].push_back(Clock::now() - start);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    nextIndex += operations;
+  }
+
+  std::vector<Clock::duration> all;
+  for (auto& threadLatencies : latencies) {
+    all.insert(all.end(), threadLatencies.begin(), threadLatencies.end());
+  }
+  std::sort(all.begin(), all.end());
+  state.SetItemsProcessed(all.size());
+  state.counters["p50_us"] = percentile(all, 0.5);
+  state.counters["p99_us"] = percentile(all, 0.99);
+}
+
+void get_trees(benchmark::State& state) {
+  BenchmarkStore store{state};
+  state.SetLabel(getStoreTypeName(store.type));
+  populate(*store.store, KeySpace::TreeFamily, FLAGS_tree_size_median);
+
+  runConcurrently(
+      state,
+      FLAGS_tree_size_median,
+      FLAGS_operations,
+      [&](Workload& workload, uint64_t) {
+        auto key = Workload::makeKey(workload.nextReadIndex());
+        auto result = store.store->get(
+            KeySpace::TreeFamily, folly::ByteRange{folly::StringPiece{key}});
+        benchmark::DoNotOptimize(result.isValid());
+      });
+}
+
+/** Get batches of state.range(2) trees, as done when prefetching. */
+void get_batch(benchmark::State& state) {
+  BenchmarkStore store{state};
+  state.SetLabel(getStoreTypeName(store.type));
+  populate(*store.store, KeySpace::TreeFamily, FLAGS_tree_size_median);
+  auto batchSize = static_cast<size_t>(state.range(2));
+
+  runConcurrently(
+      state,
+      FLAGS_tree_size_median,
+      FLAGS_operations,
+      [&](Workload& workload, uint64_t) {
+        std::vector<std::string> keys;
+        keys.reserve(batchSize);
+        for (size_t i = 0; i < batchSize; ++i) {
+          keys.push_back(Workload::makeKey(workload.nextReadIndex()));
+        }
+        std::vector<folly::ByteRange> keyRanges;
+        keyRanges.reserve(batchSize);
+        for (const auto& key : keys) {
+          keyRanges.emplace_back(folly::StringPiece{key});
+        }
+        auto results =
+            store.store->getBatch(KeySpace::TreeFamily, keyRanges).get();
+        benchmark::DoNotOptimize(results.size());
+      });
+  state.counters["objects_per_second"] = benchmark::Counter(
+      state.iterations() * FLAGS_operations * batchSize,
+      benchmark::Counter::kIsRate);
+}
+
+/**
+ * Put new blobs of the given median size, and report the write
+ * amplification once the store is closed.
+ */
+void putBlobs(
+    benchmark::State& state,
+    uint64_t sizeMedian,
+    uint64_t operations) {
+  auto store = std::make_unique<BenchmarkStore>(state);
+  state.SetLabel(getStoreTypeName(store->type));
+  std::atomic<uint64_t> putBytes{0};
+  auto writtenBefore = getWrittenBytes();
+
+  runConcurrently(
+      state, sizeMedian, operations, [&](Workload& workload, uint64_t index) {
+        // Unlike the generated keys of the read benchmarks, these are never
+        // already present.
+        std::string value(workload.nextSize(), 'x');
+        auto key = Workload::makeKey(FLAGS_keys + index);
+        store->store->put(
+            KeySpace::BlobFamily,
+            folly::ByteRange{folly::StringPiece{key}},
+            folly::ByteRange{folly::StringPiece{value}});
+        putBytes.fetch_add(
+            key.size() + value.size(), std::memory_order_relaxed);
+      });
+
+  store->store->close();
+  auto written = getWrittenBytes() - writtenBefore;
+  state.SetBytesProcessed(putBytes.load());
+  state.counters["write_amplification"] = putBytes.load()
+      ? static_cast<double>(written) / putBytes.load()
+      : 0.0;
+}
+
+void put_small_blobs(benchmark::State& state) {
+  putBlobs(state, FLAGS_small_blob_size_median, FLAGS_operations);
+}
+
+void put_large_blobs(benchmark::State& state) {
+  putBlobs(
+      state, FLAGS_large_blob_size_median, FLAGS_large_blob_operations);
+}
+
+void storeArguments(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"store", "threads"});
+  for (auto type : kStoreTypes) {
+    for (int64_t threads : {1, 8, 32}) {
+      benchmark->Args({static_cast<int64_t>(type), threads});
+    }
+  }
+  benchmark->Unit(benchmark::kMillisecond);
+  benchmark->UseRealTime();
+}
+
+void batchArguments(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"store", "threads", "batch"});
+  for (auto type : kStoreTypes) {
+    for (int64_t threads : {1, 8}) {
+      for (int64_t batchSize : {1, 16, 256}) {
+        benchmark->Args({static_cast<int64_t>(type), threads, batchSize});
+      }
+    }
+  }
+  benchmark->Unit(benchmark::kMillisecond);
+  benchmark->UseRealTime();
+}
+
+BENCHMARK(get_trees)->Apply(storeArguments);
+BENCHMARK(get_batch)->Apply(batchArguments);
+BENCHMARK(put_small_blobs)->Apply(storeArguments);
+BENCHMARK(put_large_blobs)->Apply(storeArguments);
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
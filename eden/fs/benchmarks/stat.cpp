@@ -29,6 +29,29 @@ void call_fstat(benchmark::State& state) {
 }
 BENCHMARK(call_fstat);
 
+/**
+ * stat(2) the file by path from several threads at once. Unlike fstat on an
+ * open file this goes through a lookup of the inode for every call, which
+ * shows how EdenFS scales with concurrent FUSE or NFS requests.
+ */
+void call_stat(benchmark::State& state) {
+  if (state.thread_index == 0) {
+    folly::File file{FLAGS_filename, O_CREAT | O_RDONLY | O_CLOEXEC};
+  }
+  struct stat buf;
+
+  for (auto _ : state) {
+    folly::checkUnixError(::stat(FLAGS_filename.c_str(), &buf), "stat failed");
+  }
+
+  // The timed loop starts and ends with a barrier, so the file exists for
+  // all the threads and none of them still uses it here.
+  if (state.thread_index == 0) {
+    folly::checkUnixError(::unlink(FLAGS_filename.c_str()));
+  }
+}
+BENCHMARK(call_stat)->ThreadRange(1, 32)->UseRealTime();
+
 } // namespace
 
 EDEN_BENCHMARK_MAIN();
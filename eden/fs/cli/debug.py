@@ -41,6 +41,8 @@ from facebook.eden.ttypes import (
     DebugGetRawJournalParams,
     DebugJournalDelta,
     EdenError,
+    HostSelfTestParams,
+    InodeSubtreeSummary,
     NoValueForKeyError,
     TimeSpec,
     TreeInodeDebugInfo,
@@ -520,10 +522,29 @@ class InodeCmd(Subcmd):
             "a mount point is specified, only data about inodes under the "
             "specified subdirectory will be reported.",
         )
+        parser.add_argument(
+            "--summary",
+            action="store_true",
+            help="Only report the number of inodes and the size of the "
+            "materialized files, for each directory immediately under the path.",
+        )
 
     def run(self, args: argparse.Namespace) -> int:
         out = sys.stdout.buffer
         instance, checkout, rel_path = cmd_util.require_checkout(args, args.path)
+        if args.summary:
+            with instance.get_thrift_client_legacy() as client:
+                summary = client.debugInodeSummary(
+                    bytes(checkout.path),
+                    bytes(rel_path),
+                    flags=0,
+                    sync=SyncBehavior(),
+                )
+            _print_inode_summary(summary.total, out)
+            for child in summary.children:
+                _print_inode_summary(child, out)
+            return 0
+
         with instance.get_thrift_client_legacy() as client:
             results = client.debugInodeStatus(
                 bytes(checkout.path),
@@ -794,6 +815,18 @@ class ListRecordingsCmd(Subcmd):
         return 0
 
 
+def _print_inode_summary(summary: InodeSubtreeSummary, out: IO[bytes]) -> None:
+    out.write((summary.path or b"/") + b"\n")
+    out.write(b"  Trees:              %d\n" % summary.treeCount)
+    out.write(b"  Loaded inodes:      %d\n" % summary.loadedInodeCount)
+    out.write(b"  Files:              %d\n" % summary.fileCount)
+    out.write(b"  Materialized files: %d\n" % summary.materializedFileCount)
+    out.write(
+        b"  Materialized size:  %s\n"
+        % stats_print.format_size(summary.materializedBytes).encode()
+    )
+
+
 def _print_inode_info(inode_info: TreeInodeDebugInfo, out: IO[bytes]) -> None:
     out.write(inode_info.path + b"\n")
     out.write(b"  Inode number:  %d\n" % inode_info.inodeNumber)
@@ -825,6 +858,76 @@ def _print_inode_info(inode_info: TreeInodeDebugInfo, out: IO[bytes]) -> None:
         out.write(line.encode())
 
 
+@debug_cmd(
+    "self_test",
+    "Time probes of the disk, CPU, mount and backing store from inside EdenFS",
+)
+class SelfTestCmd(Subcmd):
+    def setup_parser(self, parser: argparse.ArgumentParser) -> None:
+        parser.add_argument(
+            "path",
+            nargs="?",
+            help="The path to the EdenFS mount point to probe. "
+            "Defaults to the current directory.",
+        )
+        parser.add_argument(
+            "--samples",
+            type=int,
+            default=0,
+            help="How many times to run each probe, at most 1000",
+        )
+        parser.add_argument(
+            "--json",
+            action="store_true",
+            help="Print the report as JSON, to collect it",
+        )
+
+    def run(self, args: argparse.Namespace) -> int:
+        instance, checkout, _rel_path = cmd_util.require_checkout(
+            args, args.path or os.getcwd()
+        )
+        with instance.get_thrift_client_legacy() as client:
+            result = client.debugHostSelfTest(
+                HostSelfTestParams(
+                    mountPoint=bytes(checkout.path), samples=args.samples
+                )
+            )
+
+        if args.json:
+            report = {
+                "host": result.host,
+                "probes": [
+                    {
+                        "name": probe.name,
+                        "samples": probe.samples,
+                        "p50_us": probe.p50Micros,
+                        "p99_us": probe.p99Micros,
+                        "max_us": probe.maxMicros,
+                        "error": probe.error,
+                    }
+                    for probe in result.probes
+                ],
+            }
+            json.dump(report, sys.stdout, indent=2)
+            print()
+            return 0
+
+        for key, value in sorted(result.host.items()):
+            print(f"{key}: {value}")
+        print(f"{'probe':<25} {'p50 us':>10} {'p99 us':>10} {'max us':>10}")
+        failed = False
+        for probe in result.probes:
+            if probe.error is not None:
+                print(f"{probe.name:<25} failed: {probe.error}")
+                failed = True
+            else:
+                print(
+                    f"{probe.name:<25} {probe.p50Micros:>10} "
+                    f"{probe.p99Micros:>10} {probe.maxMicros:>10}"
+                )
+        return 1 if failed else 0
+
+
 @debug_cmd("getpath", "Get the EdenFS path that corresponds to an inode number")
 class GetPathCmd(Subcmd):
     def setup_parser(self, parser: argparse.ArgumentParser) -> None:
@@ -586,11 +586,24 @@ class StatusCmd(Subcmd):
         health_info = instance.check_health(timeout=args.timeout)
         if health_info.is_healthy():
             print("edenfs running normally (pid {})".format(health_info.pid))
+            self.print_unready_mounts(instance)
             return 0
 
         print("edenfs not healthy: {}".format(health_info.detail))
         return 1
 
+    @staticmethod
+    def print_unready_mounts(instance: EdenInstance) -> None:
+        # Checkouts may still be remounting in the background after startup.
+        for path, mount_info in sorted(instance.get_mounts().items()):
+            if not mount_info.configured or mount_info.state == MountState.RUNNING:
+                continue
+            if mount_info.state is None:
+                state_name = "NOT_MOUNTED"
+            else:
+                state_name = MountState._VALUES_TO_NAMES[mount_info.state]
+            print(f"  {path.as_posix()}: {state_name}")
+
 
 @subcmd("list", "List available checkouts")
 class ListCmd(Subcmd):
@@ -10,7 +10,7 @@ import logging
 import os
 import sys
 import textwrap
-from typing import NamedTuple, Dict, List, Optional, cast
+from typing import NamedTuple, Dict, List, Optional, Tuple, cast
 
 from facebook.eden.constants import (
     STATS_MOUNTS_STATS,
@@ -98,6 +98,13 @@ def print_stats(stat_info, out: io.TextIOWrapper):
         files = info.loadedFileCount
         trees = info.loadedTreeCount
         in_memory = files + trees
+        inode_bytes = files * (info.fileInodeSizeBytes or 0) + trees * (
+            info.treeInodeSizeBytes or 0
+        )
+        if inode_bytes:
+            inodeSize = f" using {stats_print.format_size(inode_bytes)}"
+        else:
+            inodeSize = ""
 
         if stat_info.mountPointJournalInfo is None:
             journal = None
@@ -125,7 +132,7 @@ def print_stats(stat_info, out: io.TextIOWrapper):
             textwrap.dedent(
                 f"""\
             {mount_path}
-              - Inodes in memory: {in_memory} ({trees} trees, {files} files)
+              - Inodes in memory: {in_memory} ({trees} trees, {files} files){inodeSize}
               - Unloaded, tracked inodes: {info.unloadedInodeCount}
               {journalLine}
             """
@@ -200,11 +207,23 @@ def get_fuse_counters(counters: DiagInfoCounters, all_flg: bool) -> Table:
     return table
 
 
+def split_percentile_and_period(tokens: List[str]) -> Tuple[str, Optional[str]]:
+    """Split the end of a stat name, such as p99.60, into the percentile and
+    the optional period. Tail percentiles contain a dot, as in p99.9.60."""
+    period = None
+    if tokens and tokens[-1] in ("60", "600", "3600"):
+        period = tokens[-1]
+        tokens = tokens[:-1]
+    return ".".join(tokens), period
+
+
 def insert_latency_record(
     table: Table2D, value: int, operation: str, percentile: str, period: Optional[str]
 ) -> None:
     period_table = {"60": 0, "600": 1, "3600": 2}
-    percentile_table = {"avg": 0, "p50": 1, "p90": 2, "p99": 3}
+    percentile_table = {
+        label: i for i, label in enumerate(stats_print.LATENCY_PERCENTILES)
+    }
 
     def with_microsecond_units(i: int) -> str:
         if i:
@@ -219,7 +238,11 @@ def insert_latency_record(
             for _ in range(len(period_table) + 1)
         ]
 
-    pct_index = percentile_table[percentile]
+    pct_index = percentile_table.get(percentile)
+    if pct_index is None:
+        # The stats also export a sum, a rate and low percentiles, which the
+        # latency table doesn't show.
+        return
     if period:
         period_index = period_table[period]
     else:
@@ -282,10 +305,7 @@ def get_fuse_latency(counters: DiagInfoCounters, all_flg: bool) -> Table2D:
             syscall = tokens[1][:-3]
             if not all_flg and syscall not in syscalls:
                 continue
-            percentile = tokens[2]
-            period = None
-            if len(tokens) > 3:
-                period = tokens[3]
+            percentile, period = split_percentile_and_period(tokens[2:])
             insert_latency_record(table, counters[key], syscall, percentile, period)
 
     return table
@@ -401,10 +421,7 @@ def get_store_latency(counters: DiagInfoCounters, store: str) -> Table2D:
         if key.startswith("store.{}".format(store)) and key.find(".count") == -1:
             tokens = key.split(".")
             method = tokens[2]
-            percentile = tokens[3]
-            period = None
-            if len(tokens) > 4:
-                period = tokens[4]
+            percentile, period = split_percentile_and_period(tokens[3:])
             insert_latency_record(table, counters[key], method, percentile, period)
     return table
 
@@ -420,6 +437,8 @@ class LocalStoreCmd(Subcmd):
             ("tree", True),
             ("treemeta", True),
             ("hgcommit2tree", True),
+            ("blobchunk", True),
+            ("selftest", True),
             ("scsproxyhash", True),
             ("hgproxyhash", False),
         ]
@@ -467,6 +486,30 @@ class LocalStoreCmd(Subcmd):
             out.write(f"Last Auto-GC Result:      {last_result_str}\n")
             out.write(f"Last Auto-GC Duration:    {last_gc_sec:.03f}s\n")
 
+        out.write("\n")
+        out.write("Lookups In The Last Minute:\n")
+        columns = ("Table", "Gets", "p50 (us)", "p99 (us)")
+        fmt = "{:<16} {:>10} {:>10} {:>10}\n"
+        out.write(fmt.format(*columns))
+        out.write(f"-------------------------------------------------\n")
+        for name, _ephemeral in column_families:
+            prefix = f"local_store.{name}.get_us"
+            out.write(
+                fmt.format(
+                    name,
+                    counters.get(f"{prefix}.count.60", 0),
+                    counters.get(f"{prefix}.p50.60", 0),
+                    counters.get(f"{prefix}.p99.60", 0),
+                )
+            )
+
+        hit_rate = counters.get("local_store.rocksdb.block_cache_hit_rate", None)
+        if hit_rate is not None:
+            stall_sec = counters.get("local_store.rocksdb.stall_micros", 0) / 1e6
+            out.write("\n")
+            out.write(f"Block Cache Hit Rate:     {hit_rate}%\n")
+            out.write(f"Total Write Stall Time:   {stall_sec:.03f}s\n")
+
         return 0
 
 
@@ -19,20 +19,23 @@ def write_heading(heading: str, out: TextIO) -> None:
 LATENCY_FORMAT_STR = "{:<12} {:^4} {:^10}  {:>10}  {:>15}  {:>10} {:>10}\n"
 
 
-# Prints a record of latencies with avg, 50'th,90'th and 99'th percentile.
+# The rows of a latency record, in order.
+LATENCY_PERCENTILES = ["avg", "p50", "p90", "p99", "p99.9", "p99.99"]
+
+
+# Prints a record of latencies, one row per entry of LATENCY_PERCENTILES.
 def write_latency_record(operation: str, matrix, out: TextIO) -> None:
     border = "-" * 80
-    percentile = {0: "avg", 1: "p50", 2: "p90", 3: "p99"}
 
-    for i in range(len(percentile)):
+    for i in range(len(matrix)):
         operation_name = ""
-        if i == int(len(percentile) / 2):
+        if i == int(len(matrix) / 2):
             operation_name = operation
         out.write(
             LATENCY_FORMAT_STR.format(
                 operation_name,
                 "|",
-                percentile[i],
+                LATENCY_PERCENTILES[i],
                 matrix[i][0],
                 matrix[i][1],
                 matrix[i][2],
@@ -158,6 +158,10 @@ class HgBackingStoreStatsTest(unittest.TestCase):
             "store.mononoke.get_blob.p99.60": 9920,
             "store.mononoke.get_blob.p99.600": 9930,
             "store.mononoke.get_blob.p99.3600": 9940,
+            "store.mononoke.get_blob.p99.9.60": 9990,
+            "store.mononoke.get_blob.p99.99": 9999,
+            # Not shown in the table.
+            "store.mononoke.get_blob.p10.60": 1020,
         }
         table = get_store_latency(counters, "mononoke")
         self.assertEqual(
@@ -167,5 +171,7 @@ class HgBackingStoreStatsTest(unittest.TestCase):
                 ["5020 μs", "5030 μs", "5040 μs", "5010 μs"],
                 ["9020 μs", "9030 μs", "9040 μs", "9010 μs"],
                 ["9920 μs", "9930 μs", "9940 μs", "9910 μs"],
+                ["9990 μs", "", "", ""],
+                ["", "", "", "9999 μs"],
             ],
         )
@@ -18,6 +18,7 @@ from typing import Any, Dict, List, Optional, Tuple
 from facebook.eden.ttypes import AccessCounts
 
 from . import cmd_util
+from .stats_print import format_size
 from .util import format_cmd, format_mount
 
 
@@ -35,7 +36,7 @@ HELP_SECTION_CONCERN = "concern? "
 
 Row = collections.namedtuple(
     "Row",
-    "top_pid mount fuse_reads fuse_writes fuse_total fuse_fetch fuse_memory_cache_imports fuse_disk_cache_imports fuse_backing_store_imports fuse_duration fuse_last_access command",
+    "top_pid mount fuse_reads fuse_writes fuse_total fuse_fetch fuse_memory_cache_imports fuse_disk_cache_imports fuse_backing_store_imports fuse_backing_store_bytes fuse_duration fuse_cpu_time fuse_last_access command",
 )
 
 COLUMN_TITLES = Row(
@@ -48,7 +49,9 @@ COLUMN_TITLES = Row(
     fuse_memory_cache_imports="MEMORY",
     fuse_disk_cache_imports="DISK",
     fuse_backing_store_imports="IMPORTS",
+    fuse_backing_store_bytes="FETCHED",
     fuse_duration="FUSE TIME",
+    fuse_cpu_time="FUSE CPU",
     fuse_last_access="FUSE LAST",
     command="CMD",
 )
@@ -62,7 +65,9 @@ COLUMN_SPACING = Row(
     fuse_memory_cache_imports=7,
     fuse_disk_cache_imports=7,
     fuse_backing_store_imports=7,
+    fuse_backing_store_bytes=8,
     fuse_duration=10,
+    fuse_cpu_time=10,
     fuse_last_access=10,
     command=25,
 )
@@ -76,7 +81,9 @@ COLUMN_ALIGNMENT = Row(
     fuse_memory_cache_imports=">",
     fuse_disk_cache_imports=">",
     fuse_backing_store_imports=">",
+    fuse_backing_store_bytes=">",
     fuse_duration=">",
+    fuse_cpu_time=">",
     fuse_last_access=">",
     command="<",
 )
@@ -90,7 +97,9 @@ COLUMN_REVERSE_SORT = Row(
     fuse_memory_cache_imports=True,
     fuse_disk_cache_imports=True,
     fuse_backing_store_imports=True,
+    fuse_backing_store_bytes=True,
     fuse_duration=True,
+    fuse_cpu_time=True,
     fuse_last_access=True,
     command=False,
 )
@@ -132,7 +141,9 @@ COLUMN_FORMATTING = Row(
     fuse_memory_cache_imports=lambda x: x,
     fuse_disk_cache_imports=lambda x: x,
     fuse_backing_store_imports=lambda x: x,
+    fuse_backing_store_bytes=format_size,
     fuse_duration=format_duration,
+    fuse_cpu_time=format_duration,
     fuse_last_access=format_last_access,
     command=lambda x: x,
 )
@@ -925,8 +936,9 @@ class Top:
             "checkout accessed, number of FUSE reads, FUSE writes, total FUSE "
             "requests, total number of imports cause by fuse requests since this "
             "edenfs daemon started (see FUSE FETCH section below for more info), "
-            "number of imports from the backing store, sum of the duration "
-            "of all the FUSE requests, how long ago the last FUSE request "
+            "number of imports from the backing store, bytes fetched from the "
+            "backing store, sum of the duration of all the FUSE requests, CPU "
+            "time spent handling them, how long ago the last FUSE request "
             "was, and the command that was run. Use left and right arrow "
             "keys  to change the column the processes are sorted by "
             "(highlighted in green). Use up and down arrow keys to move through "
@@ -985,7 +997,7 @@ class Process:
         self.pid = pid
         self.cmd = format_cmd(cmd)
         self.mount = format_mount(mount)
-        self.access_counts = AccessCounts(0, 0, 0, 0, 0, 0, 0)
+        self.access_counts = AccessCounts(0, 0, 0, 0, 0, 0, 0, 0, 0)
         self.fuseFetch = 0
         self.last_access_time = time.monotonic()
         self.is_running = True
@@ -1017,6 +1029,10 @@ class Process:
             access_counts.fsChannelBackingStoreImports
         )
         self.access_counts.fsChannelDurationNs += access_counts.fsChannelDurationNs
+        self.access_counts.fsChannelCpuTimeNs += access_counts.fsChannelCpuTimeNs
+        self.access_counts.fsChannelBackingStoreBytes += (
+            access_counts.fsChannelBackingStoreBytes
+        )
 
     def set_fetchs(self, fetch_counts: int) -> None:
         self.fuseFetch = fetch_counts
@@ -1032,7 +1048,9 @@ class Process:
             fuse_memory_cache_imports=self.access_counts.fsChannelMemoryCacheImports,
             fuse_disk_cache_imports=self.access_counts.fsChannelDiskCacheImports,
             fuse_backing_store_imports=self.access_counts.fsChannelBackingStoreImports,
+            fuse_backing_store_bytes=self.access_counts.fsChannelBackingStoreBytes,
             fuse_duration=self.access_counts.fsChannelDurationNs,
+            fuse_cpu_time=self.access_counts.fsChannelCpuTimeNs,
             # pyre-fixme[16]: `Process` has no attribute `last_access`.
             fuse_last_access=self.last_access,
             command=self.cmd,
@@ -5,6 +5,7 @@
 # GNU General Public License version 2.
 
 import argparse
+import sys
 
 from . import cmd_util, subcmd as subcmd_mod
 from .subcmd import Subcmd
@@ -29,6 +30,29 @@ class DisableTraceCmd(Subcmd):
         return 0
 
 
+@trace_cmd(
+    "dump",
+    "Write the most recent traces in the Chrome trace format, "
+    "which chrome://tracing and ui.perfetto.dev open",
+)
+class DumpTraceCmd(Subcmd):
+    def setup_parser(self, parser: argparse.ArgumentParser) -> None:
+        parser.add_argument(
+            "output", help="The file to write the trace to, or - for stdout"
+        )
+
+    def run(self, args: argparse.Namespace) -> int:
+        instance = cmd_util.get_eden_instance(args)
+        with instance.get_thrift_client_legacy() as client:
+            trace = client.getChromeTrace()
+        if args.output == "-":
+            sys.stdout.buffer.write(trace)
+        else:
+            with open(args.output, "wb") as f:
+                f.write(trace)
+        return 0
+
+
 @subcmd_mod.subcmd("trace", "Commands for managing EdenFS tracing")
 # pyre-fixme[13]: Attribute `parser` is never initialized.
 class TraceCmd(Subcmd):
@@ -112,6 +112,7 @@ int trace_hg(
   struct ActiveRequest {
     std::optional<HgEvent> queue;
     std::optional<HgEvent> start;
+    std::optional<HgEvent> fetch;
   };
 
   std::unordered_map<uint64_t, ActiveRequest> activeRequests;
@@ -119,13 +120,17 @@ int trace_hg(
   static const std::unordered_map<HgEventType, const char*> kEventTypes = {
       {HgEventType::QUEUE, " "},
       {HgEventType::START, reinterpret_cast<const char*>(u8"\u21E3")},
+      {HgEventType::FALLBACK, reinterpret_cast<const char*>(u8"\u21AF")},
       {HgEventType::FINISH, reinterpret_cast<const char*>(u8"\u2193")},
+      {HgEventType::CANCEL, reinterpret_cast<const char*>(u8"\u2715")},
   };
 
   static const std::unordered_map<HgResourceType, const char*> kResourceTypes =
       {
           {HgResourceType::BLOB, reinterpret_cast<const char*>(u8"\U0001F954")},
           {HgResourceType::TREE, reinterpret_cast<const char*>(u8"\U0001F332")},
+          {HgResourceType::BLOBMETA,
+           reinterpret_cast<const char*>(u8"\U0001F3F7")},
       };
 
   std::move(traceHgStream).subscribeInline([&](folly::Try<HgEvent>&& event) {
@@ -138,6 +143,7 @@ int trace_hg(
 
     std::optional<HgEvent> queueEvent;
     std::optional<HgEvent> startEvent;
+    std::optional<HgEvent> fetchEvent;
 
     const HgEventType eventType = *evt.eventType_ref();
     const HgResourceType resourceType = *evt.resourceType_ref();
@@ -155,9 +161,24 @@ int trace_hg(
         record.start = evt;
         break;
       }
+      case HgEventType::FETCH:
+        activeRequests[unique].fetch = evt;
+        break;
+      case HgEventType::FALLBACK: {
+        auto& record = activeRequests[unique];
+        startEvent = record.start;
+        break;
+      }
       case HgEventType::FINISH: {
         auto& record = activeRequests[unique];
         startEvent = record.start;
+        fetchEvent = record.fetch;
+        activeRequests.erase(unique);
+        break;
+      }
+      case HgEventType::CANCEL: {
+        auto& record = activeRequests[unique];
+        queueEvent = record.queue;
         activeRequests.erase(unique);
         break;
       }
@@ -184,11 +205,46 @@ int trace_hg(
         }
         break;
 
+      case HgEventType::FETCH:
+        // Shown as part of the FINISH event.
+        return;
+
+      case HgEventType::FALLBACK:
+        if (startEvent) {
+          auto missTime = evt.times_ref()->monotonic_time_ns_ref().value() -
+              startEvent->times_ref()->monotonic_time_ns_ref().value();
+          timeAnnotation = fmt::format(
+              " not in hgcache or EdenAPI after {}", formatTime(missTime));
+        }
+        break;
+
       case HgEventType::FINISH:
         if (startEvent) {
-          auto fetchTime = evt.times_ref()->monotonic_time_ns_ref().value() -
+          auto finishTime = evt.times_ref()->monotonic_time_ns_ref().value();
+          auto startTime =
               startEvent->times_ref()->monotonic_time_ns_ref().value();
-          timeAnnotation = fmt::format(" fetched in {}", formatTime(fetchTime));
+          if (fetchEvent) {
+            auto fetchTime =
+                fetchEvent->times_ref()->monotonic_time_ns_ref().value();
+            timeAnnotation = fmt::format(
+                " fetched in {} (+{} to finish)",
+                formatTime(fetchTime - startTime),
+                formatTime(finishTime - fetchTime));
+          } else {
+            timeAnnotation = fmt::format(
+                " fetched in {}", formatTime(finishTime - startTime));
+          }
+        }
+        break;
+
+      case HgEventType::CANCEL:
+        if (queueEvent) {
+          auto queueTime = evt.times_ref()->monotonic_time_ns_ref().value() -
+              queueEvent->times_ref()->monotonic_time_ns_ref().value();
+          timeAnnotation =
+              fmt::format(" cancelled after {}", formatTime(queueTime));
+        } else {
+          timeAnnotation = " cancelled";
         }
         break;
     }
@@ -214,6 +214,26 @@ class EdenConfig : private ConfigSettingManager {
       kUnspecifiedDefault,
       this};
 
+  /**
+   * Approximate number of bytes of memory used to cache the parsed .gitignore
+   * files of all mounts, keyed by blob, so that status calls don't parse them
+   * again. 0 disables the cache. Only read at startup.
+   */
+  ConfigSetting<size_t> gitIgnoreCacheSize{
+      "core:gitignore-cache-size",
+      8 * 1024 * 1024,
+      this};
+
+  /**
+   * Approximate number of bytes of memory used to cache the differences
+   * between the commits, and between the subtrees, compared by
+   * getScmStatusBetweenRevisions. 0 disables the cache. Only read at startup.
+   */
+  ConfigSetting<size_t> treeDiffCacheSize{
+      "core:tree-diff-cache-size",
+      32 * 1024 * 1024,
+      this};
+
   /**
    * How often to check the on-disk lock file to ensure it is still valid.
    * EdenFS will exit if the lock file is no longer valid.
@@ -223,6 +243,32 @@ class EdenConfig : private ConfigSettingManager {
       std::chrono::minutes(5),
       this};
 
+  /**
+   * If true, EdenFS reports a successful startup as soon as its thrift
+   * server is running, and keeps remounting checkouts in the background.
+   * Their progress is visible in `eden status`. Graceful restarts always wait
+   * for the mounts taken over.
+   */
+  ConfigSetting<bool> backgroundRemount{"core:background-remount", false, this};
+
+  /**
+   * Maximum number of checkouts remounted concurrently on startup. 0 remounts
+   * them all at once.
+   */
+  ConfigSetting<size_t> startupMountConcurrency{
+      "core:startup-mount-concurrency",
+      0,
+      this};
+
+  /**
+   * Paths of the checkouts to remount first on startup, in order. The other
+   * checkouts are remounted after them.
+   */
+  ConfigSetting<std::vector<std::string>> startupMountPriority{
+      "core:startup-mount-priority",
+      std::vector<std::string>{},
+      this};
+
   // [config]
 
   /**
@@ -233,6 +279,17 @@ class EdenConfig : private ConfigSettingManager {
       std::chrono::minutes(5),
       this};
 
+  /**
+   * Whether reading the config may also check, at most every 5 seconds,
+   * whether the config files changed. When false, changes are only picked up
+   * by the config:reload-interval task and by explicit reloads, and request
+   * threads never stat the config files.
+   */
+  ConfigSetting<bool> configReloadOnAccess{
+      "config:reload-on-access",
+      true,
+      this};
+
   // [thrift]
 
   ConfigSetting<bool> allowUnixGroupRequests{
@@ -249,6 +306,17 @@ class EdenConfig : private ConfigSettingManager {
       true,
       this};
 
+  /**
+   * The maximum number of thrift requests a single client process may have
+   * outstanding. Requests over the limit fail with EBUSY instead of waiting
+   * for a thrift worker. The HIGH-priority methods, like getDaemonInfo, are
+   * exempt. 0 means no limit.
+   */
+  ConfigSetting<size_t> thriftMaxRequestsPerClient{
+      "thrift:max-requests-per-client",
+      0,
+      this};
+
   // [ssl]
 
   ConfigSetting<AbsolutePath> clientCertificate{
@@ -273,6 +341,55 @@ class EdenConfig : private ConfigSettingManager {
       std::chrono::minutes(1),
       this};
 
+  /**
+   * The number of threads the RocksDB local store uses for asynchronous
+   * reads. Concurrent lookups are coalesced into MultiGet calls on these
+   * threads. Only read when the local store is opened.
+   */
+  ConfigSetting<size_t> localStoreIoThreads{"store:io-threads", 12, this};
+
+  /**
+   * How many bytes of imported objects may be buffered in memory before
+   * being written to the local store in the background. Imports block once
+   * the buffer is full. 0 writes objects synchronously. Only read when the
+   * local store is opened.
+   */
+  ConfigSetting<size_t> localStoreWriteBehindBufferSize{
+      "store:write-behind-buffer-size",
+      64 * 1024 * 1024,
+      this};
+
+  /**
+   * How often to compact the local store in the background while the
+   * filesystem is idle. 0 disables idle compaction.
+   */
+  ConfigSetting<std::chrono::nanoseconds> localStoreIdleCompactionInterval{
+      "store:idle-compaction-interval",
+      std::chrono::hours(24),
+      this};
+
+  /**
+   * The filesystem counts as idle while it serves at most this many requests
+   * per minute. An idle compaction is cancelled once the filesystem serves
+   * more.
+   */
+  ConfigSetting<uint64_t> localStoreIdleCompactionMaxRequests{
+      "store:idle-compaction-max-requests",
+      100,
+      this};
+
+  /**
+   * A directory holding a local store shared with the other EdenFS daemons
+   * of the user on the host, for the blobs, trees and the other caches.
+   * Empty keeps everything in this daemon's store. The directory must belong
+   * to the user and be writable by nobody else, otherwise it isn't used.
+   * Only read when the local store is opened.
+   */
+  ConfigSetting<std::string> localStoreSharedPath{
+      "store:shared-path",
+      "",
+      this};
+
   /*
    * The following settings control the maximum sizes of the local store's
    * caches, per object type.
@@ -301,6 +418,27 @@ class EdenConfig : private ConfigSettingManager {
       20'000'000,
       this};
 
+  ConfigSetting<uint64_t> localStoreBlobChunkSizeLimit{
+      "store:blob-chunk-size-limit",
+      15'000'000'000,
+      this};
+
+  ConfigSetting<uint64_t> localStoreSelfTestSizeLimit{
+      "store:self-test-size-limit",
+      1'000'000,
+      this};
+
+  /**
+   * When a key space exceeds its size limit, the automatic garbage
+   * collection deletes the keys that haven't been used recently. This caps
+   * how fast, in bytes per second, it reads through the key space. 0 means
+   * no limit.
+   */
+  ConfigSetting<uint64_t> localStoreAutoGcScanRate{
+      "store:auto-gc-scan-rate",
+      64 * 1024 * 1024,
+      this};
+
   /**
    * The minimum duration between logging occurrences of failed HgProxyHash
    * loads.
@@ -319,6 +457,82 @@ class EdenConfig : private ConfigSettingManager {
       2000,
       this};
 
+  /**
+   * The window over which the fetch rates of each process are averaged. A
+   * process that stops fetching stops being fetch heavy within a few
+   * windows.
+   */
+  ConfigSetting<std::chrono::nanoseconds> fetchRateWindow{
+      "store:fetch-rate-window",
+      std::chrono::seconds{10},
+      this};
+
+  /**
+   * Fetches of a process averaging this many fetches per second over
+   * store:fetch-rate-window are deprioritized. 0 disables this limit.
+   */
+  ConfigSetting<uint32_t> fetchHeavyRequestRate{
+      "store:fetch-heavy-request-rate",
+      500,
+      this};
+
+  /**
+   * Fetches of a process averaging this many bytes fetched per second over
+   * store:fetch-rate-window are deprioritized. 0 disables this limit.
+   */
+  ConfigSetting<uint64_t> fetchHeavyByteRate{
+      "store:fetch-heavy-byte-rate",
+      0,
+      this};
+
+  /**
+   * Approximate number of bytes of memory used to cache blob sizes and SHA-1s
+   * in each mount's ObjectStore. Only read when a mount is started.
+   */
+  ConfigSetting<size_t> blobMetadataCacheSize{
+      "store:blob-metadata-cache-size",
+      64 * 1024 * 1024,
+      this};
+
+  /**
+   * Approximate number of bytes of memory used to cache the ranges of the
+   * blobs that are read in ranges, see experimental:blob-range-threshold,
+   * in each mount's ObjectStore. Only read when a mount is started.
+   */
+  ConfigSetting<size_t> blobRangeCacheSize{
+      "store:blob-range-cache-size",
+      64 * 1024 * 1024,
+      this};
+
+  /**
+   * Maximum number of missing object IDs the ObjectStore remembers, so that
+   * repeated lookups of the same missing object fail fast. 0 disables the
+   * negative lookup cache. Only read when a mount is started.
+   */
+  ConfigSetting<size_t> negativeLookupCacheSize{
+      "store:negative-cache-size",
+      0,
+      this};
+
+  /**
+   * How long a missing object ID stays in the negative lookup cache.
+   */
+  ConfigSetting<std::chrono::nanoseconds> negativeLookupCacheTtl{
+      "store:negative-cache-ttl",
+      std::chrono::seconds{30},
+      this};
+
+  /**
+   * How many of the most recently used keys of the blob cache and the tree
+   * cache to save on shutdown. The next EdenFS process reloads those objects
+   * from the LocalStore in the background, so that it doesn't start with
+   * cold caches. 0 disables it.
+   */
+  ConfigSetting<size_t> warmCacheEntries{
+      "store:warm-cache-entries",
+      10000,
+      this};
+
   /**
    * The maximum number of tree prefetch operations to allow in parallel for any
    * checkout.  Setting this to 0 will disable prefetch operations.
@@ -328,6 +542,81 @@ class EdenConfig : private ConfigSettingManager {
       5,
       this};
 
+  /**
+   * When a directory is listed right after its parent, which is how a
+   * recursive walk looks, its prefetch also fetches the trees this many
+   * levels below its subdirectories, so that the walk doesn't wait on one
+   * round trip per directory. 0 disables it.
+   */
+  ConfigSetting<uint32_t> subtreePrefetchDepth{
+      "store:subtree-prefetch-depth",
+      2,
+      this};
+
+  /**
+   * The maximum number of trees fetched by the subtree prefetch of one
+   * directory.
+   */
+  ConfigSetting<uint32_t> subtreePrefetchMaxTrees{
+      "store:subtree-prefetch-max-trees",
+      1000,
+      this};
+
+  /**
+   * Once this many files in one directory have been read without their blob
+   * being cached, which is how a compiler scanning headers looks, prefetch the
+   * blobs of the rest of the directory's files. Each directory does this at
+   * most once while loaded, and shares the store:max-tree-prefetches budget.
+   * 0 disables it.
+   */
+  ConfigSetting<uint32_t> siblingBlobPrefetchThreshold{
+      "store:sibling-blob-prefetch-threshold",
+      0,
+      this};
+
+  /**
+   * The maximum number of blobs fetched by the sibling prefetch of one
+   * directory.
+   */
+  ConfigSetting<uint32_t> siblingBlobPrefetchMaxBlobs{
+      "store:sibling-blob-prefetch-max-blobs",
+      1000,
+      this};
+
+  /**
+   * The maximum number of file content comparisons that a single diff, as
+   * used by status, keeps in flight. Each of them may fetch blobs from the
+   * backing store. 0 removes the limit.
+   */
+  ConfigSetting<size_t> maxConcurrentDiffComparisons{
+      "store:max-concurrent-diff-comparisons",
+      1000,
+      this};
+
+  // [checkout]
+
+  /**
+   * The maximum number of subtrees of a checkout that may be queued or
+   * running on the server thread pool at once. Subtrees beyond that are
+   * checked out inline on the thread that processed their parent. Setting
+   * this to 0 processes the whole checkout inline.
+   */
+  ConfigSetting<size_t> checkoutMaxParallelSubtrees{
+      "checkout:max-parallel-subtrees",
+      64,
+      this};
+
+  /**
+   * The maximum number of checkout actions that may be fetching their trees,
+   * blobs and inodes at once. Further actions wait for one of those to finish
+   * loading, which keeps a checkout touching many files from queueing all of
+   * its fetches up front. Setting this to 0 removes the limit.
+   */
+  ConfigSetting<size_t> checkoutMaxConcurrentLoads{
+      "checkout:max-concurrent-loads",
+      4096,
+      this};
+
   // [fuse]
 
   /**
@@ -342,6 +631,63 @@ class EdenConfig : private ConfigSettingManager {
       1000,
       this};
 
+  /**
+   * Read FUSE requests with splice(2) so that large writes to materialized
+   * files are spliced into the overlay rather than copied through EdenFS's
+   * memory. Linux only. Takes effect for new mounts.
+   */
+  ConfigSetting<bool> fuseUseSplice{"fuse:use-splice", false, this};
+
+  /**
+   * Give each FUSE worker thread its own clone of the FUSE device
+   * (FUSE_DEV_IOC_CLONE) so the kernel does not funnel every request through
+   * one processing queue. Linux only. Takes effect for new mounts.
+   */
+  ConfigSetting<bool> fuseCloneDevicePerThread{
+      "fuse:clone-device-per-thread",
+      false,
+      this};
+
+  /**
+   * Pin each FUSE worker thread to a CPU, round-robin. Linux only. Takes
+   * effect for new mounts.
+   */
+  ConfigSetting<bool> fusePinWorkerThreads{
+      "fuse:pin-worker-threads",
+      false,
+      this};
+
+  /**
+   * The largest read or write, in bytes, the kernel may send in one FUSE
+   * request, negotiated with FUSE_MAX_PAGES where the kernel supports it.
+   * Capped at 256 pages (1MB). 0 keeps the kernel default of 128KB. Linux
+   * only. Takes effect for new mounts.
+   */
+  ConfigSetting<size_t> fuseMaxIoSize{"fuse:max-io-size", 0, this};
+
+  /**
+   * Request FUSE_WRITEBACK_CACHE: the kernel caches buffered writes and
+   * flushes them to EdenFS in larger chunks. Linux only. Takes effect for new
+   * mounts.
+   */
+  ConfigSetting<bool> fuseWritebackCache{"fuse:writeback-cache", false, this};
+
+  /**
+   * Request FUSE_ASYNC_DIO so direct I/O is submitted to EdenFS in parallel.
+   * Linux only. Takes effect for new mounts.
+   */
+  ConfigSetting<bool> fuseAsyncDio{"fuse:async-dio", false, this};
+
+  /**
+   * If non-zero, FUSE worker threads only read requests and hand them to a
+   * pool of this many threads shared by all mounts, which runs metadata
+   * requests ahead of reads and writes. Spliced writes are still handled by
+   * the worker that read them. The pool is sized by the first mount that
+   * uses it. 0 handles each request on the thread that read it. Takes effect
+   * for new mounts.
+   */
+  ConfigSetting<size_t> fuseDispatchThreads{"fuse:dispatch-threads", 0, this};
+
   /**
    * The maximum time duration allowed for a fuse request. If a request exceeds
    * this amount of time, an ETIMEDOUT error will be returned to the kernel to
@@ -400,15 +746,37 @@ class EdenConfig : private ConfigSettingManager {
    */
   ConfigSetting<uint64_t> numNfsThreads{"nfs:num-servicing-threads", 8, this};
 
+  /**
+   * Number of EventBase threads that the NFS sockets are spread across. Every
+   * mount has its own nfsd socket, so this lets the socket reads and reply
+   * writes of different mounts run in parallel. When set to 0, all the sockets
+   * share the main EventBase.
+   */
+  ConfigSetting<uint64_t> numNfsIoThreads{"nfs:num-io-threads", 0, this};
+
   /**
    * Maximum number of pending NFS requests. If more requests are inflight, the
    * NFS code will block.
+   *
+   * Reads, writes and commits are queued separately from the metadata
+   * requests, and each of these two lanes is bounded by this.
    */
   ConfigSetting<uint64_t> maxNfsInflightRequests{
       "nfs:max-inflight-requests",
       1000,
       this};
 
+  /**
+   * Maximum number of requests of a single NFS mount that are processed
+   * concurrently. Once reached, EdenFS stops reading requests from the mount's
+   * socket until some complete, so that a scan of one mount can't take all
+   * of the servicing threads. 0 means no per-mount limit.
+   */
+  ConfigSetting<uint64_t> maxNfsInflightRequestsPerMount{
+      "nfs:max-inflight-requests-per-mount",
+      0,
+      this};
+
   /**
    * Buffer size for read and writes requests. Default to 1 MiB.
    */
@@ -445,8 +813,24 @@ class EdenConfig : private ConfigSettingManager {
    * When set to true, we will use readdirplus instead of readdir. Readdirplus
    * will be enabled for all nfs mounts. If set to false, regular readdir is
    * used instead.
+   *
+   * Readdirplus loads the entries of a page in parallel and fetches the blob
+   * metadata of its files with one batched lookup, which makes `ls -l` cost
+   * one round trip per page instead of a readdir followed by a lookup per
+   * entry.
    */
-  ConfigSetting<bool> useReaddirplus{"nfs:use-readdirplus", false, this};
+  ConfigSetting<bool> useReaddirplus{"nfs:use-readdirplus", true, this};
+
+  /**
+   * How many of the most recently accessed directories of an NFS mount to
+   * remember when it shuts down. The next time it is mounted, their inodes
+   * and trees are loaded before the mount is made visible, so that the first
+   * browse doesn't start with a cascade of cold lookups. 0 disables it.
+   */
+  ConfigSetting<size_t> nfsPrewarmDirectories{
+      "nfs:prewarm-directories",
+      0,
+      this};
 
   // [prjfs]
 
@@ -480,6 +864,17 @@ class EdenConfig : private ConfigSettingManager {
       1,
       this};
 
+  /**
+   * Controls the number of threads per mount dedicated to handling file change
+   * notifications. Notifications are spread across them by parent directory:
+   * the changes to a given path are always handled in order, while different
+   * directories are handled in parallel.
+   */
+  ConfigSetting<uint8_t> prjfsNumNotificationThreads{
+      "prjfs:num-notification-threads",
+      1,
+      this};
+
   // [hg]
 
   /**
@@ -501,6 +896,17 @@ class EdenConfig : private ConfigSettingManager {
       HgObjectIdFormat::ProxyHash,
       this};
 
+  /**
+   * When hg:object-id-format embeds the hg node in object IDs, rewrite the
+   * legacy proxy hash IDs found in the overlay to that format as directories
+   * are loaded. Once migrated, fetching these objects no longer needs a
+   * lookup in the LocalStore.
+   */
+  ConfigSetting<bool> hgMigrateProxyHashes{
+      "hg:migrate-proxy-hashes",
+      false,
+      this};
+
   /**
    * Controls the number of blob or prefetch import requests we batch in
    * HgBackingStore
@@ -515,6 +921,70 @@ class EdenConfig : private ConfigSettingManager {
       1,
       this};
 
+  /**
+   * When many import requests are queued, batches grow beyond the sizes above
+   * up to this many requests. Batches keep the configured sizes when this
+   * isn't larger.
+   */
+  ConfigSetting<uint32_t> importBatchSizeMax{
+      "hg:import-batch-size-max",
+      256,
+      this};
+
+  /**
+   * How many blob import batches each backing store thread may have fetching
+   * at once. With 1, a thread waits for each batch to be fetched before
+   * taking the next one out of the queue.
+   */
+  ConfigSetting<uint32_t> importBlobBatchesInFlight{
+      "hg:import-blob-batches-in-flight",
+      1,
+      this};
+
+  /**
+   * How much longer than the round trip of a minimum size batch a larger
+   * import batch may take before the batch sizes shrink.
+   */
+  ConfigSetting<std::chrono::nanoseconds> importBatchTargetLatency{
+      "hg:import-batch-target-latency",
+      std::chrono::milliseconds(200),
+      this};
+
+  /**
+   * getBlob and getTree look for objects in hgcache on the calling thread
+   * before queueing an import. When these lookups take longer than this on
+   * average, most of them are skipped and the import threads do them
+   * instead, so that a slow hgcache doesn't stall filesystem requests.
+   */
+  ConfigSetting<std::chrono::nanoseconds> hgLocalProbeBudget{
+      "hg:local-probe-budget",
+      std::chrono::milliseconds(5),
+      this};
+
+  /**
+   * Revset of the commits whose manifest nodes are resolved in bulk the
+   * first time a commit isn't found in the commit-to-tree cache, so that
+   * checking out or rebasing across them doesn't ask the hg helper about
+   * each commit in turn. An empty revset disables the prefetch.
+   */
+  ConfigSetting<std::string> hgCommitPrefetchRevset{
+      "hg:commit-prefetch-revset",
+      "draft() + last(public(), 200)",
+      this};
+
+  /**
+   * Minimum time between two bulk prefetches of commit manifest nodes.
+   */
+  ConfigSetting<std::chrono::nanoseconds> hgCommitPrefetchInterval{
+      "hg:commit-prefetch-interval",
+      std::chrono::minutes(1),
+      this};
+
+  /**
+   * Number of commit to manifest node mappings kept in memory.
+   */
+  ConfigSetting<size_t> hgCommitCacheSize{"hg:commit-cache-size", 10000, this};
+
   // [backingstore]
 
   /**
@@ -550,6 +1020,16 @@ class EdenConfig : private ConfigSettingManager {
       std::nullopt,
       this};
 
+  /**
+   * Only one in this many fetches matching logObjectFetchPathRegex is logged,
+   * so that a fetch storm does not flood the log. The sampling happens before
+   * the event is built. 0 and 1 log every matching fetch.
+   */
+  ConfigSetting<uint32_t> logObjectFetchSampleDenominator{
+      "telemetry:log-object-fetch-sample-denominator",
+      1,
+      this};
+
   /**
    * Controls sample denominator for each request sampling group.
    * We assign request types into sampling groups based on their usage and
@@ -604,6 +1084,57 @@ class EdenConfig : private ConfigSettingManager {
       std::vector<std::string>{},
       this};
 
+  /**
+   * If non-zero, tracing is enabled at startup and keeps a rolling window of
+   * the most recent tracepoints and FUSE/NFS requests, which `eden trace dump`
+   * writes out. Only one request in this many is recorded, to keep the cost
+   * low; 1 records every request.
+   */
+  ConfigSetting<uint32_t> traceSampleDenominator{
+      "telemetry:trace-sample-denominator",
+      0,
+      this};
+
+  /**
+   * When continuous tracing is enabled, a recorded request taking at least
+   * this long dumps the rolling window to the traces directory of the state
+   * directory, at most once a minute. 0 disables these dumps.
+   */
+  ConfigSetting<std::chrono::nanoseconds> slowTraceThreshold{
+      "telemetry:slow-trace-threshold",
+      std::chrono::nanoseconds::zero(),
+      this};
+
+  /**
+   * Filesystem requests taking at least this long log their cost: the CPU
+   * time spent on them, cache misses and bytes fetched from the backing
+   * store. 0 disables the log. Read at startup.
+   */
+  ConfigSetting<std::chrono::nanoseconds> slowRequestLogThreshold{
+      "telemetry:slow-request-log-threshold",
+      std::chrono::nanoseconds::zero(),
+      this};
+
+  /**
+   * FUSE and NFS requests still outstanding after this long are reported
+   * once, while they are stuck, with a slow_request event recording the
+   * import queue and the caches at that time. 0 disables the watchdog.
+   */
+  ConfigSetting<std::chrono::nanoseconds> requestWatchdogThreshold{
+      "telemetry:request-watchdog-threshold",
+      std::chrono::nanoseconds::zero(),
+      this};
+
+  /**
+   * Record how long the InodeMap, TreeInode contents, object cache, hg import
+   * queue and rename locks are waited for and held, as lock.* stats. Costs
+   * two clock reads per acquisition. Read at startup.
+   */
+  ConfigSetting<bool> lockProfiling{
+      "telemetry:lock-profiling",
+      false,
+      this};
+
   // [experimental]
 
   /**
@@ -614,6 +1145,26 @@ class EdenConfig : private ConfigSettingManager {
       false,
       this};
 
+  /**
+   * Controls whether large blobs are split into content-defined chunks in
+   * the local store, so that similar versions of a file share storage.
+   */
+  ConfigSetting<bool> enableBlobChunking{
+      "experimental:enable-blob-chunking",
+      false,
+      this};
+
+  /**
+   * With blob chunking enabled, files at least this large are read in
+   * ranges of ObjectStore::kBlobRangeSize bytes instead of loading their
+   * whole blob in memory. 0 disables range reads. Only read when a mount is
+   * started.
+   */
+  ConfigSetting<uint64_t> blobRangeThreshold{
+      "experimental:blob-range-threshold",
+      64 * 1024 * 1024,
+      this};
+
   /**
    * Controls whether EdenFS uses EdenApi to import data from remote.
    */
@@ -665,6 +1216,26 @@ class EdenConfig : private ConfigSettingManager {
       16,
       this};
 
+  /**
+   * Number of independently locked shards the in-memory tree cache is split
+   * into. Both inMemoryTreeCacheSize and inMemoryTreeCacheMinElements are
+   * divided evenly between the shards. Only read at startup.
+   */
+  ConfigSetting<size_t> inMemoryTreeCacheNumShards{
+      "treecache:num-shards",
+      1,
+      this};
+
+  /**
+   * Number of bytes worth of LZ4-compressed trees to keep in memory after they
+   * are evicted from the in-memory tree cache. 0 disables the compressed tier.
+   * Only read at startup.
+   */
+  ConfigSetting<size_t> inMemoryTreeCompressedCacheSize{
+      "treecache:compressed-cache-size",
+      0,
+      this};
+
   // [notifications]
 
   /**
@@ -691,6 +1262,17 @@ class EdenConfig : private ConfigSettingManager {
   ConfigSetting<uint64_t> maxLogFileSize{"log:max-file-size", 50000000, this};
   ConfigSetting<uint64_t> maxRotatedLogFiles{"log:num-rotated-logs", 3, this};
 
+  /**
+   * How many bytes of EdenFS output the monitor buffers in memory while a
+   * background thread writes them to the log file, so that a slow disk does
+   * not stall EdenFS on a full pipe. Output beyond that is dropped. 0 writes
+   * the log synchronously.
+   */
+  ConfigSetting<uint64_t> logBufferSize{
+      "log:buffer-size",
+      8 * 1024 * 1024,
+      this};
+
   // [prefetch-profiles]
 
   /**
@@ -740,6 +1322,50 @@ class EdenConfig : private ConfigSettingManager {
       1500,
       this};
 
+  /**
+   * Whether predictiveGlobFiles predicts the directories to prefetch from
+   * the files EdenFS itself had to fetch, instead of asking the usage
+   * service. Builds without the usage service always do.
+   */
+  ConfigSetting<bool> predictivePrefetchFromLocalHistory{
+      "predictive-prefetch-profiles:use-local-history",
+      false,
+      this};
+
+  /**
+   * How many directories the local fetch history of a repository tracks.
+   */
+  ConfigSetting<uint32_t> predictivePrefetchHistorySize{
+      "predictive-prefetch-profiles:local-history-size",
+      10000,
+      this};
+
+  /**
+   * Whether a checkout is followed by a background predictive prefetch of
+   * the working set of the mount, as predictiveGlobFiles would return it.
+   */
+  ConfigSetting<bool> predictivePrefetchAfterCheckout{
+      "predictive-prefetch-profiles:prefetch-after-checkout",
+      false,
+      this};
+
+  /**
+   * How long the results of a glob against a commit are kept for identical
+   * globs against the same commit. 0 disables the cache.
+   */
+  ConfigSetting<std::chrono::nanoseconds> globResultCacheTtl{
+      "glob:result-cache-ttl",
+      std::chrono::seconds{30},
+      this};
+
+  /**
+   * The maximum number of glob results kept by the glob result cache.
+   */
+  ConfigSetting<size_t> globResultCacheSize{
+      "glob:result-cache-size",
+      64,
+      this};
+
   /**
    * DANGER: this option will put overlay into memory and skip persisting any
    * actual data to disk. This will guarantee to cause EdenFS corruption after
@@ -750,6 +1376,16 @@ class EdenConfig : private ConfigSettingManager {
       false,
       this};
 
+  /**
+   * When non-zero, the tree overlay is kept in memory and snapshotted to disk
+   * this often, when the working copy parent is reset (e.g. by `hg commit`),
+   * and at unmount. A crash loses the changes since the last snapshot.
+   */
+  ConfigSetting<std::chrono::nanoseconds> overlaySnapshotInterval{
+      "overlay:in-memory-snapshot-interval",
+      std::chrono::nanoseconds{0},
+      this};
+
   /**
    * The synchronous mode used when using tree overlay. Currently it only
    * supports "off" or "normal". Setting this to off may cause data loss.
@@ -759,6 +1395,54 @@ class EdenConfig : private ConfigSettingManager {
       "normal",
       this};
 
+  /**
+   * Whether the legacy overlay keeps modified directories in memory and
+   * writes them in the background, so that a directory modified many times
+   * in a row is only rewritten once. The changes are journaled, so that the
+   * directories that weren't written yet survive a crash.
+   */
+  ConfigSetting<bool> overlayDirWriteBack{
+      "overlay:dir-write-back",
+      false,
+      this};
+
+  /**
+   * The maximum number of tree overlay changes committed in one SQLite
+   * transaction. Changes are committed one by one when this is 0 or 1.
+   * Uncommitted changes are lost if EdenFS crashes.
+   */
+  ConfigSetting<uint32_t> overlayGroupCommitMaxOperations{
+      "overlay:group-commit-max-operations",
+      0,
+      this};
+
+  /**
+   * How long the tree overlay waits for more changes before committing the
+   * changes made so far.
+   */
+  ConfigSetting<std::chrono::nanoseconds> overlayGroupCommitWindow{
+      "overlay:group-commit-window",
+      std::chrono::milliseconds{10},
+      this};
+
+  /**
+   * Files of at least this many bytes are materialized by cloning a copy of
+   * their contents kept in the overlay, so that materializing the same
+   * contents again is cheap and shares disk space, where the filesystem
+   * supports reflinks. 0 disables this.
+   */
+  ConfigSetting<uint64_t> overlayPooledFileMinSize{
+      "overlay:pooled-file-min-size",
+      0,
+      this};
+
+  /**
+   * Whether the inode metadata table is mapped with transparent huge pages.
+   * This only takes effect when the overlay lives on a filesystem whose
+   * mappings support them, such as tmpfs.
+   */
+  ConfigSetting<bool> overlayHugePages{"overlay:huge-pages", false, this};
+
   // [clone]
 
   /**
@@ -769,6 +1453,77 @@ class EdenConfig : private ConfigSettingManager {
       folly::kIsWindows ? MountProtocol::PRJFS : MountProtocol::FUSE,
       this};
 
+  // [memory]
+
+  /**
+   * How often to check the memory pressure of the system, or of the cgroup
+   * EdenFS runs in, and resize the blob cache, tree cache and journals
+   * accordingly. 0 disables it.
+   */
+  ConfigSetting<std::chrono::nanoseconds> memoryGovernorInterval{
+      "memory:governor-interval",
+      std::chrono::seconds{30},
+      this};
+
+  /**
+   * The caches are shrunk when tasks are stalled on memory for at least this
+   * percentage of the last 10 seconds, as reported by the Linux pressure stall
+   * information, and grown back once it drops below the low threshold.
+   */
+  ConfigSetting<double> memoryPressureHighStallPercent{
+      "memory:high-stall-percent",
+      10.0,
+      this};
+
+  ConfigSetting<double> memoryPressureLowStallPercent{
+      "memory:low-stall-percent",
+      1.0,
+      this};
+
+  /**
+   * The caches are also shrunk when the cgroup EdenFS runs in uses at least
+   * this fraction of its memory limit, and grown back once it drops below the
+   * low threshold.
+   */
+  ConfigSetting<double> memoryPressureHighCgroupUsage{
+      "memory:high-cgroup-usage",
+      0.9,
+      this};
+
+  ConfigSetting<double> memoryPressureLowCgroupUsage{
+      "memory:low-cgroup-usage",
+      0.75,
+      this};
+
+  /**
+   * The smallest fraction of their configured size the caches and journals
+   * are shrunk to under memory pressure.
+   */
+  ConfigSetting<double> memoryGovernorMinimumScale{
+      "memory:minimum-cache-scale",
+      0.125,
+      this};
+
+  // [journal]
+
+  /**
+   * Keep a log of each mount's journal of up to this many bytes in its client
+   * directory, so that the changes made before a restart can still be queried
+   * after it. 0 disables it, and the journal starts from scratch every time
+   * the mount is remounted.
+   */
+  ConfigSetting<size_t> journalLogMaxSize{"journal:log-max-size", 0, this};
+
+  /**
+   * Notify each journal subscriber, such as Watchman, at most once per
+   * interval: changes made in the meantime are coalesced into a single
+   * notification sent when the interval elapses. 0 notifies right away.
+   */
+  ConfigSetting<std::chrono::nanoseconds> journalNotificationInterval{
+      "journal:notification-interval",
+      std::chrono::nanoseconds{0},
+      this};
+
   // [facebook]
   // Facebook internal
 
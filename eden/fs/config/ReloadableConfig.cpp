@@ -22,16 +22,24 @@ constexpr std::chrono::seconds kEdenConfigMinimumPollDuration{5};
 namespace facebook::eden {
 
 ReloadableConfig::ReloadableConfig(std::shared_ptr<const EdenConfig> config)
-    : state_{ConfigState{config}} {}
+    : state_{ConfigState{config}},
+      snapshot_{folly::rcu_default_domain(), config} {}
 ReloadableConfig::ReloadableConfig(
     std::shared_ptr<const EdenConfig> config,
     ConfigReloadBehavior reloadBehavior)
-    : state_{ConfigState{config}}, reloadBehavior_{reloadBehavior} {}
+    : state_{ConfigState{config}},
+      snapshot_{folly::rcu_default_domain(), config},
+      reloadBehavior_{reloadBehavior} {}
 
 ReloadableConfig::~ReloadableConfig() {}
 
 std::shared_ptr<const EdenConfig> ReloadableConfig::getEdenConfig(
     ConfigReloadBehavior reload) {
+  maybeReload(reload);
+  return *snapshot_.rlock();
+}
+
+void ReloadableConfig::maybeReload(ConfigReloadBehavior reload) {
   auto now = std::chrono::steady_clock::now();
 
   // TODO: Update this monitoring code to use FileChangeMonitor.
@@ -47,10 +55,22 @@ std::shared_ptr<const EdenConfig> ReloadableConfig::getEdenConfig(
       shouldReload = true;
       break;
     case ConfigReloadBehavior::AutoReload: {
+      if (!(*snapshot_.rlock())->configReloadOnAccess.getValue()) {
+        // EdenServer's config:reload-interval task does the reloads.
+        shouldReload = false;
+        break;
+      }
+      auto lastCheckRep = lastCheck_.load(std::memory_order_acquire);
       auto lastCheck = std::chrono::steady_clock::time_point{
-          std::chrono::steady_clock::duration{
-              lastCheck_.load(std::memory_order_acquire)}};
-      shouldReload = now - lastCheck >= kEdenConfigMinimumPollDuration;
+          std::chrono::steady_clock::duration{lastCheckRep}};
+      // Only the thread that moves lastCheck_ forward stats the config files.
+      // The others keep using the current config instead of all stating the
+      // files, and waiting on the lock, at the same time.
+      shouldReload = now - lastCheck >= kEdenConfigMinimumPollDuration &&
+          lastCheck_.compare_exchange_strong(
+              lastCheckRep,
+              now.time_since_epoch().count(),
+              std::memory_order_acq_rel);
       break;
     }
     default:
@@ -58,7 +78,7 @@ std::shared_ptr<const EdenConfig> ReloadableConfig::getEdenConfig(
   }
 
   if (!shouldReload) {
-    return state_.rlock()->config;
+    return;
   }
 
   auto state = state_.wlock();
@@ -82,9 +102,9 @@ std::shared_ptr<const EdenConfig> ReloadableConfig::getEdenConfig(
                  << systemConfigChanged.str();
       newConfig->loadSystemConfig();
     }
-    state->config = std::move(newConfig);
+    state->config = newConfig;
+    snapshot_.update(std::move(newConfig));
   }
-  return state->config;
 }
 
 } // namespace facebook::eden
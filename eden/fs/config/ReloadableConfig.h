@@ -12,7 +12,9 @@
 
 #include <folly/Synchronized.h>
 
+#include "eden/fs/config/ConfigSetting.h"
 #include "eden/fs/config/gen-cpp2/eden_config_types.h"
+#include "eden/fs/utils/Rcu.h"
 
 namespace facebook::eden {
 
@@ -39,14 +41,37 @@ class ReloadableConfig {
   std::shared_ptr<const EdenConfig> getEdenConfig(
       ConfigReloadBehavior reload = ConfigReloadBehavior::AutoReload);
 
+  /**
+   * Get the value of a single setting, e.g.
+   * getValue(&EdenConfig::hgObjectIdFormat).
+   *
+   * Meant for request paths: unlike getEdenConfig(), this neither takes a
+   * lock nor copies a shared_ptr unless a reload check is due, it only reads
+   * the current config under an RCU read section.
+   */
+  template <typename T, typename Converter>
+  T getValue(
+      ConfigSetting<T, Converter> EdenConfig::*setting,
+      ConfigReloadBehavior reload = ConfigReloadBehavior::AutoReload) {
+    maybeReload(reload);
+    auto config = snapshot_.rlock();
+    return ((**config).*setting).getValue();
+  }
+
  private:
+  /** Reload the config from disk if reload says it should be checked. */
+  void maybeReload(ConfigReloadBehavior reload);
+
   struct ConfigState {
     explicit ConfigState(const std::shared_ptr<const EdenConfig>& config)
         : config{config} {}
     std::shared_ptr<const EdenConfig> config;
   };
 
+  // Held while checking whether the config files changed and reloading them.
   folly::Synchronized<ConfigState> state_;
+  // The same config as state_, for readers that don't reload.
+  RcuPtr<std::shared_ptr<const EdenConfig>> snapshot_;
   std::atomic<std::chrono::steady_clock::time_point::rep> lastCheck_{};
 
   // Reload behavior, when set this overrides reload behavior passed to methods
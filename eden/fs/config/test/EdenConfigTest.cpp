@@ -13,6 +13,7 @@
 #include <folly/test/TestUtils.h>
 #include <optional>
 
+#include "eden/fs/config/ReloadableConfig.h"
 #include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/FileUtils.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -604,3 +605,38 @@ TEST_F(EdenConfigTest, getValueByFullKey) {
       std::runtime_error,
       "ill-formed");
 }
+
+TEST_F(EdenConfigTest, reloadable_config_values_follow_reloads) {
+  auto userConfigDir = rootTestDir_ + "user-home"_pc;
+  auto systemConfigDir = rootTestDir_ + "etc-eden"_pc;
+  auto userConfigPath = userConfigDir + ".edenrc"_pc;
+  auto systemConfigPath = systemConfigDir + "edenrc.toml"_pc;
+
+  ensureDirectoryExists(userConfigDir);
+  ensureDirectoryExists(systemConfigDir);
+  writeFile(userConfigPath, "[hg]\nlocal-probe-budget = \"1ms\"\n"_sp).value();
+
+  auto edenConfig = std::make_shared<EdenConfig>(
+      "username",
+      42,
+      userConfigDir,
+      userConfigPath,
+      systemConfigDir,
+      systemConfigPath);
+  edenConfig->loadUserConfig();
+  ReloadableConfig config{edenConfig};
+  EXPECT_EQ(
+      std::chrono::milliseconds{1},
+      config.getValue(
+          &EdenConfig::hgLocalProbeBudget, ConfigReloadBehavior::NoReload));
+
+  writeFile(userConfigPath, "[hg]\nlocal-probe-budget = \"20ms\"\n"_sp).value();
+  EXPECT_EQ(
+      std::chrono::milliseconds{20},
+      config.getValue(
+          &EdenConfig::hgLocalProbeBudget, ConfigReloadBehavior::ForceReload));
+  EXPECT_EQ(
+      std::chrono::milliseconds{20},
+      config.getEdenConfig(ConfigReloadBehavior::NoReload)
+          ->hgLocalProbeBudget.getValue());
+}
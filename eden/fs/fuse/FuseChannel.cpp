@@ -11,17 +11,28 @@
 
 #include <boost/cast.hpp>
 #include <fmt/core.h>
+#include <fcntl.h>
+#include <folly/FileUtil.h>
+#include <folly/container/F14Set.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
 #include <folly/executors/QueuedImmediateExecutor.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
 #include <folly/futures/Future.h>
+#include <folly/hash/Hash.h>
 #include <folly/logging/xlog.h>
+#include <folly/portability/SysUio.h>
 #include <folly/system/ThreadName.h>
 #include <signal.h>
+#include <sys/ioctl.h>
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <type_traits>
 #include "eden/fs/fuse/DirList.h"
 #include "eden/fs/fuse/FuseDispatcher.h"
 #include "eden/fs/fuse/FuseRequestContext.h"
 #include "eden/fs/telemetry/FsEventLogger.h"
+#include "eden/fs/telemetry/Tracing.h"
 #include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/IDGen.h"
 #include "eden/fs/utils/StaticAssert.h"
@@ -217,6 +228,86 @@ static_assert(
 // This is the minimum size used by libfuse so we use it too!
 constexpr size_t MIN_BUFSIZE = 0x21000;
 
+// Room for the request headers in front of a max_write sized payload.
+constexpr size_t kRequestHeaderRoom = 0x1000;
+
+// The largest max_pages the kernel accepts (FUSE_MAX_MAX_PAGES).
+constexpr size_t kMaxFusePages = 256;
+
+// The dispatch pool shared by every mount that uses one; see
+// getDispatchExecutor().
+std::atomic<folly::CPUThreadPoolExecutor*> sharedDispatchExecutor{nullptr};
+
+/**
+ * Returns the dispatch pool, creating it with numThreads threads on first
+ * use. Later mounts share it whatever their own setting.
+ */
+folly::CPUThreadPoolExecutor* getDispatchExecutor(size_t numThreads) {
+  static folly::CPUThreadPoolExecutor* executor = [numThreads] {
+    // Two priorities: metadata requests, then reads and writes.
+    auto* pool = new folly::CPUThreadPoolExecutor(
+        numThreads,
+        2,
+        std::make_shared<folly::NamedThreadFactory>("FuseDispatch"));
+    sharedDispatchExecutor.store(pool, std::memory_order_release);
+    return pool;
+  }();
+  return executor;
+}
+
+// FUSE_WRITE payloads smaller than this are not worth the extra splice(2).
+constexpr size_t kMinSpliceWriteSize = 16 * 1024;
+
+/**
+ * The pipe a worker thread splices FUSE requests into. The kernel hands it
+ * the pages of a FUSE_WRITE payload by reference, and they can be spliced on
+ * into the overlay file without being copied through user space.
+ */
+struct SplicePipe {
+  folly::File readEnd;
+  folly::File writeEnd;
+};
+
+std::optional<SplicePipe> makeSplicePipe(size_t capacity) {
+#ifdef __linux__
+  int fds[2];
+  if (pipe2(fds, O_CLOEXEC) != 0) {
+    XLOG(WARN) << "unable to create a pipe to splice FUSE requests into: "
+               << folly::errnoStr(errno);
+    return std::nullopt;
+  }
+  SplicePipe splicePipe{
+      folly::File{fds[0], /* ownsFd */ true},
+      folly::File{fds[1], /* ownsFd */ true}};
+  // The kernel fails to splice a request that doesn't fit in the pipe.
+  auto size = fcntl(fds[1], F_SETPIPE_SZ, capacity);
+  if (size < 0 || static_cast<size_t>(size) < capacity) {
+    XLOG(WARN) << "unable to grow the FUSE splice pipe to " << capacity
+               << " bytes, reading requests instead";
+    return std::nullopt;
+  }
+  return splicePipe;
+#else
+  (void)capacity;
+  return std::nullopt;
+#endif
+}
+
+/**
+ * Discard whatever a request handler left in the splice pipe, e.g. the
+ * payload of a write that failed before reading it.
+ */
+void drainSplicePipe(int pipeReadFd) {
+  std::array<char, 4096> scratch;
+  int pending = 0;
+  while (ioctl(pipeReadFd, FIONREAD, &pending) == 0 && pending > 0) {
+    auto toRead = std::min(static_cast<size_t>(pending), scratch.size());
+    if (folly::readNoInt(pipeReadFd, scratch.data(), toRead) <= 0) {
+      break;
+    }
+  }
+}
+
 using Handler = ImmediateFuture<folly::Unit> (FuseChannel::*)(
     FuseRequestContext& request,
     const fuse_in_header& header,
@@ -718,7 +809,7 @@ void FuseChannel::replyError(const fuse_in_header& request, int errorCode) {
   err.unique = request.unique;
   XLOG(DBG7) << "replyError unique=" << err.unique << " error=" << errorCode
              << " " << folly::errnoStr(errorCode);
-  auto res = write(fuseDevice_.fd(), &err, sizeof(err));
+  auto res = write(replyDeviceFd(request), &err, sizeof(err));
   if (res != sizeof(err)) {
     if (res < 0) {
       throwSystemError("replyError: error writing to fuse device");
@@ -737,22 +828,32 @@ void FuseChannel::sendReply(
 
   vec.insert(vec.begin(), make_iovec(out));
 
-  sendRawReply(vec.data(), vec.size());
+  sendRawReply(replyDeviceFd(request), vec.data(), vec.size());
 }
 
 void FuseChannel::sendReply(
     const fuse_in_header& request,
     const folly::IOBuf& buf) const {
+  auto numElements = buf.countChainElements();
+  if (numElements >= folly::kIovMax) {
+    // The reply must be sent with a single writev(2), which takes at most
+    // IOV_MAX buffers, including the header. Only chains built from a great
+    // many small fetched chunks get here, so copying them is rare.
+    auto coalesced = buf.cloneCoalescedAsValue();
+    sendReply(request, folly::ByteRange{coalesced.data(), coalesced.length()});
+    return;
+  }
+
   fuse_out_header out;
   out.unique = request.unique;
   out.error = 0;
 
   folly::fbvector<iovec> vec;
-  vec.reserve(1 + buf.countChainElements());
+  vec.reserve(1 + numElements);
   vec.push_back(make_iovec(out));
   buf.appendToIov(&vec);
 
-  sendRawReply(vec.data(), vec.size());
+  sendRawReply(replyDeviceFd(request), vec.data(), vec.size());
 }
 
 void FuseChannel::sendReply(
@@ -768,10 +869,23 @@ void FuseChannel::sendReply(
   iov[1].iov_base = const_cast<uint8_t*>(bytes.data());
   iov[1].iov_len = bytes.size();
 
-  sendRawReply(iov.data(), iov.size());
+  sendRawReply(replyDeviceFd(request), iov.data(), iov.size());
+}
+
+int FuseChannel::replyDeviceFd(const fuse_in_header& request) const {
+  if (request.padding == 0) {
+    return fuseDevice_.fd();
+  }
+  XDCHECK_LE(request.padding, clonedDevices_.size());
+  return clonedDevices_[request.padding - 1].fd();
 }
 
 void FuseChannel::sendRawReply(const iovec iov[], size_t count) const {
+  sendRawReply(fuseDevice_.fd(), iov, count);
+}
+
+void FuseChannel::sendRawReply(int deviceFd, const iovec iov[], size_t count)
+    const {
   // Ensure that the length is set correctly
   XDCHECK_EQ(iov[0].iov_len, sizeof(fuse_out_header));
   const auto header = reinterpret_cast<fuse_out_header*>(iov[0].iov_base);
@@ -780,7 +894,7 @@ void FuseChannel::sendRawReply(const iovec iov[], size_t count) const {
     header->len += iov[i].iov_len;
   }
 
-  const auto res = writev(fuseDevice_.fd(), iov, count);
+  const auto res = writev(deviceFd, iov, count);
   const int err = errno;
   XLOG(DBG7) << "sendRawReply: unique=" << header->unique
              << " header->len=" << header->len << " wrote=" << res;
@@ -810,8 +924,19 @@ FuseChannel::FuseChannel(
     std::shared_ptr<Notifier> notifier,
     CaseSensitivity caseSensitive,
     bool requireUtf8Path,
-    int32_t maximumBackgroundRequests)
-    : bufferSize_(std::max(size_t(getpagesize()) + 0x1000, MIN_BUFSIZE)),
+    int32_t maximumBackgroundRequests,
+    bool useSplice,
+    bool cloneDevicePerThread,
+    bool pinWorkerThreads,
+    size_t maxIoSize,
+    bool writebackCache,
+    bool asyncDio,
+    size_t dispatchThreads)
+    : bufferSize_(std::max(
+          {size_t(getpagesize()) + kRequestHeaderRoom,
+           MIN_BUFSIZE,
+           std::min(maxIoSize, kMaxFusePages * getpagesize()) +
+               kRequestHeaderRoom})),
       numThreads_(numThreads),
       dispatcher_(std::move(dispatcher)),
       straceLogger_(straceLogger),
@@ -821,6 +946,15 @@ FuseChannel::FuseChannel(
       caseSensitive_{caseSensitive},
       requireUtf8Path_{requireUtf8Path},
       maximumBackgroundRequests_{maximumBackgroundRequests},
+      useSplice_{useSplice},
+      cloneDevicePerThread_{cloneDevicePerThread},
+      pinWorkerThreads_{pinWorkerThreads},
+      maxIoSize_{maxIoSize},
+      writebackCache_{writebackCache},
+      asyncDio_{asyncDio},
+      dispatchExecutor_{
+          dispatchThreads > 0 ? getDispatchExecutor(dispatchThreads)
+                              : nullptr},
       fuseDevice_(std::move(fuseDevice)),
       processAccessLog_(std::move(processNameCache)),
       traceDetailedArguments_(std::make_shared<std::atomic<size_t>>(0)),
@@ -866,6 +1000,12 @@ FuseChannel::FuseChannel(
                   fuseOpcodeName(opcode),
               });
             }
+            recordTraceSpan(TraceSpan{
+                event.monotonicTime - durationNs,
+                durationNs,
+                event.getUnique(),
+                "fuse",
+                fuseOpcodeName(event.getRequest().opcode)});
             break;
           }
         }
@@ -915,9 +1055,27 @@ void FuseChannel::startWorkerThreads() {
   }
 
   try {
+    if (cloneDevicePerThread_) {
+      clonedDevices_.reserve(numThreads_ - 1);
+      try {
+        while (clonedDevices_.size() < numThreads_ - 1) {
+          clonedDevices_.push_back(cloneFuseDevice());
+        }
+      } catch (const std::exception& ex) {
+        // Without any clone this is just the shared-queue setup; threads
+        // without a clone of their own share fuseDevice_.
+        XLOG(WARNING) << "unable to clone the FUSE device for " << mountPath_
+                      << ", " << clonedDevices_.size()
+                      << " worker threads will use a clone: "
+                      << exceptionStr(ex);
+      }
+    }
+
     state->workerThreads.reserve(numThreads_);
     while (state->workerThreads.size() < numThreads_) {
-      state->workerThreads.emplace_back([this] { fuseWorkerThread(); });
+      auto workerIndex = state->workerThreads.size();
+      state->workerThreads.emplace_back(
+          [this, workerIndex] { fuseWorkerThread(workerIndex); });
     }
 
     invalidationThread_ = std::thread([this] { invalidationThread(); });
@@ -1245,18 +1403,46 @@ void FuseChannel::initWorkerThread() noexcept {
   initPromise_.setValue(sessionCompletePromise_.getSemiFuture());
 
   // Continue to run like a normal FUSE worker thread.
-  fuseWorkerThread();
+  fuseWorkerThread(0);
+}
+
+folly::File FuseChannel::cloneFuseDevice() const {
+#ifdef __linux__
+  folly::File clone{"/dev/fuse", O_RDWR | O_CLOEXEC};
+  uint32_t sessionFd = fuseDevice_.fd();
+  if (ioctl(clone.fd(), FUSE_DEV_IOC_CLONE, &sessionFd) != 0) {
+    throwSystemError("FUSE_DEV_IOC_CLONE failed");
+  }
+  return clone;
+#else
+  throw std::runtime_error("cloning the FUSE device is not supported");
+#endif
 }
 
-void FuseChannel::fuseWorkerThread() noexcept {
+void FuseChannel::fuseWorkerThread(size_t workerIndex) noexcept {
   disablePthreadCancellation();
   setThreadName(to<std::string>("fuse", mountPath_.basename()));
   setThreadSigmask();
   *(liveRequestWatches_.get()) =
       std::make_shared<RequestMetricsScope::LockedRequestWatchList>();
 
+#ifdef __linux__
+  if (pinWorkerThreads_) {
+    auto numCpus = std::max(1u, std::thread::hardware_concurrency());
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(workerIndex % numCpus, &cpus);
+    auto err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (err != 0) {
+      XLOG(WARNING) << "unable to pin FUSE worker thread " << workerIndex
+                    << ": " << folly::errnoStr(err);
+    }
+  }
+#endif
+
   try {
-    processSession();
+    processSession(
+        workerIndex <= clonedDevices_.size() ? workerIndex : size_t{0});
   } catch (const std::exception& ex) {
     XLOG(ERR) << "unexpected error in FUSE worker thread: " << exceptionStr(ex);
     // Request that all other FUSE threads exit.
@@ -1317,14 +1503,75 @@ void FuseChannel::invalidationThread() noexcept {
       lockedQueue->queue.swap(entries);
     }
 
-    // Process all of the entries we found
-    for (auto& entry : entries) {
-      sendInvalidation(entry);
+    // Process all of the entries we found. A checkout commonly invalidates
+    // the same directory many times, so drop the duplicates first.
+    auto redundant = findRedundantInvalidations(entries);
+    size_t numSkipped = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+      if (redundant[i]) {
+        ++numSkipped;
+        continue;
+      }
+      sendInvalidation(entries[i]);
+    }
+    if (numSkipped) {
+      XLOG(DBG4) << "skipped " << numSkipped << " of " << entries.size()
+                 << " redundant invalidation requests";
     }
     entries.clear();
   }
 }
 
+namespace {
+struct DirEntryKeyHash {
+  size_t operator()(const std::pair<uint64_t, folly::StringPiece>& key) const {
+    return folly::hash::hash_combine(key.first, key.second);
+  }
+};
+} // namespace
+
+std::vector<bool> FuseChannel::findRedundantInvalidations(
+    const std::vector<InvalidationEntry>& entries) {
+  std::vector<bool> redundant(entries.size(), false);
+
+  // Walk backwards so that the last of the duplicate entries is the one that
+  // gets sent. Sending an invalidation later than it was requested is always
+  // correct, as long as it isn't moved past a FLUSH.
+  folly::F14FastSet<uint64_t> fullyInvalidatedInodes;
+  folly::F14FastSet<std::pair<uint64_t, folly::StringPiece>, DirEntryKeyHash>
+      invalidatedDirEntries;
+  for (size_t i = entries.size(); i-- > 0;) {
+    const auto& entry = entries[i];
+    switch (entry.type) {
+      case InvalidationType::INODE:
+        // FUSE_NOTIFY_INVAL_INODE always drops the attributes, and a zero
+        // offset and length drops all of the cached data too, so it covers
+        // any other invalidation of the same inode.
+        if (fullyInvalidatedInodes.count(entry.inode.get())) {
+          redundant[i] = true;
+        } else if (entry.range.offset == 0 && entry.range.length == 0) {
+          fullyInvalidatedInodes.insert(entry.inode.get());
+        }
+        break;
+      case InvalidationType::DIR_ENTRY:
+        // Note that invalidating a directory inode doesn't drop its cached
+        // children, so directory entries are only deduplicated among
+        // themselves.
+        if (!invalidatedDirEntries
+                 .emplace(entry.inode.get(), entry.name.stringPiece())
+                 .second) {
+          redundant[i] = true;
+        }
+        break;
+      case InvalidationType::FLUSH:
+        fullyInvalidatedInodes.clear();
+        invalidatedDirEntries.clear();
+        break;
+    }
+  }
+  return redundant;
+}
+
 void FuseChannel::stopInvalidationThread() {
   // Check that the thread is joinable just in case we were destroyed
   // before the invalidation thread was started.
@@ -1417,7 +1664,7 @@ void FuseChannel::readInitPacket() {
   fuse_init_out connInfo = {};
   connInfo.major = init.init.major;
   connInfo.minor = init.init.minor;
-  connInfo.max_write = bufferSize_ - 4096;
+  connInfo.max_write = bufferSize_ - kRequestHeaderRoom;
   connInfo.max_readahead = init.init.max_readahead;
 
   int32_t max_background = maximumBackgroundRequests_;
@@ -1437,9 +1684,10 @@ void FuseChannel::readInitPacket() {
   const auto capable = init.init.flags;
   auto& want = connInfo.flags;
 
-  // TODO: follow up and look at the new flags; particularly
-  // FUSE_DO_READDIRPLUS, FUSE_READDIRPLUS_AUTO. FUSE_SPLICE_XXX are interesting
-  // too, but may not directly benefit eden today.
+  // FUSE_DO_READDIRPLUS and FUSE_READDIRPLUS_AUTO are deliberately not
+  // requested: answering READDIRPLUS means loading every child inode of a
+  // listed directory, which defeats lazy loading for the common `ls` or
+  // directory walk that never stats most entries.
   //
   // FUSE_ATOMIC_O_TRUNC is a nice optimization when the kernel supports it
   // and the FUSE daemon requires handling open/release for stateful file
@@ -1453,6 +1701,15 @@ void FuseChannel::readInitPacket() {
   // We handle writes of any size.
   want |= FUSE_BIG_WRITES;
 
+#ifdef __linux__
+  // Requests may be read with splice(2), see processSession(). Replies are
+  // already sent with writev(2) straight from the blob or overlay buffers,
+  // so there is nothing to gain from FUSE_SPLICE_WRITE or FUSE_SPLICE_MOVE.
+  if (useSplice_ && (capable & FUSE_SPLICE_READ)) {
+    want |= FUSE_SPLICE_READ;
+  }
+#endif
+
 #ifdef __linux__
   // We don't support setuid and setgid mode bits anyway.
   want |= FUSE_HANDLE_KILLPRIV;
@@ -1463,6 +1720,23 @@ void FuseChannel::readInitPacket() {
   want |= FUSE_CACHE_SYMLINKS;
   // We can handle almost any request in parallel.
   want |= FUSE_PARALLEL_DIROPS;
+  // Let the kernel send reads and writes larger than its default of 32 pages,
+  // up to max_write; see below.
+  if (maxIoSize_ > 0) {
+    want |= FUSE_MAX_PAGES;
+  }
+  // The kernel caches buffered writes and sends them to us in larger chunks.
+  // Writes then no longer reach us in order with other requests, and the
+  // kernel becomes the authority on file size and mtime while pages are
+  // dirty, so this is opt-in.
+  if (writebackCache_) {
+    want |= FUSE_WRITEBACK_CACHE;
+  }
+  // Allow the kernel to submit direct I/O in parallel rather than one request
+  // at a time.
+  if (asyncDio_) {
+    want |= FUSE_ASYNC_DIO;
+  }
 #endif
 #ifdef FUSE_NO_OPEN_SUPPORT
   // File handles are stateless so the kernel does not need to send open() and
@@ -1485,6 +1759,14 @@ void FuseChannel::readInitPacket() {
   // Only return the capabilities the kernel supports.
   want &= capable;
 
+#ifdef __linux__
+  if (want & FUSE_MAX_PAGES) {
+    auto pageSize = static_cast<size_t>(getpagesize());
+    connInfo.max_pages = static_cast<uint16_t>(
+        (connInfo.max_write + pageSize - 1) / pageSize);
+  }
+#endif
+
   XLOG(DBG1) << "Speaking fuse protocol kernel=" << init.init.major << "."
              << init.init.minor << " local=" << FUSE_KERNEL_VERSION << "."
              << FUSE_KERNEL_MINOR_VERSION << " on mount \"" << mountPath_
@@ -1541,16 +1823,169 @@ void FuseChannel::readInitPacket() {
   dispatcher_->initConnection(connInfo);
 }
 
-void FuseChannel::processSession() {
-  std::vector<char> buf(bufferSize_);
+ssize_t FuseChannel::readSplicedRequest(
+    int deviceFd,
+    int pipeReadFd,
+    int pipeWriteFd,
+    std::vector<char>& buf,
+    size_t& splicedPayload) {
+#ifdef __linux__
+  auto length =
+      splice(deviceFd, nullptr, pipeWriteFd, nullptr, buf.size(), 0);
+  if (length <= 0) {
+    return length;
+  }
+  auto readFromPipe = [&](size_t offset, size_t size) {
+    auto ret = folly::readFull(pipeReadFd, buf.data() + offset, size);
+    if (ret >= 0 && static_cast<size_t>(ret) != size) {
+      errno = EIO;
+      return false;
+    }
+    return ret >= 0;
+  };
+
+  constexpr size_t kWriteHeadersSize =
+      sizeof(fuse_in_header) + sizeof(fuse_write_in);
+  auto headersSize = std::min(static_cast<size_t>(length), kWriteHeadersSize);
+  if (!readFromPipe(0, headersSize)) {
+    return -1;
+  }
+  auto remaining = static_cast<size_t>(length) - headersSize;
+
+  const auto* header = reinterpret_cast<const fuse_in_header*>(buf.data());
+  if (header->opcode == FUSE_WRITE && headersSize == kWriteHeadersSize &&
+      connInfo_->minor >= 9 && remaining >= kMinSpliceWriteSize) {
+    const auto* write = reinterpret_cast<const fuse_write_in*>(header + 1);
+    if (write->size == remaining) {
+      splicedPayload = remaining;
+      return headersSize;
+    }
+  }
+
+  if (remaining != 0 && !readFromPipe(headersSize, remaining)) {
+    return -1;
+  }
+  return length;
+#else
+  (void)pipeReadFd;
+  (void)pipeWriteFd;
+  (void)splicedPayload;
+  return read(deviceFd, buf.data(), buf.size());
+#endif
+}
+
+void FuseChannel::dispatchRequest(
+    const fuse_in_header* header,
+    ByteRange arg,
+    int splicePipeFd,
+    size_t splicedPayload) {
+  const auto& handlerEntry = *lookupFuseHandlerEntry(header->opcode);
+  // Requests handed to the dispatch pool run on threads that never went
+  // through fuseWorkerThread().
+  auto& liveRequestWatches = *(liveRequestWatches_.get());
+  if (!liveRequestWatches) {
+    liveRequestWatches =
+        std::make_shared<RequestMetricsScope::LockedRequestWatchList>();
+  }
+  auto requestId = generateUniqueID();
+  if (handlerEntry.argRenderer &&
+      traceDetailedArguments_->load(std::memory_order_acquire)) {
+    traceBus_->publish(FuseTraceEvent::start(
+        requestId, *header, handlerEntry.argRenderer(arg)));
+  } else {
+    traceBus_->publish(FuseTraceEvent::start(requestId, *header));
+  }
+
+  // This is a shared_ptr because, due to timeouts, the internal request
+  // lifetime may not match the FUSE request lifetime, so we capture it
+  // in both. I'm sure this could be improved with some cleverness.
+  auto request = RequestContext::makeSharedRequestContext<FuseRequestContext>(
+      this, *header);
+  if (splicedPayload != 0) {
+    request->setSplicedPayload({splicePipeFd, splicedPayload});
+  }
+
+  auto headerCopy = *header;
+
+  FB_LOG(*straceLogger_, DBG7, ([&]() -> std::string {
+    std::string rendered;
+    if (handlerEntry.argRenderer) {
+      rendered = handlerEntry.argRenderer(arg);
+    }
+    return fmt::format(
+        "{}({}{}{})",
+        handlerEntry.getShortName(),
+        headerCopy.nodeid,
+        rendered.empty() ? "" : ", ",
+        rendered);
+  })());
+
+  request
+      ->catchErrors(
+          folly::makeFutureWith([&] {
+            request->startRequest(
+                dispatcher_->getStats(), handlerEntry.stat, liveRequestWatches);
+            auto cpuTime = request->chargeCpuTime();
+            return (this->*handlerEntry.handler)(
+                       *request, request->getReq(), arg)
+                .semi()
+                .via(&folly::QueuedImmediateExecutor::instance());
+          }).ensure([request] {
+            }).within(requestTimeout_),
+          notifier_.get())
+      .ensure([this, request, requestId, headerCopy] {
+        // The kernel got its reply, either the result or a timeout
+        // error: imports still queued for this request are no
+        // longer needed. Those shared with other requests are only
+        // dropped once all of them gave up.
+        request->cancel();
+        traceBus_->publish(FuseTraceEvent::finish(
+            requestId, headerCopy, request->getResult()));
+
+        // We may be complete; check to see if all requests are
+        // done and whether there are any threads remaining.
+        auto state = state_.wlock();
+        XCHECK_NE(state->pendingRequests, 0u)
+            << "pendingRequests double decrement";
+        if (--state->pendingRequests == 0 &&
+            state->stoppedThreads == numThreads_) {
+          sessionComplete(std::move(state));
+        }
+      });
+}
+
+void FuseChannel::processSession(size_t deviceIndex) {
+  // After a takeover, connInfo_ may have been negotiated by a process with a
+  // larger buffer than ours.
+  std::vector<char> buf(
+      std::max(bufferSize_, connInfo_->max_write + kRequestHeaderRoom));
   // Save this for the sanity check later in the loop to avoid
   // additional syscalls on each loop iteration.
   auto myPid = getpid();
 
+  std::optional<SplicePipe> splicePipe;
+  if (connInfo_->flags & FUSE_SPLICE_READ) {
+    splicePipe = makeSplicePipe(buf.size());
+  }
+  size_t splicedPayload = 0;
+  const int deviceFd = deviceIndex == 0
+      ? fuseDevice_.fd()
+      : clonedDevices_[deviceIndex - 1].fd();
+
   while (!stop_.load(std::memory_order_relaxed)) {
-    // TODO: FUSE_SPLICE_READ allows using splice(2) here if we enable it.
-    // We can look at turning this on once the main plumbing is complete.
-    auto res = read(fuseDevice_.fd(), buf.data(), buf.size());
+    if (splicedPayload != 0) {
+      drainSplicePipe(splicePipe->readEnd.fd());
+      splicedPayload = 0;
+    }
+
+    auto res = splicePipe
+        ? readSplicedRequest(
+              deviceFd,
+              splicePipe->readEnd.fd(),
+              splicePipe->writeEnd.fd(),
+              buf,
+              splicedPayload)
+        : read(deviceFd, buf.data(), buf.size());
     if (UNLIKELY(res < 0)) {
       int error = errno;
       if (stop_.load(std::memory_order_relaxed)) {
@@ -1599,6 +2034,10 @@ void FuseChannel::processSession() {
       return;
     }
 
+    // The kernel leaves padding zero; tag the request with the device it
+    // came from so that replyDeviceFd() can route its reply.
+    reinterpret_cast<fuse_in_header*>(buf.data())->padding =
+        static_cast<uint32_t>(deviceIndex);
     const auto* header = reinterpret_cast<fuse_in_header*>(buf.data());
     const ByteRange arg{
         reinterpret_cast<const uint8_t*>(header + 1),
@@ -1733,67 +2172,44 @@ void FuseChannel::processSession() {
 
       default: {
         if (handlerEntry && handlerEntry->handler) {
-          auto requestId = generateUniqueID();
-          if (handlerEntry->argRenderer &&
-              traceDetailedArguments_->load(std::memory_order_acquire)) {
-            traceBus_->publish(FuseTraceEvent::start(
-                requestId, *header, handlerEntry->argRenderer(arg)));
-          } else {
-            traceBus_->publish(FuseTraceEvent::start(requestId, *header));
-          }
-
-          // This is a shared_ptr because, due to timeouts, the internal request
-          // lifetime may not match the FUSE request lifetime, so we capture it
-          // in both. I'm sure this could be improved with some cleverness.
-          auto request =
-              RequestContext::makeSharedRequestContext<FuseRequestContext>(
-                  this, *header);
-
           ++state_.wlock()->pendingRequests;
 
-          auto headerCopy = *header;
-
-          FB_LOG(*straceLogger_, DBG7, ([&]() -> std::string {
-            std::string rendered;
-            if (handlerEntry->argRenderer) {
-              rendered = handlerEntry->argRenderer(arg);
-            }
-            return fmt::format(
-                "{}({}{}{})",
-                handlerEntry->getShortName(),
-                headerCopy.nodeid,
-                rendered.empty() ? "" : ", ",
-                rendered);
-          })());
-
-          request
-              ->catchErrors(
-                  folly::makeFutureWith([&] {
-                    request->startRequest(
-                        dispatcher_->getStats(),
-                        handlerEntry->stat,
-                        *(liveRequestWatches_.get()));
-                    return (this->*handlerEntry->handler)(
-                               *request, request->getReq(), arg)
-                        .semi()
-                        .via(&folly::QueuedImmediateExecutor::instance());
-                  }).ensure([request] {
-                    }).within(requestTimeout_),
-                  notifier_.get())
-              .ensure([this, request, requestId, headerCopy] {
-                traceBus_->publish(FuseTraceEvent::finish(
-                    requestId, headerCopy, request->getResult()));
-
-                // We may be complete; check to see if all requests are
-                // done and whether there are any threads remaining.
-                auto state = state_.wlock();
-                XCHECK_NE(state->pendingRequests, 0u)
-                    << "pendingRequests double decrement";
-                if (--state->pendingRequests == 0 &&
-                    state->stoppedThreads == numThreads_) {
-                  sessionComplete(std::move(state));
-                }
-              });
+          if (dispatchExecutor_ && splicedPayload == 0) {
+            // Hand the request to the dispatch pool so that this thread goes
+            // straight back to reading. buf is about to be reused, so the
+            // pool gets its own copy of the request.
+            auto copy = folly::IOBuf::copyBuffer(buf.data(), arg_size);
+            bool readWrite =
+                header->opcode == FUSE_READ || header->opcode == FUSE_WRITE;
+            dispatchExecutor_->addWithPriority(
+                [this,
+                 copy = std::move(copy),
+                 readWrite,
+                 enqueued = std::chrono::steady_clock::now()] {
+                  dispatcher_->getStats()
+                      ->getChannelStatsForCurrentThread()
+                      .recordLatency(
+                          readWrite
+                              ? &ChannelThreadStats::dispatchWaitReadWrite
+                              : &ChannelThreadStats::dispatchWaitMetadata,
+                          std::chrono::duration_cast<std::chrono::microseconds>(
+                              std::chrono::steady_clock::now() - enqueued));
+                  dispatchRequest(
+                      reinterpret_cast<const fuse_in_header*>(copy->data()),
+                      ByteRange{
+                          copy->data() + sizeof(fuse_in_header),
+                          copy->length() - sizeof(fuse_in_header)},
+                      -1,
+                      0);
+                },
+                readWrite ? folly::Executor::LO_PRI : folly::Executor::HI_PRI);
+          } else {
+            dispatchRequest(
+                header,
+                arg,
+                splicePipe ? splicePipe->readEnd.fd() : -1,
+                splicedPayload);
+          }
           break;
         }
 
@@ -1882,6 +2298,21 @@ ImmediateFuture<folly::Unit> FuseChannel::fuseWrite(
   XLOG(DBG7) << "FUSE_WRITE " << write->size << " @" << write->offset;
 
   auto ino = InodeNumber{header.nodeid};
+  if (auto payload = request.takeSplicedPayload()) {
+    if (auto written = dispatcher_->trySpliceWrite(
+            ino, payload->pipeFd, write->size, write->offset)) {
+      fuse_write_out out = {};
+      out.size = *written;
+      request.sendReply(out);
+      return folly::unit;
+    }
+    // processSession() left room for the payload after the headers.
+    auto ret = folly::readFull(
+        payload->pipeFd, const_cast<char*>(bufPtr), payload->size);
+    if (ret < 0 || static_cast<size_t>(ret) != payload->size) {
+      throwSystemError("unable to read the FUSE_WRITE payload from its pipe");
+    }
+  }
   return dispatcher_
       ->write(
           ino, folly::StringPiece{bufPtr, write->size}, write->offset, request)
@@ -2420,10 +2851,7 @@ ImmediateFuture<folly::Unit> FuseChannel::fuseBatchForget(
   const auto end = item + forgets->count;
   XLOG(DBG7) << "FUSE_BATCH_FORGET";
 
-  while (item != end) {
-    dispatcher_->forget(InodeNumber{item->nodeid}, item->nlookup);
-    ++item;
-  }
+  dispatcher_->batchForget(folly::Range<const fuse_forget_one*>{item, end});
   request.replyNone();
   return folly::unit;
 }
@@ -2466,12 +2894,21 @@ size_t FuseChannel::getRequestMetric(
     RequestMetricsScope::RequestMetric metric) const {
   std::vector<size_t> counters;
   for (auto& thread_watches : liveRequestWatches_.accessAllThreads()) {
+    // Dispatch pool threads fill theirs in on their first request.
+    if (!thread_watches) {
+      continue;
+    }
     counters.emplace_back(
         RequestMetricsScope::getMetricFromWatches(metric, *thread_watches));
   }
   return RequestMetricsScope::aggregateMetricCounters(metric, counters);
 }
 
+size_t FuseChannel::getDispatchQueueDepth() {
+  auto* executor = sharedDispatchExecutor.load(std::memory_order_acquire);
+  return executor ? executor->getPendingTaskCount() : 0;
+}
+
 } // namespace facebook::eden
 
 #endif
@@ -35,6 +35,7 @@
 #include "eden/fs/utils/ProcessAccessLog.h"
 
 namespace folly {
+class CPUThreadPoolExecutor;
 struct Unit;
 } // namespace folly
 
@@ -232,7 +233,14 @@ class FuseChannel {
       std::shared_ptr<Notifier> notifier,
       CaseSensitivity caseSensitive,
       bool requireUtf8Path,
-      int32_t maximumBackgroundRequests);
+      int32_t maximumBackgroundRequests,
+      bool useSplice = false,
+      bool cloneDevicePerThread = false,
+      bool pinWorkerThreads = false,
+      size_t maxIoSize = 0,
+      bool writebackCache = false,
+      bool asyncDio = false,
+      size_t dispatchThreads = 0);
 
   /**
    * Destroy the FuseChannel.
@@ -451,6 +459,14 @@ class FuseChannel {
     return *traceBus_;
   }
 
+  /**
+   * The connection parameters negotiated with the kernel, such as its FUSE
+   * protocol version. Only set once initialization completed.
+   */
+  const std::optional<fuse_init_out>& getConnInfo() const {
+    return connInfo_;
+  }
+
   ProcessAccessLog& getProcessAccessLog() {
     return processAccessLog_;
   }
@@ -461,6 +477,12 @@ class FuseChannel {
 
   size_t getRequestMetric(RequestMetricsScope::RequestMetric metric) const;
 
+  /**
+   * The number of requests waiting in the dispatch pool shared by all mounts
+   * that set fuse:dispatch-threads, or 0 if no mount uses it.
+   */
+  static size_t getDispatchQueueDepth();
+
  private:
   /**
    * All of our mutable state that may be accessed from the worker threads,
@@ -688,8 +710,32 @@ class FuseChannel {
  private:
   void setThreadSigmask();
   void initWorkerThread() noexcept;
-  void fuseWorkerThread() noexcept;
+  void fuseWorkerThread(size_t workerIndex) noexcept;
+  /**
+   * Open a new /dev/fuse descriptor attached to the same connection as
+   * fuseDevice_ via FUSE_DEV_IOC_CLONE. Requests read from the clone must be
+   * answered on the clone. Throws on failure.
+   */
+  folly::File cloneFuseDevice() const;
+  /**
+   * Return the device fd that the given request was read from, and thus the
+   * one its reply must be written to.
+   */
+  int replyDeviceFd(const fuse_in_header& request) const;
+  /**
+   * sendRawReply() to a specific device fd.
+   */
+  void sendRawReply(int deviceFd, const iovec iov[], size_t count) const;
   void invalidationThread() noexcept;
+  /**
+   * Return, for each of the entries, whether sending it is redundant because
+   * a later entry before the next FLUSH makes the kernel drop the same
+   * cached data. Such entries can be skipped without weakening any
+   * flushInvalidations() guarantee, as the later entry is sent before the
+   * flush completes.
+   */
+  static std::vector<bool> findRedundantInvalidations(
+      const std::vector<InvalidationEntry>& entries);
   void stopInvalidationThread();
   void sendInvalidation(InvalidationEntry& entry);
   void sendInvalidateInode(InodeNumber ino, int64_t off, int64_t len);
@@ -722,9 +768,35 @@ class FuseChannel {
    * Dispatches fuse requests until the session is torn down.
    * This function blocks until the fuse session is stopped.
    * The intent is that this is called from each of the
-   * fuse worker threads provided by the MountPoint.
+   * fuse worker threads provided by the MountPoint, reading requests from
+   * the device with the given index (0 is fuseDevice_, i is
+   * clonedDevices_[i - 1]).
+   */
+  void processSession(size_t deviceIndex);
+
+  /**
+   * Runs one request through its handler. The request and arg only need to
+   * stay valid until this returns. splicedPayload is the size of a FUSE_WRITE
+   * payload left in splicePipeFd, or 0.
    */
-  void processSession();
+  void dispatchRequest(
+      const fuse_in_header* header,
+      folly::ByteRange arg,
+      int splicePipeFd,
+      size_t splicedPayload);
+
+  /**
+   * Splice the next request from the FUSE device into a pipe and read it
+   * into buf, like read(2) from the device would. A large enough FUSE_WRITE
+   * payload is left in the pipe instead, in which case splicedPayload is set
+   * to its size and only the request headers are read and counted.
+   */
+  ssize_t readSplicedRequest(
+      int deviceFd,
+      int pipeReadFd,
+      int pipeWriteFd,
+      std::vector<char>& buf,
+      size_t& splicedPayload);
 
   /**
    * Requests that the worker threads terminate their processing loop.
@@ -747,6 +819,39 @@ class FuseChannel {
   CaseSensitivity caseSensitive_;
   bool requireUtf8Path_;
   int32_t maximumBackgroundRequests_;
+  /**
+   * Whether the worker threads splice(2) requests from the FUSE device into a
+   * pipe, so that write payloads can be spliced on into the overlay. Linux
+   * only.
+   */
+  const bool useSplice_;
+  /**
+   * Whether each worker thread reads from its own clone of the FUSE device,
+   * so that the kernel keeps a separate processing queue per thread instead
+   * of every thread contending on the one queue. Linux only.
+   */
+  const bool cloneDevicePerThread_;
+  /**
+   * Whether each worker thread is pinned to one CPU, round-robin by worker
+   * index. Linux only.
+   */
+  const bool pinWorkerThreads_;
+  /**
+   * If non-zero, the largest read or write the kernel may send in one
+   * request, negotiated with FUSE_MAX_PAGES. 0 keeps the kernel default.
+   */
+  const size_t maxIoSize_;
+  /** Whether to request FUSE_WRITEBACK_CACHE. */
+  const bool writebackCache_;
+  /** Whether to request FUSE_ASYNC_DIO. */
+  const bool asyncDio_;
+  /**
+   * If set, worker threads only read requests and hand them to this pool,
+   * metadata requests ahead of reads and writes. It is shared by all mounts
+   * and never destroyed, since a FuseChannel may delete itself on one of its
+   * threads.
+   */
+  folly::CPUThreadPoolExecutor* const dispatchExecutor_;
 
   /*
    * connInfo_ is modified during the initialization process,
@@ -772,6 +877,19 @@ class FuseChannel {
    */
   folly::File fuseDevice_;
 
+  /*
+   * Clones of fuseDevice_ read by worker threads 1..N-1, empty unless
+   * cloneDevicePerThread_ is set and cloning succeeded. Filled in by
+   * startWorkerThreads() before the threads that use them are started, and
+   * constant afterwards.
+   *
+   * A request read from clonedDevices_[i - 1] is tagged with i in the
+   * otherwise unused fuse_in_header::padding of our copy of the header, so
+   * that its reply is routed back to the same descriptor from whichever
+   * thread completes it.
+   */
+  std::vector<folly::File> clonedDevices_;
+
   /*
    * Mutable state that is accessed from the worker threads.
    * All of this state uses locking or other synchronization.
@@ -73,6 +73,12 @@ ImmediateFuture<fuse_entry_out> FuseDispatcher::lookup(
 
 void FuseDispatcher::forget(InodeNumber /*ino*/, unsigned long /*nlookup*/) {}
 
+void FuseDispatcher::batchForget(folly::Range<const fuse_forget_one*> forgets) {
+  for (const auto& forget : forgets) {
+    this->forget(InodeNumber{forget.nodeid}, forget.nlookup);
+  }
+}
+
 ImmediateFuture<FuseDispatcher::Attr> FuseDispatcher::getattr(
     InodeNumber /*ino*/,
     ObjectFetchContext& /*context*/) {
@@ -183,6 +189,11 @@ ImmediateFuture<size_t> FuseDispatcher::write(
   FUSELL_NOT_IMPL();
 }
 
+std::optional<size_t>
+FuseDispatcher::trySpliceWrite(InodeNumber, int, size_t, off_t) {
+  return std::nullopt;
+}
+
 ImmediateFuture<folly::Unit> FuseDispatcher::flush(InodeNumber, uint64_t) {
   FUSELL_NOT_IMPL();
 }
@@ -10,6 +10,7 @@
 #include <folly/Portability.h>
 #include <folly/Range.h>
 #include <sys/statvfs.h>
+#include <optional>
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/store/IObjectStore.h"
 #include "eden/fs/utils/BufVec.h"
@@ -85,6 +86,13 @@ class FuseDispatcher {
    */
   virtual void forget(InodeNumber ino, unsigned long nlookup);
 
+  /**
+   * Forget about several inodes at once, as sent by FUSE_BATCH_FORGET.
+   *
+   * The default implementation calls forget() for each entry.
+   */
+  virtual void batchForget(folly::Range<const fuse_forget_one*> forgets);
+
   /**
    * The stat information and the cache TTL for the kernel
    *
@@ -317,6 +325,15 @@ class FuseDispatcher {
       off_t off,
       ObjectFetchContext& context);
 
+  /**
+   * Write size bytes, read from the pipe pipeFd, at off, if that can be done
+   * right away by splicing them straight into the file's storage. Otherwise
+   * return std::nullopt without reading from the pipe, and the caller falls
+   * back to write().
+   */
+  virtual std::optional<size_t>
+  trySpliceWrite(InodeNumber ino, int pipeFd, size_t size, off_t off);
+
   /**
    * This is called on each close() of the opened file.
    *
@@ -9,6 +9,7 @@
 
 #include <folly/futures/Future.h>
 #include <atomic>
+#include <optional>
 #include <utility>
 
 #include "eden/fs/fuse/FuseChannel.h"
@@ -65,6 +66,27 @@ class FuseRequestContext : public RequestContext {
    */
   const fuse_in_header& getReq() const;
 
+  /**
+   * The payload of a FUSE_WRITE that FuseChannel left in the pipe it spliced
+   * the request into, rather than reading it into the request buffer.
+   */
+  struct SplicedPayload {
+    int pipeFd;
+    size_t size;
+  };
+
+  void setSplicedPayload(SplicedPayload payload) {
+    splicedPayload_ = payload;
+  }
+
+  /**
+   * Returns the spliced payload, if any, which the caller then has to consume
+   * before the request handler returns.
+   */
+  std::optional<SplicedPayload> takeSplicedPayload() {
+    return std::exchange(splicedPayload_, std::nullopt);
+  }
+
   /**
    * Append error handling clauses to a future chain. These clauses result in
    * reporting a fuse request error back to the kernel.
@@ -130,6 +152,8 @@ class FuseRequestContext : public RequestContext {
   const fuse_in_header fuseHeader_;
 
   std::optional<int64_t> result_;
+
+  std::optional<SplicedPayload> splicedPayload_;
 };
 
 } // namespace facebook::eden
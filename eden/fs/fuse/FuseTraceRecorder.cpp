@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/fuse/FuseTraceRecorder.h"
+
+#include <fcntl.h>
+#include <fmt/format.h>
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+#include <folly/lang/Bits.h>
+#include <folly/logging/xlog.h>
+
+#include "eden/fs/utils/FileUtils.h"
+
+namespace facebook::eden {
+
+namespace {
+
+/** Write the buffered records once they reach this size. */
+constexpr size_t kWriteBufferSize = 1024 * 1024;
+
+/**
+ * The size of a record without its arguments: type, flags, 2 bytes of
+ * padding, opcode, time, unique, nodeid, pid, size of the arguments and
+ * result.
+ */
+constexpr size_t kFixedRecordSize = 1 + 1 + 2 + 4 + 8 + 8 + 8 + 4 + 4 + 8;
+
+/** Set in the flags of FINISH records that have a result. */
+constexpr uint8_t kHasResult = 1;
+
+template <typename T>
+void appendLE(std::string& buffer, T value) {
+  value = folly::Endian::little(value);
+  buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+} // namespace
+
+class FuseTraceRecorder::Writer : public TraceEventSubscriber<FuseTraceEvent> {
+ public:
+  Writer(folly::File file, folly::Promise<folly::Unit> closed)
+      : TraceEventSubscriber{"fuse-trace-recorder"},
+        file_{std::move(file)},
+        closed_{std::move(closed)} {
+    appendLE(buffer_, kFuseTraceMagic);
+    appendLE(buffer_, kFuseTraceVersion);
+  }
+
+  ~Writer() override {
+    try {
+      flush();
+      file_.close();
+      closed_.setValue();
+    } catch (const std::exception& ex) {
+      XLOG(ERR) << "error finishing FUSE trace recording: "
+                << folly::exceptionStr(ex);
+      closed_.setException(folly::exception_wrapper{std::current_exception()});
+    }
+  }
+
+  void observeBatch(const FuseTraceEvent* begin, const FuseTraceEvent* end)
+      override {
+    for (auto* event = begin; event != end; ++event) {
+      append(*event);
+    }
+    if (buffer_.size() >= kWriteBufferSize) {
+      // Throwing unsubscribes this writer, which then closes the file.
+      flush();
+    }
+  }
+
+ private:
+  void append(const FuseTraceEvent& event) {
+    if (!start_) {
+      start_ = event.monotonicTime;
+    }
+
+    const auto& request = event.getRequest();
+    std::optional<int64_t> result;
+    const std::string* arguments = nullptr;
+    if (event.getType() == FuseTraceEvent::START) {
+      arguments = event.getArguments().get();
+    } else {
+      result = event.getResponseCode();
+    }
+    auto argumentsSize = arguments ? arguments->size() : 0;
+
+    auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        event.monotonicTime - *start_);
+
+    appendLE(buffer_, static_cast<uint8_t>(event.getType()));
+    appendLE(buffer_, static_cast<uint8_t>(result ? kHasResult : 0));
+    appendLE(buffer_, uint16_t{0});
+    appendLE(buffer_, request.opcode);
+    appendLE(buffer_, static_cast<int64_t>(time.count()));
+    appendLE(buffer_, event.getUnique());
+    appendLE(buffer_, request.nodeid);
+    appendLE(buffer_, request.pid);
+    appendLE(buffer_, static_cast<uint32_t>(argumentsSize));
+    appendLE(buffer_, result.value_or(0));
+    if (arguments) {
+      buffer_.append(*arguments);
+    }
+  }
+
+  void flush() {
+    if (buffer_.empty()) {
+      return;
+    }
+    auto written = folly::writeFull(file_.fd(), buffer_.data(), buffer_.size());
+    buffer_.clear();
+    if (written < 0) {
+      folly::throwSystemError("error writing FUSE trace recording");
+    }
+  }
+
+  folly::File file_;
+  folly::Promise<folly::Unit> closed_;
+  std::string buffer_;
+  std::optional<std::chrono::steady_clock::time_point> start_;
+};
+
+FuseTraceRecorder::FuseTraceRecorder(
+    FuseChannel& channel,
+    AbsolutePathPiece outputPath)
+    : outputPath_{outputPath} {
+  folly::File file{
+      outputPath_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600};
+  auto [promise, future] = folly::makePromiseContract<folly::Unit>();
+  closed_ = std::move(future);
+  // Ask for the arguments before subscribing, so that the requests of the
+  // recording all have theirs.
+  argumentsHandle_ = channel.traceDetailedArguments();
+  subscription_ = channel.getTraceBus().subscribe(
+      std::make_shared<Writer>(std::move(file), std::move(promise)));
+}
+
+FuseTraceRecorder::~FuseTraceRecorder() = default;
+
+folly::SemiFuture<folly::Unit> FuseTraceRecorder::stop() {
+  subscription_.reset();
+  argumentsHandle_.reset();
+  return std::move(closed_);
+}
+
+std::vector<FuseTraceRecord> readFuseTrace(AbsolutePathPiece path) {
+  auto contents = readFile(path).value();
+
+  auto buf = folly::IOBuf::wrapBufferAsValue(contents.data(), contents.size());
+  folly::io::Cursor cursor{&buf};
+  if (!cursor.canAdvance(8) || cursor.readLE<uint32_t>() != kFuseTraceMagic) {
+    throw std::runtime_error(
+        fmt::format("{} is not a FUSE trace recording", path));
+  }
+  auto version = cursor.readLE<uint32_t>();
+  if (version != kFuseTraceVersion) {
+    throw std::runtime_error(fmt::format(
+        "unsupported version {} of FUSE trace recording {}", version, path));
+  }
+
+  std::vector<FuseTraceRecord> records;
+  while (cursor.canAdvance(kFixedRecordSize)) {
+    FuseTraceRecord record;
+    record.type = static_cast<FuseTraceEvent::Type>(cursor.readLE<uint8_t>());
+    auto flags = cursor.readLE<uint8_t>();
+    cursor.skip(sizeof(uint16_t));
+    record.opcode = cursor.readLE<uint32_t>();
+    record.time = std::chrono::nanoseconds{cursor.readLE<int64_t>()};
+    record.unique = cursor.readLE<uint64_t>();
+    record.nodeid = cursor.readLE<uint64_t>();
+    record.pid = cursor.readLE<uint32_t>();
+    auto argumentsSize = cursor.readLE<uint32_t>();
+    auto result = cursor.readLE<int64_t>();
+    if (flags & kHasResult) {
+      record.result = result;
+    }
+    if (!cursor.canAdvance(argumentsSize)) {
+      XLOG(WARN) << "FUSE trace recording " << path << " is truncated";
+      break;
+    }
+    record.arguments = cursor.readFixedString(argumentsSize);
+    records.push_back(std::move(record));
+  }
+  return records;
+}
+
+} // namespace facebook::eden
+
+#endif
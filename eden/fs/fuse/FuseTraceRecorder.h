@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/futures/Future.h>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "eden/fs/fuse/FuseChannel.h"
+#include "eden/fs/telemetry/TraceBus.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * One FuseTraceEvent, as read back from a recording.
+ *
+ * A recording is a compact binary file meant to be replayed, as opposed to
+ * the activity and strace streams meant to be read by humans. It starts with
+ * kFuseTraceMagic and kFuseTraceVersion, as little-endian 32-bit integers,
+ * followed by one record per event in the order they were published. Each
+ * record is a fixed-size header of little-endian fields followed by the bytes
+ * of its arguments.
+ */
+struct FuseTraceRecord {
+  FuseTraceEvent::Type type;
+  /** The time of the event, since the first event of the recording. */
+  std::chrono::nanoseconds time;
+  /** Our permanently unique ID of the request, see FuseTraceEvent. */
+  uint64_t unique;
+  uint64_t nodeid;
+  uint32_t opcode;
+  uint32_t pid;
+  /**
+   * Only set for FINISH records of requests that were answered, as
+   * FuseTraceEvent::getResponseCode().
+   */
+  std::optional<int64_t> result;
+  /**
+   * The detailed arguments of START records, as rendered by FuseChannel:
+   * the name of a LOOKUP, "off=..., len=..." for a READ, etc.
+   */
+  std::string arguments;
+};
+
+constexpr uint32_t kFuseTraceMagic = 0x45465452; // "EFTR"
+constexpr uint32_t kFuseTraceVersion = 1;
+
+/**
+ * Read every record of the recording at path.
+ *
+ * Throws if the file can't be read, or isn't a recording of a supported
+ * version. A record truncated by a crash of the recording process ends the
+ * recording.
+ */
+std::vector<FuseTraceRecord> readFuseTrace(AbsolutePathPiece path);
+
+/**
+ * Records the requests of a FuseChannel into a new file, with their detailed
+ * arguments, from construction until stop() is called or the recorder is
+ * destroyed.
+ *
+ * Events are written from the channel's TraceBus thread, in large buffered
+ * writes, so recording only slows down requests if the disk can't keep up.
+ */
+class FuseTraceRecorder {
+ public:
+  /**
+   * Start recording. Throws if the file at outputPath can't be created.
+   */
+  FuseTraceRecorder(FuseChannel& channel, AbsolutePathPiece outputPath);
+  ~FuseTraceRecorder();
+
+  FuseTraceRecorder(const FuseTraceRecorder&) = delete;
+  FuseTraceRecorder& operator=(const FuseTraceRecorder&) = delete;
+
+  const AbsolutePath& getOutputPath() const {
+    return outputPath_;
+  }
+
+  /**
+   * Stop recording. The returned future completes once every event
+   * published until now was written and the file was closed.
+   */
+  folly::SemiFuture<folly::Unit> stop();
+
+ private:
+  class Writer;
+
+  AbsolutePath outputPath_;
+  folly::SemiFuture<folly::Unit> closed_{
+      folly::SemiFuture<folly::Unit>::makeEmpty()};
+  TraceDetailedArgumentsHandle argumentsHandle_;
+  TraceBus<FuseTraceEvent>::SubscriptionHandle subscription_;
+};
+
+} // namespace facebook::eden
@@ -18,6 +18,8 @@
 #include <folly/Format.h>
 #include <folly/SocketAddress.h>
 #include <folly/String.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
 #include <folly/init/Init.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
@@ -60,6 +62,14 @@ using std::string;
 
 namespace facebook::eden {
 
+namespace {
+/**
+ * Mounts mostly wait on the kernel, and on macOS on a fixed grace period, so
+ * a few threads are enough to overlap the mounts of all the checkouts.
+ */
+constexpr size_t kNumMountThreads = 8;
+} // namespace
+
 PrivHelperServer::PrivHelperServer() {}
 
 PrivHelperServer::~PrivHelperServer() {}
@@ -88,6 +98,9 @@ void PrivHelperServer::initPartial(folly::File&& socket, uid_t uid, gid_t gid) {
   // NotificationQueue code checks to ensure that it isn't used across a fork.
   eventBase_ = std::make_unique<folly::EventBase>();
   conn_ = UnixSocket::makeUnique(eventBase_.get(), std::move(socket));
+  mountThreads_ = std::make_unique<folly::CPUThreadPoolExecutor>(
+      kNumMountThreads,
+      std::make_shared<folly::NamedThreadFactory>("PrivHelperMount"));
   uid_ = uid;
   gid_ = gid;
 
@@ -837,7 +850,7 @@ UnixSocket::Message PrivHelperServer::processTakeoverStartupMsg(
 
   sanityCheckMountPoint(mountPath);
 
-  mountPoints_.insert(mountPath);
+  mountPoints_.wlock()->insert(mountPath);
   return makeResponse();
 }
 
@@ -850,7 +863,7 @@ UnixSocket::Message PrivHelperServer::processMountMsg(Cursor& cursor) {
   sanityCheckMountPoint(mountPath);
 
   auto fuseDev = fuseMount(mountPath.c_str(), readOnly);
-  mountPoints_.insert(mountPath);
+  mountPoints_.wlock()->insert(mountPath);
 
   return makeResponse(std::move(fuseDev));
 }
@@ -873,7 +886,7 @@ UnixSocket::Message PrivHelperServer::processMountNfsMsg(Cursor& cursor) {
   sanityCheckMountPoint(mountPath);
 
   nfsMount(mountPath, mountdAddr, nfsdAddr, readOnly, iosize, useReaddirplus);
-  mountPoints_.insert(mountPath);
+  mountPoints_.wlock()->insert(mountPath);
 
   return makeResponse();
 }
@@ -883,14 +896,13 @@ UnixSocket::Message PrivHelperServer::processUnmountMsg(Cursor& cursor) {
   PrivHelperConn::parseUnmountRequest(cursor, mountPath);
   XLOG(DBG3) << "unmount \"" << mountPath << "\"";
 
-  const auto it = mountPoints_.find(mountPath);
-  if (it == mountPoints_.end()) {
+  if (mountPoints_.rlock()->count(mountPath) == 0) {
     throw std::domain_error(
         folly::to<string>("No FUSE mount found for ", mountPath));
   }
 
   unmount(mountPath.c_str());
-  mountPoints_.erase(mountPath);
+  mountPoints_.wlock()->erase(mountPath);
   return makeResponse();
 }
 
@@ -899,14 +911,13 @@ UnixSocket::Message PrivHelperServer::processNfsUnmountMsg(Cursor& cursor) {
   PrivHelperConn::parseNfsUnmountRequest(cursor, mountPath);
   XLOG(DBG3) << "unmount \"" << mountPath << "\"";
 
-  const auto it = mountPoints_.find(mountPath);
-  if (it == mountPoints_.end()) {
+  if (mountPoints_.rlock()->count(mountPath) == 0) {
     throw std::domain_error(
         folly::to<string>("No NFS mount found for ", mountPath));
   }
 
   unmount(mountPath.c_str());
-  mountPoints_.erase(mountPath);
+  mountPoints_.wlock()->erase(mountPath);
   return makeResponse();
 }
 
@@ -916,18 +927,18 @@ UnixSocket::Message PrivHelperServer::processTakeoverShutdownMsg(
   PrivHelperConn::parseTakeoverShutdownRequest(cursor, mountPath);
   XLOG(DBG3) << "takeover shutdown \"" << mountPath << "\"";
 
-  const auto it = mountPoints_.find(mountPath);
-  if (it == mountPoints_.end()) {
+  if (mountPoints_.rlock()->count(mountPath) == 0) {
     throw std::domain_error(
         folly::to<string>("No mount found for ", mountPath));
   }
 
-  mountPoints_.erase(mountPath);
+  mountPoints_.wlock()->erase(mountPath);
   return makeResponse();
 }
 
 std::string PrivHelperServer::findMatchingMountPrefix(folly::StringPiece path) {
-  for (const auto& mountPoint : mountPoints_) {
+  auto mountPoints = mountPoints_.rlock();
+  for (const auto& mountPoint : *mountPoints) {
     if (boost::starts_with(path, mountPoint + "/")) {
       return mountPoint;
     }
@@ -1083,6 +1094,10 @@ void PrivHelperServer::run() {
   // too.
   XLOG(DBG5) << "privhelper process exiting";
 
+  // Let the mount requests that are still running finish, so that the mount
+  // points they add get cleaned up below. Their responses are never sent.
+  mountThreads_->join();
+
   // Unmount all active mount points
   cleanupMountPoints();
 }
@@ -1098,6 +1113,45 @@ void PrivHelperServer::messageReceived(UnixSocket::Message&& message) noexcept {
 
 void PrivHelperServer::processAndSendResponse(UnixSocket::Message&& message) {
   Cursor cursor{&message.data};
+  cursor.skip(sizeof(uint32_t)); // xid
+  const auto msgType =
+      static_cast<PrivHelperConn::MsgType>(cursor.readBE<uint32_t>());
+  if (!isMountRequest(msgType)) {
+    conn_->send(processRequest(message));
+    return;
+  }
+
+  mountThreads_->add([this, message = std::move(message)]() mutable {
+    try {
+      auto response = processRequest(message);
+      eventBase_->runInEventBaseThread(
+          [this, response = std::move(response)]() mutable {
+            conn_->send(std::move(response));
+          });
+    } catch (const std::exception& ex) {
+      XLOG(ERR) << "error processing privhelper request: "
+                << folly::exceptionStr(ex);
+    }
+  });
+}
+
+bool PrivHelperServer::isMountRequest(PrivHelperConn::MsgType msgType) {
+  switch (msgType) {
+    case PrivHelperConn::REQ_MOUNT_FUSE:
+    case PrivHelperConn::REQ_MOUNT_NFS:
+    case PrivHelperConn::REQ_MOUNT_BIND:
+    case PrivHelperConn::REQ_UNMOUNT_FUSE:
+    case PrivHelperConn::REQ_UNMOUNT_NFS:
+    case PrivHelperConn::REQ_UNMOUNT_BIND:
+      return true;
+    default:
+      return false;
+  }
+}
+
+UnixSocket::Message PrivHelperServer::processRequest(
+    UnixSocket::Message& message) {
+  Cursor cursor{&message.data};
   const auto xid = cursor.readBE<uint32_t>();
   const auto msgType =
       static_cast<PrivHelperConn::MsgType>(cursor.readBE<uint32_t>());
@@ -1137,7 +1191,7 @@ void PrivHelperServer::processAndSendResponse(UnixSocket::Message&& message) {
   respCursor.writeBE<uint32_t>(xid);
   respCursor.writeBE<uint32_t>(responseType);
 
-  conn_->send(std::move(response));
+  return response;
 }
 
 UnixSocket::Message PrivHelperServer::makeResponse() {
@@ -1211,7 +1265,8 @@ void PrivHelperServer::receiveError(
 }
 
 void PrivHelperServer::cleanupMountPoints() {
-  for (const auto& mountPoint : mountPoints_) {
+  auto mountPoints = mountPoints_.wlock();
+  for (const auto& mountPoint : *mountPoints) {
     try {
       unmount(mountPoint.c_str());
     } catch (const std::exception& ex) {
@@ -1220,7 +1275,7 @@ void PrivHelperServer::cleanupMountPoints() {
     }
   }
 
-  mountPoints_.clear();
+  mountPoints->clear();
 }
 
 } // namespace facebook::eden
@@ -7,8 +7,10 @@
 
 #pragma once
 
+#include <folly/Synchronized.h>
 #include <sys/types.h>
 #include <limits>
+#include <memory>
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -16,6 +18,7 @@
 #include "eden/fs/utils/UnixSocket.h"
 
 namespace folly {
+class CPUThreadPoolExecutor;
 class EventBase;
 class File;
 class SocketAddress;
@@ -34,6 +37,11 @@ namespace facebook::eden {
  *
  * See PrivHelperConn.h for the various message types.
  *
+ * Mount, unmount, and bind mount requests are handled on a small pool of
+ * threads, so that the mounts of many checkouts are set up in parallel; the
+ * responses carry the request's transaction ID and may be sent out of order.
+ * All other requests are handled in order on the main thread.
+ *
  * The uid and gid parameters specify the user and group ID of the unprivileged
  * process that will be making requests to us.
  */
@@ -71,6 +79,7 @@ class PrivHelperServer : private UnixSocket::ReceiveCallback {
   void receiveError(const folly::exception_wrapper& ew) noexcept override;
 
   void processAndSendResponse(UnixSocket::Message&& message);
+  UnixSocket::Message processRequest(UnixSocket::Message& message);
   UnixSocket::Message processMessage(
       PrivHelperConn::MsgType msgType,
       folly::io::Cursor& cursor,
@@ -78,6 +87,8 @@ class PrivHelperServer : private UnixSocket::ReceiveCallback {
   UnixSocket::Message makeResponse();
   UnixSocket::Message makeResponse(folly::File&& file);
 
+  static bool isMountRequest(PrivHelperConn::MsgType msgType);
+
   UnixSocket::Message processMountMsg(folly::io::Cursor& cursor);
   UnixSocket::Message processMountNfsMsg(folly::io::Cursor& cursor);
   UnixSocket::Message processUnmountMsg(folly::io::Cursor& cursor);
@@ -130,9 +141,11 @@ class PrivHelperServer : private UnixSocket::ReceiveCallback {
   std::chrono::nanoseconds fuseTimeout_{std::chrono::seconds(60)};
   bool useDevEdenFs_{false};
 
-  // The privhelper server only has a single thread,
-  // so we don't need to lock the following state
-  std::set<std::string> mountPoints_;
+  // Runs the requests for which isMountRequest() is true, see the class
+  // comment. Created by init() for the same reason as eventBase_.
+  std::unique_ptr<folly::CPUThreadPoolExecutor> mountThreads_;
+
+  folly::Synchronized<std::set<std::string>> mountPoints_;
 };
 
 } // namespace facebook::eden
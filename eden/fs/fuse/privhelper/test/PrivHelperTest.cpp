@@ -313,6 +313,33 @@ TEST_F(PrivHelperTest, multiplePendingFuseMounts) {
   EXPECT_THAT(server_.getUnusedFuseUnmountResults(), UnorderedElementsAre());
 }
 
+TEST_F(PrivHelperTest, fuseMountsRunInParallel) {
+  auto abcMountPoint = makeTempDir("abc");
+  auto abcPath = abcMountPoint.path().string();
+  auto defMountPoint = makeTempDir("def");
+  auto defPath = defMountPoint.path().string();
+
+  auto abcPromise = server_.setFuseMountResult(abcPath);
+  auto defPromise = server_.setFuseMountResult(defPath);
+  server_.setFuseUnmountResult(abcPath).setValue();
+  server_.setFuseUnmountResult(defPath).setValue();
+
+  auto abcResult = client_->fuseMount(abcPath, false);
+  auto defResult = client_->fuseMount(defPath, false);
+
+  // The second mount completes while the first one is still blocked.
+  TemporaryFile tempFile;
+  defPromise.setValue(File(tempFile.fd(), /* ownsFD */ false));
+  std::move(defResult).get(1s);
+  EXPECT_FALSE(abcResult.isReady());
+
+  abcPromise.setValue(File(tempFile.fd(), /* ownsFD */ false));
+  std::move(abcResult).get(1s);
+
+  cleanup();
+  EXPECT_THAT(server_.getUnusedFuseUnmountResults(), UnorderedElementsAre());
+}
+
 TEST_F(PrivHelperTest, bindMounts) {
   auto abcMountPoint = makeTempDir("abc");
   auto abcPath = abcMountPoint.path().string();
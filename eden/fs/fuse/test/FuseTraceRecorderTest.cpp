@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/fuse/FuseTraceRecorder.h"
+
+#include <folly/portability/GTest.h>
+#include "eden/fs/fuse/FuseDispatcher.h"
+#include "eden/fs/telemetry/EdenStats.h"
+#include "eden/fs/testharness/FakeFuse.h"
+#include "eden/fs/testharness/TempFile.h"
+#include "eden/fs/testharness/TestDispatcher.h"
+#include "eden/fs/utils/CaseSensitivity.h"
+#include "eden/fs/utils/FileUtils.h"
+#include "eden/fs/utils/ProcessNameCache.h"
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+using namespace folly::string_piece_literals;
+
+namespace {
+
+folly::Logger straceLogger{"eden.strace"};
+
+constexpr auto kTimeout = 1s;
+
+struct FuseTraceRecorderTest : ::testing::Test {
+  void SetUp() override {
+    auto testDispatcher = std::make_unique<TestDispatcher>(&stats);
+    dispatcher = testDispatcher.get();
+    channel.reset(new FuseChannel(
+        fuse.start(),
+        AbsolutePath{"/fake/mount/path"},
+        /*numThreads=*/2,
+        std::move(testDispatcher),
+        &straceLogger,
+        std::make_shared<ProcessNameCache>(),
+        /*fsEventLogger=*/nullptr,
+        std::chrono::seconds(60),
+        /*notifications=*/nullptr,
+        CaseSensitivity::Sensitive,
+        /*requireUtf8Path=*/true,
+        /*maximumBackgroundRequests=*/12));
+
+    auto initFuture = channel->initialize();
+    fuse.sendInitRequest();
+    fuse.recvResponse();
+    std::move(initFuture).get(kTimeout);
+  }
+
+  uint32_t sendLookup(folly::StringPiece name) {
+    auto argument = name.str();
+    argument.push_back('\0');
+    return fuse.sendRequest(
+        FUSE_LOOKUP,
+        FUSE_ROOT_ID,
+        folly::ByteRange{folly::StringPiece{argument}});
+  }
+
+  folly::test::TemporaryDirectory tempDir{makeTempDir()};
+  FakeFuse fuse;
+  EdenStats stats;
+  TestDispatcher* dispatcher;
+  std::unique_ptr<FuseChannel, FuseChannelDeleter> channel;
+};
+
+} // namespace
+
+TEST_F(FuseTraceRecorderTest, records_requests_with_their_arguments) {
+  auto outputPath = AbsolutePath{tempDir.path().string()} + "trace.bin"_pc;
+  FuseTraceRecorder recorder{*channel, outputPath};
+
+  auto requestId = sendLookup("foo");
+  auto lookup = dispatcher->waitForLookup(requestId);
+  fuse_entry_out entry{};
+  entry.nodeid = 9;
+  lookup.promise.setValue(entry);
+  EXPECT_EQ(requestId, fuse.recvResponse().header.unique);
+
+  recorder.stop().get(kTimeout);
+  auto records = readFuseTrace(outputPath);
+
+  ASSERT_EQ(2, records.size());
+  EXPECT_EQ(FuseTraceEvent::START, records[0].type);
+  EXPECT_EQ(FUSE_LOOKUP, records[0].opcode);
+  EXPECT_EQ(FUSE_ROOT_ID, records[0].nodeid);
+  EXPECT_EQ("foo", records[0].arguments);
+  EXPECT_FALSE(records[0].result.has_value());
+
+  EXPECT_EQ(FuseTraceEvent::FINISH, records[1].type);
+  EXPECT_EQ(records[0].unique, records[1].unique);
+  EXPECT_EQ(9, records[1].result.value_or(0));
+  EXPECT_LE(records[0].time, records[1].time);
+}
+
+TEST_F(FuseTraceRecorderTest, requests_after_stop_are_not_recorded) {
+  auto outputPath = AbsolutePath{tempDir.path().string()} + "trace.bin"_pc;
+  FuseTraceRecorder recorder{*channel, outputPath};
+  recorder.stop().get(kTimeout);
+
+  auto requestId = sendLookup("foo");
+  dispatcher->waitForLookup(requestId).promise.setValue(fuse_entry_out{});
+  fuse.recvResponse();
+
+  EXPECT_TRUE(readFuseTrace(outputPath).empty());
+}
+
+TEST_F(FuseTraceRecorderTest, rejects_other_files) {
+  auto path = AbsolutePath{tempDir.path().string()} + "other"_pc;
+  auto contents = "not a trace"_sp;
+  ASSERT_TRUE(writeFile(path, folly::ByteRange{contents}).hasValue());
+  EXPECT_THROW(readFuseTrace(path), std::runtime_error);
+}
@@ -108,6 +108,12 @@ class CheckoutAction::LoadingRefcount {
 Future<InvalidationRequired> CheckoutAction::run(
     CheckoutContext* ctx,
     ObjectStore* store) {
+  auto future = promise_.getFuture();
+  ctx->scheduleLoads([this, ctx, store] { startLoads(ctx, store); });
+  return future;
+}
+
+void CheckoutAction::startLoads(CheckoutContext* ctx, ObjectStore* store) {
   // Immediately create one LoadingRefcount, to ensure that our
   // numLoadsPending_ refcount does not drop to 0 until after we have started
   // all required load operations.
@@ -184,8 +190,6 @@ Future<InvalidationRequired> CheckoutAction::run(
     exception_wrapper ew{std::current_exception(), ex};
     refcount->error("error preparing to load data for checkout action", ew);
   }
-
-  return promise_.getFuture();
 }
 
 void CheckoutAction::setOldTree(std::shared_ptr<const Tree> tree) {
@@ -226,6 +230,11 @@ void CheckoutAction::error(
 }
 
 void CheckoutAction::allLoadsComplete() noexcept {
+  // Our data is loaded: let another action start fetching while we compare
+  // and update the inode, which for a directory means checking out all of
+  // its children.
+  ctx_->loadsFinished();
+
   if (!ensureDataReady()) {
     // ensureDataReady() will fulfilled promise_ with an exception
     return;
@@ -114,6 +114,13 @@ class CheckoutAction {
       const TreeEntry* newScmEntry,
       folly::Future<InodePtr> inodeFuture);
 
+  /**
+   * Start loading the trees, blob and inode the action needs. Called by
+   * CheckoutContext::scheduleLoads(), once the checkout has room for more
+   * loads.
+   */
+  void startLoads(CheckoutContext* ctx, ObjectStore* store);
+
   void setOldTree(std::shared_ptr<const Tree> tree);
   void setOldBlob(Hash20 blobSha1);
   void setNewTree(std::shared_ptr<const Tree> tree);
@@ -7,12 +7,17 @@
 
 #include "eden/fs/inodes/CheckoutContext.h"
 
+#include <folly/ScopeGuard.h>
+#include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
 #include <optional>
 
 #include "eden/fs/config/CheckoutConfig.h"
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/config/ReloadableConfig.h"
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/InodePtr.h"
+#include "eden/fs/inodes/ServerState.h"
 #include "eden/fs/inodes/TreeInode.h"
 
 using folly::Future;
@@ -79,6 +84,9 @@ Future<vector<CheckoutConflict>> CheckoutContext::finish(RootId newSnapshot) {
     config->setParentCommit(newSnapshot);
   }
 
+  XLOG(DBG2) << "checkout of " << config->getMountPath() << " processed "
+             << getTreesFinished() << " of " << getTreesStarted() << " trees";
+
   // Release the rename lock.
   // This allows any filesystem unlink() or rename() operations to proceed.
   renameLock_.unlock();
@@ -102,6 +110,59 @@ Future<vector<CheckoutConflict>> CheckoutContext::finish(RootId newSnapshot) {
   return std::move(*conflicts_.wlock());
 }
 
+Future<folly::Unit> CheckoutContext::runSubtree(
+    folly::Function<Future<folly::Unit>()> checkout) {
+  auto maxParallel = mount_->getServerState()->getReloadableConfig()->getValue(
+      &EdenConfig::checkoutMaxParallelSubtrees);
+  if (scheduledSubtrees_.fetch_add(1, std::memory_order_acq_rel) >=
+      maxParallel) {
+    scheduledSubtrees_.fetch_sub(1, std::memory_order_acq_rel);
+    return checkout();
+  }
+
+  return folly::via(
+      mount_->getServerBulkThreadPool().get(),
+      [this, checkout = std::move(checkout)]() mutable {
+        // The slot is released once this subtree has started all of its
+        // actions; the futures it returns don't occupy a pool thread.
+        SCOPE_EXIT {
+          scheduledSubtrees_.fetch_sub(1, std::memory_order_acq_rel);
+        };
+        return checkout();
+      });
+}
+
+void CheckoutContext::scheduleLoads(folly::Function<void()> load) {
+  auto maxLoads = mount_->getServerState()->getReloadableConfig()->getValue(
+      &EdenConfig::checkoutMaxConcurrentLoads);
+  {
+    auto state = loadState_.wlock();
+    if (maxLoads != 0 && state->inFlight >= maxLoads) {
+      state->pending.push_back(std::move(load));
+      return;
+    }
+    ++state->inFlight;
+  }
+  load();
+}
+
+void CheckoutContext::loadsFinished() {
+  folly::Function<void()> next;
+  {
+    auto state = loadState_.wlock();
+    if (state->pending.empty()) {
+      --state->inFlight;
+      return;
+    }
+    // Hand our slot over to the oldest queued action.
+    next = std::move(state->pending.front());
+    state->pending.pop_front();
+  }
+  // Its loads may complete immediately and call loadsFinished() again, so
+  // start them on the pool rather than recursing on this stack.
+  mount_->getServerBulkThreadPool()->add(std::move(next));
+}
+
 void CheckoutContext::addConflict(ConflictType type, RelativePathPiece path) {
   // Errors should be added using addError()
   XCHECK(type != ConflictType::ERROR)
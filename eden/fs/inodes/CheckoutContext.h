@@ -7,10 +7,14 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <deque>
 #include <optional>
 #include <unordered_map>
 #include <vector>
 
+#include <folly/Function.h>
 #include <folly/Range.h>
 #include <folly/Synchronized.h>
 #include <folly/stop_watch.h>
@@ -122,6 +126,87 @@ class CheckoutContext {
     return fetchContext_;
   }
 
+  /**
+   * Run checkout, the checkout of one subtree, on the server thread pool so
+   * that sibling subtrees are processed in parallel rather than one after
+   * the other on whichever thread loaded their parent.
+   *
+   * At most checkout:max-parallel-subtrees subtrees are queued or running on
+   * the pool at once; past that, checkout is run inline on the calling
+   * thread. This keeps a checkout of a very wide tree from flooding the pool
+   * and delaying the thrift and filesystem requests that share it.
+   */
+  folly::Future<folly::Unit> runSubtree(
+      folly::Function<folly::Future<folly::Unit>()> checkout);
+
+  /**
+   * Run load, which starts the data loads of one CheckoutAction, once fewer
+   * than checkout:max-concurrent-loads actions are loading their data. Until
+   * then, load is queued and run, in order, on the server thread pool when
+   * loadsFinished() releases a slot.
+   *
+   * A slot only covers fetching an action's trees, blobs and inode, never
+   * the checkout of its children, so actions waiting for a slot can't
+   * prevent the ones holding one from releasing it.
+   */
+  void scheduleLoads(folly::Function<void()> load);
+
+  /**
+   * Release the slot taken by scheduleLoads() once the action's data loads
+   * all completed, successfully or not.
+   */
+  void loadsFinished();
+
+  /**
+   * Record that TreeInode::checkout() started processing one more tree.
+   */
+  void treeStarted() {
+    treesStarted_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * Record that the checkout of one tree and all of its children completed.
+   */
+  void treeFinished() {
+    treesFinished_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * Returns how many trees the checkout started, and how many of them have
+   * completed. These are only meant for progress reporting, and so they may
+   * be slightly stale when read while the checkout is running.
+   */
+  uint64_t getTreesStarted() const {
+    return treesStarted_.load(std::memory_order_relaxed);
+  }
+  uint64_t getTreesFinished() const {
+    return treesFinished_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Record that the filesystem channel's cache of one directory was
+   * invalidated, and how long it took from being requested until done. On
+   * Windows this includes waiting for a thread of the invalidation pool.
+   */
+  void directoryInvalidated(std::chrono::steady_clock::duration elapsed) {
+    directoriesInvalidated_.fetch_add(1, std::memory_order_relaxed);
+    directoryInvalidationTime_.fetch_add(
+        elapsed.count(), std::memory_order_relaxed);
+  }
+
+  uint64_t getDirectoriesInvalidated() const {
+    return directoriesInvalidated_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * The sum of the durations passed to directoryInvalidated(). Compared to
+   * the wall time of the checkout, this tells how much invalidations overlap.
+   */
+  std::chrono::steady_clock::duration getDirectoryInvalidationTime() const {
+    return std::chrono::steady_clock::duration{
+        directoryInvalidationTime_.load(std::memory_order_relaxed)};
+  }
+
  private:
   CheckoutMode checkoutMode_;
   EdenMount* const mount_;
@@ -132,6 +217,24 @@ class CheckoutContext {
   // if some data load operations complete asynchronously on other threads.
   // Therefore access to the conflicts list must be synchronized.
   folly::Synchronized<std::vector<CheckoutConflict>> conflicts_;
+
+  // Number of subtrees handed to the server thread pool by runSubtree() that
+  // have not started running yet or are still running synchronously.
+  std::atomic<size_t> scheduledSubtrees_{0};
+
+  struct LoadState {
+    // Number of actions that got a slot from scheduleLoads() and haven't
+    // called loadsFinished() yet.
+    size_t inFlight{0};
+    std::deque<folly::Function<void()>> pending;
+  };
+  folly::Synchronized<LoadState> loadState_;
+
+  std::atomic<uint64_t> treesStarted_{0};
+  std::atomic<uint64_t> treesFinished_{0};
+
+  std::atomic<uint64_t> directoriesInvalidated_{0};
+  std::atomic<std::chrono::steady_clock::rep> directoryInvalidationTime_{0};
 };
 } // namespace eden
 } // namespace facebook
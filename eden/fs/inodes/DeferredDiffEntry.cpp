@@ -215,19 +215,22 @@ class ModifiedDiffEntry : public DeferredDiffEntry {
       return treeInode->diff(context_, getPath(), nullptr, ignore_, isIgnored_);
     }
 
-    return fileInode
-        ->isSameAs(
-            scmEntry_.getHash(),
-            scmEntry_.getType(),
-            context_->getFetchContext())
-        .thenValue([this](bool isSame) {
-          if (!isSame) {
-            XLOG(DBG5) << "modified file: " << getPath();
-            context_->callback->modifiedFile(getPath());
-          }
-        })
-        .semi()
-        .via(&folly::QueuedImmediateExecutor::instance());
+    return context_->runComparison([this,
+                                    fileInode = std::move(fileInode)] {
+      return fileInode
+          ->isSameAs(
+              scmEntry_.getHash(),
+              scmEntry_.getType(),
+              context_->getFetchContext())
+          .thenValue([this](bool isSame) {
+            if (!isSame) {
+              XLOG(DBG5) << "modified file: " << getPath();
+              context_->callback->modifiedFile(getPath());
+            }
+          })
+          .semi()
+          .via(&folly::QueuedImmediateExecutor::instance());
+    });
   }
 
   const GitIgnoreStack* ignore_{nullptr};
@@ -250,20 +253,22 @@ class ModifiedBlobDiffEntry : public DeferredDiffEntry {
         currentBlobHash_{currentBlobHash} {}
 
   folly::Future<folly::Unit> run() override {
-    auto f1 = context_->store->getBlobSha1(
-        scmEntry_.getHash(), context_->getFetchContext());
-    auto f2 = context_->store->getBlobSha1(
-        currentBlobHash_, context_->getFetchContext());
-    return collectAllSafe(f1, f2)
-        .thenValue([this](const std::tuple<Hash20, Hash20>& info) {
-          const auto& [info1, info2] = info;
-          if (info1 != info2) {
-            XLOG(DBG5) << "modified file: " << getPath();
-            context_->callback->modifiedFile(getPath());
-          }
-        })
-        .semi()
-        .via(&folly::QueuedImmediateExecutor::instance());
+    return context_->runComparison([this] {
+      auto f1 = context_->store->getBlobSha1(
+          scmEntry_.getHash(), context_->getFetchContext());
+      auto f2 = context_->store->getBlobSha1(
+          currentBlobHash_, context_->getFetchContext());
+      return collectAllSafe(f1, f2)
+          .thenValue([this](const std::tuple<Hash20, Hash20>& info) {
+            const auto& [info1, info2] = info;
+            if (info1 != info2) {
+              XLOG(DBG5) << "modified file: " << getPath();
+              context_->callback->modifiedFile(getPath());
+            }
+          })
+          .semi()
+          .via(&folly::QueuedImmediateExecutor::instance());
+    });
   }
 
  private:
@@ -10,6 +10,7 @@
 #include <boost/filesystem.hpp>
 #include <folly/ExceptionWrapper.h>
 #include <folly/FBString.h>
+#include <folly/String.h>
 #include <folly/stop_watch.h>
 
 #include <folly/chrono/Conv.h>
@@ -37,6 +38,7 @@
 #include "eden/fs/nfs/NfsServer.h"
 #include "eden/fs/service/PrettyPrinters.h"
 #include "eden/fs/service/gen-cpp2/eden_types.h"
+#include "eden/fs/store/BackingStore.h"
 #include "eden/fs/store/BlobAccess.h"
 #include "eden/fs/store/DiffCallback.h"
 #include "eden/fs/store/DiffContext.h"
@@ -48,6 +50,7 @@
 #include "eden/fs/utils/Clock.h"
 #include "eden/fs/utils/EdenError.h"
 #include "eden/fs/utils/FaultInjector.h"
+#include "eden/fs/utils/FileUtils.h"
 #include "eden/fs/utils/FsChannelTypes.h"
 #include "eden/fs/utils/Future.h"
 #include "eden/fs/utils/ImmediateFuture.h"
@@ -92,6 +95,8 @@ namespace {
 // .eden/this-dir -> /abs/path/to/mount/.eden
 constexpr PathComponentPiece kDotEdenSymlinkName{"this-dir"_pc};
 constexpr PathComponentPiece kNfsdSocketName{"nfsd.socket"_pc};
+// Written by EdenMount::saveWarmDirectories, one path per line.
+constexpr PathComponentPiece kWarmDirectories{"warm-directories"_pc};
 } // namespace
 #endif
 
@@ -168,10 +173,10 @@ constexpr int EdenMount::kMaxSymlinkChainDepth;
 static constexpr folly::StringPiece kEdenStracePrefix = "eden.strace.";
 
 // We compute this when the process is initialized, but stash a copy
-// in each EdenMount.  We may in the future manage to propagate enough
-// state across upgrades or restarts that we can preserve this, but
-// as implemented today, a process restart will invalidate any cached
-// mountGeneration that a client may be holding on to.
+// in each EdenMount.  A process restart invalidates any cached
+// mountGeneration that a client may be holding on to, unless the mount's
+// journal was restored from its log, in which case the generation stored
+// with the log is kept.
 // We take the bottom 16-bits of the pid and 32-bits of the current
 // time and shift them up, leaving 16 bits for a mount point generation
 // number.
@@ -229,12 +234,26 @@ EdenMount::EdenMount(
       overlayFileAccess_{overlay_.get()},
 #endif
       journal_{std::move(journal)},
-      mountGeneration_{globalProcessGeneration | ++mountGeneration},
+      mountGeneration_{journal_->getRestoredMountGeneration().value_or(
+          globalProcessGeneration | ++mountGeneration)},
       straceLogger_{
           kEdenStracePrefix.str() + checkoutConfig_->getMountPath().value()},
       lastCheckoutTime_{EdenTimestamp{serverState_->getClock()->getRealtime()}},
       owner_{Owner{getuid(), getgid()}},
       clock_{serverState_->getClock()} {
+  overlay_->setObjectIdMigrator(
+      [backingStore = objectStore_->getBackingStore()](const ObjectId& id) {
+        return backingStore->migrateObjectId(id);
+      });
+  overlay_->setDirWriteBack(getEdenConfig()->overlayDirWriteBack.getValue());
+  overlay_->setGroupCommit(
+      getEdenConfig()->overlayGroupCommitMaxOperations.getValue(),
+      getEdenConfig()->overlayGroupCommitWindow.getValue());
+  overlay_->setPooledFileMinSize(
+      getEdenConfig()->overlayPooledFileMinSize.getValue());
+  overlay_->setSnapshotInterval(
+      getEdenConfig()->overlaySnapshotInterval.getValue());
+  overlay_->setHugePages(getEdenConfig()->overlayHugePages.getValue());
 }
 
 Overlay::OverlayType EdenMount::getOverlayType() {
@@ -242,6 +261,9 @@ Overlay::OverlayType EdenMount::getOverlayType() {
     if (getEdenConfig()->unsafeInMemoryOverlay.getValue()) {
       return Overlay::OverlayType::TreeInMemory;
     }
+    if (getEdenConfig()->overlaySnapshotInterval.getValue().count() > 0) {
+      return Overlay::OverlayType::TreeInMemorySnapshot;
+    }
     if (getEdenConfig()->overlaySynchronousMode.getValue() == "off") {
       return Overlay::OverlayType::TreeSynchronousOff;
     }
@@ -270,8 +292,14 @@ FOLLY_NODISCARD folly::Future<folly::Unit> EdenMount::initialize(
 
         // Record the transition from no snapshot to the current snapshot in
         // the journal.  This also sets things up so that we can carry the
-        // snapshot id forward through subsequent journal entries.
-        journal_->recordHashUpdate(parent);
+        // snapshot id forward through subsequent journal entries.  A journal
+        // restored from its log already knows its snapshot, and only needs
+        // to record a change made while EdenFS was not running.
+        if (auto latest = journal_->getLatest()) {
+          journal_->recordHashUpdate(latest->toHash, parent);
+        } else {
+          journal_->recordHashUpdate(parent);
+        }
 
         // Initialize the overlay.
         // This must be performed before we do any operations that may
@@ -594,7 +622,8 @@ static void logStats(
              << fetchStats.blob.accessCount << " blobs ("
              << fetchStats.blob.cacheHitRate << "% chr), and "
              << fetchStats.metadata.accessCount << " metadata ("
-             << fetchStats.metadata.cacheHitRate << "% chr).";
+             << fetchStats.metadata.cacheHitRate << "% chr), fetching "
+             << fetchStats.backingStoreBytes << " bytes.";
 }
 
 static folly::StringPiece getCheckoutModeString(CheckoutMode checkoutMode) {
@@ -625,6 +654,112 @@ TreeEntryType toEdenTreeEntryType(facebook::eden::ObjectType objectType) {
   throw std::runtime_error("unsupported root type");
 }
 
+/**
+ * The objects of setPathObjectIds() grafted by one checkout: either a tree
+ * grafted at directory, or the blobs grafted in it.
+ */
+struct PathObjectGraft {
+  RelativePath directory;
+  std::optional<RootId> treeId;
+  std::vector<const PathObjectGraftRequest*> blobs;
+};
+
+/**
+ * Group the objects by the directory checked out to graft them, and check
+ * that the checkouts of the directories don't overlap.
+ */
+std::vector<PathObjectGraft> groupPathObjects(
+    const std::vector<PathObjectGraftRequest>& objects) {
+  std::unordered_set<RelativePathPiece> paths;
+  for (const auto& object : objects) {
+    if (!paths.insert(object.path.piece()).second) {
+      throw newEdenError(
+          EINVAL,
+          EdenErrorType::ARGUMENT_ERROR,
+          "path ",
+          object.path,
+          " is given more than once");
+    }
+  }
+  for (const auto& object : objects) {
+    if (object.path.empty()) {
+      continue;
+    }
+    for (auto parent : object.path.dirname().allPaths()) {
+      if (paths.count(parent)) {
+        throw newEdenError(
+            EINVAL,
+            EdenErrorType::ARGUMENT_ERROR,
+            "path ",
+            object.path,
+            " is inside another grafted path");
+      }
+    }
+  }
+
+  std::vector<PathObjectGraft> grafts;
+  std::unordered_map<RelativePathPiece, size_t> blobDirectories;
+  for (const auto& object : objects) {
+    if (object.type == facebook::eden::ObjectType::TREE) {
+      grafts.push_back(PathObjectGraft{object.path, object.id, {}});
+      continue;
+    }
+    auto [it, inserted] =
+        blobDirectories.emplace(object.path.dirname(), grafts.size());
+    if (inserted) {
+      grafts.push_back(
+          PathObjectGraft{object.path.dirname().copy(), std::nullopt, {}});
+    }
+    grafts[it->second].blobs.push_back(&object);
+  }
+  return grafts;
+}
+
+/**
+ * The tree checked out in the directory of the graft: either the grafted
+ * tree, or one made up of the grafted blobs.
+ */
+ImmediateFuture<shared_ptr<const Tree>> getGraftedTree(
+    const ObjectStore& objectStore,
+    const PathObjectGraft& graft,
+    ObjectFetchContext& context) {
+  if (graft.treeId) {
+    return objectStore.getRootTree(*graft.treeId, context).semi();
+  }
+
+  std::vector<ImmediateFuture<std::shared_ptr<TreeEntry>>> entryFutures;
+  entryFutures.reserve(graft.blobs.size());
+  for (const auto* blob : graft.blobs) {
+    entryFutures.emplace_back(objectStore
+                                  .getTreeEntryForRootId(
+                                      blob->id,
+                                      toEdenTreeEntryType(blob->type),
+                                      blob->path.basename(),
+                                      context)
+                                  .semi());
+  }
+  return collectAllSafe(std::move(entryFutures))
+      .thenValue([](std::vector<std::shared_ptr<TreeEntry>>&& entries) {
+        std::vector<TreeEntry> treeEntries;
+        treeEntries.reserve(entries.size());
+        for (auto& entry : entries) {
+          treeEntries.push_back(std::move(*entry));
+        }
+        std::sort(
+            treeEntries.begin(),
+            treeEntries.end(),
+            [](const TreeEntry& a, const TreeEntry& b) {
+              return a.getName() < b.getName();
+            });
+        // Make up a fake ObjectId for this tree.
+        // WARNING: This is dangerous -- this ObjectId cannot be used to
+        // look up this synthesized tree from the BackingStore.
+        ObjectId fakeObjectId{};
+        return std::make_shared<const Tree>(
+            std::move(treeEntries), fakeObjectId);
+      });
+}
+
 } // namespace
 
 folly::Future<SetPathObjectIdResultAndTimes> EdenMount::setPathObjectId(
@@ -632,10 +767,32 @@ folly::Future<SetPathObjectIdResultAndTimes> EdenMount::setPathObjectId(
     const RootId& rootId,
     ObjectType objectType,
     CheckoutMode checkoutMode,
+    ObjectFetchContext& context) {
+  std::vector<PathObjectGraftRequest> objects;
+  objects.push_back(
+      PathObjectGraftRequest{path.copy(), rootId, objectType});
+  return setPathObjectIds(std::move(objects), checkoutMode, context);
+}
+
+folly::Future<SetPathObjectIdResultAndTimes> EdenMount::setPathObjectIds(
+    std::vector<PathObjectGraftRequest> objects,
+    CheckoutMode checkoutMode,
     FOLLY_MAYBE_UNUSED ObjectFetchContext& context) {
-  if (objectType == facebook::eden::ObjectType::SYMLINK) {
-    XLOG(DBG3) << "setPathObjectId called with symlink for object with id "
-               << rootId << " at path" << path;
+  if (objects.empty()) {
+    return SetPathObjectIdResultAndTimes{};
+  }
+  std::vector<PathObjectGraft> grafts;
+  try {
+    grafts = groupPathObjects(objects);
+  } catch (const std::exception& ex) {
+    return folly::makeFuture<SetPathObjectIdResultAndTimes>(
+        folly::exception_wrapper{std::current_exception(), ex});
+  }
+  for (const auto& object : objects) {
+    if (object.type == facebook::eden::ObjectType::SYMLINK) {
+      XLOG(DBG3) << "setPathObjectId called with symlink for object with id "
+                 << object.id << " at path" << object.path;
+    }
   }
 
   const folly::stop_watch<> stopWatch;
@@ -647,8 +804,11 @@ folly::Future<SetPathObjectIdResultAndTimes> EdenMount::setPathObjectId(
    * objects are not weaving too much
    */
   auto oldParent = getParentCommit();
-  XLOG(DBG3) << "adding " << rootId << " to Eden mount " << this->getPath()
-             << " at path" << path << " on top of " << oldParent;
+  // As when grafting the objects one after the other, the parent ends up
+  // being the last one.
+  auto rootId = objects.back().id;
+  XLOG(DBG3) << "adding " << objects.size() << " objects to Eden mount "
+             << this->getPath() << " on top of " << oldParent;
 
   auto ctx = std::make_shared<CheckoutContext>(
       this,
@@ -663,42 +823,52 @@ folly::Future<SetPathObjectIdResultAndTimes> EdenMount::setPathObjectId(
    * partial node so only affects its children.
    */
   setLastCheckoutTime(EdenTimestamp{clock_->getRealtime()});
-  bool isTree = (objectType == facebook::eden::ObjectType::TREE);
-
-  auto getTargetTreeInodeFuture =
-      ensureDirectoryExists(
-          isTree ? path : path.dirname(), ctx->getFetchContext())
-          .semi()
-          .via(&folly::QueuedImmediateExecutor::instance());
-
-  auto getRootTreeFuture = isTree
-      ? objectStore_->getRootTree(rootId, ctx->getFetchContext())
-      : objectStore_
-            ->getTreeEntryForRootId(
-                rootId,
-                toEdenTreeEntryType(objectType),
-                path.basename(),
-                ctx->getFetchContext())
-            .thenValue([](std::shared_ptr<TreeEntry> treeEntry) {
-              // Make up a fake ObjectId for this tree.
-              // WARNING: This is dangerous -- this ObjectId cannot be used to
-              // look up this synthesized tree from the BackingStore.
-              ObjectId fakeObjectId{};
-              return std::make_shared<Tree>(
-                  std::vector<TreeEntry>{*treeEntry}, fakeObjectId);
-            });
 
-  return collectSafe(getTargetTreeInodeFuture, getRootTreeFuture)
+  // The changes made below are not recorded in the journal.
+  unjournaledChanges_.fetch_add(1, std::memory_order_acq_rel);
+
+  using TargetAndTree = std::tuple<TreeInodePtr, shared_ptr<const Tree>>;
+  std::vector<ImmediateFuture<TargetAndTree>> targetFutures;
+  targetFutures.reserve(grafts.size());
+  for (const auto& graft : grafts) {
+    auto getTargetTreeInodeFuture =
+        ensureDirectoryExists(graft.directory, ctx->getFetchContext());
+
+    auto getIncomingTreeFuture =
+        getGraftedTree(*objectStore_, graft, ctx->getFetchContext());
+    targetFutures.push_back(collectAllSafe(
+        std::move(getTargetTreeInodeFuture), std::move(getIncomingTreeFuture)));
+  }
+
+  return collectAllSafe(std::move(targetFutures))
+      .semi()
+      .via(&folly::QueuedImmediateExecutor::instance())
       .thenValue([this, ctx, setPathObjectIdTime, stopWatch, rootId](
-                     std::tuple<TreeInodePtr, shared_ptr<const Tree>> results) {
+                     std::vector<TargetAndTree> targets) {
         setPathObjectIdTime->didLookupTreesOrGetInodeByPath =
             stopWatch.elapsed();
-        auto [targetTreeInode, incomingTree] = results;
-        targetTreeInode->unloadChildrenUnreferencedByFs();
+        for (const auto& target : targets) {
+          std::get<0>(target)->unloadChildrenUnreferencedByFs();
+        }
         // TODO(@yipu): Remove rename lock
         ctx->start(this->acquireRenameLock(), {}, rootId);
         setPathObjectIdTime->didAcquireRenameLock = stopWatch.elapsed();
-        return targetTreeInode->checkout(ctx.get(), nullptr, incomingTree);
+
+        // The grafted directories don't overlap, but they may be created in
+        // the same parent, so they are checked out one after the other.
+        auto checkoutTargets =
+            std::make_shared<std::vector<TargetAndTree>>(std::move(targets));
+        auto future = folly::makeFuture();
+        for (size_t i = 0; i < checkoutTargets->size(); ++i) {
+          future = std::move(future).thenValue(
+              [ctx, checkoutTargets, i](folly::Unit) {
+                const auto& [targetTreeInode, incomingTree] =
+                    (*checkoutTargets)[i];
+                return targetTreeInode->checkout(
+                    ctx.get(), nullptr, incomingTree);
+              });
+        }
+        return future;
       })
       .thenValue([ctx, setPathObjectIdTime, stopWatch, rootId](auto&&) {
         setPathObjectIdTime->didCheckout = stopWatch.elapsed();
@@ -714,8 +884,12 @@ folly::Future<SetPathObjectIdResultAndTimes> EdenMount::setPathObjectId(
         resultAndTimes.result = std::move(result);
         return resultAndTimes;
       })
-      .thenTry([this, ctx, oldParent, rootId](
+      .thenTry([this, ctx, oldParent, rootId, objects = std::move(objects)](
                    Try<SetPathObjectIdResultAndTimes>&& resultAndTimes) {
+        // The object paths are referenced by the fetches, so they are only
+        // released here.
+        (void)objects;
+        unjournaledChanges_.fetch_add(1, std::memory_order_acq_rel);
         auto fetchStats = ctx->getFetchContext().computeStatistics();
         logStats(
             resultAndTimes.hasValue(),
@@ -795,6 +969,13 @@ folly::SemiFuture<SerializedInodeMap> EdenMount::shutdown(
 folly::SemiFuture<SerializedInodeMap> EdenMount::shutdownImpl(bool doTakeover) {
   journal_->cancelAllSubscribers();
   XLOG(DBG1) << "beginning shutdown for EdenMount " << getPath();
+#ifndef _WIN32
+  // On takeover the loaded inodes are handed to the next process, so there is
+  // nothing to prewarm.
+  if (!doTakeover) {
+    saveWarmDirectories();
+  }
+#endif
 
   return inodeMap_->shutdown(doTakeover)
       .thenValue([this](SerializedInodeMap inodeMap) {
@@ -805,6 +986,9 @@ folly::SemiFuture<SerializedInodeMap> EdenMount::shutdownImpl(bool doTakeover) {
         // the mount point.
         overlay_->close();
         XLOG(DBG1) << "successfully closed overlay at " << getPath();
+        // Nothing changes past this point, so the next edenfs process can
+        // pick up the journal where this one left off.
+        journal_->closeLog(mountGeneration_);
         auto oldState =
             state_.exchange(State::SHUT_DOWN, std::memory_order_acq_rel);
         if (oldState == State::DESTROYING) {
@@ -865,6 +1049,11 @@ const shared_ptr<UnboundedQueueExecutor>& EdenMount::getServerThreadPool()
   return serverState_->getThreadPool();
 }
 
+const shared_ptr<UnboundedQueueExecutor>&
+EdenMount::getServerBulkThreadPool() const {
+  return serverState_->getBulkThreadPool();
+}
+
 #ifdef _WIN32
 const shared_ptr<UnboundedQueueExecutor>& EdenMount::getInvalidationThreadPool()
     const {
@@ -1146,6 +1335,137 @@ ImmediateFuture<InodePtr> EdenMount::getInode(
   return inodeMap_->getRootInode()->getChildRecursive(path, context);
 }
 
+#ifndef _WIN32
+std::vector<RelativePath> EdenMount::getRecentlyAccessedDirectories(
+    size_t maxDirectories) {
+  struct Directory {
+    EdenTimestamp atime;
+    RelativePath path;
+  };
+  std::vector<Directory> directories;
+
+  // Like TreeInode::unloadChildrenLastAccessedBefore, collect strong
+  // references under the parent's contents lock and only read the children's
+  // atime once it is released.
+  std::vector<TreeInodePtr> pending{getRootInode()};
+  while (!pending.empty()) {
+    auto tree = std::move(pending.back());
+    pending.pop_back();
+
+    std::vector<TreeInodePtr> children;
+    {
+      auto contents = tree->getContents().rlock();
+      for (auto& entry : contents->entries) {
+        if (!entry.second.getInode()) {
+          continue;
+        }
+        if (auto asTree = entry.second.asTreePtrOrNull()) {
+          children.push_back(std::move(asTree));
+        }
+      }
+    }
+
+    for (auto& child : children) {
+      if (auto path = child->getPath()) {
+        directories.push_back(
+            Directory{child->getMetadata().timestamps.atime, std::move(*path)});
+      }
+      pending.push_back(std::move(child));
+    }
+  }
+
+  auto count = std::min(maxDirectories, directories.size());
+  std::partial_sort(
+      directories.begin(),
+      directories.begin() + count,
+      directories.end(),
+      [](const Directory& left, const Directory& right) {
+        return right.atime < left.atime;
+      });
+
+  std::vector<RelativePath> result;
+  result.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    result.push_back(std::move(directories[i].path));
+  }
+  return result;
+}
+
+ImmediateFuture<size_t> EdenMount::prewarmDirectories(
+    std::vector<RelativePath> paths) {
+  static auto context = ObjectFetchContext::getNullContextWithCauseDetail(
+      "EdenMount::prewarmDirectories");
+  std::vector<ImmediateFuture<TreeInodePtr>> futures;
+  futures.reserve(paths.size());
+  for (const auto& path : paths) {
+    // Loading a TreeInode loads its Tree; there's nothing else to do.
+    futures.push_back(getInode(path, *context).thenValue([](InodePtr inode) {
+      return inode.asTreePtr();
+    }));
+  }
+  return collectAll(std::move(futures))
+      .thenValue([](std::vector<folly::Try<TreeInodePtr>> results) {
+        return static_cast<size_t>(std::count_if(
+            results.begin(), results.end(), [](const auto& result) {
+              return result.hasValue();
+            }));
+      });
+}
+
+void EdenMount::saveWarmDirectories() {
+  auto maxDirectories = getEdenConfig()->nfsPrewarmDirectories.getValue();
+  if (maxDirectories == 0 || !isNfsdChannel()) {
+    return;
+  }
+  std::string data;
+  for (const auto& path : getRecentlyAccessedDirectories(maxDirectories)) {
+    data.append(path.value());
+    data.push_back('\n');
+  }
+  auto path = checkoutConfig_->getClientDirectory() +
+      kWarmDirectories;
+  auto result = writeFileAtomic(path, folly::StringPiece{data});
+  if (result.hasException()) {
+    XLOG(WARN) << "failed to save the recently accessed directories of "
+               << getPath() << ": " << result.exception().what();
+  }
+}
+
+ImmediateFuture<folly::Unit> EdenMount::restoreWarmDirectories() {
+  if (getEdenConfig()->nfsPrewarmDirectories.getValue() == 0) {
+    return folly::unit;
+  }
+  auto data = readFile(
+      checkoutConfig_->getClientDirectory() + kWarmDirectories);
+  if (data.hasException()) {
+    XLOG(DBG2) << "no recently accessed directories saved for " << getPath()
+               << ": " << data.exception().what();
+    return folly::unit;
+  }
+
+  std::vector<RelativePath> paths;
+  std::vector<folly::StringPiece> lines;
+  folly::split('\n', data.value(), lines, /*ignoreEmpty=*/true);
+  for (auto line : lines) {
+    try {
+      paths.emplace_back(line);
+    } catch (const std::exception& ex) {
+      XLOG(WARN) << "ignoring saved directory of " << getPath() << ": "
+                 << folly::exceptionStr(ex);
+    }
+  }
+
+  folly::stop_watch<std::chrono::milliseconds> watch;
+  auto count = paths.size();
+  return prewarmDirectories(std::move(paths))
+      .thenValue([this, watch, count](size_t loaded) {
+        XLOG(INFO) << "prewarmed " << loaded << " of " << count
+                   << " directories of " << getPath() << " in "
+                   << watch.elapsed().count() << "ms";
+      });
+}
+#endif // !_WIN32
+
 folly::Future<std::string> EdenMount::loadFileContentsFromPath(
     ObjectFetchContext& fetchContext,
     RelativePathPiece path,
@@ -1305,10 +1625,14 @@ folly::Future<CheckoutResult> EdenMount::checkout(
   // checkout
   setLastCheckoutTime(EdenTimestamp{clock_->getRealtime()});
 
+  // The destination commit was likely just pulled, so objects that were
+  // missing before may now be available.
+  objectStore_->invalidateNegativeLookupCache();
+
   auto journalDiffCallback = std::make_shared<JournalDiffCallback>();
   return serverState_->getFaultInjector()
       .checkAsync("checkout", getPath().stringPiece())
-      .via(getServerThreadPool().get())
+      .via(getServerBulkThreadPool().get())
       .thenValue([this, ctx, parent1Hash = oldParent, snapshotHash](auto&&) {
         XLOG(DBG7) << "Checkout: getRoots";
         auto fromTreeFuture =
@@ -1389,7 +1713,7 @@ folly::Future<CheckoutResult> EdenMount::checkout(
         auto rootInode = getRootInode();
         return serverState_->getFaultInjector()
             .checkAsync("inodeCheckout", getPath().stringPiece())
-            .via(getServerThreadPool().get())
+            .via(getServerBulkThreadPool().get())
             .thenValue([ctx,
                         treeResults = std::move(treeResults),
                         rootInode = std::move(rootInode)](auto&&) mutable {
@@ -1447,8 +1771,13 @@ folly::Future<CheckoutResult> EdenMount::checkout(
 
             return result;
           })
-      .thenTry([this, ctx, stopWatch, oldParent, snapshotHash, checkoutMode](
-                   Try<CheckoutResult>&& result) {
+      .thenTry([this,
+                ctx,
+                checkoutTimes,
+                stopWatch,
+                oldParent,
+                snapshotHash,
+                checkoutMode](Try<CheckoutResult>&& result) {
         auto fetchStats = ctx->getFetchContext().computeStatistics();
         logStats(
             result.hasValue(),
@@ -1469,6 +1798,35 @@ folly::Future<CheckoutResult> EdenMount::checkout(
         // Don't log metadata fetches, because our backends don't yet support
         // fetching metadata directly. We expect tree fetches to eventually
         // return metadata for their entries.
+        if (result.hasValue()) {
+          // The CheckoutTimes are measured from the start of the checkout,
+          // turn them into the duration of each phase.
+          using Seconds = std::chrono::duration<double>;
+          const auto& times = *checkoutTimes;
+          event.lookupTreesDuration = Seconds{times.didLookupTrees}.count();
+          event.diffDuration =
+              Seconds{times.didDiff - times.didLookupTrees}.count();
+          event.acquireRenameLockDuration =
+              Seconds{times.didAcquireRenameLock - times.didDiff}.count();
+          event.checkoutDuration =
+              Seconds{times.didCheckout - times.didAcquireRenameLock}.count();
+          event.finishDuration =
+              Seconds{times.didFinish - times.didCheckout}.count();
+        }
+        event.invalidatedDirectories = ctx->getDirectoriesInvalidated();
+        event.directoryInvalidationDuration =
+            std::chrono::duration<double>{ctx->getDirectoryInvalidationTime()}
+                .count();
+        XLOG(DBG2) << "checkout of " << this->getPath() << " took "
+                   << event.duration << "s: lookup trees "
+                   << event.lookupTreesDuration << "s, diff "
+                   << event.diffDuration << "s, rename lock "
+                   << event.acquireRenameLockDuration << "s, checkout "
+                   << event.checkoutDuration << "s, finish "
+                   << event.finishDuration << "s, "
+                   << event.invalidatedDirectories
+                   << " directories invalidated in "
+                   << event.directoryInvalidationDuration << "s";
         this->serverState_->getStructuredLogger()->logEvent(event);
         return std::move(result);
       });
@@ -1549,7 +1907,7 @@ std::unique_ptr<DiffContext> EdenMount::createDiffContext(
     return loadFileContentsFromPath(
         fetchContext, path, CacheHint::LikelyNeededAgain);
   };
-  return make_unique<DiffContext>(
+  auto context = make_unique<DiffContext>(
       callback,
       listIgnored,
       getCheckoutConfig()->getCaseSensitive(),
@@ -1557,6 +1915,10 @@ std::unique_ptr<DiffContext> EdenMount::createDiffContext(
       serverState_->getTopLevelIgnores(),
       std::move(loadContents),
       request);
+  context->setMaxConcurrentComparisons(
+      getEdenConfig()->maxConcurrentDiffComparisons.getValue());
+  context->setGitIgnoreCache(serverState_->getGitIgnoreCache());
+  return context;
 }
 
 Future<Unit> EdenMount::diff(DiffContext* ctxPtr, const RootId& commitHash)
@@ -1629,13 +1991,66 @@ folly::Future<std::unique_ptr<ScmStatus>> EdenMount::diff(
     bool listIgnored,
     bool enforceCurrentParent,
     ResponseChannelRequest* request) {
+  // Read the journal position before walking the inodes: anything that
+  // changes while the diff runs is recorded after it, and so invalidates the
+  // result we are about to cache.
+  auto sequence = journal_->getNextSequenceNumber();
+  auto ignoresVersion = serverState_->getTopLevelIgnoresVersion();
+  auto unjournaledChanges = unjournaledChanges_.load(std::memory_order_acquire);
+
+#ifdef _WIN32
+  // ProjectedFS tells us about changes asynchronously, so the journal can lag
+  // behind the working copy until diff() waits for pending notifications.
+  constexpr bool kUseCachedStatus = false;
+#else
+  constexpr bool kUseCachedStatus = true;
+#endif
+  // The cache is only used between checkouts. A diff computed while one is
+  // in progress sees a partial update, and a caller that enforces the
+  // current parent has to go through the checks of the full diff().
+  auto checkoutIdle = [this, commitHash, enforceCurrentParent] {
+    auto parentInfo = parentState_.rlock();
+    return !parentInfo->checkoutInProgress &&
+        (!enforceCurrentParent || parentInfo->commitHash == commitHash);
+  };
+  if (kUseCachedStatus && checkoutIdle()) {
+    auto cached = cachedStatus_.rlock();
+    if (cached->has_value() && (*cached)->commitHash == commitHash &&
+        (*cached)->listIgnored == listIgnored &&
+        (*cached)->sequence == sequence &&
+        (*cached)->ignoresVersion == ignoresVersion &&
+        (*cached)->unjournaledChanges == unjournaledChanges) {
+      return folly::makeFuture(std::make_unique<ScmStatus>((*cached)->status));
+    }
+  }
+
   auto callback = std::make_unique<ScmStatusDiffCallback>();
   auto callbackPtr = callback.get();
   return this
       ->diff(
           callbackPtr, commitHash, listIgnored, enforceCurrentParent, request)
-      .thenValue([callback = std::move(callback)](auto&&) {
-        return std::make_unique<ScmStatus>(callback->extractStatus());
+      .thenValue([this,
+                  callback = std::move(callback),
+                  commitHash,
+                  listIgnored,
+                  sequence,
+                  ignoresVersion,
+                  unjournaledChanges,
+                  checkoutIdle = std::move(checkoutIdle)](auto&&) {
+        auto status = std::make_unique<ScmStatus>(callback->extractStatus());
+        // Errors are usually transient fetch failures, so don't remember
+        // them.
+        if (kUseCachedStatus && status->errors_ref()->empty() &&
+            checkoutIdle()) {
+          cachedStatus_.wlock()->emplace(CachedStatus{
+              commitHash,
+              listIgnored,
+              sequence,
+              ignoresVersion,
+              unjournaledChanges,
+              *status});
+        }
+        return status;
       });
 }
 
@@ -1660,6 +2075,9 @@ void EdenMount::resetParent(const RootId& parent) {
   parentLock->commitHash = parent;
 
   journal_->recordHashUpdate(oldParent, parent);
+
+  // A commit is a natural point to persist an in-memory overlay.
+  overlay_->checkpoint();
 }
 
 EdenTimestamp EdenMount::getLastCheckoutTime() const {
@@ -1729,7 +2147,14 @@ std::unique_ptr<FuseChannel, FuseChannelDeleter> makeFuseChannel(
       mount->getServerState()->getNotifier(),
       mount->getCheckoutConfig()->getCaseSensitive(),
       mount->getCheckoutConfig()->getRequireUtf8Path(),
-      edenConfig->fuseMaximumRequests.getValue())};
+      edenConfig->fuseMaximumRequests.getValue(),
+      edenConfig->fuseUseSplice.getValue(),
+      edenConfig->fuseCloneDevicePerThread.getValue(),
+      edenConfig->fusePinWorkerThreads.getValue(),
+      edenConfig->fuseMaxIoSize.getValue(),
+      edenConfig->fuseWritebackCache.getValue(),
+      edenConfig->fuseAsyncDio.getValue(),
+      edenConfig->fuseDispatchThreads.getValue())};
 }
 
 folly::Future<NfsServer::NfsMountInfo> makeNfsChannel(
@@ -1913,7 +2338,20 @@ folly::Future<folly::Unit> EdenMount::startChannel(bool readOnly) {
     boost::filesystem::path boostMountPath{getPath().value()};
     boost::filesystem::create_directories(boostMountPath);
 
-    return channelMount(readOnly)
+#ifndef _WIN32
+    // Prewarming happens before mounting, so that the first lookups the
+    // kernel sends find the directories already loaded.
+    auto prewarm = shouldUseNFSMount_
+        ? restoreWarmDirectories()
+        : ImmediateFuture<folly::Unit>{folly::unit};
+#else
+    auto prewarm = ImmediateFuture<folly::Unit>{folly::unit};
+#endif
+    return std::move(prewarm)
+        .semi()
+        .via(&folly::QueuedImmediateExecutor::instance())
+        .thenValue(
+            [this, readOnly](auto&&) { return channelMount(readOnly); })
         .thenValue([this](auto&&) {
 #ifdef _WIN32
           channelInitSuccessful(channel_->getStopFuture());
@@ -15,6 +15,7 @@
 #include <folly/futures/Promise.h>
 #include <folly/futures/SharedPromise.h>
 #include <folly/logging/Logger.h>
+#include <atomic>
 #include <chrono>
 #include <memory>
 #include <mutex>
@@ -34,6 +35,7 @@
 #include "eden/fs/store/BlobAccess.h"
 #include "eden/fs/takeover/TakeoverData.h"
 #include "eden/fs/telemetry/IActivityRecorder.h"
+#include "eden/fs/telemetry/LockProfiling.h"
 #include "eden/fs/utils/PathFuncs.h"
 
 #ifndef _WIN32
@@ -93,6 +95,11 @@ class TreeEntry;
 class RenameLock;
 class SharedRenameLock;
 
+using RenameMutex = ProfiledSharedMutex<
+    folly::SharedMutex,
+    &LockThreadStats::renameWait,
+    &LockThreadStats::renameHold>;
+
 /**
  * Represents types of keys for some fb303 counters.
  */
@@ -179,6 +186,15 @@ struct SetPathObjectIdResultAndTimes {
   SetPathObjectIdTimes times;
 };
 
+/**
+ * One object grafted by setPathObjectIds().
+ */
+struct PathObjectGraftRequest {
+  RelativePath path;
+  RootId id;
+  ObjectType type;
+};
+
 /**
  * EdenMount contains all of the data about a specific eden mount point.
  *
@@ -451,6 +467,12 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    */
   const std::shared_ptr<UnboundedQueueExecutor>& getServerThreadPool() const;
 
+  /**
+   * Returns the server's thread pool for bulk work, such as checkout.
+   */
+  const std::shared_ptr<UnboundedQueueExecutor>& getServerBulkThreadPool()
+      const;
+
 #ifdef _WIN32
   /**
    * Returns the thread pool where directory invalidation need to be performed.
@@ -535,6 +557,22 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
       RelativePathPiece path,
       ObjectFetchContext& context) const;
 
+#ifndef _WIN32
+  /**
+   * Return the paths of up to maxDirectories loaded directories, most
+   * recently accessed first.
+   */
+  std::vector<RelativePath> getRecentlyAccessedDirectories(
+      size_t maxDirectories);
+
+  /**
+   * Load the inodes and trees of the given directories. Paths that no longer
+   * exist or aren't directories are skipped. Returns the number of
+   * directories loaded.
+   */
+  ImmediateFuture<size_t> prewarmDirectories(std::vector<RelativePath> paths);
+#endif // !_WIN32
+
   /**
    * Resolves symlinks and loads file contents from the Inode at the given path.
    * This loads the entire file contents into memory, so this can be expensive
@@ -613,6 +651,10 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    * @return Returns a folly::Future that will be fulfilled when the diff
    *     operation is complete.  This is marked FOLLY_NODISCARD to
    *     make sure callers do not forget to wait for the operation to complete.
+   *
+   * The last result is cached, and returned again without walking the inodes
+   * for as long as the journal has recorded no changes and the top-level
+   * ignore files are unchanged.
    */
   FOLLY_NODISCARD folly::Future<std::unique_ptr<ScmStatus>> diff(
       const RootId& commitHash,
@@ -620,6 +662,22 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
       bool enforceCurrentParent = true,
       apache::thrift::ResponseChannelRequest* FOLLY_NULLABLE request = nullptr);
 
+  /**
+   * This accepts a callback which will be invoked as differences are found.
+   * Note that the callback methods may be invoked simultaneously from multiple
+   * different threads, and the callback is responsible for performing
+   * synchronization (if it is needed). It will be packaged into a DiffContext
+   * and passed through the TreeInode diff() codepath.
+   *
+   * Unlike the diff() above, the result is never cached.
+   */
+  FOLLY_NODISCARD folly::Future<folly::Unit> diff(
+      DiffCallback* callback,
+      const RootId& commitHash,
+      bool listIgnored,
+      bool enforceCurrentParent,
+      apache::thrift::ResponseChannelRequest* FOLLY_NULLABLE request) const;
+
   /**
    * This version of diff is primarily intended for testing.
    * Use diff(DiffCallback* callback, bool listIgnored) instead.
@@ -826,6 +884,20 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
       CheckoutMode checkoutMode,
       ObjectFetchContext& context);
 
+  /**
+   * Graft many trees or blobs at once, as if by calling setPathObjectId() for
+   * each of them, but in a single checkout: the rename lock is taken once and
+   * the kernel invalidations are flushed once, after all of them.
+   *
+   * Blobs grafted in the same directory are checked out together. No path may
+   * be given twice, or be a parent directory of another one of the paths.
+   */
+  FOLLY_NODISCARD folly::Future<SetPathObjectIdResultAndTimes>
+  setPathObjectIds(
+      std::vector<PathObjectGraftRequest> objects,
+      CheckoutMode checkoutMode,
+      ObjectFetchContext& context);
+
   /**
    * Should only be called by the mount contructor. We decide wether this
    * mount should use nfs at construction time and do not change the decision.
@@ -928,6 +1000,20 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
 
   folly::SemiFuture<SerializedInodeMap> shutdownImpl(bool doTakeover);
 
+#ifndef _WIN32
+  /**
+   * Save the most recently accessed directories of an NFS mount to its client
+   * directory, for restoreWarmDirectories() to load on the next mount. See
+   * nfs:prewarm-directories.
+   */
+  void saveWarmDirectories();
+
+  /**
+   * Load the directories saved by saveWarmDirectories(), if any. Never fails.
+   */
+  ImmediateFuture<folly::Unit> restoreWarmDirectories();
+#endif // !_WIN32
+
   /**
    * Create a DiffContext to be passed through the TreeInode diff codepath. This
    * will be used to record differences through the callback (in which
@@ -941,20 +1027,6 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
       apache::thrift::ResponseChannelRequest* FOLLY_NULLABLE request =
           nullptr) const;
 
-  /**
-   * This accepts a callback which will be invoked as differences are found.
-   * Note that the callback methods may be invoked simultaneously from multiple
-   * different threads, and the callback is responsible for performing
-   * synchronization (if it is needed). It will be packaged into a DiffContext
-   * and passed through the TreeInode diff() codepath
-   */
-  FOLLY_NODISCARD folly::Future<folly::Unit> diff(
-      DiffCallback* callback,
-      const RootId& commitHash,
-      bool listIgnored,
-      bool enforceCurrentParent,
-      apache::thrift::ResponseChannelRequest* FOLLY_NULLABLE request) const;
-
   /**
    * Signal to unmount() that fuseMount() or takeoverFuse() has started.
    *
@@ -1062,7 +1134,7 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    * Any operation that modifies an existing InodeBase's location_ data must
    * hold the rename lock.
    */
-  folly::SharedMutex renameMutex_;
+  RenameMutex renameMutex_;
 
   struct ParentCommitState {
     RootId commitHash;
@@ -1081,6 +1153,27 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
   std::unique_ptr<Journal> journal_;
   folly::Synchronized<std::unique_ptr<IActivityRecorder>> activityRecorder_;
 
+  /**
+   * The last status computed by diff(), along with the state it was computed
+   * against.
+   */
+  struct CachedStatus {
+    RootId commitHash;
+    bool listIgnored;
+    Journal::SequenceNumber sequence;
+    size_t ignoresVersion;
+    uint64_t unjournaledChanges;
+    ScmStatus status;
+  };
+  folly::Synchronized<std::optional<CachedStatus>> cachedStatus_;
+
+  /**
+   * Incremented before and after operations that update the working copy
+   * without recording the changes in the journal, such as setPathObjectId(),
+   * so that a status computed around them is not reused.
+   */
+  std::atomic<uint64_t> unjournaledChanges_{0};
+
   /**
    * A number to uniquely identify this particular incarnation of this mount.
    * We use bits from the process id and the time at which we were mounted.
@@ -1198,11 +1291,11 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
  * but it also provides a helper method to ensure that it is currently holding
  * a lock on the desired mount.
  */
-class RenameLock : public std::unique_lock<folly::SharedMutex> {
+class RenameLock : public std::unique_lock<RenameMutex> {
  public:
   RenameLock() {}
   explicit RenameLock(EdenMount* mount)
-      : std::unique_lock<folly::SharedMutex>{mount->renameMutex_} {}
+      : std::unique_lock<RenameMutex>{mount->renameMutex_} {}
 
   bool isHeld(EdenMount* mount) const {
     return owns_lock() && (mutex() == &mount->renameMutex_);
@@ -1212,10 +1305,10 @@ class RenameLock : public std::unique_lock<folly::SharedMutex> {
 /**
  * SharedRenameLock is a holder for an EdenMount's rename mutex in shared mode.
  */
-class SharedRenameLock : public std::shared_lock<folly::SharedMutex> {
+class SharedRenameLock : public std::shared_lock<RenameMutex> {
  public:
   explicit SharedRenameLock(EdenMount* mount)
-      : std::shared_lock<folly::SharedMutex>{mount->renameMutex_} {}
+      : std::shared_lock<RenameMutex>{mount->renameMutex_} {}
 
   bool isHeld(EdenMount* mount) const {
     return owns_lock() && (mutex() == &mount->renameMutex_);
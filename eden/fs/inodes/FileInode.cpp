@@ -18,9 +18,11 @@
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/store/SharedFetchContext.h"
 #include "eden/fs/telemetry/IHiveLogger.h"
 #include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/Clock.h"
+#include "eden/fs/utils/CoverageSet.h"
 #include "eden/fs/utils/DirType.h"
 #include "eden/fs/utils/EnumValue.h"
 #include "eden/fs/utils/FileHash.h"
@@ -146,7 +148,7 @@ std::shared_ptr<const Blob> FileInode::LockedState::getCachedBlob(
   // caches.
   ptr_->interestHandle.reset();
 #ifndef _WIN32
-  ptr_->readByteRanges.clear();
+  ptr_->readByteRanges.reset();
 #endif // !_WIN32
 
   return nullptr;
@@ -159,7 +161,7 @@ void FileInode::LockedState::setMaterialized() {
   ptr_->interestHandle.reset();
 
 #ifndef _WIN32
-  ptr_->readByteRanges.clear();
+  ptr_->readByteRanges.reset();
 #endif
 }
 
@@ -168,6 +170,20 @@ void FileInode::LockedState::setMaterialized() {
  * These definitions need to appear before any functions that use them.
  ********************************************************************/
 
+namespace {
+/**
+ * Whether a blob load was cancelled because everyone else waiting on it gave
+ * up, while the caller with fetchContext still wants the data. The caller
+ * should then start the load over.
+ */
+bool shouldRestartLoad(
+    const folly::Try<std::shared_ptr<const Blob>>& blob,
+    const ObjectFetchContext& fetchContext) {
+  return blob.hasException<folly::OperationCancelled>() &&
+      !fetchContext.getCancellationToken().isCancellationRequested();
+}
+} // namespace
+
 template <typename ReturnType, typename Fn>
 ReturnType FileInode::runWhileDataLoaded(
     LockedState state,
@@ -194,7 +210,8 @@ ReturnType FileInode::runWhileDataLoaded(
       break;
     case State::BLOB_LOADING:
       // If we're already loading, latch on to the in-progress load
-      future = state->blobLoadingPromise->getFuture();
+      state->blobLoad->fetchContext->addWaiter(fetchContext);
+      future = state->blobLoad->promise.getFuture();
       state.unlock();
       break;
     case State::MATERIALIZED_IN_OVERLAY:
@@ -203,14 +220,17 @@ ReturnType FileInode::runWhileDataLoaded(
           [&] { return std::forward<Fn>(fn)(std::move(state), nullptr); });
   }
 
-  return std::move(future).thenValue(
+  return std::move(future).thenTry(
       [self = inodePtrFromThis(),
        fn = std::forward<Fn>(fn),
        interest,
-       &fetchContext](std::shared_ptr<const Blob> blob) mutable {
+       &fetchContext](folly::Try<std::shared_ptr<const Blob>> blob) mutable {
         // Simply call runWhileDataLoaded() again when we we finish loading the
         // blob data.  The state should be BLOB_NOT_LOADING or
         // MATERIALIZED_IN_OVERLAY this time around.
+        if (!shouldRestartLoad(blob, fetchContext)) {
+          blob.throwUnlessValue();
+        }
         auto stateLock = LockedState{self};
         XDCHECK(
             stateLock->tag == State::BLOB_NOT_LOADING ||
@@ -220,7 +240,7 @@ ReturnType FileInode::runWhileDataLoaded(
             std::move(stateLock),
             interest,
             fetchContext,
-            std::move(blob),
+            blob.hasValue() ? std::move(blob).value() : nullptr,
             std::forward<Fn>(fn));
       });
 }
@@ -278,7 +298,8 @@ typename folly::futures::detail::callableResult<FileInode::LockedState, Fn>::
       break;
     case State::BLOB_LOADING:
       // If we're already loading, latch on to the in-progress load
-      future = state->blobLoadingPromise->getFuture();
+      state->blobLoad->fetchContext->addWaiter(fetchContext);
+      future = state->blobLoad->promise.getFuture();
       state.unlock();
       break;
     case State::MATERIALIZED_IN_OVERLAY:
@@ -287,11 +308,14 @@ typename folly::futures::detail::callableResult<FileInode::LockedState, Fn>::
           [&] { return std::forward<Fn>(fn)(LockedState{std::move(state)}); });
   }
 
-  return std::move(future).thenValue(
+  return std::move(future).thenTry(
       [self = inodePtrFromThis(), fn = std::forward<Fn>(fn), &fetchContext](
-          std::shared_ptr<const Blob> blob) mutable {
+          folly::Try<std::shared_ptr<const Blob>> blob) mutable {
         // Simply call runWhileMaterialized() again when we we are finished
         // loading the blob data.
+        if (!shouldRestartLoad(blob, fetchContext)) {
+          blob.throwUnlessValue();
+        }
         auto stateLock = LockedState{self};
         XDCHECK(
             stateLock->tag == State::BLOB_NOT_LOADING ||
@@ -299,7 +323,7 @@ typename folly::futures::detail::callableResult<FileInode::LockedState, Fn>::
             << "unexpected FileInode state after loading: " << stateLock->tag;
         return self->runWhileMaterialized(
             std::move(stateLock),
-            std::move(blob),
+            blob.hasValue() ? std::move(blob).value() : nullptr,
             std::forward<Fn>(fn),
             fetchContext);
       });
@@ -322,15 +346,14 @@ FileInode::truncateAndRun(LockedState state, Fn&& fn) {
       // - Assuming we successfully materialized the file, mark ourself
       //   materialized in our parent TreeInode.
       // - If we successfully materialized the file and were in the
-      //   BLOB_LOADING state, fulfill the blobLoadingPromise.
-      std::unique_ptr<folly::SharedPromise<std::shared_ptr<const Blob>>>
-          loadingPromise;
+      //   BLOB_LOADING state, fulfill the blobLoad promise.
+      std::unique_ptr<State::BlobLoad> blobLoad;
       SCOPE_EXIT {
-        if (loadingPromise) {
+        if (blobLoad) {
           // If transitioning from the loading state to materialized, fulfill
           // the loading promise will null. Callbacks will have to handle the
           // case that the state is now materialized.
-          loadingPromise->setValue(nullptr);
+          blobLoad->promise.setValue(nullptr);
         }
       };
 
@@ -338,11 +361,11 @@ FileInode::truncateAndRun(LockedState state, Fn&& fn) {
       materializeAndTruncate(state);
 
       // Now that materializeAndTruncate() has succeeded, extract the
-      // blobLoadingPromise so we can fulfill it as we exit.
-      loadingPromise = std::move(state->blobLoadingPromise);
-      state->blobLoadingPromise.reset();
+      // blobLoad so we can fulfill it as we exit.
+      blobLoad = std::move(state->blobLoad);
+      state->blobLoad.reset();
       // Also call materializeInParent() as we exit, before fulfilling the
-      // blobLoadingPromise.
+      // blobLoad promise.
       SCOPE_EXIT {
         XCHECK(state.isNull());
         materializeInParent();
@@ -392,21 +415,21 @@ void FileInodeState::checkInvariants() {
   switch (tag) {
     case BLOB_NOT_LOADING:
       XCHECK(nonMaterializedState);
-      XCHECK(!blobLoadingPromise);
+      XCHECK(!blobLoad);
       return;
     case BLOB_LOADING:
       XCHECK(nonMaterializedState);
-      XCHECK(blobLoadingPromise);
+      XCHECK(blobLoad);
 #ifndef _WIN32
-      XCHECK(readByteRanges.empty());
+      XCHECK(!readByteRanges);
 #endif
       return;
     case MATERIALIZED_IN_OVERLAY:
       // 'materialized'
       XCHECK(!nonMaterializedState);
-      XCHECK(!blobLoadingPromise);
+      XCHECK(!blobLoad);
 #ifndef _WIN32
-      XCHECK(readByteRanges.empty());
+      XCHECK(!readByteRanges);
 #endif
       return;
   }
@@ -737,6 +760,17 @@ ImmediateFuture<BlobMetadata> FileInode::getBlobMetadata(
   XLOG(FATAL) << "FileInode in illegal state: " << state->tag;
 }
 
+std::optional<ObjectId> FileInode::getBlobHashForMetadata(
+    ObjectFetchContext& fetchContext) {
+  auto state = LockedState{this};
+  if (!state->nonMaterializedState) {
+    return std::nullopt;
+  }
+
+  logAccess(fetchContext);
+  return state->nonMaterializedState->hash;
+}
+
 ImmediateFuture<struct stat> FileInode::stat(ObjectFetchContext& context) {
   auto st = getMount()->initStatData();
   st.st_nlink = 1; // Eden does not support hard links yet.
@@ -892,12 +926,54 @@ void FileInode::materialize() {
 Future<std::tuple<BufVec, bool>>
 FileInode::read(size_t size, off_t off, ObjectFetchContext& context) {
   XDCHECK_GE(off, 0);
-  return runWhileDataLoaded<Future<std::tuple<BufVec, bool>>>(
-      LockedState{this},
+  auto state = LockedState{this};
+
+  std::shared_ptr<const Blob> blob;
+  if (state->tag == State::BLOB_NOT_LOADING) {
+    blob = state.getCachedBlob(getMount(), BlobCache::Interest::WantHandle);
+  }
+  // If this read has to fetch the blob, let the directory decide whether its
+  // other files are about to be read too. This takes the directory's lock, so
+  // it must happen after state_ is released.
+  bool coldRead = state->tag == State::BLOB_NOT_LOADING && !blob;
+  auto noteColdRead = [&] {
+    if (auto parent = getParentRacy()) {
+      parent->childBlobReadCold(context);
+    }
+  };
+
+  if (coldRead) {
+    // Read huge files in ranges rather than loading their whole blob.
+    auto blobSize = state->nonMaterializedState->size;
+    if (blobSize != State::NonMaterializedState::kUnknownSize &&
+        getObjectStore()->shouldReadBlobRanges(blobSize)) {
+      auto hash = state->nonMaterializedState->hash;
+      updateAtimeLocked(*state);
+      state.unlock();
+      logAccess(context);
+      noteColdRead();
+
+      auto offset = static_cast<uint64_t>(off);
+      if (offset >= blobSize) {
+        return makeFuture(
+            std::tuple{BufVec{folly::IOBuf::wrapBuffer("", 0)}, true});
+      }
+      auto length = std::min<uint64_t>(size, blobSize - offset);
+      return getObjectStore()
+          ->getBlobRange(hash, offset, length, context)
+          .thenValue([eof = offset + length == blobSize](
+                         std::unique_ptr<folly::IOBuf> buf) {
+            return std::tuple{BufVec{std::move(buf)}, eof};
+          });
+    }
+  }
+
+  auto future = runWhileDataLoaded<Future<std::tuple<BufVec, bool>>>(
+      std::move(state),
       BlobCache::Interest::WantHandle,
       // This function is only called by FUSE.
       context,
-      nullptr,
+      std::move(blob),
       [size, off, self = inodePtrFromThis()](
           LockedState&& state,
           std::shared_ptr<const Blob> blob) -> std::tuple<BufVec, bool> {
@@ -921,16 +997,26 @@ FileInode::read(size_t size, off_t off, ObjectFetchContext& context) {
         XDCHECK_EQ(state->tag, State::BLOB_NOT_LOADING);
         XDCHECK(blob) << "blob missing after load completed";
 
-        state->readByteRanges.add(off, off + size);
-        if (state->readByteRanges.covers(0, blob->getSize())) {
+        auto& readByteRanges = state->readByteRanges;
+        bool fullyRead = off == 0 && size >= blob->getSize();
+        if (!fullyRead) {
+          if (!readByteRanges) {
+            readByteRanges = std::make_unique<CoverageSet>();
+          }
+          readByteRanges->add(off, off + size);
+          fullyRead = readByteRanges->covers(0, blob->getSize());
+        }
+        if (fullyRead) {
           XLOG(DBG4) << "Inode " << self->getNodeId()
                      << " dropping interest for blob " << blob->getHash()
                      << " because it's been fully read.";
           state->interestHandle.reset();
-          state->readByteRanges.clear();
+          readByteRanges.reset();
         }
 
-        auto buf = blob->getContents();
+        // Hand out slices that share storage with the cached blob rather than
+        // copying: the FUSE and NFS channels write the chain out as is.
+        const auto& buf = blob->getContents();
         folly::io::Cursor cursor(&buf);
 
         if (!cursor.canAdvance(off)) {
@@ -945,6 +1031,10 @@ FileInode::read(size_t size, off_t off, ObjectFetchContext& context) {
 
         return {BufVec{std::move(result)}, cursor.isAtEnd()};
       });
+  if (coldRead) {
+    noteColdRead();
+  }
+  return future;
 }
 
 size_t FileInode::writeImpl(
@@ -1004,6 +1094,25 @@ folly::Future<size_t> FileInode::write(
       },
       fetchContext);
 }
+
+std::optional<size_t>
+FileInode::trySpliceWrite(int pipeFd, size_t size, off_t off) {
+  auto state = LockedState{this};
+  if (state->tag != State::MATERIALIZED_IN_OVERLAY) {
+    return std::nullopt;
+  }
+
+  auto xfer =
+      getOverlayFileAccess(state)->spliceWrite(*this, pipeFd, size, off);
+
+  updateMtimeAndCtimeLocked(*state, getNow());
+
+  state.unlock();
+
+  updateJournal();
+
+  return xfer;
+}
 #endif
 
 Future<std::shared_ptr<const Blob>> FileInode::startLoadingData(
@@ -1015,14 +1124,14 @@ Future<std::shared_ptr<const Blob>> FileInode::startLoadingData(
   // Start the blob load first in case this throws an exception.
   // Ideally the state transition is no-except in tandem with the
   // Future's .then call.
+  auto sharedContext = std::make_shared<SharedFetchContext>(fetchContext);
   auto getBlobFuture = getMount()->getBlobAccess()->getBlob(
-      state->nonMaterializedState->hash, fetchContext, interest);
-  auto blobLoadingPromise =
-      std::make_unique<folly::SharedPromise<std::shared_ptr<const Blob>>>();
+      state->nonMaterializedState->hash, *sharedContext, interest);
+  auto blobLoad = std::make_unique<State::BlobLoad>(sharedContext);
 
   // Everything from here through blobFuture.then should be noexcept.
-  state->blobLoadingPromise = std::move(blobLoadingPromise);
-  auto resultFuture = state->blobLoadingPromise->getFuture();
+  state->blobLoad = std::move(blobLoad);
+  auto resultFuture = state->blobLoad->promise.getFuture();
   state->tag = State::BLOB_LOADING;
 
   // Unlock state_ while we wait on the blob data to load
@@ -1030,7 +1139,8 @@ Future<std::shared_ptr<const Blob>> FileInode::startLoadingData(
 
   auto self = inodePtrFromThis(); // separate line for formatting
   std::move(getBlobFuture)
-      .thenTry([self](folly::Try<BlobCache::GetResult> tryResult) mutable {
+      .thenTry([self, sharedContext = std::move(sharedContext)](
+                   folly::Try<BlobCache::GetResult> tryResult) mutable {
         auto state = LockedState{self};
 
         switch (state->tag) {
@@ -1045,8 +1155,8 @@ Future<std::shared_ptr<const Blob>> FileInode::startLoadingData(
           // materialized the FileInode, so we may already be
           // MATERIALIZED_IN_OVERLAY at this point.
           case State::BLOB_LOADING: {
-            auto promise = std::move(*state->blobLoadingPromise);
-            state->blobLoadingPromise.reset();
+            auto promise = std::move(state->blobLoad->promise);
+            state->blobLoad.reset();
             state->tag = State::BLOB_NOT_LOADING;
 
             // Call the Future's subscribers while the state_ lock is not
@@ -1067,7 +1177,7 @@ Future<std::shared_ptr<const Blob>> FileInode::startLoadingData(
             // The load raced with a someone materializing the file to truncate
             // it.  Nothing left to do here. The truncation completed the
             // promise with a null blob.
-            XCHECK_EQ(state->blobLoadingPromise.get(), nullptr);
+            XCHECK_EQ(state->blobLoad.get(), nullptr);
             return;
         }
       })
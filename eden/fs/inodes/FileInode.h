@@ -20,7 +20,6 @@
 #include "eden/fs/store/ImportPriority.h"
 #include "eden/fs/utils/BufVec.h"
 #ifndef _WIN32
-#include "eden/fs/utils/CoverageSet.h"
 #endif
 
 namespace folly {
@@ -31,9 +30,11 @@ namespace facebook {
 namespace eden {
 
 class Blob;
+class CoverageSet;
 class ObjectFetchContext;
 class ObjectStore;
 class OverlayFileAccess;
+class SharedFetchContext;
 
 /**
  * The contents of a FileInode.
@@ -101,16 +102,30 @@ struct FileInodeState {
    */
   std::optional<NonMaterializedState> nonMaterializedState;
 
+  struct BlobLoad {
+    explicit BlobLoad(std::shared_ptr<SharedFetchContext> fetchContext)
+        : fetchContext{std::move(fetchContext)} {}
+
+    /**
+     * It's possible for this promise to complete with a null blob - that
+     * happens if a truncate operation occurs during load. In that case, the
+     * promise is completed and the inode transitions to the materialized state
+     * without a blob. Callbacks on its futures must handle that case.
+     */
+    folly::SharedPromise<std::shared_ptr<const Blob>> promise;
+
+    /**
+     * The context the blob is fetched with. Everyone waiting on the load is
+     * one of its waiters, so the fetch is only cancelled once all of them gave
+     * up.
+     */
+    std::shared_ptr<SharedFetchContext> fetchContext;
+  };
+
   /**
    * Set if 'loading'. Unset when load completes.
-   *
-   * It's possible for this future to complete with a null blob - that happens
-   * if a truncate operation occurs during load. In that case, the future is
-   * completed and the inode transitions to the materialized state without
-   * a blob. Callbacks on this future must handle that case.
    */
-  std::unique_ptr<folly::SharedPromise<std::shared_ptr<const Blob>>>
-      blobLoadingPromise;
+  std::unique_ptr<BlobLoad> blobLoad;
 
   /**
    * If the blob has ever been loaded from cache, this handle represents this
@@ -128,8 +143,11 @@ struct FileInodeState {
 #ifndef _WIN32
   /**
    * Records the ranges that have been read() when not materialized.
+   *
+   * Only allocated once a partial read happened, so that the many inodes
+   * that are never read, or read in one go, don't pay for it.
    */
-  CoverageSet readByteRanges;
+  std::unique_ptr<CoverageSet> readByteRanges;
 #endif
 };
 
@@ -183,6 +201,16 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
   ImmediateFuture<BlobMetadata> getBlobMetadata(
       ObjectFetchContext& fetchContext);
 
+  /**
+   * If this file is backed by a source control Blob, log the access as
+   * getBlobMetadata() would and return the Blob's hash, so that callers
+   * fetching the metadata of many files can look it up with
+   * ObjectStore::getBlobMetadataBatch(). Returns std::nullopt if the file is
+   * materialized, in which case getBlobMetadata() must be used instead.
+   */
+  std::optional<ObjectId> getBlobHashForMetadata(
+      ObjectFetchContext& fetchContext);
+
   /**
    * Check to see if the file has the same contents as the specified blob
    * and the same tree entry type.
@@ -277,6 +305,13 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
   folly::Future<size_t>
   write(folly::StringPiece data, off_t off, ObjectFetchContext& fetchContext);
 
+  /**
+   * If the file is materialized, write size bytes read from the pipe pipeFd
+   * at off and return how many were written. Otherwise return std::nullopt
+   * without touching the pipe.
+   */
+  std::optional<size_t> trySpliceWrite(int pipeFd, size_t size, off_t off);
+
   void fsync(bool datasync);
 
   FOLLY_NODISCARD folly::Future<folly::Unit>
@@ -365,7 +400,7 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
    *
    * After this function returns the caller must call materializeInParent()
    * after releasing the state lock.  If the state was previously BLOB_LOADING
-   * the caller must also fulfill the blobLoadingPromise.
+   * the caller must also fulfill the blobLoad promise.
    *
    * This should normally only be invoked by truncateAndRun().  Most callers
    * should use truncateAndRun() instead of calling this function directly.
@@ -15,9 +15,11 @@
 #include "eden/fs/inodes/InodeMap.h"
 #include "eden/fs/inodes/InodePtr.h"
 #include "eden/fs/inodes/Overlay.h"
+#include "eden/fs/inodes/ServerState.h"
 #include "eden/fs/inodes/TreeInode.h"
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/utils/Clock.h"
+#include "eden/fs/utils/FaultInjector.h"
 #include "eden/fs/utils/SystemError.h"
 
 using namespace folly;
@@ -51,6 +53,17 @@ FuseDispatcher::Attr attrForInodeWithCorruptOverlay(InodeNumber ino) noexcept {
   st.st_mode = S_IFREG;
   return FuseDispatcher::Attr{st, kBrokenInodeCacheSeconds};
 }
+
+/**
+ * Give fault injection a chance to delay or fail the reply to a FUSE request.
+ * This is free unless faults are defined.
+ */
+ImmediateFuture<folly::Unit> checkFuseFault(
+    EdenMount& mount,
+    folly::StringPiece request) {
+  return mount.getServerState()->getFaultInjector().checkImmediate(
+      "fuse", request);
+}
 } // namespace
 
 FuseDispatcherImpl::FuseDispatcherImpl(EdenMount* mount)
@@ -61,7 +74,8 @@ FuseDispatcherImpl::FuseDispatcherImpl(EdenMount* mount)
 ImmediateFuture<FuseDispatcher::Attr> FuseDispatcherImpl::getattr(
     InodeNumber ino,
     ObjectFetchContext& context) {
-  return inodeMap_->lookupInode(ino)
+  return checkFuseFault(*mount_, "getattr")
+      .thenValue([this, ino](auto&&) { return inodeMap_->lookupInode(ino); })
       .thenValue(
           [&context](const InodePtr& inode) { return inode->stat(context); })
       .thenValue(
@@ -94,7 +108,9 @@ ImmediateFuture<fuse_entry_out> FuseDispatcherImpl::lookup(
     InodeNumber parent,
     PathComponentPiece namepiece,
     ObjectFetchContext& context) {
-  return inodeMap_->lookupTreeInode(parent)
+  return checkFuseFault(*mount_, "lookup")
+      .thenValue(
+          [this, parent](auto&&) { return inodeMap_->lookupTreeInode(parent); })
       .thenValue([name = PathComponent(namepiece),
                   &context](const TreeInodePtr& tree) {
         return tree->getOrLoadChild(name, context);
@@ -207,6 +223,17 @@ void FuseDispatcherImpl::forget(InodeNumber ino, unsigned long nlookup) {
   inodeMap_->decFsRefcount(ino, nlookup);
 }
 
+void FuseDispatcherImpl::batchForget(
+    folly::Range<const fuse_forget_one*> forgets) {
+  std::vector<std::pair<InodeNumber, uint32_t>> decrements;
+  decrements.reserve(forgets.size());
+  for (const auto& forget : forgets) {
+    decrements.emplace_back(
+        InodeNumber{forget.nodeid}, static_cast<uint32_t>(forget.nlookup));
+  }
+  inodeMap_->decFsRefcounts(decrements);
+}
+
 ImmediateFuture<uint64_t> FuseDispatcherImpl::open(
     InodeNumber /*ino*/,
     int /*flags*/) {
@@ -247,8 +274,10 @@ ImmediateFuture<BufVec> FuseDispatcherImpl::read(
     size_t size,
     off_t off,
     ObjectFetchContext& context) {
-  return inodeMap_->lookupFileInode(ino).thenValue(
-      [&context, size, off](FileInodePtr&& inode) {
+  return checkFuseFault(*mount_, "read")
+      .thenValue(
+          [this, ino](auto&&) { return inodeMap_->lookupFileInode(ino); })
+      .thenValue([&context, size, off](FileInodePtr&& inode) {
         return inode->read(size, off, context)
             .thenValue([](std::tuple<BufVec, bool>&& readRes) {
               return std::get<BufVec>(std::move(readRes));
@@ -268,6 +297,19 @@ ImmediateFuture<size_t> FuseDispatcherImpl::write(
       });
 }
 
+std::optional<size_t> FuseDispatcherImpl::trySpliceWrite(
+    InodeNumber ino,
+    int pipeFd,
+    size_t size,
+    off_t off) {
+  // Only a file that is loaded and materialized can take the data right away.
+  auto inode = inodeMap_->lookupLoadedFile(ino);
+  if (!inode) {
+    return std::nullopt;
+  }
+  return inode->trySpliceWrite(pipeFd, size, off);
+}
+
 ImmediateFuture<Unit> FuseDispatcherImpl::flush(
     InodeNumber /* ino */,
     uint64_t /* lock_owner */) {
@@ -41,6 +41,7 @@ class FuseDispatcherImpl : public FuseDispatcher {
       ObjectFetchContext& context) override;
 
   void forget(InodeNumber ino, unsigned long nlookup) override;
+  void batchForget(folly::Range<const fuse_forget_one*> forgets) override;
   ImmediateFuture<uint64_t> open(InodeNumber ino, int flags) override;
   ImmediateFuture<std::string> readlink(
       InodeNumber ino,
@@ -94,6 +95,10 @@ class FuseDispatcherImpl : public FuseDispatcher {
       size_t size,
       off_t off,
       ObjectFetchContext& context) override;
+
+  std::optional<size_t>
+  trySpliceWrite(InodeNumber ino, int pipeFd, size_t size, off_t off) override;
+
   ImmediateFuture<size_t> write(
       InodeNumber ino,
       folly::StringPiece data,
@@ -38,7 +38,7 @@ struct TreeInodePtrRoot {
   explicit TreeInodePtrRoot(TreeInodePtr root) : root(std::move(root)) {}
 
   /** Return an object that holds a lock over the children */
-  folly::Synchronized<TreeInodeState>::RLockedPtr lockContents() {
+  SynchronizedTreeInodeState::RLockedPtr lockContents() {
     return root->getContents().rlock();
   }
 
@@ -61,7 +61,7 @@ struct TreeInodePtrRoot {
    * The returned iterator yields ENTRY elements that can be
    * used with the entryXXX methods below. */
   const DirContents& iterate(
-      const folly::Synchronized<TreeInodeState>::RLockedPtr& contents) const {
+      const SynchronizedTreeInodeState::RLockedPtr& contents) const {
     return contents->entries;
   }
 
@@ -516,18 +516,50 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateRecursiveComponentImpl(
     const RootId& originRootId) const {
   vector<RelativePath> subDirNames;
   vector<ImmediateFuture<folly::Unit>> futures;
+  // Most of the entries of a recursive glob neither match nor are
+  // directories, so their names are built in a reused buffer and only copied
+  // into a RelativePath when they are needed. Matches are also gathered here
+  // so that the shared result lists are not locked for every match.
+  std::string candidateBuffer;
+  vector<GlobResult> matches;
+  vector<ObjectId> blobsToPrefetch;
+  auto flushMatches = [&] {
+    if (!matches.empty()) {
+      auto results = globResult.wlock();
+      results->insert(
+          results->end(),
+          std::make_move_iterator(matches.begin()),
+          std::make_move_iterator(matches.end()));
+      matches.clear();
+    }
+    if (!blobsToPrefetch.empty()) {
+      auto blobs = fileBlobsToPrefetch->wlock();
+      blobs->insert(
+          blobs->end(), blobsToPrefetch.begin(), blobsToPrefetch.end());
+      blobsToPrefetch.clear();
+    }
+  };
   {
     const auto& contents = root.lockContents();
     for (auto& entry : root.iterate(contents)) {
-      auto candidateName = startOfRecursive + root.entryName(entry);
+      candidateBuffer.assign(
+          startOfRecursive.stringPiece().data(),
+          startOfRecursive.stringPiece().size());
+      if (!candidateBuffer.empty()) {
+        candidateBuffer.push_back(kDirSeparator);
+      }
+      auto entryName = root.entryName(entry).stringPiece();
+      candidateBuffer.append(entryName.data(), entryName.size());
+      RelativePathPiece candidateName{
+          candidateBuffer, detail::SkipPathSanityCheck{}};
 
       for (auto& node : recursiveChildren_) {
         if (node->alwaysMatch_ ||
             node->matcher_.match(candidateName.stringPiece())) {
-          globResult.wlock()->emplace_back(root.entryToResult(
-              rootPath + candidateName.copy(), entry, originRootId));
+          matches.emplace_back(root.entryToResult(
+              rootPath + candidateName, entry, originRootId));
           if (fileBlobsToPrefetch && root.entryShouldPrefetch(entry)) {
-            fileBlobsToPrefetch->wlock()->emplace_back(root.entryHash(entry));
+            blobsToPrefetch.emplace_back(root.entryHash(entry));
           }
           // No sense running multiple matches for this same file.
           break;
@@ -538,11 +570,14 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateRecursiveComponentImpl(
       // the lock on the contents.
       if (root.entryIsTree(entry)) {
         if (root.entryShouldLoadChildTree(entry)) {
-          subDirNames.emplace_back(std::move(candidateName));
+          subDirNames.emplace_back(candidateName.copy());
         } else {
+          // Trees that are already loaded are evaluated inline, so keep
+          // their results after the matches that precede them.
+          flushMatches();
           futures.emplace_back(
               store->getTree(root.entryHash(entry), context)
-                  .thenValue([candidateName = std::move(candidateName),
+                  .thenValue([candidateName = candidateName.copy(),
                               rootPath = rootPath.copy(),
                               store,
                               &context,
@@ -565,6 +600,8 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateRecursiveComponentImpl(
     }
   }
 
+  flushMatches();
+
   // Recursively load child inodes and evaluate matches
   for (auto& candidateName : subDirNames) {
     auto childTreeFuture =
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/GlobResultCache.h"
+
+#include <algorithm>
+
+namespace facebook::eden {
+
+GlobResultCache::GlobResultCache(size_t maximumEntries, Clock::duration ttl)
+    : ttl_{ttl},
+      entries_{folly::in_place, std::max<size_t>(maximumEntries, 1)} {}
+
+std::string GlobResultCache::makeKey(
+    folly::StringPiece mountPath,
+    folly::StringPiece rootId,
+    RelativePathPiece searchRoot,
+    const std::vector<std::string>& globs,
+    bool includeDotfiles,
+    bool prefetchFiles) {
+  // NUL can't appear in paths or patterns, so the fields can't run together.
+  std::string key;
+  key.append(mountPath.data(), mountPath.size());
+  key.push_back('\0');
+  key.append(rootId.data(), rootId.size());
+  key.push_back('\0');
+  key.append(searchRoot.stringPiece().data(), searchRoot.stringPiece().size());
+  key.push_back('\0');
+  key.push_back(includeDotfiles ? '1' : '0');
+  key.push_back(prefetchFiles ? '1' : '0');
+  for (const auto& glob : globs) {
+    key.push_back('\0');
+    key.append(glob);
+  }
+  return key;
+}
+
+std::shared_ptr<const GlobResultCache::Results> GlobResultCache::get(
+    const std::string& key,
+    Clock::time_point now) {
+  if (!isEnabled()) {
+    return nullptr;
+  }
+  // A hit promotes the entry in the LRU, so a write lock is needed either way.
+  auto entries = entries_.wlock();
+  auto iter = entries->find(key);
+  if (iter == entries->end()) {
+    return nullptr;
+  }
+  if (iter->second.expiry <= now) {
+    entries->erase(iter);
+    return nullptr;
+  }
+  return iter->second.results;
+}
+
+void GlobResultCache::insert(
+    std::string key,
+    std::shared_ptr<const Results> results,
+    Clock::time_point now) {
+  if (!isEnabled()) {
+    return;
+  }
+  entries_.wlock()->set(std::move(key), Entry{now + ttl_, std::move(results)});
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/utils/DirType.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * A short-lived cache of the results of globs evaluated against commits.
+ *
+ * Tools like watchman and buck often issue the same globFiles call against
+ * the same commit several times in a row. Since a commit never changes, the
+ * matches of a set of patterns below it only need to be computed once, and
+ * the following calls can reuse them. Globs against the working copy are not
+ * cached, as it can change at any time.
+ *
+ * Entries expire after a TTL, which bounds the memory held by results that
+ * are not asked for again. A TTL of zero disables the cache.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class GlobResultCache {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Match {
+    RelativePath name;
+    dtype_t dtype;
+  };
+
+  struct Results {
+    std::vector<Match> matches;
+    /**
+     * The blobs of the matching files, when the glob prefetched them.
+     */
+    std::vector<ObjectId> blobsToPrefetch;
+  };
+
+  GlobResultCache(size_t maximumEntries, Clock::duration ttl);
+
+  bool isEnabled() const noexcept {
+    return ttl_.count() > 0;
+  }
+
+  /**
+   * Build the key of a glob of the given sorted patterns against rootId.
+   * Every option that changes the results has to be part of the key.
+   */
+  static std::string makeKey(
+      folly::StringPiece mountPath,
+      folly::StringPiece rootId,
+      RelativePathPiece searchRoot,
+      const std::vector<std::string>& globs,
+      bool includeDotfiles,
+      bool prefetchFiles);
+
+  std::shared_ptr<const Results> get(
+      const std::string& key,
+      Clock::time_point now = Clock::now());
+
+  void insert(
+      std::string key,
+      std::shared_ptr<const Results> results,
+      Clock::time_point now = Clock::now());
+
+ private:
+  struct Entry {
+    Clock::time_point expiry;
+    std::shared_ptr<const Results> results;
+  };
+
+  const Clock::duration ttl_;
+  folly::Synchronized<folly::EvictingCacheMap<std::string, Entry>> entries_;
+};
+
+} // namespace facebook::eden
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <optional>
 
 #ifdef __APPLE__
@@ -18,6 +19,7 @@
 
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
+#include "eden/fs/model/Hash.h"
 #include "eden/fs/utils/PathFuncs.h"
 
 namespace folly {
@@ -121,6 +123,16 @@ class IOverlay {
       InodeNumber inodeNumber,
       const folly::IOBuf& contents) = 0;
 
+  /**
+   * Like createOverlayFile(), but lets the overlay share the storage of
+   * files whose contents have the given SHA-1, e.g. by cloning a copy of
+   * these contents that it keeps for this purpose.
+   */
+  virtual folly::File createPooledOverlayFile(
+      InodeNumber inodeNumber,
+      const Hash20& contentsSha1,
+      const folly::IOBuf& contents) = 0;
+
   /**
    * Helper function that opens an existing overlay file,
    * checks if the file has valid header, and returns the file.
@@ -148,6 +160,31 @@ class IOverlay {
    */
   virtual void updateUsedInodeNumber(uint64_t /* usedInodeNumber */) {}
 
+  /**
+   * Commit changes in groups of up to maxOperations, or of those made within
+   * window of the first one, rather than one by one. Overlays that don't
+   * commit each change separately ignore this.
+   *
+   * Must be called before initOverlay().
+   */
+  virtual void setGroupCommit(
+      size_t /* maxOperations */,
+      std::chrono::nanoseconds /* window */) {}
+
+  /**
+   * How often an overlay that is kept in memory writes a snapshot of itself
+   * to disk. Other overlays ignore this.
+   *
+   * Must be called before initOverlay().
+   */
+  virtual void setSnapshotInterval(std::chrono::nanoseconds /* interval */) {}
+
+  /**
+   * Write a snapshot of an overlay that is kept in memory to disk now. Other
+   * overlays persist each change already, and do nothing.
+   */
+  virtual void checkpoint() {}
+
   virtual void addChild(
       InodeNumber /* parent */,
       PathComponentPiece /* name */,
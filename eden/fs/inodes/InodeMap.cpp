@@ -11,6 +11,7 @@
 
 #include <folly/Exception.h>
 #include <folly/Likely.h>
+#include <folly/MapUtil.h>
 #include <folly/chrono/Conv.h>
 #include <folly/logging/xlog.h>
 
@@ -21,6 +22,7 @@
 #include "eden/fs/inodes/Overlay.h"
 #include "eden/fs/inodes/ParentInodeInfo.h"
 #include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/store/SharedFetchContext.h"
 #include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/NotImplemented.h"
 #include "eden/fs/utils/SystemError.h"
@@ -122,7 +124,7 @@ InodeMap::~InodeMap() {
 }
 
 inline void InodeMap::insertLoadedInode(
-    const folly::Synchronized<Members>::LockedPtr& data,
+    const SynchronizedMembers::LockedPtr& data,
     InodeBase* inode) {
   auto ret = data->loadedInodes_.emplace(inode->getNodeId(), inode);
   XCHECK(ret.second);
@@ -134,7 +136,7 @@ inline void InodeMap::insertLoadedInode(
 }
 
 void InodeMap::initializeRoot(
-    const folly::Synchronized<Members>::LockedPtr& data,
+    const SynchronizedMembers::LockedPtr& data,
     TreeInodePtr root) {
   XCHECK_EQ(data->loadedInodes_.size(), 0ul)
       << "cannot load InodeMap data over a populated instance";
@@ -154,7 +156,7 @@ void InodeMap::initialize(TreeInodePtr root) {
 
 template <class... Args>
 void InodeMap::initializeUnloadedInode(
-    const folly::Synchronized<Members>::LockedPtr& data,
+    const SynchronizedMembers::LockedPtr& data,
     InodeNumber parentIno,
     InodeNumber ino,
     Args&&... args) {
@@ -175,7 +177,11 @@ void InodeMap::initializeFromTakeover(
   auto data = data_.wlock();
   initializeRoot(data, std::move(root));
 
-  for (const auto& entry : *takeover.unloadedInodes_ref()) {
+  // With millions of remembered inodes, growing the map one rehash at a time
+  // dominates the replay.
+  const auto& entries = *takeover.unloadedInodes_ref();
+  data->unloadedInodes_.reserve(data->unloadedInodes_.size() + entries.size());
+  for (const auto& entry : entries) {
     if (*entry.numFsReferences_ref() < 0) {
       auto message = folly::to<std::string>(
           "inode number ",
@@ -309,6 +315,12 @@ void InodeMap::initializeFromOverlay(TreeInodePtr root, Overlay& overlay) {
 }
 
 ImmediateFuture<InodePtr> InodeMap::lookupInode(InodeNumber number) {
+  // Nearly all lookups are for inodes that are already loaded, which every
+  // FUSE and NFS thread can find concurrently under the read lock.
+  if (auto inode = lookupLoadedInode(number)) {
+    return inode;
+  }
+
   // Lock the data.
   // We hold it while doing most of our work below, but explicitly unlock it
   // before triggering inode loading or before fulfilling any Promises.
@@ -344,12 +356,25 @@ ImmediateFuture<InodePtr> InodeMap::lookupInode(InodeNumber number) {
   bool alreadyLoading = !unloadedData->promises.empty();
 
   // Add a new entry to the promises list.
+  //
+  // This lookup can't be cancelled, but it may join a load that everyone else
+  // waiting on gave up on, and that was cancelled before seeing this lookup.
+  // Look the inode up again in that case.
   unloadedData->promises.emplace_back();
-  auto result = unloadedData->promises.back().getSemiFuture();
+  auto result =
+      ImmediateFuture<InodePtr>{unloadedData->promises.back().getSemiFuture()}
+          .thenTry([this, number](folly::Try<InodePtr>&& inode)
+                       -> ImmediateFuture<InodePtr> {
+            if (inode.hasException<folly::OperationCancelled>()) {
+              return lookupInode(number);
+            }
+            return std::move(inode);
+          });
 
   // If someone else has already started loading this inode we are done.
   // The current loading attempt will signal our promise when it completes.
   if (alreadyLoading) {
+    keepLoadAlive(*data, number);
     return result;
   }
 
@@ -422,6 +447,7 @@ ImmediateFuture<InodePtr> InodeMap::lookupInode(InodeNumber number) {
     if (alreadyLoading) {
       // This parent is already being loaded.
       // We don't need to trigger any new loads ourself.
+      keepLoadAlive(*data, unloadedData->parent);
       return result;
     }
 
@@ -502,6 +528,7 @@ InodeMap::PromiseVector InodeMap::inodeLoadComplete(InodeBase* inode) {
     // Insert the entry into loadedInodes_, and remove it from unloadedInodes_
     insertLoadedInode(data, inode);
     data->unloadedInodes_.erase(it);
+    data->loadContexts_.erase(number);
     return promises;
   } catch (const std::exception& ex) {
     XLOG(ERR) << "error marking inode " << number
@@ -534,10 +561,17 @@ InodeMap::PromiseVector InodeMap::extractPendingPromises(InodeNumber number) {
         << "failed to find unloaded inode data when finishing load of inode "
         << number;
     swap(promises, it->second.promises);
+    data->loadContexts_.erase(number);
   }
   return promises;
 }
 
+void InodeMap::keepLoadAlive(Members& data, InodeNumber number) {
+  if (auto* loadContext = folly::get_ptr(data.loadContexts_, number)) {
+    (*loadContext)->addWaiter(ObjectFetchContext::getNullContext());
+  }
+}
+
 ImmediateFuture<TreeInodePtr> InodeMap::lookupTreeInode(InodeNumber number) {
   return lookupInode(number).thenValue(
       [](const InodePtr& inode) { return inode.asTreePtr(); });
@@ -580,7 +614,7 @@ std::optional<RelativePath> InodeMap::getPathForInode(InodeNumber inodeNumber) {
 
 std::optional<RelativePath> InodeMap::getPathForInodeHelper(
     InodeNumber inodeNumber,
-    const folly::Synchronized<Members>::RLockedPtr& data) {
+    const SynchronizedMembers::RLockedPtr& data) {
   auto loadedIt = data->loadedInodes_.find(inodeNumber);
   if (loadedIt != data->loadedInodes_.cend()) {
     // If the inode is loaded, return its RelativePath
@@ -610,20 +644,40 @@ std::optional<RelativePath> InodeMap::getPathForInodeHelper(
   }
 }
 void InodeMap::decFsRefcount(InodeNumber number, uint32_t count) {
-  InodePtr inodePtr;
-  {
+  // The FS refcount of a loaded inode is decremented on the inode itself, so
+  // the write lock is only needed for unloaded inodes.
+  auto inodePtr = lookupLoadedInode(number);
+  if (!inodePtr) {
     auto data = data_.wlock();
     inodePtr = decFsRefcountHelper(data, number, count);
   }
   // Now release our lock before decrementing the inode's FS reference
   // count and immediately releasing our pointer reference.
   if (inodePtr) {
-    inodePtr->decFsRefcount();
+    inodePtr->decFsRefcount(count);
+  }
+}
+
+void InodeMap::decFsRefcounts(
+    folly::Range<const std::pair<InodeNumber, uint32_t>*> decrements) {
+  std::vector<std::pair<InodePtr, uint32_t>> loaded;
+  {
+    auto data = data_.wlock();
+    for (const auto& [number, count] : decrements) {
+      if (auto inodePtr = decFsRefcountHelper(data, number, count)) {
+        loaded.emplace_back(std::move(inodePtr), count);
+      }
+    }
+  }
+  // As in decFsRefcount(), decrement loaded inodes and drop our pointer
+  // references only after releasing the lock.
+  for (auto& [inodePtr, count] : loaded) {
+    inodePtr->decFsRefcount(count);
   }
 }
 
 InodePtr InodeMap::decFsRefcountHelper(
-    folly::Synchronized<Members>::LockedPtr& data,
+    SynchronizedMembers::LockedPtr& data,
     InodeNumber number,
     uint32_t count,
     bool clearRefCount) {
@@ -912,8 +966,7 @@ Future<SerializedInodeMap> InodeMap::shutdown(
   });
 }
 
-void InodeMap::shutdownComplete(
-    folly::Synchronized<Members>::LockedPtr&& data) {
+void InodeMap::shutdownComplete(SynchronizedMembers::LockedPtr&& data) {
   // We manually dropped our reference count to the root inode in
   // beginShutdown().  Destroy it now, and call resetNoDecRef() on our pointer
   // to make sure it doesn't try to decrement the reference count again when
@@ -1020,7 +1073,7 @@ void InodeMap::unloadInode(
     TreeInode* parent,
     PathComponentPiece name,
     bool isUnlinked,
-    const folly::Synchronized<Members>::LockedPtr& data) {
+    const SynchronizedMembers::LockedPtr& data) {
   // Call updateOverlayForUnload() to update the overlay and compute
   // if we need to remember an UnloadedInode entry.
   auto unloadedEntry =
@@ -1049,7 +1102,7 @@ optional<InodeMap::UnloadedInode> InodeMap::updateOverlayForUnload(
     TreeInode* parent,
     PathComponentPiece name,
     bool isUnlinked,
-    const folly::Synchronized<Members>::LockedPtr& data) {
+    const SynchronizedMembers::LockedPtr& data) {
   auto fsCount = inode->getFsRefcount();
   if (isUnlinked && (data->isUnmounted_ || fsCount == 0)) {
     try {
@@ -1136,11 +1189,12 @@ optional<InodeMap::UnloadedInode> InodeMap::updateOverlayForUnload(
   }
 }
 
-bool InodeMap::shouldLoadChild(
+std::shared_ptr<SharedFetchContext> InodeMap::shouldLoadChild(
     const TreeInode* parent,
     PathComponentPiece name,
     InodeNumber childInode,
-    folly::Promise<InodePtr> promise) {
+    folly::Promise<InodePtr> promise,
+    ObjectFetchContext& context) {
   auto data = data_.wlock();
   UnloadedInode* unloadedData{nullptr};
   auto iter = data->unloadedInodes_.find(childInode);
@@ -1163,7 +1217,16 @@ bool InodeMap::shouldLoadChild(
   // If this is the very first promise then tell the caller they need
   // to start the load operation.  Otherwise someone else (whoever added the
   // first promise) has already started loading the inode.
-  return isFirstPromise;
+  if (!isFirstPromise) {
+    if (auto* loadContext = folly::get_ptr(data->loadContexts_, childInode)) {
+      (*loadContext)->addWaiter(context);
+    }
+    return nullptr;
+  }
+
+  auto loadContext = std::make_shared<SharedFetchContext>(context);
+  data->loadContexts_.emplace(childInode, loadContext);
+  return loadContext;
 }
 
 void InodeMap::inodeCreated(const InodePtr& inode) {
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <folly/Range.h>
+#include <folly/SharedMutex.h>
 #include <folly/Synchronized.h>
 #include <folly/futures/Future.h>
 #include <list>
@@ -18,6 +20,7 @@
 #include "eden/fs/inodes/InodePtr.h"
 #include "eden/fs/inodes/Overlay.h"
 #include "eden/fs/model/ObjectId.h"
+#include "eden/fs/telemetry/LockProfiling.h"
 #include "eden/fs/takeover/gen-cpp2/takeover_types.h"
 #include "eden/fs/utils/ImmediateFuture.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -32,6 +35,8 @@ namespace eden {
 class EdenMount;
 class FileInode;
 class InodeBase;
+class ObjectFetchContext;
+class SharedFetchContext;
 class TreeInode;
 class ParentInodeInfo;
 class ReloadableConfig;
@@ -239,6 +244,13 @@ class InodeMap {
    */
   void decFsRefcount(InodeNumber number, uint32_t count = 1);
 
+  /**
+   * decFsRefcount() for each (inode number, count) pair, taking the data lock
+   * once for the whole batch rather than once per inode.
+   */
+  void decFsRefcounts(
+      folly::Range<const std::pair<InodeNumber, uint32_t>*> decrements);
+
   /**
    * See EdenMount::forgetStaleInodes
    */
@@ -331,10 +343,10 @@ class InodeMap {
    *
    * shouldLoadChild() will be called when TreeInode wants to load one of
    * its child entries that already has an allocated inode number.  It returns
-   * true if the TreeInode should start loading the inode now, or false if the
-   * inode is already being loaded.
+   * a fetch context if the TreeInode should start loading the inode now, or
+   * null if the inode is already being loaded.
    *
-   * If shouldLoadChild() returns true, the TreeInode will then start
+   * If shouldLoadChild() returns a context, the TreeInode will then start
    * loading the child inode.  It must then call inodeLoadComplete() or
    * inodeLoadFailed() when it finishes loading the inode.
    *
@@ -346,15 +358,19 @@ class InodeMap {
    * @param childInode The inode number of the child.
    * @param promise A promise to fulfill when this inode is finished loading.
    *   The InodeMap is responsible for fulfilling this promise.
+   * @param context The fetch context of the caller, which becomes a waiter of
+   *   the load: the load is only cancelled once all its waiters gave up.
    *
-   * @return Returns true if the TreeInode should start loading this child
-   *   inode, or false if this child is already being loaded.
+   * @return Returns the fetch context to load this child inode with if the
+   *   TreeInode should start loading it, or null if this child is already
+   *   being loaded.
    */
-  bool shouldLoadChild(
+  std::shared_ptr<SharedFetchContext> shouldLoadChild(
       const TreeInode* parent,
       PathComponentPiece name,
       InodeNumber childInode,
-      folly::Promise<InodePtr> promise);
+      folly::Promise<InodePtr> promise,
+      ObjectFetchContext& context);
 
   /**
    * inodeLoadComplete() should only be called by TreeInode.
@@ -520,6 +536,14 @@ class InodeMap {
      */
     std::unordered_map<InodeNumber, UnloadedInode> unloadedInodes_;
 
+    /**
+     * The fetch contexts of the loads started through shouldLoadChild() that
+     * are still in progress. Lookups that join one of these loads become
+     * waiters of its context.
+     */
+    std::unordered_map<InodeNumber, std::shared_ptr<SharedFetchContext>>
+        loadContexts_;
+
     /**
      * Indicates if the FS mount point has been unmounted.
      *
@@ -556,10 +580,16 @@ class InodeMap {
     std::optional<folly::Promise<folly::Unit>> shutdownPromise;
   };
 
+  using MembersMutex = ProfiledSharedMutex<
+      folly::SharedMutex,
+      &LockThreadStats::inodeMapWait,
+      &LockThreadStats::inodeMapHold>;
+  using SynchronizedMembers = folly::Synchronized<Members, MembersMutex>;
+
   InodeMap(InodeMap const&) = delete;
   InodeMap& operator=(InodeMap const&) = delete;
 
-  void shutdownComplete(folly::Synchronized<Members>::LockedPtr&& data);
+  void shutdownComplete(SynchronizedMembers::LockedPtr&& data);
 
   void setupParentLookupPromise(
       folly::Promise<InodePtr>& promise,
@@ -585,9 +615,15 @@ class InodeMap {
    */
   PromiseVector extractPendingPromises(InodeNumber number);
 
+  /**
+   * Called when a lookup that can't be cancelled joins the load of the
+   * specified inode number, which then won't be cancelled either.
+   */
+  static void keepLoadAlive(Members& data, InodeNumber number);
+
   std::optional<RelativePath> getPathForInodeHelper(
       InodeNumber inodeNumber,
-      const folly::Synchronized<Members>::RLockedPtr& data);
+      const SynchronizedMembers::RLockedPtr& data);
 
   /**
    * Unload an inode
@@ -603,7 +639,7 @@ class InodeMap {
       TreeInode* parent,
       PathComponentPiece name,
       bool isUnlinked,
-      const folly::Synchronized<Members>::LockedPtr& lock);
+      const SynchronizedMembers::LockedPtr& lock);
 
   /**
    * Update the overlay data for an inode before unloading it.
@@ -617,17 +653,17 @@ class InodeMap {
       TreeInode* parent,
       PathComponentPiece name,
       bool isUnlinked,
-      const folly::Synchronized<Members>::LockedPtr& lock);
+      const SynchronizedMembers::LockedPtr& lock);
 
   void insertLoadedInode(
-      const folly::Synchronized<Members>::LockedPtr& data,
+      const SynchronizedMembers::LockedPtr& data,
       InodeBase* inode);
 
   /**
    * Verify the InodeMap precondition and initialize the root_ member.
    */
   void initializeRoot(
-      const folly::Synchronized<Members>::LockedPtr& data,
+      const SynchronizedMembers::LockedPtr& data,
       TreeInodePtr root);
 
   /**
@@ -641,7 +677,7 @@ class InodeMap {
    */
   template <class... Args>
   void initializeUnloadedInode(
-      const folly::Synchronized<Members>::LockedPtr& data,
+      const SynchronizedMembers::LockedPtr& data,
       InodeNumber parentIno,
       InodeNumber ino,
       Args&&... args);
@@ -654,7 +690,7 @@ class InodeMap {
    * WARNING: The returned inodePtr must be destroyed OUTSIDE of the data lock!
    */
   InodePtr decFsRefcountHelper(
-      folly::Synchronized<Members>::LockedPtr& data,
+      SynchronizedMembers::LockedPtr& data,
       InodeNumber number,
       uint32_t count = 0,
       bool clearRefCount = false);
@@ -684,7 +720,7 @@ class InodeMap {
    * internal lock.  (This makes it safe for InodeBase to perform operations on
    * the InodeMap while holding their own lock.)
    */
-  folly::Synchronized<Members> data_;
+  SynchronizedMembers data_;
 
   /**
    * This boolean controls EdenFS's response to receiving a request for an
@@ -723,8 +759,7 @@ class InodeMap {
  */
 class InodeMapLock {
  public:
-  explicit InodeMapLock(
-      folly::Synchronized<InodeMap::Members>::LockedPtr&& data)
+  explicit InodeMapLock(InodeMap::SynchronizedMembers::LockedPtr&& data)
       : data_(std::move(data)) {}
 
   void unlock() {
@@ -733,7 +768,7 @@ class InodeMapLock {
 
  private:
   friend class InodeMap;
-  folly::Synchronized<InodeMap::Members>::LockedPtr data_;
+  InodeMap::SynchronizedMembers::LockedPtr data_;
 };
 } // namespace eden
 } // namespace facebook
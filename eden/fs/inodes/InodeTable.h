@@ -239,6 +239,14 @@ class InodeTable {
     }
   }
 
+  /**
+   * Hint that the table's storage should be backed by huge pages. See
+   * MappedDiskVector::adviseHugePages().
+   */
+  void adviseHugePages() {
+    state_.wlock()->storage.adviseHugePages();
+  }
+
  private:
   explicit InodeTable(MappedDiskVector<Entry>&& storage)
       : state_{folly::in_place, std::move(storage)} {}
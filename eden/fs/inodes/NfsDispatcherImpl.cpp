@@ -19,6 +19,30 @@
 
 namespace facebook::eden {
 
+namespace {
+/**
+ * Stat an inode after it, or one of its children, was modified.
+ *
+ * The result is sent back as post-op attributes of the reply, which lets the
+ * client refresh its attribute cache without a GETATTR round trip. These
+ * attributes are optional in the protocol, hence a failure to stat isn't
+ * reported to the caller.
+ */
+ImmediateFuture<std::optional<struct stat>> statForReply(
+    InodePtr inode,
+    ObjectFetchContext& context) {
+  auto statFut = inode->stat(context);
+  return std::move(statFut).thenTry(
+      [inode = std::move(inode)](
+          folly::Try<struct stat> st) -> std::optional<struct stat> {
+        if (st.hasException()) {
+          return std::nullopt;
+        }
+        return st.value();
+      });
+}
+} // namespace
+
 NfsDispatcherImpl::NfsDispatcherImpl(EdenMount* mount)
     : NfsDispatcher(mount->getStats(), mount->getClock()),
       mount_(mount),
@@ -108,13 +132,15 @@ ImmediateFuture<NfsDispatcher::WriteRes> NfsDispatcherImpl::write(
   return inodeMap_->lookupFileInode(ino).thenValue(
       [data = std::move(data), offset, &context](
           const FileInodePtr& inode) mutable {
-        // TODO(xavierd): Modify write to obtain pre and post stat of the
-        // file.
-        return inode->write(std::move(data), offset, context)
-            .thenValue([](size_t written) {
-              return WriteRes{written, std::nullopt, std::nullopt};
-            })
-            .semi();
+        // TODO(xavierd): Modify write to obtain the pre stat of the file.
+        return ImmediateFuture<size_t>{
+            inode->write(std::move(data), offset, context).semi()}
+            .thenValue([inode, &context](size_t written) {
+              return statForReply(inode, context)
+                  .thenValue([written](std::optional<struct stat> postStat) {
+                    return WriteRes{written, std::nullopt, postStat};
+                  });
+            });
       });
 }
 
@@ -127,19 +153,20 @@ ImmediateFuture<NfsDispatcher::CreateRes> NfsDispatcherImpl::create(
   mode = S_IFREG | (0777 & mode);
   return inodeMap_->lookupTreeInode(dir).thenValue(
       [&context, name = std::move(name), mode](const TreeInodePtr& inode) {
-        // TODO(xavierd): Modify mknod to obtain the pre and post stat of the
+        // TODO(xavierd): Modify mknod to obtain the pre stat of the
         // directory.
         // Set dev to 0 as this is unused for a regular file.
         auto newFile = inode->mknod(name, mode, 0, InvalidationRequired::No);
         auto statFut = newFile->stat(context);
         return std::move(statFut).thenValue(
-            [newFile = std::move(newFile)](struct stat&& stat) {
+            [newFile = std::move(newFile), inode, &context](
+                struct stat&& stat) {
               newFile->incFsRefcount();
-              return CreateRes{
-                  newFile->getNodeId(),
-                  std::move(stat),
-                  std::nullopt,
-                  std::nullopt};
+              return statForReply(inode, context)
+                  .thenValue([ino = newFile->getNodeId(), stat](
+                                 std::optional<struct stat> postDirStat) {
+                    return CreateRes{ino, stat, std::nullopt, postDirStat};
+                  });
             });
       });
 }
@@ -151,16 +178,19 @@ ImmediateFuture<NfsDispatcher::MkdirRes> NfsDispatcherImpl::mkdir(
     ObjectFetchContext& context) {
   return inodeMap_->lookupTreeInode(dir).thenValue(
       [&context, name = std::move(name), mode](const TreeInodePtr& inode) {
-        // TODO(xavierd): Modify mkdir to obtain the pre and post stat of the
+        // TODO(xavierd): Modify mkdir to obtain the pre stat of the
         // directory.
         auto newDir = inode->mkdir(name, mode, InvalidationRequired::No);
         auto statFut = newDir->stat(context);
-        return std::move(statFut).thenValue([newDir = std::move(newDir)](
-                                                struct stat&& stat) {
-          newDir->incFsRefcount();
-          return MkdirRes{
-              newDir->getNodeId(), std::move(stat), std::nullopt, std::nullopt};
-        });
+        return std::move(statFut).thenValue(
+            [newDir = std::move(newDir), inode, &context](struct stat&& stat) {
+              newDir->incFsRefcount();
+              return statForReply(inode, context)
+                  .thenValue([ino = newDir->getNodeId(), stat](
+                                 std::optional<struct stat> postDirStat) {
+                    return MkdirRes{ino, stat, std::nullopt, postDirStat};
+                  });
+            });
       });
 }
 
@@ -172,18 +202,19 @@ ImmediateFuture<NfsDispatcher::SymlinkRes> NfsDispatcherImpl::symlink(
   return inodeMap_->lookupTreeInode(dir).thenValue(
       [&context, name = std::move(name), data = std::move(data)](
           const TreeInodePtr& inode) {
-        // TODO(xavierd): Modify symlink to obtain the pre and post stat of the
+        // TODO(xavierd): Modify symlink to obtain the pre stat of the
         // directory.
         auto symlink = inode->symlink(name, data, InvalidationRequired::No);
         auto statFut = symlink->stat(context);
         return std::move(statFut).thenValue(
-            [symlink = std::move(symlink)](struct stat&& stat) {
+            [symlink = std::move(symlink), inode, &context](
+                struct stat&& stat) {
               symlink->incFsRefcount();
-              return SymlinkRes{
-                  symlink->getNodeId(),
-                  std::move(stat),
-                  std::nullopt,
-                  std::nullopt};
+              return statForReply(inode, context)
+                  .thenValue([ino = symlink->getNodeId(), stat](
+                                 std::optional<struct stat> postDirStat) {
+                    return SymlinkRes{ino, stat, std::nullopt, postDirStat};
+                  });
             });
       });
 }
@@ -197,18 +228,19 @@ ImmediateFuture<NfsDispatcher::MknodRes> NfsDispatcherImpl::mknod(
   return inodeMap_->lookupTreeInode(dir).thenValue(
       [&context, name = std::move(name), mode, rdev](
           const TreeInodePtr& inode) {
-        // TODO(xavierd): Modify mknod to obtain the pre and post stat of the
+        // TODO(xavierd): Modify mknod to obtain the pre stat of the
         // directory.
         auto newFile = inode->mknod(name, mode, rdev, InvalidationRequired::No);
         auto statFut = newFile->stat(context);
         return std::move(statFut).thenValue(
-            [newFile = std::move(newFile)](struct stat&& stat) {
+            [newFile = std::move(newFile), inode, &context](
+                struct stat&& stat) {
               newFile->incFsRefcount();
-              return MknodRes{
-                  newFile->getNodeId(),
-                  std::move(stat),
-                  std::nullopt,
-                  std::nullopt};
+              return statForReply(inode, context)
+                  .thenValue([ino = newFile->getNodeId(), stat](
+                                 std::optional<struct stat> postDirStat) {
+                    return MknodRes{ino, stat, std::nullopt, postDirStat};
+                  });
             });
       });
 }
@@ -220,10 +252,13 @@ ImmediateFuture<NfsDispatcher::UnlinkRes> NfsDispatcherImpl::unlink(
   return inodeMap_->lookupTreeInode(dir).thenValue(
       [&context, name = std::move(name)](const TreeInodePtr& inode) {
         return inode->unlink(name, InvalidationRequired::No, context)
-            .thenValue([](auto&&) {
-              // TODO(xavierd): Modify unlink to obtain the pre and post stat
-              // of the directory.
-              return NfsDispatcher::UnlinkRes{std::nullopt, std::nullopt};
+            .thenValue([inode, &context](auto&&) {
+              // TODO(xavierd): Modify unlink to obtain the pre stat of the
+              // directory.
+              return statForReply(inode, context)
+                  .thenValue([](std::optional<struct stat> postDirStat) {
+                    return NfsDispatcher::UnlinkRes{std::nullopt, postDirStat};
+                  });
             });
       });
 }
@@ -235,10 +270,13 @@ ImmediateFuture<NfsDispatcher::RmdirRes> NfsDispatcherImpl::rmdir(
   return inodeMap_->lookupTreeInode(dir).thenValue(
       [&context, name = std::move(name)](const TreeInodePtr& inode) {
         return inode->rmdir(name, InvalidationRequired::No, context)
-            .thenValue([](auto&&) {
-              // TODO(xavierd): Modify rmdir to obtain the pre and post stat of
-              // the directory.
-              return NfsDispatcher::RmdirRes{std::nullopt, std::nullopt};
+            .thenValue([inode, &context](auto&&) {
+              // TODO(xavierd): Modify rmdir to obtain the pre stat of the
+              // directory.
+              return statForReply(inode, context)
+                  .thenValue([](std::optional<struct stat> postDirStat) {
+                    return NfsDispatcher::RmdirRes{std::nullopt, postDirStat};
+                  });
             });
       });
 }
@@ -267,12 +305,25 @@ ImmediateFuture<NfsDispatcher::RenameRes> NfsDispatcherImpl::rename(
                       toName,
                       InvalidationRequired::No,
                       context)
-                  .semi();
+                  .thenValue([fromDirInode, toDirInode, &context](auto&&) {
+                    // TODO(xavierd): collect pre dir stats.
+                    auto fromStatFut = statForReply(fromDirInode, context);
+                    return std::move(fromStatFut)
+                        .thenValue([toDirInode, &context](
+                                       std::optional<struct stat> fromStat) {
+                          return statForReply(toDirInode, context)
+                              .thenValue(
+                                  [fromStat](
+                                      std::optional<struct stat> toStat) {
+                                    return NfsDispatcher::RenameRes{
+                                        std::nullopt,
+                                        fromStat,
+                                        std::nullopt,
+                                        toStat};
+                                  });
+                        });
+                  });
             });
-      })
-      .thenValue([](auto&&) {
-        // TODO(xavierd): collect pre and post dir stats.
-        return NfsDispatcher::RenameRes{};
       });
 }
 
@@ -300,6 +351,20 @@ ImmediateFuture<NfsDispatcher::ReaddirRes> NfsDispatcherImpl::readdirplus(
             NfsDirList{count, nfsv3Procs::readdirplus}, offset, context);
         auto& dirListRef = dirList.getListRef();
         std::vector<ImmediateFuture<folly::Unit>> futuresVec{};
+
+        // Start one batched metadata lookup for the whole page before loading
+        // the children, the stat() of each file below then shares it.
+        std::vector<PathComponent> names;
+        names.reserve(dirListRef.size());
+        for (const auto& entry : dirListRef) {
+          if (entry.name != "." && entry.name != "..") {
+            names.emplace_back(entry.name);
+          }
+        }
+        futuresVec.push_back(
+            inode->prefetchChildBlobMetadata(names, context)
+                .thenTry([](folly::Try<folly::Unit>) { return folly::unit; }));
+
         for (auto& entry : dirListRef) {
           if (entry.name == "." || entry.name == "..") {
             futuresVec.push_back(
@@ -311,7 +376,7 @@ ImmediateFuture<NfsDispatcher::ReaddirRes> NfsDispatcherImpl::readdirplus(
           } else {
             futuresVec.push_back(
                 inode->getOrLoadChild(PathComponent{entry.name}, context)
-                    .thenValue([entry, &context](InodePtr&& inodep) {
+                    .thenValue([&context](InodePtr&& inodep) {
                       return inodep->stat(context);
                     })
                     .thenTry([&entry](folly::Try<struct stat> st) {
@@ -337,6 +402,14 @@ ImmediateFuture<struct statfs> NfsDispatcherImpl::statfs(
   return mount_->getOverlay()->statFs();
 }
 
+ImmediateFuture<folly::Unit> NfsDispatcherImpl::fsync(
+    InodeNumber ino,
+    bool datasync,
+    ObjectFetchContext& /*context*/) {
+  return inodeMap_->lookupFileInode(ino).thenValue(
+      [datasync](const FileInodePtr& inode) { inode->fsync(datasync); });
+}
+
 } // namespace facebook::eden
 
 #endif
@@ -111,6 +111,9 @@ class NfsDispatcherImpl : public NfsDispatcher {
       InodeNumber ino,
       ObjectFetchContext& context) override;
 
+  ImmediateFuture<folly::Unit>
+  fsync(InodeNumber ino, bool datasync, ObjectFetchContext& context) override;
+
  private:
   // The EdenMount associated with this dispatcher.
   EdenMount* const mount_;
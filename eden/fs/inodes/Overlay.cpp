@@ -9,13 +9,16 @@
 
 #include <boost/filesystem.hpp>
 #include <algorithm>
+#include <utility>
 
 #include <folly/Exception.h>
 #include <folly/File.h>
 #include <folly/FileUtil.h>
 #include <folly/Range.h>
+#include <folly/String.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
+#include <folly/lang/Bits.h>
 #include <folly/logging/xlog.h>
 #include <folly/stop_watch.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
@@ -39,6 +42,33 @@ namespace {
 constexpr uint64_t ioCountMask = 0x7FFFFFFFFFFFFFFFull;
 constexpr uint64_t ioClosedMask = 1ull << 63;
 
+using apache::thrift::CompactSerializer;
+
+constexpr folly::StringPiece kDirJournalFile{"dir-journal"};
+
+/**
+ * The operations of the journal of the dirty directories. Each record is the
+ * little-endian uint32_t length of the rest, the uint8_t operation, the
+ * uint64_t inode number, the uint32_t length of the child name, the child
+ * name and a payload taking up the rest of the record.
+ */
+enum DirJournalOp : uint8_t {
+  // The payload is the serialized overlay::OverlayDir.
+  kDirJournalSave = 1,
+  // The payload is the serialized overlay::OverlayEntry of the child.
+  kDirJournalSetChild = 2,
+  kDirJournalRemoveChild = 3,
+  // The directory was removed.
+  kDirJournalDrop = 4,
+};
+
+constexpr size_t kDirJournalHeaderLength =
+    sizeof(uint8_t) + sizeof(uint64_t) + sizeof(uint32_t);
+
+// How long the GC thread waits before writing the directories that failed to
+// be written again.
+constexpr std::chrono::seconds kDirtyDirRetryInterval{5};
+
 std::unique_ptr<IOverlay> makeOverlay(
     AbsolutePathPiece localDir,
     Overlay::OverlayType overlayType) {
@@ -51,6 +81,9 @@ std::unique_ptr<IOverlay> makeOverlay(
   } else if (overlayType == Overlay::OverlayType::TreeSynchronousOff) {
     return std::make_unique<TreeOverlay>(
         localDir, TreeOverlayStore::SynchronousMode::Off);
+  } else if (overlayType == Overlay::OverlayType::TreeInMemorySnapshot) {
+    return std::make_unique<TreeOverlay>(
+        localDir, TreeOverlay::inMemorySnapshot);
   }
 #ifdef _WIN32
   return std::make_unique<SqliteOverlay>(localDir);
@@ -111,6 +144,9 @@ void Overlay::close() {
     return;
   }
 
+  // The GC thread is gone, so write what it didn't get to here.
+  writeDirtyDirs();
+
   // Since we are closing the overlay, no other threads can still be using
   // it. They must have used some external synchronization mechanism to
   // ensure this, so it is okay for us to still use relaxed access to
@@ -177,6 +213,7 @@ void Overlay::initOverlay(
         progressCallback) {
   IORequest req{this};
   auto optNextInodeNumber = backingOverlay_->initOverlay(true);
+  replayDirJournal();
   if (!optNextInodeNumber.has_value()) {
 #ifndef _WIN32
     // If the next-inode-number data is missing it means that this overlay was
@@ -239,6 +276,9 @@ void Overlay::initOverlay(
       InodeMetadataTable::open((backingOverlay_->getLocalDir() +
                                 PathComponentPiece{FsOverlay::kMetadataFile})
                                    .c_str());
+  if (hugePages_) {
+    inodeMetadataTable_->adviseHugePages();
+  }
 #endif // !_WIN32
 }
 
@@ -264,15 +304,37 @@ InodeNumber Overlay::allocateInodeNumber() {
   return InodeNumber{previous};
 }
 
+InodeNumber Overlay::allocateInodeNumbers(size_t count) {
+  XDCHECK_NE(0u, count);
+  auto first = nextInodeNumber_.fetch_add(count);
+#ifdef _WIN32
+  backingOverlay_->updateUsedInodeNumber(first + count - 1);
+#endif
+  XDCHECK_NE(0u, first) << "allocateInodeNumbers called before initialize";
+  return InodeNumber{first};
+}
+
 DirContents Overlay::loadOverlayDir(InodeNumber inodeNumber) {
   DirContents result(caseSensitive_);
   IORequest req{this};
-  auto dirData = backingOverlay_->loadOverlayDir(inodeNumber);
+  std::optional<overlay::OverlayDir> dirData;
+  if (dirWriteBack_) {
+    auto dirtyDirs = dirtyDirs_.rlock();
+    if (auto dirtyDir = dirtyDirs->find(inodeNumber)) {
+      dirData = *dirtyDir;
+    }
+  }
+  if (!dirData.has_value()) {
+    dirData = backingOverlay_->loadOverlayDir(inodeNumber);
+  }
   if (!dirData.has_value()) {
     return result;
   }
   const auto& dir = dirData.value();
+  result.reserve(dir.entries_ref()->size());
 
+  // Set when entries are rewritten as they are loaded, in which case the
+  // directory is saved back in the new format.
   bool shouldMigrateToNewFormat = false;
 
   for (auto& iter : *dir.entries_ref()) {
@@ -290,6 +352,12 @@ DirContents Overlay::loadOverlayDir(InodeNumber inodeNumber) {
     if (value.hash_ref() && !value.hash_ref()->empty()) {
       auto hash =
           ObjectId{folly::ByteRange{folly::StringPiece{*value.hash_ref()}}};
+      if (objectIdMigrator_) {
+        if (auto migrated = objectIdMigrator_(hash)) {
+          hash = std::move(*migrated);
+          shouldMigrateToNewFormat = true;
+        }
+      }
       result.emplace(PathComponentPiece{name}, *value.mode_ref(), ino, hash);
     } else {
       // The inode is materialized
@@ -351,11 +419,297 @@ overlay::OverlayDir Overlay::serializeOverlayDir(
   return odir;
 }
 
+void Overlay::setGroupCommit(
+    size_t maxOperations,
+    std::chrono::nanoseconds window) {
+  backingOverlay_->setGroupCommit(maxOperations, window);
+}
+
+void Overlay::setSnapshotInterval(std::chrono::nanoseconds interval) {
+  backingOverlay_->setSnapshotInterval(interval);
+}
+
+void Overlay::checkpoint() {
+  IORequest req{this};
+  backingOverlay_->checkpoint();
+}
+
 void Overlay::saveOverlayDir(InodeNumber inodeNumber, const DirContents& dir) {
+  if (dirWriteBack_) {
+    updateDirtyDir(inodeNumber, dir);
+    return;
+  }
   backingOverlay_->saveOverlayDir(
       inodeNumber, serializeOverlayDir(inodeNumber, dir));
 }
 
+const overlay::OverlayDir* Overlay::DirtyDirs::find(
+    InodeNumber inodeNumber) const {
+  auto iter = dirty.find(inodeNumber);
+  if (iter != dirty.end()) {
+    return &iter->second;
+  }
+  if (writing && !removed.count(inodeNumber)) {
+    auto writingIter = writing->find(inodeNumber);
+    if (writingIter != writing->end()) {
+      return &writingIter->second;
+    }
+  }
+  return nullptr;
+}
+
+void Overlay::updateDirtyDir(
+    InodeNumber inodeNumber,
+    const DirContents& dir,
+    std::optional<PathComponentPiece> childName,
+    const overlay::OverlayEntry* childEntry) {
+  bool wasClean;
+  {
+    auto dirtyDirs = dirtyDirs_.wlock();
+    wasClean = dirtyDirs->dirty.empty();
+    // The journal is written first, so that a directory that couldn't be
+    // journaled is left untouched.
+    auto iter = dirtyDirs->dirty.find(inodeNumber);
+    if (!childName || iter == dirtyDirs->dirty.end()) {
+      // Replaying the journal mustn't depend on what made it to the backing
+      // overlay, so the first change of a directory records all of it.
+      auto dirData = serializeOverlayDir(inodeNumber, dir);
+      appendToDirJournal(
+          *dirtyDirs,
+          kDirJournalSave,
+          inodeNumber,
+          "",
+          CompactSerializer::serialize<std::string>(dirData));
+      dirtyDirs->dirty.insert_or_assign(inodeNumber, std::move(dirData));
+    } else if (childEntry) {
+      appendToDirJournal(
+          *dirtyDirs,
+          kDirJournalSetChild,
+          inodeNumber,
+          childName->stringPiece(),
+          CompactSerializer::serialize<std::string>(*childEntry));
+      iter->second.entries_ref()->insert_or_assign(
+          childName->stringPiece().str(), *childEntry);
+    } else {
+      appendToDirJournal(
+          *dirtyDirs,
+          kDirJournalRemoveChild,
+          inodeNumber,
+          childName->stringPiece(),
+          "");
+      iter->second.entries_ref()->erase(childName->stringPiece().str());
+    }
+  }
+  // The GC thread writes all the dirty directories, so it only needs to be
+  // woken up for the first one.
+  if (wasClean) {
+    gcQueue_.lock()->queue.emplace_back(GCRequest::WriteDirtyDirs{});
+    gcCondVar_.notify_one();
+  }
+}
+
+void Overlay::forgetDirtyDir(DirtyDirs& dirtyDirs, InodeNumber inodeNumber) {
+  if (!dirtyDirs.journalEmpty) {
+    appendToDirJournal(dirtyDirs, kDirJournalDrop, inodeNumber, "", "");
+  }
+  dirtyDirs.dirty.erase(inodeNumber);
+  if (dirtyDirs.writing && dirtyDirs.writing->count(inodeNumber)) {
+    dirtyDirs.removed.insert(inodeNumber);
+  }
+}
+
+bool Overlay::writeDirtyDirs() {
+  std::shared_ptr<const DirtyDirs::DirMap> writing;
+  {
+    auto dirtyDirs = dirtyDirs_.wlock();
+    if (dirtyDirs->dirty.empty()) {
+      return true;
+    }
+    writing = std::make_shared<const DirtyDirs::DirMap>(
+        std::exchange(dirtyDirs->dirty, {}));
+    dirtyDirs->writing = writing;
+  }
+
+  // Loads keep finding the directories in writing while they are written
+  // without the lock.
+  std::unordered_set<InodeNumber> failed;
+  for (const auto& [inodeNumber, dirData] : *writing) {
+    try {
+      backingOverlay_->saveOverlayDir(inodeNumber, dirData);
+    } catch (const std::exception& e) {
+      XLOG(ERR) << "Failed to write overlay data for directory inode "
+                << inodeNumber << ": " << e.what();
+      failed.insert(inodeNumber);
+    }
+  }
+
+  auto dirtyDirs = dirtyDirs_.wlock();
+  dirtyDirs->writing.reset();
+  for (auto inodeNumber : dirtyDirs->removed) {
+    if (failed.erase(inodeNumber)) {
+      continue;
+    }
+    // The directory was removed from the backing overlay before it was
+    // written there.
+    try {
+      backingOverlay_->removeOverlayData(inodeNumber);
+    } catch (const std::exception& e) {
+      XLOG(ERR) << "Failed to remove overlay data for directory inode "
+                << inodeNumber << ": " << e.what();
+    }
+  }
+  dirtyDirs->removed.clear();
+  // A directory changed since it was taken out is more recent, and the
+  // journal still has the change that failed.
+  for (auto inodeNumber : failed) {
+    dirtyDirs->dirty.emplace(inodeNumber, writing->at(inodeNumber));
+  }
+
+  if (dirtyDirs->dirty.empty() && !dirtyDirs->journalEmpty) {
+    if (folly::ftruncateNoInt(dirtyDirs->journal.fd(), 0) == 0) {
+      dirtyDirs->journalEmpty = true;
+    } else {
+      XLOG(ERR) << "Failed to truncate " << getDirJournalPath() << ": "
+                << folly::errnoStr(errno);
+    }
+  }
+  return failed.empty();
+}
+
+AbsolutePath Overlay::getDirJournalPath() const {
+  return backingOverlay_->getLocalDir() + PathComponentPiece{kDirJournalFile};
+}
+
+void Overlay::appendToDirJournal(
+    DirtyDirs& dirtyDirs,
+    uint8_t op,
+    InodeNumber inodeNumber,
+    folly::StringPiece name,
+    folly::StringPiece payload) {
+  if (!dirtyDirs.journal) {
+    dirtyDirs.journal = folly::File{
+        getDirJournalPath().c_str(),
+        O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+        0600};
+  }
+
+  std::string record;
+  auto appendInt = [&record](auto value) {
+    value = folly::Endian::little(value);
+    record.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  };
+  appendInt(static_cast<uint32_t>(
+      kDirJournalHeaderLength + name.size() + payload.size()));
+  appendInt(op);
+  appendInt(inodeNumber.get());
+  appendInt(static_cast<uint32_t>(name.size()));
+  record.append(name.data(), name.size());
+  record.append(payload.data(), payload.size());
+
+  // Like the backing overlays, this only protects against the process dying,
+  // so it doesn't fsync.
+  auto written =
+      folly::writeFull(dirtyDirs.journal.fd(), record.data(), record.size());
+  if (written != static_cast<ssize_t>(record.size())) {
+    folly::throwSystemError("Failed to append to ", getDirJournalPath());
+  }
+  dirtyDirs.journalEmpty = false;
+}
+
+void Overlay::replayDirJournal() {
+  auto path = getDirJournalPath();
+  std::string contents;
+  if (!folly::readFile(path.c_str(), contents)) {
+    if (errno != ENOENT) {
+      folly::throwSystemError("Failed to read ", path);
+    }
+    return;
+  }
+
+  std::unordered_map<InodeNumber, overlay::OverlayDir> dirs;
+  std::unordered_set<InodeNumber> dropped;
+  auto buf = folly::IOBuf::wrapBufferAsValue(contents.data(), contents.size());
+  folly::io::Cursor cursor{&buf};
+  size_t records = 0;
+  try {
+    // A record cut short by a crash was never acknowledged, so it is the end
+    // of the journal.
+    while (cursor.canAdvance(sizeof(uint32_t))) {
+      auto length = cursor.readLE<uint32_t>();
+      if (length < kDirJournalHeaderLength || !cursor.canAdvance(length)) {
+        break;
+      }
+      auto op = cursor.readLE<uint8_t>();
+      auto inodeNumber = InodeNumber{cursor.readLE<uint64_t>()};
+      auto nameLength = cursor.readLE<uint32_t>();
+      if (nameLength > length - kDirJournalHeaderLength) {
+        break;
+      }
+      auto name = cursor.readFixedString(nameLength);
+      auto payload =
+          cursor.readFixedString(length - kDirJournalHeaderLength - nameLength);
+      ++records;
+
+      if (op == kDirJournalSave) {
+        dropped.erase(inodeNumber);
+        dirs.insert_or_assign(
+            inodeNumber,
+            CompactSerializer::deserialize<overlay::OverlayDir>(payload));
+        continue;
+      }
+      if (op == kDirJournalDrop) {
+        dirs.erase(inodeNumber);
+        dropped.insert(inodeNumber);
+        continue;
+      }
+      if (dropped.count(inodeNumber)) {
+        continue;
+      }
+      auto iter = dirs.find(inodeNumber);
+      if (iter == dirs.end()) {
+        auto dirData = backingOverlay_->loadOverlayDir(inodeNumber);
+        if (!dirData) {
+          XLOG(WARN) << "Journaled directory inode " << inodeNumber
+                     << " is missing from the overlay";
+          continue;
+        }
+        iter = dirs.emplace(inodeNumber, std::move(*dirData)).first;
+      }
+      if (op == kDirJournalSetChild) {
+        iter->second.entries_ref()->insert_or_assign(
+            name,
+            CompactSerializer::deserialize<overlay::OverlayEntry>(payload));
+      } else {
+        iter->second.entries_ref()->erase(name);
+      }
+    }
+  } catch (const std::exception& e) {
+    XLOG(WARN) << "Ignoring the rest of corrupt " << path << ": " << e.what();
+  }
+
+  XLOG(INFO) << "Replaying " << records << " changes to " << dirs.size()
+             << " directories from " << path;
+  // Any failure leaves the journal for the next attempt.
+  for (const auto& [inodeNumber, dirData] : dirs) {
+    backingOverlay_->saveOverlayDir(inodeNumber, dirData);
+  }
+  folly::checkUnixError(unlink(path.c_str()), "Failed to remove ", path);
+}
+
+std::optional<overlay::OverlayDir> Overlay::loadAndRemoveDir(
+    InodeNumber inodeNumber) {
+  std::optional<overlay::OverlayDir> dirtyDir;
+  if (dirWriteBack_) {
+    auto dirtyDirs = dirtyDirs_.wlock();
+    if (auto dirData = dirtyDirs->find(inodeNumber)) {
+      dirtyDir = *dirData;
+    }
+    forgetDirtyDir(*dirtyDirs, inodeNumber);
+  }
+  auto dirData = backingOverlay_->loadAndRemoveOverlayDir(inodeNumber);
+  return dirtyDir ? std::move(dirtyDir) : std::move(dirData);
+}
+
 void Overlay::freeInodeFromMetadataTable(InodeNumber ino) {
 #ifndef _WIN32
   // TODO: batch request during GC
@@ -369,6 +723,9 @@ void Overlay::removeOverlayData(InodeNumber inodeNumber) {
   IORequest req{this};
 
   freeInodeFromMetadataTable(inodeNumber);
+  if (dirWriteBack_) {
+    forgetDirtyDir(*dirtyDirs_.wlock(), inodeNumber);
+  }
   backingOverlay_->removeOverlayData(inodeNumber);
 }
 
@@ -381,7 +738,7 @@ void Overlay::recursivelyRemoveOverlayData(InodeNumber inodeNumber) {
   // saveOverlayDir(I).  There's also no risk of violating our durability
   // guarantees if the process dies after this call but before the thread could
   // remove this data.
-  auto dirData = backingOverlay_->loadAndRemoveOverlayDir(inodeNumber);
+  auto dirData = loadAndRemoveDir(inodeNumber);
   if (dirData) {
     gcQueue_.lock()->queue.emplace_back(std::move(*dirData));
     gcCondVar_.notify_one();
@@ -400,6 +757,9 @@ folly::Future<folly::Unit> Overlay::flushPendingAsync() {
 
 bool Overlay::hasOverlayData(InodeNumber inodeNumber) {
   IORequest req{this};
+  if (dirWriteBack_ && dirtyDirs_.rlock()->find(inodeNumber)) {
+    return true;
+  }
   return backingOverlay_->hasOverlayData(inodeNumber);
 }
 
@@ -442,6 +802,23 @@ OverlayFile Overlay::createOverlayFile(
       weak_from_this());
 }
 
+OverlayFile Overlay::createOverlayFile(
+    InodeNumber inodeNumber,
+    const Hash20& contentsSha1,
+    const folly::IOBuf& contents) {
+  if (pooledFileMinSize_ == 0 ||
+      contents.computeChainDataLength() < pooledFileMinSize_) {
+    return createOverlayFile(inodeNumber, contents);
+  }
+  IORequest req{this};
+  XCHECK_LT(inodeNumber.get(), nextInodeNumber_.load(std::memory_order_relaxed))
+      << "createOverlayFile called with unallocated inode number";
+  return OverlayFile(
+      backingOverlay_->createPooledOverlayFile(
+          inodeNumber, contentsSha1, contents),
+      weak_from_this());
+}
+
 #endif // !_WIN32
 
 InodeNumber Overlay::getMaxInodeNumber() {
@@ -505,6 +882,14 @@ void Overlay::gcThread() noexcept {
         if (lock->stop) {
           return;
         }
+        if (lock->retryDirtyDirs) {
+          gcCondVar_.wait_for(lock.as_lock(), kDirtyDirRetryInterval);
+          if (lock->queue.empty() && !lock->stop) {
+            lock->retryDirtyDirs = false;
+            lock->queue.emplace_back(GCRequest::WriteDirtyDirs{});
+          }
+          continue;
+        }
         gcCondVar_.wait(lock.as_lock());
         continue;
       }
@@ -530,6 +915,13 @@ void Overlay::handleGCRequest(GCRequest& request) {
     return;
   }
 
+  if (request.writeDirtyDirs) {
+    if (!writeDirtyDirs()) {
+      gcQueue_.lock()->retryDirtyDirs = true;
+    }
+    return;
+  }
+
   // Should only include inode numbers for trees.
   std::queue<InodeNumber> queue;
 
@@ -576,7 +968,7 @@ void Overlay::handleGCRequest(GCRequest& request) {
     overlay::OverlayDir dir;
     try {
       freeInodeFromMetadataTable(ino);
-      auto dirData = backingOverlay_->loadAndRemoveOverlayDir(ino);
+      auto dirData = loadAndRemoveDir(ino);
       if (!dirData.has_value()) {
         XLOG(DBG7) << "no dir data for inode " << ino;
         continue;
@@ -600,6 +992,9 @@ void Overlay::addChild(
   if (supportsSemanticOperations_) {
     backingOverlay_->addChild(
         parent, childEntry.first, serializeOverlayEntry(childEntry.second));
+  } else if (dirWriteBack_) {
+    auto entry = serializeOverlayEntry(childEntry.second);
+    updateDirtyDir(parent, content, childEntry.first, &entry);
   } else {
     saveOverlayDir(parent, content);
   }
@@ -611,6 +1006,8 @@ void Overlay::removeChild(
     const DirContents& content) {
   if (supportsSemanticOperations_) {
     backingOverlay_->removeChild(parent, childName);
+  } else if (dirWriteBack_) {
+    updateDirtyDir(parent, content, childName);
   } else {
     saveOverlayDir(parent, content);
   }
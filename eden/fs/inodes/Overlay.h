@@ -8,18 +8,24 @@
 #pragma once
 #include <folly/File.h>
 #include <folly/Range.h>
+#include <folly/Synchronized.h>
 #include <folly/futures/Future.h>
 #include <folly/futures/Promise.h>
 #include <folly/synchronization/Baton.h>
 #include <array>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <functional>
 #include <optional>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/overlay/OverlayChecker.h"
 #include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
 #include "eden/fs/inodes/sqliteoverlay/SqliteOverlay.h"
+#include "eden/fs/model/Hash.h"
 #include "eden/fs/telemetry/StructuredLogger.h"
 #include "eden/fs/utils/CaseSensitivity.h"
 #include "eden/fs/utils/DirType.h"
@@ -75,6 +81,7 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
     Tree = 1,
     TreeInMemory = 2,
     TreeSynchronousOff = 3,
+    TreeInMemorySnapshot = 4,
   };
 
   /**
@@ -159,11 +166,15 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
    *   TreeInode::create() or TreeInode::mkdir().  In this case
    *   inodeCreated() should be called immediately afterwards to register the
    *   new child Inode object.
-   *
-   * TODO: It would be easy to extend this function to allocate a range of
-   * inode values in one atomic operation.
    */
   InodeNumber allocateInodeNumber();
+
+  /**
+   * Allocate count consecutive inode numbers in one atomic operation, and
+   * return the first of them. Used by TreeInode to number all the entries
+   * of a directory loaded from a Tree at once.
+   */
+  InodeNumber allocateInodeNumbers(size_t count);
 #ifndef _WIN32
 
   /**
@@ -176,6 +187,81 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
   }
 #endif // !_WIN32
 
+  /**
+   * Returns the ID a source control object ID loaded from the overlay should
+   * be replaced with, or std::nullopt to keep it.
+   */
+  using ObjectIdMigrator =
+      std::function<std::optional<ObjectId>(const ObjectId&)>;
+
+  /**
+   * Rewrite the object IDs of the directory entries as they are loaded, for
+   * instance to replace IDs that need a lookup in the LocalStore with
+   * self-contained ones. Directories with rewritten entries are saved back,
+   * so each entry is only migrated once.
+   *
+   * Must be called before initialize().
+   */
+  void setObjectIdMigrator(ObjectIdMigrator migrator) {
+    objectIdMigrator_ = std::move(migrator);
+  }
+
+  /**
+   * Keep the directories saved through saveOverlayDir(), addChild(),
+   * removeChild() and renameChild() in memory and write them to the backing
+   * overlay from the GC thread, so that a directory modified many times in a
+   * row, e.g. by an untar, is only written once. Only used by backing
+   * overlays that don't support semantic operations, which rewrite the whole
+   * directory on every change.
+   *
+   * Every change is first appended to a journal in the overlay directory,
+   * which initialize() replays if the process died before the directories
+   * were written.
+   *
+   * Must be called before initialize().
+   */
+  void setDirWriteBack(bool enabled) {
+    dirWriteBack_ = enabled;
+  }
+
+  /**
+   * Let the backing overlay commit changes in groups, see
+   * IOverlay::setGroupCommit().
+   *
+   * Must be called before initialize().
+   */
+  void setGroupCommit(size_t maxOperations, std::chrono::nanoseconds window);
+
+  /**
+   * See IOverlay::setSnapshotInterval(). Must be called before initialize().
+   */
+  void setSnapshotInterval(std::chrono::nanoseconds interval);
+
+  /**
+   * Write a snapshot of an in-memory backing overlay to disk, see
+   * IOverlay::checkpoint().
+   */
+  void checkpoint();
+
+  /**
+   * Write files of at least minSize bytes through
+   * IOverlay::createPooledOverlayFile() when their SHA-1 is known. 0, the
+   * default, never does.
+   */
+  void setPooledFileMinSize(size_t minSize) {
+    pooledFileMinSize_ = minSize;
+  }
+
+  /**
+   * Hint that the inode metadata table should be mapped with huge pages, see
+   * MappedDiskVector::adviseHugePages().
+   *
+   * Must be called before initialize().
+   */
+  void setHugePages(bool enabled) {
+    hugePages_ = enabled;
+  }
+
   void saveOverlayDir(InodeNumber inodeNumber, const DirContents& dir);
 
   /*
@@ -196,7 +282,8 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
 
   /**
    * Returns a future that completes once all previously-issued async
-   * operations, namely recursivelyRemoveOverlayData, finish.
+   * operations, namely recursivelyRemoveOverlayData and the writes of the
+   * directories kept in memory by setDirWriteBack(), finish.
    */
   folly::Future<folly::Unit> flushPendingAsync();
 
@@ -229,6 +316,15 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
       InodeNumber inodeNumber,
       const folly::IOBuf& contents);
 
+  /**
+   * Like createOverlayFile(), but may share storage with other files of the
+   * same contents, see setPooledFileMinSize().
+   */
+  OverlayFile createOverlayFile(
+      InodeNumber inodeNumber,
+      const Hash20& contentsSha1,
+      const folly::IOBuf& contents);
+
   /**
    * call statfs(2) on the filesystem in which the overlay is located
    */
@@ -272,26 +368,106 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
    * durability goals.
    */
   struct GCRequest {
+    struct WriteDirtyDirs {};
+
     GCRequest() {}
     explicit GCRequest(overlay::OverlayDir&& d) : dir{std::move(d)} {}
     explicit GCRequest(folly::Promise<folly::Unit> p) : flush{std::move(p)} {}
+    explicit GCRequest(WriteDirtyDirs) : writeDirtyDirs{true} {}
 
     overlay::OverlayDir dir;
     // Iff set, this is a flush request.
     std::optional<folly::Promise<folly::Unit>> flush;
+    // Iff true, write the dirty directories to the backing overlay.
+    bool writeDirtyDirs{false};
   };
 
   struct GCQueue {
     bool stop = false;
+    // Iff true, some dirty directories couldn't be written and the GC thread
+    // tries again once it has been idle for a while.
+    bool retryDirtyDirs = false;
     std::vector<GCRequest> queue;
   };
 
+  /**
+   * The directories kept in memory by setDirWriteBack(), and the journal of
+   * their changes.
+   */
+  struct DirtyDirs {
+    using DirMap = std::unordered_map<InodeNumber, overlay::OverlayDir>;
+
+    /**
+     * The most recent copy of the directory if it isn't in the backing
+     * overlay yet, or nullptr.
+     */
+    const overlay::OverlayDir* find(InodeNumber inodeNumber) const;
+
+    // Modified since the GC thread last started writing.
+    DirMap dirty;
+    // Being written by the GC thread, which reads them without the lock, so
+    // they are never modified.
+    std::shared_ptr<const DirMap> writing;
+    // Removed while they were being written, so that the GC thread removes
+    // them again afterwards.
+    std::unordered_set<InodeNumber> removed;
+
+    // Opened on the first change and truncated whenever all the directories
+    // are written.
+    folly::File journal;
+    bool journalEmpty{true};
+  };
+
   void initOverlay(
       std::optional<AbsolutePath> mountPath,
       const OverlayChecker::ProgressCallback& progressCallback = [](auto) {});
   void gcThread() noexcept;
   void handleGCRequest(GCRequest& request);
 
+  /**
+   * Journal a change to a directory and apply it to its in-memory copy.
+   * Without a childName, the whole directory is replaced by dir. Otherwise
+   * the child is set to childEntry, or removed if childEntry is nullptr.
+   * dir must already include the change.
+   */
+  void updateDirtyDir(
+      InodeNumber inodeNumber,
+      const DirContents& dir,
+      std::optional<PathComponentPiece> childName = std::nullopt,
+      const overlay::OverlayEntry* childEntry = nullptr);
+
+  /**
+   * Forget the in-memory copy of a removed directory, if any.
+   */
+  void forgetDirtyDir(DirtyDirs& dirtyDirs, InodeNumber inodeNumber);
+
+  /**
+   * Write the dirty directories to the backing overlay. The ones that
+   * couldn't be written stay dirty, in which case false is returned.
+   */
+  bool writeDirtyDirs();
+
+  AbsolutePath getDirJournalPath() const;
+
+  void appendToDirJournal(
+      DirtyDirs& dirtyDirs,
+      uint8_t op,
+      InodeNumber inodeNumber,
+      folly::StringPiece name,
+      folly::StringPiece payload);
+
+  /**
+   * Write the directories of the journal left behind by a crash to the
+   * backing overlay, and remove the journal.
+   */
+  void replayDirJournal();
+
+  /**
+   * Forget the dirty copy of the directory, if any, and remove it from the
+   * backing overlay, returning the most recent of the two.
+   */
+  std::optional<overlay::OverlayDir> loadAndRemoveDir(InodeNumber inodeNumber);
+
   // Serialize EdenFS overlay data structure into Thrift data structure
   overlay::OverlayEntry serializeOverlayEntry(const DirEntry& entry);
 
@@ -362,6 +538,18 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
 
   std::shared_ptr<StructuredLogger> structuredLogger_;
 
+  ObjectIdMigrator objectIdMigrator_;
+
+  bool dirWriteBack_{false};
+  size_t pooledFileMinSize_{0};
+  bool hugePages_{false};
+
+  /**
+   * The directories that were saved but not written to the backing overlay
+   * yet, see setDirWriteBack().
+   */
+  folly::Synchronized<DirtyDirs> dirtyDirs_;
+
   friend class IORequest;
 };
 
@@ -9,7 +9,11 @@
 
 #include "eden/fs/inodes/OverlayFile.h"
 
+#include <fcntl.h>
 #include <folly/FileUtil.h>
+#ifdef __linux__
+#include <sys/xattr.h>
+#endif
 
 #include "eden/fs/inodes/Overlay.h"
 
@@ -70,13 +74,49 @@ OverlayFile::pwritev(const iovec* iov, int iovcnt, off_t offset) const {
   }
   IORequest req{overlay.get()};
 
-  auto ret = folly::pwritevNoInt(file_.fd(), iov, iovcnt, offset);
+  // pwritevFull splits vectors longer than IOV_MAX, as a write coming from
+  // an NFS socket may be, and resumes after short writes.
+  auto ret = folly::pwritevFull(file_.fd(), iov, iovcnt, offset);
   if (ret == -1) {
     return folly::makeUnexpected(errno);
   }
   return ret;
 }
 
+folly::Expected<ssize_t, int>
+OverlayFile::spliceFrom(int pipeFd, size_t n, off_t offset) const {
+#ifdef __linux__
+  std::shared_ptr<Overlay> overlay = overlay_.lock();
+  if (!overlay) {
+    return folly::makeUnexpected(EIO);
+  }
+  IORequest req{overlay.get()};
+
+  size_t total = 0;
+  while (total < n) {
+    loff_t position = offset + total;
+    auto ret = ::splice(
+        pipeFd, nullptr, file_.fd(), &position, n - total, SPLICE_F_MOVE);
+    if (ret == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return folly::makeUnexpected(errno);
+    }
+    if (ret == 0) {
+      break;
+    }
+    total += ret;
+  }
+  return static_cast<ssize_t>(total);
+#else
+  (void)pipeFd;
+  (void)n;
+  (void)offset;
+  return folly::makeUnexpected(ENOSYS);
+#endif
+}
+
 folly::Expected<int, int> OverlayFile::ftruncate(off_t length) const {
   std::shared_ptr<Overlay> overlay = overlay_.lock();
   if (!overlay) {
@@ -146,6 +186,69 @@ folly::Expected<int, int> OverlayFile::fdatasync() const {
 #endif
 }
 
+folly::Expected<ssize_t, int>
+OverlayFile::fgetxattr(const char* name, void* value, size_t size) const {
+#ifdef __linux__
+  std::shared_ptr<Overlay> overlay = overlay_.lock();
+  if (!overlay) {
+    return folly::makeUnexpected(EIO);
+  }
+  IORequest req{overlay.get()};
+
+  auto ret = ::fgetxattr(file_.fd(), name, value, size);
+  if (ret == -1) {
+    return folly::makeUnexpected(errno);
+  }
+  return ret;
+#else
+  (void)name;
+  (void)value;
+  (void)size;
+  return folly::makeUnexpected(ENOSYS);
+#endif
+}
+
+folly::Expected<int, int>
+OverlayFile::fsetxattr(const char* name, const void* value, size_t size) const {
+#ifdef __linux__
+  std::shared_ptr<Overlay> overlay = overlay_.lock();
+  if (!overlay) {
+    return folly::makeUnexpected(EIO);
+  }
+  IORequest req{overlay.get()};
+
+  auto ret = ::fsetxattr(file_.fd(), name, value, size, 0);
+  if (ret == -1) {
+    return folly::makeUnexpected(errno);
+  }
+  return folly::makeExpected<int>(ret);
+#else
+  (void)name;
+  (void)value;
+  (void)size;
+  return folly::makeUnexpected(ENOSYS);
+#endif
+}
+
+folly::Expected<int, int> OverlayFile::fremovexattr(const char* name) const {
+#ifdef __linux__
+  std::shared_ptr<Overlay> overlay = overlay_.lock();
+  if (!overlay) {
+    return folly::makeUnexpected(EIO);
+  }
+  IORequest req{overlay.get()};
+
+  auto ret = ::fremovexattr(file_.fd(), name);
+  if (ret == -1) {
+    return folly::makeUnexpected(errno);
+  }
+  return folly::makeExpected<int>(ret);
+#else
+  (void)name;
+  return folly::makeUnexpected(ENOSYS);
+#endif
+}
+
 folly::Expected<std::string, int> OverlayFile::readFile() const {
   std::shared_ptr<Overlay> overlay = overlay_.lock();
   if (!overlay) {
@@ -32,13 +32,31 @@ class OverlayFile {
   folly::Expected<ssize_t, int> preadNoInt(void* buf, size_t n, off_t offset)
       const;
   folly::Expected<off_t, int> lseek(off_t offset, int whence) const;
+  /**
+   * Write all the buffers of iov at offset, however many of them there are.
+   */
   folly::Expected<ssize_t, int>
   pwritev(const iovec* iov, int iovcnt, off_t offset) const;
+  /**
+   * Move up to n bytes from the pipe pipeFd into the file at offset with
+   * splice(2), stopping early if the pipe runs empty. Linux only.
+   */
+  folly::Expected<ssize_t, int> spliceFrom(int pipeFd, size_t n, off_t offset)
+      const;
   folly::Expected<int, int> ftruncate(off_t length) const;
   folly::Expected<int, int> fsync() const;
   folly::Expected<int, int> fallocate(off_t offset, off_t length) const;
   folly::Expected<int, int> fdatasync() const;
   folly::Expected<std::string, int> readFile() const;
+  /**
+   * Read, write or remove an extended attribute of the overlay file itself,
+   * for metadata that should stay with the file across restarts. Linux only.
+   */
+  folly::Expected<ssize_t, int>
+  fgetxattr(const char* name, void* value, size_t size) const;
+  folly::Expected<int, int>
+  fsetxattr(const char* name, const void* value, size_t size) const;
+  folly::Expected<int, int> fremovexattr(const char* name) const;
 
  private:
   OverlayFile(const OverlayFile&) = delete;
@@ -11,9 +11,12 @@
 
 #include <folly/Expected.h>
 #include <folly/Range.h>
+#include <folly/String.h>
 #include <folly/logging/xlog.h>
 #include <gflags/gflags.h>
 #include <openssl/sha.h>
+#include <sys/resource.h>
+#include <algorithm>
 
 #include "eden/fs/inodes/FileInode.h"
 #include "eden/fs/inodes/InodeError.h"
@@ -23,6 +26,8 @@
 #include "eden/fs/inodes/TreeInode.h"
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/utils/Bug.h"
+#include "eden/fs/utils/FileHash.h"
+#include "eden/fs/utils/StatTimes.h"
 #include "folly/FileUtil.h"
 
 namespace facebook {
@@ -35,27 +40,77 @@ namespace eden {
  */
 
 DEFINE_uint64(overlayFileCacheSize, 100, "");
+DEFINE_uint64(
+    overlayFileCacheNofileDivisor,
+    0,
+    "If non-zero, keep up to the open file limit divided by this many overlay "
+    "files open per mount, when that is more than overlayFileCacheSize");
+
+namespace {
+size_t getOverlayFileCacheSize() {
+  size_t cacheSize = FLAGS_overlayFileCacheSize;
+  if (cacheSize == 0) {
+    throw std::range_error{"overlayFileCacheSize must be at least 1"};
+  }
+  if (FLAGS_overlayFileCacheNofileDivisor != 0) {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 &&
+        limit.rlim_cur != RLIM_INFINITY) {
+      cacheSize = std::max<size_t>(
+          cacheSize, limit.rlim_cur / FLAGS_overlayFileCacheNofileDivisor);
+    }
+  }
+  return cacheSize;
+}
 
-void OverlayFileAccess::Entry::Info::invalidateMetadata() {
+/**
+ * The SHA-1 of a materialized file, persisted in an extended attribute of its
+ * overlay file. It is only trusted while the file still has the size and
+ * modification time it had when it was hashed, which any write to the file
+ * changes, including writes by versions of EdenFS that don't know about it.
+ */
+struct PersistedSha1 {
+  uint32_t formatVersion;
+  uint32_t reserved;
+  uint64_t size;
+  int64_t mtimeSec;
+  int64_t mtimeNsec;
+  uint8_t sha1[Hash20::RAW_SIZE];
+};
+
+constexpr uint32_t kPersistedSha1Version = 1;
+constexpr const char* kPersistedSha1Xattr = "user.eden.sha1";
+
+bool isXattrUnsupported(int error) {
+  return error == ENOTSUP || error == EOPNOTSUPP || error == ENOSYS;
+}
+} // namespace
+
+void OverlayFileAccess::Entry::Info::invalidateMetadata(uint64_t offset) {
   ++version;
   size = std::nullopt;
   sha1 = std::nullopt;
+  if (offset < sha1PrefixLength) {
+    sha1Prefix = std::nullopt;
+    sha1PrefixLength = 0;
+  }
 }
 
-OverlayFileAccess::State::State(size_t cacheSize) : entries{cacheSize} {
-  if (cacheSize == 0) {
-    throw std::range_error{"overlayFileCacheSize must be at least 1"};
+OverlayFileAccess::OverlayFileAccess(Overlay* overlay) : overlay_{overlay} {
+  auto cacheSize = getOverlayFileCacheSize();
+  shardCount_ = std::min(cacheSize, kMaxShards);
+  // Round up, so that the shards together hold at least cacheSize files.
+  auto shardSize = (cacheSize + shardCount_ - 1) / shardCount_;
+  for (size_t i = 0; i < shardCount_; ++i) {
+    shards_[i].wlock()->entries.setMaxSize(shardSize);
   }
 }
 
-OverlayFileAccess::OverlayFileAccess(Overlay* overlay)
-    : overlay_{overlay}, state_{folly::in_place, FLAGS_overlayFileCacheSize} {}
-
 OverlayFileAccess::~OverlayFileAccess() = default;
 
 void OverlayFileAccess::createEmptyFile(InodeNumber ino) {
   auto file = overlay_->createOverlayFile(ino, folly::ByteRange{});
-  auto state = state_.wlock();
+  auto state = getShard(ino).wlock();
   XCHECK(!state->entries.exists(ino))
       << "Cannot create overlay file " << ino << " when it's already open!";
   state->entries.set(
@@ -66,8 +121,10 @@ void OverlayFileAccess::createFile(
     InodeNumber ino,
     const Blob& blob,
     const std::optional<Hash20>& sha1) {
-  auto file = overlay_->createOverlayFile(ino, blob.getContents());
-  auto state = state_.wlock();
+  auto file = sha1
+      ? overlay_->createOverlayFile(ino, *sha1, blob.getContents())
+      : overlay_->createOverlayFile(ino, blob.getContents());
+  auto state = getShard(ino).wlock();
   XCHECK(!state->entries.exists(ino))
       << "Cannot create overlay file " << ino << " when it's already open!";
   state->entries.set(
@@ -124,29 +181,57 @@ off_t OverlayFileAccess::getFileSize(InodeNumber ino, InodeBase* inode) {
 Hash20 OverlayFileAccess::getSha1(FileInode& inode) {
   auto entry = getEntryForInode(inode.getNodeId());
   uint64_t version;
+  std::optional<SHA_CTX> prefix;
+  uint64_t prefixLength;
   {
     auto info = entry->info.rlock();
     if (info->sha1.has_value()) {
       return *info->sha1;
     }
     version = info->version;
+    prefix = info->sha1Prefix;
+    prefixLength = info->sha1PrefixLength;
   }
 
-  // SHA-1 is not known, so recompute it. Do so while the lock is not held to
-  // improve concurrency.
+  // Stat the file before reading it, so that a write racing with the hashing
+  // below makes the persisted hash invalid.
+  auto st = entry->file.fstat();
+  if (st.hasError()) {
+    throw InodeError(
+        st.error(), inode.inodePtrFromThis(), "unable to fstat overlay file");
+  }
+  if (!prefix.has_value()) {
+    if (auto persisted = loadPersistedSha1(*entry, st.value())) {
+      auto info = entry->info.wlock();
+      if (version == info->version) {
+        info->sha1 = *persisted;
+        info->sha1Persisted = true;
+      }
+      return *persisted;
+    }
+  }
 
-  SHA_CTX ctx;
-  SHA1_Init(&ctx);
+  // SHA-1 is not known, so recompute it, or hash what was appended since it
+  // was last computed. Do so while the lock is not held to improve
+  // concurrency.
 
+  SHA_CTX ctx;
   off_t off = FsOverlay::kHeaderLength;
+  if (prefix.has_value()) {
+    ctx = *prefix;
+    off += prefixLength;
+  } else {
+    SHA1_Init(&ctx);
+  }
+
+  auto buf = std::make_unique<uint8_t[]>(kFileSha1ReadSize);
   while (true) {
     // Using pread here so that we don't move the file position;
     // the file descriptor is shared between multiple file handles
     // and while we serialize the requests to FileData, it seems
     // like a good property of this function to avoid changing that
     // state.
-    uint8_t buf[8192];
-    auto ret = entry->file.preadNoInt(&buf, sizeof(buf), off);
+    auto ret = entry->file.preadNoInt(buf.get(), kFileSha1ReadSize, off);
     if (ret.hasError()) {
       throw InodeError(
           ret.error(),
@@ -157,10 +242,12 @@ Hash20 OverlayFileAccess::getSha1(FileInode& inode) {
     if (len == 0) {
       break;
     }
-    SHA1_Update(&ctx, buf, len);
+    SHA1_Update(&ctx, buf.get(), len);
     off += len;
   }
 
+  uint64_t hashedLength = off - FsOverlay::kHeaderLength;
+  auto hashedCtx = ctx;
   static_assert(Hash20::RAW_SIZE == SHA_DIGEST_LENGTH);
   Hash20 sha1;
   SHA1_Final(sha1.mutableBytes().begin(), &ctx);
@@ -169,6 +256,11 @@ Hash20 OverlayFileAccess::getSha1(FileInode& inode) {
   auto info = entry->info.wlock();
   if (version == info->version) {
     info->sha1 = sha1;
+    info->sha1Prefix = hashedCtx;
+    info->sha1PrefixLength = hashedLength;
+    if (!info->sha1Persisted) {
+      info->sha1Persisted = persistSha1(*entry, st.value(), hashedLength, sha1);
+    }
   }
   return sha1;
 }
@@ -229,6 +321,9 @@ size_t OverlayFileAccess::write(
     size_t iovcnt,
     off_t off) {
   auto entry = getEntryForInode(inode.getNodeId());
+  // Also before the write, so that a persisted SHA-1 doesn't survive a crash
+  // in the middle of it.
+  invalidateMetadata(*entry, off);
 
   auto xfer = entry->file.pwritev(iov, iovcnt, off + FsOverlay::kHeaderLength);
   if (xfer.hasError()) {
@@ -237,14 +332,35 @@ size_t OverlayFileAccess::write(
         inode.inodePtrFromThis(),
         "pwritev failed during file write");
   }
-  auto info = entry->info.wlock();
-  info->invalidateMetadata();
+  invalidateMetadata(*entry, off);
+
+  return xfer.value();
+}
+
+size_t OverlayFileAccess::spliceWrite(
+    FileInode& inode,
+    int pipeFd,
+    size_t size,
+    off_t off) {
+  auto entry = getEntryForInode(inode.getNodeId());
+  invalidateMetadata(*entry, off);
+
+  auto xfer =
+      entry->file.spliceFrom(pipeFd, size, off + FsOverlay::kHeaderLength);
+  if (xfer.hasError()) {
+    throw InodeError(
+        xfer.error(),
+        inode.inodePtrFromThis(),
+        "splice failed during file write");
+  }
+  invalidateMetadata(*entry, off);
 
   return xfer.value();
 }
 
 void OverlayFileAccess::truncate(FileInode& inode, off_t size) {
   auto entry = getEntryForInode(inode.getNodeId());
+  invalidateMetadata(*entry, size);
   auto result = entry->file.ftruncate(size + FsOverlay::kHeaderLength);
   if (result.hasError()) {
     throw InodeError(
@@ -253,8 +369,7 @@ void OverlayFileAccess::truncate(FileInode& inode, off_t size) {
         "unable to ftruncate overlay file");
   }
 
-  auto info = entry->info.wlock();
-  info->invalidateMetadata();
+  invalidateMetadata(*entry, size);
 }
 
 void OverlayFileAccess::fsync(FileInode& inode, bool datasync) {
@@ -288,29 +403,107 @@ void OverlayFileAccess::fallocate(
 
 OverlayFileAccess::EntryPtr OverlayFileAccess::getEntryForInode(
     InodeNumber ino) {
+  auto& shard = getShard(ino);
   {
-    auto state = state_.wlock();
+    auto state = shard.wlock();
     auto iter = state->entries.find(ino);
     if (iter != state->entries.end()) {
       return iter->second;
     }
   }
 
-  // No entry found. Open one while the lock is not held.
-  // TODO: A possible future optimization here is, if a SHA-1 is known when
-  // the blob is evicted, write it into an xattr when the blob is closed. When
-  // reopened, if the xattr exists, read it back out (and clear).
+  // No entry found. Open one while the lock is not held. A persisted SHA-1 is
+  // only read when getSha1 needs it.
   auto entry = std::make_shared<Entry>(
       overlay_->openFileNoVerify(ino), std::nullopt, std::nullopt);
 
   {
-    auto state = state_.wlock();
+    auto state = shard.wlock();
     state->entries.set(ino, entry);
   }
 
   return entry;
 }
 
+void OverlayFileAccess::invalidateMetadata(Entry& entry, uint64_t offset) {
+  auto info = entry.info.wlock();
+  info->invalidateMetadata(offset);
+  if (info->sha1Persisted) {
+    info->sha1Persisted = false;
+    auto result = entry.file.fremovexattr(kPersistedSha1Xattr);
+    if (result.hasError() && result.error() != ENODATA) {
+      // The hash is no longer trusted anyway, since the modification changes
+      // the file's modification time.
+      XLOG(DBG3) << "unable to remove the persisted SHA-1 of an overlay file: "
+                 << folly::errnoStr(result.error());
+    }
+  }
+}
+
+std::optional<Hash20> OverlayFileAccess::loadPersistedSha1(
+    const Entry& entry,
+    const struct stat& st) {
+  if (sha1XattrUnsupported_.load(std::memory_order_relaxed)) {
+    return std::nullopt;
+  }
+
+  PersistedSha1 persisted;
+  auto result = entry.file.fgetxattr(
+      kPersistedSha1Xattr, &persisted, sizeof(persisted));
+  if (result.hasError()) {
+    if (isXattrUnsupported(result.error())) {
+      sha1XattrUnsupported_.store(true, std::memory_order_relaxed);
+    }
+    return std::nullopt;
+  }
+
+  auto mtime = stMtime(st);
+  if (result.value() != sizeof(persisted) ||
+      persisted.formatVersion != kPersistedSha1Version ||
+      persisted.size + FsOverlay::kHeaderLength !=
+          static_cast<uint64_t>(st.st_size) ||
+      persisted.mtimeSec != mtime.tv_sec ||
+      persisted.mtimeNsec != mtime.tv_nsec) {
+    return std::nullopt;
+  }
+  return Hash20{folly::ByteRange{persisted.sha1, sizeof(persisted.sha1)}};
+}
+
+bool OverlayFileAccess::persistSha1(
+    const Entry& entry,
+    const struct stat& st,
+    uint64_t size,
+    const Hash20& sha1) {
+  if (sha1XattrUnsupported_.load(std::memory_order_relaxed) ||
+      size + FsOverlay::kHeaderLength != static_cast<uint64_t>(st.st_size)) {
+    return false;
+  }
+
+  auto mtime = stMtime(st);
+  PersistedSha1 persisted{};
+  persisted.formatVersion = kPersistedSha1Version;
+  persisted.size = size;
+  persisted.mtimeSec = mtime.tv_sec;
+  persisted.mtimeNsec = mtime.tv_nsec;
+  auto bytes = sha1.getBytes();
+  memcpy(persisted.sha1, bytes.data(), bytes.size());
+
+  auto result = entry.file.fsetxattr(
+      kPersistedSha1Xattr, &persisted, sizeof(persisted));
+  if (result.hasError()) {
+    if (isXattrUnsupported(result.error())) {
+      XLOG(INFO) << "the overlay does not support extended attributes, "
+                 << "SHA-1s of materialized files will not be persisted";
+      sha1XattrUnsupported_.store(true, std::memory_order_relaxed);
+    } else {
+      XLOG(DBG3) << "unable to persist the SHA-1 of an overlay file: "
+                 << folly::errnoStr(result.error());
+    }
+    return false;
+  }
+  return true;
+}
+
 } // namespace eden
 } // namespace facebook
 
@@ -10,6 +10,9 @@
 #include <folly/File.h>
 #include <folly/Synchronized.h>
 #include <folly/container/EvictingCacheMap.h>
+#include <openssl/sha.h>
+#include <array>
+#include <atomic>
 #include <memory>
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/InodePtr.h"
@@ -68,6 +71,10 @@ class OverlayFileAccess {
 
   /**
    * Returns the SHA-1 hash of the file contents for the given inode number.
+   *
+   * The hash is persisted in an extended attribute of the overlay file, and
+   * reused after a restart for as long as the file is not modified. After
+   * appends, only the appended data is hashed.
    */
   Hash20 getSha1(FileInode& inode);
 
@@ -89,6 +96,13 @@ class OverlayFileAccess {
   size_t
   write(FileInode& inode, const struct iovec* iov, size_t iovcnt, off_t off);
 
+  /**
+   * Writes size bytes read from the pipe pipeFd into the file at the specified
+   * offset, without copying them through user space. Returns the number of
+   * bytes written.
+   */
+  size_t spliceWrite(FileInode& inode, int pipeFd, size_t size, off_t off);
+
   /**
    * Sets the size of the file in the overlay.
    */
@@ -123,6 +137,10 @@ class OverlayFileAccess {
    * concurrent with write or truncate, a version number is incremented on every
    * modification to an entry's file, and checked before writing the cached
    * value back.
+   *
+   * The persisted SHA-1 is the exception to the rule about not doing IO with
+   * the lock held: it is written and removed under the entry's lock, so that a
+   * hash can't be persisted after a concurrent write invalidated it.
    */
 
   struct Entry {
@@ -136,10 +154,22 @@ class OverlayFileAccess {
       Info(std::optional<size_t> s, const std::optional<Hash20>& h)
           : size{s}, sha1{h} {}
 
-      void invalidateMetadata();
+      /**
+       * Forget the size and SHA-1 after a modification of the file at or
+       * after the given offset.
+       */
+      void invalidateMetadata(uint64_t offset);
 
       std::optional<size_t> size;
       std::optional<Hash20> sha1;
+      // The SHA-1 state after hashing the first sha1PrefixLength bytes of the
+      // file. It is kept while modifications land after those bytes, so that
+      // getSha1 only has to hash the rest of the file after an append.
+      std::optional<SHA_CTX> sha1Prefix;
+      uint64_t sha1PrefixLength{0};
+      // Whether sha1 is persisted in the overlay file, and has to be removed
+      // from it when the file is modified.
+      bool sha1Persisted{false};
       uint64_t version{0};
     };
 
@@ -150,21 +180,64 @@ class OverlayFileAccess {
   using EntryPtr = std::shared_ptr<Entry>;
 
   struct State {
-    explicit State(size_t cacheSize);
+    State() : entries{1} {}
 
     folly::EvictingCacheMap<InodeNumber, EntryPtr> entries;
   };
 
   using LockedStatePtr = folly::Synchronized<State>::LockedPtr;
 
+  /**
+   * The LRU cache is split in up to this many shards by inode number, each
+   * with its own lock, so that concurrent accesses to different files rarely
+   * wait for each other.
+   */
+  static constexpr size_t kMaxShards = 16;
+
+  folly::Synchronized<State>& getShard(InodeNumber ino) {
+    return shards_[ino.get() % shardCount_];
+  }
+
   /**
    * Looks up an entry for the given inode. If the entry exists, it is returned.
    * Otherwise, one is loaded (and an old entry evicted if the cache is full).
    */
   EntryPtr getEntryForInode(InodeNumber);
 
+  /**
+   * Invalidates the cached metadata of the entry after a modification at or
+   * after the given offset, and removes its persisted SHA-1 if there is one.
+   */
+  void invalidateMetadata(Entry& entry, uint64_t offset);
+
+  /**
+   * Returns the SHA-1 persisted in the entry's file if it is still valid for a
+   * file with the given stat() result.
+   */
+  std::optional<Hash20> loadPersistedSha1(
+      const Entry& entry,
+      const struct stat& st);
+
+  /**
+   * Persists the SHA-1 of the first size bytes of the entry's file, which had
+   * the given stat() result before it was hashed. Returns whether it was
+   * written.
+   */
+  bool persistSha1(
+      const Entry& entry,
+      const struct stat& st,
+      uint64_t size,
+      const Hash20& sha1);
+
+  /**
+   * Whether persisting a SHA-1 failed because the overlay's filesystem doesn't
+   * support extended attributes, so that we stop trying.
+   */
+  std::atomic<bool> sha1XattrUnsupported_{false};
+
   Overlay* overlay_ = nullptr;
-  folly::Synchronized<State> state_;
+  size_t shardCount_;
+  std::array<folly::Synchronized<State>, kMaxShards> shards_;
 };
 
 } // namespace eden
@@ -11,7 +11,9 @@
 #include <cpptoml.h>
 #include <folly/executors/QueuedImmediateExecutor.h>
 #include <folly/executors/SerialExecutor.h>
+#include <folly/futures/FutureSplitter.h>
 #include <folly/logging/xlog.h>
+#include <limits>
 #include "eden/fs/config/CheckoutConfig.h"
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/FileInode.h"
@@ -59,10 +61,38 @@ std::string makeDotEdenConfig(EdenMount& mount) {
 PrjfsDispatcherImpl::PrjfsDispatcherImpl(EdenMount* mount)
     : PrjfsDispatcher(mount->getStats()),
       mount_{mount},
-      executor_{1, "PrjfsDispatcher"},
-      notificationExecutor_{
-          folly::SerialExecutor::create(folly::getKeepAliveToken(&executor_))},
-      dotEdenConfig_{makeDotEdenConfig(*mount)} {}
+      executor_{
+          std::max<size_t>(
+              mount->getEdenConfig()->prjfsNumNotificationThreads.getValue(),
+              1),
+          "PrjfsDispatcher"},
+      dotEdenConfig_{makeDotEdenConfig(*mount)} {
+  auto numExecutors = std::max<size_t>(
+      mount->getEdenConfig()->prjfsNumNotificationThreads.getValue(), 1);
+  notificationExecutors_.reserve(numExecutors);
+  for (size_t i = 0; i < numExecutors; ++i) {
+    notificationExecutors_.push_back(
+        folly::SerialExecutor::create(folly::getKeepAliveToken(&executor_)));
+  }
+}
+
+folly::Executor::KeepAlive<folly::SequencedExecutor>
+PrjfsDispatcherImpl::getNotificationExecutor(RelativePathPiece path) const {
+  // Notifications reconcile EdenFS with what is on disk at the time they are
+  // handled, and create the missing parent directories, so only the changes
+  // to the same path need to be ordered. Keying on the parent directory keeps
+  // all the entries of a directory together, which also avoids contending on
+  // its TreeInode from several threads.
+  //
+  // The paths ProjectedFS sends aren't necessarily in the same case as the
+  // canonical ones lookup uses, hence the case insensitive hash.
+  auto dirname = path.dirname().value();
+  size_t hash = 0;
+  for (auto c : dirname) {
+    hash = hash * 31 + static_cast<unsigned char>(std::tolower(c));
+  }
+  return notificationExecutors_[hash % notificationExecutors_.size()];
+}
 
 ImmediateFuture<std::vector<PrjfsDirEntry>> PrjfsDispatcherImpl::opendir(
     RelativePath path,
@@ -77,17 +107,46 @@ ImmediateFuture<std::vector<PrjfsDirEntry>> PrjfsDispatcherImpl::opendir(
         auto& tree = std::get<std::shared_ptr<const Tree>>(treeOrTreeEntry);
         auto& treeEntries = tree->getTreeEntries();
 
+        // Explorer and indexers enumerate whole trees, so look up the sizes
+        // of all the files of this directory with one batched request
+        // instead of one getBlobSize per entry. Each entry then picks its
+        // size out of the shared result.
+        std::vector<ObjectId> blobIds;
+        for (const auto& treeEntry : treeEntries) {
+          if (!treeEntry.isTree()) {
+            blobIds.push_back(treeEntry.getHash());
+          }
+        }
+        using BlobMetadataResults =
+            std::shared_ptr<const std::vector<folly::Try<BlobMetadata>>>;
+        folly::FutureSplitter<BlobMetadataResults> blobMetadata{
+            objectStore->getBlobMetadataBatch(blobIds, *context)
+                .thenValue([](std::vector<folly::Try<BlobMetadata>> results) {
+                  return BlobMetadataResults{
+                      std::make_shared<
+                          const std::vector<folly::Try<BlobMetadata>>>(
+                          std::move(results))};
+                })
+                .ensure([context]() {})
+                .semi()
+                .via(&folly::QueuedImmediateExecutor::instance())};
+
         std::vector<PrjfsDirEntry> ret;
         ret.reserve(treeEntries.size() + isRoot);
+        size_t blobIndex = 0;
         for (const auto& treeEntry : treeEntries) {
           if (treeEntry.isTree()) {
             ret.emplace_back(
                 treeEntry.getName(), true, ImmediateFuture<uint64_t>(0));
           } else {
-            auto sizeFut =
-                objectStore->getBlobSize(treeEntry.getHash(), *context)
-                    .ensure([context]() {});
-            ret.emplace_back(treeEntry.getName(), false, std::move(sizeFut));
+            auto sizeFut = blobMetadata.getFuture().thenValue(
+                [index = blobIndex++](const BlobMetadataResults& results) {
+                  return (*results)[index].value().size;
+                });
+            ret.emplace_back(
+                treeEntry.getName(),
+                false,
+                ImmediateFuture<uint64_t>{std::move(sizeFut).semi()});
           }
         }
 
@@ -150,8 +209,9 @@ ImmediateFuture<std::optional<LookupResult>> PrjfsDispatcherImpl::lookup(
               // call. In rare situation, this might happen during a checkout
               // operation which is already holding locks that the code below
               // also need.
+              auto executor = getNotificationExecutor(path);
               folly::via(
-                  notificationExecutor_,
+                  std::move(executor),
                   [&mount = *mount_,
                    path = std::move(path),
                    context = std::move(context)]() {
@@ -214,10 +274,16 @@ ImmediateFuture<std::string> PrjfsDispatcherImpl::read(
     RelativePath path,
     std::shared_ptr<ObjectFetchContext> context) {
   return mount_->getTreeOrTreeEntry(path, *context)
-      .thenValue([&context = *context, objectStore = mount_->getObjectStore()](
+      .thenValue([this,
+                  path,
+                  &context = *context,
+                  objectStore = mount_->getObjectStore()](
                      std::variant<std::shared_ptr<const Tree>, TreeEntry>
                          treeOrTreeEntry) {
         auto& treeEntry = std::get<TreeEntry>(treeOrTreeEntry);
+        if (!mount_->getBlobCache()->contains(treeEntry.getHash())) {
+          fileReadCold(path);
+        }
         return ImmediateFuture{
             objectStore->getBlob(treeEntry.getHash(), context).semi()}
             .thenValue([](std::shared_ptr<const Blob> blob) {
@@ -238,6 +304,61 @@ ImmediateFuture<std::string> PrjfsDispatcherImpl::read(
       .ensure([context = std::move(context)]() {});
 }
 
+void PrjfsDispatcherImpl::fileReadCold(RelativePathPiece path) {
+  auto config = mount_->getEdenConfig();
+  auto threshold = config->siblingBlobPrefetchThreshold.getValue();
+  if (threshold == 0) {
+    return;
+  }
+  auto dirname = path.dirname();
+  {
+    auto key = dirname.copy();
+    auto coldReads = coldReads_.wlock();
+    // Only remember recently read directories, this is a heuristic.
+    constexpr size_t kMaxTrackedDirectories = 10000;
+    if (coldReads->size() >= kMaxTrackedDirectories &&
+        coldReads->find(key) == coldReads->end()) {
+      coldReads->clear();
+    }
+    auto& count = (*coldReads)[std::move(key)];
+    if (count == std::numeric_limits<uint32_t>::max() || ++count < threshold) {
+      return;
+    }
+    count = std::numeric_limits<uint32_t>::max();
+  }
+
+  static auto context = ObjectFetchContext::getNullContextWithCauseDetail(
+      "PrjfsDispatcherImpl::fileReadCold");
+  auto maxBlobs = config->siblingBlobPrefetchMaxBlobs.getValue();
+  XLOG(DBG4) << "starting sibling blob prefetch for " << dirname;
+  mount_->getTreeOrTreeEntry(dirname, *context)
+      .thenValue([objectStore = mount_->getObjectStore(), maxBlobs](
+                     std::variant<std::shared_ptr<const Tree>, TreeEntry>
+                         treeOrTreeEntry) {
+        auto& tree = std::get<std::shared_ptr<const Tree>>(treeOrTreeEntry);
+        auto blobIds = std::make_shared<std::vector<ObjectId>>();
+        for (const auto& treeEntry : tree->getTreeEntries()) {
+          if (blobIds->size() >= maxBlobs) {
+            break;
+          }
+          if (!treeEntry.isTree()) {
+            blobIds->push_back(treeEntry.getHash());
+          }
+        }
+        // prefetchBlobs requires the ids to outlive it.
+        return ImmediateFuture{objectStore->prefetchBlobs(*blobIds, *context)
+                                   .ensure([blobIds] {})
+                                   .semi()};
+      })
+      .semi()
+      .via(mount_->getServerThreadPool().get())
+      .thenError(
+          [dirname = dirname.copy()](const folly::exception_wrapper& ew) {
+            XLOG(DBG3) << "sibling blob prefetch for " << dirname
+                       << " failed: " << ew;
+          });
+}
+
 namespace {
 ImmediateFuture<TreeInodePtr> createDirInode(
     const EdenMount& mount,
@@ -519,21 +640,30 @@ ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::fileCreated(
     RelativePath path,
     std::shared_ptr<ObjectFetchContext> context) {
   return fileNotification(
-      *mount_, path, notificationExecutor_, std::move(context));
+      *mount_,
+      path,
+      getNotificationExecutor(path),
+      std::move(context));
 }
 
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::dirCreated(
     RelativePath path,
     std::shared_ptr<ObjectFetchContext> context) {
   return fileNotification(
-      *mount_, path, notificationExecutor_, std::move(context));
+      *mount_,
+      path,
+      getNotificationExecutor(path),
+      std::move(context));
 }
 
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::fileModified(
     RelativePath path,
     std::shared_ptr<ObjectFetchContext> context) {
   return fileNotification(
-      *mount_, path, notificationExecutor_, std::move(context));
+      *mount_,
+      path,
+      getNotificationExecutor(path),
+      std::move(context));
 }
 
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::fileRenamed(
@@ -543,9 +673,13 @@ ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::fileRenamed(
   // A rename is just handled like 2 notifications separate notifications on
   // the old and new paths.
   auto oldNotification =
-      fileNotification(*mount_, oldPath, notificationExecutor_, context);
+      fileNotification(
+          *mount_, oldPath, getNotificationExecutor(oldPath), context);
   auto newNotification = fileNotification(
-      *mount_, newPath, notificationExecutor_, std::move(context));
+      *mount_,
+      newPath,
+      getNotificationExecutor(newPath),
+      std::move(context));
 
   return collectAllSafe(std::move(oldNotification), std::move(newNotification))
       .thenValue(
@@ -586,7 +720,10 @@ ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::fileDeleted(
     RelativePath path,
     std::shared_ptr<ObjectFetchContext> context) {
   return fileNotification(
-      *mount_, path, notificationExecutor_, std::move(context));
+      *mount_,
+      path,
+      getNotificationExecutor(path),
+      std::move(context));
 }
 
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::preFileDelete(
@@ -603,7 +740,10 @@ ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::dirDeleted(
     RelativePath path,
     std::shared_ptr<ObjectFetchContext> context) {
   return fileNotification(
-      *mount_, path, notificationExecutor_, std::move(context));
+      *mount_,
+      path,
+      getNotificationExecutor(path),
+      std::move(context));
 }
 
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::preDirDelete(
@@ -618,8 +758,8 @@ ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::preDirDelete(
 
 ImmediateFuture<folly::Unit>
 PrjfsDispatcherImpl::waitForPendingNotifications() {
-  // Since the executor is a SequencedExecutor, and the fileNotification
-  // function blocks in the executor, the body of the lambda will only be
+  // Since the executors are SequencedExecutors, and the fileNotification
+  // function blocks in the executor, the body of the lambdas will only be
   // executed when all previously enqueued notifications have completed.
   //
   // Note that this synchronization only guarantees that writes from a the
@@ -627,8 +767,14 @@ PrjfsDispatcherImpl::waitForPendingNotifications() {
   // made by a concurrent process or a different thread may still be in
   // ProjectedFS queue and therefore may still be pending when the future
   // complete. This is expected and therefore not a bug.
-  return ImmediateFuture{
-      folly::via(notificationExecutor_, []() { return folly::unit; }).semi()};
+  std::vector<ImmediateFuture<folly::Unit>> futures;
+  futures.reserve(notificationExecutors_.size());
+  for (const auto& executor : notificationExecutors_) {
+    futures.push_back(ImmediateFuture{
+        folly::via(executor, []() { return folly::unit; }).semi()});
+  }
+  return collectAllSafe(std::move(futures))
+      .thenValue([](std::vector<folly::Unit>&&) { return folly::unit; });
 }
 
 } // namespace facebook::eden
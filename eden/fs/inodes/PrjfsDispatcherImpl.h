@@ -7,7 +7,9 @@
 
 #pragma once
 
+#include <folly/Synchronized.h>
 #include <folly/executors/SequencedExecutor.h>
+#include <unordered_map>
 #include "eden/fs/prjfs/PrjfsDispatcher.h"
 #include "eden/fs/utils/UnboundedQueueExecutor.h"
 
@@ -84,13 +86,35 @@ class PrjfsDispatcherImpl : public PrjfsDispatcher {
   // The EdenMount associated with this dispatcher.
   EdenMount* const mount_;
 
+  /**
+   * The executor that notifications and lookups for the given path must be
+   * dispatched to, so that they are processed in order.
+   */
+  folly::Executor::KeepAlive<folly::SequencedExecutor> getNotificationExecutor(
+      RelativePathPiece path) const;
+
+  /**
+   * Called when read() of the file at path had to fetch its blob. Once
+   * store:sibling-blob-prefetch-threshold files of one directory were read
+   * cold, prefetch the blobs of the rest of that directory. This is the
+   * ProjectedFS counterpart of TreeInode::childBlobReadCold, which can't be
+   * used here as reads are served from Trees, not from inodes.
+   */
+  void fileReadCold(RelativePathPiece path);
+
   UnboundedQueueExecutor executor_;
-  // All the notifications are dispatched to this executor. The
-  // waitForPendingNotifications implementation depends on this being a
-  // SequencedExecutor.
-  folly::Executor::KeepAlive<folly::SequencedExecutor> notificationExecutor_;
+  // Notifications are dispatched to one of these executors, chosen by the
+  // parent directory of their path, see getNotificationExecutor. The
+  // waitForPendingNotifications implementation depends on these being
+  // SequencedExecutors.
+  std::vector<folly::Executor::KeepAlive<folly::SequencedExecutor>>
+      notificationExecutors_;
 
   const std::string dotEdenConfig_;
+
+  // The number of cold reads per directory, see fileReadCold. Directories
+  // whose blobs were already prefetched are set to UINT32_MAX.
+  folly::Synchronized<std::unordered_map<RelativePath, uint32_t>> coldReads_;
 };
 
 } // namespace facebook::eden
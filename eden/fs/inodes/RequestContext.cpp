@@ -7,6 +7,7 @@
 
 #include "eden/fs/inodes/RequestContext.h"
 
+#include <folly/ClockGettimeWrappers.h>
 #include <folly/logging/xlog.h>
 
 #include "eden/fs/telemetry/RequestMetricsScope.h"
@@ -16,6 +17,18 @@ using namespace std::chrono;
 
 namespace facebook::eden {
 
+namespace {
+std::atomic<nanoseconds::rep> slowRequestThresholdNs{0};
+} // namespace
+
+void RequestContext::setSlowRequestThreshold(nanoseconds threshold) {
+  slowRequestThresholdNs.store(threshold.count(), std::memory_order_relaxed);
+}
+
+nanoseconds RequestContext::getThreadCpuTime() {
+  return nanoseconds{folly::chrono::clock_gettime_ns(CLOCK_THREAD_CPUTIME_ID)};
+}
+
 void RequestContext::startRequest(
     EdenStats* stats,
     ChannelThreadStats::StatPtr stat,
@@ -51,6 +64,23 @@ void RequestContext::finishRequest() noexcept {
       channelThreadLocalStats_.reset();
     }
 
+    ProcessAccessLog::RequestCost cost{
+        diff_ns,
+        nanoseconds{edenTopStats_.cpuTimeNs.load(std::memory_order_relaxed)},
+        edenTopStats_.backingStoreBytes.load(std::memory_order_relaxed)};
+
+    auto slowThreshold = slowRequestThresholdNs.load(std::memory_order_relaxed);
+    if (slowThreshold != 0 && diff_ns.count() >= slowThreshold) {
+      XLOG(INFO) << "slow " << getCauseDetail().value_or("request")
+                 << " from pid " << getClientPid().value_or(0) << " took "
+                 << duration_cast<milliseconds>(diff).count() << "ms: "
+                 << duration_cast<microseconds>(cost.cpuTime).count()
+                 << "us cpu, "
+                 << edenTopStats_.cacheMisses.load(std::memory_order_relaxed)
+                 << " cache misses, " << cost.backingStoreBytes
+                 << " bytes fetched";
+    }
+
     if (auto pid = getClientPid(); pid.has_value()) {
       switch (getEdenTopStats().getFetchOrigin()) {
         case Origin::FromMemoryCache:
@@ -68,7 +98,7 @@ void RequestContext::finishRequest() noexcept {
         default:
           break;
       }
-      pal_.recordDuration(*pid, diff_ns);
+      pal_.recordCost(*pid, cost);
     }
   } catch (const std::exception& ex) {
     XLOG(WARN) << "Failed to complete request: " << folly::exceptionStr(ex);
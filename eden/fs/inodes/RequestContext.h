@@ -7,8 +7,11 @@
 
 #pragma once
 
+#include <folly/CancellationToken.h>
+#include <folly/ScopeGuard.h>
 #include <folly/futures/Future.h>
 #include <atomic>
+#include <chrono>
 #include <utility>
 
 #include "eden/fs/store/ImportPriority.h"
@@ -54,8 +57,39 @@ class RequestContext : public ObjectFetchContext {
   void didFetch(ObjectType /*type*/, const ObjectId& /*hash*/, Origin origin)
       override {
     edenTopStats_.setFetchOrigin(origin);
+    if (origin == Origin::FromDiskCache || origin == Origin::FromNetworkFetch) {
+      edenTopStats_.cacheMisses.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  // Override of `ObjectFetchContext`, may also be called concurrently.
+  void didFetchBytes(ObjectType /*type*/, Origin origin, uint64_t bytes)
+      override {
+    if (origin == Origin::FromNetworkFetch) {
+      edenTopStats_.backingStoreBytes.fetch_add(
+          bytes, std::memory_order_relaxed);
+    }
   }
 
+  /**
+   * Charge the CPU time the calling thread spends until the returned guard is
+   * destroyed to this request. Channels wrap the synchronous part of their
+   * handlers with it; work done on other threads, such as imports shared by
+   * several requests, isn't charged to any request.
+   */
+  [[nodiscard]] auto chargeCpuTime() {
+    return folly::makeGuard([this, start = getThreadCpuTime()] {
+      edenTopStats_.cpuTimeNs.fetch_add(
+          (getThreadCpuTime() - start).count(), std::memory_order_relaxed);
+    });
+  }
+
+  /**
+   * Requests taking at least threshold log what they cost on completion.
+   * Process-wide; zero, the default, disables the log.
+   */
+  static void setSlowRequestThreshold(std::chrono::nanoseconds threshold);
+
   // Override of `getPriority`
   ImportPriority getPriority() const override {
     return priority_;
@@ -81,6 +115,21 @@ class RequestContext : public ObjectFetchContext {
     return nullptr;
   }
 
+  // Override of `getCancellationToken`
+  folly::CancellationToken getCancellationToken() const override {
+    return cancellationSource_.getToken();
+  }
+
+  /**
+   * Signal that the result of the request is no longer awaited, so that the
+   * imports it queued can be dropped.
+   *
+   * May be called concurrently by arbitrary threads.
+   */
+  void cancel() {
+    cancellationSource_.requestCancellation();
+  }
+
   void startRequest(
       EdenStats* stats,
       ChannelThreadStats::StatPtr stat,
@@ -100,6 +149,11 @@ class RequestContext : public ObjectFetchContext {
     }
     std::chrono::nanoseconds fuseDuration{0};
 
+    // The cost of the request, beyond its duration.
+    std::atomic<uint64_t> cacheMisses{0};
+    std::atomic<uint64_t> backingStoreBytes{0};
+    std::atomic<std::chrono::nanoseconds::rep> cpuTimeNs{0};
+
    private:
     std::atomic<Origin> fetchOrigin_{Origin::NotFetched};
   };
@@ -108,6 +162,8 @@ class RequestContext : public ObjectFetchContext {
     return edenTopStats_;
   }
 
+  static std::chrono::nanoseconds getThreadCpuTime();
+
   // Needed to track stats
   std::chrono::time_point<std::chrono::steady_clock> startTime_;
   ChannelThreadStats::StatPtr latencyStat_{nullptr};
@@ -127,6 +183,8 @@ class RequestContext : public ObjectFetchContext {
    */
   std::atomic<ImportPriority> priority_{
       ImportPriority(ImportPriorityKind::High)};
+
+  folly::CancellationSource cancellationSource_;
 };
 
 } // namespace facebook::eden
@@ -12,6 +12,8 @@
 
 #include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/model/git/TopLevelIgnores.h"
+#include "eden/fs/store/GitIgnoreCache.h"
+#include "eden/fs/store/TreeDiffCache.h"
 #include "eden/fs/telemetry/FsEventLogger.h"
 #include "eden/fs/utils/Clock.h"
 #include "eden/fs/utils/FaultInjector.h"
@@ -44,6 +46,7 @@ ServerState::ServerState(
     UserInfo userInfo,
     std::shared_ptr<PrivHelper> privHelper,
     std::shared_ptr<UnboundedQueueExecutor> threadPool,
+    std::shared_ptr<UnboundedQueueExecutor> bulkThreadPool,
     std::shared_ptr<Clock> clock,
     std::shared_ptr<ProcessNameCache> processNameCache,
     std::shared_ptr<StructuredLogger> structuredLogger,
@@ -55,6 +58,7 @@ ServerState::ServerState(
     : userInfo_{std::move(userInfo)},
       privHelper_{std::move(privHelper)},
       threadPool_{std::move(threadPool)},
+      bulkThreadPool_{std::move(bulkThreadPool)},
       clock_{std::move(clock)},
       processNameCache_{std::move(processNameCache)},
       structuredLogger_{std::move(structuredLogger)},
@@ -68,6 +72,16 @@ ServerState::ServerState(
       systemIgnoreFileMonitor_{CachedParsedFileMonitor<GitIgnoreFileParser>{
           initialConfig.systemIgnoreFile.getValue(),
           kSystemIgnoreMinPollSeconds}},
+      gitIgnoreCache_{
+          initialConfig.gitIgnoreCacheSize.getValue()
+              ? std::make_shared<GitIgnoreCache>(
+                    initialConfig.gitIgnoreCacheSize.getValue())
+              : nullptr},
+      treeDiffCache_{
+          initialConfig.treeDiffCacheSize.getValue()
+              ? std::make_shared<TreeDiffCache>(
+                    initialConfig.treeDiffCacheSize.getValue())
+              : nullptr},
       fsEventLogger_{
           (kHasHiveLogger && initialConfig.requestSamplesPerMinute.getValue())
               ? std::make_shared<FsEventLogger>(config_, hiveLogger_)
@@ -114,5 +128,20 @@ std::unique_ptr<TopLevelIgnores> ServerState::getTopLevelIgnores() {
       std::move(userGitIgnore), std::move(systemGitIgnore));
 }
 
+size_t ServerState::getTopLevelIgnoresVersion() {
+  auto edenConfig = getEdenConfig();
+
+  // Refresh the monitors first so that their update counts reflect the
+  // current contents of the files.
+  auto userMonitor = userIgnoreFileMonitor_.wlock();
+  userMonitor->getFileContents(edenConfig->userIgnoreFile.getValue());
+  auto systemMonitor = systemIgnoreFileMonitor_.wlock();
+  systemMonitor->getFileContents(edenConfig->systemIgnoreFile.getValue());
+
+  // Both counts only ever increase, so their sum changes whenever either
+  // file does.
+  return userMonitor->getUpdateCount() + systemMonitor->getUpdateCount();
+}
+
 } // namespace eden
 } // namespace facebook
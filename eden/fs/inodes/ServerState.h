@@ -28,9 +28,11 @@ class EdenConfig;
 class FaultInjector;
 class IHiveLogger;
 class FsEventLogger;
+class GitIgnoreCache;
 class ProcessNameCache;
 class StructuredLogger;
 class TopLevelIgnores;
+class TreeDiffCache;
 class UnboundedQueueExecutor;
 class NfsServer;
 
@@ -46,6 +48,7 @@ class ServerState {
       UserInfo userInfo,
       std::shared_ptr<PrivHelper> privHelper,
       std::shared_ptr<UnboundedQueueExecutor> threadPool,
+      std::shared_ptr<UnboundedQueueExecutor> bulkThreadPool,
       std::shared_ptr<Clock> clock,
       std::shared_ptr<ProcessNameCache> processNameCache,
       std::shared_ptr<StructuredLogger> structuredLogger,
@@ -103,6 +106,29 @@ class ServerState {
    */
   std::unique_ptr<TopLevelIgnores> getTopLevelIgnores();
 
+  /**
+   * Returns a number that changes whenever the system or user git ignore
+   * files that getTopLevelIgnores() is based on change.
+   */
+  size_t getTopLevelIgnoresVersion();
+
+  /**
+   * Get the cache of parsed .gitignore files shared by the diffs of every
+   * mount. Returns nullptr if core:gitignore-cache-size is 0.
+   */
+  const std::shared_ptr<GitIgnoreCache>& getGitIgnoreCache() const {
+    return gitIgnoreCache_;
+  }
+
+  /**
+   * Get the cache of differences between commits and between trees shared by
+   * the commit diffs of every mount. Returns nullptr if
+   * core:tree-diff-cache-size is 0.
+   */
+  const std::shared_ptr<TreeDiffCache>& getTreeDiffCache() const {
+    return treeDiffCache_;
+  }
+
   /**
    * Get the UserInfo object describing the user running this edenfs process.
    */
@@ -127,6 +153,16 @@ class ServerState {
     return threadPool_;
   }
 
+  /**
+   * Get the thread pool for bulk work, such as checkout and prefetching, that
+   * shouldn't delay the tasks of getThreadPool().
+   *
+   * Adding new tasks to this thread pool executor will never block.
+   */
+  const std::shared_ptr<UnboundedQueueExecutor>& getBulkThreadPool() const {
+    return bulkThreadPool_;
+  }
+
   /**
    * Get the Clock.
    */
@@ -189,6 +225,7 @@ class ServerState {
   EdenStats edenStats_;
   std::shared_ptr<PrivHelper> privHelper_;
   std::shared_ptr<UnboundedQueueExecutor> threadPool_;
+  std::shared_ptr<UnboundedQueueExecutor> bulkThreadPool_;
   std::shared_ptr<Clock> clock_;
   std::shared_ptr<ProcessNameCache> processNameCache_;
   std::shared_ptr<StructuredLogger> structuredLogger_;
@@ -201,6 +238,8 @@ class ServerState {
       userIgnoreFileMonitor_;
   folly::Synchronized<CachedParsedFileMonitor<GitIgnoreFileParser>>
       systemIgnoreFileMonitor_;
+  std::shared_ptr<GitIgnoreCache> gitIgnoreCache_;
+  std::shared_ptr<TreeDiffCache> treeDiffCache_;
   std::shared_ptr<Notifier> notifier_;
   std::shared_ptr<FsEventLogger> fsEventLogger_;
 };
@@ -30,6 +30,105 @@ std::vector<ChildEntry> parseDirContents(const DirContents& contents) {
   return results;
 }
 
+ImmediateFuture<folly::Unit> traverseTreeInodeChildrenParallel(
+    Overlay* overlay,
+    const std::vector<ChildEntry>& children,
+    RelativePathPiece rootPath,
+    InodeNumber ino,
+    const std::optional<ObjectId>& hash,
+    uint64_t fsRefcount,
+    TraversalCallbacks& callbacks,
+    folly::Executor::KeepAlive<> executor);
+
+/**
+ * Copy the entries of the given child tree, and traverse them. The child is
+ * either loaded, or allocated in the overlay and read from there.
+ */
+ImmediateFuture<folly::Unit> traverseChildParallel(
+    Overlay* overlay,
+    const ChildEntry& entry,
+    RelativePathPiece childPath,
+    TraversalCallbacks& callbacks,
+    folly::Executor::KeepAlive<> executor) {
+  if (auto* loadedTreeInode = entry.loadedChild.asTreeOrNull()) {
+    std::vector<ChildEntry> children;
+    std::optional<ObjectId> hash;
+    {
+      auto contents = loadedTreeInode->getContents().rlock();
+      children = parseDirContents(contents->entries);
+      hash = contents->treeHash;
+    }
+    return traverseTreeInodeChildrenParallel(
+        overlay,
+        children,
+        childPath,
+        entry.ino,
+        hash,
+        loadedTreeInode->debugGetFsRefcount(),
+        callbacks,
+        std::move(executor));
+  }
+
+  // If we are able to load a child directory from the overlay, then this
+  // child entry has been allocated, and can be traversed.
+  auto contents = overlay->loadOverlayDir(entry.ino);
+  if (contents.empty()) {
+    return folly::unit;
+  }
+  return traverseTreeInodeChildrenParallel(
+      overlay,
+      parseDirContents(contents),
+      childPath,
+      entry.ino,
+      entry.hash,
+      0,
+      callbacks,
+      std::move(executor));
+}
+
+ImmediateFuture<folly::Unit> traverseTreeInodeChildrenParallel(
+    Overlay* overlay,
+    const std::vector<ChildEntry>& children,
+    RelativePathPiece rootPath,
+    InodeNumber ino,
+    const std::optional<ObjectId>& hash,
+    uint64_t fsRefcount,
+    TraversalCallbacks& callbacks,
+    folly::Executor::KeepAlive<> executor) {
+  XLOG(DBG7) << "Traversing: " << rootPath;
+  callbacks.visitTreeInode(rootPath, ino, hash, fsRefcount, children);
+
+  std::vector<ImmediateFuture<folly::Unit>> futures;
+  for (auto& entry : children) {
+    bool isTree = entry.loadedChild
+        ? entry.loadedChild.asTreeOrNull() != nullptr
+        : dtype_t::Dir == entry.dtype;
+    if (!isTree || !callbacks.shouldRecurse(entry)) {
+      continue;
+    }
+    // The entry holds a reference to the loaded child, which keeps it alive
+    // until its subtree has been traversed.
+    futures.emplace_back(
+        folly::via(
+            executor,
+            [overlay,
+             entry,
+             childPath = rootPath + entry.name,
+             &callbacks,
+             executor]() mutable {
+              return traverseChildParallel(
+                         overlay,
+                         entry,
+                         childPath,
+                         callbacks,
+                         std::move(executor))
+                  .semi();
+            })
+            .semi());
+  }
+  return collectAllSafe(std::move(futures)).thenValue([](auto&&) {});
+}
+
 } // namespace
 
 void traverseTreeInodeChildren(
@@ -96,4 +195,30 @@ void traverseObservedInodes(
       callbacks);
 }
 
+ImmediateFuture<folly::Unit> traverseObservedInodesParallel(
+    const TreeInode& root,
+    RelativePathPiece rootPath,
+    TraversalCallbacks& callbacks,
+    folly::Executor::KeepAlive<> executor) {
+  auto* overlay = root.getMount()->getOverlay();
+
+  std::vector<ChildEntry> children;
+  std::optional<ObjectId> hash;
+  {
+    auto contents = root.getContents().rlock();
+    children = parseDirContents(contents->entries);
+    hash = contents->treeHash;
+  }
+
+  return traverseTreeInodeChildrenParallel(
+      overlay,
+      children,
+      rootPath,
+      root.getNodeId(),
+      hash,
+      root.debugGetFsRefcount(),
+      callbacks,
+      std::move(executor));
+}
+
 } // namespace facebook::eden
@@ -7,11 +7,13 @@
 
 #pragma once
 
+#include <folly/Executor.h>
 #include <variant>
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/InodePtr.h"
 #include "eden/fs/model/ObjectId.h"
 #include "eden/fs/utils/DirType.h"
+#include "eden/fs/utils/ImmediateFuture.h"
 #include "eden/fs/utils/PathFuncs.h"
 
 namespace facebook::eden {
@@ -70,4 +72,26 @@ void traverseObservedInodes(
     RelativePathPiece rootPath,
     TraversalCallbacks& callbacks);
 
+/**
+ * Performs the same traversal as traverseObservedInodes, but visits sibling
+ * subtrees concurrently on the given executor, which also does the Overlay
+ * reads for the unloaded trees.
+ *
+ * Each TreeInode's contents lock is only held while its entries are copied,
+ * so a long traversal doesn't stall concurrent filesystem requests, and the
+ * result is a snapshot of each tree at the time it was visited rather than of
+ * the whole checkout at once.
+ *
+ * The callbacks may be called from several threads at once and must be
+ * thread-safe. The root is visited first, and every tree is visited before its
+ * children, but there is otherwise no ordering between the visited trees. The
+ * root and the callbacks must remain valid until the returned future
+ * completes.
+ */
+ImmediateFuture<folly::Unit> traverseObservedInodesParallel(
+    const TreeInode& root,
+    RelativePathPiece rootPath,
+    TraversalCallbacks& callbacks,
+    folly::Executor::KeepAlive<> executor);
+
 } // namespace facebook::eden
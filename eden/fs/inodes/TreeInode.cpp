@@ -73,6 +73,13 @@ namespace eden {
 namespace {
 static constexpr PathComponentPiece kIgnoreFilename{".gitignore"};
 
+/**
+ * removeRecursively() unlinks unloaded directories with at least this many
+ * entries at once. Smaller ones are removed entry by entry, which costs little
+ * and records every removed file in the journal.
+ */
+constexpr size_t kMinEntriesToRemoveAtOnce = 100;
+
 /**
  * For case insensitive system, we need to use the casing of the file as
  * present in the SCM rather than the one used for lookup.
@@ -261,13 +268,13 @@ ImmediateFuture<InodePtr> TreeInode::getOrLoadChild(
                folly::Promise<InodePtr> promise;
                auto returnFuture = promise.getSemiFuture();
                auto childNumber = entry.getInodeNumber();
-               bool startLoad = getInodeMap()->shouldLoadChild(
-                   this, name, childNumber, std::move(promise));
-               if (startLoad) {
+               auto loadContext = getInodeMap()->shouldLoadChild(
+                   this, name, childNumber, std::move(promise), context);
+               if (loadContext) {
                  // The inode is not already being loaded.  We have to start
                  // loading it now.
                  auto loadFuture =
-                     startLoadingInodeNoThrow(entry, name, context);
+                     startLoadingInodeNoThrow(entry, name, *loadContext);
                  if (loadFuture.isReady() && loadFuture.hasValue()) {
                    // If we finished loading the inode immediately, just call
                    // InodeMap::inodeLoadComplete() now, since we still have the
@@ -291,11 +298,30 @@ ImmediateFuture<InodePtr> TreeInode::getOrLoadChild(
                  }
                }
 
+               if (!loadContext) {
+                 return waitForChildLoad(
+                     std::move(returnFuture), name, context);
+               }
                return ImmediateFuture<InodePtr>{std::move(returnFuture)};
              })
       .ensure([b = std::move(block)]() mutable { b.close(); });
 }
 
+ImmediateFuture<InodePtr> TreeInode::waitForChildLoad(
+    folly::SemiFuture<InodePtr> load,
+    PathComponentPiece name,
+    ObjectFetchContext& context) {
+  return ImmediateFuture<InodePtr>{std::move(load)}.thenTry(
+      [self = inodePtrFromThis(), name = PathComponent{name}, &context](
+          folly::Try<InodePtr>&& child) -> ImmediateFuture<InodePtr> {
+        if (child.hasException<folly::OperationCancelled>() &&
+            !context.getCancellationToken().isCancellationRequested()) {
+          return self->getOrLoadChild(name, context);
+        }
+        return std::move(child);
+      });
+}
+
 ImmediateFuture<TreeInodePtr> TreeInode::getOrLoadChildTree(
     PathComponentPiece name,
     ObjectFetchContext& context) {
@@ -869,25 +895,29 @@ DirContents TreeInode::buildDirFromTree(
     CaseSensitivity caseSensitive) {
   XCHECK(tree);
 
-  // A future optimization is for this code to allocate all of the inode numbers
-  // at once and then dole them out, one per entry. It would reduce the number
-  // of atomic operations from N to 1, though if the atomic is issued with the
-  // other work this loop is doing it may not matter much.
-
+  const auto& entries = tree->getTreeEntries();
   DirContents dir(caseSensitive);
-  // TODO: O(N^2)
-  for (const auto& treeEntry : tree->getTreeEntries()) {
+  if (entries.empty()) {
+    return dir;
+  }
+
+  // Tree entries are sorted by name, so each of them is appended to dir's
+  // storage, which is allocated once here. Their inode numbers are allocated
+  // with a single atomic operation as well.
+  dir.reserve(entries.size());
+  auto inodeNumber = overlay->allocateInodeNumbers(entries.size()).get();
+  for (const auto& treeEntry : entries) {
     dir.emplace(
         treeEntry.getName(),
         modeFromTreeEntryType(treeEntry.getType()),
-        overlay->allocateInodeNumber(),
+        InodeNumber{inodeNumber++},
         treeEntry.getHash());
   }
   return dir;
 }
 
 FileInodePtr TreeInode::createImpl(
-    folly::Synchronized<TreeInodeState>::LockedPtr contents,
+    SynchronizedTreeInodeState::LockedPtr contents,
     PathComponentPiece name,
     mode_t mode,
     FOLLY_MAYBE_UNUSED ByteRange fileContents,
@@ -1163,6 +1193,9 @@ ImmediateFuture<folly::Unit> TreeInode::removeRecursively(
               std::move(name), std::move(child), invalidate, 1, context);
         } else {
           auto tree = child.asTreePtr();
+          if (self->tryRemoveUnloadedTree(name, tree, invalidate)) {
+            return ImmediateFuture<folly::Unit>{folly::unit};
+          }
 
           std::vector<PathComponent> names;
           {
@@ -1377,6 +1410,93 @@ int TreeInode::tryRemoveChild(
   return 0;
 }
 
+bool TreeInode::tryRemoveUnloadedTree(
+    PathComponentPiece name,
+    const TreeInodePtr& child,
+    InvalidationRequired invalidate) {
+#ifdef _WIN32
+  // ProjectedFS may have placeholders on disk for any entry of the subtree,
+  // and those can only be invalidated one at a time.
+  if (invalidate == InvalidationRequired::Yes) {
+    return false;
+  }
+#endif
+
+  auto renameLock = getMount()->acquireRenameLock();
+  auto myPath = getPath();
+  if (!myPath.has_value()) {
+    // Let removeImpl() report the error.
+    return false;
+  }
+  auto targetName = myPath.value() + name;
+
+  materialize(&renameLock);
+
+#ifndef _WIN32
+  if (getNodeId() == getMount()->getDotEdenInodeNumber()) {
+    return false;
+  }
+#endif // !_WIN32
+
+  std::unique_ptr<InodeBase> deletedInode;
+  {
+    auto contents = contents_.wlock();
+    auto entIter = contents->entries.find(name);
+    if (entIter == contents->entries.end() ||
+        entIter->second.getInode() != child.get()) {
+      return false;
+    }
+    auto inodeName = copyCanonicalInodeName(entIter);
+    auto childNumber = entIter->second.getInodeNumber();
+
+    {
+      // A loaded inode keeps its parent loaded, and the kernel only knows
+      // about inodes that are loaded or remembered by the InodeMap. So if no
+      // child is either, nothing below this directory can be referenced.
+      auto childContents = child->contents_.wlock();
+      if (childContents->entries.size() < kMinEntriesToRemoveAtOnce) {
+        return false;
+      }
+      for (const auto& childEntry : childContents->entries) {
+        if (childEntry.second.getInode() ||
+            getInodeMap()->isInodeRemembered(
+                childEntry.second.getInodeNumber())) {
+          return false;
+        }
+      }
+
+      if (InvalidationRequired::Yes == invalidate) {
+        auto success =
+            invalidateChannelEntryCache(*contents, inodeName, childNumber);
+        if (success.hasException()) {
+          return false;
+        }
+        success = invalidateChannelDirCache(*contents).getTry();
+        if (success.hasException()) {
+          return false;
+        }
+      }
+
+      // The child may still be open, in which case it must look empty, like
+      // a directory removed one entry at a time.
+      childContents->entries.clear();
+    }
+
+    // Only the root of the subtree is removed here, the rest of its overlay
+    // data is removed by the GC thread.
+    getOverlay()->recursivelyRemoveOverlayData(childNumber);
+
+    deletedInode = child->markUnlinked(this, inodeName, renameLock);
+    contents->entries.erase(entIter);
+    updateMtimeAndCtimeLocked(contents->entries, getNow());
+    getOverlay()->removeChild(getNodeId(), inodeName, contents->entries);
+  }
+  deletedInode.reset();
+
+  getMount()->getJournal().recordRemoved(targetName);
+  return true;
+}
+
 int TreeInode::checkPreRemove(const TreeInodePtr& child) {
   // Lock the child contents, and make sure they are empty
   auto childContents = child->contents_.rlock();
@@ -1480,9 +1600,9 @@ class TreeInode::TreeRenameLocks {
    * always both set, so that destContents_ can be used regardless of wether
    * the source and destination are both the same directory or not.
    */
-  folly::Synchronized<TreeInodeState>::LockedPtr srcContentsLock_;
-  folly::Synchronized<TreeInodeState>::LockedPtr destContentsLock_;
-  folly::Synchronized<TreeInodeState>::LockedPtr destChildContentsLock_;
+  SynchronizedTreeInodeState::LockedPtr srcContentsLock_;
+  SynchronizedTreeInodeState::LockedPtr destContentsLock_;
+  SynchronizedTreeInodeState::LockedPtr destChildContentsLock_;
 
   /**
    * Pointers to the source and destination directory contents.
@@ -1993,6 +2113,31 @@ std::tuple<NfsDirList, bool> TreeInode::nfsReaddir(
 
   return {std::move(list), isEof};
 }
+
+ImmediateFuture<folly::Unit> TreeInode::prefetchChildBlobMetadata(
+    const std::vector<PathComponent>& names,
+    ObjectFetchContext& context) {
+  std::vector<ObjectId> blobIds;
+  {
+    auto contents = contents_.rlock();
+    for (const auto& name : names) {
+      auto it = contents->entries.find(name);
+      if (it == contents->entries.end()) {
+        continue;
+      }
+      const auto& entry = it->second;
+      if (!entry.getInode() && !entry.isDirectory() &&
+          !entry.isMaterialized()) {
+        blobIds.push_back(entry.getHash());
+      }
+    }
+  }
+  if (blobIds.empty()) {
+    return folly::unit;
+  }
+  return getStore()->getBlobMetadataBatch(blobIds, context).thenValue(
+      [](auto&&) { return folly::unit; });
+}
 #endif // _WIN32
 
 InodeMap* TreeInode::getInodeMap() const {
@@ -2151,6 +2296,37 @@ Future<Unit> TreeInode::loadGitIgnoreThenDiff(
     shared_ptr<const Tree> tree,
     const GitIgnoreStack* parentIgnore,
     bool isIgnored) {
+  // A .gitignore that isn't materialized is the blob it was checked out from,
+  // which may have been parsed already.
+  std::optional<ObjectId> blobHash;
+  if (context->hasGitIgnoreCache() &&
+      gitignoreInode->getType() == dtype_t::Regular) {
+    blobHash = gitignoreInode.asFilePtr()->getBlobHash();
+  }
+  if (blobHash) {
+    return context->loadGitIgnore(*blobHash)
+        .thenError([](const folly::exception_wrapper& ex) {
+          XLOG(WARN) << "error reading ignore file: "
+                     << folly::exceptionStr(ex);
+          return std::shared_ptr<const GitIgnore>{};
+        })
+        .thenValue(
+            [self = inodePtrFromThis(),
+             context,
+             currentPath = RelativePath{currentPath}, // deep copy
+             tree,
+             parentIgnore,
+             isIgnored](std::shared_ptr<const GitIgnore>&& ignore) mutable {
+              return self->computeDiff(
+                  self->contents_.wlock(),
+                  context,
+                  currentPath,
+                  std::move(tree),
+                  make_unique<GitIgnoreStack>(parentIgnore, std::move(ignore)),
+                  isIgnored);
+            });
+  }
+
   return getMount()
       ->loadFileContents(context->getFetchContext(), gitignoreInode)
       .thenError([](const folly::exception_wrapper& ex) {
@@ -2199,7 +2375,7 @@ due to the fact that we do not need to worry about recursive lock holding since
 the only time a lock is held in this path is when we load gitignore files.
 */
 Future<Unit> TreeInode::computeDiff(
-    folly::Synchronized<TreeInodeState>::LockedPtr contentsLock,
+    SynchronizedTreeInodeState::LockedPtr contentsLock,
     DiffContext* context,
     RelativePathPiece currentPath,
     shared_ptr<const Tree> tree,
@@ -2345,7 +2521,22 @@ Future<Unit> TreeInode::computeDiff(
         }
       }
 
-      if (inodeEntry->getInode()) {
+      if (!inodeEntry->isMaterialized() &&
+          // Eventually the mode will come from inode metadata storage,
+          // not from the directory entry.  However, any source-control-visible
+          // metadata changes will cause the inode to be materialized.
+          treeEntryTypeFromMode(inodeEntry->getInitialMode()) ==
+              scmEntry.getType() &&
+          inodeEntry->getHash() == scmEntry.getHash()) {
+        // This file or directory is unchanged.  We can skip it.
+        //
+        // This holds even when the child is loaded: modifying a file, or
+        // anything below a directory, materializes it and then marks its
+        // entry here as materialized, before the change can be observed.
+        // So a whole clean subtree is skipped from this entry alone, without
+        // taking the child's contents lock.
+        XLOG(DBG9) << "diff: unchanged entry: " << entryPath;
+      } else if (inodeEntry->getInode()) {
         // This inode is already loaded.
         auto childInodePtr = inodeEntry->getInodePtr();
         deferredEntries.emplace_back(DeferredDiffEntry::createModifiedEntry(
@@ -2372,16 +2563,6 @@ Future<Unit> TreeInode::computeDiff(
                 std::move(inodeFuture),
                 ignore.get(),
                 entryIgnored));
-      } else if (
-          // Eventually the mode will come from inode metadata storage,
-          // not from the directory entry.  However, any source-control-visible
-          // metadata changes will cause the inode to be materialized, and
-          // the previous path will be taken.
-          treeEntryTypeFromMode(inodeEntry->getInitialMode()) ==
-              scmEntry.getType() &&
-          inodeEntry->getHash() == scmEntry.getHash()) {
-        // This file or directory is unchanged.  We can skip it.
-        XLOG(DBG9) << "diff: unchanged unloaded file: " << entryPath;
       } else if (inodeEntry->isDirectory()) {
         // This is a modified directory. Since it is not materialized we can
         // directly compare the source control objects.
@@ -2539,6 +2720,7 @@ Future<Unit> TreeInode::checkout(
              << (fromTree ? fromTree->getHash().toLogString() : "<none>")
              << " --> "
              << (toTree ? toTree->getHash().toLogString() : "<none>");
+  ctx->treeStarted();
 
   vector<unique_ptr<CheckoutAction>> actions;
   vector<IncompleteInodeLoad> pendingLoads;
@@ -2592,13 +2774,18 @@ Future<Unit> TreeInode::checkout(
               // the futures, while holding the contents lock all the way. The
               // reason is that we in theory need to rollback what was done in
               // case we can't invalidate.
+              auto invalidationStart = std::chrono::steady_clock::now();
               {
                 auto contents = self->contents_.wlock();
                 invalidation = self->invalidateChannelDirCache(*contents);
               }
               invalidation =
                   std::move(invalidation)
-                      .thenTry([self, ctx](folly::Try<folly::Unit>&& success) {
+                      .thenTry([self, ctx, invalidationStart](
+                                   folly::Try<folly::Unit>&& success) {
+                        ctx->directoryInvalidated(
+                            std::chrono::steady_clock::now() -
+                            invalidationStart);
                         if (success.hasException()) {
                           auto location =
                               self->getLocationInfo(ctx->renameLock());
@@ -2624,13 +2811,14 @@ Future<Unit> TreeInode::checkout(
                              XLOG(DBG4) << "checkout: finished update of "
                                         << self->getLogPath() << ": "
                                         << numErrors << " errors";
+                             ctx->treeFinished();
                            });
 
             if (fut.isReady()) {
               return folly::makeFuture(std::move(fut).getTry());
             } else {
               return std::move(fut).semi().via(
-                  self->getMount()->getServerThreadPool().get());
+                  self->getMount()->getServerBulkThreadPool().get());
             }
           });
 }
@@ -2939,27 +3127,46 @@ unique_ptr<CheckoutAction> TreeInode::processCheckoutEntry(
   }
 
   auto oldEntryInodeNumber = entry.getInodeNumber();
+  auto wasDirectory = entry.isDirectory();
 
   // We are removing or replacing an entry - attempt to invalidate it while the
   // write lock is held and before the contents are updated.
+  //
+  // FUSE only caches entries that it looked up, and those are either loaded
+  // or remembered by the InodeMap, in which case we took the load path above.
+  // So there is nothing to invalidate here, and skipping it keeps the cost of
+  // checking out subtrees that were never accessed independent of their
+  // size. ProjectedFS on the other hand may have placeholders on disk for
+  // entries that EdenFS never loaded.
+#ifdef _WIN32
   auto success = invalidateChannelEntryCache(state, name, oldEntryInodeNumber);
   if (success.hasException()) {
     ctx->addError(this, name, success.exception());
     return nullptr;
   }
+#endif
 
   // TODO: remove entry.getInodeNumber() from both the overlay and the
   // InodeTable.  Or at least verify that it's already done in a test.
   //
   // This logic could potentially be unified with TreeInode::tryRemoveChild
   // and TreeInode::checkoutUpdateEntry.
-  contents.erase(it);
-  if (newScmEntry) {
-    contents.emplace(
-        newScmEntry->getName(),
+  if (newScmEntry && it->first == newScmEntry->getName()) {
+    // Replacing the entry in place avoids shifting the rest of the sorted
+    // directory twice for every entry that changed.
+    entry = DirEntry{
         modeFromTreeEntryType(newScmEntry->getType()),
         getOverlay()->allocateInodeNumber(),
-        newScmEntry->getHash());
+        newScmEntry->getHash()};
+  } else {
+    contents.erase(it);
+    if (newScmEntry) {
+      contents.emplace(
+          newScmEntry->getName(),
+          modeFromTreeEntryType(newScmEntry->getType()),
+          getOverlay()->allocateInodeNumber(),
+          newScmEntry->getHash());
+    }
   }
 
   wasDirectoryListModified = true;
@@ -2970,7 +3177,7 @@ unique_ptr<CheckoutAction> TreeInode::processCheckoutEntry(
   // filesystem, it's as if the entire subtree got deleted and checked out
   // from scratch.  (Note: if anything uses Watchman and cares precisely about
   // inode numbers, it could miss changes.)
-  if (!kPreciseInodeNumberMemory && entry.isDirectory()) {
+  if (!kPreciseInodeNumberMemory && wasDirectory) {
     XLOG(DBG5) << "recursively removing overlay data for "
                << oldEntryInodeNumber << "(" << getLogPath() << " / " << name
                << ")";
@@ -3073,7 +3280,14 @@ Future<InvalidationRequired> TreeInode::checkoutUpdateEntry(
       // new name.
     } else {
       // TODO: Also apply permissions changes to the entry.
-      return treeInode->checkout(ctx, std::move(oldTree), std::move(newTree))
+      return ctx
+          ->runSubtree([ctx,
+                        treeInode,
+                        oldTree = std::move(oldTree),
+                        newTree = std::move(newTree)]() mutable {
+            return treeInode->checkout(
+                ctx, std::move(oldTree), std::move(newTree));
+          })
           .thenValue([](folly::Unit) { return InvalidationRequired::No; });
     }
   }
@@ -3083,7 +3297,10 @@ Future<InvalidationRequired> TreeInode::checkoutUpdateEntry(
   // Fortunately, calling checkout() with an empty destination tree does
   // exactly what we want.  checkout() will even remove the directory before it
   // returns if the directory is empty.
-  return treeInode->checkout(ctx, std::move(oldTree), nullptr)
+  return ctx
+      ->runSubtree([ctx, treeInode, oldTree = std::move(oldTree)]() mutable {
+        return treeInode->checkout(ctx, std::move(oldTree), nullptr);
+      })
       .thenValue(
           [ctx, parentInode = inodePtrFromThis(), treeInode, newScmEntry](
               auto&&) -> folly::Future<InvalidationRequired> {
@@ -3173,7 +3390,7 @@ Future<InvalidationRequired> TreeInode::checkoutUpdateEntry(
               return std::move(fut).getTry();
             } else {
               return std::move(fut).semi().via(
-                  parentInode->getMount()->getServerThreadPool().get());
+                  parentInode->getMount()->getServerBulkThreadPool().get());
             }
           });
 }
@@ -3431,10 +3648,10 @@ folly::Future<InodePtr> TreeInode::loadChildLocked(
   folly::Promise<InodePtr> promise;
   auto future = promise.getFuture();
   auto childNumber = entry.getInodeNumber();
-  bool startLoad = getInodeMap()->shouldLoadChild(
-      this, name, childNumber, std::move(promise));
-  if (startLoad) {
-    auto loadFuture = startLoadingInodeNoThrow(entry, name, fetchContext);
+  auto loadContext = getInodeMap()->shouldLoadChild(
+      this, name, childNumber, std::move(promise), fetchContext);
+  if (loadContext) {
+    auto loadFuture = startLoadingInodeNoThrow(entry, name, *loadContext);
     pendingLoads.emplace_back(
         this, std::move(loadFuture), name, entry.getInodeNumber());
   }
@@ -3682,11 +3899,21 @@ void TreeInode::prefetch(ObjectFetchContext& context) {
     prefetched_.store(false);
     return;
   }
+  // A directory listed right after its parent is most likely part of a
+  // recursive walk, which will list its subdirectories next.
+  uint32_t subtreeDepth = 0;
+  if (auto parent = getParentRacy();
+      parent && parent->prefetched_.load(std::memory_order_relaxed)) {
+    subtreeDepth = config->subtreePrefetchDepth.getValue();
+  }
+  auto subtreeMaxTrees = config->subtreePrefetchMaxTrees.getValue();
   XLOG(DBG4) << "starting prefetch for " << getLogPath();
 
   folly::via(
-      getMount()->getServerThreadPool().get(),
-      [lease = std::move(*prefetchLease)]() mutable {
+      getMount()->getServerBulkThreadPool().get(),
+      [lease = std::move(*prefetchLease),
+       subtreeDepth,
+       subtreeMaxTrees]() mutable {
         // prefetch() is called by readdir, under the assumption that a series
         // of stat calls on its entries will follow. (e.g. `ls -l` or `find
         // -ls`). To optimize that common situation, load trees and blob
@@ -3701,6 +3928,26 @@ void TreeInode::prefetch(ObjectFetchContext& context) {
         {
           auto contents = lease.getTreeInode()->contents_.wlock();
 
+          // Fetch the metadata of all the unloaded files with one batched
+          // lookup before loading them, so that the stat() of each file below
+          // waits for this lookup instead of starting its own.
+          std::vector<ObjectId> blobIds;
+          for (auto& [name, entry] : contents->entries) {
+            if (!entry.getInode() && !entry.isDirectory() &&
+                !entry.isMaterialized()) {
+              blobIds.push_back(entry.getHash());
+            }
+          }
+          if (!blobIds.empty()) {
+            inodeFutures.emplace_back(
+                lease.getTreeInode()
+                    ->getStore()
+                    ->getBlobMetadataBatch(blobIds, context)
+                    .semi()
+                    .via(&folly::QueuedImmediateExecutor::instance())
+                    .unit());
+          }
+
           for (auto& [name, entry] : contents->entries) {
             if (entry.getInode()) {
               // Already loaded
@@ -3721,6 +3968,22 @@ void TreeInode::prefetch(ObjectFetchContext& context) {
                       return inode->stat(context).semi();
                     })
                     .unit());
+
+            // Loading the child only fetches its own tree. For a walk, also
+            // fetch the ones below it, concurrently.
+            if (subtreeDepth > 0 && entry.isDirectory() &&
+                !entry.isMaterialized()) {
+              inodeFutures.emplace_back(
+                  lease.getTreeInode()
+                      ->getStore()
+                      ->prefetchTrees(
+                          entry.getHash(),
+                          subtreeDepth,
+                          subtreeMaxTrees,
+                          context)
+                      .semi()
+                      .via(&folly::QueuedImmediateExecutor::instance()));
+            }
           }
         }
 
@@ -3739,6 +4002,61 @@ void TreeInode::prefetch(ObjectFetchContext& context) {
       });
 }
 
+void TreeInode::childBlobReadCold(ObjectFetchContext& context) {
+  auto config = getMount()->getServerState()->getEdenConfig();
+  auto threshold = config->siblingBlobPrefetchThreshold.getValue();
+  if (threshold == 0 ||
+      siblingBlobsPrefetched_.load(std::memory_order_relaxed) ||
+      coldChildReads_.fetch_add(1, std::memory_order_relaxed) + 1 < threshold) {
+    return;
+  }
+  bool expected = false;
+  if (!siblingBlobsPrefetched_.compare_exchange_strong(expected, true)) {
+    return;
+  }
+  auto prefetchLease =
+      getMount()->tryStartTreePrefetch(inodePtrFromThis(), context);
+  if (!prefetchLease) {
+    XLOG(DBG3) << "skipping sibling blob prefetch for " << getLogPath()
+               << ": too many prefetches already in progress";
+    // Try again on the next cold read.
+    siblingBlobsPrefetched_.store(false);
+    return;
+  }
+
+  auto maxBlobs = config->siblingBlobPrefetchMaxBlobs.getValue();
+  auto blobIds = std::make_shared<std::vector<ObjectId>>();
+  {
+    auto contents = contents_.rlock();
+    for (const auto& [name, entry] : contents->entries) {
+      if (blobIds->size() >= maxBlobs) {
+        break;
+      }
+      if (!entry.isDirectory() && !entry.isMaterialized()) {
+        blobIds->push_back(entry.getHash());
+      }
+    }
+  }
+  if (blobIds->empty()) {
+    return;
+  }
+  XLOG(DBG4) << "starting sibling blob prefetch of " << blobIds->size()
+             << " blobs for " << getLogPath();
+
+  folly::via(
+      getMount()->getServerBulkThreadPool().get(),
+      [lease = std::move(*prefetchLease), blobIds]() mutable {
+        auto& context = lease.getContext();
+        return lease.getTreeInode()
+            ->getStore()
+            ->prefetchBlobs(*blobIds, context)
+            .thenTry([lease = std::move(lease), blobIds](auto&&) {
+              XLOG(DBG4) << "finished sibling blob prefetch for "
+                         << lease.getTreeInode()->getLogPath();
+            });
+      });
+}
+
 folly::Future<struct stat> TreeInode::setattr(
     const DesiredMetadata& desired,
     ObjectFetchContext& /*fetchContext*/) {
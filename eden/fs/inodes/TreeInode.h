@@ -8,12 +8,14 @@
 #pragma once
 #include <folly/File.h>
 #include <folly/Portability.h>
+#include <folly/SharedMutex.h>
 #include <folly/Synchronized.h>
 #include <optional>
 #include "eden/fs/fuse/Invalidation.h"
 #include "eden/fs/inodes/CheckoutAction.h"
 #include "eden/fs/inodes/DirEntry.h"
 #include "eden/fs/inodes/InodeBase.h"
+#include "eden/fs/telemetry/LockProfiling.h"
 
 namespace facebook {
 namespace eden {
@@ -66,6 +68,13 @@ struct TreeInodeState {
   std::optional<ObjectId> treeHash;
 };
 
+using TreeInodeStateMutex = ProfiledSharedMutex<
+    folly::SharedMutex,
+    &LockThreadStats::treeInodeContentsWait,
+    &LockThreadStats::treeInodeContentsHold>;
+using SynchronizedTreeInodeState =
+    folly::Synchronized<TreeInodeState, TreeInodeStateMutex>;
+
 /**
  * Represents a directory in the file system.
  */
@@ -169,12 +178,24 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
    */
   std::tuple<NfsDirList, bool>
   nfsReaddir(NfsDirList&& list, off_t off, ObjectFetchContext& context);
+
+  /**
+   * Fetch the metadata of the unloaded files among the named children with
+   * one batched lookup.
+   *
+   * NFS readdirplus replies with the attributes of every listed entry. Calling
+   * this before stat()ing them makes each stat() wait for this lookup instead
+   * of issuing its own.
+   */
+  ImmediateFuture<folly::Unit> prefetchChildBlobMetadata(
+      const std::vector<PathComponent>& names,
+      ObjectFetchContext& context);
 #endif
 
-  const folly::Synchronized<TreeInodeState>& getContents() const {
+  const SynchronizedTreeInodeState& getContents() const {
     return contents_;
   }
-  folly::Synchronized<TreeInodeState>& getContents() {
+  SynchronizedTreeInodeState& getContents() {
     return contents_;
   }
 
@@ -512,6 +533,13 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
 
   void prefetch(ObjectFetchContext& context);
 
+  /**
+   * Called by a child FileInode whose read() had to fetch its blob. After
+   * store:sibling-blob-prefetch-threshold such reads, prefetches the blobs
+   * of the other files in this directory in the background.
+   */
+  void childBlobReadCold(ObjectFetchContext& context);
+
   /**
    * Get a TreeInodePtr to ourself.
    *
@@ -540,7 +568,7 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
    * This is used by create(), symlink(), and mknod().
    */
   FileInodePtr createImpl(
-      folly::Synchronized<TreeInodeState>::LockedPtr contentsLock,
+      SynchronizedTreeInodeState::LockedPtr contentsLock,
       PathComponentPiece name,
       mode_t mode,
       folly::ByteRange fileContents,
@@ -604,6 +632,20 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
       InodePtrType child,
       InvalidationRequired invalidate);
 
+  /**
+   * Fast path of removeRecursively() for a large directory none of whose
+   * children are loaded or known to the kernel: unlink it with all its
+   * contents at once, recording a single journal entry, and leave the removal
+   * of the overlay data of its subtree to the overlay GC thread.
+   *
+   * Returns false without changing anything when the fast path doesn't
+   * apply, in which case the directory must be removed entry by entry.
+   */
+  FOLLY_NODISCARD bool tryRemoveUnloadedTree(
+      PathComponentPiece name,
+      const TreeInodePtr& child,
+      InvalidationRequired invalidate);
+
   /**
    * checkPreRemove() is called by tryRemoveChild() for file or directory
    * specific checks before unlinking an entry.  Returns an errno value or 0.
@@ -611,6 +653,16 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
   FOLLY_NODISCARD static int checkPreRemove(const TreeInodePtr& child);
   FOLLY_NODISCARD static int checkPreRemove(const FileInodePtr& child);
 
+  /**
+   * Wait on the load of a child inode that another caller started. Should
+   * everyone else waiting on it give up, and so cancel it, while this caller
+   * still wants the child, the child is loaded again.
+   */
+  ImmediateFuture<InodePtr> waitForChildLoad(
+      folly::SemiFuture<InodePtr> load,
+      PathComponentPiece name,
+      ObjectFetchContext& context);
+
   /**
    * This helper function starts loading a currently unloaded child inode.
    * It must be held with the contents_ lock held.  (The Dir argument is only
@@ -645,7 +697,7 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
    * diff once all .gitignore data is loaded.
    */
   FOLLY_NODISCARD folly::Future<folly::Unit> computeDiff(
-      folly::Synchronized<TreeInodeState>::LockedPtr contentsLock,
+      SynchronizedTreeInodeState::LockedPtr contentsLock,
       DiffContext* context,
       RelativePathPiece currentPath,
       std::shared_ptr<const Tree> tree,
@@ -736,12 +788,19 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
    */
   FOLLY_NODISCARD bool checkoutTryRemoveEmptyDir(CheckoutContext* ctx);
 
-  folly::Synchronized<TreeInodeState> contents_;
+  SynchronizedTreeInodeState contents_;
 
   /**
    * Only prefetch blob metadata on the first readdir() of a loaded inode.
    */
   std::atomic<bool> prefetched_{false};
+
+  /**
+   * Number of childBlobReadCold() calls, and whether they have triggered the
+   * sibling blob prefetch yet.
+   */
+  std::atomic<uint32_t> coldChildReads_{0};
+  std::atomic<bool> siblingBlobsPrefetched_{false};
 };
 
 /**
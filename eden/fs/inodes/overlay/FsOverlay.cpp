@@ -11,17 +11,23 @@
 
 #include <boost/filesystem.hpp>
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 
 #include <folly/Exception.h>
 #include <folly/File.h>
 #include <folly/FileUtil.h>
 #include <folly/Range.h>
+#include <folly/String.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 #include <folly/lang/ToAscii.h>
 #include <folly/logging/xlog.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
+#ifdef __linux__
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
 
 #include "eden/fs/service/gen-cpp2/eden_types.h"
 #include "eden/fs/utils/EdenError.h"
@@ -55,6 +61,8 @@ constexpr const char* kNextInodeNumberFile{"next-inode-number"};
 constexpr StringPiece kInfoHeaderMagic{"\xed\xe0\x00\x01"};
 
 constexpr folly::StringPiece FsOverlay::kMetadataFile;
+constexpr folly::StringPiece FsOverlay::kBlobPoolDir;
+constexpr folly::StringPiece FsOverlay::kBlobPoolUsersDir;
 
 /**
  * A version number for the overlay directory format.
@@ -137,6 +145,7 @@ std::optional<InodeNumber> FsOverlay::initOverlay(bool createIfNonExisting) {
   if (overlayCreated) {
     return InodeNumber{kRootNodeId.get() + 1};
   }
+  prunePool();
   return tryLoadNextInodeNumber();
 }
 
@@ -465,6 +474,16 @@ folly::File FsOverlay::createOverlayFileImpl(
     InodeNumber inodeNumber,
     iovec* iov,
     size_t iovCount) {
+  size_t totalSize = 0;
+  for (size_t i = 0; i < iovCount; ++i) {
+    totalSize += iov[i].iov_len;
+  }
+  if (totalSize <= kInPlaceCreateLimit && inodeNumber != kRootNodeId) {
+    if (auto file = tryCreateOverlayFileInPlace(inodeNumber, iov, iovCount)) {
+      return std::move(*file);
+    }
+  }
+
   // We do not use mkstemp() to create the temporary file, since there is no
   // mkstempat() equivalent that can create files relative to dirFile.  We
   // simply create the file with a fixed suffix, and do not use O_EXCL.  This
@@ -547,6 +566,47 @@ folly::File FsOverlay::createOverlayFileImpl(
   return file;
 }
 
+std::optional<folly::File> FsOverlay::tryCreateOverlayFileInPlace(
+    InodeNumber inodeNumber,
+    iovec* iov,
+    size_t iovCount) {
+  // Most materialized files of a build are new and tiny, so the temporary
+  // file and rename cost as much as the write itself. A write this small is
+  // done by a single writev() call, which a crash of the process can't split,
+  // so the file is complete unless the kernel or the machine dies, which we
+  // don't claim to handle anyway. The OverlayChecker reports such a file as
+  // too short for its header, just like a truncated one.
+  auto path = getFilePath(inodeNumber);
+  auto fd = openat(
+      dirFile_.fd(),
+      path.c_str(),
+      O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC | O_NOFOLLOW,
+      0600);
+  if (fd == -1 && errno == EEXIST) {
+    // Replace the old file atomically through a temporary file instead.
+    return std::nullopt;
+  }
+  folly::checkUnixError(
+      fd,
+      "failed to create overlay file for inode ",
+      inodeNumber,
+      " in ",
+      localDir_);
+  folly::File file{fd, /* ownsFd */ true};
+  auto sizeWritten = folly::writevFull(fd, iov, iovCount);
+  if (sizeWritten == -1) {
+    auto err = errno;
+    unlinkat(dirFile_.fd(), path.c_str(), 0);
+    folly::throwSystemErrorExplicit(
+        err,
+        "error writing to overlay file for inode ",
+        inodeNumber,
+        " in ",
+        localDir_);
+  }
+  return file;
+}
+
 folly::File FsOverlay::createOverlayFile(
     InodeNumber inodeNumber,
     ByteRange contents) {
@@ -582,6 +642,188 @@ folly::File FsOverlay::createOverlayFile(
   return createOverlayFileImpl(inodeNumber, iov.data(), iov.size());
 }
 
+folly::File FsOverlay::createPooledOverlayFile(
+    InodeNumber inodeNumber,
+    const Hash20& contentsSha1,
+    const IOBuf& contents) {
+#ifdef FICLONE
+  if (cloneUnsupported_.load(std::memory_order_relaxed)) {
+    return createOverlayFile(inodeNumber, contents);
+  }
+
+  auto poolFile = openPoolFile(contentsSha1, contents);
+
+  auto path = getFilePath(inodeNumber);
+  auto tmpPath = getFileTmpPath(inodeNumber);
+  auto tmpFD = openat(
+      dirFile_.fd(),
+      tmpPath.data(),
+      O_CREAT | O_RDWR | O_CLOEXEC | O_NOFOLLOW | O_TRUNC,
+      0600);
+  folly::checkUnixError(
+      tmpFD,
+      "failed to create temporary overlay file for inode ",
+      inodeNumber,
+      " in ",
+      localDir_);
+  File file{tmpFD, /* ownsFd */ true};
+  bool success = false;
+  SCOPE_EXIT {
+    if (!success) {
+      unlinkat(dirFile_.fd(), tmpPath.data(), 0);
+    }
+  };
+
+  if (ioctl(tmpFD, FICLONE, poolFile.fd()) == -1) {
+    auto err = errno;
+    if (err != EOPNOTSUPP && err != EXDEV && err != EINVAL && err != ENOTTY) {
+      folly::throwSystemErrorExplicit(
+          err,
+          "error cloning overlay file for inode ",
+          inodeNumber,
+          " in ",
+          localDir_);
+    }
+    XLOG(DBG2) << "overlay in " << localDir_
+               << " can't clone files: " << folly::errnoStr(err);
+    cloneUnsupported_.store(true, std::memory_order_relaxed);
+    return createOverlayFile(inodeNumber, contents);
+  }
+
+  auto returnCode =
+      renameat(dirFile_.fd(), tmpPath.data(), dirFile_.fd(), path.c_str());
+  folly::checkUnixError(
+      returnCode,
+      "error committing overlay file for inode ",
+      inodeNumber,
+      " in ",
+      localDir_);
+  success = true;
+
+  // Losing track of a user only lets prunePool() remove the pooled file
+  // early, which is fine, so failures here aren't fatal.
+  auto poolPath = folly::to<string>(kBlobPoolDir, "/", contentsSha1.toString());
+  auto userPath = folly::to<string>(kBlobPoolUsersDir, "/", inodeNumber);
+  poolHasUsers_.store(true, std::memory_order_relaxed);
+  unlinkat(dirFile_.fd(), userPath.c_str(), 0);
+  returnCode = linkat(
+      dirFile_.fd(), poolPath.c_str(), dirFile_.fd(), userPath.c_str(), 0);
+  if (returnCode == -1 && errno == ENOENT) {
+    mkdirat(dirFile_.fd(), kBlobPoolUsersDir.str().c_str(), 0700);
+    returnCode = linkat(
+        dirFile_.fd(), poolPath.c_str(), dirFile_.fd(), userPath.c_str(), 0);
+  }
+  if (returnCode == -1) {
+    XLOG(WARN) << "failed to record use of pooled overlay file " << poolPath
+               << " by inode " << inodeNumber << ": " << folly::errnoStr(errno);
+  }
+
+  return file;
+#else
+  (void)contentsSha1;
+  return createOverlayFile(inodeNumber, contents);
+#endif
+}
+
+File FsOverlay::openPoolFile(
+    const Hash20& contentsSha1,
+    const IOBuf& contents) {
+  auto poolPath = folly::to<string>(kBlobPoolDir, "/", contentsSha1.toString());
+  auto fd = openat(
+      dirFile_.fd(), poolPath.c_str(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+  if (fd != -1) {
+    return File{fd, /* ownsFd */ true};
+  }
+  if (errno != ENOENT) {
+    folly::throwSystemError("failed to open pooled overlay file ", poolPath);
+  }
+
+  // Overlays created before the pool existed don't have its directory.
+  if (mkdirat(dirFile_.fd(), kBlobPoolDir.str().c_str(), 0700) == -1 &&
+      errno != EEXIST) {
+    folly::throwSystemError(
+        "failed to create overlay blob pool directory in ", localDir_);
+  }
+
+  // Concurrent materializations of the same contents may race to add the
+  // file, so each writes its own temporary file and the last rename wins.
+  // Both copies are complete, so whichever a clone sees is fine.
+  static std::atomic<uint64_t> tmpCounter{0};
+  auto tmpPath = folly::to<string>(
+      poolPath, ".tmp", tmpCounter.fetch_add(1, std::memory_order_relaxed));
+  fd = openat(
+      dirFile_.fd(),
+      tmpPath.c_str(),
+      O_CREAT | O_RDWR | O_CLOEXEC | O_NOFOLLOW | O_TRUNC,
+      0600);
+  folly::checkUnixError(fd, "failed to create pooled overlay file ", tmpPath);
+  File file{fd, /* ownsFd */ true};
+  bool success = false;
+  SCOPE_EXIT {
+    if (!success) {
+      unlinkat(dirFile_.fd(), tmpPath.c_str(), 0);
+    }
+  };
+
+  auto header = createHeader(kHeaderIdentifierFile, kHeaderVersion);
+  fbvector<struct iovec> iov;
+  iov.resize(1);
+  iov[0].iov_base = header.data();
+  iov[0].iov_len = header.size();
+  contents.appendToIov(&iov);
+  auto sizeWritten = folly::writevFull(fd, iov.data(), iov.size());
+  folly::checkUnixError(
+      sizeWritten, "error writing pooled overlay file ", tmpPath);
+
+  auto returnCode = renameat(
+      dirFile_.fd(), tmpPath.c_str(), dirFile_.fd(), poolPath.c_str());
+  folly::checkUnixError(
+      returnCode, "error committing pooled overlay file ", poolPath);
+  success = true;
+
+  return file;
+}
+
+void FsOverlay::prunePool() {
+  auto poolDir = localDir_ + PathComponentPiece{kBlobPoolDir};
+  boost::system::error_code error;
+  auto iterator =
+      boost::filesystem::directory_iterator(poolDir.asString(), error);
+  if (error) {
+    // Overlays that never pooled a file don't have the directory.
+    return;
+  }
+  poolHasUsers_.store(
+      boost::filesystem::exists(
+          (localDir_ + RelativePathPiece{kBlobPoolUsersDir}).asString(),
+          error),
+      std::memory_order_relaxed);
+
+  size_t removed = 0;
+  for (const auto& entry : iterator) {
+    if (entry.status(error).type() != boost::filesystem::regular_file) {
+      continue;
+    }
+    // Nothing else uses the overlay yet, so the temporary files are stale.
+    bool stale = entry.path().filename().string().find(".tmp") !=
+        std::string::npos;
+    if (!stale && boost::filesystem::hard_link_count(entry.path(), error) > 1) {
+      continue;
+    }
+    if (error) {
+      continue;
+    }
+    if (boost::filesystem::remove(entry.path(), error)) {
+      ++removed;
+    } else {
+      XLOG(WARN) << "failed to remove pooled overlay file " << entry.path()
+                 << ": " << error.message();
+    }
+  }
+  XLOG_IF(DBG2, removed) << "removed " << removed
+                         << " unused pooled overlay files from " << poolDir;
+}
+
 void FsOverlay::validateHeader(
     InodeNumber inodeNumber,
     folly::StringPiece contents,
@@ -625,6 +867,16 @@ void FsOverlay::validateHeader(
 }
 
 void FsOverlay::removeOverlayData(InodeNumber inodeNumber) {
+  if (poolHasUsers_.load(std::memory_order_relaxed)) {
+    // Removed first, so that a crash can only leave the pooled file unused.
+    auto userPath = folly::to<string>(kBlobPoolUsersDir, "/", inodeNumber);
+    if (unlinkat(dirFile_.fd(), userPath.c_str(), 0) == -1 &&
+        errno != ENOENT) {
+      folly::throwSystemError(
+          "error unlinking pooled overlay file user ", userPath);
+    }
+  }
+
   auto path = getFilePath(inodeNumber);
   int result = ::unlinkat(dirFile_.fd(), path.c_str(), 0);
   if (result == 0) {
@@ -11,6 +11,7 @@
 #include <folly/Range.h>
 #include <gtest/gtest_prod.h>
 #include <array>
+#include <atomic>
 #include <condition_variable>
 #include <optional>
 #include "eden/fs/inodes/IOverlay.h"
@@ -156,6 +157,17 @@ class FsOverlay : public IOverlay {
       InodeNumber inodeNumber,
       const folly::IOBuf& contents) override;
 
+  /**
+   * Write an overlay file for a FileInode by reflinking (FICLONE) a copy of
+   * the same contents kept in kBlobPoolDir, adding that copy first if it
+   * doesn't exist. Falls back to copying the contents where the filesystem
+   * can't clone files.
+   */
+  folly::File createPooledOverlayFile(
+      InodeNumber inodeNumber,
+      const Hash20& contentsSha1,
+      const folly::IOBuf& contents) override;
+
   /**
    * Remove the overlay data associated with the passed InodeNumber.
    */
@@ -198,6 +210,24 @@ class FsOverlay : public IOverlay {
 
   static constexpr folly::StringPiece kMetadataFile{"metadata.table"};
 
+  /**
+   * Directory of complete overlay files named by the SHA-1 of their
+   * contents, see createPooledOverlayFile(). Its files are never opened as
+   * inodes and may be deleted at any time.
+   *
+   * Its kBlobPoolUsersDir subdirectory has a hard link to the pooled file
+   * each inode was cloned from, named by the inode number, so that a pooled
+   * file nobody was cloned from anymore has a single link.
+   */
+  static constexpr folly::StringPiece kBlobPoolDir{"blob-pool"};
+  static constexpr folly::StringPiece kBlobPoolUsersDir{"blob-pool/users"};
+
+  /**
+   * Remove the pooled files that no inode uses anymore, and the temporary
+   * files left behind by a crash. Done by initOverlay().
+   */
+  void prunePool();
+
   /**
    * Constants for an header in overlay file.
    */
@@ -205,6 +235,12 @@ class FsOverlay : public IOverlay {
   static constexpr folly::StringPiece kHeaderIdentifierFile{"OVFL"};
   static constexpr uint32_t kHeaderVersion = 1;
   static constexpr size_t kHeaderLength = 64;
+
+  /**
+   * New overlay files up to this size, header included, are written directly
+   * at their final path rather than through a temporary file.
+   */
+  static constexpr size_t kInPlaceCreateLimit = 4096;
   static constexpr uint32_t kNumShards = 256;
   static constexpr size_t kShardDirPathLength = 2;
 
@@ -238,6 +274,23 @@ class FsOverlay : public IOverlay {
   folly::File
   createOverlayFileImpl(InodeNumber inodeNumber, iovec* iov, size_t iovCount);
 
+  /**
+   * Create a small overlay file in place, see kInPlaceCreateLimit. Returns
+   * std::nullopt if a file already exists at its path.
+   */
+  std::optional<folly::File> tryCreateOverlayFileInPlace(
+      InodeNumber inodeNumber,
+      iovec* iov,
+      size_t iovCount);
+
+  /**
+   * Open the pooled overlay file with the given contents, creating it if
+   * needed.
+   */
+  folly::File openPoolFile(
+      const Hash20& contentsSha1,
+      const folly::IOBuf& contents);
+
  private:
   /** Path to ".eden/CLIENT/local" */
   const AbsolutePath localDir_;
@@ -257,6 +310,18 @@ class FsOverlay : public IOverlay {
    * We maintain this so we can use openat(), unlinkat(), etc.
    */
   folly::File dirFile_;
+
+  /**
+   * Set once cloning a pooled file failed because the filesystem doesn't
+   * support it, after which createPooledOverlayFile() just copies.
+   */
+  std::atomic<bool> cloneUnsupported_{false};
+
+  /**
+   * Set once kBlobPoolUsersDir may have links, after which
+   * removeOverlayData() removes the inode's link too.
+   */
+  std::atomic<bool> poolHasUsers_{false};
 };
 
 class InodePath {
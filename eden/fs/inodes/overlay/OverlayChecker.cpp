@@ -9,8 +9,11 @@
 
 #include "eden/fs/inodes/overlay/OverlayChecker.h"
 
+#include <algorithm>
+#include <atomic>
 #include <boost/filesystem.hpp>
 #include <fcntl.h>
+#include <thread>
 #include <time.h>
 #include <unistd.h>
 
@@ -18,8 +21,10 @@
 #include <folly/ExceptionWrapper.h>
 #include <folly/File.h>
 #include <folly/FileUtil.h>
+#include <folly/ScopeGuard.h>
 #include <folly/String.h>
 #include <folly/logging/xlog.h>
+#include <folly/synchronization/Baton.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 
 #include "eden/fs/inodes/overlay/FsOverlay.h"
@@ -38,6 +43,11 @@ using std::chrono::seconds;
 namespace facebook {
 namespace eden {
 
+namespace {
+// Upper bound on the threads used to read the overlay shards in readInodes().
+constexpr size_t kMaxScanThreads = 8;
+} // namespace
+
 class OverlayChecker::RepairState {
  public:
   explicit RepairState(OverlayChecker* checker)
@@ -857,11 +867,52 @@ PathComponent OverlayChecker::findChildName(
 }
 
 void OverlayChecker::readInodes(const ProgressCallback& progressCallback) {
-  // Walk through all of the sharded subdirectories
+  // Walk through all of the sharded subdirectories. Reading and parsing the
+  // inode files dominates, so the shards are scanned by several threads,
+  // while this one merges their results in order.
+  std::vector<ShardScan> scans(FsOverlay::kNumShards);
+  std::vector<folly::Baton<>> scanned(FsOverlay::kNumShards);
+  std::atomic<uint32_t> nextShard{0};
+  auto scanShards = [&] {
+    std::array<char, 2> subdirBuffer;
+    MutableStringPiece subdir{subdirBuffer.data(), subdirBuffer.size()};
+    for (;;) {
+      auto shardID = nextShard.fetch_add(1, std::memory_order_relaxed);
+      if (shardID >= FsOverlay::kNumShards) {
+        return;
+      }
+      FsOverlay::formatSubdirShardPath(shardID, subdir);
+      auto subdirPath = fs_->getLocalDir() + PathComponentPiece{subdir};
+      readInodeSubdir(subdirPath, shardID, scans[shardID]);
+      scanned[shardID].post();
+    }
+  };
+  auto threadCount = std::clamp<size_t>(
+      std::thread::hardware_concurrency(), 1, kMaxScanThreads);
+  std::vector<std::thread> threads;
+  threads.reserve(threadCount);
+  SCOPE_EXIT {
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  };
+  for (size_t i = 0; i < threadCount; ++i) {
+    threads.emplace_back(scanShards);
+  }
+
   uint32_t progress10pct = 0;
-  std::array<char, 2> subdirBuffer;
-  MutableStringPiece subdir{subdirBuffer.data(), subdirBuffer.size()};
   for (uint32_t shardID = 0; shardID < FsOverlay::kNumShards; ++shardID) {
+    scanned[shardID].wait();
+    auto& scan = scans[shardID];
+    for (auto& [number, info] : scan.inodes) {
+      inodes_.emplace(number, std::move(info));
+    }
+    for (auto& error : scan.errors) {
+      addError(std::move(error));
+    }
+    updateMaxInodeNumber(InodeNumber{scan.maxInodeNumber});
+    scan = ShardScan{};
+
     // Log a INFO message every 10% done
     uint32_t progress = (10 * shardID) / FsOverlay::kNumShards;
     if (progress > progress10pct) {
@@ -872,10 +923,6 @@ void OverlayChecker::readInodes(const ProgressCallback& progressCallback) {
       }
       progress10pct = progress;
     }
-    FsOverlay::formatSubdirShardPath(shardID, subdir);
-    auto subdirPath = fs_->getLocalDir() + PathComponentPiece{subdir};
-
-    readInodeSubdir(subdirPath, shardID);
   }
   if (auto callback = progressCallback) {
     callback(10);
@@ -886,14 +933,15 @@ void OverlayChecker::readInodes(const ProgressCallback& progressCallback) {
 
 void OverlayChecker::readInodeSubdir(
     const AbsolutePath& path,
-    ShardID shardID) {
+    ShardID shardID,
+    ShardScan& scan) {
   XLOG(DBG5) << "fsck:" << fs_->getLocalDir() << ": scanning " << path;
 
   boost::system::error_code error;
   auto boostPath = boost::filesystem::path{path.value().c_str()};
   auto iterator = boost::filesystem::directory_iterator(boostPath, error);
   if (error.value() != 0) {
-    addError<ShardDirectoryEnumerationError>(path, error);
+    scan.addError<ShardDirectoryEnumerationError>(path, error);
     return;
   }
 
@@ -904,37 +952,42 @@ void OverlayChecker::readInodeSubdir(
     auto entryInodeNumber =
         folly::tryTo<uint64_t>(inodePath.basename().value());
     if (entryInodeNumber.hasValue()) {
-      loadInode(InodeNumber(*entryInodeNumber), shardID);
+      loadInode(InodeNumber(*entryInodeNumber), shardID, scan);
     } else {
-      addError<UnexpectedOverlayFile>(inodePath);
+      scan.addError<UnexpectedOverlayFile>(inodePath);
     }
 
     iterator.increment(error);
     if (error.value() != 0) {
-      addError<ShardDirectoryEnumerationError>(path, error);
+      scan.addError<ShardDirectoryEnumerationError>(path, error);
       break;
     }
   }
 }
 
-void OverlayChecker::loadInode(InodeNumber number, ShardID shardID) {
+void OverlayChecker::loadInode(
+    InodeNumber number,
+    ShardID shardID,
+    ShardScan& scan) {
   XLOG(DBG9) << "fsck: loading inode " << number;
-  updateMaxInodeNumber(number);
+  scan.maxInodeNumber = std::max(scan.maxInodeNumber, number.get());
 
   // Verify that we found this inode in the correct shard subdirectory.
   // Ignore the data if it is in the wrong directory.
   ShardID expectedShard = static_cast<ShardID>(number.get() & 0xff);
   if (expectedShard != shardID) {
-    addError<UnexpectedInodeShard>(number, shardID);
+    scan.addError<UnexpectedInodeShard>(number, shardID);
     return;
   }
 
-  inodes_.emplace(number, loadInodeInfo(number));
+  scan.inodes.emplace_back(number, loadInodeInfo(number, scan));
 }
 
-OverlayChecker::InodeInfo OverlayChecker::loadInodeInfo(InodeNumber number) {
-  auto inodeError = [this, number](auto&&... args) {
-    addError<InodeDataError>(number, args...);
+OverlayChecker::InodeInfo OverlayChecker::loadInodeInfo(
+    InodeNumber number,
+    ShardScan& scan) {
+  auto inodeError = [&scan, number](auto&&... args) {
+    scan.addError<InodeDataError>(number, args...);
     return InodeInfo(number, InodeType::Error);
   };
 
@@ -187,10 +187,30 @@ class OverlayChecker {
   PathInfo cachedPathComputation(InodeNumber number, Fn&& fn);
 
   using ShardID = uint32_t;
+
+  /**
+   * What the scan of one shard subdirectory found. Shards are scanned
+   * concurrently, and their results are then merged in shard order.
+   */
+  struct ShardScan {
+    template <typename ErrorType, typename... Args>
+    void addError(Args&&... args) {
+      errors.push_back(
+          std::make_unique<ErrorType>(std::forward<Args>(args)...));
+    }
+
+    std::vector<std::pair<InodeNumber, InodeInfo>> inodes;
+    std::vector<std::unique_ptr<Error>> errors;
+    uint64_t maxInodeNumber{0};
+  };
+
   void readInodes(const ProgressCallback& progressCallback = [](auto) {});
-  void readInodeSubdir(const AbsolutePath& path, ShardID shardID);
-  void loadInode(InodeNumber number, ShardID shardID);
-  InodeInfo loadInodeInfo(InodeNumber number);
+  void readInodeSubdir(
+      const AbsolutePath& path,
+      ShardID shardID,
+      ShardScan& scan);
+  void loadInode(InodeNumber number, ShardID shardID, ShardScan& scan);
+  InodeInfo loadInodeInfo(InodeNumber number, ShardScan& scan);
   overlay::OverlayDir loadDirectoryChildren(folly::File& file);
 
   void linkInodeChildren();
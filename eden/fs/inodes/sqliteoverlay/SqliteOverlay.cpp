@@ -293,6 +293,13 @@ folly::File SqliteOverlay::createOverlayFile(
   EDEN_BUG() << "UNIMPLEMENTED";
 }
 
+folly::File SqliteOverlay::createPooledOverlayFile(
+    InodeNumber /*inodeNumber*/,
+    const Hash20& /*contentsSha1*/,
+    const folly::IOBuf& /*contents*/) {
+  EDEN_BUG() << "UNIMPLEMENTED";
+}
+
 folly::File SqliteOverlay::openFile(
     InodeNumber /*inodeNumber*/,
     folly::StringPiece /*headerId*/) {
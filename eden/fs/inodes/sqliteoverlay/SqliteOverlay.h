@@ -99,6 +99,11 @@ class SqliteOverlay : public IOverlay {
       InodeNumber inodeNumber,
       const folly::IOBuf& contents) override;
 
+  folly::File createPooledOverlayFile(
+      InodeNumber inodeNumber,
+      const Hash20& contentsSha1,
+      const folly::IOBuf& contents) override;
+
   folly::File openFile(InodeNumber inodeNumber, folly::StringPiece headerId)
       override;
 
@@ -900,6 +900,52 @@ TEST(Checkout, removeSubdirectorySimple) {
   }
 }
 
+TEST(Checkout, modifyUnloadedSubdirectoryDoesNotLoadIt) {
+  auto builder1 = FakeTreeBuilder();
+  builder1.setFile("src/main.c", "int main() { return 0; }\n");
+  builder1.setFile("src/lib/a.c", "a\n");
+  builder1.setFile("src/lib/b.c", "b\n");
+  builder1.setFile("src/lib/sub/c.c", "c\n");
+  TestMount testMount{builder1};
+
+  auto builder2 = builder1.clone();
+  builder2.replaceFile("src/lib/b.c", "new b\n");
+  builder2.setFile("src/lib/sub/d.c", "d\n");
+  builder2.finalize(testMount.getBackingStore(), true);
+  auto commit2 = testMount.getBackingStore()->putCommit("2", builder2);
+  commit2->setReady();
+
+  // Only load the parent of the directory that changes.
+  auto srcTree = testMount.getTreeInode("src"_relpath);
+  auto oldNumber = srcTree->getContents()
+                       .rlock()
+                       ->entries.find("lib"_pc)
+                       ->second.getInodeNumber();
+
+  auto executor = testMount.getServerExecutor().get();
+  auto checkoutResult = testMount.getEdenMount()
+                            ->checkout(RootId("2"), std::nullopt, __func__)
+                            .waitVia(executor);
+  ASSERT_TRUE(checkoutResult.isReady());
+  EXPECT_EQ(0, std::move(checkoutResult).get().conflicts.size());
+
+  {
+    auto contents = srcTree->getContents().rlock();
+    auto& entry = contents->entries.find("lib"_pc)->second;
+    EXPECT_FALSE(entry.getInodePtr());
+    EXPECT_FALSE(entry.isMaterialized());
+    EXPECT_NE(oldNumber, entry.getInodeNumber());
+    EXPECT_EQ(
+        builder2.getStoredTree("src/lib"_relpath)->get().getHash(),
+        entry.getHash());
+  }
+
+  EXPECT_FILE_INODE(
+      testMount.getFileInode("src/lib/b.c"_relpath), "new b\n", 0644);
+  EXPECT_FILE_INODE(
+      testMount.getFileInode("src/lib/sub/d.c"_relpath), "d\n", 0644);
+}
+
 TEST(Checkout, checkoutModifiesDirectoryDuringLoad) {
   auto builder1 = FakeTreeBuilder{};
   builder1.setFile("dir/sub/file.txt", "contents");
@@ -1452,6 +1498,90 @@ TEST(Checkout, testSetPathObjectIdCheckoutMultipleFiles) {
   EXPECT_FILE_INODE(testMount.getFileInode(path2), contents2, 0644);
 }
 
+TEST(Checkout, testSetPathObjectIds) {
+  auto builder1 = FakeTreeBuilder{};
+  builder1.setFile("dir/file.txt", "contents");
+  TestMount testMount{builder1};
+
+  auto builder2 = FakeTreeBuilder{};
+  builder2.setFile("subdir/tree.txt", "tree contents");
+  builder2.finalize(testMount.getBackingStore(), true);
+  testMount.getBackingStore()->putCommit("2", builder2)->setReady();
+  testMount.getBackingStore()->putBlob(ObjectId{"3"}, "blob")->setReady();
+  testMount.getBackingStore()->putBlob(ObjectId{"4"}, "blob2")->setReady();
+
+  std::vector<PathObjectGraftRequest> objects;
+  objects.push_back(PathObjectGraftRequest{
+      RelativePath{"dir/a"},
+      RootId{"2"},
+      facebook::eden::ObjectType::TREE});
+  objects.push_back(PathObjectGraftRequest{
+      RelativePath{"dir/b"},
+      RootId{"2"},
+      facebook::eden::ObjectType::TREE});
+  // Both blobs are grafted by the same checkout of dir.
+  objects.push_back(PathObjectGraftRequest{
+      RelativePath{"dir/blob.txt"},
+      RootId{"3"},
+      facebook::eden::ObjectType::REGULAR_FILE});
+  objects.push_back(PathObjectGraftRequest{
+      RelativePath{"dir/blob2.txt"},
+      RootId{"4"},
+      facebook::eden::ObjectType::REGULAR_FILE});
+
+  auto executor = testMount.getServerExecutor().get();
+  auto result = testMount.getEdenMount()
+                    ->setPathObjectIds(
+                        std::move(objects),
+                        facebook::eden::CheckoutMode::NORMAL,
+                        ObjectFetchContext::getNullContext())
+                    .waitVia(executor)
+                    .get();
+  EXPECT_EQ(0, result.result.conflicts_ref()->size());
+
+  EXPECT_FILE_INODE(
+      testMount.getFileInode("dir/a/subdir/tree.txt"_relpath),
+      "tree contents",
+      0644);
+  EXPECT_FILE_INODE(
+      testMount.getFileInode("dir/b/subdir/tree.txt"_relpath),
+      "tree contents",
+      0644);
+  EXPECT_FILE_INODE(
+      testMount.getFileInode("dir/blob.txt"_relpath), "blob", 0644);
+  EXPECT_FILE_INODE(
+      testMount.getFileInode("dir/blob2.txt"_relpath), "blob2", 0644);
+  // Entries that weren't grafted are left alone.
+  EXPECT_FILE_INODE(
+      testMount.getFileInode("dir/file.txt"_relpath), "contents", 0644);
+}
+
+TEST(Checkout, testSetPathObjectIdsOverlappingPaths) {
+  auto builder1 = FakeTreeBuilder{};
+  builder1.setFile("dir/file.txt", "contents");
+  TestMount testMount{builder1};
+
+  std::vector<PathObjectGraftRequest> objects;
+  objects.push_back(PathObjectGraftRequest{
+      RelativePath{"dir"}, RootId{"2"}, facebook::eden::ObjectType::TREE});
+  objects.push_back(PathObjectGraftRequest{
+      RelativePath{"dir/sub/blob.txt"},
+      RootId{"3"},
+      facebook::eden::ObjectType::REGULAR_FILE});
+
+  auto executor = testMount.getServerExecutor().get();
+  EXPECT_THROW_RE(
+      testMount.getEdenMount()
+          ->setPathObjectIds(
+              std::move(objects),
+              facebook::eden::CheckoutMode::NORMAL,
+              ObjectFetchContext::getNullContext())
+          .waitVia(executor)
+          .get(),
+      EdenError,
+      "is inside another grafted path");
+}
+
 #endif
 
 template <typename Unloader>
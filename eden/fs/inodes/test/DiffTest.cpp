@@ -182,6 +182,49 @@ TEST(DiffTest, fileModified) {
           std::make_pair("src/1.txt", ScmFileStatus::MODIFIED)));
 }
 
+TEST(DiffTest, fileModifiedBelowLoadedDirectories) {
+  DiffTest test;
+  test.getMount().loadAllInodes();
+  test.checkNoChanges();
+
+  // The change has to be found through the clean, loaded siblings of every
+  // directory on its path.
+  test.getMount().overwriteFile("src/a/b/c/4.txt", "updated\n");
+  auto result = test.diff();
+  EXPECT_THAT(
+      *result.entries_ref(),
+      UnorderedElementsAre(
+          std::make_pair("src/a/b/c/4.txt", ScmFileStatus::MODIFIED)));
+}
+
+TEST(DiffTest, cachedStatusFollowsJournal) {
+  DiffTest test;
+  auto status = test.diffFuture();
+  EXPECT_THAT(
+      *EXPECT_FUTURE_RESULT(status).entries_ref(), UnorderedElementsAre());
+
+  // Repeating the diff with no changes in between can reuse the last result,
+  // but any change recorded in the journal must show up.
+  status = test.diffFuture();
+  EXPECT_THAT(
+      *EXPECT_FUTURE_RESULT(status).entries_ref(), UnorderedElementsAre());
+
+  test.getMount().overwriteFile("src/1.txt", "This file has been updated.\n");
+  status = test.diffFuture();
+  EXPECT_THAT(
+      *EXPECT_FUTURE_RESULT(status).entries_ref(),
+      UnorderedElementsAre(
+          std::make_pair("src/1.txt", ScmFileStatus::MODIFIED)));
+
+  test.getMount().addFile("src/new.txt", "new\n");
+  status = test.diffFuture();
+  EXPECT_THAT(
+      *EXPECT_FUTURE_RESULT(status).entries_ref(),
+      UnorderedElementsAre(
+          std::make_pair("src/1.txt", ScmFileStatus::MODIFIED),
+          std::make_pair("src/new.txt", ScmFileStatus::ADDED)));
+}
+
 #ifndef _WIN32
 TEST(DiffTest, fileModeChanged) {
   DiffTest test;
@@ -729,6 +729,47 @@ TEST(EdenMount, concurrentDeepEnsureDirectoryExists) {
   EXPECT_NE(nullptr, testMount.getTreeInode(dirPath));
 }
 
+#ifndef _WIN32
+TEST(EdenMount, prewarmDirectoriesSkipsMissingPathsAndFiles) {
+  auto builder = FakeTreeBuilder{};
+  builder.mkdir("a/b");
+  builder.setFile("a/file.txt", "");
+  TestMount testMount{builder};
+  auto edenMount = testMount.getEdenMount();
+  edenMount->getRootInode()->unloadChildrenNow();
+
+  auto loaded = edenMount
+                    ->prewarmDirectories(
+                        {RelativePath{"a/b"},
+                         RelativePath{"a/file.txt"},
+                         RelativePath{"missing"}})
+                    .get(0ms);
+  EXPECT_EQ(1, loaded);
+  EXPECT_NE(
+      nullptr,
+      edenMount->getInodeMap()->lookupLoadedTree(
+          testMount.getTreeInode("a/b")->getNodeId()));
+}
+
+TEST(EdenMount, getRecentlyAccessedDirectoriesReturnsLoadedDirectories) {
+  auto builder = FakeTreeBuilder{};
+  builder.mkdir("a/b");
+  builder.mkdir("c");
+  TestMount testMount{builder};
+  auto edenMount = testMount.getEdenMount();
+  edenMount->getRootInode()->unloadChildrenNow();
+  testMount.getTreeInode("a/b");
+
+  auto directories = edenMount->getRecentlyAccessedDirectories(100);
+  std::sort(directories.begin(), directories.end());
+  EXPECT_EQ(
+      (std::vector<RelativePath>{RelativePath{"a"}, RelativePath{"a/b"}}),
+      directories);
+
+  EXPECT_EQ(1, edenMount->getRecentlyAccessedDirectories(1).size());
+}
+#endif
+
 TEST(EdenMount, setOwnerChangesTakeEffect) {
   FakeTreeBuilder builder;
   builder.setFile("dir/file.txt", "contents");
@@ -394,6 +394,32 @@ TEST_F(FileInodeTest, truncatingMaterializesParent) {
   EXPECT_EQ(true, isInodeMaterialized(parent));
 }
 
+TEST_F(FileInodeTest, sha1OfMaterializedFile) {
+  auto& context = ObjectFetchContext::getNullContext();
+  mount_.addFile("dir/sha1_file", "");
+  auto inode = mount_.getFileInode("dir/sha1_file");
+
+  inode->write("hello", 0, context).get(0ms);
+  EXPECT_EQ(Hash20::sha1("hello"), inode->getSha1(context).get(0ms));
+
+  // Appends only hash the new data, which must give the same result.
+  inode->write(" world", 5, context).get(0ms);
+  EXPECT_EQ(Hash20::sha1("hello world"), inode->getSha1(context).get(0ms));
+
+  inode->write("J", 0, context).get(0ms);
+  EXPECT_EQ(Hash20::sha1("Jello world"), inode->getSha1(context).get(0ms));
+
+  inode.reset();
+  mount_.remount();
+  inode = mount_.getFileInode("dir/sha1_file");
+  EXPECT_EQ(Hash20::sha1("Jello world"), inode->getSha1(context).get(0ms));
+
+  DesiredMetadata desired;
+  desired.size = 5;
+  (void)inode->setattr(desired, context).get(0ms);
+  EXPECT_EQ(Hash20::sha1("Jello"), inode->getSha1(context).get(0ms));
+}
+
 #ifdef __linux__
 TEST_F(FileInodeTest, fallocate) {
   mount_.addFile("dir/fallocate_file", "");
@@ -635,6 +661,26 @@ TEST(FileInode, reloadsBlobIfCacheIsEvicted) {
       << "reading should insert hash " << hash << " into cache";
 }
 
+TEST(FileInode, readSharesBlobStorage) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"bigfile.txt", "1234567890ab"}});
+  TestMount mount{builder};
+  auto blobCache = mount.getBlobCache();
+
+  auto inode = mount.getFileInode("bigfile.txt");
+  auto hash = inode->getBlobHash().value();
+
+  auto [buf, eof] =
+      inode->read(4, 4, ObjectFetchContext::getNullContext()).get(0ms);
+  EXPECT_FALSE(eof);
+  EXPECT_EQ("5678", buf->cloneCoalescedAsValue().moveToFbString());
+
+  auto blob = blobCache->get(hash).object;
+  ASSERT_TRUE(blob);
+  ASSERT_FALSE(blob->getContents().isChained());
+  EXPECT_EQ(blob->getContents().data() + 4, buf->data());
+}
+
 // TODO: test multiple flags together
 // TODO: ensure ctime is updated after every call to setattr()
 // TODO: ensure mtime is updated after opening a file, writing to it, then
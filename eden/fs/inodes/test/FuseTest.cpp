@@ -10,6 +10,7 @@
 #include <chrono>
 #include "eden/fs/testharness/FakeFuse.h"
 #include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/FuseTraceReplayer.h"
 #include "eden/fs/testharness/TestMount.h"
 #include "eden/fs/utils/UnboundedQueueExecutor.h"
 
@@ -190,4 +191,60 @@ TEST(FuseTest, destroyWithInitRace) {
   }
 }
 
+TEST(FuseTest, replayRecordedRequests) {
+  auto builder = FakeTreeBuilder();
+  builder.setFile("src/main.c", "int main() { return 0; }\n");
+  TestMount testMount{builder};
+  auto fuse = make_shared<FakeFuse>();
+  testMount.startFuseAndWait(fuse);
+
+  auto record = [](FuseTraceEvent::Type type,
+                   uint64_t unique,
+                   uint32_t opcode,
+                   uint64_t nodeid,
+                   std::string arguments = {},
+                   std::optional<int64_t> result = std::nullopt) {
+    FuseTraceRecord r;
+    r.type = type;
+    r.time = std::chrono::nanoseconds{0};
+    r.unique = unique;
+    r.nodeid = nodeid;
+    r.opcode = opcode;
+    r.pid = 0;
+    r.result = result;
+    r.arguments = std::move(arguments);
+    return r;
+  };
+  using Type = FuseTraceEvent::Type;
+  // The inode numbers of the recording differ from the ones of the mount.
+  std::vector<FuseTraceRecord> records{
+      record(Type::START, 1, FUSE_LOOKUP, FUSE_ROOT_ID, "src"),
+      record(Type::FINISH, 1, FUSE_LOOKUP, FUSE_ROOT_ID, {}, 100),
+      record(Type::START, 2, FUSE_LOOKUP, 100, "main.c"),
+      record(Type::START, 3, FUSE_LOOKUP, FUSE_ROOT_ID, "missing"),
+      record(Type::FINISH, 3, FUSE_LOOKUP, FUSE_ROOT_ID, {}, 0),
+      record(Type::FINISH, 2, FUSE_LOOKUP, 100, {}, 200),
+      record(Type::START, 4, FUSE_GETATTR, 200),
+      record(Type::START, 5, FUSE_READ, 200, "off=0, len=4096"),
+      record(Type::FINISH, 4, FUSE_GETATTR, 200, {}, 0),
+      record(Type::FINISH, 5, FUSE_READ, 200, {}, 0),
+      // Writes aren't replayed, and neither are requests about inodes that
+      // weren't looked up.
+      record(Type::START, 6, FUSE_WRITE, 200, "off=0, len=1"),
+      record(Type::FINISH, 6, FUSE_WRITE, 200, {}, 0),
+      record(Type::START, 7, FUSE_GETATTR, 300),
+      record(Type::FINISH, 7, FUSE_GETATTR, 300, {}, 0),
+  };
+
+  FuseTraceReplayer::Options options;
+  options.poll = [&] { testMount.drainServerExecutor(); };
+  options.timeout = kWaitTimeout;
+  auto result = FuseTraceReplayer{*fuse, options}.replay(records);
+
+  EXPECT_EQ(5, result.replayed);
+  EXPECT_EQ(2, result.skipped);
+  EXPECT_EQ(0, result.mismatched);
+  EXPECT_EQ(5, result.latencies.size());
+}
+
 #endif
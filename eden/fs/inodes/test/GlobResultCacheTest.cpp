@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/GlobResultCache.h"
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+std::shared_ptr<const GlobResultCache::Results> makeResults(
+    folly::StringPiece name) {
+  auto results = std::make_shared<GlobResultCache::Results>();
+  results->matches.push_back({RelativePath{name}, dtype_t::Regular});
+  return results;
+}
+
+std::string makeKey(folly::StringPiece rootId, std::vector<std::string> globs) {
+  return GlobResultCache::makeKey(
+      "/mnt", rootId, RelativePathPiece{}, globs, false, false);
+}
+} // namespace
+
+TEST(GlobResultCache, reuses_results_of_the_same_glob) {
+  GlobResultCache cache{10, 1min};
+  EXPECT_EQ(nullptr, cache.get(makeKey("abc", {"**/*.cpp"})));
+
+  cache.insert(makeKey("abc", {"**/*.cpp"}), makeResults("a.cpp"));
+  auto cached = cache.get(makeKey("abc", {"**/*.cpp"}));
+  ASSERT_NE(nullptr, cached);
+  ASSERT_EQ(1, cached->matches.size());
+  EXPECT_EQ(RelativePath{"a.cpp"}, cached->matches[0].name);
+
+  EXPECT_EQ(nullptr, cache.get(makeKey("def", {"**/*.cpp"})));
+  EXPECT_EQ(nullptr, cache.get(makeKey("abc", {"**/*.h"})));
+  EXPECT_EQ(nullptr, cache.get(makeKey("abc", {"**/*.cpp", "**/*.h"})));
+}
+
+TEST(GlobResultCache, key_depends_on_options) {
+  std::vector<std::string> globs{"*"};
+  auto key = GlobResultCache::makeKey(
+      "/mnt", "abc", RelativePathPiece{}, globs, false, false);
+  EXPECT_NE(
+      key,
+      GlobResultCache::makeKey(
+          "/mnt", "abc", RelativePathPiece{}, globs, true, false));
+  EXPECT_NE(
+      key,
+      GlobResultCache::makeKey(
+          "/mnt", "abc", RelativePathPiece{}, globs, false, true));
+  EXPECT_NE(
+      key,
+      GlobResultCache::makeKey(
+          "/mnt", "abc", RelativePathPiece{"dir"}, globs, false, false));
+  EXPECT_NE(
+      key,
+      GlobResultCache::makeKey(
+          "/other", "abc", RelativePathPiece{}, globs, false, false));
+}
+
+TEST(GlobResultCache, entries_expire_after_ttl) {
+  GlobResultCache cache{10, 1min};
+  auto now = GlobResultCache::Clock::now();
+  cache.insert(makeKey("abc", {"*"}), makeResults("a"), now);
+  EXPECT_NE(nullptr, cache.get(makeKey("abc", {"*"}), now + 30s));
+  EXPECT_EQ(nullptr, cache.get(makeKey("abc", {"*"}), now + 61s));
+}
+
+TEST(GlobResultCache, is_bounded) {
+  GlobResultCache cache{1, 1min};
+  cache.insert(makeKey("abc", {"*"}), makeResults("a"));
+  cache.insert(makeKey("def", {"*"}), makeResults("b"));
+  EXPECT_EQ(nullptr, cache.get(makeKey("abc", {"*"})));
+  EXPECT_NE(nullptr, cache.get(makeKey("def", {"*"})));
+}
+
+TEST(GlobResultCache, zero_ttl_disables_the_cache) {
+  GlobResultCache cache{10, 0s};
+  EXPECT_FALSE(cache.isEnabled());
+  cache.insert(makeKey("abc", {"*"}), makeResults("a"));
+  EXPECT_EQ(nullptr, cache.get(makeKey("abc", {"*"})));
+}
@@ -476,6 +476,57 @@ TEST(InodeMap, unloadedFileMetadataIsForgotten) {
   EXPECT_FALSE(mount.hasMetadata(file1ino));
   EXPECT_FALSE(mount.hasMetadata(file2ino));
 }
+
+TEST(InodeMap, batchedDecFsRefcountsForgetUnlinkedInodes) {
+  FakeTreeBuilder builder;
+  builder.setFile("dir/file1.txt", "contents");
+  builder.setFile("dir/file2.txt", "contents");
+  TestMount mount{builder};
+  auto edenMount = mount.getEdenMount();
+
+  auto dir =
+      edenMount
+          ->getInode(
+              RelativePathPiece{"dir"}, ObjectFetchContext::getNullContext())
+          .get()
+          .asTreePtr();
+  auto file1 = edenMount
+                   ->getInode(
+                       RelativePathPiece{"dir/file1.txt"},
+                       ObjectFetchContext::getNullContext())
+                   .get()
+                   .asFilePtr();
+  auto file1ino = file1->getNodeId();
+  auto file2 = edenMount
+                   ->getInode(
+                       RelativePathPiece{"dir/file2.txt"},
+                       ObjectFetchContext::getNullContext())
+                   .get()
+                   .asFilePtr();
+  auto file2ino = file2->getNodeId();
+
+  // Hold a pointer to file1 while the batch is applied, but not to file2.
+  file1->incFsRefcount(2);
+  file2->incFsRefcount();
+  file2.reset();
+
+  for (auto name : {"file1.txt", "file2.txt"}) {
+    dir->unlink(
+            PathComponentPiece{name},
+            InvalidationRequired::No,
+            ObjectFetchContext::getNullContext())
+        .get(0ms);
+  }
+  EXPECT_TRUE(mount.hasMetadata(file1ino));
+  EXPECT_TRUE(mount.hasMetadata(file2ino));
+
+  std::vector<std::pair<InodeNumber, uint32_t>> decrements{
+      {file1ino, 2}, {file2ino, 1}};
+  edenMount->getInodeMap()->decFsRefcounts(decrements);
+  file1.reset();
+  EXPECT_FALSE(mount.hasMetadata(file1ino));
+  EXPECT_FALSE(mount.hasMetadata(file2ino));
+}
 #endif
 
 struct InodePersistenceTreeTest : ::testing::Test {
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/futures/Future.h>
+#include <folly/portability/SysResource.h>
+#include <algorithm>
+#include "eden/fs/benchharness/Bench.h"
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/inodes/GlobNode.h"
+#include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/store/ScmStatusDiffCallback.h"
+#include "eden/fs/testharness/FakeBackingStore.h"
+#include "eden/fs/testharness/SyntheticRepo.h"
+#include "eden/fs/testharness/TestMount.h"
+#include "eden/fs/utils/ProcUtil.h"
+
+using namespace facebook::eden;
+
+/**
+ * Checkout, status and glob against synthetic repositories of growing size,
+ * to see how their time and memory scale with the number of files, the
+ * directory fan-out and the size of the change between two commits.
+ *
+ * Every benchmark takes four arguments: the depth of the tree, the number
+ * of subdirectories and of files per directory, and the number of files
+ * changed between the two commits. Each iteration runs on a new mount, with
+ * empty caches and no loaded inodes.
+ *
+ * Besides time, each benchmark reports the resident memory of the process
+ * once the workload completed, and its peak resident memory so far. The peak
+ * is process-wide, so run one benchmark per process, with
+ * --benchmark_filter, to attribute it to a single benchmark.
+ */
+namespace {
+
+SyntheticRepoOptions getOptions(const benchmark::State& state) {
+  SyntheticRepoOptions options;
+  options.depth = state.range(0);
+  options.directoriesPerDirectory = state.range(1);
+  options.filesPerDirectory = state.range(2);
+  options.changedFiles = state.range(3);
+  return options;
+}
+
+struct ScaleMount {
+  explicit ScaleMount(const SyntheticRepoOptions& options)
+      : repo{*mount.getBackingStore(), options} {
+    mount.initialize(commit1, repo.putRootTree(/*modified=*/false));
+    mount.getBackingStore()
+        ->putCommit(commit2, repo.putRootTree(/*modified=*/true))
+        ->setReady();
+  }
+
+  template <typename T>
+  T wait(folly::SemiFuture<T> future) {
+    auto executor = mount.getServerExecutor().get();
+    return std::move(future).via(executor).getVia(executor);
+  }
+
+  TestMount mount;
+  SyntheticRepo repo;
+  RootId commit1{"scale-commit-1"};
+  RootId commit2{"scale-commit-2"};
+};
+
+/**
+ * Run workload on a new mount of the repository described by the
+ * benchmark's arguments for every iteration, and report its memory usage.
+ */
+template <typename Workload>
+void runWorkload(benchmark::State& state, Workload workload) {
+  auto options = getOptions(state);
+  size_t fileCount = 0;
+  size_t residentBytes = 0;
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto scaleMount = std::make_unique<ScaleMount>(options);
+    fileCount = scaleMount->repo.getFileCount();
+    state.ResumeTiming();
+
+    workload(*scaleMount);
+
+    state.PauseTiming();
+    if (auto memory = readMemoryStats()) {
+      residentBytes = std::max(residentBytes, memory->resident);
+    }
+    scaleMount.reset();
+    state.ResumeTiming();
+  }
+
+  struct rusage usage {};
+  getrusage(RUSAGE_SELF, &usage);
+
+  state.SetItemsProcessed(state.iterations() * fileCount);
+  state.counters["files"] = fileCount;
+  state.counters["resident_bytes"] = residentBytes;
+  // ru_maxrss is in kilobytes on Linux.
+  state.counters["peak_resident_bytes"] = usage.ru_maxrss * 1024.0;
+}
+
+/** Check out from the first commit to the second one. */
+void checkout(benchmark::State& state) {
+  runWorkload(state, [](ScaleMount& scaleMount) {
+    auto result = scaleMount.wait(scaleMount.mount.getEdenMount()
+                                      ->checkout(
+                                          scaleMount.commit2,
+                                          std::nullopt,
+                                          __func__)
+                                      .semi());
+    benchmark::DoNotOptimize(result);
+  });
+}
+
+/** Status of a clean working copy of the first commit against the second. */
+void diff(benchmark::State& state) {
+  runWorkload(state, [](ScaleMount& scaleMount) {
+    ScmStatusDiffCallback callback;
+    scaleMount.wait(scaleMount.mount.getEdenMount()
+                        ->diff(
+                            &callback,
+                            scaleMount.commit2,
+                            /*listIgnored=*/false,
+                            /*enforceCurrentParent=*/false,
+                            /*request=*/nullptr)
+                        .semi());
+    benchmark::DoNotOptimize(callback.extractStatus());
+  });
+}
+
+/** Glob every header of the working copy. */
+void glob(benchmark::State& state) {
+  runWorkload(state, [](ScaleMount& scaleMount) {
+    GlobNode globRoot{/*includeDotfiles=*/false};
+    globRoot.parse("**/*.h");
+    GlobNode::ResultList results;
+    scaleMount.wait(globRoot
+                        .evaluate(
+                            scaleMount.mount.getEdenMount()->getObjectStore(),
+                            ObjectFetchContext::getNullContext(),
+                            RelativePathPiece(),
+                            scaleMount.mount.getTreeInode(RelativePathPiece()),
+                            /*fileBlobsToPrefetch=*/nullptr,
+                            results,
+                            scaleMount.commit1)
+                        .semi());
+    benchmark::DoNotOptimize(results.rlock()->size());
+  });
+}
+
+void scaleArguments(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"depth", "dirs", "files", "changed"});
+  // Growing file counts with the same shape and change size.
+  benchmark->Args({2, 10, 10, 100});
+  benchmark->Args({3, 10, 10, 100});
+  benchmark->Args({4, 10, 10, 100});
+  // The same number of files, in wide or in deep trees.
+  benchmark->Args({1, 100, 100, 100});
+  benchmark->Args({3, 21, 1, 100});
+  // Growing changes on the same repository.
+  benchmark->Args({3, 10, 10, 1000});
+  benchmark->Args({3, 10, 10, 10000});
+  benchmark->Unit(benchmark::kMillisecond);
+}
+
+BENCHMARK(checkout)->Apply(scaleArguments);
+BENCHMARK(diff)->Apply(scaleArguments);
+BENCHMARK(glob)->Apply(scaleArguments);
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <fmt/format.h>
+#include <folly/futures/Future.h>
+#include <gflags/gflags.h>
+#include "eden/fs/benchharness/Bench.h"
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/inodes/FileInode.h"
+#include "eden/fs/inodes/InodePtr.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/store/ScmStatusDiffCallback.h"
+#include "eden/fs/testharness/FakeBackingStore.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/TestMount.h"
+#include "eden/fs/utils/ImmediateFuture.h"
+
+DEFINE_uint64(
+    backing_store_latency_us,
+    0,
+    "Delay added to every tree and blob fetched from the fake backing store");
+DEFINE_uint64(directories, 100, "Number of directories in the test tree");
+DEFINE_uint64(files_per_directory, 100, "Number of files in each directory");
+
+using namespace facebook::eden;
+
+/**
+ * End-to-end workloads run against a TestMount backed by a FakeBackingStore,
+ * going through the same inode, object store and cache code as requests
+ * from the filesystem channel.
+ *
+ * Each benchmark takes one argument: 0 builds a new mount, with empty
+ * caches, for every iteration; 1 reuses a single mount whose inodes and
+ * caches were populated by a first, untimed run of the workload.
+ */
+namespace {
+
+constexpr int64_t kColdCaches = 0;
+constexpr int64_t kWarmCaches = 1;
+
+/** A checkout of many small headers, spread over many directories. */
+const std::vector<std::string>& getFilePaths() {
+  static const auto paths = [] {
+    std::vector<std::string> result;
+    for (uint64_t dir = 0; dir < FLAGS_directories; ++dir) {
+      for (uint64_t file = 0; file < FLAGS_files_per_directory; ++file) {
+        result.push_back(fmt::format("dir{}/file{}.h", dir, file));
+      }
+    }
+    return result;
+  }();
+  return paths;
+}
+
+/** Whether the second commit, and a dirty working copy, change path i. */
+bool isModified(size_t i) {
+  return i % 10 == 0;
+}
+
+struct BenchMount {
+  BenchMount() {
+    FakeTreeBuilder builder;
+    const auto& paths = getFilePaths();
+    for (const auto& path : paths) {
+      builder.setFile(folly::StringPiece{path}, fmt::format("// {}\n", path));
+    }
+    mount = std::make_unique<TestMount>(builder);
+    commit1 = mount->getEdenMount()->getParentCommit();
+
+    auto builder2 = builder.clone();
+    for (size_t i = 0; i < paths.size(); ++i) {
+      if (isModified(i)) {
+        builder2.replaceFile(
+            folly::StringPiece{paths[i]}, fmt::format("// {} v2\n", paths[i]));
+      }
+    }
+    builder2.finalize(mount->getBackingStore(), /*setReady=*/true);
+    mount->getBackingStore()->putCommit(commit2, builder2)->setReady();
+
+    mount->getBackingStore()->setLatency(
+        std::chrono::microseconds(FLAGS_backing_store_latency_us));
+  }
+
+  template <typename T>
+  T wait(folly::SemiFuture<T> future) {
+    auto executor = mount->getServerExecutor().get();
+    return std::move(future).via(executor).getVia(executor);
+  }
+
+  std::unique_ptr<TestMount> mount;
+  RootId commit1;
+  RootId commit2{"bench-commit-2"};
+};
+
+/**
+ * Run workload on a mount for every iteration, with the cache mode given by
+ * the benchmark's argument. setup prepares a new mount outside of the timed
+ * section.
+ */
+template <typename Workload, typename Setup>
+void runWorkload(benchmark::State& state, Workload workload, Setup setup) {
+  std::unique_ptr<BenchMount> mount;
+  if (state.range(0) == kWarmCaches) {
+    mount = std::make_unique<BenchMount>();
+    setup(*mount);
+    workload(*mount);
+  }
+
+  for (auto _ : state) {
+    if (state.range(0) == kColdCaches) {
+      state.PauseTiming();
+      mount.reset();
+      mount = std::make_unique<BenchMount>();
+      setup(*mount);
+      state.ResumeTiming();
+    }
+    workload(*mount);
+  }
+
+  state.SetItemsProcessed(state.iterations() * getFilePaths().size());
+}
+
+template <typename Workload>
+void runWorkload(benchmark::State& state, Workload workload) {
+  runWorkload(state, std::move(workload), [](BenchMount&) {});
+}
+
+/** A parallel build reading every header at once. */
+void read_headers(benchmark::State& state) {
+  runWorkload(state, [](BenchMount& bench) {
+    auto& context = ObjectFetchContext::getNullContext();
+    std::vector<folly::SemiFuture<std::string>> reads;
+    for (const auto& path : getFilePaths()) {
+      reads.push_back(
+          bench.mount->getEdenMount()
+              ->getInode(RelativePathPiece{path}, context)
+              .thenValue([&context](InodePtr inode) {
+                return ImmediateFuture<std::string>{
+                    inode.asFilePtr()
+                        ->readAll(context, CacheHint::LikelyNeededAgain)
+                        .semi()};
+              })
+              .semi());
+    }
+    auto results = bench.wait(folly::collectAll(std::move(reads)));
+    benchmark::DoNotOptimize(results);
+  });
+}
+
+/** `ls -R`: load every directory and file inode of the mount. */
+void list_recursive(benchmark::State& state) {
+  runWorkload(state, [](BenchMount& bench) {
+    bench.wait(bench.mount->loadAllInodesFuture().semi());
+  });
+}
+
+/** `hg status` with one file in ten modified. */
+void status_dirty_tree(benchmark::State& state) {
+  runWorkload(
+      state,
+      [](BenchMount& bench) {
+        ScmStatusDiffCallback callback;
+        auto edenMount = bench.mount->getEdenMount();
+        bench.wait(edenMount
+                       ->diff(
+                           &callback,
+                           edenMount->getParentCommit(),
+                           /*listIgnored=*/false,
+                           /*enforceCurrentParent=*/false,
+                           /*request=*/nullptr)
+                       .semi());
+        benchmark::DoNotOptimize(callback.extractStatus());
+      },
+      [](BenchMount& bench) {
+        const auto& paths = getFilePaths();
+        for (size_t i = 0; i < paths.size(); ++i) {
+          if (isModified(i)) {
+            bench.mount->overwriteFile(paths[i], "modified\n");
+          }
+        }
+      });
+}
+
+/** Check out back and forth between two commits changing one file in ten. */
+void checkout_between_commits(benchmark::State& state) {
+  runWorkload(state, [](BenchMount& bench) {
+    auto edenMount = bench.mount->getEdenMount();
+    auto target = edenMount->getParentCommit() == bench.commit1
+        ? bench.commit2
+        : bench.commit1;
+    auto result =
+        bench.wait(edenMount->checkout(target, std::nullopt, __func__).semi());
+    benchmark::DoNotOptimize(result);
+  });
+}
+
+BENCHMARK(read_headers)->Arg(kColdCaches)->Arg(kWarmCaches);
+BENCHMARK(list_recursive)->Arg(kColdCaches)->Arg(kWarmCaches);
+BENCHMARK(status_dirty_tree)->Arg(kColdCaches)->Arg(kWarmCaches);
+BENCHMARK(checkout_between_commits)->Arg(kColdCaches)->Arg(kWarmCaches);
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
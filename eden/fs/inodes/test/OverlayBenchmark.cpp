@@ -5,34 +5,150 @@
  * GNU General Public License version 2.
  */
 
-#include <folly/init/Init.h>
+#include <fmt/format.h>
+#include <folly/portability/Unistd.h>
 #include <folly/stop_watch.h>
 #include <gflags/gflags.h>
-#include <stdlib.h>
+#include <string>
+#include "eden/fs/benchharness/Bench.h"
 #include "eden/fs/inodes/DirEntry.h"
 #include "eden/fs/inodes/Overlay.h"
 #include "eden/fs/telemetry/NullStructuredLogger.h"
+#include "eden/fs/testharness/TempFile.h"
 
 using namespace facebook::eden;
 using namespace folly::string_piece_literals;
 
-DEFINE_string(overlayPath, "", "Directory where the test overlay is created");
+DEFINE_string(
+    overlayPath,
+    "",
+    "Directory where the test overlays are created, to measure on different "
+    "filesystem types. Defaults to the temporary directory.");
 
+/**
+ * Compares the Overlay::OverlayType implementations on the operations whose
+ * cost depends on the backing overlay: saving directories, creating, writing
+ * and removing files, opening an overlay after a clean shutdown, and checking
+ * it after an unclean one.
+ *
+ * The first argument of every benchmark is the OverlayType, also reported as
+ * the label of the run. Use --benchmark_format=json or --benchmark_out for
+ * machine-readable results.
+ */
 namespace {
 
-void benchmarkOverlayTreeWrites(AbsolutePathPiece overlayPath) {
-  // A large mount will contain 500,000 trees. If they're all loaded, they
-  // will all be written into the overlay. This benchmark simulates that
-  // workload and measures how long it takes.
-  //
-  // overlayPath is parameterized to measure on different filesystem types.
+constexpr Overlay::OverlayType kOverlayTypes[] = {
+    Overlay::OverlayType::Legacy,
+    Overlay::OverlayType::Tree,
+    Overlay::OverlayType::TreeInMemory,
+    Overlay::OverlayType::TreeSynchronousOff,
+    Overlay::OverlayType::TreeInMemorySnapshot,
+};
+
+/** The number of files in each directory of a populated overlay. */
+constexpr size_t kFilesPerDirectory = 16;
+
+const char* getOverlayTypeName(Overlay::OverlayType type) {
+  switch (type) {
+    case Overlay::OverlayType::Legacy:
+#ifdef _WIN32
+      return "SqliteOverlay";
+#else
+      return "FsOverlay";
+#endif
+    case Overlay::OverlayType::Tree:
+      return "TreeOverlay";
+    case Overlay::OverlayType::TreeInMemory:
+      return "TreeOverlay/in-memory";
+    case Overlay::OverlayType::TreeSynchronousOff:
+      return "TreeOverlay/synchronous-off";
+    case Overlay::OverlayType::TreeInMemorySnapshot:
+      return "TreeOverlay/in-memory-snapshot";
+  }
+  return "unknown";
+}
+
+folly::test::TemporaryDirectory makeBenchmarkDir() {
+  if (FLAGS_overlayPath.empty()) {
+    return makeTempDir("eden_overlay_bench");
+  }
+  return folly::test::TemporaryDirectory{
+      "eden_overlay_bench", FLAGS_overlayPath};
+}
+
+/**
+ * A directory holding an overlay of the benchmark's type, which can be
+ * opened and closed repeatedly.
+ */
+class OverlayDir {
+ public:
+  explicit OverlayDir(const benchmark::State& state)
+      : type_{static_cast<Overlay::OverlayType>(state.range(0))} {}
+
+  Overlay::OverlayType getType() const {
+    return type_;
+  }
+
+  AbsolutePathPiece getOverlayPath() const {
+    return overlayPath_;
+  }
+
+  std::shared_ptr<Overlay> open() {
+    auto overlay = Overlay::create(
+        overlayPath_,
+        kPathMapDefaultCaseSensitive,
+        type_,
+        std::make_shared<NullStructuredLogger>());
+    // Only used by the TreeOverlay on Windows, to look for changes made
+    // while EdenFS wasn't running.
+    overlay->initialize(AbsolutePath{mountDir_.path().string()}).get();
+    return overlay;
+  }
+
+  /**
+   * Save a root with the given number of directories, each with
+   * kFilesPerDirectory unmodified files, and close the overlay cleanly.
+   */
+  void populate(size_t directories) {
+    auto overlay = open();
+    ObjectId fileHash{folly::ByteRange{"abcdabcdabcdabcdabcd"_sp}};
+    DirContents root(kPathMapDefaultCaseSensitive);
+    for (size_t d = 0; d < directories; ++d) {
+      DirContents dir(kPathMapDefaultCaseSensitive);
+      for (size_t f = 0; f < kFilesPerDirectory; ++f) {
+        dir.emplace(
+            PathComponent{fmt::format("file{}", f)},
+            S_IFREG | 0644,
+            overlay->allocateInodeNumber(),
+            fileHash);
+      }
+      auto ino = overlay->allocateInodeNumber();
+      overlay->saveOverlayDir(ino, dir);
+      root.emplace(PathComponent{fmt::format("dir{}", d)}, S_IFDIR | 0755, ino);
+    }
+    overlay->saveOverlayDir(kRootNodeId, root);
+    overlay->close();
+  }
+
+ private:
+  Overlay::OverlayType type_;
+  folly::test::TemporaryDirectory dir_{makeBenchmarkDir()};
+  folly::test::TemporaryDirectory mountDir_{makeTempDir("eden_overlay_mount")};
+  AbsolutePath overlayPath_{AbsolutePath{dir_.path().string()} + "overlay"_pc};
+};
 
-  auto overlay = Overlay::create(
-      overlayPath,
-      kPathMapDefaultCaseSensitive,
-      Overlay::OverlayType::Legacy,
-      std::make_shared<NullStructuredLogger>());
-  overlay->initialize().get();
+/**
+ * A large mount contains 500,000 trees. If they're all loaded, they are all
+ * written into the overlay. This benchmark simulates that workload.
+ *
+ * The cost of writing into the overlay increases as the overlay grows, as
+ * xfs especially updates its btrees, so this runs a fixed number of
+ * iterations for comparable results.
+ */
+void saveOverlayDir_new_directories(benchmark::State& state) {
+  OverlayDir overlayDir{state};
+  state.SetLabel(getOverlayTypeName(overlayDir.getType()));
+  auto overlay = overlayDir.open();
 
   ObjectId hash1{folly::ByteRange{"abcdabcdabcdabcdabcd"_sp}};
   ObjectId hash2{folly::ByteRange{"01234012340123401234"_sp}};
@@ -49,49 +165,178 @@ void benchmarkOverlayTreeWrites(AbsolutePathPiece overlayPath) {
       overlay->allocateInodeNumber(),
       hash2);
 
-  uint64_t N = 500000;
+  for (auto _ : state) {
+    overlay->saveOverlayDir(overlay->allocateInodeNumber(), contents);
+  }
+}
 
-  folly::stop_watch<> timer;
+/**
+ * Repeatedly save a single directory of range(1) entries, as done every time
+ * an entry is added to or removed from a directory by overlays that don't
+ * support semantic operations.
+ */
+void saveOverlayDir_large_directory(benchmark::State& state) {
+  OverlayDir overlayDir{state};
+  state.SetLabel(getOverlayTypeName(overlayDir.getType()));
+  auto overlay = overlayDir.open();
 
-  for (uint64_t i = 1; i <= N; i++) {
-    auto ino = overlay->allocateInodeNumber();
+  ObjectId hash{folly::ByteRange{"abcdabcdabcdabcdabcd"_sp}};
+  DirContents contents(kPathMapDefaultCaseSensitive);
+  for (int64_t i = 0; i < state.range(1); ++i) {
+    contents.emplace(
+        PathComponent{fmt::format("file{}", i)},
+        S_IFREG | 0644,
+        overlay->allocateInodeNumber(),
+        hash);
+  }
+  auto ino = overlay->allocateInodeNumber();
+
+  for (auto _ : state) {
     overlay->saveOverlayDir(ino, contents);
   }
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+
+/**
+ * Create a file of range(1) bytes in a directory, append to it and remove
+ * it, like a build writing and cleaning up temporary files.
+ *
+ * Only the FsOverlay stores the contents of files. Other overlays only
+ * record the directory entries, the contents being left in the working copy.
+ */
+void create_write_unlink(benchmark::State& state) {
+  OverlayDir overlayDir{state};
+  state.SetLabel(getOverlayTypeName(overlayDir.getType()));
+  auto overlay = overlayDir.open();
+#ifndef _WIN32
+  bool storesFiles = overlayDir.getType() == Overlay::OverlayType::Legacy;
+  std::string data(state.range(1), 'a');
+#endif
+
+  auto parent = overlay->allocateInodeNumber();
+  DirContents contents(kPathMapDefaultCaseSensitive);
+  overlay->saveOverlayDir(parent, contents);
+
+  uint64_t i = 0;
+  for (auto _ : state) {
+    auto name = PathComponent{fmt::format("file{}", i++)};
+    auto ino = overlay->allocateInodeNumber();
+    auto entry = contents.emplace(name, S_IFREG | 0644, ino).first;
+    overlay->addChild(parent, *entry, contents);
+#ifndef _WIN32
+    if (storesFiles) {
+      auto file = overlay->createOverlayFile(
+          ino, folly::ByteRange{folly::StringPiece{data}});
+      iovec iov{data.data(), data.size()};
+      auto written = file.pwritev(&iov, 1, data.size());
+      benchmark::DoNotOptimize(written);
+    }
+#endif
 
-  auto elapsed = timer.elapsed();
-
-  printf(
-      "Total elapsed time for %" SCNu64 " entries: %.2f s\n",
-      N,
-      std::chrono::duration_cast<std::chrono::duration<double>>(elapsed)
-          .count());
-
-  // Normally, I prefer to use minimum, but the cost of writing into the
-  // overlay increases as the overlay grows, as xfs especially updates its
-  // btrees.
-  //
-  // That reason, plus the reason that we want a fixed N for comparable results
-  // is why this benchmark doesn't use folly Benchmark.
-  printf(
-      "Average time per call: %.2f us\n",
-      static_cast<double>(
-          std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(
-              elapsed / N)
-              .count()));
+    contents.erase(name);
+    overlay->removeChild(parent, name, contents);
+    overlay->removeOverlayData(ino);
+  }
+  state.SetItemsProcessed(state.iterations());
 }
 
-} // namespace
+/**
+ * Open an overlay of range(1) directories that was shut down cleanly.
+ *
+ * The in-memory overlays lose their contents when closed, so they always
+ * start empty.
+ */
+void open_after_clean_shutdown(benchmark::State& state) {
+  OverlayDir overlayDir{state};
+  state.SetLabel(getOverlayTypeName(overlayDir.getType()));
+  overlayDir.populate(state.range(1));
 
-int main(int argc, char* argv[]) {
-  folly::init(&argc, &argv);
+  for (auto _ : state) {
+    folly::stop_watch<> timer;
+    auto overlay = overlayDir.open();
+    state.SetIterationTime(
+        std::chrono::duration<double>{timer.elapsed()}.count());
+    overlay->close();
+  }
+}
 
-  if (FLAGS_overlayPath.empty()) {
-    fprintf(stderr, "error: overlayPath is required\n");
-    return 1;
+/**
+ * Open an overlay of range(1) directories that wasn't shut down cleanly,
+ * which scans it with the OverlayChecker. Only the FsOverlay needs such a
+ * scan: the others always know their next inode number.
+ */
+void open_after_unclean_shutdown(benchmark::State& state) {
+  OverlayDir overlayDir{state};
+  state.SetLabel(getOverlayTypeName(overlayDir.getType()));
+#ifndef _WIN32
+  if (overlayDir.getType() != Overlay::OverlayType::Legacy) {
+    state.SkipWithError("only the FsOverlay is checked on startup");
+    return;
+  }
+  overlayDir.populate(state.range(1));
+  auto nextInodeNumberPath =
+      overlayDir.getOverlayPath() + "next-inode-number"_pc;
+
+  for (auto _ : state) {
+    if (unlink(nextInodeNumberPath.c_str())) {
+      state.SkipWithError("failed to remove the next inode number");
+      return;
+    }
+    folly::stop_watch<> timer;
+    auto overlay = overlayDir.open();
+    state.SetIterationTime(
+        std::chrono::duration<double>{timer.elapsed()}.count());
+    overlay->close();
   }
+#else
+  state.SkipWithError("only the FsOverlay is checked on startup");
+#endif
+}
 
-  auto overlayPath = normalizeBestEffort(FLAGS_overlayPath.c_str());
-  benchmarkOverlayTreeWrites(overlayPath);
+void overlayTypes(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgName("type");
+  for (auto type : kOverlayTypes) {
+    benchmark->Arg(static_cast<int64_t>(type));
+  }
+}
 
-  return 0;
+/** Every overlay type, with each of the given sizes. */
+template <int64_t... Sizes>
+void overlayTypesAndSizes(benchmark::internal::Benchmark* benchmark) {
+  for (auto type : kOverlayTypes) {
+    for (auto size : {Sizes...}) {
+      benchmark->Args({static_cast<int64_t>(type), size});
+    }
+  }
 }
+
+BENCHMARK(saveOverlayDir_new_directories)
+    ->Apply(overlayTypes)
+    ->Iterations(500000)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(saveOverlayDir_large_directory)
+    ->Apply(overlayTypesAndSizes<16, 1024, 65536>)
+    ->ArgNames({"type", "entries"})
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(create_write_unlink)
+    ->Apply(overlayTypesAndSizes<4096, 1024 * 1024>)
+    ->ArgNames({"type", "size"})
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(open_after_clean_shutdown)
+    ->Apply(overlayTypesAndSizes<1000, 100000>)
+    ->ArgNames({"type", "dirs"})
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(open_after_unclean_shutdown)
+    ->Apply(overlayTypesAndSizes<1000, 100000>)
+    ->ArgNames({"type", "dirs"})
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -320,6 +320,188 @@ TEST(PlainOverlayTest, unclean_overlay_is_dirty) {
   EXPECT_FALSE(overlay->hadCleanStartup());
 }
 
+TEST(PlainOverlayTest, dir_write_back_coalesces_directory_changes) {
+  folly::test::TemporaryDirectory testDir;
+  auto hash = ObjectId::fromHex("0123456789012345678901234567890123456789");
+  InodeNumber dirIno;
+  {
+    auto overlay = Overlay::create(
+        AbsolutePath{testDir.path().string()},
+        kPathMapDefaultCaseSensitive,
+        kOverlayType,
+        std::make_shared<NullStructuredLogger>());
+    overlay->setDirWriteBack(true);
+    overlay->initialize().get();
+
+    dirIno = overlay->allocateInodeNumber();
+    DirContents dir(kPathMapDefaultCaseSensitive);
+    for (int i = 0; i < 10; ++i) {
+      auto ino = overlay->allocateInodeNumber();
+      auto name = PathComponent{fmt::format("file{}", i)};
+      auto [iter, inserted] = dir.emplace(name, S_IFREG | 0644, ino, hash);
+      ASSERT_TRUE(inserted);
+      overlay->addChild(dirIno, *iter, dir);
+    }
+    dir.erase("file3"_pc);
+    overlay->removeChild(dirIno, "file3"_pc, dir);
+
+    // The unwritten changes are visible right away.
+    EXPECT_TRUE(overlay->hasOverlayData(dirIno));
+    EXPECT_EQ(9, overlay->loadOverlayDir(dirIno).size());
+
+    overlay->flushPendingAsync().get();
+    EXPECT_EQ(9, overlay->loadOverlayDir(dirIno).size());
+  }
+
+  // And were written by the time the overlay was closed.
+  auto overlay = Overlay::create(
+      AbsolutePath{testDir.path().string()},
+      kPathMapDefaultCaseSensitive,
+      kOverlayType,
+      std::make_shared<NullStructuredLogger>());
+  overlay->initialize().get();
+  auto result = overlay->loadOverlayDir(dirIno);
+  EXPECT_EQ(9, result.size());
+  EXPECT_EQ(result.end(), result.find("file3"_pc));
+  EXPECT_NE(result.end(), result.find("file9"_pc));
+}
+
+TEST(PlainOverlayTest, dir_write_back_journal_is_replayed_after_a_crash) {
+  folly::test::TemporaryDirectory testDir;
+  folly::test::TemporaryDirectory crashedDir;
+  auto hash = ObjectId::fromHex("0123456789012345678901234567890123456789");
+  InodeNumber dirIno;
+  {
+    auto overlay = Overlay::create(
+        AbsolutePath{testDir.path().string()},
+        kPathMapDefaultCaseSensitive,
+        kOverlayType,
+        std::make_shared<NullStructuredLogger>());
+    overlay->setDirWriteBack(true);
+    overlay->initialize().get();
+
+    // Block the GC thread, so that the directory isn't written and the
+    // journal isn't truncated.
+    folly::Baton<> unblock;
+    auto blocked = overlay->flushPendingAsync().thenValue(
+        [&](auto&&) { unblock.wait(); });
+
+    dirIno = overlay->allocateInodeNumber();
+    DirContents dir(kPathMapDefaultCaseSensitive);
+    for (int i = 0; i < 10; ++i) {
+      auto ino = overlay->allocateInodeNumber();
+      auto name = PathComponent{fmt::format("file{}", i)};
+      auto [iter, inserted] = dir.emplace(name, S_IFREG | 0644, ino, hash);
+      ASSERT_TRUE(inserted);
+      overlay->addChild(dirIno, *iter, dir);
+    }
+    dir.erase("file3"_pc);
+    overlay->removeChild(dirIno, "file3"_pc, dir);
+
+    // What a crash would have left behind.
+    std::string journal;
+    ASSERT_TRUE(folly::readFile(
+        (testDir.path() / "dir-journal").string().c_str(), journal));
+    ASSERT_TRUE(folly::writeFile(
+        journal, (crashedDir.path() / "dir-journal").string().c_str()));
+
+    unblock.post();
+    std::move(blocked).get();
+  }
+
+  auto overlay = Overlay::create(
+      AbsolutePath{crashedDir.path().string()},
+      kPathMapDefaultCaseSensitive,
+      kOverlayType,
+      std::make_shared<NullStructuredLogger>());
+  overlay->initialize().get();
+  auto result = overlay->loadOverlayDir(dirIno);
+  EXPECT_EQ(9, result.size());
+  EXPECT_EQ(result.end(), result.find("file3"_pc));
+  EXPECT_NE(result.end(), result.find("file9"_pc));
+  EXPECT_FALSE(boost::filesystem::exists(crashedDir.path() / "dir-journal"));
+}
+
+TEST(PlainOverlayTest, pooled_files_are_independent_copies) {
+  folly::test::TemporaryDirectory testDir;
+  auto overlay = Overlay::create(
+      AbsolutePath{testDir.path().string()},
+      kPathMapDefaultCaseSensitive,
+      kOverlayType,
+      std::make_shared<NullStructuredLogger>());
+  overlay->setPooledFileMinSize(1);
+  overlay->initialize().get();
+
+  auto contents = folly::IOBuf::copyBuffer("pooled contents");
+  auto sha1 = Hash20::sha1(*contents);
+  auto header = FsOverlay::kHeaderLength;
+
+  auto ino1 = overlay->allocateInodeNumber();
+  auto file1 = overlay->createOverlayFile(ino1, sha1, *contents);
+  auto ino2 = overlay->allocateInodeNumber();
+  auto file2 = overlay->createOverlayFile(ino2, sha1, *contents);
+  EXPECT_EQ("pooled contents", file1.readFile().value().substr(header));
+  EXPECT_EQ("pooled contents", file2.readFile().value().substr(header));
+
+  // Writing to one of them doesn't change the other.
+  std::string data = "changed";
+  iovec iov{data.data(), data.size()};
+  ASSERT_TRUE(file1.pwritev(&iov, 1, header).hasValue());
+  EXPECT_EQ("changed contents", file1.readFile().value().substr(header));
+  EXPECT_EQ("pooled contents", file2.readFile().value().substr(header));
+  EXPECT_EQ(
+      "pooled contents",
+      overlay->openFile(ino2, FsOverlay::kHeaderIdentifierFile)
+          .readFile()
+          .value()
+          .substr(header));
+}
+
+TEST(PlainOverlayTest, removing_the_last_user_frees_the_pooled_file) {
+  folly::test::TemporaryDirectory testDir;
+  auto contents = folly::IOBuf::copyBuffer("pooled contents");
+  auto sha1 = Hash20::sha1(*contents);
+  auto poolFile =
+      testDir.path() / FsOverlay::kBlobPoolDir.str() / sha1.toString();
+  auto openOverlay = [&] {
+    auto overlay = Overlay::create(
+        AbsolutePath{testDir.path().string()},
+        kPathMapDefaultCaseSensitive,
+        kOverlayType,
+        std::make_shared<NullStructuredLogger>());
+    overlay->setPooledFileMinSize(1);
+    overlay->initialize().get();
+    return overlay;
+  };
+
+  InodeNumber ino1;
+  InodeNumber ino2;
+  {
+    auto overlay = openOverlay();
+    ino1 = overlay->allocateInodeNumber();
+    overlay->createOverlayFile(ino1, sha1, *contents);
+    ino2 = overlay->allocateInodeNumber();
+    overlay->createOverlayFile(ino2, sha1, *contents);
+  }
+  if (boost::filesystem::hard_link_count(poolFile) == 1) {
+    GTEST_SKIP() << "The filesystem can't clone files";
+  }
+
+  {
+    auto overlay = openOverlay();
+    EXPECT_TRUE(boost::filesystem::exists(poolFile));
+    overlay->removeOverlayData(ino1);
+  }
+  {
+    auto overlay = openOverlay();
+    EXPECT_TRUE(boost::filesystem::exists(poolFile));
+    overlay->removeOverlayData(ino2);
+  }
+
+  openOverlay();
+  EXPECT_FALSE(boost::filesystem::exists(poolFile));
+}
+
 enum class OverlayRestartMode {
   CLEAN,
   UNCLEAN,
@@ -541,6 +723,40 @@ TEST_P(RawOverlayTest, remembers_max_inode_number_of_tree_inodes) {
   EXPECT_EQ(2_ino, overlay->getMaxInodeNumber());
 }
 
+TEST_P(RawOverlayTest, object_ids_are_migrated_on_load) {
+  auto ino2 = overlay->allocateInodeNumber();
+  DirContents dir(kPathMapDefaultCaseSensitive);
+  dir.emplace(
+      PathComponentPiece{"legacy"}, S_IFREG | 0644, ino2, ObjectId{"legacy"});
+  overlay->saveOverlayDir(kRootNodeId, dir);
+
+  unloadOverlay();
+  std::vector<ObjectId> migrated;
+  overlay = Overlay::create(
+      getLocalDir(),
+      kPathMapDefaultCaseSensitive,
+      kOverlayType,
+      std::make_shared<NullStructuredLogger>());
+  overlay->setObjectIdMigrator(
+      [&](const ObjectId& id) -> std::optional<ObjectId> {
+        migrated.push_back(id);
+        if (id == ObjectId{"legacy"}) {
+          return ObjectId{"embedded"};
+        }
+        return std::nullopt;
+      });
+  overlay->initialize().get();
+
+  auto loaded = overlay->loadOverlayDir(kRootNodeId);
+  EXPECT_EQ(ObjectId{"embedded"}, loaded.find("legacy"_pc)->second.getHash());
+
+  // The migrated directory was saved back.
+  recreate();
+  loaded = overlay->loadOverlayDir(kRootNodeId);
+  EXPECT_EQ(ObjectId{"embedded"}, loaded.find("legacy"_pc)->second.getHash());
+  EXPECT_EQ(std::vector<ObjectId>{ObjectId{"legacy"}}, migrated);
+}
+
 TEST_P(RawOverlayTest, remembers_max_inode_number_of_tree_entries) {
   auto ino2 = overlay->allocateInodeNumber();
   EXPECT_EQ(2_ino, ino2);
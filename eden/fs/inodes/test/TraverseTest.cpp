@@ -7,6 +7,10 @@
 
 #include "eden/fs/inodes/Traverse.h"
 
+#include <algorithm>
+
+#include <folly/Synchronized.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
 #include <folly/portability/GTest.h>
 #include "eden/fs/inodes/FileInode.h"
 #include "eden/fs/inodes/InodeBase.h"
@@ -38,6 +42,23 @@ struct TestCallbacks : TraversalCallbacks {
   }
 };
 
+struct ConcurrentTestCallbacks : TraversalCallbacks {
+  folly::Synchronized<std::vector<RelativePath>> paths;
+
+  void visitTreeInode(
+      RelativePathPiece path,
+      InodeNumber /*ino*/,
+      const std::optional<ObjectId>& /*hash*/,
+      uint64_t /*fuseRefcount*/,
+      const std::vector<ChildEntry>& /*entries*/) override {
+    paths.wlock()->emplace_back(path);
+  }
+
+  bool shouldRecurse(const ChildEntry& /*entry*/) override {
+    return true;
+  }
+};
+
 TEST(TraverseTest, does_not_traverse_unallocated_and_unmaterialized_trees) {
   FakeTreeBuilder builder;
   builder.setFile("dir1/dir2/file", "test\n");
@@ -74,3 +95,34 @@ TEST(TraverseTest, does_traverse_loaded_trees) {
   EXPECT_EQ("dir1", callbacks.paths.at(2));
   EXPECT_EQ("dir1/dir2", callbacks.paths.at(3));
 }
+
+TEST(TraverseTest, parallel_traversal_visits_the_same_trees) {
+  FakeTreeBuilder builder;
+  builder.setFile("dir1/dir2/file", "test\n");
+  builder.setFile("dir3/dir4/file", "test\n");
+  builder.setFile("dir5/file", "test\n");
+  TestMount mount{builder};
+
+  auto rootPath = RelativePath{""};
+  auto root = mount.getTreeInode(rootPath);
+
+  // Trigger allocation of dir2, dir4 and their files.
+  auto file1 = mount.getFileInode("dir1/dir2/file");
+  auto file2 = mount.getFileInode("dir3/dir4/file");
+
+  TestCallbacks serialCallbacks;
+  traverseObservedInodes(*root, rootPath, serialCallbacks);
+
+  folly::CPUThreadPoolExecutor executor{4};
+  ConcurrentTestCallbacks callbacks;
+  traverseObservedInodesParallel(
+      *root, rootPath, callbacks, folly::getKeepAliveToken(executor))
+      .get();
+
+  auto paths = callbacks.paths.copy();
+  ASSERT_EQ(6, paths.size());
+  // The root is always visited first.
+  EXPECT_EQ("", paths.at(0));
+  std::sort(paths.begin(), paths.end());
+  EXPECT_EQ(serialCallbacks.paths, paths);
+}
@@ -463,3 +463,33 @@ TEST(TreeInode, removeRecursivelyConcurrentAddition) {
   // Since somedir/newfile.txt hasn't been removed, somedir should still exist.
   auto inode = mount.getTreeInode("somedir"_relpath);
 }
+
+TEST(TreeInode, removeRecursivelyLargeUnloadedTree) {
+  FakeTreeBuilder builder;
+  for (int i = 0; i < 200; ++i) {
+    builder.setFile("bigdir/file" + std::to_string(i), "contents\n");
+  }
+  builder.setFile("bigdir/subdir/foo.txt", "foo\n");
+  TestMount mount{builder};
+  mount.addFile("bigdir/subdir/new.txt", "new\n");
+  // Unload everything below bigdir.
+  mount.getTreeInode("bigdir"_relpath)->unloadChildrenNow();
+
+  auto& journal = mount.getEdenMount()->getJournal();
+  auto testStart = journal.getLatest()->sequenceID;
+
+  auto root = mount.getEdenMount()->getRootInode();
+  root->removeRecursively(
+          "bigdir"_pc,
+          InvalidationRequired::No,
+          ObjectFetchContext::getNullContext())
+      .get(0ms);
+
+  EXPECT_THROW_ERRNO(mount.getTreeInode("bigdir"_relpath), ENOENT);
+
+  // The whole directory was removed at once.
+  auto summedDelta = journal.accumulateRange(testStart);
+  EXPECT_EQ(1, summedDelta->changedFilesInOverlay.size());
+  EXPECT_EQ(
+      1, summedDelta->changedFilesInOverlay.count(RelativePath{"bigdir"}));
+}
@@ -8,6 +8,7 @@
 #include "eden/fs/inodes/treeoverlay/TreeOverlay.h"
 
 #include <folly/File.h>
+#include <folly/logging/xlog.h>
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
 #include "eden/fs/inodes/treeoverlay/TreeOverlayWindowsFsck.h"
@@ -20,15 +21,81 @@ TreeOverlay::TreeOverlay(
     TreeOverlayStore::SynchronousMode mode)
     : path_{path.copy()}, store_{path_, mode} {}
 
+TreeOverlay::TreeOverlay(AbsolutePathPiece path, InMemorySnapshot)
+    : path_{path.copy()},
+      store_{TreeOverlayStore::loadSnapshot(path_)},
+      snapshotted_{true} {}
+
+TreeOverlay::~TreeOverlay() {
+  stopSnapshotThread();
+}
+
 std::optional<InodeNumber> TreeOverlay::initOverlay(bool createIfNonExisting) {
   if (createIfNonExisting) {
     store_.createTableIfNonExisting();
   }
   initialized_ = true;
+  if (snapshotted_ && snapshotInterval_.count() > 0) {
+    snapshotThread_ = std::thread{[this] { snapshotThread(); }};
+  }
   return store_.loadCounters();
 }
 
+void TreeOverlay::setSnapshotInterval(std::chrono::nanoseconds interval) {
+  snapshotInterval_ = interval;
+}
+
+void TreeOverlay::checkpoint() {
+  if (snapshotted_) {
+    store_.snapshotTo(path_);
+  }
+}
+
+void TreeOverlay::snapshotThread() {
+  std::unique_lock<std::mutex> lock{snapshotMutex_};
+  while (!stopSnapshots_) {
+    snapshotCondVar_.wait_for(lock, snapshotInterval_);
+    if (stopSnapshots_) {
+      break;
+    }
+    lock.unlock();
+    try {
+      checkpoint();
+    } catch (const std::exception& ex) {
+      XLOG(ERR) << "Failed to snapshot the overlay to " << path_ << ": "
+                << ex.what();
+    }
+    lock.lock();
+  }
+}
+
+void TreeOverlay::stopSnapshotThread() {
+  if (snapshotThread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock{snapshotMutex_};
+      stopSnapshots_ = true;
+    }
+    snapshotCondVar_.notify_one();
+    snapshotThread_.join();
+  }
+}
+
+void TreeOverlay::setGroupCommit(
+    size_t maxOperations,
+    std::chrono::nanoseconds window) {
+  store_.setGroupCommit(maxOperations, window);
+}
+
 void TreeOverlay::close(std::optional<InodeNumber> /*nextInodeNumber*/) {
+  stopSnapshotThread();
+  if (snapshotted_ && initialized_) {
+    try {
+      checkpoint();
+    } catch (const std::exception& ex) {
+      XLOG(ERR) << "Failed to snapshot the overlay to " << path_ << ": "
+                << ex.what();
+    }
+  }
   store_.close();
 }
 
@@ -65,6 +132,13 @@ folly::File TreeOverlay::createOverlayFile(
   EDEN_BUG() << "UNIMPLEMENTED";
 }
 
+folly::File TreeOverlay::createPooledOverlayFile(
+    InodeNumber /*inodeNumber*/,
+    const Hash20& /*contentsSha1*/,
+    const folly::IOBuf& /*contents*/) {
+  EDEN_BUG() << "UNIMPLEMENTED";
+}
+
 folly::File TreeOverlay::openFile(
     InodeNumber /*inodeNumber*/,
     folly::StringPiece /*headerId*/) {
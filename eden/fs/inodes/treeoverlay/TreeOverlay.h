@@ -8,7 +8,11 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <optional>
+#include <thread>
 
 #include "eden/fs/inodes/IOverlay.h"
 #include "eden/fs/inodes/treeoverlay/TreeOverlayStore.h"
@@ -34,7 +38,18 @@ class TreeOverlay : public IOverlay {
   explicit TreeOverlay(std::unique_ptr<SqliteDatabase> store)
       : store_(std::move(store)) {}
 
-  ~TreeOverlay() override {}
+  constexpr static struct InMemorySnapshot {
+  } inMemorySnapshot{};
+
+  /**
+   * Keep the overlay in memory, starting from the last snapshot in `path`.
+   * It is only written back to `path` by checkpoint(), every snapshot
+   * interval, and when closed, so a crash loses the changes made since the
+   * last snapshot but no change is written to disk on its own.
+   */
+  TreeOverlay(AbsolutePathPiece path, InMemorySnapshot);
+
+  ~TreeOverlay() override;
 
   TreeOverlay(const TreeOverlay&) = delete;
   TreeOverlay& operator=(const TreeOverlay&) = delete;
@@ -73,6 +88,11 @@ class TreeOverlay : public IOverlay {
       InodeNumber inodeNumber,
       const folly::IOBuf& contents) override;
 
+  folly::File createPooledOverlayFile(
+      InodeNumber inodeNumber,
+      const Hash20& contentsSha1,
+      const folly::IOBuf& contents) override;
+
   folly::File openFile(InodeNumber inodeNumber, folly::StringPiece headerId)
       override;
 
@@ -98,6 +118,13 @@ class TreeOverlay : public IOverlay {
       PathComponentPiece srcName,
       PathComponentPiece dstName) override;
 
+  void setGroupCommit(size_t maxOperations, std::chrono::nanoseconds window)
+      override;
+
+  void setSnapshotInterval(std::chrono::nanoseconds interval) override;
+
+  void checkpoint() override;
+
   InodeNumber nextInodeNumber();
 
   /**
@@ -108,10 +135,22 @@ class TreeOverlay : public IOverlay {
   InodeNumber scanLocalChanges(AbsolutePathPiece mountPath);
 
  private:
+  void snapshotThread();
+  void stopSnapshotThread();
+
   AbsolutePath path_;
 
   TreeOverlayStore store_;
 
   bool initialized_ = false;
+
+  /** Whether this is an in-memory overlay, see InMemorySnapshot. */
+  bool snapshotted_ = false;
+
+  std::chrono::nanoseconds snapshotInterval_{0};
+  std::thread snapshotThread_;
+  std::mutex snapshotMutex_;
+  std::condition_variable snapshotCondVar_;
+  bool stopSnapshots_ = false;
 };
 } // namespace facebook::eden
@@ -8,7 +8,11 @@
 #include "eden/fs/inodes/treeoverlay/TreeOverlayStore.h"
 
 #include <folly/Range.h>
+#include <folly/logging/xlog.h>
 #include <array>
+#include <functional>
+#include <unordered_set>
+#include <vector>
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
 #include "eden/fs/sqlite/PersistentSqliteStatement.h"
@@ -37,6 +41,9 @@ constexpr uint32_t kSchemaVersion = 1;
 // Maximum number of values when we do batch insertion
 constexpr size_t kBatchInsertSize = 8;
 
+// Read-only connections opened next to the writer one
+constexpr size_t kReadConnections = 4;
+
 } // namespace
 
 struct TreeOverlayStore::StatementCache {
@@ -77,6 +84,12 @@ struct TreeOverlayStore::StatementCache {
             "UPDATE ",
             kEntryTable,
             " SET parent = ?, name = ? WHERE parent = ? AND name = ?"},
+        beginTransaction{db, "BEGIN"},
+        commitTransaction{db, "COMMIT"},
+        rollbackTransaction{db, "ROLLBACK"},
+        savepoint{db, "SAVEPOINT operation"},
+        releaseSavepoint{db, "RELEASE operation"},
+        rollbackToSavepoint{db, "ROLLBACK TO operation"},
         batchInsert{
             makeBatchInsert(db, 1),
             makeBatchInsert(db, 2),
@@ -116,9 +129,36 @@ struct TreeOverlayStore::StatementCache {
   PersistentSqliteStatement deleteChild;
   PersistentSqliteStatement hasChild;
   PersistentSqliteStatement renameChild;
+  PersistentSqliteStatement beginTransaction;
+  PersistentSqliteStatement commitTransaction;
+  PersistentSqliteStatement rollbackTransaction;
+  PersistentSqliteStatement savepoint;
+  PersistentSqliteStatement releaseSavepoint;
+  PersistentSqliteStatement rollbackToSavepoint;
   std::array<PersistentSqliteStatement, kBatchInsertSize> batchInsert;
 };
 
+// The statements of loadTree and hasTree, prepared for each connection they
+// run on.
+struct TreeOverlayStore::ReadStatementCache {
+  explicit ReadStatementCache(SqliteDatabase::Connection& db)
+      : selectTree{
+            db,
+            "SELECT name, dtype, inode, hash FROM ",
+            kEntryTable,
+            " WHERE parent = ? ORDER BY name"},
+        hasTree{db, "SELECT 1 FROM ", kEntryTable, " WHERE parent = ?"},
+        beginTransaction{db, "BEGIN"},
+        commitTransaction{db, "COMMIT"},
+        rollbackTransaction{db, "ROLLBACK"} {}
+
+  PersistentSqliteStatement selectTree;
+  PersistentSqliteStatement hasTree;
+  PersistentSqliteStatement beginTransaction;
+  PersistentSqliteStatement commitTransaction;
+  PersistentSqliteStatement rollbackTransaction;
+};
+
 TreeOverlayStore::TreeOverlayStore(
     AbsolutePathPiece path,
     TreeOverlayStore::SynchronousMode synchronous_mode) {
@@ -143,20 +183,76 @@ TreeOverlayStore::TreeOverlayStore(std::unique_ptr<SqliteDatabase> db)
 
 // We must define the destructor here because of incomplete definition of
 // `StatementCache`
-TreeOverlayStore::~TreeOverlayStore() = default;
+TreeOverlayStore::~TreeOverlayStore() {
+  stopGroupCommitThread();
+}
+
+void TreeOverlayStore::stopGroupCommitThread() {
+  if (groupCommitThread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock{groupMutex_};
+      stopGroupCommit_ = true;
+    }
+    groupCondVar_.notify_one();
+    groupCommitThread_.join();
+  }
+}
 
 void TreeOverlayStore::close() {
+  stopGroupCommitThread();
+  if (cache_) {
+    try {
+      flush();
+    } catch (const std::exception& ex) {
+      XLOG(ERR) << "Failed to commit the last tree overlay operations: "
+                << ex.what();
+    }
+  }
   cache_.reset();
+  resetReadCaches();
   if (db_) {
     db_->close();
   }
 }
 
 std::unique_ptr<SqliteDatabase> TreeOverlayStore::takeDatabase() {
+  stopGroupCommitThread();
+  if (cache_) {
+    flush();
+  }
   cache_.reset();
+  resetReadCaches();
   return std::move(db_);
 }
 
+void TreeOverlayStore::resetReadCaches() {
+  writerReads_.reset();
+  for (auto& cache : readerCaches_) {
+    *cache.wlock() = nullptr;
+  }
+}
+
+std::unique_ptr<SqliteDatabase> TreeOverlayStore::loadSnapshot(
+    AbsolutePathPiece dir) {
+  ensureDirectoryExists(dir);
+  auto db = std::make_unique<SqliteDatabase>(SqliteDatabase::inMemory);
+  SqliteDatabase snapshot{dir + kTreeStorePath};
+  auto snapshotConn = snapshot.lock();
+  auto conn = db->lock();
+  SqliteDatabase::backup(snapshotConn, conn);
+  return db;
+}
+
+void TreeOverlayStore::snapshotTo(AbsolutePathPiece dir) {
+  SqliteDatabase snapshot{dir + kTreeStorePath};
+  auto snapshotConn = snapshot.lock();
+  auto conn = db_->lock();
+  if (groupOpen_) {
+    commitGroup(conn);
+  }
+  SqliteDatabase::backup(conn, snapshotConn);
+}
+
 void TreeOverlayStore::createTableIfNonExisting() {
   // TODO: check `user_version` and migrate schema if necessary
   db_->transaction([&](auto& txn) {
@@ -220,7 +316,14 @@ void TreeOverlayStore::createTableIfNonExisting() {
   {
     auto conn = db_->lock();
     cache_ = std::make_unique<StatementCache>(conn);
+    writerReads_ = std::make_unique<ReadStatementCache>(conn);
   }
+
+  // The statements of each reader are prepared on its first use.
+  db_->openReadConnections(kReadConnections);
+  readerCaches_ =
+      std::vector<folly::Synchronized<std::unique_ptr<ReadStatementCache>>>(
+          db_->readConnectionCount());
 }
 
 InodeNumber TreeOverlayStore::loadCounters() {
@@ -263,33 +366,64 @@ InodeNumber TreeOverlayStore::nextInodeNumber() {
 void TreeOverlayStore::saveTree(
     InodeNumber inodeNumber,
     const overlay::OverlayDir& odir) {
-  db_->transaction([&](auto& txn) {
+  transaction([&](auto& txn) {
     // When `saveTree` gets called, caller is expected to rewrite the tree
-    // content. So we need to remove the previously stored version.
-    auto& stmt = cache_->deleteParent.get(txn);
-    stmt.bind(1, inodeNumber.get());
-    stmt.step();
+    // content. Most callers only changed a few entries of the previously
+    // stored version though, so only the rows that differ are replaced,
+    // instead of deleting and inserting the whole tree.
+    const auto& entries = *odir.entries_ref();
+    std::vector<std::string> removed;
+    std::unordered_set<std::string> unchanged;
+    auto& query = cache_->selectTree.get(txn);
+    query.bind(1, inodeNumber.get());
+    while (query.step()) {
+      auto name = query.columnBlob(0);
+      auto iter = entries.find(name.str());
+      if (iter != entries.end() &&
+          isSameEntry(
+              iter->second,
+              query.columnUint64(1),
+              query.columnUint64(2),
+              query.columnBlob(3))) {
+        unchanged.insert(name.str());
+      } else {
+        removed.push_back(name.str());
+      }
+    }
+
+    for (const auto& name : removed) {
+      auto& stmt = cache_->deleteChild.get(txn);
+      stmt.bind(1, inodeNumber.get());
+      stmt.bind(2, name);
+      stmt.step();
+    }
 
     // The following section generates the insertion SQLite statements based
-    // on number of entries in `OverlayDir`. This is faster than inserting
-    // them separately. Although we have to dynamically generate statements
-    // here.
-    auto count = odir.entries_ref()->size();
+    // on number of entries to insert. This is faster than inserting them
+    // separately. Although we have to dynamically generate statements here.
+    std::vector<const std::pair<const std::string, overlay::OverlayEntry>*>
+        inserted;
+    for (const auto& entry : entries) {
+      if (!unchanged.count(entry.first)) {
+        inserted.push_back(&entry);
+      }
+    }
+    auto count = inserted.size();
     if (count == 0) {
       return;
     }
 
     size_t batch_count = count / kBatchInsertSize;
     auto remaining = count % kBatchInsertSize;
-    auto entries_iter = odir.entries_ref()->cbegin();
+    auto entries_iter = inserted.cbegin();
 
     if (batch_count != 0) {
       auto& batch_insert = cache_->batchInsert[kBatchInsertSize - 1].get(txn);
       for (size_t i = 0; i < batch_count; i++) {
         // One batch
         for (size_t n = 0; n < kBatchInsertSize; n++, entries_iter++) {
-          auto name = PathComponentPiece{entries_iter->first};
-          const auto& entry = entries_iter->second;
+          auto name = PathComponentPiece{(*entries_iter)->first};
+          const auto& entry = (*entries_iter)->second;
           insertInodeEntry(batch_insert, n, inodeNumber, name, entry);
         }
 
@@ -300,10 +434,10 @@ void TreeOverlayStore::saveTree(
 
     if (remaining != 0) {
       auto& insert = cache_->batchInsert[remaining - 1].get(txn);
-      for (size_t n = 0; entries_iter != odir.entries_ref()->cend();
+      for (size_t n = 0; entries_iter != inserted.cend();
            entries_iter++, n++) {
-        auto name = PathComponentPiece{entries_iter->first};
-        const auto& entry = entries_iter->second;
+        auto name = PathComponentPiece{(*entries_iter)->first};
+        const auto& entry = (*entries_iter)->second;
         insertInodeEntry(insert, n, inodeNumber, name, entry);
       }
       insert.step();
@@ -311,11 +445,28 @@ void TreeOverlayStore::saveTree(
   });
 }
 
+bool TreeOverlayStore::isSameEntry(
+    const overlay::OverlayEntry& entry,
+    uint64_t dtype,
+    uint64_t inode,
+    folly::StringPiece hash) {
+  auto mode = static_cast<uint32_t>(entry.mode_ref().value());
+  if (dtype != static_cast<uint64_t>(mode_to_dtype(mode)) ||
+      inode != static_cast<uint64_t>(entry.inodeNumber_ref().value())) {
+    return false;
+  }
+  folly::StringPiece entryHash;
+  if (auto entryHashRef = entry.hash_ref()) {
+    entryHash = *entryHashRef;
+  }
+  return entryHash == hash;
+}
+
 overlay::OverlayDir TreeOverlayStore::loadTree(InodeNumber inode) {
   overlay::OverlayDir dir;
 
-  db_->transaction([&](auto& txn) {
-    auto& query = cache_->selectTree.get(txn);
+  readTransaction([&](auto& txn, ReadStatementCache& statements) {
+    auto& query = statements.selectTree.get(txn);
     query.bind(1, inode.get());
 
     while (query.step()) {
@@ -335,7 +486,7 @@ overlay::OverlayDir TreeOverlayStore::loadTree(InodeNumber inode) {
 overlay::OverlayDir TreeOverlayStore::loadAndRemoveTree(InodeNumber inode) {
   overlay::OverlayDir dir;
 
-  db_->transaction([&](auto& txn) {
+  transaction([&](auto& txn) {
     // SQLite does not support select-and-delete in one query.
     auto& query = cache_->selectTree.get(txn);
     query.bind(1, inode.get());
@@ -360,7 +511,7 @@ overlay::OverlayDir TreeOverlayStore::loadAndRemoveTree(InodeNumber inode) {
 }
 
 void TreeOverlayStore::removeTree(InodeNumber inode) {
-  db_->transaction([&](auto& txn) {
+  transaction([&](auto& txn) {
     auto& children = cache_->countChildren.get(txn);
     children.bind(1, inode.get());
 
@@ -376,33 +527,35 @@ void TreeOverlayStore::removeTree(InodeNumber inode) {
 }
 
 bool TreeOverlayStore::hasTree(InodeNumber inode) {
-  auto db = db_->lock();
-  auto& query = cache_->hasTree.get(db);
-  query.bind(1, inode.get());
-  if (query.step()) {
-    return query.columnUint64(0) == 1;
-  }
-  return false;
+  bool found = false;
+  readTransaction([&](auto& txn, ReadStatementCache& statements) {
+    auto& query = statements.hasTree.get(txn);
+    query.bind(1, inode.get());
+    found = query.step() && query.columnUint64(0) == 1;
+  });
+  return found;
 }
 
 void TreeOverlayStore::addChild(
     InodeNumber parent,
     PathComponentPiece name,
     overlay::OverlayEntry entry) {
-  auto db = db_->lock();
-  auto& stmt = cache_->insertChild.get(db);
-  insertInodeEntry(stmt, 0, parent, name, entry);
-  stmt.step();
+  transaction([&](auto& txn) {
+    auto& stmt = cache_->insertChild.get(txn);
+    insertInodeEntry(stmt, 0, parent, name, entry);
+    stmt.step();
+  });
 }
 
 void TreeOverlayStore::removeChild(
     InodeNumber parent,
     PathComponentPiece childName) {
-  auto db = db_->lock();
-  auto& stmt = cache_->deleteChild.get(db);
-  stmt.bind(1, parent.get());
-  stmt.bind(2, childName.stringPiece());
-  stmt.step();
+  transaction([&](auto& txn) {
+    auto& stmt = cache_->deleteChild.get(txn);
+    stmt.bind(1, parent.get());
+    stmt.bind(2, childName.stringPiece());
+    stmt.step();
+  });
 }
 
 void TreeOverlayStore::renameChild(
@@ -412,7 +565,7 @@ void TreeOverlayStore::renameChild(
     PathComponentPiece dstName) {
   // When rename also overwrites some file in the destination, we need to make
   // sure this is transactional.
-  db_->transaction([&](auto& txn) {
+  transaction([&](auto& txn) {
     auto& overwriteEmpty = cache_->hasChild.get(txn);
     overwriteEmpty.bind(1, dst.get());
     overwriteEmpty.bind(2, dstName.stringPiece());
@@ -436,6 +589,139 @@ void TreeOverlayStore::renameChild(
   });
 }
 
+void TreeOverlayStore::setGroupCommit(
+    size_t maxOperations,
+    std::chrono::steady_clock::duration window) {
+  XCHECK(!groupCommitThread_.joinable()) << "group commit is already set up";
+  if (maxOperations <= 1) {
+    return;
+  }
+  groupMaxOperations_ = maxOperations;
+  groupWindow_ = window;
+  groupCommitThread_ = std::thread{[this] { groupCommitThread(); }};
+}
+
+void TreeOverlayStore::flush() {
+  auto conn = db_->lock();
+  if (groupOpen_) {
+    commitGroup(conn);
+  }
+}
+
+void TreeOverlayStore::transaction(
+    const std::function<void(SqliteDatabase::Connection&)>& func) {
+  auto conn = db_->lock();
+  if (groupMaxOperations_ != 0 && !groupOpen_) {
+    cache_->beginTransaction.get(conn).step();
+    groupOpen_ = true;
+    groupOperations_ = 0;
+    {
+      std::lock_guard<std::mutex> lock{groupMutex_};
+      groupDeadline_ = std::chrono::steady_clock::now() + groupWindow_;
+    }
+    groupCondVar_.notify_one();
+  }
+
+  if (!groupOpen_) {
+    try {
+      cache_->beginTransaction.get(conn).step();
+      func(conn);
+      cache_->commitTransaction.get(conn).step();
+    } catch (const std::exception& ex) {
+      cache_->rollbackTransaction.get(conn).step();
+      XLOG(WARN) << "SQLite transaction failed: " << ex.what();
+      throw;
+    }
+    return;
+  }
+
+  // Each operation of a group is a savepoint, so that a failed operation
+  // is undone without undoing the others.
+  try {
+    cache_->savepoint.get(conn).step();
+    func(conn);
+    cache_->releaseSavepoint.get(conn).step();
+  } catch (const std::exception& ex) {
+    cache_->rollbackToSavepoint.get(conn).step();
+    cache_->releaseSavepoint.get(conn).step();
+    XLOG(WARN) << "SQLite transaction failed: " << ex.what();
+    throw;
+  }
+  if (++groupOperations_ >= groupMaxOperations_) {
+    commitGroup(conn);
+  }
+}
+
+void TreeOverlayStore::readTransaction(const ReadFunction& func) {
+  auto run = [&](SqliteDatabase::Connection& conn,
+                 ReadStatementCache& statements) {
+    try {
+      statements.beginTransaction.get(conn).step();
+      func(conn, statements);
+      statements.commitTransaction.get(conn).step();
+    } catch (const std::exception& ex) {
+      statements.rollbackTransaction.get(conn).step();
+      XLOG(WARN) << "SQLite transaction failed: " << ex.what();
+      throw;
+    }
+  };
+
+  // The read connections only see committed writes, so they can't be used
+  // while a group is open. A group opened after this check only holds
+  // writes that raced with this read.
+  if (!readerCaches_.empty() && !groupOpen_.load(std::memory_order_acquire)) {
+    auto reader = db_->lockRead();
+    auto statements = readerCaches_[reader.index].wlock();
+    if (!*statements) {
+      *statements = std::make_unique<ReadStatementCache>(reader.conn);
+    }
+    run(reader.conn, **statements);
+    return;
+  }
+
+  auto conn = db_->lock();
+  if (groupOpen_) {
+    // The connection already sees the writes of the open group, and holding
+    // its lock keeps them from changing.
+    func(conn, *writerReads_);
+    return;
+  }
+  run(conn, *writerReads_);
+}
+
+void TreeOverlayStore::commitGroup(SqliteDatabase::Connection& conn) {
+  cache_->commitTransaction.get(conn).step();
+  groupOpen_.store(false, std::memory_order_release);
+  std::lock_guard<std::mutex> lock{groupMutex_};
+  groupDeadline_.reset();
+}
+
+void TreeOverlayStore::groupCommitThread() {
+  std::unique_lock<std::mutex> lock{groupMutex_};
+  while (!stopGroupCommit_) {
+    if (!groupDeadline_) {
+      groupCondVar_.wait(lock);
+      continue;
+    }
+    if (std::chrono::steady_clock::now() < *groupDeadline_) {
+      groupCondVar_.wait_until(lock, *groupDeadline_);
+      continue;
+    }
+
+    // The database lock is always acquired before groupMutex_.
+    lock.unlock();
+    try {
+      flush();
+    } catch (const std::exception& ex) {
+      XLOG(ERR) << "Failed to commit tree overlay operations: " << ex.what();
+      lock.lock();
+      groupDeadline_ = std::chrono::steady_clock::now() + groupWindow_;
+      continue;
+    }
+    lock.lock();
+  }
+}
+
 void TreeOverlayStore::insertInodeEntry(
     SqliteStatement& inserts,
     size_t index,
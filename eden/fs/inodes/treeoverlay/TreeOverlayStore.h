@@ -9,7 +9,14 @@
 
 #include <gtest/gtest_prod.h>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
 
 #include <fmt/format.h>
 #include "eden/fs/sqlite/SqliteDatabase.h"
@@ -134,12 +141,45 @@ class TreeOverlayStore {
       PathComponentPiece srcName,
       PathComponentPiece dstName);
 
+  /**
+   * Commit the write operations in groups of up to maxOperations, or of the
+   * operations issued within window of the first one, instead of one
+   * transaction each. This saves a sync of the database per operation, but
+   * the operations of a group that isn't committed yet are lost if the
+   * process dies. Grouping is disabled when maxOperations is at most 1.
+   *
+   * Must be called at most once, before any operation.
+   */
+  void setGroupCommit(
+      size_t maxOperations,
+      std::chrono::steady_clock::duration window);
+
+  /**
+   * Commit the current group of operations, if any. All the operations that
+   * returned before this is called are durable once it returns.
+   */
+  void flush();
+
   std::unique_ptr<SqliteDatabase> takeDatabase();
 
+  /**
+   * Create an in-memory database holding a copy of the store in `dir`, for a
+   * store that is only written to disk by snapshotTo().
+   */
+  static std::unique_ptr<SqliteDatabase> loadSnapshot(AbsolutePathPiece dir);
+
+  /**
+   * Replace the store in `dir` with a copy of this one, committing the open
+   * group of operations first.
+   */
+  void snapshotTo(AbsolutePathPiece dir);
+
  private:
   FRIEND_TEST(TreeOverlayStoreTest, testRecoverInodeEntryNumber);
+  FRIEND_TEST(TreeOverlayStoreTest, testSavingTreeOnlyRewritesChangedEntries);
 
   struct StatementCache;
+  struct ReadStatementCache;
 
   /**
    * Private helper function to add a SQLite statement that inserts a row to the
@@ -152,10 +192,72 @@ class TreeOverlayStore {
       PathComponentPiece name,
       const overlay::OverlayEntry& entry);
 
+  /**
+   * Whether entry is the same as the stored row with the given columns.
+   */
+  static bool isSameEntry(
+      const overlay::OverlayEntry& entry,
+      uint64_t dtype,
+      uint64_t inode,
+      folly::StringPiece hash);
+
+  /**
+   * Run func in its own transaction, or as part of the current group when
+   * group commit is enabled.
+   */
+  void transaction(
+      const std::function<void(SqliteDatabase::Connection&)>& func);
+
+  /**
+   * Run the read-only func in a transaction, on one of the read connections
+   * of the database if there are any, or as part of the current group if one
+   * is open.
+   */
+  using ReadFunction =
+      std::function<void(SqliteDatabase::Connection&, ReadStatementCache&)>;
+  void readTransaction(const ReadFunction& func);
+
+  void resetReadCaches();
+
+  void commitGroup(SqliteDatabase::Connection& conn);
+
+  void groupCommitThread();
+  void stopGroupCommitThread();
+
   std::unique_ptr<SqliteDatabase> db_;
 
   std::unique_ptr<StatementCache> cache_;
 
+  // The read statements of the writer connection.
+  std::unique_ptr<ReadStatementCache> writerReads_;
+
+  /**
+   * The read statements of each read connection, by index. Each one is only
+   * used with its connection locked, but its own lock keeps the uses by
+   * resetReadCaches() safe.
+   */
+  std::vector<folly::Synchronized<std::unique_ptr<ReadStatementCache>>>
+      readerCaches_;
+
+  size_t groupMaxOperations_{0};
+  std::chrono::steady_clock::duration groupWindow_{};
+
+  // Only changed with the database locked, but read without it to decide
+  // whether the read connections can be used.
+  std::atomic<bool> groupOpen_{false};
+  // Only accessed with the database locked.
+  size_t groupOperations_{0};
+
+  /**
+   * Protects groupDeadline_ and stopGroupCommit_, which wake up
+   * groupCommitThread_ to commit the open group once its window elapsed.
+   */
+  std::mutex groupMutex_;
+  std::condition_variable groupCondVar_;
+  std::optional<std::chrono::steady_clock::time_point> groupDeadline_;
+  bool stopGroupCommit_{false};
+  std::thread groupCommitThread_;
+
   std::atomic_uint64_t nextEntryId_{0};
 
   std::atomic_uint64_t nextInode_{0};
@@ -8,11 +8,18 @@
 #include "eden/fs/inodes/treeoverlay/TreeOverlayWindowsFsck.h"
 
 #ifdef _WIN32
-#include <boost/filesystem.hpp>
+#include <fmt/format.h>
+#include <folly/ScopeGuard.h>
 #include <folly/portability/Windows.h>
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 #include <ProjectedFSLib.h> // @manual
-#include <winioctl.h> // @manual
 
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
@@ -23,8 +30,6 @@
 namespace facebook::eden {
 namespace {
 
-namespace boost_fs = boost::filesystem;
-
 PRJ_FILE_STATE getPrjFileState(AbsolutePathPiece entry) {
   auto wpath = entry.wide();
   PRJ_FILE_STATE state;
@@ -47,109 +52,79 @@ std::set<PathComponent> makeEntriesSet(const overlay::OverlayDir& dir) {
   return result;
 }
 
-namespace {
 // Reparse tag for UNIX domain socket is not defined in Windows header files.
 const ULONG IO_REPARSE_TAG_SOCKET = 0x80000023;
 
-// This is only defined in Windows Device Driver Kit and it is inconvenient to
-// include. This is copied from Watchman's FileDescriptor.cpp.
-struct REPARSE_DATA_BUFFER {
-  ULONG ReparseTag;
-  USHORT ReparseDataLength;
-  USHORT Reserved;
-  union {
-    struct {
-      USHORT SubstituteNameOffset;
-      USHORT SubstituteNameLength;
-      USHORT PrintNameOffset;
-      USHORT PrintNameLength;
-      ULONG Flags;
-      WCHAR PathBuffer[1];
-    } SymbolicLinkReparseBuffer;
-    struct {
-      USHORT SubstituteNameOffset;
-      USHORT SubstituteNameLength;
-      USHORT PrintNameOffset;
-      USHORT PrintNameLength;
-      WCHAR PathBuffer[1];
-    } MountPointReparseBuffer;
-    struct {
-      UCHAR DataBuffer[1];
-    } GenericReparseBuffer;
-  };
-};
-} // namespace
-
-dtype_t dtypeFromEntry(const boost::filesystem::directory_entry& entry) {
-  XLOGF(DBG9, "dtypeFromEntry: {}", entry.path().string().c_str());
-  auto path = entry.path().wstring();
-  WIN32_FILE_ATTRIBUTE_DATA attrs;
-
-  if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &attrs)) {
-    XLOGF(
-        DBG3,
-        "Unable to get file attributes for {}: {}",
-        entry.path().string(),
-        GetLastError());
-    return dtype_t::Unknown;
-  }
-
-  if (attrs.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) {
-    auto handle = CreateFileW(
-        path.c_str(),
-        FILE_GENERIC_READ,
-        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
-        NULL,
-        OPEN_EXISTING,
-        FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OPEN_REPARSE_POINT,
-        NULL);
-    if (handle == INVALID_HANDLE_VALUE) {
-      XLOGF(
-          DBG3,
-          "Unable to determine reparse point type for {}: {}",
-          entry.path().string(),
-          GetLastError());
-      return dtype_t::Unknown;
-    }
-
-    char buffer[MAXIMUM_REPARSE_DATA_BUFFER_SIZE];
-    DWORD bytes_written;
-
-    if (!DeviceIoControl(
-            handle,
-            FSCTL_GET_REPARSE_POINT,
-            NULL,
-            0,
-            buffer,
-            MAXIMUM_REPARSE_DATA_BUFFER_SIZE,
-            &bytes_written,
-            NULL)) {
-      XLOGF(
-          DBG3,
-          "Unable to read reparse point data for {}: {}",
-          entry.path().string(),
-          GetLastError());
-      return dtype_t::Unknown;
-    }
+// At most this many directories are scanned at once.
+constexpr unsigned kMaxScanThreads = 16;
 
-    auto reparse_data = reinterpret_cast<const REPARSE_DATA_BUFFER*>(buffer);
+// An entry of a directory on disk.
+struct DiskEntry {
+  PathComponent name;
+  dtype_t dtype;
+  PRJ_FILE_STATE state;
+};
 
-    if (reparse_data->ReparseTag == IO_REPARSE_TAG_SYMLINK) {
+dtype_t dtypeFromFindData(const WIN32_FIND_DATAW& findData) {
+  if (findData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) {
+    // The listing reports the reparse tag of reparse points.
+    if (findData.dwReserved0 == IO_REPARSE_TAG_SYMLINK) {
       return dtype_t::Symlink;
-    } else if (reparse_data->ReparseTag == IO_REPARSE_TAG_SOCKET) {
+    } else if (findData.dwReserved0 == IO_REPARSE_TAG_SOCKET) {
       return dtype_t::Regular;
     }
 
     // We don't care about other reparse point types, so treating them as
     // regular files.
     return dtype_t::Regular;
-  } else if (attrs.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+  } else if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
     return dtype_t::Dir;
   } else {
     return dtype_t::Regular;
   }
 }
 
+// List a directory with its file types, in one pass and without opening any
+// of its entries.
+std::vector<DiskEntry> listDirectory(AbsolutePathPiece dir) {
+  auto pattern = dir.wide() + L"\\*";
+  WIN32_FIND_DATAW findData;
+  // The basic info level skips the short names, and the large fetch reads
+  // the directory in fewer round trips.
+  auto handle = FindFirstFileExW(
+      pattern.c_str(),
+      FindExInfoBasic,
+      &findData,
+      FindExSearchNameMatch,
+      nullptr,
+      FIND_FIRST_EX_LARGE_FETCH);
+  if (handle == INVALID_HANDLE_VALUE) {
+    throwWin32ErrorExplicit(
+        GetLastError(), fmt::format("Unable to list {}", dir));
+  }
+  SCOPE_EXIT {
+    FindClose(handle);
+  };
+
+  std::vector<DiskEntry> entries;
+  do {
+    std::wstring_view name{findData.cFileName};
+    if (name == L"." || name == L"..") {
+      continue;
+    }
+    PathComponent component{name};
+    auto state = getPrjFileState(dir + component);
+    entries.push_back(
+        DiskEntry{std::move(component), dtypeFromFindData(findData), state});
+  } while (FindNextFileW(handle, &findData));
+
+  auto error = GetLastError();
+  if (error != ERROR_NO_MORE_FILES) {
+    throwWin32ErrorExplicit(error, fmt::format("Unable to list {}", dir));
+  }
+  return entries;
+}
+
 std::optional<overlay::OverlayEntry> getEntryFromOverlayDir(
     const overlay::OverlayDir& dir,
     PathComponentPiece name) {
@@ -200,26 +175,30 @@ void removeOverlayEntry(
   overlay.removeChild(parent, name);
 }
 
-void scanCurrentDir(
-    TreeOverlay& overlay,
-    AbsolutePathPiece dir,
-    InodeNumber inode,
-    overlay::OverlayDir knownState,
-    bool recordDeletion) {
-  if (!dir.is_directory()) {
-    XLOGF(WARN, "Attempting to scan '{}' which is not a directory", dir);
-    return;
-  }
+// A directory left to scan.
+struct ScanJob {
+  AbsolutePath dir;
+  InodeNumber inode;
+  bool recordDeletion;
+};
 
+// Synchronize the overlay state of one directory with its disk state, and
+// return the subdirectories users could have changed.
+std::vector<ScanJob> scanCurrentDir(TreeOverlay& overlay, const ScanJob& job) {
+  const auto& dir = job.dir;
+  auto inode = job.inode;
   XLOGF(DBG3, "Scanning {}", dir);
 
+  // Directories added to the overlay by the scan of their parent have no
+  // entries there yet.
+  auto knownState =
+      overlay.loadOverlayDir(inode).value_or(overlay::OverlayDir{});
   auto overlayEntries = makeEntriesSet(knownState);
+  auto diskEntries = listDirectory(dir);
   // Loop to synchronize overlay state with disk state
-  for (const auto& entry :
-       boost::filesystem::directory_iterator(dir.as_boost())) {
-    auto path = AbsolutePath{entry.path().c_str()};
-    auto name = path.basename();
-    auto dtype = dtypeFromEntry(entry);
+  for (const auto& entry : diskEntries) {
+    const auto& name = entry.name;
+    auto dtype = entry.dtype;
 
     // TODO: EdenFS for Windows does not support symlinks yet, the only
     // symlink we have are redirection points.
@@ -261,9 +240,8 @@ void scanCurrentDir(
       }
     }
 
-    auto state = getPrjFileState(path);
     auto isTombstone =
-        (state & PRJ_FILE_STATE_TOMBSTONE) == PRJ_FILE_STATE_TOMBSTONE;
+        (entry.state & PRJ_FILE_STATE_TOMBSTONE) == PRJ_FILE_STATE_TOMBSTONE;
 
     // Tombstone residue may still linger around when EdenFS is not running.
     // These represent files are deleted and we should not add them back.
@@ -281,7 +259,7 @@ void scanCurrentDir(
   // DirtyPlaceholder directory may hide entries that were not previously
   // accessed when EdenFS is not running, which could lead fsck to remove
   // entries from overlay incorrectly.
-  if (recordDeletion && !overlayEntries.empty()) {
+  if (job.recordDeletion && !overlayEntries.empty()) {
     // Files in overlay are not present on disk, remove them.
     for (auto removed = overlayEntries.cbegin();
          removed != overlayEntries.cend();
@@ -296,43 +274,119 @@ void scanCurrentDir(
   auto updated = *overlay.loadOverlayDir(inode);
 
   // Now that this overlay directory is consistent with the on-disk state,
-  // proceed to its children.
-  for (const auto& entry :
-       boost::filesystem::directory_iterator(dir.as_boost())) {
-    auto path = AbsolutePath{entry.path().c_str()};
-    auto mode = dtypeFromEntry(entry);
-
+  // its children can be scanned.
+  std::vector<ScanJob> children;
+  for (const auto& entry : diskEntries) {
     // We can't scan non-directories nor follow symlinks
-    if (mode == dtype_t::Symlink) {
-      XLOGF(DBG5, "Skipped {} since it's a symlink", path);
+    if (entry.dtype == dtype_t::Symlink) {
+      XLOGF(DBG5, "Skipped {} since it's a symlink", dir + entry.name);
       continue;
-    } else if (mode != dtype_t::Dir) {
+    } else if (entry.dtype != dtype_t::Dir) {
       continue;
     }
 
-    auto state = getPrjFileState(path);
     // User can only modify directory content if it is Full or Dirty
     // Placeholder.
-    auto isFull = (state & PRJ_FILE_STATE_FULL) == PRJ_FILE_STATE_FULL;
-    auto isDirtyPlaceholder = (state & PRJ_FILE_STATE_DIRTY_PLACEHOLDER) ==
+    auto isFull = (entry.state & PRJ_FILE_STATE_FULL) == PRJ_FILE_STATE_FULL;
+    auto isDirtyPlaceholder =
+        (entry.state & PRJ_FILE_STATE_DIRTY_PLACEHOLDER) ==
         PRJ_FILE_STATE_DIRTY_PLACEHOLDER;
     if (isFull || isDirtyPlaceholder) {
-      auto overlayEntry = getEntryFromOverlayDir(updated, path.basename());
+      auto overlayEntry = getEntryFromOverlayDir(updated, entry.name);
       auto entryInode =
           InodeNumber::fromThrift(*overlayEntry->inodeNumber_ref());
-      auto entryDir = overlay.loadOverlayDir(entryInode);
-      scanCurrentDir(overlay, path, entryInode, *entryDir, isFull);
+      children.push_back(ScanJob{dir + entry.name, entryInode, isFull});
     }
   }
+  return children;
 }
+
+/**
+ * Scan the directories of a tree on several threads. Every directory is a
+ * job, and subdirectories are queued once their parent is consistent, so
+ * the threads share the work however unbalanced the tree is.
+ */
+class ParallelScan {
+ public:
+  explicit ParallelScan(TreeOverlay& overlay) : overlay_{overlay} {}
+
+  void run(ScanJob root) {
+    jobs_.push_back(std::move(root));
+    auto numThreads =
+        std::clamp(std::thread::hardware_concurrency(), 1u, kMaxScanThreads);
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < numThreads; ++i) {
+      threads.emplace_back([this] { work(); });
+    }
+    work();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+ private:
+  void work() {
+    std::unique_lock<std::mutex> lock{mutex_};
+    for (;;) {
+      // Until a failure, other threads may still queue more jobs.
+      cond_.wait(lock, [this] { return !jobs_.empty() || running_ == 0; });
+      if (jobs_.empty() || error_) {
+        return;
+      }
+      auto job = std::move(jobs_.back());
+      jobs_.pop_back();
+      ++running_;
+      lock.unlock();
+
+      std::vector<ScanJob> children;
+      std::exception_ptr error;
+      try {
+        children = scanCurrentDir(overlay_, job);
+      } catch (const std::exception& ex) {
+        XLOGF(ERR, "Unable to scan {}: {}", job.dir, ex.what());
+        error = std::current_exception();
+      }
+
+      lock.lock();
+      --running_;
+      if (error) {
+        if (!error_) {
+          error_ = error;
+        }
+        jobs_.clear();
+      } else if (!error_) {
+        for (auto& child : children) {
+          jobs_.push_back(std::move(child));
+        }
+      }
+      cond_.notify_all();
+    }
+  }
+
+  TreeOverlay& overlay_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  // Protected by mutex_.
+  std::vector<ScanJob> jobs_;
+  size_t running_{0};
+  std::exception_ptr error_;
+};
 } // namespace
 
 void windowsFsckScanLocalChanges(
     TreeOverlay& overlay,
     AbsolutePathPiece mountPath) {
   XLOGF(INFO, "Start scanning {}", mountPath);
-  if (auto view = overlay.loadOverlayDir(kRootNodeId)) {
-    scanCurrentDir(overlay, mountPath, kRootNodeId, *view, false);
+  if (overlay.loadOverlayDir(kRootNodeId)) {
+    if (!mountPath.is_directory()) {
+      XLOGF(
+          WARN, "Attempting to scan '{}' which is not a directory", mountPath);
+      return;
+    }
+    ParallelScan{overlay}.run(ScanJob{mountPath.copy(), kRootNodeId, false});
     XLOGF(INFO, "Scanning complete for {}", mountPath);
   } else {
     XLOG(INFO)
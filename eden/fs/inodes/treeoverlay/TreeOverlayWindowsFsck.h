@@ -44,6 +44,8 @@ class TreeOverlay;
  *
  * See also: https://docs.microsoft.com/en-us/windows/win32/projfs/cache-state
  *
+ * Directories are scanned on several threads, each one once its parent is
+ * consistent with the disk.
  */
 void windowsFsckScanLocalChanges(
     TreeOverlay& overlay,
@@ -7,10 +7,14 @@
 
 #include "eden/fs/inodes/treeoverlay/TreeOverlayStore.h"
 
+#include <folly/experimental/TestUtil.h>
 #include <folly/logging/xlog.h>
 #include <folly/portability/GTest.h>
+#include <chrono>
 #include <memory>
 #include <optional>
+#include <thread>
+#include <vector>
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
 #include "eden/fs/model/Hash.h"
@@ -142,6 +146,31 @@ TEST_F(TreeOverlayStoreTest, testSavingTreeOverwrite) {
   expect_entries(*newDir.entries_ref(), *loaded.entries_ref());
 }
 
+TEST_F(TreeOverlayStoreTest, testSavingTreeOnlyRewritesChangedEntries) {
+  auto inode = InodeNumber{overlay_->nextInodeNumber()};
+  overlay::OverlayDir dir;
+  dir.entries_ref()->emplace(std::make_pair("hello", makeEntry()));
+  dir.entries_ref()->emplace(std::make_pair("world", makeEntry()));
+  dir.entries_ref()->emplace(std::make_pair(
+      "foo",
+      makeEntry(
+          Hash20{"aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"}, dtype_t::Dir)));
+  overlay_->saveTree(inode, dir);
+  auto entryId = overlay_->nextEntryId_.load();
+
+  // Materialize "foo", remove "world" and add "bar".
+  (*dir.entries_ref())["foo"].hash_ref().reset();
+  dir.entries_ref()->erase("world");
+  dir.entries_ref()->emplace(std::make_pair("bar", makeEntry()));
+  overlay_->saveTree(inode, dir);
+
+  // Only "foo" and "bar" were inserted again.
+  EXPECT_EQ(entryId + 2, overlay_->nextEntryId_.load());
+  auto loaded = overlay_->loadTree(inode);
+  ASSERT_EQ(dir.entries_ref()->size(), loaded.entries_ref()->size());
+  expect_entries(*dir.entries_ref(), *loaded.entries_ref());
+}
+
 TEST_F(TreeOverlayStoreTest, testHasTree) {
   auto inode = InodeNumber{overlay_->nextInodeNumber()};
   EXPECT_FALSE(overlay_->hasTree(inode));
@@ -154,6 +183,45 @@ TEST_F(TreeOverlayStoreTest, testHasTree) {
   EXPECT_FALSE(overlay_->hasTree(InodeNumber{overlay_->nextInodeNumber()}));
 }
 
+TEST_F(TreeOverlayStoreTest, testReadConnections) {
+  folly::test::TemporaryDirectory testDir;
+  TreeOverlayStore store{AbsolutePath{testDir.path().string()}};
+  store.createTableIfNonExisting();
+  store.loadCounters();
+  store.setGroupCommit(100, std::chrono::hours{1});
+
+  auto inode = InodeNumber{store.nextInodeNumber()};
+  overlay::OverlayDir dir;
+  overlay::OverlayEntry entry;
+  entry.mode_ref() = dtype_to_mode(dtype_t::Regular);
+  entry.inodeNumber_ref() = store.nextInodeNumber().get();
+  dir.entries_ref()->emplace(std::make_pair("hello", entry));
+  store.saveTree(inode, dir);
+  // Reads see the writes of the open group, which only the writer can.
+  EXPECT_TRUE(store.hasTree(inode));
+  store.flush();
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < 100; ++j) {
+        EXPECT_EQ(store.loadTree(inode).entries_ref()->size(), 1);
+        EXPECT_TRUE(store.hasTree(inode));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // Writes committed on their own are seen by the next read.
+  entry.inodeNumber_ref() = store.nextInodeNumber().get();
+  store.addChild(inode, "world"_pc, entry);
+  store.flush();
+  EXPECT_EQ(store.loadTree(inode).entries_ref()->size(), 2);
+  store.close();
+}
+
 TEST_F(TreeOverlayStoreTest, testRemoveTree) {
   auto inode = InodeNumber{overlay_->nextInodeNumber()};
   overlay::OverlayDir dir;
@@ -168,6 +236,63 @@ TEST_F(TreeOverlayStoreTest, testRemoveTree) {
   EXPECT_EQ(overlay_->loadTree(inode).entries_ref()->size(), 0);
 }
 
+TEST_F(TreeOverlayStoreTest, testGroupCommit) {
+  overlay_->setGroupCommit(3, std::chrono::hours{1});
+
+  auto inode = InodeNumber{overlay_->nextInodeNumber()};
+  overlay::OverlayDir dir;
+  dir.entries_ref()->emplace(std::make_pair("hello", makeEntry()));
+  overlay_->saveTree(inode, dir);
+  overlay_->addChild(inode, "world"_pc, makeEntry());
+  EXPECT_EQ(overlay_->loadTree(inode).entries_ref()->size(), 2);
+
+  // A failed operation only undoes its own changes.
+  EXPECT_THROW(overlay_->removeTree(inode), TreeOverlayNonEmptyError);
+  overlay_->removeChild(inode, "hello"_pc);
+  overlay_->addChild(inode, "foo"_pc, makeEntry());
+  overlay_->flush();
+
+  auto loaded = overlay_->loadTree(inode);
+  ASSERT_EQ(loaded.entries_ref()->size(), 2);
+  EXPECT_EQ(loaded.entries_ref()->count("world"), 1);
+  EXPECT_EQ(loaded.entries_ref()->count("foo"), 1);
+
+  // The operations of the open group are committed before the database is
+  // handed over.
+  overlay_->addChild(inode, "bar"_pc, makeEntry());
+  auto db = overlay_->takeDatabase();
+  overlay_.reset();
+  auto newOverlay = std::make_unique<TreeOverlayStore>(std::move(db));
+  newOverlay->createTableIfNonExisting();
+  EXPECT_EQ(newOverlay->loadTree(inode).entries_ref()->size(), 3);
+}
+
+TEST_F(TreeOverlayStoreTest, testSnapshot) {
+  folly::test::TemporaryDirectory testDir;
+  auto dir = AbsolutePath{testDir.path().string()};
+
+  auto inode = InodeNumber{overlay_->nextInodeNumber()};
+  overlay::OverlayDir tree;
+  tree.entries_ref()->emplace(std::make_pair("hello", makeEntry()));
+  overlay_->saveTree(inode, tree);
+  overlay_->snapshotTo(dir);
+
+  // Changes made after the snapshot are not in it.
+  overlay_->addChild(inode, "world"_pc, makeEntry());
+
+  TreeOverlayStore restored{TreeOverlayStore::loadSnapshot(dir)};
+  restored.createTableIfNonExisting();
+  auto loaded = restored.loadTree(inode);
+  ASSERT_EQ(loaded.entries_ref()->size(), 1);
+  EXPECT_EQ(loaded.entries_ref()->count("hello"), 1);
+
+  // A newer snapshot replaces the older one.
+  overlay_->snapshotTo(dir);
+  TreeOverlayStore restoredAgain{TreeOverlayStore::loadSnapshot(dir)};
+  restoredAgain.createTableIfNonExisting();
+  EXPECT_EQ(restoredAgain.loadTree(inode).entries_ref()->size(), 2);
+}
+
 TEST_F(TreeOverlayStoreTest, testAddChild) {
   auto inode = InodeNumber{overlay_->nextInodeNumber()};
   overlay::OverlayDir dir;
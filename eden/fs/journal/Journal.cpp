@@ -6,6 +6,11 @@
  */
 
 #include "Journal.h"
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <folly/container/F14Set.h>
+#include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
 #include "eden/fs/journal/JournalDelta.h"
 
@@ -32,6 +37,11 @@ JournalDeltaPtr Journal::DeltaState::frontPtr() noexcept {
 }
 
 void Journal::DeltaState::popFront() {
+  if (!empty() && getFrontSequenceID() > checkpointedThrough &&
+      deltasSinceCheckpoint > 0) {
+    --deltasSinceCheckpoint;
+  }
+
   bool isFileChangeEmpty = fileChangeDeltas.empty();
   bool isHashUpdateEmpty = hashUpdateDeltas.empty();
   if (!isFileChangeEmpty && !isHashUpdateEmpty) {
@@ -46,6 +56,12 @@ void Journal::DeltaState::popFront() {
   } else if (!isHashUpdateEmpty) {
     hashUpdateDeltas.pop_front();
   }
+
+  while (!checkpoints.empty() &&
+         (empty() || checkpoints.front().fromSequence < getFrontSequenceID())) {
+    checkpointMemoryUsage -= checkpoints.front().estimateMemoryUsage();
+    checkpoints.pop_front();
+  }
 }
 
 JournalDeltaPtr Journal::DeltaState::backPtr() noexcept {
@@ -103,29 +119,46 @@ Journal::Journal(std::shared_ptr<EdenStats> edenStats)
 }
 
 void Journal::recordCreated(RelativePathPiece fileName) {
-  addDelta(FileChangeJournalDelta(fileName, FileChangeJournalDelta::CREATED));
+  addDelta({fileName}, [&](JournalPathTable& paths) {
+    return FileChangeJournalDelta(
+        paths.intern(fileName), FileChangeJournalDelta::CREATED);
+  });
 }
 
 void Journal::recordRemoved(RelativePathPiece fileName) {
-  addDelta(FileChangeJournalDelta(fileName, FileChangeJournalDelta::REMOVED));
+  addDelta({fileName}, [&](JournalPathTable& paths) {
+    return FileChangeJournalDelta(
+        paths.intern(fileName), FileChangeJournalDelta::REMOVED);
+  });
 }
 
 void Journal::recordChanged(RelativePathPiece fileName) {
-  addDelta(FileChangeJournalDelta(fileName, FileChangeJournalDelta::CHANGED));
+  addDelta({fileName}, [&](JournalPathTable& paths) {
+    return FileChangeJournalDelta(
+        paths.intern(fileName), FileChangeJournalDelta::CHANGED);
+  });
 }
 
 void Journal::recordRenamed(
     RelativePathPiece oldName,
     RelativePathPiece newName) {
-  addDelta(FileChangeJournalDelta(
-      oldName, newName, FileChangeJournalDelta::RENAMED));
+  addDelta({oldName, newName}, [&](JournalPathTable& paths) {
+    return FileChangeJournalDelta(
+        paths.intern(oldName),
+        paths.intern(newName),
+        FileChangeJournalDelta::RENAMED);
+  });
 }
 
 void Journal::recordReplaced(
     RelativePathPiece oldName,
     RelativePathPiece newName) {
-  addDelta(FileChangeJournalDelta(
-      oldName, newName, FileChangeJournalDelta::REPLACED));
+  addDelta({oldName, newName}, [&](JournalPathTable& paths) {
+    return FileChangeJournalDelta(
+        paths.intern(oldName),
+        paths.intern(newName),
+        FileChangeJournalDelta::REPLACED);
+  });
 }
 
 void Journal::recordHashUpdate(RootId toHash) {
@@ -150,13 +183,15 @@ void Journal::recordUncleanPaths(
   }
   RootUpdateJournalDelta delta;
   delta.fromHash = std::move(fromHash);
-  delta.uncleanPaths = std::move(uncleanPaths);
-  addDelta(std::move(delta), std::move(toHash));
+  addDelta(std::move(delta), std::move(toHash), uncleanPaths);
 }
 
 void Journal::truncateIfNecessary(DeltaState& deltaState) {
+  auto memoryLimit = static_cast<size_t>(
+      static_cast<double>(deltaState.memoryLimit) *
+      deltaState.memoryLimitScale);
   while (JournalDeltaPtr front = deltaState.frontPtr()) {
-    if (estimateMemoryUsage(deltaState) <= deltaState.memoryLimit) {
+    if (estimateMemoryUsage(deltaState) <= memoryLimit) {
       break;
     }
     deltaState.stats->entryCount--;
@@ -184,8 +219,61 @@ bool Journal::compact(
   return false;
 }
 
+void Journal::addCheckpoint(DeltaState& deltaState) {
+  deltaState.deltasSinceCheckpoint = 0;
+
+  JournalCheckpoint checkpoint;
+  auto mergeChange = [&](const JournalPath& path, const PathChangeInfo& info) {
+    auto [it, inserted] =
+        checkpoint.changedFilesInOverlay.try_emplace(path.copy(), info);
+    if (!inserted) {
+      // Deltas are visited newest first.
+      it->second.existedBefore = info.existedBefore;
+    }
+  };
+  bool empty = true;
+  auto visit = [&](const JournalDelta& current) {
+    if (empty) {
+      checkpoint.toSequence = current.sequenceID;
+      checkpoint.toTime = current.time;
+      empty = false;
+    }
+    checkpoint.fromSequence = current.sequenceID;
+    checkpoint.fromTime = current.time;
+  };
+  forEachDelta(
+      deltaState,
+      deltaState.checkpointedThrough + 1,
+      std::numeric_limits<SequenceNumber>::max(),
+      std::nullopt,
+      [&](const FileChangeJournalDelta& current) -> void {
+        visit(current);
+        ++checkpoint.fileChangeCount;
+        if (current.isPath1Valid) {
+          mergeChange(current.path1, current.info1);
+        }
+        if (current.isPath2Valid) {
+          mergeChange(current.path2, current.info2);
+        }
+      },
+      [&](const RootUpdateJournalDelta& current) -> void {
+        visit(current);
+        checkpoint.fromHashes.push_back(current.fromHash);
+        for (const auto& path : current.uncleanPaths) {
+          checkpoint.uncleanPaths.insert(path.copy());
+        }
+      });
+  if (empty) {
+    return;
+  }
+
+  deltaState.checkpointedThrough = checkpoint.toSequence;
+  deltaState.checkpointMemoryUsage += checkpoint.estimateMemoryUsage();
+  deltaState.checkpoints.push_back(std::move(checkpoint));
+}
+
 template <typename T>
-bool Journal::addDeltaBeforeNotifying(T&& delta, DeltaState& deltaState) {
+uint64_t Journal::addDeltaBeforeNotifying(T&& delta, DeltaState& deltaState) {
   delta.sequenceID = deltaState.nextSequence++;
   delta.time = std::chrono::steady_clock::now();
 
@@ -212,55 +300,177 @@ bool Journal::addDeltaBeforeNotifying(T&& delta, DeltaState& deltaState) {
       deltaState.deltaMemoryUsage = delta.estimateMemoryUsage();
     }
     deltaState.stats->latestTimestamp = delta.time;
+    if (deltaState.deltasSinceCheckpoint >= kCheckpointInterval) {
+      addCheckpoint(deltaState);
+    }
     deltaState.appendDelta(std::forward<T>(delta));
+    ++deltaState.deltasSinceCheckpoint;
   }
 
   deltaState.stats->earliestTimestamp = deltaState.frontPtr()->time;
 
-  bool shouldNotify = deltaState.lastModificationHasBeenObserved;
-  deltaState.lastModificationHasBeenObserved = false;
-  return shouldNotify;
+  return deltaState.observationCount;
 }
 
-void Journal::notifySubscribers() const {
-  auto subscribers = subscriberState_.rlock()->subscribers;
-  for (auto& sub : subscribers) {
-    sub.second();
+void Journal::notifySubscribers(
+    uint64_t observationCount,
+    folly::Range<const RelativePathPiece*> changedPaths) {
+  if (everyoneNotifiedAtObservation_.load(std::memory_order_acquire) >=
+      observationCount) {
+    return;
+  }
+
+  std::vector<SubscriberCallback> callbacks;
+  std::vector<std::pair<SubscriberId, std::chrono::nanoseconds>> deferred;
+  {
+    auto subscriberState = subscriberState_->wlock();
+    auto now = std::chrono::steady_clock::now();
+    auto interval = subscriberState->notificationInterval;
+    auto maybeNotify = [&](SubscriberId id, Subscriber& subscriber) {
+      if (subscriber.notifiedAtObservation >= observationCount) {
+        return;
+      }
+      if (subscriber.dirty) {
+        subscriber.pendingObservation =
+            std::max(subscriber.pendingObservation, observationCount);
+        return;
+      }
+      auto elapsed = now - subscriber.notifiedAt;
+      if (elapsed < interval) {
+        subscriber.dirty = true;
+        subscriber.pendingObservation = observationCount;
+        deferred.emplace_back(id, interval - elapsed);
+        return;
+      }
+      subscriber.notifiedAtObservation = observationCount;
+      subscriber.notifiedAt = now;
+      callbacks.push_back(subscriber.callback);
+    };
+
+    if (changedPaths.empty()) {
+      for (auto& entry : subscriberState->subscribers) {
+        maybeNotify(entry.first, entry.second);
+      }
+    } else {
+      auto& byRoot = subscriberState->subscribersByRoot;
+      for (auto changedPath : changedPaths) {
+        // Look up every prefix of the path, from "" to the path itself.
+        for (auto prefix : changedPath.allPaths()) {
+          auto it = byRoot.find(prefix.stringPiece());
+          if (it == byRoot.end()) {
+            continue;
+          }
+          for (auto id : it->second) {
+            maybeNotify(id, subscriberState->subscribers.at(id));
+          }
+        }
+      }
+    }
+
+    bool everyoneNotified = std::all_of(
+        subscriberState->subscribers.begin(),
+        subscriberState->subscribers.end(),
+        [&](const auto& entry) {
+          // A pending notification covers any change made before it fires.
+          return entry.second.notifiedAtObservation >= observationCount ||
+              entry.second.dirty;
+        });
+    if (everyoneNotified) {
+      everyoneNotifiedAtObservation_.store(
+          observationCount, std::memory_order_release);
+    }
+  }
+
+  for (auto& callback : callbacks) {
+    callback();
+  }
+  for (const auto& [id, delay] : deferred) {
+    folly::futures::sleep(std::chrono::ceil<std::chrono::microseconds>(delay))
+        .toUnsafeFuture()
+        .thenValue([state = std::weak_ptr{subscriberState_}, id = id](auto&&) {
+          deliverDeferredNotification(state, id);
+        });
   }
 }
 
-void Journal::addDelta(FileChangeJournalDelta&& delta) {
-  bool shouldNotify;
+void Journal::deliverDeferredNotification(
+    const std::weak_ptr<folly::Synchronized<SubscriberState>>& state,
+    SubscriberId id) {
+  auto subscriberState = state.lock();
+  if (!subscriberState) {
+    return;
+  }
+  SubscriberCallback callback;
   {
-    auto deltaState = deltaState_.lock();
-    shouldNotify = addDeltaBeforeNotifying(std::move(delta), *deltaState);
+    auto locked = subscriberState->wlock();
+    auto it = locked->subscribers.find(id);
+    if (it == locked->subscribers.end() || !it->second.dirty) {
+      return;
+    }
+    auto& subscriber = it->second;
+    subscriber.dirty = false;
+    subscriber.notifiedAtObservation = subscriber.pendingObservation;
+    subscriber.notifiedAt = std::chrono::steady_clock::now();
+    callback = subscriber.callback;
   }
-  if (shouldNotify) {
-    notifySubscribers();
+  callback();
+}
+
+void Journal::addDelta(
+    std::initializer_list<RelativePathPiece> changedPaths,
+    folly::FunctionRef<FileChangeJournalDelta(JournalPathTable&)> makeDelta) {
+  folly::Range<const RelativePathPiece*> paths{
+      changedPaths.begin(), changedPaths.end()};
+  uint64_t observationCount;
+  {
+    // JournalPaths may only be created and destroyed while holding the lock,
+    // so the delta is built, and dropped if compacted, inside this scope.
+    auto deltaState = deltaState_.lock();
+    auto delta = makeDelta(deltaState->pathTable);
+    if (deltaState->log) {
+      deltaState->log->appendFileChange(
+          deltaState->nextSequence, paths, delta.info1, delta.info2);
+    }
+    observationCount = addDeltaBeforeNotifying(std::move(delta), *deltaState);
   }
+  notifySubscribers(observationCount, paths);
 }
 
-void Journal::addDelta(RootUpdateJournalDelta&& delta, RootId newRootId) {
-  bool shouldNotify;
+void Journal::addDelta(
+    RootUpdateJournalDelta&& delta,
+    RootId newRootId,
+    const std::unordered_set<RelativePath>& uncleanPaths) {
+  uint64_t observationCount;
   {
     auto deltaState = deltaState_.lock();
+    delta.uncleanPaths.reserve(uncleanPaths.size());
+    for (const auto& path : uncleanPaths) {
+      delta.uncleanPaths.push_back(deltaState->pathTable.intern(path));
+    }
 
     // If the hashes were not set to anything, default to copying
     // the value from the prior journal entry
     if (delta.fromHash == RootId{}) {
       delta.fromHash = deltaState->currentHash;
     }
-    shouldNotify = addDeltaBeforeNotifying(std::move(delta), *deltaState);
+    if (deltaState->log) {
+      deltaState->log->appendRootUpdate(
+          deltaState->nextSequence, delta.fromHash, newRootId, uncleanPaths);
+    }
+    observationCount = addDeltaBeforeNotifying(std::move(delta), *deltaState);
     deltaState->currentHash = std::move(newRootId);
   }
-  if (shouldNotify) {
-    notifySubscribers();
-  }
+  // Moving to a new root may change any path.
+  notifySubscribers(observationCount, {});
+}
+
+Journal::SequenceNumber Journal::getNextSequenceNumber() {
+  return deltaState_.lock()->nextSequence;
 }
 
 std::optional<JournalDeltaInfo> Journal::getLatest() {
   auto deltaState = deltaState_.lock();
-  deltaState->lastModificationHasBeenObserved = true;
+  ++deltaState->observationCount;
   if (deltaState->empty()) {
     return std::nullopt;
   } else {
@@ -279,21 +489,64 @@ std::optional<JournalDeltaInfo> Journal::getLatest() {
   }
 }
 
-uint64_t Journal::registerSubscriber(SubscriberCallback&& callback) {
-  auto subscriberState = subscriberState_.wlock();
+namespace {
+/** Empty roots, or any empty root, means the whole mount. */
+std::vector<RelativePath> normalizeRoots(std::vector<RelativePath> roots) {
+  if (std::any_of(roots.begin(), roots.end(), [](const RelativePath& root) {
+        return root.empty();
+      })) {
+    roots.clear();
+  }
+  return roots;
+}
+} // namespace
+
+uint64_t Journal::registerSubscriber(
+    SubscriberCallback&& callback,
+    std::vector<RelativePath> roots) {
+  roots = normalizeRoots(std::move(roots));
+
+  auto subscriberState = subscriberState_->wlock();
   auto id = subscriberState->nextSubscriberId++;
-  subscriberState->subscribers[id] = std::move(callback);
+  if (roots.empty()) {
+    subscriberState->subscribersByRoot[""].push_back(id);
+  }
+  for (const auto& root : roots) {
+    subscriberState->subscribersByRoot[root.stringPiece().str()].push_back(id);
+  }
+  subscriberState->subscribers[id] =
+      Subscriber{std::move(callback), std::move(roots)};
+  // The new subscriber has not been notified of anything yet.
+  everyoneNotifiedAtObservation_.store(0, std::memory_order_release);
   return id;
 }
 
 void Journal::cancelSubscriber(uint64_t id) {
-  auto subscriberState = subscriberState_.wlock();
+  auto subscriberState = subscriberState_->wlock();
   auto it = subscriberState->subscribers.find(id);
   if (it == subscriberState->subscribers.end()) {
     return;
   }
   // Extend the lifetime of the value we're removing
-  auto callback = std::move(it->second);
+  auto callback = std::move(it->second.callback);
+  auto& byRoot = subscriberState->subscribersByRoot;
+  auto unindex = [&](folly::StringPiece root) {
+    auto rootIt = byRoot.find(root);
+    if (rootIt == byRoot.end()) {
+      return;
+    }
+    auto& ids = rootIt->second;
+    ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+    if (ids.empty()) {
+      byRoot.erase(rootIt);
+    }
+  };
+  if (it->second.roots.empty()) {
+    unindex("");
+  }
+  for (const auto& root : it->second.roots) {
+    unindex(root.stringPiece());
+  }
   subscriberState->subscribers.erase(it);
   // release the lock before we trigger the destructor
   subscriberState.unlock();
@@ -304,13 +557,21 @@ void Journal::cancelAllSubscribers() {
   // Take care: some subscribers will attempt to call cancelSubscriber()
   // as part of their tear down, so we need to make sure that we aren't
   // holding the lock when we trigger that.
-  std::unordered_map<SubscriberId, SubscriberCallback> subscribers;
-  subscriberState_.wlock()->subscribers.swap(subscribers);
+  std::unordered_map<SubscriberId, Subscriber> subscribers;
+  {
+    auto subscriberState = subscriberState_->wlock();
+    subscriberState->subscribers.swap(subscribers);
+    subscriberState->subscribersByRoot.clear();
+  }
   subscribers.clear();
 }
 
+void Journal::setNotificationInterval(std::chrono::nanoseconds interval) {
+  subscriberState_->wlock()->notificationInterval = interval;
+}
+
 bool Journal::isSubscriberValid(uint64_t id) const {
-  auto subscriberState = subscriberState_.rlock();
+  auto subscriberState = subscriberState_->rlock();
   auto& subscribers = subscriberState->subscribers;
   return subscribers.find(id) != subscribers.end();
 }
@@ -343,6 +604,12 @@ size_t Journal::getMemoryLimit() const {
   return deltaState->memoryLimit;
 }
 
+void Journal::setMemoryLimitScale(double scale) {
+  auto deltaState = deltaState_.lock();
+  deltaState->memoryLimitScale = std::clamp(scale, 0.0, 1.0);
+  truncateIfNecessary(*deltaState);
+}
+
 size_t Journal::estimateMemoryUsage() const {
   return estimateMemoryUsage(*deltaState_.lock());
 }
@@ -362,6 +629,9 @@ size_t Journal::estimateMemoryUsage(const DeltaState& deltaState) const {
   // Account for overhead of deques which have a maximum buffer size of 512.
   memoryUsage += getPaddingAmount(deltaState.fileChangeDeltas);
   memoryUsage += getPaddingAmount(deltaState.hashUpdateDeltas);
+  memoryUsage += deltaState.pathTable.estimateMemoryUsage();
+  memoryUsage += getPaddingAmount(deltaState.checkpoints);
+  memoryUsage += deltaState.checkpointMemoryUsage;
 
   if (deltaState.stats) {
     memoryUsage += deltaState.deltaMemoryUsage;
@@ -370,35 +640,130 @@ size_t Journal::estimateMemoryUsage(const DeltaState& deltaState) const {
 }
 
 void Journal::flush() {
-  bool shouldNotify;
+  uint64_t observationCount;
   {
     auto deltaState = deltaState_.lock();
-    ++deltaState->nextSequence;
-    auto lastHash = deltaState->currentHash;
-    deltaState->fileChangeDeltas.clear();
-    deltaState->hashUpdateDeltas.clear();
-    deltaState->stats = std::nullopt;
-    auto delta = RootUpdateJournalDelta();
-    /* Tracking the hash correctly when the journal is flushed is important
-     * since Watchman uses the hash to correctly determine what additional files
-     * were changed when a checkout happens, journals have at least one entry
-     * unless they are on the null commit with no modifications done. A flush
-     * operation should leave us on the same checkout we were on before the
-     * flush operation.
-     */
-    delta.fromHash = lastHash;
-    shouldNotify = addDeltaBeforeNotifying(std::move(delta), *deltaState);
-  }
-  if (shouldNotify) {
-    notifySubscribers();
+    if (deltaState->log) {
+      deltaState->log->appendFlush(deltaState->nextSequence + 1);
+    }
+    observationCount = flushBeforeNotifying(*deltaState);
+  }
+  notifySubscribers(observationCount, {});
+}
+
+uint64_t Journal::flushBeforeNotifying(DeltaState& deltaState) {
+  ++deltaState.nextSequence;
+  auto lastHash = deltaState.currentHash;
+  deltaState.fileChangeDeltas.clear();
+  deltaState.hashUpdateDeltas.clear();
+  deltaState.checkpoints.clear();
+  deltaState.deltasSinceCheckpoint = 0;
+  deltaState.checkpointMemoryUsage = 0;
+  deltaState.stats = std::nullopt;
+  auto delta = RootUpdateJournalDelta();
+  /* Tracking the hash correctly when the journal is flushed is important
+   * since Watchman uses the hash to correctly determine what additional files
+   * were changed when a checkout happens, journals have at least one entry
+   * unless they are on the null commit with no modifications done. A flush
+   * operation should leave us on the same checkout we were on before the
+   * flush operation.
+   */
+  delta.fromHash = lastHash;
+  return addDeltaBeforeNotifying(std::move(delta), deltaState);
+}
+
+void Journal::openLog(AbsolutePathPiece directory, size_t maxSize) {
+  auto log = std::make_unique<JournalLog>(directory, maxSize);
+  auto deltaState = deltaState_.lock();
+  XCHECK(deltaState->empty() && deltaState->nextSequence == 1)
+      << "the journal log must be opened before recording any change";
+  if (auto contents = log->takeContents()) {
+    replay(*deltaState, contents->records);
+    deltaState->restoredMountGeneration = contents->mountGeneration;
+  }
+  deltaState->log = std::move(log);
+}
+
+void Journal::replay(
+    DeltaState& deltaState,
+    std::vector<JournalLogRecord>& records) {
+  for (auto& record : records) {
+    if (record.sequence < deltaState.nextSequence) {
+      XLOG(WARN) << "ignoring the journal log from out of order sequence "
+                 << "number " << record.sequence;
+      break;
+    }
+    // Every record reuses the sequence number it had when it was logged.
+    deltaState.nextSequence = record.sequence;
+    switch (record.type) {
+      case JournalLogRecord::Type::FileChange: {
+        FileChangeJournalDelta delta;
+        delta.path1 = deltaState.pathTable.intern(record.changes[0].first);
+        delta.info1 = record.changes[0].second;
+        delta.isPath1Valid = true;
+        if (record.changes.size() > 1) {
+          delta.path2 = deltaState.pathTable.intern(record.changes[1].first);
+          delta.info2 = record.changes[1].second;
+          delta.isPath2Valid = true;
+        }
+        (void)addDeltaBeforeNotifying(std::move(delta), deltaState);
+        break;
+      }
+      case JournalLogRecord::Type::RootUpdate: {
+        RootUpdateJournalDelta delta;
+        delta.fromHash = std::move(record.fromHash);
+        delta.uncleanPaths.reserve(record.uncleanPaths.size());
+        for (const auto& path : record.uncleanPaths) {
+          delta.uncleanPaths.push_back(deltaState.pathTable.intern(path));
+        }
+        (void)addDeltaBeforeNotifying(std::move(delta), deltaState);
+        deltaState.currentHash = std::move(record.toHash);
+        break;
+      }
+      case JournalLogRecord::Type::Flush:
+        // flushBeforeNotifying skips a sequence number.
+        --deltaState.nextSequence;
+        (void)flushBeforeNotifying(deltaState);
+        break;
+      case JournalLogRecord::Type::CleanShutdown:
+        break;
+    }
+  }
+}
+
+void Journal::closeLog(uint64_t mountGeneration) {
+  auto deltaState = deltaState_.lock();
+  if (deltaState->log) {
+    deltaState->log->close(mountGeneration);
   }
 }
 
+std::optional<uint64_t> Journal::getRestoredMountGeneration() {
+  return deltaState_.lock()->restoredMountGeneration;
+}
+
 std::unique_ptr<JournalDeltaRange> Journal::accumulateRange(
-    SequenceNumber from) {
+    SequenceNumber from,
+    const std::vector<RelativePath>& roots) {
   XDCHECK(from > 0);
   std::unique_ptr<JournalDeltaRange> result = nullptr;
 
+  folly::F14FastSet<std::string> rootIndex;
+  for (const auto& root : normalizeRoots(roots)) {
+    rootIndex.insert(root.stringPiece().str());
+  }
+  auto isUnderRoots = [&](RelativePathPiece path) {
+    if (rootIndex.empty()) {
+      return true;
+    }
+    for (auto prefix : path.allPaths()) {
+      if (rootIndex.count(prefix.stringPiece())) {
+        return true;
+      }
+    }
+    return false;
+  };
+
   size_t filesAccumulated = 0;
   auto deltaState = deltaState_.lock();
   // If this is going to be truncated, handle it before iterating.
@@ -406,57 +771,119 @@ std::unique_ptr<JournalDeltaRange> Journal::accumulateRange(
     result = std::make_unique<JournalDeltaRange>();
     result->isTruncated = true;
   } else {
-    forEachDelta(
-        *deltaState,
-        from,
-        std::nullopt,
-        [&](const FileChangeJournalDelta& current) -> void {
-          ++filesAccumulated;
-          if (!result) {
-            result = std::make_unique<JournalDeltaRange>();
-            result->toSequence = current.sequenceID;
-            result->toTime = current.time;
-            result->snapshotTransitions.push_back(deltaState->currentHash);
-          }
-          // Capture the lower bound.
-          result->fromSequence = current.sequenceID;
-          result->fromTime = current.time;
-
-          for (auto& entry : current.getChangedFilesInOverlay()) {
-            auto& name = entry.first;
-            auto& currentInfo = entry.second;
-            auto* resultInfo =
-                folly::get_ptr(result->changedFilesInOverlay, name);
-            if (!resultInfo) {
-              result->changedFilesInOverlay.emplace(name, currentInfo);
-            } else {
-              if (resultInfo->existedBefore != currentInfo.existedAfter) {
-                auto event1 = eventCharacterizationFor(currentInfo);
-                auto event2 = eventCharacterizationFor(*resultInfo);
-                XLOG(ERR) << "Journal for " << name << " holds invalid "
-                          << event1 << ", " << event2 << " sequence";
-              }
+    // Deltas and checkpoints are visited newest first. Each one extends the
+    // lower bound of the range.
+    auto captureBounds = [&](SequenceNumber toSequence,
+                             std::chrono::steady_clock::time_point toTime,
+                             SequenceNumber fromSequence,
+                             std::chrono::steady_clock::time_point fromTime) {
+      if (!result) {
+        result = std::make_unique<JournalDeltaRange>();
+        result->toSequence = toSequence;
+        result->toTime = toTime;
+        result->snapshotTransitions.push_back(deltaState->currentHash);
+      }
+      // Capture the lower bound.
+      result->fromSequence = fromSequence;
+      result->fromTime = fromTime;
+    };
+    auto mergeChange = [&](RelativePath name,
+                           const PathChangeInfo& currentInfo) {
+      if (!isUnderRoots(name)) {
+        return;
+      }
+      auto* resultInfo = folly::get_ptr(result->changedFilesInOverlay, name);
+      if (!resultInfo) {
+        result->changedFilesInOverlay.emplace(std::move(name), currentInfo);
+      } else {
+        if (resultInfo->existedBefore != currentInfo.existedAfter) {
+          auto event1 = eventCharacterizationFor(currentInfo);
+          auto event2 = eventCharacterizationFor(*resultInfo);
+          XLOG(ERR) << "Journal for " << name << " holds invalid " << event1
+                    << ", " << event2 << " sequence";
+        }
 
-              resultInfo->existedBefore = currentInfo.existedBefore;
+        resultInfo->existedBefore = currentInfo.existedBefore;
+      }
+    };
+    auto accumulateDeltas = [&](SequenceNumber lower, SequenceNumber upper) {
+      forEachDelta(
+          *deltaState,
+          lower,
+          upper,
+          std::nullopt,
+          [&](const FileChangeJournalDelta& current) -> void {
+            ++filesAccumulated;
+            captureBounds(
+                current.sequenceID,
+                current.time,
+                current.sequenceID,
+                current.time);
+            for (auto& entry : current.getChangedFilesInOverlay()) {
+              mergeChange(entry.first, entry.second);
             }
-          }
-        },
-        [&](const RootUpdateJournalDelta& current) -> void {
-          if (!result) {
-            result = std::make_unique<JournalDeltaRange>();
-            result->toSequence = current.sequenceID;
-            result->toTime = current.time;
-            result->snapshotTransitions.push_back(deltaState->currentHash);
-          }
-          // Capture the lower bound.
-          result->fromSequence = current.sequenceID;
-          result->fromTime = current.time;
-          result->snapshotTransitions.push_back(current.fromHash);
-
-          // Merge the unclean status list
-          result->uncleanPaths.insert(
-              current.uncleanPaths.begin(), current.uncleanPaths.end());
+          },
+          [&](const RootUpdateJournalDelta& current) -> void {
+            captureBounds(
+                current.sequenceID,
+                current.time,
+                current.sequenceID,
+                current.time);
+            result->snapshotTransitions.push_back(current.fromHash);
+
+            // Merge the unclean status list
+            for (const auto& path : current.uncleanPaths) {
+              auto uncleanPath = path.path();
+              if (isUnderRoots(uncleanPath)) {
+                result->uncleanPaths.insert(std::move(uncleanPath));
+              }
+            }
+          });
+    };
+
+    // Checkpoints cover every delta from the oldest one kept to
+    // checkpointedThrough, so only the deltas newer than the last checkpoint
+    // and older than the first one that fits in the range need walking.
+    const auto& checkpoints = deltaState->checkpoints;
+    auto firstCheckpoint = std::lower_bound(
+        checkpoints.begin(),
+        checkpoints.end(),
+        from,
+        [](const JournalCheckpoint& checkpoint, SequenceNumber sequence) {
+          return checkpoint.fromSequence < sequence;
         });
+    if (firstCheckpoint == checkpoints.end()) {
+      accumulateDeltas(from, std::numeric_limits<SequenceNumber>::max());
+    } else {
+      accumulateDeltas(
+          checkpoints.back().toSequence + 1,
+          std::numeric_limits<SequenceNumber>::max());
+      for (auto it = checkpoints.rbegin();
+           it != std::make_reverse_iterator(firstCheckpoint);
+           ++it) {
+        const JournalCheckpoint& checkpoint = *it;
+        filesAccumulated += checkpoint.fileChangeCount;
+        captureBounds(
+            checkpoint.toSequence,
+            checkpoint.toTime,
+            checkpoint.fromSequence,
+            checkpoint.fromTime);
+        for (const auto& entry : checkpoint.changedFilesInOverlay) {
+          mergeChange(entry.first.path(), entry.second);
+        }
+        result->snapshotTransitions.insert(
+            result->snapshotTransitions.end(),
+            checkpoint.fromHashes.begin(),
+            checkpoint.fromHashes.end());
+        for (const auto& path : checkpoint.uncleanPaths) {
+          auto uncleanPath = path.path();
+          if (isUnderRoots(uncleanPath)) {
+            result->uncleanPaths.insert(std::move(uncleanPath));
+          }
+        }
+      }
+      accumulateDeltas(from, firstCheckpoint->fromSequence - 1);
+    }
   }
 
   if (result) {
@@ -477,7 +904,7 @@ std::unique_ptr<JournalDeltaRange> Journal::accumulateRange(
         result->snapshotTransitions.begin(), result->snapshotTransitions.end());
   }
 
-  deltaState->lastModificationHasBeenObserved = true;
+  ++deltaState->observationCount;
   return result;
 }
 
@@ -492,6 +919,7 @@ std::vector<DebugJournalDelta> Journal::getDebugRawJournalInfo(
   forEachDelta(
       *deltaState,
       from,
+      std::numeric_limits<SequenceNumber>::max(),
       limit,
       [&](const FileChangeJournalDelta& current) -> void {
         DebugJournalDelta delta;
@@ -537,7 +965,7 @@ std::vector<DebugJournalDelta> Journal::getDebugRawJournalInfo(
         currentHash = current.fromHash;
 
         for (auto& path : current.uncleanPaths) {
-          delta.uncleanPaths_ref()->emplace(path.stringPiece().str());
+          delta.uncleanPaths_ref()->emplace(path.path().stringPiece().str());
         }
 
         result.push_back(delta);
@@ -553,12 +981,27 @@ template <class FileChangeFunc, class HashUpdateFunc>
 void Journal::forEachDelta(
     const DeltaState& deltaState,
     JournalDelta::SequenceNumber from,
+    JournalDelta::SequenceNumber to,
     std::optional<size_t> lengthLimit,
     FileChangeFunc&& fileChangeDeltaCallback,
     HashUpdateFunc&& hashUpdateDeltaCallback) const {
   size_t iters = 0;
-  auto fileChangeIt = deltaState.fileChangeDeltas.rbegin();
-  auto hashUpdateIt = deltaState.hashUpdateDeltas.rbegin();
+  auto bySequence = [](JournalDelta::SequenceNumber sequence,
+                       const JournalDelta& delta) {
+    return sequence < delta.sequenceID;
+  };
+  // Both deques are sorted by sequence ID, so start from the newest delta no
+  // greater than 'to'.
+  auto fileChangeIt = std::make_reverse_iterator(std::upper_bound(
+      deltaState.fileChangeDeltas.begin(),
+      deltaState.fileChangeDeltas.end(),
+      to,
+      bySequence));
+  auto hashUpdateIt = std::make_reverse_iterator(std::upper_bound(
+      deltaState.hashUpdateDeltas.begin(),
+      deltaState.hashUpdateDeltas.end(),
+      to,
+      bySequence));
   auto fileChangeRend = deltaState.fileChangeDeltas.rend();
   auto hashUpdateRend = deltaState.hashUpdateDeltas.rend();
   while (fileChangeIt != fileChangeRend || hashUpdateIt != hashUpdateRend) {
@@ -9,12 +9,20 @@
 
 #include <folly/Function.h>
 #include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <initializer_list>
 #include <memory>
 #include <optional>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include "eden/fs/journal/JournalDelta.h"
+#include "eden/fs/journal/JournalLog.h"
 #include "eden/fs/model/RootId.h"
 #include "eden/fs/service/gen-cpp2/StreamingEdenService.h"
 #include "eden/fs/telemetry/EdenStats.h"
@@ -55,7 +63,8 @@ struct JournalDeltaInfo {
  * the larger list of files.
  *
  * The Journal class is thread-safe.  Subscribers are called on the thread
- * that called addDelta.
+ * that called addDelta, or on a timer thread when their notification was
+ * deferred by setNotificationInterval().
  */
 class Journal {
  public:
@@ -112,6 +121,15 @@ class Journal {
    */
   std::optional<JournalDeltaInfo> getLatest();
 
+  /**
+   * Returns the sequence number the next delta will get. Every recorded
+   * change advances it, including the ones compacted into the previous
+   * delta, so callers can cheaply check whether anything happened since they
+   * last looked. Unlike getLatest(), this doesn't count as observing the
+   * journal for the purpose of subscriber notifications.
+   */
+  SequenceNumber getNextSequenceNumber();
+
   /**
    * Returns an accumulation of all deltas with sequence number >= limitSequence
    * merged. If limitSequence is further back than the Journal remembers,
@@ -120,9 +138,14 @@ class Journal {
    * The default limit value indicates that all deltas should be summed.
    *
    * If the limitSequence means that no deltas will match, returns nullptr.
+   *
+   * If roots is not empty, changedFilesInOverlay and uncleanPaths only
+   * contain the paths equal to or below one of the roots. The sequence range
+   * and snapshot transitions are not affected.
    */
   std::unique_ptr<JournalDeltaRange> accumulateRange(
-      SequenceNumber limitSequence = 1);
+      SequenceNumber limitSequence = 1,
+      const std::vector<RelativePath>& roots = {});
 
   // Subscription functionality:
 
@@ -139,15 +162,31 @@ class Journal {
    * modifications between subscriber notifications and calls to getLatest or
    * accumulateRange.
    *
+   * If roots is not empty, the subscriber is only notified of changes to paths
+   * equal to or below one of the roots, and of changes to the current root.
+   * The Journal indexes subscribers by root, so the cost of a change does not
+   * grow with the number of subscribers uninterested in it.
+   *
    * The return value of registerSubscriber is an identifier than can be passed
    * to cancelSubscriber to later remove the registration.
    */
-  SubscriberId registerSubscriber(SubscriberCallback&& callback);
+  SubscriberId registerSubscriber(
+      SubscriberCallback&& callback,
+      std::vector<RelativePath> roots = {});
   void cancelSubscriber(SubscriberId id);
 
   void cancelAllSubscribers();
   bool isSubscriberValid(SubscriberId id) const;
 
+  /**
+   * Notify each subscriber at most once per interval. A change made sooner
+   * marks the subscriber dirty, and a single notification covering every
+   * change since is delivered once the interval has elapsed, so bulk writes
+   * don't wake subscribers up more than once per interval while no change
+   * waits longer than that. 0, the default, notifies right away.
+   */
+  void setNotificationInterval(std::chrono::nanoseconds interval);
+
   // Statistics and debugging:
 
   /**
@@ -176,40 +215,102 @@ class Journal {
 
   size_t getMemoryLimit() const;
 
+  /**
+   * Only keep memoryLimit * scale bytes of deltas, truncating right away if
+   * the journal is larger. Lets the server shrink journals under memory
+   * pressure without forgetting the limit configured with setMemoryLimit().
+   * scale is clamped to [0, 1].
+   */
+  void setMemoryLimitScale(double scale);
+
   size_t estimateMemoryUsage() const;
 
+  // Persistence across restarts:
+
+  /**
+   * Log every change to a JournalLog in directory, using at most maxSize
+   * bytes on disk. If the previous process closed its log cleanly, its
+   * changes are replayed first, so that the journal positions it handed out
+   * remain valid. Must be called before anything is recorded.
+   */
+  void openLog(AbsolutePathPiece directory, size_t maxSize);
+
+  /**
+   * Mark the log as complete, recording the mountGeneration that the next
+   * process should keep using if it restores the log. Anything recorded
+   * afterwards discards the log.
+   */
+  void closeLog(uint64_t mountGeneration);
+
+  /**
+   * The mountGeneration passed to closeLog() by the process whose log was
+   * replayed by openLog(), if any.
+   */
+  std::optional<uint64_t> getRestoredMountGeneration();
+
  private:
   /** Add a delta to the journal and notify subscribers.
    * The delta will have a new sequence number and timestamp
-   * applied.
+   * applied. changedPaths are the paths the delta refers to.
    */
-  void addDelta(FileChangeJournalDelta&& delta);
-  void addDelta(RootUpdateJournalDelta&& delta, RootId newRootId);
+  void addDelta(
+      std::initializer_list<RelativePathPiece> changedPaths,
+      folly::FunctionRef<FileChangeJournalDelta(JournalPathTable&)> makeDelta);
+  void addDelta(
+      RootUpdateJournalDelta&& delta,
+      RootId newRootId,
+      const std::unordered_set<RelativePath>& uncleanPaths = {});
 
   static constexpr size_t kDefaultJournalMemoryLimit = 1000000000;
 
+  /**
+   * Number of deltas summarized by each JournalCheckpoint. accumulateRange
+   * walks at most this many deltas at either end of the range and merges
+   * checkpoints in between.
+   */
+  static constexpr size_t kCheckpointInterval = 1024;
+
   struct DeltaState {
     /**
      * The sequence number that we'll use for the next entry that we link into
      * the chain.
      */
     SequenceNumber nextSequence{1};
+    /**
+     * Every path referenced by the deltas below. Declared before them so that
+     * it outlives the JournalPaths they hold.
+     */
+    JournalPathTable pathTable;
     /**
      * All recorded entries. Newer (more recent) deltas are added to the back of
      * the appropriate deque.
      */
     std::deque<FileChangeJournalDelta> fileChangeDeltas;
     std::deque<RootUpdateJournalDelta> hashUpdateDeltas;
+    /**
+     * Summaries of consecutive deltas, oldest first. Checkpoints are dropped
+     * as soon as truncation removes any delta they cover.
+     */
+    std::deque<JournalCheckpoint> checkpoints;
+    /** The newest sequence number covered by a checkpoint, ever. */
+    SequenceNumber checkpointedThrough{0};
+    /** Deltas appended since the newest checkpoint was built. */
+    size_t deltasSinceCheckpoint = 0;
+    size_t checkpointMemoryUsage = 0;
     RootId currentHash;
     /// The stats about this Journal up to the latest delta.
     std::optional<JournalStats> stats;
     size_t memoryLimit = kDefaultJournalMemoryLimit;
+    double memoryLimitScale = 1.0;
     size_t deltaMemoryUsage = 0;
 
-    // Set to false when a delta is added.
-    // Set to true when getLatest() or accumulateRange() are called.
-    // If true before calling addDelta, subscribers are notified.
-    bool lastModificationHasBeenObserved = true;
+    // Incremented when getLatest() or accumulateRange() are called. Each
+    // subscriber is notified at most once per observation.
+    uint64_t observationCount = 1;
+
+    /** Set by openLog(), records every change made afterwards. */
+    std::unique_ptr<JournalLog> log;
+    std::optional<uint64_t> restoredMountGeneration;
 
     JournalDeltaPtr frontPtr() noexcept;
     void popFront();
@@ -248,9 +349,38 @@ class Journal {
   bool compact(FileChangeJournalDelta& delta, DeltaState& deltaState);
   bool compact(RootUpdateJournalDelta& delta, DeltaState& deltaState);
 
+  /**
+   * Summarizes every delta appended since the previous checkpoint into a new
+   * JournalCheckpoint. Must be called before appending a new delta, since the
+   * back delta may no longer be compacted afterwards.
+   */
+  void addCheckpoint(DeltaState& deltaState);
+
+  struct Subscriber {
+    SubscriberCallback callback;
+    /** Empty if the subscriber wants every change. */
+    std::vector<RelativePath> roots;
+    /** The observationCount this subscriber was last notified at. */
+    uint64_t notifiedAtObservation{0};
+    std::chrono::steady_clock::time_point notifiedAt;
+    /**
+     * Set while a change waits for the notification interval to elapse, with
+     * the newest observationCount the pending notification covers.
+     */
+    bool dirty{false};
+    uint64_t pendingObservation{0};
+  };
+
   struct SubscriberState {
     SubscriberId nextSubscriberId{1};
-    std::unordered_map<SubscriberId, SubscriberCallback> subscribers;
+    std::unordered_map<SubscriberId, Subscriber> subscribers;
+    /**
+     * The IDs of the subscribers interested in each root. Unfiltered
+     * subscribers are listed under the empty path, which is a prefix of every
+     * path.
+     */
+    folly::F14FastMap<std::string, std::vector<SubscriberId>> subscribersByRoot;
+    std::chrono::nanoseconds notificationInterval{0};
   };
 
   /**
@@ -259,33 +389,66 @@ class Journal {
    * applied. A lock to the deltaState must be held and passed to this
    * function.
    *
-   * Returns true if subscribers should be notified.
+   * Returns the observationCount to pass to notifySubscribers.
    */
   template <typename T>
-  [[nodiscard]] bool addDeltaBeforeNotifying(T&& delta, DeltaState& deltaState);
+  [[nodiscard]] uint64_t addDeltaBeforeNotifying(
+      T&& delta,
+      DeltaState& deltaState);
+
+  /**
+   * Notify the subscribers interested in a change to changedPaths, or every
+   * subscriber if changedPaths is empty, unless they were already notified at
+   * this observationCount. Must not be called while Journal locks are held.
+   */
+  void notifySubscribers(
+      uint64_t observationCount,
+      folly::Range<const RelativePathPiece*> changedPaths);
 
   /**
-   * Notify subscribers that a change has happened. Must not be called while
-   * Journal locks are held.
+   * Clear the journal, leaving a single delta that keeps the current root.
+   * Returns the observationCount to pass to notifySubscribers.
    */
-  void notifySubscribers() const;
+  [[nodiscard]] uint64_t flushBeforeNotifying(DeltaState& deltaState);
+
+  /** Apply the records of a JournalLog to an empty journal. */
+  void replay(DeltaState& deltaState, std::vector<JournalLogRecord>& records);
+
+  /**
+   * Called by the timer started when a notification was deferred. Only holds
+   * a weak reference to the state since the Journal may be gone by then.
+   */
+  static void deliverDeferredNotification(
+      const std::weak_ptr<folly::Synchronized<SubscriberState>>& state,
+      SubscriberId id);
 
   size_t estimateMemoryUsage(const DeltaState& deltaState) const;
 
   /**
-   * Runs from the latest delta to the delta with sequence ID (if 'lengthLimit'
-   * is not nullopt then checks at most 'lengthLimit' entries) and runs
-   * deltaActor on each entry encountered.
+   * Runs from the latest delta with a sequence ID no greater than 'to' to the
+   * delta with sequence ID 'from' (if 'lengthLimit' is not nullopt then checks
+   * at most 'lengthLimit' entries) and runs deltaActor on each entry
+   * encountered.
    * */
   template <class FileChangeFunc, class HashUpdateFunc>
   void forEachDelta(
       const DeltaState& deltaState,
       JournalDelta::SequenceNumber from,
+      JournalDelta::SequenceNumber to,
       std::optional<size_t> lengthLimit,
       FileChangeFunc&& fileChangeDeltaCallback,
       HashUpdateFunc&& hashUpdateDeltaCallback) const;
 
-  folly::Synchronized<SubscriberState> subscriberState_;
+  /** Shared with the timers of deferred notifications. */
+  std::shared_ptr<folly::Synchronized<SubscriberState>> subscriberState_{
+      std::make_shared<folly::Synchronized<SubscriberState>>()};
+
+  /**
+   * The newest observationCount at which every subscriber has been notified.
+   * Lets notifySubscribers return without taking any lock in the common case
+   * of a burst of changes nobody has looked at yet.
+   */
+  std::atomic<uint64_t> everyoneNotifiedAtObservation_{0};
 
   std::shared_ptr<EdenStats> edenStats_;
 };
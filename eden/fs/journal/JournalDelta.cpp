@@ -12,89 +12,74 @@ namespace facebook {
 namespace eden {
 
 FileChangeJournalDelta::FileChangeJournalDelta(
-    RelativePathPiece fileName,
+    JournalPath fileName,
     FileChangeJournalDelta::Created)
-    : path1{fileName.copy()},
+    : path1{std::move(fileName)},
       info1{PathChangeInfo{false, true}},
       isPath1Valid{true} {}
 
 FileChangeJournalDelta::FileChangeJournalDelta(
-    RelativePathPiece fileName,
+    JournalPath fileName,
     FileChangeJournalDelta::Removed)
-    : path1{fileName.copy()},
+    : path1{std::move(fileName)},
       info1{PathChangeInfo{true, false}},
       isPath1Valid{true} {}
 
 FileChangeJournalDelta::FileChangeJournalDelta(
-    RelativePathPiece fileName,
+    JournalPath fileName,
     FileChangeJournalDelta::Changed)
-    : path1{fileName.copy()},
+    : path1{std::move(fileName)},
       info1{PathChangeInfo{true, true}},
       isPath1Valid{true} {}
 
 FileChangeJournalDelta::FileChangeJournalDelta(
-    RelativePathPiece oldName,
-    RelativePathPiece newName,
+    JournalPath oldName,
+    JournalPath newName,
     FileChangeJournalDelta::Renamed)
-    : path1{oldName.copy()},
-      path2{newName.copy()},
+    : path1{std::move(oldName)},
+      path2{std::move(newName)},
       info1{PathChangeInfo{true, false}},
       info2{PathChangeInfo{false, true}},
       isPath1Valid{true},
       isPath2Valid{true} {}
 
 FileChangeJournalDelta::FileChangeJournalDelta(
-    RelativePathPiece oldName,
-    RelativePathPiece newName,
+    JournalPath oldName,
+    JournalPath newName,
     FileChangeJournalDelta::Replaced)
-    : path1{oldName.copy()},
-      path2{newName.copy()},
+    : path1{std::move(oldName)},
+      path2{std::move(newName)},
       info1{PathChangeInfo{true, false}},
       info2{PathChangeInfo{true, true}},
       isPath1Valid{true},
       isPath2Valid{true} {}
 
 size_t FileChangeJournalDelta::estimateMemoryUsage() const {
-  size_t mem = sizeof(FileChangeJournalDelta);
-
-  /* NOTE: The following code assumes an unordered_set is separated into an
-   * array of buckets, each one being a chain of nodes containing a next
-   * pointer, a key-value pair, and a stored hash
-   */
-  if (isPath1Valid) {
-    mem += facebook::eden::estimateIndirectMemoryUsage(path1);
-  }
-  if (isPath2Valid) {
-    mem += facebook::eden::estimateIndirectMemoryUsage(path2);
-  }
-
-  return mem;
+  // path1 and path2 only reference the Journal's JournalPathTable, whose
+  // memory is accounted for once by the Journal.
+  return sizeof(FileChangeJournalDelta);
 }
 
 size_t RootUpdateJournalDelta::estimateMemoryUsage() const {
   size_t mem = sizeof(RootUpdateJournalDelta);
-
-  /* NOTE: The following code assumes an unordered_set is separated into an
-   * array of buckets, each one being a chain of nodes containing a next
-   * pointer, a key-value pair, and a stored hash
-   */
-
-  // Calculate Memory For Nodes in Each Bucket (Pointer to element and next)
-  size_t set_elem_size = folly::goodMallocSize(
-      sizeof(void*) + sizeof(decltype(uncleanPaths)::value_type) +
-      sizeof(size_t));
-  for (unsigned long i = 0; i < uncleanPaths.bucket_count(); ++i) {
-    mem += set_elem_size * uncleanPaths.bucket_size(i);
+  if (uncleanPaths.capacity() > 0) {
+    mem += folly::goodMallocSize(
+        sizeof(decltype(uncleanPaths)::value_type) * uncleanPaths.capacity());
   }
+  return mem;
+}
 
-  // Calculate Memory Usage of Bucket List
-  mem += folly::goodMallocSize(sizeof(void*) * uncleanPaths.bucket_count());
-
-  // Calculate Memory Usage used indirectly by elements
-  for (auto& path : uncleanPaths) {
-    mem += facebook::eden::estimateIndirectMemoryUsage(path);
+size_t JournalCheckpoint::estimateMemoryUsage() const {
+  size_t mem = sizeof(JournalCheckpoint);
+  mem += changedFilesInOverlay.getAllocatedMemorySize();
+  mem += uncleanPaths.getAllocatedMemorySize();
+  if (fromHashes.capacity() > 0) {
+    mem += folly::goodMallocSize(
+        sizeof(decltype(fromHashes)::value_type) * fromHashes.capacity());
+  }
+  for (const auto& hash : fromHashes) {
+    mem += estimateIndirectMemoryUsage(hash.value());
   }
-
   return mem;
 }
 
@@ -102,10 +87,10 @@ std::unordered_map<RelativePath, PathChangeInfo>
 FileChangeJournalDelta::getChangedFilesInOverlay() const {
   std::unordered_map<RelativePath, PathChangeInfo> changedFilesInOverlay;
   if (isPath1Valid) {
-    changedFilesInOverlay[path1] = info1;
+    changedFilesInOverlay[path1.path()] = info1;
   }
   if (isPath2Valid) {
-    changedFilesInOverlay[path2] = info2;
+    changedFilesInOverlay[path2.path()] = info2;
   }
   return changedFilesInOverlay;
 }
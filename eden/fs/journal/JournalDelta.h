@@ -7,10 +7,14 @@
 
 #pragma once
 
+#include <folly/container/F14Map.h>
+#include <folly/container/F14Set.h>
 #include <chrono>
 #include <type_traits>
 #include <unordered_set>
 #include <variant>
+#include <vector>
+#include "eden/fs/journal/JournalPathTable.h"
 #include "eden/fs/model/RootId.h"
 #include "eden/fs/utils/PathFuncs.h"
 
@@ -75,30 +79,27 @@ class FileChangeJournalDelta : public JournalDelta {
   FileChangeJournalDelta& operator=(FileChangeJournalDelta&&) = default;
   FileChangeJournalDelta(const FileChangeJournalDelta&) = delete;
   FileChangeJournalDelta& operator=(const FileChangeJournalDelta&) = delete;
-  FileChangeJournalDelta(RelativePathPiece fileName, Created);
-  FileChangeJournalDelta(RelativePathPiece fileName, Removed);
-  FileChangeJournalDelta(RelativePathPiece fileName, Changed);
+  FileChangeJournalDelta(JournalPath fileName, Created);
+  FileChangeJournalDelta(JournalPath fileName, Removed);
+  FileChangeJournalDelta(JournalPath fileName, Changed);
 
   /**
    * "Renamed" means that that newName was created as a result of the mv(1).
    */
-  FileChangeJournalDelta(
-      RelativePathPiece oldName,
-      RelativePathPiece newName,
-      Renamed);
+  FileChangeJournalDelta(JournalPath oldName, JournalPath newName, Renamed);
 
   /**
    * "Replaced" means that that newName was overwritten by oldName as a result
    * of the mv(1).
    */
-  FileChangeJournalDelta(
-      RelativePathPiece oldName,
-      RelativePathPiece newName,
-      Replaced);
-
-  /** Which of these paths actually contain information */
-  RelativePath path1;
-  RelativePath path2;
+  FileChangeJournalDelta(JournalPath oldName, JournalPath newName, Replaced);
+
+  /**
+   * Which of these paths actually contain information.
+   * Both are interned in the Journal's JournalPathTable.
+   */
+  JournalPath path1;
+  JournalPath path2;
   PathChangeInfo info1;
   PathChangeInfo info2;
   bool isPath1Valid = false;
@@ -114,7 +115,7 @@ class FileChangeJournalDelta : public JournalDelta {
    * sequenceID [whether they do the same action] */
   bool isSameAction(const FileChangeJournalDelta& other) const;
 
-  /** Get memory used (in bytes) by this Delta */
+  /** Get memory used (in bytes) by this Delta, excluding the path table */
   size_t estimateMemoryUsage() const;
 };
 
@@ -135,10 +136,11 @@ class RootUpdateJournalDelta : public JournalDelta {
   RootId fromHash;
 
   /** The set of files that had differing status across a checkout or
-   * some other operation that changes the snapshot hash */
-  std::unordered_set<RelativePath> uncleanPaths;
+   * some other operation that changes the snapshot hash. These are unique and
+   * interned in the Journal's JournalPathTable. */
+  std::vector<JournalPath> uncleanPaths;
 
-  /** Get memory used (in bytes) by this Delta */
+  /** Get memory used (in bytes) by this Delta, excluding the path table */
   size_t estimateMemoryUsage() const;
 };
 
@@ -168,6 +170,39 @@ class JournalDeltaPtr {
       data_;
 };
 
+/**
+ * A precomputed summary of consecutive deltas, so that accumulateRange can
+ * merge a single checkpoint instead of walking every delta it covers.
+ */
+struct JournalCheckpoint {
+  JournalCheckpoint() = default;
+  JournalCheckpoint(JournalCheckpoint&&) = default;
+  JournalCheckpoint& operator=(JournalCheckpoint&&) = default;
+  JournalCheckpoint(const JournalCheckpoint&) = delete;
+  JournalCheckpoint& operator=(const JournalCheckpoint&) = delete;
+
+  /** The oldest and newest deltas summarized by this checkpoint. */
+  JournalDelta::SequenceNumber fromSequence;
+  JournalDelta::SequenceNumber toSequence;
+  std::chrono::steady_clock::time_point fromTime;
+  std::chrono::steady_clock::time_point toTime;
+
+  /** The number of FileChangeJournalDeltas summarized. */
+  size_t fileChangeCount = 0;
+
+  /** The merged changes of every FileChangeJournalDelta summarized. */
+  folly::F14FastMap<JournalPath, PathChangeInfo> changedFilesInOverlay;
+
+  /** The fromHash of every RootUpdateJournalDelta summarized, newest first. */
+  std::vector<RootId> fromHashes;
+
+  /** The union of the uncleanPaths of every RootUpdateJournalDelta. */
+  folly::F14FastSet<JournalPath> uncleanPaths;
+
+  /** Get memory used (in bytes) by this checkpoint, excluding the path table */
+  size_t estimateMemoryUsage() const;
+};
+
 struct JournalDeltaRange {
   /**
    * The current sequence range.
@@ -0,0 +1,448 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/journal/JournalLog.h"
+
+#include <folly/Exception.h>
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <folly/hash/Checksum.h>
+#include <folly/lang/Bits.h>
+#include <folly/logging/xlog.h>
+#include <folly/portability/Fcntl.h>
+#include <algorithm>
+#include <cstring>
+#include "eden/fs/utils/FileUtils.h"
+
+namespace facebook::eden {
+
+namespace {
+
+constexpr folly::StringPiece kMagic{"EDENJLOG"};
+constexpr uint32_t kVersion = 1;
+/** Magic, version and segment number. */
+constexpr size_t kHeaderSize = 8 + 4 + 8;
+/** Length and checksum of the payload. */
+constexpr size_t kRecordHeaderSize = 4 + 4;
+/** Buffered records are written out once they reach this size. */
+constexpr size_t kWriteBufferSize = 64 * 1024;
+
+#ifdef _WIN32
+constexpr int kOpenFlags = O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC | O_BINARY;
+#else
+constexpr int kOpenFlags = O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC;
+#endif
+
+template <typename T>
+void appendInt(std::string& out, T value) {
+  value = folly::Endian::big(value);
+  out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+void storeInt(std::string& out, size_t offset, T value) {
+  value = folly::Endian::big(value);
+  memcpy(&out[offset], &value, sizeof(value));
+}
+
+void appendString(std::string& out, folly::StringPiece str) {
+  appendInt(out, static_cast<uint32_t>(str.size()));
+  out.append(str.data(), str.size());
+}
+
+uint8_t encodeInfo(PathChangeInfo info) {
+  return (info.existedBefore ? 1 : 0) | (info.existedAfter ? 2 : 0);
+}
+
+PathChangeInfo decodeInfo(uint8_t bits) {
+  return PathChangeInfo{(bits & 1) != 0, (bits & 2) != 0};
+}
+
+uint32_t checksum(folly::StringPiece data) {
+  return folly::crc32c(
+      reinterpret_cast<const uint8_t*>(data.data()), data.size());
+}
+
+/** Reads big-endian integers and strings, failing once data runs out. */
+class Reader {
+ public:
+  explicit Reader(folly::StringPiece data) : data_{data} {}
+
+  template <typename T>
+  bool read(T& value) {
+    if (data_.size() < sizeof(T)) {
+      return false;
+    }
+    memcpy(&value, data_.data(), sizeof(T));
+    value = folly::Endian::big(value);
+    data_.advance(sizeof(T));
+    return true;
+  }
+
+  bool readString(folly::StringPiece& str) {
+    uint32_t size;
+    if (!read(size) || data_.size() < size) {
+      return false;
+    }
+    str = data_.subpiece(0, size);
+    data_.advance(size);
+    return true;
+  }
+
+  bool readPath(RelativePath& path) {
+    folly::StringPiece str;
+    if (!readString(str)) {
+      return false;
+    }
+    path = RelativePath{str};
+    return true;
+  }
+
+  bool empty() const {
+    return data_.empty();
+  }
+
+ private:
+  folly::StringPiece data_;
+};
+
+std::optional<JournalLogRecord> parseRecord(folly::StringPiece payload) {
+  Reader reader{payload};
+  JournalLogRecord record;
+  uint8_t type;
+  if (!reader.read(type) || !reader.read(record.sequence)) {
+    return std::nullopt;
+  }
+  record.type = static_cast<JournalLogRecord::Type>(type);
+
+  switch (record.type) {
+    case JournalLogRecord::Type::FileChange: {
+      uint8_t count;
+      if (!reader.read(count) || count < 1 || count > 2) {
+        return std::nullopt;
+      }
+      for (uint8_t i = 0; i < count; ++i) {
+        uint8_t info;
+        RelativePath path;
+        if (!reader.read(info) || !reader.readPath(path)) {
+          return std::nullopt;
+        }
+        record.changes.emplace_back(std::move(path), decodeInfo(info));
+      }
+      break;
+    }
+    case JournalLogRecord::Type::RootUpdate: {
+      folly::StringPiece fromHash;
+      folly::StringPiece toHash;
+      uint32_t count;
+      if (!reader.readString(fromHash) || !reader.readString(toHash) ||
+          !reader.read(count)) {
+        return std::nullopt;
+      }
+      record.fromHash = RootId{fromHash.str()};
+      record.toHash = RootId{toHash.str()};
+      for (uint32_t i = 0; i < count; ++i) {
+        RelativePath path;
+        if (!reader.readPath(path)) {
+          return std::nullopt;
+        }
+        record.uncleanPaths.push_back(std::move(path));
+      }
+      break;
+    }
+    case JournalLogRecord::Type::Flush:
+      break;
+    case JournalLogRecord::Type::CleanShutdown:
+      if (!reader.read(record.mountGeneration)) {
+        return std::nullopt;
+      }
+      break;
+    default:
+      return std::nullopt;
+  }
+
+  if (!reader.empty()) {
+    return std::nullopt;
+  }
+  return record;
+}
+
+} // namespace
+
+JournalLog::JournalLog(AbsolutePathPiece directory, size_t maxSize)
+    : segmentPaths_{
+          directory + "journal-log.0"_pc,
+          directory + "journal-log.1"_pc},
+      segmentLimit_{std::max(maxSize / 2, kHeaderSize)} {
+  std::optional<Segment> segments[2] = {
+      readSegment(segmentPaths_[0]), readSegment(segmentPaths_[1])};
+  bool secondIsNewer = segments[1] &&
+      (!segments[0] || segments[1]->number > segments[0]->number);
+  size_t newest = secondIsNewer ? 1 : 0;
+  auto& latest = segments[newest];
+  auto& previous = segments[1 - newest];
+
+  try {
+    if (latest && latest->complete && latest->mountGeneration) {
+      Contents contents;
+      contents.mountGeneration = *latest->mountGeneration;
+      // The previous segment only holds older records if nothing failed while
+      // it was active.
+      if (previous && previous->complete && !previous->mountGeneration &&
+          previous->number + 1 == latest->number) {
+        contents.records = std::move(previous->records);
+      }
+      for (auto& record : latest->records) {
+        contents.records.push_back(std::move(record));
+      }
+      contents_ = std::move(contents);
+
+      // Drop the CleanShutdown trailer: until close() writes a new one, the
+      // log must not be trusted.
+      openSegment(newest, latest->number, latest->size);
+    } else {
+      if (latest || previous) {
+        XLOG(WARN) << "discarding the journal log in " << directory
+                   << " since it was not cleanly closed";
+      }
+      openSegment(0, 0, 0);
+      removeFileWithAbsolutePath(segmentPaths_[1]);
+    }
+  } catch (const std::exception& ex) {
+    XLOG(ERR) << "unable to open the journal log in " << directory << ": "
+              << folly::exceptionStr(ex);
+    contents_.reset();
+    discard();
+  }
+}
+
+JournalLog::~JournalLog() = default;
+
+std::optional<JournalLog::Segment> JournalLog::readSegment(
+    AbsolutePathPiece path) {
+  auto data = readFile(path);
+  if (data.hasException()) {
+    return std::nullopt;
+  }
+  folly::StringPiece contents{*data};
+
+  Reader header{contents};
+  uint64_t magic;
+  uint32_t version;
+  Segment segment;
+  if (!header.read(magic) || !header.read(version) ||
+      !header.read(segment.number) ||
+      memcmp(contents.data(), kMagic.data(), kMagic.size()) != 0 ||
+      version != kVersion) {
+    return std::nullopt;
+  }
+
+  size_t offset = kHeaderSize;
+  while (contents.size() - offset >= kRecordHeaderSize) {
+    Reader recordHeader{contents.subpiece(offset, kRecordHeaderSize)};
+    uint32_t length;
+    uint32_t crc;
+    recordHeader.read(length);
+    recordHeader.read(crc);
+    if (contents.size() - offset - kRecordHeaderSize < length) {
+      break;
+    }
+    auto payload = contents.subpiece(offset + kRecordHeaderSize, length);
+    if (checksum(payload) != crc) {
+      break;
+    }
+    std::optional<JournalLogRecord> record;
+    try {
+      record = parseRecord(payload);
+    } catch (const std::exception&) {
+      // An invalid path.
+    }
+    if (!record || segment.mountGeneration) {
+      // Nothing may follow the CleanShutdown trailer.
+      segment.mountGeneration.reset();
+      break;
+    }
+
+    if (record->type == JournalLogRecord::Type::CleanShutdown) {
+      segment.mountGeneration = record->mountGeneration;
+      segment.size = offset;
+    } else {
+      segment.records.push_back(std::move(*record));
+    }
+    offset += kRecordHeaderSize + length;
+  }
+
+  segment.complete = offset == contents.size();
+  if (!segment.mountGeneration) {
+    segment.size = offset;
+  }
+  return segment;
+}
+
+std::optional<JournalLog::Contents> JournalLog::takeContents() {
+  return std::exchange(contents_, std::nullopt);
+}
+
+bool JournalLog::prepareAppend() {
+  if (discarded_) {
+    return false;
+  }
+  if (closed_) {
+    XLOG(WARN) << "journal changed after its log was closed, discarding "
+               << segmentPaths_[activeIndex_];
+    discard();
+    return false;
+  }
+  return true;
+}
+
+void JournalLog::appendFileChange(
+    JournalDelta::SequenceNumber sequence,
+    folly::Range<const RelativePathPiece*> paths,
+    PathChangeInfo info1,
+    PathChangeInfo info2) {
+  if (!prepareAppend()) {
+    return;
+  }
+  XDCHECK(paths.size() == 1 || paths.size() == 2);
+  startRecord(JournalLogRecord::Type::FileChange, sequence);
+  buffer_.push_back(static_cast<char>(paths.size()));
+  for (size_t i = 0; i < paths.size(); ++i) {
+    buffer_.push_back(static_cast<char>(encodeInfo(i == 0 ? info1 : info2)));
+    appendString(buffer_, paths[i].stringPiece());
+  }
+  finishRecord();
+}
+
+void JournalLog::appendRootUpdate(
+    JournalDelta::SequenceNumber sequence,
+    const RootId& fromHash,
+    const RootId& toHash,
+    const std::unordered_set<RelativePath>& uncleanPaths) {
+  if (!prepareAppend()) {
+    return;
+  }
+  startRecord(JournalLogRecord::Type::RootUpdate, sequence);
+  appendString(buffer_, fromHash.value());
+  appendString(buffer_, toHash.value());
+  appendInt(buffer_, static_cast<uint32_t>(uncleanPaths.size()));
+  for (const auto& path : uncleanPaths) {
+    appendString(buffer_, path.stringPiece());
+  }
+  finishRecord();
+}
+
+void JournalLog::appendFlush(JournalDelta::SequenceNumber sequence) {
+  if (!prepareAppend()) {
+    return;
+  }
+  startRecord(JournalLogRecord::Type::Flush, sequence);
+  finishRecord();
+}
+
+void JournalLog::close(uint64_t mountGeneration) {
+  if (discarded_ || closed_) {
+    return;
+  }
+  closed_ = true;
+  startRecord(JournalLogRecord::Type::CleanShutdown, 0);
+  appendInt(buffer_, mountGeneration);
+  finishRecord();
+
+  write();
+  if (!discarded_ && folly::fsyncNoInt(active_.fd()) != 0) {
+    XLOG(ERR) << "error syncing journal log " << segmentPaths_[activeIndex_]
+              << ": " << folly::errnoStr(errno);
+    discard();
+  }
+}
+
+void JournalLog::startRecord(JournalLogRecord::Type type, uint64_t sequence) {
+  recordStart_ = buffer_.size();
+  buffer_.append(kRecordHeaderSize, '\0');
+  buffer_.push_back(static_cast<char>(type));
+  appendInt(buffer_, sequence);
+}
+
+void JournalLog::finishRecord() {
+  auto payloadStart = recordStart_ + kRecordHeaderSize;
+  auto payload = folly::StringPiece{buffer_}.subpiece(payloadStart);
+  storeInt(buffer_, recordStart_, static_cast<uint32_t>(payload.size()));
+  storeInt(buffer_, recordStart_ + 4, checksum(payload));
+
+  // close() writes the trailer itself, and it must stay in the active
+  // segment.
+  if (closed_) {
+    return;
+  }
+  if (getActiveSegmentSize() > segmentLimit_) {
+    rotate();
+  } else if (buffer_.size() >= kWriteBufferSize) {
+    write();
+  }
+}
+
+void JournalLog::write() {
+  if (discarded_ || buffer_.empty()) {
+    return;
+  }
+  if (folly::writeFull(active_.fd(), buffer_.data(), buffer_.size()) < 0) {
+    XLOG(ERR) << "error writing journal log " << segmentPaths_[activeIndex_]
+              << ": " << folly::errnoStr(errno);
+    discard();
+    return;
+  }
+  activeSize_ += buffer_.size();
+  buffer_.clear();
+}
+
+void JournalLog::rotate() {
+  write();
+  if (discarded_) {
+    return;
+  }
+  try {
+    openSegment(1 - activeIndex_, activeNumber_ + 1, 0);
+  } catch (const std::exception& ex) {
+    XLOG(ERR) << "unable to rotate the journal log: "
+              << folly::exceptionStr(ex);
+    discard();
+  }
+}
+
+void JournalLog::openSegment(size_t index, uint64_t number, size_t keepBytes) {
+  active_ = folly::File{segmentPaths_[index].c_str(), kOpenFlags, 0644};
+  folly::checkUnixError(
+      folly::ftruncateNoInt(active_.fd(), keepBytes),
+      "unable to truncate ",
+      segmentPaths_[index]);
+  activeIndex_ = index;
+  activeNumber_ = number;
+  activeSize_ = keepBytes;
+
+  if (keepBytes == 0) {
+    buffer_.append(kMagic.data(), kMagic.size());
+    appendInt(buffer_, kVersion);
+    appendInt(buffer_, number);
+  }
+}
+
+void JournalLog::discard() {
+  discarded_ = true;
+  buffer_.clear();
+  active_.closeNoThrow();
+  for (const auto& path : segmentPaths_) {
+    try {
+      removeFileWithAbsolutePath(path);
+    } catch (const std::exception& ex) {
+      XLOG(ERR) << "unable to remove journal log " << path << ": "
+                << folly::exceptionStr(ex);
+    }
+  }
+}
+
+} // namespace facebook::eden
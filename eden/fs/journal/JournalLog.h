@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/File.h>
+#include <folly/Range.h>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "eden/fs/journal/JournalDelta.h"
+#include "eden/fs/model/RootId.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/** One change recorded in a JournalLog, in the order it was appended. */
+struct JournalLogRecord {
+  enum class Type : uint8_t {
+    FileChange = 1,
+    RootUpdate = 2,
+    Flush = 3,
+    CleanShutdown = 4,
+  };
+
+  Type type;
+  JournalDelta::SequenceNumber sequence{0};
+
+  /** FileChange: path1 and, for renames and replacements, path2. */
+  std::vector<std::pair<RelativePath, PathChangeInfo>> changes;
+
+  /** RootUpdate */
+  RootId fromHash;
+  RootId toHash;
+  std::vector<RelativePath> uncleanPaths;
+
+  /** CleanShutdown */
+  uint64_t mountGeneration{0};
+};
+
+/**
+ * An append-only log of a mount's journal, kept in its client directory so
+ * that journal positions handed out before a restart remain valid after it.
+ *
+ * The log is split into two segment files, each holding about half of the
+ * configured size: when the active segment is full, the older one is
+ * truncated and becomes the active one. Replaying reads the older segment,
+ * then the newer one.
+ *
+ * Records are buffered in memory and written out in batches, so the log is
+ * only trusted if it ends with the record written by close(). After a crash,
+ * the log is discarded and the journal starts from scratch as it would
+ * without a log.
+ *
+ * Not thread-safe: the Journal only uses it while holding its lock.
+ */
+class JournalLog {
+ public:
+  struct Contents {
+    /** The mount generation passed to close() by the previous process. */
+    uint64_t mountGeneration;
+    std::vector<JournalLogRecord> records;
+  };
+
+  /**
+   * Open the log in directory. If the previous log was cleanly closed, its
+   * records can be retrieved with takeContents() and new records are
+   * appended after them. Otherwise it is discarded.
+   */
+  JournalLog(AbsolutePathPiece directory, size_t maxSize);
+  ~JournalLog();
+
+  JournalLog(const JournalLog&) = delete;
+  JournalLog& operator=(const JournalLog&) = delete;
+
+  /** The records of the previous log, if it was cleanly closed. */
+  std::optional<Contents> takeContents();
+
+  void appendFileChange(
+      JournalDelta::SequenceNumber sequence,
+      folly::Range<const RelativePathPiece*> paths,
+      PathChangeInfo info1,
+      PathChangeInfo info2);
+  void appendRootUpdate(
+      JournalDelta::SequenceNumber sequence,
+      const RootId& fromHash,
+      const RootId& toHash,
+      const std::unordered_set<RelativePath>& uncleanPaths);
+  void appendFlush(JournalDelta::SequenceNumber sequence);
+
+  /**
+   * Write every buffered record followed by a CleanShutdown record for
+   * mountGeneration, and sync the log to disk. Appending anything afterwards
+   * discards the log, since the next process would not know about it.
+   */
+  void close(uint64_t mountGeneration);
+
+  /** Bytes in the active segment, including those not written yet. */
+  size_t getActiveSegmentSize() const {
+    return activeSize_ + buffer_.size();
+  }
+
+ private:
+  struct Segment {
+    uint64_t number{0};
+    /** Bytes of header and records, excluding the CleanShutdown trailer. */
+    size_t size{0};
+    std::vector<JournalLogRecord> records;
+    /** Whether every byte of the file was read back successfully. */
+    bool complete{false};
+    /** Set if the segment ends with a CleanShutdown record. */
+    std::optional<uint64_t> mountGeneration;
+  };
+
+  static std::optional<Segment> readSegment(AbsolutePathPiece path);
+
+  /** Whether the record about to be appended should be written. */
+  bool prepareAppend();
+  void startRecord(JournalLogRecord::Type type, uint64_t sequence);
+  void finishRecord();
+  void write();
+  void rotate();
+  /**
+   * Make segment index the active one, keeping its first keepBytes bytes, or
+   * starting it over with a new header if keepBytes is 0.
+   */
+  void openSegment(size_t index, uint64_t number, size_t keepBytes);
+  /** Stop logging and remove the segments after an error or late append. */
+  void discard();
+
+  AbsolutePath segmentPaths_[2];
+  size_t segmentLimit_;
+
+  folly::File active_;
+  size_t activeIndex_{0};
+  uint64_t activeNumber_{0};
+  size_t activeSize_{0};
+
+  /** Records not written to active_ yet. */
+  std::string buffer_;
+  size_t recordStart_{0};
+
+  bool closed_{false};
+  bool discarded_{false};
+  std::optional<Contents> contents_;
+};
+
+} // namespace facebook::eden
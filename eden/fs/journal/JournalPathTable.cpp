@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/journal/JournalPathTable.h"
+
+#include <folly/small_vector.h>
+#include <folly/logging/xlog.h>
+#include "eden/fs/utils/Memory.h"
+
+namespace facebook::eden {
+
+struct JournalPath::Node {
+  Node(Node* parent, folly::StringPiece name)
+      : parent{parent}, name{name.str()} {}
+
+  PathComponentPiece namePiece() const {
+    return PathComponentPiece{folly::StringPiece{name}, SkipPathSanityCheck{}};
+  }
+
+  /** nullptr for the Root. */
+  Node* const parent;
+  /** Empty for the Root, which is why this isn't a PathComponent. */
+  const folly::fbstring name;
+  /** Number of JournalPaths referencing this node. */
+  uint32_t refCount{0};
+  /** Keyed by a piece of the child's own name. */
+  folly::F14FastMap<PathComponentPiece, std::unique_ptr<Node>> children;
+};
+
+struct JournalPathTable::Root : JournalPath::Node {
+  Root() : Node{nullptr, folly::StringPiece{}} {}
+
+  size_t nodeCount{0};
+  size_t memoryUsage{0};
+};
+
+namespace {
+
+using Node = JournalPath::Node;
+
+size_t estimateNodeMemoryUsage(const Node& node) {
+  return folly::goodMallocSize(sizeof(Node)) +
+      sizeof(decltype(node.children)::value_type) +
+      estimateIndirectMemoryUsage(node.name);
+}
+
+} // namespace
+
+JournalPath::JournalPath(Node* node) noexcept : node_{node} {
+  if (node_) {
+    ++node_->refCount;
+  }
+}
+
+JournalPath::~JournalPath() {
+  if (!node_) {
+    return;
+  }
+  XDCHECK_GT(node_->refCount, 0u);
+  if (--node_->refCount != 0 || !node_->children.empty()) {
+    return;
+  }
+
+  // Unlink every node that is no longer referenced, then charge the removal
+  // to the Root, which is the only node without a parent.
+  size_t removedNodes = 0;
+  size_t removedMemory = 0;
+  Node* node = node_;
+  while (node->parent && node->refCount == 0 && node->children.empty()) {
+    Node* parent = node->parent;
+    ++removedNodes;
+    removedMemory += estimateNodeMemoryUsage(*node);
+    // Erase by iterator: the key points into the name of the node being
+    // destroyed.
+    parent->children.erase(parent->children.find(node->namePiece()));
+    node = parent;
+  }
+  while (node->parent) {
+    node = node->parent;
+  }
+  auto* root = static_cast<JournalPathTable::Root*>(node);
+  root->nodeCount -= removedNodes;
+  root->memoryUsage -= removedMemory;
+}
+
+JournalPath& JournalPath::operator=(JournalPath&& other) noexcept {
+  if (this != &other) {
+    JournalPath released{std::move(*this)};
+    node_ = other.node_;
+    other.node_ = nullptr;
+  }
+  return *this;
+}
+
+RelativePath JournalPath::path() const {
+  folly::small_vector<PathComponentPiece, 16> components;
+  for (const Node* node = node_; node && node->parent; node = node->parent) {
+    components.push_back(node->namePiece());
+  }
+  return RelativePath{components.rbegin(), components.rend()};
+}
+
+JournalPathTable::JournalPathTable() : root_{std::make_unique<Root>()} {}
+
+JournalPathTable::~JournalPathTable() {
+  // Every JournalPath must be destroyed before its table.
+  XDCHECK(root_->children.empty());
+}
+
+JournalPath JournalPathTable::intern(RelativePathPiece path) {
+  Node* node = root_.get();
+  for (auto component : path.components()) {
+    auto it = node->children.find(component);
+    if (it == node->children.end()) {
+      auto child = std::make_unique<Node>(node, component.stringPiece());
+      auto key = child->namePiece();
+      root_->nodeCount++;
+      root_->memoryUsage += estimateNodeMemoryUsage(*child);
+      it = node->children.emplace(key, std::move(child)).first;
+    }
+    node = it->second.get();
+  }
+  return node == root_.get() ? JournalPath{} : JournalPath{node};
+}
+
+size_t JournalPathTable::getNodeCount() const {
+  return root_->nodeCount;
+}
+
+size_t JournalPathTable::estimateMemoryUsage() const {
+  return folly::goodMallocSize(sizeof(Root)) + root_->memoryUsage;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/container/F14Map.h>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class JournalPathTable;
+
+/**
+ * A reference to a path interned in a JournalPathTable.
+ *
+ * A JournalPath is a single pointer: a path that is recorded over and over
+ * shares one entry in the table, and paths with a common parent share the
+ * nodes for that parent. Destroying the last JournalPath referencing a path
+ * removes it from the table.
+ *
+ * Like the table itself, JournalPaths are not thread-safe and must only be
+ * created, read and destroyed while holding the lock that protects the
+ * table.
+ */
+class JournalPath {
+ public:
+  /** An empty path, which also represents the root of the repository. */
+  JournalPath() noexcept = default;
+  ~JournalPath();
+
+  JournalPath(JournalPath&& other) noexcept : node_{other.node_} {
+    other.node_ = nullptr;
+  }
+  JournalPath& operator=(JournalPath&& other) noexcept;
+  JournalPath(const JournalPath&) = delete;
+  JournalPath& operator=(const JournalPath&) = delete;
+
+  /** Build a copy of the full path. */
+  RelativePath path() const;
+
+  /** Return another reference to the same path. */
+  JournalPath copy() const {
+    return JournalPath{node_};
+  }
+
+  /**
+   * Two JournalPaths interned in the same table are equal exactly when they
+   * name the same path.
+   */
+  bool operator==(const JournalPath& other) const {
+    return node_ == other.node_;
+  }
+  bool operator!=(const JournalPath& other) const {
+    return node_ != other.node_;
+  }
+
+  size_t hash() const {
+    return std::hash<const void*>{}(node_);
+  }
+
+  /** A node of the trie; only defined in JournalPathTable.cpp. */
+  struct Node;
+
+ private:
+  friend class JournalPathTable;
+
+  explicit JournalPath(Node* node) noexcept;
+
+  Node* node_{nullptr};
+};
+
+/**
+ * A trie of PathComponents holding every path currently referenced by the
+ * Journal. Each node is kept alive by the JournalPaths naming it and by its
+ * children, so the table only ever holds paths still present in some delta.
+ */
+class JournalPathTable {
+ public:
+  JournalPathTable();
+  ~JournalPathTable();
+
+  JournalPathTable(const JournalPathTable&) = delete;
+  JournalPathTable& operator=(const JournalPathTable&) = delete;
+
+  /** Return a reference to path, adding it to the table if necessary. */
+  JournalPath intern(RelativePathPiece path);
+
+  /** Number of trie nodes, i.e. distinct path prefixes, in the table. */
+  size_t getNodeCount() const;
+
+  /** Get memory used (in bytes) by the table, excluding sizeof(*this). */
+  size_t estimateMemoryUsage() const;
+
+ private:
+  friend class JournalPath;
+  struct Root;
+
+  std::unique_ptr<Root> root_;
+};
+
+} // namespace facebook::eden
+
+namespace std {
+template <>
+struct hash<facebook::eden::JournalPath> {
+  size_t operator()(const facebook::eden::JournalPath& path) const {
+    return path.hash();
+  }
+};
+} // namespace std
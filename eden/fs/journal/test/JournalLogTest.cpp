@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/journal/JournalLog.h"
+
+#include <folly/experimental/TestUtil.h>
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using folly::test::TemporaryDirectory;
+
+namespace {
+
+struct JournalLogTest : ::testing::Test {
+  TemporaryDirectory tmpDir;
+  AbsolutePath dir{canonicalPath(tmpDir.path().string())};
+};
+
+void appendChange(JournalLog& log, uint64_t sequence, RelativePathPiece path) {
+  RelativePathPiece paths[] = {path};
+  log.appendFileChange(
+      sequence, folly::range(paths), PathChangeInfo{true, true}, {});
+}
+
+} // namespace
+
+TEST_F(JournalLogTest, round_trip) {
+  {
+    JournalLog log{dir, 1024 * 1024};
+    EXPECT_FALSE(log.takeContents());
+    RelativePathPiece renamed[] = {"a/old"_relpath, "a/new"_relpath};
+    log.appendFileChange(
+        1,
+        folly::range(renamed),
+        PathChangeInfo{true, false},
+        PathChangeInfo{false, true});
+    log.appendRootUpdate(
+        2, RootId{"from"}, RootId{"to"}, {RelativePath{"unclean"}});
+    log.appendFlush(4);
+    log.close(42);
+  }
+
+  JournalLog log{dir, 1024 * 1024};
+  auto contents = log.takeContents();
+  ASSERT_TRUE(contents);
+  EXPECT_EQ(42, contents->mountGeneration);
+  ASSERT_EQ(3, contents->records.size());
+
+  const auto& change = contents->records[0];
+  EXPECT_EQ(JournalLogRecord::Type::FileChange, change.type);
+  EXPECT_EQ(1, change.sequence);
+  ASSERT_EQ(2, change.changes.size());
+  EXPECT_EQ("a/old"_relpath, change.changes[0].first);
+  EXPECT_EQ((PathChangeInfo{true, false}), change.changes[0].second);
+  EXPECT_EQ("a/new"_relpath, change.changes[1].first);
+  EXPECT_EQ((PathChangeInfo{false, true}), change.changes[1].second);
+
+  const auto& update = contents->records[1];
+  EXPECT_EQ(JournalLogRecord::Type::RootUpdate, update.type);
+  EXPECT_EQ(2, update.sequence);
+  EXPECT_EQ(RootId{"from"}, update.fromHash);
+  EXPECT_EQ(RootId{"to"}, update.toHash);
+  EXPECT_EQ(
+      std::vector<RelativePath>{RelativePath{"unclean"}}, update.uncleanPaths);
+
+  EXPECT_EQ(JournalLogRecord::Type::Flush, contents->records[2].type);
+  EXPECT_EQ(4, contents->records[2].sequence);
+}
+
+TEST_F(JournalLogTest, reopened_log_keeps_appending) {
+  {
+    JournalLog log{dir, 1024 * 1024};
+    appendChange(log, 1, "first"_relpath);
+    log.close(1);
+  }
+  {
+    JournalLog log{dir, 1024 * 1024};
+    appendChange(log, 2, "second"_relpath);
+    log.close(2);
+  }
+
+  JournalLog log{dir, 1024 * 1024};
+  auto contents = log.takeContents();
+  ASSERT_TRUE(contents);
+  EXPECT_EQ(2, contents->mountGeneration);
+  ASSERT_EQ(2, contents->records.size());
+  EXPECT_EQ("first"_relpath, contents->records[0].changes[0].first);
+  EXPECT_EQ("second"_relpath, contents->records[1].changes[0].first);
+}
+
+TEST_F(JournalLogTest, log_not_closed_is_discarded) {
+  {
+    JournalLog log{dir, 1024 * 1024};
+    appendChange(log, 1, "file"_relpath);
+    log.close(1);
+  }
+  {
+    // Reopening removes the trailer, so crashing now loses everything.
+    JournalLog log{dir, 1024 * 1024};
+    EXPECT_TRUE(log.takeContents());
+    appendChange(log, 2, "file"_relpath);
+  }
+
+  JournalLog log{dir, 1024 * 1024};
+  EXPECT_FALSE(log.takeContents());
+}
+
+TEST_F(JournalLogTest, append_after_close_discards_log) {
+  {
+    JournalLog log{dir, 1024 * 1024};
+    appendChange(log, 1, "file"_relpath);
+    log.close(1);
+    appendChange(log, 2, "file"_relpath);
+  }
+
+  JournalLog log{dir, 1024 * 1024};
+  EXPECT_FALSE(log.takeContents());
+}
+
+TEST_F(JournalLogTest, size_is_bounded) {
+  constexpr size_t kMaxSize = 4096;
+  constexpr uint64_t kCount = 1000;
+  {
+    JournalLog log{dir, kMaxSize};
+    for (uint64_t sequence = 1; sequence <= kCount; ++sequence) {
+      appendChange(log, sequence, "some/file/name"_relpath);
+      EXPECT_LE(log.getActiveSegmentSize(), kMaxSize / 2 + 64);
+    }
+    log.close(1);
+  }
+
+  JournalLog log{dir, kMaxSize};
+  auto contents = log.takeContents();
+  ASSERT_TRUE(contents);
+  // The oldest records were dropped, the newest ones are all there, in order.
+  ASSERT_FALSE(contents->records.empty());
+  EXPECT_GT(contents->records.front().sequence, 1);
+  EXPECT_EQ(kCount, contents->records.back().sequence);
+  for (size_t i = 1; i < contents->records.size(); ++i) {
+    EXPECT_EQ(
+        contents->records[i - 1].sequence + 1, contents->records[i].sequence);
+  }
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/journal/JournalPathTable.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+TEST(JournalPathTable, shares_common_prefixes) {
+  JournalPathTable table;
+  auto baz = table.intern("foo/bar/baz"_relpath);
+  auto qux = table.intern("foo/bar/qux"_relpath);
+  auto other = table.intern("foo/other"_relpath);
+  // foo, foo/bar, foo/bar/baz, foo/bar/qux and foo/other.
+  EXPECT_EQ(5, table.getNodeCount());
+
+  EXPECT_EQ("foo/bar/baz"_relpath, baz.path());
+  EXPECT_EQ("foo/bar/qux"_relpath, qux.path());
+  EXPECT_EQ("foo/other"_relpath, other.path());
+}
+
+TEST(JournalPathTable, same_path_is_same_node) {
+  JournalPathTable table;
+  auto a = table.intern("dir/file.txt"_relpath);
+  auto b = table.intern("dir/file.txt"_relpath);
+  auto c = table.intern("dir"_relpath);
+  EXPECT_EQ(a, b);
+  EXPECT_NE(a, c);
+  EXPECT_EQ(2, table.getNodeCount());
+}
+
+TEST(JournalPathTable, empty_path) {
+  JournalPathTable table;
+  auto root = table.intern(""_relpath);
+  EXPECT_EQ(JournalPath{}, root);
+  EXPECT_EQ(RelativePath{}, root.path());
+  EXPECT_EQ(0, table.getNodeCount());
+}
+
+TEST(JournalPathTable, releasing_last_reference_removes_path) {
+  JournalPathTable table;
+  auto emptyMemory = table.estimateMemoryUsage();
+  auto dir = table.intern("a/b"_relpath);
+  {
+    auto file = table.intern("a/b/c/file.txt"_relpath);
+    auto again = table.intern("a/b/c/file.txt"_relpath);
+    EXPECT_EQ(4, table.getNodeCount());
+  }
+  // a/b is still referenced, but nothing needs a/b/c anymore.
+  EXPECT_EQ(2, table.getNodeCount());
+  EXPECT_EQ("a/b"_relpath, dir.path());
+
+  JournalPath moved = std::move(dir);
+  EXPECT_EQ(2, table.getNodeCount());
+  moved = JournalPath{};
+  EXPECT_EQ(0, table.getNodeCount());
+  EXPECT_EQ(emptyMemory, table.estimateMemoryUsage());
+}
@@ -7,6 +7,9 @@
 
 #include "eden/fs/journal/Journal.h"
 
+#include <folly/Conv.h>
+#include <folly/experimental/TestUtil.h>
+#include <folly/synchronization/Baton.h>
 #include <folly/portability/GMock.h>
 #include <folly/portability/GTest.h>
 
@@ -420,6 +423,104 @@ TEST_F(JournalTest, memory_usage) {
   }
 }
 
+TEST_F(JournalTest, repeated_paths_are_stored_once) {
+  journal.recordCreated("some/deeply/nested/directory/file.txt"_relpath);
+  auto oneEntry = journal.estimateMemoryUsage();
+  journal.recordRemoved("some/deeply/nested/directory/file.txt"_relpath);
+  auto twoEntries = journal.estimateMemoryUsage();
+  journal.recordCreated("some/deeply/nested/directory/file.txt"_relpath);
+  auto threeEntries = journal.estimateMemoryUsage();
+
+  // Once the path is interned, later deltas only pay for themselves.
+  EXPECT_EQ(twoEntries - oneEntry, threeEntries - twoEntries);
+  EXPECT_LE(threeEntries - twoEntries, sizeof(FileChangeJournalDelta));
+
+  auto summed = journal.accumulateRange(1);
+  ASSERT_TRUE(summed);
+  std::unordered_map<RelativePath, PathChangeInfo> expected = {
+      {RelativePath{"some/deeply/nested/directory/file.txt"},
+       PathChangeInfo{false, true}}};
+  EXPECT_EQ(expected, summed->changedFilesInOverlay);
+}
+
+TEST_F(JournalTest, accumulate_range_across_checkpoints) {
+  // Enough deltas for the Journal to summarize several checkpoints.
+  constexpr Journal::SequenceNumber kLatest = 4000;
+  constexpr Journal::SequenceNumber kHashUpdate = 2000;
+  RootId hash1{"1111111111111111111111111111111111111111"};
+  for (Journal::SequenceNumber i = 1; i <= kLatest; ++i) {
+    if (i == kHashUpdate) {
+      journal.recordHashUpdate(hash1);
+    } else {
+      journal.recordCreated(
+          RelativePath{folly::to<std::string>("dir", i % 10, "/file", i)});
+    }
+  }
+
+  for (Journal::SequenceNumber from :
+       {1, 2, 1024, 1025, 1999, 2000, 2001, 3333, 4000}) {
+    SCOPED_TRACE(from);
+    auto summed = journal.accumulateRange(from);
+    ASSERT_TRUE(summed);
+    EXPECT_FALSE(summed->isTruncated);
+    EXPECT_EQ(from, summed->fromSequence);
+    EXPECT_EQ(kLatest, summed->toSequence);
+
+    size_t expectedFiles = kLatest - from + (from <= kHashUpdate ? 0 : 1);
+    EXPECT_EQ(expectedFiles, summed->changedFilesInOverlay.size());
+    EXPECT_EQ(
+        1,
+        summed->changedFilesInOverlay.count(RelativePath{
+            folly::to<std::string>("dir", kLatest % 10, "/file", kLatest)}));
+    for (const auto& entry : summed->changedFilesInOverlay) {
+      EXPECT_EQ(PathChangeInfo(false, true), entry.second);
+    }
+
+    auto expectedTransitions = from <= kHashUpdate
+        ? std::vector<RootId>{RootId{}, hash1}
+        : std::vector<RootId>{hash1};
+    EXPECT_EQ(expectedTransitions, summed->snapshotTransitions);
+  }
+}
+
+TEST_F(JournalTest, checkpoints_merge_existence_and_follow_truncation) {
+  // Odd sequence numbers create the file, even ones remove it.
+  constexpr Journal::SequenceNumber kLatest = 3000;
+  for (Journal::SequenceNumber i = 1; i <= kLatest; ++i) {
+    if (i % 2 == 1) {
+      journal.recordCreated("shared.txt"_relpath);
+    } else {
+      journal.recordRemoved("shared.txt"_relpath);
+    }
+  }
+
+  auto expectRange = [&](Journal::SequenceNumber from) {
+    SCOPED_TRACE(from);
+    auto summed = journal.accumulateRange(from);
+    ASSERT_TRUE(summed);
+    EXPECT_FALSE(summed->isTruncated);
+    EXPECT_EQ(from, summed->fromSequence);
+    std::unordered_map<RelativePath, PathChangeInfo> expected = {
+        {RelativePath{"shared.txt"}, PathChangeInfo{from % 2 == 0, false}}};
+    EXPECT_EQ(expected, summed->changedFilesInOverlay);
+  };
+  for (Journal::SequenceNumber from : {1, 2, 1024, 1025, 1026, 2049, 2999}) {
+    expectRange(from);
+  }
+
+  // Truncation drops the checkpoints covering deltas it removed, and ranges
+  // starting at the new oldest delta remain accurate.
+  journal.setMemoryLimit(journal.estimateMemoryUsage());
+  journal.setMemoryLimitScale(0.5);
+  auto entryCount = journal.getStats()->entryCount;
+  ASSERT_LT(entryCount, kLatest);
+  auto oldest = kLatest - entryCount + 1;
+  EXPECT_TRUE(journal.accumulateRange(oldest - 1)->isTruncated);
+  expectRange(oldest);
+  expectRange(oldest + 1);
+  expectRange(kLatest);
+}
+
 TEST_F(JournalTest, set_get_memory_limit) {
   journal.setMemoryLimit(500);
   ASSERT_EQ(500, journal.getMemoryLimit());
@@ -429,6 +530,29 @@ TEST_F(JournalTest, set_get_memory_limit) {
   ASSERT_EQ(0, journal.getMemoryLimit());
 }
 
+TEST_F(JournalTest, memory_limit_scale_truncates_and_keeps_limit) {
+  journal.setMemoryLimit(20000);
+  for (int i = 0; i < 500; ++i) {
+    journal.recordChanged("file1.txt"_relpath);
+    journal.recordChanged("file2.txt"_relpath);
+  }
+  auto entriesBefore = journal.getStats()->entryCount;
+
+  journal.setMemoryLimitScale(0.25);
+  EXPECT_EQ(20000, journal.getMemoryLimit());
+  auto entriesShrunk = journal.getStats()->entryCount;
+  EXPECT_LT(entriesShrunk, entriesBefore);
+  EXPECT_LE(journal.estimateMemoryUsage(), 5000);
+
+  // Growing back lets the journal fill up to the configured limit again.
+  journal.setMemoryLimitScale(1.0);
+  for (int i = 0; i < 500; ++i) {
+    journal.recordChanged("file1.txt"_relpath);
+    journal.recordChanged("file2.txt"_relpath);
+  }
+  EXPECT_GT(journal.getStats()->entryCount, entriesShrunk);
+}
+
 TEST_F(JournalTest, truncation_by_flush) {
   journal.recordCreated("file1.txt"_relpath);
   journal.recordCreated("file2.txt"_relpath);
@@ -657,3 +781,140 @@ TEST_F(JournalTest, all_subscribers_are_notified_after_any_observation) {
   EXPECT_EQ(2u, calls1);
   EXPECT_EQ(2u, calls2);
 }
+
+TEST_F(JournalTest, filtered_subscribers_only_see_changes_under_their_roots) {
+  unsigned allCalls = 0;
+  unsigned fooCalls = 0;
+  auto all = journal.registerSubscriber([&] { ++allCalls; });
+  auto foo = journal.registerSubscriber(
+      [&] { ++fooCalls; }, {RelativePath{"foo"}, RelativePath{"baz/qux"}});
+
+  journal.recordChanged("bar/file"_relpath);
+  EXPECT_EQ(1u, allCalls);
+  EXPECT_EQ(0u, fooCalls);
+
+  // "foobar" shares a string prefix with "foo" but isn't below it.
+  journal.recordChanged("foobar"_relpath);
+  EXPECT_EQ(1u, allCalls);
+  EXPECT_EQ(0u, fooCalls);
+
+  // Not observed yet by anyone, but foo was never notified.
+  journal.recordChanged("foo/file"_relpath);
+  EXPECT_EQ(1u, allCalls);
+  EXPECT_EQ(1u, fooCalls);
+
+  journal.getLatest();
+  journal.recordRenamed("bar/file"_relpath, "baz/qux/file"_relpath);
+  EXPECT_EQ(2u, allCalls);
+  EXPECT_EQ(2u, fooCalls);
+
+  // Moving to a new commit may change anything.
+  journal.getLatest();
+  journal.recordHashUpdate(RootId{"1111111111111111111111111111111111111111"});
+  EXPECT_EQ(3u, allCalls);
+  EXPECT_EQ(3u, fooCalls);
+
+  journal.cancelSubscriber(foo);
+  EXPECT_FALSE(journal.isSubscriberValid(foo));
+  journal.getLatest();
+  journal.recordChanged("foo/file"_relpath);
+  EXPECT_EQ(4u, allCalls);
+  EXPECT_EQ(3u, fooCalls);
+  journal.cancelSubscriber(all);
+}
+
+TEST_F(JournalTest, accumulate_range_filtered_by_roots) {
+  journal.recordCreated("foo/a"_relpath);
+  journal.recordCreated("foobar"_relpath);
+  journal.recordChanged("bar/b"_relpath);
+  journal.recordRenamed("bar/b"_relpath, "foo/sub/b"_relpath);
+  journal.recordUncleanPaths(
+      RootId{},
+      RootId{"1111111111111111111111111111111111111111"},
+      {RelativePath{"foo/unclean"}, RelativePath{"bar/unclean"}});
+
+  auto summed = journal.accumulateRange(1, {RelativePath{"foo"}});
+  ASSERT_TRUE(summed);
+  EXPECT_EQ(1u, summed->fromSequence);
+  EXPECT_EQ(5u, summed->toSequence);
+  std::unordered_map<RelativePath, PathChangeInfo> expected = {
+      {RelativePath{"foo/a"}, PathChangeInfo{false, true}},
+      {RelativePath{"foo/sub/b"}, PathChangeInfo{false, true}}};
+  EXPECT_EQ(expected, summed->changedFilesInOverlay);
+  EXPECT_EQ(
+      std::unordered_set<RelativePath>{RelativePath{"foo/unclean"}},
+      summed->uncleanPaths);
+  EXPECT_EQ(2u, summed->snapshotTransitions.size());
+
+  // An empty root matches everything.
+  summed = journal.accumulateRange(1, {RelativePath{""}});
+  ASSERT_TRUE(summed);
+  EXPECT_EQ(4u, summed->changedFilesInOverlay.size());
+  EXPECT_EQ(2u, summed->uncleanPaths.size());
+}
+
+TEST_F(JournalTest, log_restores_journal_across_restarts) {
+  folly::test::TemporaryDirectory tmpDir;
+  auto dir = canonicalPath(tmpDir.path().string());
+  auto hash1 = RootId{"1111111111111111111111111111111111111111"};
+  {
+    Journal previous{edenStats};
+    previous.openLog(dir, 1024 * 1024);
+    EXPECT_FALSE(previous.getRestoredMountGeneration());
+    previous.recordHashUpdate(hash1);
+    previous.recordCreated("created"_relpath);
+    previous.recordChanged("changed"_relpath);
+    previous.recordChanged("changed"_relpath);
+    previous.recordRenamed("changed"_relpath, "renamed"_relpath);
+    previous.closeLog(42);
+  }
+
+  journal.openLog(dir, 1024 * 1024);
+  EXPECT_EQ(42, journal.getRestoredMountGeneration());
+  EXPECT_EQ(6, journal.getNextSequenceNumber());
+
+  // Positions from before the restart are still meaningful.
+  auto summed = journal.accumulateRange(2);
+  ASSERT_TRUE(summed);
+  EXPECT_FALSE(summed->isTruncated);
+  EXPECT_EQ(2, summed->fromSequence);
+  EXPECT_EQ(5, summed->toSequence);
+  std::unordered_map<RelativePath, PathChangeInfo> expected = {
+      {RelativePath{"created"}, PathChangeInfo{false, true}},
+      {RelativePath{"changed"}, PathChangeInfo{true, false}},
+      {RelativePath{"renamed"}, PathChangeInfo{false, true}}};
+  EXPECT_EQ(expected, summed->changedFilesInOverlay);
+  EXPECT_EQ(hash1, journal.getLatest()->toHash);
+
+  journal.recordCreated("after"_relpath);
+  EXPECT_EQ(6, journal.getLatest()->sequenceID);
+}
+
+TEST_F(JournalTest, notifications_are_coalesced_within_interval) {
+  journal.setNotificationInterval(std::chrono::milliseconds{50});
+  std::atomic<size_t> calls{0};
+  folly::Baton<> deferredDelivered;
+  auto id = journal.registerSubscriber([&] {
+    if (++calls == 2) {
+      deferredDelivered.post();
+    }
+  });
+
+  journal.recordChanged("file"_relpath);
+  EXPECT_EQ(1u, calls);
+
+  // These changes are observed, but come too soon after the notification.
+  journal.getLatest();
+  journal.recordChanged("file"_relpath);
+  journal.getLatest();
+  journal.recordCreated("other"_relpath);
+  EXPECT_EQ(1u, calls);
+
+  ASSERT_TRUE(deferredDelivered.try_wait_for(std::chrono::seconds{10}));
+  EXPECT_EQ(2u, calls);
+
+  // The deferred notification covered every change made before it fired.
+  journal.recordChanged("file"_relpath);
+  EXPECT_EQ(2u, calls);
+  journal.cancelSubscriber(id);
+}
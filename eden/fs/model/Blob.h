@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 #include <string>
 #include "eden/fs/model/Hash.h"
@@ -47,6 +48,23 @@ class Blob {
     return size_;
   }
 
+  /**
+   * Return at most length bytes of the contents starting at offset, sharing
+   * storage with the blob. Empty if offset is at or past the end.
+   */
+  std::unique_ptr<folly::IOBuf> getContentsRange(
+      uint64_t offset,
+      uint64_t length) const {
+    if (offset >= size_) {
+      return folly::IOBuf::create(0);
+    }
+    folly::io::Cursor cursor(&contents_);
+    cursor.skip(offset);
+    std::unique_ptr<folly::IOBuf> result;
+    cursor.cloneAtMost(result, length);
+    return result;
+  }
+
   size_t getSizeBytes() const {
     return size_;
   }
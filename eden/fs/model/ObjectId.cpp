@@ -11,6 +11,7 @@
 #include <folly/Conv.h>
 #include <folly/Format.h>
 #include <folly/String.h>
+#include <folly/hash/SpookyHashV2.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 #include <folly/ssl/OpenSSLHash.h>
@@ -35,7 +36,10 @@ std::string ObjectId::asString() const {
 }
 
 size_t ObjectId::getHashCode() const noexcept {
-  return std::hash<folly::fbstring>{}(bytes_);
+  // std::hash<fbstring> is a byte at a time 32-bit FNV hash, which is slow
+  // for the long ids that embed a path and needs to be mixed again by F14.
+  return static_cast<size_t>(
+      folly::hash::SpookyHashV2::Hash64(bytes_.data(), bytes_.size(), 0));
 }
 
 bool ObjectId::operator==(const ObjectId& otherHash) const {
@@ -14,6 +14,7 @@
 #include <stdint.h>
 #include <array>
 #include <iosfwd>
+#include <type_traits>
 
 namespace folly {
 class IOBuf;
@@ -86,6 +87,10 @@ class ObjectId : boost::totally_ordered<ObjectId> {
   /** @return bytes of this ObjectId. */
   std::string asString() const;
 
+  /**
+   * A 64-bit hash of the bytes of this ObjectId, with every bit depending on
+   * all of them.
+   */
   size_t getHashCode() const noexcept;
 
   bool operator==(const ObjectId&) const;
@@ -165,6 +170,9 @@ class ObjectIdCodec {
 namespace std {
 template <>
 struct hash<facebook::eden::ObjectId> {
+  // Lets F14 maps use the hash code as is rather than mixing it again.
+  using folly_is_avalanching = std::true_type;
+
   size_t operator()(const facebook::eden::ObjectId& hash) const noexcept {
     return hash.getHashCode();
   }
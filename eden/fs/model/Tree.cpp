@@ -7,6 +7,9 @@
 
 #include "Tree.h"
 #include <folly/io/IOBuf.h>
+#include <folly/lang/Bits.h>
+#include <cstring>
+#include <numeric>
 
 namespace facebook::eden {
 using namespace folly;
@@ -21,6 +24,74 @@ bool operator!=(const Tree& tree1, const Tree& tree2) {
   return !(tree1 == tree2);
 }
 
+uint64_t Tree::getNamePrefix(folly::StringPiece name) {
+  uint64_t prefix = 0;
+  memcpy(&prefix, name.data(), std::min(name.size(), sizeof(prefix)));
+  return folly::Endian::big(prefix);
+}
+
+std::vector<uint64_t> Tree::computeNamePrefixes(
+    const std::vector<TreeEntry>& entries) {
+  std::vector<uint64_t> prefixes;
+  prefixes.reserve(entries.size());
+  for (const auto& entry : entries) {
+    prefixes.push_back(getNamePrefix(entry.getName().stringPiece()));
+  }
+  return prefixes;
+}
+
+#ifdef _WIN32
+std::vector<uint32_t> Tree::computeCaseFoldedIndex(
+    const std::vector<TreeEntry>& entries) {
+  XCHECK_LE(entries.size(), std::numeric_limits<uint32_t>::max());
+  std::vector<uint32_t> index(entries.size());
+  std::iota(index.begin(), index.end(), 0);
+  std::sort(
+      index.begin(), index.end(), [&entries](uint32_t left, uint32_t right) {
+        return caseInsensitiveLess(
+            entries[left].getName().stringPiece(),
+            entries[right].getName().stringPiece());
+      });
+  return index;
+}
+#endif
+
+const TreeEntry* Tree::getEntryPtr(PathComponentPiece path) const {
+  auto prefix = getNamePrefix(path.stringPiece());
+  auto range = std::equal_range(
+      namePrefixes_.cbegin(), namePrefixes_.cend(), prefix);
+  auto first = entries_.cbegin() + (range.first - namePrefixes_.cbegin());
+  auto last = entries_.cbegin() + (range.second - namePrefixes_.cbegin());
+  auto iter = std::lower_bound(
+      first, last, path, [](const TreeEntry& entry, PathComponentPiece piece) {
+        return entry.getName() < piece;
+      });
+  if (UNLIKELY(iter == last || iter->getName() != path)) {
+#ifdef _WIN32
+    // On Windows we need to do a case insensitive lookup for the file and
+    // directory names. For performance, we will do a case sensitive search
+    // first which should cover most of the cases and if not found then do a
+    // case insensitive search.
+    auto fileName = path.stringPiece();
+    auto folded = std::lower_bound(
+        caseFoldedIndex_.cbegin(),
+        caseFoldedIndex_.cend(),
+        fileName,
+        [this](uint32_t index, folly::StringPiece name) {
+          return caseInsensitiveLess(
+              entries_[index].getName().stringPiece(), name);
+        });
+    if (folded != caseFoldedIndex_.cend() &&
+        entries_[*folded].getName().stringPiece().equals(
+            fileName, folly::AsciiCaseInsensitive())) {
+      return &entries_[*folded];
+    }
+#endif
+    return nullptr;
+  }
+  return &*iter;
+}
+
 size_t Tree::getSizeBytes() const {
   // TODO: we should consider using a standard memory framework across
   // eden for this type of thing. D17174143 is one such idea.
@@ -32,6 +103,12 @@ size_t Tree::getSizeBytes() const {
   for (auto& entry : entries_) {
     indirect_size += entry.getIndirectSizeBytes();
   }
+  indirect_size +=
+      folly::goodMallocSize(sizeof(uint64_t) * namePrefixes_.capacity());
+#ifdef _WIN32
+  indirect_size +=
+      folly::goodMallocSize(sizeof(uint32_t) * caseFoldedIndex_.capacity());
+#endif
   return internal_size + indirect_size;
 }
 
@@ -83,7 +160,7 @@ std::optional<Tree> Tree::tryDeserialize(
     if (!entry) {
       return std::nullopt;
     }
-    entries.push_back(*entry);
+    entries.push_back(std::move(*entry));
   }
 
   if (data.size() != 0u) {
@@ -17,8 +17,14 @@ namespace facebook::eden {
 
 class Tree {
  public:
-  explicit Tree(std::vector<TreeEntry>&& entries, const ObjectId& hash)
-      : hash_(hash), entries_(std::move(entries)) {}
+  explicit Tree(std::vector<TreeEntry>&& entries, ObjectId hash)
+      : hash_(std::move(hash)),
+        entries_(std::move(entries)),
+        namePrefixes_(computeNamePrefixes(entries_)) {
+#ifdef _WIN32
+    caseFoldedIndex_ = computeCaseFoldedIndex(entries_);
+#endif
+  }
 
   const ObjectId& getHash() const {
     return hash_;
@@ -38,32 +44,10 @@ class Tree {
     return entries_.at(index);
   }
 
-  const TreeEntry* getEntryPtr(PathComponentPiece path) const {
-    auto iter = std::lower_bound(
-        entries_.cbegin(),
-        entries_.cend(),
-        path,
-        [](const TreeEntry& entry, PathComponentPiece piece) {
-          return entry.getName() < piece;
-        });
-    if (UNLIKELY(iter == entries_.cend() || iter->getName() != path)) {
-#ifdef _WIN32
-      // On Windows we need to do a case insensitive lookup for the file and
-      // directory names. For performance, we will do a case sensitive search
-      // first which should cover most of the cases and if not found then do a
-      // case sensitive search.
-      const auto& fileName = path.stringPiece();
-      for (const auto& entry : entries_) {
-        if (entry.getName().stringPiece().equals(
-                fileName, folly::AsciiCaseInsensitive())) {
-          return &entry;
-        }
-      }
-#endif
-      return nullptr;
-    }
-    return &*iter;
-  }
+  /**
+   * Look up an entry by name. The entries must be sorted by name.
+   */
+  const TreeEntry* getEntryPtr(PathComponentPiece path) const;
 
   const TreeEntry& getEntryAt(PathComponentPiece path) const {
     auto entry = getEntryPtr(path);
@@ -111,8 +95,38 @@ class Tree {
       folly::StringPiece data);
 
  private:
+  /**
+   * Returns the first 8 bytes of name as a big endian integer, padded with
+   * zeros, so that comparing prefixes orders names like comparing them.
+   */
+  static uint64_t getNamePrefix(folly::StringPiece name);
+  static std::vector<uint64_t> computeNamePrefixes(
+      const std::vector<TreeEntry>& entries);
+#ifdef _WIN32
+  static std::vector<uint32_t> computeCaseFoldedIndex(
+      const std::vector<TreeEntry>& entries);
+#endif
+
+  // Trees are immutable through their interface; the entries are not const
+  // only so that a deserialized Tree can be moved rather than copied.
   const ObjectId hash_;
-  const std::vector<TreeEntry> entries_;
+  std::vector<TreeEntry> entries_;
+  /**
+   * The name prefix of each entry, in the same order.
+   *
+   * The names of the entries live in separate allocations, so a binary
+   * search over the entries takes a cache miss at each step. Lookups search
+   * this contiguous table instead and only compare the full names of the
+   * entries that share the prefix of the path.
+   */
+  std::vector<uint64_t> namePrefixes_;
+#ifdef _WIN32
+  /**
+   * The positions of the entries sorted by caseInsensitiveLess, for the
+   * lookups that do not match the case of the entry.
+   */
+  std::vector<uint32_t> caseFoldedIndex_;
+#endif
 
   static constexpr uint32_t V1_VERSION = 1u;
 };
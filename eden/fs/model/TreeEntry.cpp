@@ -129,16 +129,8 @@ void TreeEntry::serialize(Appender& appender) const {
   XCHECK_LE(name.size(), std::numeric_limits<uint16_t>::max());
   appender.write<uint16_t>(folly::to_narrow(name.size()));
   appender.push(name);
-  if (size_) {
-    appender.write<uint64_t>(*size_);
-  } else {
-    appender.write<uint64_t>(NO_SIZE);
-  }
-  if (contentSha1_) {
-    appender.push(contentSha1_->getBytes());
-  } else {
-    appender.push(kZeroHash.getBytes());
-  }
+  appender.write<uint64_t>(size_);
+  appender.push(contentSha1_.getBytes());
 }
 
 std::optional<TreeEntry> TreeEntry::deserialize(folly::StringPiece& data) {
@@ -218,7 +210,8 @@ std::optional<TreeEntry> TreeEntry::deserialize(folly::StringPiece& data) {
     sha1 = sha1_raw;
   }
 
-  return TreeEntry{hash, name, (TreeEntryType)type, size, sha1};
+  return TreeEntry{
+      std::move(hash), std::move(name), (TreeEntryType)type, size, sha1};
 }
 
 } // namespace facebook::eden
@@ -45,23 +45,21 @@ std::optional<TreeEntryType> treeEntryTypeFromMode(mode_t mode);
 
 class TreeEntry {
  public:
-  explicit TreeEntry(
-      const ObjectId& hash,
-      PathComponent name,
-      TreeEntryType type)
-      : type_(type), hash_(hash), name_(std::move(name)) {}
+  explicit TreeEntry(ObjectId hash, PathComponent name, TreeEntryType type)
+      : type_(type), hash_(std::move(hash)), name_(std::move(name)) {}
 
   explicit TreeEntry(
-      const ObjectId& hash,
+      ObjectId hash,
       PathComponent name,
       TreeEntryType type,
       std::optional<uint64_t> size,
       std::optional<Hash20> contentSha1)
       : type_(type),
-        hash_(hash),
+        hasContentSha1_(contentSha1.has_value()),
+        contentSha1_(contentSha1.value_or(kZeroHash)),
+        hash_(std::move(hash)),
         name_(std::move(name)),
-        size_(size),
-        contentSha1_(contentSha1) {}
+        size_(size.value_or(NO_SIZE)) {}
 
   const ObjectId& getHash() const {
     return hash_;
@@ -110,11 +108,17 @@ class TreeEntry {
 
   std::string toLogString() const;
 
-  const std::optional<uint64_t>& getSize() const {
+  std::optional<uint64_t> getSize() const {
+    if (size_ == NO_SIZE) {
+      return std::nullopt;
+    }
     return size_;
   }
 
-  const std::optional<Hash20>& getContentSha1() const {
+  std::optional<Hash20> getContentSha1() const {
+    if (!hasContentSha1_) {
+      return std::nullopt;
+    }
     return contentSha1_;
   }
 
@@ -140,11 +144,15 @@ class TreeEntry {
   static std::optional<TreeEntry> deserialize(folly::StringPiece& data);
 
  private:
+  // Trees hold many entries, so the optional fields are packed: a missing
+  // size is stored as NO_SIZE, and the SHA-1 is paired with a flag that sits
+  // next to the type so that all three fit in the slot before hash_.
   TreeEntryType type_;
+  bool hasContentSha1_{false};
+  Hash20 contentSha1_;
   ObjectId hash_;
   PathComponent name_;
-  std::optional<uint64_t> size_;
-  std::optional<Hash20> contentSha1_;
+  uint64_t size_{NO_SIZE};
 
   static constexpr uint64_t NO_SIZE = std::numeric_limits<uint64_t>::max();
 };
@@ -67,20 +67,75 @@ void GitIgnore::loadFile(StringPiece contents) {
   // stop at the first match.
   std::reverse(newRules.begin(), newRules.end());
   std::swap(rules_, newRules);
+
+  exactBasenames_.clear();
+  exactPaths_.clear();
+  basenameSuffixes_.clear();
+  suffixLengths_.clear();
+  globRules_.clear();
+  for (uint32_t index = 0; index < rules_.size(); ++index) {
+    const auto& rule = rules_[index];
+    auto literal = rule.getLiteral();
+    switch (rule.getLiteralType()) {
+      case GitIgnorePattern::LiteralType::EXACT:
+        (rule.isBasenameOnly() ? exactBasenames_ : exactPaths_)[literal.str()]
+            .push_back(index);
+        break;
+      case GitIgnorePattern::LiteralType::SUFFIX:
+        basenameSuffixes_[literal.str()].push_back(index);
+        suffixLengths_.push_back(literal.size());
+        break;
+      case GitIgnorePattern::LiteralType::NONE:
+        globRules_.push_back(index);
+        break;
+    }
+  }
+  std::sort(suffixLengths_.begin(), suffixLengths_.end());
+  suffixLengths_.erase(
+      std::unique(suffixLengths_.begin(), suffixLengths_.end()),
+      suffixLengths_.end());
 }
 
 GitIgnore::MatchResult GitIgnore::match(
     RelativePathPiece path,
     PathComponentPiece basename,
     FileType fileType) const {
-  for (const auto& pattern : rules_) {
-    auto result = pattern.match(path, basename, fileType);
-    if (result != NO_MATCH) {
-      return result;
+  // Find the matching rule of highest precedence, i.e. the lowest index. The
+  // indexes only give candidates: a rule may still only match directories.
+  auto bestIndex = static_cast<uint32_t>(rules_.size());
+  MatchResult bestResult = NO_MATCH;
+  auto tryRules = [&](const std::vector<uint32_t>& indices) {
+    for (auto index : indices) {
+      if (index >= bestIndex) {
+        return;
+      }
+      auto result = rules_[index].match(path, basename, fileType);
+      if (result != NO_MATCH) {
+        bestIndex = index;
+        bestResult = result;
+        return;
+      }
+    }
+  };
+  auto lookup = [&](const RuleIndex& rules, StringPiece key) {
+    auto it = rules.find(key);
+    if (it != rules.end()) {
+      tryRules(it->second);
+    }
+  };
+
+  auto name = basename.stringPiece();
+  lookup(exactBasenames_, name);
+  lookup(exactPaths_, path.stringPiece());
+  for (auto length : suffixLengths_) {
+    if (length > name.size()) {
+      break;
     }
+    lookup(basenameSuffixes_, name.subpiece(name.size() - length));
   }
+  tryRules(globRules_);
 
-  return NO_MATCH;
+  return bestResult;
 }
 
 string GitIgnore::matchString(MatchResult result) {
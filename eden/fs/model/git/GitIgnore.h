@@ -8,6 +8,8 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <folly/container/F14Map.h>
+#include <string>
 #include <vector>
 #include "eden/fs/utils/PathFuncs.h"
 
@@ -179,6 +181,25 @@ class GitIgnore {
    * listed in the .gitignore file).
    */
   std::vector<GitIgnorePattern> rules_;
+
+  /**
+   * Indices into rules_ of the patterns matching a literal string, in
+   * increasing order, keyed by that string.
+   */
+  using RuleIndex = folly::F14FastMap<std::string, std::vector<uint32_t>>;
+
+  /**
+   * The rules matching exactly one basename, or one path, and the rules
+   * matching the basenames with a given suffix, like "*.o". match() looks up
+   * the candidate rules in these instead of trying each of them, and only
+   * tries the remaining rules, in globRules_, one by one.
+   */
+  RuleIndex exactBasenames_;
+  RuleIndex exactPaths_;
+  RuleIndex basenameSuffixes_;
+  /** The distinct lengths of the keys of basenameSuffixes_, sorted. */
+  std::vector<size_t> suffixLengths_;
+  std::vector<uint32_t> globRules_;
 };
 
 } // namespace facebook::eden
@@ -12,6 +12,12 @@ using std::optional;
 
 namespace facebook::eden {
 
+namespace {
+bool hasGlobSpecials(StringPiece glob) {
+  return glob.find_first_of("*?[\\") != StringPiece::npos;
+}
+} // namespace
+
 optional<GitIgnorePattern> GitIgnorePattern::parseLine(StringPiece line) {
   uint32_t flags = 0;
 
@@ -137,11 +143,35 @@ optional<GitIgnorePattern> GitIgnorePattern::parseLine(StringPiece line) {
     return std::nullopt;
   }
 
-  return GitIgnorePattern(flags, std::move(matcher).value());
+  // Most patterns are file names or extensions, like "build" or "*.o".
+  // Recording them lets GitIgnore look them up instead of matching them one
+  // at a time. A '*' only stands for any string in a basename, since it
+  // doesn't match '/'.
+  auto literalType = LiteralType::NONE;
+  StringPiece literal;
+  if (!hasGlobSpecials(line)) {
+    literalType = LiteralType::EXACT;
+    literal = line;
+  } else if (
+      (flags & FLAG_BASENAME_ONLY) && line[0] == '*' &&
+      !hasGlobSpecials(line.subpiece(1))) {
+    literalType = LiteralType::SUFFIX;
+    literal = line.subpiece(1);
+  }
+
+  return GitIgnorePattern(
+      flags, std::move(matcher).value(), literalType, literal.str());
 }
 
-GitIgnorePattern::GitIgnorePattern(uint32_t flags, GlobMatcher&& matcher)
-    : flags_(flags), matcher_(std::move(matcher)) {}
+GitIgnorePattern::GitIgnorePattern(
+    uint32_t flags,
+    GlobMatcher&& matcher,
+    LiteralType literalType,
+    std::string literal)
+    : flags_(flags),
+      matcher_(std::move(matcher)),
+      literalType_(literalType),
+      literal_(std::move(literal)) {}
 
 GitIgnorePattern::~GitIgnorePattern() {}
 
@@ -9,6 +9,7 @@
 
 #include <folly/Range.h>
 #include <optional>
+#include <string>
 #include "eden/fs/model/git/GitIgnore.h"
 #include "eden/fs/model/git/GlobMatcher.h"
 
@@ -23,6 +24,20 @@ namespace facebook::eden {
  */
 class GitIgnorePattern {
  public:
+  /**
+   * Whether the paths matched by a pattern can be found out from a literal
+   * string, which lets GitIgnore find the patterns that may match a path with
+   * hash table lookups rather than by trying each of them.
+   */
+  enum class LiteralType : uint8_t {
+    /** The pattern has wildcards, it must be matched with its GlobMatcher. */
+    NONE,
+    /** The pattern only matches getLiteral() itself. */
+    EXACT,
+    /** The pattern is "*" followed by getLiteral(). */
+    SUFFIX,
+  };
+
   /**
    * Parse a line from a gitignore file.
    *
@@ -69,6 +84,26 @@ class GitIgnorePattern {
       PathComponentPiece basename,
       GitIgnore::FileType fileType) const;
 
+  /**
+   * Whether this pattern is matched against the basename of paths rather than
+   * their full path.
+   */
+  bool isBasenameOnly() const {
+    return flags_ & FLAG_BASENAME_ONLY;
+  }
+
+  LiteralType getLiteralType() const {
+    return literalType_;
+  }
+
+  /**
+   * The string matched by a pattern whose LiteralType is not NONE, or the
+   * empty string.
+   */
+  folly::StringPiece getLiteral() const {
+    return literal_;
+  }
+
  private:
   /**
    * Flag values that can be bitwise-ORed to create the flags_ value.
@@ -84,7 +119,11 @@ class GitIgnorePattern {
     FLAG_BASENAME_ONLY = 0x04,
   };
 
-  GitIgnorePattern(uint32_t flags, GlobMatcher&& matcher);
+  GitIgnorePattern(
+      uint32_t flags,
+      GlobMatcher&& matcher,
+      LiteralType literalType,
+      std::string literal);
 
   /**
    * A bit set of the Flags defined above.
@@ -94,6 +133,8 @@ class GitIgnorePattern {
    * The GlobMatcher object for performing matching.
    */
   GlobMatcher matcher_;
+  LiteralType literalType_{LiteralType::NONE};
+  std::string literal_;
 };
 
 } // namespace facebook::eden
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include "eden/fs/model/git/GitIgnore.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -56,10 +57,23 @@ class GitIgnoreStack {
       const GitIgnoreStack* parent,
       folly::StringPiece ignoreFileContents)
       : parent_{parent} {
-    ignore_.loadFile(ignoreFileContents);
+    auto ignore = std::make_shared<GitIgnore>();
+    ignore->loadFile(ignoreFileContents);
+    ignore_ = std::move(ignore);
   }
 
   GitIgnoreStack(const GitIgnoreStack* parent, GitIgnore ignore)
+      : ignore_{std::make_shared<const GitIgnore>(std::move(ignore))},
+        parent_{parent} {}
+
+  /**
+   * Create a new GitIgnoreStack sharing already parsed rules, for instance
+   * from a GitIgnoreCache. A null ignore is the same as having no .gitignore
+   * file.
+   */
+  GitIgnoreStack(
+      const GitIgnoreStack* parent,
+      std::shared_ptr<const GitIgnore> ignore)
       : ignore_{std::move(ignore)}, parent_{parent} {}
 
   /**
@@ -70,14 +84,15 @@ class GitIgnoreStack {
       GitIgnore::FileType fileType) const;
 
   bool empty() const {
-    return ignore_.empty();
+    return !ignore_ || ignore_->empty();
   }
 
  private:
   /**
-   * The GitIgnore info for this node on the stack
+   * The GitIgnore info for this node on the stack, or null if its directory
+   * has no .gitignore file.
    */
-  GitIgnore ignore_;
+  std::shared_ptr<const GitIgnore> ignore_;
 
   /**
    * A pointer to the next node in the stack.
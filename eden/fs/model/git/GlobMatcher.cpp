@@ -90,7 +90,42 @@ bool operator&(GlobOptions a, GlobOptions b) {
 }
 
 GlobMatcher::GlobMatcher(vector<uint8_t> pattern)
-    : pattern_(std::move(pattern)) {}
+    : pattern_(std::move(pattern)) {
+  // Most patterns are a single literal, optionally with one wildcard opcode
+  // before or after it. Recognize these shapes so that match() can handle
+  // them with memcmp() and memchr() rather than by going through
+  // tryMatchAt().
+  auto isLiteralAt = [&](size_t idx, size_t trailingBytes) {
+    return idx + 1 < pattern_.size() && pattern_[idx] == GLOB_LITERAL &&
+        idx + 2 + pattern_[idx + 1] + trailingBytes == pattern_.size();
+  };
+  auto setShape = [&](Shape shape, size_t lengthIdx, bool matchesDotfiles) {
+    shape_ = shape;
+    shapeMatchesDotfiles_ = matchesDotfiles;
+    shapeLiteralIdx_ = lengthIdx + 1;
+    shapeLiteralLength_ = pattern_[lengthIdx];
+  };
+
+  if (isLiteralAt(0, 0)) {
+    // "BUCK"
+    setShape(Shape::LITERAL, 1, true);
+  } else if (
+      pattern_.size() >= 3 && pattern_[0] == GLOB_ENDS_WITH &&
+      3 + pattern_[2] == pattern_.size()) {
+    // "*.cpp": GLOB_ENDS_WITH, bool, length, data
+    setShape(Shape::ENDS_WITH, 2, pattern_[1] == GLOB_TRUE);
+  } else if (
+      isLiteralAt(0, 2) &&
+      pattern_[pattern_.size() - 2] == GLOB_STAR_STAR_END) {
+    // "prefix/**": GLOB_LITERAL, length, data, GLOB_STAR_STAR_END, bool
+    setShape(Shape::STARTS_WITH, 1, pattern_.back() == GLOB_TRUE);
+  } else if (
+      pattern_.size() >= 2 && pattern_[0] == GLOB_STAR_STAR_SLASH &&
+      isLiteralAt(2, 0)) {
+    // "**/BUCK": GLOB_STAR_STAR_SLASH, bool, GLOB_LITERAL, length, data
+    setShape(Shape::ANY_DIR_ENDS_WITH, 3, pattern_[1] == GLOB_TRUE);
+  }
+}
 
 GlobMatcher::GlobMatcher() {}
 
@@ -467,6 +502,38 @@ bool GlobMatcher::addCharClass(
 }
 
 bool GlobMatcher::match(StringPiece text) const {
+  switch (shape_) {
+    case Shape::GENERAL:
+      break;
+    case Shape::LITERAL:
+      return text == getShapeLiteral();
+    case Shape::ENDS_WITH: {
+      // The same checks as the GLOB_ENDS_WITH opcode in tryMatchAt().
+      auto suffix = getShapeLiteral();
+      if (!shapeMatchesDotfiles_ && !text.empty() && text[0] == '.') {
+        return false;
+      }
+      return text.endsWith(suffix) &&
+          memchr(text.data(), '/', text.size() - suffix.size()) == nullptr;
+    }
+    case Shape::STARTS_WITH: {
+      auto prefix = getShapeLiteral();
+      if (!text.startsWith(prefix)) {
+        return false;
+      }
+      // The same check as the GLOB_STAR_STAR_END opcode in tryMatchAt(). The
+      // prefix always ends with a slash.
+      return shapeMatchesDotfiles_ ||
+          text.find("/.", prefix.size() - 1) == StringPiece::npos;
+    }
+    case Shape::ANY_DIR_ENDS_WITH:
+      // Most text doesn't end with the literal. When it does, leave checking
+      // the directories it is in to tryMatchAt().
+      if (!text.endsWith(getShapeLiteral())) {
+        return false;
+      }
+      break;
+  }
   return tryMatchAt(text, 0, 0);
 }
 
@@ -76,8 +76,33 @@ class GlobMatcher {
   bool match(folly::StringPiece text) const;
 
  private:
+  /**
+   * The common pattern shapes that match() handles without interpreting the
+   * pattern buffer, detected when the GlobMatcher is constructed.
+   */
+  enum class Shape : uint8_t {
+    /** Any other pattern, matched by tryMatchAt(). */
+    GENERAL,
+    /** A literal string, like "BUCK". */
+    LITERAL,
+    /** A literal suffix, like "*.cpp". */
+    ENDS_WITH,
+    /** A literal directory prefix, like "prefix/**". */
+    STARTS_WITH,
+    /** A literal path under any directory: "**", a slash, then "BUCK". */
+    ANY_DIR_ENDS_WITH,
+  };
+
   explicit GlobMatcher(std::vector<uint8_t> pattern);
 
+  /**
+   * The literal data of the pattern buffer, for shapes other than GENERAL.
+   */
+  folly::StringPiece getShapeLiteral() const {
+    return folly::StringPiece{folly::ByteRange{
+        pattern_.data() + shapeLiteralIdx_, shapeLiteralLength_}};
+  }
+
   static folly::Expected<size_t, std::string> parseBracketExpr(
       folly::StringPiece glob,
       size_t idx,
@@ -116,6 +141,16 @@ class GlobMatcher {
    * rather than heap-allocating them in a vector.
    */
   std::vector<uint8_t> pattern_;
+
+  Shape shape_{Shape::GENERAL};
+  /**
+   * For shapes with a wildcard part, whether it can match text starting with
+   * a '.', as per the bool byte of its opcode.
+   */
+  bool shapeMatchesDotfiles_{true};
+  /** Where the literal data is in pattern_. */
+  uint8_t shapeLiteralIdx_{0};
+  uint8_t shapeLiteralLength_{0};
 };
 
 } // namespace facebook::eden
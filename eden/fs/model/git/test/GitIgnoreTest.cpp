@@ -668,3 +668,36 @@ TEST(GitIgnore, directory) {
   // path known to be a file.  It expects ignored directories earlier in the
   // path to have already been filtered out.
 }
+
+TEST(GitIgnore, literalAndGlobPrecedence) {
+  // Literal, suffix and wildcard patterns are looked up separately, this
+  // checks that the last matching line still wins across them.
+  GitIgnore ignore;
+  ignore.loadFile(
+      "*.o\n"
+      "!keep.o\n"
+      "!*.o\n"
+      "main.o\n"
+      "src/gen.o\n"
+      "o*\n"
+      "!*s.o\n"
+      "out/\n");
+
+  EXPECT_IGNORE(ignore, EXCLUDE, "main.o");
+  EXPECT_IGNORE(ignore, EXCLUDE, "test/main.o");
+  EXPECT_IGNORE(ignore, INCLUDE, "keep.o");
+  EXPECT_IGNORE(ignore, INCLUDE, "lib.o");
+  EXPECT_IGNORE(ignore, INCLUDE, "libs.o");
+  EXPECT_IGNORE(ignore, EXCLUDE, "src/gen.o");
+  EXPECT_IGNORE(ignore, INCLUDE, "test/src/gen.o");
+  EXPECT_IGNORE(ignore, EXCLUDE, "obj.o");
+  EXPECT_IGNORE(ignore, INCLUDE, "objs.o");
+  EXPECT_IGNORE(ignore, INCLUDE, ".o");
+  EXPECT_IGNORE(ignore, EXCLUDE, "out");
+  EXPECT_IGNORE_DIR(ignore, EXCLUDE, "out");
+  EXPECT_IGNORE(ignore, NO_MATCH, "main.c");
+
+  ignore.loadFile("main.c\n");
+  EXPECT_IGNORE(ignore, EXCLUDE, "main.c");
+  EXPECT_IGNORE(ignore, NO_MATCH, "main.o");
+}
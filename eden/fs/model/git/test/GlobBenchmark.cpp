@@ -211,6 +211,30 @@ GBENCHMARK(endswith_fixed)(benchmark::State& state) {
   runBenchmark<EndsWithImpl>(state, ".txt", basenameCorpus);
 }
 
+GBENCHMARK(prefix_globmatch)(benchmark::State& state) {
+  runBenchmark<GlobMatcherImpl>(state, "Documentation/**", fullnameCorpus);
+}
+
+GBENCHMARK(prefix_wildmatch)(benchmark::State& state) {
+  runBenchmark<WildmatchImpl>(state, "Documentation/**", fullnameCorpus);
+}
+
+GBENCHMARK(prefix_re2)(benchmark::State& state) {
+  runBenchmark<RE2Impl>(state, "Documentation/.*", fullnameCorpus);
+}
+
+GBENCHMARK(anyDirFixedPath_globmatch)(benchmark::State& state) {
+  runBenchmark<GlobMatcherImpl>(state, "**/README", fullnameCorpus);
+}
+
+GBENCHMARK(anyDirFixedPath_wildmatch)(benchmark::State& state) {
+  runBenchmark<WildmatchImpl>(state, "**/README", fullnameCorpus);
+}
+
+GBENCHMARK(anyDirFixedPath_re2)(benchmark::State& state) {
+  runBenchmark<RE2Impl>(state, "(.*/)?README", fullnameCorpus);
+}
+
 GBENCHMARK(basenameGlob_globmatch)(benchmark::State& state) {
   runBenchmark<GlobMatcherImpl>(state, ".*.swp", basenameCorpus);
 }
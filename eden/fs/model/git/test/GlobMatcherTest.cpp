@@ -313,6 +313,46 @@ TEST(Glob, testIgnoreDotfiles) {
   EXPECT_IGNORE_DOTFILES_NOMATCH("foo/bar/.baz", "foo/**");
 }
 
+TEST(Glob, testSimpleShapes) {
+  // These pattern shapes don't go through the general pattern interpreter.
+  EXPECT_MATCH("BUCK", "BUCK");
+  EXPECT_NOMATCH("BUCK2", "BUCK");
+  EXPECT_NOMATCH("BUC", "BUCK");
+  EXPECT_NOMATCH("foo/BUCK", "BUCK");
+  EXPECT_MATCH("", "");
+  EXPECT_NOMATCH("x", "");
+  std::string longLiteral(300, 'x');
+  EXPECT_MATCH(longLiteral, longLiteral);
+  EXPECT_NOMATCH(longLiteral + "x", longLiteral);
+
+  EXPECT_MATCH("foo.cpp", "*.cpp");
+  EXPECT_MATCH(".cpp", "*.cpp");
+  EXPECT_NOMATCH("foo.cpp2", "*.cpp");
+  EXPECT_NOMATCH("cpp", "*.cpp");
+  EXPECT_NOMATCH("foo/bar.cpp", "*.cpp");
+  EXPECT_NOMATCH("foo/.cpp", "*.cpp");
+
+  EXPECT_MATCH("prefix/foo", "prefix/**");
+  EXPECT_MATCH("prefix/foo/bar", "prefix/**");
+  EXPECT_MATCH("prefix/.foo", "prefix/**");
+  EXPECT_NOMATCH("prefix", "prefix/**");
+  EXPECT_NOMATCH("prefix2/foo", "prefix/**");
+  EXPECT_NOMATCH("other/prefix/foo", "prefix/**");
+  EXPECT_IGNORE_DOTFILES_MATCH("prefix/foo/bar", "prefix/**");
+  EXPECT_IGNORE_DOTFILES_NOMATCH("prefix/foo/.bar", "prefix/**");
+  EXPECT_IGNORE_DOTFILES_MATCH(".prefix/foo", ".prefix/**");
+
+  EXPECT_MATCH("BUCK", "**/BUCK");
+  EXPECT_MATCH("foo/BUCK", "**/BUCK");
+  EXPECT_MATCH("foo/bar/BUCK", "**/BUCK");
+  EXPECT_MATCH(".foo/BUCK", "**/BUCK");
+  EXPECT_NOMATCH("foo/xBUCK", "**/BUCK");
+  EXPECT_NOMATCH("foo/BUCK/bar", "**/BUCK");
+  EXPECT_MATCH("foo/bar/baz", "**/bar/baz");
+  EXPECT_NOMATCH("foo/xbar/baz", "**/bar/baz");
+  EXPECT_IGNORE_DOTFILES_NOMATCH("foo/.bar/BUCK", "**/BUCK");
+}
+
 TEST(Glob, testOther) {
   // Test parsing "**" by itself
   EXPECT_BADGLOB("**");
@@ -6,6 +6,7 @@
  */
 
 #include "eden/fs/model/Hash.h"
+#include "eden/fs/model/ObjectId.h"
 
 #include <folly/String.h>
 #include <folly/container/Array.h>
@@ -219,3 +220,15 @@ TEST(Hash20, getHashCode) {
   // using 64 bits of data to contribute to the hash code.
   EXPECT_EQ(folly::Endian::big(0xfaceb00cdeadbeef), testHash.getHashCode());
 }
+
+TEST(ObjectId, getHashCode) {
+  // Ids that embed a path only differ in their last bytes, which must still
+  // change the hash code.
+  auto makeId = [](StringPiece bytes) { return ObjectId{ByteRange{bytes}}; };
+  auto id = makeId("\x01some/directory/file.txt");
+  EXPECT_EQ(
+      id.getHashCode(), makeId("\x01some/directory/file.txt").getHashCode());
+  EXPECT_NE(
+      id.getHashCode(), makeId("\x01some/directory/file.txu").getHashCode());
+  EXPECT_EQ(std::hash<ObjectId>{}(id), id.getHashCode());
+}
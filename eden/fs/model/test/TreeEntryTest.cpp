@@ -71,3 +71,26 @@ TEST(TreeEntry, testEntrySize) {
   EXPECT_LE(
       name.length() + Hash20::RAW_SIZE + sizeof(TreeEntryType), totalSize);
 }
+
+TEST(TreeEntry, optionalMetadataRoundTrips) {
+  auto hash = makeTestHash("faceb00c");
+  auto sha1 = makeTestHash20("1234");
+  TreeEntry withMetadata{
+      hash, PathComponent{"file.txt"}, TreeEntryType::REGULAR_FILE, 42, sha1};
+  EXPECT_EQ(42, withMetadata.getSize());
+  EXPECT_EQ(sha1, withMetadata.getContentSha1());
+
+  TreeEntry withoutMetadata{
+      hash, PathComponent{"file.txt"}, TreeEntryType::REGULAR_FILE};
+  EXPECT_EQ(std::nullopt, withoutMetadata.getSize());
+  EXPECT_EQ(std::nullopt, withoutMetadata.getContentSha1());
+
+  folly::IOBuf buf(folly::IOBuf::CREATE, withMetadata.serializedSize());
+  folly::io::Appender appender(&buf, 0);
+  withMetadata.serialize(appender);
+  auto data = folly::StringPiece{buf.coalesce()};
+  auto entry = TreeEntry::deserialize(data);
+  ASSERT_TRUE(entry.has_value());
+  EXPECT_EQ(42, entry->getSize());
+  EXPECT_EQ(sha1, entry->getContentSha1());
+}
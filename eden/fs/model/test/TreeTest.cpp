@@ -72,6 +72,36 @@ TEST(Tree, testGetEntryPtr) {
   EXPECT_EQ(nullptr, tree.getEntryPtr(nonExistentPath));
 }
 
+TEST(Tree, testGetEntryPtrWithSharedPrefixes) {
+  // Names that share their first 8 bytes, or are prefixes of each other, are
+  // ordered by the full names.
+  vector<string> names{
+      "a",
+      "abcdefg",
+      "abcdefgh",
+      "abcdefgh.cpp",
+      "abcdefgh.h",
+      "abcdefgi",
+      "b",
+      "\xff_non_ascii"};
+  vector<TreeEntry> entries;
+  for (const auto& name : names) {
+    entries.emplace_back(
+        testHash, PathComponent{name}, TreeEntryType::REGULAR_FILE);
+  }
+  Tree tree(std::move(entries), testHash);
+
+  for (const auto& name : names) {
+    auto entry = tree.getEntryPtr(PathComponentPiece{name});
+    ASSERT_NE(nullptr, entry) << name;
+    EXPECT_EQ(name, entry->getName().stringPiece());
+  }
+  EXPECT_EQ(nullptr, tree.getEntryPtr(PathComponentPiece{"abc"}));
+  EXPECT_EQ(nullptr, tree.getEntryPtr(PathComponentPiece{"abcdefgh.c"}));
+  EXPECT_EQ(nullptr, tree.getEntryPtr(PathComponentPiece{"abcdefgh.hpp"}));
+  EXPECT_EQ(nullptr, tree.getEntryPtr(PathComponentPiece{"c"}));
+}
+
 TEST(Tree, testSize) {
   std::string entryName{"file.txt"};
   auto entryType = TreeEntryType::REGULAR_FILE;
@@ -276,6 +276,8 @@ void SpawnedEdenInstance::timeoutExpired() noexcept {
   // Note that forwarding with cat like this will continue writing to the old
   // log file even if the log gets rotated, but this probably shouldn't be a
   // major problem in practice.
+  // Let the output we already read reach the file before cat appends to it.
+  log_->flush();
   SpawnedProcess::Options options;
   options.dup2(
       FileDescriptor(::dup(log_->fd()), "dup", FileDescriptor::FDType::Generic),
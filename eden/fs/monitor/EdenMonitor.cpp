@@ -101,7 +101,10 @@ EdenMonitor::EdenMonitor(
         config->maxRotatedLogFiles.getValue());
   }
   log_ = std::make_shared<LogFile>(
-      logDir + "edenfs.log"_relpath, maxLogSize, std::move(rotationStrategy));
+      logDir + "edenfs.log"_relpath,
+      maxLogSize,
+      std::move(rotationStrategy),
+      config->logBufferSize.getValue());
 }
 
 EdenMonitor::~EdenMonitor() {}
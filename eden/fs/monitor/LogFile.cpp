@@ -8,7 +8,9 @@
 #include "eden/fs/monitor/LogFile.h"
 
 #include <fcntl.h>
+#include <utility>
 
+#include <folly/Conv.h>
 #include <folly/FileUtil.h>
 #include <folly/String.h>
 #include <folly/logging/xlog.h>
@@ -40,24 +42,98 @@ namespace eden {
 LogFile::LogFile(
     const AbsolutePath& path,
     size_t maxSize,
-    std::unique_ptr<LogRotationStrategy> rotationStrategy)
+    std::unique_ptr<LogRotationStrategy> rotationStrategy,
+    size_t maxBufferSize)
     : path_{path},
       log_{path.c_str(), O_CREAT | O_WRONLY | O_APPEND | O_CLOEXEC, 0644},
       logSize_{getFileSize(path_, log_)},
       maxLogSize_{maxSize},
       rotationStrategy_{std::move(rotationStrategy)},
-      rotationThread_{[this] { runRotateThread(); }} {
+      rotationThread_{[this] { runRotateThread(); }},
+      maxBufferSize_{maxBufferSize} {
   if (rotationStrategy_) {
     rotationStrategy_->init(path_);
   }
+  if (maxBufferSize_ > 0) {
+    writerThread_ = std::thread{[this] { runWriterThread(); }};
+  }
 }
 
 LogFile::~LogFile() {
+  if (writerThread_.joinable()) {
+    writeBuffer_.lock()->stop = true;
+    writeCV_.notify_all();
+    writerThread_.join();
+  }
   triggerBackgroundRotation(std::nullopt);
   rotationThread_.join();
 }
 
 int LogFile::write(const void* buffer, size_t size) {
+  if (maxBufferSize_ == 0) {
+    std::lock_guard<std::mutex> lock{fileMutex_};
+    return writeToFile(buffer, size);
+  }
+
+  {
+    auto writeBuffer = writeBuffer_.lock();
+    if (writeBuffer->data.size() + size > maxBufferSize_) {
+      writeBuffer->droppedBytes += size;
+      return ENOBUFS;
+    }
+    writeBuffer->data.append(static_cast<const char*>(buffer), size);
+  }
+  writeCV_.notify_all();
+  return 0;
+}
+
+void LogFile::flush() {
+  auto writeBuffer = writeBuffer_.lock();
+  writeCV_.wait(writeBuffer.as_lock(), [&] {
+    return writeBuffer->data.empty() && writeBuffer->droppedBytes == 0 &&
+        !writeBuffer->writing;
+  });
+}
+
+void LogFile::runWriterThread() {
+  std::string data;
+  while (true) {
+    size_t droppedBytes;
+    {
+      auto writeBuffer = writeBuffer_.lock();
+      writeBuffer->writing = false;
+      writeCV_.notify_all();
+      writeCV_.wait(writeBuffer.as_lock(), [&] {
+        return !writeBuffer->data.empty() || writeBuffer->droppedBytes > 0 ||
+            writeBuffer->stop;
+      });
+      if (writeBuffer->data.empty() && writeBuffer->droppedBytes == 0) {
+        // stop was requested and everything was written.
+        break;
+      }
+      // Hand our emptied string back, so that its capacity gets reused.
+      data.clear();
+      std::swap(data, writeBuffer->data);
+      droppedBytes = std::exchange(writeBuffer->droppedBytes, 0);
+      writeBuffer->writing = true;
+    }
+
+    if (droppedBytes > 0) {
+      data += folly::to<std::string>(
+          "[edenfs_monitor: dropped ",
+          droppedBytes,
+          " bytes of log output because the log file could not keep up]\n");
+    }
+    std::lock_guard<std::mutex> lock{fileMutex_};
+    auto errnum = writeToFile(data.data(), data.size());
+    if (errnum != 0) {
+      XLOG_EVERY_MS(ERR, std::chrono::seconds{60})
+          << "error writing EdenFS log output: " << folly::errnoStr(errnum);
+    }
+  }
+}
+
+int LogFile::writeToFile(const void* buffer, size_t size) {
   // Always write the full input buffer, even if it would exceed maxLogSize_.
   // This reduces the chances of us splitting the log in the middle of a message
   // (but doesn't guarantee we won't).
@@ -81,10 +157,8 @@ int LogFile::write(const void* buffer, size_t size) {
 }
 
 void LogFile::rotate() {
-  // Note: we currently do not need synchronization here since edenfs_monitor
-  // runs with a single main thread and performs all logging in this thread.
-  // If we ever changed to logging from multiple threads we would need to add
-  // synchronization here.  e.g., by putting our state in a folly::Synchronized.
+  // Called with fileMutex_ held, either from write() or from the background
+  // writer thread.
   XLOG(DBG1) << "rotating log file " << path_;
 
   if (!rotationStrategy_) {
@@ -11,6 +11,8 @@
 #include <deque>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <string>
 #include <thread>
 
 #include <folly/File.h>
@@ -25,33 +27,65 @@ class LogRotationStrategy;
 
 class LogFile {
  public:
+  /**
+   * If maxBufferSize is not 0, write() only copies the data into a buffer of
+   * up to that many bytes, and a background thread writes it to the file and
+   * rotates it, so that a slow disk never blocks the caller. Data that does
+   * not fit in the buffer is dropped, and a line saying how much was dropped
+   * is written in its place.
+   */
   LogFile(
       const AbsolutePath& path,
       size_t maxSize,
-      std::unique_ptr<LogRotationStrategy> rotationStrategy);
+      std::unique_ptr<LogRotationStrategy> rotationStrategy,
+      size_t maxBufferSize = 0);
   ~LogFile();
 
   /**
    * Write data to the log file.
    *
-   * If the full buffer was successfully written 0 is returned.
-   * Returns an errno value on failure.
+   * If the full buffer was successfully written, or buffered for the
+   * background writer, 0 is returned. Returns an errno value on failure,
+   * including ENOBUFS when the data was dropped because the background
+   * writer's buffer is full.
    */
   int write(const void* buffer, size_t size);
 
+  /**
+   * Wait until the data buffered for the background writer, if any, has
+   * been written out.
+   */
+  void flush();
+
   int fd() const {
+    std::lock_guard<std::mutex> lock{fileMutex_};
     return log_.fd();
   }
 
  private:
   using RotateQueue = std::deque<std::optional<AbsolutePath>>;
 
+  struct WriteBuffer {
+    std::string data;
+    size_t droppedBytes{0};
+    /** Set while the writer thread writes out data it took from here. */
+    bool writing{false};
+    bool stop{false};
+  };
+
+  int writeToFile(const void* buffer, size_t size);
+  void runWriterThread();
   void rotate();
   folly::File mainThreadRotation();
   void triggerBackgroundRotation(std::optional<AbsolutePath>&& path);
   void runRotateThread();
 
   AbsolutePath const path_;
+  /**
+   * Protects log_ and logSize_, which the background writer updates when it
+   * is used.
+   */
+  mutable std::mutex fileMutex_;
   folly::File log_;
   size_t logSize_{0};
   size_t maxLogSize_{100 * 1024 * 1024};
@@ -60,6 +94,11 @@ class LogFile {
   std::condition_variable rotationCV_;
   folly::Synchronized<RotateQueue, std::mutex> rotationQueue_;
   std::thread rotationThread_;
+
+  size_t const maxBufferSize_;
+  std::condition_variable writeCV_;
+  folly::Synchronized<WriteBuffer, std::mutex> writeBuffer_;
+  std::thread writerThread_;
 };
 
 } // namespace eden
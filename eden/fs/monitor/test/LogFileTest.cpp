@@ -7,6 +7,7 @@
 
 #include <chrono>
 
+#include <folly/FileUtil.h>
 #include <folly/Range.h>
 #include <folly/logging/xlog.h>
 #include <folly/portability/GMock.h>
@@ -210,5 +211,32 @@ TEST(TimestampLogRotation, appendLogSuffix) {
       "foo.log-20200302.013456.123");
 }
 
+TEST(LogFile, backgroundWriter) {
+  auto tempdir = makeTempDir();
+  auto dir = AbsolutePath(tempdir.path().native());
+  auto logPath = dir + "test.log"_pc;
+
+  LogFile log(logPath, 1024 * 1024, nullptr, /*maxBufferSize=*/16);
+  EXPECT_EQ(0, log.write("hello ", 6));
+  EXPECT_EQ(0, log.write("world\n", 6));
+  log.flush();
+
+  string contents;
+  ASSERT_TRUE(folly::readFile(logPath.c_str(), contents));
+  EXPECT_EQ("hello world\n", contents);
+
+  // Writes that can never fit in the buffer are dropped, and the writer
+  // says so in the log.
+  string large(32, 'x');
+  EXPECT_EQ(ENOBUFS, log.write(large.data(), large.size()));
+  log.flush();
+  ASSERT_TRUE(folly::readFile(logPath.c_str(), contents));
+  EXPECT_EQ(
+      "hello world\n"
+      "[edenfs_monitor: dropped 32 bytes of log output because the log file "
+      "could not keep up]\n",
+      contents);
+}
+
 } // namespace eden
 } // namespace facebook
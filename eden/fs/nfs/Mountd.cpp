@@ -216,9 +216,14 @@ void MountdServerProcessor::unregisterMount(AbsolutePathPiece path) {
 
 Mountd::Mountd(
     folly::EventBase* evb,
-    std::shared_ptr<folly::Executor> threadPool)
+    std::shared_ptr<folly::Executor> threadPool,
+    std::shared_ptr<folly::IOThreadPoolExecutor> ioThreadPool)
     : proc_(std::make_shared<MountdServerProcessor>()),
-      server_(RpcServer::create(proc_, evb, std::move(threadPool))) {}
+      server_(RpcServer::create(
+          proc_,
+          evb,
+          std::move(threadPool),
+          std::move(ioThreadPool))) {}
 
 void Mountd::initialize(folly::SocketAddress addr, bool registerWithRpcbind) {
   server_->initialize(addr);
@@ -18,6 +18,7 @@
 
 namespace folly {
 class Executor;
+class IOThreadPoolExecutor;
 }
 
 namespace facebook::eden {
@@ -36,7 +37,10 @@ class Mountd {
    * to manually specify the port on which this server is bound, so registering
    * is not necessary for a properly behaving EdenFS.
    */
-  Mountd(folly::EventBase* evb, std::shared_ptr<folly::Executor> threadPool);
+  Mountd(
+      folly::EventBase* evb,
+      std::shared_ptr<folly::Executor> threadPool,
+      std::shared_ptr<folly::IOThreadPoolExecutor> ioThreadPool = nullptr);
 
   /**
    * Bind the RPC mountd program to the passed in address.
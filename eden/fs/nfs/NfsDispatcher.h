@@ -367,6 +367,14 @@ class NfsDispatcher {
       InodeNumber dir,
       ObjectFetchContext& context) = 0;
 
+  /**
+   * Flush the data written to the file referenced by the InodeNumber ino to
+   * stable storage. When datasync is true, only the data and the metadata
+   * needed to read it back are flushed.
+   */
+  virtual ImmediateFuture<folly::Unit>
+  fsync(InodeNumber ino, bool datasync, ObjectFetchContext& context) = 0;
+
  private:
   EdenStats* stats_{nullptr};
   const Clock& clock_;
@@ -9,6 +9,7 @@
 
 #include "eden/fs/nfs/NfsServer.h"
 
+#include <folly/executors/IOThreadPoolExecutor.h>
 #include <folly/executors/thread_factory/NamedThreadFactory.h>
 #include "eden/fs/nfs/Nfsd3.h"
 #include "eden/fs/utils/EdenTaskQueue.h"
@@ -18,13 +19,25 @@ namespace facebook::eden {
 NfsServer::NfsServer(
     folly::EventBase* evb,
     uint64_t numServicingThreads,
-    uint64_t maxInflightRequests)
+    uint64_t maxInflightRequests,
+    uint64_t numIoThreads,
+    uint64_t maxInflightRequestsPerMount)
     : evb_(evb),
+      // Two lanes: metadata requests, then reads, writes and commits. See
+      // Nfsd3ServerProcessor::getRequestPriority.
+      taskQueue_(new EdenTaskQueue(maxInflightRequests, 2)),
       threadPool_(std::make_shared<folly::CPUThreadPoolExecutor>(
           numServicingThreads,
-          std::make_unique<EdenTaskQueue>(maxInflightRequests),
+          std::unique_ptr<EdenTaskQueue>(taskQueue_),
           std::make_unique<folly::NamedThreadFactory>("NfsThreadPool"))),
-      mountd_(evb_, threadPool_) {}
+      ioThreadPool_(
+          numIoThreads == 0
+              ? nullptr
+              : std::make_shared<folly::IOThreadPoolExecutor>(
+                    numIoThreads,
+                    std::make_shared<folly::NamedThreadFactory>("NfsIo"))),
+      maxInflightRequestsPerMount_(maxInflightRequestsPerMount),
+      mountd_(evb_, threadPool_, ioThreadPool_) {}
 
 void NfsServer::initialize(
     folly::SocketAddress addr,
@@ -57,7 +70,9 @@ NfsServer::NfsMountInfo NfsServer::registerMount(
       requestTimeout,
       std::move(notifier),
       caseSensitive,
-      iosize);
+      iosize,
+      ioThreadPool_,
+      maxInflightRequestsPerMount_);
   mountd_.registerMount(path, rootIno);
 
   return {std::move(nfsd), mountd_.getAddr()};
@@ -71,6 +86,14 @@ folly::SemiFuture<folly::File> NfsServer::takeoverStop() {
   return mountd_.takeoverStop();
 }
 
+size_t NfsServer::getMetadataQueueDepth() const {
+  return taskQueue_->sizeOfPriority(folly::Executor::MID_PRI);
+}
+
+size_t NfsServer::getDataQueueDepth() const {
+  return taskQueue_->sizeOfPriority(folly::Executor::LO_PRI);
+}
+
 } // namespace facebook::eden
 
 #endif
@@ -16,10 +16,12 @@
 
 namespace folly {
 class Executor;
+class IOThreadPoolExecutor;
 }
 
 namespace facebook::eden {
 
+class EdenTaskQueue;
 class Notifier;
 class ProcessNameCache;
 
@@ -33,6 +35,15 @@ class NfsServer {
    * blocking thread pool initialized with numServicingThreads and
    * maxInflightRequests.
    *
+   * When numIoThreads is non-zero, the connected sockets are spread across
+   * that many EventBase threads instead of all running on evb. The listening
+   * sockets always run on evb.
+   *
+   * Reads, writes and commits are queued in their own lane of the thread
+   * pool, which prefers the metadata requests of the other lane. When
+   * maxInflightRequestsPerMount is non-zero, no more than that many requests
+   * of a single mount are processed concurrently.
+   *
    * One mountd program will be created per NfsServer, while one nfsd program
    * will be created per-mount point, this allows nfsd program to be only aware
    * of its own mount point which greatly simplifies it.
@@ -40,7 +51,9 @@ class NfsServer {
   NfsServer(
       folly::EventBase* evb,
       uint64_t numServicingThreads,
-      uint64_t maxInflightRequests);
+      uint64_t maxInflightRequests,
+      uint64_t numIoThreads = 0,
+      uint64_t maxInflightRequestsPerMount = 0);
 
   /**
    * Bind the NfsServer to the passed in socket.
@@ -96,6 +109,13 @@ class NfsServer {
 
   folly::SemiFuture<folly::File> takeoverStop();
 
+  /**
+   * Number of metadata requests (resp. reads, writes and commits) waiting
+   * for a thread.
+   */
+  size_t getMetadataQueueDepth() const;
+  size_t getDataQueueDepth() const;
+
   NfsServer(const NfsServer&) = delete;
   NfsServer(NfsServer&&) = delete;
   NfsServer& operator=(const NfsServer&) = delete;
@@ -103,7 +123,11 @@ class NfsServer {
 
  private:
   folly::EventBase* evb_;
+  // Owned by threadPool_.
+  EdenTaskQueue* taskQueue_;
   std::shared_ptr<folly::Executor> threadPool_;
+  std::shared_ptr<folly::IOThreadPoolExecutor> ioThreadPool_;
+  uint64_t maxInflightRequestsPerMount_;
   Mountd mountd_;
 };
 
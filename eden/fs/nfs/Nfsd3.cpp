@@ -14,6 +14,7 @@
 #include <sys/sysmacros.h>
 #endif
 
+#include <folly/Random.h>
 #include <folly/Utility.h>
 #include <folly/executors/SerialExecutor.h>
 #include <folly/futures/Future.h>
@@ -23,6 +24,7 @@
 #include "eden/fs/nfs/NfsdRpc.h"
 #include "eden/fs/telemetry/FsEventLogger.h"
 #include "eden/fs/telemetry/RequestMetricsScope.h"
+#include "eden/fs/telemetry/Tracing.h"
 #include "eden/fs/utils/Clock.h"
 #include "eden/fs/utils/IDGen.h"
 #include "eden/fs/utils/StaticAssert.h"
@@ -72,6 +74,14 @@ class Nfsd3ServerProcessor final : public RpcServerProcessor {
       uint32_t progVersion,
       uint32_t procNumber) override;
 
+  int8_t getRequestPriority(
+      uint32_t progNumber,
+      uint32_t progVersion,
+      uint32_t procNumber) override;
+
+  void recordQueueWait(int8_t priority, std::chrono::microseconds wait)
+      override;
+
   void onShutdown(RpcStopData stopData) override;
 
   ImmediateFuture<folly::Unit> null(
@@ -573,11 +583,13 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::read(
 /**
  * Generate a unique per-EdenFS instance write cookie.
  *
- * TODO(xavierd): Note that for now this will always be 0 as this is to handle
- * the case where the server restart while the client isn't aware.
+ * A client holds on to the data of UNSTABLE writes until a COMMIT returns the
+ * verifier the writes did. If EdenFS restarts in between, the verifier
+ * changes and the client knows to send the writes again.
  */
 writeverf3 makeWriteVerf() {
-  return 0;
+  static const writeverf3 verf = folly::Random::secureRand64();
+  return verf;
 }
 
 ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::write(
@@ -593,9 +605,24 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::write(
   queue.append(std::move(args.data));
   auto data = queue.split(args.count);
 
-  return dispatcher_
-      ->write(args.file.ino, std::move(data), args.offset, context)
-      .thenTry([ser = std::move(ser)](
+  // UNSTABLE writes are only as durable as the overlay's page cache until the
+  // client sends a COMMIT; the others are flushed before replying.
+  auto ino = args.file.ino;
+  auto stable = args.stable;
+  return dispatcher_->write(ino, std::move(data), args.offset, context)
+      .thenValue(
+          [this, ino, stable, &context](NfsDispatcher::WriteRes&& writeRes)
+              -> ImmediateFuture<NfsDispatcher::WriteRes> {
+            if (stable == stable_how::UNSTABLE) {
+              return std::move(writeRes);
+            }
+            return dispatcher_
+                ->fsync(ino, stable == stable_how::DATA_SYNC, context)
+                .thenValue([writeRes = std::move(writeRes)](auto&&) mutable {
+                  return std::move(writeRes);
+                });
+          })
+      .thenTry([ser = std::move(ser), stable](
                    folly::Try<NfsDispatcher::WriteRes> writeTry) mutable {
         if (writeTry.hasException()) {
           WRITE3res res{
@@ -616,12 +643,7 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::write(
                     /*file_wcc*/ statToWccData(
                         writeRes.preStat, writeRes.postStat),
                     /*count*/ folly::to_narrow(writeRes.written),
-                    // TODO(xavierd): the following is a total lie and we
-                    // should call inode->fdatasync() in the case where
-                    // args.stable is anything other than
-                    // stable_how::UNSTABLE. For testing purpose, this is
-                    // OK.
-                    /*committed*/ stable_how::FILE_SYNC,
+                    /*committed*/ stable,
                     /*verf*/ makeWriteVerf(),
                 }}}};
           XdrTrait<WRITE3res>::serialize(ser, res);
@@ -1130,7 +1152,7 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::readdir(
                                   .extractList<entry3>(),
                               /*eof*/ readdirRes.isEof,
                           }}}}};
-                XdrTrait<READDIR3res>::serialize(ser, res);
+                serializePresized(ser, res);
               }
               return folly::unit;
             });
@@ -1186,7 +1208,7 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::readdirplus(
                                   .extractList<entryplus3>(),
                               /*eof*/ readdirRes.isEof,
                           }}}}};
-                XdrTrait<READDIRPLUS3res>::serialize(ser, res);
+                serializePresized(ser, res);
               }
               return folly::unit;
             });
@@ -1240,28 +1262,31 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::fsinfo(
     NfsRequestContext& context) {
   serializeReply(ser, accept_stat::SUCCESS, context.getXid());
   auto args = XdrTrait<FSINFO3args>::deserialize(deser);
-  (void)args;
-
-  FSINFO3res res{
-      {{nfsstat3::NFS3_OK,
-        FSINFO3resok{
-            // TODO(xavierd): fill the post_op_attr.
-            post_op_attr{},
-            /*rtmax=*/iosize_,
-            /*rtpref=*/iosize_,
-            /*rtmult=*/1,
-            /*wtmax=*/iosize_,
-            /*wtpref=*/iosize_,
-            /*wtmult=*/1,
-            /*dtpref=*/iosize_,
-            /*maxfilesize=*/std::numeric_limits<uint64_t>::max(),
-            nfstime3{0, 1},
-            /*properties*/ FSF3_SYMLINK | FSF3_HOMOGENEOUS | FSF3_CANSETTIME,
-        }}}};
-
-  XdrTrait<FSINFO3res>::serialize(ser, res);
 
-  return folly::unit;
+  return dispatcher_->getattr(args.fsroot.ino, context)
+      .thenTry([this, ser = std::move(ser)](
+                   const folly::Try<struct stat>& tryStat) mutable {
+        FSINFO3res res{
+            {{nfsstat3::NFS3_OK,
+              FSINFO3resok{
+                  statToPostOpAttr(tryStat),
+                  /*rtmax=*/iosize_,
+                  /*rtpref=*/iosize_,
+                  /*rtmult=*/1,
+                  /*wtmax=*/iosize_,
+                  /*wtpref=*/iosize_,
+                  /*wtmult=*/1,
+                  /*dtpref=*/iosize_,
+                  /*maxfilesize=*/std::numeric_limits<uint64_t>::max(),
+                  nfstime3{0, 1},
+                  /*properties*/ FSF3_SYMLINK | FSF3_HOMOGENEOUS |
+                      FSF3_CANSETTIME,
+              }}}};
+
+        XdrTrait<FSINFO3res>::serialize(ser, res);
+
+        return folly::unit;
+      });
 }
 
 ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::pathconf(
@@ -1270,32 +1295,63 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::pathconf(
     NfsRequestContext& context) {
   serializeReply(ser, accept_stat::SUCCESS, context.getXid());
   auto args = XdrTrait<PATHCONF3args>::deserialize(deser);
-  (void)args;
-
-  PATHCONF3res res{
-      {{nfsstat3::NFS3_OK,
-        PATHCONF3resok{
-            // TODO(xavierd): fill up the post_op_attr
-            post_op_attr{},
-            /*linkmax=*/0,
-            /*name_max=*/NAME_MAX,
-            /*no_trunc=*/true,
-            /*chown_restricted=*/true,
-            /*case_insensitive=*/caseSensitive_ == CaseSensitivity::Insensitive,
-            /*case_preserving=*/true,
-        }}}};
-
-  XdrTrait<PATHCONF3res>::serialize(ser, res);
 
-  return folly::unit;
+  return dispatcher_->getattr(args.object.ino, context)
+      .thenTry([this, ser = std::move(ser)](
+                   const folly::Try<struct stat>& tryStat) mutable {
+        PATHCONF3res res{
+            {{nfsstat3::NFS3_OK,
+              PATHCONF3resok{
+                  statToPostOpAttr(tryStat),
+                  /*linkmax=*/0,
+                  /*name_max=*/NAME_MAX,
+                  /*no_trunc=*/true,
+                  /*chown_restricted=*/true,
+                  /*case_insensitive=*/caseSensitive_ ==
+                      CaseSensitivity::Insensitive,
+                  /*case_preserving=*/true,
+              }}}};
+
+        XdrTrait<PATHCONF3res>::serialize(ser, res);
+
+        return folly::unit;
+      });
 }
 
 ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::commit(
-    folly::io::Cursor /*deser*/,
+    folly::io::Cursor deser,
     folly::io::QueueAppender ser,
     NfsRequestContext& context) {
-  serializeReply(ser, accept_stat::PROC_UNAVAIL, context.getXid());
-  return folly::unit;
+  serializeReply(ser, accept_stat::SUCCESS, context.getXid());
+  auto args = XdrTrait<COMMIT3args>::deserialize(deser);
+
+  // The overlay has no notion of dirty ranges, so the whole file is flushed
+  // whatever the offset and count.
+  return dispatcher_->fsync(args.file.ino, /*datasync=*/false, context)
+      .thenTry([this, ser = std::move(ser), ino = args.file.ino, &context](
+                   folly::Try<folly::Unit> try_) mutable {
+        return dispatcher_->getattr(ino, context)
+            .thenTry([ser = std::move(ser), try_ = std::move(try_)](
+                         const folly::Try<struct stat>& tryStat) mutable {
+              if (try_.hasException()) {
+                COMMIT3res res{
+                    {{exceptionToNfsError(try_.exception()),
+                      COMMIT3resfail{wcc_data{
+                          pre_op_attr{}, statToPostOpAttr(tryStat)}}}}};
+                XdrTrait<COMMIT3res>::serialize(ser, res);
+              } else {
+                COMMIT3res res{
+                    {{nfsstat3::NFS3_OK,
+                      COMMIT3resok{
+                          /*file_wcc*/
+                          wcc_data{pre_op_attr{}, statToPostOpAttr(tryStat)},
+                          /*verf*/ makeWriteVerf(),
+                      }}}};
+                XdrTrait<COMMIT3res>::serialize(ser, res);
+              }
+              return folly::unit;
+            });
+      });
 }
 
 NfsArgsDetails formatNull(folly::io::Cursor /*deser*/) {
@@ -1568,9 +1624,15 @@ NfsArgsDetails formatPathconf(folly::io::Cursor deser) {
   return {fmt::format(FMT_STRING("ino={}"), args.object.ino), args.object.ino};
 }
 
-NfsArgsDetails formatCommit(folly::io::Cursor /*deser*/) {
-  // TODO(xavierd): Fill this in.
-  return {""};
+NfsArgsDetails formatCommit(folly::io::Cursor deser) {
+  auto args = XdrTrait<COMMIT3args>::deserialize(deser);
+  return {
+      fmt::format(
+          FMT_STRING("ino={}, offset={}, count={}"),
+          args.file.ino,
+          args.offset,
+          args.count),
+      args.file.ino};
 }
 
 using Handler = ImmediateFuture<folly::Unit> (Nfsd3ServerProcessor::*)(
@@ -1834,10 +1896,43 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::dispatchRpc(
   // handler function and is deleted when context unique_ptr goes out of the
   // scope at the `ensure` lambda.
   auto& contextRef = *context;
-  return (this->*handlerEntry.handler)(
-             std::move(deser), std::move(ser), contextRef)
-      .ensure([liveRequest = std::move(liveRequest),
-               context = std::move(context)]() {});
+  auto result = [&] {
+    auto cpuTime = contextRef.chargeCpuTime();
+    return (this->*handlerEntry.handler)(
+        std::move(deser), std::move(ser), contextRef);
+  }();
+  return std::move(result).ensure([liveRequest = std::move(liveRequest),
+                                   context = std::move(context)]() {});
+}
+
+int8_t Nfsd3ServerProcessor::getRequestPriority(
+    uint32_t progNumber,
+    uint32_t /*progVersion*/,
+    uint32_t procNumber) {
+  if (progNumber != kNfsdProgNumber) {
+    return folly::Executor::MID_PRI;
+  }
+  // Bulk data transfers go to their own lane so that a burst of them (e.g. a
+  // Spotlight or antivirus scan) doesn't hold back the lookups and getattrs
+  // of interactive tools.
+  switch (static_cast<nfsv3Procs>(procNumber)) {
+    case nfsv3Procs::read:
+    case nfsv3Procs::write:
+    case nfsv3Procs::commit:
+      return folly::Executor::LO_PRI;
+    default:
+      return folly::Executor::MID_PRI;
+  }
+}
+
+void Nfsd3ServerProcessor::recordQueueWait(
+    int8_t priority,
+    std::chrono::microseconds wait) {
+  dispatcher_->getStats()->getChannelStatsForCurrentThread().recordLatency(
+      priority == folly::Executor::LO_PRI
+          ? &ChannelThreadStats::nfsDispatchWaitData
+          : &ChannelThreadStats::nfsDispatchWaitMetadata,
+      wait);
 }
 
 void Nfsd3ServerProcessor::onShutdown(RpcStopData data) {
@@ -1858,7 +1953,9 @@ Nfsd3::Nfsd3(
     folly::Duration /*requestTimeout*/,
     std::shared_ptr<Notifier> /*notifier*/,
     CaseSensitivity caseSensitive,
-    uint32_t iosize)
+    uint32_t iosize,
+    std::shared_ptr<folly::IOThreadPoolExecutor> ioThreadPool,
+    size_t maxInflightRequests)
     : server_(RpcServer::create(
           std::make_shared<Nfsd3ServerProcessor>(
               std::move(dispatcher),
@@ -1870,7 +1967,9 @@ Nfsd3::Nfsd3(
               traceDetailedArguments_,
               traceBus_),
           evb,
-          std::move(threadPool))),
+          std::move(threadPool),
+          std::move(ioThreadPool),
+          maxInflightRequests)),
       processAccessLog_(std::move(processNameCache)),
       invalidationExecutor_{
           folly::SerialExecutor::create(folly::getGlobalCPUExecutor())},
@@ -1888,7 +1987,10 @@ Nfsd3::Nfsd3(
             // therefore fail. We just ignore duplicated requests.
             (void)state->requests.emplace(
                 event.getXid(),
-                OutstandingRequest{event.getXid(), event.monotonicTime});
+                OutstandingRequest{
+                    event.getXid(),
+                    event.getProcNumber(),
+                    event.monotonicTime});
             break;
           }
           case NfsTraceEvent::FINISH: {
@@ -1913,6 +2015,12 @@ Nfsd3::Nfsd3(
                   nfsProcName(procNumber),
               });
             }
+            recordTraceSpan(TraceSpan{
+                event.monotonicTime - durationNs,
+                durationNs,
+                event.getXid(),
+                "nfs",
+                nfsProcName(event.getProcNumber())});
             break;
           }
         }
@@ -20,6 +20,7 @@
 
 namespace folly {
 class Executor;
+class IOThreadPoolExecutor;
 }
 
 namespace facebook::eden {
@@ -121,6 +122,10 @@ class Nfsd3 {
    * All the socket processing will be run on the EventBase passed in. This
    * also must be called on that EventBase thread.
    *
+   * When maxInflightRequests is non-zero, no more than that many requests of
+   * this mount are processed concurrently, so that one busy mount can't
+   * occupy the whole thread pool.
+   *
    * Note: at mount time, EdenFS will manually call mount.nfs with -o port
    * to manually specify the port on which this server is bound, so registering
    * is not necessary for a properly behaving EdenFS.
@@ -135,7 +140,9 @@ class Nfsd3 {
       folly::Duration requestTimeout,
       std::shared_ptr<Notifier> notifications,
       CaseSensitivity caseSensitive,
-      uint32_t iosize);
+      uint32_t iosize,
+      std::shared_ptr<folly::IOThreadPoolExecutor> ioThreadPool = nullptr,
+      size_t maxInflightRequests = 0);
 
   /**
    * This is triggered when the kernel closes the socket. The socket is closed
@@ -182,6 +189,7 @@ class Nfsd3 {
 
   struct OutstandingRequest {
     uint32_t xid;
+    uint32_t procNumber;
     std::chrono::steady_clock::time_point requestStartTime;
   };
 
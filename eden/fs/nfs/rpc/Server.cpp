@@ -13,6 +13,7 @@
 
 #include <folly/Exception.h>
 #include <folly/String.h>
+#include <folly/executors/IOThreadPoolExecutor.h>
 #include <folly/executors/QueuedImmediateExecutor.h>
 #include <folly/futures/Future.h>
 #include <folly/io/IOBufQueue.h>
@@ -104,10 +105,12 @@ RpcTcpHandler::RpcTcpHandler(
     std::shared_ptr<RpcServerProcessor> proc,
     AsyncSocket::UniquePtr&& socket,
     std::shared_ptr<folly::Executor> threadPool,
-    std::weak_ptr<RpcServer> owningServer)
+    std::weak_ptr<RpcServer> owningServer,
+    size_t maxInflightRequests)
     : proc_(proc),
       sock_(std::move(socket)),
       threadPool_(std::move(threadPool)),
+      maxInflightRequests_(maxInflightRequests),
       reader_(std::make_unique<Reader>(this)),
       state_(sock_->getEventBase()),
       owningServer_(std::move(owningServer)) {
@@ -218,26 +221,86 @@ void RpcTcpHandler::tryConsumeReadBuffer() noexcept {
     }
     XLOG(DBG7) << "received a request";
     state_.get().pendingRequests += 1;
+    // Metadata requests can be given precedence over reads and writes queued
+    // before them.
+    auto priority = threadPool_->getNumPriorities() > 1
+        ? std::optional<int8_t>{getPriority(*buf)}
+        : std::nullopt;
+    auto queuedPriority = priority.value_or(folly::Executor::MID_PRI);
     // Send the work to a thread pool to increase the number of inflight
     // requests that can be handled concurrently.
-    threadPool_->add(
-        [this, buf = std::move(buf), guard = DestructorGuard(this)]() mutable {
-          XLOG(DBG8) << "Received:\n"
-                     << folly::hexDump(buf->data(), buf->length());
-          auto data = buf->data();
-          auto fragmentHeader = folly::Endian::big(*(uint32_t*)data);
-          bool isLast = (fragmentHeader & 0x80000000) != 0;
-
-          // Supporting multiple fragments is expensive and requires playing
-          // with IOBuf to avoid copying data. Since neither macOS nor Linux
-          // are sending requests spanning multiple segments, let's not support
-          // these.
-          XCHECK(isLast);
-          buf->trimStart(sizeof(uint32_t));
-
-          dispatchAndReply(std::move(buf), std::move(guard));
-        });
+    auto work = [this,
+                 buf = std::move(buf),
+                 guard = DestructorGuard(this),
+                 queuedPriority,
+                 enqueued = std::chrono::steady_clock::now()]() mutable {
+      proc_->recordQueueWait(
+          queuedPriority,
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              std::chrono::steady_clock::now() - enqueued));
+      XLOG(DBG8) << "Received:\n"
+                 << folly::hexDump(buf->data(), buf->length());
+      auto data = buf->data();
+      auto fragmentHeader = folly::Endian::big(*(uint32_t*)data);
+      bool isLast = (fragmentHeader & 0x80000000) != 0;
+
+      // Supporting multiple fragments is expensive and requires playing
+      // with IOBuf to avoid copying data. Since neither macOS nor Linux
+      // are sending requests spanning multiple segments, let's not support
+      // these.
+      XCHECK(isLast);
+      buf->trimStart(sizeof(uint32_t));
+
+      dispatchAndReply(std::move(buf), std::move(guard));
+    };
+    if (priority) {
+      threadPool_->addWithPriority(std::move(work), *priority);
+    } else {
+      threadPool_->add(std::move(work));
+    }
+  }
+  maybePauseReading();
+}
+
+int8_t RpcTcpHandler::getPriority(const folly::IOBuf& request) {
+  // Only peek at the program and procedure numbers of the call header, the
+  // whole request is deserialized on the thread pool. These follow the
+  // fragment header, the xid, the message type and the RPC version.
+  folly::io::Cursor c(&request);
+  uint32_t prog, vers, procNumber;
+  if (!c.tryAdvance(4 * sizeof(uint32_t)) || !c.tryReadBE(prog) ||
+      !c.tryReadBE(vers) || !c.tryReadBE(procNumber)) {
+    // Malformed requests will fail deserializing.
+    return folly::Executor::MID_PRI;
+  }
+  return proc_->getRequestPriority(prog, vers, procNumber);
+}
+
+void RpcTcpHandler::maybePauseReading() {
+  auto& state = state_.get();
+  if (maxInflightRequests_ == 0 || state.readPaused ||
+      state.stopReason != RpcStopReason::RUNNING ||
+      state.pendingRequests < maxInflightRequests_) {
+    return;
+  }
+  XLOG(DBG5) << "pausing reads with " << state.pendingRequests
+             << " pending requests";
+  state.readPaused = true;
+  sock_->setReadCB(nullptr);
+}
+
+void RpcTcpHandler::maybeResumeReading() {
+  auto& state = state_.get();
+  // A takeover or shutdown also stops reading, reads must not be resumed
+  // behind its back.
+  if (!state.readPaused || state.stopReason != RpcStopReason::RUNNING ||
+      state.pendingRequests >= maxInflightRequests_) {
+    return;
   }
+  XLOG(DBG5) << "resuming reads with " << state.pendingRequests
+             << " pending requests";
+  state.readPaused = false;
+  sock_->setReadCB(reader_.get());
 }
 
 std::unique_ptr<folly::IOBuf> RpcTcpHandler::readOneRequest() noexcept {
@@ -414,6 +477,7 @@ void RpcTcpHandler::dispatchAndReply(
             }
           }
         }
+        maybeResumeReading();
       });
 }
 
@@ -422,9 +486,14 @@ void RpcServer::RpcAcceptCallback::connectionAccepted(
     const folly::SocketAddress& clientAddr,
     AcceptInfo /* info */) noexcept {
   XLOG(DBG7) << "Accepted connection from: " << clientAddr;
+  evb_->dcheckIsInEventBaseThread();
   auto socket = AsyncSocket::newSocket(evb_, fd);
   auto handler = RpcTcpHandler::create(
-      proc_, std::move(socket), threadPool_, owningServer_);
+      proc_,
+      std::move(socket),
+      threadPool_,
+      owningServer_,
+      maxInflightRequestsPerConnection_);
 
   if (auto server = owningServer_.lock()) {
     server->registerRpcHandler(std::move(handler));
@@ -455,6 +524,17 @@ auth_stat RpcServerProcessor::checkAuthentication(
   return auth_stat::AUTH_OK;
 }
 
+int8_t RpcServerProcessor::getRequestPriority(
+    uint32_t /*progNumber*/,
+    uint32_t /*progVersion*/,
+    uint32_t /*procNumber*/) {
+  return folly::Executor::MID_PRI;
+}
+
+void RpcServerProcessor::recordQueueWait(
+    int8_t /*priority*/,
+    std::chrono::microseconds /*wait*/) {}
+
 ImmediateFuture<folly::Unit> RpcServerProcessor::dispatchRpc(
     folly::io::Cursor /*deser*/,
     folly::io::QueueAppender /*ser*/,
@@ -470,62 +550,106 @@ void RpcServerProcessor::onShutdown(RpcStopData) {}
 std::shared_ptr<RpcServer> RpcServer::create(
     std::shared_ptr<RpcServerProcessor> proc,
     folly::EventBase* evb,
-    std::shared_ptr<folly::Executor> threadPool) {
-  return std::shared_ptr<RpcServer>{
-      new RpcServer{std::move(proc), evb, std::move(threadPool)}};
+    std::shared_ptr<folly::Executor> threadPool,
+    std::shared_ptr<folly::IOThreadPoolExecutor> ioThreadPool,
+    size_t maxInflightRequestsPerConnection) {
+  return std::shared_ptr<RpcServer>{new RpcServer{
+      std::move(proc),
+      evb,
+      std::move(threadPool),
+      std::move(ioThreadPool),
+      maxInflightRequestsPerConnection}};
 }
 
 RpcServer::RpcServer(
     std::shared_ptr<RpcServerProcessor> proc,
     folly::EventBase* evb,
-    std::shared_ptr<folly::Executor> threadPool)
+    std::shared_ptr<folly::Executor> threadPool,
+    std::shared_ptr<folly::IOThreadPoolExecutor> ioThreadPool,
+    size_t maxInflightRequestsPerConnection)
     : evb_(evb),
       threadPool_(threadPool),
-      acceptCb_(nullptr),
+      ioThreadPool_(std::move(ioThreadPool)),
+      maxInflightRequestsPerConnection_(maxInflightRequestsPerConnection),
+      acceptCbs_{},
       serverSocket_(new AsyncServerSocket(evb_)),
       proc_(std::move(proc)),
       rpcTcpHandlers_{} {}
 
-void RpcServer::initialize(folly::SocketAddress addr) {
-  acceptCb_.reset(new RpcServer::RpcAcceptCallback{
-      proc_, evb_, threadPool_, std::weak_ptr<RpcServer>{shared_from_this()}});
+std::vector<folly::EventBase*> RpcServer::getConnectionEventBases() const {
+  if (!ioThreadPool_) {
+    return {evb_};
+  }
+  std::vector<folly::EventBase*> evbs;
+  for (auto& evb : ioThreadPool_->getAllEventBases()) {
+    evbs.push_back(evb.get());
+  }
+  return evbs;
+}
+
+void RpcServer::startAccepting() {
+  // The AsyncServerSocket accepts on evb_ and hands each new connection to one
+  // of the callbacks in a round-robin fashion, on the callback's EventBase.
+  // This is what spreads connections (mountd requests, and the nfsd sockets
+  // of the various mounts) across the IO threads.
+  for (auto evb : getConnectionEventBases()) {
+    acceptCbs_.emplace_back(new RpcServer::RpcAcceptCallback{
+        proc_,
+        evb,
+        threadPool_,
+        std::weak_ptr<RpcServer>{shared_from_this()},
+        maxInflightRequestsPerConnection_});
+    serverSocket_->addAcceptCallback(acceptCbs_.back().get(), evb);
+  }
+  serverSocket_->startAccepting();
+}
 
+void RpcServer::initialize(folly::SocketAddress addr) {
   // Ask kernel to assign us a port on the loopback interface
   serverSocket_->bind(addr);
   serverSocket_->listen(1024);
 
-  serverSocket_->addAcceptCallback(acceptCb_.get(), evb_);
-  serverSocket_->startAccepting();
+  startAccepting();
 }
 
 void RpcServer::initialize(folly::File&& socket, InitialSocketType type) {
   switch (type) {
-    case InitialSocketType::CONNECTED_SOCKET:
+    case InitialSocketType::CONNECTED_SOCKET: {
       XLOG(DBG7) << "Initializing server from connected socket: "
                  << socket.fd();
       // Note we don't initialize the accepting socket in this case. This is
       // meant for server that only ever has one connected socket (nfsd3). Since
       // we already have the one connected socket, we will not need the
       // accepting socket to make any more connections.
-      rpcTcpHandlers_.wlock()->emplace_back(RpcTcpHandler::create(
-          proc_,
-          AsyncSocket::newSocket(
-              evb_, folly::NetworkSocket::fromFd(socket.release())),
-          threadPool_,
-          shared_from_this()));
+      if (!ioThreadPool_) {
+        rpcTcpHandlers_.wlock()->emplace_back(RpcTcpHandler::create(
+            proc_,
+            AsyncSocket::newSocket(
+                evb_, folly::NetworkSocket::fromFd(socket.release())),
+            threadPool_,
+            shared_from_this(),
+            maxInflightRequestsPerConnection_));
+      } else {
+        // The read callback must be installed from the socket's EventBase
+        // thread, hence the handler is created there.
+        auto evb = ioThreadPool_->getEventBase();
+        evb->runInEventBaseThreadAndWait([this, evb, fd = socket.release()]() {
+          rpcTcpHandlers_.wlock()->emplace_back(RpcTcpHandler::create(
+              proc_,
+              AsyncSocket::newSocket(evb, folly::NetworkSocket::fromFd(fd)),
+              threadPool_,
+              shared_from_this(),
+              maxInflightRequestsPerConnection_));
+        });
+      }
       return;
+    }
     case InitialSocketType::SERVER_SOCKET:
       XLOG(DBG7) << "Initializing server from server socket: " << socket.fd();
-      acceptCb_.reset(new RpcServer::RpcAcceptCallback{
-          proc_,
-          evb_,
-          threadPool_,
-          std::weak_ptr<RpcServer>{shared_from_this()}});
       serverSocket_->useExistingSocket(
           folly::NetworkSocket::fromFd(socket.release()));
 
-      serverSocket_->addAcceptCallback(acceptCb_.get(), evb_);
-      serverSocket_->startAccepting();
+      startAccepting();
       return;
   }
   throw std::runtime_error("Impossible socket type.");
@@ -550,9 +674,9 @@ void RpcServer::unregisterRpcHandler(RpcTcpHandler* handlerToErase) {
 folly::SemiFuture<folly::File> RpcServer::takeoverStop() {
   evb_->dcheckIsInEventBaseThread();
 
-  XLOG(DBG7) << "Removing accept callback";
-  if (acceptCb_) {
-    serverSocket_->removeAcceptCallback(acceptCb_.get(), evb_);
+  XLOG(DBG7) << "Removing accept callbacks";
+  for (auto& acceptCb : acceptCbs_) {
+    serverSocket_->removeAcceptCallback(acceptCb.get(), nullptr);
   }
   // implicitly pauses accepting on the socket.
   // not more connections will be made after this point.
@@ -569,7 +693,17 @@ folly::SemiFuture<folly::File> RpcServer::takeoverStop() {
   std::vector<folly::SemiFuture<folly::Unit>> futures{};
   futures.reserve(handlers.size());
   for (auto& handler : handlers) {
-    futures.emplace_back(handler->takeoverStop());
+    auto handlerEvb = handler->getEventBase();
+    if (handlerEvb == evb_) {
+      futures.emplace_back(handler->takeoverStop());
+    } else {
+      // takeoverStop must run on the socket's EventBase. The handler is moved
+      // along so that it is also released on that thread.
+      futures.emplace_back(
+          folly::via(handlerEvb, [handler = std::move(handler)]() mutable {
+            return handler->takeoverStop();
+          }).semi());
+    }
   }
   return collectAll(futures)
       .via(evb_) // make sure we are running on the eventbase to do some more
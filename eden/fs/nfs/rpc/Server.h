@@ -9,6 +9,7 @@
 
 #ifndef _WIN32
 
+#include <chrono>
 #include <vector>
 
 #include <folly/SocketAddress.h>
@@ -23,7 +24,8 @@
 
 namespace folly {
 class Executor;
-}
+class IOThreadPoolExecutor;
+} // namespace folly
 
 namespace facebook::eden {
 
@@ -57,6 +59,20 @@ class RpcServerProcessor {
  public:
   virtual ~RpcServerProcessor() = default;
   virtual auth_stat checkAuthentication(const call_body& call_body);
+  /**
+   * Priority with which a request for the given procedure is added to the
+   * thread pool, see folly::Executor::addWithPriority. Only used when the
+   * thread pool has more than one priority.
+   */
+  virtual int8_t getRequestPriority(
+      uint32_t progNumber,
+      uint32_t progVersion,
+      uint32_t procNumber);
+  /**
+   * Called on the thread pool right before a request is dispatched, with the
+   * priority it was queued with and how long it waited in the queue.
+   */
+  virtual void recordQueueWait(int8_t priority, std::chrono::microseconds wait);
   virtual ImmediateFuture<folly::Unit> dispatchRpc(
       folly::io::Cursor deser,
       folly::io::QueueAppender ser,
@@ -98,12 +114,20 @@ class RpcTcpHandler : public folly::DelayedDestruction {
    */
   folly::SemiFuture<folly::Unit> takeoverStop();
 
+  /**
+   * Return the EventBase that the socket of this handler is attached to.
+   */
+  folly::EventBase* getEventBase() const {
+    return sock_->getEventBase();
+  }
+
  private:
   RpcTcpHandler(
       std::shared_ptr<RpcServerProcessor> proc,
       folly::AsyncSocket::UniquePtr&& socket,
       std::shared_ptr<folly::Executor> threadPool,
-      std::weak_ptr<RpcServer> owningServer);
+      std::weak_ptr<RpcServer> owningServer,
+      size_t maxInflightRequests = 0);
 
   class Reader : public folly::AsyncReader::ReadCallback {
    public:
@@ -153,6 +177,23 @@ class RpcTcpHandler : public folly::DelayedDestruction {
    */
   void tryConsumeReadBuffer() noexcept;
 
+  /**
+   * Stop reading from the socket while this connection has
+   * maxInflightRequests_ requests being processed, and start again once some
+   * of them completed. Requests not read yet stay in the socket, which pushes
+   * back on the client.
+   *
+   * These must be called on the main event base of the socket.
+   */
+  void maybePauseReading();
+  void maybeResumeReading();
+
+  /**
+   * Return the thread pool priority of the RPC call in request, which still
+   * starts with its fragment header.
+   */
+  int8_t getPriority(const folly::IOBuf& request);
+
   /**
    * Delete the reader, called when the socket is closed or on takeover.
    *
@@ -194,6 +235,12 @@ class RpcTcpHandler : public folly::DelayedDestruction {
    */
   std::shared_ptr<folly::Executor> threadPool_;
 
+  /**
+   * Maximum number of requests of this connection that can be processed
+   * concurrently. 0 means unlimited.
+   */
+  const size_t maxInflightRequests_;
+
   /**
    * Reads raw data off the socket.
    */
@@ -217,6 +264,8 @@ class RpcTcpHandler : public folly::DelayedDestruction {
     RpcStopReason stopReason = RpcStopReason::RUNNING;
     // number of requests we are in the middle of processing
     size_t pendingRequests = 0;
+    // whether reading was paused due to maxInflightRequests_
+    bool readPaused = false;
 
     State() {}
     State(const State& state) = delete;
@@ -267,11 +316,20 @@ class RpcServer : public std::enable_shared_from_this<RpcServer> {
    *
    * Request will be received on the passed EventBase and dispatched to the
    * RpcServerProcessor on the passed in threadPool.
+   *
+   * When ioThreadPool is non-null, connected sockets are spread across its
+   * EventBases instead of all sharing evb, which then only runs the
+   * listening socket.
+   *
+   * When maxInflightRequestsPerConnection is non-zero, a connection stops
+   * being read from while that many of its requests are being processed.
    */
   static std::shared_ptr<RpcServer> create(
       std::shared_ptr<RpcServerProcessor> proc,
       folly::EventBase* evb,
-      std::shared_ptr<folly::Executor> threadPool);
+      std::shared_ptr<folly::Executor> threadPool,
+      std::shared_ptr<folly::IOThreadPoolExecutor> ioThreadPool = nullptr,
+      size_t maxInflightRequestsPerConnection = 0);
 
   ~RpcServer();
 
@@ -320,10 +378,23 @@ class RpcServer : public std::enable_shared_from_this<RpcServer> {
   void unregisterRpcHandler(RpcTcpHandler* handlerToErase);
 
  private:
+  /**
+   * Return the event bases that connected sockets should be attached to.
+   */
+  std::vector<folly::EventBase*> getConnectionEventBases() const;
+
+  /**
+   * Register one accept callback per connection event base on serverSocket_
+   * and start accepting.
+   */
+  void startAccepting();
+
   RpcServer(
       std::shared_ptr<RpcServerProcessor> proc,
       folly::EventBase* evb,
-      std::shared_ptr<folly::Executor> threadPool);
+      std::shared_ptr<folly::Executor> threadPool,
+      std::shared_ptr<folly::IOThreadPoolExecutor> ioThreadPool,
+      size_t maxInflightRequestsPerConnection);
 
   class RpcAcceptCallback : public folly::AsyncServerSocket::AcceptCallback,
                             public folly::DelayedDestruction {
@@ -335,11 +406,13 @@ class RpcServer : public std::enable_shared_from_this<RpcServer> {
         std::shared_ptr<RpcServerProcessor> proc,
         folly::EventBase* evb,
         std::shared_ptr<folly::Executor> threadPool,
-        std::weak_ptr<RpcServer> owningServer)
+        std::weak_ptr<RpcServer> owningServer,
+        size_t maxInflightRequestsPerConnection)
         : evb_(evb),
           proc_(proc),
           threadPool_(std::move(threadPool)),
           owningServer_(std::move(owningServer)),
+          maxInflightRequestsPerConnection_(maxInflightRequestsPerConnection),
           guard_(this) {}
 
    private:
@@ -358,6 +431,7 @@ class RpcServer : public std::enable_shared_from_this<RpcServer> {
     std::shared_ptr<RpcServerProcessor> proc_;
     std::shared_ptr<folly::Executor> threadPool_;
     std::weak_ptr<RpcServer> owningServer_;
+    size_t maxInflightRequestsPerConnection_;
 
     /**
      * Hold a guard to ourself to avoid being deleted until the callback is
@@ -374,8 +448,17 @@ class RpcServer : public std::enable_shared_from_this<RpcServer> {
   // Threadpool for processing requests off the main event base.
   std::shared_ptr<folly::Executor> threadPool_;
 
-  // will be called when clients connect to the server socket.
-  RpcAcceptCallback::UniquePtr acceptCb_;
+  // Optional pool of event bases that connected sockets are attached to. When
+  // null, all the sockets live on evb_.
+  std::shared_ptr<folly::IOThreadPoolExecutor> ioThreadPool_;
+
+  // See create().
+  size_t maxInflightRequestsPerConnection_;
+
+  // will be called when clients connect to the server socket. There is one
+  // callback per event base that accepts connections, the AsyncServerSocket
+  // round-robins new connections between them.
+  std::vector<RpcAcceptCallback::UniquePtr> acceptCbs_;
 
   // listening socket for this server.
   folly::AsyncServerSocket::UniquePtr serverSocket_;
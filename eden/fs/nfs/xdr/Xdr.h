@@ -625,6 +625,20 @@ struct XdrTrait<std::optional<T>> {
   }
 };
 
+/**
+ * Serialize value after reserving contiguous room for all of it.
+ *
+ * A QueueAppender grows its queue by its growth size at a time, so large
+ * replies made of many small fields (READDIRPLUS) otherwise allocate one
+ * small IOBuf after another. Don't use this for types holding IOBufs: these
+ * are appended by reference and reserving room for them would be wasted.
+ */
+template <typename T>
+void serializePresized(folly::io::QueueAppender& appender, const T& value) {
+  appender.ensure(XdrTrait<T>::serializedSize(value));
+  XdrTrait<T>::serialize(appender, value);
+}
+
 } // namespace facebook::eden
 
 #endif
@@ -151,6 +151,21 @@ struct ListHead {
 EDEN_XDR_SERDE_DECL(ListHead, elements);
 EDEN_XDR_SERDE_IMPL(ListHead, elements);
 
+TEST(XdrSerialize, iobufIsNotCopied) {
+  auto data = folly::IOBuf::copyBuffer(std::string(64 * 1024, 'a'));
+  auto dataPtr = data->data();
+  struct IOBufStruct buf {
+    42, std::move(data), 10
+  };
+
+  auto encoded = ser(buf);
+  bool found = false;
+  for (const auto& range : *encoded) {
+    found |= range.data() == dataPtr;
+  }
+  EXPECT_TRUE(found);
+}
+
 TEST(XdrSerialize, list) {
   std::vector<ListElement> elements;
   elements.emplace_back(ListElement{1});
@@ -163,6 +178,23 @@ TEST(XdrSerialize, list) {
   roundtrip(head);
 }
 
+TEST(XdrSerialize, presized) {
+  std::vector<ListElement> elements;
+  for (uint32_t i = 0; i < 1000; i++) {
+    elements.emplace_back(ListElement{i});
+  }
+  ListHead head{{std::move(elements)}};
+
+  folly::IOBufQueue queue;
+  folly::io::QueueAppender appender(&queue, 64);
+  serializePresized(appender, head);
+  auto encoded = queue.move();
+
+  EXPECT_FALSE(encoded->isChained());
+  EXPECT_EQ(encoded->length(), XdrTrait<ListHead>::serializedSize(head));
+  EXPECT_EQ(head, de<ListHead>(std::move(encoded)));
+}
+
 TEST(XdrSerialize, optional) {
   std::optional<uint32_t> nullOpt{std::nullopt};
   roundtrip(nullOpt);
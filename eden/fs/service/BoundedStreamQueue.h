@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/ExceptionWrapper.h>
+#include <folly/Portability.h>
+#include <folly/ScopeGuard.h>
+#include <folly/Synchronized.h>
+#include <thrift/lib/cpp2/async/ServerStream.h>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/AsyncGenerator.h>
+#include <folly/experimental/coro/Baton.h>
+#endif
+
+namespace facebook::eden {
+
+/**
+ * The elements of a thrift stream that the client didn't read yet, of which
+ * there are at most capacity. A client that can't keep up is disconnected
+ * with an error once the queue is full, rather than leaving EdenFS to buffer
+ * everything the producer comes up with.
+ *
+ * The client only reads at its own pace where coroutines are available.
+ * Otherwise the stream is fed by a ServerStreamPublisher, which doesn't tell
+ * when an element was read, so push() hands every element straight to it.
+ */
+template <typename T>
+class BoundedStreamQueue {
+ public:
+  /**
+   * Create the stream to return to thrift, and the queue that feeds it.
+   */
+  static std::pair<
+      apache::thrift::ServerStream<T>,
+      std::shared_ptr<BoundedStreamQueue>>
+  create(size_t capacity) {
+    auto queue = std::shared_ptr<BoundedStreamQueue>{
+        new BoundedStreamQueue{capacity}};
+#if FOLLY_HAS_COROUTINES
+    return {apache::thrift::ServerStream<T>{consume(queue)}, queue};
+#else
+    auto [stream, publisher] =
+        apache::thrift::ServerStream<T>::createPublisher(
+            [weakQueue = std::weak_ptr<BoundedStreamQueue>{queue}] {
+              if (auto queue = weakQueue.lock()) {
+                queue->disconnected_.store(true, std::memory_order_relaxed);
+              }
+            });
+    queue->state_.wlock()->publisher.emplace(std::move(publisher));
+    return {std::move(stream), queue};
+#endif
+  }
+
+  BoundedStreamQueue(const BoundedStreamQueue&) = delete;
+  BoundedStreamQueue& operator=(const BoundedStreamQueue&) = delete;
+
+  ~BoundedStreamQueue() {
+    // Destroying a publisher that wasn't completed aborts the process.
+    complete();
+  }
+
+  /**
+   * Queue item for the client. Returns false, dropping item, once the stream
+   * ended: because it was completed, the client went away or the queue was
+   * full.
+   */
+  bool push(T item) {
+    auto state = state_.wlock();
+    if (state->done || disconnected_.load(std::memory_order_relaxed)) {
+      return false;
+    }
+#if FOLLY_HAS_COROUTINES
+    if (state->items.size() >= capacity_) {
+      state->done = true;
+      state->items.clear();
+      state->error = folly::make_exception_wrapper<std::runtime_error>(
+          "the client fell too far behind the stream");
+      ready_.post();
+      return false;
+    }
+    state->items.push_back(std::move(item));
+    ready_.post();
+#else
+    state->publisher->next(std::move(item));
+#endif
+    return true;
+  }
+
+  /**
+   * End the stream once the client read what was pushed, with ew if set.
+   * Does nothing if the stream already ended.
+   */
+  void complete(folly::exception_wrapper ew = {}) {
+    auto state = state_.wlock();
+    if (state->done) {
+      return;
+    }
+    state->done = true;
+#if FOLLY_HAS_COROUTINES
+    state->error = std::move(ew);
+    ready_.post();
+#else
+    if (ew) {
+      std::move(*state->publisher).complete(std::move(ew));
+    } else {
+      std::move(*state->publisher).complete();
+    }
+#endif
+  }
+
+ private:
+  explicit BoundedStreamQueue(size_t capacity) : capacity_{capacity} {}
+
+  struct State {
+    bool done{false};
+#if FOLLY_HAS_COROUTINES
+    std::deque<T> items;
+    folly::exception_wrapper error;
+#else
+    std::optional<apache::thrift::ServerStreamPublisher<T>> publisher;
+#endif
+  };
+
+#if FOLLY_HAS_COROUTINES
+  static folly::coro::AsyncGenerator<T&&> consume(
+      std::shared_ptr<BoundedStreamQueue> queue) {
+    // Destroyed when the client goes away, after which pushes are dropped.
+    SCOPE_EXIT {
+      queue->disconnected_.store(true, std::memory_order_relaxed);
+    };
+    for (;;) {
+      std::optional<T> item;
+      folly::exception_wrapper error;
+      bool done = false;
+      {
+        auto state = queue->state_.wlock();
+        if (!state->items.empty()) {
+          item.emplace(std::move(state->items.front()));
+          state->items.pop_front();
+        } else if (state->done) {
+          done = true;
+          error = std::move(state->error);
+        } else {
+          // Reset with the lock held, so that a push can't be missed.
+          queue->ready_.reset();
+        }
+      }
+      if (item) {
+        co_yield std::move(*item);
+      } else if (error) {
+        co_yield folly::coro::co_error(std::move(error));
+      } else if (done) {
+        co_return;
+      } else {
+        co_await queue->ready_;
+      }
+    }
+  }
+
+  folly::coro::Baton ready_;
+#endif
+
+  FOLLY_MAYBE_UNUSED const size_t capacity_;
+  std::atomic<bool> disconnected_{false};
+  folly::Synchronized<State> state_;
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/service/ClientRequestLimiter.h"
+
+namespace facebook::eden {
+
+ClientRequestLimiter::Token::~Token() {
+  if (limiter_) {
+    limiter_->release(pid_);
+  }
+}
+
+std::optional<ClientRequestLimiter::Token> ClientRequestLimiter::tryAcquire(
+    pid_t pid,
+    size_t limit) {
+  if (limit == 0) {
+    // Not counted, so the common case of no limit doesn't contend on the lock.
+    return Token{nullptr, pid};
+  }
+  {
+    auto outstanding = outstanding_.wlock();
+    auto& count = (*outstanding)[pid];
+    if (count >= limit) {
+      return std::nullopt;
+    }
+    ++count;
+  }
+  return Token{shared_from_this(), pid};
+}
+
+size_t ClientRequestLimiter::getOutstanding(pid_t pid) const {
+  auto outstanding = outstanding_.rlock();
+  auto it = outstanding->find(pid);
+  return it == outstanding->end() ? 0 : it->second;
+}
+
+void ClientRequestLimiter::release(pid_t pid) {
+  auto outstanding = outstanding_.wlock();
+  auto it = outstanding->find(pid);
+  if (it != outstanding->end() && --it->second == 0) {
+    outstanding->erase(it);
+  }
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <sys/types.h>
+#include <memory>
+#include <optional>
+
+namespace facebook::eden {
+
+/**
+ * Counts the thrift requests each client process has outstanding, so that a
+ * single client issuing many expensive requests at once, like a build
+ * calling getSHA1 for every file, can't keep every thrift worker busy.
+ */
+class ClientRequestLimiter
+    : public std::enable_shared_from_this<ClientRequestLimiter> {
+ public:
+  /** Holds one of the outstanding requests of a client until destroyed. */
+  class Token {
+   public:
+    Token(Token&& other) noexcept = default;
+    Token& operator=(Token&& other) = delete;
+    ~Token();
+
+   private:
+    friend class ClientRequestLimiter;
+    Token(std::shared_ptr<ClientRequestLimiter> limiter, pid_t pid)
+        : limiter_{std::move(limiter)}, pid_{pid} {}
+
+    std::shared_ptr<ClientRequestLimiter> limiter_;
+    pid_t pid_;
+  };
+
+  /**
+   * Count a new request from pid, unless pid already has limit requests
+   * outstanding, in which case nullopt is returned. A limit of 0 means no
+   * limit, and the requests acquired with it aren't counted.
+   */
+  std::optional<Token> tryAcquire(pid_t pid, size_t limit);
+
+  /** The number of requests pid has outstanding. */
+  size_t getOutstanding(pid_t pid) const;
+
+ private:
+  void release(pid_t pid);
+
+  folly::Synchronized<folly::F14FastMap<pid_t, size_t>> outstanding_;
+};
+
+} // namespace facebook::eden
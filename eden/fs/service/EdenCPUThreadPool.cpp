@@ -8,14 +8,58 @@
 #include "eden/fs/service/EdenCPUThreadPool.h"
 
 #include <gflags/gflags.h>
+#include <chrono>
 
 DEFINE_int32(num_eden_threads, 12, "the number of eden CPU worker threads");
+DEFINE_int32(
+    num_eden_bulk_threads,
+    8,
+    "the number of eden worker threads for bulk work such as checkout");
 
 namespace facebook {
 namespace eden {
 
-EdenCPUThreadPool::EdenCPUThreadPool()
-    : UnboundedQueueExecutor(FLAGS_num_eden_threads, "EdenCPUThread") {}
+EdenCPUThreadPool::EdenCPUThreadPool(std::shared_ptr<EdenStats> stats)
+    : EdenCPUThreadPool(
+          FLAGS_num_eden_threads,
+          "EdenCPUThread",
+          std::move(stats),
+          &ExecutorThreadStats::serverQueueWait) {}
+
+EdenCPUThreadPool::EdenCPUThreadPool(
+    size_t threadCount,
+    folly::StringPiece threadNamePrefix,
+    std::shared_ptr<EdenStats> stats,
+    ExecutorThreadStats::StatPtr queueWait)
+    : UnboundedQueueExecutor(threadCount, threadNamePrefix),
+      stats_{std::move(stats)},
+      queueWait_{queueWait} {}
+
+void EdenCPUThreadPool::add(folly::Func func) {
+  if (!stats_) {
+    UnboundedQueueExecutor::add(std::move(func));
+    return;
+  }
+  // The task holds a reference to the stats since the queue is only drained
+  // once the UnboundedQueueExecutor base is destroyed, after stats_.
+  UnboundedQueueExecutor::add([stats = stats_,
+                               queueWait = queueWait_,
+                               queued = std::chrono::steady_clock::now(),
+                               func = std::move(func)]() mutable {
+    (stats->getExecutorStatsForCurrentThread().*queueWait)
+        .addValue(std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::chrono::steady_clock::now() - queued)
+                      .count());
+    func();
+  });
+}
+
+EdenBulkThreadPool::EdenBulkThreadPool(std::shared_ptr<EdenStats> stats)
+    : EdenCPUThreadPool(
+          FLAGS_num_eden_bulk_threads,
+          "EdenBulkThread",
+          std::move(stats),
+          &ExecutorThreadStats::bulkQueueWait) {}
 
 } // namespace eden
 } // namespace facebook
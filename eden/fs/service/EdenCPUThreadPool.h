@@ -7,15 +7,40 @@
 
 #pragma once
 
+#include <memory>
+#include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/utils/UnboundedQueueExecutor.h"
 
 namespace facebook {
 namespace eden {
 
 // The Eden CPU thread pool is intended for miscellaneous background tasks.
+//
+// When given stats, the time each task spends queued is recorded into them.
 class EdenCPUThreadPool : public UnboundedQueueExecutor {
  public:
-  explicit EdenCPUThreadPool();
+  explicit EdenCPUThreadPool(std::shared_ptr<EdenStats> stats = nullptr);
+
+  void add(folly::Func func) override;
+
+ protected:
+  EdenCPUThreadPool(
+      size_t threadCount,
+      folly::StringPiece threadNamePrefix,
+      std::shared_ptr<EdenStats> stats,
+      ExecutorThreadStats::StatPtr queueWait);
+
+ private:
+  std::shared_ptr<EdenStats> stats_;
+  ExecutorThreadStats::StatPtr queueWait_;
+};
+
+// The bulk thread pool runs work touching many inodes at once, like checkout
+// and prefetches, so that it can't delay the latency sensitive tasks queued
+// on the EdenCPUThreadPool.
+class EdenBulkThreadPool : public EdenCPUThreadPool {
+ public:
+  explicit EdenBulkThreadPool(std::shared_ptr<EdenStats> stats = nullptr);
 };
 
 } // namespace eden
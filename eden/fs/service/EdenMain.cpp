@@ -31,6 +31,7 @@
 #include "eden/fs/service/EdenInit.h"
 #include "eden/fs/service/EdenServer.h"
 #include "eden/fs/service/EdenServiceHandler.h" // for kServiceName
+#include "eden/fs/service/FuseTraceActivityRecorder.h"
 #include "eden/fs/service/StartupLogger.h"
 #include "eden/fs/service/Systemd.h"
 #include "eden/fs/telemetry/IHiveLogger.h"
@@ -129,9 +130,16 @@ void DefaultEdenMain::prepare(const EdenServer& /*server*/) {
 }
 
 ActivityRecorderFactory DefaultEdenMain::getActivityRecorderFactory() {
+#ifndef _WIN32
+  return [](std::shared_ptr<EdenMount> edenMount)
+             -> std::unique_ptr<IActivityRecorder> {
+    return std::make_unique<FuseTraceActivityRecorder>(std::move(edenMount));
+  };
+#else
   return [](std::shared_ptr<const EdenMount>) {
     return std::make_unique<NullActivityRecorder>();
   };
+#endif
 }
 
 std::shared_ptr<IHiveLogger> DefaultEdenMain::getHiveLogger(
@@ -11,9 +11,11 @@
 #include <chrono>
 
 #include <sys/stat.h>
+#include <algorithm>
 #include <atomic>
 #include <fstream>
 #include <functional>
+#include <map>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -41,6 +43,7 @@
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/InodeBase.h"
 #include "eden/fs/inodes/InodeMap.h"
+#include "eden/fs/inodes/RequestContext.h"
 #include "eden/fs/inodes/TreeInode.h"
 #include "eden/fs/nfs/NfsServer.h"
 #include "eden/fs/service/EdenCPUThreadPool.h"
@@ -50,27 +53,35 @@
 #include "eden/fs/service/gen-cpp2/eden_types.h"
 #include "eden/fs/store/BackingStoreLogger.h"
 #include "eden/fs/store/BlobCache.h"
+#include "eden/fs/store/CacheWarmState.h"
 #include "eden/fs/store/EmptyBackingStore.h"
 #include "eden/fs/store/LocalStore.h"
 #include "eden/fs/store/LocalStoreCachedBackingStore.h"
 #include "eden/fs/store/MemoryLocalStore.h"
 #include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/store/PackLocalStore.h"
 #include "eden/fs/store/RocksDbLocalStore.h"
+#include "eden/fs/store/SharedLocalStore.h"
 #include "eden/fs/store/SqliteLocalStore.h"
 #include "eden/fs/store/TreeCache.h"
+#include "eden/fs/store/WriteBehindLocalStore.h"
 #include "eden/fs/store/hg/HgBackingStore.h"
 #include "eden/fs/store/hg/HgQueuedBackingStore.h"
+#include "eden/fs/telemetry/ChromeTrace.h"
 #include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/telemetry/IHiveLogger.h"
+#include "eden/fs/telemetry/LockProfiling.h"
 #include "eden/fs/telemetry/RequestMetricsScope.h"
 #include "eden/fs/telemetry/SessionInfo.h"
 #include "eden/fs/telemetry/StructuredLogger.h"
 #include "eden/fs/telemetry/StructuredLoggerFactory.h"
+#include "eden/fs/telemetry/Tracing.h"
 #include "eden/fs/utils/Clock.h"
 #include "eden/fs/utils/EdenError.h"
 #include "eden/fs/utils/EnumValue.h"
 #include "eden/fs/utils/FileUtils.h"
 #include "eden/fs/utils/FsChannelTypes.h"
+#include "eden/fs/utils/Memory.h"
 #include "eden/fs/utils/NfsSocket.h"
 #include "eden/fs/utils/NotImplemented.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -109,7 +120,7 @@ DEFINE_bool(
     "Enable the fault injection framework.");
 
 #define DEFAULT_STORAGE_ENGINE "rocksdb"
-#define SUPPORTED_STORAGE_ENGINES "rocksdb|sqlite|memory"
+#define SUPPORTED_STORAGE_ENGINES "rocksdb|sqlite|pack|memory"
 
 DEFINE_string(
     local_storage_engine_unsafe,
@@ -129,6 +140,17 @@ DEFINE_int32(
     thrift_max_requests,
     apache::thrift::concurrency::ThreadManager::DEFAULT_MAX_QUEUE_SIZE,
     "Maximum number of active thrift requests");
+DEFINE_int32(
+    thrift_num_high_priority_workers,
+    2,
+    "The number of thrift worker threads reserved for requests annotated as "
+    "high priority in eden.thrift, such as getDaemonInfo. If 0, requests of "
+    "every priority share the same worker threads");
+DEFINE_int32(
+    thrift_num_best_effort_workers,
+    1,
+    "The number of thrift worker threads handling best effort requests, "
+    "when thrift_num_high_priority_workers is not 0");
 DEFINE_bool(thrift_enable_codel, false, "Enable Codel queuing timeout");
 DEFINE_int32(thrift_queue_timeout, 5000, "Request queue timeout in ms");
 
@@ -144,6 +166,17 @@ DEFINE_int64(
     unload_age_minutes,
     6 * 60,
     "Minimum age of the inodes to be unloaded in background");
+DEFINE_uint64(
+    unload_loaded_inode_budget,
+    0,
+    "When a mount still has more loaded inodes than this after the background "
+    "unload, keep unloading inodes younger than unload_age_minutes, oldest "
+    "first. 0 disables the budget");
+DEFINE_int64(
+    unload_min_age_minutes,
+    5,
+    "Inodes accessed more recently than this are never unloaded in "
+    "background to meet unload_loaded_inode_budget");
 
 DEFINE_uint64(
     maximumBlobCacheSize,
@@ -153,6 +186,15 @@ DEFINE_uint64(
     minimumBlobCacheEntryCount,
     16,
     "The minimum number of recent blobs to keep cached. Trumps maximumBlobCacheSize");
+DEFINE_uint64(
+    blobCacheShardCount,
+    1,
+    "Number of independently locked shards the blob cache is split into");
+DEFINE_string(
+    blobCacheEvictionPolicy,
+    "lru",
+    "Blob cache eviction policy: 'lru', or 'tinylfu' to only admit new blobs "
+    "that are accessed more often than the ones they would evict");
 
 using apache::thrift::ThriftServer;
 using apache::thrift::ThriftServerAsyncProcessorFactory;
@@ -173,11 +215,18 @@ using namespace facebook::eden;
 
 constexpr StringPiece kRocksDBPath{"storage/rocks-db"};
 constexpr StringPiece kSqlitePath{"storage/sqlite.db"};
+constexpr StringPiece kPackPath{"storage/pack"};
+constexpr StringPiece kSharedSqlitePath{"sqlite.db"};
 constexpr StringPiece kHgStorePrefix{"store.hg"};
 #ifndef _WIN32
 constexpr StringPiece kFuseRequestPrefix{"fuse"};
 #endif
 constexpr StringPiece kStateConfig{"config.toml"};
+constexpr StringPiece kCacheWarmState{"cache-warm-state"};
+constexpr StringPiece kTracesDir{"traces"};
+// Slow requests tend to come in bursts, one dump covers all of them.
+constexpr auto kSlowTraceDumpInterval = 1min;
+constexpr auto kRequestWatchdogInterval = 1s;
 
 std::optional<std::string> getUnixDomainSocketPath(
     const folly::SocketAddress& address) {
@@ -185,6 +234,28 @@ std::optional<std::string> getUnixDomainSocketPath(
                                         : std::nullopt;
 }
 
+/**
+ * Whether the LocalStore recorded in the state config can be opened while the
+ * edenfs process we take over from still has it open. SQLite coordinates
+ * concurrent processes itself, but RocksDB holds an exclusive lock until it
+ * is closed, and pack stores append to their files without any lock.
+ */
+bool canOpenStorageEngineConcurrently(const cpptoml::table& config) {
+  auto engine = config.get_qualified_as<std::string>("local-store.engine");
+  return engine && (*engine == "sqlite" || *engine == "memory");
+}
+
+ObjectCacheEvictionPolicy parseBlobCacheEvictionPolicy(StringPiece policy) {
+  if (policy == "tinylfu") {
+    return ObjectCacheEvictionPolicy::TinyLfu;
+  }
+  if (policy != "lru") {
+    XLOG(WARN) << "Unknown blob cache eviction policy \"" << policy
+               << "\", using lru";
+  }
+  return ObjectCacheEvictionPolicy::Lru;
+}
+
 std::string getCounterNameForImportMetric(
     RequestMetricsScope::RequestStage stage,
     RequestMetricsScope::RequestMetric metric,
@@ -318,6 +389,13 @@ class EdenServer::ThriftServerEventHandler
 };
 
 static constexpr folly::StringPiece kBlobCacheMemory{"blob_cache.memory"};
+#ifndef _WIN32
+static constexpr folly::StringPiece kFuseDispatchQueueDepth{
+    "fuse.dispatch_queue_depth"};
+static constexpr folly::StringPiece kNfsMetadataQueueDepth{
+    "nfs.queue_depth_metadata"};
+static constexpr folly::StringPiece kNfsDataQueueDepth{"nfs.queue_depth_data"};
+#endif
 
 EdenServer::EdenServer(
     std::vector<std::string> originalCommandLine,
@@ -333,7 +411,9 @@ EdenServer::EdenServer(
       activityRecorderFactory_(std::move(activityRecorderFactory)),
       blobCache_{BlobCache::create(
           FLAGS_maximumBlobCacheSize,
-          FLAGS_minimumBlobCacheEntryCount)},
+          FLAGS_minimumBlobCacheEntryCount,
+          FLAGS_blobCacheShardCount,
+          parseBlobCacheEvictionPolicy(FLAGS_blobCacheEvictionPolicy))},
       config_{std::make_shared<ReloadableConfig>(edenConfig)},
       // Store a pointer to the EventBase that will be used to drive
       // the main thread.  The runServer() code will end up driving this
@@ -342,7 +422,8 @@ EdenServer::EdenServer(
       serverState_{make_shared<ServerState>(
           std::move(userInfo),
           std::move(privHelper),
-          std::make_shared<EdenCPUThreadPool>(),
+          std::make_shared<EdenCPUThreadPool>(std::make_shared<EdenStats>()),
+          std::make_shared<EdenBulkThreadPool>(std::make_shared<EdenStats>()),
           std::make_shared<UnixClock>(),
           std::make_shared<ProcessNameCache>(),
           makeDefaultStructuredLogger(*edenConfig, std::move(sessionInfo)),
@@ -354,7 +435,9 @@ EdenServer::EdenServer(
               ? std::make_shared<NfsServer>(
                     mainEventBase_,
                     edenConfig->numNfsThreads.getValue(),
-                    edenConfig->maxNfsInflightRequests.getValue())
+                    edenConfig->maxNfsInflightRequests.getValue(),
+                    edenConfig->numNfsIoThreads.getValue(),
+                    edenConfig->maxNfsInflightRequestsPerMount.getValue())
               :
 #endif
               nullptr,
@@ -368,6 +451,19 @@ EdenServer::EdenServer(
   counters->registerCallback(kBlobCacheMemory, [this] {
     return this->getBlobCache()->getStats().totalSizeInBytes;
   });
+#ifndef _WIN32
+  counters->registerCallback(kFuseDispatchQueueDepth, [] {
+    return FuseChannel::getDispatchQueueDepth();
+  });
+  if (auto nfsServer = serverState_->getNfsServer()) {
+    counters->registerCallback(kNfsMetadataQueueDepth, [nfsServer] {
+      return nfsServer->getMetadataQueueDepth();
+    });
+    counters->registerCallback(kNfsDataQueueDepth, [nfsServer] {
+      return nfsServer->getDataQueueDepth();
+    });
+  }
+#endif
 
   for (auto stage : RequestMetricsScope::requestStages) {
     for (auto metric : RequestMetricsScope::requestMetrics) {
@@ -405,6 +501,11 @@ EdenServer::EdenServer(
 EdenServer::~EdenServer() {
   auto counters = fb303::ServiceData::get()->getDynamicCounters();
   counters->unregisterCallback(kBlobCacheMemory);
+#ifndef _WIN32
+  counters->unregisterCallback(kFuseDispatchQueueDepth);
+  counters->unregisterCallback(kNfsMetadataQueueDepth);
+  counters->unregisterCallback(kNfsDataQueueDepth);
+#endif
 
   for (auto stage : RequestMetricsScope::requestStages) {
     for (auto metric : RequestMetricsScope::requestMetrics) {
@@ -416,6 +517,9 @@ EdenServer::~EdenServer() {
       counters->unregisterCallback(summaryCounterName);
     }
   }
+
+  // The handler refers to the thread pool, which is about to go away.
+  setSlowTraceSpanHandler(std::chrono::nanoseconds::zero(), nullptr);
 }
 
 namespace cursor_helper {
@@ -657,6 +761,61 @@ void EdenServer::startPeriodicTasks() {
   backingStoreTask_.updateInterval(1min);
 }
 
+void EdenServer::startContinuousTracing() {
+  auto config = serverState_->getReloadableConfig()->getEdenConfig();
+  auto denominator = config->traceSampleDenominator.getValue();
+  if (denominator == 0) {
+    return;
+  }
+  setTraceSampling(denominator);
+  enableTracing();
+
+  auto threshold = config->slowTraceThreshold.getValue();
+  if (threshold.count() == 0) {
+    return;
+  }
+  auto tracesDir = edenDir_.getPath() + RelativePathPiece{kTracesDir};
+  auto nextDump =
+      std::make_shared<std::atomic<std::chrono::steady_clock::rep>>(0);
+  // Called on the thread that served the request, so only claim the dump
+  // here and render it on the thread pool.
+  setSlowTraceSpanHandler(
+      threshold,
+      [tracesDir = std::move(tracesDir),
+       nextDump = std::move(nextDump),
+       threadPool = serverState_->getThreadPool()](const TraceSpan& span) {
+        using Clock = std::chrono::steady_clock;
+        auto now = Clock::now().time_since_epoch().count();
+        auto interval =
+            std::chrono::duration_cast<Clock::duration>(kSlowTraceDumpInterval)
+                .count();
+        auto next = nextDump->load(std::memory_order_relaxed);
+        if (now < next ||
+            !nextDump->compare_exchange_strong(next, now + interval)) {
+          return;
+        }
+        XLOG(WARN) << "Slow " << span.category << " " << span.name
+                   << " request took "
+                   << std::chrono::duration_cast<std::chrono::milliseconds>(
+                          span.duration)
+                          .count()
+                   << "ms, dumping recent traces to " << tracesDir;
+        threadPool->add([tracesDir] {
+          ensureDirectoryExists(tracesDir);
+          auto path = tracesDir +
+              PathComponent{folly::to<std::string>(
+                  "slow-", ::time(nullptr), ".json")};
+          auto trace =
+              renderChromeTrace(getRecentTracepoints(), getRecentTraceSpans());
+          auto result = writeFileAtomic(path, folly::StringPiece{trace});
+          if (result.hasException()) {
+            XLOG(ERR) << "Failed to write trace to " << path << ": "
+                      << result.exception().what();
+          }
+        });
+      });
+}
+
 void EdenServer::updatePeriodicTaskIntervals(const EdenConfig& config) {
   // Update all periodic tasks whose interval is
   // controlled by EdenConfig settings.
@@ -676,6 +835,15 @@ void EdenServer::updatePeriodicTaskIntervals(const EdenConfig& config) {
   localStoreTask_.updateInterval(
       std::chrono::duration_cast<std::chrono::milliseconds>(
           config.localStoreManagementInterval.getValue()));
+
+  memoryGovernorTask_.updateInterval(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          config.memoryGovernorInterval.getValue()));
+
+  requestWatchdogTask_.updateInterval(
+      config.requestWatchdogThreshold.getValue().count()
+          ? std::chrono::milliseconds{kRequestWatchdogInterval}
+          : std::chrono::milliseconds::zero());
 }
 
 void EdenServer::scheduleCallbackOnMainEventBase(
@@ -743,11 +911,35 @@ void EdenServer::unloadInodes() {
   }
 
   if (!roots.empty()) {
-    auto cutoff = std::chrono::system_clock::now() -
-        std::chrono::minutes(FLAGS_unload_age_minutes);
-    auto cutoff_ts = folly::to<timespec>(cutoff);
+    auto now = std::chrono::system_clock::now();
+    auto unloadOlderThan = [&now](TreeInode& root, std::chrono::minutes age) {
+      return root.unloadChildrenLastAccessedBefore(
+          folly::to<timespec>(now - age));
+    };
+    auto minAge = std::chrono::minutes(FLAGS_unload_min_age_minutes);
+
     for (auto& [name, rootInode, mount] : roots) {
-      auto unloaded = rootInode->unloadChildrenLastAccessedBefore(cutoff_ts);
+      auto age = std::chrono::minutes(FLAGS_unload_age_minutes);
+      auto unloaded = unloadOlderThan(*rootInode, age);
+
+      // If the mount is still over its budget, lower the age cutoff step by
+      // step, so that the least recently used inodes are the ones unloaded.
+      // Each step walks the loaded inodes one directory at a time, without
+      // holding the rename lock or more than one contents lock.
+      auto overBudget = [&mount = mount] {
+        auto counts = mount->getInodeMap()->getInodeCounts();
+        return counts.fileCount + counts.treeCount >
+            FLAGS_unload_loaded_inode_budget;
+      };
+      while (FLAGS_unload_loaded_inode_budget > 0 && age > minAge &&
+             overBudget()) {
+        age = std::max(age / 2, minAge);
+        XLOG(DBG2) << "Mount " << name << " is over its loaded inode budget, "
+                   << "unloading inodes unused for " << age.count()
+                   << " minutes";
+        unloaded += unloadOlderThan(*rootInode, age);
+      }
+
       if (unloaded) {
         XLOG(INFO) << "Unloaded " << unloaded
                    << " inodes in background from mount " << name;
@@ -842,6 +1034,30 @@ Future<Unit> EdenServer::prepareImpl(std::shared_ptr<StartupLogger> logger) {
 #endif
 
   startPeriodicTasks();
+  startContinuousTracing();
+  RequestContext::setSlowRequestThreshold(
+      serverState_->getReloadableConfig()
+          ->getEdenConfig()
+          ->slowRequestLogThreshold.getValue());
+  if (serverState_->getReloadableConfig()
+          ->getEdenConfig()
+          ->lockProfiling.getValue()) {
+    enableLockProfiling(getSharedStats());
+  }
+
+  // TODO: The "state config" only has one configuration knob now. When
+  // another is required, introduce an EdenStateConfig class to manage
+  // defaults and save on update.
+  auto config = parseConfig();
+  bool shouldSaveConfig = false;
+  bool storageEngineOpened = false;
+  if (doingTakeover && canOpenStorageEngineConcurrently(*config)) {
+    // The mounts are frozen from the moment the old process hands them over
+    // until we remount them, so do the slow work that doesn't need the old
+    // process to be gone first.
+    shouldSaveConfig = openStorageEngine(*config, *logger);
+    storageEngineOpened = true;
+  }
 
 #ifndef _WIN32
   // If we are gracefully taking over from an existing edenfs process,
@@ -890,14 +1106,13 @@ Future<Unit> EdenServer::prepareImpl(std::shared_ptr<StartupLogger> logger) {
   }
 #endif
 
-  // TODO: The "state config" only has one configuration knob now. When
-  // another is required, introduce an EdenStateConfig class to manage
-  // defaults and save on update.
-  auto config = parseConfig();
-  bool shouldSaveConfig = openStorageEngine(*config, *logger);
+  if (!storageEngineOpened) {
+    shouldSaveConfig = openStorageEngine(*config, *logger);
+  }
   if (shouldSaveConfig) {
     saveConfig(*config);
   }
+  restoreCacheWarmState();
 
 #ifndef _WIN32
   // Start listening for graceful takeover requests
@@ -921,6 +1136,16 @@ Future<Unit> EdenServer::prepareImpl(std::shared_ptr<StartupLogger> logger) {
     mountFutures = prepareMounts(logger);
   }
 
+  if (!doingTakeover &&
+      serverState_->getEdenConfig()->backgroundRemount.getValue()) {
+    // Report startup as soon as the thrift server is running. The remounts
+    // keep going in the background and log their own failures.
+    (void)folly::collectAllUnsafe(mountFutures).thenValue([](auto&&) {
+      XLOG(INFO) << "finished remounting checkouts in the background";
+    });
+    return thriftRunningFuture;
+  }
+
   // Return a future that will complete only when all mount points have
   // started and the thrift server is also running.
   mountFutures.emplace_back(std::move(thriftRunningFuture));
@@ -983,6 +1208,17 @@ bool EdenServer::openStorageEngine(
         "Opened SQLite store in ",
         watch.elapsed().count() / 1000.0,
         " seconds.");
+#ifndef _WIN32
+  } else if (storageEngine == "pack") {
+    const auto path = edenDir_.getPath() + RelativePathPiece{kPackPath};
+    logger.log("Opening local pack store ", path, "...");
+    folly::stop_watch<std::chrono::milliseconds> watch;
+    localStore_ = make_shared<PackLocalStore>(path);
+    logger.log(
+        "Opened pack store in ",
+        watch.elapsed().count() / 1000.0,
+        " seconds.");
+#endif
   } else if (storageEngine == "rocksdb") {
     logger.log("Opening local RocksDB store...");
     folly::stop_watch<std::chrono::milliseconds> watch;
@@ -991,7 +1227,9 @@ bool EdenServer::openStorageEngine(
     localStore_ = make_shared<RocksDbLocalStore>(
         rocksPath,
         serverState_->getStructuredLogger(),
-        &serverState_->getFaultInjector());
+        &serverState_->getFaultInjector(),
+        RocksDBOpenMode::ReadWrite,
+        serverState_->getEdenConfig()->localStoreIoThreads.getValue());
     localStore_->enableBlobCaching.store(
         serverState_->getEdenConfig()->enableBlobCaching.getValue(),
         std::memory_order_relaxed);
@@ -1004,6 +1242,36 @@ bool EdenServer::openStorageEngine(
         folly::to<string>("invalid storage engine: ", storageEngine));
   }
 
+  auto sharedPath =
+      serverState_->getEdenConfig()->localStoreSharedPath.getValue();
+  if (storageEngine != "memory" && !sharedPath.empty()) {
+    const auto path =
+        canonicalPath(sharedPath) + RelativePathPiece{kSharedSqlitePath};
+    ensureDirectoryExists(path.dirname());
+    bool canShare = true;
+    try {
+      SharedLocalStore::checkSharedDirectory(path.dirname());
+    } catch (const std::exception& ex) {
+      logger.warn("Not sharing the local store: ", ex.what());
+      canShare = false;
+    }
+    if (canShare) {
+      logger.log("Opening shared SQLite store ", path, "...");
+      localStore_ = make_shared<SharedLocalStore>(
+          std::move(localStore_), make_shared<SqliteLocalStore>(path));
+    }
+  }
+
+  auto writeBehindBufferSize =
+      serverState_->getEdenConfig()->localStoreWriteBehindBufferSize.getValue();
+  if (storageEngine != "memory" && writeBehindBufferSize > 0) {
+    localStore_ = make_shared<WriteBehindLocalStore>(
+        std::move(localStore_), writeBehindBufferSize);
+  }
+  localStore_->enableBlobChunking.store(
+      serverState_->getEdenConfig()->enableBlobChunking.getValue(),
+      std::memory_order_relaxed);
+
   return configUpdated;
 }
 
@@ -1073,18 +1341,33 @@ std::vector<Future<Unit>> EdenServer::prepareMounts(
   }
   logger->log("Remounting ", dirs.size(), " mount points...");
 
+  // Pairs of mount path and client name, in the order they are remounted.
+  std::vector<std::pair<std::string, std::string>> checkouts;
   for (const auto& client : dirs.items()) {
-    auto mountFuture = makeFutureWith([&] {
+    checkouts.emplace_back(client.first.asString(), client.second.asString());
+  }
+  auto edenConfig = serverState_->getEdenConfig();
+  auto priority = edenConfig->startupMountPriority.getValue();
+  auto rank = [&](const std::string& mountPath) {
+    return std::find(priority.begin(), priority.end(), mountPath) -
+        priority.begin();
+  };
+  std::stable_sort(
+      checkouts.begin(), checkouts.end(), [&](const auto& a, const auto& b) {
+        return rank(a.first) < rank(b.first);
+      });
+
+  auto remount = [this, logger](std::pair<std::string, std::string> client) {
+    return makeFutureWith([&] {
       MountInfo mountInfo;
-      *mountInfo.mountPoint_ref() = client.first.c_str();
-      auto edenClientPath =
-          edenDir_.getCheckoutStateDir(client.second.asString());
+      *mountInfo.mountPoint_ref() = client.first;
+      auto edenClientPath = edenDir_.getCheckoutStateDir(client.second);
       *mountInfo.edenClientPath_ref() = edenClientPath.stringPiece().str();
       auto initialConfig = CheckoutConfig::loadFromClientDirectory(
           AbsolutePathPiece{*mountInfo.mountPoint_ref()},
           AbsolutePathPiece{*mountInfo.edenClientPath_ref()});
       auto progressIndex = progressManager_->wlock()->registerEntry(
-          client.first.asString(), initialConfig->getOverlayPath().c_str());
+          client.first, initialConfig->getOverlayPath().c_str());
 
       return mount(
                  std::move(initialConfig),
@@ -1096,7 +1379,7 @@ std::vector<Future<Unit>> EdenServer::prepareMounts(
           .thenTry(
               [this,
                logger,
-               mountPath = client.first.asString(),
+               mountPath = client.first,
                progressIndex](folly::Try<std::shared_ptr<EdenMount>>&& result) {
                 if (result.hasValue()) {
                   auto wl = progressManager_->wlock();
@@ -1114,10 +1397,20 @@ std::vector<Future<Unit>> EdenServer::prepareMounts(
                 }
               });
     });
+  };
 
-    mountFutures.push_back(std::move(mountFuture));
+  // Each remount starts as soon as one of the previous ones completes. It is
+  // started on the thread pool, rather than inline on the thread that
+  // completed the previous one.
+  auto concurrency = edenConfig->startupMountConcurrency.getValue();
+  if (concurrency == 0) {
+    concurrency = checkouts.size();
   }
-  return mountFutures;
+  return folly::window(
+      folly::getKeepAliveToken(serverState_->getThreadPool().get()),
+      std::move(checkouts),
+      std::move(remount),
+      concurrency);
 }
 
 void EdenServer::incrementStartupMountFailures() {
@@ -1126,6 +1419,51 @@ void EdenServer::incrementStartupMountFailures() {
   fb303::fbData->incrementCounter("startup_mount_failures");
 }
 
+void EdenServer::saveCacheWarmState() {
+  auto maxEntries = serverState_->getEdenConfig()->warmCacheEntries.getValue();
+  if (maxEntries == 0) {
+    return;
+  }
+  auto path = edenDir_.getPath() + RelativePathPiece{kCacheWarmState};
+  auto state = CacheWarmState::capture(*blobCache_, *treeCache_, maxEntries);
+  auto result = state.save(path);
+  if (result.hasException()) {
+    XLOG(WARN) << "failed to save the cache warm state to " << path << ": "
+               << result.exception().what();
+    return;
+  }
+  XLOG(DBG2) << "saved " << state.blobs.size() << " blob and "
+             << state.trees.size() << " tree cache keys to " << path;
+}
+
+void EdenServer::restoreCacheWarmState() {
+  if (serverState_->getEdenConfig()->warmCacheEntries.getValue() == 0) {
+    return;
+  }
+  auto state = CacheWarmState::load(
+      edenDir_.getPath() + RelativePathPiece{kCacheWarmState});
+  if (!state) {
+    return;
+  }
+  // Only reads from the LocalStore, so this never competes with imports for
+  // the BackingStore; it just runs in the background next to the mounts
+  // starting up.
+  serverState_->getThreadPool()->add([localStore = localStore_,
+                                      blobCache = blobCache_,
+                                      treeCache = treeCache_,
+                                      state = std::move(*state)] {
+    folly::stop_watch<std::chrono::milliseconds> watch;
+    try {
+      auto loaded = state.restore(*localStore, *blobCache, *treeCache);
+      XLOG(INFO) << "warmed the in-memory caches with " << loaded
+                 << " objects in " << watch.elapsed().count() << "ms";
+    } catch (const std::exception& ex) {
+      XLOG(WARN) << "failed to warm the in-memory caches: "
+                 << folly::exceptionStr(ex);
+    }
+  });
+}
+
 void EdenServer::closeStorage() {
   // Destroy the local store and backing stores.
   // We shouldn't access the local store any more after giving up our
@@ -1199,6 +1537,10 @@ bool EdenServer::performCleanup() {
   }
 #endif
 
+  if (!takeover) {
+    // Takeovers already saved it before handing over the lock.
+    saveCacheWarmState();
+  }
   closeStorage();
   // Stop the privhelper process.
   shutdownPrivhelper();
@@ -1430,6 +1772,13 @@ folly::Future<std::shared_ptr<EdenMount>> EdenServer::mount(
       serverState_->getStructuredLogger(),
       serverState_->getReloadableConfig()->getEdenConfig());
   auto journal = std::make_unique<Journal>(getSharedStats());
+  auto edenConfig = serverState_->getEdenConfig();
+  auto journalLogMaxSize = edenConfig->journalLogMaxSize.getValue();
+  if (journalLogMaxSize > 0) {
+    journal->openLog(initialConfig->getClientDirectory(), journalLogMaxSize);
+  }
+  journal->setNotificationInterval(
+      edenConfig->journalNotificationInterval.getValue());
 
   // Create the EdenMount object and insert the mount into the mountPoints_ map.
   auto edenMount = EdenMount::create(
@@ -1871,6 +2220,25 @@ Future<Unit> EdenServer::createThriftServer() {
       std::chrono::milliseconds{FLAGS_thrift_queue_timeout});
   server_->setAllowCheckUnimplementedExtraInterfaces(false);
 
+  if (FLAGS_thrift_num_high_priority_workers > 0) {
+    // Give each priority its own worker threads, so that a flood of
+    // expensive requests can't delay the cheap ones.
+    using apache::thrift::concurrency::PriorityThreadManager;
+    auto highWorkers =
+        folly::to<size_t>(FLAGS_thrift_num_high_priority_workers);
+    auto threadManager = PriorityThreadManager::newPriorityThreadManager({{
+        highWorkers, // HIGH_IMPORTANT
+        highWorkers, // HIGH
+        highWorkers, // IMPORTANT
+        folly::to<size_t>(std::max(FLAGS_thrift_num_workers, 1)), // NORMAL
+        folly::to<size_t>(
+            std::max(FLAGS_thrift_num_best_effort_workers, 1)), // BEST_EFFORT
+    }});
+    threadManager->setNamePrefix("Thrift");
+    threadManager->start();
+    server_->setThreadManager(std::move(threadManager));
+  }
+
   // Setting this allows us to to only do stopListening() on the stop() call
   // and delay thread-pool join (stop cpu workers + stop workers) untill
   // server object destruction. This specifically matters in the takeover
@@ -2019,6 +2387,10 @@ folly::Future<TakeoverData> EdenServer::startTakeoverShutdown() {
                     << ". Continuing takeover server shutdown anyway.";
         }
 
+        // Must happen before the new process gets our lock, since it reads
+        // the file during its startup.
+        saveCacheWarmState();
+
         shutdownSubscribers();
 
         // Stop the thrift server. In the future, we'd like to
@@ -2111,7 +2483,177 @@ void EdenServer::reportMemoryStats() {
 void EdenServer::manageLocalStore() {
   auto config = serverState_->getReloadableConfig()->getEdenConfig(
       ConfigReloadBehavior::NoReload);
+  localStore_->enableBlobChunking.store(
+      config->enableBlobChunking.getValue(), std::memory_order_relaxed);
   localStore_->periodicManagementTask(*config);
+  compactLocalStoreWhileIdle(*config);
+}
+
+void EdenServer::compactLocalStoreWhileIdle(const EdenConfig& config) {
+  // The count of every FUSE, NFS and ProjectedFS latency stat over the last
+  // minute is the number of requests served during that minute.
+  std::map<std::string, int64_t> counters;
+  fb303::ServiceData::get()->getRegexCounters(
+      counters, "^(fuse|nfs|prjfs)\\..*_us\\.count\\.60$");
+  int64_t recentRequests = 0;
+  for (const auto& counter : counters) {
+    recentRequests += counter.second;
+  }
+  auto maxRequests = config.localStoreIdleCompactionMaxRequests.getValue();
+  auto isIdle = recentRequests <= static_cast<int64_t>(maxRequests);
+
+  auto state = idleCompaction_.wlock();
+  if (state->job) {
+    if (!state->job->isDone()) {
+      if (!isIdle) {
+        XLOG(INFO) << "cancelling idle local store compaction: "
+                   << recentRequests << " filesystem requests in the last "
+                   << "minute";
+        state->job->cancel();
+      }
+      return;
+    }
+    if (!state->job->isCancelled()) {
+      state->lastCompleted = std::chrono::steady_clock::now();
+    }
+    state->job.reset();
+  }
+
+  auto interval = config.localStoreIdleCompactionInterval.getValue();
+  if (interval.count() == 0 || !isIdle ||
+      std::chrono::steady_clock::now() - state->lastCompleted < interval) {
+    return;
+  }
+  XLOG(INFO) << "filesystem is idle, compacting the local store";
+  try {
+    state->job = localStore_->startCompaction(/*clearCaches=*/false);
+  } catch (const std::exception& ex) {
+    XLOG(ERR) << "error starting idle local store compaction: "
+              << folly::exceptionStr(ex);
+  }
+}
+
+void EdenServer::manageMemoryPressure() {
+  auto config = serverState_->getReloadableConfig()->getEdenConfig(
+      ConfigReloadBehavior::NoReload);
+  MemoryGovernor::Thresholds thresholds{
+      config->memoryPressureHighStallPercent.getValue(),
+      config->memoryPressureLowStallPercent.getValue(),
+      config->memoryPressureHighCgroupUsage.getValue(),
+      config->memoryPressureLowCgroupUsage.getValue(),
+      config->memoryGovernorMinimumScale.getValue(),
+  };
+  auto pressure = readMemoryPressure();
+
+  MemoryGovernor::Decision decision;
+  double scale;
+  {
+    auto governor = memoryGovernor_.wlock();
+    decision = governor->update(pressure, thresholds);
+    scale = governor->getScale();
+  }
+  if (decision == MemoryGovernor::Decision::Keep && scale == 1.0) {
+    return;
+  }
+  if (decision != MemoryGovernor::Decision::Keep) {
+    XLOG(INFO) << (decision == MemoryGovernor::Decision::Shrink ? "shrinking"
+                                                                : "growing")
+               << " in-memory caches to " << scale * 100
+               << "% of their configured size";
+  }
+
+  // Also apply an unchanged scale below 1, so that mounts added since the
+  // last shrink get their journals limited too.
+  blobCache_->setMaximumSize(static_cast<size_t>(
+      static_cast<double>(FLAGS_maximumBlobCacheSize) * scale));
+  treeCache_->setMaximumSize(static_cast<size_t>(
+      static_cast<double>(config->inMemoryTreeCacheSize.getValue()) * scale));
+  for (const auto& mount : getMountPoints()) {
+    mount->getJournal().setMemoryLimitScale(scale);
+  }
+}
+
+void EdenServer::checkOutstandingRequests() {
+  using Clock = std::chrono::steady_clock;
+  auto config = serverState_->getReloadableConfig()->getEdenConfig(
+      ConfigReloadBehavior::NoReload);
+  auto threshold = std::chrono::duration_cast<Clock::duration>(
+      config->requestWatchdogThreshold.getValue());
+  auto now = Clock::now();
+  // Each request is reported once: when it crosses the threshold between two
+  // checks.
+  auto lastCheck = std::exchange(lastRequestWatchdogCheck_, now);
+  if (threshold.count() == 0) {
+    return;
+  }
+
+  for (const auto& mount : getMountPoints()) {
+    SlowRequest event;
+    Clock::duration oldest{0};
+    FOLLY_MAYBE_UNUSED auto check = [&](Clock::time_point start,
+                                        folly::StringPiece channel,
+                                        folly::StringPiece request) {
+      ++event.outstanding_requests;
+      auto age = now - start;
+      if (age < threshold || lastCheck - start >= threshold) {
+        return;
+      }
+      ++event.slow_requests;
+      if (age > oldest) {
+        oldest = age;
+        event.channel = channel.str();
+        event.request = request.str();
+      }
+    };
+#ifndef _WIN32
+    if (auto* fuseChannel = mount->getFuseChannel()) {
+      for (const auto& call : fuseChannel->getOutstandingRequests()) {
+        check(
+            call.requestStartTime,
+            "fuse",
+            fuseOpcodeName(call.request.opcode));
+      }
+    }
+    if (auto* nfsdChannel = mount->getNfsdChannel()) {
+      for (const auto& call : nfsdChannel->getOutstandingRequests()) {
+        check(call.requestStartTime, "nfs", nfsProcName(call.procNumber));
+      }
+    }
+#endif // !_WIN32
+    if (event.slow_requests == 0) {
+      continue;
+    }
+
+    event.mount = mount->getPath().stringPiece().str();
+    event.age = std::chrono::duration<double>(oldest).count();
+
+    std::map<std::string, int64_t> counters;
+    fb303::ServiceData::get()->getRegexCounters(
+        counters, "^store\\.hg\\.(pending|live)_import\\.count$");
+    event.pending_imports = counters[getCounterNameForImportMetric(
+        RequestMetricsScope::RequestStage::PENDING,
+        RequestMetricsScope::RequestMetric::COUNT)];
+    event.live_imports = counters[getCounterNameForImportMetric(
+        RequestMetricsScope::RequestStage::LIVE,
+        RequestMetricsScope::RequestMetric::COUNT)];
+    auto blobCacheStats = blobCache_->getStats();
+    event.blob_cache_bytes = blobCacheStats.totalSizeInBytes;
+    event.blob_cache_hit_rate = blobCacheStats.getHitRate();
+    auto treeCacheStats = treeCache_->getStats();
+    event.tree_cache_bytes = treeCacheStats.totalSizeInBytes;
+    event.tree_cache_hit_rate = treeCacheStats.getHitRate();
+
+    XLOG(WARN) << event.slow_requests << " request(s) on " << event.mount
+               << " outstanding for more than "
+               << std::chrono::duration_cast<std::chrono::milliseconds>(
+                      threshold)
+                      .count()
+               << "ms, the oldest is " << event.channel << " "
+               << event.request << " (" << event.age << "s); "
+               << event.pending_imports << " pending and "
+               << event.live_imports << " live imports";
+    serverState_->getStructuredLogger()->logEvent(event);
+  }
 }
 
 void EdenServer::refreshBackingStore() {
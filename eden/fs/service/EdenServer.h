@@ -30,6 +30,7 @@
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/ServerState.h"
 #include "eden/fs/service/EdenStateDir.h"
+#include "eden/fs/service/MemoryGovernor.h"
 #include "eden/fs/service/PeriodicTask.h"
 #include "eden/fs/service/StartupLogger.h"
 #include "eden/fs/takeover/TakeoverData.h"
@@ -64,6 +65,7 @@ class BackingStore;
 class HgQueuedBackingStore;
 class IHiveLogger;
 class BlobCache;
+class CompactionJob;
 class TreeCache;
 class Dirstate;
 class EdenServiceHandler;
@@ -141,7 +143,8 @@ class EdenServer : private TakeoverHandler {
    *
    * The returned future will complete until the EdenServer is running
    * successfully and accepting thrift connections and when all mount points
-   * have been remountd.
+   * have been remountd. With core:background-remount, it doesn't wait for
+   * the mount points, except those taken over in a graceful restart.
    *
    * If an error occurs remounting some mount points the Future will complete
    * with an exception, but the server will still continue to run.  Everything
@@ -297,6 +300,14 @@ class EdenServer : private TakeoverHandler {
     return treeCache_;
   }
 
+  /**
+   * Returns the latest memory pressure reading and how the caches were
+   * resized in response.
+   */
+  MemoryGovernor::Stats getMemoryGovernorStats() const {
+    return memoryGovernor_.rlock()->getStats();
+  }
+
   /**
    * Look up the BackingStore object for the specified repository type+name.
    *
@@ -451,6 +462,12 @@ class EdenServer : private TakeoverHandler {
   EdenServer& operator=(EdenServer const&) = delete;
 
   void startPeriodicTasks();
+  /**
+   * Keep a rolling window of traces if telemetry:trace-sample-denominator is
+   * set, and dump it when a request is slower than
+   * telemetry:slow-trace-threshold.
+   */
+  void startContinuousTracing();
   void updatePeriodicTaskIntervals(const EdenConfig& config);
 
   /**
@@ -508,6 +525,19 @@ class EdenServer : private TakeoverHandler {
    */
   bool openStorageEngine(cpptoml::table& config, StartupLogger& logger);
 
+  /**
+   * Save the hot keys of the blob and tree caches to the state directory, for
+   * restoreCacheWarmState() to reload them in the next EdenFS process.
+   */
+  void saveCacheWarmState();
+
+  /**
+   * Start loading the objects saved by saveCacheWarmState() from the
+   * LocalStore into the caches, in the background. Must be called after the
+   * LocalStore is opened.
+   */
+  void restoreCacheWarmState();
+
   // Called when a mount has been unmounted and has stopped.
   void mountFinished(
       EdenMount* mountPoint,
@@ -558,6 +588,19 @@ class EdenServer : private TakeoverHandler {
   // necessary
   void manageLocalStore();
 
+  // Compact the local store in the background while the filesystem is idle,
+  // at most once per store:idle-compaction-interval, and cancel the
+  // compaction once filesystem requests pick up again.
+  void compactLocalStoreWhileIdle(const EdenConfig& config);
+
+  // Check the memory pressure and shrink or grow the blob cache, tree cache
+  // and journals together in response.
+  void manageMemoryPressure();
+
+  // Report the FUSE and NFS requests that have been outstanding for longer
+  // than telemetry:request-watchdog-threshold since the previous check.
+  void checkOutstandingRequests();
+
   // some backing store may require periodic maintenance, specifically rust
   // datapack store needs to release file descriptor it holds every once in a
   // while.
@@ -597,6 +640,18 @@ class EdenServer : private TakeoverHandler {
   const std::shared_ptr<BlobCache> blobCache_;
   std::shared_ptr<TreeCache> treeCache_;
   std::shared_ptr<ReloadableConfig> config_;
+  folly::Synchronized<MemoryGovernor> memoryGovernor_;
+
+  struct IdleCompactionState {
+    std::shared_ptr<CompactionJob> job;
+    // Initialized to the startup time, so a restart doesn't compact again.
+    std::chrono::steady_clock::time_point lastCompleted{
+        std::chrono::steady_clock::now()};
+  };
+  folly::Synchronized<IdleCompactionState> idleCompaction_;
+
+  // Only accessed by checkOutstandingRequests(), on the main event base.
+  std::chrono::steady_clock::time_point lastRequestWatchdogCheck_;
 
   folly::Synchronized<MountMap> mountPoints_{kPathMapDefaultCaseSensitive};
 
@@ -721,10 +776,16 @@ class EdenServer : private TakeoverHandler {
   PeriodicFnTask<&EdenServer::manageLocalStore> localStoreTask_{
       this,
       "local_store"};
+  PeriodicFnTask<&EdenServer::manageMemoryPressure> memoryGovernorTask_{
+      this,
+      "memory_governor"};
 
   PeriodicFnTask<&EdenServer::refreshBackingStore> backingStoreTask_{
       this,
       "backing_store"};
+  PeriodicFnTask<&EdenServer::checkOutstandingRequests> requestWatchdogTask_{
+      this,
+      "request_watchdog"};
 };
 } // namespace eden
 } // namespace facebook
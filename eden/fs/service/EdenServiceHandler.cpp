@@ -9,8 +9,10 @@
 
 #include <sys/types.h>
 #include <algorithm>
+#include <mutex>
 #include <optional>
 #include <typeinfo>
+#include <unordered_set>
 #include "eden/fs/utils/ProcessNameCache.h"
 
 #include <fb303/ServiceData.h>
@@ -56,7 +58,9 @@
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/model/TreeEntry.h"
+#include "eden/fs/service/BoundedStreamQueue.h"
 #include "eden/fs/service/EdenServer.h"
+#include "eden/fs/service/HostSelfTest.h"
 #include "eden/fs/service/ThriftPermissionChecker.h"
 #include "eden/fs/service/ThriftUtil.h"
 #include "eden/fs/service/gen-cpp2/eden_constants.h"
@@ -70,6 +74,7 @@
 #include "eden/fs/store/ObjectStore.h"
 #include "eden/fs/store/PathLoader.h"
 #include "eden/fs/store/hg/HgQueuedBackingStore.h"
+#include "eden/fs/telemetry/ChromeTrace.h"
 #include "eden/fs/telemetry/SessionInfo.h"
 #include "eden/fs/telemetry/Tracing.h"
 #include "eden/fs/utils/Bug.h"
@@ -144,6 +149,23 @@ std::string toLogArg(const std::vector<std::string>& args) {
         " more]");
   }
 }
+
+/**
+ * Number of results sent in each element of a streaming glob, status or
+ * journal query when the client doesn't pick one.
+ */
+constexpr size_t kDefaultStreamChunkSize = 1000;
+
+/**
+ * Number of elements of a stream produced as results are found that may wait
+ * for the client to read them before it is disconnected.
+ */
+constexpr size_t kMaxQueuedStreamChunks = 100;
+
+size_t getStreamChunkSize(int64_t requested) {
+  return requested > 0 ? static_cast<size_t>(requested)
+                       : kDefaultStreamChunkSize;
+}
 } // namespace
 
 #define TLOG(logger, level, file, line)     \
@@ -236,14 +258,16 @@ class ThriftLogHelper {
       folly::StringPiece itcFunctionName,
       folly::StringPiece itcFileName,
       uint32_t itcLineNumber,
-      std::optional<pid_t> pid)
+      std::optional<pid_t> pid,
+      std::optional<ClientRequestLimiter::Token> clientRequest = std::nullopt)
       : itcFunctionName_(itcFunctionName),
         itcFileName_(itcFileName),
         itcLineNumber_(itcLineNumber),
         level_(level),
         itcLogger_(logger),
         fetchContext_{pid, itcFunctionName},
-        prefetchFetchContext_{pid, itcFunctionName} {}
+        prefetchFetchContext_{pid, itcFunctionName},
+        clientRequest_{std::move(clientRequest)} {}
 
   ~ThriftLogHelper() {
     // Logging completion time for the request
@@ -276,6 +300,8 @@ class ThriftLogHelper {
   folly::stop_watch<std::chrono::microseconds> itcTimer_ = {};
   ThriftFetchContext fetchContext_;
   PrefetchFetchContext prefetchFetchContext_;
+  /** Counts this request against the client's outstanding requests. */
+  std::optional<ClientRequestLimiter::Token> clientRequest_;
 };
 
 template <typename ReturnType>
@@ -319,6 +345,10 @@ facebook::eden::InodePtr inodeFromUserPath(
 
 // When not attached to Future it will log the completion of the operation and
 // time taken to complete it.
+//
+// The request counts against thrift:max-requests-per-client until the
+// ThriftLogHelper is destroyed, and fails with an EdenError if the client
+// already has too many requests outstanding.
 #define INSTRUMENT_THRIFT_CALL(level, ...)                            \
   ([&](folly::StringPiece functionName,                               \
        folly::StringPiece fileName,                                   \
@@ -326,13 +356,16 @@ facebook::eden::InodePtr inodeFromUserPath(
     static folly::Logger logger("eden.thrift." + functionName.str()); \
     TLOG(logger, folly::LogLevel::level, fileName, lineNumber)        \
         << functionName << "(" << toDelimWrapper(__VA_ARGS__) << ")"; \
+    auto pid = getAndRegisterClientPid();                             \
+    auto clientRequest = acquireClientRequest(pid, functionName);     \
     return std::make_unique<ThriftLogHelper>(                         \
         logger,                                                       \
         folly::LogLevel::level,                                       \
         functionName,                                                 \
         fileName,                                                     \
         lineNumber,                                                   \
-        getAndRegisterClientPid());                                   \
+        pid,                                                          \
+        std::move(clientRequest));                                    \
   }(__func__, __FILE__, __LINE__))
 
 // INSTRUMENT_THRIFT_CALL_WITH_FUNCTION_NAME_AND_PID works in the same way
@@ -368,7 +401,14 @@ EdenServiceHandler::EdenServiceHandler(
     EdenServer* server)
     : BaseService{kServiceName},
       originalCommandLine_{std::move(originalCommandLine)},
-      server_{server} {
+      server_{server},
+      globResultCache_{
+          server->getServerState()
+              ->getEdenConfig()
+              ->globResultCacheSize.getValue(),
+          server->getServerState()
+              ->getEdenConfig()
+              ->globResultCacheTtl.getValue()} {
   struct HistConfig {
     int64_t bucketSize{250};
     int64_t min{0};
@@ -494,6 +534,33 @@ void EdenServiceHandler::checkOutRevision(
       helper->getFunctionName(),
       checkoutMode);
   results = std::move(std::move(checkoutFuture).get().conflicts);
+
+  if (checkoutMode != CheckoutMode::DRY_RUN &&
+      server_->getServerState()
+          ->getEdenConfig()
+          ->predictivePrefetchAfterCheckout.getValue()) {
+    // The working set of the new commit is predicted from the history of the
+    // repository, the checkout doesn't wait for it to be prefetched.
+    try {
+      GlobParams globParams;
+      globParams.mountPoint_ref() = *mountPoint;
+      globParams.prefetchFiles_ref() = true;
+      globParams.suppressFileList_ref() = true;
+      globParams.background_ref() = true;
+      globMostFetchedDirectories(
+          globParams,
+          "prefetchAfterCheckout",
+          helper->getFetchContext().getClientPid())
+          .thenError([](folly::exception_wrapper&& ew) {
+            XLOG(WARN) << "failed to prefetch after checkout: "
+                       << folly::exceptionStr(ew);
+            return std::make_unique<Glob>();
+          });
+    } catch (const std::exception& ex) {
+      XLOG(WARN) << "failed to prefetch after checkout: "
+                 << folly::exceptionStr(ex);
+    }
+  }
 }
 
 void EdenServiceHandler::resetParentCommits(
@@ -574,22 +641,18 @@ void EdenServiceHandler::getSHA1(
   auto syncTimeout = getSyncTimeout(*sync);
   auto helper = INSTRUMENT_THRIFT_CALL(
       DBG3, *mountPoint, syncTimeout.count(), toLogArg(*paths));
-  vector<ImmediateFuture<Hash20>> futures;
   auto mountPath = AbsolutePathPiece{*mountPoint};
 
   waitForPendingNotifications(*server_->getMount(mountPath), syncTimeout)
       .thenValue([&](auto&&) {
-        for (const auto& path : *paths) {
-          futures.emplace_back(getSHA1ForPathDefensively(
-              mountPath, path, helper->getFetchContext()));
-        }
-
-        auto results = collectAll(std::move(futures)).get();
+        auto results = getBlobMetadataForPaths(
+                           mountPath, *paths, helper->getFetchContext())
+                           .get();
         for (auto& result : results) {
           out.emplace_back();
           SHA1Result& sha1Result = out.back();
           if (result.hasValue()) {
-            sha1Result.sha1_ref() = thriftHash20(result.value());
+            sha1Result.sha1_ref() = thriftHash20(result.value().sha1);
           } else {
             sha1Result.error_ref() = newEdenError(result.exception());
           }
@@ -598,45 +661,12 @@ void EdenServiceHandler::getSHA1(
       .get();
 }
 
-ImmediateFuture<Hash20> EdenServiceHandler::getSHA1ForPathDefensively(
-    AbsolutePathPiece mountPoint,
-    StringPiece path,
-    ObjectFetchContext& fetchContext) noexcept {
-  return makeImmediateFutureWith(
-      [&] { return getSHA1ForPath(mountPoint, path, fetchContext); });
-}
-
-ImmediateFuture<Hash20> EdenServiceHandler::getSHA1ForPath(
+ImmediateFuture<FileInodePtr> EdenServiceHandler::getRegularFileInodeForPath(
     AbsolutePathPiece mountPoint,
     StringPiece path,
     ObjectFetchContext& fetchContext) {
   if (path.empty()) {
-    return ImmediateFuture<Hash20>(newEdenError(
-        EINVAL,
-        EdenErrorType::ARGUMENT_ERROR,
-        "path cannot be the empty string"));
-  }
-
-  auto edenMount = server_->getMount(mountPoint);
-  auto relativePath = RelativePathPiece{path};
-  return edenMount->getInode(relativePath, fetchContext)
-      .thenValue([&fetchContext](const InodePtr& inode) {
-        auto fileInode = inode.asFilePtr();
-        if (fileInode->getType() != dtype_t::Regular) {
-          // We intentionally want to refuse to compute the SHA1 of symlinks
-          return makeImmediateFuture<Hash20>(
-              InodeError(EINVAL, fileInode, "file is a symlink"));
-        }
-        return fileInode->getSha1(fetchContext);
-      });
-}
-
-ImmediateFuture<BlobMetadata> EdenServiceHandler::getBlobMetadataForPath(
-    AbsolutePathPiece mountPoint,
-    StringPiece path,
-    ObjectFetchContext& fetchContext) {
-  if (path.empty()) {
-    return ImmediateFuture<BlobMetadata>(newEdenError(
+    return ImmediateFuture<FileInodePtr>(newEdenError(
         EINVAL,
         EdenErrorType::ARGUMENT_ERROR,
         "path cannot be the empty string"));
@@ -646,21 +676,161 @@ ImmediateFuture<BlobMetadata> EdenServiceHandler::getBlobMetadataForPath(
     auto edenMount = server_->getMount(mountPoint);
     auto relativePath = RelativePathPiece{path};
     return edenMount->getInode(relativePath, fetchContext)
-        .thenValue([&fetchContext](const InodePtr& inode) {
+        .thenValue([](const InodePtr& inode) {
           auto fileInode = inode.asFilePtr();
           if (fileInode->getType() != dtype_t::Regular) {
             // We intentionally want to refuse to get the metadata of symlinks
-            return makeImmediateFuture<BlobMetadata>(
+            return makeImmediateFuture<FileInodePtr>(
                 InodeError(EINVAL, fileInode, "file is a symlink"));
           }
-          return fileInode->getBlobMetadata(fetchContext);
+          return ImmediateFuture<FileInodePtr>{std::move(fileInode)};
         });
   } catch (const std::exception& e) {
-    return ImmediateFuture<BlobMetadata>(
+    return ImmediateFuture<FileInodePtr>(
         newEdenError(EINVAL, EdenErrorType::ARGUMENT_ERROR, e.what()));
   }
 }
 
+ImmediateFuture<BlobMetadata> EdenServiceHandler::getBlobMetadataForPath(
+    AbsolutePathPiece mountPoint,
+    StringPiece path,
+    ObjectFetchContext& fetchContext) {
+  return getRegularFileInodeForPath(mountPoint, path, fetchContext)
+      .thenValue([&fetchContext](const FileInodePtr& fileInode) {
+        return fileInode->getBlobMetadata(fetchContext);
+      });
+}
+
+namespace {
+/**
+ * Get the metadata of each loaded file in inodes. The files that are still
+ * backed by a source control blob are looked up in a single batch.
+ */
+ImmediateFuture<std::vector<folly::Try<BlobMetadata>>>
+getBlobMetadataForInodes(
+    const EdenMount& edenMount,
+    std::vector<folly::Try<FileInodePtr>> inodes,
+    ObjectFetchContext& fetchContext) {
+  std::vector<folly::Try<BlobMetadata>> results(inodes.size());
+
+  // Files that are still backed by a source control blob get their
+  // metadata from the ObjectStore in a single batch, the materialized
+  // ones compute it from the overlay.
+  std::vector<ObjectId> blobIds;
+  std::vector<size_t> blobIndices;
+  vector<ImmediateFuture<BlobMetadata>> materializedFutures;
+  std::vector<size_t> materializedIndices;
+  for (size_t i = 0; i < inodes.size(); ++i) {
+    if (inodes[i].hasException()) {
+      results[i] = folly::Try<BlobMetadata>{inodes[i].exception()};
+      continue;
+    }
+    const auto& fileInode = inodes[i].value();
+    if (auto blobId = fileInode->getBlobHashForMetadata(fetchContext)) {
+      blobIds.push_back(std::move(*blobId));
+      blobIndices.push_back(i);
+    } else {
+      materializedFutures.emplace_back(makeImmediateFutureWith(
+          [&] { return fileInode->getBlobMetadata(fetchContext); }));
+      materializedIndices.push_back(i);
+    }
+  }
+
+  return edenMount.getObjectStore()
+      ->getBlobMetadataBatch(blobIds, fetchContext)
+      .thenValue([results = std::move(results),
+                  blobIndices = std::move(blobIndices),
+                  materializedFutures = std::move(materializedFutures),
+                  materializedIndices = std::move(materializedIndices)](
+                     std::vector<folly::Try<BlobMetadata>>&&
+                         blobResults) mutable {
+        for (size_t i = 0; i < blobResults.size(); ++i) {
+          results[blobIndices[i]] = std::move(blobResults[i]);
+        }
+        return collectAll(std::move(materializedFutures))
+            .thenValue([results = std::move(results),
+                        materializedIndices = std::move(materializedIndices)](
+                           std::vector<folly::Try<BlobMetadata>>&&
+                               materializedResults) mutable {
+              for (size_t i = 0; i < materializedResults.size(); ++i) {
+                results[materializedIndices[i]] =
+                    std::move(materializedResults[i]);
+              }
+              return std::move(results);
+            });
+      });
+}
+
+/**
+ * Load the regular files at paths, relative to rootInode. Unlike loading each
+ * path through EdenMount::getInode(), the directories shared by several paths
+ * are only looked up once, see applyToInodes().
+ */
+ImmediateFuture<std::vector<folly::Try<FileInodePtr>>> loadRegularFiles(
+    InodePtr rootInode,
+    const std::vector<std::string>& paths,
+    ObjectFetchContext& fetchContext) {
+  std::vector<folly::Try<FileInodePtr>> results(paths.size());
+  std::vector<std::string> validPaths;
+  std::vector<size_t> validIndices;
+  for (size_t i = 0; i < paths.size(); ++i) {
+    if (paths[i].empty()) {
+      results[i] = folly::Try<FileInodePtr>{newEdenError(
+          EINVAL,
+          EdenErrorType::ARGUMENT_ERROR,
+          "path cannot be the empty string")};
+      continue;
+    }
+    try {
+      auto path = RelativePathPiece{paths[i]};
+      validPaths.push_back(path.stringPiece().str());
+      validIndices.push_back(i);
+    } catch (const std::exception& e) {
+      results[i] = folly::Try<FileInodePtr>{
+          newEdenError(EINVAL, EdenErrorType::ARGUMENT_ERROR, e.what())};
+    }
+  }
+
+  auto inodeFutures = applyToInodes(
+      std::move(rootInode),
+      validPaths,
+      [](InodePtr inode) {
+        auto fileInode = inode.asFilePtr();
+        if (fileInode->getType() != dtype_t::Regular) {
+          // We intentionally want to refuse to get the metadata of symlinks
+          throw InodeError(EINVAL, fileInode, "file is a symlink");
+        }
+        return folly::makeSemiFuture(std::move(fileInode));
+      },
+      fetchContext);
+  return ImmediateFuture<std::vector<folly::Try<FileInodePtr>>>{
+      folly::collectAll(std::move(inodeFutures))}
+      .thenValue([results = std::move(results),
+                  validIndices = std::move(validIndices)](
+                     std::vector<folly::Try<FileInodePtr>>&& loaded) mutable {
+        for (size_t i = 0; i < loaded.size(); ++i) {
+          results[validIndices[i]] = std::move(loaded[i]);
+        }
+        return std::move(results);
+      });
+}
+} // namespace
+
+ImmediateFuture<std::vector<folly::Try<BlobMetadata>>>
+EdenServiceHandler::getBlobMetadataForPaths(
+    AbsolutePathPiece mountPoint,
+    const std::vector<std::string>& paths,
+    ObjectFetchContext& fetchContext) {
+  auto edenMount = server_->getMount(mountPoint);
+
+  return loadRegularFiles(edenMount->getRootInode(), paths, fetchContext)
+      .thenValue([edenMount = std::move(edenMount), &fetchContext](
+                     std::vector<folly::Try<FileInodePtr>>&& inodes) {
+        return getBlobMetadataForInodes(
+            *edenMount, std::move(inodes), fetchContext);
+      });
+}
+
 void EdenServiceHandler::getBindMounts(
     std::vector<std::string>&,
     std::unique_ptr<std::string>) {
@@ -722,13 +892,19 @@ void EdenServiceHandler::getCurrentJournalPosition(
   }
 }
 
-apache::thrift::ServerStream<JournalPosition>
-EdenServiceHandler::subscribeStreamTemporary(
-    std::unique_ptr<std::string> mountPoint) {
-  auto helper = INSTRUMENT_THRIFT_CALL(DBG3, *mountPoint);
-  auto mountPath = AbsolutePathPiece{*mountPoint};
-  auto edenMount = server_->getMount(mountPath);
+namespace {
+std::vector<RelativePath> parseRoots(const std::vector<std::string>& roots) {
+  std::vector<RelativePath> result;
+  result.reserve(roots.size());
+  for (const auto& root : roots) {
+    result.emplace_back(root);
+  }
+  return result;
+}
 
+apache::thrift::ServerStream<JournalPosition> subscribeToJournal(
+    const std::shared_ptr<EdenMount>& edenMount,
+    std::vector<RelativePath> roots) {
   // We need a weak ref on the mount because the thrift stream plumbing
   // may outlive the mount point
   std::weak_ptr<EdenMount> weakMount(edenMount);
@@ -792,10 +968,31 @@ EdenServiceHandler::subscribeStreamTemporary(
         // the subscriber should call getCurrentJournalPosition or
         // getFilesChangedSince.
         stream->publisher.next(pos);
-      }));
+      },
+      std::move(roots)));
 
   return std::move(streamAndPublisher.first);
 }
+} // namespace
+
+apache::thrift::ServerStream<JournalPosition>
+EdenServiceHandler::subscribeStreamTemporary(
+    std::unique_ptr<std::string> mountPoint) {
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG3, *mountPoint);
+  auto mountPath = AbsolutePathPiece{*mountPoint};
+  auto edenMount = server_->getMount(mountPath);
+
+  return subscribeToJournal(edenMount, {});
+}
+
+apache::thrift::ServerStream<JournalPosition>
+EdenServiceHandler::subscribeStreamForRoots(
+    std::unique_ptr<SubscribeStreamParams> params) {
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG3, *params->mountPoint_ref());
+  auto mountPath = AbsolutePathPiece{*params->mountPoint_ref()};
+  auto edenMount = server_->getMount(mountPath);
+  return subscribeToJournal(edenMount, parseRoots(*params->roots_ref()));
+}
 
 namespace {
 TraceEventTimes thriftTraceEventTimes(const TraceEventBase& event) {
@@ -1180,9 +1377,18 @@ apache::thrift::ServerStream<HgEvent> EdenServiceHandler::traceHgEvents(
           case HgImportTraceEvent::START:
             te.eventType_ref() = HgEventType::START;
             break;
+          case HgImportTraceEvent::FETCH:
+            te.eventType_ref() = HgEventType::FETCH;
+            break;
+          case HgImportTraceEvent::FALLBACK:
+            te.eventType_ref() = HgEventType::FALLBACK;
+            break;
           case HgImportTraceEvent::FINISH:
             te.eventType_ref() = HgEventType::FINISH;
             break;
+          case HgImportTraceEvent::CANCEL:
+            te.eventType_ref() = HgEventType::CANCEL;
+            break;
         }
 
         switch (event.resourceType) {
@@ -1192,6 +1398,9 @@ apache::thrift::ServerStream<HgEvent> EdenServiceHandler::traceHgEvents(
           case HgImportTraceEvent::TREE:
             te.resourceType_ref() = HgResourceType::TREE;
             break;
+          case HgImportTraceEvent::BLOBMETA:
+            te.resourceType_ref() = HgResourceType::BLOBMETA;
+            break;
         }
 
         te.unique_ref() = event.unique;
@@ -1208,15 +1417,13 @@ apache::thrift::ServerStream<HgEvent> EdenServiceHandler::traceHgEvents(
   return std::move(serverStream);
 }
 
-void EdenServiceHandler::getFilesChangedSince(
+namespace {
+void fillFilesChangedSince(
     FileDelta& out,
-    std::unique_ptr<std::string> mountPoint,
-    std::unique_ptr<JournalPosition> fromPosition) {
-  auto helper = INSTRUMENT_THRIFT_CALL(DBG3, *mountPoint);
-  auto mountPath = AbsolutePathPiece{*mountPoint};
-  auto edenMount = server_->getMount(mountPath);
-
-  if (*fromPosition->mountGeneration_ref() !=
+    const std::shared_ptr<EdenMount>& edenMount,
+    const JournalPosition& fromPosition,
+    const std::vector<RelativePath>& roots) {
+  if (*fromPosition.mountGeneration_ref() !=
       static_cast<ssize_t>(edenMount->getMountGeneration())) {
     throw newEdenError(
         ERANGE,
@@ -1230,12 +1437,12 @@ void EdenServiceHandler::getFilesChangedSince(
   // its limitSequence parameter and we want the changes *since*
   // the provided sequence number.
   auto summed = edenMount->getJournal().accumulateRange(
-      *fromPosition->sequenceNumber_ref() + 1);
+      *fromPosition.sequenceNumber_ref() + 1, roots);
 
   // We set the default toPosition to be where we where if summed is null
   out.toPosition_ref()->sequenceNumber_ref() =
-      *fromPosition->sequenceNumber_ref();
-  out.toPosition_ref()->snapshotHash_ref() = *fromPosition->snapshotHash_ref();
+      *fromPosition.sequenceNumber_ref();
+  out.toPosition_ref()->snapshotHash_ref() = *fromPosition.snapshotHash_ref();
   out.toPosition_ref()->mountGeneration_ref() = edenMount->getMountGeneration();
 
   out.fromPosition_ref() = *out.toPosition_ref();
@@ -1282,6 +1489,82 @@ void EdenServiceHandler::getFilesChangedSince(
     }
   }
 }
+} // namespace
+
+void EdenServiceHandler::getFilesChangedSince(
+    FileDelta& out,
+    std::unique_ptr<std::string> mountPoint,
+    std::unique_ptr<JournalPosition> fromPosition) {
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG3, *mountPoint);
+  auto mountPath = AbsolutePathPiece{*mountPoint};
+  auto edenMount = server_->getMount(mountPath);
+
+  fillFilesChangedSince(out, edenMount, *fromPosition, {});
+}
+
+void EdenServiceHandler::getFilesChangedSinceForRoots(
+    FileDelta& out,
+    std::unique_ptr<GetFilesChangedSinceParams> params) {
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG3, *params->mountPoint_ref());
+  auto mountPath = AbsolutePathPiece{*params->mountPoint_ref()};
+  auto edenMount = server_->getMount(mountPath);
+  fillFilesChangedSince(
+      out,
+      edenMount,
+      *params->fromPosition_ref(),
+      parseRoots(*params->roots_ref()));
+}
+
+apache::thrift::ServerStream<FileDelta>
+EdenServiceHandler::streamFilesChangedSince(
+    std::unique_ptr<StreamFilesChangedSinceParams> params) {
+  auto& changedParams = *params->params_ref();
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG3, *changedParams.mountPoint_ref());
+  auto mountPath = AbsolutePathPiece{*changedParams.mountPoint_ref()};
+  auto edenMount = server_->getMount(mountPath);
+
+  FileDelta delta;
+  fillFilesChangedSince(
+      delta,
+      edenMount,
+      *changedParams.fromPosition_ref(),
+      parseRoots(*changedParams.roots_ref()));
+  auto chunkSize = getStreamChunkSize(*params->chunkSize_ref());
+
+  auto fromPosition = *delta.fromPosition_ref();
+  auto toPosition = *delta.toPosition_ref();
+  auto changedPaths = std::exchange(*delta.changedPaths_ref(), {});
+  auto createdPaths = std::exchange(*delta.createdPaths_ref(), {});
+
+  // Paths are taken from the end of the lists, so that the remaining ones
+  // don't have to be moved.
+  auto takePaths = [](std::vector<std::string>& from,
+                      std::vector<std::string>& to,
+                      size_t& room) {
+    while (room > 0 && !from.empty()) {
+      to.push_back(std::move(from.back()));
+      from.pop_back();
+      --room;
+    }
+  };
+
+  auto [serverStream, publisher] =
+      apache::thrift::ServerStream<FileDelta>::createPublisher([] {});
+  // The first chunk carries everything but the paths, the following ones
+  // only the journal positions.
+  FileDelta chunk = std::move(delta);
+  do {
+    size_t room = chunkSize;
+    takePaths(changedPaths, *chunk.changedPaths_ref(), room);
+    takePaths(createdPaths, *chunk.createdPaths_ref(), room);
+    publisher.next(std::move(chunk));
+    chunk = FileDelta{};
+    chunk.fromPosition_ref() = fromPosition;
+    chunk.toPosition_ref() = toPosition;
+  } while (!changedPaths.empty() || !createdPaths.empty());
+  std::move(publisher).complete();
+  return std::move(serverStream);
+}
 
 void EdenServiceHandler::setJournalMemoryLimit(
     std::unique_ptr<PathString> mountPoint,
@@ -1457,6 +1740,30 @@ EdenServiceHandler::semifuture_getFileInformation(
 #define ATTR_BITMASK(req, attr) \
   ((req) & static_cast<uint64_t>((FileAttributes::attr)))
 
+namespace {
+FileAttributeDataOrError makeFileAttributeResult(
+    const folly::Try<BlobMetadata>& tryMetadata,
+    uint64_t reqBitmask) {
+  FileAttributeDataOrError file_res;
+  // check for exceptions. if found, return EdenError early
+  if (tryMetadata.hasException()) {
+    file_res.error_ref() = newEdenError(tryMetadata.exception());
+  } else { /* No exceptions, fill in data */
+    FileAttributeData file_data;
+    const auto& metadata = tryMetadata.value();
+    // Only fill in requested fields
+    if (ATTR_BITMASK(reqBitmask, SHA1_HASH)) {
+      file_data.sha1_ref() = thriftHash20(metadata.sha1);
+    }
+    if (ATTR_BITMASK(reqBitmask, FILE_SIZE)) {
+      file_data.fileSize_ref() = metadata.size;
+    }
+    file_res.data_ref() = file_data;
+  }
+  return file_res;
+}
+} // namespace
+
 folly::SemiFuture<std::unique_ptr<GetAttributesFromFilesResult>>
 EdenServiceHandler::semifuture_getAttributesFromFiles(
     std::unique_ptr<GetAttributesFromFilesParams> params) {
@@ -1479,44 +1786,17 @@ EdenServiceHandler::semifuture_getAttributesFromFiles(
                              &fetchContext,
                              mountPath = mountPath.copy(),
                              reqBitmask](auto&&) mutable {
-                   vector<ImmediateFuture<BlobMetadata>> futures;
-                   for (const auto& p : paths) {
-                     futures.emplace_back(
-                         getBlobMetadataForPath(mountPath, p, fetchContext));
-                   }
-
-                   // Collect all futures into a single tuple
-                   return facebook::eden::collectAll(std::move(futures))
+                   return getBlobMetadataForPaths(
+                              mountPath, paths, fetchContext)
                        .thenValue([paths = std::move(paths), reqBitmask](
                                       std::vector<folly::Try<BlobMetadata>>&&
                                           allRes) {
                          auto res =
                              std::make_unique<GetAttributesFromFilesResult>();
-                         auto sizeRequested =
-                             ATTR_BITMASK(reqBitmask, FILE_SIZE);
-                         auto sha1Requested =
-                             ATTR_BITMASK(reqBitmask, SHA1_HASH);
                          for (const auto& tryMetadata : allRes) {
-                           FileAttributeDataOrError file_res;
-                           // check for exceptions. if found, return EdenError
-                           // early
-                           if (tryMetadata.hasException()) {
-                             file_res.error_ref() =
-                                 newEdenError(tryMetadata.exception());
-                           } else { /* No exceptions, fill in data */
-                             FileAttributeData file_data;
-                             const auto& metadata = tryMetadata.value();
-                             // Only fill in requested fields
-                             if (sha1Requested) {
-                               file_data.sha1_ref() =
-                                   thriftHash20(metadata.sha1);
-                             }
-                             if (sizeRequested) {
-                               file_data.fileSize_ref() = metadata.size;
-                             }
-                             file_res.data_ref() = file_data;
-                           }
-                           res->res_ref()->emplace_back(file_res);
+                           res->res_ref()->emplace_back(
+                               makeFileAttributeResult(
+                                   tryMetadata, reqBitmask));
                          }
                          return res;
                        });
@@ -1524,6 +1804,95 @@ EdenServiceHandler::semifuture_getAttributesFromFiles(
       .semi();
 }
 
+folly::SemiFuture<std::unique_ptr<GetAttributesFromFilesResult>>
+EdenServiceHandler::semifuture_getAttributesFromFilesBatch(
+    std::unique_ptr<GetAttributesFromFilesBatchParams> params) {
+  auto requests = std::move(*params->requests_ref());
+  auto syncTimeout = getSyncTimeout(*params->sync_ref());
+  auto helper =
+      INSTRUMENT_THRIFT_CALL(DBG3, requests.size(), syncTimeout.count());
+  auto& fetchContext = helper->getFetchContext();
+
+  // Group the requests by mount, so that each mount is only looked up,
+  // synchronized and traversed once.
+  struct MountRequests {
+    std::shared_ptr<EdenMount> mount;
+    std::vector<std::string> paths;
+    std::vector<size_t> indices;
+  };
+  std::vector<MountRequests> mounts;
+  std::unordered_map<std::string, size_t> mountIndices;
+  auto results = std::vector<FileAttributeDataOrError>(requests.size());
+  for (size_t i = 0; i < requests.size(); ++i) {
+    auto& mountPoint = *requests[i].mountPoint_ref();
+    auto it = mountIndices.find(mountPoint);
+    if (it == mountIndices.end()) {
+      std::shared_ptr<EdenMount> mount;
+      try {
+        mount = server_->getMount(AbsolutePathPiece{mountPoint});
+      } catch (const std::exception& ex) {
+        results[i].error_ref() = newEdenError(ex);
+        continue;
+      }
+      it = mountIndices.emplace(mountPoint, mounts.size()).first;
+      mounts.push_back(MountRequests{std::move(mount), {}, {}});
+    }
+    auto& mountRequests = mounts[it->second];
+    mountRequests.paths.push_back(std::move(*requests[i].path_ref()));
+    mountRequests.indices.push_back(i);
+  }
+
+  std::vector<ImmediateFuture<std::vector<folly::Try<BlobMetadata>>>>
+      mountFutures;
+  mountFutures.reserve(mounts.size());
+  for (auto& mountRequests : mounts) {
+    auto mount = mountRequests.mount;
+    mountFutures.emplace_back(
+        waitForPendingNotifications(*mount, syncTimeout)
+            .thenValue([mount,
+                        paths = std::move(mountRequests.paths),
+                        &fetchContext](auto&&) {
+              return loadRegularFiles(
+                  mount->getRootInode(), paths, fetchContext);
+            })
+            .thenValue([mount, &fetchContext](
+                           std::vector<folly::Try<FileInodePtr>>&& inodes) {
+              return getBlobMetadataForInodes(
+                  *mount, std::move(inodes), fetchContext);
+            }));
+  }
+
+  return wrapImmediateFuture(
+             std::move(helper),
+             collectAll(std::move(mountFutures))
+                 .thenValue(
+                     [requests = std::move(requests),
+                      mounts = std::move(mounts),
+                      results = std::move(results)](
+                         std::vector<folly::Try<
+                             std::vector<folly::Try<BlobMetadata>>>>&&
+                             mountResults) mutable {
+                       for (size_t m = 0; m < mounts.size(); ++m) {
+                         const auto& indices = mounts[m].indices;
+                         for (size_t j = 0; j < indices.size(); ++j) {
+                           auto index = indices[j];
+                           auto metadata = mountResults[m].hasException()
+                               ? folly::Try<BlobMetadata>{mountResults[m]
+                                                              .exception()}
+                               : std::move(mountResults[m].value()[j]);
+                           results[index] = makeFileAttributeResult(
+                               metadata,
+                               *requests[index].requestedAttributes_ref());
+                         }
+                       }
+                       auto res =
+                           std::make_unique<GetAttributesFromFilesResult>();
+                       res->res_ref() = std::move(results);
+                       return res;
+                     }))
+      .semi();
+}
+
 folly::Future<std::unique_ptr<Glob>> EdenServiceHandler::globFilesImpl(
     folly::StringPiece mountPoint,
     std::vector<std::string> globs,
@@ -1583,10 +1952,46 @@ folly::Future<std::unique_ptr<Glob>> EdenServiceHandler::globFilesImpl(
     // invalidate the earlier commitHash refrences
     globFutures.reserve(rootHashes.size());
     originRootIds->reserve(rootHashes.size());
+    // The order of the patterns doesn't change the results.
+    auto sortedGlobs = globs;
+    std::sort(sortedGlobs.begin(), sortedGlobs.end());
     for (auto& rootHash : rootHashes) {
       const RootId& originRootId = originRootIds->emplace_back(
           edenMount->getObjectStore()->parseRootId(rootHash));
 
+      // Commits don't change, so the results of an identical recent glob
+      // against the same commit can be reused.
+      auto cacheKey = GlobResultCache::makeKey(
+          mountPoint,
+          rootHash,
+          searchRoot,
+          sortedGlobs,
+          globOptions.includeDotfiles,
+          globOptions.prefetchFiles);
+      if (auto cached = globResultCache_.get(cacheKey)) {
+        XLOG(DBG4) << "reusing cached glob results for " << rootHash;
+        {
+          auto results = globResults->wlock();
+          for (const auto& match : cached->matches) {
+            results->emplace_back(match.name, match.dtype, originRootId);
+          }
+        }
+        if (fileBlobsToPrefetch) {
+          auto blobs = fileBlobsToPrefetch->wlock();
+          blobs->insert(
+              blobs->end(),
+              cached->blobsToPrefetch.begin(),
+              cached->blobsToPrefetch.end());
+        }
+        continue;
+      }
+
+      // Each commit is evaluated into its own lists, so that its results can
+      // be cached before they are merged with those of the other commits.
+      auto rootResults = std::make_shared<GlobNode::ResultList>();
+      auto rootBlobsToPrefetch = fileBlobsToPrefetch
+          ? std::make_shared<GlobNode::PrefetchList>()
+          : nullptr;
       globFutures.emplace_back(
           edenMount->getObjectStore()
               ->getRootTree(originRootId, fetchContext)
@@ -1602,8 +2007,8 @@ folly::Future<std::unique_ptr<Glob>> EdenServiceHandler::globFilesImpl(
                   [edenMount,
                    globRoot,
                    &fetchContext,
-                   fileBlobsToPrefetch,
-                   globResults,
+                   rootBlobsToPrefetch,
+                   rootResults,
                    &originRootId](std::shared_ptr<const Tree>&& tree) mutable {
                     return globRoot
                         ->evaluate(
@@ -1611,11 +2016,41 @@ folly::Future<std::unique_ptr<Glob>> EdenServiceHandler::globFilesImpl(
                             fetchContext,
                             RelativePathPiece(),
                             std::move(tree),
-                            fileBlobsToPrefetch.get(),
-                            *globResults,
+                            rootBlobsToPrefetch.get(),
+                            *rootResults,
                             originRootId)
                         .semi();
-                  }));
+                  })
+              .thenValue([this,
+                          cacheKey = std::move(cacheKey),
+                          rootResults,
+                          rootBlobsToPrefetch,
+                          globResults,
+                          fileBlobsToPrefetch](folly::Unit) mutable {
+                auto cached = std::make_shared<GlobResultCache::Results>();
+                auto matches = std::move(*rootResults->wlock());
+                cached->matches.reserve(matches.size());
+                for (const auto& match : matches) {
+                  cached->matches.push_back({match.name, match.dtype});
+                }
+                {
+                  auto results = globResults->wlock();
+                  results->insert(
+                      results->end(),
+                      std::make_move_iterator(matches.begin()),
+                      std::make_move_iterator(matches.end()));
+                }
+                if (rootBlobsToPrefetch) {
+                  cached->blobsToPrefetch =
+                      std::move(*rootBlobsToPrefetch->wlock());
+                  auto blobs = fileBlobsToPrefetch->wlock();
+                  blobs->insert(
+                      blobs->end(),
+                      cached->blobsToPrefetch.begin(),
+                      cached->blobsToPrefetch.end());
+                }
+                globResultCache_.insert(std::move(cacheKey), std::move(cached));
+              }));
     }
   } else {
     const RootId& originRootId =
@@ -1751,11 +2186,28 @@ EdenServiceHandler::future_setPathObjectId(
   auto mountPath = AbsolutePathPiece{mountPoint};
   auto edenMount = server_->getMount(mountPath);
   // TODO: This function should operate with ObjectId instead of RootId.
-  auto repoPath = params->get_path();
-  auto parsedRootId =
-      edenMount->getObjectStore()->parseRootId(params->get_objectId());
+  std::vector<PathObjectGraftRequest> objects;
+  if (params->objects_ref()->empty()) {
+    objects.push_back(PathObjectGraftRequest{
+        RelativePath{params->get_path()},
+        edenMount->getObjectStore()->parseRootId(params->get_objectId()),
+        params->get_type()});
+  } else {
+    objects.reserve(params->objects_ref()->size());
+    for (const auto& object : *params->objects_ref()) {
+      objects.push_back(PathObjectGraftRequest{
+          RelativePath{object.get_path()},
+          edenMount->getObjectStore()->parseRootId(object.get_objectId()),
+          object.get_type()});
+    }
+  }
   auto helper = INSTRUMENT_THRIFT_CALL(
-      DBG1, mountPoint, repoPath, parsedRootId, params->get_type());
+      DBG1,
+      mountPoint,
+      objects.front().path.stringPiece(),
+      objects.front().id,
+      objects.front().type,
+      objects.size());
 
   auto& fetchContext = helper->getFetchContext();
   if (auto requestInfo = params->requestInfo_ref()) {
@@ -1764,12 +2216,8 @@ EdenServiceHandler::future_setPathObjectId(
   return wrapFuture(
       std::move(helper),
       edenMount
-          ->setPathObjectId(
-              RelativePathPiece{repoPath},
-              parsedRootId,
-              params->get_type(),
-              params->get_mode(),
-              fetchContext)
+          ->setPathObjectIds(
+              std::move(objects), params->get_mode(), fetchContext)
           .thenValue([](auto&& resultAndTimes) {
             return std::make_unique<SetPathObjectIdResult>(
                 std::move(resultAndTimes.result));
@@ -1821,6 +2269,14 @@ folly::Future<std::unique_ptr<Glob>>
 EdenServiceHandler::future_predictiveGlobFiles(
     std::unique_ptr<GlobParams> params) {
 #ifdef EDEN_HAVE_USAGE_SERVICE
+  if (server_->getServerState()
+          ->getEdenConfig()
+          ->predictivePrefetchFromLocalHistory.getValue()) {
+    auto future = globMostFetchedDirectories(
+        *params, __func__, getAndRegisterClientPid());
+    return std::move(future).ensure([params = std::move(params)]() {});
+  }
+
   // TODO: since we call INSTRUMENT_THRIFT_CALL in _globFiles, the time
   // of getTopUsedDirs won't be taken into account
   auto& mountPoint = *params->mountPoint_ref();
@@ -1901,11 +2357,46 @@ EdenServiceHandler::future_predictiveGlobFiles(
       })
       .ensure([params = std::move(params)]() {});
 #else // !EDEN_HAVE_USAGE_SERVICE
-  (void)params;
-  NOT_IMPLEMENTED();
+  auto future = globMostFetchedDirectories(
+      *params, __func__, getAndRegisterClientPid());
+  return std::move(future).ensure([params = std::move(params)]() {});
 #endif // !EDEN_HAVE_USAGE_SERVICE
 }
 
+folly::Future<std::unique_ptr<Glob>>
+EdenServiceHandler::globMostFetchedDirectories(
+    const GlobParams& params,
+    folly::StringPiece caller,
+    std::optional<pid_t> pid) {
+  const auto& mountPoint = *params.mountPoint_ref();
+  uint32_t numResults = server_->getServerState()
+                            ->getEdenConfig()
+                            ->predictivePrefetchProfileSize.getValue();
+  if (const auto& predictiveGlob = params.predictiveGlob_ref()) {
+    numResults = predictiveGlob->numTopDirectories_ref().value_or(numResults);
+  }
+
+  auto directories = server_->getMount(AbsolutePathPiece{mountPoint})
+                         ->getObjectStore()
+                         ->getBackingStore()
+                         ->getMostFetchedDirectories(numResults);
+  std::vector<std::string> globs;
+  globs.reserve(directories.size());
+  for (const auto& directory : directories) {
+    auto path = directory.stringPiece();
+    globs.push_back(path.empty() ? "*" : folly::to<std::string>(path, "/*"));
+  }
+
+  return globFilesImpl(
+      mountPoint,
+      std::move(globs),
+      *params.revisions_ref(),
+      *params.searchRoot_ref(),
+      GlobOptions{params},
+      caller,
+      pid);
+}
+
 folly::Future<std::unique_ptr<Glob>> EdenServiceHandler::future_globFiles(
     std::unique_ptr<GlobParams> params) {
   GlobOptions globOptions{*params};
@@ -1919,6 +2410,68 @@ folly::Future<std::unique_ptr<Glob>> EdenServiceHandler::future_globFiles(
       getAndRegisterClientPid());
 }
 
+namespace {
+/**
+ * Publish glob in Globs of at most chunkSize files each. dtypes and
+ * originHashes are only set when they were requested, in which case they
+ * have one element per matching file.
+ */
+void publishGlobChunks(
+    apache::thrift::ServerStreamPublisher<Glob>& publisher,
+    Glob& glob,
+    size_t chunkSize) {
+  auto& files = *glob.matchingFiles_ref();
+  size_t start = 0;
+  do {
+    auto end = std::min(files.size(), start + chunkSize);
+    auto moveRange = [start, end](auto& from, auto& to) {
+      if (!from.empty()) {
+        to.assign(
+            std::make_move_iterator(from.begin() + start),
+            std::make_move_iterator(from.begin() + end));
+      }
+    };
+    Glob chunk;
+    moveRange(files, *chunk.matchingFiles_ref());
+    moveRange(*glob.dtypes_ref(), *chunk.dtypes_ref());
+    moveRange(*glob.originHashes_ref(), *chunk.originHashes_ref());
+    publisher.next(std::move(chunk));
+    start = end;
+  } while (start < files.size());
+}
+} // namespace
+
+apache::thrift::ServerStream<Glob> EdenServiceHandler::streamGlobFiles(
+    std::unique_ptr<StreamGlobFilesParams> params) {
+  auto& globParams = *params->params_ref();
+  GlobOptions globOptions{globParams};
+  auto chunkSize = getStreamChunkSize(*params->chunkSize_ref());
+
+  // Invalid arguments are reported before the stream is created.
+  auto globFuture = globFilesImpl(
+      *globParams.mountPoint_ref(),
+      *globParams.globs_ref(),
+      *globParams.revisions_ref(),
+      *globParams.searchRoot_ref(),
+      globOptions,
+      __func__,
+      getAndRegisterClientPid());
+
+  auto [serverStream, publisher] =
+      apache::thrift::ServerStream<Glob>::createPublisher([] {});
+  (void)std::move(globFuture)
+      .thenTry([publisher = std::move(publisher), chunkSize](
+                   folly::Try<std::unique_ptr<Glob>>&& result) mutable {
+        if (result.hasException()) {
+          std::move(publisher).complete(std::move(result).exception());
+          return;
+        }
+        publishGlobChunks(publisher, *result.value(), chunkSize);
+        std::move(publisher).complete();
+      });
+  return std::move(serverStream);
+}
+
 folly::Future<Unit> EdenServiceHandler::future_chown(
     FOLLY_MAYBE_UNUSED std::unique_ptr<std::string> mountPoint,
     FOLLY_MAYBE_UNUSED int32_t uid,
@@ -1969,6 +2522,130 @@ void EdenServiceHandler::async_tm_getScmStatusV2(
       });
 }
 
+namespace {
+/**
+ * A DiffCallback publishing the differences it is told about on a stream, in
+ * ScmStatus chunks of at most chunkSize entries and errors. Once the client
+ * is gone or too far behind, the differences are dropped.
+ */
+class StreamingScmStatusCallback : public DiffCallback {
+ public:
+  StreamingScmStatusCallback(
+      std::shared_ptr<BoundedStreamQueue<ScmStatus>> queue,
+      size_t chunkSize)
+      : chunkSize_{chunkSize}, queue_{std::move(queue)} {}
+
+  void ignoredFile(RelativePathPiece path) override {
+    addEntry(path, ScmFileStatus::IGNORED);
+  }
+
+  void addedFile(RelativePathPiece path) override {
+    addEntry(path, ScmFileStatus::ADDED);
+  }
+
+  void removedFile(RelativePathPiece path) override {
+    addEntry(path, ScmFileStatus::REMOVED);
+  }
+
+  void modifiedFile(RelativePathPiece path) override {
+    addEntry(path, ScmFileStatus::MODIFIED);
+  }
+
+  void diffError(RelativePathPiece path, const folly::exception_wrapper& ew)
+      override {
+    XLOG(WARNING) << "error computing status data for " << path << ": "
+                  << folly::exceptionStr(ew);
+    auto state = state_.wlock();
+    if (state->ended) {
+      return;
+    }
+    state->chunk.errors_ref()->emplace(
+        path.stringPiece().str(), folly::exceptionStr(ew).toStdString());
+    addedToChunk(*state);
+  }
+
+  /**
+   * Publish the last chunk and end the stream, with ew if the diff failed.
+   * Must be called exactly once, after the diff completed.
+   */
+  void complete(folly::exception_wrapper ew) {
+    auto state = state_.wlock();
+    if (!ew) {
+      // Always publish at least one ScmStatus, even if it is empty.
+      queue_->push(std::move(state->chunk));
+    }
+    queue_->complete(std::move(ew));
+  }
+
+ private:
+  struct State {
+    ScmStatus chunk;
+    size_t chunkEntries{0};
+    // Set once the stream can't take more chunks.
+    bool ended{false};
+  };
+
+  void addEntry(RelativePathPiece path, ScmFileStatus status) {
+    auto state = state_.wlock();
+    if (state->ended) {
+      return;
+    }
+    state->chunk.entries_ref()->emplace(path.stringPiece().str(), status);
+    addedToChunk(*state);
+  }
+
+  void addedToChunk(State& state) {
+    if (++state.chunkEntries >= chunkSize_) {
+      state.ended = !queue_->push(std::exchange(state.chunk, ScmStatus{}));
+      state.chunkEntries = 0;
+    }
+  }
+
+  const size_t chunkSize_;
+  const std::shared_ptr<BoundedStreamQueue<ScmStatus>> queue_;
+  folly::Synchronized<State> state_;
+};
+} // namespace
+
+apache::thrift::ServerStream<ScmStatus> EdenServiceHandler::streamScmStatus(
+    std::unique_ptr<StreamScmStatusParams> params) {
+  auto& statusParams = *params->params_ref();
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      DBG2,
+      *statusParams.mountPoint_ref(),
+      folly::to<string>("commitHash=", logHash(*statusParams.commit_ref())),
+      folly::to<string>("listIgnored=", *statusParams.listIgnored_ref()));
+
+  auto mountPath = AbsolutePathPiece{*statusParams.mountPoint_ref()};
+  auto mount = server_->getMount(mountPath);
+  auto rootId =
+      mount->getObjectStore()->parseRootId(*statusParams.commit_ref());
+  auto enforceParents = server_->getServerState()
+                            ->getReloadableConfig()
+                            ->getEdenConfig()
+                            ->enforceParents.getValue();
+
+  auto [serverStream, queue] =
+      BoundedStreamQueue<ScmStatus>::create(kMaxQueuedStreamChunks);
+  auto callback = std::make_unique<StreamingScmStatusCallback>(
+      std::move(queue), getStreamChunkSize(*params->chunkSize_ref()));
+  auto* callbackPtr = callback.get();
+  (void)mount
+      ->diff(
+          callbackPtr,
+          rootId,
+          *statusParams.listIgnored_ref(),
+          enforceParents,
+          nullptr)
+      .thenTry([mount, callback = std::move(callback)](
+                   folly::Try<Unit>&& result) {
+        callback->complete(
+            result.hasException() ? std::move(result).exception()
+                                  : folly::exception_wrapper{});
+      });
+  return std::move(serverStream);
+}
+
 void EdenServiceHandler::async_tm_getScmStatus(
     unique_ptr<apache::thrift::HandlerCallback<unique_ptr<ScmStatus>>> callback,
     unique_ptr<string> mountPoint,
@@ -2018,7 +2695,11 @@ EdenServiceHandler::future_getScmStatusBetweenRevisions(
   auto id2 = mount->getObjectStore()->parseRootId(*newHash);
   return wrapFuture(
       std::move(helper),
-      diffCommitsForStatus(mount->getObjectStore(), id1, id2));
+      diffCommitsForStatus(
+          mount->getObjectStore(),
+          id1,
+          id2,
+          server_->getServerState()->getTreeDiffCache()));
 }
 
 void EdenServiceHandler::debugGetScmTree(
@@ -2115,6 +2796,53 @@ void EdenServiceHandler::debugGetScmBlobMetadata(
 }
 
 namespace {
+/**
+ * Get the size of a materialized file from the overlay, or from the working
+ * copy on Windows.
+ */
+int64_t getMaterializedFileSize(
+    EdenMount& mount,
+    RelativePathPiece parentPath,
+    const ChildEntry& entry) {
+#ifndef _WIN32
+  (void)parentPath;
+  return mount.getOverlayFileAccess()->getFileSize(
+      entry.ino, entry.loadedChild.get());
+#else
+  // This following code ends up doing a stat in the working directory.
+  // This is safe to do as Windows works very differently from
+  // Linux/macOS when dealing with materialized files. In this code, we
+  // know that the file is materialized because we do not have a hash
+  // for it, and every materialized file is present on disk and
+  // reading/stating it is guaranteed to be done without EdenFS
+  // involvement. If somehow EdenFS is wrong, and this ends up
+  // triggering a recursive call into EdenFS, we are detecting this and
+  // simply bailing out very early in the callback.
+  auto filePath = mount.getPath() + parentPath + entry.name;
+  struct stat fileStat;
+  if (::stat(filePath.c_str(), &fileStat) == 0) {
+    return fileStat.st_size;
+  }
+  // Couldn't read the file, let's pretend it has a size of 0.
+  return 0;
+#endif
+}
+
+/**
+ * Whether a debugInodeStatus or debugInodeSummary traversal with the given
+ * flags should descend into the entry.
+ */
+bool shouldRecurseWithFlags(int64_t flags, const ChildEntry& entry) {
+  if ((flags & eden_constants::DIS_REQUIRE_LOADED_) && !entry.loadedChild) {
+    return false;
+  }
+  if ((flags & eden_constants::DIS_REQUIRE_MATERIALIZED_) &&
+      entry.hash.has_value()) {
+    return false;
+  }
+  return true;
+}
+
 class InodeStatusCallbacks : public TraversalCallbacks {
  public:
   explicit InodeStatusCallbacks(
@@ -2134,6 +2862,7 @@ class InodeStatusCallbacks : public TraversalCallbacks {
 #endif
 
     TreeInodeDebugInfo info;
+    std::vector<std::pair<size_t, ObjectId>> requestedSizes;
     info.inodeNumber_ref() = ino.get();
     info.path_ref() = path.stringPiece().str();
     info.materialized_ref() = !hash.has_value();
@@ -2174,50 +2903,28 @@ class InodeStatusCallbacks : public TraversalCallbacks {
           dtype_t::Dir != entry.dtype) {
         if (entry.hash.has_value()) {
           // schedule fetching size from ObjectStore::getBlobSize
-          requestedSizes_.push_back(RequestedSize{
-              results_.size(), info.entries_ref()->size(), entry.hash.value()});
+          requestedSizes.emplace_back(
+              info.entries_ref()->size(), entry.hash.value());
         } else {
-#ifndef _WIN32
           entryInfo.fileSize_ref() =
-              mount_->getOverlayFileAccess()->getFileSize(
-                  entry.ino, entry.loadedChild.get());
-#else
-          // This following code ends up doing a stat in the working directory.
-          // This is safe to do as Windows works very differently from
-          // Linux/macOS when dealing with materialized files. In this code, we
-          // know that the file is materialized because we do not have a hash
-          // for it, and every materialized file is present on disk and
-          // reading/stating it is guaranteed to be done without EdenFS
-          // involvement. If somehow EdenFS is wrong, and this ends up
-          // triggering a recursive call into EdenFS, we are detecting this and
-          // simply bailing out very early in the callback.
-          auto filePath = mount_->getPath() + path + entry.name;
-          struct stat fileStat;
-          if (::stat(filePath.c_str(), &fileStat) == 0) {
-            entryInfo.fileSize_ref() = fileStat.st_size;
-          } else {
-            // Couldn't read the file, let's pretend it has a size of 0.
-            entryInfo.fileSize_ref() = 0;
-          }
-#endif
+              getMaterializedFileSize(*mount_, path, entry);
         }
       }
 
       info.entries_ref()->push_back(entryInfo);
     }
 
+    // The traversal visits trees concurrently.
+    std::lock_guard<std::mutex> lock{mutex_};
+    for (auto& [entryIndex, blobHash] : requestedSizes) {
+      requestedSizes_.push_back(
+          RequestedSize{results_.size(), entryIndex, std::move(blobHash)});
+    }
     results_.push_back(std::move(info));
   }
 
   bool shouldRecurse(const ChildEntry& entry) override {
-    if ((flags_ & eden_constants::DIS_REQUIRE_LOADED_) && !entry.loadedChild) {
-      return false;
-    }
-    if ((flags_ & eden_constants::DIS_REQUIRE_MATERIALIZED_) &&
-        entry.hash.has_value()) {
-      return false;
-    }
-    return true;
+    return shouldRecurseWithFlags(flags_, entry);
   }
 
   void fillBlobSizes(ObjectFetchContext& fetchContext) {
@@ -2245,10 +2952,126 @@ class InodeStatusCallbacks : public TraversalCallbacks {
 
   EdenMount* mount_;
   int64_t flags_;
+  std::mutex mutex_;
   std::vector<TreeInodeDebugInfo>& results_;
   std::vector<RequestedSize> requestedSizes_;
 };
 
+class InodeSummaryCallbacks : public TraversalCallbacks {
+ public:
+  InodeSummaryCallbacks(
+      EdenMount* mount,
+      int64_t flags,
+      RelativePathPiece rootPath)
+      : mount_{mount}, flags_{flags}, rootPath_{rootPath} {
+    for (auto component : rootPath.components()) {
+      (void)component;
+      ++rootDepth_;
+    }
+  }
+
+  void visitTreeInode(
+      RelativePathPiece path,
+      InodeNumber /*ino*/,
+      const std::optional<ObjectId>& /*hash*/,
+      uint64_t /*fsRefcount*/,
+      const std::vector<ChildEntry>& entries) override {
+    Counts counts;
+    counts.trees = 1;
+    for (auto& entry : entries) {
+      if (entry.loadedChild) {
+        ++counts.loadedInodes;
+      }
+      if (dtype_t::Dir == entry.dtype) {
+        continue;
+      }
+      ++counts.files;
+      if (!entry.hash.has_value()) {
+        ++counts.materializedFiles;
+        counts.materializedBytes +=
+            getMaterializedFileSize(*mount_, path, entry);
+      }
+    }
+
+    auto child = getChildBelowRoot(path);
+    auto state = state_.wlock();
+    state->total += counts;
+    if (child.has_value()) {
+      state->children[PathComponent{*child}] += counts;
+    }
+  }
+
+  bool shouldRecurse(const ChildEntry& entry) override {
+    return shouldRecurseWithFlags(flags_, entry);
+  }
+
+  InodeSummary getSummary() const {
+    auto state = state_.rlock();
+    InodeSummary summary;
+    summary.total_ref() = state->total.toThrift(rootPath_);
+    summary.children_ref()->reserve(state->children.size());
+    for (const auto& [name, counts] : state->children) {
+      summary.children_ref()->push_back(counts.toThrift(rootPath_ + name));
+    }
+    return summary;
+  }
+
+ private:
+  struct Counts {
+    int64_t trees{0};
+    int64_t loadedInodes{0};
+    int64_t files{0};
+    int64_t materializedFiles{0};
+    int64_t materializedBytes{0};
+
+    Counts& operator+=(const Counts& other) {
+      trees += other.trees;
+      loadedInodes += other.loadedInodes;
+      files += other.files;
+      materializedFiles += other.materializedFiles;
+      materializedBytes += other.materializedBytes;
+      return *this;
+    }
+
+    InodeSubtreeSummary toThrift(RelativePathPiece path) const {
+      InodeSubtreeSummary result;
+      result.path_ref() = path.stringPiece().str();
+      result.treeCount_ref() = trees;
+      result.loadedInodeCount_ref() = loadedInodes;
+      result.fileCount_ref() = files;
+      result.materializedFileCount_ref() = materializedFiles;
+      result.materializedBytes_ref() = materializedBytes;
+      return result;
+    }
+  };
+
+  struct State {
+    Counts total;
+    std::map<PathComponent, Counts> children;
+  };
+
+  /**
+   * The directory immediately below the root that contains the given path, or
+   * nullopt for the root itself.
+   */
+  std::optional<PathComponentPiece> getChildBelowRoot(
+      RelativePathPiece path) const {
+    size_t depth = 0;
+    for (auto component : path.components()) {
+      if (depth++ == rootDepth_) {
+        return component;
+      }
+    }
+    return std::nullopt;
+  }
+
+  EdenMount* mount_;
+  int64_t flags_;
+  RelativePath rootPath_;
+  size_t rootDepth_{0};
+  folly::Synchronized<State> state_;
+};
+
 } // namespace
 
 void EdenServiceHandler::debugInodeStatus(
@@ -2276,12 +3099,54 @@ void EdenServiceHandler::debugInodeStatus(
         auto inodePath = inode->getPath().value();
 
         InodeStatusCallbacks callbacks{edenMount.get(), flags, inodeInfo};
-        traverseObservedInodes(*inode, inodePath, callbacks);
+        traverseObservedInodesParallel(
+            *inode,
+            inodePath,
+            callbacks,
+            folly::getKeepAliveToken(
+                server_->getServerState()->getBulkThreadPool().get()))
+            .get();
         callbacks.fillBlobSizes(helper->getFetchContext());
       })
       .get();
 }
 
+void EdenServiceHandler::debugInodeSummary(
+    InodeSummary& summary,
+    unique_ptr<string> mountPoint,
+    unique_ptr<std::string> path,
+    int64_t flags,
+    std::unique_ptr<SyncBehavior> sync) {
+  if (0 == flags) {
+    flags = eden_constants::DIS_REQUIRE_LOADED_;
+  }
+
+  auto syncTimeout = getSyncTimeout(*sync);
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      DBG2, *mountPoint, *path, flags, syncTimeout.count());
+  auto mountPath = AbsolutePathPiece{*mountPoint};
+  auto edenMount = server_->getMount(mountPath);
+
+  waitForPendingNotifications(*edenMount, syncTimeout)
+      .thenValue([&](auto&&) {
+        auto inode =
+            inodeFromUserPath(*edenMount, *path, helper->getFetchContext())
+                .asTreePtr();
+        auto inodePath = inode->getPath().value();
+
+        InodeSummaryCallbacks callbacks{edenMount.get(), flags, inodePath};
+        traverseObservedInodesParallel(
+            *inode,
+            inodePath,
+            callbacks,
+            folly::getKeepAliveToken(
+                server_->getServerState()->getBulkThreadPool().get()))
+            .get();
+        summary = callbacks.getSummary();
+      })
+      .get();
+}
+
 void EdenServiceHandler::debugOutstandingFuseCalls(
     FOLLY_MAYBE_UNUSED std::vector<FuseCall>& outstandingCalls,
     FOLLY_MAYBE_UNUSED std::unique_ptr<std::string> mountPoint) {
@@ -2418,6 +3283,33 @@ void EdenServiceHandler::debugListActivityRecordings(
   result.recordings_ref() = recordings;
 }
 
+folly::Future<std::unique_ptr<HostSelfTestResult>>
+EdenServiceHandler::future_debugHostSelfTest(
+    std::unique_ptr<HostSelfTestParams> params) {
+  const auto& mountPoint = *params->mountPoint_ref();
+  auto samples = *params->samples_ref();
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG1, mountPoint, samples);
+  auto edenMount = server_->getMount(AbsolutePathPiece{mountPoint});
+  if (samples < 0) {
+    throw newEdenError(
+        EINVAL,
+        EdenErrorType::ARGUMENT_ERROR,
+        "the number of samples cannot be negative");
+  }
+  size_t sampleCount = samples
+      ? std::min(static_cast<size_t>(samples), kMaxHostSelfTestSamples)
+      : kDefaultHostSelfTestSamples;
+  // The probes block for a while, so they don't run on a thrift thread.
+  return wrapFuture(
+      std::move(helper),
+      folly::via(
+          server_->getServerState()->getBulkThreadPool().get(),
+          [edenMount = std::move(edenMount), sampleCount] {
+            return std::make_unique<HostSelfTestResult>(
+                runHostSelfTest(*edenMount, sampleCount));
+          }));
+}
+
 void EdenServiceHandler::debugGetInodePath(
     InodePathDebugInfo& info,
     std::unique_ptr<std::string> mountPoint,
@@ -2499,7 +3391,8 @@ void EdenServiceHandler::getAccessCounts(
     auto& mountStr = mount->getPath().value();
     auto& pal = mount->getProcessAccessLog();
 
-    auto& pidFetches = mount->getObjectStore()->getPidFetches();
+    auto* objectStore = mount->getObjectStore();
+    auto& pidFetches = objectStore->getPidFetches();
 
     MountAccesses& ma = result.accessesByMount_ref()[mountStr];
     for (auto& [pid, accessCounts] : pal.getAccessCounts(seconds)) {
@@ -2509,6 +3402,13 @@ void EdenServiceHandler::getAccessCounts(
     for (auto& [pid, fetchCount] : *pidFetches.rlock()) {
       ma.fetchCountsByPid_ref()[pid] = fetchCount;
     }
+
+    for (auto& [pid, rates] : objectStore->getProcessFetchRates()) {
+      FetchRates& fetchRates = ma.fetchRatesByPid_ref()[pid];
+      fetchRates.requestsPerSecond_ref() = rates.requestsPerSecond;
+      fetchRates.bytesPerSecond_ref() = rates.bytesPerSecond;
+      fetchRates.deprioritized_ref() = objectStore->isFetchHeavy(rates);
+    }
   }
 }
 
@@ -2573,6 +3473,8 @@ void EdenServiceHandler::getStatInfo(
       mountInodeInfo.unloadedInodeCount_ref() = counts.unloadedInodeCount;
       mountInodeInfo.loadedFileCount_ref() = counts.fileCount;
       mountInodeInfo.loadedTreeCount_ref() = counts.treeCount;
+      mountInodeInfo.fileInodeSizeBytes_ref() = sizeof(FileInode);
+      mountInodeInfo.treeInodeSizeBytes_ref() = sizeof(TreeInode);
 
       JournalInfo journalThrift;
       if (auto journalStats = mount->getJournal().getStats()) {
@@ -2642,6 +3544,9 @@ void EdenServiceHandler::getStatInfo(
     result.blobCacheStats_ref()->evictionCount_ref() =
         blobCacheStats.evictionCount;
     result.blobCacheStats_ref()->dropCount_ref() = blobCacheStats.dropCount;
+    result.blobCacheStats_ref()->insertCount_ref() = blobCacheStats.insertCount;
+    result.blobCacheStats_ref()->admissionRejectCount_ref() =
+        blobCacheStats.admissionRejectCount;
 
     const auto treeCacheStats = server_->getTreeCache()->getStats();
     result.treeCacheStats_ref() = CacheStats{};
@@ -2652,6 +3557,53 @@ void EdenServiceHandler::getStatInfo(
     result.treeCacheStats_ref()->missCount_ref() = treeCacheStats.missCount;
     result.treeCacheStats_ref()->evictionCount_ref() =
         treeCacheStats.evictionCount;
+    result.treeCacheStats_ref()->insertCount_ref() = treeCacheStats.insertCount;
+
+    const auto governorStats = server_->getMemoryGovernorStats();
+    MemoryGovernorStats governorThrift;
+    governorThrift.cacheScale_ref() = governorStats.scale;
+    switch (governorStats.lastDecision) {
+      case MemoryGovernor::Decision::Keep:
+        governorThrift.lastDecision_ref() = MemoryGovernorDecision::KEEP;
+        break;
+      case MemoryGovernor::Decision::Shrink:
+        governorThrift.lastDecision_ref() = MemoryGovernorDecision::SHRINK;
+        break;
+      case MemoryGovernor::Decision::Grow:
+        governorThrift.lastDecision_ref() = MemoryGovernorDecision::GROW;
+        break;
+    }
+    governorThrift.shrinkCount_ref() = governorStats.shrinkCount;
+    governorThrift.growCount_ref() = governorStats.growCount;
+    if (governorStats.lastPressure.stallPercent) {
+      governorThrift.stallPercent_ref() =
+          *governorStats.lastPressure.stallPercent;
+    }
+    if (governorStats.lastPressure.cgroupUsageRatio) {
+      governorThrift.cgroupUsageRatio_ref() =
+          *governorStats.lastPressure.cgroupUsageRatio;
+    }
+    governorThrift.blobCacheMaximumSize_ref() =
+        server_->getBlobCache()->getMaximumSize();
+    governorThrift.treeCacheMaximumSize_ref() =
+        server_->getTreeCache()->getMaximumSize();
+    result.memoryGovernorStats_ref() = std::move(governorThrift);
+  }
+
+  if (statsMask & eden_constants::STATS_HG_IMPORT_CLIENTS_) {
+    std::map<pid_t, HgImportClientStats> clients;
+    for (const auto& store : server_->getHgQueuedBackingStores()) {
+      for (const auto& [pid, stats] : store->getImportClientStats()) {
+        auto& client = clients[pid];
+        client.queuedTrees_ref() =
+            *client.queuedTrees_ref() + stats.queuedTrees;
+        client.queuedBlobs_ref() =
+            *client.queuedBlobs_ref() + stats.queuedBlobs;
+        client.queuedBlobMetadata_ref() =
+            *client.queuedBlobMetadata_ref() + stats.queuedBlobMetadata;
+      }
+    }
+    result.hgImportClients_ref() = std::move(clients);
   }
 }
 
@@ -2747,6 +3699,10 @@ void EdenServiceHandler::getTracePoints(std::vector<TracePoint>& result) {
   }
 }
 
+void EdenServiceHandler::getChromeTrace(std::string& result) {
+  result = renderChromeTrace(getRecentTracepoints(), getRecentTraceSpans());
+}
+
 namespace {
 std::optional<folly::exception_wrapper> getFaultError(
     apache::thrift::optional_field_ref<std::string&> errorType,
@@ -2785,6 +3741,39 @@ void EdenServiceHandler::injectFault(unique_ptr<FaultDefinition> fault) {
     return;
   }
 
+  if (fault->latency_ref().has_value()) {
+    const auto& latency = *fault->latency_ref();
+    using Distribution = FaultInjector::LatencyProfile::Distribution;
+    FaultInjector::LatencyProfile profile;
+    switch (*latency.distribution_ref()) {
+      case LatencyDistribution::CONSTANT:
+        profile.distribution = Distribution::Constant;
+        break;
+      case LatencyDistribution::LOG_NORMAL:
+        profile.distribution = Distribution::LogNormal;
+        break;
+      case LatencyDistribution::TAIL_SPIKES:
+        profile.distribution = Distribution::TailSpikes;
+        break;
+      default:
+        throw newEdenError(
+            EINVAL,
+            EdenErrorType::ARGUMENT_ERROR,
+            "unknown latency distribution");
+    }
+    profile.latency =
+        std::chrono::microseconds{*latency.latencyMicroseconds_ref()};
+    profile.sigma = *latency.sigma_ref();
+    profile.spikeProbability = *latency.spikeProbability_ref();
+    profile.spike = std::chrono::microseconds{*latency.spikeMicroseconds_ref()};
+    injector.injectLatency(
+        *fault->keyClass_ref(),
+        *fault->keyValueRegex_ref(),
+        profile,
+        *fault->count_ref());
+    return;
+  }
+
   auto error = getFaultError(fault->errorType_ref(), fault->errorMessage_ref());
   std::chrono::milliseconds delay(*fault->delayMilliseconds_ref());
   if (error.has_value()) {
@@ -2928,5 +3917,36 @@ std::optional<pid_t> EdenServiceHandler::getAndRegisterClientPid() {
 #endif
 }
 
+std::optional<ClientRequestLimiter::Token>
+EdenServiceHandler::acquireClientRequest(
+    std::optional<pid_t> pid,
+    folly::StringPiece functionName) {
+  // The methods annotated with priority = 'HIGH' in eden.thrift. They are
+  // cheap and run on their own workers, so they can't starve anyone, and they
+  // are how tools check on a daemon that is busy with a client's requests.
+  static const std::unordered_set<folly::StringPiece> kUnlimitedFunctions{
+      "listMounts", "getCurrentJournalPosition", "getDaemonInfo"};
+  if (!pid || kUnlimitedFunctions.count(functionName)) {
+    return std::nullopt;
+  }
+  auto limit = server_->getServerState()
+                   ->getEdenConfig()
+                   ->thriftMaxRequestsPerClient.getValue();
+  auto token = clientRequestLimiter_->tryAcquire(*pid, limit);
+  if (!token) {
+    throw newEdenError(
+        EBUSY,
+        EdenErrorType::POSIX_ERROR,
+        "rejecting ",
+        functionName,
+        "(): process ",
+        *pid,
+        " already has ",
+        limit,
+        " outstanding requests");
+  }
+  return token;
+}
+
 } // namespace eden
 } // namespace facebook
@@ -10,12 +10,17 @@
 #include <fb303/BaseService.h>
 #include <optional>
 #include "eden/fs/eden-config.h"
+#include "eden/fs/inodes/GlobResultCache.h"
+#include "eden/fs/inodes/InodePtrFwd.h"
+#include "eden/fs/service/ClientRequestLimiter.h"
 #include "eden/fs/service/gen-cpp2/StreamingEdenService.h"
 #include "eden/fs/utils/PathFuncs.h"
 
 namespace folly {
 template <typename T>
 class Future;
+template <typename T>
+class Try;
 }
 
 namespace facebook {
@@ -95,6 +100,18 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
       folly::StringPiece path,
       ObjectFetchContext& fetchContext);
 
+  /**
+   * Get the metadata of several files, with one result per path in the same
+   * order. The paths are resolved together, each directory being looked up
+   * once, and the lookups of the files that aren't materialized are batched
+   * through ObjectStore::getBlobMetadataBatch().
+   */
+  ImmediateFuture<std::vector<folly::Try<BlobMetadata>>>
+  getBlobMetadataForPaths(
+      AbsolutePathPiece mountPoint,
+      const std::vector<std::string>& paths,
+      ObjectFetchContext& fetchContext);
+
   void getCurrentJournalPosition(
       JournalPosition& out,
       std::unique_ptr<std::string> mountPoint) override;
@@ -104,6 +121,10 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
       std::unique_ptr<std::string> mountPoint,
       std::unique_ptr<JournalPosition> fromPosition) override;
 
+  void getFilesChangedSinceForRoots(
+      FileDelta& out,
+      std::unique_ptr<GetFilesChangedSinceParams> params) override;
+
   void setJournalMemoryLimit(
       std::unique_ptr<PathString> mountPoint,
       int64_t limit) override;
@@ -133,6 +154,10 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
   semifuture_getAttributesFromFiles(
       std::unique_ptr<GetAttributesFromFilesParams> params) override;
 
+  folly::SemiFuture<std::unique_ptr<GetAttributesFromFilesResult>>
+  semifuture_getAttributesFromFilesBatch(
+      std::unique_ptr<GetAttributesFromFilesBatchParams> params) override;
+
   folly::Future<std::unique_ptr<Glob>> future_globFiles(
       std::unique_ptr<GlobParams> params) override;
 
@@ -147,6 +172,9 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
   apache::thrift::ServerStream<JournalPosition> subscribeStreamTemporary(
       std::unique_ptr<std::string> mountPoint) override;
 
+  apache::thrift::ServerStream<JournalPosition> subscribeStreamForRoots(
+      std::unique_ptr<SubscribeStreamParams> params) override;
+
   apache::thrift::ServerStream<FsEvent> traceFsEvents(
       std::unique_ptr<std::string> mountPoint,
       int64_t eventCategoryMask) override;
@@ -154,6 +182,15 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
   apache::thrift::ServerStream<HgEvent> traceHgEvents(
       std::unique_ptr<std::string> mountPoint) override;
 
+  apache::thrift::ServerStream<Glob> streamGlobFiles(
+      std::unique_ptr<StreamGlobFilesParams> params) override;
+
+  apache::thrift::ServerStream<ScmStatus> streamScmStatus(
+      std::unique_ptr<StreamScmStatusParams> params) override;
+
+  apache::thrift::ServerStream<FileDelta> streamFilesChangedSince(
+      std::unique_ptr<StreamFilesChangedSinceParams> params) override;
+
   void async_tm_getScmStatusV2(
       std::unique_ptr<apache::thrift::HandlerCallback<
           std::unique_ptr<GetScmStatusResult>>> callback,
@@ -196,6 +233,13 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
       int64_t flags,
       std::unique_ptr<SyncBehavior> sync) override;
 
+  void debugInodeSummary(
+      InodeSummary& summary,
+      std::unique_ptr<std::string> mountPoint,
+      std::unique_ptr<std::string> path,
+      int64_t flags,
+      std::unique_ptr<SyncBehavior> sync) override;
+
   void debugOutstandingFuseCalls(
       std::vector<FuseCall>& outstandingCalls,
       std::unique_ptr<std::string> mountPoint) override;
@@ -222,6 +266,9 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
       ListActivityRecordingsResult& result,
       std::unique_ptr<std::string> mountPoint) override;
 
+  folly::Future<std::unique_ptr<HostSelfTestResult>> future_debugHostSelfTest(
+      std::unique_ptr<HostSelfTestParams> params) override;
+
   void debugGetInodePath(
       InodePathDebugInfo& inodePath,
       std::unique_ptr<std::string> mountPoint,
@@ -258,6 +305,7 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
   void enableTracing() override;
   void disableTracing() override;
   void getTracePoints(std::vector<TracePoint>& result) override;
+  void getChromeTrace(std::string& result) override;
 
   void injectFault(std::unique_ptr<FaultDefinition> fault) override;
   bool removeFault(std::unique_ptr<RemoveFaultArg> fault) override;
@@ -312,15 +360,22 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
   std::optional<pid_t> getAndRegisterClientPid();
 
  private:
-  ImmediateFuture<Hash20> getSHA1ForPath(
-      AbsolutePathPiece mountPoint,
-      folly::StringPiece path,
-      ObjectFetchContext& fetchContext);
+  /**
+   * Count a request from pid against thrift:max-requests-per-client, throwing
+   * an EdenError if pid already has that many requests outstanding. The
+   * HIGH-priority methods are exempt.
+   */
+  std::optional<ClientRequestLimiter::Token> acquireClientRequest(
+      std::optional<pid_t> pid,
+      folly::StringPiece functionName);
 
-  ImmediateFuture<Hash20> getSHA1ForPathDefensively(
+  /**
+   * Load the inode at path, failing if it isn't a regular file.
+   */
+  ImmediateFuture<FileInodePtr> getRegularFileInodeForPath(
       AbsolutePathPiece mountPoint,
       folly::StringPiece path,
-      ObjectFetchContext& fetchContext) noexcept;
+      ObjectFetchContext& fetchContext);
 
   struct GlobOptions {
     explicit GlobOptions(const GlobParams& params);
@@ -333,6 +388,18 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
     bool listOnlyFiles;
   };
 
+  /**
+   * Glob the files of the directories whose files the backing store of the
+   * mount had to fetch the most, as recorded by
+   * BackingStore::getMostFetchedDirectories(), with the options of params.
+   * The user, repo and os of params.predictiveGlob are ignored: the history
+   * is that of this user, and of the repository of the mount.
+   */
+  folly::Future<std::unique_ptr<Glob>> globMostFetchedDirectories(
+      const GlobParams& params,
+      folly::StringPiece caller,
+      std::optional<pid_t> pid);
+
   folly::Future<std::unique_ptr<Glob>> globFilesImpl(
       folly::StringPiece mountPoint,
       std::vector<std::string> globs,
@@ -349,6 +416,12 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
 #endif
   const std::vector<std::string> originalCommandLine_;
   EdenServer* const server_;
+  /**
+   * Results of recent globs against commits, see globFilesImpl.
+   */
+  GlobResultCache globResultCache_;
+  std::shared_ptr<ClientRequestLimiter> clientRequestLimiter_{
+      std::make_shared<ClientRequestLimiter>()};
 };
 } // namespace eden
 } // namespace facebook
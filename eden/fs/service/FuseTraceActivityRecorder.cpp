@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/service/FuseTraceActivityRecorder.h"
+
+#include <fmt/format.h>
+#include <folly/logging/xlog.h>
+#include <chrono>
+
+#include "eden/fs/fuse/FuseChannel.h"
+#include "eden/fs/fuse/FuseTraceRecorder.h"
+#include "eden/fs/inodes/EdenMount.h"
+
+namespace facebook::eden {
+
+FuseTraceActivityRecorder::FuseTraceActivityRecorder(
+    std::shared_ptr<EdenMount> edenMount)
+    : IActivityRecorder{std::move(edenMount)} {}
+
+FuseTraceActivityRecorder::~FuseTraceActivityRecorder() = default;
+
+uint64_t FuseTraceActivityRecorder::addSubscriber(
+    AbsolutePathPiece outputDir) {
+  auto* channel = edenMount_->getFuseChannel();
+  if (!channel) {
+    XLOG(ERR) << "can't record the activity of " << edenMount_->getPath()
+              << ": it has no FUSE channel";
+    return 0;
+  }
+
+  auto recordings = recordings_.wlock();
+  // Like the other activity recorders, identify recordings by their start
+  // time, in seconds.
+  uint64_t unique = std::chrono::duration_cast<std::chrono::seconds>(
+                        std::chrono::system_clock::now().time_since_epoch())
+                        .count();
+  while (recordings->count(unique)) {
+    ++unique;
+  }
+
+  auto outputPath =
+      outputDir + PathComponent{fmt::format("fuse-trace-{}.bin", unique)};
+  try {
+    recordings->emplace(
+        unique, std::make_unique<FuseTraceRecorder>(*channel, outputPath));
+  } catch (const std::exception& ex) {
+    XLOG(ERR) << "error starting the recording of " << edenMount_->getPath()
+              << " into " << outputPath << ": " << folly::exceptionStr(ex);
+    return 0;
+  }
+  return unique;
+}
+
+std::optional<std::string> FuseTraceActivityRecorder::removeSubscriber(
+    uint64_t unique) {
+  std::unique_ptr<FuseTraceRecorder> recorder;
+  {
+    auto recordings = recordings_.wlock();
+    auto it = recordings->find(unique);
+    if (it == recordings->end()) {
+      return std::nullopt;
+    }
+    recorder = std::move(it->second);
+    recordings->erase(it);
+  }
+
+  // Only return the path once the whole recording is in the file.
+  try {
+    recorder->stop().get();
+  } catch (const std::exception& ex) {
+    XLOG(ERR) << "error finishing the recording into "
+              << recorder->getOutputPath() << ": " << folly::exceptionStr(ex);
+    return std::nullopt;
+  }
+  return recorder->getOutputPath().value();
+}
+
+std::vector<std::tuple<uint64_t, std::string>>
+FuseTraceActivityRecorder::getSubscribers() {
+  std::vector<std::tuple<uint64_t, std::string>> subscribers;
+  auto recordings = recordings_.rlock();
+  for (const auto& [unique, recorder] : *recordings) {
+    subscribers.emplace_back(unique, recorder->getOutputPath().value());
+  }
+  return subscribers;
+}
+
+} // namespace facebook::eden
+
+#endif
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <map>
+#include <memory>
+
+#include "eden/fs/telemetry/IActivityRecorder.h"
+
+namespace facebook::eden {
+
+class FuseTraceRecorder;
+
+/**
+ * An activity recorder writing, for each subscriber, a FuseTraceRecorder
+ * recording of the requests of the mount's FUSE channel into a
+ * fuse-trace-<unique>.bin file of the subscriber's output directory.
+ *
+ * Mounts without a FUSE channel can't be recorded: addSubscriber() returns
+ * 0 for them.
+ */
+class FuseTraceActivityRecorder : public IActivityRecorder {
+ public:
+  explicit FuseTraceActivityRecorder(std::shared_ptr<EdenMount> edenMount);
+  ~FuseTraceActivityRecorder() override;
+
+  uint64_t addSubscriber(AbsolutePathPiece outputDir) override;
+  std::optional<std::string> removeSubscriber(uint64_t unique) override;
+  std::vector<std::tuple<uint64_t, std::string>> getSubscribers() override;
+
+ private:
+  folly::Synchronized<std::map<uint64_t, std::unique_ptr<FuseTraceRecorder>>>
+      recordings_;
+};
+
+} // namespace facebook::eden
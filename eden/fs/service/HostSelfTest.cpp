@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/service/HostSelfTest.h"
+
+#include <fmt/format.h>
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <folly/logging/xlog.h>
+#include <folly/portability/Fcntl.h>
+#include <folly/portability/SysStat.h>
+#include <folly/portability/Unistd.h>
+#include <folly/stop_watch.h>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/utsname.h>
+#include "eden/fs/fuse/FuseChannel.h"
+#endif
+
+#include "eden/fs/config/CheckoutConfig.h"
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/BackingStore.h"
+#include "eden/fs/store/KeySpace.h"
+#include "eden/fs/store/LocalStore.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/store/StoreResult.h"
+
+namespace facebook::eden {
+
+namespace {
+
+using namespace folly::string_piece_literals;
+
+constexpr size_t kHashedBytes = 1024 * 1024;
+constexpr size_t kWrittenBytes = 4096;
+constexpr auto kFetchTimeout = std::chrono::seconds{30};
+
+constexpr auto kLocalStoreKey = "eden-self-test"_sp;
+
+/** Names looked up in the mount, never twice, to defeat the kernel cache. */
+std::atomic<uint64_t> lookupCounter{0};
+
+using Sample = std::function<void()>;
+
+/**
+ * Call sample the given number of times and summarize its latencies. A probe
+ * that throws is reported with the error.
+ */
+HostSelfTestProbe runProbe(
+    std::string name,
+    size_t samples,
+    const std::function<Sample()>& setUp) {
+  HostSelfTestProbe probe;
+  probe.name_ref() = std::move(name);
+  try {
+    auto sample = setUp();
+    std::vector<int64_t> latencies;
+    latencies.reserve(samples);
+    for (size_t i = 0; i < samples; ++i) {
+      folly::stop_watch<std::chrono::microseconds> timer;
+      sample();
+      latencies.push_back(timer.elapsed().count());
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto at = [&](double p) {
+      return latencies.empty()
+          ? 0
+          : latencies[std::min(
+                latencies.size() - 1,
+                static_cast<size_t>(p * (latencies.size() - 1) + 0.5))];
+    };
+    probe.samples_ref() = latencies.size();
+    probe.p50Micros_ref() = at(0.5);
+    probe.p99Micros_ref() = at(0.99);
+    probe.maxMicros_ref() = at(1.0);
+  } catch (const std::exception& ex) {
+    probe.error_ref() = folly::exceptionStr(ex).toStdString();
+  }
+  return probe;
+}
+
+std::map<std::string, std::string> describeHost(
+    FOLLY_MAYBE_UNUSED EdenMount& mount) {
+  std::map<std::string, std::string> host;
+#ifndef _WIN32
+  struct utsname name;
+  if (uname(&name) == 0) {
+    host["kernel"] = fmt::format("{} {}", name.sysname, name.release);
+  }
+  if (auto* fuseChannel = mount.getFuseChannel()) {
+    if (const auto& connInfo = fuseChannel->getConnInfo()) {
+      host["fuse_protocol"] =
+          fmt::format("{}.{}", connInfo->major, connInfo->minor);
+    }
+  }
+#endif
+#ifdef __linux__
+  // A current frequency well below the maximum one hints at throttling.
+  for (auto [key, file] :
+       {std::pair{"cpu0_khz", "scaling_cur_freq"},
+        std::pair{"cpu0_max_khz", "cpuinfo_max_freq"}}) {
+    std::string value;
+    if (folly::readFile(
+            fmt::format("/sys/devices/system/cpu/cpu0/cpufreq/{}", file)
+                .c_str(),
+            value)) {
+      host[key] = folly::trimWhitespace(value).str();
+    }
+  }
+#endif
+  return host;
+}
+
+} // namespace
+
+HostSelfTestResult runHostSelfTest(EdenMount& mount, size_t samples) {
+  std::vector<HostSelfTestProbe> probes;
+
+  probes.push_back(runProbe("cpu_sha1_1mib", samples, [] {
+    auto data = std::make_shared<std::string>(kHashedBytes, 'x');
+    // Keeps the hashes used.
+    auto sink = std::make_shared<uint8_t>(0);
+    return [data, sink] { *sink ^= Hash20::sha1(*data).getBytes()[0]; };
+  }));
+
+  auto localStore = mount.getObjectStore()->getLocalStore();
+  probes.push_back(runProbe("local_store_read", samples, [&] {
+    localStore->put(
+        KeySpace::SelfTestFamily,
+        folly::ByteRange{kLocalStoreKey},
+        folly::ByteRange{"self-test"_sp});
+    return [localStore] {
+      auto result = localStore->get(
+          KeySpace::SelfTestFamily, folly::ByteRange{kLocalStoreKey});
+      if (!result.isValid()) {
+        throw std::runtime_error("the value just stored isn't found");
+      }
+    };
+  }));
+  try {
+    localStore->clearKeySpace(KeySpace::SelfTestFamily);
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "Failed to clear the self-test key space: "
+               << folly::exceptionStr(ex);
+  }
+
+  probes.push_back(runProbe("state_dir_write_fsync", samples, [&] {
+    // Next to the overlay, on the same filesystem, without touching it.
+    auto path = mount.getCheckoutConfig()->getClientDirectory() +
+        "self-test.tmp"_pc;
+    auto file = std::make_shared<folly::File>(
+        path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    // Where open files can't be removed, as on Windows, it's reused by the
+    // next run instead.
+    unlink(path.c_str());
+    auto data = std::make_shared<std::string>(kWrittenBytes, 'x');
+    return [file, data] {
+      if (folly::pwriteFull(file->fd(), data->data(), data->size(), 0) < 0) {
+        folly::throwSystemError("write failed");
+      }
+      if (folly::fsyncNoInt(file->fd()) < 0) {
+        folly::throwSystemError("fsync failed");
+      }
+    };
+  }));
+
+#ifndef _WIN32
+  probes.push_back(runProbe("mount_lookup", samples, [&] {
+    auto mountPath = mount.getPath();
+    return [mountPath] {
+      // The kernel caches negative lookups, so every name must be new to
+      // reach the daemon.
+      auto path = mountPath +
+          PathComponent{fmt::format(
+              ".eden-self-test-{}", lookupCounter.fetch_add(1))};
+      struct stat st;
+      if (lstat(path.c_str(), &st) == 0 || errno != ENOENT) {
+        folly::throwSystemError(
+            "lookup of ", path.c_str(), " didn't fail with ENOENT");
+      }
+    };
+  }));
+#endif
+
+  probes.push_back(runProbe("backing_store_root_tree", samples, [&] {
+    auto backingStore = mount.getObjectStore()->getBackingStore();
+    auto rootId = mount.getParentCommit();
+    return [backingStore, rootId] {
+      backingStore->getRootTree(rootId, ObjectFetchContext::getNullContext())
+          .get(kFetchTimeout);
+    };
+  }));
+
+  HostSelfTestResult result;
+  result.probes_ref() = std::move(probes);
+  result.host_ref() = describeHost(mount);
+  return result;
+}
+
+} // namespace facebook::eden
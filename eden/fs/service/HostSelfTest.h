@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "eden/fs/service/gen-cpp2/eden_types.h"
+
+namespace facebook::eden {
+
+class EdenMount;
+
+/** How many times each probe runs when the caller doesn't say. */
+constexpr size_t kDefaultHostSelfTestSamples = 20;
+
+/** The most times each probe runs, whatever the caller says. */
+constexpr size_t kMaxHostSelfTestSamples = 1000;
+
+/**
+ * Run every probe of debugHostSelfTest() against mount, samples times each,
+ * on the calling thread, which may block for a while.
+ *
+ * Each probe is short and of a fixed size, so that reports of different hosts
+ * are comparable: the time to hash 1MiB, to read a small value back from the
+ * LocalStore, to write and fsync 4KiB in the checkout's state directory, to
+ * look up a missing name at the root of the mount through the kernel (except
+ * on Windows), and to fetch the root tree of the working copy parent from the
+ * backing store, bypassing the LocalStore.
+ *
+ * A failing probe is reported with its error. It doesn't stop the others.
+ */
+HostSelfTestResult runHostSelfTest(EdenMount& mount, size_t samples);
+
+} // namespace facebook::eden
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/service/MemoryGovernor.h"
+
+#include <algorithm>
+
+namespace facebook::eden {
+
+MemoryGovernor::Decision MemoryGovernor::update(
+    const MemoryPressure& pressure,
+    const Thresholds& thresholds) {
+  stats_.lastPressure = pressure;
+
+  auto minimumScale = std::clamp(thresholds.minimumScale, 0.0, 1.0);
+  bool high = (pressure.stallPercent &&
+               *pressure.stallPercent >= thresholds.highStallPercent) ||
+      (pressure.cgroupUsageRatio &&
+       *pressure.cgroupUsageRatio >= thresholds.highCgroupUsageRatio);
+  // Without any reading, keep things as they are.
+  bool low = (pressure.stallPercent || pressure.cgroupUsageRatio) &&
+      (!pressure.stallPercent ||
+       *pressure.stallPercent < thresholds.lowStallPercent) &&
+      (!pressure.cgroupUsageRatio ||
+       *pressure.cgroupUsageRatio < thresholds.lowCgroupUsageRatio);
+
+  auto decision = Decision::Keep;
+  if (high && stats_.scale > minimumScale) {
+    stats_.scale = std::max(stats_.scale / 2, minimumScale);
+    ++stats_.shrinkCount;
+    decision = Decision::Shrink;
+  } else if (low && stats_.scale < 1.0) {
+    stats_.scale = std::min(stats_.scale * 2, 1.0);
+    ++stats_.growCount;
+    decision = Decision::Grow;
+  } else if (stats_.scale < minimumScale) {
+    // The minimum was raised since the last shrink.
+    stats_.scale = minimumScale;
+    ++stats_.growCount;
+    decision = Decision::Grow;
+  }
+  stats_.lastDecision = decision;
+  return decision;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "eden/fs/utils/Memory.h"
+
+namespace facebook::eden {
+
+/**
+ * Decides which fraction of their configured size EdenFS' in-memory caches
+ * and journals may use, from periodic MemoryPressure readings.
+ *
+ * Every reading above one of the high thresholds halves the scale, down to
+ * the minimum scale, and every reading below all the low thresholds doubles
+ * it, up to 1. Readings in between leave it alone, so that the caches don't
+ * oscillate around a single threshold.
+ *
+ * Not thread safe.
+ */
+class MemoryGovernor {
+ public:
+  struct Thresholds {
+    double highStallPercent;
+    double lowStallPercent;
+    double highCgroupUsageRatio;
+    double lowCgroupUsageRatio;
+    double minimumScale;
+  };
+
+  enum class Decision {
+    Keep,
+    Shrink,
+    Grow,
+  };
+
+  struct Stats {
+    double scale = 1.0;
+    Decision lastDecision = Decision::Keep;
+    MemoryPressure lastPressure;
+    uint64_t shrinkCount = 0;
+    uint64_t growCount = 0;
+  };
+
+  /**
+   * Record a new reading and return how it changed the scale.
+   */
+  Decision update(const MemoryPressure& pressure, const Thresholds& thresholds);
+
+  double getScale() const {
+    return stats_.scale;
+  }
+
+  const Stats& getStats() const {
+    return stats_;
+  }
+
+ private:
+  Stats stats_;
+};
+
+} // namespace facebook::eden
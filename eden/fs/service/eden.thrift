@@ -329,6 +329,25 @@ struct GetAttributesFromFilesResult {
   1: list<FileAttributeDataOrError> res;
 }
 
+/**
+ * One file of a getAttributesFromFilesBatch() request.
+ */
+struct FileAttributesRequest {
+  1: PathString mountPoint;
+  2: PathString path;
+  3: unsigned64 requestedAttributes;
+}
+
+/**
+ * Parameters for the getAttributesFromFilesBatch() function. The requests may
+ * target any number of mounts, each of which is synchronized once according
+ * to sync.
+ */
+struct GetAttributesFromFilesBatchParams {
+  1: list<FileAttributesRequest> requests;
+  2: SyncBehavior sync;
+}
+
 /** reference a point in time in the journal.
  * This can be used to reason about a point in time in a given mount point.
  * The mountGeneration value is opaque to the client.
@@ -403,6 +422,16 @@ struct FileDelta {
   7: list<ThriftRootId> snapshotTransitions;
 }
 
+struct GetFilesChangedSinceParams {
+  1: PathString mountPoint;
+  2: JournalPosition fromPosition;
+  /**
+   * Paths relative to the mount. Only changes to these paths and to anything
+   * below them are reported. An empty list reports the whole mount.
+   */
+  3: list<PathString> roots;
+}
+
 struct DebugGetRawJournalParams {
   1: PathString mountPoint;
   2: optional i32 limit;
@@ -635,6 +664,30 @@ struct TreeInodeDebugInfo {
   6: i64 refcount;
 }
 
+/**
+ * Aggregated counts for the inodes of a subtree, returned by
+ * debugInodeSummary.
+ */
+struct InodeSubtreeSummary {
+  1: PathString path;
+  // The number of trees visited, whether loaded or only allocated in the
+  // overlay.
+  2: i64 treeCount;
+  // The number of inodes below the trees that are loaded in memory.
+  3: i64 loadedInodeCount;
+  4: i64 fileCount;
+  5: i64 materializedFileCount;
+  // The total size of the materialized files.
+  6: i64 materializedBytes;
+}
+
+struct InodeSummary {
+  1: InodeSubtreeSummary total;
+  // One entry for each visited directory immediately below the requested
+  // path, which the total also includes.
+  2: list<InodeSubtreeSummary> children;
+}
+
 struct InodePathDebugInfo {
   1: PathString path;
   2: bool loaded;
@@ -653,6 +706,32 @@ struct ListActivityRecordingsResult {
   1: list<ActivityRecorderResult> recordings;
 }
 
+/**
+ * The latencies of one probe of debugHostSelfTest(), in microseconds.
+ */
+struct HostSelfTestProbe {
+  1: string name;
+  2: i64 samples;
+  3: i64 p50Micros;
+  4: i64 p99Micros;
+  5: i64 maxMicros;
+  // Set if the probe failed, in which case the latencies are not.
+  6: optional string error;
+}
+
+struct HostSelfTestParams {
+  1: PathString mountPoint;
+  // How many times each probe runs, at most 1000. 0 selects the default.
+  2: i32 samples;
+}
+
+struct HostSelfTestResult {
+  1: list<HostSelfTestProbe> probes;
+  // Facts about the host that the probes depend on, such as the kernel
+  // release and the negotiated FUSE protocol version.
+  2: map<string, string> host;
+}
+
 struct SetLogLevelResult {
   1: bool categoryCreated;
 }
@@ -672,6 +751,10 @@ struct MountInodeInfo {
   2: i64 unloadedInodeCount;
   4: i64 loadedFileCount;
   5: i64 loadedTreeCount;
+  // The in-memory size of one loaded FileInode and TreeInode object, not
+  // counting what they allocate on the heap, such as directory entries.
+  6: i64 fileInodeSizeBytes;
+  7: i64 treeInodeSizeBytes;
 }
 
 struct CacheStats {
@@ -681,6 +764,40 @@ struct CacheStats {
   4: i64 missCount;
   5: i64 evictionCount;
   6: i64 dropCount;
+  7: i64 insertCount;
+  8: i64 admissionRejectCount;
+}
+
+enum MemoryGovernorDecision {
+  KEEP = 0,
+  SHRINK = 1,
+  GROW = 2,
+}
+
+/*
+ * How EdenFS resized its in-memory caches in response to memory pressure.
+ */
+struct MemoryGovernorStats {
+  // Fraction of their configured size the caches and journals may use.
+  1: double cacheScale;
+  2: MemoryGovernorDecision lastDecision;
+  3: i64 shrinkCount;
+  4: i64 growCount;
+  // The latest readings, unset when not available on this platform.
+  5: optional double stallPercent;
+  6: optional double cgroupUsageRatio;
+  7: i64 blobCacheMaximumSize;
+  8: i64 treeCacheMaximumSize;
+}
+
+/*
+ * The hg imports queued on behalf of one process. Each process gets an equal
+ * share of the import threads among the imports of the same priority.
+ */
+struct HgImportClientStats {
+  1: i64 queuedTrees;
+  2: i64 queuedBlobs;
+  3: i64 queuedBlobMetadata;
 }
 
 /*
@@ -692,6 +809,7 @@ const i64 STATS_SMAPS = 0x4;
 const i64 STATS_PRIVATE_BYTES = 0x8;
 const i64 STATS_RSS_BYTES = 0x10;
 const i64 STATS_CACHE_STATS = 0x20;
+const i64 STATS_HG_IMPORT_CLIENTS = 0x40;
 const i64 STATS_ALL = 0xFFFF;
 
 /**
@@ -750,6 +868,17 @@ struct InternalStats {
    * Populated if STATS_CACHE_STATS is set.
    */
   9: optional CacheStats treeCacheStats;
+  /**
+   * The memory pressure based resizing of the caches.
+   * Populated if STATS_CACHE_STATS is set.
+   */
+  10: optional MemoryGovernorStats memoryGovernorStats;
+  /**
+   * The queued hg imports of each client pid, summed over all the
+   * repositories. Imports without a known client are under pid 0.
+   * Populated if STATS_HG_IMPORT_CLIENTS is set.
+   */
+  11: optional map<pid_t, HgImportClientStats> hgImportClients;
 }
 
 struct FuseCall {
@@ -923,11 +1052,28 @@ struct AccessCounts {
   5: i64 fsChannelDurationNs;
   6: i64 fsChannelMemoryCacheImports;
   7: i64 fsChannelDiskCacheImports;
+  /**
+   * CPU time spent by the channel threads handling the requests, excluding
+   * imports and other work done asynchronously.
+   */
+  8: i64 fsChannelCpuTimeNs;
+  9: i64 fsChannelBackingStoreBytes;
+}
+
+/**
+ * The recent fetch rates of a process, averaged over store:fetch-rate-window.
+ */
+struct FetchRates {
+  1: double requestsPerSecond;
+  2: double bytesPerSecond;
+  /** Whether the fetches of this process are currently deprioritized. */
+  3: bool deprioritized;
 }
 
 struct MountAccesses {
   1: map<pid_t, AccessCounts> accessCountsByPid;
   2: map<pid_t, i64> fetchCountsByPid;
+  3: map<pid_t, FetchRates> fetchRatesByPid;
 }
 
 struct GetAccessCountsResult {
@@ -964,6 +1110,23 @@ struct TracePoint {
   6: TracePointEvent event;
 }
 
+enum LatencyDistribution {
+  CONSTANT = 0,
+  // Log-normal around a median of latencyMicroseconds, with shape sigma.
+  LOG_NORMAL = 1,
+  // latencyMicroseconds, except for a fraction spikeProbability of the hits
+  // which take spikeMicroseconds.
+  TAIL_SPIKES = 2,
+}
+
+struct FaultLatency {
+  1: LatencyDistribution distribution;
+  2: i64 latencyMicroseconds;
+  3: double sigma;
+  4: double spikeProbability;
+  5: i64 spikeMicroseconds;
+}
+
 struct FaultDefinition {
   1: string keyClass;
   2: string keyValueRegex;
@@ -976,6 +1139,9 @@ struct FaultDefinition {
   5: i64 delayMilliseconds;
   6: optional string errorType;
   7: optional string errorMessage;
+  // If latency is set each hit is delayed by a duration drawn from it, and
+  // delayMilliseconds and errorMessage are ignored.
+  8: optional FaultLatency latency;
 }
 
 struct RemoveFaultArg {
@@ -1035,6 +1201,12 @@ enum ObjectType {
   SYMLINK = 3,
 }
 
+struct SetPathObjectIdObjectAndPath {
+  1: PathString path;
+  2: ThriftObjectId objectId;
+  3: ObjectType type;
+}
+
 struct SetPathObjectIdParams {
   1: PathString mountPoint;
   2: PathString path;
@@ -1043,6 +1215,13 @@ struct SetPathObjectIdParams {
   5: CheckoutMode mode;
   // Extra request infomation. i.e. build uuid, cache session id.
   6: optional map<string, string> requestInfo;
+  /**
+   * Objects to graft all at once, in a single checkout. When this is not
+   * empty, path, objectId and type are ignored.
+   *
+   * No path may be given twice, or be a parent directory of another one.
+   */
+  7: list<SetPathObjectIdObjectAndPath> objects;
 }
 
 struct SetPathObjectIdResult {
@@ -1087,8 +1266,14 @@ struct SynchronizeWorkingCopyParams {
   1: SyncBehavior sync;
 }
 
+/**
+ * Methods run on the thrift worker threads of their priority: cheap, latency
+ * sensitive calls are annotated with priority = 'HIGH' so they aren't queued
+ * behind expensive ones, and maintenance calls with priority = 'BEST_EFFORT'
+ * so they don't take threads away from regular requests.
+ */
 service EdenService extends fb303_core.BaseService {
-  list<MountInfo> listMounts() throws (1: EdenError ex);
+  list<MountInfo> listMounts() throws (1: EdenError ex) (priority = 'HIGH');
   void mount(1: MountArgument info) throws (1: EdenError ex);
   void unmount(1: PathString mountPoint) throws (1: EdenError ex);
 
@@ -1223,7 +1408,7 @@ service EdenService extends fb303_core.BaseService {
    */
   JournalPosition getCurrentJournalPosition(1: PathString mountPoint) throws (
     1: EdenError ex,
-  );
+  ) (priority = 'HIGH');
 
   /** Returns the set of files (and dirs) that changed since a prior point.
    * If fromPosition.mountGeneration is mismatched with the current
@@ -1239,6 +1424,14 @@ service EdenService extends fb303_core.BaseService {
     2: JournalPosition fromPosition,
   ) throws (1: EdenError ex);
 
+  /**
+   * Like getFilesChangedSince, but only reports the changed and unclean
+   * paths equal to or below one of params.roots.
+   */
+  FileDelta getFilesChangedSinceForRoots(
+    1: GetFilesChangedSinceParams params,
+  ) throws (1: EdenError ex);
+
   /** Sets the memory limit on the journal such that the journal will forget
    * old data to keep itself under a certain estimated memory use.
    */
@@ -1310,6 +1503,23 @@ service EdenService extends fb303_core.BaseService {
     1: GetAttributesFromFilesParams params,
   ) throws (1: EdenError ex);
 
+  /**
+   * Returns the requested file attributes of files in any number of mounts,
+   * res[i] holding the result of requests[i].
+   *
+   * This is equivalent to one getAttributesFromFiles() call per mount, but
+   * the paths of a mount are resolved together so that the directories they
+   * share are only looked up once, and the metadata of the files of a mount
+   * is fetched in a single batch.
+   *
+   * Note: may return stale data if synchronizeWorkingCopy isn't called, and if
+   * the SyncBehavior specify a 0 timeout. see the documentation for both of
+   * these for more details.
+   */
+  GetAttributesFromFilesResult getAttributesFromFilesBatch(
+    1: GetAttributesFromFilesBatchParams params,
+  ) throws (1: EdenError ex);
+
   /**
    * DEPRECATED: Use globFiles().
    *
@@ -1342,7 +1552,9 @@ service EdenService extends fb303_core.BaseService {
    * the SyncBehavior specify a 0 timeout. see the documentation for both of
    * these for more details.
    */
-  Glob predictiveGlobFiles(1: GlobParams params) throws (1: EdenError ex);
+  Glob predictiveGlobFiles(1: GlobParams params) throws (1: EdenError ex) (
+    priority = 'BEST_EFFORT',
+  );
 
   /**
    * Chowns all files in the requested mount to the requested uid and gid
@@ -1396,7 +1608,7 @@ service EdenService extends fb303_core.BaseService {
    * Returns information about the running process, including pid and command
    * line.
    */
-  DaemonInfo getDaemonInfo() throws (1: EdenError ex);
+  DaemonInfo getDaemonInfo() throws (1: EdenError ex) (priority = 'HIGH');
 
   /**
   * Returns information about the privhelper process, including accesibility.
@@ -1410,7 +1622,7 @@ service EdenService extends fb303_core.BaseService {
    * getDaemonInfo instead. This method exists for Thrift clients that
    * predate getDaemonInfo, such as older versions of the CLI.
    */
-  i64 getPid() throws (1: EdenError ex);
+  i64 getPid() throws (1: EdenError ex) (priority = 'HIGH');
 
   /**
    * Ask the server to shutdown and provide it some context for its logs
@@ -1504,7 +1716,24 @@ service EdenService extends fb303_core.BaseService {
     2: PathString path,
     3: i64 flags,
     4: SyncBehavior sync,
-  ) throws (1: EdenError ex);
+  ) throws (1: EdenError ex) (priority = 'BEST_EFFORT');
+
+  /**
+   * Get aggregated counts of the inodes under the given path, overall and for
+   * each directory immediately below it, without returning a record for every
+   * inode.
+   *
+   * The flags accept DIS_REQUIRE_LOADED and DIS_REQUIRE_MATERIALIZED, which
+   * select the trees to walk as they do for debugInodeStatus. 0 is the same as
+   * DIS_REQUIRE_LOADED. Only the sizes of materialized files are counted, so
+   * this never fetches from the backing store.
+   */
+  InodeSummary debugInodeSummary(
+    1: PathString mountPoint,
+    2: PathString path,
+    3: i64 flags,
+    4: SyncBehavior sync,
+  ) throws (1: EdenError ex) (priority = 'BEST_EFFORT');
 
   /**
    * Get the list of outstanding fuse requests
@@ -1560,6 +1789,17 @@ service EdenService extends fb303_core.BaseService {
     1: PathString mountPoint,
   );
 
+  /**
+   * Run short, calibrated probes of the resources the given mount depends on
+   * from inside the daemon: CPU hashing speed, LocalStore reads, writes and
+   * fsyncs next to the overlay, filesystem round trips through the mount, and
+   * backing store fetches. Comparing reports across hosts tells a slow host
+   * apart from a slow EdenFS.
+   */
+  HostSelfTestResult debugHostSelfTest(1: HostSelfTestParams params) throws (
+    1: EdenError ex,
+  );
+
   /**
    * Get the InodePathDebugInfo for the inode that corresponds to the given
    * inode number. This provides the path for the inode and also indicates
@@ -1618,18 +1858,24 @@ service EdenService extends fb303_core.BaseService {
    * risk of running out of disk space. Since RocksDB is a write-ahead logging
    * database, clearing a column increases its disk usage until it's compacted.
    */
-  void clearAndCompactLocalStore() throws (1: EdenError ex);
+  void clearAndCompactLocalStore() throws (1: EdenError ex) (
+    priority = 'BEST_EFFORT',
+  );
 
   /**
    * Clears all data from the LocalStore that can be populated from the upstream
    * backing store.
    */
-  void debugClearLocalStoreCaches() throws (1: EdenError ex);
+  void debugClearLocalStoreCaches() throws (1: EdenError ex) (
+    priority = 'BEST_EFFORT',
+  );
 
   /**
    * Asks RocksDB to perform a compaction.
    */
-  void debugCompactLocalStorage() throws (1: EdenError ex);
+  void debugCompactLocalStorage() throws (1: EdenError ex) (
+    priority = 'BEST_EFFORT',
+  );
 
   /**
   * Unloads unused Inodes from a directory inside a mountPoint whose last
@@ -1676,6 +1922,13 @@ service EdenService extends fb303_core.BaseService {
   void disableTracing();
   list<TracePoint> getTracePoints();
 
+  /**
+   * Render the most recent tracepoints and FUSE/NFS requests, without
+   * consuming them, in the Chrome trace event JSON format that
+   * chrome://tracing and the Perfetto UI open.
+   */
+  binary getChromeTrace();
+
   /**
    * Configure a new fault in Eden's fault injection framework.
    *
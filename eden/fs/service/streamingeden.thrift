@@ -86,12 +86,19 @@ enum HgEventType {
   QUEUE = 1,
   START = 2,
   FINISH = 3,
+  CANCEL = 4,
+  // Found in hgcache or EdenAPI, between START and FINISH.
+  FETCH = 5,
+  // Not found in hgcache or EdenAPI, imported through the hg importer.
+  FALLBACK = 6,
 }
 
 enum HgResourceType {
   UNKNOWN = 0,
   BLOB = 1,
   TREE = 2,
+  // The size and SHA-1 of a blob, fetched without its contents.
+  BLOBMETA = 3,
 }
 
 struct HgEvent {
@@ -115,6 +122,52 @@ struct HgEvent {
  * primarily javadeprecated which is used by Buck. When Buck is updated to
  * use java-swift instead, we can merge EdenService and StreamingEdenService.
  */
+struct SubscribeStreamParams {
+  1: eden.PathString mountPoint;
+  /**
+   * Paths relative to the mount. An empty list subscribes to the whole mount.
+   */
+  2: list<eden.PathString> roots;
+}
+
+/**
+ * Parameters of streamGlobFiles(), which streams the results of globFiles().
+ */
+struct StreamGlobFilesParams {
+  1: eden.GlobParams params;
+  /**
+   * Maximum number of files in each Glob sent on the stream. 0 picks a
+   * default.
+   */
+  2: i64 chunkSize;
+}
+
+/**
+ * Parameters of streamScmStatus(), which streams the results of
+ * getScmStatusV2().
+ */
+struct StreamScmStatusParams {
+  1: eden.GetScmStatusParams params;
+  /**
+   * Maximum number of entries and errors in each ScmStatus sent on the
+   * stream. 0 picks a default.
+   */
+  2: i64 chunkSize;
+}
+
+/**
+ * Parameters of streamFilesChangedSince(), which streams the results of
+ * getFilesChangedSinceForRoots().
+ */
+struct StreamFilesChangedSinceParams {
+  1: eden.GetFilesChangedSinceParams params;
+  /**
+   * Maximum number of paths in each FileDelta sent on the stream. 0 picks a
+   * default.
+   */
+  2: i64 chunkSize;
+}
+
 service StreamingEdenService extends eden.EdenService {
   /**
    * Request notification about changes to the journal for
@@ -139,6 +192,15 @@ service StreamingEdenService extends eden.EdenService {
     1: eden.PathString mountPoint,
   );
 
+  /**
+   * Like subscribeStreamTemporary, but only notifies about changes to paths
+   * equal to or below one of params.roots, and about changes of the current
+   * commit. Changes elsewhere in the mount don't wake the subscriber at all.
+   */
+  stream<eden.JournalPosition> subscribeStreamForRoots(
+    1: SubscribeStreamParams params,
+  );
+
   /**
    * Returns, in order, a stream of FUSE or PrjFS requests and responses for
    * the given mount.
@@ -158,4 +220,27 @@ service StreamingEdenService extends eden.EdenService {
    * started, and finished.
    */
   stream<HgEvent> traceHgEvents(1: eden.PathString mountPoint);
+
+  /**
+   * Like globFiles(), but the matching files are sent in several Globs. The
+   * concatenation of their lists is what globFiles() would return.
+   */
+  stream<eden.Glob> streamGlobFiles(1: StreamGlobFilesParams params);
+
+  /**
+   * Like getScmStatusV2(), but the differences are sent in several ScmStatus
+   * as they are found, rather than once the whole working copy was compared.
+   * An error computing the status ends the stream early.
+   */
+  stream<eden.ScmStatus> streamScmStatus(1: StreamScmStatusParams params);
+
+  /**
+   * Like getFilesChangedSinceForRoots(), but the paths are sent in several
+   * FileDeltas. The first one holds the journal positions, snapshot
+   * transitions and unclean paths, and each holds part of the changed and
+   * created paths.
+   */
+  stream<eden.FileDelta> streamFilesChangedSince(
+    1: StreamFilesChangedSinceParams params,
+  );
 }
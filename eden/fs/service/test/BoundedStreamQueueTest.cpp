@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/service/BoundedStreamQueue.h"
+
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/portability/GTest.h>
+#include <vector>
+
+using namespace facebook::eden;
+
+namespace {
+/**
+ * Subscribe to stream and read it to the end, returning the elements and
+ * whether it ended with an error.
+ */
+std::pair<std::vector<int>, bool> readStream(
+    apache::thrift::ServerStream<int> stream) {
+  folly::ScopedEventBaseThread evbThread;
+  std::vector<int> values;
+  bool failed = false;
+  std::move(stream)
+      .toClientStreamUnsafeDoNotUse(evbThread.getEventBase(), 1)
+      .subscribeInline([&](folly::Try<int>&& next) {
+        if (next.hasException()) {
+          failed = true;
+        } else if (next.hasValue()) {
+          values.push_back(*next);
+        }
+      });
+  return {std::move(values), failed};
+}
+} // namespace
+
+TEST(BoundedStreamQueue, subscriber_receives_what_was_pushed) {
+  auto [stream, queue] = BoundedStreamQueue<int>::create(10);
+  EXPECT_TRUE(queue->push(1));
+  EXPECT_TRUE(queue->push(2));
+  EXPECT_TRUE(queue->push(3));
+  queue->complete();
+  EXPECT_FALSE(queue->push(4));
+
+  auto [values, failed] = readStream(std::move(stream));
+  EXPECT_EQ((std::vector<int>{1, 2, 3}), values);
+  EXPECT_FALSE(failed);
+}
+
+TEST(BoundedStreamQueue, subscriber_receives_the_error) {
+  auto [stream, queue] = BoundedStreamQueue<int>::create(10);
+  EXPECT_TRUE(queue->push(1));
+  queue->complete(folly::make_exception_wrapper<std::runtime_error>("oops"));
+
+  auto [values, failed] = readStream(std::move(stream));
+  EXPECT_EQ(std::vector<int>{1}, values);
+  EXPECT_TRUE(failed);
+}
+
+#if FOLLY_HAS_COROUTINES
+TEST(BoundedStreamQueue, subscriber_too_far_behind_is_disconnected) {
+  auto [stream, queue] = BoundedStreamQueue<int>::create(2);
+  EXPECT_TRUE(queue->push(1));
+  EXPECT_TRUE(queue->push(2));
+  EXPECT_FALSE(queue->push(3));
+  EXPECT_FALSE(queue->push(4));
+
+  auto [values, failed] = readStream(std::move(stream));
+  EXPECT_TRUE(values.empty());
+  EXPECT_TRUE(failed);
+}
+#endif
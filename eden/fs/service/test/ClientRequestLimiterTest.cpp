@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/service/ClientRequestLimiter.h"
+
+#include <folly/portability/GTest.h>
+#include <vector>
+
+using namespace facebook::eden;
+
+TEST(ClientRequestLimiter, limits_each_client_separately) {
+  auto limiter = std::make_shared<ClientRequestLimiter>();
+  auto first = limiter->tryAcquire(1, 2);
+  auto second = limiter->tryAcquire(1, 2);
+  ASSERT_TRUE(first);
+  ASSERT_TRUE(second);
+  EXPECT_FALSE(limiter->tryAcquire(1, 2));
+  EXPECT_EQ(2, limiter->getOutstanding(1));
+
+  EXPECT_TRUE(limiter->tryAcquire(2, 2));
+  EXPECT_EQ(0, limiter->getOutstanding(2));
+
+  first.reset();
+  EXPECT_EQ(1, limiter->getOutstanding(1));
+  EXPECT_TRUE(limiter->tryAcquire(1, 2));
+}
+
+TEST(ClientRequestLimiter, zero_means_unlimited) {
+  auto limiter = std::make_shared<ClientRequestLimiter>();
+  std::vector<ClientRequestLimiter::Token> tokens;
+  for (int i = 0; i < 100; ++i) {
+    auto token = limiter->tryAcquire(1, 0);
+    ASSERT_TRUE(token);
+    tokens.push_back(std::move(*token));
+  }
+  EXPECT_EQ(0, limiter->getOutstanding(1));
+  tokens.clear();
+  EXPECT_EQ(0, limiter->getOutstanding(1));
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/service/HostSelfTest.h"
+
+#include <folly/portability/GTest.h>
+#include <algorithm>
+
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/store/LocalStore.h"
+#include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/TestMount.h"
+
+using namespace facebook::eden;
+
+TEST(HostSelfTest, every_probe_reports_its_samples) {
+  FakeTreeBuilder builder;
+  builder.setFile("README", "hello\n");
+  TestMount mount{builder};
+
+  auto result = runHostSelfTest(*mount.getEdenMount(), 3);
+
+  std::vector<std::string> names;
+  for (const auto& probe : *result.probes_ref()) {
+    names.push_back(*probe.name_ref());
+    EXPECT_FALSE(probe.error_ref().has_value())
+        << *probe.name_ref() << ": " << probe.error_ref().value_or("");
+    EXPECT_EQ(3, *probe.samples_ref());
+    EXPECT_LE(*probe.p50Micros_ref(), *probe.p99Micros_ref());
+    EXPECT_LE(*probe.p99Micros_ref(), *probe.maxMicros_ref());
+  }
+  EXPECT_NE(
+      names.end(), std::find(names.begin(), names.end(), "cpu_sha1_1mib"));
+  EXPECT_NE(
+      names.end(),
+      std::find(names.begin(), names.end(), "backing_store_root_tree"));
+}
+
+TEST(HostSelfTest, local_store_is_left_as_it_was) {
+  FakeTreeBuilder builder;
+  builder.setFile("README", "hello\n");
+  TestMount mount{builder};
+
+  runHostSelfTest(*mount.getEdenMount(), 1);
+
+  auto localStore = mount.getEdenMount()->getObjectStore()->getLocalStore();
+  auto key = folly::ByteRange{folly::StringPiece{"eden-self-test"}};
+  EXPECT_FALSE(localStore->hasKey(KeySpace::SelfTestFamily, key));
+  EXPECT_FALSE(localStore->hasKey(KeySpace::BlobFamily, key));
+}
+
+TEST(HostSelfTest, failing_probes_report_their_error) {
+  FakeTreeBuilder builder;
+  builder.setFile("README", "hello\n");
+  TestMount mount{builder};
+  // The root tree of an unknown commit can't be fetched.
+  mount.getEdenMount()->resetParent(RootId{"unknown"});
+
+  auto result = runHostSelfTest(*mount.getEdenMount(), 1);
+
+  for (const auto& probe : *result.probes_ref()) {
+    if (*probe.name_ref() == "backing_store_root_tree") {
+      EXPECT_TRUE(probe.error_ref().has_value());
+    } else {
+      EXPECT_FALSE(probe.error_ref().has_value()) << *probe.name_ref();
+    }
+  }
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/service/MemoryGovernor.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+namespace {
+
+const MemoryGovernor::Thresholds kThresholds{
+    /*highStallPercent=*/10.0,
+    /*lowStallPercent=*/1.0,
+    /*highCgroupUsageRatio=*/0.9,
+    /*lowCgroupUsageRatio=*/0.75,
+    /*minimumScale=*/0.25,
+};
+
+MemoryPressure stall(double percent) {
+  MemoryPressure pressure;
+  pressure.stallPercent = percent;
+  return pressure;
+}
+
+MemoryPressure cgroupUsage(double ratio) {
+  MemoryPressure pressure;
+  pressure.cgroupUsageRatio = ratio;
+  return pressure;
+}
+
+} // namespace
+
+TEST(MemoryGovernor, starts_at_full_scale) {
+  MemoryGovernor governor;
+  EXPECT_EQ(1.0, governor.getScale());
+  EXPECT_EQ(
+      MemoryGovernor::Decision::Keep, governor.update(stall(0), kThresholds));
+  EXPECT_EQ(1.0, governor.getScale());
+}
+
+TEST(MemoryGovernor, shrinks_down_to_minimum_under_pressure) {
+  MemoryGovernor governor;
+  EXPECT_EQ(
+      MemoryGovernor::Decision::Shrink,
+      governor.update(stall(20), kThresholds));
+  EXPECT_EQ(0.5, governor.getScale());
+  EXPECT_EQ(
+      MemoryGovernor::Decision::Shrink,
+      governor.update(cgroupUsage(0.95), kThresholds));
+  EXPECT_EQ(0.25, governor.getScale());
+  EXPECT_EQ(
+      MemoryGovernor::Decision::Keep,
+      governor.update(stall(50), kThresholds));
+  EXPECT_EQ(0.25, governor.getScale());
+  EXPECT_EQ(2, governor.getStats().shrinkCount);
+}
+
+TEST(MemoryGovernor, grows_back_only_below_low_thresholds) {
+  MemoryGovernor governor;
+  governor.update(stall(20), kThresholds);
+  governor.update(stall(20), kThresholds);
+  ASSERT_EQ(0.25, governor.getScale());
+
+  // Between the thresholds nothing changes.
+  EXPECT_EQ(
+      MemoryGovernor::Decision::Keep, governor.update(stall(5), kThresholds));
+  EXPECT_EQ(0.25, governor.getScale());
+
+  // Both readings have to be low.
+  MemoryPressure mixed;
+  mixed.stallPercent = 0.0;
+  mixed.cgroupUsageRatio = 0.8;
+  EXPECT_EQ(
+      MemoryGovernor::Decision::Keep, governor.update(mixed, kThresholds));
+
+  EXPECT_EQ(
+      MemoryGovernor::Decision::Grow, governor.update(stall(0), kThresholds));
+  EXPECT_EQ(0.5, governor.getScale());
+  EXPECT_EQ(
+      MemoryGovernor::Decision::Grow,
+      governor.update(cgroupUsage(0.1), kThresholds));
+  EXPECT_EQ(1.0, governor.getScale());
+  EXPECT_EQ(2, governor.getStats().growCount);
+}
+
+TEST(MemoryGovernor, keeps_scale_without_readings) {
+  MemoryGovernor governor;
+  governor.update(stall(20), kThresholds);
+  EXPECT_EQ(
+      MemoryGovernor::Decision::Keep,
+      governor.update(MemoryPressure{}, kThresholds));
+  EXPECT_EQ(0.5, governor.getScale());
+}
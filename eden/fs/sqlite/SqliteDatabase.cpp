@@ -7,8 +7,11 @@
 
 #include "eden/fs/sqlite/SqliteDatabase.h"
 
+#include <folly/ScopeGuard.h>
+#include <folly/String.h>
 #include <folly/logging/xlog.h>
 #include "eden/fs/sqlite/PersistentSqliteStatement.h"
+#include "eden/fs/sqlite/SqliteStatement.h"
 
 namespace facebook::eden {
 struct SqliteDatabase::StatementCache {
@@ -44,7 +47,7 @@ void checkSqliteResult(sqlite3* db, int result) {
   }
 }
 
-SqliteDatabase::SqliteDatabase(const char* addr) {
+SqliteDatabase::SqliteDatabase(const char* addr) : address_{addr} {
   sqlite3* db = nullptr;
   auto result = sqlite3_open(addr, &db);
   if (result != SQLITE_OK) {
@@ -68,6 +71,14 @@ void SqliteDatabase::close() {
     sqlite3_close(*db);
     *db = nullptr;
   }
+  if (readPool_) {
+    for (auto& reader : readPool_->readers) {
+      auto conn = reader.wlock();
+      sqlite3_close(*conn);
+      *conn = nullptr;
+    }
+    readPool_.reset();
+  }
 }
 
 SqliteDatabase::~SqliteDatabase() {
@@ -78,6 +89,57 @@ SqliteDatabase::Connection SqliteDatabase::lock() {
   return db_.wlock();
 }
 
+void SqliteDatabase::openReadConnections(size_t count) {
+  if (readPool_ || count == 0 || address_ == ":memory:") {
+    return;
+  }
+  {
+    // Readers of a database in another journal mode block its writer.
+    auto conn = lock();
+    SqliteStatement journalMode{conn, "PRAGMA journal_mode"};
+    if (!journalMode.step() ||
+        !folly::StringPiece{journalMode.columnBlob(0)}.equals(
+            "wal", folly::AsciiCaseInsensitive{})) {
+      return;
+    }
+  }
+
+  auto pool = std::make_unique<ReadPool>(count);
+  SCOPE_FAIL {
+    for (auto& reader : pool->readers) {
+      sqlite3_close(*reader.wlock());
+    }
+  };
+  for (auto& reader : pool->readers) {
+    sqlite3* db = nullptr;
+    auto result = sqlite3_open_v2(
+        address_.c_str(), &db, SQLITE_OPEN_READONLY, nullptr);
+    if (result != SQLITE_OK) {
+      // @lint-ignore CLANGTIDY
+      sqlite3_close(db);
+      checkSqliteResult(nullptr, result);
+    }
+    // Readers can still briefly be locked out while the WAL is recovered
+    // after a crash.
+    sqlite3_busy_timeout(db, 5000);
+    *reader.wlock() = db;
+  }
+  readPool_ = std::move(pool);
+}
+
+SqliteDatabase::ReadConnection SqliteDatabase::lockRead() {
+  auto& readers = readPool_->readers;
+  auto start = readPool_->next.fetch_add(1, std::memory_order_relaxed);
+  for (size_t i = 0; i < readers.size(); ++i) {
+    auto index = (start + i) % readers.size();
+    if (auto conn = readers[index].tryWLock()) {
+      return ReadConnection{index, std::move(conn)};
+    }
+  }
+  auto index = start % readers.size();
+  return ReadConnection{index, readers[index].wlock()};
+}
+
 void SqliteDatabase::transaction(const std::function<void(Connection&)>& func) {
   auto conn = lock();
   try {
@@ -90,4 +152,17 @@ void SqliteDatabase::transaction(const std::function<void(Connection&)>& func) {
     throw;
   }
 }
+
+void SqliteDatabase::backup(Connection& from, Connection& to) {
+  auto* backup = sqlite3_backup_init(*to, "main", *from, "main");
+  if (!backup) {
+    checkSqliteResult(*to, sqlite3_errcode(*to));
+  }
+  auto result = sqlite3_backup_step(backup, -1);
+  auto finishResult = sqlite3_backup_finish(backup);
+  if (result != SQLITE_DONE) {
+    checkSqliteResult(*to, result);
+  }
+  checkSqliteResult(*to, finishResult);
+}
 } // namespace facebook::eden
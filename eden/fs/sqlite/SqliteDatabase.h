@@ -9,6 +9,9 @@
 
 #include <folly/Synchronized.h>
 #include <sqlite3.h>
+#include <atomic>
+#include <string>
+#include <vector>
 #include "eden/fs/utils/PathFuncs.h"
 
 namespace facebook::eden {
@@ -56,6 +59,35 @@ class SqliteDatabase {
    * to the SqliteStatement class. */
   Connection lock();
 
+  /**
+   * A locked read-only connection, with its index among the
+   * readConnectionCount() ones, for callers keeping state per connection.
+   */
+  struct ReadConnection {
+    size_t index;
+    Connection conn;
+  };
+
+  /**
+   * Open `count` read-only connections to the database, next to the one
+   * lock() returns, so that reads from several threads don't wait on each
+   * other. They only see committed transactions.
+   *
+   * This does nothing unless the database is a file in WAL mode, where
+   * readers don't block the writer, or if read connections are open already.
+   */
+  void openReadConnections(size_t count);
+
+  size_t readConnectionCount() const {
+    return readPool_ ? readPool_->readers.size() : 0;
+  }
+
+  /**
+   * Obtain one of the read-only connections, preferring an unused one. Must
+   * only be called when readConnectionCount() isn't 0.
+   */
+  ReadConnection lockRead();
+
   /**
    * Executes a SQLite transaction. If the lambda body throws any error, the
    * transaction will be rolled back. This function returns a boolean to
@@ -72,13 +104,31 @@ class SqliteDatabase {
    */
   void transaction(const std::function<void(Connection&)>& func);
 
+  /**
+   * Replace the contents of the database behind `to` with a copy of the one
+   * behind `from`, using the SQLite online backup API.
+   */
+  static void backup(Connection& from, Connection& to);
+
  private:
   struct StatementCache;
 
+  struct ReadPool {
+    explicit ReadPool(size_t count) : readers(count) {}
+
+    std::vector<folly::Synchronized<sqlite3*>> readers;
+    // Where lockRead() starts looking for an unused connection.
+    std::atomic<size_t> next{0};
+  };
+
   explicit SqliteDatabase(const char* address);
 
+  std::string address_;
+
   folly::Synchronized<sqlite3*> db_{nullptr};
 
+  std::unique_ptr<ReadPool> readPool_;
+
   std::unique_ptr<StatementCache> cache_;
 };
 } // namespace facebook::eden
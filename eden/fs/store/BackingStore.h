@@ -10,10 +10,13 @@
 #include <folly/Range.h>
 #include <folly/futures/Future.h>
 #include <memory>
+#include <vector>
 
+#include "eden/fs/model/Blob.h"
 #include "eden/fs/model/BlobMetadata.h"
 #include "eden/fs/model/ObjectId.h"
 #include "eden/fs/model/RootId.h"
+#include "eden/fs/service/gen-cpp2/eden_types.h"
 #include "eden/fs/store/ImportPriority.h"
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -25,7 +28,6 @@ class Future;
 
 namespace facebook::eden {
 
-class Blob;
 class Tree;
 class TreeEntry;
 enum class TreeEntryType : uint8_t;
@@ -100,6 +102,30 @@ class BackingStore : public RootIdCodec, public ObjectIdCodec {
       const ObjectId& id,
       ObjectFetchContext& context) = 0;
 
+  /**
+   * Fetch at most length bytes of a blob's contents, starting at offset.
+   *
+   * Returns nullptr if the blob doesn't exist, like getBlob() returns a null
+   * blob, and an empty buffer if offset is past its end. The default fetches
+   * the whole blob and keeps the range; backing stores that can read part of
+   * a blob override it so that reading the start of a huge file doesn't
+   * load all of it.
+   */
+  virtual folly::SemiFuture<std::unique_ptr<folly::IOBuf>> getBlobRange(
+      const ObjectId& id,
+      uint64_t offset,
+      uint64_t length,
+      ObjectFetchContext& context) {
+    return getBlob(id, context)
+        .deferValue([offset, length](GetBlobRes result)
+                        -> std::unique_ptr<folly::IOBuf> {
+          if (!result.blob) {
+            return nullptr;
+          }
+          return result.blob->getContentsRange(offset, length);
+        });
+  }
+
   /**
    * Fetch blob metadata if available locally.
    */
@@ -109,6 +135,30 @@ class BackingStore : public RootIdCodec, public ObjectIdCodec {
     return nullptr;
   }
 
+  /**
+   * Fetch blob metadata without fetching the blob contents, for backing
+   * stores that can. Returns nullptr when the metadata isn't available this
+   * way, in which case the caller computes it from the blob.
+   */
+  virtual folly::SemiFuture<std::unique_ptr<BlobMetadata>> getBlobMetadata(
+      const ObjectId& /*id*/,
+      ObjectFetchContext& /*context*/) {
+    return folly::makeSemiFuture(std::unique_ptr<BlobMetadata>{});
+  }
+
+  /**
+   * Compute the files that differ between two commits, for backing stores
+   * that can compare the commits natively without the ObjectStore loading
+   * every tree that differs. Returns nullptr if the backing store can't, in
+   * which case the caller diffs the trees itself.
+   */
+  virtual folly::SemiFuture<std::unique_ptr<ScmStatus>> diffRoots(
+      const RootId& /*root1*/,
+      const RootId& /*root2*/,
+      ObjectFetchContext& /*context*/) {
+    return folly::makeSemiFuture(std::unique_ptr<ScmStatus>{});
+  }
+
   /**
    * Prefetch all the blobs represented by the HashRange.
    *
@@ -140,6 +190,18 @@ class BackingStore : public RootIdCodec, public ObjectIdCodec {
     return {};
   }
 
+  /**
+   * Up to count directories whose files had to be fetched the most, from
+   * most to least fetched. This is the local history that predictive
+   * prefetches can use in place of a remote usage service.
+   *
+   * Currently implemented in HgQueuedBackingStore.
+   */
+  virtual std::vector<RelativePath> getMostFetchedDirectories(
+      size_t /*count*/) {
+    return {};
+  }
+
   /**
    * Directly import a manifest for a root.
    *
@@ -161,6 +223,16 @@ class BackingStore : public RootIdCodec, public ObjectIdCodec {
     return folly::unit;
   }
 
+  /**
+   * If id is in a legacy format that needs a lookup to be resolved, and the
+   * BackingStore is configured to produce self-contained IDs, return the
+   * self-contained ID of the same object. Returns std::nullopt when id should
+   * be kept as is.
+   */
+  virtual std::optional<ObjectId> migrateObjectId(const ObjectId& /*id*/) {
+    return std::nullopt;
+  }
+
   /**
    * If supported, returns the name of the underlying repo. The result name is
    * primarily for logging and may not be unique.
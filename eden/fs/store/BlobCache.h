@@ -29,11 +29,15 @@ class BlobCache : public ObjectCache<Blob, ObjectCacheFlavor::InterestHandle> {
  public:
   static std::shared_ptr<BlobCache> create(
       size_t maximumCacheSizeBytes,
-      size_t minimumEntryCount) {
+      size_t minimumEntryCount,
+      size_t numShards = 1,
+      ObjectCacheEvictionPolicy policy = ObjectCacheEvictionPolicy::Lru) {
     struct BC : BlobCache {
-      BC(size_t x, size_t y) : BlobCache{x, y} {}
+      BC(size_t x, size_t y, size_t z, ObjectCacheEvictionPolicy p)
+          : BlobCache{x, y, z, p} {}
     };
-    return std::make_shared<BC>(maximumCacheSizeBytes, minimumEntryCount);
+    return std::make_shared<BC>(
+        maximumCacheSizeBytes, minimumEntryCount, numShards, policy);
   }
   ~BlobCache() = default;
 
@@ -70,10 +74,16 @@ class BlobCache : public ObjectCache<Blob, ObjectCacheFlavor::InterestHandle> {
   }
 
  private:
-  explicit BlobCache(size_t maximumCacheSizeBytes, size_t minimumEntryCount)
+  explicit BlobCache(
+      size_t maximumCacheSizeBytes,
+      size_t minimumEntryCount,
+      size_t numShards,
+      ObjectCacheEvictionPolicy policy)
       : ObjectCache<Blob, ObjectCacheFlavor::InterestHandle>{
             maximumCacheSizeBytes,
-            minimumEntryCount} {}
+            minimumEntryCount,
+            numShards,
+            policy} {}
 };
 
 } // namespace facebook::eden
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/BlobMetadataCache.h"
+
+#include <folly/MapUtil.h>
+
+namespace facebook::eden {
+
+namespace {
+// ObjectId storage keeps ids up to this many bytes inline, which covers 20
+// byte hashes. Longer ids, such as ones embedding a path, allocate.
+constexpr size_t kObjectIdInlineCapacity = 23;
+
+// The F14 index stores a copy of the id and the slot number, plus roughly one
+// byte of per-entry metadata and some slack for its load factor.
+constexpr size_t kIndexEntryOverhead =
+    (sizeof(ObjectId) + sizeof(uint32_t)) * 5 / 4 + 1;
+} // namespace
+
+BlobMetadataCache::BlobMetadataCache(size_t maximumSizeBytes)
+    : maximumSizeBytes_{maximumSizeBytes} {}
+
+size_t BlobMetadataCache::getEntrySize(const ObjectId& id) {
+  // The id is stored twice: once in the slot and once as the index key.
+  auto idHeapSize = id.size() > kObjectIdInlineCapacity ? id.size() * 2 : 0;
+  return sizeof(Slot) + kIndexEntryOverhead + idHeapSize;
+}
+
+std::optional<BlobMetadata> BlobMetadataCache::get(const ObjectId& id) {
+  auto state = state_.wlock();
+  auto* slotIndex = folly::get_ptr(state->index, id);
+  if (!slotIndex) {
+    ++state->missCount;
+    return std::nullopt;
+  }
+  ++state->hitCount;
+  auto& slot = state->slots[*slotIndex];
+  slot.referenced = true;
+  return slot.metadata;
+}
+
+bool BlobMetadataCache::contains(const ObjectId& id) const {
+  return state_.rlock()->index.count(id) != 0;
+}
+
+void BlobMetadataCache::set(const ObjectId& id, const BlobMetadata& metadata) {
+  auto entrySize = getEntrySize(id);
+  if (entrySize > maximumSizeBytes_) {
+    return;
+  }
+
+  auto state = state_.wlock();
+  if (auto* slotIndex = folly::get_ptr(state->index, id)) {
+    auto& slot = state->slots[*slotIndex];
+    slot.metadata = metadata;
+    slot.referenced = true;
+    return;
+  }
+
+  while (!state->slots.empty() &&
+         state->totalSize + entrySize > maximumSizeBytes_) {
+    evictOne(*state);
+  }
+
+  state->slots.emplace_back(id, metadata);
+  try {
+    state->index.emplace(id, static_cast<uint32_t>(state->slots.size() - 1));
+  } catch (const std::exception&) {
+    state->slots.pop_back();
+    throw;
+  }
+  state->totalSize += entrySize;
+}
+
+void BlobMetadataCache::evictOne(State& state) {
+  auto& slots = state.slots;
+  // Sweep until an entry that was not referenced since the last pass is found.
+  // This terminates within two passes since every visited bit is cleared.
+  while (true) {
+    if (state.clockHand >= slots.size()) {
+      state.clockHand = 0;
+    }
+    auto& candidate = slots[state.clockHand];
+    if (!candidate.referenced) {
+      break;
+    }
+    candidate.referenced = false;
+    ++state.clockHand;
+  }
+
+  auto victimIndex = state.clockHand;
+  state.totalSize -= getEntrySize(slots[victimIndex].id);
+  state.index.erase(slots[victimIndex].id);
+  ++state.evictionCount;
+
+  // Fill the hole with the last slot so the vector stays dense.
+  auto lastIndex = slots.size() - 1;
+  if (victimIndex != lastIndex) {
+    slots[victimIndex] = std::move(slots[lastIndex]);
+    state.index[slots[victimIndex].id] = static_cast<uint32_t>(victimIndex);
+  }
+  slots.pop_back();
+}
+
+void BlobMetadataCache::clear() {
+  auto state = state_.wlock();
+  state->slots.clear();
+  state->index.clear();
+  state->clockHand = 0;
+  state->totalSize = 0;
+}
+
+BlobMetadataCache::Stats BlobMetadataCache::getStats() const {
+  auto state = state_.rlock();
+  Stats stats;
+  stats.entryCount = state->slots.size();
+  stats.totalSizeInBytes = state->totalSize;
+  stats.hitCount = state->hitCount;
+  stats.missCount = state->missCount;
+  stats.evictionCount = state->evictionCount;
+  return stats;
+}
+
+} // namespace facebook::eden
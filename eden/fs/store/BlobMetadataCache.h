@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <optional>
+#include <vector>
+
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+
+#include "eden/fs/model/BlobMetadata.h"
+#include "eden/fs/model/ObjectId.h"
+
+namespace facebook::eden {
+
+/**
+ * A bounded in-memory cache of blob sizes and SHA-1s, limited by an estimate
+ * of the memory it uses rather than by a number of entries.
+ *
+ * Entries are stored densely in a flat vector, with an F14 index from
+ * ObjectId to slot. Instead of an LRU list, which costs two pointers per
+ * entry, eviction uses the CLOCK algorithm: lookups set a referenced bit, and
+ * the eviction hand clears bits until it finds an entry that was not
+ * referenced since the last sweep. Evicted slots are filled by moving the last
+ * slot into them, so the vector never has holes.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class BlobMetadataCache {
+ public:
+  struct Stats {
+    size_t entryCount{0};
+    size_t totalSizeInBytes{0};
+    uint64_t hitCount{0};
+    uint64_t missCount{0};
+    uint64_t evictionCount{0};
+  };
+
+  explicit BlobMetadataCache(size_t maximumSizeBytes);
+
+  /**
+   * Return the metadata for the blob if cached, marking it as recently used.
+   */
+  std::optional<BlobMetadata> get(const ObjectId& id);
+
+  /**
+   * Returns true if the metadata for the blob is cached. Does not affect
+   * eviction order.
+   */
+  bool contains(const ObjectId& id) const;
+
+  /**
+   * Insert or replace the metadata for the blob, evicting other entries if
+   * the cache grows past its maximum size.
+   */
+  void set(const ObjectId& id, const BlobMetadata& metadata);
+
+  void clear();
+
+  Stats getStats() const;
+
+  /**
+   * Estimated number of bytes used by one entry for the given id.
+   */
+  static size_t getEntrySize(const ObjectId& id);
+
+ private:
+  struct Slot {
+    Slot(const ObjectId& i, const BlobMetadata& m) : id{i}, metadata{m} {}
+
+    ObjectId id;
+    BlobMetadata metadata;
+    bool referenced{false};
+  };
+
+  struct State {
+    std::vector<Slot> slots;
+    folly::F14FastMap<ObjectId, uint32_t> index;
+    size_t clockHand{0};
+    size_t totalSize{0};
+    uint64_t hitCount{0};
+    uint64_t missCount{0};
+    uint64_t evictionCount{0};
+  };
+
+  static void evictOne(State& state);
+
+  const size_t maximumSizeBytes_;
+  folly::Synchronized<State> state_;
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/CacheWarmState.h"
+
+#include <fmt/format.h>
+#include <folly/Utility.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+#include <folly/logging/xlog.h>
+#include <algorithm>
+#include <stdexcept>
+
+#include "eden/fs/store/BlobCache.h"
+#include "eden/fs/store/LocalStore.h"
+#include "eden/fs/store/TreeCache.h"
+#include "eden/fs/utils/FileUtils.h"
+
+namespace facebook::eden {
+
+namespace {
+/**
+ * The file is laid out as:
+ * - magic (4 bytes) and version (4 bytes)
+ * - the blob keys, then the tree keys, each as:
+ *   - count (4 bytes)
+ *   - for each key: frequency (1 byte), id length (2 bytes), id bytes
+ *
+ * All integers are big endian.
+ */
+constexpr uint32_t kMagic = 0x45574353; // "EWCS"
+constexpr uint32_t kVersion = 1;
+
+void appendKeys(
+    folly::io::Appender& appender,
+    const std::vector<CacheHotKey>& keys) {
+  appender.writeBE<uint32_t>(folly::to_narrow(keys.size()));
+  for (const auto& key : keys) {
+    auto bytes = key.id.getBytes();
+    appender.writeBE<uint8_t>(key.frequency);
+    appender.writeBE<uint16_t>(folly::to_narrow(bytes.size()));
+    appender.push(bytes);
+  }
+}
+
+std::vector<CacheHotKey> readKeys(folly::io::Cursor& cursor) {
+  auto count = cursor.readBE<uint32_t>();
+  std::vector<CacheHotKey> keys;
+  // Don't trust count for the reservation, a corrupt file could make it huge.
+  keys.reserve(std::min<size_t>(count, cursor.totalLength()));
+  for (uint32_t i = 0; i < count; ++i) {
+    auto frequency = cursor.readBE<uint8_t>();
+    auto length = cursor.readBE<uint16_t>();
+    auto id = cursor.readFixedString(length);
+    keys.push_back(CacheHotKey{
+        ObjectId{folly::ByteRange{folly::StringPiece{id}}}, frequency});
+  }
+  return keys;
+}
+
+/**
+ * Return the keys in the order they should be inserted: least frequently
+ * used first, and among equally frequent ones, least recently used first.
+ */
+std::vector<CacheHotKey> insertionOrder(std::vector<CacheHotKey> keys) {
+  std::reverse(keys.begin(), keys.end());
+  std::stable_sort(
+      keys.begin(), keys.end(), [](const auto& left, const auto& right) {
+        return left.frequency < right.frequency;
+      });
+  return keys;
+}
+} // namespace
+
+CacheWarmState CacheWarmState::capture(
+    const BlobCache& blobCache,
+    const TreeCache& treeCache,
+    size_t maxEntries) {
+  CacheWarmState state;
+  state.blobs = blobCache.getHotKeys(maxEntries);
+  state.trees = treeCache.getHotKeys(maxEntries);
+  return state;
+}
+
+std::string CacheWarmState::serialize() const {
+  folly::IOBufQueue queue{folly::IOBufQueue::cacheChainLength()};
+  folly::io::Appender appender{&queue, 4096};
+  appender.writeBE<uint32_t>(kMagic);
+  appender.writeBE<uint32_t>(kVersion);
+  appendKeys(appender, blobs);
+  appendKeys(appender, trees);
+  std::string result;
+  queue.move()->appendTo(result);
+  return result;
+}
+
+CacheWarmState CacheWarmState::deserialize(folly::ByteRange data) {
+  auto buf = folly::IOBuf::wrapBufferAsValue(data);
+  folly::io::Cursor cursor{&buf};
+  try {
+    if (cursor.readBE<uint32_t>() != kMagic) {
+      throw std::invalid_argument("not a cache warm state file");
+    }
+    auto version = cursor.readBE<uint32_t>();
+    if (version != kVersion) {
+      throw std::invalid_argument(
+          fmt::format("unsupported cache warm state version {}", version));
+    }
+    CacheWarmState state;
+    state.blobs = readKeys(cursor);
+    state.trees = readKeys(cursor);
+    return state;
+  } catch (const std::out_of_range&) {
+    throw std::invalid_argument("truncated cache warm state file");
+  }
+}
+
+folly::Try<void> CacheWarmState::save(AbsolutePathPiece path) const {
+  auto data = serialize();
+  return writeFileAtomic(path, folly::StringPiece{data});
+}
+
+std::optional<CacheWarmState> CacheWarmState::load(AbsolutePathPiece path) {
+  auto data = readFile(path);
+  if (data.hasException()) {
+    XLOG(DBG2) << "no cache warm state at " << path << ": "
+               << data.exception().what();
+    return std::nullopt;
+  }
+  try {
+    return deserialize(folly::StringPiece{data.value()});
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "ignoring cache warm state at " << path << ": "
+               << folly::exceptionStr(ex);
+    return std::nullopt;
+  }
+}
+
+size_t CacheWarmState::restore(
+    const LocalStore& localStore,
+    BlobCache& blobCache,
+    TreeCache& treeCache) const {
+  size_t loaded = 0;
+  for (const auto& key : insertionOrder(trees)) {
+    auto tree = localStore.getTree(key.id).get();
+    if (tree) {
+      treeCache.insert(std::move(tree));
+      ++loaded;
+    }
+  }
+  for (const auto& key : insertionOrder(blobs)) {
+    auto blob = localStore.getBlob(key.id).get();
+    if (blob) {
+      blobCache.insert(std::move(blob));
+      ++loaded;
+    }
+  }
+  return loaded;
+}
+
+} // namespace facebook::eden
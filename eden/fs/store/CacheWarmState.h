@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/Try.h>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "eden/fs/store/ObjectCache.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class BlobCache;
+class LocalStore;
+class TreeCache;
+
+/**
+ * The hot keys of the in-memory blob and tree caches, saved when EdenFS shuts
+ * down so that the next EdenFS process can reload those objects from the
+ * LocalStore instead of starting with cold caches.
+ */
+struct CacheWarmState {
+  /// Most recently used first, as returned by ObjectCache::getHotKeys().
+  std::vector<CacheHotKey> blobs;
+  std::vector<CacheHotKey> trees;
+
+  /**
+   * Capture up to maxEntries hot keys of each cache.
+   */
+  static CacheWarmState capture(
+      const BlobCache& blobCache,
+      const TreeCache& treeCache,
+      size_t maxEntries);
+
+  std::string serialize() const;
+
+  /**
+   * Throws std::invalid_argument if data is not a serialized CacheWarmState.
+   */
+  static CacheWarmState deserialize(folly::ByteRange data);
+
+  FOLLY_NODISCARD folly::Try<void> save(AbsolutePathPiece path) const;
+
+  /**
+   * Returns std::nullopt if the file doesn't exist or can't be parsed.
+   */
+  static std::optional<CacheWarmState> load(AbsolutePathPiece path);
+
+  /**
+   * Load the objects that are present in the LocalStore into the caches, the
+   * coldest first so that the hottest end up most recently used. Objects
+   * missing from the LocalStore are skipped; they are never fetched from a
+   * BackingStore. Blocks until done, and returns the number of objects
+   * loaded.
+   */
+  size_t restore(
+      const LocalStore& localStore,
+      BlobCache& blobCache,
+      TreeCache& treeCache) const;
+};
+
+} // namespace facebook::eden
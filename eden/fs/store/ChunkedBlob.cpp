@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/ChunkedBlob.h"
+
+#include <folly/Bits.h>
+#include <folly/Conv.h>
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+using folly::ByteRange;
+using folly::StringPiece;
+
+namespace facebook::eden {
+
+namespace {
+
+constexpr StringPiece kManifestPrefix{"chunked "};
+constexpr StringPiece kSizedManifestPrefix{"chunked2 "};
+constexpr size_t kSizedEntrySize = Hash20::RAW_SIZE + sizeof(uint32_t);
+
+constexpr uint64_t splitMix64(uint64_t& state) {
+  uint64_t z = (state += 0x9e3779b97f4a7c15);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  return z ^ (z >> 31);
+}
+
+constexpr std::array<uint64_t, 256> makeGearTable() {
+  std::array<uint64_t, 256> table{};
+  uint64_t state = 0x45444e4643444321;
+  for (auto& entry : table) {
+    entry = splitMix64(state);
+  }
+  return table;
+}
+
+/**
+ * Random values for every byte, mixed into the rolling gear hash. This must
+ * never change: chunks are only shared with blobs split the same way.
+ */
+constexpr auto kGear = makeGearTable();
+
+constexpr uint64_t topBitsMask(unsigned bits) {
+  return ~uint64_t{0} << (64 - bits);
+}
+
+// A boundary is found when the masked bits of the hash are all zero. With
+// a 16-bit mask that happens on average every 64KB; FastCDC's normalized
+// chunking uses a harder mask before the average size and an easier one
+// after it, which narrows the spread of chunk sizes around the average.
+static_assert(ChunkedBlob::kAverageChunkSize == 1 << 16);
+constexpr uint64_t kHardMask = topBitsMask(18);
+constexpr uint64_t kEasyMask = topBitsMask(14);
+
+/**
+ * Return the length of the chunk at the start of data.
+ */
+size_t findBoundary(ByteRange data) {
+  if (data.size() <= ChunkedBlob::kMinChunkSize) {
+    return data.size();
+  }
+  auto end = std::min(data.size(), ChunkedBlob::kMaxChunkSize);
+  auto average = std::min(end, ChunkedBlob::kAverageChunkSize);
+
+  uint64_t hash = 0;
+  size_t i = ChunkedBlob::kMinChunkSize;
+  for (; i < average; ++i) {
+    hash = (hash << 1) + kGear[data[i]];
+    if ((hash & kHardMask) == 0) {
+      return i + 1;
+    }
+  }
+  for (; i < end; ++i) {
+    hash = (hash << 1) + kGear[data[i]];
+    if ((hash & kEasyMask) == 0) {
+      return i + 1;
+    }
+  }
+  return end;
+}
+
+} // namespace
+
+std::vector<ByteRange> ChunkedBlob::split(ByteRange data) {
+  std::vector<ByteRange> chunks;
+  chunks.reserve(data.size() / kAverageChunkSize + 1);
+  while (!data.empty()) {
+    auto length = findBoundary(data);
+    chunks.push_back(data.subpiece(0, length));
+    data.advance(length);
+  }
+  return chunks;
+}
+
+std::string ChunkedBlob::Manifest::serialize() const {
+  auto sized = hasChunkSizes();
+  auto prefix = sized ? kSizedManifestPrefix : kManifestPrefix;
+  auto entrySize = sized ? kSizedEntrySize : Hash20::RAW_SIZE;
+  auto result = folly::to<std::string>(prefix, size);
+  result.push_back('\0');
+  result.reserve(result.size() + chunks.size() * entrySize);
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    auto bytes = chunks[i].getBytes();
+    result.append(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    if (sized) {
+      auto chunkSize = folly::Endian::big(chunkSizes[i]);
+      result.append(
+          reinterpret_cast<const char*>(&chunkSize), sizeof(chunkSize));
+    }
+  }
+  return result;
+}
+
+std::optional<ChunkedBlob::Manifest> ChunkedBlob::Manifest::tryParse(
+    ByteRange data) {
+  StringPiece piece{data};
+  bool sized;
+  if (piece.startsWith(kSizedManifestPrefix)) {
+    sized = true;
+    piece.advance(kSizedManifestPrefix.size());
+  } else if (piece.startsWith(kManifestPrefix)) {
+    sized = false;
+    piece.advance(kManifestPrefix.size());
+  } else {
+    return std::nullopt;
+  }
+
+  auto terminator = piece.find('\0');
+  if (terminator == StringPiece::npos) {
+    throw std::invalid_argument("chunked blob manifest has no size");
+  }
+  Manifest manifest;
+  manifest.size = folly::to<uint64_t>(piece.subpiece(0, terminator));
+  piece.advance(terminator + 1);
+
+  auto entrySize = sized ? kSizedEntrySize : Hash20::RAW_SIZE;
+  if (piece.size() % entrySize != 0) {
+    throw std::invalid_argument("chunked blob manifest is truncated");
+  }
+  manifest.chunks.reserve(piece.size() / entrySize);
+  if (sized) {
+    manifest.chunkSizes.reserve(piece.size() / entrySize);
+  }
+  while (!piece.empty()) {
+    manifest.chunks.emplace_back(
+        ByteRange{piece.subpiece(0, Hash20::RAW_SIZE)});
+    if (sized) {
+      manifest.chunkSizes.push_back(folly::Endian::big(
+          folly::loadUnaligned<uint32_t>(piece.data() + Hash20::RAW_SIZE)));
+    }
+    piece.advance(entrySize);
+  }
+  return manifest;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <optional>
+#include <string>
+#include <vector>
+#include "eden/fs/model/Hash.h"
+
+namespace facebook::eden {
+
+/**
+ * Large blobs can be stored in the LocalStore as a manifest in the
+ * BlobFamily key space that lists the hashes of the blob's chunks, with the
+ * chunks themselves stored in the BlobChunkFamily key space, keyed by the
+ * SHA-1 of their contents.
+ *
+ * Chunk boundaries are chosen from the contents, FastCDC-style, so an edit
+ * to a large file only changes the chunks around it. The other chunks are
+ * shared with the previous versions of the file and only stored once.
+ */
+class ChunkedBlob {
+ public:
+  /**
+   * Blobs smaller than this are always stored whole.
+   */
+  static constexpr size_t kMinBlobSize = 1024 * 1024;
+
+  static constexpr size_t kMinChunkSize = 16 * 1024;
+  static constexpr size_t kAverageChunkSize = 64 * 1024;
+  static constexpr size_t kMaxChunkSize = 256 * 1024;
+
+  /**
+   * Split data into content-defined chunks, each between kMinChunkSize and
+   * kMaxChunkSize bytes long, except for a shorter last chunk. The chunks
+   * cover data in order.
+   */
+  static std::vector<folly::ByteRange> split(folly::ByteRange data);
+
+  /**
+   * The manifest stored in place of a chunked blob.
+   *
+   * Serialized as "chunked2 <size>\0" followed by the 20-byte hash and the
+   * 4-byte big-endian size of every chunk. Manifests written before chunk
+   * sizes were recorded start with "chunked <size>\0" and only list the
+   * hashes. Whole blobs are stored git-style, starting with "blob ", so they
+   * can't be confused with either.
+   */
+  struct Manifest {
+    uint64_t size{0};
+    std::vector<Hash20> chunks;
+    /**
+     * The size of every chunk, in the same order, which lets a range of the
+     * blob be read without its other chunks. Empty for manifests that
+     * predate it.
+     */
+    std::vector<uint32_t> chunkSizes;
+
+    bool hasChunkSizes() const {
+      return chunkSizes.size() == chunks.size();
+    }
+
+    std::string serialize() const;
+
+    /**
+     * Parse a value from the BlobFamily key space, returning std::nullopt
+     * if it is not a manifest. Throws if it looks like a manifest but is
+     * malformed.
+     */
+    static std::optional<Manifest> tryParse(folly::ByteRange data);
+  };
+};
+
+} // namespace facebook::eden
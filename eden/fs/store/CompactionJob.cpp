@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/CompactionJob.h"
+
+#include <utility>
+
+namespace facebook::eden {
+
+CompactionJob::CompactionJob(size_t totalKeySpaces)
+    : totalKeySpaces_{totalKeySpaces} {}
+
+bool CompactionJob::isCancelled() const {
+  return state_.lock()->cancelled;
+}
+
+bool CompactionJob::isDone() const {
+  return state_.lock()->done;
+}
+
+void CompactionJob::cancel() {
+  auto state = state_.lock();
+  if (state->done || state->cancelled) {
+    return;
+  }
+  state->cancelled = true;
+  // Called with the lock held, so that whoever observes isCancelled() also
+  // observes the effects of the callback.
+  if (state->cancelCallback) {
+    std::exchange(state->cancelCallback, nullptr)();
+  }
+}
+
+void CompactionJob::wait() {
+  auto state = state_.lock();
+  doneCV_.wait(state.as_lock(), [&] { return state->done; });
+  if (state->error) {
+    state->error.throw_exception();
+  }
+}
+
+void CompactionJob::setCancelCallback(std::function<void()> callback) {
+  auto state = state_.lock();
+  if (state->cancelled) {
+    callback();
+  } else {
+    state->cancelCallback = std::move(callback);
+  }
+}
+
+void CompactionJob::finish(folly::exception_wrapper error) {
+  {
+    auto state = state_.lock();
+    if (state->done) {
+      return;
+    }
+    state->done = true;
+    state->error = std::move(error);
+    state->cancelCallback = nullptr;
+  }
+  doneCV_.notify_all();
+}
+
+} // namespace facebook::eden
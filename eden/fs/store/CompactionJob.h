@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/ExceptionWrapper.h>
+#include <folly/Synchronized.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+namespace facebook::eden {
+
+/**
+ * Progress of a LocalStore compaction started by
+ * LocalStore::startCompaction().
+ *
+ * A job covers a fixed number of key spaces. It can be cancelled at any
+ * time: key spaces that haven't started yet are skipped, and stores that
+ * can interrupt a compaction in progress do so. A cancelled job still
+ * completes, with getCompletedKeySpaces() less than getTotalKeySpaces().
+ *
+ * CompactionJob is thread-safe.
+ */
+class CompactionJob {
+ public:
+  explicit CompactionJob(size_t totalKeySpaces);
+
+  CompactionJob(const CompactionJob&) = delete;
+  CompactionJob& operator=(const CompactionJob&) = delete;
+
+  size_t getTotalKeySpaces() const {
+    return totalKeySpaces_;
+  }
+
+  size_t getCompletedKeySpaces() const {
+    return completedKeySpaces_.load(std::memory_order_relaxed);
+  }
+
+  bool isCancelled() const;
+  bool isDone() const;
+
+  /**
+   * Ask the job to stop as soon as possible. Does nothing if the job is
+   * already done.
+   */
+  void cancel();
+
+  /**
+   * Block until the job is done. Rethrows the first error encountered while
+   * compacting, if any.
+   */
+  void wait();
+
+  // The functions below are for the LocalStore running the job.
+
+  /**
+   * Called by cancel(), on the cancelling thread, to interrupt compactions
+   * in progress. Called immediately if the job is already cancelled. The
+   * callback runs with the job locked and must not use the job.
+   */
+  void setCancelCallback(std::function<void()> callback);
+
+  void keySpaceCompleted() {
+    completedKeySpaces_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * Mark the job as done, waking up wait(). Later calls are ignored.
+   */
+  void finish(folly::exception_wrapper error = {});
+
+ private:
+  struct State {
+    bool cancelled{false};
+    bool done{false};
+    folly::exception_wrapper error;
+    std::function<void()> cancelCallback;
+  };
+
+  const size_t totalKeySpaces_;
+  std::atomic<size_t> completedKeySpaces_{0};
+  folly::Synchronized<State, std::mutex> state_;
+  std::condition_variable doneCV_;
+};
+
+} // namespace facebook::eden
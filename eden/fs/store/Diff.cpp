@@ -17,9 +17,11 @@
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/model/TreeEntry.h"
 #include "eden/fs/model/git/GitIgnoreStack.h"
+#include "eden/fs/store/BackingStore.h"
 #include "eden/fs/store/DiffContext.h"
 #include "eden/fs/store/ObjectStore.h"
 #include "eden/fs/store/ScmStatusDiffCallback.h"
+#include "eden/fs/store/TreeDiffCache.h"
 #include "eden/fs/utils/Future.h"
 #include "eden/fs/utils/ImmediateFuture.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -181,6 +183,44 @@ FOLLY_NODISCARD Future<Unit> computeTreeDiff(
       .ensure([ignore = std::move(ignore)] {});
 }
 
+/**
+ * Load the GitIgnoreStack of a directory from its .gitignore file. Errors are
+ * logged, and treated as if the directory had no .gitignore file.
+ */
+FOLLY_NODISCARD Future<std::unique_ptr<GitIgnoreStack>> loadGitIgnoreStack(
+    const TreeEntry& gitIgnoreEntry,
+    DiffContext* context,
+    RelativePathPiece currentPath,
+    const GitIgnoreStack* parentIgnore) {
+  auto entryPath = currentPath + gitIgnoreEntry.getName();
+  auto onError = [entryPath, parentIgnore](const folly::exception_wrapper& ex) {
+    // TODO: add an API to DiffCallback to report user errors like this
+    // (errors that do not indicate a problem with EdenFS itself) that can
+    // be returned to the caller in a thrift response
+    XLOG(WARN) << "error loading gitignore at " << entryPath << ": "
+               << folly::exceptionStr(ex);
+    return make_unique<GitIgnoreStack>(parentIgnore);
+  };
+
+  // The wdTree isn't materialized, so a regular .gitignore file is the blob
+  // of its entry, which other diffs may have parsed already.
+  if (context->hasGitIgnoreCache() &&
+      gitIgnoreEntry.getDType() == dtype_t::Regular) {
+    return context->loadGitIgnore(gitIgnoreEntry.getHash())
+        .thenValue([parentIgnore](std::shared_ptr<const GitIgnore>&& ignore) {
+          return make_unique<GitIgnoreStack>(parentIgnore, std::move(ignore));
+        })
+        .thenError(std::move(onError));
+  }
+
+  auto loadFileContentsFromPath = context->getLoadFileContentsFromPath();
+  return loadFileContentsFromPath(context->getFetchContext(), entryPath)
+      .thenValue([parentIgnore](std::string&& ignoreFileContents) {
+        return make_unique<GitIgnoreStack>(parentIgnore, ignoreFileContents);
+      })
+      .thenError(std::move(onError));
+}
+
 FOLLY_NODISCARD Future<Unit> loadGitIgnoreThenDiffTrees(
     const TreeEntry& gitIgnoreEntry,
     DiffContext* context,
@@ -189,32 +229,18 @@ FOLLY_NODISCARD Future<Unit> loadGitIgnoreThenDiffTrees(
     const Tree& wdTree,
     const GitIgnoreStack* parentIgnore,
     bool isIgnored) {
-  // TODO: load file contents directly from context->store if gitIgnoreEntry is
-  // a regular file
-  auto loadFileContentsFromPath = context->getLoadFileContentsFromPath();
-  return loadFileContentsFromPath(
-             context->getFetchContext(), currentPath + gitIgnoreEntry.getName())
-      .thenError([entryPath = currentPath + gitIgnoreEntry.getName()](
-                     const folly::exception_wrapper& ex) {
-        // TODO: add an API to DiffCallback to report user errors like this
-        // (errors that do not indicate a problem with EdenFS itself) that can
-        // be returned to the caller in a thrift response
-        XLOG(WARN) << "error loading gitignore at " << entryPath << ": "
-                   << folly::exceptionStr(ex);
-        return std::string{};
-      })
+  return loadGitIgnoreStack(gitIgnoreEntry, context, currentPath, parentIgnore)
       .thenValue([context,
                   currentPath = currentPath.copy(),
                   scmTree,
                   wdTree,
-                  parentIgnore,
-                  isIgnored](std::string&& ignoreFileContents) mutable {
+                  isIgnored](std::unique_ptr<GitIgnoreStack>&& ignore) mutable {
         return computeTreeDiff(
             context,
             currentPath,
             scmTree,
             wdTree,
-            make_unique<GitIgnoreStack>(parentIgnore, ignoreFileContents),
+            std::move(ignore),
             isIgnored);
       });
 }
@@ -302,26 +328,13 @@ FOLLY_NODISCARD Future<Unit> loadGitIgnoreThenProcessAddedChildren(
     const Tree& wdTree,
     const GitIgnoreStack* parentIgnore,
     bool isIgnored) {
-  auto loadFileContentsFromPath = context->getLoadFileContentsFromPath();
-  return loadFileContentsFromPath(
-             context->getFetchContext(), currentPath + gitIgnoreEntry.getName())
-      .thenError([entryPath = currentPath + gitIgnoreEntry.getName()](
-                     const folly::exception_wrapper& ex) {
-        XLOG(WARN) << "error loading gitignore at " << entryPath << ": "
-                   << folly::exceptionStr(ex);
-        return std::string{};
-      })
+  return loadGitIgnoreStack(gitIgnoreEntry, context, currentPath, parentIgnore)
       .thenValue([context,
                   currentPath = currentPath.copy(),
                   wdTree,
-                  parentIgnore,
-                  isIgnored](std::string&& ignoreFileContents) mutable {
+                  isIgnored](std::unique_ptr<GitIgnoreStack>&& ignore) mutable {
         return processAddedChildren(
-            context,
-            currentPath,
-            wdTree,
-            make_unique<GitIgnoreStack>(parentIgnore, ignoreFileContents),
-            isIgnored);
+            context, currentPath, wdTree, std::move(ignore), isIgnored);
       });
 }
 
@@ -555,15 +568,18 @@ void processBothPresent(
         // based on the file contents (as opposed to file contents + history)
         // then we could drop this extra load of the blob SHA-1, and rely only
         // on the blob ID comparison instead.
-        auto compareEntryContents =
-            folly::makeFutureWith([context,
-                                   entryPath = currentPath + scmEntry.getName(),
-                                   &scmEntry,
-                                   &wdEntry] {
+        //
+        // The comparison may run after the trees are gone, so it can't refer
+        // to their entries.
+        auto compareEntryContents = context->runComparison(
+            [context,
+             entryPath = currentPath + scmEntry.getName(),
+             scmId = scmEntry.getHash(),
+             wdId = wdEntry.getHash()] {
               auto scmFuture = context->store->getBlobSha1(
-                  scmEntry.getHash(), context->getFetchContext());
+                  scmId, context->getFetchContext());
               auto wdFuture = context->store->getBlobSha1(
-                  wdEntry.getHash(), context->getFetchContext());
+                  wdId, context->getFetchContext());
               return collectAllSafe(scmFuture, wdFuture)
                   .thenValue([entryPath = entryPath.copy(),
                               context](const std::tuple<Hash20, Hash20>& info) {
@@ -605,6 +621,64 @@ FOLLY_NODISCARD Future<Unit> waitOnResults(
       });
 }
 
+/**
+ * Report the cached differences of two trees at currentPath.
+ */
+void replayTreeDiff(
+    DiffContext* context,
+    RelativePathPiece currentPath,
+    const ScmStatus& cached) {
+  for (const auto& [path, status] : *cached.entries_ref()) {
+    auto entryPath = currentPath + RelativePathPiece{path};
+    switch (status) {
+      case ScmFileStatus::ADDED:
+        context->callback->addedFile(entryPath);
+        break;
+      case ScmFileStatus::REMOVED:
+        context->callback->removedFile(entryPath);
+        break;
+      case ScmFileStatus::MODIFIED:
+        context->callback->modifiedFile(entryPath);
+        break;
+      case ScmFileStatus::IGNORED:
+        context->callback->ignoredFile(entryPath);
+        break;
+    }
+  }
+}
+
+/**
+ * Cache the differences between two commits, and those of the trees that
+ * were compared entry by entry to compute them.
+ */
+void cacheCommitDiff(
+    TreeDiffCache& cache,
+    DiffContext& context,
+    const RootId& root1,
+    const RootId& root2,
+    const ScmStatus& status) {
+  // A diff that failed somewhere may be missing differences anywhere below.
+  if (!status.errors_ref()->empty() || context.isCancelled()) {
+    return;
+  }
+  const auto& entries = *status.entries_ref();
+  for (auto& trees : context.takeDiffedTrees()) {
+    // The entries are sorted, so those below the trees are next to each
+    // other.
+    auto prefix = trees.path.stringPiece().str() + kDirSeparator;
+    ScmStatus treeStatus;
+    for (auto it = entries.lower_bound(prefix); it != entries.end() &&
+         folly::StringPiece{it->first}.startsWith(prefix);
+         ++it) {
+      treeStatus.entries_ref()->emplace(
+          it->first.substr(prefix.size()), it->second);
+    }
+    cache.insertTrees(
+        trees.from, trees.to, context.caseSensitive, std::move(treeStatus));
+  }
+  cache.insertRoots(root1, root2, context.caseSensitive, status);
+}
+
 /**
  * Diff two commits.
  *
@@ -637,14 +711,44 @@ diffRoots(DiffContext* context, const RootId& root1, const RootId& root2) {
 Future<std::unique_ptr<ScmStatus>> diffCommitsForStatus(
     const ObjectStore* store,
     const RootId& root1,
-    const RootId& root2) {
-  return folly::makeFutureWith([&] {
+    const RootId& root2,
+    std::shared_ptr<TreeDiffCache> cache) {
+  return folly::makeFutureWith([&]() -> Future<std::unique_ptr<ScmStatus>> {
     auto state = std::make_unique<DiffState>(store);
-    auto statePtr = state.get();
-    auto contextPtr = &(statePtr->context);
-    return diffRoots(contextPtr, root1, root2)
-        .thenValue([state = std::move(state)](auto&&) {
-          return std::make_unique<ScmStatus>(state->callback.extractStatus());
+    if (cache) {
+      if (auto cached =
+              cache->getRoots(root1, root2, state->context.caseSensitive)) {
+        return std::make_unique<ScmStatus>(*cached);
+      }
+      state->context.setTreeDiffCache(cache);
+    }
+    auto& fetchContext = state->context.getFetchContext();
+    // Backing stores that can compare the commits natively spare us loading
+    // every tree that differs.
+    return store->getBackingStore()
+        ->diffRoots(root1, root2, fetchContext)
+        .via(&folly::QueuedImmediateExecutor::instance())
+        .thenValue([state = std::move(state), root1, root2, cache](
+                       std::unique_ptr<ScmStatus> status) mutable
+                   -> Future<std::unique_ptr<ScmStatus>> {
+          if (status) {
+            if (cache) {
+              cacheCommitDiff(*cache, state->context, root1, root2, *status);
+            }
+            return std::move(status);
+          }
+          auto contextPtr = &(state->context);
+          return diffRoots(contextPtr, root1, root2)
+              .thenValue([state = std::move(state), root1, root2, cache](
+                             auto&&) {
+                auto result = std::make_unique<ScmStatus>(
+                    state->callback.extractStatus());
+                if (cache) {
+                  cacheCommitDiff(
+                      *cache, state->context, root1, root2, *result);
+                }
+                return result;
+              });
         });
   });
 }
@@ -656,6 +760,16 @@ FOLLY_NODISCARD Future<Unit> diffTrees(
     ObjectId wdHash,
     const GitIgnoreStack* ignore,
     bool isIgnored) {
+  // Diffs that load .gitignore files are never given a cache.
+  if (const auto& cache = context->getTreeDiffCache()) {
+    if (auto cached =
+            cache->getTrees(scmHash, wdHash, context->caseSensitive)) {
+      replayTreeDiff(context, currentPath, *cached);
+      return makeFuture();
+    }
+    context->recordDiffedTrees(currentPath, scmHash, wdHash);
+  }
+
   auto scmTreeFuture =
       context->store->getTree(scmHash, context->getFetchContext());
   auto wdTreeFuture =
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <memory>
+
 #include "eden/fs/service/gen-cpp2/eden_types.h"
 #include "eden/fs/utils/PathFuncs.h"
 
@@ -24,6 +26,7 @@ class Tree;
 class DiffContext;
 class GitIgnoreStack;
 class RootId;
+class TreeDiffCache;
 
 /**
  * Compute the diff between two commits.
@@ -31,12 +34,17 @@ class RootId;
  * The caller is responsible for ensuring that the ObjectStore remains valid
  * until the returned Future completes.
  *
+ * If cache is set, the diff is returned from it when it was computed before,
+ * and the differences of the subtrees compared on the way are reused from it
+ * and added to it.
+ *
  * The differences will be returned to the caller.
  */
 folly::Future<std::unique_ptr<ScmStatus>> diffCommitsForStatus(
     const ObjectStore* store,
     const RootId& root1,
-    const RootId& root2);
+    const RootId& root2,
+    std::shared_ptr<TreeDiffCache> cache = nullptr);
 
 /**
  * Compute the diff between a source control Tree and the current directory
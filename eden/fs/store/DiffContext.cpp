@@ -9,9 +9,12 @@
 
 #include <thrift/lib/cpp2/async/ResponseChannel.h>
 
+#include "eden/fs/model/Blob.h"
 #include "eden/fs/model/git/GitIgnoreStack.h"
 #include "eden/fs/model/git/TopLevelIgnores.h"
+#include "eden/fs/store/GitIgnoreCache.h"
 #include "eden/fs/store/IObjectStore.h"
+#include "eden/fs/store/ObjectStore.h"
 
 using apache::thrift::ResponseChannelRequest;
 
@@ -52,6 +55,20 @@ DiffContext::LoadFileFunction DiffContext::getLoadFileContentsFromPath() const {
   return loadFileContentsFromPath_;
 }
 
+folly::Future<std::shared_ptr<const GitIgnore>> DiffContext::loadGitIgnore(
+    const ObjectId& id) {
+  if (auto ignore = gitIgnoreCache_->get(id)) {
+    return ignore;
+  }
+  return store->getBlob(id, fetchContext_)
+      .thenValue([cache = gitIgnoreCache_,
+                  id](std::shared_ptr<const Blob> blob) {
+        std::string contents;
+        blob->getContents().appendTo(contents);
+        return cache->insert(id, contents);
+      });
+}
+
 bool DiffContext::isCancelled() const {
   // If request_ is null we do not have an associated thrift
   // request that can be cancelled, so we are always still active
@@ -61,4 +78,55 @@ bool DiffContext::isCancelled() const {
   return false;
 }
 
+folly::Future<folly::Unit> DiffContext::runComparison(
+    folly::Function<folly::Future<folly::Unit>()> compare) {
+  {
+    auto queue = comparisons_.wlock();
+    if (maxConcurrentComparisons_ != 0 &&
+        queue->inFlight >= maxConcurrentComparisons_) {
+      auto& pending = queue->pending.emplace_back(
+          PendingComparison{folly::Promise<folly::Unit>{}, std::move(compare)});
+      return pending.promise.getFuture();
+    }
+    ++queue->inFlight;
+  }
+
+  auto future = folly::makeFutureWith(std::move(compare));
+  if (future.isReady()) {
+    finishComparison();
+    return future;
+  }
+  return std::move(future).ensure([this] { finishComparison(); });
+}
+
+void DiffContext::finishComparison() {
+  // Comparisons of blobs that are already cached complete immediately, so
+  // run those in a loop rather than recursing once per pending comparison.
+  while (true) {
+    std::optional<PendingComparison> next;
+    {
+      auto queue = comparisons_.wlock();
+      if (queue->pending.empty()) {
+        --queue->inFlight;
+        return;
+      }
+      // The slot goes straight to the next comparison.
+      next.emplace(std::move(queue->pending.front()));
+      queue->pending.pop_front();
+    }
+
+    auto future = folly::makeFutureWith(std::move(next->compare));
+    if (!future.isReady()) {
+      std::move(future).thenTry(
+          [this, promise = std::move(next->promise)](
+              folly::Try<folly::Unit>&& result) mutable {
+            promise.setTry(std::move(result));
+            finishComparison();
+          });
+      return;
+    }
+    next->promise.setTry(std::move(future).getTry());
+  }
+}
+
 } // namespace facebook::eden
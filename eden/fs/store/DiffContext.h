@@ -7,9 +7,16 @@
 
 #pragma once
 
+#include <folly/Function.h>
 #include <folly/Range.h>
+#include <folly/Synchronized.h>
 #include <folly/futures/Future.h>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <vector>
 
+#include "eden/fs/model/ObjectId.h"
 #include "eden/fs/store/StatsFetchContext.h"
 #include "eden/fs/utils/PathFuncs.h"
 
@@ -27,9 +34,12 @@ class ResponseChannelRequest;
 namespace facebook::eden {
 
 class DiffCallback;
+class GitIgnore;
+class GitIgnoreCache;
 class GitIgnoreStack;
 class ObjectFetchContext;
 class ObjectStore;
+class TreeDiffCache;
 class UserInfo;
 class TopLevelIgnores;
 class EdenMount;
@@ -95,12 +105,110 @@ class DiffContext {
     return caseSensitive_;
   }
 
+  /**
+   * Run compare, which compares the contents of a pair of files, once fewer
+   * than the maximum number of other comparisons are in flight.
+   *
+   * Comparing contents is where a diff fetches blobs, so a large diff would
+   * otherwise start all of its comparisons at once, flooding the import
+   * queue and keeping every fetched blob in memory until the diff is done.
+   * Comparisons don't start other work, so limiting them can't deadlock the
+   * diff. Pending comparisons run in the order they were submitted, which
+   * is directory by directory.
+   */
+  folly::Future<folly::Unit> runComparison(
+      folly::Function<folly::Future<folly::Unit>()> compare);
+
+  /**
+   * Set how many comparisons may be in flight at once. 0 removes the limit.
+   */
+  void setMaxConcurrentComparisons(size_t maxComparisons) {
+    maxConcurrentComparisons_ = maxComparisons;
+  }
+
+  static constexpr size_t kDefaultMaxConcurrentComparisons = 1000;
+
+  /**
+   * Share the .gitignore files parsed by this diff with other diffs through
+   * cache.
+   */
+  void setGitIgnoreCache(std::shared_ptr<GitIgnoreCache> cache) {
+    gitIgnoreCache_ = std::move(cache);
+  }
+
+  bool hasGitIgnoreCache() const {
+    return gitIgnoreCache_ != nullptr;
+  }
+
+  /**
+   * Load and parse the .gitignore file stored in blob id, or return it from
+   * the GitIgnoreCache if it was already parsed. Must only be called if
+   * hasGitIgnoreCache().
+   */
+  folly::Future<std::shared_ptr<const GitIgnore>> loadGitIgnore(
+      const ObjectId& id);
+
+  /**
+   * Share the differences of the trees diffed by this diff between two
+   * commits with other diffs through cache. Only meaningful for diffs that
+   * don't load .gitignore files, since cached differences ignore them.
+   */
+  void setTreeDiffCache(std::shared_ptr<TreeDiffCache> cache) {
+    treeDiffCache_ = std::move(cache);
+  }
+
+  const std::shared_ptr<TreeDiffCache>& getTreeDiffCache() const {
+    return treeDiffCache_;
+  }
+
+  /**
+   * A pair of trees that this diff compared entry by entry, whose
+   * differences can be cached once the diff completes.
+   */
+  struct DiffedTrees {
+    RelativePath path;
+    ObjectId from;
+    ObjectId to;
+  };
+
+  void recordDiffedTrees(
+      RelativePathPiece path,
+      const ObjectId& from,
+      const ObjectId& to) {
+    diffedTrees_.wlock()->push_back(DiffedTrees{path.copy(), from, to});
+  }
+
+  std::vector<DiffedTrees> takeDiffedTrees() {
+    return std::move(*diffedTrees_.wlock());
+  }
+
  private:
+  struct PendingComparison {
+    folly::Promise<folly::Unit> promise;
+    folly::Function<folly::Future<folly::Unit>()> compare;
+  };
+  struct ComparisonQueue {
+    size_t inFlight{0};
+    std::deque<PendingComparison> pending;
+  };
+
+  /**
+   * Release the slot of a completed comparison, by running the pending
+   * comparisons that can use it.
+   */
+  void finishComparison();
+
+
   std::unique_ptr<TopLevelIgnores> topLevelIgnores_;
   const LoadFileFunction loadFileContentsFromPath_;
   apache::thrift::ResponseChannelRequest* const FOLLY_NULLABLE request_;
   StatsFetchContext fetchContext_;
   CaseSensitivity caseSensitive_;
+  size_t maxConcurrentComparisons_{kDefaultMaxConcurrentComparisons};
+  std::shared_ptr<GitIgnoreCache> gitIgnoreCache_;
+  std::shared_ptr<TreeDiffCache> treeDiffCache_;
+  folly::Synchronized<std::vector<DiffedTrees>> diffedTrees_;
+  folly::Synchronized<ComparisonQueue> comparisons_;
 };
 
 } // namespace facebook::eden
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/FetchedDirectoryHistory.h"
+
+#include <algorithm>
+
+namespace facebook::eden {
+
+FetchedDirectoryHistory::FetchedDirectoryHistory(size_t maxDirectories)
+    : maxDirectories_{std::max<size_t>(maxDirectories, 1)} {}
+
+void FetchedDirectoryHistory::recordFileFetch(RelativePathPiece path) {
+  auto directory = path.dirname().stringPiece();
+  auto counts = counts_.wlock();
+  auto it = counts->find(directory);
+  if (it != counts->end()) {
+    ++it->second;
+    return;
+  }
+
+  while (counts->size() >= maxDirectories_) {
+    for (auto entry = counts->begin(); entry != counts->end();) {
+      entry->second /= 2;
+      if (entry->second == 0) {
+        entry = counts->erase(entry);
+      } else {
+        ++entry;
+      }
+    }
+  }
+  counts->emplace(directory.str(), 1);
+}
+
+std::vector<RelativePath> FetchedDirectoryHistory::getTopDirectories(
+    size_t count) const {
+  std::vector<std::pair<uint64_t, folly::StringPiece>> sorted;
+  auto counts = counts_.rlock();
+  sorted.reserve(counts->size());
+  for (const auto& [directory, fetches] : *counts) {
+    sorted.emplace_back(fetches, directory);
+  }
+  count = std::min(count, sorted.size());
+  std::partial_sort(
+      sorted.begin(),
+      sorted.begin() + count,
+      sorted.end(),
+      [](const auto& a, const auto& b) {
+        return a.first > b.first || (a.first == b.first && a.second < b.second);
+      });
+
+  std::vector<RelativePath> result;
+  result.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    result.emplace_back(RelativePathPiece{sorted[i].second});
+  }
+  return result;
+}
+
+} // namespace facebook::eden
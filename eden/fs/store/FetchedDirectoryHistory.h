@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <string>
+#include <vector>
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * Counts how often files of each directory had to be fetched from the
+ * backing store, so that EdenFS can predict the working set of a repository
+ * from its own history, without a remote usage service.
+ *
+ * At most maxDirectories directories are tracked. When that many are, every
+ * count is halved and the directories left at zero are forgotten, so the
+ * counts favor recently used directories.
+ */
+class FetchedDirectoryHistory {
+ public:
+  explicit FetchedDirectoryHistory(size_t maxDirectories);
+
+  /** Record a fetch of the file at path. */
+  void recordFileFetch(RelativePathPiece path);
+
+  /** Up to count directories, from most to least fetched. */
+  std::vector<RelativePath> getTopDirectories(size_t count) const;
+
+ private:
+  size_t maxDirectories_;
+  /** Keyed by the directory path, supporting lookups by StringPiece. */
+  folly::Synchronized<folly::F14NodeMap<std::string, uint64_t>> counts_;
+};
+
+} // namespace facebook::eden
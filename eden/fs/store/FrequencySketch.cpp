@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/FrequencySketch.h"
+
+#include <algorithm>
+
+#include <folly/Bits.h>
+#include <folly/hash/Hash.h>
+
+namespace facebook::eden {
+
+namespace {
+// Arbitrary odd constants, one per row of the sketch.
+constexpr uint64_t kSeeds[] = {
+    0xc3a5c85c97cb3127ULL,
+    0xb492b66fbe98f273ULL,
+    0x9ae16a3b2f90404fULL,
+    0xcbf29ce484222325ULL,
+};
+
+// All 4-bit counters but the high bit of each: used to halve 16 counters at
+// once with a single shift.
+constexpr uint64_t kResetMask = 0x7777777777777777ULL;
+
+constexpr size_t kMinTableSize = 64;
+} // namespace
+
+FrequencySketch::FrequencySketch(size_t expectedEntries) {
+  // One word holds 16 counters, and every key uses kDepth of them, so one word
+  // per expected entry gives a low collision rate.
+  auto tableSize = folly::nextPowTwo(std::max(expectedEntries, kMinTableSize));
+  table_.resize(tableSize);
+  tableMask_ = tableSize - 1;
+  sampleSize_ = 10 * std::max<size_t>(expectedEntries, 1);
+}
+
+void FrequencySketch::increment(uint64_t hash) noexcept {
+  bool added = false;
+  for (size_t i = 0; i < kDepth; ++i) {
+    auto mixed = folly::hash::twang_mix64(hash ^ kSeeds[i]);
+    auto& word = table_[mixed & tableMask_];
+    auto shift = (mixed >> 60) * 4;
+    if (((word >> shift) & 0xf) < kMaxFrequency) {
+      word += uint64_t{1} << shift;
+      added = true;
+    }
+  }
+  if (added && ++additions_ >= sampleSize_) {
+    age();
+  }
+}
+
+uint32_t FrequencySketch::estimate(uint64_t hash) const noexcept {
+  uint32_t frequency = kMaxFrequency;
+  for (size_t i = 0; i < kDepth; ++i) {
+    auto mixed = folly::hash::twang_mix64(hash ^ kSeeds[i]);
+    auto word = table_[mixed & tableMask_];
+    auto shift = (mixed >> 60) * 4;
+    frequency =
+        std::min(frequency, static_cast<uint32_t>((word >> shift) & 0xf));
+  }
+  return frequency;
+}
+
+void FrequencySketch::clear() noexcept {
+  std::fill(table_.begin(), table_.end(), 0);
+  additions_ = 0;
+}
+
+void FrequencySketch::age() noexcept {
+  for (auto& word : table_) {
+    word = (word >> 1) & kResetMask;
+  }
+  additions_ /= 2;
+}
+
+} // namespace facebook::eden
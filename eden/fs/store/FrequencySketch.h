@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace facebook::eden {
+
+/**
+ * A compact, approximate access frequency counter, as used by the TinyLFU
+ * cache admission policy.
+ *
+ * This is a count-min sketch of 4-bit saturating counters, 16 of them packed
+ * per 64-bit word. Each key is counted in kDepth different counters and its
+ * frequency is estimated as the minimum of those. To let the sketch adapt to
+ * changing workloads, all counters are halved once the number of increments
+ * reaches the sample size, which is 10 times the expected number of entries.
+ *
+ * Estimates never under-count (until aged), but can over-count on hash
+ * collisions.
+ *
+ * This class is not thread-safe; callers must provide their own locking.
+ */
+class FrequencySketch {
+ public:
+  /// Largest value a single counter can hold.
+  static constexpr uint32_t kMaxFrequency = 15;
+
+  /**
+   * Size the sketch for roughly expectedEntries distinct hot keys.
+   */
+  explicit FrequencySketch(size_t expectedEntries);
+
+  /**
+   * Record one access to the key with the given hash.
+   */
+  void increment(uint64_t hash) noexcept;
+
+  /**
+   * Return the estimated number of accesses to the key with the given hash,
+   * between 0 and kMaxFrequency.
+   */
+  uint32_t estimate(uint64_t hash) const noexcept;
+
+  /**
+   * Forget all recorded accesses.
+   */
+  void clear() noexcept;
+
+  size_t getSampleSize() const noexcept {
+    return sampleSize_;
+  }
+
+ private:
+  static constexpr size_t kDepth = 4;
+
+  /**
+   * Halve every counter. Called once additions_ reaches sampleSize_.
+   */
+  void age() noexcept;
+
+  std::vector<uint64_t> table_;
+  uint64_t tableMask_;
+  size_t sampleSize_;
+  size_t additions_{0};
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/GitIgnoreCache.h"
+
+namespace facebook::eden {
+
+GitIgnoreCache::Entry::Entry(const ObjectId& id, folly::StringPiece contents)
+    : hash{id}, sizeBytes{sizeof(Entry) + 2 * contents.size()} {
+  ignore.loadFile(contents);
+}
+
+GitIgnoreCache::GitIgnoreCache(size_t maximumSizeBytes)
+    : cache_{ObjectCache<Entry, ObjectCacheFlavor::Simple>::create(
+          maximumSizeBytes,
+          /*minimumEntryCount=*/0)} {}
+
+std::shared_ptr<const GitIgnore> GitIgnoreCache::get(const ObjectId& id) {
+  auto entry = cache_->getSimple(id);
+  if (!entry) {
+    return nullptr;
+  }
+  return std::shared_ptr<const GitIgnore>{entry, &entry->ignore};
+}
+
+std::shared_ptr<const GitIgnore> GitIgnoreCache::insert(
+    const ObjectId& id,
+    folly::StringPiece contents) {
+  auto entry = std::make_shared<const Entry>(id, contents);
+  cache_->insertSimple(entry);
+  return std::shared_ptr<const GitIgnore>{entry, &entry->ignore};
+}
+
+void GitIgnoreCache::clear() {
+  cache_->clear();
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include <folly/Range.h>
+
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/model/git/GitIgnore.h"
+#include "eden/fs/store/ObjectCache.h"
+
+namespace facebook::eden {
+
+/**
+ * An in-memory LRU cache of parsed .gitignore files, keyed by the id of the
+ * blob holding their contents.
+ *
+ * Since blobs are immutable, entries never need to be invalidated: editing a
+ * .gitignore materializes it, and materialized files are not cached, while
+ * checking out another commit gives it another blob id. This lets status
+ * calls on any mount of the process reuse each other's parsed files.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class GitIgnoreCache {
+ public:
+  explicit GitIgnoreCache(size_t maximumSizeBytes);
+
+  /**
+   * Return the parsed .gitignore file stored in blob id if it is cached, or
+   * nullptr.
+   */
+  std::shared_ptr<const GitIgnore> get(const ObjectId& id);
+
+  /**
+   * Parse the contents of the .gitignore file stored in blob id, and cache
+   * the result.
+   */
+  std::shared_ptr<const GitIgnore> insert(
+      const ObjectId& id,
+      folly::StringPiece contents);
+
+  void clear();
+
+ private:
+  struct Entry {
+    Entry(const ObjectId& id, folly::StringPiece contents);
+
+    const ObjectId& getHash() const {
+      return hash;
+    }
+
+    size_t getSizeBytes() const {
+      return sizeBytes;
+    }
+
+    ObjectId hash;
+    GitIgnore ignore;
+    /** An estimate of the memory used by ignore, from its file's size. */
+    size_t sizeBytes;
+  };
+
+  std::shared_ptr<ObjectCache<Entry, ObjectCacheFlavor::Simple>> cache_;
+};
+
+} // namespace facebook::eden
@@ -102,6 +102,17 @@ class KeySpace {
       8,
       "recasdigestproxyhash",
       Deprecated{}};
+  // Chunks of large blobs, keyed by the SHA-1 of their contents. See
+  // ChunkedBlob.
+  static constexpr KeySpaceRecord BlobChunkFamily{
+      9,
+      "blobchunk",
+      Ephemeral{&EdenConfig::localStoreBlobChunkSizeLimit}};
+  // Scratch values of debugHostSelfTest(), cleared once it is done.
+  static constexpr KeySpaceRecord SelfTestFamily{
+      10,
+      "selftest",
+      Ephemeral{&EdenConfig::localStoreSelfTestSizeLimit}};
 
   static constexpr const KeySpaceRecord* kAll[] = {
       &BlobFamily,
@@ -112,7 +123,9 @@ class KeySpace {
       &BlobSizeFamily,
       &ScsProxyHashFamily,
       &TreeMetaDataFamily,
-      &ReCasDigestProxyHashFamily};
+      &ReCasDigestProxyHashFamily,
+      &BlobChunkFamily,
+      &SelfTestFamily};
   static constexpr size_t kTotalCount = std::size(kAll);
 
  private:
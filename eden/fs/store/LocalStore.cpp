@@ -13,12 +13,14 @@
 #include <folly/io/IOBuf.h>
 #include <folly/lang/Bits.h>
 #include <folly/logging/xlog.h>
+#include <algorithm>
 #include <array>
 
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/model/git/GitBlob.h"
 #include "eden/fs/model/git/GitTree.h"
+#include "eden/fs/store/ChunkedBlob.h"
 #include "eden/fs/store/SerializedBlobMetadata.h"
 #include "eden/fs/store/StoreResult.h"
 #include "eden/fs/store/TreeMetadata.h"
@@ -42,12 +44,7 @@ void LocalStore::clearDeprecatedKeySpaces() {
 }
 
 void LocalStore::clearCachesAndCompactAll() {
-  for (auto& ks : KeySpace::kAll) {
-    if (ks->isEphemeral()) {
-      clearKeySpace(ks);
-    }
-    compactKeySpace(ks);
-  }
+  startCompaction(/*clearCaches=*/true)->wait();
 }
 
 void LocalStore::clearCaches() {
@@ -59,9 +56,28 @@ void LocalStore::clearCaches() {
 }
 
 void LocalStore::compactStorage() {
-  for (auto& ks : KeySpace::kAll) {
-    compactKeySpace(ks);
+  startCompaction(/*clearCaches=*/false)->wait();
+}
+
+std::shared_ptr<CompactionJob> LocalStore::startCompaction(bool clearCaches) {
+  auto job = std::make_shared<CompactionJob>(KeySpace::kAll.size());
+  try {
+    for (auto& ks : KeySpace::kAll) {
+      if (job->isCancelled()) {
+        break;
+      }
+      if (clearCaches && ks->isEphemeral()) {
+        clearKeySpace(ks);
+      }
+      compactKeySpace(ks);
+      job->keySpaceCompleted();
+    }
+  } catch (const std::exception& ex) {
+    job->finish(folly::exception_wrapper{std::current_exception(), ex});
+    return job;
   }
+  job->finish();
+  return job;
 }
 
 StoreResult LocalStore::get(KeySpace keySpace, const ObjectId& id) const {
@@ -99,7 +115,7 @@ folly::Future<std::unique_ptr<Tree>> LocalStore::getTree(
         }
         auto try_tree = Tree::tryDeserialize(id, StringPiece{data.bytes()});
         if (try_tree) {
-          return std::make_unique<Tree>(*try_tree);
+          return std::make_unique<Tree>(std::move(*try_tree));
         }
         return deserializeGitTree(id, data.bytes());
       });
@@ -112,15 +128,147 @@ folly::Future<std::unique_ptr<Blob>> LocalStore::getBlob(
   }
 
   return getFuture(KeySpace::BlobFamily, id.getBytes())
-      .thenValue([id](StoreResult&& data) {
+      .thenValue([this, id](StoreResult&& data)
+                     -> folly::Future<std::unique_ptr<Blob>> {
         if (!data.isValid()) {
           return std::unique_ptr<Blob>(nullptr);
         }
+        if (auto manifest = ChunkedBlob::Manifest::tryParse(data.bytes())) {
+          return getChunkedBlob(id, std::move(*manifest));
+        }
         auto buf = data.extractIOBuf();
         return deserializeGitBlob(id, &buf);
       });
 }
 
+folly::Future<std::unique_ptr<Blob>> LocalStore::getChunkedBlob(
+    const ObjectId& id,
+    ChunkedBlob::Manifest manifest) const {
+  std::vector<ByteRange> keys;
+  keys.reserve(manifest.chunks.size());
+  for (const auto& chunk : manifest.chunks) {
+    keys.push_back(chunk.getBytes());
+  }
+  auto chunks = getBatch(KeySpace::BlobChunkFamily, keys);
+  // The keys point into the manifest, so it has to outlive the lookup.
+  return std::move(chunks).thenValue(
+      [id, manifest = std::move(manifest)](std::vector<StoreResult>&& results)
+          -> std::unique_ptr<Blob> {
+        IOBuf contents;
+        for (auto& result : results) {
+          if (!result.isValid()) {
+            XLOG(DBG3) << "Chunk of " << id
+                       << " was evicted from the local store";
+            return nullptr;
+          }
+          // Chain the chunks rather than copying them into one buffer.
+          contents.prependChain(
+              std::make_unique<IOBuf>(result.extractIOBuf()));
+        }
+        if (contents.computeChainDataLength() != manifest.size) {
+          throw std::invalid_argument(folly::to<string>(
+              "chunks of blob ", id, " do not add up to its size"));
+        }
+        return std::make_unique<Blob>(id, std::move(contents));
+      });
+}
+
+folly::Future<std::unique_ptr<IOBuf>>
+LocalStore::getBlobRange(const ObjectId& id, uint64_t offset, uint64_t length) {
+  if (!enableBlobCaching) {
+    return std::unique_ptr<IOBuf>(nullptr);
+  }
+
+  return getFuture(KeySpace::BlobFamily, id.getBytes())
+      .thenValue([this, id, offset, length](StoreResult&& data)
+                     -> folly::Future<std::unique_ptr<IOBuf>> {
+        if (!data.isValid()) {
+          return std::unique_ptr<IOBuf>(nullptr);
+        }
+        if (auto manifest = ChunkedBlob::Manifest::tryParse(data.bytes())) {
+          if (manifest->hasChunkSizes()) {
+            return getChunkedBlobRange(
+                id, std::move(*manifest), offset, length);
+          }
+          return getChunkedBlob(id, std::move(*manifest))
+              .thenValue([this, id, offset, length](std::unique_ptr<Blob> blob)
+                             -> std::unique_ptr<IOBuf> {
+                if (!blob) {
+                  return nullptr;
+                }
+                rechunkBlob(id, *blob);
+                return blob->getContentsRange(offset, length);
+              });
+        }
+        auto buf = data.extractIOBuf();
+        auto blob = deserializeGitBlob(id, &buf);
+        rechunkBlob(id, *blob);
+        return blob->getContentsRange(offset, length);
+      });
+}
+
+folly::Future<std::unique_ptr<IOBuf>> LocalStore::getChunkedBlobRange(
+    const ObjectId& id,
+    ChunkedBlob::Manifest manifest,
+    uint64_t offset,
+    uint64_t length) const {
+  if (offset >= manifest.size || length == 0) {
+    return IOBuf::create(0);
+  }
+  auto end = std::min(manifest.size, offset + length);
+
+  // Find the chunks overlapping [offset, end).
+  std::vector<ByteRange> keys;
+  uint64_t chunkStart = 0;
+  uint64_t rangeStart = 0;
+  for (size_t i = 0; i < manifest.chunks.size() && chunkStart < end; ++i) {
+    auto chunkEnd = chunkStart + manifest.chunkSizes[i];
+    if (chunkEnd > offset) {
+      if (keys.empty()) {
+        rangeStart = chunkStart;
+      }
+      keys.push_back(manifest.chunks[i].getBytes());
+    }
+    chunkStart = chunkEnd;
+  }
+
+  auto chunks = getBatch(KeySpace::BlobChunkFamily, keys);
+  // The keys point into the manifest, so it has to outlive the lookup.
+  return std::move(chunks).thenValue(
+      [id,
+       manifest = std::move(manifest),
+       skip = offset - rangeStart,
+       length = end - offset](std::vector<StoreResult>&& results)
+          -> std::unique_ptr<IOBuf> {
+        IOBuf contents;
+        for (auto& result : results) {
+          if (!result.isValid()) {
+            XLOG(DBG3) << "Chunk of " << id
+                       << " was evicted from the local store";
+            return nullptr;
+          }
+          contents.prependChain(
+              std::make_unique<IOBuf>(result.extractIOBuf()));
+        }
+        folly::io::Cursor cursor(&contents);
+        if (!cursor.canAdvance(skip + length)) {
+          throw std::invalid_argument(folly::to<string>(
+              "chunks of blob ", id, " do not add up to its size"));
+        }
+        cursor.skip(skip);
+        std::unique_ptr<IOBuf> range;
+        cursor.clone(range, length);
+        return range;
+      });
+}
+
+void LocalStore::rechunkBlob(const ObjectId& id, const Blob& blob) {
+  if (enableBlobChunking.load(std::memory_order_relaxed) &&
+      blob.getSize() >= ChunkedBlob::kMinBlobSize) {
+    putChunkedBlob(id, &blob);
+  }
+}
+
 folly::Future<optional<BlobMetadata>> LocalStore::getBlobMetadata(
     const ObjectId& id) const {
   return getFuture(KeySpace::BlobMetaDataFamily, id.getBytes())
@@ -133,6 +281,29 @@ folly::Future<optional<BlobMetadata>> LocalStore::getBlobMetadata(
       });
 }
 
+folly::Future<std::vector<optional<BlobMetadata>>>
+LocalStore::getBlobMetadataBatch(const std::vector<ObjectId>& ids) const {
+  std::vector<folly::ByteRange> keys;
+  keys.reserve(ids.size());
+  for (const auto& id : ids) {
+    keys.push_back(id.getBytes());
+  }
+  return getBatch(KeySpace::BlobMetaDataFamily, keys)
+      .thenValue([ids](std::vector<StoreResult>&& data) {
+        std::vector<optional<BlobMetadata>> results;
+        results.reserve(ids.size());
+        for (size_t i = 0; i < ids.size(); ++i) {
+          if (data[i].isValid()) {
+            results.emplace_back(
+                SerializedBlobMetadata::parse(ids[i], data[i]));
+          } else {
+            results.emplace_back(std::nullopt);
+          }
+        }
+        return results;
+      });
+}
+
 folly::IOBuf LocalStore::serializeTree(const Tree& tree) {
   if (!tree.isGitTreeCompatible()) {
     return tree.serialize();
@@ -172,22 +343,57 @@ void LocalStore::putBlob(const ObjectId& id, const Blob* blob) {
     // Pre-allocate a buffer of approximately the right size; it
     // needs to hold the blob content plus have room for a couple of
     // hashes for the keys, plus some padding.
+    if (enableBlobChunking.load(std::memory_order_relaxed) &&
+        blob->getSize() >= ChunkedBlob::kMinBlobSize) {
+      putChunkedBlob(id, blob);
+      return;
+    }
     auto batch = beginWrite(blob->getSize() + 64);
     batch->putBlob(id, blob);
     batch->flush();
   }
 }
 
-BlobMetadata LocalStore::putBlobMetadata(const ObjectId& id, const Blob* blob) {
-  BlobMetadata metadata{Hash20::sha1(blob->getContents()), blob->getSize()};
-  auto hashBytes = id.getBytes();
-  SerializedBlobMetadata metadataBytes(metadata);
+void LocalStore::putChunkedBlob(const ObjectId& id, const Blob* blob) {
+  const IOBuf& contents = blob->getContents();
+  ByteRange data{contents.data(), contents.length()};
+  IOBuf coalesced;
+  if (contents.isChained()) {
+    coalesced = contents.cloneCoalescedAsValue();
+    data = ByteRange{coalesced.data(), coalesced.length()};
+  }
 
-  put(KeySpace::BlobMetaDataFamily, hashBytes, metadataBytes.slice());
+  ChunkedBlob::Manifest manifest;
+  manifest.size = data.size();
+  auto batch = beginWrite(blob->getSize() + 64);
+  for (auto chunk : ChunkedBlob::split(data)) {
+    auto hash = Hash20::sha1(chunk);
+    // Chunks shared with another blob are already stored.
+    if (!hasKey(KeySpace::BlobChunkFamily, hash.getBytes())) {
+      batch->put(KeySpace::BlobChunkFamily, hash.getBytes(), chunk);
+    }
+    manifest.chunks.push_back(hash);
+    manifest.chunkSizes.push_back(static_cast<uint32_t>(chunk.size()));
+  }
+  // Written after the chunks, so a manifest is only visible once all its
+  // chunks are.
+  batch->flush();
+  put(KeySpace::BlobFamily, id.getBytes(), StringPiece{manifest.serialize()});
+}
 
+BlobMetadata LocalStore::putBlobMetadata(const ObjectId& id, const Blob* blob) {
+  BlobMetadata metadata{Hash20::sha1(blob->getContents()), blob->getSize()};
+  putBlobMetadata(id, metadata);
   return metadata;
 }
 
+void LocalStore::putBlobMetadata(
+    const ObjectId& id,
+    const BlobMetadata& metadata) {
+  SerializedBlobMetadata metadataBytes(metadata);
+  put(KeySpace::BlobMetaDataFamily, id.getBytes(), metadataBytes.slice());
+}
+
 void LocalStore::put(
     KeySpace keySpace,
     const ObjectId& id,
@@ -13,12 +13,15 @@
 #include <optional>
 #include "eden/fs/model/BlobMetadata.h"
 #include "eden/fs/model/ObjectId.h"
+#include "eden/fs/store/ChunkedBlob.h"
+#include "eden/fs/store/CompactionJob.h"
 #include "eden/fs/store/KeySpace.h"
 #include "eden/fs/utils/PathFuncs.h"
 
 namespace folly {
 template <typename T>
 class Future;
+class IOBuf;
 } // namespace folly
 
 namespace facebook::eden {
@@ -78,6 +81,16 @@ class LocalStore : public std::enable_shared_from_this<LocalStore> {
    */
   void compactStorage();
 
+  /**
+   * Compact every key space, clearing the ephemeral ones first when
+   * clearCaches is true, and return a job tracking the progress.
+   *
+   * The default implementation goes through the key spaces one after the
+   * other and only returns once they are all done. Stores that can compact
+   * in the background return immediately instead.
+   */
+  virtual std::shared_ptr<CompactionJob> startCompaction(bool clearCaches);
+
   /**
    * Clears all entries from the given KeySpace.
    */
@@ -127,6 +140,20 @@ class LocalStore : public std::enable_shared_from_this<LocalStore> {
    */
   folly::Future<std::unique_ptr<Blob>> getBlob(const ObjectId& id) const;
 
+  /**
+   * Get at most length bytes of a blob's contents, starting at offset.
+   *
+   * Only the chunks covering the range are read from blobs stored chunked.
+   * Blobs stored whole, or with a manifest that predates chunk sizes, are
+   * read whole, and are rewritten chunked if enableBlobChunking is set, so
+   * that later ranges are cheap.
+   *
+   * Returns nullptr if the blob, or one of the chunks of the range, is not
+   * present in the store, and an empty buffer if offset is past its end.
+   */
+  folly::Future<std::unique_ptr<folly::IOBuf>>
+  getBlobRange(const ObjectId& id, uint64_t offset, uint64_t length);
+
   /**
    * Get the size of a blob and the SHA-1 hash of its contents.
    *
@@ -136,6 +163,15 @@ class LocalStore : public std::enable_shared_from_this<LocalStore> {
   folly::Future<std::optional<BlobMetadata>> getBlobMetadata(
       const ObjectId& id) const;
 
+  /**
+   * Get the metadata of several blobs with a single getBatch() call.
+   *
+   * The result has one entry per id, in the same order, which is
+   * std::nullopt if that key is not present in the store.
+   */
+  folly::Future<std::vector<std::optional<BlobMetadata>>> getBlobMetadataBatch(
+      const std::vector<ObjectId>& ids) const;
+
   /**
    * Test whether the key is stored.
    */
@@ -157,6 +193,11 @@ class LocalStore : public std::enable_shared_from_this<LocalStore> {
    */
   BlobMetadata putBlobMetadata(const ObjectId& id, const Blob* blob);
 
+  /**
+   * Store a blob metadata obtained without the blob.
+   */
+  void putBlobMetadata(const ObjectId& id, const BlobMetadata& metadata);
+
   /**
    * Put arbitrary data in the store.
    */
@@ -246,6 +287,13 @@ class LocalStore : public std::enable_shared_from_this<LocalStore> {
    */
   std::atomic<bool> enableBlobCaching = true;
 
+  /**
+   * Whether putBlob() stores large blobs as content-defined chunks, see
+   * ChunkedBlob. Blobs are read back either way. Updated by EdenServer from
+   * the configuration, like enableBlobCaching.
+   */
+  std::atomic<bool> enableBlobChunking = false;
+
  private:
   /**
    * Compute the serialized version of the tree in a (not coalesced) IOBuf.
@@ -255,6 +303,36 @@ class LocalStore : public std::enable_shared_from_this<LocalStore> {
    * two phase import.
    */
   static folly::IOBuf serializeTree(const Tree& tree);
+
+  /**
+   * Store the blob's chunks in BlobChunkFamily and its manifest in
+   * BlobFamily.
+   */
+  void putChunkedBlob(const ObjectId& id, const Blob* blob);
+
+  /**
+   * Reassemble a blob from the chunks listed in its manifest. Returns
+   * nullptr if any chunk is missing from the store.
+   */
+  folly::Future<std::unique_ptr<Blob>> getChunkedBlob(
+      const ObjectId& id,
+      ChunkedBlob::Manifest manifest) const;
+
+  /**
+   * Read the chunks of a blob covering a range. The manifest must have chunk
+   * sizes.
+   */
+  folly::Future<std::unique_ptr<folly::IOBuf>> getChunkedBlobRange(
+      const ObjectId& id,
+      ChunkedBlob::Manifest manifest,
+      uint64_t offset,
+      uint64_t length) const;
+
+  /**
+   * Rewrite a blob that was read whole as chunks with sizes, if chunking
+   * is enabled and the blob is large enough.
+   */
+  void rechunkBlob(const ObjectId& id, const Blob& blob);
 };
 
 } // namespace facebook::eden
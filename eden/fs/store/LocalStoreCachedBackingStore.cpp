@@ -77,6 +77,14 @@ LocalStoreCachedBackingStore::getLocalBlobMetadata(
   return backingStore_->getLocalBlobMetadata(id, context);
 }
 
+folly::SemiFuture<std::unique_ptr<BlobMetadata>>
+LocalStoreCachedBackingStore::getBlobMetadata(
+    const ObjectId& id,
+    ObjectFetchContext& context) {
+  // ObjectStore stores the metadata in the LocalStore itself.
+  return backingStore_->getBlobMetadata(id, context);
+}
+
 folly::SemiFuture<BackingStore::GetBlobRes>
 LocalStoreCachedBackingStore::getBlob(
     const ObjectId& id,
@@ -108,6 +116,54 @@ LocalStoreCachedBackingStore::getBlob(
       });
 }
 
+folly::SemiFuture<std::unique_ptr<folly::IOBuf>>
+LocalStoreCachedBackingStore::getBlobRange(
+    const ObjectId& id,
+    uint64_t offset,
+    uint64_t length,
+    ObjectFetchContext& context) {
+  return localStore_->getBlobRange(id, offset, length)
+      .thenValue([id = id,
+                  offset,
+                  length,
+                  &context,
+                  localStore = localStore_,
+                  backingStore = backingStore_,
+                  stats = stats_](std::unique_ptr<folly::IOBuf> range) mutable {
+        if (range) {
+          stats->getObjectStoreStatsForCurrentThread()
+              .getBlobFromLocalStore.addValue(1);
+          return folly::makeSemiFuture(std::move(range));
+        }
+
+        // The backing store fetches the whole blob anyway, so store all of
+        // it: the next ranges are then read from the LocalStore.
+        return backingStore->getBlob(id, context)
+            .deferValue([localStore = std::move(localStore),
+                         stats = std::move(stats),
+                         id,
+                         offset,
+                         length](BackingStore::GetBlobRes result)
+                            -> std::unique_ptr<folly::IOBuf> {
+              if (!result.blob) {
+                return nullptr;
+              }
+              localStore->putBlob(id, result.blob.get());
+              stats->getObjectStoreStatsForCurrentThread()
+                  .getBlobFromBackingStore.addValue(1);
+              return result.blob->getContentsRange(offset, length);
+            });
+      });
+}
+
+folly::SemiFuture<std::unique_ptr<ScmStatus>>
+LocalStoreCachedBackingStore::diffRoots(
+    const RootId& root1,
+    const RootId& root2,
+    ObjectFetchContext& context) {
+  return backingStore_->diffRoots(root1, root2, context);
+}
+
 folly::SemiFuture<folly::Unit> LocalStoreCachedBackingStore::prefetchBlobs(
     ObjectIdRange ids,
     ObjectFetchContext& context) {
@@ -127,6 +183,11 @@ LocalStoreCachedBackingStore::stopRecordingFetch() {
   return backingStore_->stopRecordingFetch();
 }
 
+std::vector<RelativePath>
+LocalStoreCachedBackingStore::getMostFetchedDirectories(size_t count) {
+  return backingStore_->getMostFetchedDirectories(count);
+}
+
 folly::SemiFuture<folly::Unit>
 LocalStoreCachedBackingStore::importManifestForRoot(
     const RootId& rootId,
@@ -156,4 +217,9 @@ std::optional<folly::StringPiece> LocalStoreCachedBackingStore::getRepoName() {
   return backingStore_->getRepoName();
 }
 
+std::optional<ObjectId> LocalStoreCachedBackingStore::migrateObjectId(
+    const ObjectId& id) {
+  return backingStore_->migrateObjectId(id);
+}
+
 } // namespace facebook::eden
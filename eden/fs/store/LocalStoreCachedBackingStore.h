@@ -48,11 +48,25 @@ class LocalStoreCachedBackingStore : public BackingStore {
   folly::SemiFuture<GetBlobRes> getBlob(
       const ObjectId& id,
       ObjectFetchContext& context) override;
+  folly::SemiFuture<std::unique_ptr<folly::IOBuf>> getBlobRange(
+      const ObjectId& id,
+      uint64_t offset,
+      uint64_t length,
+      ObjectFetchContext& context) override;
 
   std::unique_ptr<BlobMetadata> getLocalBlobMetadata(
       const ObjectId& id,
       ObjectFetchContext& context) override;
 
+  folly::SemiFuture<std::unique_ptr<BlobMetadata>> getBlobMetadata(
+      const ObjectId& id,
+      ObjectFetchContext& context) override;
+
+  folly::SemiFuture<std::unique_ptr<ScmStatus>> diffRoots(
+      const RootId& root1,
+      const RootId& root2,
+      ObjectFetchContext& context) override;
+
   FOLLY_NODISCARD folly::SemiFuture<folly::Unit> prefetchBlobs(
       ObjectIdRange ids,
       ObjectFetchContext& context) override;
@@ -61,6 +75,7 @@ class LocalStoreCachedBackingStore : public BackingStore {
 
   void startRecordingFetch() override;
   std::unordered_set<std::string> stopRecordingFetch() override;
+  std::vector<RelativePath> getMostFetchedDirectories(size_t count) override;
 
   folly::SemiFuture<folly::Unit> importManifestForRoot(
       const RootId& rootId,
@@ -72,6 +87,7 @@ class LocalStoreCachedBackingStore : public BackingStore {
   std::string renderObjectId(const ObjectId& objectId) override;
 
   std::optional<folly::StringPiece> getRepoName() override;
+  std::optional<ObjectId> migrateObjectId(const ObjectId& id) override;
 
   /**
    * Get the underlying BackingStore. This should only be used for operations
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/LocalStoreStats.h"
+
+#include <folly/Conv.h>
+
+#include "eden/fs/telemetry/EdenStats.h"
+
+namespace facebook::eden {
+
+namespace {
+
+constexpr folly::StringPiece kOperationNames[] = {"get", "get_batch", "put"};
+
+fb303::detail::QuantileStatWrapper createStat(const std::string& name) {
+  return fb303::detail::QuantileStatWrapper{
+      name,
+      fb303::ExportTypeConsts::kSumCountAvgRate,
+      kStatQuantiles,
+      fb303::SlidingWindowPeriodConsts::kOneMinTenMinHour,
+  };
+}
+
+} // namespace
+
+LocalStoreStats::OperationStats::OperationStats(
+    const std::string& latencyName,
+    const std::string& bytesName)
+    : latency{createStat(latencyName)}, bytes{createStat(bytesName)} {}
+
+LocalStoreStats::LocalStoreStats(const std::string& prefix)
+    : writeBatchFlush_{
+          createStat(folly::to<std::string>(prefix, "write_batch.flush_us"))} {
+  static_assert(std::size(kOperationNames) == kOperationCount);
+  keySpaces_.resize(KeySpace::kTotalCount);
+  for (const auto& ks : KeySpace::kAll) {
+    if (ks->isDeprecated()) {
+      continue;
+    }
+    for (auto name : kOperationNames) {
+      auto stem = folly::to<std::string>(prefix, ks->name, '.', name);
+      keySpaces_[ks->index].emplace_back(stem + "_us", stem + "_bytes");
+    }
+  }
+}
+
+LocalStoreStats::OperationStats* LocalStoreStats::statsFor(
+    KeySpace keySpace,
+    Operation operation) {
+  auto& operations = keySpaces_[keySpace->index];
+  if (operations.empty()) {
+    return nullptr;
+  }
+  return &operations[static_cast<size_t>(operation)];
+}
+
+void LocalStoreStats::recordLatency(
+    KeySpace keySpace,
+    Operation operation,
+    std::chrono::microseconds elapsed) {
+  if (auto* stats = statsFor(keySpace, operation)) {
+    stats->latency.addValue(elapsed.count());
+  }
+}
+
+void LocalStoreStats::recordBytes(
+    KeySpace keySpace,
+    Operation operation,
+    size_t bytes) {
+  if (auto* stats = statsFor(keySpace, operation)) {
+    stats->bytes.addValue(bytes);
+  }
+}
+
+void LocalStoreStats::recordWriteBatchFlush(std::chrono::microseconds elapsed) {
+  writeBatchFlush_.addValue(elapsed.count());
+}
+
+} // namespace facebook::eden
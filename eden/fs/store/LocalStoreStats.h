@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <fb303/detail/QuantileStatWrappers.h>
+#include <chrono>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "eden/fs/store/KeySpace.h"
+
+namespace facebook::eden {
+
+/**
+ * Per-KeySpace operation counts, byte counts and latency histograms of a
+ * LocalStore.
+ *
+ * Stats are exported through fb303, like the EdenStats thread stats, and
+ * therefore show up in the counters returned by getStatInfo():
+ *
+ *   <prefix><keyspace>.<operation>_us     latency in microseconds
+ *   <prefix><keyspace>.<operation>_bytes  size of the values read or written
+ *   <prefix>write_batch.flush_us          latency of committing a WriteBatch
+ *
+ * The count of a latency stat is the number of operations. A get that
+ * misses contributes to the latency but not to the bytes.
+ *
+ * The underlying fb303 stats are thread safe, so one LocalStoreStats can
+ * be shared by every thread using the store.
+ */
+class LocalStoreStats {
+ public:
+  enum class Operation {
+    Get,
+    GetBatch,
+    Put,
+  };
+
+  explicit LocalStoreStats(const std::string& prefix);
+
+  void recordLatency(
+      KeySpace keySpace,
+      Operation operation,
+      std::chrono::microseconds elapsed);
+
+  void recordBytes(KeySpace keySpace, Operation operation, size_t bytes);
+
+  void recordWriteBatchFlush(std::chrono::microseconds elapsed);
+
+ private:
+  using Stat = fb303::detail::QuantileStatWrapper;
+
+  static constexpr size_t kOperationCount = 3;
+
+  struct OperationStats {
+    OperationStats(
+        const std::string& latencyName,
+        const std::string& bytesName);
+
+    Stat latency;
+    Stat bytes;
+  };
+
+  /**
+   * Returns nullptr for deprecated key spaces, which aren't tracked.
+   */
+  OperationStats* statsFor(KeySpace keySpace, Operation operation);
+
+  /**
+   * Indexed by KeySpace index, then by Operation. A deque, since stats
+   * can't be moved.
+   */
+  std::vector<std::deque<OperationStats>> keySpaces_;
+  Stat writeBatchFlush_;
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/NegativeLookupCache.h"
+
+namespace facebook::eden {
+
+NegativeLookupCache::NegativeLookupCache(
+    size_t maximumEntries,
+    Clock::duration ttl)
+    : ttl_{ttl}, state_{folly::in_place, maximumEntries} {}
+
+void NegativeLookupCache::insert(
+    const ObjectId& id,
+    uint64_t generation,
+    Clock::time_point now) {
+  auto state = state_.wlock();
+  // Checked under the lock so that invalidate(), which bumps the generation
+  // while holding it, cannot interleave with this insert.
+  if (generation != getGeneration()) {
+    return;
+  }
+  state->entries.set(id, Entry{now + ttl_});
+  ++state->insertCount;
+}
+
+bool NegativeLookupCache::contains(
+    const ObjectId& id,
+    Clock::time_point now) {
+  // A hit promotes the entry in the LRU, so a write lock is needed either way.
+  auto state = state_.wlock();
+  auto iter = state->entries.find(id);
+  if (iter == state->entries.end()) {
+    ++state->missCount;
+    return false;
+  }
+  if (iter->second.expiry <= now) {
+    state->entries.erase(iter);
+    ++state->expiredCount;
+    ++state->missCount;
+    return false;
+  }
+  ++state->hitCount;
+  return true;
+}
+
+void NegativeLookupCache::erase(const ObjectId& id) {
+  state_.wlock()->entries.erase(id);
+}
+
+void NegativeLookupCache::invalidate() {
+  auto state = state_.wlock();
+  generation_.fetch_add(1, std::memory_order_acq_rel);
+  state->entries.clear();
+  ++state->invalidationCount;
+}
+
+NegativeLookupCache::Stats NegativeLookupCache::getStats() const {
+  auto state = state_.rlock();
+  Stats stats;
+  stats.entryCount = state->entries.size();
+  stats.hitCount = state->hitCount;
+  stats.missCount = state->missCount;
+  stats.insertCount = state->insertCount;
+  stats.expiredCount = state->expiredCount;
+  stats.invalidationCount = state->invalidationCount;
+  return stats;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+
+#include "eden/fs/model/ObjectId.h"
+
+namespace facebook::eden {
+
+/**
+ * A bounded, in-memory record of objects that were recently looked up and
+ * found to not exist, so that repeated lookups of the same missing object can
+ * fail fast instead of going to the LocalStore and BackingStore again.
+ *
+ * Entries expire after a fixed TTL. In addition, the cache carries a
+ * generation number: invalidate() drops every entry and bumps the generation,
+ * and insertions tagged with an older generation are ignored. Callers should
+ * read the generation before starting a lookup and pass it back when
+ * recording the miss, so a lookup that raced with an invalidation (e.g. a pull
+ * that made the object available) does not record a stale negative result.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class NegativeLookupCache {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Stats {
+    size_t entryCount{0};
+    uint64_t hitCount{0};
+    uint64_t missCount{0};
+    uint64_t insertCount{0};
+    uint64_t expiredCount{0};
+    uint64_t invalidationCount{0};
+  };
+
+  NegativeLookupCache(size_t maximumEntries, Clock::duration ttl);
+
+  /**
+   * Return the current generation, to be passed to insert().
+   */
+  uint64_t getGeneration() const noexcept {
+    return generation_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Record that the object does not exist, unless the cache was invalidated
+   * since generation was obtained.
+   */
+  void insert(
+      const ObjectId& id,
+      uint64_t generation,
+      Clock::time_point now = Clock::now());
+
+  /**
+   * Returns true if the object was recently recorded as missing.
+   */
+  bool contains(const ObjectId& id, Clock::time_point now = Clock::now());
+
+  /**
+   * Forget the object, e.g. because it was just found after all.
+   */
+  void erase(const ObjectId& id);
+
+  /**
+   * Drop every entry and bump the generation.
+   */
+  void invalidate();
+
+  Stats getStats() const;
+
+ private:
+  struct Entry {
+    Clock::time_point expiry;
+  };
+
+  struct State {
+    explicit State(size_t maximumEntries) : entries{maximumEntries} {}
+
+    folly::EvictingCacheMap<ObjectId, Entry> entries;
+    uint64_t hitCount{0};
+    uint64_t missCount{0};
+    uint64_t insertCount{0};
+    uint64_t expiredCount{0};
+    uint64_t invalidationCount{0};
+  };
+
+  const Clock::duration ttl_;
+  std::atomic<uint64_t> generation_{0};
+  folly::Synchronized<State> state_;
+};
+
+} // namespace facebook::eden
@@ -6,7 +6,9 @@
  */
 
 #include <folly/MapUtil.h>
+#include <folly/hash/Hash.h>
 #include <folly/logging/xlog.h>
+#include <algorithm>
 #include <utility>
 
 #include "eden/fs/store/ObjectCache.h"
@@ -61,20 +63,53 @@ template <typename ObjectType, ObjectCacheFlavor Flavor>
 std::shared_ptr<ObjectCache<ObjectType, Flavor>>
 ObjectCache<ObjectType, Flavor>::create(
     size_t maximumCacheSizeBytes,
-    size_t minimumEntryCount) {
+    size_t minimumEntryCount,
+    size_t numShards,
+    ObjectCacheEvictionPolicy policy) {
   // Allow make_shared with private constructor.
   struct OC : ObjectCache<ObjectType, Flavor> {
-    OC(size_t x, size_t y) : ObjectCache<ObjectType, Flavor>{x, y} {}
+    OC(size_t x, size_t y, size_t z, ObjectCacheEvictionPolicy p)
+        : ObjectCache<ObjectType, Flavor>{x, y, z, p} {}
   };
-  return std::make_shared<OC>(maximumCacheSizeBytes, minimumEntryCount);
+  return std::make_shared<OC>(
+      maximumCacheSizeBytes, minimumEntryCount, numShards, policy);
 }
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 ObjectCache<ObjectType, Flavor>::ObjectCache(
     size_t maximumCacheSizeBytes,
-    size_t minimumEntryCount)
+    size_t minimumEntryCount,
+    size_t numShards,
+    ObjectCacheEvictionPolicy policy)
     : maximumCacheSizeBytes_{maximumCacheSizeBytes},
-      minimumEntryCount_{minimumEntryCount} {}
+      minimumEntryCount_{minimumEntryCount},
+      shards_(std::max<size_t>(numShards, 1)),
+      shardMaximumSizeBytes_{maximumCacheSizeBytes / shards_.size()},
+      shardMinimumEntryCount_{
+          (minimumEntryCount + shards_.size() - 1) / shards_.size()} {
+  if (policy == ObjectCacheEvictionPolicy::TinyLfu) {
+    // The number of objects that fit is unknown up front, so size the sketch
+    // assuming small objects. Over-sizing it only costs a few bytes per entry.
+    constexpr size_t kAssumedObjectSize = 4096;
+    auto expectedEntries = std::max(
+        getShardMaximumSize() / kAssumedObjectSize, shardMinimumEntryCount_);
+    for (auto& shard : shards_) {
+      shard.state.sketch.emplace(expectedEntries);
+    }
+  }
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+typename ObjectCache<ObjectType, Flavor>::Shard&
+ObjectCache<ObjectType, Flavor>::getShard(const ObjectId& hash) const {
+  if (shards_.size() == 1) {
+    return shards_[0];
+  }
+  // ObjectId hashes of hg proxy hashes are not necessarily well distributed in
+  // their low bits, so mix them before picking a shard.
+  auto index = folly::hash::twang_mix64(hash.getHashCode()) % shards_.size();
+  return shards_[index];
+}
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 template <ObjectCacheFlavor F>
@@ -90,7 +125,7 @@ ObjectCache<ObjectType, Flavor>::getInterestHandle(
   // runs after the lock is released.
   ObjectInterestHandle<ObjectType> interestHandle;
 
-  auto state = lockState();
+  auto state = lockState(hash);
 
   auto item = getImpl(hash, state);
   if (!item) {
@@ -129,7 +164,7 @@ typename std::enable_if_t<
     typename ObjectCache<ObjectType, Flavor>::ObjectPtr>
 ObjectCache<ObjectType, Flavor>::getSimple(const ObjectId& hash) {
   XLOG(DBG6) << "BlobCache::getSimple " << hash;
-  auto state = lockState();
+  auto state = lockState(hash);
 
   if (auto item = getImpl(hash, state)) {
     return item->object;
@@ -143,6 +178,10 @@ ObjectCache<ObjectType, Flavor>::getImpl(
     const ObjectId& hash,
     LockedState& state) {
   XLOG(DBG6) << "ObjectCache::getImpl " << hash;
+  if (state->sketch) {
+    state->sketch->increment(hash.getHashCode());
+  }
+
   auto* item = folly::get_ptr(state->items, hash);
   if (!item) {
     XLOG(DBG6) << "ObjectCache::getImpl missed";
@@ -190,8 +229,15 @@ ObjectCache<ObjectType, Flavor>::insertInterestHandle(
 
   XLOG(DBG6) << "  creating entry with generation=" << cacheItemGeneration;
 
-  auto state = lockState();
+  auto state = lockState(object->getHash());
   auto [item, inserted] = insertImpl(object, state);
+  if (!item) {
+    XLOG(DBG6) << "entry rejected by admission policy";
+    // The handle can still be used to retrieve the object while it is alive,
+    // but it no longer refers to a cache entry.
+    interestHandle.cacheItemGeneration_ = 0;
+    return interestHandle;
+  }
   switch (interest) {
     case Interest::UnlikelyNeededAgain:
       break;
@@ -219,8 +265,15 @@ typename std::enable_if_t<F == ObjectCacheFlavor::Simple, void>
 ObjectCache<ObjectType, Flavor>::insertSimple(
     ObjectCache<ObjectType, Flavor>::ObjectPtr object) {
   XLOG(DBG6) << "ObjectCache::insertSimple " << object->getHash();
-  auto state = lockState();
-  insertImpl(object, state);
+  std::vector<ObjectPtr> evicted;
+  {
+    auto state = lockState(object->getHash());
+    insertImpl(object, state);
+    evicted.swap(state->pendingEvictions);
+  }
+  if (!evicted.empty()) {
+    evictionObserver_(std::move(evicted));
+  }
 }
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
@@ -233,6 +286,14 @@ ObjectCache<ObjectType, Flavor>::insertImpl(
   auto hash = object->getHash();
   auto size = object->getSizeBytes();
 
+  if (state->sketch) {
+    state->sketch->increment(hash.getHashCode());
+    if (!state->items.count(hash) && !shouldAdmit(hash, size, state)) {
+      ++state->admissionRejectCount;
+      return std::make_pair(nullptr, false);
+    }
+  }
+
   // the following should be no except
 
   auto [iter, inserted] =
@@ -248,6 +309,7 @@ ObjectCache<ObjectType, Flavor>::insertImpl(
     }
     iter->second.index = std::prev(state->evictionQueue.end());
     state->totalSize += size;
+    ++state->insertCount;
     evictUntilFits(state);
   } else {
     state->evictionQueue.splice(
@@ -256,32 +318,140 @@ ObjectCache<ObjectType, Flavor>::insertImpl(
   return std::make_pair(itemPtr, inserted);
 }
 
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+bool ObjectCache<ObjectType, Flavor>::shouldAdmit(
+    const ObjectId& hash,
+    size_t size,
+    LockedState& state) {
+  if (!state->sketch) {
+    return true;
+  }
+  // Nothing would be evicted by this insert, so there is no reason to refuse
+  // it.
+  if (state->evictionQueue.empty() ||
+      state->totalSize + size <= getShardMaximumSize() ||
+      state->evictionQueue.size() + 1 <= shardMinimumEntryCount_) {
+    return true;
+  }
+  // Only compare against the first victim. Large candidates may end up
+  // evicting more than one object, but that is what LRU would do as well.
+  const auto& victimHash = state->evictionQueue.front()->object->getHash();
+  return state->sketch->estimate(hash.getHashCode()) >
+      state->sketch->estimate(victimHash.getHashCode());
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+void ObjectCache<ObjectType, Flavor>::setMaximumSize(
+    size_t maximumCacheSizeBytes) {
+  maximumCacheSizeBytes_.store(
+      maximumCacheSizeBytes, std::memory_order_relaxed);
+  shardMaximumSizeBytes_.store(
+      maximumCacheSizeBytes / shards_.size(), std::memory_order_relaxed);
+  for (auto& shard : shards_) {
+    std::vector<ObjectPtr> evicted;
+    {
+      auto state = lockShard(shard);
+      evictUntilFits(state);
+      evicted.swap(state->pendingEvictions);
+    }
+    if (!evicted.empty()) {
+      evictionObserver_(std::move(evicted));
+    }
+  }
+}
+
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 bool ObjectCache<ObjectType, Flavor>::contains(const ObjectId& hash) const {
-  auto state = lockState();
+  auto state = lockState(hash);
   return 1 == state->items.count(hash);
 }
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 void ObjectCache<ObjectType, Flavor>::clear() {
   XLOG(DBG6) << "ObjectCache::clear";
-  auto state = lockState();
-  state->totalSize = 0;
-  state->items.clear();
-  state->evictionQueue.clear();
+  for (auto& shard : shards_) {
+    auto state = lockShard(shard);
+    state->totalSize = 0;
+    state->items.clear();
+    state->evictionQueue.clear();
+  }
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+std::vector<CacheHotKey> ObjectCache<ObjectType, Flavor>::getHotKeys(
+    size_t limit) const {
+  std::vector<std::vector<CacheHotKey>> perShard;
+  perShard.reserve(shards_.size());
+  auto shardLimit = (limit + shards_.size() - 1) / shards_.size();
+  for (auto& shard : shards_) {
+    auto& keys = perShard.emplace_back();
+    auto state = lockShard(shard);
+    keys.reserve(std::min(shardLimit, state->evictionQueue.size()));
+    for (auto it = state->evictionQueue.rbegin();
+         it != state->evictionQueue.rend() && keys.size() < shardLimit;
+         ++it) {
+      const auto& id = (*it)->object->getHash();
+      auto frequency = static_cast<uint8_t>(
+          state->sketch ? state->sketch->estimate(id.getHashCode()) : 0);
+      keys.push_back(CacheHotKey{id, frequency});
+    }
+  }
+
+  size_t total = 0;
+  for (const auto& keys : perShard) {
+    total += keys.size();
+  }
+  std::vector<CacheHotKey> result;
+  result.reserve(std::min(limit, total));
+  for (size_t i = 0; result.size() < limit; ++i) {
+    bool any = false;
+    for (auto& keys : perShard) {
+      if (i < keys.size() && result.size() < limit) {
+        result.push_back(std::move(keys[i]));
+        any = true;
+      }
+    }
+    if (!any) {
+      break;
+    }
+  }
+  return result;
 }
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 typename ObjectCache<ObjectType, Flavor>::Stats
 ObjectCache<ObjectType, Flavor>::getStats() const {
-  auto state = lockState();
   Stats stats;
-  stats.objectCount = state->items.size();
-  stats.totalSizeInBytes = state->totalSize;
-  stats.hitCount = state->hitCount;
-  stats.missCount = state->missCount;
-  stats.evictionCount = state->evictionCount;
-  stats.dropCount = state->dropCount;
+  if (shards_.size() > 1) {
+    stats.shardStats.reserve(shards_.size());
+  }
+  // Shards are locked one at a time, so the totals are not an atomic snapshot
+  // across the whole cache, but they are consistent within each shard.
+  for (auto& shard : shards_) {
+    Stats shardStats;
+    {
+      auto state = lockShard(shard);
+      shardStats.objectCount = state->items.size();
+      shardStats.totalSizeInBytes = state->totalSize;
+      shardStats.hitCount = state->hitCount;
+      shardStats.missCount = state->missCount;
+      shardStats.evictionCount = state->evictionCount;
+      shardStats.dropCount = state->dropCount;
+      shardStats.insertCount = state->insertCount;
+      shardStats.admissionRejectCount = state->admissionRejectCount;
+    }
+    stats.objectCount += shardStats.objectCount;
+    stats.totalSizeInBytes += shardStats.totalSizeInBytes;
+    stats.hitCount += shardStats.hitCount;
+    stats.missCount += shardStats.missCount;
+    stats.evictionCount += shardStats.evictionCount;
+    stats.dropCount += shardStats.dropCount;
+    stats.insertCount += shardStats.insertCount;
+    stats.admissionRejectCount += shardStats.admissionRejectCount;
+    if (shards_.size() > 1) {
+      stats.shardStats.push_back(std::move(shardStats));
+    }
+  }
   return stats;
 }
 
@@ -290,7 +460,7 @@ void ObjectCache<ObjectType, Flavor>::dropInterestHandle(
     const ObjectId& hash,
     uint64_t generation) noexcept {
   XLOG(DBG6) << "dropInterestHandle " << hash << " generation=" << generation;
-  auto state = lockState();
+  auto state = lockState(hash);
 
   auto* item = folly::get_ptr(state->items, hash);
   if (!item) {
@@ -321,13 +491,14 @@ void ObjectCache<ObjectType, Flavor>::dropInterestHandle(
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 void ObjectCache<ObjectType, Flavor>::evictUntilFits(
     LockedState& state) noexcept {
+  auto shardMaximumSizeBytes = getShardMaximumSize();
   XLOG(DBG6) << "ObjectCache::evictUntilFits "
              << "state.totalSize=" << state->totalSize
-             << ", maximumCacheSizeBytes_=" << maximumCacheSizeBytes_
+             << ", shardMaximumSizeBytes_=" << shardMaximumSizeBytes
              << ", evictionQueue.size()=" << state->evictionQueue.size()
-             << ", minimumEntryCount_=" << minimumEntryCount_;
-  while (state->totalSize > maximumCacheSizeBytes_ &&
-         state->evictionQueue.size() > minimumEntryCount_) {
+             << ", shardMinimumEntryCount_=" << shardMinimumEntryCount_;
+  while (state->totalSize > shardMaximumSizeBytes &&
+         state->evictionQueue.size() > shardMinimumEntryCount_) {
     evictOne(state);
   }
 }
@@ -337,6 +508,16 @@ void ObjectCache<ObjectType, Flavor>::evictOne(LockedState& state) noexcept {
   CacheItem* front = state->evictionQueue.front();
   state->evictionQueue.pop_front();
   ++state->evictionCount;
+  // Only insertSimple drains pendingEvictions.
+  if (Flavor == ObjectCacheFlavor::Simple && evictionObserver_) {
+    // Keep the object alive until the observer has seen it. This also defers
+    // running its destructor until after the lock is released.
+    try {
+      state->pendingEvictions.push_back(front->object);
+    } catch (const std::bad_alloc&) {
+      XLOG(WARN) << "dropping eviction notification: out of memory";
+    }
+  }
   evictItem(state, front);
 }
 
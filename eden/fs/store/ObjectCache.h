@@ -7,18 +7,57 @@
 
 #pragma once
 
+#include <atomic>
+#include <functional>
 #include <list>
 #include <mutex>
+#include <optional>
 #include <unordered_map>
+#include <vector>
 
+#include <folly/lang/Align.h>
 #include <folly/synchronization/DistributedMutex.h>
 
 #include "eden/fs/model/ObjectId.h"
+#include "eden/fs/store/FrequencySketch.h"
+#include "eden/fs/telemetry/LockProfiling.h"
 
 namespace facebook::eden {
 
 enum class ObjectCacheFlavor { Simple, InterestHandle };
 
+/**
+ * Decides which objects an ObjectCache keeps once it is full.
+ */
+enum class ObjectCacheEvictionPolicy {
+  /**
+   * Every inserted object is admitted, and the least recently used objects
+   * are evicted to make room for it.
+   */
+  Lru,
+
+  /**
+   * Objects are still evicted in LRU order, but a new object is only admitted
+   * into a full cache if it has been accessed more often than the object it
+   * would evict, according to a FrequencySketch of recent accesses. This keeps
+   * one-off scans from pushing a reused working set out of the cache.
+   */
+  TinyLfu,
+};
+
+/**
+ * An object that was recently used in an ObjectCache, as returned by
+ * ObjectCache::getHotKeys().
+ */
+struct CacheHotKey {
+  ObjectId id;
+  /**
+   * The object's estimated access frequency, between 0 and
+   * FrequencySketch::kMaxFrequency. Always 0 with the Lru policy.
+   */
+  uint8_t frequency = 0;
+};
+
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 class ObjectCache;
 
@@ -100,6 +139,15 @@ class ObjectInterestHandle {
  * be used that only allow clients to use one flavor of get and insert. See
  * BlobCache and TreeCache for examples of each flavor.
  *
+ * The eviction policy is chosen at construction, see
+ * ObjectCacheEvictionPolicy.
+ *
+ * The cache can optionally be split into several shards, each with its own
+ * lock, LRU queue and an equal part of the size and entry budgets. Objects are
+ * assigned to a shard by hashing their ObjectId. This trades exact global LRU
+ * ordering for less lock contention when many threads hit the cache
+ * concurrently. With a single shard, the cache behaves as a plain LRU.
+ *
  * It is safe to use this object from arbitrary threads.
  */
 template <typename ObjectType, ObjectCacheFlavor Flavor>
@@ -144,11 +192,45 @@ class ObjectCache
     uint64_t missCount{0};
     uint64_t evictionCount{0};
     uint64_t dropCount{0};
+    /// Number of new objects added to the cache.
+    uint64_t insertCount{0};
+    /// Number of new objects the admission policy refused to add.
+    uint64_t admissionRejectCount{0};
+
+    /**
+     * Fraction of lookups that found their object, or 0 if there were none.
+     */
+    double getHitRate() const {
+      auto total = hitCount + missCount;
+      return total ? static_cast<double>(hitCount) / total : 0.0;
+    }
+
+    /**
+     * Fraction of new objects the admission policy refused to add, or 0 if
+     * there were no inserts.
+     */
+    double getAdmissionRejectRate() const {
+      auto total = insertCount + admissionRejectCount;
+      return total ? static_cast<double>(admissionRejectCount) / total : 0.0;
+    }
+
+    /**
+     * Per-shard breakdown of the above. Only populated when the cache has
+     * more than one shard. The nested entries never have shardStats set.
+     */
+    std::vector<Stats> shardStats;
   };
 
+  /**
+   * Create a new cache. numShards is clamped to at least 1; each shard gets
+   * maximumCacheSizeBytes / numShards bytes and at least
+   * minimumEntryCount / numShards (rounded up) entries.
+   */
   static std::shared_ptr<ObjectCache<ObjectType, Flavor>> create(
       size_t maximumCacheSizeBytes,
-      size_t minimumEntryCount);
+      size_t minimumEntryCount,
+      size_t numShards = 1,
+      ObjectCacheEvictionPolicy policy = ObjectCacheEvictionPolicy::Lru);
   ~ObjectCache() {}
 
   /**
@@ -184,7 +266,7 @@ class ObjectCache
   /**
    * Inserts a object into the cache for future lookup. If the new total size
    * exceeds the maximum cache size and the minimum entry count, old entries are
-   * evicted.
+   * evicted. The eviction policy may instead decide not to cache the object.
    *
    * Optionally returns an interest handle that, when dropped, evicts the
    * inserted object.
@@ -222,8 +304,56 @@ class ObjectCache
    */
   Stats getStats() const;
 
+  /**
+   * Return the ids of up to limit of the most recently used objects, most
+   * recently used first. Shards are interleaved, so each of them contributes
+   * its own most recently used objects.
+   */
+  std::vector<CacheHotKey> getHotKeys(size_t limit) const;
+
+  /**
+   * Change the maximum total size of the cache, evicting the least recently
+   * used objects right away if it no longer fits. The minimum entry count is
+   * unchanged.
+   */
+  void setMaximumSize(size_t maximumCacheSizeBytes);
+
+  /**
+   * Returns the current maximum total size of the cache.
+   */
+  size_t getMaximumSize() const {
+    return maximumCacheSizeBytes_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Returns the number of independently locked shards.
+   */
+  size_t getShardCount() const {
+    return shards_.size();
+  }
+
  protected:
-  explicit ObjectCache(size_t maximumCacheSizeBytes, size_t minimumEntryCount);
+  explicit ObjectCache(
+      size_t maximumCacheSizeBytes,
+      size_t minimumEntryCount,
+      size_t numShards = 1,
+      ObjectCacheEvictionPolicy policy = ObjectCacheEvictionPolicy::Lru);
+
+  using EvictionObserver = std::function<void(std::vector<ObjectPtr>)>;
+
+  /**
+   * Register a callback that receives the objects evicted to make room for
+   * newly inserted ones, or to fit a smaller setMaximumSize(). It is called
+   * without any of the cache locks held. Only supported by
+   * the Simple flavor. Objects evicted
+   * because their interest handles were dropped, or by clear(), are not
+   * reported.
+   *
+   * Must be called before the cache is shared with other threads.
+   */
+  void setEvictionObserver(EvictionObserver observer) {
+    evictionObserver_ = std::move(observer);
+  }
 
  private:
   /*
@@ -267,6 +397,24 @@ class ObjectCache
     uint64_t missCount{0};
     uint64_t evictionCount{0};
     uint64_t dropCount{0};
+    uint64_t insertCount{0};
+    uint64_t admissionRejectCount{0};
+
+    /// Only set with ObjectCacheEvictionPolicy::TinyLfu.
+    std::optional<FrequencySketch> sketch;
+
+    /// Objects evicted under the lock, waiting to be handed to the
+    /// evictionObserver_ once it is released.
+    std::vector<ObjectPtr> pendingEvictions;
+  };
+
+  /**
+   * One independently locked slice of the cache. Aligned to avoid false
+   * sharing between the locks of neighbouring shards.
+   */
+  struct alignas(folly::hardware_destructive_interference_size) Shard {
+    State state;
+    folly::DistributedMutex lock;
   };
 
   /**
@@ -280,7 +428,9 @@ class ObjectCache
   class LockedState {
    public:
     LockedState(State& state, folly::DistributedMutex& lock)
-        : state_{state}, stateLock_{lock} {}
+        : state_{state}, stateLock_{lock} {
+      timer_.acquired();
+    }
 
     LockedState(const LockedState&) = delete;
     LockedState(LockedState&&) = delete;
@@ -297,11 +447,24 @@ class ObjectCache
 
    private:
     State& state_;
+    // Declared first, so it starts timing before the lock is acquired and
+    // stops once it is released.
+    LockTimer<
+        &LockThreadStats::objectCacheWait,
+        &LockThreadStats::objectCacheHold>
+        timer_;
     std::unique_lock<folly::DistributedMutex> stateLock_;
   };
 
-  LockedState lockState() const {
-    return LockedState{state_, stateLock_};
+  Shard& getShard(const ObjectId& hash) const;
+
+  LockedState lockState(const ObjectId& hash) const {
+    auto& shard = getShard(hash);
+    return LockedState{shard.state, shard.lock};
+  }
+
+  static LockedState lockShard(Shard& shard) {
+    return LockedState{shard.state, shard.lock};
   }
 
   /**
@@ -319,20 +482,35 @@ class ObjectCache
    * duplicate insert) and a boolean indicating if this item was freshly
    * inserted (returns false if this is a duplicate insert).
    *
+   * If the eviction policy rejects the object, returns a null item and false.
+   *
    * Does not do anything related to InterestHandles
    */
   std::pair<CacheItem*, bool> insertImpl(ObjectPtr object, LockedState& state);
 
+  /**
+   * Whether a new object of the given size should be added to the shard.
+   * Always true for the Lru policy.
+   */
+  bool shouldAdmit(const ObjectId& hash, size_t size, LockedState& state);
+
   void dropInterestHandle(const ObjectId& hash, uint64_t generation) noexcept;
 
   void evictUntilFits(LockedState& state) noexcept;
   void evictOne(LockedState& state) noexcept;
   void evictItem(LockedState&, CacheItem* item) noexcept;
 
-  const size_t maximumCacheSizeBytes_;
+  size_t getShardMaximumSize() const {
+    return shardMaximumSizeBytes_.load(std::memory_order_relaxed);
+  }
+
+  std::atomic<size_t> maximumCacheSizeBytes_;
   const size_t minimumEntryCount_;
-  mutable State state_;
-  mutable folly::DistributedMutex stateLock_;
+  mutable std::vector<Shard> shards_;
+  /// Budgets applied to each shard, derived from the ones above.
+  std::atomic<size_t> shardMaximumSizeBytes_;
+  const size_t shardMinimumEntryCount_;
+  EvictionObserver evictionObserver_;
 
   friend class ObjectInterestHandle<ObjectType>;
 };
@@ -9,6 +9,7 @@
 #include <optional>
 #include <unordered_map>
 
+#include <folly/CancellationToken.h>
 #include <folly/Range.h>
 
 #include "eden/fs/store/ImportPriority.h"
@@ -64,6 +65,13 @@ class ObjectFetchContext {
 
   virtual void didFetch(ObjectType, const ObjectId&, Origin) {}
 
+  /**
+   * Called after didFetch for fetches that read object contents, with the
+   * number of bytes read: the blob size, or the size of a blob range fetched
+   * from the backing store.
+   */
+  virtual void didFetchBytes(ObjectType, Origin, uint64_t /*bytes*/) {}
+
   virtual std::optional<pid_t> getClientPid() const {
     return std::nullopt;
   }
@@ -83,6 +91,17 @@ class ObjectFetchContext {
   virtual const std::unordered_map<std::string, std::string>* getRequestInfo()
       const = 0;
 
+  /**
+   * Cancelled once nobody waits on the result of the fetch anymore, for
+   * instance because the filesystem request that caused it timed out.
+   * Queued imports whose callers all gave up are dropped.
+   *
+   * The default token can't be cancelled.
+   */
+  virtual folly::CancellationToken getCancellationToken() const {
+    return {};
+  }
+
   /**
    * Support deprioritizing in sub-classes.
    * Note: Normally, each ObjectFetchContext is designed to be used for only one
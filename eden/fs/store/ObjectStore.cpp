@@ -9,8 +9,11 @@
 
 #include <folly/Conv.h>
 #include <folly/Executor.h>
+#include <folly/MapUtil.h>
 #include <folly/futures/Future.h>
+#include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
+#include <folly/lang/Bits.h>
 
 #include <stdexcept>
 
@@ -19,6 +22,7 @@
 #include "eden/fs/store/BackingStore.h"
 #include "eden/fs/store/LocalStore.h"
 #include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/store/SharedFetchContext.h"
 #include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/utils/ImmediateFuture.h"
 
@@ -32,8 +36,52 @@ namespace facebook::eden {
 
 namespace {
 constexpr uint64_t kImportPriorityDeprioritizeAmount = 1;
+
+std::unique_ptr<NegativeLookupCache> makeNegativeLookupCache(
+    const EdenConfig& config) {
+  auto size = config.negativeLookupCacheSize.getValue();
+  if (size == 0) {
+    return nullptr;
+  }
+  return std::make_unique<NegativeLookupCache>(
+      size,
+      std::chrono::duration_cast<NegativeLookupCache::Clock::duration>(
+          config.negativeLookupCacheTtl.getValue()));
+}
+
+ProcessFetchRates::Clock::duration getFetchRateWindow(
+    const EdenConfig& config) {
+  auto window = config.fetchRateWindow.getValue();
+  if (window <= std::chrono::nanoseconds::zero()) {
+    return std::chrono::seconds{1};
+  }
+  return std::chrono::duration_cast<ProcessFetchRates::Clock::duration>(
+      window);
+}
+
+/**
+ * Return length bytes starting skip bytes into the concatenation of pieces.
+ */
+unique_ptr<folly::IOBuf> joinBlobRanges(
+    const std::vector<shared_ptr<const Blob>>& pieces,
+    uint64_t skip,
+    uint64_t length) {
+  folly::IOBuf contents;
+  for (const auto& piece : pieces) {
+    contents.prependChain(piece->getContents().clone());
+  }
+  folly::io::Cursor cursor(&contents);
+  if (!cursor.canAdvance(skip)) {
+    return folly::IOBuf::create(0);
+  }
+  cursor.skip(skip);
+  unique_ptr<folly::IOBuf> result;
+  cursor.cloneAtMost(result, length);
+  return result;
 }
 
+} // namespace
+
 std::shared_ptr<ObjectStore> ObjectStore::create(
     shared_ptr<LocalStore> localStore,
     shared_ptr<BackingStore> backingStore,
@@ -63,7 +111,11 @@ ObjectStore::ObjectStore(
     std::shared_ptr<ProcessNameCache> processNameCache,
     std::shared_ptr<StructuredLogger> structuredLogger,
     std::shared_ptr<const EdenConfig> edenConfig)
-    : metadataCache_{folly::in_place, kCacheSize},
+    : metadataCache_{edenConfig->blobMetadataCacheSize.getValue()},
+      negativeCache_{makeNegativeLookupCache(*edenConfig)},
+      rangeCache_{BlobCache::create(
+          edenConfig->blobRangeCacheSize.getValue(),
+          /*minimumEntryCount=*/0)},
       treeCache_{std::move(treeCache)},
       localStore_{std::move(localStore)},
       backingStore_{std::move(backingStore)},
@@ -76,9 +128,39 @@ ObjectStore::ObjectStore(
 
 ObjectStore::~ObjectStore() {}
 
+bool ObjectStore::isKnownMissing(const ObjectId& id) const {
+  return negativeCache_ && negativeCache_->contains(id);
+}
+
+uint64_t ObjectStore::getNegativeCacheGeneration() const {
+  return negativeCache_ ? negativeCache_->getGeneration() : 0;
+}
+
+void ObjectStore::recordMissing(const ObjectId& id, uint64_t generation)
+    const {
+  if (negativeCache_) {
+    negativeCache_->insert(id, generation);
+  }
+}
+
+void ObjectStore::invalidateNegativeLookupCache() const {
+  if (negativeCache_) {
+    negativeCache_->invalidate();
+  }
+}
+
+NegativeLookupCache::Stats ObjectStore::getNegativeLookupCacheStats() const {
+  if (negativeCache_) {
+    return negativeCache_->getStats();
+  }
+  return NegativeLookupCache::Stats{};
+}
+
 void ObjectStore::updateProcessFetch(
-    const ObjectFetchContext& fetchContext) const {
+    const ObjectFetchContext& fetchContext,
+    uint64_t bytes) const {
   if (auto pid = fetchContext.getClientPid()) {
+    pidFetchRates_.record(pid.value(), bytes, getFetchRateWindow(*edenConfig_));
     auto fetch_count = pidFetchCounts_->recordProcessFetch(pid.value());
     auto threshold = edenConfig_->fetchHeavyThreshold.getValue();
     if (fetch_count && threshold && !(fetch_count % threshold)) {
@@ -99,14 +181,26 @@ void ObjectStore::deprioritizeWhenFetchHeavy(
     ObjectFetchContext& context) const {
   auto pid = context.getClientPid();
   if (pid.has_value()) {
-    auto fetch_count = pidFetchCounts_->getCountByPid(pid.value());
-    auto threshold = edenConfig_->fetchHeavyThreshold.getValue();
-    if (threshold && fetch_count >= threshold) {
+    auto rates =
+        pidFetchRates_.get(pid.value(), getFetchRateWindow(*edenConfig_));
+    if (isFetchHeavy(rates)) {
       context.deprioritize(kImportPriorityDeprioritizeAmount);
     }
   }
 }
 
+bool ObjectStore::isFetchHeavy(const ProcessFetchRates::Rates& rates) const {
+  auto requestRate = edenConfig_->fetchHeavyRequestRate.getValue();
+  auto byteRate = edenConfig_->fetchHeavyByteRate.getValue();
+  return (requestRate && rates.requestsPerSecond >= requestRate) ||
+      (byteRate && rates.bytesPerSecond >= byteRate);
+}
+
+std::unordered_map<pid_t, ProcessFetchRates::Rates>
+ObjectStore::getProcessFetchRates() const {
+  return pidFetchRates_.getAll(getFetchRateWindow(*edenConfig_));
+}
+
 RootId ObjectStore::parseRootId(folly::StringPiece rootId) {
   return backingStore_->parseRootId(rootId);
 }
@@ -180,16 +274,28 @@ ImmediateFuture<shared_ptr<const Tree>> ObjectStore::getTree(
     return maybeTree;
   }
 
+  if (isKnownMissing(id)) {
+    XLOG(DBG3) << "tree " << id << " is known to be missing";
+    return ImmediateFuture<shared_ptr<const Tree>>{
+        folly::Try<shared_ptr<const Tree>>{
+            std::domain_error(fmt::format("tree {} not found", id))}};
+  }
+
   deprioritizeWhenFetchHeavy(fetchContext);
 
+  // Read before starting the fetch, see NegativeLookupCache.
+  auto generation = getNegativeCacheGeneration();
   return backingStore_->getTree(id, fetchContext)
       .via(executor_)
-      .thenValue([self = shared_from_this(), id, &fetchContext](
-                     BackingStore::GetTreeRes result) {
+      .thenTry([self = shared_from_this(), id, &fetchContext, generation](
+                   folly::Try<BackingStore::GetTreeRes> tryResult) {
+        if (tryResult.hasException<std::domain_error>()) {
+          self->recordMissing(id, generation);
+        }
+        auto& result = tryResult.value();
         if (!result.tree) {
-          // TODO: Perhaps we should do some short-term negative
-          // caching?
           XLOG(DBG2) << "unable to find tree " << id;
+          self->recordMissing(id, generation);
           throw std::domain_error(fmt::format("tree {} not found", id));
         }
 
@@ -203,6 +309,44 @@ ImmediateFuture<shared_ptr<const Tree>> ObjectStore::getTree(
       .semi();
 }
 
+ImmediateFuture<folly::Unit> ObjectStore::prefetchTrees(
+    const ObjectId& id,
+    size_t depth,
+    size_t maxTrees,
+    ObjectFetchContext& context) const {
+  return prefetchTreesImpl(
+      id,
+      depth,
+      std::make_shared<std::atomic<int64_t>>(static_cast<int64_t>(maxTrees)),
+      context);
+}
+
+ImmediateFuture<folly::Unit> ObjectStore::prefetchTreesImpl(
+    const ObjectId& id,
+    size_t depth,
+    std::shared_ptr<std::atomic<int64_t>> budget,
+    ObjectFetchContext& context) const {
+  if (budget->fetch_sub(1, std::memory_order_relaxed) <= 0) {
+    return folly::unit;
+  }
+  return getTree(id, context)
+      .thenValue([self = shared_from_this(),
+                  depth,
+                  budget = std::move(budget),
+                  &context](std::shared_ptr<const Tree> tree) {
+        std::vector<ImmediateFuture<folly::Unit>> futures;
+        if (depth > 0) {
+          for (const auto& entry : tree->getTreeEntries()) {
+            if (entry.isTree()) {
+              futures.push_back(self->prefetchTreesImpl(
+                  entry.getHash(), depth - 1, budget, context));
+            }
+          }
+        }
+        return collectAll(std::move(futures)).thenValue([](auto&&) {});
+      });
+}
+
 folly::Future<folly::Unit> ObjectStore::prefetchBlobs(
     ObjectIdRange ids,
     ObjectFetchContext& fetchContext) const {
@@ -223,14 +367,26 @@ folly::Future<folly::Unit> ObjectStore::prefetchBlobs(
 Future<shared_ptr<const Blob>> ObjectStore::getBlob(
     const ObjectId& id,
     ObjectFetchContext& fetchContext) const {
+  if (isKnownMissing(id)) {
+    XLOG(DBG3) << "blob " << id << " is known to be missing";
+    return makeFuture<shared_ptr<const Blob>>(
+        std::domain_error(fmt::format("blob {} not found", id)));
+  }
+
   deprioritizeWhenFetchHeavy(fetchContext);
+  // Read before starting the fetch, see NegativeLookupCache.
+  auto generation = getNegativeCacheGeneration();
   return backingStore_->getBlob(id, fetchContext)
       .via(executor_)
-      .thenValue([self = shared_from_this(), id, &fetchContext](
-                     BackingStore::GetBlobRes result) {
+      .thenTry([self = shared_from_this(), id, &fetchContext, generation](
+                   folly::Try<BackingStore::GetBlobRes> tryResult) {
+        if (tryResult.hasException<std::domain_error>()) {
+          self->recordMissing(id, generation);
+        }
+        auto& result = tryResult.value();
         if (!result.blob) {
-          // TODO: Perhaps we should do some short-term negative caching?
           XLOG(DBG2) << "unable to find blob " << id;
+          self->recordMissing(id, generation);
           throw std::domain_error(fmt::format("blob {} not found", id));
         }
         // Quick check in-memory cache first, before doing expensive
@@ -239,107 +395,439 @@ Future<shared_ptr<const Blob>> ObjectStore::getBlob(
         // Additionally check if we use aux metadata from mercurial, and do not
         // compute it in this case.
         if (!self->edenConfig_->useAuxMetadata.getValue() &&
-            !self->metadataCache_.rlock()->exists(id)) {
+            !self->metadataCache_.contains(id)) {
           auto metadata =
               self->localStore_->putBlobMetadata(id, result.blob.get());
-          self->metadataCache_.wlock()->set(id, metadata);
+          self->metadataCache_.set(id, metadata);
         }
-        self->updateProcessFetch(fetchContext);
+        self->updateProcessFetch(fetchContext, result.blob->getSize());
         fetchContext.didFetch(ObjectFetchContext::Blob, id, result.origin);
+        fetchContext.didFetchBytes(
+            ObjectFetchContext::Blob, result.origin, result.blob->getSize());
         return std::move(result.blob);
       });
 }
 
-ImmediateFuture<BlobMetadata> ObjectStore::getBlobMetadata(
+bool ObjectStore::shouldReadBlobRanges(uint64_t blobSize) const {
+  auto threshold = edenConfig_->blobRangeThreshold.getValue();
+  return threshold != 0 && blobSize >= threshold &&
+      localStore_->enableBlobChunking.load(std::memory_order_relaxed);
+}
+
+ObjectId ObjectStore::getBlobRangeId(const ObjectId& id, uint64_t index) {
+  // The index comes first and has a fixed size, so that the pieces of two
+  // blobs can't have the same ID whatever the lengths of the blob IDs.
+  auto bigIndex = folly::Endian::big(index);
+  ObjectId::Storage bytes{
+      reinterpret_cast<const char*>(&bigIndex), sizeof(bigIndex)};
+  auto idBytes = id.getBytes();
+  bytes.append(reinterpret_cast<const char*>(idBytes.data()), idBytes.size());
+  return ObjectId{std::move(bytes)};
+}
+
+Future<unique_ptr<folly::IOBuf>> ObjectStore::getBlobRange(
     const ObjectId& id,
-    ObjectFetchContext& context) const {
-  // Check in-memory cache
-  {
-    auto metadataCache = metadataCache_.wlock();
-    auto cacheIter = metadataCache->find(id);
-    if (cacheIter != metadataCache->end()) {
-      stats_->getObjectStoreStatsForCurrentThread()
-          .getBlobMetadataFromMemory.addValue(1);
-      context.didFetch(
-          ObjectFetchContext::BlobMetadata,
-          id,
-          ObjectFetchContext::FromMemoryCache);
+    uint64_t offset,
+    uint64_t length,
+    ObjectFetchContext& fetchContext) const {
+  if (length == 0) {
+    return folly::IOBuf::create(0);
+  }
+  if (isKnownMissing(id)) {
+    XLOG(DBG3) << "blob " << id << " is known to be missing";
+    return makeFuture<unique_ptr<folly::IOBuf>>(
+        std::domain_error(fmt::format("blob {} not found", id)));
+  }
 
-      updateProcessFetch(context);
-      return cacheIter->second;
+  auto first = offset / kBlobRangeSize;
+  auto last = (offset + length - 1) / kBlobRangeSize;
+  auto skip = offset - first * kBlobRangeSize;
+  std::vector<shared_ptr<const Blob>> pieces;
+  pieces.reserve(last - first + 1);
+  std::optional<uint64_t> firstMissing;
+  uint64_t lastMissing = 0;
+  for (auto index = first; index <= last; ++index) {
+    auto piece = rangeCache_->get(getBlobRangeId(id, index)).object;
+    if (!piece) {
+      if (!firstMissing) {
+        firstMissing = index;
+      }
+      lastMissing = index;
     }
+    pieces.push_back(std::move(piece));
+  }
+
+  if (!firstMissing) {
+    stats_->getObjectStoreStatsForCurrentThread()
+        .getBlobRangeFromMemory.addValue(1);
+    return joinBlobRanges(pieces, skip, length);
+  }
+
+  // Fetch everything from the first to the last missing piece at once.
+  deprioritizeWhenFetchHeavy(fetchContext);
+  // Read before starting the fetch, see NegativeLookupCache.
+  auto generation = getNegativeCacheGeneration();
+  return backingStore_
+      ->getBlobRange(
+          id,
+          *firstMissing * kBlobRangeSize,
+          (lastMissing - *firstMissing + 1) * kBlobRangeSize,
+          fetchContext)
+      .via(executor_)
+      .thenTry([self = shared_from_this(),
+                id,
+                first,
+                firstMissing = *firstMissing,
+                lastMissing,
+                pieces = std::move(pieces),
+                skip,
+                length,
+                generation,
+                &fetchContext](
+                   folly::Try<unique_ptr<folly::IOBuf>> tryRange) mutable {
+        if (tryRange.hasException<std::domain_error>()) {
+          self->recordMissing(id, generation);
+        }
+        auto& range = tryRange.value();
+        if (!range) {
+          XLOG(DBG2) << "unable to find blob " << id;
+          self->recordMissing(id, generation);
+          throw std::domain_error(fmt::format("blob {} not found", id));
+        }
+        self->stats_->getObjectStoreStatsForCurrentThread()
+            .getBlobRangeFromBackingStore.addValue(1);
+        fetchContext.didFetchBytes(
+            ObjectFetchContext::Blob,
+            ObjectFetchContext::FromNetworkFetch,
+            range->computeChainDataLength());
+
+        folly::io::Cursor cursor(range.get());
+        for (auto index = firstMissing; index <= lastMissing; ++index) {
+          folly::IOBuf contents;
+          cursor.cloneAtMost(contents, kBlobRangeSize);
+          auto piece = std::make_shared<const Blob>(
+              getBlobRangeId(id, index), std::move(contents));
+          self->rangeCache_->insert(piece);
+          pieces[index - first] = std::move(piece);
+        }
+        self->updateProcessFetch(fetchContext, range->computeChainDataLength());
+        return joinBlobRanges(pieces, skip, length);
+      });
+}
+
+std::optional<BlobMetadata> ObjectStore::getCachedBlobMetadata(
+    const ObjectId& id,
+    ObjectFetchContext& context) const {
+  // Check in-memory cache
+  if (auto metadata = metadataCache_.get(id)) {
+    stats_->getObjectStoreStatsForCurrentThread()
+        .getBlobMetadataFromMemory.addValue(1);
+    context.didFetch(
+        ObjectFetchContext::BlobMetadata,
+        id,
+        ObjectFetchContext::FromMemoryCache);
+
+    updateProcessFetch(context);
+    return metadata;
   }
 
   if (backingStore_ && edenConfig_->useAuxMetadata.getValue()) {
     // if configured, check hg cache for aux metadata
     auto localMetadata = backingStore_->getLocalBlobMetadata(id, context);
     if (localMetadata) {
-      metadataCache_.wlock()->set(id, *localMetadata);
+      metadataCache_.set(id, *localMetadata);
       context.didFetch(
           ObjectFetchContext::BlobMetadata,
           id,
           ObjectFetchContext::FromDiskCache);
       updateProcessFetch(context);
-      return *localMetadata;
+      return localMetadata;
     }
   }
 
+  return std::nullopt;
+}
+
+void ObjectStore::recordLocalStoreBlobMetadata(
+    const ObjectId& id,
+    const BlobMetadata& metadata,
+    ObjectFetchContext& context) const {
+  stats_->getObjectStoreStatsForCurrentThread()
+      .getBlobMetadataFromLocalStore.addValue(1);
+  metadataCache_.set(id, metadata);
+  context.didFetch(
+      ObjectFetchContext::BlobMetadata, id, ObjectFetchContext::FromDiskCache);
+
+  updateProcessFetch(context);
+}
+
+ImmediateFuture<BlobMetadata> ObjectStore::getBlobMetadata(
+    const ObjectId& id,
+    ObjectFetchContext& context) const {
+  if (auto metadata = getCachedBlobMetadata(id, context)) {
+    return *metadata;
+  }
+
+  if (isKnownMissing(id)) {
+    XLOG(DBG3) << "blob " << id << " is known to be missing";
+    return ImmediateFuture<BlobMetadata>{folly::Try<BlobMetadata>{
+        std::domain_error(fmt::format("blob {} not found", id))}};
+  }
+
+  // If another request is already looking up this blob's metadata, wait for
+  // its result instead of issuing the same LocalStore and BackingStore
+  // lookups again.
+  std::shared_ptr<SharedFetchContext> sharedContext;
+  {
+    auto pending = pendingMetadataLookups_.wlock();
+    if (auto* lookup = folly::get_ptr(*pending, id)) {
+      stats_->getObjectStoreStatsForCurrentThread()
+          .getBlobMetadataCoalesced.addValue(1);
+      lookup->context->addWaiter(context);
+      auto [promise, future] = folly::makePromiseContract<BlobMetadata>();
+      lookup->waiters.emplace_back(std::move(promise));
+      pending.unlock();
+      return waitForPendingMetadataLookup(id, std::move(future), context);
+    }
+    sharedContext = std::make_shared<SharedFetchContext>(context);
+    pending->emplace(id, PendingMetadataLookup{sharedContext});
+  }
+
   auto self = shared_from_this();
+  auto generation = getNegativeCacheGeneration();
 
   // Check local store
-  return localStore_->getBlobMetadata(id)
-      .thenValue([self, id, &context](std::optional<BlobMetadata>&& metadata) {
+  return folly::makeFutureWith([&] { return localStore_->getBlobMetadata(id); })
+      .thenValue([self, id, sharedContext, generation](
+                     std::optional<BlobMetadata>&& metadata) {
         if (metadata) {
-          self->stats_->getObjectStoreStatsForCurrentThread()
-              .getBlobMetadataFromLocalStore.addValue(1);
-          self->metadataCache_.wlock()->set(id, *metadata);
-          context.didFetch(
-              ObjectFetchContext::BlobMetadata,
-              id,
-              ObjectFetchContext::FromDiskCache);
-
-          self->updateProcessFetch(context);
+          self->recordLocalStoreBlobMetadata(id, *metadata, *sharedContext);
           return makeFuture(*metadata);
         }
 
-        self->deprioritizeWhenFetchHeavy(context);
-
-        // Check backing store
-        //
-        // TODO: It would be nice to add a smarter API to the BackingStore so
-        // that we can query it just for the blob metadata if it supports
-        // getting that without retrieving the full blob data.
-        //
-        // TODO: This should probably check the LocalStore for the blob first,
-        // especially when we begin to expire entries in RocksDB.
-        return self->backingStore_->getBlob(id, context)
-            .via(self->executor_)
-            .thenValue([self, id, &context](BackingStore::GetBlobRes result) {
-              if (result.blob) {
-                self->stats_->getObjectStoreStatsForCurrentThread()
-                    .getBlobMetadataFromBackingStore.addValue(1);
-                self->localStore_->putBlob(id, result.blob.get());
-                auto metadata =
-                    self->localStore_->putBlobMetadata(id, result.blob.get());
-                self->metadataCache_.wlock()->set(id, metadata);
-                // I could see an argument for recording this fetch with
-                // type Blob instead of BlobMetadata, but it's probably more
-                // useful in context to know how many metadata fetches
-                // occurred. Also, since backing stores don't directly
-                // support fetching metadata, it should be clear.
-                context.didFetch(
-                    ObjectFetchContext::BlobMetadata, id, result.origin);
-
-                self->updateProcessFetch(context);
-                return makeFuture(metadata);
-              }
-
-              throw std::domain_error(fmt::format("blob {} not fonud", id));
-            });
+        self->deprioritizeWhenFetchHeavy(*sharedContext);
+        return self->getBlobMetadataFromBackingStore(
+            id, *sharedContext, generation);
+      })
+      .thenTry([self, id, sharedContext](folly::Try<BlobMetadata> result) {
+        self->completePendingMetadataLookup(id, result);
+        return std::move(result).value();
       })
       .semi();
 }
 
+ImmediateFuture<BlobMetadata> ObjectStore::waitForPendingMetadataLookup(
+    const ObjectId& id,
+    folly::SemiFuture<BlobMetadata> future,
+    ObjectFetchContext& context) const {
+  return ImmediateFuture<BlobMetadata>{std::move(future)}.thenTry(
+      [self = shared_from_this(), id, &context](
+          folly::Try<BlobMetadata>&& result) -> ImmediateFuture<BlobMetadata> {
+        if (result.hasException<folly::OperationCancelled>() &&
+            !context.getCancellationToken().isCancellationRequested()) {
+          return self->getBlobMetadata(id, context);
+        }
+        return std::move(result);
+      });
+}
+
+ImmediateFuture<std::vector<folly::Try<BlobMetadata>>>
+ObjectStore::getBlobMetadataBatch(
+    const std::vector<ObjectId>& ids,
+    ObjectFetchContext& context) const {
+  std::vector<ImmediateFuture<BlobMetadata>> results;
+  results.reserve(ids.size());
+
+  // The ids this batch registered in pendingMetadataLookups_ and now has to
+  // look up. Every result that isn't known yet, including those of the ids
+  // in toFetch, is delivered through a promise in pendingMetadataLookups_,
+  // so this batch and concurrent getBlobMetadata() calls share lookups.
+  std::vector<ObjectId> toFetch;
+  auto sharedContext = std::make_shared<SharedFetchContext>(context);
+  for (const auto& id : ids) {
+    if (auto metadata = getCachedBlobMetadata(id, context)) {
+      results.emplace_back(std::move(*metadata));
+      continue;
+    }
+
+    if (isKnownMissing(id)) {
+      XLOG(DBG3) << "blob " << id << " is known to be missing";
+      results.emplace_back(folly::Try<BlobMetadata>{
+          std::domain_error(fmt::format("blob {} not found", id))});
+      continue;
+    }
+
+    auto [promise, future] = folly::makePromiseContract<BlobMetadata>();
+    bool inserted;
+    {
+      auto pending = pendingMetadataLookups_.wlock();
+      auto iter = pending->find(id);
+      inserted = iter == pending->end();
+      if (inserted) {
+        iter = pending->emplace(id, PendingMetadataLookup{sharedContext}).first;
+        toFetch.push_back(id);
+      } else {
+        stats_->getObjectStoreStatsForCurrentThread()
+            .getBlobMetadataCoalesced.addValue(1);
+        iter->second.context->addWaiter(context);
+      }
+      iter->second.waiters.emplace_back(std::move(promise));
+    }
+    if (inserted) {
+      results.emplace_back(std::move(future));
+    } else {
+      results.emplace_back(
+          waitForPendingMetadataLookup(id, std::move(future), context));
+    }
+  }
+
+  if (toFetch.empty()) {
+    return collectAll(std::move(results));
+  }
+
+  auto self = shared_from_this();
+  auto generation = getNegativeCacheGeneration();
+
+  // Check local store with a single batched read, then send the remaining
+  // misses to the backing store all at once, so a queued backing store can
+  // import them together.
+  auto fetched =
+      folly::makeFutureWith(
+          [&] { return localStore_->getBlobMetadataBatch(toFetch); })
+          .thenTry(
+              [self, toFetch, sharedContext, generation](
+                  folly::Try<std::vector<std::optional<BlobMetadata>>>&&
+                      localResults) {
+                if (localResults.hasException()) {
+                  for (const auto& id : toFetch) {
+                    self->completePendingMetadataLookup(
+                        id,
+                        folly::Try<BlobMetadata>{localResults.exception()});
+                  }
+                  return folly::makeSemiFuture();
+                }
+
+                std::vector<folly::Future<folly::Unit>> backingFetches;
+                for (size_t i = 0; i < toFetch.size(); ++i) {
+                  const auto& id = toFetch[i];
+                  const auto& metadata = localResults.value()[i];
+                  if (metadata) {
+                    self->recordLocalStoreBlobMetadata(
+                        id, *metadata, *sharedContext);
+                    self->completePendingMetadataLookup(
+                        id, folly::Try<BlobMetadata>{*metadata});
+                    continue;
+                  }
+
+                  if (backingFetches.empty()) {
+                    self->deprioritizeWhenFetchHeavy(*sharedContext);
+                  }
+                  backingFetches.emplace_back(
+                      folly::makeFutureWith([&] {
+                        return self->getBlobMetadataFromBackingStore(
+                            id, *sharedContext, generation);
+                      }).thenTry([self, id, sharedContext](
+                                     folly::Try<BlobMetadata> result) {
+                        self->completePendingMetadataLookup(id, result);
+                      }));
+                }
+                return folly::collectAll(std::move(backingFetches)).unit();
+              });
+
+  return ImmediateFuture<folly::Unit>{std::move(fetched).semi()}.thenValue(
+      [results = std::move(results)](folly::Unit) mutable {
+        return collectAll(std::move(results));
+      });
+}
+
+folly::Future<BlobMetadata> ObjectStore::getBlobMetadataFromBackingStore(
+    const ObjectId& id,
+    ObjectFetchContext& context,
+    uint64_t generation) const {
+  if (!edenConfig_->useAuxMetadata.getValue()) {
+    return getBlobMetadataFromBlob(id, context, generation);
+  }
+
+  return backingStore_->getBlobMetadata(id, context)
+      .via(executor_)
+      .thenTry([self = shared_from_this(), id, &context, generation](
+                   folly::Try<std::unique_ptr<BlobMetadata>> tryMetadata) {
+        if (tryMetadata.hasException() || !tryMetadata.value()) {
+          // Whatever went wrong, fetching the blob may still work.
+          return self->getBlobMetadataFromBlob(id, context, generation);
+        }
+        auto& metadata = *tryMetadata.value();
+        self->stats_->getObjectStoreStatsForCurrentThread()
+            .getBlobMetadataFromBackingStoreAuxData.addValue(1);
+        self->localStore_->putBlobMetadata(id, metadata);
+        self->metadataCache_.set(id, metadata);
+        context.didFetch(
+            ObjectFetchContext::BlobMetadata,
+            id,
+            ObjectFetchContext::FromNetworkFetch);
+
+        self->updateProcessFetch(context);
+        return folly::makeFuture(metadata);
+      });
+}
+
+folly::Future<BlobMetadata> ObjectStore::getBlobMetadataFromBlob(
+    const ObjectId& id,
+    ObjectFetchContext& context,
+    uint64_t generation) const {
+  // TODO: This should probably check the LocalStore for the blob first,
+  // especially when we begin to expire entries in RocksDB.
+  return backingStore_->getBlob(id, context)
+      .via(executor_)
+      .thenTry([self = shared_from_this(), id, &context, generation](
+                   folly::Try<BackingStore::GetBlobRes> tryResult) {
+        if (tryResult.hasException<std::domain_error>()) {
+          self->recordMissing(id, generation);
+        }
+        auto& result = tryResult.value();
+        if (result.blob) {
+          self->stats_->getObjectStoreStatsForCurrentThread()
+              .getBlobMetadataFromBackingStore.addValue(1);
+          self->localStore_->putBlob(id, result.blob.get());
+          auto metadata =
+              self->localStore_->putBlobMetadata(id, result.blob.get());
+          self->metadataCache_.set(id, metadata);
+          // I could see an argument for recording this fetch with
+          // type Blob instead of BlobMetadata, but it's probably more
+          // useful in context to know how many metadata fetches
+          // occurred. Also, since backing stores don't directly
+          // support fetching metadata, it should be clear.
+          context.didFetch(ObjectFetchContext::BlobMetadata, id, result.origin);
+
+          self->updateProcessFetch(context);
+          return metadata;
+        }
+
+        self->recordMissing(id, generation);
+        throw std::domain_error(fmt::format("blob {} not fonud", id));
+      });
+}
+
+void ObjectStore::completePendingMetadataLookup(
+    const ObjectId& id,
+    const folly::Try<BlobMetadata>& result) const {
+  std::vector<folly::Promise<BlobMetadata>> waiters;
+  {
+    auto pending = pendingMetadataLookups_.wlock();
+    auto iter = pending->find(id);
+    if (iter == pending->end()) {
+      return;
+    }
+    waiters = std::move(iter->second.waiters);
+    pending->erase(iter);
+  }
+  // Fulfill the promises without the lock held, as they may run callbacks
+  // inline.
+  for (auto& waiter : waiters) {
+    waiter.setTry(folly::Try<BlobMetadata>{result});
+  }
+}
+
 ImmediateFuture<Hash20> ObjectStore::getBlobSha1(
     const ObjectId& id,
     ObjectFetchContext& context) const {
@@ -9,7 +9,8 @@
 
 #include <folly/Executor.h>
 #include <folly/Synchronized.h>
-#include <folly/container/EvictingCacheMap.h>
+#include <folly/futures/Promise.h>
+#include <atomic>
 #include <memory>
 #include <unordered_map>
 
@@ -18,9 +19,13 @@
 #include "eden/fs/model/BlobMetadata.h"
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/model/RootId.h"
+#include "eden/fs/store/BlobCache.h"
+#include "eden/fs/store/BlobMetadataCache.h"
 #include "eden/fs/store/IObjectStore.h"
 #include "eden/fs/store/ImportPriority.h"
+#include "eden/fs/store/NegativeLookupCache.h"
 #include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/store/ProcessFetchRates.h"
 #include "eden/fs/store/TreeCache.h"
 #include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/telemetry/StructuredLogger.h"
@@ -31,6 +36,7 @@ namespace facebook::eden {
 class BackingStore;
 class Blob;
 class LocalStore;
+class SharedFetchContext;
 class Tree;
 
 struct PidFetchCounts {
@@ -85,10 +91,12 @@ class ObjectStore : public IObjectStore,
 
   /**
    * When pid of fetchContext is available, this function updates
-   * pidFetchCounts_. If the current process needs to be logged as
-   * a fetch-heavy process, it sends a FetchHeavy event to Scuba.
+   * pidFetchCounts_ and pidFetchRates_. If the current process needs to be
+   * logged as a fetch-heavy process, it sends a FetchHeavy event to Scuba.
    */
-  void updateProcessFetch(const ObjectFetchContext& fetchContext) const;
+  void updateProcessFetch(
+      const ObjectFetchContext& fetchContext,
+      uint64_t bytes = 0) const;
 
   /**
    * send a FetchHeavy log event to Scuba. If either processNameCache_
@@ -97,9 +105,10 @@ class ObjectStore : public IObjectStore,
   void sendFetchHeavyEvent(pid_t pid, uint64_t fetch_count) const;
 
   /**
-   * Check fetch count of the process using this fetchContext before using
-   * the fetchContext in BackingStore. if fetchHeavyThreshold in edenConfig_ is
-   * exceeded, deprioritize the fetchContext by 1.
+   * Check the fetch rates of the process using this fetchContext before using
+   * the fetchContext in BackingStore. If it is fetch heavy, deprioritize the
+   * fetchContext by 1. Once its rates decay, its fetches get their normal
+   * priority back.
    *
    * Note: Normally, one fetchContext is created for only one fetch request,
    * so deprioritize() should only be called once by one thread, but that is
@@ -108,6 +117,19 @@ class ObjectStore : public IObjectStore,
    */
   void deprioritizeWhenFetchHeavy(ObjectFetchContext& context) const;
 
+  /**
+   * Whether a process fetching at these rates is fetch heavy, per
+   * store:fetch-heavy-request-rate and store:fetch-heavy-byte-rate.
+   */
+  bool isFetchHeavy(const ProcessFetchRates::Rates& rates) const;
+
+  /**
+   * The recent fetch rates of every process that fetched through this
+   * ObjectStore.
+   */
+  std::unordered_map<pid_t, ProcessFetchRates::Rates> getProcessFetchRates()
+      const;
+
   /**
    * Each BackingStore implementation defines its interpretation of root IDs.
    * This function gives the BackingStore a chance to parse and canonicalize the
@@ -169,6 +191,24 @@ class ObjectStore : public IObjectStore,
       const ObjectId& id,
       ObjectFetchContext& context) const override;
 
+  /**
+   * Fetch the tree id and the trees below it, down to depth levels of
+   * subdirectories and at most maxTrees trees in total, so that they are in
+   * the TreeCache and the LocalStore when a recursive walk reaches them.
+   *
+   * Each child tree is requested as soon as its parent arrives, so the trees
+   * of a level are fetched concurrently and batched by the BackingStore,
+   * rather than one round trip at a time as the walk progresses. Failures to
+   * fetch the trees below id are ignored.
+   *
+   * The caller must keep context alive until the returned future completes.
+   */
+  ImmediateFuture<folly::Unit> prefetchTrees(
+      const ObjectId& id,
+      size_t depth,
+      size_t maxTrees,
+      ObjectFetchContext& context) const;
+
   /**
    * Prefetch all the blobs represented by the HashRange.
    *
@@ -190,6 +230,38 @@ class ObjectStore : public IObjectStore,
       const ObjectId& id,
       ObjectFetchContext& context) const override;
 
+  /**
+   * Ranges of large blobs are read and cached in aligned pieces of this
+   * size.
+   */
+  static constexpr uint64_t kBlobRangeSize = 1024 * 1024;
+
+  /**
+   * Whether a file of blobSize bytes should be read with getBlobRange()
+   * rather than by loading its whole blob.
+   *
+   * True for files of at least experimental:blob-range-threshold bytes, as
+   * long as blob chunking is enabled: the LocalStore reads the range of a
+   * chunked blob without the rest, while it would read a blob stored whole
+   * again for every range.
+   */
+  bool shouldReadBlobRanges(uint64_t blobSize) const;
+
+  /**
+   * Get at most length bytes of a Blob's contents, starting at offset,
+   * without keeping the whole blob in memory.
+   *
+   * The blob is read in aligned kBlobRangeSize pieces, which are kept in an
+   * in-memory cache of store:blob-range-cache-size bytes, so that small
+   * sequential reads only go to the BackingStore once per piece. It may
+   * result in a std::domain_error if the specified blob ID does not exist.
+   */
+  folly::Future<std::unique_ptr<folly::IOBuf>> getBlobRange(
+      const ObjectId& id,
+      uint64_t offset,
+      uint64_t length,
+      ObjectFetchContext& context) const;
+
   /**
    * Get metadata about a Blob.
    *
@@ -201,6 +273,19 @@ class ObjectStore : public IObjectStore,
       const ObjectId& id,
       ObjectFetchContext& context) const;
 
+  /**
+   * Get metadata about several Blobs.
+   *
+   * Blobs whose metadata isn't cached in memory are looked up in the
+   * LocalStore with one batched read, and the remaining ones are requested
+   * from the BackingStore together. The result has one entry per id, in the
+   * same order, holding either the metadata or the error getBlobMetadata()
+   * would have produced for that id.
+   */
+  ImmediateFuture<std::vector<folly::Try<BlobMetadata>>> getBlobMetadataBatch(
+      const std::vector<ObjectId>& ids,
+      ObjectFetchContext& context) const;
+
   /**
    * Returns the size of the contents of the blob with the given ID.
    */
@@ -235,6 +320,27 @@ class ObjectStore : public IObjectStore,
 
   void clearFetchCounts() {
     pidFetchCounts_->clear();
+    pidFetchRates_.clear();
+  }
+
+  /**
+   * Forget every object recorded as missing. Should be called whenever the
+   * BackingStore may have gained new objects, e.g. before a checkout to a
+   * commit that was just pulled.
+   */
+  void invalidateNegativeLookupCache() const;
+
+  /**
+   * Return statistics about the negative lookup cache. All zeros if it is
+   * disabled.
+   */
+  NegativeLookupCache::Stats getNegativeLookupCacheStats() const;
+
+  /**
+   * Return statistics about the in-memory blob metadata cache.
+   */
+  BlobMetadataCache::Stats getBlobMetadataCacheStats() const {
+    return metadataCache_.getStats();
   }
 
  private:
@@ -252,24 +358,131 @@ class ObjectStore : public IObjectStore,
   ObjectStore(ObjectStore const&) = delete;
   ObjectStore& operator=(ObjectStore const&) = delete;
 
-  static constexpr size_t kCacheSize = 1000000;
-
   /**
    * During status and checkout, it's common to look up the SHA-1 for a given
    * blob ID. To avoid needing to hit RocksDB, keep a bounded in-memory cache of
-   * the sizes and SHA-1s of blobs we've seen. Each node is somewhere around 50
-   * bytes (20+28 + LRU overhead) and we store kMetadataCacheSize entries, which
-   * EvictingCacheMap divides in two for some reason. At the time of this
-   * comment, EvictingCacheMap does not store its nodes densely, so there may
-   * also be some jemalloc tracking overhead and some internal fragmentation
-   * depending on whether the node fits cleanly into one of jemalloc's size
-   * classes.
+   * the sizes and SHA-1s of blobs we've seen, limited to
+   * store:blob-metadata-cache-size bytes.
+   */
+  mutable BlobMetadataCache metadataCache_;
+
+  /**
+   * Tools that probe for optional files cause repeated lookups of objects
+   * that do not exist. Remember recent misses for a short while so those
+   * lookups fail without going to the LocalStore and BackingStore again.
    *
-   * TODO: It never makes sense to rlock an LRU cache, since cache hits mutate
-   * the data structure. Thus, should we use a more appropriate type of lock?
+   * Null if store:negative-cache-size is 0.
+   */
+  const std::unique_ptr<NegativeLookupCache> negativeCache_;
+
+  /**
+   * The pieces of the blobs read by getBlobRange(), keyed by
+   * getBlobRangeId(). Separate from the mounts' BlobCache so that reading a
+   * huge file doesn't evict the blobs of the small ones.
    */
-  mutable folly::Synchronized<folly::EvictingCacheMap<ObjectId, BlobMetadata>>
-      metadataCache_;
+  const std::shared_ptr<BlobCache> rangeCache_;
+
+  /**
+   * The ID under which the index'th kBlobRangeSize piece of blob id is
+   * cached in rangeCache_.
+   */
+  static ObjectId getBlobRangeId(const ObjectId& id, uint64_t index);
+
+  ImmediateFuture<folly::Unit> prefetchTreesImpl(
+      const ObjectId& id,
+      size_t depth,
+      std::shared_ptr<std::atomic<int64_t>> budget,
+      ObjectFetchContext& context) const;
+
+  /**
+   * Returns true, and records the lookup, if id is in the negative cache.
+   */
+  bool isKnownMissing(const ObjectId& id) const;
+
+  /**
+   * Returns the negative cache generation to pass to recordMissing().
+   */
+  uint64_t getNegativeCacheGeneration() const;
+
+  void recordMissing(const ObjectId& id, uint64_t generation) const;
+
+  struct PendingMetadataLookup {
+    explicit PendingMetadataLookup(std::shared_ptr<SharedFetchContext> context)
+        : context{std::move(context)} {}
+
+    /**
+     * The context the lookup runs with. Each request waiting on the lookup is
+     * one of its waiters, so the lookup is only cancelled once all of them
+     * gave up.
+     */
+    std::shared_ptr<SharedFetchContext> context;
+    std::vector<folly::Promise<BlobMetadata>> waiters;
+  };
+
+  /**
+   * Blob metadata lookups currently going to the LocalStore or BackingStore,
+   * with the promises of the concurrent requests for the same blob, which
+   * just wait for that lookup's result. getBlobMetadataBatch() also receives
+   * the results of the lookups it starts through these promises.
+   */
+  mutable folly::Synchronized<
+      std::unordered_map<ObjectId, PendingMetadataLookup>>
+      pendingMetadataLookups_;
+
+  /**
+   * Wait for the result of a lookup another request started. Should all the
+   * other waiters give up and cancel it while this one still wants the
+   * result, the lookup is started over.
+   */
+  ImmediateFuture<BlobMetadata> waitForPendingMetadataLookup(
+      const ObjectId& id,
+      folly::SemiFuture<BlobMetadata> future,
+      ObjectFetchContext& context) const;
+
+  /**
+   * Remove the pending lookup for id and fulfill its waiters with result.
+   */
+  void completePendingMetadataLookup(
+      const ObjectId& id,
+      const folly::Try<BlobMetadata>& result) const;
+
+  /**
+   * Look up blob metadata in the in-memory cache, and in the BackingStore's
+   * local aux data if hg:use-aux-metadata is set. Records the fetch if
+   * found.
+   */
+  std::optional<BlobMetadata> getCachedBlobMetadata(
+      const ObjectId& id,
+      ObjectFetchContext& context) const;
+
+  /**
+   * Cache and record the fetch of metadata that was found in the LocalStore.
+   */
+  void recordLocalStoreBlobMetadata(
+      const ObjectId& id,
+      const BlobMetadata& metadata,
+      ObjectFetchContext& context) const;
+
+  /**
+   * Fetch the metadata from the BackingStore and store it in the LocalStore.
+   *
+   * With aux metadata enabled, the BackingStore is asked for the metadata
+   * alone first, so that the blob contents are only downloaded when it
+   * doesn't have it.
+   */
+  folly::Future<BlobMetadata> getBlobMetadataFromBackingStore(
+      const ObjectId& id,
+      ObjectFetchContext& context,
+      uint64_t generation) const;
+
+  /**
+   * Fetch the blob from the BackingStore and compute its metadata, storing
+   * both in the LocalStore.
+   */
+  folly::Future<BlobMetadata> getBlobMetadataFromBlob(
+      const ObjectId& id,
+      ObjectFetchContext& context,
+      uint64_t generation) const;
 
   /**
    * During glob, we need to read a lot of trees, but we avoid loading inodes,
@@ -306,6 +519,10 @@ class ObjectStore : public IObjectStore,
    * from the beginning of the eden daemon progress */
   std::unique_ptr<PidFetchCounts> pidFetchCounts_;
 
+  /* recent fetch rates of each process, used to deprioritize the fetches of
+   * fetch-heavy processes */
+  mutable ProcessFetchRates pidFetchRates_;
+
   /* process name cache and structured logger used for
    * sending fetch heavy events, set to nullptr if not
    * initialized by create()
@@ -0,0 +1,471 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/store/PackLocalStore.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <algorithm>
+#include <cstring>
+#include <optional>
+
+#include <boost/filesystem.hpp>
+#include <folly/Conv.h>
+#include <folly/Exception.h>
+#include <folly/FileUtil.h>
+#include <folly/io/IOBuf.h>
+#include <folly/lang/Bits.h>
+#include <folly/logging/xlog.h>
+
+#include "eden/fs/store/StoreResult.h"
+
+namespace facebook::eden {
+
+namespace {
+
+constexpr folly::StringPiece kSegmentMagic{"EDENPAK1"};
+constexpr uint64_t kSegmentHeaderSize = kSegmentMagic.size();
+constexpr uint64_t kRecordHeaderSize = 2 * sizeof(uint32_t);
+constexpr folly::StringPiece kSegmentSuffix{".pack"};
+
+/**
+ * Parse "<keySpaceName>.<number>.pack" and return the number.
+ */
+std::optional<uint32_t> parseSegmentNumber(
+    folly::StringPiece keySpaceName,
+    folly::StringPiece fileName) {
+  if (!fileName.removePrefix(keySpaceName) || !fileName.removePrefix(".") ||
+      !fileName.removeSuffix(kSegmentSuffix)) {
+    return std::nullopt;
+  }
+  auto number = folly::tryTo<uint32_t>(fileName);
+  if (!number.hasValue()) {
+    return std::nullopt;
+  }
+  return number.value();
+}
+
+/**
+ * IOBuf free function that drops the reference to the segment a value was
+ * read from.
+ */
+template <typename SegmentPtr>
+void releaseSegment(void* /* buf */, void* userData) {
+  delete static_cast<SegmentPtr*>(userData);
+}
+
+uint64_t recordSize(size_t keyLength, size_t valueLength) {
+  return kRecordHeaderSize + keyLength + valueLength;
+}
+
+class PackWriteBatch : public LocalStore::WriteBatch {
+ public:
+  PackWriteBatch(PackLocalStore& store, size_t bufSize)
+      : store_{store}, bufSize_{bufSize}, records_(KeySpace::kTotalCount) {}
+
+  void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value)
+      override {
+    bufferedBytes_ += key.size() + value.size();
+    records_[keySpace->index].push_back(PackLocalStore::Record{
+        folly::StringPiece{key}.str(), folly::StringPiece{value}.str()});
+    if (bufSize_ > 0 && bufferedBytes_ >= bufSize_) {
+      flush();
+    }
+  }
+
+  void put(
+      KeySpace keySpace,
+      folly::ByteRange key,
+      std::vector<folly::ByteRange> valueSlices) override {
+    std::string value;
+    for (const auto& slice : valueSlices) {
+      value.append(reinterpret_cast<const char*>(slice.data()), slice.size());
+    }
+    put(keySpace, key, folly::StringPiece{value});
+  }
+
+  void flush() override {
+    for (auto& ks : KeySpace::kAll) {
+      auto& records = records_[ks->index];
+      if (!records.empty()) {
+        store_.append(ks, records);
+        records.clear();
+      }
+    }
+    bufferedBytes_ = 0;
+  }
+
+ private:
+  PackLocalStore& store_;
+  size_t bufSize_;
+  size_t bufferedBytes_{0};
+  std::vector<std::vector<PackLocalStore::Record>> records_;
+};
+
+} // namespace
+
+PackLocalStore::Segment::Segment(
+    AbsolutePath path,
+    folly::File file,
+    size_t mappedSize)
+    : path_{std::move(path)}, file_{std::move(file)}, mappedSize_{mappedSize} {
+  // Map the whole reserved size up front. Pages past the end of the file are
+  // never touched until a record has been written there.
+  mapping_ = mmap(nullptr, mappedSize_, PROT_READ, MAP_SHARED, file_.fd(), 0);
+  if (mapping_ == MAP_FAILED) {
+    folly::throwSystemError("unable to mmap pack segment ", path_);
+  }
+}
+
+PackLocalStore::Segment::~Segment() {
+  munmap(mapping_, mappedSize_);
+}
+
+PackLocalStore::PackLocalStore(
+    AbsolutePathPiece directory,
+    uint64_t maxSegmentSize)
+    : directory_{directory.copy()},
+      maxSegmentSize_{std::max<uint64_t>(maxSegmentSize, 4096)} {
+  ensureDirectoryExists(directory_);
+
+  keySpaces_.reserve(KeySpace::kTotalCount);
+  for (size_t i = 0; i < KeySpace::kTotalCount; ++i) {
+    keySpaces_.push_back(std::make_unique<KeySpaceState>());
+  }
+
+  std::vector<std::vector<uint32_t>> segmentNumbers(KeySpace::kTotalCount);
+  for (const auto& entry :
+       boost::filesystem::directory_iterator(directory_.as_boost())) {
+    auto fileName = entry.path().filename().string();
+    for (auto& ks : KeySpace::kAll) {
+      if (auto number = parseSegmentNumber(ks->name, fileName)) {
+        segmentNumbers[ks->index].push_back(*number);
+      }
+    }
+  }
+
+  for (auto& ks : KeySpace::kAll) {
+    auto& numbers = segmentNumbers[ks->index];
+    std::sort(numbers.begin(), numbers.end());
+    for (size_t i = 0; i < numbers.size(); ++i) {
+      loadSegment(
+          ks,
+          numbers[i],
+          segmentPath(ks, numbers[i]),
+          /*isLast=*/i + 1 == numbers.size());
+    }
+    if (!numbers.empty()) {
+      stateFor(ks).writer.nextSegmentNumber = numbers.back() + 1;
+    }
+  }
+}
+
+PackLocalStore::~PackLocalStore() {
+  close();
+}
+
+AbsolutePath PackLocalStore::segmentPath(KeySpace keySpace, uint32_t number)
+    const {
+  return directory_ +
+      PathComponent{folly::to<std::string>(
+          keySpace->name, ".", number, kSegmentSuffix)};
+}
+
+void PackLocalStore::loadSegment(
+    KeySpace keySpace,
+    uint32_t number,
+    AbsolutePathPiece path,
+    bool isLast) {
+  auto& state = stateFor(keySpace);
+
+  folly::File file{path.c_str(), O_RDWR | O_CLOEXEC};
+  struct stat st;
+  folly::checkUnixError(fstat(file.fd(), &st), "unable to stat ", path);
+  auto fileSize = static_cast<uint64_t>(st.st_size);
+
+  auto segment = std::make_shared<Segment>(
+      path.copy(), std::move(file), std::max(fileSize, maxSegmentSize_));
+  auto* data = segment->data();
+  if (fileSize < kSegmentHeaderSize ||
+      memcmp(data, kSegmentMagic.data(), kSegmentHeaderSize) != 0) {
+    XLOG(WARN) << "removing invalid pack segment " << path;
+    unlink(path.c_str());
+    return;
+  }
+
+  uint64_t offset = kSegmentHeaderSize;
+  while (offset + kRecordHeaderSize <= fileSize) {
+    uint32_t keyLength;
+    uint32_t valueLength;
+    memcpy(&keyLength, data + offset, sizeof(uint32_t));
+    memcpy(&valueLength, data + offset + sizeof(uint32_t), sizeof(uint32_t));
+    keyLength = folly::Endian::little(keyLength);
+    valueLength = folly::Endian::little(valueLength);
+
+    auto end = offset + recordSize(keyLength, valueLength);
+    if (end > fileSize) {
+      break;
+    }
+    auto keyStart = offset + kRecordHeaderSize;
+    std::string key{reinterpret_cast<const char*>(data + keyStart), keyLength};
+    auto location = Location{number, keyStart + keyLength, valueLength};
+    bucketFor(state, key).wlock()->insert_or_assign(std::move(key), location);
+    offset = end;
+  }
+
+  if (offset != fileSize) {
+    // The process died while appending this record.
+    XLOG(WARN) << "discarding " << (fileSize - offset)
+               << " bytes of truncated records at the end of " << path;
+    folly::checkUnixError(
+        ftruncate(segment->getFile().fd(), offset),
+        "unable to truncate ",
+        path);
+  }
+
+  state.writer.totalBytes += offset;
+  if (isLast) {
+    state.writer.tail = segment;
+    state.writer.tailNumber = number;
+    state.writer.tailOffset = offset;
+  }
+  state.segments.wlock()->emplace(number, std::move(segment));
+}
+
+void PackLocalStore::createSegment(
+    KeySpace keySpace,
+    Writer& writer,
+    uint64_t minimumSize) {
+  auto number = writer.nextSegmentNumber++;
+  auto path = segmentPath(keySpace, number);
+
+  folly::File file{path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644};
+  if (folly::writeFull(file.fd(), kSegmentMagic.data(), kSegmentHeaderSize) <
+      0) {
+    folly::throwSystemError("unable to write pack segment header to ", path);
+  }
+
+  auto segment = std::make_shared<Segment>(
+      std::move(path), std::move(file), std::max(minimumSize, maxSegmentSize_));
+  stateFor(keySpace).segments.wlock()->emplace(number, segment);
+
+  writer.tail = std::move(segment);
+  writer.tailNumber = number;
+  writer.tailOffset = kSegmentHeaderSize;
+  writer.totalBytes += kSegmentHeaderSize;
+}
+
+void PackLocalStore::appendLocked(
+    KeySpace keySpace,
+    Writer& writer,
+    folly::ByteRange key,
+    folly::ByteRange value) {
+  if (key.size() > std::numeric_limits<uint32_t>::max() ||
+      value.size() > std::numeric_limits<uint32_t>::max()) {
+    throw std::length_error("pack local store records are limited to 4GB");
+  }
+
+  auto size = recordSize(key.size(), value.size());
+  if (!writer.tail ||
+      writer.tailOffset + size > writer.tail->getMappedSize()) {
+    createSegment(keySpace, writer, kSegmentHeaderSize + size);
+  }
+
+  uint32_t header[2] = {
+      folly::Endian::little(static_cast<uint32_t>(key.size())),
+      folly::Endian::little(static_cast<uint32_t>(value.size()))};
+  std::array<iovec, 3> iov;
+  iov[0].iov_base = header;
+  iov[0].iov_len = sizeof(header);
+  iov[1].iov_base = const_cast<uint8_t*>(key.data());
+  iov[1].iov_len = key.size();
+  iov[2].iov_base = const_cast<uint8_t*>(value.data());
+  iov[2].iov_len = value.size();
+
+  auto& segment = *writer.tail;
+  auto written = folly::pwritevFull(
+      segment.getFile().fd(), iov.data(), iov.size(), writer.tailOffset);
+  if (written < 0) {
+    folly::throwSystemError("error appending to ", segment.getPath());
+  }
+
+  // The record is fully in the page cache, and thus visible through the
+  // mapping, before the index points readers at it.
+  auto location = Location{
+      writer.tailNumber,
+      writer.tailOffset + kRecordHeaderSize + key.size(),
+      static_cast<uint32_t>(value.size())};
+  auto keyStr = folly::StringPiece{key};
+  bucketFor(stateFor(keySpace), keyStr)
+      .wlock()
+      ->insert_or_assign(keyStr.str(), location);
+
+  writer.tailOffset += size;
+  writer.totalBytes += size;
+}
+
+void PackLocalStore::close() {
+  for (auto& ks : KeySpace::kAll) {
+    auto& state = stateFor(ks);
+    std::lock_guard<std::mutex> lock{state.writeLock};
+    for (auto& bucket : state.fanout) {
+      bucket.wlock()->clear();
+    }
+    state.segments.wlock()->clear();
+    state.writer.tail.reset();
+  }
+}
+
+void PackLocalStore::clearKeySpace(KeySpace keySpace) {
+  auto& state = stateFor(keySpace);
+  std::lock_guard<std::mutex> lock{state.writeLock};
+
+  for (auto& bucket : state.fanout) {
+    bucket.wlock()->clear();
+  }
+  auto segments = std::move(*state.segments.wlock());
+  state.segments.wlock()->clear();
+  for (const auto& [number, segment] : segments) {
+    // Values that are still referenced keep the unlinked file mapped.
+    unlink(segment->getPath().c_str());
+  }
+
+  state.writer.tail.reset();
+  state.writer.tailOffset = 0;
+  state.writer.totalBytes = 0;
+}
+
+void PackLocalStore::compactKeySpace(KeySpace keySpace) {
+  auto& state = stateFor(keySpace);
+  std::lock_guard<std::mutex> lock{state.writeLock};
+
+  auto oldSegments = *state.segments.rlock();
+  uint64_t liveBytes = 0;
+  for (auto& bucket : state.fanout) {
+    for (const auto& [key, location] : *bucket.rlock()) {
+      liveBytes += recordSize(key.size(), location.length);
+    }
+  }
+  auto overhead = kSegmentHeaderSize * oldSegments.size();
+  if (liveBytes + overhead >= state.writer.totalBytes) {
+    // Nothing has been overwritten; there is no garbage to reclaim.
+    return;
+  }
+
+  XLOG(DBG2) << "compacting pack local store key space " << keySpace->name
+             << ": " << state.writer.totalBytes << " bytes, " << liveBytes
+             << " of them live";
+
+  // Copy the live records into fresh segments. Holding the write lock keeps
+  // the index stable, apart from our own updates.
+  state.writer.tail.reset();
+  state.writer.totalBytes = 0;
+  for (auto& bucket : state.fanout) {
+    auto entries = *bucket.rlock();
+    for (const auto& [key, location] : entries) {
+      const auto& segment = oldSegments.at(location.segment);
+      appendLocked(
+          keySpace,
+          state.writer,
+          folly::StringPiece{key},
+          folly::ByteRange{
+              segment->data() + location.offset, location.length});
+    }
+  }
+
+  {
+    auto segments = state.segments.wlock();
+    for (const auto& [number, segment] : oldSegments) {
+      segments->erase(number);
+    }
+  }
+  for (const auto& [number, segment] : oldSegments) {
+    unlink(segment->getPath().c_str());
+  }
+}
+
+StoreResult PackLocalStore::get(KeySpace keySpace, folly::ByteRange key)
+    const {
+  auto& state = stateFor(keySpace);
+  auto keyStr = folly::StringPiece{key};
+
+  Location location;
+  {
+    auto bucket = bucketFor(state, keyStr).rlock();
+    auto it = bucket->find(keyStr);
+    if (it == bucket->end()) {
+      return StoreResult::missing(keySpace, key);
+    }
+    location = it->second;
+  }
+
+  std::shared_ptr<Segment> segment;
+  {
+    auto segments = state.segments.rlock();
+    auto it = segments->find(location.segment);
+    if (it == segments->end()) {
+      // The key space was cleared or compacted since we read the index.
+      return StoreResult::missing(keySpace, key);
+    }
+    segment = it->second;
+  }
+
+  auto* data = const_cast<uint8_t*>(segment->data() + location.offset);
+  auto buf = folly::IOBuf::takeOwnership(
+      data,
+      location.length,
+      releaseSegment<std::shared_ptr<Segment>>,
+      new std::shared_ptr<Segment>(std::move(segment)));
+  return StoreResult{std::move(buf)};
+}
+
+bool PackLocalStore::hasKey(KeySpace keySpace, folly::ByteRange key) const {
+  auto keyStr = folly::StringPiece{key};
+  auto bucket = bucketFor(stateFor(keySpace), keyStr).rlock();
+  return bucket->find(keyStr) != bucket->end();
+}
+
+void PackLocalStore::put(
+    KeySpace keySpace,
+    folly::ByteRange key,
+    folly::ByteRange value) {
+  auto& state = stateFor(keySpace);
+  std::lock_guard<std::mutex> lock{state.writeLock};
+  appendLocked(keySpace, state.writer, key, value);
+}
+
+void PackLocalStore::append(
+    KeySpace keySpace,
+    const std::vector<Record>& records) {
+  auto& state = stateFor(keySpace);
+  std::lock_guard<std::mutex> lock{state.writeLock};
+  for (const auto& record : records) {
+    appendLocked(
+        keySpace,
+        state.writer,
+        folly::StringPiece{record.key},
+        folly::StringPiece{record.value});
+  }
+}
+
+uint64_t PackLocalStore::getSegmentBytes(KeySpace keySpace) const {
+  auto& state = stateFor(keySpace);
+  std::lock_guard<std::mutex> lock{state.writeLock};
+  return state.writer.totalBytes;
+}
+
+std::unique_ptr<LocalStore::WriteBatch> PackLocalStore::beginWrite(
+    size_t bufSize) {
+  return std::make_unique<PackWriteBatch>(*this, bufSize);
+}
+
+} // namespace facebook::eden
+
+#endif
@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#ifndef _WIN32
+
+#include <folly/File.h>
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "eden/fs/store/KeySpace.h"
+#include "eden/fs/store/LocalStore.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * An implementation of LocalStore that appends values to large,
+ * memory-mapped pack files, in the spirit of git packfiles.
+ *
+ * Every key space is a sequence of pack segments named
+ * "<keyspace>.<number>.pack". Each segment is a small header followed by
+ * records of the form:
+ *
+ *   uint32_t keyLength; uint32_t valueLength; key bytes; value bytes
+ *
+ * Records are only ever appended. Overwriting a key appends a new record
+ * and leaves the old one as garbage for compactKeySpace() to reclaim. The
+ * index from key to record lives in memory and is rebuilt by scanning the
+ * segments on open; a record truncated by a crash ends the scan and is
+ * discarded. It is split into a 256-way fanout table on the first key byte,
+ * each bucket with its own lock, so concurrent lookups rarely contend.
+ *
+ * Segments are mapped once at their full maximum size, so a lookup returns
+ * an IOBuf pointing straight into the mapping, without copying. The IOBuf
+ * keeps the segment mapped until it is released, even if the key space is
+ * cleared or compacted in the meantime.
+ *
+ * Writes are not fsync'ed: like the other stores, this is a cache that can
+ * be repopulated from the backing store.
+ *
+ * PackLocalStore is thread safe, allowing reads and writes from any thread.
+ */
+class PackLocalStore : public LocalStore {
+ public:
+  /**
+   * The size a segment may grow to before writes move on to a new one.
+   */
+  static constexpr uint64_t kDefaultMaxSegmentSize = 1024 * 1024 * 1024;
+
+  explicit PackLocalStore(
+      AbsolutePathPiece directory,
+      uint64_t maxSegmentSize = kDefaultMaxSegmentSize);
+  ~PackLocalStore() override;
+
+  void close() override;
+  void clearKeySpace(KeySpace keySpace) override;
+  void compactKeySpace(KeySpace keySpace) override;
+  StoreResult get(KeySpace keySpace, folly::ByteRange key) const override;
+  bool hasKey(KeySpace keySpace, folly::ByteRange key) const override;
+  void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value)
+      override;
+  std::unique_ptr<LocalStore::WriteBatch> beginWrite(
+      size_t bufSize = 0) override;
+
+  /**
+   * A key and value to append; used by WriteBatch to append many records
+   * while taking the key space's write lock once.
+   */
+  struct Record {
+    std::string key;
+    std::string value;
+  };
+
+  /**
+   * Append the records to the key space, in order.
+   */
+  void append(KeySpace keySpace, const std::vector<Record>& records);
+
+  /**
+   * Return the number of bytes of the key space's segments, including
+   * records that have since been overwritten.
+   */
+  uint64_t getSegmentBytes(KeySpace keySpace) const;
+
+ private:
+  /**
+   * One memory-mapped pack file.
+   */
+  class Segment {
+   public:
+    Segment(AbsolutePath path, folly::File file, size_t mappedSize);
+    ~Segment();
+
+    Segment(const Segment&) = delete;
+    Segment& operator=(const Segment&) = delete;
+
+    const uint8_t* data() const {
+      return static_cast<const uint8_t*>(mapping_);
+    }
+
+    const AbsolutePath& getPath() const {
+      return path_;
+    }
+
+    folly::File& getFile() {
+      return file_;
+    }
+
+    size_t getMappedSize() const {
+      return mappedSize_;
+    }
+
+   private:
+    AbsolutePath path_;
+    folly::File file_;
+    void* mapping_;
+    size_t mappedSize_;
+  };
+
+  struct Location {
+    uint32_t segment;
+    uint64_t offset;
+    uint32_t length;
+  };
+
+  using Bucket = folly::F14FastMap<std::string, Location>;
+
+  /**
+   * The write-side state of a key space. Held while appending, clearing or
+   * compacting.
+   */
+  struct Writer {
+    /**
+     * The segment records are appended to, or nullptr if a new one has to
+     * be created by the next append.
+     */
+    std::shared_ptr<Segment> tail;
+    uint32_t tailNumber{0};
+    /**
+     * The offset at which the next record is written in the tail segment.
+     */
+    uint64_t tailOffset{0};
+    /**
+     * The segment number to use for the next new segment.
+     */
+    uint32_t nextSegmentNumber{0};
+    /**
+     * The size of all the key space's segments.
+     */
+    uint64_t totalBytes{0};
+  };
+
+  struct KeySpaceState {
+    std::mutex writeLock;
+    Writer writer;
+    /**
+     * Segments by their number.
+     */
+    folly::Synchronized<
+        folly::F14FastMap<uint32_t, std::shared_ptr<Segment>>>
+        segments;
+    std::array<folly::Synchronized<Bucket>, 256> fanout;
+  };
+
+  KeySpaceState& stateFor(KeySpace keySpace) const {
+    return *keySpaces_[keySpace->index];
+  }
+
+  static folly::Synchronized<Bucket>& bucketFor(
+      KeySpaceState& state,
+      folly::StringPiece key) {
+    return state.fanout[key.empty() ? 0 : static_cast<uint8_t>(key[0])];
+  }
+
+  void loadSegment(
+      KeySpace keySpace,
+      uint32_t number,
+      AbsolutePathPiece path,
+      bool isLast);
+
+  /**
+   * Start a new tail segment, mapped large enough to hold at least
+   * minimumSize bytes.
+   */
+  void createSegment(KeySpace keySpace, Writer& writer, uint64_t minimumSize);
+
+  /**
+   * Append one record. Must be called with the key space's write lock held.
+   */
+  void appendLocked(
+      KeySpace keySpace,
+      Writer& writer,
+      folly::ByteRange key,
+      folly::ByteRange value);
+
+  AbsolutePath segmentPath(KeySpace keySpace, uint32_t number) const;
+
+  const AbsolutePath directory_;
+  const uint64_t maxSegmentSize_;
+  std::vector<std::unique_ptr<KeySpaceState>> keySpaces_;
+};
+
+} // namespace facebook::eden
+
+#endif
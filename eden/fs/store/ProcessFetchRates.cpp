@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/ProcessFetchRates.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace facebook::eden {
+
+namespace {
+
+/**
+ * After this many windows without fetching, a process's rates are below
+ * e^-10 of what they were, and it is not worth remembering.
+ */
+constexpr int kIdleWindows = 10;
+
+double toSeconds(ProcessFetchRates::Clock::duration duration) {
+  return std::chrono::duration<double>(duration).count();
+}
+
+} // namespace
+
+ProcessFetchRates::ProcessFetchRates(size_t maximumProcesses)
+    : maximumProcesses_{maximumProcesses} {}
+
+ProcessFetchRates::Rates ProcessFetchRates::decay(
+    const Entry& entry,
+    Clock::duration window,
+    Clock::time_point now) {
+  auto elapsed = now - entry.lastUpdate;
+  if (elapsed <= Clock::duration::zero()) {
+    return entry.rates;
+  }
+  auto factor = std::exp(-toSeconds(elapsed) / toSeconds(window));
+  return Rates{
+      entry.rates.requestsPerSecond * factor,
+      entry.rates.bytesPerSecond * factor};
+}
+
+ProcessFetchRates::Rates ProcessFetchRates::record(
+    pid_t pid,
+    uint64_t bytes,
+    Clock::duration window,
+    Clock::time_point now) {
+  // Each fetch adds 1/window to the rate, so that the rate of a process
+  // fetching N objects a second converges to N.
+  auto windowSeconds = toSeconds(window);
+  auto entries = entries_.wlock();
+
+  if (entries->size() >= maximumProcesses_ &&
+      entries->find(pid) == entries->end()) {
+    auto idleBefore = now - window * kIdleWindows;
+    for (auto it = entries->begin(); it != entries->end();) {
+      if (it->second.lastUpdate < idleBefore) {
+        it = entries->erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  auto [it, inserted] = entries->try_emplace(pid, Entry{Rates{}, now});
+  auto& entry = it->second;
+  entry.rates = decay(entry, window, now);
+  entry.rates.requestsPerSecond += 1.0 / windowSeconds;
+  entry.rates.bytesPerSecond += static_cast<double>(bytes) / windowSeconds;
+  entry.lastUpdate = std::max(entry.lastUpdate, now);
+  return entry.rates;
+}
+
+ProcessFetchRates::Rates ProcessFetchRates::get(
+    pid_t pid,
+    Clock::duration window,
+    Clock::time_point now) const {
+  auto entries = entries_.rlock();
+  auto it = entries->find(pid);
+  if (it == entries->end()) {
+    return Rates{};
+  }
+  return decay(it->second, window, now);
+}
+
+std::unordered_map<pid_t, ProcessFetchRates::Rates> ProcessFetchRates::getAll(
+    Clock::duration window,
+    Clock::time_point now) const {
+  std::unordered_map<pid_t, Rates> result;
+  auto idleBefore = now - window * kIdleWindows;
+  auto entries = entries_.rlock();
+  for (const auto& [pid, entry] : *entries) {
+    if (entry.lastUpdate >= idleBefore) {
+      result.emplace(pid, decay(entry, window, now));
+    }
+  }
+  return result;
+}
+
+void ProcessFetchRates::clear() {
+  entries_.wlock()->clear();
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <sys/types.h>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+
+namespace facebook::eden {
+
+/**
+ * The recent fetch rates of every process fetching objects, as the number
+ * of fetches and of bytes fetched per second.
+ *
+ * Rates are decayed exponentially over a window: a process fetching
+ * steadily converges to its actual rate within a few windows, and one that
+ * stops fetching decays back to 0 just as fast. Processes idle for long
+ * enough are forgotten.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class ProcessFetchRates {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Rates {
+    double requestsPerSecond{0.0};
+    double bytesPerSecond{0.0};
+  };
+
+  explicit ProcessFetchRates(size_t maximumProcesses = 4096);
+
+  /**
+   * Record a fetch of bytes by pid, and return its updated rates.
+   */
+  Rates record(
+      pid_t pid,
+      uint64_t bytes,
+      Clock::duration window,
+      Clock::time_point now = Clock::now());
+
+  /**
+   * pid's rates as of now, all 0 if it didn't fetch recently.
+   */
+  Rates get(
+      pid_t pid,
+      Clock::duration window,
+      Clock::time_point now = Clock::now()) const;
+
+  /**
+   * The rates of every process that fetched recently.
+   */
+  std::unordered_map<pid_t, Rates> getAll(
+      Clock::duration window,
+      Clock::time_point now = Clock::now()) const;
+
+  void clear();
+
+ private:
+  struct Entry {
+    Rates rates;
+    Clock::time_point lastUpdate;
+  };
+
+  static Rates decay(
+      const Entry& entry,
+      Clock::duration window,
+      Clock::time_point now);
+
+  const size_t maximumProcesses_;
+  folly::Synchronized<folly::F14FastMap<pid_t, Entry>> entries_;
+};
+
+} // namespace facebook::eden
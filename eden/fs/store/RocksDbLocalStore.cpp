@@ -7,21 +7,28 @@
 
 #include "eden/fs/store/RocksDbLocalStore.h"
 
+#include <algorithm>
 #include <array>
 #include <atomic>
+#include <thread>
 
 #include <fb303/ServiceData.h>
 #include <folly/Format.h>
 #include <folly/String.h>
 #include <folly/futures/Future.h>
+#include <folly/hash/SpookyHashV2.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 #include <folly/lang/Bits.h>
 #include <folly/logging/xlog.h>
+#include <folly/stop_watch.h>
+#include <rocksdb/cache.h>
 #include <rocksdb/convenience.h>
 #include <rocksdb/db.h>
 #include <rocksdb/filter_policy.h>
+#include <rocksdb/statistics.h>
 #include <rocksdb/table.h>
+#include <rocksdb/version.h>
 
 #include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/rocksdb/RocksException.h"
@@ -43,18 +50,96 @@ using std::chrono::duration_cast;
 namespace {
 using namespace facebook::eden;
 
-rocksdb::ColumnFamilyOptions makeColumnOptions(uint64_t LRUblockCacheSizeMB) {
+// Integrated blob files were added to RocksDB in 6.18.
+#if ROCKSDB_MAJOR > 6 || (ROCKSDB_MAJOR == 6 && ROCKSDB_MINOR >= 18)
+#define EDEN_ROCKSDB_HAVE_BLOB_FILES 1
+
+// Blob values at least this large are written to blob files rather than
+// inlined into the SST files, keeping them out of the compaction path.
+constexpr uint64_t kMinBlobFileValueSize = 4096;
+#endif
+
+/**
+ * The compression to use for compressible data. RocksDB is built without LZ4
+ * on Windows, and asking for an unsupported compression type fails the open.
+ */
+constexpr rocksdb::CompressionType kDataCompression =
+#ifdef _WIN32
+    rocksdb::kNoCompression;
+#else
+    rocksdb::kLZ4Compression;
+#endif
+
+/**
+ * The block caches shared by the column families. Trees and metadata are
+ * small and looked up constantly, so they get the larger share. Blob data
+ * gets its own smaller cache; the assumption is that the vfs cache and
+ * EdenFS's in-memory BlobCache will compensate for that.
+ */
+struct BlockCaches {
+  std::shared_ptr<rocksdb::Cache> metadata = rocksdb::NewLRUCache(64 << 20);
+  std::shared_ptr<rocksdb::Cache> blob = rocksdb::NewLRUCache(8 << 20);
+};
+
+rocksdb::ColumnFamilyOptions makeColumnOptions(
+    std::shared_ptr<rocksdb::Cache> blockCache) {
   rocksdb::ColumnFamilyOptions options;
 
   // We'll never perform range scans on any of the keys that we store.
   // This enables bloom filters and a hash policy that improves our
   // get/put performance.
-  options.OptimizeForPointLookup(LRUblockCacheSizeMB);
+  options.OptimizeForPointLookup(0);
+
+  rocksdb::BlockBasedTableOptions tableOptions;
+  tableOptions.block_cache = std::move(blockCache);
+  tableOptions.data_block_index_type =
+      rocksdb::BlockBasedTableOptions::kDataBlockBinaryAndHash;
+  tableOptions.data_block_hash_table_util_ratio = 0.75;
+  // Every lookup is for a full key, so whole-key bloom filters let a miss
+  // skip reading data blocks entirely.
+  tableOptions.filter_policy.reset(rocksdb::NewBloomFilterPolicy(10, false));
+  tableOptions.whole_key_filtering = true;
+  options.table_factory.reset(rocksdb::NewBlockBasedTableFactory(tableOptions));
 
   options.OptimizeLevelStyleCompaction();
   return options;
 }
 
+/**
+ * Tuned options for a key space.
+ *
+ * - Blobs and blob chunks are large, write-once values. They go to
+ *   integrated blob files when RocksDB supports them, so compactions only
+ *   rewrite the keys.
+ * - Trees are small, compressible and point-looked-up.
+ * - Everything else holds hashes and sizes, which don't compress, so
+ *   compression would only cost CPU.
+ */
+rocksdb::ColumnFamilyOptions makeColumnOptions(
+    const KeySpaceRecord& ks,
+    const BlockCaches& caches) {
+  if (ks.index == KeySpace::BlobFamily.index ||
+      ks.index == KeySpace::BlobChunkFamily.index) {
+    auto options = makeColumnOptions(caches.blob);
+    options.compression = kDataCompression;
+#ifdef EDEN_ROCKSDB_HAVE_BLOB_FILES
+    options.enable_blob_files = true;
+    options.min_blob_size = kMinBlobFileValueSize;
+    options.blob_compression_type = kDataCompression;
+    // Blobs are cleared when the key space exceeds its size limit; reclaim
+    // the blob files of deleted values during compaction.
+    options.enable_blob_garbage_collection = true;
+#endif
+    return options;
+  }
+
+  auto options = makeColumnOptions(caches.metadata);
+  options.compression = ks.index == KeySpace::TreeFamily.index
+      ? kDataCompression
+      : rocksdb::kNoCompression;
+  return options;
+}
+
 /**
  * The different key spaces that we desire.
  * The ordering is coupled with the values of the KeySpace enum.
@@ -62,12 +147,8 @@ rocksdb::ColumnFamilyOptions makeColumnOptions(uint64_t LRUblockCacheSizeMB) {
 const std::vector<rocksdb::ColumnFamilyDescriptor> columnFamilies(
     const rocksdb::DBOptions& db_options,
     const std::string& name) {
-  // Most of the column families will share the same cache.  We
-  // want the blob data to live in its own smaller cache; the assumption
-  // is that the vfs cache will compensate for that, together with the
-  // idea that we shouldn't need to materialize a great many files.
-  auto options = makeColumnOptions(64);
-  auto blobOptions = makeColumnOptions(8);
+  BlockCaches caches;
+  auto options = makeColumnOptions(caches.metadata);
 
   // We have to open all column families that currenly exists in our RocksDb.
   // Else we will get "Invalid argument: You have to open all column
@@ -80,9 +161,7 @@ const std::vector<rocksdb::ColumnFamilyDescriptor> columnFamilies(
 
   std::vector<rocksdb::ColumnFamilyDescriptor> families;
   for (auto& ks : KeySpace::kAll) {
-    families.emplace_back(
-        ks->name.str(),
-        (ks->index == KeySpace::BlobFamily.index) ? blobOptions : options);
+    families.emplace_back(ks->name.str(), makeColumnOptions(*ks, caches));
     auto oldFamily = find(
         oldUnopenedColumnFamilies.begin(),
         oldUnopenedColumnFamilies.end(),
@@ -134,6 +213,53 @@ rocksdb::Slice _createSlice(folly::ByteRange bytes) {
   return Slice(reinterpret_cast<const char*>(bytes.data()), bytes.size());
 }
 
+// The maximum number of keys looked up by a single MultiGet call.
+constexpr size_t kMaxMultiGetKeys = 2048;
+
+// The number of distinct hot keys the recent access sketch is sized for.
+constexpr size_t kRecentAccessEntries = 1 << 20;
+
+// Deletions issued by evictColdKeys() are written in batches of this size.
+constexpr size_t kEvictionBatchSize = 1024;
+
+using RecentAccesses = folly::Synchronized<FrequencySketch, std::mutex>;
+
+void recordKeyAccess(
+    RecentAccesses& recentAccesses,
+    KeySpace keySpace,
+    folly::ByteRange key) {
+  if (keySpace->isEphemeral()) {
+    auto hash = folly::hash::SpookyHashV2::Hash64(key.data(), key.size(), 0);
+    recentAccesses.lock()->increment(hash);
+  }
+}
+
+/**
+ * Turn the outcome of a RocksDB lookup into a StoreResult. A missing key
+ * yields an empty StoreResult; any other error is thrown.
+ */
+StoreResult makeStoreResult(
+    const rocksdb::Status& status,
+    std::string&& value,
+    KeySpace keySpace,
+    folly::ByteRange key) {
+  if (!status.ok()) {
+    if (status.IsNotFound()) {
+      // Return an empty StoreResult
+      return StoreResult::missing(keySpace, key);
+    }
+
+    // TODO: RocksDB can return a "TryAgain" error.
+    // Should we try again for the user, rather than re-throwing the error?
+
+    // We don't use RocksException::check(), since we don't want to waste our
+    // time computing the hex string of the key if we succeeded.
+    throw RocksException::build(
+        status, "failed to get ", folly::hexlify(key), " from local store");
+  }
+  return StoreResult(std::move(value));
+}
+
 class RocksDbWriteBatch : public LocalStore::WriteBatch {
  public:
   void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value)
@@ -147,11 +273,15 @@ class RocksDbWriteBatch : public LocalStore::WriteBatch {
   // Use LocalStore::beginWrite() to create a write batch
   RocksDbWriteBatch(
       Synchronized<RocksHandles>::ConstRLockedPtr&& dbHandles,
+      RecentAccesses& recentAccesses,
+      LocalStoreStats& stats,
       size_t bufferSize);
 
   void flushIfNeeded();
 
   folly::Synchronized<RocksHandles>::ConstRLockedPtr lockedDB_;
+  RecentAccesses& recentAccesses_;
+  LocalStoreStats& stats_;
   rocksdb::WriteBatch writeBatch_;
   size_t bufSize_;
 };
@@ -165,7 +295,9 @@ void RocksDbWriteBatch::flush() {
   XLOG(DBG5) << "Flushing " << pending << " entries with data size of "
              << writeBatch_.GetDataSize();
 
+  folly::stop_watch<std::chrono::microseconds> watch;
   auto status = lockedDB_->db->Write(WriteOptions(), &writeBatch_);
+  stats_.recordWriteBatchFlush(watch.elapsed());
   XLOG(DBG5) << "... Flushed";
 
   if (!status.ok()) {
@@ -186,9 +318,13 @@ void RocksDbWriteBatch::flushIfNeeded() {
 
 RocksDbWriteBatch::RocksDbWriteBatch(
     Synchronized<RocksHandles>::ConstRLockedPtr&& dbHandles,
+    RecentAccesses& recentAccesses,
+    LocalStoreStats& stats,
     size_t bufSize)
     : LocalStore::WriteBatch(),
       lockedDB_(std::move(dbHandles)),
+      recentAccesses_(recentAccesses),
+      stats_(stats),
       writeBatch_(bufSize),
       bufSize_(bufSize) {}
 
@@ -207,6 +343,8 @@ void RocksDbWriteBatch::put(
       lockedDB_->columns[keySpace->index].get(),
       _createSlice(key),
       _createSlice(value));
+  recordKeyAccess(recentAccesses_, keySpace, key);
+  stats_.recordBytes(keySpace, LocalStoreStats::Operation::Put, value.size());
 
   flushIfNeeded();
 }
@@ -216,9 +354,11 @@ void RocksDbWriteBatch::put(
     folly::ByteRange key,
     std::vector<folly::ByteRange> valueSlices) {
   std::vector<Slice> slices;
+  size_t valueSize = 0;
 
   for (auto& valueSlice : valueSlices) {
     slices.emplace_back(_createSlice(valueSlice));
+    valueSize += valueSlice.size();
   }
 
   auto keySlice = _createSlice(key);
@@ -227,6 +367,8 @@ void RocksDbWriteBatch::put(
       lockedDB_->columns[keySpace->index].get(),
       keyParts,
       SliceParts(slices.data(), slices.size()));
+  recordKeyAccess(recentAccesses_, keySpace, key);
+  stats_.recordBytes(keySpace, LocalStoreStats::Operation::Put, valueSize);
 
   flushIfNeeded();
 }
@@ -244,6 +386,12 @@ rocksdb::Options getRocksdbOptions() {
   // Make sure we never hold more than 128MB onto the WAL
   options.max_total_wal_size = 128 * 1024 * 1024;
 
+  // Count block cache hits, stalls and the like for publishRocksDbStats().
+  options.statistics = rocksdb::CreateDBStatistics();
+
+  // Split large manual compactions across the background threads.
+  options.max_subcompactions = RocksDbLocalStore::kCompactionThreadCount;
+
   return options;
 }
 
@@ -277,11 +425,14 @@ RocksDbLocalStore::RocksDbLocalStore(
     AbsolutePathPiece pathToRocksDb,
     std::shared_ptr<StructuredLogger> structuredLogger,
     FaultInjector* faultInjector,
-    RocksDBOpenMode mode)
+    RocksDBOpenMode mode,
+    size_t ioThreadCount)
     : structuredLogger_{std::move(structuredLogger)},
       faultInjector_(*faultInjector),
-      ioPool_(12, "RocksLocalStore"),
-      dbHandles_(folly::in_place, openDB(pathToRocksDb, mode)) {
+      ioPool_(std::max<size_t>(ioThreadCount, 1), "RocksLocalStore"),
+      recentAccesses_(folly::in_place, kRecentAccessEntries),
+      dbHandles_(folly::in_place, openDB(pathToRocksDb, mode)),
+      compactionPool_(kCompactionThreadCount, "RocksCompaction") {
   // Publish fb303 stats once when we first open the DB.
   // These will be kept up-to-date later by the periodicManagementTask() call.
   computeStats(/*publish=*/true, /*config=*/nullptr);
@@ -293,6 +444,9 @@ RocksDbLocalStore::~RocksDbLocalStore() {
 }
 
 void RocksDbLocalStore::close() {
+  // Don't wait for background compactions to finish.
+  setManualCompactionEnabled(false);
+
   // Acquire dbHandles_ in write-lock mode.
   // Since any other access to the DB acquires a read lock this will block until
   // all current DB operations are complete.
@@ -374,7 +528,86 @@ void RocksDbLocalStore::compactKeySpace(KeySpace keySpace) {
   }
 }
 
+std::shared_ptr<CompactionJob> RocksDbLocalStore::startCompaction(
+    bool clearCaches) {
+  auto job = std::make_shared<CompactionJob>(KeySpace::kAll.size());
+  job->setCancelCallback([weakStore = weak_from_this()] {
+    if (auto store = weakStore.lock()) {
+      static_cast<const RocksDbLocalStore&>(*store)
+          .setManualCompactionEnabled(false);
+    }
+  });
+
+  auto setCounter = [this](folly::StringPiece name, int64_t value) {
+    fb303::fbData->setCounter(
+        folly::to<string>(statsPrefix_, "compaction.", name), value);
+  };
+  setCounter("running", 1);
+  setCounter("total_key_spaces", job->getTotalKeySpaces());
+  setCounter("completed_key_spaces", 0);
+
+  // Every task and the final callback run on compactionPool_, whose threads
+  // are joined before the rest of the store is destroyed, so capturing this
+  // is safe even when the store isn't owned by a shared_ptr.
+  std::vector<folly::Future<folly::Unit>> futures;
+  futures.reserve(KeySpace::kAll.size());
+  for (auto& ks : KeySpace::kAll) {
+    futures.push_back(folly::via(
+        &compactionPool_, [this, job, ks, clearCaches, setCounter] {
+          if (job->isCancelled()) {
+            return;
+          }
+          if (clearCaches && ks->isEphemeral()) {
+            clearKeySpace(ks);
+          }
+          compactKeySpace(ks);
+          job->keySpaceCompleted();
+          setCounter("completed_key_spaces", job->getCompletedKeySpaces());
+        }));
+  }
+
+  folly::stop_watch<std::chrono::milliseconds> watch;
+  folly::collectAll(std::move(futures))
+      .toUnsafeFuture()
+      .thenValue([this, job, setCounter, watch](
+                     std::vector<folly::Try<folly::Unit>> results) {
+        folly::exception_wrapper error;
+        if (job->isCancelled()) {
+          // Interrupted compactions fail, which is expected.
+          setManualCompactionEnabled(true);
+        } else {
+          for (auto& result : results) {
+            if (result.hasException()) {
+              error = std::move(result.exception());
+              break;
+            }
+          }
+        }
+        setCounter("running", 0);
+        XLOG(INFO) << "local store compaction "
+                   << (job->isCancelled() ? "cancelled" : "finished")
+                   << " after " << watch.elapsed().count() << "ms, "
+                   << job->getCompletedKeySpaces() << " of "
+                   << job->getTotalKeySpaces() << " key spaces compacted";
+        job->finish(std::move(error));
+      });
+  return job;
+}
+
+void RocksDbLocalStore::setManualCompactionEnabled(bool enabled) const {
+  auto handles = dbHandles_.rlock();
+  if (!handles->db) {
+    return;
+  }
+  if (enabled) {
+    handles->db->EnableManualCompaction();
+  } else {
+    handles->db->DisableManualCompaction();
+  }
+}
+
 StoreResult RocksDbLocalStore::get(KeySpace keySpace, ByteRange key) const {
+  folly::stop_watch<std::chrono::microseconds> watch;
   auto handles = getHandles();
   string value;
   auto status = handles->db->Get(
@@ -382,56 +615,142 @@ StoreResult RocksDbLocalStore::get(KeySpace keySpace, ByteRange key) const {
       handles->columns[keySpace->index].get(),
       _createSlice(key),
       &value);
-  if (!status.ok()) {
-    if (status.IsNotFound()) {
-      // Return an empty StoreResult
-      return StoreResult::missing(keySpace, key);
-    }
-
-    // TODO: RocksDB can return a "TryAgain" error.
-    // Should we try again for the user, rather than re-throwing the error?
-
-    // We don't use RocksException::check(), since we don't want to waste our
-    // time computing the hex string of the key if we succeeded.
-    throw RocksException::build(
-        status, "failed to get ", folly::hexlify(key), " from local store");
+  stats_.recordLatency(
+      keySpace, LocalStoreStats::Operation::Get, watch.elapsed());
+  if (status.ok()) {
+    recordAccess(keySpace, key);
+    stats_.recordBytes(keySpace, LocalStoreStats::Operation::Get, value.size());
   }
-  return StoreResult(std::move(value));
+  return makeStoreResult(status, std::move(value), keySpace, key);
+}
+
+void RocksDbLocalStore::recordAccess(KeySpace keySpace, ByteRange key) const {
+  recordKeyAccess(recentAccesses_, keySpace, key);
 }
 
 FOLLY_NODISCARD folly::Future<StoreResult> RocksDbLocalStore::getFuture(
     KeySpace keySpace,
     folly::ByteRange key) const {
-  // We're really just passing key through to the get() method, but we need to
-  // make a copy of it on the way through.  It will usually be an eden::Hash
-  // but can potentially be an arbitrary length so we can't just use Hash as
-  // the storage here.  std::string is appropriate, but there's some noise
-  // with the conversion from unsigned/signed and back again.
-  return faultInjector_.checkAsync("local store get single", "")
-      .via(&ioPool_)
-      .thenValue([keySpace,
-                  key = std::string(
-                      reinterpret_cast<const char*>(key.data()), key.size()),
-                  this](folly::Unit&&) {
-        return get(
-            keySpace,
-            folly::ByteRange(
-                reinterpret_cast<const unsigned char*>(key.data()),
-                key.size()));
+  // We need to make a copy of the key on the way through.  It will usually
+  // be an eden::Hash but can potentially be an arbitrary length so we can't
+  // just use Hash as the storage here.
+  auto keyStr =
+      std::string(reinterpret_cast<const char*>(key.data()), key.size());
+  auto faultCheck = faultInjector_.checkAsync("local store get single", "");
+  if (!faultCheck.isReady()) {
+    return std::move(faultCheck)
+        .via(&ioPool_)
+        .thenValue([this, keySpace, keyStr = std::move(keyStr)](
+                       folly::Unit&&) mutable {
+          return enqueueGet(keySpace, std::move(keyStr));
+        });
+  }
+  if (faultCheck.hasException()) {
+    return folly::makeFuture<StoreResult>(
+        std::move(faultCheck).getTry().exception());
+  }
+  return enqueueGet(keySpace, std::move(keyStr)).via(&ioPool_);
+}
+
+folly::SemiFuture<StoreResult> RocksDbLocalStore::enqueueGet(
+    KeySpace keySpace,
+    std::string key) const {
+  auto [promise, future] = folly::makePromiseContract<StoreResult>();
+  bool scheduleDrain = false;
+  {
+    auto pending = pendingGets_.lock();
+    pending->gets.push_back(PendingGet{
+        keySpace,
+        std::move(key),
+        std::move(promise),
+        std::chrono::steady_clock::now()});
+    if (!pending->drainScheduled) {
+      pending->drainScheduled = true;
+      scheduleDrain = true;
+    }
+  }
+  if (scheduleDrain) {
+    ioPool_.add([this] { drainPendingGets(); });
+  }
+  return std::move(future);
+}
+
+void RocksDbLocalStore::drainPendingGets() const {
+  std::vector<PendingGet> gets;
+  {
+    auto pending = pendingGets_.lock();
+    if (pending->gets.size() <= kMaxMultiGetKeys) {
+      gets.swap(pending->gets);
+      pending->drainScheduled = false;
+    } else {
+      // Leave the rest to another drain so a burst of lookups is spread
+      // over the I/O pool rather than serialized on this thread.
+      auto split = pending->gets.begin() + kMaxMultiGetKeys;
+      gets.assign(
+          std::make_move_iterator(pending->gets.begin()),
+          std::make_move_iterator(split));
+      pending->gets.erase(pending->gets.begin(), split);
+      ioPool_.add([this] { drainPendingGets(); });
+    }
+  }
+
+  XLOG(DBG7) << "looking up " << gets.size() << " coalesced keys";
+  try {
+    auto handles = getHandles();
+    std::vector<Slice> keySlices;
+    std::vector<rocksdb::ColumnFamilyHandle*> columns;
+    keySlices.reserve(gets.size());
+    columns.reserve(gets.size());
+    for (auto& get : gets) {
+      keySlices.emplace_back(get.key);
+      columns.emplace_back(handles->columns[get.keySpace->index].get());
+    }
+    std::vector<std::string> values;
+    auto statuses =
+        handles->db->MultiGet(ReadOptions(), columns, keySlices, &values);
+
+    // The latency includes the time spent queued, as seen by the caller.
+    auto now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < gets.size(); ++i) {
+      auto& get = gets[i];
+      auto key = folly::ByteRange{folly::StringPiece{get.key}};
+      stats_.recordLatency(
+          get.keySpace,
+          LocalStoreStats::Operation::Get,
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              now - get.enqueued));
+      if (statuses[i].ok()) {
+        recordAccess(get.keySpace, key);
+        stats_.recordBytes(
+            get.keySpace, LocalStoreStats::Operation::Get, values[i].size());
+      }
+      get.promise.setWith([&] {
+        return makeStoreResult(
+            statuses[i], std::move(values[i]), get.keySpace, key);
       });
+    }
+  } catch (const std::exception& ex) {
+    auto ew = folly::exception_wrapper{std::current_exception(), ex};
+    for (auto& get : gets) {
+      if (!get.promise.isFulfilled()) {
+        get.promise.setException(ew);
+      }
+    }
+  }
 }
 
 FOLLY_NODISCARD folly::Future<std::vector<StoreResult>>
 RocksDbLocalStore::getBatch(
     KeySpace keySpace,
     const std::vector<folly::ByteRange>& keys) const {
+  folly::stop_watch<std::chrono::microseconds> watch;
   std::vector<folly::Future<std::vector<StoreResult>>> futures;
 
   std::vector<std::shared_ptr<std::vector<std::string>>> batches;
   batches.emplace_back(std::make_shared<std::vector<std::string>>());
 
   for (auto& key : keys) {
-    if (batches.back()->size() >= 2048) {
+    if (batches.back()->size() >= kMaxMultiGetKeys) {
       batches.emplace_back(std::make_shared<std::vector<std::string>>());
     }
     batches.back()->emplace_back(
@@ -458,38 +777,28 @@ RocksDbLocalStore::getBatch(
                   ReadOptions(), columns, keySlices, &values);
 
               std::vector<StoreResult> results;
+              results.reserve(keys->size());
+              size_t bytes = 0;
               for (size_t i = 0; i < keys->size(); ++i) {
-                auto& status = statuses[i];
-                if (!status.ok()) {
-                  if (status.IsNotFound()) {
-                    // Return an empty StoreResult
-                    results.push_back(StoreResult::missing(
-                        keySpace,
-                        folly::ByteRange{folly::StringPiece{keys->at(i)}}));
-                    continue;
-                  }
-
-                  // TODO: RocksDB can return a "TryAgain" error.
-                  // Should we try again for the user, rather than
-                  // re-throwing the error?
-
-                  // We don't use RocksException::check(), since we don't
-                  // want to waste our time computing the hex string of the
-                  // key if we succeeded.
-                  throw RocksException::build(
-                      status,
-                      "failed to get ",
-                      folly::hexlify(keys->at(i)),
-                      " from local store");
+                auto key = folly::ByteRange{folly::StringPiece{keys->at(i)}};
+                if (statuses[i].ok()) {
+                  store->recordAccess(keySpace, key);
+                  bytes += values[i].size();
                 }
-                results.emplace_back(std::move(values[i]));
+                results.push_back(makeStoreResult(
+                    statuses[i], std::move(values[i]), keySpace, key));
               }
+              store->stats_.recordBytes(
+                  keySpace, LocalStoreStats::Operation::GetBatch, bytes);
               return results;
             }));
   }
 
   return folly::collectUnsafe(futures).thenValue(
-      [](std::vector<std::vector<StoreResult>>&& tries) {
+      [store = getSharedFromThis(), keySpace, watch](
+          std::vector<std::vector<StoreResult>>&& tries) {
+        store->stats_.recordLatency(
+            keySpace, LocalStoreStats::Operation::GetBatch, watch.elapsed());
         std::vector<StoreResult> results;
         for (auto& batch : tries) {
           results.insert(
@@ -527,19 +836,25 @@ bool RocksDbLocalStore::hasKey(KeySpace keySpace, folly::ByteRange key) const {
 
 std::unique_ptr<LocalStore::WriteBatch> RocksDbLocalStore::beginWrite(
     size_t bufSize) {
-  return std::make_unique<RocksDbWriteBatch>(getHandles(), bufSize);
+  return std::make_unique<RocksDbWriteBatch>(
+      getHandles(), recentAccesses_, stats_, bufSize);
 }
 
 void RocksDbLocalStore::put(
     KeySpace keySpace,
     folly::ByteRange key,
     folly::ByteRange value) {
+  folly::stop_watch<std::chrono::microseconds> watch;
   auto handles = getHandles();
   handles->db->Put(
       WriteOptions(),
       handles->columns[keySpace->index].get(),
       _createSlice(key),
       _createSlice(value));
+  recordAccess(keySpace, key);
+  stats_.recordLatency(
+      keySpace, LocalStoreStats::Operation::Put, watch.elapsed());
+  stats_.recordBytes(keySpace, LocalStoreStats::Operation::Put, value.size());
 }
 
 uint64_t RocksDbLocalStore::getApproximateSize(KeySpace keySpace) const {
@@ -610,7 +925,7 @@ void RocksDbLocalStore::periodicManagementTask(const EdenConfig& config) {
                << "ephemeral data sizes of columns " << keySpaceNames
                << " exceed their limits; total ephemeral size = "
                << before.ephemeral;
-    triggerAutoGC(before);
+    triggerAutoGC(before, config);
   }
 }
 
@@ -643,11 +958,63 @@ RocksDbLocalStore::SizeSummary RocksDbLocalStore::computeStats(
     fb303::fbData->setCounter(
         folly::to<string>(statsPrefix_, "persistent.total_size"),
         result.persistent);
+    publishRocksDbStats();
   }
 
   return result;
 }
 
+void RocksDbLocalStore::publishRocksDbStats() const {
+  auto handles = getHandles();
+  auto setCounter = [&](folly::StringPiece name, int64_t value) {
+    fb303::fbData->setCounter(
+        folly::to<string>(statsPrefix_, "rocksdb.", name), value);
+  };
+
+  for (const auto& ks : KeySpace::kAll) {
+    if (ks->isDeprecated()) {
+      continue;
+    }
+    uint64_t pendingCompactionBytes;
+    if (handles->db->GetIntProperty(
+            handles->columns[ks->index].get(),
+            rocksdb::DB::Properties::kEstimatePendingCompactionBytes,
+            &pendingCompactionBytes)) {
+      fb303::fbData->setCounter(
+          folly::to<string>(
+              statsPrefix_, ks->name, ".pending_compaction_bytes"),
+          pendingCompactionBytes);
+    }
+  }
+
+  uint64_t value;
+  if (handles->db->GetIntProperty(
+          rocksdb::DB::Properties::kIsWriteStopped, &value)) {
+    setCounter("write_stopped", value);
+  }
+  if (handles->db->GetIntProperty(
+          rocksdb::DB::Properties::kActualDelayedWriteRate, &value)) {
+    setCounter("delayed_write_rate", value);
+  }
+
+  auto statistics = handles->db->GetDBOptions().statistics;
+  if (!statistics) {
+    return;
+  }
+  auto hits = statistics->getTickerCount(rocksdb::BLOCK_CACHE_HIT);
+  auto misses = statistics->getTickerCount(rocksdb::BLOCK_CACHE_MISS);
+  setCounter("block_cache_hit", hits);
+  setCounter("block_cache_miss", misses);
+  // In percent, since fb303 counters are integers.
+  setCounter(
+      "block_cache_hit_rate",
+      hits + misses == 0 ? 0 : hits * 100 / (hits + misses));
+  setCounter("stall_micros", statistics->getTickerCount(rocksdb::STALL_MICROS));
+  setCounter("bytes_read", statistics->getTickerCount(rocksdb::BYTES_READ));
+  setCounter(
+      "bytes_written", statistics->getTickerCount(rocksdb::BYTES_WRITTEN));
+}
+
 // In the future it would perhaps be nicer to move the triggerAutoGC()
 // logic up into the LocalStore base class.  However, for now it is more
 // convenient to be able to use RocksDbLocalStore's ioPool_ to schedule the
@@ -655,7 +1022,9 @@ RocksDbLocalStore::SizeSummary RocksDbLocalStore::computeStats(
 // code, but the gc operation can take a significant amount of time, and it
 // seems unfortunate to tie up one of the main pool threads for potentially
 // multiple minutes.
-void RocksDbLocalStore::triggerAutoGC(SizeSummary before) {
+void RocksDbLocalStore::triggerAutoGC(
+    SizeSummary before,
+    const EdenConfig& config) {
   {
     auto state = autoGCState_.wlock();
     if (state->inProgress_) {
@@ -674,10 +1043,31 @@ void RocksDbLocalStore::triggerAutoGC(SizeSummary before) {
     state->inProgress_ = true;
   }
 
-  ioPool_.add([store = getSharedFromThis(), before] {
+  std::array<uint64_t, KeySpace::kTotalCount> limits{};
+  for (const auto& ks : KeySpace::kAll) {
+    if (auto* ephemeral = std::get_if<Ephemeral>(&ks->persistence)) {
+      limits[ks->index] = (config.*(ephemeral->cacheLimit)).getValue();
+    }
+  }
+  auto scanRate = config.localStoreAutoGcScanRate.getValue();
+
+  ioPool_.add([store = getSharedFromThis(), before, limits, scanRate] {
     try {
       for (auto& ks : KeySpace::kAll) {
-        if (before.excessiveKeySpaces.test(ks->index)) {
+        if (!before.excessiveKeySpaces.test(ks->index)) {
+          continue;
+        }
+        // Evict what hasn't been used lately and keep the hot set. If the
+        // hot set alone doesn't fit in the limit, fall back to clearing
+        // the key space so that disk usage stays bounded.
+        auto evicted = store->evictColdKeys(ks, scanRate);
+        store->compactKeySpace(ks);
+        auto size = store->getApproximateSize(ks);
+        XLOG(INFO) << "evicted " << evicted << " cold keys from " << ks->name
+                   << ", size is now " << size;
+        if (size > limits[ks->index]) {
+          XLOG(INFO) << "recently used data in " << ks->name
+                     << " exceeds its limit, clearing it";
           store->clearKeySpace(ks);
           store->compactKeySpace(ks);
         }
@@ -692,6 +1082,69 @@ void RocksDbLocalStore::triggerAutoGC(SizeSummary before) {
   });
 }
 
+uint64_t RocksDbLocalStore::evictColdKeys(
+    KeySpace keySpace,
+    uint64_t bytesPerSecond) {
+  XCHECK(keySpace->isEphemeral())
+      << "refusing to evict keys from persistent key space " << keySpace->name;
+
+  auto handles = getHandles();
+  auto* columnFamily = handles->columns[keySpace->index].get();
+
+  ReadOptions readOptions;
+  // Don't let the scan push the hot set out of the block cache.
+  readOptions.fill_cache = false;
+  auto it = std::unique_ptr<rocksdb::Iterator>(
+      handles->db->NewIterator(readOptions, columnFamily));
+
+  auto start = std::chrono::steady_clock::now();
+  uint64_t bytesScanned = 0;
+  uint64_t evicted = 0;
+  rocksdb::WriteBatch batch;
+
+  auto flushBatch = [&] {
+    if (batch.Count() == 0) {
+      return;
+    }
+    auto status = handles->db->Write(WriteOptions(), &batch);
+    if (!status.ok()) {
+      throw RocksException::build(
+          status, "error evicting keys from ", keySpace->name);
+    }
+    evicted += batch.Count();
+    batch.Clear();
+
+    if (bytesPerSecond > 0) {
+      auto target = std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::duration<double>(
+              static_cast<double>(bytesScanned) / bytesPerSecond));
+      auto elapsed = std::chrono::steady_clock::now() - start;
+      if (elapsed < target) {
+        /* sleep override */ std::this_thread::sleep_for(target - elapsed);
+      }
+    }
+  };
+
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    auto key = it->key();
+    bytesScanned += key.size() + it->value().size();
+    auto hash = folly::hash::SpookyHashV2::Hash64(key.data(), key.size(), 0);
+    if (recentAccesses_.lock()->estimate(hash) > 0) {
+      continue;
+    }
+    batch.Delete(columnFamily, key);
+    if (batch.Count() >= kEvictionBatchSize) {
+      flushBatch();
+    }
+  }
+  if (!it->status().ok()) {
+    throw RocksException::build(
+        it->status(), "error scanning ", keySpace->name, " for eviction");
+  }
+  flushBatch();
+  return evicted;
+}
+
 void RocksDbLocalStore::autoGCFinished(
     bool successful,
     uint64_t ephemeralSizeBefore) {
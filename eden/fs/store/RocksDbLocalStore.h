@@ -9,10 +9,14 @@
 
 #include <folly/CppAttributes.h>
 #include <folly/Synchronized.h>
+#include <folly/futures/Promise.h>
 #include <bitset>
+#include <mutex>
 
 #include "eden/fs/rocksdb/RocksHandles.h"
+#include "eden/fs/store/FrequencySketch.h"
 #include "eden/fs/store/LocalStore.h"
+#include "eden/fs/store/LocalStoreStats.h"
 #include "eden/fs/utils/UnboundedQueueExecutor.h"
 
 namespace facebook::eden {
@@ -25,19 +29,46 @@ class StructuredLogger;
  */
 class RocksDbLocalStore : public LocalStore {
  public:
+  /**
+   * The number of threads performing RocksDB reads when the caller doesn't
+   * specify one.
+   */
+  static constexpr size_t kDefaultIoThreadCount = 12;
+
+  /**
+   * The number of column families compacted concurrently by
+   * startCompaction(). RocksDB further splits each compaction into
+   * subcompactions on its own background threads.
+   */
+  static constexpr size_t kCompactionThreadCount = 4;
+
   /**
    * The given FaultInjector must be valid during the lifetime of this
    * RocksDbLocalStore object.
+   *
+   * Asynchronous reads are performed on a pool of ioThreadCount threads, so
+   * that callers such as FUSE and NFS workers never block on disk I/O.
    */
   explicit RocksDbLocalStore(
       AbsolutePathPiece pathToRocksDb,
       std::shared_ptr<StructuredLogger> structuredLogger,
       FaultInjector* FOLLY_NONNULL faultInjector,
-      RocksDBOpenMode mode = RocksDBOpenMode::ReadWrite);
+      RocksDBOpenMode mode = RocksDBOpenMode::ReadWrite,
+      size_t ioThreadCount = kDefaultIoThreadCount);
   ~RocksDbLocalStore();
   void close() override;
   void clearKeySpace(KeySpace keySpace) override;
   void compactKeySpace(KeySpace keySpace) override;
+
+  /**
+   * Compact the column families in parallel on a dedicated pool, returning
+   * immediately. Progress is also published as local_store.compaction.*
+   * counters.
+   *
+   * Cancelling the job interrupts every manual compaction running in this
+   * store, including the ones of other jobs, which then fail.
+   */
+  std::shared_ptr<CompactionJob> startCompaction(bool clearCaches) override;
   StoreResult get(KeySpace keySpace, folly::ByteRange key) const override;
   FOLLY_NODISCARD folly::Future<StoreResult> getFuture(
       KeySpace keySpace,
@@ -59,6 +90,16 @@ class RocksDbLocalStore : public LocalStore {
 
   void periodicManagementTask(const EdenConfig& config) override;
 
+  /**
+   * Delete the keys of an ephemeral key space that have not been read or
+   * written recently, keeping the hot set in place.
+   *
+   * The key space is scanned at no more than bytesPerSecond (0 means no
+   * limit), so that the garbage collection doesn't starve regular lookups
+   * of disk bandwidth. Returns the number of keys deleted.
+   */
+  uint64_t evictColdKeys(KeySpace keySpace, uint64_t bytesPerSecond);
+
  private:
   /**
    * Get a pointer to the RocksHandles object in order to perform an I/O
@@ -84,6 +125,39 @@ class RocksDbLocalStore : public LocalStore {
         shared_from_this());
   }
 
+  /**
+   * A getFuture() call waiting for the next MultiGet on the I/O pool.
+   */
+  struct PendingGet {
+    KeySpace keySpace;
+    std::string key;
+    folly::Promise<StoreResult> promise;
+    std::chrono::steady_clock::time_point enqueued;
+  };
+
+  struct PendingGets {
+    std::vector<PendingGet> gets;
+    /**
+     * Whether a drainPendingGets() call is queued on the I/O pool. Gets that
+     * arrive while it is queued are served by the same MultiGet.
+     */
+    bool drainScheduled{false};
+  };
+
+  /**
+   * Queue a single key lookup, scheduling a drain on the I/O pool if none is
+   * pending.
+   */
+  folly::SemiFuture<StoreResult> enqueueGet(
+      KeySpace keySpace,
+      std::string key) const;
+
+  /**
+   * Look up the queued keys with a single MultiGet and fulfill their
+   * promises. Runs on the I/O pool.
+   */
+  void drainPendingGets() const;
+
   struct AutoGCState {
     bool inProgress_{false};
     std::chrono::steady_clock::time_point startTime_;
@@ -111,15 +185,44 @@ class RocksDbLocalStore : public LocalStore {
    */
   SizeSummary computeStats(bool publish, const EdenConfig* config);
 
-  void triggerAutoGC(SizeSummary before);
+  /**
+   * Publish fb303 counters for RocksDB's internal state: block cache hits,
+   * write stalls and the compaction backlog.
+   */
+  void publishRocksDbStats() const;
+
+  /**
+   * Record that a key of an ephemeral key space was read or written.
+   */
+  void recordAccess(KeySpace keySpace, folly::ByteRange key) const;
+
+  /**
+   * Allow or interrupt and disallow manual compactions. Does nothing once
+   * the store is closed.
+   */
+  void setManualCompactionEnabled(bool enabled) const;
+
+  void triggerAutoGC(SizeSummary before, const EdenConfig& config);
   void autoGCFinished(bool successful, uint64_t ephemeralSizeBefore);
 
   std::shared_ptr<StructuredLogger> structuredLogger_;
   const std::string statsPrefix_{"local_store."};
+  mutable LocalStoreStats stats_{statsPrefix_};
   FaultInjector& faultInjector_;
+  // Declared before ioPool_ so that queued drains never outlive it.
+  mutable folly::Synchronized<PendingGets, std::mutex> pendingGets_;
   mutable UnboundedQueueExecutor ioPool_;
   folly::Synchronized<AutoGCState> autoGCState_;
+  /**
+   * Approximate access counts of ephemeral keys. Counts are halved after
+   * every few million accesses, so a key that goes untouched for a
+   * generation decays to zero and becomes eligible for eviction.
+   */
+  mutable folly::Synchronized<FrequencySketch, std::mutex> recentAccesses_;
   folly::Synchronized<RocksHandles> dbHandles_;
+  // Declared last so that its threads are joined before anything they use
+  // is destroyed.
+  UnboundedQueueExecutor compactionPool_;
 };
 
 } // namespace facebook::eden
@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/SharedFetchContext.h"
+
+namespace facebook::eden {
+
+SharedFetchContext::SharedFetchContext(ObjectFetchContext& leader)
+    : leader_{leader} {
+  addWaiter(leader);
+}
+
+void SharedFetchContext::addWaiter(const ObjectFetchContext& waiter) {
+  auto token = waiter.getCancellationToken();
+  interested_.fetch_add(1, std::memory_order_acq_rel);
+  if (!token.canBeCancelled()) {
+    // Nothing will ever release this interest.
+    return;
+  }
+
+  // Runs inline if the waiter already gave up, so the lock can't be held.
+  auto callback = std::make_unique<folly::CancellationCallback>(
+      std::move(token), [this] { release(); });
+  callbacks_.wlock()->push_back(std::move(callback));
+}
+
+void SharedFetchContext::release() {
+  if (interested_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    cancellationSource_.requestCancellation();
+  }
+}
+
+} // namespace facebook::eden
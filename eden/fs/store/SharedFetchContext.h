@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/CancellationToken.h>
+#include <folly/Synchronized.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "eden/fs/store/ObjectFetchContext.h"
+
+namespace facebook::eden {
+
+/**
+ * The fetch context of work shared by several callers, such as a coalesced
+ * blob metadata lookup or an inode load.
+ *
+ * Everything but cancellation is forwarded to the context of the caller that
+ * started the work, which waits on it like the others and thus outlives it.
+ * The cancellation token is only cancelled once every waiter's token is: a
+ * caller that gives up must not fail the callers that still want the result.
+ * A waiter whose token can't be cancelled keeps the work alive for good.
+ */
+class SharedFetchContext : public ObjectFetchContext {
+ public:
+  /**
+   * The leader is the first waiter.
+   */
+  explicit SharedFetchContext(ObjectFetchContext& leader);
+
+  /**
+   * Register interest of another caller in the result of the work.
+   */
+  void addWaiter(const ObjectFetchContext& waiter);
+
+  /**
+   * Whether all the waiters gave up. Callers that still want the result and
+   * get folly::OperationCancelled should start the work over.
+   */
+  bool isCancelled() const {
+    return cancellationSource_.isCancellationRequested();
+  }
+
+  void didFetch(ObjectType type, const ObjectId& id, Origin origin) override {
+    leader_.didFetch(type, id, origin);
+  }
+
+  void didFetchBytes(ObjectType type, Origin origin, uint64_t bytes) override {
+    leader_.didFetchBytes(type, origin, bytes);
+  }
+
+  std::optional<pid_t> getClientPid() const override {
+    return leader_.getClientPid();
+  }
+
+  Cause getCause() const override {
+    return leader_.getCause();
+  }
+
+  std::optional<folly::StringPiece> getCauseDetail() const override {
+    return leader_.getCauseDetail();
+  }
+
+  ImportPriority getPriority() const override {
+    return leader_.getPriority();
+  }
+
+  const std::unordered_map<std::string, std::string>* getRequestInfo()
+      const override {
+    return leader_.getRequestInfo();
+  }
+
+  folly::CancellationToken getCancellationToken() const override {
+    return cancellationSource_.getToken();
+  }
+
+  void deprioritize(uint64_t delta) override {
+    leader_.deprioritize(delta);
+  }
+
+ private:
+  void release();
+
+  ObjectFetchContext& leader_;
+  folly::CancellationSource cancellationSource_;
+
+  /**
+   * The number of waiters that haven't given up yet.
+   */
+  std::atomic<size_t> interested_{0};
+
+  /**
+   * Declared last so that the callbacks, which use the members above, are
+   * unregistered first.
+   */
+  folly::Synchronized<std::vector<std::unique_ptr<folly::CancellationCallback>>>
+      callbacks_;
+};
+
+} // namespace facebook::eden
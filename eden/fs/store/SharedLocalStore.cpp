@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/SharedLocalStore.h"
+
+#include <folly/Conv.h>
+#include <folly/Exception.h>
+#include <folly/futures/Future.h>
+#include <folly/portability/SysStat.h>
+#include <folly/portability/Unistd.h>
+
+#include "eden/fs/store/StoreResult.h"
+
+using folly::ByteRange;
+
+namespace facebook::eden {
+
+namespace {
+
+/**
+ * Sends each write to the batch of the store that holds its key space.
+ */
+class SharedWriteBatch : public LocalStore::WriteBatch {
+ public:
+  SharedWriteBatch(
+      std::unique_ptr<LocalStore::WriteBatch> privateBatch,
+      std::unique_ptr<LocalStore::WriteBatch> sharedBatch)
+      : privateBatch_{std::move(privateBatch)},
+        sharedBatch_{std::move(sharedBatch)} {}
+
+  void put(KeySpace keySpace, ByteRange key, ByteRange value) override {
+    batchFor(keySpace).put(keySpace, key, value);
+  }
+
+  void put(KeySpace keySpace, ByteRange key, std::vector<ByteRange> valueSlices)
+      override {
+    batchFor(keySpace).put(keySpace, key, std::move(valueSlices));
+  }
+
+  void flush() override {
+    privateBatch_->flush();
+    sharedBatch_->flush();
+  }
+
+ private:
+  LocalStore::WriteBatch& batchFor(KeySpace keySpace) {
+    return SharedLocalStore::isShared(keySpace) ? *sharedBatch_
+                                                : *privateBatch_;
+  }
+
+  std::unique_ptr<LocalStore::WriteBatch> privateBatch_;
+  std::unique_ptr<LocalStore::WriteBatch> sharedBatch_;
+};
+
+} // namespace
+
+SharedLocalStore::SharedLocalStore(
+    std::shared_ptr<LocalStore> privateStore,
+    std::shared_ptr<LocalStore> sharedStore)
+    : privateStore_{std::move(privateStore)},
+      sharedStore_{std::move(sharedStore)} {
+  enableBlobCaching.store(
+      privateStore_->enableBlobCaching.load(std::memory_order_relaxed),
+      std::memory_order_relaxed);
+}
+
+SharedLocalStore::~SharedLocalStore() {
+  close();
+}
+
+void SharedLocalStore::close() {
+  privateStore_->close();
+  sharedStore_->close();
+}
+
+void SharedLocalStore::clearKeySpace(KeySpace keySpace) {
+  storeFor(keySpace).clearKeySpace(keySpace);
+}
+
+void SharedLocalStore::compactKeySpace(KeySpace keySpace) {
+  storeFor(keySpace).compactKeySpace(keySpace);
+}
+
+std::shared_ptr<CompactionJob> SharedLocalStore::startCompaction(
+    bool clearCaches) {
+  auto sharedJob = sharedStore_->startCompaction(clearCaches);
+  try {
+    sharedJob->wait();
+  } catch (const std::exception&) {
+    // The job is done and reports the error.
+    return sharedJob;
+  }
+  return privateStore_->startCompaction(clearCaches);
+}
+
+void SharedLocalStore::checkSharedDirectory(AbsolutePathPiece dir) {
+#ifndef _WIN32
+  struct stat st;
+  folly::checkUnixError(
+      ::stat(dir.stringPiece().str().c_str(), &st),
+      "unable to stat shared local store directory ",
+      dir);
+  if (st.st_uid != ::geteuid()) {
+    throw std::runtime_error(folly::to<std::string>(
+        "shared local store directory ",
+        dir,
+        " belongs to another user: only the daemons of one user can share a "
+        "local store"));
+  }
+  if (st.st_mode & (S_IWGRP | S_IWOTH)) {
+    throw std::runtime_error(folly::to<std::string>(
+        "shared local store directory ",
+        dir,
+        " can be written by other users: only the daemons of one user can "
+        "share a local store"));
+  }
+#else
+  // There is no owner to compare to: rely on the ACLs of the directory.
+  (void)dir;
+#endif
+}
+
+StoreResult SharedLocalStore::get(KeySpace keySpace, ByteRange key) const {
+  return storeFor(keySpace).get(keySpace, key);
+}
+
+folly::Future<StoreResult> SharedLocalStore::getFuture(
+    KeySpace keySpace,
+    ByteRange key) const {
+  return storeFor(keySpace).getFuture(keySpace, key);
+}
+
+folly::Future<std::vector<StoreResult>> SharedLocalStore::getBatch(
+    KeySpace keySpace,
+    const std::vector<ByteRange>& keys) const {
+  return storeFor(keySpace).getBatch(keySpace, keys);
+}
+
+bool SharedLocalStore::hasKey(KeySpace keySpace, ByteRange key) const {
+  return storeFor(keySpace).hasKey(keySpace, key);
+}
+
+void SharedLocalStore::put(KeySpace keySpace, ByteRange key, ByteRange value) {
+  storeFor(keySpace).put(keySpace, key, value);
+}
+
+std::unique_ptr<LocalStore::WriteBatch> SharedLocalStore::beginWrite(
+    size_t bufSize) {
+  return std::make_unique<SharedWriteBatch>(
+      privateStore_->beginWrite(bufSize), sharedStore_->beginWrite(bufSize));
+}
+
+void SharedLocalStore::periodicManagementTask(const EdenConfig& config) {
+  privateStore_->periodicManagementTask(config);
+  sharedStore_->periodicManagementTask(config);
+  enableBlobCaching.store(
+      privateStore_->enableBlobCaching.load(std::memory_order_relaxed),
+      std::memory_order_relaxed);
+}
+
+} // namespace facebook::eden
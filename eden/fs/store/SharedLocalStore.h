@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "eden/fs/store/LocalStore.h"
+
+namespace facebook::eden {
+
+/**
+ * A LocalStore that keeps the ephemeral key spaces in a store shared with
+ * other EdenFS daemons on the host, and everything else in the daemon's
+ * private store.
+ *
+ * Every mount of a daemon already shares the daemon's LocalStore, but a
+ * developer with several EdenFS instances keeps a copy of the same trees and
+ * blobs in each. Ephemeral key spaces are keyed by object ID and only hold
+ * data that can be refetched, so they can be shared. Persistent key spaces,
+ * like proxy hashes, stay private, so another daemon clearing the shared
+ * caches can never lose data this one can't recreate.
+ *
+ * Objects read from the shared store are trusted like those of the private
+ * store: object IDs aren't content hashes for every backing store, so they
+ * can't be checked. The store is thus only shared between the daemons of a
+ * single user, see checkSharedDirectory().
+ *
+ * The shared store must support being opened by several processes at
+ * once, which SqliteLocalStore does. Clearing or compacting an ephemeral
+ * key space affects every daemon using the shared store.
+ */
+class SharedLocalStore : public LocalStore {
+ public:
+  SharedLocalStore(
+      std::shared_ptr<LocalStore> privateStore,
+      std::shared_ptr<LocalStore> sharedStore);
+  ~SharedLocalStore() override;
+
+  void close() override;
+  void clearKeySpace(KeySpace keySpace) override;
+  void compactKeySpace(KeySpace keySpace) override;
+
+  /**
+   * Compact the shared store, then start compacting the private one, which
+   * the returned job tracks.
+   */
+  std::shared_ptr<CompactionJob> startCompaction(bool clearCaches) override;
+  StoreResult get(KeySpace keySpace, folly::ByteRange key) const override;
+  FOLLY_NODISCARD folly::Future<StoreResult> getFuture(
+      KeySpace keySpace,
+      folly::ByteRange key) const override;
+  FOLLY_NODISCARD folly::Future<std::vector<StoreResult>> getBatch(
+      KeySpace keySpace,
+      const std::vector<folly::ByteRange>& keys) const override;
+  bool hasKey(KeySpace keySpace, folly::ByteRange key) const override;
+  void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value)
+      override;
+  std::unique_ptr<WriteBatch> beginWrite(size_t bufSize = 0) override;
+  void periodicManagementTask(const EdenConfig& config) override;
+
+  /**
+   * Whether keySpace is stored in the shared store.
+   */
+  static bool isShared(KeySpace keySpace) {
+    return keySpace->isEphemeral();
+  }
+
+  /**
+   * Throws unless dir, which holds the shared store, belongs to the current
+   * user and nobody else can write to it.
+   */
+  static void checkSharedDirectory(AbsolutePathPiece dir);
+
+ private:
+  LocalStore& storeFor(KeySpace keySpace) const {
+    return isShared(keySpace) ? *sharedStore_ : *privateStore_;
+  }
+
+  std::shared_ptr<LocalStore> privateStore_;
+  std::shared_ptr<LocalStore> sharedStore_;
+};
+
+} // namespace facebook::eden
@@ -10,7 +10,11 @@
 #include <folly/String.h>
 #include <folly/container/Array.h>
 #include <folly/logging/xlog.h>
+#include <algorithm>
+#include <limits>
 
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/sqlite/PersistentSqliteStatement.h"
 #include "eden/fs/sqlite/SqliteStatement.h"
 #include "eden/fs/store/StoreResult.h"
 
@@ -20,6 +24,42 @@ using folly::ByteRange;
 using folly::StringPiece;
 using std::string;
 
+struct SqliteLocalStore::StatementCache {
+  struct KeySpaceStatements {
+    KeySpaceStatements(SqliteDatabase::Connection& db, KeySpace keySpace)
+        : get{db, "select value from ", keySpace->name, " where key = ?"},
+          hasKey{db, "select 1 from ", keySpace->name, " where key = ?"},
+          // TODO: we need `or ignore` otherwise we hit primary key violations
+          // when running our integration tests.  This implies that we're
+          // over-fetching and that we have a perf improvement opportunity.
+          put{db, "insert or ignore into ", keySpace->name, " VALUES(?, ?)"} {
+    }
+
+    PersistentSqliteStatement get;
+    PersistentSqliteStatement hasKey;
+    PersistentSqliteStatement put;
+  };
+
+  explicit StatementCache(SqliteDatabase::Connection& db)
+      : beginTransaction{db, "BEGIN"},
+        commitTransaction{db, "COMMIT"},
+        rollbackTransaction{db, "ROLLBACK"} {
+    keySpaces.reserve(KeySpace::kTotalCount);
+    for (const auto& ks : KeySpace::kAll) {
+      keySpaces.emplace_back(db, ks);
+    }
+  }
+
+  KeySpaceStatements& operator[](KeySpace keySpace) {
+    return keySpaces[keySpace->index];
+  }
+
+  PersistentSqliteStatement beginTransaction;
+  PersistentSqliteStatement commitTransaction;
+  PersistentSqliteStatement rollbackTransaction;
+  std::vector<KeySpaceStatements> keySpaces;
+};
+
 namespace {
 
 /**
@@ -31,17 +71,21 @@ namespace {
  * The latter might be interesting to explore if the cost of opening the
  * connection is cheap enough.
  * For now though, we batch up the incoming data and then send it to the
- * database in the flush method.
+ * database in the flush method, or as soon as more than bufSize bytes have
+ * been buffered.
  */
 class SqliteWriteBatch : public LocalStore::WriteBatch {
  public:
-  explicit SqliteWriteBatch(SqliteDatabase& db) : db_(db) {
+  SqliteWriteBatch(SqliteLocalStore& store, size_t bufSize)
+      : store_(store), bufSize_(bufSize) {
     buffer_.resize(KeySpace::kTotalCount);
   }
 
   void put(KeySpace keySpace, ByteRange key, ByteRange value) override {
     buffer_[keySpace->index].emplace_back(
         StringPiece(key).str(), StringPiece(value).str());
+    bufferedBytes_ += key.size() + value.size();
+    flushIfNeeded();
   }
 
   void put(KeySpace keySpace, ByteRange key, std::vector<ByteRange> valueSlices)
@@ -54,48 +98,27 @@ class SqliteWriteBatch : public LocalStore::WriteBatch {
   }
 
   void flush() override {
-    auto db = db_.lock();
-
-    // Start a transaction for the flush operation
-    SqliteStatement(db, "BEGIN").step();
-
-    try {
-      for (size_t i = 0; i < buffer_.size(); ++i) {
-        auto& items = buffer_[i];
-        if (items.empty()) {
-          continue;
-        }
-
-        // See commentary in SqliteLocalStore::put re: `or ignore`
-        SqliteStatement stmt(
-            db,
-            "insert or ignore into ",
-            KeySpace::kAll[i]->name,
-            " VALUES(?, ?)");
-
-        for (const auto& item : items) {
-          const auto& key = item.first;
-          const auto& value = item.second;
-
-          stmt.bind(1, key);
-          stmt.bind(2, value);
-          stmt.step();
-        }
-        items.clear();
-      }
-
-      SqliteStatement(db, "COMMIT").step();
-    } catch (const std::exception&) {
-      // Speculative rollback to make sure that we're not still in a
-      // transaction if we bail out in the error path
-      SqliteStatement(db, "ROLLBACK").step();
-      throw;
+    if (bufferedBytes_ == 0) {
+      return;
     }
+    store_.putBatch(buffer_);
+    for (auto& items : buffer_) {
+      items.clear();
+    }
+    bufferedBytes_ = 0;
   }
 
  private:
-  std::vector<std::vector<std::pair<string, string>>> buffer_;
-  SqliteDatabase& db_;
+  void flushIfNeeded() {
+    if (bufSize_ > 0 && bufferedBytes_ >= bufSize_) {
+      flush();
+    }
+  }
+
+  std::vector<std::vector<SqliteLocalStore::Item>> buffer_;
+  SqliteLocalStore& store_;
+  size_t bufSize_;
+  size_t bufferedBytes_{0};
 };
 
 } // namespace
@@ -105,9 +128,18 @@ SqliteLocalStore::SqliteLocalStore(AbsolutePathPiece pathToDb)
   {
     auto db = db_.lock();
 
+    // The database may be shared with other processes, see
+    // SharedLocalStore. Wait for their transactions rather than failing
+    // with SQLITE_BUSY.
+    SqliteStatement(db, "PRAGMA busy_timeout=10000").step();
+
     // Write ahead log for faster perf
     // https://www.sqlite.org/wal.html
     SqliteStatement(db, "PRAGMA journal_mode=WAL").step();
+    // In WAL mode, NORMAL only syncs at checkpoints. A power loss may roll
+    // back the last few commits, which is fine for a cache that can be
+    // refetched, and saves an fsync per write.
+    SqliteStatement(db, "PRAGMA synchronous=NORMAL").step();
 
     for (const auto& ks : KeySpace::kAll) {
       SqliteStatement(
@@ -121,15 +153,35 @@ SqliteLocalStore::SqliteLocalStore(AbsolutePathPiece pathToDb)
           ")")
           .step();
     }
+
+    cache_ = std::make_unique<StatementCache>(db);
   }
 
   clearDeprecatedKeySpaces();
 }
 
+SqliteLocalStore::~SqliteLocalStore() {
+  close();
+}
+
 void SqliteLocalStore::close() {
+  {
+    auto db = db_.lock();
+    // The cached statements must be finalized before the database can be
+    // closed.
+    cache_.reset();
+  }
   db_.close();
 }
 
+SqliteLocalStore::StatementCache& SqliteLocalStore::getStatements(
+    SqliteDatabase::Connection& /* db */) const {
+  if (!cache_) {
+    throw std::logic_error("SqliteLocalStore used after being closed");
+  }
+  return *cache_;
+}
+
 void SqliteLocalStore::clearKeySpace(KeySpace keySpace) {
   auto db = db_.lock();
 
@@ -139,11 +191,65 @@ void SqliteLocalStore::clearKeySpace(KeySpace keySpace) {
 
 void SqliteLocalStore::compactKeySpace(KeySpace) {}
 
-StoreResult SqliteLocalStore::get(KeySpace keySpace, ByteRange key) const {
+uint64_t SqliteLocalStore::getUsedSize() const {
+  auto db = db_.lock();
+
+  auto pragma = [&](StringPiece name) {
+    SqliteStatement stmt(db, "PRAGMA ", name);
+    stmt.step();
+    return stmt.columnUint64(0);
+  };
+  return (pragma("page_count") - pragma("freelist_count")) *
+      pragma("page_size");
+}
+
+uint64_t SqliteLocalStore::getKeySpaceSize(KeySpace keySpace) const {
   auto db = db_.lock();
 
   SqliteStatement stmt(
-      db, "select value from ", keySpace->name, " where key = ?");
+      db,
+      "select coalesce(sum(length(key) + length(value)), 0) from ",
+      keySpace->name);
+  stmt.step();
+  return stmt.columnUint64(0);
+}
+
+void SqliteLocalStore::periodicManagementTask(const EdenConfig& config) {
+  // Measuring a key space reads all of its rows. Skip that when the whole
+  // database is too small for any key space to exceed its limit.
+  auto smallestLimit = std::numeric_limits<uint64_t>::max();
+  for (const auto& ks : KeySpace::kAll) {
+    if (auto* ephemeral = std::get_if<Ephemeral>(&ks->persistence)) {
+      smallestLimit =
+          std::min(smallestLimit, (config.*(ephemeral->cacheLimit)).getValue());
+    }
+  }
+  if (getUsedSize() <= smallestLimit) {
+    return;
+  }
+
+  // Like RocksDbLocalStore does when the recently used data doesn't fit,
+  // clear the key spaces that are too large. SQLite reuses the freed pages,
+  // so the file stops growing.
+  for (const auto& ks : KeySpace::kAll) {
+    auto* ephemeral = std::get_if<Ephemeral>(&ks->persistence);
+    if (!ephemeral) {
+      continue;
+    }
+    auto limit = (config.*(ephemeral->cacheLimit)).getValue();
+    auto size = getKeySpaceSize(ks);
+    if (size > limit) {
+      XLOG(INFO) << "clearing " << ks->name << " from the SQLite local store: "
+                 << "its size " << size << " exceeds its limit " << limit;
+      clearKeySpace(ks);
+    }
+  }
+}
+
+StoreResult SqliteLocalStore::get(KeySpace keySpace, ByteRange key) const {
+  auto db = db_.lock();
+
+  auto& stmt = getStatements(db)[keySpace].get.get(db);
 
   // Bind the key; parameters are 1-based
   stmt.bind(1, key);
@@ -160,7 +266,7 @@ StoreResult SqliteLocalStore::get(KeySpace keySpace, ByteRange key) const {
 bool SqliteLocalStore::hasKey(KeySpace keySpace, ByteRange key) const {
   auto db = db_.lock();
 
-  SqliteStatement stmt(db, "select 1 from ", keySpace->name, " where key = ?");
+  auto& stmt = getStatements(db)[keySpace].hasKey.get(db);
 
   stmt.bind(1, key);
   return stmt.step();
@@ -169,22 +275,44 @@ bool SqliteLocalStore::hasKey(KeySpace keySpace, ByteRange key) const {
 void SqliteLocalStore::put(KeySpace keySpace, ByteRange key, ByteRange value) {
   auto db = db_.lock();
 
-  SqliteStatement stmt(
-      db,
-      // TODO: we need `or ignore` otherwise we hit primary key violations
-      // when running our integration tests.  This implies that we're
-      // over-fetching and that we have a perf improvement opportunity.
-      "insert or ignore into ",
-      keySpace->name,
-      " VALUES(?, ?)");
+  auto& stmt = getStatements(db)[keySpace].put.get(db);
 
   stmt.bind(1, key);
   stmt.bind(2, value);
   stmt.step();
 }
 
-std::unique_ptr<LocalStore::WriteBatch> SqliteLocalStore::beginWrite(size_t) {
-  return std::make_unique<SqliteWriteBatch>(db_);
+void SqliteLocalStore::putBatch(const std::vector<std::vector<Item>>& items) {
+  auto db = db_.lock();
+  auto& statements = getStatements(db);
+
+  // Start a transaction for the flush operation
+  statements.beginTransaction.get(db).step();
+
+  try {
+    for (size_t i = 0; i < items.size(); ++i) {
+      auto& putStatement = statements[KeySpace::kAll[i]].put;
+      for (const auto& item : items[i]) {
+        // See commentary in StatementCache re: `or ignore`
+        auto& stmt = putStatement.get(db);
+        stmt.bind(1, item.first);
+        stmt.bind(2, item.second);
+        stmt.step();
+      }
+    }
+
+    statements.commitTransaction.get(db).step();
+  } catch (const std::exception&) {
+    // Speculative rollback to make sure that we're not still in a
+    // transaction if we bail out in the error path
+    statements.rollbackTransaction.get(db).step();
+    throw;
+  }
+}
+
+std::unique_ptr<LocalStore::WriteBatch> SqliteLocalStore::beginWrite(
+    size_t bufSize) {
+  return std::make_unique<SqliteWriteBatch>(*this, bufSize);
 }
 
 } // namespace facebook::eden
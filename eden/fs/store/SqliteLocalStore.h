@@ -7,6 +7,10 @@
 
 #pragma once
 #include <folly/Synchronized.h>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 #include "eden/fs/sqlite/SqliteDatabase.h"
 #include "eden/fs/store/LocalStore.h"
 
@@ -19,6 +23,7 @@ namespace facebook::eden {
 class SqliteLocalStore : public LocalStore {
  public:
   explicit SqliteLocalStore(AbsolutePathPiece pathToDb);
+  ~SqliteLocalStore() override;
   void close() override;
   void clearKeySpace(KeySpace keySpace) override;
   void compactKeySpace(KeySpace keySpace) override;
@@ -29,8 +34,45 @@ class SqliteLocalStore : public LocalStore {
   std::unique_ptr<LocalStore::WriteBatch> beginWrite(
       size_t bufSize = 0) override;
 
+  /**
+   * Clear the ephemeral key spaces that grew beyond their configured limit.
+   */
+  void periodicManagementTask(const EdenConfig& config) override;
+
+  using Item = std::pair<std::string, std::string>;
+
+  /**
+   * Insert the items, indexed by key space, in a single transaction.
+   */
+  void putBatch(const std::vector<std::vector<Item>>& items);
+
  private:
+  struct StatementCache;
+
+  /**
+   * Return the prepared statements of the open database. Must be called
+   * with the database lock held.
+   */
+  StatementCache& getStatements(SqliteDatabase::Connection& db) const;
+
+  /**
+   * The bytes used by the pages of the database that hold data, for all the
+   * key spaces together.
+   */
+  uint64_t getUsedSize() const;
+
+  /**
+   * The bytes of the keys and values of keySpace. Reads every row.
+   */
+  uint64_t getKeySpaceSize(KeySpace keySpace) const;
+
   mutable SqliteDatabase db_;
+  /**
+   * Per key space prepared statements, so that the hot get/hasKey/put paths
+   * don't have to re-parse their SQL on every call. Only accessed with the
+   * database lock held, and reset before the database is closed.
+   */
+  std::unique_ptr<StatementCache> cache_;
 };
 
 } // namespace facebook::eden
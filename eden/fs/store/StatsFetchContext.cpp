@@ -28,6 +28,9 @@ StatsFetchContext::StatsFetchContext(const StatsFetchContext& other) {
       counts_[y][x] = other.counts_[y][x].load();
     }
   }
+  for (size_t x = 0; x < ObjectFetchContext::kOriginEnumMax; ++x) {
+    bytes_[x] = other.bytes_[x].load();
+  }
 }
 
 void StatsFetchContext::didFetch(
@@ -41,6 +44,17 @@ void StatsFetchContext::didFetch(
   counts_[type][origin].fetch_add(1, std::memory_order_acq_rel);
 }
 
+void StatsFetchContext::didFetchBytes(
+    ObjectType type,
+    Origin origin,
+    uint64_t bytes) {
+  XCHECK(type < ObjectFetchContext::kObjectTypeEnumMax)
+      << "type is out of range: " << type;
+  XCHECK(origin < ObjectFetchContext::kOriginEnumMax)
+      << "origin is out of range: " << origin;
+  bytes_[origin].fetch_add(bytes, std::memory_order_acq_rel);
+}
+
 uint64_t StatsFetchContext::countFetchesOfType(ObjectType type) const {
   XCHECK(type < ObjectFetchContext::kObjectTypeEnumMax)
       << "type is out of range: " << type;
@@ -60,6 +74,10 @@ void StatsFetchContext::merge(const StatsFetchContext& other) {
       counts_[type][origin] += other.counts_[type][origin];
     }
   }
+  for (unsigned origin = 0; origin < ObjectFetchContext::kOriginEnumMax;
+       ++origin) {
+    bytes_[origin] += other.bytes_[origin];
+  }
 }
 
 uint64_t StatsFetchContext::countFetchesOfTypeAndOrigin(
@@ -72,6 +90,12 @@ uint64_t StatsFetchContext::countFetchesOfTypeAndOrigin(
   return counts_[type][origin].load(std::memory_order_acquire);
 }
 
+uint64_t StatsFetchContext::countBytesFromOrigin(Origin origin) const {
+  XCHECK(origin < ObjectFetchContext::kOriginEnumMax)
+      << "origin is out of range: " << origin;
+  return bytes_[origin].load(std::memory_order_acquire);
+}
+
 FetchStatistics StatsFetchContext::computeStatistics() const {
   auto computePercent = [&](uint64_t n, uint64_t d) -> unsigned short {
     XDCHECK_LE(n, d) << n << " > " << d;
@@ -94,6 +118,8 @@ FetchStatistics StatsFetchContext::computeStatistics() const {
   result.tree = computeAccessStats(ObjectFetchContext::Tree);
   result.blob = computeAccessStats(ObjectFetchContext::Blob);
   result.metadata = computeAccessStats(ObjectFetchContext::BlobMetadata);
+  result.backingStoreBytes =
+      countBytesFromOrigin(ObjectFetchContext::FromNetworkFetch);
   return result;
 }
 
@@ -37,6 +37,11 @@ struct FetchStatistics {
   Access tree;
   Access blob;
   Access metadata;
+
+  /**
+   * Bytes of blob contents fetched from the backing store.
+   */
+  uint64_t backingStoreBytes = 0;
 };
 
 class StatsFetchContext : public ObjectFetchContext {
@@ -50,6 +55,7 @@ class StatsFetchContext : public ObjectFetchContext {
   StatsFetchContext(const StatsFetchContext& other);
 
   void didFetch(ObjectType type, const ObjectId& id, Origin origin) override;
+  void didFetchBytes(ObjectType type, Origin origin, uint64_t bytes) override;
 
   std::optional<pid_t> getClientPid() const override;
 
@@ -59,6 +65,7 @@ class StatsFetchContext : public ObjectFetchContext {
 
   uint64_t countFetchesOfType(ObjectType type) const;
   uint64_t countFetchesOfTypeAndOrigin(ObjectType type, Origin origin) const;
+  uint64_t countBytesFromOrigin(Origin origin) const;
 
   FetchStatistics computeStatistics() const;
 
@@ -75,6 +82,7 @@ class StatsFetchContext : public ObjectFetchContext {
  private:
   std::atomic<uint64_t> counts_[ObjectFetchContext::kObjectTypeEnumMax]
                                [ObjectFetchContext::kOriginEnumMax] = {};
+  std::atomic<uint64_t> bytes_[ObjectFetchContext::kOriginEnumMax] = {};
   std::optional<pid_t> clientPid_ = std::nullopt;
   Cause cause_ = Cause::Unknown;
   folly::StringPiece causeDetail_;
@@ -39,6 +39,12 @@ IOBuf StoreResult::iobufWrapper() const {
 folly::IOBuf StoreResult::extractIOBuf() {
   ensureValid();
 
+  if (buf_) {
+    auto buf = std::move(*buf_);
+    buf_.reset();
+    return buf;
+  }
+
   // Unfortunately RocksDB returns data to us in a std::string.  This makes it
   // difficult for us to control the lifetime.  We end up having to allocate a
   // new std::string on the heap, just to control when it will free the
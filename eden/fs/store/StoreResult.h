@@ -8,13 +8,11 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <folly/io/IOBuf.h>
+#include <memory>
 #include <string>
 #include <utility>
 
-namespace folly {
-class IOBuf;
-}
-
 namespace facebook::eden {
 
 class KeySpace;
@@ -31,6 +29,10 @@ class KeySpace;
  * - It is move-only, so prevents us from ever unintentionally copying the
  *   string data.
  * - It provides APIs for creating IOBuf objects around the string result.
+ *
+ * Stores that can hand out their data without copying it, such as the
+ * memory-mapped PackLocalStore, construct a StoreResult from an IOBuf
+ * instead.
  */
 class StoreResult {
  public:
@@ -44,10 +46,18 @@ class StoreResult {
    */
   explicit StoreResult(std::string data) : StoreResult{true, std::move(data)} {}
 
+  /**
+   * Construct a StoreResult from payload data held in a single, unchained
+   * IOBuf. The buffer is handed out as is by extractIOBuf().
+   */
+  explicit StoreResult(std::unique_ptr<folly::IOBuf> buf)
+      : valid_{true}, buf_{std::move(buf)} {}
+
   StoreResult(StoreResult&& that) noexcept
       : valid_{false}, data_{"moved-from"} {
     std::swap(valid_, that.valid_);
     std::swap(data_, that.data_);
+    std::swap(buf_, that.buf_);
   }
 
   StoreResult& operator=(StoreResult&& that) noexcept {
@@ -55,6 +65,7 @@ class StoreResult {
     // Allocate the new std::string before performing the no-except swaps.
     valid_ = std::exchange(that.valid_, false);
     data_ = std::exchange(that.data_, std::move(data));
+    buf_ = std::move(that.buf_);
     return *this;
   }
 
@@ -69,10 +80,17 @@ class StoreResult {
   /**
    * Get a reference to the std::string result.
    *
+   * If the result is held in an IOBuf, this copies it into a string on the
+   * first call; prefer bytes() or piece().
+   *
    * Throws std::domain_error if the key was not present in the store.
    */
   const std::string& asString() const {
     ensureValid();
+    if (buf_) {
+      data_ = piece().str();
+      buf_.reset();
+    }
     return data_;
   }
 
@@ -83,6 +101,9 @@ class StoreResult {
    */
   folly::ByteRange bytes() const {
     ensureValid();
+    if (buf_) {
+      return folly::ByteRange{buf_->data(), buf_->length()};
+    }
     return folly::StringPiece{data_};
   }
 
@@ -92,8 +113,7 @@ class StoreResult {
    * Throws std::domain_error if the key was not present in the store.
    */
   folly::StringPiece piece() const {
-    ensureValid();
-    return folly::StringPiece{data_};
+    return folly::StringPiece{bytes()};
   }
 
   /**
@@ -111,6 +131,11 @@ class StoreResult {
   std::string extractValue() {
     ensureValid();
     valid_ = false;
+    if (buf_) {
+      auto value = folly::StringPiece{buf_->data(), buf_->length()}.str();
+      buf_.reset();
+      return value;
+    }
     return std::move(data_);
   }
 
@@ -122,7 +147,8 @@ class StoreResult {
    *
    * This does require a memory allocation to move the stored std::string onto
    * the heap (but it just does a small allocation for the string object
-   * itself, and not the string data).
+   * itself, and not the string data). A result constructed from an IOBuf
+   * returns that buffer without any allocation.
    */
   folly::IOBuf extractIOBuf();
 
@@ -152,7 +178,13 @@ class StoreResult {
    * looked up.
    */
   bool valid_{false};
-  std::string data_;
+  // asString() lazily moves an IOBuf-backed result into data_.
+  mutable std::string data_;
+  /**
+   * The payload, when the store handed it out as an IOBuf. data_ is unused
+   * in that case.
+   */
+  mutable std::unique_ptr<folly::IOBuf> buf_;
 };
 
 } // namespace facebook::eden
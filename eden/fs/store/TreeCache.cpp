@@ -7,12 +7,45 @@
 
 #include "eden/fs/store/TreeCache.h"
 
+#include <folly/compression/Compression.h>
+#include <folly/logging/xlog.h>
+
 #include "eden/fs/config/EdenConfig.h"
 
 namespace facebook::eden {
+
+namespace {
+// LZ4 is used rather than zstd as inflating on a cache hit is on the lookup
+// path, and the varint framing lets us uncompress without storing the size.
+constexpr auto kCompressedTierCodec = folly::io::CodecType::LZ4_VARINT_SIZE;
+
+// Bookkeeping overhead of one compressed entry: the map node, the eviction
+// queue node and the IOBuf.
+constexpr size_t kCompressedEntryOverhead =
+    sizeof(ObjectId) * 2 + sizeof(folly::IOBuf) + 64;
+
+size_t getCompressedTierMaxSize(const ReloadableConfig& config) {
+  auto size =
+      config.getEdenConfig()->inMemoryTreeCompressedCacheSize.getValue();
+  if (size > 0 && !folly::io::hasCodec(kCompressedTierCodec)) {
+    XLOG(WARN) << "LZ4 is not available, disabling the compressed tree cache";
+    return 0;
+  }
+  return size;
+}
+} // namespace
+
 std::shared_ptr<const Tree> TreeCache::get(const ObjectId& hash) {
   if (config_->getEdenConfig()->enableInMemoryTreeCaching.getValue()) {
-    return getSimple(hash);
+    if (auto tree = getSimple(hash)) {
+      return tree;
+    }
+    if (compressedTierMaxSize_ > 0) {
+      if (auto tree = getCompressed(hash)) {
+        insertSimple(tree);
+        return tree;
+      }
+    }
   }
   return std::shared_ptr<const Tree>{nullptr};
 }
@@ -23,10 +56,114 @@ void TreeCache::insert(std::shared_ptr<const Tree> tree) {
   }
 }
 
+TreeCache::CompressedTierStats TreeCache::getCompressedTierStats() const {
+  auto tier = compressedTier_.rlock();
+  CompressedTierStats stats;
+  stats.entryCount = tier->entries.size();
+  stats.totalSizeInBytes = tier->totalSize;
+  stats.hitCount = tier->hitCount;
+  stats.missCount = tier->missCount;
+  stats.evictionCount = tier->evictionCount;
+  return stats;
+}
+
+bool TreeCache::compressedTierContains(const ObjectId& hash) const {
+  return compressedTier_.rlock()->entries.count(hash) == 1;
+}
+
+size_t TreeCache::getCompressedEntrySize(const CompressedEntry& entry) {
+  return entry.data->computeChainDataLength() + kCompressedEntryOverhead;
+}
+
+void TreeCache::onEvicted(std::vector<std::shared_ptr<const Tree>> trees) {
+  auto codec = folly::io::getCodec(kCompressedTierCodec);
+
+  // Compress without holding the lock.
+  std::vector<std::pair<ObjectId, std::unique_ptr<folly::IOBuf>>> compressed;
+  compressed.reserve(trees.size());
+  for (auto& tree : trees) {
+    auto serialized = tree->serialize();
+    try {
+      compressed.emplace_back(tree->getHash(), codec->compress(&serialized));
+    } catch (const std::exception& ex) {
+      XLOG(WARN) << "failed to compress tree " << tree->getHash() << ": "
+                 << folly::exceptionStr(ex);
+    }
+  }
+  // Free the trees before taking the lock as well.
+  trees.clear();
+
+  auto tier = compressedTier_.wlock();
+  for (auto& [hash, data] : compressed) {
+    auto [iter, inserted] =
+        tier->entries.try_emplace(hash, CompressedEntry{std::move(data), {}});
+    if (!inserted) {
+      continue;
+    }
+    tier->evictionQueue.push_back(hash);
+    iter->second.index = std::prev(tier->evictionQueue.end());
+    tier->totalSize += getCompressedEntrySize(iter->second);
+  }
+
+  while (tier->totalSize > compressedTierMaxSize_ &&
+         !tier->evictionQueue.empty()) {
+    auto entryIter = tier->entries.find(tier->evictionQueue.front());
+    tier->totalSize -= getCompressedEntrySize(entryIter->second);
+    tier->entries.erase(entryIter);
+    tier->evictionQueue.pop_front();
+    ++tier->evictionCount;
+  }
+}
+
+std::shared_ptr<const Tree> TreeCache::getCompressed(const ObjectId& hash) {
+  std::unique_ptr<folly::IOBuf> data;
+  {
+    auto tier = compressedTier_.wlock();
+    auto iter = tier->entries.find(hash);
+    if (iter == tier->entries.end()) {
+      ++tier->missCount;
+      return nullptr;
+    }
+    ++tier->hitCount;
+    tier->totalSize -= getCompressedEntrySize(iter->second);
+    tier->evictionQueue.erase(iter->second.index);
+    data = std::move(iter->second.data);
+    tier->entries.erase(iter);
+  }
+
+  try {
+    auto uncompressed = folly::io::getCodec(kCompressedTierCodec)
+                            ->uncompress(data.get());
+    uncompressed->coalesce();
+    auto tree = Tree::tryDeserialize(
+        hash,
+        folly::StringPiece{
+            reinterpret_cast<const char*>(uncompressed->data()),
+            uncompressed->length()});
+    if (!tree) {
+      XLOG(WARN) << "failed to deserialize compressed tree " << hash;
+      return nullptr;
+    }
+    return std::make_shared<const Tree>(std::move(*tree));
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "failed to uncompress tree " << hash << ": "
+               << folly::exceptionStr(ex);
+    return nullptr;
+  }
+}
+
 TreeCache::TreeCache(std::shared_ptr<ReloadableConfig> config)
       : ObjectCache<Tree, ObjectCacheFlavor::Simple>{
             config->getEdenConfig()->inMemoryTreeCacheSize.getValue(),
-            config->getEdenConfig()->inMemoryTreeCacheMinElements.getValue()},
-        config_{config} {}
+            config->getEdenConfig()->inMemoryTreeCacheMinElements.getValue(),
+            config->getEdenConfig()->inMemoryTreeCacheNumShards.getValue()},
+        config_{config},
+        compressedTierMaxSize_{getCompressedTierMaxSize(*config)} {
+  if (compressedTierMaxSize_ > 0) {
+    setEvictionObserver([this](std::vector<std::shared_ptr<const Tree>> trees) {
+      onEvicted(std::move(trees));
+    });
+  }
+}
 
 } // namespace facebook::eden
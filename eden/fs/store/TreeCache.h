@@ -7,10 +7,20 @@
 
 #pragma once
 
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+#include <folly/Synchronized.h>
+
 #include "eden/fs/config/ReloadableConfig.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/store/ObjectCache.h"
 
+namespace folly::io {
+class Codec;
+}
+
 namespace facebook::eden {
 
 /**
@@ -29,6 +39,11 @@ namespace facebook::eden {
  * be cachable your minimum entry count must be atleast 1, otherwise insert may
  * not actually insert the tree into the cache.
  *
+ * Optionally, trees evicted from the cache are kept in a second, compressed
+ * tier sized by treecache:compressed-cache-size. A lookup that misses the
+ * primary tier but hits the compressed one inflates the tree and moves it
+ * back into the primary tier, avoiding a LocalStore round trip.
+ *
  * It is safe to use this object from arbitrary threads.
  */
 class TreeCache : public ObjectCache<Tree, ObjectCacheFlavor::Simple> {
@@ -55,12 +70,68 @@ class TreeCache : public ObjectCache<Tree, ObjectCacheFlavor::Simple> {
    */
   void insert(std::shared_ptr<const Tree> tree);
 
+  struct CompressedTierStats {
+    size_t entryCount{0};
+    size_t totalSizeInBytes{0};
+    uint64_t hitCount{0};
+    uint64_t missCount{0};
+    uint64_t evictionCount{0};
+  };
+
+  /**
+   * Return information about the compressed tier. All zeros when the
+   * compressed tier is disabled.
+   */
+  CompressedTierStats getCompressedTierStats() const;
+
+  /**
+   * Returns true if the compressed tier holds the tree for the given hash.
+   */
+  bool compressedTierContains(const ObjectId& hash) const;
+
  private:
+  struct CompressedEntry {
+    std::unique_ptr<folly::IOBuf> data;
+    std::list<ObjectId>::iterator index;
+  };
+
+  struct CompressedTier {
+    std::unordered_map<ObjectId, CompressedEntry> entries;
+    /// Entries are evicted from the front of the queue.
+    std::list<ObjectId> evictionQueue;
+    size_t totalSize{0};
+    uint64_t hitCount{0};
+    uint64_t missCount{0};
+    uint64_t evictionCount{0};
+  };
+
+  /**
+   * Compress trees that were evicted from the primary tier and store them in
+   * the compressed tier.
+   */
+  void onEvicted(std::vector<std::shared_ptr<const Tree>> trees);
+
+  /**
+   * Look a tree up in the compressed tier. On a hit, the entry is removed from
+   * that tier and the inflated tree is returned.
+   */
+  std::shared_ptr<const Tree> getCompressed(const ObjectId& hash);
+
+  static size_t getCompressedEntrySize(const CompressedEntry& entry);
+
   /**
    * Reference to the eden config, may be a null pointer in unit tests.
    */
   std::shared_ptr<ReloadableConfig> config_;
 
+  /**
+   * Maximum number of bytes of compressed trees to keep. Zero disables the
+   * compressed tier.
+   */
+  const size_t compressedTierMaxSize_;
+
+  folly::Synchronized<CompressedTier> compressedTier_;
+
   explicit TreeCache(std::shared_ptr<ReloadableConfig> config);
 };
 
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/TreeDiffCache.h"
+
+#include <folly/Range.h>
+
+namespace facebook::eden {
+
+namespace {
+
+/**
+ * Build the key of a pair of ids. The kind keeps the keys of commit pairs and
+ * tree pairs apart, and the length of the first id keeps a pair from being
+ * read as another one.
+ */
+ObjectId makeKey(
+    char kind,
+    folly::ByteRange from,
+    folly::ByteRange to,
+    CaseSensitivity caseSensitive) {
+  auto fromSize = static_cast<uint32_t>(from.size());
+  ObjectId::Storage key;
+  key.reserve(2 + sizeof(fromSize) + from.size() + to.size());
+  key.push_back(kind);
+  key.push_back(caseSensitive == CaseSensitivity::Sensitive ? 's' : 'i');
+  key.append(reinterpret_cast<const char*>(&fromSize), sizeof(fromSize));
+  key.append(reinterpret_cast<const char*>(from.data()), from.size());
+  key.append(reinterpret_cast<const char*>(to.data()), to.size());
+  return ObjectId{std::move(key)};
+}
+
+folly::ByteRange bytesOf(const RootId& id) {
+  return folly::ByteRange{folly::StringPiece{id.value()}};
+}
+
+} // namespace
+
+TreeDiffCache::Entry::Entry(ObjectId key, ScmStatus status)
+    : hash{std::move(key)}, status{std::move(status)} {
+  sizeBytes = sizeof(Entry) + hash.size();
+  for (const auto& [path, fileStatus] : *this->status.entries_ref()) {
+    // The map node, and the path it holds.
+    sizeBytes += 64 + path.size();
+  }
+}
+
+TreeDiffCache::TreeDiffCache(size_t maximumSizeBytes)
+    : cache_{ObjectCache<Entry, ObjectCacheFlavor::Simple>::create(
+          maximumSizeBytes,
+          /*minimumEntryCount=*/0)} {}
+
+std::shared_ptr<const ScmStatus> TreeDiffCache::getRoots(
+    const RootId& from,
+    const RootId& to,
+    CaseSensitivity caseSensitive) {
+  return get(makeKey('r', bytesOf(from), bytesOf(to), caseSensitive));
+}
+
+void TreeDiffCache::insertRoots(
+    const RootId& from,
+    const RootId& to,
+    CaseSensitivity caseSensitive,
+    ScmStatus status) {
+  insert(
+      makeKey('r', bytesOf(from), bytesOf(to), caseSensitive),
+      std::move(status));
+}
+
+std::shared_ptr<const ScmStatus> TreeDiffCache::getTrees(
+    const ObjectId& from,
+    const ObjectId& to,
+    CaseSensitivity caseSensitive) {
+  return get(makeKey('t', from.getBytes(), to.getBytes(), caseSensitive));
+}
+
+void TreeDiffCache::insertTrees(
+    const ObjectId& from,
+    const ObjectId& to,
+    CaseSensitivity caseSensitive,
+    ScmStatus status) {
+  insert(
+      makeKey('t', from.getBytes(), to.getBytes(), caseSensitive),
+      std::move(status));
+}
+
+void TreeDiffCache::clear() {
+  cache_->clear();
+}
+
+std::shared_ptr<const ScmStatus> TreeDiffCache::get(const ObjectId& key) {
+  auto entry = cache_->getSimple(key);
+  if (!entry) {
+    return nullptr;
+  }
+  return std::shared_ptr<const ScmStatus>{entry, &entry->status};
+}
+
+void TreeDiffCache::insert(ObjectId key, ScmStatus status) {
+  cache_->insertSimple(
+      std::make_shared<const Entry>(std::move(key), std::move(status)));
+}
+
+} // namespace facebook::eden
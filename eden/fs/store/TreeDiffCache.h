@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/model/RootId.h"
+#include "eden/fs/service/gen-cpp2/eden_types.h"
+#include "eden/fs/store/ObjectCache.h"
+#include "eden/fs/utils/CaseSensitivity.h"
+
+namespace facebook::eden {
+
+/**
+ * An in-memory LRU cache of the differences between pairs of commits, and
+ * between pairs of source control trees, as computed by
+ * diffCommitsForStatus().
+ *
+ * Commits and trees are immutable, so entries never need to be invalidated.
+ * The differences of trees are keyed by the ids of the two trees, with paths
+ * relative to them, so that diffs of overlapping commit ranges share the
+ * subtrees that changed the same way in both.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class TreeDiffCache {
+ public:
+  explicit TreeDiffCache(size_t maximumSizeBytes);
+
+  /**
+   * Return the differences between the commits from and to if they are
+   * cached, or nullptr.
+   */
+  std::shared_ptr<const ScmStatus> getRoots(
+      const RootId& from,
+      const RootId& to,
+      CaseSensitivity caseSensitive);
+
+  void insertRoots(
+      const RootId& from,
+      const RootId& to,
+      CaseSensitivity caseSensitive,
+      ScmStatus status);
+
+  /**
+   * Return the differences between the trees from and to if they are cached,
+   * or nullptr. The paths of the differences are relative to the trees.
+   */
+  std::shared_ptr<const ScmStatus> getTrees(
+      const ObjectId& from,
+      const ObjectId& to,
+      CaseSensitivity caseSensitive);
+
+  void insertTrees(
+      const ObjectId& from,
+      const ObjectId& to,
+      CaseSensitivity caseSensitive,
+      ScmStatus status);
+
+  void clear();
+
+ private:
+  struct Entry {
+    Entry(ObjectId key, ScmStatus status);
+
+    const ObjectId& getHash() const {
+      return hash;
+    }
+
+    size_t getSizeBytes() const {
+      return sizeBytes;
+    }
+
+    ObjectId hash;
+    ScmStatus status;
+    /** An estimate of the memory used by status. */
+    size_t sizeBytes;
+  };
+
+  std::shared_ptr<const ScmStatus> get(const ObjectId& key);
+  void insert(ObjectId key, ScmStatus status);
+
+  std::shared_ptr<ObjectCache<Entry, ObjectCacheFlavor::Simple>> cache_;
+};
+
+} // namespace facebook::eden
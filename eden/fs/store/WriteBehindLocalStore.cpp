@@ -0,0 +1,327 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/WriteBehindLocalStore.h"
+
+#include <folly/futures/Future.h>
+#include <folly/logging/xlog.h>
+#include <folly/system/ThreadName.h>
+
+#include "eden/fs/store/StoreResult.h"
+
+using folly::ByteRange;
+using folly::StringPiece;
+
+namespace facebook::eden {
+
+namespace {
+
+/**
+ * Buffers values until flush, like the other stores' write batches, and
+ * then hands them to the WriteBehindLocalStore's buffer.
+ */
+class WriteBehindWriteBatch : public LocalStore::WriteBatch {
+ public:
+  WriteBehindWriteBatch(WriteBehindLocalStore& store, size_t bufSize)
+      : store_(store), bufSize_(bufSize) {}
+
+  void put(KeySpace keySpace, ByteRange key, ByteRange value) override {
+    bufferedBytes_ += key.size() + value.size();
+    items_.push_back(
+        Item{keySpace, StringPiece(key).str(), StringPiece(value).str()});
+    flushIfNeeded();
+  }
+
+  void put(KeySpace keySpace, ByteRange key, std::vector<ByteRange> valueSlices)
+      override {
+    std::string value;
+    for (auto& slice : valueSlices) {
+      value.append(reinterpret_cast<const char*>(slice.data()), slice.size());
+    }
+    bufferedBytes_ += key.size() + value.size();
+    items_.push_back(Item{keySpace, StringPiece(key).str(), std::move(value)});
+    flushIfNeeded();
+  }
+
+  void flush() override {
+    for (auto& item : items_) {
+      store_.enqueue(
+          item.keySpace, std::move(item.key), std::move(item.value));
+    }
+    items_.clear();
+    bufferedBytes_ = 0;
+  }
+
+ private:
+  struct Item {
+    KeySpace keySpace;
+    std::string key;
+    std::string value;
+  };
+
+  void flushIfNeeded() {
+    if (bufSize_ > 0 && bufferedBytes_ >= bufSize_) {
+      flush();
+    }
+  }
+
+  WriteBehindLocalStore& store_;
+  size_t bufSize_;
+  size_t bufferedBytes_{0};
+  std::vector<Item> items_;
+};
+
+} // namespace
+
+WriteBehindLocalStore::WriteBehindLocalStore(
+    std::shared_ptr<LocalStore> backend,
+    size_t capacityBytes,
+    size_t batchBytes)
+    : backend_{std::move(backend)},
+      capacityBytes_{capacityBytes},
+      batchBytes_{batchBytes} {
+  enableBlobCaching.store(
+      backend_->enableBlobCaching.load(std::memory_order_relaxed),
+      std::memory_order_relaxed);
+  {
+    auto state = state_.lock();
+    state->pending.resize(KeySpace::kTotalCount);
+    state->flushing.resize(KeySpace::kTotalCount);
+  }
+  thread_ = std::thread{[this] {
+    folly::setThreadName("LocalStoreWriter");
+    threadLoop();
+  }};
+}
+
+WriteBehindLocalStore::~WriteBehindLocalStore() {
+  close();
+}
+
+void WriteBehindLocalStore::close() {
+  {
+    auto state = state_.lock();
+    if (state->stop) {
+      return;
+    }
+    state->stop = true;
+  }
+  pendingCV_.notify_one();
+  // The thread commits everything still buffered before it exits.
+  thread_.join();
+  backend_->close();
+}
+
+void WriteBehindLocalStore::threadLoop() {
+  while (true) {
+    {
+      auto state = state_.lock();
+      pendingCV_.wait(state.as_lock(), [&] {
+        return state->stop || state->bufferedBytes > 0;
+      });
+      if (state->bufferedBytes == 0) {
+        // Stopping, and nothing is left to commit.
+        return;
+      }
+      std::swap(state->pending, state->flushing);
+      state->isFlushing = true;
+    }
+
+    // Only this thread touches flushing while isFlushing is set, other than
+    // readers holding the lock, so it can be read without the lock here.
+    auto& flushing = state_.unsafeGetUnlocked().flushing;
+    size_t committedBytes = 0;
+    try {
+      auto batch = backend_->beginWrite(batchBytes_);
+      for (const auto& ks : KeySpace::kAll) {
+        for (const auto& [key, value] : flushing[ks->index]) {
+          batch->put(ks, StringPiece{key}, StringPiece{value});
+        }
+      }
+      batch->flush();
+    } catch (const std::exception& ex) {
+      // Only ephemeral key spaces are buffered, so the values can be fetched
+      // again from the backing store.
+      XLOG(ERR) << "Error committing buffered writes to the local store: "
+                << ex.what();
+    }
+    for (const auto& items : flushing) {
+      for (const auto& [key, value] : items) {
+        committedBytes += key.size() + value.size();
+      }
+    }
+
+    {
+      auto state = state_.lock();
+      for (auto& items : state->flushing) {
+        items.clear();
+      }
+      state->bufferedBytes -= committedBytes;
+      state->isFlushing = false;
+    }
+    drainedCV_.notify_all();
+  }
+}
+
+void WriteBehindLocalStore::flush() {
+  auto state = state_.lock();
+  pendingCV_.notify_one();
+  drainedCV_.wait(state.as_lock(), [&] {
+    return state->bufferedBytes == 0 || state->stop;
+  });
+}
+
+size_t WriteBehindLocalStore::getBufferedBytes() const {
+  return state_.lock()->bufferedBytes;
+}
+
+void WriteBehindLocalStore::enqueue(
+    KeySpace keySpace,
+    std::string key,
+    std::string value) {
+  if (!keySpace->isEphemeral()) {
+    backend_->put(keySpace, StringPiece{key}, StringPiece{value});
+    return;
+  }
+
+  auto size = key.size() + value.size();
+  bool wake;
+  {
+    auto state = state_.lock();
+    if (state->stop) {
+      throw std::logic_error("WriteBehindLocalStore used after being closed");
+    }
+    // A value larger than the whole buffer is still accepted once the
+    // buffer is empty.
+    drainedCV_.wait(state.as_lock(), [&] {
+      return state->bufferedBytes == 0 ||
+          state->bufferedBytes + size <= capacityBytes_;
+    });
+
+    auto& items = state->pending[keySpace->index];
+    auto [it, inserted] = items.try_emplace(std::move(key), std::move(value));
+    if (inserted) {
+      state->bufferedBytes += size;
+    } else {
+      state->bufferedBytes -= it->second.size();
+      state->bufferedBytes += value.size();
+      it->second = std::move(value);
+    }
+    wake = !state->isFlushing;
+  }
+  if (wake) {
+    pendingCV_.notify_one();
+  }
+}
+
+std::optional<std::string> WriteBehindLocalStore::lookup(
+    KeySpace keySpace,
+    ByteRange key) const {
+  if (!keySpace->isEphemeral()) {
+    return std::nullopt;
+  }
+
+  auto state = state_.lock();
+  if (state->bufferedBytes == 0) {
+    return std::nullopt;
+  }
+  for (const auto* buffer : {&state->pending, &state->flushing}) {
+    const auto& items = (*buffer)[keySpace->index];
+    auto it = items.find(StringPiece{key});
+    if (it != items.end()) {
+      return it->second;
+    }
+  }
+  return std::nullopt;
+}
+
+void WriteBehindLocalStore::clearKeySpace(KeySpace keySpace) {
+  // Commit first, so buffered values don't reappear after the clear.
+  flush();
+  backend_->clearKeySpace(keySpace);
+}
+
+void WriteBehindLocalStore::compactKeySpace(KeySpace keySpace) {
+  backend_->compactKeySpace(keySpace);
+}
+
+std::shared_ptr<CompactionJob> WriteBehindLocalStore::startCompaction(
+    bool clearCaches) {
+  // Commit first, so the buffered values get compacted too.
+  flush();
+  return backend_->startCompaction(clearCaches);
+}
+
+StoreResult WriteBehindLocalStore::get(KeySpace keySpace, ByteRange key)
+    const {
+  // Buffered values are only removed once the backend has them, so checking
+  // the buffer before the backend never misses a value.
+  if (auto value = lookup(keySpace, key)) {
+    return StoreResult{std::move(*value)};
+  }
+  return backend_->get(keySpace, key);
+}
+
+folly::Future<StoreResult> WriteBehindLocalStore::getFuture(
+    KeySpace keySpace,
+    ByteRange key) const {
+  if (auto value = lookup(keySpace, key)) {
+    return StoreResult{std::move(*value)};
+  }
+  return backend_->getFuture(keySpace, key);
+}
+
+folly::Future<std::vector<StoreResult>> WriteBehindLocalStore::getBatch(
+    KeySpace keySpace,
+    const std::vector<ByteRange>& keys) const {
+  std::vector<std::optional<std::string>> buffered;
+  buffered.reserve(keys.size());
+  bool anyBuffered = false;
+  for (auto key : keys) {
+    buffered.push_back(lookup(keySpace, key));
+    anyBuffered |= buffered.back().has_value();
+  }
+  if (!anyBuffered) {
+    return backend_->getBatch(keySpace, keys);
+  }
+
+  return backend_->getBatch(keySpace, keys)
+      .thenValue([buffered = std::move(buffered)](
+                     std::vector<StoreResult>&& results) mutable {
+        for (size_t i = 0; i < results.size(); ++i) {
+          if (buffered[i]) {
+            results[i] = StoreResult{std::move(*buffered[i])};
+          }
+        }
+        return std::move(results);
+      });
+}
+
+bool WriteBehindLocalStore::hasKey(KeySpace keySpace, ByteRange key) const {
+  return lookup(keySpace, key).has_value() || backend_->hasKey(keySpace, key);
+}
+
+void WriteBehindLocalStore::put(
+    KeySpace keySpace,
+    ByteRange key,
+    ByteRange value) {
+  enqueue(keySpace, StringPiece(key).str(), StringPiece(value).str());
+}
+
+std::unique_ptr<LocalStore::WriteBatch> WriteBehindLocalStore::beginWrite(
+    size_t bufSize) {
+  return std::make_unique<WriteBehindWriteBatch>(*this, bufSize);
+}
+
+void WriteBehindLocalStore::periodicManagementTask(const EdenConfig& config) {
+  backend_->periodicManagementTask(config);
+  enableBlobCaching.store(
+      backend_->enableBlobCaching.load(std::memory_order_relaxed),
+      std::memory_order_relaxed);
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "eden/fs/store/LocalStore.h"
+
+namespace facebook::eden {
+
+/**
+ * A LocalStore that buffers writes in memory and commits them to another
+ * LocalStore from a background thread.
+ *
+ * Imports write every tree and blob they fetch into the LocalStore, which
+ * puts a disk write on the path of every cold fetch. With this store in
+ * front, put() only copies the value into a bounded in-memory buffer. A
+ * background thread drains the buffer into the backend in large
+ * WriteBatches. Reads of buffered keys are served from the buffer, so a
+ * value is visible as soon as put() returns.
+ *
+ * When the buffer holds capacityBytes, put() blocks until the background
+ * thread has committed the current batch, so a burst of imports can't grow
+ * memory usage without bound.
+ *
+ * Only ephemeral key spaces are buffered. Writes to persistent key spaces,
+ * like proxy hashes, can't be refetched if they were lost in a crash, so
+ * they go straight to the backend.
+ */
+class WriteBehindLocalStore : public LocalStore {
+ public:
+  /**
+   * The size a batch written to the backend may reach before it is
+   * flushed.
+   */
+  static constexpr size_t kDefaultBatchBytes = 4 * 1024 * 1024;
+
+  WriteBehindLocalStore(
+      std::shared_ptr<LocalStore> backend,
+      size_t capacityBytes,
+      size_t batchBytes = kDefaultBatchBytes);
+  ~WriteBehindLocalStore() override;
+
+  /**
+   * Commit all buffered writes, stop the background thread, and close the
+   * backend.
+   */
+  void close() override;
+  void clearKeySpace(KeySpace keySpace) override;
+  void compactKeySpace(KeySpace keySpace) override;
+  std::shared_ptr<CompactionJob> startCompaction(bool clearCaches) override;
+  StoreResult get(KeySpace keySpace, folly::ByteRange key) const override;
+  FOLLY_NODISCARD folly::Future<StoreResult> getFuture(
+      KeySpace keySpace,
+      folly::ByteRange key) const override;
+  FOLLY_NODISCARD folly::Future<std::vector<StoreResult>> getBatch(
+      KeySpace keySpace,
+      const std::vector<folly::ByteRange>& keys) const override;
+  bool hasKey(KeySpace keySpace, folly::ByteRange key) const override;
+  void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value)
+      override;
+  std::unique_ptr<LocalStore::WriteBatch> beginWrite(
+      size_t bufSize = 0) override;
+  void periodicManagementTask(const EdenConfig& config) override;
+
+  /**
+   * Block until every write buffered before this call has been committed
+   * to the backend.
+   */
+  void flush();
+
+  /**
+   * Return the number of bytes of keys and values not yet committed to the
+   * backend.
+   */
+  size_t getBufferedBytes() const;
+
+  /**
+   * Buffer the value if its key space is ephemeral, or write it straight
+   * to the backend otherwise. Used by the WriteBatch on flush.
+   */
+  void enqueue(KeySpace keySpace, std::string key, std::string value);
+
+ private:
+  using Buffer = std::vector<folly::F14FastMap<std::string, std::string>>;
+
+  struct State {
+    /**
+     * Writes not yet picked up by the background thread, by key space.
+     */
+    Buffer pending;
+    /**
+     * The writes the background thread is currently committing. They
+     * stay readable until the backend has them.
+     */
+    Buffer flushing;
+    /**
+     * The size of the keys and values in pending and flushing.
+     */
+    size_t bufferedBytes{0};
+    bool isFlushing{false};
+    bool stop{false};
+  };
+
+  /**
+   * Return the buffered value of the key, if any.
+   */
+  std::optional<std::string> lookup(KeySpace keySpace, folly::ByteRange key)
+      const;
+
+  void threadLoop();
+
+  std::shared_ptr<LocalStore> backend_;
+  const size_t capacityBytes_;
+  const size_t batchBytes_;
+
+  folly::Synchronized<State, std::mutex> state_;
+  /**
+   * Signaled when there are pending writes, or the thread should stop.
+   */
+  std::condition_variable pendingCV_;
+  /**
+   * Signaled when the background thread has committed a batch.
+   */
+  std::condition_variable drainedCV_;
+  std::thread thread_;
+};
+
+} // namespace facebook::eden
@@ -8,9 +8,14 @@
 #include "GitBackingStore.h"
 
 #include <folly/Conv.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
 #include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
+#include <gflags/gflags.h>
 #include <git2.h>
+#include <algorithm>
+#include <iterator>
 
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/model/Hash.h"
@@ -31,8 +36,17 @@ using std::make_unique;
 using std::string;
 using std::unique_ptr;
 
+DEFINE_int32(
+    num_git_import_threads,
+    8,
+    "the maximum number of git import threads per repo");
+
 namespace {
 
+// Blob batches are not split into smaller pieces than this, which would
+// cost more in scheduling than they gain in parallelism.
+constexpr size_t kMinBlobBatchSize = 16;
+
 template <typename... Args>
 void gitCheckError(int error, Args&&... args) {
   if (error) {
@@ -51,20 +65,46 @@ void freeBlobIOBufData(void* /*blobData*/, void* blobObject) {
 
 namespace facebook::eden {
 
-GitBackingStore::GitBackingStore(AbsolutePathPiece repository) {
+GitBackingStore::LibGit2::LibGit2() {
   // Make sure libgit2 is initialized.
   // (git_libgit2_init() is safe to call multiple times if multiple
   // GitBackingStore objects are created.  git_libgit2_shutdown() should be
   // called once for each call to git_libgit2_init().)
   git_libgit2_init();
+}
+
+GitBackingStore::LibGit2::~LibGit2() {
+  git_libgit2_shutdown();
+}
 
+GitBackingStore::ThreadRepository::~ThreadRepository() {
+  git_repository_free(repo);
+}
+
+GitBackingStore::GitBackingStore(AbsolutePathPiece repository)
+    : repository_{repository},
+      importThreadPool_{std::make_unique<folly::CPUThreadPoolExecutor>(
+          std::pair<size_t, size_t>(FLAGS_num_git_import_threads, 1),
+          std::make_shared<folly::NamedThreadFactory>("GitImport"))} {
   auto error = git_repository_open(&repo_, repository.value().str().c_str());
   gitCheckError(error, "error opening git repository", repository);
 }
 
 GitBackingStore::~GitBackingStore() {
+  // Join the import threads, which frees their repositories, before the
+  // main one.
+  importThreadPool_.reset();
   git_repository_free(repo_);
-  git_libgit2_shutdown();
+}
+
+git_repository* GitBackingStore::getThreadRepository() {
+  auto& threadRepository = *threadRepositories_;
+  if (!threadRepository.repo) {
+    auto error = git_repository_open(
+        &threadRepository.repo, repository_.value().str().c_str());
+    gitCheckError(error, "error opening git repository", repository_);
+  }
+  return threadRepository.repo;
 }
 
 const char* GitBackingStore::getPath() const {
@@ -92,13 +132,27 @@ std::string GitBackingStore::renderObjectId(const ObjectId& objectId) {
 SemiFuture<unique_ptr<Tree>> GitBackingStore::getRootTree(
     const RootId& rootId,
     ObjectFetchContext& /*context*/) {
-  // TODO: Use a separate thread pool to do the git I/O
+  return folly::via(
+             importThreadPool_.get(),
+             [this, rootId] { return getRootTreeImpl(rootId); })
+      .semi();
+}
+
+unique_ptr<Tree> GitBackingStore::getRootTreeImpl(const RootId& rootId) {
+  git_tree* tree = lookupRootTree(rootId);
+  SCOPE_EXIT {
+    git_tree_free(tree);
+  };
+  return getTreeImpl(oid2Hash(git_tree_id(tree)));
+}
+
+git_tree* GitBackingStore::lookupRootTree(const RootId& rootId) {
   XLOG(DBG4) << "resolving tree for commit " << rootId;
 
   // Look up the commit info
   git_oid commitOID = root2Oid(rootId);
   git_commit* commit = nullptr;
-  auto error = git_commit_lookup(&commit, repo_, &commitOID);
+  auto error = git_commit_lookup(&commit, getThreadRepository(), &commitOID);
   gitCheckError(
       error,
       "unable to find git commit ",
@@ -109,19 +163,95 @@ SemiFuture<unique_ptr<Tree>> GitBackingStore::getRootTree(
     git_commit_free(commit);
   };
 
-  // Get the tree ID for this commit.
-  ObjectId treeID = oid2Hash(git_commit_tree_id(commit));
+  git_tree* tree = nullptr;
+  error = git_commit_tree(&tree, commit);
+  gitCheckError(
+      error,
+      "unable to find the tree of git commit ",
+      rootId,
+      " in repository ",
+      getPath());
+  return tree;
+}
+
+SemiFuture<unique_ptr<ScmStatus>> GitBackingStore::diffRoots(
+    const RootId& root1,
+    const RootId& root2,
+    ObjectFetchContext& /*context*/) {
+  return folly::via(
+             importThreadPool_.get(),
+             [this, root1, root2] { return diffRootsImpl(root1, root2); })
+      .semi();
+}
+
+unique_ptr<ScmStatus> GitBackingStore::diffRootsImpl(
+    const RootId& root1,
+    const RootId& root2) {
+  auto status = make_unique<ScmStatus>();
+  if (root1 == root2) {
+    return status;
+  }
+
+  git_tree* tree1 = lookupRootTree(root1);
+  SCOPE_EXIT {
+    git_tree_free(tree1);
+  };
+  git_tree* tree2 = lookupRootTree(root2);
+  SCOPE_EXIT {
+    git_tree_free(tree2);
+  };
+
+  git_diff_options options;
+  git_diff_options_init(&options, GIT_DIFF_OPTIONS_VERSION);
+  // Status only needs the paths, so don't read blobs to detect binaries.
+  // Without GIT_DIFF_INCLUDE_TYPECHANGE, a file replaced by a directory is
+  // reported as removed, with the directory's files added, like the tree
+  // walk of diffCommitsForStatus() does.
+  options.flags |= GIT_DIFF_SKIP_BINARY_CHECK;
+
+  git_diff* diff = nullptr;
+  auto error = git_diff_tree_to_tree(
+      &diff, getThreadRepository(), tree1, tree2, &options);
+  gitCheckError(error, "unable to diff git commits ", root1, " and ", root2);
+  SCOPE_EXIT {
+    git_diff_free(diff);
+  };
 
-  // Now get the specified tree.
-  return getTreeImpl(treeID);
+  auto& entries = *status->entries_ref();
+  size_t numDeltas = git_diff_num_deltas(diff);
+  for (size_t i = 0; i < numDeltas; ++i) {
+    const git_diff_delta* delta = git_diff_get_delta(diff, i);
+    switch (delta->status) {
+      case GIT_DELTA_ADDED:
+        entries.emplace(delta->new_file.path, ScmFileStatus::ADDED);
+        break;
+      case GIT_DELTA_DELETED:
+        entries.emplace(delta->old_file.path, ScmFileStatus::REMOVED);
+        break;
+      case GIT_DELTA_MODIFIED:
+        entries.emplace(delta->new_file.path, ScmFileStatus::MODIFIED);
+        break;
+      default:
+        // Renames, copies and type changes are only reported when asked
+        // for, and tree diffs have no ignored or untracked files.
+        XLOG(DBG3) << "unexpected git diff delta " << enumValue(delta->status)
+                   << " for " << delta->new_file.path;
+        break;
+    }
+  }
+  return status;
 }
 
 SemiFuture<BackingStore::GetTreeRes> GitBackingStore::getTree(
     const ObjectId& id,
     ObjectFetchContext& /*context*/) {
-  // TODO: Use a separate thread pool to do the git I/O
-  return makeSemiFuture(BackingStore::GetTreeRes{
-      getTreeImpl(id), ObjectFetchContext::Origin::FromDiskCache});
+  return folly::via(
+             importThreadPool_.get(),
+             [this, id] {
+               return BackingStore::GetTreeRes{
+                   getTreeImpl(id), ObjectFetchContext::Origin::FromDiskCache};
+             })
+      .semi();
 }
 
 unique_ptr<Tree> GitBackingStore::getTreeImpl(const ObjectId& id) {
@@ -129,7 +259,7 @@ unique_ptr<Tree> GitBackingStore::getTreeImpl(const ObjectId& id) {
 
   git_oid treeOID = hash2Oid(id);
   git_tree* gitTree = nullptr;
-  auto error = git_tree_lookup(&gitTree, repo_, &treeOID);
+  auto error = git_tree_lookup(&gitTree, getThreadRepository(), &treeOID);
   gitCheckError(
       error, "unable to find git tree ", id, " in repository ", getPath());
   SCOPE_EXIT {
@@ -170,9 +300,69 @@ unique_ptr<Tree> GitBackingStore::getTreeImpl(const ObjectId& id) {
 SemiFuture<BackingStore::GetBlobRes> GitBackingStore::getBlob(
     const ObjectId& id,
     ObjectFetchContext& /*context*/) {
-  // TODO: Use a separate thread pool to do the git I/O
-  return makeSemiFuture(BackingStore::GetBlobRes{
-      getBlobImpl(id), ObjectFetchContext::Origin::FromDiskCache});
+  return folly::via(
+             importThreadPool_.get(),
+             [this, id] {
+               return BackingStore::GetBlobRes{
+                   getBlobImpl(id), ObjectFetchContext::Origin::FromDiskCache};
+             })
+      .semi();
+}
+
+SemiFuture<std::vector<folly::Try<unique_ptr<Blob>>>>
+GitBackingStore::getBlobBatch(std::vector<ObjectId> ids) {
+  using BatchResult = std::vector<folly::Try<unique_ptr<Blob>>>;
+
+  // One batch per import thread, so that each thread walks its part of the
+  // packs in order.
+  auto threads = static_cast<size_t>(std::max(FLAGS_num_git_import_threads, 1));
+  auto batchSize =
+      std::max(kMinBlobBatchSize, (ids.size() + threads - 1) / threads);
+  std::vector<SemiFuture<BatchResult>> batches;
+  for (size_t start = 0; start < ids.size(); start += batchSize) {
+    auto end = std::min(ids.size(), start + batchSize);
+    std::vector<ObjectId> batch(
+        std::make_move_iterator(ids.begin() + start),
+        std::make_move_iterator(ids.begin() + end));
+    batches.push_back(folly::via(
+                          importThreadPool_.get(),
+                          [this, batch = std::move(batch)] {
+                            BatchResult results;
+                            results.reserve(batch.size());
+                            for (const auto& id : batch) {
+                              results.push_back(folly::makeTryWith(
+                                  [&] { return getBlobImpl(id); }));
+                            }
+                            return results;
+                          })
+                          .semi());
+  }
+
+  return folly::collect(std::move(batches))
+      .deferValue([](std::vector<BatchResult> batchResults) {
+        BatchResult results;
+        for (auto& batchResult : batchResults) {
+          std::move(
+              batchResult.begin(),
+              batchResult.end(),
+              std::back_inserter(results));
+        }
+        return results;
+      });
+}
+
+SemiFuture<folly::Unit> GitBackingStore::prefetchBlobs(
+    ObjectIdRange ids,
+    ObjectFetchContext& /*context*/) {
+  return getBlobBatch(std::vector<ObjectId>(ids.begin(), ids.end()))
+      .deferValue([](std::vector<folly::Try<unique_ptr<Blob>>> results) {
+        for (const auto& result : results) {
+          if (result.hasException()) {
+            XLOG(DBG3) << "failed to prefetch git blob: "
+                       << result.exception().what();
+          }
+        }
+      });
 }
 
 unique_ptr<Blob> GitBackingStore::getBlobImpl(const ObjectId& id) {
@@ -180,7 +370,7 @@ unique_ptr<Blob> GitBackingStore::getBlobImpl(const ObjectId& id) {
 
   auto blobOID = hash2Oid(id);
   git_blob* blob = nullptr;
-  int error = git_blob_lookup(&blob, repo_, &blobOID);
+  int error = git_blob_lookup(&blob, getThreadRepository(), &blobOID);
   gitCheckError(
       error, "unable to find git blob ", id, " in repository ", getPath());
 
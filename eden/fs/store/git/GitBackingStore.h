@@ -8,6 +8,10 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <folly/ThreadLocal.h>
+#include <folly/Try.h>
+#include <memory>
+#include <vector>
 
 #include "eden/fs/store/BackingStore.h"
 #include "eden/fs/store/ObjectFetchContext.h"
@@ -15,11 +19,18 @@
 
 struct git_oid;
 struct git_repository;
+struct git_tree;
 
 namespace facebook::eden {
 
 /**
  * A BackingStore implementation that loads data out of a git repository.
+ *
+ * Objects are read on a pool of import threads. A libgit2 repository must
+ * not be used by several threads at once, so every import thread opens the
+ * repository for itself; lookups of different objects then proceed in
+ * parallel instead of queueing on one handle. libgit2 uses the repository's
+ * multi-pack-index and commit-graph files on its own when they exist.
  */
 class GitBackingStore final : public BackingStore {
  public:
@@ -62,19 +73,78 @@ class GitBackingStore final : public BackingStore {
       const ObjectId& id,
       ObjectFetchContext& context) override;
 
+  /**
+   * Diff the trees of the two commits with libgit2, which compares entry
+   * OIDs and never reads the subtrees that are the same on both sides.
+   */
+  folly::SemiFuture<std::unique_ptr<ScmStatus>> diffRoots(
+      const RootId& root1,
+      const RootId& root2,
+      ObjectFetchContext& context) override;
+
+  /**
+   * Read the blobs, spreading them over the import threads. Returns one
+   * result per id, in order.
+   */
+  folly::SemiFuture<std::vector<folly::Try<std::unique_ptr<Blob>>>>
+  getBlobBatch(std::vector<ObjectId> ids);
+
+  /**
+   * Read the blobs in batches, which brings their packs into the page cache
+   * so that the later getBlob() calls don't wait on the disk.
+   */
+  FOLLY_NODISCARD folly::SemiFuture<folly::Unit> prefetchBlobs(
+      ObjectIdRange ids,
+      ObjectFetchContext& context) override;
+
  private:
   GitBackingStore(GitBackingStore const&) = delete;
   GitBackingStore& operator=(GitBackingStore const&) = delete;
 
+  std::unique_ptr<Tree> getRootTreeImpl(const RootId& rootId);
+  std::unique_ptr<ScmStatus> diffRootsImpl(
+      const RootId& root1,
+      const RootId& root2);
+
+  /**
+   * Look up the root tree of a commit in the calling thread's repository.
+   * The caller must free it.
+   */
+  git_tree* lookupRootTree(const RootId& rootId);
   std::unique_ptr<Tree> getTreeImpl(const ObjectId& id);
   std::unique_ptr<Blob> getBlobImpl(const ObjectId& id);
 
+  /**
+   * The repository opened by the calling thread, opening it if needed.
+   */
+  git_repository* getThreadRepository();
+
   static git_oid root2Oid(const RootId& rootId);
 
   static git_oid hash2Oid(const ObjectId& hash);
   static ObjectId oid2Hash(const git_oid* oid);
 
+  /**
+   * Initializes libgit2 for as long as the store exists. Declared first so
+   * that the repositories are all freed before libgit2 is shut down.
+   */
+  struct LibGit2 {
+    LibGit2();
+    ~LibGit2();
+  };
+  LibGit2 libgit2_;
+
+  const AbsolutePath repository_;
   git_repository* repo_{nullptr};
+
+  struct ThreadRepository {
+    ~ThreadRepository();
+
+    git_repository* repo{nullptr};
+  };
+  folly::ThreadLocal<ThreadRepository> threadRepositories_;
+
+  std::unique_ptr<folly::Executor> importThreadPool_;
 };
 
 } // namespace facebook::eden
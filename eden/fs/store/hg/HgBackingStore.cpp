@@ -7,7 +7,11 @@
 
 #include "HgBackingStore.h"
 
+#include <algorithm>
+#include <iterator>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include <folly/Range.h>
 #include <folly/Synchronized.h>
@@ -68,7 +72,11 @@ DEFINE_int32(
     // See benchmarks in the doc linked from D5067763.
     // Note that this number would benefit from occasional revisiting.
     8,
-    "the number of hg import threads per repo");
+    "the maximum number of hg import threads per repo");
+DEFINE_int32(
+    min_hg_import_threads,
+    1,
+    "the number of hg import threads per repo that are kept when idle");
 DEFINE_bool(
     hg_fetch_missing_trees,
     true,
@@ -160,8 +168,15 @@ HgBackingStore::HgBackingStore(
     std::shared_ptr<StructuredLogger> logger)
     : localStore_(std::move(localStore)),
       stats_(stats),
+      commitCache_{folly::in_place,
+                   config->getEdenConfig()->hgCommitCacheSize.getValue()},
       importThreadPool_(make_unique<folly::CPUThreadPoolExecutor>(
-          FLAGS_num_hg_import_threads,
+          // Threads, and the helper processes they own, are started when
+          // imports queue up and stopped after being idle for a while.
+          std::pair<size_t, size_t>(
+              FLAGS_num_hg_import_threads,
+              std::min(
+                  FLAGS_min_hg_import_threads, FLAGS_num_hg_import_threads)),
           /* Eden performance will degrade when, for example, a status operation
            * causes a large number of import requests to be scheduled before a
            * lightweight operation needs to check the RocksDB cache. In that
@@ -204,6 +219,8 @@ HgBackingStore::HgBackingStore(
     std::shared_ptr<EdenStats> stats)
     : localStore_{std::move(localStore)},
       stats_{std::move(stats)},
+      commitCache_{folly::in_place,
+                   config->getEdenConfig()->hgCommitCacheSize.getValue()},
       importThreadPool_{std::make_unique<HgImporterTestExecutor>(importer)},
       config_(std::move(config)),
       serverThreadPool_{importThreadPool_.get()},
@@ -471,7 +488,7 @@ std::unique_ptr<Tree> HgBackingStore::processTree(
     LocalStore::WriteBatch* writeBatch) {
   auto manifest = Manifest(std::move(content));
   std::vector<TreeEntry> entries;
-  auto hgObjectIdFormat = config_->getEdenConfig()->hgObjectIdFormat.getValue();
+  auto hgObjectIdFormat = config_->getValue(&EdenConfig::hgObjectIdFormat);
 
   for (auto& entry : manifest) {
     XLOG(DBG9) << "tree: " << manifestNode << " " << entry.name
@@ -507,6 +524,7 @@ folly::Future<folly::Unit> HgBackingStore::importTreeManifestForRoot(
               return folly::unit;
             }
 
+            cacheManifestNode(commitId, manifestId);
             return importTreeManifestImpl(manifestId)
                 .thenValue([this, commitId, manifestId](
                                std::unique_ptr<Tree> rootTree) {
@@ -524,6 +542,16 @@ folly::Future<folly::Unit> HgBackingStore::importTreeManifestForRoot(
 
 folly::Future<std::unique_ptr<Tree>> HgBackingStore::importTreeManifest(
     const ObjectId& commitId) {
+  if (auto manifestNode = getCachedManifestNode(commitId)) {
+    XLOG(DBG4) << "revision " << commitId << " has cached manifest node "
+               << *manifestNode;
+    return importTreeManifestImpl(*manifestNode);
+  }
+
+  // A commit we haven't seen is usually the start of a checkout or rebase
+  // that will visit its neighbours next.
+  prefetchManifestNodes();
+
   return folly::via(
              importThreadPool_.get(),
              [commitId] {
@@ -534,15 +562,70 @@ folly::Future<std::unique_ptr<Tree>> HgBackingStore::importTreeManifest(
       .thenValue([this, commitId](auto manifestNode) {
         XLOG(DBG2) << "revision " << commitId << " has manifest node "
                    << manifestNode;
+        cacheManifestNode(commitId, manifestNode);
         return importTreeManifestImpl(manifestNode);
       });
 }
 
+void HgBackingStore::cacheManifestNode(
+    const ObjectId& commitId,
+    const Hash20& manifestNode) {
+  commitCache_.wlock()->manifestNodes.set(commitId, manifestNode);
+}
+
+std::optional<Hash20> HgBackingStore::getCachedManifestNode(
+    const ObjectId& commitId) {
+  auto cache = commitCache_.wlock();
+  auto it = cache->manifestNodes.find(commitId);
+  if (it == cache->manifestNodes.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+void HgBackingStore::prefetchManifestNodes() {
+  auto edenConfig = config_->getEdenConfig();
+  auto revset = edenConfig->hgCommitPrefetchRevset.getValue();
+  if (revset.empty()) {
+    return;
+  }
+
+  {
+    auto now = std::chrono::steady_clock::now();
+    auto cache = commitCache_.wlock();
+    if (cache->prefetched &&
+        now - cache->lastPrefetch <
+            edenConfig->hgCommitPrefetchInterval.getValue()) {
+      return;
+    }
+    cache->prefetched = true;
+    cache->lastPrefetch = now;
+  }
+
+  importThreadPool_->add([this, revset = std::move(revset)] {
+    std::vector<std::pair<Hash20, Hash20>> nodes;
+    try {
+      nodes = getThreadLocalImporter().resolveManifestNodes(revset);
+    } catch (const std::exception& ex) {
+      XLOG(WARN) << "failed to prefetch the manifest nodes of '" << revset
+                 << "': " << folly::exceptionStr(ex);
+      return;
+    }
+
+    XLOG(DBG3) << "prefetched the manifest nodes of " << nodes.size()
+               << " commits";
+    auto cache = commitCache_.wlock();
+    for (const auto& [commit, manifestNode] : nodes) {
+      cache->manifestNodes.set(ObjectId{commit.getBytes()}, manifestNode);
+    }
+  });
+}
+
 folly::Future<std::unique_ptr<Tree>> HgBackingStore::importTreeManifestImpl(
     Hash20 manifestNode) {
   // Record that we are at the root for this node
   RelativePathPiece path{};
-  auto hgObjectIdFormat = config_->getEdenConfig()->hgObjectIdFormat.getValue();
+  auto hgObjectIdFormat = config_->getValue(&EdenConfig::hgObjectIdFormat);
 
   ObjectId objectId;
   std::optional<std::pair<ObjectId, std::string>> computedPair;
@@ -605,6 +688,68 @@ SemiFuture<std::unique_ptr<Blob>> HgBackingStore::fetchBlobFromHgImporter(
       });
 }
 
+std::vector<SemiFuture<std::unique_ptr<Blob>>>
+HgBackingStore::fetchBlobsFromHgImporter(std::vector<HgProxyHash> hgInfos) {
+  std::vector<SemiFuture<std::unique_ptr<Blob>>> futures;
+  futures.reserve(hgInfos.size());
+
+  // Each helper pipelines up to kMaxPipelinedRequests; larger batches are
+  // spread over several helpers.
+  for (size_t begin = 0; begin < hgInfos.size();
+       begin += HgImporter::kMaxPipelinedRequests) {
+    auto end =
+        std::min(begin + HgImporter::kMaxPipelinedRequests, hgInfos.size());
+    std::vector<HgProxyHash> chunk{
+        std::make_move_iterator(hgInfos.begin() + begin),
+        std::make_move_iterator(hgInfos.begin() + end)};
+    std::vector<folly::Promise<std::unique_ptr<Blob>>> promises(chunk.size());
+    for (auto& promise : promises) {
+      futures.push_back(promise.getSemiFuture());
+    }
+
+    importThreadPool_->add([this,
+                            stats = stats_,
+                            chunk = std::move(chunk),
+                            promises = std::move(promises),
+                            &liveImportBlobWatches =
+                                liveImportBlobWatches_]() mutable {
+      Importer& importer = getThreadLocalImporter();
+      folly::stop_watch<std::chrono::milliseconds> watch;
+      std::vector<RequestMetricsScope> queueTrackers;
+      queueTrackers.reserve(chunk.size());
+      std::vector<std::pair<RelativePathPiece, Hash20>> files;
+      files.reserve(chunk.size());
+      for (auto& hgInfo : chunk) {
+        queueTrackers.emplace_back(&liveImportBlobWatches);
+        if (useEdenApi_ && logger_) {
+          logger_->logEvent(EdenApiMiss{
+              repoName_,
+              EdenApiMiss::Blob,
+              hgInfo.path().stringPiece().toString(),
+              hgInfo.revHash().toString(),
+          });
+        }
+        files.emplace_back(hgInfo.path(), hgInfo.revHash());
+      }
+
+      auto results = folly::makeTryWith(
+          [&] { return importer.importFileContentsBatch(files); });
+      auto elapsed = watch.elapsed().count();
+      auto& threadStats = stats->getHgBackingStoreStatsForCurrentThread();
+      for (size_t i = 0; i < promises.size(); ++i) {
+        threadStats.hgBackingStoreImportBlob.addValue(elapsed);
+        if (results.hasException()) {
+          promises[i].setException(results.exception());
+        } else {
+          promises[i].setTry(std::move(results.value()[i]));
+        }
+      }
+    });
+  }
+
+  return futures;
+}
+
 folly::StringPiece HgBackingStore::stringOfHgImportObject(
     HgImportObject object) {
   switch (object) {
@@ -7,12 +7,16 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
+#include <optional>
+#include <vector>
 
 #include <folly/Executor.h>
 #include <folly/Range.h>
 #include <folly/String.h>
 #include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
 
 #include "eden/fs/eden-config.h"
 #include "eden/fs/store/BackingStore.h"
@@ -115,6 +119,13 @@ class HgBackingStore {
   folly::SemiFuture<std::unique_ptr<Blob>> fetchBlobFromHgImporter(
       HgProxyHash hgInfo);
 
+  /**
+   * Fetch several blobs from Mercurial, pipelining the requests to each
+   * helper process. Returns one future per blob, in order.
+   */
+  std::vector<folly::SemiFuture<std::unique_ptr<Blob>>>
+  fetchBlobsFromHgImporter(std::vector<HgProxyHash> hgInfos);
+
   HgDatapackStore& getDatapackStore() {
     return datapackStore_;
   }
@@ -131,6 +142,19 @@ class HgBackingStore {
   folly::Future<std::unique_ptr<Tree>> importTreeManifestImpl(
       Hash20 manifestNode);
 
+  /**
+   * Record that the root manifest of commitId is manifestNode.
+   */
+  void cacheManifestNode(const ObjectId& commitId, const Hash20& manifestNode);
+  std::optional<Hash20> getCachedManifestNode(const ObjectId& commitId);
+
+  /**
+   * Resolve the manifest nodes of the hg:commit-prefetch-revset commits on
+   * an import thread, unless that was done less than
+   * hg:commit-prefetch-interval ago.
+   */
+  void prefetchManifestNodes();
+
   void initializeDatapackImport(AbsolutePathPiece repository);
   folly::Future<std::unique_ptr<Tree>> importTreeImpl(
       const Hash20& manifestNode,
@@ -154,6 +178,19 @@ class HgBackingStore {
 
   std::shared_ptr<LocalStore> localStore_;
   std::shared_ptr<EdenStats> stats_;
+
+  struct CommitCache {
+    explicit CommitCache(size_t maxSize) : manifestNodes{maxSize} {}
+
+    folly::EvictingCacheMap<ObjectId, Hash20> manifestNodes;
+    std::chrono::steady_clock::time_point lastPrefetch;
+    bool prefetched{false};
+  };
+  // Root manifest nodes of recently used commits, so that most commits
+  // don't need a round trip to the hg helper to find their root tree.
+  // Declared before the import threads, which fill it.
+  folly::Synchronized<CommitCache> commitCache_;
+
   // A set of threads owning HgImporter instances
   std::unique_ptr<folly::Executor> importThreadPool_;
   std::shared_ptr<ReloadableConfig> config_;
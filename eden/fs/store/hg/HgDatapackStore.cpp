@@ -10,6 +10,7 @@
 #include <folly/Optional.h>
 #include <folly/io/IOBuf.h>
 #include <folly/logging/xlog.h>
+#include <folly/stop_watch.h>
 #include <memory>
 #include <optional>
 
@@ -112,7 +113,7 @@ std::unique_ptr<Tree> HgDatapackStore::getTreeLocal(
     const HgProxyHash& proxyHash,
     LocalStore& localStore) {
   auto tree = store_.getTree(proxyHash.byteHash(), /*local=*/true);
-  auto hgObjectIdFormat = config_->getEdenConfig()->hgObjectIdFormat.getValue();
+  auto hgObjectIdFormat = config_->getValue(&EdenConfig::hgObjectIdFormat);
   if (tree) {
     return fromRawTree(
         tree.get(),
@@ -128,7 +129,8 @@ std::unique_ptr<Tree> HgDatapackStore::getTreeLocal(
 }
 
 void HgDatapackStore::getBlobBatch(
-    const std::vector<std::shared_ptr<HgImportRequest>>& importRequests) {
+    const std::vector<std::shared_ptr<HgImportRequest>>& importRequests,
+    FetchCallback onFetch) {
   size_t count = importRequests.size();
 
   std::vector<std::pair<folly::ByteRange, folly::ByteRange>> requests;
@@ -152,7 +154,7 @@ void HgDatapackStore::getBlobBatch(
       requests,
       false,
       // store_.getBlobBatch is blocking, hence we can take these by reference.
-      [&importRequests, &requests, &requestsWatches](
+      [&importRequests, &requests, &requestsWatches, onFetch](
           size_t index, std::unique_ptr<folly::IOBuf> content) {
         XLOGF(
             DBG9,
@@ -162,7 +164,9 @@ void HgDatapackStore::getBlobBatch(
         auto& importRequest = importRequests[index];
         auto* blobRequest =
             importRequest->getRequest<HgImportRequest::BlobImport>();
+        folly::stop_watch<std::chrono::microseconds> watch;
         auto blob = std::make_unique<Blob>(blobRequest->hash, *content);
+        onFetch(*importRequest, watch.elapsed());
         importRequest->getPromise<std::unique_ptr<Blob>>()->setValue(
             std::move(blob));
 
@@ -171,9 +175,69 @@ void HgDatapackStore::getBlobBatch(
       });
 }
 
+folly::SemiFuture<folly::Unit> HgDatapackStore::getBlobBatchAsync(
+    std::vector<std::shared_ptr<HgImportRequest>> importRequests,
+    folly::Function<void(const HgImportRequest&, std::chrono::microseconds)>
+        onFetch) {
+  size_t count = importRequests.size();
+
+  std::vector<std::pair<folly::ByteRange, folly::ByteRange>> requests;
+  requests.reserve(count);
+
+  for (const auto& importRequest : importRequests) {
+    auto& proxyHash =
+        importRequest->getRequest<HgImportRequest::BlobImport>()->proxyHash;
+    requests.emplace_back(
+        folly::ByteRange{proxyHash.path().stringPiece()}, proxyHash.byteHash());
+  }
+
+  // Unlike in getBlobBatch, the requests outlive this call, so the callbacks
+  // share them.
+  struct Batch {
+    std::vector<std::shared_ptr<HgImportRequest>> importRequests;
+    std::vector<RequestMetricsScope> requestsWatches;
+    folly::Function<void(const HgImportRequest&, std::chrono::microseconds)>
+        onFetch;
+    folly::Promise<folly::Unit> done;
+  };
+  auto batch = std::make_shared<Batch>();
+  batch->importRequests = std::move(importRequests);
+  batch->requestsWatches.reserve(count);
+  for (auto i = 0ul; i < count; i++) {
+    batch->requestsWatches.emplace_back(&liveBatchedBlobWatches_);
+  }
+  batch->onFetch = std::move(onFetch);
+  auto future = batch->done.getSemiFuture();
+
+  store_.getBlobBatchAsync(
+      requests,
+      false,
+      [batch](size_t index, std::unique_ptr<folly::IOBuf> content) {
+        auto& importRequest = batch->importRequests[index];
+        auto* blobRequest =
+            importRequest->getRequest<HgImportRequest::BlobImport>();
+        XLOGF(
+            DBG9,
+            "Imported name={} node={}",
+            blobRequest->proxyHash.path().stringPiece(),
+            folly::hexlify(blobRequest->proxyHash.byteHash()));
+        folly::stop_watch<std::chrono::microseconds> watch;
+        auto blob = std::make_unique<Blob>(blobRequest->hash, *content);
+        batch->onFetch(*importRequest, watch.elapsed());
+        importRequest->getPromise<std::unique_ptr<Blob>>()->setValue(
+            std::move(blob));
+
+        // Make sure that we're stopping this watch.
+        auto watch = std::move(batch->requestsWatches[index]);
+      },
+      [batch] { batch->done.setValue(); });
+  return future;
+}
+
 void HgDatapackStore::getTreeBatch(
     const std::vector<std::shared_ptr<HgImportRequest>>& importRequests,
-    LocalStore::WriteBatch* writeBatch) {
+    LocalStore::WriteBatch* writeBatch,
+    FetchCallback onFetch) {
   auto count = importRequests.size();
 
   std::vector<std::pair<folly::ByteRange, folly::ByteRange>> requests;
@@ -192,7 +256,7 @@ void HgDatapackStore::getTreeBatch(
     requestsWatches.emplace_back(&liveBatchedTreeWatches_);
   }
 
-  auto hgObjectIdFormat = config_->getEdenConfig()->hgObjectIdFormat.getValue();
+  auto hgObjectIdFormat = config_->getValue(&EdenConfig::hgObjectIdFormat);
 
   store_.getTreeBatch(
       requests,
@@ -202,7 +266,8 @@ void HgDatapackStore::getTreeBatch(
        &requests,
        &importRequests,
        &requestsWatches,
-       writeBatch](size_t index, std::shared_ptr<RustTree> content) mutable {
+       writeBatch,
+       onFetch](size_t index, std::shared_ptr<RustTree> content) mutable {
         XLOGF(
             DBG4,
             "Imported tree name={} node={}",
@@ -212,6 +277,7 @@ void HgDatapackStore::getTreeBatch(
         auto* treeRequest =
             importRequest->getRequest<HgImportRequest::TreeImport>();
 
+        folly::stop_watch<std::chrono::microseconds> watch;
         auto tree = fromRawTree(
             content.get(),
             treeRequest->hash,
@@ -219,6 +285,7 @@ void HgDatapackStore::getTreeBatch(
             hgObjectIdFormat,
             (hgObjectIdFormat != HgObjectIdFormat::ProxyHash) ? nullptr
                                                               : writeBatch);
+        onFetch(*importRequest, watch.elapsed());
 
         importRequest->getPromise<std::unique_ptr<Tree>>()->setValue(
             std::move(tree));
@@ -228,6 +295,32 @@ void HgDatapackStore::getTreeBatch(
       });
 }
 
+void HgDatapackStore::getBlobMetadataBatch(
+    const std::vector<std::shared_ptr<HgImportRequest>>& importRequests) {
+  std::vector<std::pair<folly::ByteRange, folly::ByteRange>> requests;
+  requests.reserve(importRequests.size());
+
+  for (const auto& importRequest : importRequests) {
+    auto& proxyHash =
+        importRequest->getRequest<HgImportRequest::BlobMetaImport>()->proxyHash;
+    requests.emplace_back(
+        folly::ByteRange{proxyHash.path().stringPiece()}, proxyHash.byteHash());
+  }
+
+  store_.getBlobMetadataBatch(
+      requests,
+      false,
+      // store_.getBlobMetadataBatch is blocking, hence we can take these by
+      // reference.
+      [&importRequests](
+          size_t index, std::shared_ptr<RustFileAuxData> metadata) {
+        importRequests[index]
+            ->getPromise<std::unique_ptr<BlobMetadata>>()
+            ->setValue(std::make_unique<BlobMetadata>(
+                Hash20{metadata->content_sha1}, metadata->total_size));
+      });
+}
+
 std::unique_ptr<Tree> HgDatapackStore::getTree(
     const RelativePath& path,
     const Hash20& manifestId,
@@ -248,8 +341,7 @@ std::unique_ptr<Tree> HgDatapackStore::getTree(
     tree = store_.getTree(manifestId.getBytes(), false);
   }
   if (tree) {
-    auto hgObjectIdFormat =
-        config_->getEdenConfig()->hgObjectIdFormat.getValue();
+    auto hgObjectIdFormat = config_->getValue(&EdenConfig::hgObjectIdFormat);
     return fromRawTree(
         tree.get(),
         edenTreeId,
@@ -7,7 +7,11 @@
 
 #pragma once
 
+#include <chrono>
+
+#include <folly/Function.h>
 #include <folly/Range.h>
+#include <folly/futures/Future.h>
 #include <folly/futures/Promise.h>
 
 #include "eden/fs/model/Blob.h"
@@ -50,17 +54,46 @@ class HgDatapackStore {
       const HgProxyHash& proxyHash,
       LocalStore& localStore);
 
+  /**
+   * Called by the batch imports for each request that was found, with the
+   * time taken to convert its data to a Blob or Tree, right before the
+   * promise of the request is fulfilled.
+   */
+  using FetchCallback = folly::FunctionRef<
+      void(const HgImportRequest& request, std::chrono::microseconds)>;
+
   /**
    * Import multiple blobs at once. The vector parameters have to be the same
    * length. Promises passed in will be resolved if a blob is successfully
    * imported. Otherwise the promise will be left untouched.
    */
   void getBlobBatch(
-      const std::vector<std::shared_ptr<HgImportRequest>>& requests);
+      const std::vector<std::shared_ptr<HgImportRequest>>& requests,
+      FetchCallback onFetch);
+
+  /**
+   * Like getBlobBatch, but doesn't wait for the blobs to be fetched: the
+   * promises are fulfilled, and onFetch called, from the thread fetching
+   * them. The returned future completes once every blob was either imported
+   * or not found.
+   */
+  folly::SemiFuture<folly::Unit> getBlobBatchAsync(
+      std::vector<std::shared_ptr<HgImportRequest>> requests,
+      folly::Function<void(const HgImportRequest&, std::chrono::microseconds)>
+          onFetch);
 
   void getTreeBatch(
       const std::vector<std::shared_ptr<HgImportRequest>>& requests,
-      LocalStore::WriteBatch* writeBatch);
+      LocalStore::WriteBatch* writeBatch,
+      FetchCallback onFetch);
+
+  /**
+   * Import the metadata of multiple blobs at once, from hgcache or EdenAPI,
+   * without their contents. Like getBlobBatch, the promises of the requests
+   * that aren't found are left untouched.
+   */
+  void getBlobMetadataBatch(
+      const std::vector<std::shared_ptr<HgImportRequest>>& requests);
 
   std::unique_ptr<Tree> getTree(
       const RelativePath& path,
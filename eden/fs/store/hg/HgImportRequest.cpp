@@ -10,6 +10,7 @@
 #include <folly/Try.h>
 #include <folly/futures/Future.h>
 #include <folly/futures/Promise.h>
+#include <algorithm>
 
 #include "eden/fs/telemetry/RequestMetricsScope.h"
 
@@ -36,15 +37,57 @@ std::shared_ptr<HgImportRequest> HgImportRequest::makeRequest(
 std::shared_ptr<HgImportRequest> HgImportRequest::makeBlobImportRequest(
     ObjectId hash,
     HgProxyHash proxyHash,
-    ImportPriority priority) {
-  return makeRequest<BlobImport>(priority, hash, std::move(proxyHash));
+    ImportPriority priority,
+    folly::CancellationToken cancellationToken,
+    std::optional<pid_t> clientPid) {
+  auto request = makeRequest<BlobImport>(priority, hash, std::move(proxyHash));
+  request->cancellationTokens_.push_back(std::move(cancellationToken));
+  request->clientPid_ = clientPid;
+  return request;
 }
 
 std::shared_ptr<HgImportRequest> HgImportRequest::makeTreeImportRequest(
     ObjectId hash,
     HgProxyHash proxyHash,
-    ImportPriority priority) {
-  return makeRequest<TreeImport>(priority, hash, std::move(proxyHash));
+    ImportPriority priority,
+    folly::CancellationToken cancellationToken,
+    std::optional<pid_t> clientPid) {
+  auto request = makeRequest<TreeImport>(priority, hash, std::move(proxyHash));
+  request->cancellationTokens_.push_back(std::move(cancellationToken));
+  request->clientPid_ = clientPid;
+  return request;
+}
+
+std::shared_ptr<HgImportRequest> HgImportRequest::makeBlobMetaImportRequest(
+    ObjectId hash,
+    HgProxyHash proxyHash,
+    ImportPriority priority,
+    folly::CancellationToken cancellationToken,
+    std::optional<pid_t> clientPid) {
+  auto request =
+      makeRequest<BlobMetaImport>(priority, hash, std::move(proxyHash));
+  request->cancellationTokens_.push_back(std::move(cancellationToken));
+  request->clientPid_ = clientPid;
+  return request;
+}
+
+bool HgImportRequest::isAbandoned() const {
+  // A default constructed token is never cancelled, so a caller that can't
+  // cancel keeps the request alive.
+  return !cancellationTokens_.empty() &&
+      std::all_of(
+             cancellationTokens_.begin(),
+             cancellationTokens_.end(),
+             [](const folly::CancellationToken& token) {
+               return token.isCancellationRequested();
+             });
+}
+
+void HgImportRequest::addWaitersOf(const HgImportRequest& duplicate) {
+  cancellationTokens_.insert(
+      cancellationTokens_.end(),
+      duplicate.cancellationTokens_.begin(),
+      duplicate.cancellationTokens_.end());
 }
 
 } // namespace facebook::eden
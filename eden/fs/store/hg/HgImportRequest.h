@@ -7,11 +7,15 @@
 
 #pragma once
 
+#include <folly/CancellationToken.h>
 #include <folly/futures/Promise.h>
+#include <optional>
 #include <utility>
 #include <variant>
+#include <vector>
 
 #include "eden/fs/model/Blob.h"
+#include "eden/fs/model/BlobMetadata.h"
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/store/ImportPriority.h"
@@ -55,13 +59,36 @@ class HgImportRequest {
     std::vector<folly::Promise<Response>> promises;
   };
 
+  /**
+   * Fetch the size and SHA-1 of a blob, without its contents.
+   */
+  struct BlobMetaImport {
+    using Response = std::unique_ptr<BlobMetadata>;
+    BlobMetaImport(ObjectId hash, HgProxyHash proxyHash)
+        : hash(hash), proxyHash(proxyHash) {}
+
+    ObjectId hash;
+    HgProxyHash proxyHash;
+
+    // Always empty: ObjectStore already coalesces concurrent metadata
+    // lookups, so these requests aren't de-duplicated by the queue.
+    std::vector<folly::Promise<Response>> promises;
+  };
+
   /**
    * Allocate a blob request.
+   *
+   * The cancellation token and client pid are the ones of the caller's
+   * ObjectFetchContext: once the token is cancelled, the caller no longer
+   * waits on the result, and the pid is used to share the import threads
+   * fairly between processes.
    */
   static std::shared_ptr<HgImportRequest> makeBlobImportRequest(
       ObjectId hash,
       HgProxyHash proxyHash,
-      ImportPriority priority);
+      ImportPriority priority,
+      folly::CancellationToken cancellationToken = {},
+      std::optional<pid_t> clientPid = std::nullopt);
 
   /**
    * Allocate a tree request.
@@ -69,7 +96,19 @@ class HgImportRequest {
   static std::shared_ptr<HgImportRequest> makeTreeImportRequest(
       ObjectId hash,
       HgProxyHash proxyHash,
-      ImportPriority priority);
+      ImportPriority priority,
+      folly::CancellationToken cancellationToken = {},
+      std::optional<pid_t> clientPid = std::nullopt);
+
+  /**
+   * Allocate a blob metadata request.
+   */
+  static std::shared_ptr<HgImportRequest> makeBlobMetaImportRequest(
+      ObjectId hash,
+      HgProxyHash proxyHash,
+      ImportPriority priority,
+      folly::CancellationToken cancellationToken = {},
+      std::optional<pid_t> clientPid = std::nullopt);
 
   /**
    * Implementation detail of the make*Request functions from above. Do not use
@@ -122,6 +161,26 @@ class HgImportRequest {
     return unique_;
   }
 
+  /**
+   * The process that caused this request, if known.
+   */
+  std::optional<pid_t> getClientPid() const {
+    return clientPid_;
+  }
+
+  /**
+   * Whether every caller waiting on this request, including the callers of
+   * the duplicates folded into it, gave up on it. Importing it would then
+   * be wasted work.
+   */
+  bool isAbandoned() const;
+
+  /**
+   * Record that the caller of duplicate, a request for the same object,
+   * waits on this request too.
+   */
+  void addWaitersOf(const HgImportRequest& duplicate);
+
   std::chrono::steady_clock::time_point getRequestTime() const {
     return requestTime_;
   }
@@ -138,10 +197,11 @@ class HgImportRequest {
   HgImportRequest(const HgImportRequest&) = delete;
   HgImportRequest& operator=(const HgImportRequest&) = delete;
 
-  using Request = std::variant<BlobImport, TreeImport>;
+  using Request = std::variant<BlobImport, TreeImport, BlobMetaImport>;
   using Response = std::variant<
       folly::Promise<std::unique_ptr<Blob>>,
-      folly::Promise<std::unique_ptr<Tree>>>;
+      folly::Promise<std::unique_ptr<Tree>>,
+      folly::Promise<std::unique_ptr<BlobMetadata>>>;
 
   Request request_;
   ImportPriority priority_;
@@ -149,6 +209,12 @@ class HgImportRequest {
   uint64_t unique_ = generateUniqueID();
   std::chrono::steady_clock::time_point requestTime_ =
       std::chrono::steady_clock::now();
+  /**
+   * One token per caller waiting on this request. Only accessed with the
+   * HgImportRequestQueue lock held.
+   */
+  std::vector<folly::CancellationToken> cancellationTokens_;
+  std::optional<pid_t> clientPid_;
 
   friend bool operator<(
       const HgImportRequest& lhs,
@@ -6,12 +6,32 @@
  */
 
 #include "eden/fs/store/hg/HgImportRequestQueue.h"
+#include <folly/CancellationToken.h>
 #include <folly/futures/Future.h>
+#include <folly/logging/xlog.h>
 #include <algorithm>
 #include "eden/fs/config/ReloadableConfig.h"
 
 namespace facebook::eden {
 
+namespace {
+
+/**
+ * Fail the promises of an abandoned request, including the ones of the
+ * duplicates folded into it.
+ */
+template <typename ImportType>
+void failAbandoned(HgImportRequest& request) {
+  auto* import = request.getRequest<ImportType>();
+  for (auto& promise : import->promises) {
+    promise.setException(folly::OperationCancelled{});
+  }
+  request.getPromise<typename ImportType::Response>()->setException(
+      folly::OperationCancelled{});
+}
+
+} // namespace
+
 void HgImportRequestQueue::stop() {
   auto state = state_.lock();
   if (state->running) {
@@ -20,6 +40,36 @@ void HgImportRequestQueue::stop() {
   }
 }
 
+ImportBatchSizer::Limits HgImportRequestQueue::getBatchLimits(
+    bool isTree) const {
+  auto config = config_->getEdenConfig();
+  return ImportBatchSizer::Limits{
+      isTree ? config->importBatchSizeTree.getValue()
+             : config->importBatchSize.getValue(),
+      config->importBatchSizeMax.getValue(),
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          config->importBatchTargetLatency.getValue())};
+}
+
+HgImportRequestQueue::ImportQueue& HgImportRequestQueue::State::queueFor(
+    const HgImportRequest& request) {
+  if (request.isType<HgImportRequest::TreeImport>()) {
+    return treeQueue;
+  } else if (request.isType<HgImportRequest::BlobMetaImport>()) {
+    return blobMetaQueue;
+  }
+  return blobQueue;
+}
+
+void HgImportRequestQueue::recordBatchDuration(
+    const HgImportRequest& request,
+    size_t batchSize,
+    std::chrono::microseconds elapsed) {
+  auto limits = getBatchLimits(request.isType<HgImportRequest::TreeImport>());
+  auto state = state_.lock();
+  state->queueFor(request).batchSizer.recordBatch(batchSize, elapsed, limits);
+}
+
 folly::Future<std::unique_ptr<Blob>> HgImportRequestQueue::enqueueBlob(
     std::shared_ptr<HgImportRequest> request) {
   return enqueue<std::unique_ptr<Blob>, HgImportRequest::BlobImport>(
@@ -32,12 +82,24 @@ folly::Future<std::unique_ptr<Tree>> HgImportRequestQueue::enqueueTree(
       std::move(request));
 }
 
+folly::Future<std::unique_ptr<BlobMetadata>>
+HgImportRequestQueue::enqueueBlobMeta(
+    std::shared_ptr<HgImportRequest> request) {
+  auto state = state_.lock();
+  auto promise = request->getPromise<std::unique_ptr<BlobMetadata>>();
+  state->blobMetaQueue.push(std::move(request));
+
+  queueCV_.notify_one();
+
+  return promise->getFuture();
+}
+
 template <typename Ret, typename ImportType>
 folly::Future<Ret> HgImportRequestQueue::enqueue(
     std::shared_ptr<HgImportRequest> request) {
   auto state = state_.lock();
 
-  std::vector<std::shared_ptr<HgImportRequest>>* queue;
+  ImportQueue* queue;
   if constexpr (std::is_same_v<ImportType, HgImportRequest::BlobImport>) {
     queue = &state->blobQueue;
   } else {
@@ -46,61 +108,145 @@ folly::Future<Ret> HgImportRequestQueue::enqueue(
   }
 
   const auto& hash = request->getRequest<ImportType>()->hash;
-  if (auto* existingRequestPtr = folly::get_ptr(state->requestTracker, hash)) {
-    auto& existingRequest = *existingRequestPtr;
+  if (auto* tracked = folly::get_ptr(state->requestTracker, hash)) {
+    auto& existingRequest = tracked->request;
     auto* trackedImport = existingRequest->template getRequest<ImportType>();
 
     auto [promise, future] = folly::makePromiseContract<Ret>();
     trackedImport->promises.emplace_back(std::move(promise));
+    existingRequest->addWaitersOf(*request);
 
     if (existingRequest->getPriority() < request->getPriority()) {
       existingRequest->setPriority(request->getPriority());
 
-      // Since the new request has a higher priority than the already present
-      // one, we need to re-order the heap.
-      //
-      // TODO(xavierd): this has a O(n) complexity, and enqueing tons of
-      // duplicated requests will thus lead to a quadratic complexity.
-      std::make_heap(
-          queue->begin(),
-          queue->end(),
-          [](const std::shared_ptr<HgImportRequest>& lhs,
-             const std::shared_ptr<HgImportRequest>& rhs) {
-            return (*lhs) < (*rhs);
-          });
+      // Move the request to the bucket of its new priority. The entry left
+      // behind in the old bucket is now stale and will be skipped.
+      if (tracked->queued) {
+        queue->requests[request->getPriority().value()].emplace(
+            tracked->tag, existingRequest);
+      }
     }
 
     return std::move(future).toUnsafeFuture();
   }
 
-  queue->emplace_back(request);
   auto promise = request->getPromise<Ret>();
-
-  state->requestTracker.emplace(hash, std::move(request));
-
-  std::push_heap(
-      queue->begin(),
-      queue->end(),
-      [](const std::shared_ptr<HgImportRequest>& lhs,
-         const std::shared_ptr<HgImportRequest>& rhs) {
-        return (*lhs) < (*rhs);
-      });
+  auto tag = queue->push(request);
+  state->requestTracker.emplace(
+      hash, TrackedImport{std::move(request), tag});
 
   queueCV_.notify_one();
 
   return promise->getFuture();
 }
 
+uint64_t HgImportRequestQueue::ImportQueue::push(
+    std::shared_ptr<HgImportRequest> request) {
+  auto& client = clients[request->getClientPid().value_or(0)];
+  // A client that was idle starts at the current virtual time rather than
+  // getting credit for the time it didn't use.
+  auto tag = std::max(virtualTime, client.finishTag);
+  client.finishTag = tag + 1;
+  ++client.queued;
+  ++depth;
+
+  auto priority = request->getPriority().value();
+  requests[priority].emplace(tag, std::move(request));
+  return tag;
+}
+
+std::shared_ptr<HgImportRequest> HgImportRequestQueue::ImportQueue::pop() {
+  auto& bucket = requests.begin()->second;
+  auto entry = bucket.begin();
+  virtualTime = std::max(virtualTime, entry->first);
+  auto request = std::move(entry->second);
+  bucket.erase(entry);
+  --depth;
+
+  auto client = clients.find(request->getClientPid().value_or(0));
+  if (client != clients.end() && --client->second.queued == 0) {
+    clients.erase(client);
+  }
+  return request;
+}
+
+HgImportRequest* HgImportRequestQueue::front(PriorityQueue& queue) {
+  while (!queue.empty()) {
+    auto bucket = queue.begin();
+    auto& requests = bucket->second;
+    while (!requests.empty() &&
+           requests.begin()->second->getPriority().value() != bucket->first) {
+      requests.erase(requests.begin());
+    }
+    if (!requests.empty()) {
+      return requests.begin()->second.get();
+    }
+    queue.erase(bucket);
+  }
+  return nullptr;
+}
+
+std::map<pid_t, HgImportRequestQueue::ClientStats>
+HgImportRequestQueue::getClientStats() const {
+  std::map<pid_t, ClientStats> result;
+  auto state = state_.lock();
+  for (const auto& [pid, client] : state->treeQueue.clients) {
+    result[pid].queuedTrees = client.queued;
+  }
+  for (const auto& [pid, client] : state->blobQueue.clients) {
+    result[pid].queuedBlobs = client.queued;
+  }
+  for (const auto& [pid, client] : state->blobMetaQueue.clients) {
+    result[pid].queuedBlobMetadata = client.queued;
+  }
+  return result;
+}
+
 std::vector<std::shared_ptr<HgImportRequest>> HgImportRequestQueue::dequeue() {
+  while (true) {
+    std::vector<std::shared_ptr<HgImportRequest>> abandoned;
+    auto result = tryDequeue(abandoned);
+
+    // Outside of the lock, as the callbacks of the futures may enqueue more
+    // requests.
+    for (auto& request : abandoned) {
+      XLOG(DBG4) << "Dropping abandoned import request";
+      if (request->isType<HgImportRequest::TreeImport>()) {
+        failAbandoned<HgImportRequest::TreeImport>(*request);
+      } else if (request->isType<HgImportRequest::BlobMetaImport>()) {
+        failAbandoned<HgImportRequest::BlobMetaImport>(*request);
+      } else {
+        failAbandoned<HgImportRequest::BlobImport>(*request);
+      }
+    }
+
+    if (!result) {
+      return {};
+    }
+    // Everything that was dequeued may have been abandoned, in which case
+    // wait for more requests.
+    if (!result->empty()) {
+      return std::move(*result);
+    }
+  }
+}
+
+std::optional<std::vector<std::shared_ptr<HgImportRequest>>>
+HgImportRequestQueue::tryDequeue(
+    std::vector<std::shared_ptr<HgImportRequest>>& abandoned) {
   size_t count;
-  std::vector<std::shared_ptr<HgImportRequest>>* queue = nullptr;
+  ImportQueue* queue = nullptr;
 
   auto state = state_.lock();
   while (true) {
     if (!state->running) {
-      state->treeQueue.clear();
-      state->blobQueue.clear();
-      return std::vector<std::shared_ptr<HgImportRequest>>();
+      for (auto* importQueue :
+           {&state->treeQueue, &state->blobMetaQueue, &state->blobQueue}) {
+        importQueue->requests.clear();
+        importQueue->clients.clear();
+        importQueue->depth = 0;
+      }
+      return std::nullopt;
     }
 
     ImportPriority highestPriority{ImportPriorityKind::Low, 0};
@@ -109,18 +255,26 @@ std::vector<std::shared_ptr<HgImportRequest>> HgImportRequestQueue::dequeue() {
     // order.  The reason for trees having a higher priority is due to trees
     // allowing a higher fan-out and thus increasing concurrency of fetches
     // which translate onto a higher overall throughput.
-    if (!state->treeQueue.empty()) {
-      count = config_->getEdenConfig()->importBatchSizeTree.getValue();
-      highestPriority = state->treeQueue.front()->getPriority();
+    size_t workers =
+        config_->getEdenConfig()->numBackingstoreThreads.getValue();
+    if (auto* tree = front(state->treeQueue.requests)) {
+      count = state->treeQueue.batchSizer.getBatchSize(
+          state->treeQueue.depth, workers, getBatchLimits(/*isTree=*/true));
+      highestPriority = tree->getPriority();
       queue = &state->treeQueue;
     }
 
-    if (!state->blobQueue.empty()) {
-      auto priority = state->blobQueue.front()->getPriority();
-      if (!queue || priority > highestPriority) {
-        queue = &state->blobQueue;
-        count = config_->getEdenConfig()->importBatchSize.getValue();
-        highestPriority = priority;
+    // Metadata goes before blobs of the same priority: it is much cheaper
+    // to fetch and is what stat() waits on.
+    for (auto* blobQueue : {&state->blobMetaQueue, &state->blobQueue}) {
+      if (auto* blob = front(blobQueue->requests)) {
+        auto priority = blob->getPriority();
+        if (!queue || priority > highestPriority) {
+          queue = blobQueue;
+          count = blobQueue->batchSizer.getBatchSize(
+              blobQueue->depth, workers, getBatchLimits(/*isTree=*/false));
+          highestPriority = priority;
+        }
       }
     }
 
@@ -131,20 +285,34 @@ std::vector<std::shared_ptr<HgImportRequest>> HgImportRequestQueue::dequeue() {
     }
   }
 
-  count = std::min(count, queue->size());
   std::vector<std::shared_ptr<HgImportRequest>> result;
   result.reserve(count);
-  for (size_t i = 0; i < count; i++) {
-    std::pop_heap(
-        queue->begin(),
-        queue->end(),
-        [](const std::shared_ptr<HgImportRequest>& lhs,
-           const std::shared_ptr<HgImportRequest>& rhs) {
-          return (*lhs) < (*rhs);
-        });
-
-    result.emplace_back(std::move(queue->back()));
-    queue->pop_back();
+  while (result.size() < count && front(queue->requests)) {
+    auto request = queue->pop();
+
+    if (request->isType<HgImportRequest::BlobMetaImport>()) {
+      if (request->isAbandoned()) {
+        abandoned.emplace_back(std::move(request));
+      } else {
+        result.emplace_back(std::move(request));
+      }
+      continue;
+    }
+
+    const auto& hash = request->isType<HgImportRequest::TreeImport>()
+        ? request->getRequest<HgImportRequest::TreeImport>()->hash
+        : request->getRequest<HgImportRequest::BlobImport>()->hash;
+    if (request->isAbandoned()) {
+      // Nobody waits on it anymore. A new request for the same object will
+      // enqueue a fresh import.
+      state->requestTracker.erase(hash);
+      abandoned.emplace_back(std::move(request));
+      continue;
+    }
+    if (auto* tracked = folly::get_ptr(state->requestTracker, hash)) {
+      tracked->queued = false;
+    }
+    result.emplace_back(std::move(request));
   }
 
   return result;
@@ -11,10 +11,15 @@
 #include <folly/Try.h>
 #include <folly/container/F14Map.h>
 #include <condition_variable>
+#include <functional>
+#include <map>
 #include <mutex>
+#include <optional>
 #include <vector>
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/store/hg/HgImportRequest.h"
+#include "eden/fs/store/hg/ImportBatchSizer.h"
+#include "eden/fs/telemetry/LockProfiling.h"
 #include "folly/futures/Future.h"
 
 namespace facebook::eden {
@@ -42,17 +47,51 @@ class HgImportRequestQueue {
   folly::Future<std::unique_ptr<Tree>> enqueueTree(
       std::shared_ptr<HgImportRequest> request);
 
+  /**
+   * Enqueue a blob metadata request to the queue.
+   *
+   * Return a future that will complete when the request completes.
+   */
+  folly::Future<std::unique_ptr<BlobMetadata>> enqueueBlobMeta(
+      std::shared_ptr<HgImportRequest> request);
+
   /**
    * Returns a list of requests from the queue. It returns an empty list while
    * the queue is being destructed. This function will block when there is no
    * item available in the queue.
    *
    * All requests in the vector are guaranteed to be the same type.
-   * The number of the returned requests is controlled by `import-batch-size*`
-   * options in the config. It may have fewer requests than configured.
+   * The number of the returned requests is at least the `import-batch-size*`
+   * option of their type, unless fewer are queued. It grows up to
+   * `hg:import-batch-size-max` when the queue is deep, see ImportBatchSizer.
+   *
+   * Requests that every caller abandoned, see HgImportRequest::isAbandoned,
+   * are never returned: their futures fail with folly::OperationCancelled.
    */
   std::vector<std::shared_ptr<HgImportRequest>> dequeue();
 
+  /**
+   * Report how long importing a batch of batchSize requests returned by
+   * dequeue() took, so that the following batches of that type can be sized
+   * accordingly. request is any request of the batch.
+   */
+  void recordBatchDuration(
+      const HgImportRequest& request,
+      size_t batchSize,
+      std::chrono::microseconds elapsed);
+
+  struct ClientStats {
+    size_t queuedTrees{0};
+    size_t queuedBlobs{0};
+    size_t queuedBlobMetadata{0};
+  };
+
+  /**
+   * Return the number of queued requests of each client pid, with requests
+   * without a known client under pid 0.
+   */
+  std::map<pid_t, ClientStats> getClientStats() const;
+
   /**
    * Destroy the queue.
    *
@@ -73,7 +112,7 @@ class HgImportRequestQueue {
 
       auto importReq = state->requestTracker.find(id);
       if (importReq != state->requestTracker.end()) {
-        import = std::move(importReq->second);
+        import = std::move(importReq->second.request);
         state->requestTracker.erase(importReq);
       }
     }
@@ -118,13 +157,116 @@ class HgImportRequestQueue {
   template <typename Ret, typename ImportType>
   folly::Future<Ret> enqueue(std::shared_ptr<HgImportRequest> request);
 
+  /**
+   * A single attempt at dequeue(): returns std::nullopt once the queue is
+   * stopped, and may return an empty vector when all the requests it took
+   * were abandoned, which it moves to abandoned.
+   */
+  std::optional<std::vector<std::shared_ptr<HgImportRequest>>> tryDequeue(
+      std::vector<std::shared_ptr<HgImportRequest>>& abandoned);
+
   HgImportRequestQueue(HgImportRequestQueue&&) = delete;
   HgImportRequestQueue& operator=(HgImportRequestQueue&&) = delete;
 
+  /**
+   * Queued requests of one type, bucketed by ImportPriority::value(), highest
+   * first. Within a bucket, requests are ordered by their fair queuing start
+   * tag, see ImportQueue.
+   *
+   * Raising the priority of a queued request inserts it in its new bucket
+   * and leaves a stale entry in the old one, which is dropped when it reaches
+   * the front since the request's priority no longer matches the bucket.
+   * This makes enqueueing a duplicate request O(log(n)), where re-heapifying
+   * the whole queue was O(n).
+   */
+  using PriorityQueue = std::map<
+      int64_t,
+      std::multimap<uint64_t, std::shared_ptr<HgImportRequest>>,
+      std::greater<int64_t>>;
+
+  /**
+   * Drop the stale entries at the front of the queue, and return the highest
+   * priority request, or nullptr if the queue is empty.
+   */
+  static HgImportRequest* front(PriorityQueue& queue);
+
+  struct ClientState {
+    /**
+     * The virtual time at which the last queued request of the client is
+     * done being served.
+     */
+    uint64_t finishTag{0};
+    size_t queued{0};
+  };
+
+  /**
+   * The requests of one type.
+   *
+   * Clients, the processes that caused the requests, get an equal share of
+   * the import threads within a priority, using start-time fair queuing: a
+   * request is tagged with the virtual time at which it would start being
+   * served if every client was served in turn, and requests are dequeued in
+   * tag order. A process issuing thousands of requests thus only delays the
+   * requests of another process by one request each, rather than by its
+   * whole backlog.
+   */
+  struct ImportQueue {
+    PriorityQueue requests;
+
+    /**
+     * The number of requests in the queue, not counting stale entries.
+     */
+    size_t depth{0};
+
+    /**
+     * The start tag of the last dequeued request.
+     */
+    uint64_t virtualTime{0};
+
+    /**
+     * Clients with queued requests. Requests without a known client pid are
+     * accounted to pid 0.
+     */
+    folly::F14FastMap<pid_t, ClientState> clients;
+
+    ImportBatchSizer batchSizer;
+
+    /**
+     * Add request to the queue and return its start tag.
+     */
+    uint64_t push(std::shared_ptr<HgImportRequest> request);
+
+    /**
+     * Remove the front request, see front().
+     */
+    std::shared_ptr<HgImportRequest> pop();
+  };
+
+  struct TrackedImport {
+    std::shared_ptr<HgImportRequest> request;
+    /**
+     * The fair queuing start tag of the request.
+     */
+    uint64_t tag;
+    /**
+     * Whether the request is still in its queue, as opposed to handed out by
+     * dequeue() and being imported.
+     */
+    bool queued{true};
+  };
+
+  /**
+   * Blob metadata batches use the limits of blobs.
+   */
+  ImportBatchSizer::Limits getBatchLimits(bool isTree) const;
+
   struct State {
     bool running = true;
-    std::vector<std::shared_ptr<HgImportRequest>> treeQueue;
-    std::vector<std::shared_ptr<HgImportRequest>> blobQueue;
+    ImportQueue treeQueue;
+    ImportQueue blobQueue;
+    ImportQueue blobMetaQueue;
+
+    ImportQueue& queueFor(const HgImportRequest& request);
 
     /**
      * Map of a ObjectId to an element in the queue. Any changes to this type
@@ -132,13 +274,20 @@ class HgImportRequestQueue {
      * it needs to be carefully studied and measured. The
      * benchmarks/hg_import_request_queue.cpp is a good way to measure the
      * potential performance impact.
+     *
+     * Only blob and tree requests are tracked, as a blob and its metadata
+     * share an ObjectId.
      */
-    folly::F14FastMap<ObjectId, std::shared_ptr<HgImportRequest>>
-        requestTracker;
+    folly::F14FastMap<ObjectId, TrackedImport> requestTracker;
   };
   std::shared_ptr<ReloadableConfig> config_;
-  folly::Synchronized<State, std::mutex> state_;
-  std::condition_variable queueCV_;
+  using StateMutex = ProfiledMutex<
+      std::mutex,
+      &LockThreadStats::hgImportQueueWait,
+      &LockThreadStats::hgImportQueueHold>;
+  folly::Synchronized<State, StateMutex> state_;
+  // Waits on a ProfiledMutex, so it can't be a std::condition_variable.
+  std::condition_variable_any queueCV_;
 };
 
 } // namespace facebook::eden
@@ -262,7 +262,47 @@ unique_ptr<Blob> HgImporter::importFileContents(
 
   // Ask the import helper process for the file contents
   auto requestID = sendFileRequest(path, blobHash);
+  return readFileResponse(requestID, path, blobHash);
+}
+
+std::vector<folly::Try<std::unique_ptr<Blob>>>
+HgImporter::importFileContentsBatch(
+    const std::vector<std::pair<RelativePathPiece, Hash20>>& files) {
+  XLOG(DBG5) << "requesting file contents of " << files.size() << " files";
+
+  std::vector<folly::Try<std::unique_ptr<Blob>>> results;
+  results.reserve(files.size());
+  // The helper answers in order, so the transaction ID of the response to
+  // files[i] is firstRequestID + i.
+  auto firstRequestID = nextRequestID_;
+  size_t sent = 0;
+  while (results.size() < files.size()) {
+    while (sent < files.size() &&
+           sent - results.size() < kMaxPipelinedRequests) {
+      sendFileRequest(files[sent].first, files[sent].second);
+      ++sent;
+    }
+
+    auto& [path, blobHash] = files[results.size()];
+    auto requestID =
+        firstRequestID + static_cast<TransactionID>(results.size());
+    try {
+      results.emplace_back(readFileResponse(requestID, path, blobHash));
+    } catch (const HgImportPyError& ex) {
+      // The error response was read entirely, so the channel is still in
+      // sync and the following responses can be read. Any other error
+      // leaves it in an unknown state and is propagated.
+      results.emplace_back(
+          folly::exception_wrapper{std::current_exception(), ex});
+    }
+  }
+  return results;
+}
 
+unique_ptr<Blob> HgImporter::readFileResponse(
+    TransactionID requestID,
+    RelativePathPiece path,
+    Hash20 blobHash) {
   // Read the response.  The response body contains the file contents,
   // which is exactly what we want to return.
   //
@@ -405,6 +445,57 @@ Hash20 HgImporter::resolveManifestNode(folly::StringPiece revName) {
   return Hash20(buffer);
 }
 
+std::vector<std::pair<Hash20, Hash20>> HgImporter::resolveManifestNodes(
+    folly::StringPiece revset) {
+  auto txnID = nextRequestID_++;
+  ChunkHeader header;
+  header.command = Endian::big<uint32_t>(CMD_MANIFEST_NODES_FOR_REVSET);
+  header.requestID = Endian::big<uint32_t>(txnID);
+  header.flags = 0;
+  header.dataLength = Endian::big<uint32_t>(folly::to_narrow(revset.size()));
+
+  std::array<struct iovec, 2> iov;
+  iov[0].iov_base = &header;
+  iov[0].iov_len = sizeof(header);
+  iov[1].iov_base = const_cast<char*>(revset.data());
+  iov[1].iov_len = revset.size();
+  writeToHelper(iov, "CMD_MANIFEST_NODES_FOR_REVSET");
+
+  auto response = readChunkHeader(txnID, "CMD_MANIFEST_NODES_FOR_REVSET");
+  constexpr size_t kEntrySize = 2 * Hash20::RAW_SIZE;
+  if (response.dataLength % kEntrySize != 0) {
+    // The body must still be consumed to keep the channel in sync.
+    std::vector<uint8_t> discard(response.dataLength);
+    readFromHelper(
+        discard.data(),
+        response.dataLength,
+        "CMD_MANIFEST_NODES_FOR_REVSET response body");
+    throw std::runtime_error(fmt::format(
+        "CMD_MANIFEST_NODES_FOR_REVSET response for '{}' has length {}, "
+        "which isn't a multiple of {}",
+        revset,
+        response.dataLength,
+        kEntrySize));
+  }
+
+  std::vector<std::pair<Hash20, Hash20>> result;
+  result.reserve(response.dataLength / kEntrySize);
+  for (size_t i = 0; i < response.dataLength / kEntrySize; ++i) {
+    Hash20::Storage commit;
+    Hash20::Storage manifest;
+    readFromHelper(
+        commit.data(),
+        folly::to_narrow(commit.size()),
+        "CMD_MANIFEST_NODES_FOR_REVSET response body");
+    readFromHelper(
+        manifest.data(),
+        folly::to_narrow(manifest.size()),
+        "CMD_MANIFEST_NODES_FOR_REVSET response body");
+    result.emplace_back(Hash20{commit}, Hash20{manifest});
+  }
+  return result;
+}
+
 HgImporter::ChunkHeader HgImporter::readChunkHeader(
     TransactionID txnID,
     StringPiece cmdName) {
@@ -644,6 +735,13 @@ Hash20 HgImporterManager::resolveManifestNode(StringPiece revName) {
   });
 }
 
+std::vector<std::pair<Hash20, Hash20>> HgImporterManager::resolveManifestNodes(
+    StringPiece revset) {
+  return retryOnError([&](HgImporter* importer) {
+    return importer->resolveManifestNodes(revset);
+  });
+}
+
 unique_ptr<Blob> HgImporterManager::importFileContents(
     RelativePathPiece path,
     Hash20 blobHash) {
@@ -652,6 +750,24 @@ unique_ptr<Blob> HgImporterManager::importFileContents(
   });
 }
 
+std::vector<folly::Try<std::unique_ptr<Blob>>>
+HgImporterManager::importFileContentsBatch(
+    const std::vector<std::pair<RelativePathPiece, Hash20>>& files) {
+  auto results = retryOnError([&](HgImporter* importer) {
+    return importer->importFileContentsBatch(files);
+  });
+  // Files whose import asked for the helper to be restarted are retried one
+  // at a time, which restarts it.
+  for (size_t i = 0; i < results.size(); ++i) {
+    auto* error = results[i].tryGetExceptionObject<HgImportPyError>();
+    if (error && error->errorType() == "ResetRepoError") {
+      results[i] = folly::makeTryWith(
+          [&] { return importFileContents(files[i].first, files[i].second); });
+    }
+  }
+  return results;
+}
+
 std::unique_ptr<IOBuf> HgImporterManager::fetchTree(
     RelativePathPiece path,
     Hash20 pathManifestNode) {
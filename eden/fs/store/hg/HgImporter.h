@@ -8,9 +8,12 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <folly/Try.h>
 #include <folly/portability/GFlags.h>
 #include <folly/portability/IOVec.h>
 #include <optional>
+#include <utility>
+#include <vector>
 
 #include "eden/fs/eden-config.h"
 #include "eden/fs/telemetry/EdenStats.h"
@@ -67,6 +70,14 @@ class Importer {
    */
   virtual Hash20 resolveManifestNode(folly::StringPiece revName) = 0;
 
+  /**
+   * Resolve the manifest nodes of all the commits of a revset.
+   *
+   * Returns (commit hash, manifest node) pairs.
+   */
+  virtual std::vector<std::pair<Hash20, Hash20>> resolveManifestNodes(
+      folly::StringPiece revset) = 0;
+
   /**
    * Import file information
    *
@@ -79,6 +90,16 @@ class Importer {
       RelativePathPiece path,
       Hash20 blobHash) = 0;
 
+  /**
+   * Import the contents of several files.
+   *
+   * Returns one result per file, in the same order. A file that the helper
+   * failed to import only fails its own result.
+   */
+  virtual std::vector<folly::Try<std::unique_ptr<Blob>>>
+  importFileContentsBatch(
+      const std::vector<std::pair<RelativePathPiece, Hash20>>& files) = 0;
+
   /**
    * Import tree and store it in the datapack
    *
@@ -123,15 +144,33 @@ class HgImporter : public Importer {
   ProcessStatus debugStopHelperProcess();
 
   Hash20 resolveManifestNode(folly::StringPiece revName) override;
+  std::vector<std::pair<Hash20, Hash20>> resolveManifestNodes(
+      folly::StringPiece revset) override;
   std::unique_ptr<Blob> importFileContents(
       RelativePathPiece path,
       Hash20 blobHash) override;
+  /**
+   * Requests are pipelined: up to kMaxPipelinedRequests of them are written
+   * to the helper before the response of the first one is read, so the
+   * helper never waits for us between two requests.
+   */
+  std::vector<folly::Try<std::unique_ptr<Blob>>> importFileContentsBatch(
+      const std::vector<std::pair<RelativePathPiece, Hash20>>& files)
+      override;
   std::unique_ptr<folly::IOBuf> fetchTree(
       RelativePathPiece path,
       Hash20 pathManifestNode) override;
 
   const ImporterOptions& getOptions() const;
 
+  /**
+   * How many CMD_CAT_FILE requests importFileContentsBatch() keeps in
+   * flight. The helper blocks writing responses while we write requests,
+   * so the in-flight requests must fit in the pipe buffer (64KB on Linux)
+   * even for paths of PATH_MAX bytes.
+   */
+  static constexpr size_t kMaxPipelinedRequests = 8;
+
  private:
   /**
    * Chunk header flags.
@@ -180,6 +219,7 @@ class HgImporter : public Importer {
     CMD_CAT_FILE = 7,
     CMD_GET_FILE_SIZE = 8,
     CMD_CAT_TREE = 9,
+    CMD_MANIFEST_NODES_FOR_REVSET = 11,
   };
   using TransactionID = uint32_t;
   struct ChunkHeader {
@@ -239,6 +279,13 @@ class HgImporter : public Importer {
    * of the given file at the specified file revision.
    */
   TransactionID sendFileRequest(RelativePathPiece path, Hash20 fileRevHash);
+  /**
+   * Read the response to a request sent by sendFileRequest().
+   */
+  std::unique_ptr<Blob> readFileResponse(
+      TransactionID requestID,
+      RelativePathPiece path,
+      Hash20 blobHash);
   /**
    * Send a request to the helper process, asking it to send us the
    * manifest node (NOT the full manifest!) for the specified revision.
@@ -297,10 +344,15 @@ class HgImporterManager : public Importer {
       std::optional<AbsolutePath> importHelperScript = std::nullopt);
 
   Hash20 resolveManifestNode(folly::StringPiece revName) override;
+  std::vector<std::pair<Hash20, Hash20>> resolveManifestNodes(
+      folly::StringPiece revset) override;
 
   std::unique_ptr<Blob> importFileContents(
       RelativePathPiece path,
       Hash20 blobHash) override;
+  std::vector<folly::Try<std::unique_ptr<Blob>>> importFileContentsBatch(
+      const std::vector<std::pair<RelativePathPiece, Hash20>>& files)
+      override;
   std::unique_ptr<folly::IOBuf> fetchTree(
       RelativePathPiece path,
       Hash20 pathManifestNode) override;
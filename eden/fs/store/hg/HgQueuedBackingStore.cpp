@@ -8,15 +8,20 @@
 #include "eden/fs/store/hg/HgQueuedBackingStore.h"
 
 #include <chrono>
+#include <deque>
 #include <thread>
 #include <utility>
 #include <variant>
 
 #include <re2/re2.h>
 
+#include <folly/CancellationToken.h>
+#include <folly/Random.h>
 #include <folly/Range.h>
+#include <folly/executors/InlineExecutor.h>
 #include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
+#include <folly/stop_watch.h>
 #include <folly/system/ThreadName.h>
 #include <gflags/gflags.h>
 
@@ -50,6 +55,10 @@ static_assert(CheckSize<HgImportTraceEvent, 56>());
 // 10 MB overhead per backing repo is tolerable.
 static_assert(
     CheckEqual<5600000, kTraceBusCapacity * sizeof(HgImportTraceEvent)>());
+
+// While hgcache lookups are over budget, only one in this many is done on
+// the calling thread.
+constexpr uint64_t kLocalProbeSampleInterval = 16;
 } // namespace
 
 HgImportTraceEvent::HgImportTraceEvent(
@@ -77,11 +86,16 @@ HgQueuedBackingStore::HgQueuedBackingStore(
     : localStore_(std::move(localStore)),
       stats_(std::move(stats)),
       config_(config),
+      fetchedDirectories_{
+          config_->getEdenConfig()->predictivePrefetchHistorySize.getValue()},
       backingStore_(std::move(backingStore)),
       queue_(std::move(config)),
       structuredLogger_{std::move(structuredLogger)},
       logger_(std::move(logger)),
-      traceBus_{TraceBus<HgImportTraceEvent>::create("hg", kTraceBusCapacity)} {
+      traceBus_{TraceBus<HgImportTraceEvent>::create(
+          "hg",
+          kTraceBusCapacity,
+          TraceBus<HgImportTraceEvent>::OverflowPolicy::Drop)} {
   uint8_t numberThreads =
       config_->getEdenConfig()->numBackingstoreThreads.getValue();
   if (!numberThreads) {
@@ -102,26 +116,77 @@ HgQueuedBackingStore::~HgQueuedBackingStore() {
   }
 }
 
-void HgQueuedBackingStore::processBlobImportRequests(
-    std::vector<std::shared_ptr<HgImportRequest>>&& requests) {
-  folly::stop_watch<std::chrono::milliseconds> watch;
-
+void HgQueuedBackingStore::startBlobImports(
+    const std::vector<std::shared_ptr<HgImportRequest>>& requests) {
   XLOG(DBG4) << "Processing blob import batch size=" << requests.size();
 
   for (auto& request : requests) {
     auto* blobImport = request->getRequest<HgImportRequest::BlobImport>();
 
-    traceBus_->publish(HgImportTraceEvent::start(
-        request->getUnique(), HgImportTraceEvent::BLOB, blobImport->proxyHash));
+    recordImportStart(
+        *request, HgImportTraceEvent::BLOB, blobImport->proxyHash);
 
     XLOGF(DBG4, "Processing blob request for {}", blobImport->hash);
   }
+}
+
+void HgQueuedBackingStore::processBlobImportRequests(
+    std::vector<std::shared_ptr<HgImportRequest>>&& requests) {
+  folly::stop_watch<std::chrono::milliseconds> watch;
+  startBlobImports(requests);
+
+  folly::stop_watch<std::chrono::microseconds> fetchWatch;
+  backingStore_->getDatapackStore().getBlobBatch(
+      requests,
+      [&](const HgImportRequest& request,
+          std::chrono::microseconds deserialize) {
+        recordImportFetch(
+            request,
+            HgImportTraceEvent::BLOB,
+            request.getRequest<HgImportRequest::BlobImport>()->proxyHash,
+            fetchWatch.elapsed() - deserialize,
+            deserialize);
+      });
 
-  backingStore_->getDatapackStore().getBlobBatch(requests);
+  importMissingBlobs(std::move(requests), watch);
+}
+
+folly::Future<folly::Unit>
+HgQueuedBackingStore::processBlobImportRequestsAsync(
+    std::vector<std::shared_ptr<HgImportRequest>>&& requests) {
+  folly::stop_watch<std::chrono::milliseconds> watch;
+  startBlobImports(requests);
+
+  folly::stop_watch<std::chrono::microseconds> fetchWatch;
+  auto fetched = backingStore_->getDatapackStore().getBlobBatchAsync(
+      requests,
+      [this, fetchWatch](
+          const HgImportRequest& request,
+          std::chrono::microseconds deserialize) {
+        recordImportFetch(
+            request,
+            HgImportTraceEvent::BLOB,
+            request.getRequest<HgImportRequest::BlobImport>()->proxyHash,
+            fetchWatch.elapsed() - deserialize,
+            deserialize);
+      });
 
+  // Inline, so that the thread which read the batch imports what it missed,
+  // leaving this one free to take the next batch.
+  return std::move(fetched)
+      .via(&folly::InlineExecutor::instance())
+      .thenValue([this, requests = std::move(requests), watch](
+                     folly::Unit) mutable {
+        importMissingBlobs(std::move(requests), watch);
+      });
+}
+
+void HgQueuedBackingStore::importMissingBlobs(
+    std::vector<std::shared_ptr<HgImportRequest>>&& requests,
+    folly::stop_watch<std::chrono::milliseconds> watch) {
   {
-    std::vector<folly::SemiFuture<folly::Unit>> futures;
-    futures.reserve(requests.size());
+    std::vector<std::shared_ptr<HgImportRequest>> missing;
+    std::vector<HgProxyHash> missingHashes;
 
     for (auto& request : requests) {
       auto* promise = request->getPromise<std::unique_ptr<Blob>>();
@@ -134,17 +199,36 @@ void HgQueuedBackingStore::processBlobImportRequests(
       // The blobs were either not found locally, or, when EdenAPI is enabled,
       // not found on the server. Let's import the blob through the hg importer.
       // TODO(xavierd): remove when EdenAPI has been rolled out everywhere.
-      auto fetchSemiFuture = backingStore_->fetchBlobFromHgImporter(
-          request->getRequest<HgImportRequest::BlobImport>()->proxyHash);
+      auto& proxyHash =
+          request->getRequest<HgImportRequest::BlobImport>()->proxyHash;
+      traceBus_->publish(HgImportTraceEvent::fallback(
+          request->getUnique(), HgImportTraceEvent::BLOB, proxyHash));
+      missingHashes.push_back(proxyHash);
+      missing.push_back(std::move(request));
+    }
+
+    folly::stop_watch<std::chrono::microseconds> importerWatch;
+    auto fetchSemiFutures =
+        backingStore_->fetchBlobsFromHgImporter(std::move(missingHashes));
+
+    std::vector<folly::SemiFuture<folly::Unit>> futures;
+    futures.reserve(missing.size());
+    for (size_t i = 0; i < missing.size(); ++i) {
       futures.emplace_back(
-          std::move(fetchSemiFuture)
-              .defer([request = std::move(request), watch, stats = stats_](
-                         auto&& result) mutable {
+          std::move(fetchSemiFutures[i])
+              .defer([request = std::move(missing[i]),
+                      watch,
+                      importerWatch,
+                      stats = stats_](auto&& result) mutable {
                 XLOG(DBG4)
                     << "Imported blob from HgImporter for "
                     << request->getRequest<HgImportRequest::BlobImport>()->hash;
-                stats->getHgBackingStoreStatsForCurrentThread()
-                    .hgBackingStoreGetBlob.addValue(watch.elapsed().count());
+                auto& threadStats =
+                    stats->getHgBackingStoreStatsForCurrentThread();
+                threadStats.importerFetch.addValue(
+                    importerWatch.elapsed().count());
+                threadStats.hgBackingStoreGetBlob.addValue(
+                    watch.elapsed().count());
                 request->getPromise<HgImportRequest::BlobImport::Response>()
                     ->setTry(std::forward<decltype(result)>(result));
               }));
@@ -161,15 +245,32 @@ void HgQueuedBackingStore::processTreeImportRequests(
   for (auto& request : requests) {
     auto* treeImport = request->getRequest<HgImportRequest::TreeImport>();
 
-    traceBus_->publish(HgImportTraceEvent::start(
-        request->getUnique(), HgImportTraceEvent::TREE, treeImport->proxyHash));
+    recordImportStart(
+        *request, HgImportTraceEvent::TREE, treeImport->proxyHash);
 
     XLOGF(DBG4, "Processing tree request for {}", treeImport->hash);
   }
 
   {
     auto writeBatch = localStore_->beginWrite();
-    backingStore_->getDatapackStore().getTreeBatch(requests, writeBatch.get());
+    folly::stop_watch<std::chrono::microseconds> fetchWatch;
+    backingStore_->getDatapackStore().getTreeBatch(
+        requests,
+        writeBatch.get(),
+        [&](const HgImportRequest& request,
+            std::chrono::microseconds deserialize) {
+          recordImportFetch(
+              request,
+              HgImportTraceEvent::TREE,
+              request.getRequest<HgImportRequest::TreeImport>()->proxyHash,
+              fetchWatch.elapsed() - deserialize,
+              deserialize);
+        });
+
+    folly::stop_watch<std::chrono::microseconds> writeWatch;
+    writeBatch->flush();
+    stats_->getHgBackingStoreStatsForCurrentThread().localStoreWrite.addValue(
+        writeWatch.elapsed().count());
   }
 
   {
@@ -188,16 +289,27 @@ void HgQueuedBackingStore::processTreeImportRequests(
       // not found on the server. Let's import the trees through the hg
       // importer.
       // TODO(xavierd): remove when EdenAPI has been rolled out everywhere.
+      traceBus_->publish(HgImportTraceEvent::fallback(
+          request->getUnique(),
+          HgImportTraceEvent::TREE,
+          request->getRequest<HgImportRequest::TreeImport>()->proxyHash));
+      folly::stop_watch<std::chrono::microseconds> importerWatch;
       auto treeSemiFuture = backingStore_->getTree(request);
       futures.emplace_back(
           std::move(treeSemiFuture)
-              .defer([request = std::move(request), watch, stats = stats_](
-                         auto&& result) mutable {
+              .defer([request = std::move(request),
+                      watch,
+                      importerWatch,
+                      stats = stats_](auto&& result) mutable {
                 XLOG(DBG4)
                     << "Imported tree from HgImporter for "
                     << request->getRequest<HgImportRequest::TreeImport>()->hash;
-                stats->getHgBackingStoreStatsForCurrentThread()
-                    .hgBackingStoreGetTree.addValue(watch.elapsed().count());
+                auto& threadStats =
+                    stats->getHgBackingStoreStatsForCurrentThread();
+                threadStats.importerFetch.addValue(
+                    importerWatch.elapsed().count());
+                threadStats.hgBackingStoreGetTree.addValue(
+                    watch.elapsed().count());
                 request->getPromise<HgImportRequest::TreeImport::Response>()
                     ->setTry(std::forward<decltype(result)>(result));
               }));
@@ -207,8 +319,67 @@ void HgQueuedBackingStore::processTreeImportRequests(
   }
 }
 
+void HgQueuedBackingStore::processBlobMetaImportRequests(
+    std::vector<std::shared_ptr<HgImportRequest>>&& requests) {
+  XLOG(DBG4) << "Processing blob metadata import batch size="
+             << requests.size();
+
+  for (auto& request : requests) {
+    auto* blobMetaImport =
+        request->getRequest<HgImportRequest::BlobMetaImport>();
+
+    recordImportStart(
+        *request, HgImportTraceEvent::BLOBMETA, blobMetaImport->proxyHash);
+
+    XLOGF(
+        DBG4,
+        "Processing blob metadata request for {}",
+        blobMetaImport->hash);
+  }
+
+  backingStore_->getDatapackStore().getBlobMetadataBatch(requests);
+
+  for (auto& request : requests) {
+    auto* promise = request->getPromise<std::unique_ptr<BlobMetadata>>();
+    if (!promise->isFulfilled()) {
+      // Not worth importing through the hg importer: the caller falls back
+      // to fetching the blob, which does.
+      promise->setValue(nullptr);
+    }
+  }
+}
+
+void HgQueuedBackingStore::recordImportStart(
+    const HgImportRequest& request,
+    HgImportTraceEvent::ResourceType resourceType,
+    const HgProxyHash& proxyHash) {
+  traceBus_->publish(HgImportTraceEvent::start(
+      request.getUnique(), resourceType, proxyHash));
+
+  auto queueWait = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - request.getRequestTime());
+  stats_->getHgBackingStoreStatsForCurrentThread().queueWait.addValue(
+      queueWait.count());
+}
+
+void HgQueuedBackingStore::recordImportFetch(
+    const HgImportRequest& request,
+    HgImportTraceEvent::ResourceType resourceType,
+    const HgProxyHash& proxyHash,
+    std::chrono::microseconds fetch,
+    std::chrono::microseconds deserialize) {
+  traceBus_->publish(HgImportTraceEvent::fetch(
+      request.getUnique(), resourceType, proxyHash));
+
+  auto& threadStats = stats_->getHgBackingStoreStatsForCurrentThread();
+  threadStats.datapackFetch.addValue(fetch.count());
+  threadStats.deserialize.addValue(deserialize.count());
+}
+
 void HgQueuedBackingStore::processRequest() {
   folly::setThreadName("hgqueue");
+  // The blob batches of this thread still being imported, oldest first.
+  std::deque<folly::Future<folly::Unit>> blobBatches;
   for (;;) {
     auto requests = queue_.dequeue();
 
@@ -216,13 +387,41 @@ void HgQueuedBackingStore::processRequest() {
       break;
     }
 
-    const auto& first = requests.at(0);
+    auto first = requests.at(0);
+    auto batchSize = requests.size();
+    folly::stop_watch<std::chrono::microseconds> watch;
 
     if (first->isType<HgImportRequest::BlobImport>()) {
+      auto maxInFlight =
+          config_->getEdenConfig()->importBlobBatchesInFlight.getValue();
+      if (maxInFlight > 1) {
+        blobBatches.push_back(
+            processBlobImportRequestsAsync(std::move(requests))
+                .thenValue([this, first, batchSize, watch](folly::Unit) {
+                  queue_.recordBatchDuration(
+                      *first, batchSize, watch.elapsed());
+                }));
+        // Batches that already finished are dropped along the way.
+        while (!blobBatches.empty() &&
+               (blobBatches.size() >= maxInFlight ||
+                blobBatches.front().isReady())) {
+          std::move(blobBatches.front()).get();
+          blobBatches.pop_front();
+        }
+        continue;
+      }
       processBlobImportRequests(std::move(requests));
     } else if (first->isType<HgImportRequest::TreeImport>()) {
       processTreeImportRequests(std::move(requests));
+    } else if (first->isType<HgImportRequest::BlobMetaImport>()) {
+      processBlobMetaImportRequests(std::move(requests));
     }
+
+    queue_.recordBatchDuration(*first, batchSize, watch.elapsed());
+  }
+
+  for (auto& blobBatch : blobBatches) {
+    std::move(blobBatch).get();
   }
 }
 
@@ -303,12 +502,17 @@ folly::SemiFuture<BackingStore::GetTreeRes> HgQueuedBackingStore::getTree(
       folly::Range{&proxyHash, 1},
       ObjectFetchContext::ObjectType::Tree);
 
-  if (auto tree = backingStore_->getDatapackStore().getTreeLocal(
-          id, proxyHash, *localStore_)) {
-    XLOG(DBG5) << "imported tree of '" << proxyHash.path() << "', "
-               << proxyHash.revHash().toString() << " from hgcache";
-    return folly::makeSemiFuture(BackingStore::GetTreeRes{
-        std::move(tree), ObjectFetchContext::Origin::FromDiskCache});
+  if (shouldProbeLocally()) {
+    folly::stop_watch<std::chrono::microseconds> watch;
+    auto tree = backingStore_->getDatapackStore().getTreeLocal(
+        id, proxyHash, *localStore_);
+    recordLocalProbe(watch.elapsed());
+    if (tree) {
+      XLOG(DBG5) << "imported tree of '" << proxyHash.path() << "', "
+                 << proxyHash.revHash().toString() << " from hgcache";
+      return folly::makeSemiFuture(BackingStore::GetTreeRes{
+          std::move(tree), ObjectFetchContext::Origin::FromDiskCache});
+    }
   }
 
   return getTreeImpl(id, proxyHash, context);
@@ -329,13 +533,58 @@ std::unique_ptr<BlobMetadata> HgQueuedBackingStore::getLocalBlobMetadata(
       proxyHash.revHash());
 }
 
+folly::SemiFuture<std::unique_ptr<BlobMetadata>>
+HgQueuedBackingStore::getBlobMetadata(
+    const ObjectId& id,
+    ObjectFetchContext& context) {
+  HgProxyHash proxyHash;
+  try {
+    proxyHash = HgProxyHash::load(localStore_.get(), id, "getBlobMetadata");
+  } catch (const std::exception&) {
+    logMissingProxyHash();
+    throw;
+  }
+
+  XLOG(DBG4) << "make blob metadata import request for " << proxyHash.path()
+             << ", hash is:" << id;
+
+  auto request = HgImportRequest::makeBlobMetaImportRequest(
+      id,
+      proxyHash,
+      context.getPriority(),
+      context.getCancellationToken(),
+      context.getClientPid());
+  auto unique = request->getUnique();
+
+  traceBus_->publish(HgImportTraceEvent::queue(
+      unique, HgImportTraceEvent::BLOBMETA, proxyHash));
+
+  return queue_.enqueueBlobMeta(std::move(request))
+      .thenTry([this, unique, proxyHash](
+                   folly::Try<std::unique_ptr<BlobMetadata>>&& result) {
+        if (result.hasException<folly::OperationCancelled>()) {
+          traceBus_->publish(HgImportTraceEvent::cancel(
+              unique, HgImportTraceEvent::BLOBMETA, proxyHash));
+        } else {
+          traceBus_->publish(HgImportTraceEvent::finish(
+              unique, HgImportTraceEvent::BLOBMETA, proxyHash));
+        }
+        return std::move(result).value();
+      })
+      .semi();
+}
+
 folly::SemiFuture<BackingStore::GetTreeRes> HgQueuedBackingStore::getTreeImpl(
     const ObjectId& id,
     const HgProxyHash& proxyHash,
     ObjectFetchContext& context) {
   auto getTreeFuture = folly::makeFutureWith([&] {
     auto request = HgImportRequest::makeTreeImportRequest(
-        id, proxyHash, context.getPriority());
+        id,
+        proxyHash,
+        context.getPriority(),
+        context.getCancellationToken(),
+        context.getClientPid());
     uint64_t unique = request->getUnique();
 
     auto importTracker =
@@ -344,12 +593,19 @@ folly::SemiFuture<BackingStore::GetTreeRes> HgQueuedBackingStore::getTreeImpl(
         HgImportTraceEvent::queue(unique, HgImportTraceEvent::TREE, proxyHash));
 
     return queue_.enqueueTree(std::move(request))
-        .ensure([this,
-                 unique,
-                 proxyHash,
-                 importTracker = std::move(importTracker)]() {
-          traceBus_->publish(HgImportTraceEvent::finish(
-              unique, HgImportTraceEvent::TREE, proxyHash));
+        .thenTry([this,
+                  unique,
+                  proxyHash,
+                  importTracker = std::move(importTracker)](
+                     folly::Try<std::unique_ptr<Tree>>&& result) {
+          if (result.hasException<folly::OperationCancelled>()) {
+            traceBus_->publish(HgImportTraceEvent::cancel(
+                unique, HgImportTraceEvent::TREE, proxyHash));
+          } else {
+            traceBus_->publish(HgImportTraceEvent::finish(
+                unique, HgImportTraceEvent::TREE, proxyHash));
+          }
+          return std::move(result).value();
         });
   });
 
@@ -378,10 +634,14 @@ folly::SemiFuture<BackingStore::GetBlobRes> HgQueuedBackingStore::getBlob(
       folly::Range{&proxyHash, 1},
       ObjectFetchContext::ObjectType::Blob);
 
-  if (auto blob =
-          backingStore_->getDatapackStore().getBlobLocal(id, proxyHash)) {
-    return folly::makeSemiFuture(BackingStore::GetBlobRes{
-        std::move(blob), ObjectFetchContext::Origin::FromDiskCache});
+  if (shouldProbeLocally()) {
+    folly::stop_watch<std::chrono::microseconds> watch;
+    auto blob = backingStore_->getDatapackStore().getBlobLocal(id, proxyHash);
+    recordLocalProbe(watch.elapsed());
+    if (blob) {
+      return folly::makeSemiFuture(BackingStore::GetBlobRes{
+          std::move(blob), ObjectFetchContext::Origin::FromDiskCache});
+    }
   }
 
   return getBlobImpl(id, proxyHash, context);
@@ -396,7 +656,11 @@ folly::SemiFuture<BackingStore::GetBlobRes> HgQueuedBackingStore::getBlobImpl(
                << ", hash is:" << id;
 
     auto request = HgImportRequest::makeBlobImportRequest(
-        id, proxyHash, context.getPriority());
+        id,
+        proxyHash,
+        context.getPriority(),
+        context.getCancellationToken(),
+        context.getClientPid());
     auto unique = request->getUnique();
 
     auto importTracker =
@@ -405,12 +669,19 @@ folly::SemiFuture<BackingStore::GetBlobRes> HgQueuedBackingStore::getBlobImpl(
         HgImportTraceEvent::queue(unique, HgImportTraceEvent::BLOB, proxyHash));
 
     return queue_.enqueueBlob(std::move(request))
-        .ensure([this,
-                 unique,
-                 proxyHash,
-                 importTracker = std::move(importTracker)]() {
-          traceBus_->publish(HgImportTraceEvent::finish(
-              unique, HgImportTraceEvent::BLOB, proxyHash));
+        .thenTry([this,
+                  unique,
+                  proxyHash,
+                  importTracker = std::move(importTracker)](
+                     folly::Try<std::unique_ptr<Blob>>&& result) {
+          if (result.hasException<folly::OperationCancelled>()) {
+            traceBus_->publish(HgImportTraceEvent::cancel(
+                unique, HgImportTraceEvent::BLOB, proxyHash));
+          } else {
+            traceBus_->publish(HgImportTraceEvent::finish(
+                unique, HgImportTraceEvent::BLOB, proxyHash));
+          }
+          return std::move(result).value();
         });
   });
 
@@ -470,6 +741,49 @@ folly::SemiFuture<folly::Unit> HgQueuedBackingStore::prefetchBlobs(
       });
 }
 
+std::optional<ObjectId> HgQueuedBackingStore::migrateObjectId(
+    const ObjectId& id) {
+  auto config = config_->getEdenConfig();
+  auto format = config->hgObjectIdFormat.getValue();
+  if (format == HgObjectIdFormat::ProxyHash ||
+      !config->hgMigrateProxyHashes.getValue() ||
+      HgProxyHash::tryParseEmbeddedProxyHash(id)) {
+    return std::nullopt;
+  }
+
+  try {
+    auto proxyHash =
+        HgProxyHash::load(localStore_.get(), id, "migrateObjectId");
+    return HgProxyHash::store(
+        proxyHash.path(), proxyHash.revHash(), format, nullptr);
+  } catch (const std::exception& ex) {
+    // Keep the legacy ID: fetching it will report the missing proxy hash.
+    XLOG(WARN) << "unable to migrate proxy hash " << id << ": " << ex.what();
+    return std::nullopt;
+  }
+}
+
+bool HgQueuedBackingStore::shouldProbeLocally() {
+  auto budget = std::chrono::duration_cast<std::chrono::microseconds>(
+      config_->getValue(&EdenConfig::hgLocalProbeBudget));
+  if (localProbeAverageUs_.load(std::memory_order_relaxed) <= budget.count()) {
+    return true;
+  }
+  // Keep doing the occasional lookup so that the average recovers once
+  // hgcache is fast again.
+  return localProbesOverBudget_.fetch_add(1, std::memory_order_relaxed) %
+      kLocalProbeSampleInterval ==
+      0;
+}
+
+void HgQueuedBackingStore::recordLocalProbe(
+    std::chrono::microseconds elapsed) {
+  // Concurrent updates may lose a sample, which is fine for an average.
+  auto average = localProbeAverageUs_.load(std::memory_order_relaxed);
+  localProbeAverageUs_.store(
+      (average * 7 + elapsed.count()) / 8, std::memory_order_relaxed);
+}
+
 void HgQueuedBackingStore::logMissingProxyHash() {
   auto now = std::chrono::steady_clock::now();
 
@@ -493,11 +807,16 @@ void HgQueuedBackingStore::logBackingStoreFetch(
     ObjectFetchContext& context,
     folly::Range<HgProxyHash*> hashes,
     ObjectFetchContext::ObjectType type) {
-  const auto& logFetchPathRegex =
-      config_->getEdenConfig()->logObjectFetchPathRegex.getValue();
+  auto config = config_->getEdenConfig();
+  const auto& logFetchPathRegex = config->logObjectFetchPathRegex.getValue();
 
   if (logFetchPathRegex) {
+    auto sampleDenominator = config->logObjectFetchSampleDenominator.getValue();
     for (const auto& hash : hashes) {
+      if (sampleDenominator > 1 &&
+          0 != folly::Random::rand32(sampleDenominator)) {
+        continue;
+      }
       auto path = hash.path();
       auto pathPiece = path.stringPiece();
 
@@ -510,11 +829,15 @@ void HgQueuedBackingStore::logBackingStoreFetch(
   }
 
   if (type != ObjectFetchContext::ObjectType::Tree &&
-      isRecordingFetch_.load(std::memory_order_relaxed) &&
       context.getCause() != ObjectFetchContext::Cause::Prefetch) {
-    auto guard = fetchedFilePaths_.wlock();
     for (const auto& hash : hashes) {
-      guard->emplace(hash.path().stringPiece().str());
+      fetchedDirectories_.recordFileFetch(hash.path());
+    }
+    if (isRecordingFetch_.load(std::memory_order_relaxed)) {
+      auto guard = fetchedFilePaths_.wlock();
+      for (const auto& hash : hashes) {
+        guard->emplace(hash.path().stringPiece().str());
+      }
     }
   }
 }
@@ -567,6 +890,11 @@ std::unordered_set<std::string> HgQueuedBackingStore::stopRecordingFetch() {
   return paths;
 }
 
+std::vector<RelativePath> HgQueuedBackingStore::getMostFetchedDirectories(
+    size_t count) {
+  return fetchedDirectories_.getTopDirectories(count);
+}
+
 folly::SemiFuture<folly::Unit> HgQueuedBackingStore::importManifestForRoot(
     const RootId& root,
     const Hash20& manifest) {
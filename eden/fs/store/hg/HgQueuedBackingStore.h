@@ -9,13 +9,18 @@
 
 #include <folly/Range.h>
 #include <folly/Synchronized.h>
+#include <folly/futures/Future.h>
+#include <folly/stop_watch.h>
 #include <sys/types.h>
 #include <atomic>
+#include <chrono>
+#include <map>
 #include <memory>
 #include <vector>
 
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/store/BackingStore.h"
+#include "eden/fs/store/FetchedDirectoryHistory.h"
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/store/hg/HgBackingStore.h"
 #include "eden/fs/store/hg/HgImportRequestQueue.h"
@@ -36,12 +41,28 @@ struct HgImportTraceEvent : TraceEventBase {
   enum EventType : uint8_t {
     QUEUE,
     START,
+    /**
+     * The data was read from hgcache or EdenAPI and converted to a Blob or
+     * Tree, and is about to be handed to the callers.
+     */
+    FETCH,
+    /**
+     * The object was not found in hgcache or EdenAPI and is being imported
+     * through the hg importer.
+     */
+    FALLBACK,
     FINISH,
+    /**
+     * The import was dropped before it started, because every caller
+     * waiting on it gave up. Ends the request like FINISH.
+     */
+    CANCEL,
   };
 
   enum ResourceType : uint8_t {
     BLOB,
     TREE,
+    BLOBMETA,
   };
 
   static HgImportTraceEvent queue(
@@ -58,6 +79,20 @@ struct HgImportTraceEvent : TraceEventBase {
     return HgImportTraceEvent{unique, START, resourceType, proxyHash};
   }
 
+  static HgImportTraceEvent fetch(
+      uint64_t unique,
+      ResourceType resourceType,
+      const HgProxyHash& proxyHash) {
+    return HgImportTraceEvent{unique, FETCH, resourceType, proxyHash};
+  }
+
+  static HgImportTraceEvent fallback(
+      uint64_t unique,
+      ResourceType resourceType,
+      const HgProxyHash& proxyHash) {
+    return HgImportTraceEvent{unique, FALLBACK, resourceType, proxyHash};
+  }
+
   static HgImportTraceEvent finish(
       uint64_t unique,
       ResourceType resourceType,
@@ -65,6 +100,13 @@ struct HgImportTraceEvent : TraceEventBase {
     return HgImportTraceEvent{unique, FINISH, resourceType, proxyHash};
   }
 
+  static HgImportTraceEvent cancel(
+      uint64_t unique,
+      ResourceType resourceType,
+      const HgProxyHash& proxyHash) {
+    return HgImportTraceEvent{unique, CANCEL, resourceType, proxyHash};
+  }
+
   HgImportTraceEvent(
       uint64_t unique,
       EventType eventType,
@@ -76,8 +118,9 @@ struct HgImportTraceEvent : TraceEventBase {
     return path.get();
   }
 
-  // Unique per request, but is consistent across the three stages of an import:
-  // queue, start, and finish. Used to correlate events to a request.
+  // Unique per request, but is consistent across the stages of an import:
+  // queue, start, fetch or fallback, and finish or cancel. Used to correlate
+  // events to a request.
   uint64_t unique;
   EventType eventType;
   ResourceType resourceType;
@@ -109,6 +152,15 @@ class HgQueuedBackingStore final : public BackingStore {
     return *traceBus_;
   }
 
+  /**
+   * The number of queued imports of each client process, see
+   * HgImportRequestQueue::getClientStats.
+   */
+  std::map<pid_t, HgImportRequestQueue::ClientStats> getImportClientStats()
+      const {
+    return queue_.getClientStats();
+  }
+
   RootId parseRootId(folly::StringPiece rootId) override;
   std::string renderRootId(const RootId& rootId) override;
   ObjectId parseObjectId(folly::StringPiece objectId) override {
@@ -158,6 +210,7 @@ class HgQueuedBackingStore final : public BackingStore {
 
   void startRecordingFetch() override;
   std::unordered_set<std::string> stopRecordingFetch() override;
+  std::vector<RelativePath> getMostFetchedDirectories(size_t count) override;
 
   folly::SemiFuture<folly::Unit> importManifestForRoot(
       const RootId& root,
@@ -169,6 +222,12 @@ class HgQueuedBackingStore final : public BackingStore {
     return backingStore_->getRepoName();
   }
 
+  /**
+   * Convert proxy hashes to the embedded format of hg:object-id-format when
+   * hg:migrate-proxy-hashes is set.
+   */
+  std::optional<ObjectId> migrateObjectId(const ObjectId& id) override;
+
   HgBackingStore& getHgBackingStore() {
     return *backingStore_;
   }
@@ -180,11 +239,45 @@ class HgQueuedBackingStore final : public BackingStore {
 
   void processBlobImportRequests(
       std::vector<std::shared_ptr<HgImportRequest>>&& requests);
+  /**
+   * Like processBlobImportRequests, but returns while hgcache and EdenAPI are
+   * still being read. The blobs they miss are then imported from the thread
+   * reading them.
+   */
+  folly::Future<folly::Unit> processBlobImportRequestsAsync(
+      std::vector<std::shared_ptr<HgImportRequest>>&& requests);
+  void startBlobImports(
+      const std::vector<std::shared_ptr<HgImportRequest>>& requests);
+  void importMissingBlobs(
+      std::vector<std::shared_ptr<HgImportRequest>>&& requests,
+      folly::stop_watch<std::chrono::milliseconds> watch);
   void processTreeImportRequests(
       std::vector<std::shared_ptr<HgImportRequest>>&& requests);
+  void processBlobMetaImportRequests(
+      std::vector<std::shared_ptr<HgImportRequest>>&& requests);
   void processPrefetchRequests(
       std::vector<std::shared_ptr<HgImportRequest>>&& requests);
 
+  /**
+   * Publish the START event of a request taken out of the queue, and record
+   * how long it waited there.
+   */
+  void recordImportStart(
+      const HgImportRequest& request,
+      HgImportTraceEvent::ResourceType resourceType,
+      const HgProxyHash& proxyHash);
+
+  /**
+   * Publish the FETCH event of a request found in hgcache or EdenAPI, and
+   * record the time spent fetching and converting its data.
+   */
+  void recordImportFetch(
+      const HgImportRequest& request,
+      HgImportTraceEvent::ResourceType resourceType,
+      const HgProxyHash& proxyHash,
+      std::chrono::microseconds fetch,
+      std::chrono::microseconds deserialize);
+
   /**
    * The worker runloop function.
    */
@@ -208,6 +301,14 @@ class HgQueuedBackingStore final : public BackingStore {
       const ObjectId& id,
       ObjectFetchContext& context) override;
 
+  /**
+   * Queue a fetch of the aux data of the blob from hgcache or EdenAPI.
+   * Returns nullptr if neither has it.
+   */
+  folly::SemiFuture<std::unique_ptr<BlobMetadata>> getBlobMetadata(
+      const ObjectId& id,
+      ObjectFetchContext& context) override;
+
   /**
    * Fetch a tree from Mercurial.
    *
@@ -220,6 +321,17 @@ class HgQueuedBackingStore final : public BackingStore {
       const HgProxyHash& proxyHash,
       ObjectFetchContext& context);
 
+  /**
+   * Whether getBlob and getTree should look for the object in hgcache before
+   * queueing an import, see EdenConfig::hgLocalProbeBudget.
+   */
+  bool shouldProbeLocally();
+
+  /**
+   * Record how long a lookup in hgcache from getBlob or getTree took.
+   */
+  void recordLocalProbe(std::chrono::microseconds elapsed);
+
   /**
    * Logs a backing store fetch to scuba if the path being fetched is in the
    * configured paths to log. The path is derived from the proxy hash.
@@ -270,6 +382,12 @@ class HgQueuedBackingStore final : public BackingStore {
    */
   std::shared_ptr<ReloadableConfig> config_;
 
+  /**
+   * The directories of the files fetched for anything but prefetches, always
+   * recorded unlike fetchedFilePaths_.
+   */
+  FetchedDirectoryHistory fetchedDirectories_;
+
   std::unique_ptr<HgBackingStore> backingStore_;
 
   /**
@@ -296,6 +414,12 @@ class HgQueuedBackingStore final : public BackingStore {
   folly::Synchronized<std::chrono::steady_clock::time_point>
       lastMissingProxyHashLog_;
 
+  // Moving average of the duration of the hgcache lookups done by getBlob
+  // and getTree, in microseconds.
+  std::atomic<int64_t> localProbeAverageUs_{0};
+  // How many lookups were considered while over the budget.
+  std::atomic<uint64_t> localProbesOverBudget_{0};
+
   // Track metrics for queued imports
   mutable RequestMetricsScope::LockedRequestWatchList pendingImportBlobWatches_;
   mutable RequestMetricsScope::LockedRequestWatchList pendingImportTreeWatches_;
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/hg/ImportBatchSizer.h"
+
+#include <algorithm>
+
+namespace facebook::eden {
+
+size_t ImportBatchSizer::currentLimit(const Limits& limits) const {
+  auto limit = limit_ ? limit_ : limits.maxSize;
+  return std::clamp(limit, limits.minSize, limits.maxSize);
+}
+
+size_t ImportBatchSizer::getBatchSize(
+    size_t queueDepth,
+    size_t workers,
+    const Limits& limits) const {
+  if (limits.maxSize <= limits.minSize) {
+    return limits.minSize;
+  }
+  // Split the queue evenly between the workers rather than letting the first
+  // one take it all.
+  workers = std::max<size_t>(workers, 1);
+  auto share = (queueDepth + workers - 1) / workers;
+  return std::clamp(share, limits.minSize, currentLimit(limits));
+}
+
+void ImportBatchSizer::recordBatch(
+    size_t size,
+    std::chrono::microseconds elapsed,
+    const Limits& limits) {
+  if (limits.maxSize <= limits.minSize) {
+    return;
+  }
+
+  if (size <= limits.minSize) {
+    roundTrip_ =
+        roundTrip_.count() == 0 ? elapsed : (roundTrip_ * 7 + elapsed) / 8;
+    return;
+  }
+
+  auto limit = currentLimit(limits);
+  if (elapsed > roundTrip_ + limits.targetLatency) {
+    limit = std::min(limit, size) / 2;
+  } else if (size >= limit) {
+    limit += std::max<size_t>(limit / 4, 1);
+  }
+  limit_ = std::clamp(limit, limits.minSize, limits.maxSize);
+}
+
+} // namespace facebook::eden
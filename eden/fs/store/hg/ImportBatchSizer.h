@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace facebook::eden {
+
+/**
+ * Picks the size of the import batches of one request type.
+ *
+ * Batching amortizes the round trip of a remote fetch over many objects,
+ * but a request at the end of a large batch waits for all the others. So
+ * batches only grow beyond the minimum when the queue is deep enough to
+ * give every worker thread a full batch, which keeps interactive reads of a
+ * single file in small batches and lets import storms use large ones.
+ *
+ * The maximum is adjusted from the observed latencies: the latency of
+ * minimum size batches estimates the round trip, and a batch that takes
+ * longer than the round trip plus the target latency halves the maximum,
+ * while a full batch that stays within it grows the maximum by a quarter.
+ *
+ * Not thread safe; HgImportRequestQueue only uses it with its lock held.
+ */
+class ImportBatchSizer {
+ public:
+  struct Limits {
+    /**
+     * Batches are never smaller than this, even when the queue is short.
+     * Adaptive sizing is disabled when maxSize is not larger.
+     */
+    size_t minSize;
+    size_t maxSize;
+    /**
+     * How much longer than a round trip a batch may take.
+     */
+    std::chrono::microseconds targetLatency;
+  };
+
+  /**
+   * Return how many requests the next batch should take out of queueDepth
+   * queued requests shared by workers threads.
+   */
+  size_t getBatchSize(size_t queueDepth, size_t workers, const Limits& limits)
+      const;
+
+  /**
+   * Record that a batch of size requests took elapsed to import.
+   */
+  void recordBatch(
+      size_t size,
+      std::chrono::microseconds elapsed,
+      const Limits& limits);
+
+  std::chrono::microseconds getRoundTripEstimate() const {
+    return roundTrip_;
+  }
+
+ private:
+  size_t currentLimit(const Limits& limits) const;
+
+  /**
+   * Moving average of the latency of minimum size batches.
+   */
+  std::chrono::microseconds roundTrip_{0};
+  /**
+   * The current maximum batch size, or 0 until the first large batch
+   * completes, in which case limits.maxSize is used.
+   */
+  size_t limit_{0};
+};
+
+} // namespace facebook::eden
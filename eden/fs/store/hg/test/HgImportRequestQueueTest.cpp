@@ -5,6 +5,7 @@
  * GNU General Public License version 2.
  */
 
+#include <folly/CancellationToken.h>
 #include <folly/Try.h>
 #include <folly/logging/xlog.h>
 #include <folly/portability/GTest.h>
@@ -556,3 +557,143 @@ TEST_F(HgImportRequestQueueTest, twoDuplicateRequestsDifferentPriority) {
         request->getRequest<HgImportRequest::BlobImport>()->hash, expBlob);
   }
 }
+
+TEST_F(HgImportRequestQueueTest, samePriorityIsFifo) {
+  auto queue = HgImportRequestQueue{edenConfig};
+  std::vector<ObjectId> enqueued;
+
+  for (int i = 0; i < 5; i++) {
+    enqueued.push_back(
+        insertBlobImportRequest(queue, ImportPriority::kNormal()));
+  }
+
+  for (const auto& expected : enqueued) {
+    auto request = queue.dequeue().at(0);
+    EXPECT_EQ(
+        expected, request->getRequest<HgImportRequest::BlobImport>()->hash);
+  }
+}
+
+TEST_F(HgImportRequestQueueTest, raisingPriorityInFlightDoesNotRequeue) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  auto proxyHash = HgProxyHash{RelativePath{"some_blob"}, uniqueHash()};
+  auto [hash, request] =
+      makeBlobImportRequestWithHash(ImportPriority::kLow(), proxyHash);
+  auto [hash2, request2] =
+      makeBlobImportRequestWithHash(ImportPriority::kHigh(), proxyHash);
+  auto [hash3, request3] =
+      makeBlobImportRequestWithHash(ImportPriority::kHigh(), proxyHash);
+
+  queue.enqueueBlob(std::move(request));
+  // Raise the priority while queued, then again once in flight.
+  queue.enqueueBlob(std::move(request2));
+  auto dequeued = queue.dequeue().at(0);
+  EXPECT_EQ(hash, dequeued->getRequest<HgImportRequest::BlobImport>()->hash);
+  queue.enqueueBlob(std::move(request3));
+
+  auto other = insertBlobImportRequest(queue, ImportPriority::kLow());
+  auto next = queue.dequeue().at(0);
+  EXPECT_EQ(other, next->getRequest<HgImportRequest::BlobImport>()->hash);
+
+  folly::Try<std::unique_ptr<Blob>> blob = folly::makeTryWith(
+      [hash = hash]() { return std::make_unique<Blob>(hash, folly::IOBuf{}); });
+  queue.markImportAsFinished<Blob>(hash, blob);
+  EXPECT_EQ(
+      2, dequeued->getRequest<HgImportRequest::BlobImport>()->promises.size());
+}
+
+TEST_F(HgImportRequestQueueTest, abandonedRequestsAreNotDequeued) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  folly::CancellationSource source;
+  auto proxyHash = HgProxyHash{RelativePath{"some_blob"}, uniqueHash()};
+  auto hash = proxyHash.sha1();
+  auto future = queue.enqueueBlob(HgImportRequest::makeBlobImportRequest(
+      hash, proxyHash, ImportPriority::kHigh(), source.getToken()));
+  auto duplicate = queue.enqueueBlob(HgImportRequest::makeBlobImportRequest(
+      hash, proxyHash, ImportPriority::kHigh(), source.getToken()));
+  auto other = insertBlobImportRequest(queue, ImportPriority::kLow());
+
+  source.requestCancellation();
+  auto next = queue.dequeue().at(0);
+  EXPECT_EQ(other, next->getRequest<HgImportRequest::BlobImport>()->hash);
+
+  ASSERT_TRUE(future.isReady());
+  EXPECT_TRUE(future.result().hasException<folly::OperationCancelled>());
+  ASSERT_TRUE(duplicate.isReady());
+  EXPECT_TRUE(duplicate.result().hasException<folly::OperationCancelled>());
+}
+
+TEST_F(HgImportRequestQueueTest, requestIsKeptWhileOneCallerWaits) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  folly::CancellationSource source;
+  auto proxyHash = HgProxyHash{RelativePath{"some_blob"}, uniqueHash()};
+  auto hash = proxyHash.sha1();
+  queue.enqueueBlob(HgImportRequest::makeBlobImportRequest(
+      hash, proxyHash, ImportPriority::kHigh(), source.getToken()));
+  queue.enqueueBlob(HgImportRequest::makeBlobImportRequest(
+      hash, proxyHash, ImportPriority::kHigh()));
+
+  source.requestCancellation();
+  auto dequeued = queue.dequeue().at(0);
+  EXPECT_EQ(hash, dequeued->getRequest<HgImportRequest::BlobImport>()->hash);
+}
+
+TEST_F(HgImportRequestQueueTest, clientsOfSamePriorityShareTheQueue) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  auto enqueueForClient = [&](pid_t pid) {
+    auto proxyHash = HgProxyHash{RelativePath{"some_blob"}, uniqueHash()};
+    auto hash = proxyHash.sha1();
+    queue.enqueueBlob(HgImportRequest::makeBlobImportRequest(
+        hash, proxyHash, ImportPriority::kNormal(), {}, pid));
+    return hash;
+  };
+
+  std::vector<ObjectId> heavy;
+  for (int i = 0; i < 5; i++) {
+    heavy.push_back(enqueueForClient(100));
+  }
+  auto light = enqueueForClient(200);
+
+  auto stats = queue.getClientStats();
+  EXPECT_EQ(5u, stats[100].queuedBlobs);
+  EXPECT_EQ(1u, stats[200].queuedBlobs);
+
+  // The request of the light client doesn't wait for the whole backlog of
+  // the heavy one.
+  std::vector<ObjectId> expected{heavy[0], light, heavy[1], heavy[2]};
+  for (const auto& hash : expected) {
+    auto request = queue.dequeue().at(0);
+    EXPECT_EQ(hash, request->getRequest<HgImportRequest::BlobImport>()->hash);
+  }
+
+  stats = queue.getClientStats();
+  EXPECT_EQ(2u, stats[100].queuedBlobs);
+  EXPECT_EQ(0u, stats.count(200));
+}
+
+TEST_F(HgImportRequestQueueTest, blobMetadataIsDequeuedBeforeBlobs) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  // The blob and its metadata share an ObjectId, but are separate requests.
+  auto proxyHash = HgProxyHash{RelativePath{"some_blob"}, uniqueHash()};
+  auto hash = proxyHash.sha1();
+  queue.enqueueBlob(HgImportRequest::makeBlobImportRequest(
+      hash, proxyHash, ImportPriority::kNormal()));
+  auto metadata =
+      queue.enqueueBlobMeta(HgImportRequest::makeBlobMetaImportRequest(
+          hash, proxyHash, ImportPriority::kNormal()));
+
+  auto request = queue.dequeue().at(0);
+  ASSERT_TRUE(request->isType<HgImportRequest::BlobMetaImport>());
+  EXPECT_EQ(hash, request->getRequest<HgImportRequest::BlobMetaImport>()->hash);
+  request->getPromise<std::unique_ptr<BlobMetadata>>()->setValue(
+      std::make_unique<BlobMetadata>(Hash20{}, 0));
+  EXPECT_TRUE(metadata.isReady());
+
+  request = queue.dequeue().at(0);
+  EXPECT_EQ(hash, request->getRequest<HgImportRequest::BlobImport>()->hash);
+}
@@ -5,12 +5,15 @@
  * GNU General Public License version 2.
  */
 
+#include <folly/String.h>
 #include <folly/experimental/TestUtil.h>
 #include <folly/futures/Future.h>
 #include <folly/portability/GMock.h>
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
 
+#include <map>
+
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/model/Tree.h"
@@ -90,6 +93,72 @@ TEST_F(HgImportTest, importTest) {
       "no match found");
 }
 
+TEST_F(HgImportTest, importBatchTest) {
+  // More files than the importer pipelines, so that requests are still being
+  // sent while the first responses are read.
+  std::map<std::string, std::string> contents;
+  repo_.mkdir("foo");
+  for (size_t i = 0; i < HgImporter::kMaxPipelinedRequests + 3; ++i) {
+    auto path = fmt::format("foo/file{}.txt", i);
+    contents[path] = fmt::format("contents of file {}\n", i);
+    repo_.writeFile(RelativePathPiece{path}, contents[path]);
+  }
+  repo_.hg("add");
+  repo_.commit("Initial commit");
+
+  // Each line of the manifest is "<file node> <mode> <path>".
+  auto manifest = repo_.hg("manifest", "--debug");
+  std::vector<StringPiece> lines;
+  folly::split('\n', manifest, lines, true);
+  std::vector<std::pair<RelativePathPiece, Hash20>> files;
+  for (auto line : lines) {
+    files.emplace_back(
+        RelativePathPiece{line.subpiece(line.rfind(' ') + 1)},
+        Hash20{line.subpiece(0, 40)});
+  }
+  ASSERT_EQ(contents.size(), files.size());
+
+  // A missing file in the middle of the batch only fails its own result.
+  files.insert(
+      files.begin() + 2,
+      {RelativePathPiece{"foo/missing.txt"}, makeTestHash20("123")});
+
+  HgImporter importer(repo_.path(), stats_);
+  auto results = importer.importFileContentsBatch(files);
+  ASSERT_EQ(files.size(), results.size());
+  for (size_t i = 0; i < files.size(); ++i) {
+    if (i == 2) {
+      EXPECT_THROW_RE(results[i].value(), std::exception, "no match found");
+    } else {
+      EXPECT_BLOB_EQ(
+          results[i].value(), contents[files[i].first.stringPiece().str()]);
+    }
+  }
+}
+
+TEST_F(HgImportTest, resolveManifestNodesTest) {
+  repo_.writeFile(RelativePathPiece{"a.txt"}, "a\n");
+  repo_.hg("add");
+  auto commit1 = repo_.commit("First commit");
+  repo_.writeFile(RelativePathPiece{"a.txt"}, "b\n");
+  auto commit2 = repo_.commit("Second commit");
+
+  HgImporter importer(repo_.path(), stats_);
+  auto nodes = importer.resolveManifestNodes("all()");
+  ASSERT_EQ(2, nodes.size());
+  EXPECT_EQ(Hash20{commit1.value()}, nodes[0].first);
+  EXPECT_EQ(repo_.getManifestForCommit(commit1), nodes[0].second);
+  EXPECT_EQ(Hash20{commit2.value()}, nodes[1].first);
+  EXPECT_EQ(repo_.getManifestForCommit(commit2), nodes[1].second);
+
+  EXPECT_EQ(0, importer.resolveManifestNodes("none()").size());
+
+  // The helper is still usable after a bad revset.
+  EXPECT_THROW(
+      importer.resolveManifestNodes("no_such_function()"), HgImportPyError);
+  EXPECT_EQ(1, importer.resolveManifestNodes(".").size());
+}
+
 // TODO(T33797958): Check hg_importer_helper's exit code on Windows (in
 // HgImportTest).
 #ifndef _WIN32
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/hg/ImportBatchSizer.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+const ImportBatchSizer::Limits kLimits{1, 64, 100ms};
+}
+
+TEST(ImportBatchSizerTest, short_queues_use_minimum_batches) {
+  ImportBatchSizer sizer;
+  EXPECT_EQ(1, sizer.getBatchSize(1, 4, kLimits));
+  EXPECT_EQ(1, sizer.getBatchSize(4, 4, kLimits));
+  EXPECT_EQ(8, sizer.getBatchSize(32, 4, kLimits));
+  EXPECT_EQ(64, sizer.getBatchSize(10000, 4, kLimits));
+}
+
+TEST(ImportBatchSizerTest, adaptive_sizing_can_be_disabled) {
+  ImportBatchSizer sizer;
+  ImportBatchSizer::Limits fixed{16, 16, 100ms};
+  EXPECT_EQ(16, sizer.getBatchSize(10000, 4, fixed));
+  EXPECT_EQ(16, sizer.getBatchSize(1, 4, fixed));
+}
+
+TEST(ImportBatchSizerTest, slow_batches_shrink_the_limit) {
+  ImportBatchSizer sizer;
+  // Single request batches take 50ms: that is the round trip.
+  sizer.recordBatch(1, 50ms, kLimits);
+  EXPECT_EQ(50ms, sizer.getRoundTripEstimate());
+
+  sizer.recordBatch(64, 400ms, kLimits);
+  EXPECT_EQ(32, sizer.getBatchSize(10000, 4, kLimits));
+  sizer.recordBatch(32, 300ms, kLimits);
+  EXPECT_EQ(16, sizer.getBatchSize(10000, 4, kLimits));
+
+  // Full batches within the round trip plus the target grow it again.
+  sizer.recordBatch(16, 120ms, kLimits);
+  EXPECT_EQ(20, sizer.getBatchSize(10000, 4, kLimits));
+
+  // Batches that weren't full don't say whether a larger one would be fast.
+  sizer.recordBatch(4, 60ms, kLimits);
+  EXPECT_EQ(20, sizer.getBatchSize(10000, 4, kLimits));
+}
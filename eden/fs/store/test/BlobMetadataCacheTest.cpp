@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/BlobMetadataCache.h"
+#include <folly/portability/GTest.h>
+#include <array>
+
+using namespace facebook::eden;
+
+namespace {
+ObjectId makeId(uint8_t n) {
+  std::array<uint8_t, 20> bytes{};
+  bytes[19] = n;
+  return ObjectId{folly::ByteRange{bytes.data(), bytes.size()}};
+}
+
+BlobMetadata makeMetadata(uint64_t size) {
+  return BlobMetadata{Hash20{}, size};
+}
+} // namespace
+
+TEST(BlobMetadataCache, get_returns_inserted_metadata) {
+  BlobMetadataCache cache{1024 * 1024};
+  cache.set(makeId(1), makeMetadata(10));
+  cache.set(makeId(2), makeMetadata(20));
+
+  EXPECT_EQ(10, cache.get(makeId(1)).value().size);
+  EXPECT_EQ(20, cache.get(makeId(2)).value().size);
+  EXPECT_FALSE(cache.get(makeId(3)).has_value());
+  EXPECT_TRUE(cache.contains(makeId(1)));
+
+  auto stats = cache.getStats();
+  EXPECT_EQ(2, stats.entryCount);
+  EXPECT_EQ(2, stats.hitCount);
+  EXPECT_EQ(1, stats.missCount);
+  EXPECT_EQ(
+      2 * BlobMetadataCache::getEntrySize(makeId(1)), stats.totalSizeInBytes);
+}
+
+TEST(BlobMetadataCache, set_replaces_existing_metadata) {
+  BlobMetadataCache cache{1024 * 1024};
+  cache.set(makeId(1), makeMetadata(10));
+  cache.set(makeId(1), makeMetadata(11));
+  EXPECT_EQ(11, cache.get(makeId(1)).value().size);
+  EXPECT_EQ(1, cache.getStats().entryCount);
+}
+
+TEST(BlobMetadataCache, evicts_to_stay_under_size_limit) {
+  auto entrySize = BlobMetadataCache::getEntrySize(makeId(0));
+  BlobMetadataCache cache{entrySize * 4};
+  for (uint8_t i = 0; i < 10; ++i) {
+    cache.set(makeId(i), makeMetadata(i));
+  }
+  auto stats = cache.getStats();
+  EXPECT_EQ(4, stats.entryCount);
+  EXPECT_EQ(6, stats.evictionCount);
+  EXPECT_LE(stats.totalSizeInBytes, entrySize * 4);
+  // Every surviving entry is still reachable through the index.
+  size_t found = 0;
+  for (uint8_t i = 0; i < 10; ++i) {
+    if (auto metadata = cache.get(makeId(i))) {
+      EXPECT_EQ(i, metadata->size);
+      ++found;
+    }
+  }
+  EXPECT_EQ(4, found);
+}
+
+TEST(BlobMetadataCache, referenced_entries_survive_eviction) {
+  auto entrySize = BlobMetadataCache::getEntrySize(makeId(0));
+  BlobMetadataCache cache{entrySize * 3};
+  cache.set(makeId(1), makeMetadata(1));
+  cache.set(makeId(2), makeMetadata(2));
+  cache.set(makeId(3), makeMetadata(3));
+
+  // Entry 1 is used, so the clock hand skips it and evicts entry 2 instead.
+  EXPECT_TRUE(cache.get(makeId(1)).has_value());
+  cache.set(makeId(4), makeMetadata(4));
+
+  EXPECT_TRUE(cache.contains(makeId(1)));
+  EXPECT_FALSE(cache.contains(makeId(2)));
+  EXPECT_TRUE(cache.contains(makeId(3)));
+  EXPECT_TRUE(cache.contains(makeId(4)));
+}
+
+TEST(BlobMetadataCache, clear_removes_everything) {
+  BlobMetadataCache cache{1024 * 1024};
+  cache.set(makeId(1), makeMetadata(1));
+  cache.clear();
+  EXPECT_FALSE(cache.contains(makeId(1)));
+  EXPECT_EQ(0, cache.getStats().totalSizeInBytes);
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/CacheWarmState.h"
+
+#include <folly/portability/GTest.h>
+#include <folly/testing/TestUtil.h>
+
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/config/ReloadableConfig.h"
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/BlobCache.h"
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/TreeCache.h"
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+
+namespace {
+
+const auto blobId1 =
+    ObjectId::fromHex("0000000000000000000000000000000000000001");
+const auto blobId2 =
+    ObjectId::fromHex("0000000000000000000000000000000000000002");
+const auto missingId =
+    ObjectId::fromHex("0000000000000000000000000000000000000003");
+const auto treeId =
+    ObjectId::fromHex("0000000000000000000000000000000000000004");
+
+struct CacheWarmStateTest : ::testing::Test {
+  void SetUp() override {
+    auto config = std::make_shared<ReloadableConfig>(
+        EdenConfig::createTestEdenConfig(), ConfigReloadBehavior::NoReload);
+    treeCache = TreeCache::create(config);
+    blobCache = BlobCache::create(1024 * 1024, 1);
+    localStore = std::make_shared<MemoryLocalStore>();
+  }
+
+  std::shared_ptr<TreeCache> treeCache;
+  std::shared_ptr<BlobCache> blobCache;
+  std::shared_ptr<MemoryLocalStore> localStore;
+};
+
+} // namespace
+
+TEST(CacheWarmState, serialize_roundtrip) {
+  CacheWarmState state;
+  state.blobs = {CacheHotKey{blobId1, 3}, CacheHotKey{blobId2, 0}};
+  state.trees = {CacheHotKey{ObjectId{"a longer proxy id"_sp}, 15}};
+
+  auto data = state.serialize();
+  auto copy = CacheWarmState::deserialize(folly::StringPiece{data});
+  ASSERT_EQ(2, copy.blobs.size());
+  EXPECT_EQ(blobId1, copy.blobs[0].id);
+  EXPECT_EQ(3, copy.blobs[0].frequency);
+  EXPECT_EQ(blobId2, copy.blobs[1].id);
+  ASSERT_EQ(1, copy.trees.size());
+  EXPECT_EQ(ObjectId{"a longer proxy id"_sp}, copy.trees[0].id);
+  EXPECT_EQ(15, copy.trees[0].frequency);
+}
+
+TEST(CacheWarmState, deserialize_rejects_bad_data) {
+  EXPECT_THROW(
+      CacheWarmState::deserialize(folly::StringPiece{"garbage"}),
+      std::invalid_argument);
+
+  CacheWarmState state;
+  state.blobs = {CacheHotKey{blobId1, 1}};
+  auto data = state.serialize();
+  data.resize(data.size() - 4);
+  EXPECT_THROW(
+      CacheWarmState::deserialize(folly::StringPiece{data}),
+      std::invalid_argument);
+}
+
+TEST(CacheWarmState, save_and_load) {
+  folly::test::TemporaryDirectory tmpDir;
+  auto path =
+      canonicalPath(tmpDir.path().string()) + PathComponentPiece{"warm"};
+  EXPECT_FALSE(CacheWarmState::load(path));
+
+  CacheWarmState state;
+  state.blobs = {CacheHotKey{blobId1, 2}};
+  state.save(path).value();
+  auto loaded = CacheWarmState::load(path);
+  ASSERT_TRUE(loaded);
+  ASSERT_EQ(1, loaded->blobs.size());
+  EXPECT_EQ(blobId1, loaded->blobs[0].id);
+}
+
+TEST_F(CacheWarmStateTest, capture_and_restore) {
+  auto blob1 = std::make_shared<Blob>(blobId1, "blob one"_sp);
+  auto blob2 = std::make_shared<Blob>(blobId2, "blob two"_sp);
+  auto tree = std::make_shared<Tree>(std::vector<TreeEntry>{}, treeId);
+  localStore->putBlob(blobId1, blob1.get());
+  localStore->putBlob(blobId2, blob2.get());
+  localStore->putTree(*tree);
+
+  blobCache->insert(blob2);
+  blobCache->insert(blob1);
+  treeCache->insert(tree);
+  auto state = CacheWarmState::capture(*blobCache, *treeCache, 10);
+  ASSERT_EQ(2, state.blobs.size());
+  EXPECT_EQ(blobId1, state.blobs[0].id);
+  EXPECT_EQ(blobId2, state.blobs[1].id);
+  state.blobs.push_back(CacheHotKey{missingId, 0});
+
+  auto freshBlobCache = BlobCache::create(1024 * 1024, 1);
+  auto config = std::make_shared<ReloadableConfig>(
+      EdenConfig::createTestEdenConfig(), ConfigReloadBehavior::NoReload);
+  auto freshTreeCache = TreeCache::create(config);
+  EXPECT_EQ(3, state.restore(*localStore, *freshBlobCache, *freshTreeCache));
+
+  EXPECT_TRUE(freshBlobCache->contains(blobId1));
+  EXPECT_TRUE(freshBlobCache->contains(blobId2));
+  EXPECT_FALSE(freshBlobCache->contains(missingId));
+  EXPECT_TRUE(freshTreeCache->contains(treeId));
+
+  // The recency order survives the restore.
+  auto hotKeys = freshBlobCache->getHotKeys(10);
+  ASSERT_EQ(2, hotKeys.size());
+  EXPECT_EQ(blobId1, hotKeys[0].id);
+  EXPECT_EQ(blobId2, hotKeys[1].id);
+}
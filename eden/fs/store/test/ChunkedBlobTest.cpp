@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/ChunkedBlob.h"
+
+#include <folly/container/F14Set.h>
+#include <folly/portability/GTest.h>
+#include <random>
+
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/StoreResult.h"
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+
+std::string randomData(size_t size, uint32_t seed) {
+  std::mt19937 gen{seed};
+  std::string data(size, '\0');
+  for (auto& c : data) {
+    c = static_cast<char>(gen());
+  }
+  return data;
+}
+
+folly::F14FastSet<std::string> chunkSet(folly::StringPiece data) {
+  folly::F14FastSet<std::string> chunks;
+  for (auto chunk : ChunkedBlob::split(folly::ByteRange{data})) {
+    chunks.insert(folly::StringPiece{chunk}.str());
+  }
+  return chunks;
+}
+
+} // namespace
+
+TEST(ChunkedBlobTest, split_covers_data_within_size_bounds) {
+  auto data = randomData(4 * 1024 * 1024, 1);
+  auto chunks = ChunkedBlob::split(folly::ByteRange{folly::StringPiece{data}});
+
+  ASSERT_GT(chunks.size(), 1);
+  auto* expected = reinterpret_cast<const uint8_t*>(data.data());
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    EXPECT_EQ(expected, chunks[i].data());
+    expected += chunks[i].size();
+    EXPECT_LE(chunks[i].size(), ChunkedBlob::kMaxChunkSize);
+    if (i + 1 < chunks.size()) {
+      EXPECT_GE(chunks[i].size(), ChunkedBlob::kMinChunkSize);
+    }
+  }
+  EXPECT_EQ(expected, reinterpret_cast<const uint8_t*>(data.end()));
+}
+
+TEST(ChunkedBlobTest, insertion_only_changes_nearby_chunks) {
+  auto original = randomData(4 * 1024 * 1024, 2);
+  auto edited = original;
+  edited.insert(edited.size() / 2, "a few new bytes");
+
+  auto originalChunks = chunkSet(original);
+  auto editedChunks = chunkSet(edited);
+  size_t shared = 0;
+  for (const auto& chunk : editedChunks) {
+    shared += originalChunks.count(chunk);
+  }
+  EXPECT_GE(shared + 3, editedChunks.size());
+}
+
+TEST(ChunkedBlobTest, manifest_roundtrip) {
+  ChunkedBlob::Manifest manifest;
+  manifest.size = 12345;
+  manifest.chunks.push_back(Hash20::sha1(std::string{"first"}));
+  manifest.chunks.push_back(Hash20::sha1(std::string{"second"}));
+
+  auto serialized = manifest.serialize();
+  auto parsed = ChunkedBlob::Manifest::tryParse(
+      folly::ByteRange{folly::StringPiece{serialized}});
+  ASSERT_TRUE(parsed.has_value());
+  EXPECT_EQ(12345, parsed->size);
+  EXPECT_EQ(manifest.chunks, parsed->chunks);
+
+  EXPECT_FALSE(ChunkedBlob::Manifest::tryParse(
+      folly::ByteRange{folly::StringPiece{"blob 5"}}));
+  serialized.pop_back();
+  EXPECT_THROW(
+      ChunkedBlob::Manifest::tryParse(
+          folly::ByteRange{folly::StringPiece{serialized}}),
+      std::invalid_argument);
+}
+
+TEST(ChunkedBlobTest, sized_manifest_roundtrip) {
+  ChunkedBlob::Manifest manifest;
+  manifest.size = 70000;
+  manifest.chunks.push_back(Hash20::sha1(std::string{"first"}));
+  manifest.chunks.push_back(Hash20::sha1(std::string{"second"}));
+  manifest.chunkSizes = {65536, 4464};
+
+  auto serialized = manifest.serialize();
+  auto parsed = ChunkedBlob::Manifest::tryParse(
+      folly::ByteRange{folly::StringPiece{serialized}});
+  ASSERT_TRUE(parsed.has_value());
+  EXPECT_EQ(70000, parsed->size);
+  EXPECT_EQ(manifest.chunks, parsed->chunks);
+  EXPECT_EQ(manifest.chunkSizes, parsed->chunkSizes);
+
+  serialized.pop_back();
+  EXPECT_THROW(
+      ChunkedBlob::Manifest::tryParse(
+          folly::ByteRange{folly::StringPiece{serialized}}),
+      std::invalid_argument);
+}
+
+TEST(ChunkedBlobTest, ranges_only_read_their_chunks) {
+  auto store = std::make_shared<MemoryLocalStore>();
+  auto data = randomData(4 * 1024 * 1024, 5);
+  auto id = ObjectId::sha1(data);
+  Blob blob{id, folly::StringPiece{data}};
+
+  auto readRange = [&](uint64_t offset, uint64_t length) {
+    auto range = store->getBlobRange(id, offset, length).get(10s);
+    EXPECT_TRUE(range);
+    return range ? range->moveToFbString().toStdString() : std::string{};
+  };
+
+  // Stored whole, and rewritten chunked by the first range read.
+  store->putBlob(id, &blob);
+  store->enableBlobChunking = true;
+  EXPECT_EQ(data.substr(100, 5000), readRange(100, 5000));
+  auto manifest = ChunkedBlob::Manifest::tryParse(
+      store->get(KeySpace::BlobFamily, id.getBytes()).bytes());
+  ASSERT_TRUE(manifest.has_value());
+  EXPECT_TRUE(manifest->hasChunkSizes());
+
+  // Ranges spanning chunk boundaries, and past the end.
+  EXPECT_EQ(data.substr(0, 300000), readRange(0, 300000));
+  EXPECT_EQ(data.substr(1000000, 1000000), readRange(1000000, 1000000));
+  EXPECT_EQ(data.substr(data.size() - 10), readRange(data.size() - 10, 100));
+  EXPECT_EQ("", readRange(data.size(), 100));
+
+  // A range only misses when one of its own chunks is evicted.
+  store->clearKeySpace(KeySpace::BlobChunkFamily);
+  EXPECT_FALSE(store->getBlobRange(id, 0, 100).get(10s));
+}
+
+TEST(ChunkedBlobTest, similar_blobs_share_chunks_in_local_store) {
+  auto store = std::make_shared<MemoryLocalStore>();
+  store->enableBlobChunking = true;
+
+  auto original = randomData(4 * 1024 * 1024, 3);
+  auto edited = original;
+  edited[edited.size() / 2] ^= 1;
+  auto originalId = ObjectId::sha1(original);
+  auto editedId = ObjectId::sha1(edited);
+
+  Blob originalBlob{originalId, folly::StringPiece{original}};
+  Blob editedBlob{editedId, folly::StringPiece{edited}};
+  store->putBlob(originalId, &originalBlob);
+  store->putBlob(editedId, &editedBlob);
+
+  for (const auto& [id, contents] :
+       {std::pair{originalId, &original}, std::pair{editedId, &edited}}) {
+    auto blob = store->getBlob(id).get(10s);
+    ASSERT_TRUE(blob);
+    auto buf = blob->getContents().cloneCoalescedAsValue();
+    EXPECT_EQ(*contents, folly::StringPiece{buf.coalesce()});
+  }
+
+  // Flipping one bit only changes the chunk it is in, and possibly the next
+  // one if it moved a boundary.
+  auto originalChunks = chunkSet(original);
+  size_t newChunks = 0;
+  for (const auto& chunk : chunkSet(edited)) {
+    newChunks += !originalChunks.count(chunk);
+  }
+  EXPECT_LE(newChunks, 2);
+
+  // A blob is a cache miss once any of its chunks is evicted.
+  store->clearKeySpace(KeySpace::BlobChunkFamily);
+  EXPECT_FALSE(store->getBlob(originalId).get(10s));
+}
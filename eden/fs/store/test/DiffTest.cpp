@@ -19,6 +19,7 @@
 #include "eden/fs/store/ObjectStore.h"
 #include "eden/fs/store/ScmStatusDiffCallback.h"
 #include "eden/fs/store/TreeCache.h"
+#include "eden/fs/store/TreeDiffCache.h"
 #include "eden/fs/telemetry/NullStructuredLogger.h"
 #include "eden/fs/testharness/FakeBackingStore.h"
 #include "eden/fs/testharness/FakeTreeBuilder.h"
@@ -183,6 +184,68 @@ TEST_F(DiffTest, basicDiff) {
           Pair("a/b/1.txt", ScmFileStatus::REMOVED)));
 }
 
+TEST_F(DiffTest, cachedDiff) {
+  FakeTreeBuilder builder;
+  builder.setFile("a/b/1.txt", "1");
+  builder.setFile("src/main.c", "hello world");
+  builder.setFile("src/test/test.c", "testing");
+  builder.finalize(backingStore_, /* setReady */ true);
+  backingStore_->putCommit("1", builder)->setReady();
+
+  auto builder2 = builder.clone();
+  builder2.replaceFile("src/main.c", "hello world v2");
+  builder2.setFile("src/test/test2.c", "another test");
+  builder2.finalize(backingStore_, /* setReady */ true);
+  backingStore_->putCommit("2", builder2)->setReady();
+
+  // Leaves src as it is in commit 2.
+  auto builder3 = builder2.clone();
+  builder3.removeFile("a/b/1.txt");
+  builder3.finalize(backingStore_, /* setReady */ true);
+  backingStore_->putCommit("3", builder3)->setReady();
+
+  auto cache = std::make_shared<TreeDiffCache>(1024 * 1024);
+  auto diff = [&](StringPiece commit1, StringPiece commit2) {
+    return diffCommitsForStatus(
+               store_.get(),
+               RootId{commit1.str()},
+               RootId{commit2.str()},
+               cache)
+        .get(100ms);
+  };
+
+  auto result = diff("1", "2");
+  EXPECT_THAT(
+      *result->entries_ref(),
+      UnorderedElementsAre(
+          Pair("src/main.c", ScmFileStatus::MODIFIED),
+          Pair("src/test/test2.c", ScmFileStatus::ADDED)));
+  auto caseSensitive = kPathMapDefaultCaseSensitive;
+  EXPECT_NE(nullptr, cache->getRoots(RootId{"1"}, RootId{"2"}, caseSensitive));
+  auto srcDiff = cache->getTrees(
+      builder.getStoredTree(RelativePathPiece{"src"})->get().getHash(),
+      builder2.getStoredTree(RelativePathPiece{"src"})->get().getHash(),
+      caseSensitive);
+  ASSERT_NE(nullptr, srcDiff);
+  EXPECT_THAT(
+      *srcDiff->entries_ref(),
+      UnorderedElementsAre(
+          Pair("main.c", ScmFileStatus::MODIFIED),
+          Pair("test/test2.c", ScmFileStatus::ADDED)));
+
+  // The differences in src are reused from the first diff.
+  auto result2 = diff("1", "3");
+  EXPECT_THAT(
+      *result2->entries_ref(),
+      UnorderedElementsAre(
+          Pair("src/main.c", ScmFileStatus::MODIFIED),
+          Pair("src/test/test2.c", ScmFileStatus::ADDED),
+          Pair("a/b/1.txt", ScmFileStatus::REMOVED)));
+
+  // Cached diffs are returned as they were computed.
+  EXPECT_EQ(*result, *diff("1", "2"));
+}
+
 TEST_F(DiffTest, directoryOrdering) {
   FakeTreeBuilder builder;
 
@@ -1272,3 +1335,37 @@ TEST_F(DiffTest, caseSensitivity) {
           Pair("a/b.txt", ScmFileStatus::REMOVED),
           Pair("a/B.txt", ScmFileStatus::ADDED)));
 }
+
+TEST_F(DiffTest, comparisonsAreLimited) {
+  ScmStatusDiffCallback callback;
+  DiffContext context{&callback, store_.get()};
+  context.setMaxConcurrentComparisons(2);
+
+  std::vector<folly::Promise<folly::Unit>> promises(4);
+  std::vector<size_t> started;
+  std::vector<Future<folly::Unit>> results;
+  for (size_t i = 0; i < promises.size(); ++i) {
+    results.push_back(context.runComparison([&, i] {
+      started.push_back(i);
+      return promises[i].getFuture();
+    }));
+  }
+  EXPECT_EQ((std::vector<size_t>{0, 1}), started);
+
+  // Completing a comparison, even with an error, starts the next pending one.
+  promises[1].setException(std::runtime_error("fetch failed"));
+  EXPECT_EQ((std::vector<size_t>{0, 1, 2}), started);
+  EXPECT_THROW(std::move(results[1]).get(0ms), std::runtime_error);
+
+  promises[0].setValue();
+  promises[2].setValue();
+  EXPECT_EQ((std::vector<size_t>{0, 1, 2, 3}), started);
+  promises[3].setValue();
+  for (auto i : {0, 2, 3}) {
+    EXPECT_TRUE(results[i].isReady());
+  }
+
+  // Comparisons that complete immediately don't wait for a slot.
+  auto immediate = context.runComparison([] { return folly::makeFuture(); });
+  EXPECT_TRUE(immediate.isReady());
+}
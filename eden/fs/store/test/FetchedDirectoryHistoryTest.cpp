@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/FetchedDirectoryHistory.h"
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+TEST(FetchedDirectoryHistory, orders_directories_by_fetches) {
+  FetchedDirectoryHistory history{10};
+  history.recordFileFetch("a/one"_relpath);
+  history.recordFileFetch("b/c/one"_relpath);
+  history.recordFileFetch("b/c/two"_relpath);
+  history.recordFileFetch("top"_relpath);
+  history.recordFileFetch("b/c/three"_relpath);
+  history.recordFileFetch("a/two"_relpath);
+
+  auto top = history.getTopDirectories(10);
+  ASSERT_EQ(3, top.size());
+  EXPECT_EQ("b/c"_relpath, top[0]);
+  EXPECT_EQ("a"_relpath, top[1]);
+  EXPECT_EQ(""_relpath, top[2]);
+
+  EXPECT_EQ(
+      std::vector<RelativePath>{RelativePath{"b/c"}},
+      history.getTopDirectories(1));
+}
+
+TEST(FetchedDirectoryHistory, full_history_forgets_rarely_fetched_directories) {
+  FetchedDirectoryHistory history{2};
+  for (int i = 0; i < 4; ++i) {
+    history.recordFileFetch("hot/file"_relpath);
+  }
+  history.recordFileFetch("cold/file"_relpath);
+
+  // Halving the counts to make room forgets cold, hot remains.
+  history.recordFileFetch("new/file"_relpath);
+  auto top = history.getTopDirectories(10);
+  ASSERT_EQ(2, top.size());
+  EXPECT_EQ("hot"_relpath, top[0]);
+  EXPECT_EQ("new"_relpath, top[1]);
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/FrequencySketch.h"
+#include <gtest/gtest.h>
+
+using namespace facebook::eden;
+
+TEST(FrequencySketch, unseen_keys_have_zero_frequency) {
+  FrequencySketch sketch{100};
+  EXPECT_EQ(0, sketch.estimate(1));
+  EXPECT_EQ(0, sketch.estimate(12345));
+}
+
+TEST(FrequencySketch, counts_increments) {
+  FrequencySketch sketch{100};
+  for (int i = 0; i < 5; ++i) {
+    sketch.increment(42);
+  }
+  sketch.increment(43);
+  EXPECT_EQ(5, sketch.estimate(42));
+  EXPECT_EQ(1, sketch.estimate(43));
+}
+
+TEST(FrequencySketch, saturates_at_max_frequency) {
+  FrequencySketch sketch{100};
+  for (int i = 0; i < 100; ++i) {
+    sketch.increment(7);
+  }
+  EXPECT_EQ(FrequencySketch::kMaxFrequency, sketch.estimate(7));
+}
+
+TEST(FrequencySketch, ages_after_sample_size_increments) {
+  FrequencySketch sketch{100};
+  for (int i = 0; i < 8; ++i) {
+    sketch.increment(7);
+  }
+  EXPECT_EQ(8, sketch.estimate(7));
+
+  // Touch enough other keys to trigger a halving of all counters.
+  for (uint64_t key = 1000; key < 1000 + sketch.getSampleSize(); ++key) {
+    sketch.increment(key);
+  }
+  EXPECT_LE(sketch.estimate(7), 4);
+}
+
+TEST(FrequencySketch, clear_forgets_everything) {
+  FrequencySketch sketch{100};
+  sketch.increment(7);
+  sketch.clear();
+  EXPECT_EQ(0, sketch.estimate(7));
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/GitIgnoreCache.h"
+#include <folly/portability/GTest.h>
+#include <array>
+
+using namespace facebook::eden;
+
+namespace {
+ObjectId makeId(uint8_t n) {
+  std::array<uint8_t, 20> bytes{};
+  bytes[19] = n;
+  return ObjectId{folly::ByteRange{bytes.data(), bytes.size()}};
+}
+} // namespace
+
+TEST(GitIgnoreCache, get_returns_parsed_file) {
+  GitIgnoreCache cache{1024 * 1024};
+  EXPECT_EQ(nullptr, cache.get(makeId(1)));
+
+  auto inserted = cache.insert(makeId(1), "*.o\n");
+  EXPECT_EQ(
+      GitIgnore::EXCLUDE,
+      inserted->match(RelativePathPiece{"a.o"}, GitIgnore::TYPE_FILE));
+
+  auto cached = cache.get(makeId(1));
+  EXPECT_EQ(inserted, cached);
+  EXPECT_EQ(nullptr, cache.get(makeId(2)));
+
+  cache.clear();
+  EXPECT_EQ(nullptr, cache.get(makeId(1)));
+  // Evicted rules stay valid for as long as they are used.
+  EXPECT_EQ(
+      GitIgnore::EXCLUDE,
+      cached->match(RelativePathPiece{"a.o"}, GitIgnore::TYPE_FILE));
+}
+
+TEST(GitIgnoreCache, size_is_bounded) {
+  GitIgnoreCache cache{4096};
+  std::string contents(1024, 'x');
+  for (uint8_t n = 0; n < 10; ++n) {
+    cache.insert(makeId(n), contents);
+  }
+  EXPECT_EQ(nullptr, cache.get(makeId(0)));
+  EXPECT_NE(nullptr, cache.get(makeId(9)));
+}
@@ -9,7 +9,10 @@
 
 #include "eden/fs/store/test/LocalStoreTest.h"
 #include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/PackLocalStore.h"
+#include "eden/fs/store/SharedLocalStore.h"
 #include "eden/fs/store/SqliteLocalStore.h"
+#include "eden/fs/store/WriteBehindLocalStore.h"
 
 namespace {
 
@@ -21,6 +24,29 @@ LocalStoreImplResult makeMemoryLocalStore(FaultInjector*) {
   return {std::nullopt, std::make_unique<MemoryLocalStore>()};
 }
 
+LocalStoreImplResult makePackLocalStore(FaultInjector*) {
+  auto tempDir = makeTempDir();
+  auto store = std::make_unique<PackLocalStore>(
+      AbsolutePathPiece{tempDir.path().string()} + "pack"_pc);
+  return {std::move(tempDir), std::move(store)};
+}
+
+LocalStoreImplResult makeWriteBehindLocalStore(FaultInjector*) {
+  return {
+      std::nullopt,
+      std::make_unique<WriteBehindLocalStore>(
+          std::make_shared<MemoryLocalStore>(), /*capacityBytes=*/1024)};
+}
+
+LocalStoreImplResult makeSharedLocalStore(FaultInjector*) {
+  auto tempDir = makeTempDir();
+  auto store = std::make_unique<SharedLocalStore>(
+      std::make_shared<MemoryLocalStore>(),
+      std::make_shared<SqliteLocalStore>(
+          AbsolutePathPiece{tempDir.path().string()} + "shared"_pc));
+  return {std::move(tempDir), std::move(store)};
+}
+
 LocalStoreImplResult makeSqliteLocalStore(FaultInjector*) {
   auto tempDir = makeTempDir();
   auto store = std::make_unique<SqliteLocalStore>(
@@ -143,6 +169,26 @@ TEST_P(LocalStoreTest, testGetResult) {
   EXPECT_THROW(result2.piece(), std::domain_error);
 }
 
+TEST_P(LocalStoreTest, testConcurrentGetFutures) {
+  store_->put(KeySpace::BlobFamily, "blob"_sp, "blob value"_sp);
+  store_->put(KeySpace::TreeFamily, "tree"_sp, "tree value"_sp);
+
+  std::vector<folly::Future<StoreResult>> futures;
+  for (int i = 0; i < 100; ++i) {
+    futures.push_back(store_->getFuture(KeySpace::BlobFamily, "blob"_sp));
+    futures.push_back(store_->getFuture(KeySpace::TreeFamily, "tree"_sp));
+    futures.push_back(store_->getFuture(KeySpace::TreeFamily, "blob"_sp));
+  }
+  auto results = folly::collectAll(std::move(futures)).get(10s);
+
+  ASSERT_EQ(300, results.size());
+  for (size_t i = 0; i < results.size(); i += 3) {
+    EXPECT_EQ("blob value", results[i].value().piece());
+    EXPECT_EQ("tree value", results[i + 1].value().piece());
+    EXPECT_FALSE(results[i + 2].value().isValid());
+  }
+}
+
 TEST_P(LocalStoreTest, StoreResult_contains_keyspace_name_and_key) {
   auto key = ObjectId{kEmptySha1.getBytes()};
   auto result = store_->get(KeySpace::BlobFamily, key);
@@ -226,6 +272,21 @@ INSTANTIATE_TEST_CASE_P(
     Sqlite,
     LocalStoreTest,
     ::testing::Values(makeSqliteLocalStore));
+
+INSTANTIATE_TEST_CASE_P(
+    Pack,
+    LocalStoreTest,
+    ::testing::Values(makePackLocalStore));
+
+INSTANTIATE_TEST_CASE_P(
+    WriteBehind,
+    LocalStoreTest,
+    ::testing::Values(makeWriteBehindLocalStore));
+
+INSTANTIATE_TEST_CASE_P(
+    Shared,
+    LocalStoreTest,
+    ::testing::Values(makeSharedLocalStore));
 #pragma clang diagnostic pop
 
 } // namespace
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/NegativeLookupCache.h"
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+const auto id1 = ObjectId::fromHex("0000000000000000000000000000000000000001");
+const auto id2 = ObjectId::fromHex("0000000000000000000000000000000000000002");
+const auto id3 = ObjectId::fromHex("0000000000000000000000000000000000000003");
+} // namespace
+
+TEST(NegativeLookupCache, records_and_finds_misses) {
+  NegativeLookupCache cache{10, 1min};
+  EXPECT_FALSE(cache.contains(id1));
+  cache.insert(id1, cache.getGeneration());
+  EXPECT_TRUE(cache.contains(id1));
+  EXPECT_FALSE(cache.contains(id2));
+
+  auto stats = cache.getStats();
+  EXPECT_EQ(1, stats.entryCount);
+  EXPECT_EQ(1, stats.hitCount);
+  EXPECT_EQ(2, stats.missCount);
+  EXPECT_EQ(1, stats.insertCount);
+}
+
+TEST(NegativeLookupCache, entries_expire_after_ttl) {
+  NegativeLookupCache cache{10, 1min};
+  auto now = NegativeLookupCache::Clock::now();
+  cache.insert(id1, cache.getGeneration(), now);
+  EXPECT_TRUE(cache.contains(id1, now + 30s));
+  EXPECT_FALSE(cache.contains(id1, now + 61s));
+  EXPECT_EQ(1, cache.getStats().expiredCount);
+  EXPECT_EQ(0, cache.getStats().entryCount);
+}
+
+TEST(NegativeLookupCache, is_bounded) {
+  NegativeLookupCache cache{2, 1min};
+  cache.insert(id1, cache.getGeneration());
+  cache.insert(id2, cache.getGeneration());
+  cache.insert(id3, cache.getGeneration());
+  EXPECT_LE(cache.getStats().entryCount, 2);
+  EXPECT_TRUE(cache.contains(id3));
+}
+
+TEST(NegativeLookupCache, invalidate_drops_entries_and_stale_inserts) {
+  NegativeLookupCache cache{10, 1min};
+  auto staleGeneration = cache.getGeneration();
+  cache.insert(id1, staleGeneration);
+
+  cache.invalidate();
+  EXPECT_FALSE(cache.contains(id1));
+  EXPECT_NE(staleGeneration, cache.getGeneration());
+
+  // A lookup that started before the invalidation may not record its miss.
+  cache.insert(id2, staleGeneration);
+  EXPECT_FALSE(cache.contains(id2));
+
+  cache.insert(id2, cache.getGeneration());
+  EXPECT_TRUE(cache.contains(id2));
+  EXPECT_EQ(1, cache.getStats().invalidationCount);
+}
+
+TEST(NegativeLookupCache, erase_forgets_entry) {
+  NegativeLookupCache cache{10, 1min};
+  cache.insert(id1, cache.getGeneration());
+  cache.erase(id1);
+  EXPECT_FALSE(cache.contains(id1));
+}
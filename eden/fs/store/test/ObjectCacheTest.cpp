@@ -534,3 +534,216 @@ TEST(
   handle3.reset();
   EXPECT_TRUE(cache->contains(hash3));
 }
+
+/**
+ * Sharded test cases
+ */
+
+TEST(ObjectCache, sharded_cache_finds_objects_in_any_shard) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(1000, 0, 4);
+  EXPECT_EQ(4, cache->getShardCount());
+
+  for (auto& object : {object3, object3a, object3b, object3c, object4}) {
+    cache->insertSimple(object);
+  }
+  for (auto& object : {object3, object3a, object3b, object3c, object4}) {
+    EXPECT_TRUE(cache->contains(object->getHash()));
+    EXPECT_EQ(object, cache->getSimple(object->getHash()));
+  }
+
+  auto stats = cache->getStats();
+  EXPECT_EQ(5, stats.objectCount);
+  EXPECT_EQ(16, stats.totalSizeInBytes);
+  EXPECT_EQ(5, stats.hitCount);
+  ASSERT_EQ(4, stats.shardStats.size());
+
+  size_t objectCount = 0;
+  size_t totalSize = 0;
+  for (auto& shardStats : stats.shardStats) {
+    objectCount += shardStats.objectCount;
+    totalSize += shardStats.totalSizeInBytes;
+    EXPECT_TRUE(shardStats.shardStats.empty());
+  }
+  EXPECT_EQ(stats.objectCount, objectCount);
+  EXPECT_EQ(stats.totalSizeInBytes, totalSize);
+
+  cache->clear();
+  EXPECT_EQ(0, cache->getStats().objectCount);
+  EXPECT_FALSE(cache->contains(object3->getHash()));
+}
+
+TEST(ObjectCache, sharded_cache_splits_size_budget_between_shards) {
+  // Each of the 2 shards may hold 5 bytes worth of objects and must keep at
+  // least one entry.
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(10, 2, 2);
+
+  for (auto& object :
+       {object3, object3a, object3b, object3c, object4, object5, object6}) {
+    cache->insertSimple(object);
+  }
+
+  auto stats = cache->getStats();
+  ASSERT_EQ(2, stats.shardStats.size());
+  for (auto& shardStats : stats.shardStats) {
+    EXPECT_TRUE(
+        shardStats.totalSizeInBytes <= 5 || shardStats.objectCount == 1);
+  }
+  // The most recently inserted object always survives.
+  EXPECT_TRUE(cache->contains(object6->getHash()));
+}
+
+TEST(ObjectCache, sharded_interest_handle_drop_evicts_from_owning_shard) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::InterestHandle>::create(
+          100, 0, 8);
+  auto handle3 = cache->insertInterestHandle(
+      object3,
+      ObjectCache<CacheObject, ObjectCacheFlavor::InterestHandle>::Interest::
+          WantHandle);
+  cache->insertInterestHandle(object4);
+  EXPECT_TRUE(cache->contains(hash3));
+  handle3.reset();
+  EXPECT_FALSE(cache->contains(hash3));
+  EXPECT_TRUE(cache->contains(hash4));
+  EXPECT_EQ(1, cache->getStats().dropCount);
+}
+
+/**
+ * TinyLFU admission test cases
+ */
+
+TEST(ObjectCache, tinylfu_rejects_infrequent_objects_when_full) {
+  auto cache = ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(
+      10, 0, 1, ObjectCacheEvictionPolicy::TinyLfu);
+
+  cache->insertSimple(object3);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(object3, cache->getSimple(hash3));
+  }
+  cache->insertSimple(object4);
+
+  // object5 does not fit, and has been seen less often than object3, which
+  // would be the LRU victim.
+  cache->insertSimple(object5);
+  EXPECT_FALSE(cache->contains(hash5));
+  EXPECT_TRUE(cache->contains(hash3));
+  EXPECT_TRUE(cache->contains(hash4));
+
+  auto stats = cache->getStats();
+  EXPECT_EQ(2, stats.insertCount);
+  EXPECT_EQ(1, stats.admissionRejectCount);
+  EXPECT_DOUBLE_EQ(1.0 / 3.0, stats.getAdmissionRejectRate());
+  EXPECT_DOUBLE_EQ(1.0, stats.getHitRate());
+
+  // Once object5 is requested more often than object3, it is admitted.
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(nullptr, cache->getSimple(hash5));
+  }
+  cache->insertSimple(object5);
+  EXPECT_TRUE(cache->contains(hash5));
+  EXPECT_FALSE(cache->contains(hash3));
+  EXPECT_TRUE(cache->contains(hash4));
+}
+
+TEST(ObjectCache, tinylfu_admits_everything_while_not_full) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::InterestHandle>::create(
+          100, 0, 1, ObjectCacheEvictionPolicy::TinyLfu);
+  for (auto& object : {object3, object4, object5, object6, object9}) {
+    cache->insertInterestHandle(object);
+  }
+  for (auto& object : {object3, object4, object5, object6, object9}) {
+    EXPECT_TRUE(cache->contains(object->getHash()));
+  }
+  EXPECT_EQ(0, cache->getStats().admissionRejectCount);
+}
+
+TEST(ObjectCache, tinylfu_rejected_interest_handle_still_returns_object) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::InterestHandle>::create(
+          10, 0, 1, ObjectCacheEvictionPolicy::TinyLfu);
+  cache->insertInterestHandle(object6);
+  EXPECT_EQ(object6, cache->getInterestHandle(hash6).object);
+
+  auto handle = cache->insertInterestHandle(
+      object5,
+      ObjectCache<CacheObject, ObjectCacheFlavor::InterestHandle>::Interest::
+          WantHandle);
+  EXPECT_FALSE(cache->contains(hash5));
+  EXPECT_EQ(object5, handle.getObject());
+  handle.reset();
+  EXPECT_TRUE(cache->contains(hash6));
+}
+
+TEST(ObjectCache, setMaximumSize_evicts_until_it_fits) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(20, 1);
+  cache->insertSimple(object3);
+  cache->insertSimple(object4);
+  cache->insertSimple(object5);
+  cache->insertSimple(object6);
+  EXPECT_EQ(18, cache->getStats().totalSizeInBytes);
+
+  cache->setMaximumSize(11);
+  EXPECT_EQ(11, cache->getMaximumSize());
+  EXPECT_FALSE(cache->contains(object3->getHash()));
+  EXPECT_FALSE(cache->contains(object4->getHash()));
+  EXPECT_TRUE(cache->contains(object5->getHash()));
+  EXPECT_TRUE(cache->contains(object6->getHash()));
+  EXPECT_EQ(2, cache->getStats().evictionCount);
+
+  // New inserts respect the new limit.
+  cache->insertSimple(object9);
+  EXPECT_EQ(9, cache->getStats().totalSizeInBytes);
+
+  cache->setMaximumSize(20);
+  cache->insertSimple(object11);
+  EXPECT_TRUE(cache->contains(object9->getHash()));
+  EXPECT_TRUE(cache->contains(object11->getHash()));
+}
+
+TEST(ObjectCache, setMaximumSize_keeps_minimum_entry_count) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(20, 2);
+  cache->insertSimple(object5);
+  cache->insertSimple(object6);
+  cache->insertSimple(object9);
+
+  cache->setMaximumSize(0);
+  EXPECT_EQ(2, cache->getStats().objectCount);
+  EXPECT_TRUE(cache->contains(object6->getHash()));
+  EXPECT_TRUE(cache->contains(object9->getHash()));
+}
+
+TEST(ObjectCache, getHotKeys_returns_most_recently_used_first) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(100, 1);
+  cache->insertSimple(object3);
+  cache->insertSimple(object4);
+  cache->insertSimple(object5);
+  cache->getSimple(object3->getHash());
+
+  auto keys = cache->getHotKeys(2);
+  ASSERT_EQ(2, keys.size());
+  EXPECT_EQ(hash3, keys[0].id);
+  EXPECT_EQ(hash5, keys[1].id);
+  EXPECT_EQ(0, keys[0].frequency);
+
+  EXPECT_EQ(3, cache->getHotKeys(10).size());
+}
+
+TEST(ObjectCache, getHotKeys_reports_tinylfu_frequency) {
+  auto cache = ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(
+      100, 1, 1, ObjectCacheEvictionPolicy::TinyLfu);
+  cache->insertSimple(object3);
+  cache->insertSimple(object4);
+  cache->getSimple(object3->getHash());
+  cache->getSimple(object3->getHash());
+
+  auto keys = cache->getHotKeys(10);
+  ASSERT_EQ(2, keys.size());
+  EXPECT_EQ(hash3, keys[0].id);
+  EXPECT_GT(keys[0].frequency, keys[1].frequency);
+}
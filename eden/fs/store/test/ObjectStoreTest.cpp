@@ -105,6 +105,38 @@ TEST_F(ObjectStoreTest, getBlob_tracks_second_read_from_cache) {
   EXPECT_EQ(ObjectFetchContext::FromDiskCache, request.origin);
 }
 
+TEST_F(ObjectStoreTest, getBlobRange_caches_pieces) {
+  localStore->enableBlobChunking = true;
+  std::string data(3 * ObjectStore::kBlobRangeSize + 100, '\0');
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<char>(i * 7 + i / 4096);
+  }
+  auto id = putReadyBlob(data);
+
+  auto readRange = [&](uint64_t offset, uint64_t length) {
+    return objectStore->getBlobRange(id, offset, length, context)
+        .get(0ms)
+        ->moveToFbString()
+        .toStdString();
+  };
+
+  // Spans the first two pieces.
+  auto offset = ObjectStore::kBlobRangeSize - 10;
+  EXPECT_EQ(data.substr(offset, 20), readRange(offset, 20));
+  EXPECT_EQ(1, fakeBackingStore->getAccessCount(id));
+
+  // Within the cached pieces, without going back to the stores.
+  localStore->clearKeySpace(KeySpace::BlobFamily);
+  EXPECT_EQ(data.substr(5, 100), readRange(5, 100));
+  EXPECT_EQ(1, fakeBackingStore->getAccessCount(id));
+
+  // The last, short piece comes from the BackingStore again.
+  auto tail = 3 * ObjectStore::kBlobRangeSize + 50;
+  EXPECT_EQ(data.substr(tail), readRange(tail, 4096));
+  EXPECT_EQ("", readRange(data.size() + 1, 10));
+  EXPECT_EQ(2, fakeBackingStore->getAccessCount(id));
+}
+
 TEST_F(ObjectStoreTest, getTree_tracks_backing_store_read) {
   objectStore->getTree(readyTreeId, context).get(0ms);
   ASSERT_EQ(1, context.requests.size());
@@ -138,6 +170,42 @@ TEST_F(ObjectStoreTest, getTree_tracks_second_read_from_local_store) {
   EXPECT_EQ(ObjectFetchContext::FromDiskCache, request.origin);
 }
 
+TEST_F(ObjectStoreTest, prefetchTrees_fetches_subtree_to_depth) {
+  auto* blob = fakeBackingStore->putBlob("data");
+  auto* leaf = fakeBackingStore->putTree({{"leaf_file", blob}});
+  auto* deep = fakeBackingStore->putTree({{"leaf", leaf}});
+  auto* left = fakeBackingStore->putTree({{"deep", deep}});
+  auto* right = fakeBackingStore->putTree({{"right_file", blob}});
+  auto* root = fakeBackingStore->putTree(
+      {{"file", blob}, {"left", left}, {"right", right}});
+  for (auto* tree : {leaf, deep, left, right, root}) {
+    tree->setReady();
+  }
+
+  objectStore->prefetchTrees(root->get().getHash(), 1, 100, context).get(0ms);
+
+  EXPECT_EQ(1, fakeBackingStore->getAccessCount(left->get().getHash()));
+  EXPECT_EQ(1, fakeBackingStore->getAccessCount(right->get().getHash()));
+  EXPECT_EQ(0, fakeBackingStore->getAccessCount(deep->get().getHash()));
+}
+
+TEST_F(ObjectStoreTest, prefetchTrees_stops_at_max_trees) {
+  auto* blob = fakeBackingStore->putBlob("data");
+  auto* left = fakeBackingStore->putTree({{"left_file", blob}});
+  auto* right = fakeBackingStore->putTree({{"right_file", blob}});
+  auto* root = fakeBackingStore->putTree({{"left", left}, {"right", right}});
+  for (auto* tree : {left, right, root}) {
+    tree->setReady();
+  }
+
+  objectStore->prefetchTrees(root->get().getHash(), 1, 2, context).get(0ms);
+
+  EXPECT_EQ(
+      1,
+      fakeBackingStore->getAccessCount(left->get().getHash()) +
+          fakeBackingStore->getAccessCount(right->get().getHash()));
+}
+
 TEST_F(ObjectStoreTest, getBlobSize_tracks_backing_store_read) {
   objectStore->getBlobSize(readyBlobId, context).get(0ms);
   ASSERT_EQ(1, context.requests.size());
@@ -222,6 +290,181 @@ TEST_F(ObjectStoreTest, get_size_and_sha1_only_imports_blob_once) {
   EXPECT_EQ(1, fakeBackingStore->getAccessCount(readyBlobId));
 }
 
+TEST_F(ObjectStoreTest, concurrent_metadata_lookups_are_coalesced) {
+  StoredBlob* storedBlob = fakeBackingStore->putBlob("coalesced");
+  auto id = storedBlob->get().getHash();
+
+  auto sizeFuture = objectStore->getBlobSize(id, context);
+  auto sha1Future = objectStore->getBlobSha1(id, context);
+  EXPECT_FALSE(sizeFuture.isReady());
+  EXPECT_FALSE(sha1Future.isReady());
+
+  storedBlob->setReady();
+  EXPECT_EQ(9, std::move(sizeFuture).get(0ms));
+  EXPECT_EQ(Hash20::sha1("coalesced"_sp), std::move(sha1Future).get(0ms));
+  EXPECT_EQ(1, fakeBackingStore->getAccessCount(id));
+}
+
+TEST_F(ObjectStoreTest, coalesced_metadata_lookups_share_errors) {
+  StoredBlob* storedBlob = fakeBackingStore->putBlob("failing");
+  auto id = storedBlob->get().getHash();
+
+  auto future1 = objectStore->getBlobMetadata(id, context);
+  auto future2 = objectStore->getBlobMetadata(id, context);
+  storedBlob->triggerError(std::runtime_error("import failed"));
+  EXPECT_THROW(std::move(future1).get(0ms), std::runtime_error);
+  EXPECT_THROW(std::move(future2).get(0ms), std::runtime_error);
+
+  // The failed lookup is no longer pending, so a new one is issued.
+  storedBlob->setReady();
+  EXPECT_EQ(7, objectStore->getBlobSize(id, context).get(0ms));
+  EXPECT_EQ(2, fakeBackingStore->getAccessCount(id));
+}
+
+TEST_F(ObjectStoreTest, getBlobMetadataBatch_returns_results_in_order) {
+  auto id1 = putReadyBlob("first");
+  auto id2 = putReadyBlob("second blob");
+  ObjectId missingId;
+
+  auto results =
+      objectStore->getBlobMetadataBatch({id2, missingId, id1}, context)
+          .get(0ms);
+  ASSERT_EQ(3, results.size());
+  EXPECT_EQ(11, results[0].value().size);
+  EXPECT_EQ(Hash20::sha1("second blob"_sp), results[0].value().sha1);
+  EXPECT_TRUE(results[1].hasException<std::domain_error>());
+  EXPECT_EQ(5, results[2].value().size);
+  EXPECT_EQ(Hash20::sha1("first"_sp), results[2].value().sha1);
+}
+
+TEST_F(ObjectStoreTest, getBlobMetadataBatch_reads_local_store) {
+  auto id1 = putReadyBlob("A");
+  auto id2 = putReadyBlob("BB");
+  // Caches the metadata in the local store.
+  objectStore->getBlobMetadataBatch({id1, id2}, context).get(0ms);
+
+  // Without a backing store, only the local store can provide the metadata.
+  objectStore = ObjectStore::create(
+      localStore,
+      nullptr,
+      treeCache,
+      stats,
+      executor,
+      std::make_shared<ProcessNameCache>(),
+      std::make_shared<NullStructuredLogger>(),
+      EdenConfig::createTestEdenConfig());
+
+  auto results =
+      objectStore->getBlobMetadataBatch({id1, id2}, context).get(0ms);
+  ASSERT_EQ(2, results.size());
+  EXPECT_EQ(1, results[0].value().size);
+  EXPECT_EQ(2, results[1].value().size);
+  EXPECT_EQ(ObjectFetchContext::FromDiskCache, context.requests.back().origin);
+}
+
+TEST_F(ObjectStoreTest, getBlobMetadataBatch_shares_pending_lookups) {
+  StoredBlob* storedBlob = fakeBackingStore->putBlob("pending");
+  auto id = storedBlob->get().getHash();
+
+  auto sizeFuture = objectStore->getBlobSize(id, context);
+  auto batchFuture =
+      objectStore->getBlobMetadataBatch({id, readyBlobId, id}, context);
+  EXPECT_FALSE(sizeFuture.isReady());
+  EXPECT_FALSE(batchFuture.isReady());
+
+  storedBlob->setReady();
+  EXPECT_EQ(7, std::move(sizeFuture).get(0ms));
+  auto results = std::move(batchFuture).get(0ms);
+  ASSERT_EQ(3, results.size());
+  EXPECT_EQ(7, results[0].value().size);
+  EXPECT_EQ(9, results[1].value().size);
+  EXPECT_EQ(7, results[2].value().size);
+  EXPECT_EQ(1, fakeBackingStore->getAccessCount(id));
+}
+
+class CancellableFetchContext : public ObjectFetchContext {
+ public:
+  folly::CancellationToken getCancellationToken() const override {
+    return source_.getToken();
+  }
+
+  const std::unordered_map<std::string, std::string>* FOLLY_NULLABLE
+  getRequestInfo() const override {
+    return nullptr;
+  }
+
+  void cancel() {
+    source_.requestCancellation();
+  }
+
+ private:
+  folly::CancellationSource source_;
+};
+
+TEST_F(ObjectStoreTest, coalesced_lookup_survives_one_reader_giving_up) {
+  StoredBlob* storedBlob = fakeBackingStore->putBlob("shared");
+  auto id = storedBlob->get().getHash();
+
+  CancellableFetchContext reader1;
+  CancellableFetchContext reader2;
+  auto future1 = objectStore->getBlobMetadata(id, reader1);
+  auto future2 = objectStore->getBlobMetadata(id, reader2);
+
+  // The reader that started the import is interrupted, but the other one
+  // still waits on it.
+  reader1.cancel();
+  storedBlob->setReady();
+  EXPECT_EQ(6, std::move(future2).get(0ms).size);
+  EXPECT_EQ(6, std::move(future1).get(0ms).size);
+  EXPECT_EQ(1, fakeBackingStore->getAccessCount(id));
+}
+
+TEST_F(ObjectStoreTest, coalesced_lookup_is_cancelled_once_every_reader_is) {
+  StoredBlob* storedBlob = fakeBackingStore->putBlob("shared");
+  auto id = storedBlob->get().getHash();
+
+  CancellableFetchContext reader1;
+  CancellableFetchContext reader2;
+  auto future1 = objectStore->getBlobMetadata(id, reader1);
+  auto future2 = objectStore->getBlobMetadata(id, reader2);
+
+  reader2.cancel();
+  reader1.cancel();
+  storedBlob->setReady();
+  EXPECT_THROW(std::move(future1).get(0ms), folly::OperationCancelled);
+  EXPECT_THROW(std::move(future2).get(0ms), folly::OperationCancelled);
+}
+
+TEST_F(ObjectStoreTest, uncancellable_reader_keeps_coalesced_lookup_alive) {
+  StoredBlob* storedBlob = fakeBackingStore->putBlob("shared");
+  auto id = storedBlob->get().getHash();
+
+  CancellableFetchContext reader;
+  auto future1 = objectStore->getBlobMetadata(id, reader);
+  auto future2 = objectStore->getBlobMetadata(id, context);
+
+  reader.cancel();
+  storedBlob->setReady();
+  EXPECT_EQ(6, std::move(future1).get(0ms).size);
+  EXPECT_EQ(6, std::move(future2).get(0ms).size);
+}
+
+TEST_F(ObjectStoreTest, reader_joining_cancelled_lookup_starts_it_over) {
+  StoredBlob* storedBlob = fakeBackingStore->putBlob("shared");
+  auto id = storedBlob->get().getHash();
+
+  CancellableFetchContext reader1;
+  CancellableFetchContext reader2;
+  auto future1 = objectStore->getBlobMetadata(id, reader1);
+  reader1.cancel();
+  auto future2 = objectStore->getBlobMetadata(id, reader2);
+
+  storedBlob->setReady();
+  EXPECT_THROW(std::move(future1).get(0ms), folly::OperationCancelled);
+  EXPECT_EQ(6, std::move(future2).get(0ms).size);
+  EXPECT_EQ(2, fakeBackingStore->getAccessCount(id));
+}
+
 class PidFetchContext : public ObjectFetchContext {
  public:
   PidFetchContext(pid_t pid) : ObjectFetchContext{}, pid_{pid} {}
@@ -258,3 +501,71 @@ TEST_F(ObjectStoreTest, test_process_access_counts) {
   EXPECT_EQ(2, objectStore->getPidFetches().rlock()->at(pid0));
   EXPECT_EQ(1, objectStore->getPidFetches().rlock()->at(pid1));
 }
+
+struct ObjectStoreNegativeCacheTest : ObjectStoreTest {
+  void SetUp() override {
+    ObjectStoreTest::SetUp();
+    auto edenConfig = EdenConfig::createTestEdenConfig();
+    edenConfig->negativeLookupCacheSize.setValue(
+        100, ConfigSource::Default, true);
+    objectStore = ObjectStore::create(
+        localStore,
+        backingStore,
+        treeCache,
+        stats,
+        executor,
+        std::make_shared<ProcessNameCache>(),
+        std::make_shared<NullStructuredLogger>(),
+        edenConfig);
+  }
+};
+
+TEST_F(ObjectStoreNegativeCacheTest, missing_tree_is_not_fetched_again) {
+  StoredTree* storedTree = fakeBackingStore->putTree({});
+  auto id = storedTree->get().getHash();
+
+  auto future = objectStore->getTree(id, context);
+  storedTree->triggerError(std::domain_error("tree not found"));
+  EXPECT_THROW(std::move(future).get(0ms), std::domain_error);
+  EXPECT_EQ(1, fakeBackingStore->getAccessCount(id));
+
+  EXPECT_THROW_RE(
+      objectStore->getTree(id, context).get(0ms),
+      std::domain_error,
+      "tree .* not found");
+  EXPECT_EQ(1, fakeBackingStore->getAccessCount(id));
+  EXPECT_EQ(1, objectStore->getNegativeLookupCacheStats().hitCount);
+
+  // Once invalidated, the tree is fetched again.
+  objectStore->invalidateNegativeLookupCache();
+  storedTree->setReady();
+  objectStore->getTree(id, context).get(0ms);
+  EXPECT_EQ(2, fakeBackingStore->getAccessCount(id));
+}
+
+TEST_F(ObjectStoreNegativeCacheTest, missing_blob_is_not_fetched_again) {
+  StoredBlob* storedBlob = fakeBackingStore->putBlob("missing");
+  auto id = storedBlob->get().getHash();
+
+  auto future = objectStore->getBlob(id, context);
+  storedBlob->triggerError(std::domain_error("blob not found"));
+  EXPECT_THROW(std::move(future).get(0ms), std::domain_error);
+
+  EXPECT_THROW(objectStore->getBlob(id, context).get(0ms), std::domain_error);
+  EXPECT_THROW(
+      objectStore->getBlobSize(id, context).get(0ms), std::domain_error);
+  EXPECT_EQ(1, fakeBackingStore->getAccessCount(id));
+}
+
+TEST_F(ObjectStoreNegativeCacheTest, other_errors_are_not_cached) {
+  StoredBlob* storedBlob = fakeBackingStore->putBlob("flaky");
+  auto id = storedBlob->get().getHash();
+
+  auto future = objectStore->getBlob(id, context);
+  storedBlob->triggerError(std::runtime_error("network error"));
+  EXPECT_THROW(std::move(future).get(0ms), std::runtime_error);
+
+  storedBlob->setReady();
+  objectStore->getBlob(id, context).get(0ms);
+  EXPECT_EQ(2, fakeBackingStore->getAccessCount(id));
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/store/PackLocalStore.h"
+
+#include <boost/filesystem.hpp>
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
+#include <folly/portability/GTest.h>
+#include <folly/testing/TestUtil.h>
+
+#include "eden/fs/store/StoreResult.h"
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+
+namespace {
+
+struct PackLocalStoreTest : ::testing::Test {
+  AbsolutePath storePath() const {
+    return canonicalPath(tmpDir.path().string()) + "pack"_pc;
+  }
+
+  folly::test::TemporaryDirectory tmpDir;
+};
+
+} // namespace
+
+TEST_F(PackLocalStoreTest, values_survive_reopening) {
+  {
+    PackLocalStore store{storePath()};
+    store.put(KeySpace::BlobFamily, "key"_sp, "first"_sp);
+    store.put(KeySpace::BlobFamily, "key"_sp, "second"_sp);
+    store.put(KeySpace::TreeFamily, "tree"_sp, "tree data"_sp);
+  }
+
+  PackLocalStore store{storePath()};
+  EXPECT_EQ("second", store.get(KeySpace::BlobFamily, "key"_sp).piece());
+  EXPECT_EQ("tree data", store.get(KeySpace::TreeFamily, "tree"_sp).piece());
+  EXPECT_FALSE(store.hasKey(KeySpace::TreeFamily, "key"_sp));
+}
+
+TEST_F(PackLocalStoreTest, truncated_record_is_discarded_on_open) {
+  {
+    PackLocalStore store{storePath()};
+    store.put(KeySpace::BlobFamily, "good"_sp, "complete"_sp);
+    store.put(KeySpace::BlobFamily, "bad"_sp, "truncated"_sp);
+  }
+
+  auto segment = storePath() + "blob.0.pack"_pc;
+  std::string contents;
+  ASSERT_TRUE(folly::readFile(segment.c_str(), contents));
+  contents.resize(contents.size() - 3);
+  ASSERT_TRUE(folly::writeFile(contents, segment.c_str()));
+
+  PackLocalStore store{storePath()};
+  EXPECT_EQ("complete", store.get(KeySpace::BlobFamily, "good"_sp).piece());
+  EXPECT_FALSE(store.hasKey(KeySpace::BlobFamily, "bad"_sp));
+
+  // New records are appended where the truncated one started.
+  store.put(KeySpace::BlobFamily, "bad"_sp, "rewritten"_sp);
+  EXPECT_EQ("rewritten", store.get(KeySpace::BlobFamily, "bad"_sp).piece());
+}
+
+TEST_F(PackLocalStoreTest, writes_roll_over_to_new_segments) {
+  PackLocalStore store{storePath(), /*maxSegmentSize=*/4096};
+  std::string value(1000, 'x');
+  for (int i = 0; i < 10; ++i) {
+    store.put(
+        KeySpace::BlobFamily,
+        folly::StringPiece{folly::to<std::string>("key", i)},
+        folly::StringPiece{value});
+  }
+  EXPECT_TRUE(boost::filesystem::exists(
+      (storePath() + "blob.2.pack"_pc).as_boost()));
+
+  // Values larger than a segment get a segment of their own.
+  std::string large(10000, 'y');
+  store.put(KeySpace::BlobFamily, "large"_sp, folly::StringPiece{large});
+  EXPECT_EQ(large, store.get(KeySpace::BlobFamily, "large"_sp).piece());
+  EXPECT_EQ(value, store.get(KeySpace::BlobFamily, "key3"_sp).piece());
+}
+
+TEST_F(PackLocalStoreTest, compaction_reclaims_overwritten_records) {
+  PackLocalStore store{storePath()};
+  for (int i = 0; i < 100; ++i) {
+    store.put(
+        KeySpace::BlobFamily,
+        "key"_sp,
+        folly::StringPiece{folly::to<std::string>("value", i)});
+  }
+  store.put(KeySpace::BlobFamily, "other"_sp, "other value"_sp);
+  auto before = store.getSegmentBytes(KeySpace::BlobFamily);
+
+  store.compactKeySpace(KeySpace::BlobFamily);
+  EXPECT_LT(store.getSegmentBytes(KeySpace::BlobFamily), before / 10);
+  EXPECT_EQ("value99", store.get(KeySpace::BlobFamily, "key"_sp).piece());
+  EXPECT_EQ("other value", store.get(KeySpace::BlobFamily, "other"_sp).piece());
+
+  // An already compact key space is left alone.
+  auto after = store.getSegmentBytes(KeySpace::BlobFamily);
+  store.compactKeySpace(KeySpace::BlobFamily);
+  EXPECT_EQ(after, store.getSegmentBytes(KeySpace::BlobFamily));
+}
+
+TEST_F(PackLocalStoreTest, extracted_iobuf_outlives_clear) {
+  PackLocalStore store{storePath()};
+  store.put(KeySpace::BlobFamily, "key"_sp, "mapped value"_sp);
+
+  auto buf = store.get(KeySpace::BlobFamily, "key"_sp).extractIOBuf();
+  store.clearKeySpace(KeySpace::BlobFamily);
+  EXPECT_FALSE(store.hasKey(KeySpace::BlobFamily, "key"_sp));
+  EXPECT_EQ("mapped value", buf.moveToFbString());
+}
+
+#endif
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/ProcessFetchRates.h"
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+TEST(ProcessFetchRates, steady_fetches_converge_to_their_rate) {
+  ProcessFetchRates rates;
+  auto now = ProcessFetchRates::Clock::now();
+  // 100 fetches of 1000 bytes a second for 10 windows.
+  for (int i = 0; i < 10000; ++i) {
+    rates.record(1, 1000, 10s, now);
+    now += 10ms;
+  }
+  auto result = rates.get(1, 10s, now);
+  EXPECT_NEAR(100.0, result.requestsPerSecond, 1.0);
+  EXPECT_NEAR(100000.0, result.bytesPerSecond, 1000.0);
+
+  EXPECT_EQ(0.0, rates.get(2, 10s, now).requestsPerSecond);
+}
+
+TEST(ProcessFetchRates, rates_decay_when_idle) {
+  ProcessFetchRates rates;
+  auto now = ProcessFetchRates::Clock::now();
+  auto initial = rates.record(1, 0, 1s, now);
+  EXPECT_DOUBLE_EQ(1.0, initial.requestsPerSecond);
+  EXPECT_NEAR(
+      initial.requestsPerSecond / 2.0,
+      rates.get(1, 1s, now + 693ms).requestsPerSecond,
+      0.01);
+  EXPECT_LT(rates.get(1, 1s, now + 5s).requestsPerSecond, 0.01);
+}
+
+TEST(ProcessFetchRates, idle_processes_are_forgotten) {
+  ProcessFetchRates rates{2};
+  auto now = ProcessFetchRates::Clock::now();
+  rates.record(1, 0, 1s, now);
+  rates.record(2, 0, 1s, now + 20s);
+  EXPECT_EQ(1, rates.getAll(1s, now + 20s).size());
+
+  // The map is full, so recording pid 3 prunes the idle pid 1.
+  rates.record(3, 0, 1s, now + 20s);
+  EXPECT_EQ(0.0, rates.get(1, 1s, now + 20s).requestsPerSecond);
+  EXPECT_EQ(2, rates.getAll(1s, now + 20s).size());
+
+  rates.clear();
+  EXPECT_TRUE(rates.getAll(1s, now + 20s).empty());
+}
@@ -6,6 +6,9 @@
  */
 
 #include "eden/fs/store/RocksDbLocalStore.h"
+
+#include <fb303/ServiceData.h>
+
 #include "eden/fs/store/test/LocalStoreTest.h"
 #include "eden/fs/telemetry/NullStructuredLogger.h"
 
@@ -31,3 +34,100 @@ INSTANTIATE_TEST_CASE_P(
 #pragma clang diagnostic pop
 
 } // namespace
+
+TEST(RocksDbLocalStore, evictColdKeys_keeps_recently_used_keys) {
+  using namespace folly::string_piece_literals;
+
+  FaultInjector faultInjector{/*enabled=*/false};
+  auto tempDir = makeTempDir();
+  auto path = AbsolutePathPiece{tempDir.path().string()};
+
+  {
+    auto store = std::make_shared<RocksDbLocalStore>(
+        path, std::make_shared<NullStructuredLogger>(), &faultInjector);
+    store->put(KeySpace::BlobFamily, "hot"_sp, "hot value"_sp);
+    store->put(KeySpace::BlobFamily, "cold1"_sp, "cold value"_sp);
+    store->put(KeySpace::BlobFamily, "cold2"_sp, "cold value"_sp);
+  }
+
+  // A freshly opened store hasn't seen any of the keys yet.
+  auto store = std::make_shared<RocksDbLocalStore>(
+      path, std::make_shared<NullStructuredLogger>(), &faultInjector);
+  EXPECT_TRUE(store->get(KeySpace::BlobFamily, "hot"_sp).isValid());
+
+  EXPECT_EQ(2, store->evictColdKeys(KeySpace::BlobFamily, 0));
+  EXPECT_TRUE(store->get(KeySpace::BlobFamily, "hot"_sp).isValid());
+  EXPECT_FALSE(store->get(KeySpace::BlobFamily, "cold1"_sp).isValid());
+  EXPECT_FALSE(store->get(KeySpace::BlobFamily, "cold2"_sp).isValid());
+
+  // Keys written through this store count as recently used.
+  store->put(KeySpace::BlobFamily, "new"_sp, "new value"_sp);
+  EXPECT_EQ(0, store->evictColdKeys(KeySpace::BlobFamily, 0));
+  EXPECT_TRUE(store->get(KeySpace::BlobFamily, "new"_sp).isValid());
+}
+
+TEST(RocksDbLocalStore, records_per_keyspace_stats) {
+  using namespace folly::string_piece_literals;
+
+  FaultInjector faultInjector{/*enabled=*/false};
+  auto tempDir = makeTempDir();
+  auto store = std::make_shared<RocksDbLocalStore>(
+      AbsolutePathPiece{tempDir.path().string()},
+      std::make_shared<NullStructuredLogger>(),
+      &faultInjector);
+
+  auto data = facebook::fb303::ServiceData::get();
+  data->getQuantileStatMap()->flushAll();
+  auto before = data->getCounters();
+
+  store->put(KeySpace::TreeFamily, "tree"_sp, "tree value"_sp);
+  EXPECT_TRUE(store->get(KeySpace::TreeFamily, "tree"_sp).isValid());
+  EXPECT_FALSE(store->get(KeySpace::TreeFamily, "missing"_sp).isValid());
+
+  data->getQuantileStatMap()->flushAll();
+  auto after = data->getCounters();
+  auto delta = [&](const std::string& key) {
+    return after[key] - before[key];
+  };
+  EXPECT_EQ(1, delta("local_store.tree.put_us.count"));
+  EXPECT_EQ(10, delta("local_store.tree.put_bytes.sum"));
+  EXPECT_EQ(2, delta("local_store.tree.get_us.count"));
+  EXPECT_EQ(10, delta("local_store.tree.get_bytes.sum"));
+  EXPECT_EQ(0, delta("local_store.blob.get_us.count"));
+
+  // RocksDB's own statistics are published when the store is opened.
+  EXPECT_EQ(1, after.count("local_store.rocksdb.block_cache_hit_rate"));
+  EXPECT_EQ(1, after.count("local_store.tree.pending_compaction_bytes"));
+}
+
+TEST(RocksDbLocalStore, compaction_job_clears_caches_and_can_be_cancelled) {
+  using namespace folly::string_piece_literals;
+
+  FaultInjector faultInjector{/*enabled=*/false};
+  auto tempDir = makeTempDir();
+  auto store = std::make_shared<RocksDbLocalStore>(
+      AbsolutePathPiece{tempDir.path().string()},
+      std::make_shared<NullStructuredLogger>(),
+      &faultInjector);
+  store->put(KeySpace::BlobFamily, "blob"_sp, "blob value"_sp);
+  store->put(KeySpace::HgProxyHashFamily, "proxy"_sp, "proxy hash"_sp);
+
+  auto job = store->startCompaction(/*clearCaches=*/true);
+  job->wait();
+  EXPECT_TRUE(job->isDone());
+  EXPECT_EQ(KeySpace::kAll.size(), job->getTotalKeySpaces());
+  EXPECT_EQ(job->getTotalKeySpaces(), job->getCompletedKeySpaces());
+  EXPECT_FALSE(store->hasKey(KeySpace::BlobFamily, "blob"_sp));
+  EXPECT_TRUE(store->hasKey(KeySpace::HgProxyHashFamily, "proxy"_sp));
+
+  job = store->startCompaction(/*clearCaches=*/false);
+  job->cancel();
+  job->wait();
+  if (job->isCancelled()) {
+    EXPECT_LE(job->getCompletedKeySpaces(), job->getTotalKeySpaces());
+  }
+
+  // Cancelling doesn't prevent later compactions.
+  store->compactStorage();
+  EXPECT_TRUE(store->hasKey(KeySpace::HgProxyHashFamily, "proxy"_sp));
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/SharedLocalStore.h"
+
+#include <folly/portability/GTest.h>
+#include <folly/portability/SysStat.h>
+#include <folly/testing/TestUtil.h>
+
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/SqliteLocalStore.h"
+#include "eden/fs/store/StoreResult.h"
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+
+namespace {
+
+struct SharedLocalStoreTest : ::testing::Test {
+  /**
+   * Open the shared store the way another daemon would: with its own
+   * private store and its own connection to the shared database.
+   */
+  std::unique_ptr<SharedLocalStore> openDaemonStore() const {
+    return std::make_unique<SharedLocalStore>(
+        std::make_shared<MemoryLocalStore>(),
+        std::make_shared<SqliteLocalStore>(
+            canonicalPath(tmpDir.path().string()) + "shared"_pc));
+  }
+
+  folly::test::TemporaryDirectory tmpDir;
+};
+
+} // namespace
+
+TEST_F(SharedLocalStoreTest, caches_are_shared_between_daemons) {
+  auto first = openDaemonStore();
+  auto second = openDaemonStore();
+
+  first->put(KeySpace::BlobFamily, "blob"_sp, "contents"_sp);
+  auto batch = first->beginWrite();
+  batch->put(KeySpace::TreeFamily, "tree"_sp, "entries"_sp);
+  batch->flush();
+
+  EXPECT_EQ("contents", second->get(KeySpace::BlobFamily, "blob"_sp).piece());
+  EXPECT_EQ("entries", second->get(KeySpace::TreeFamily, "tree"_sp).piece());
+}
+
+TEST_F(SharedLocalStoreTest, persistent_key_spaces_stay_private) {
+  auto first = openDaemonStore();
+  auto second = openDaemonStore();
+
+  auto batch = first->beginWrite();
+  batch->put(KeySpace::HgProxyHashFamily, "proxy"_sp, "path and rev"_sp);
+  batch->flush();
+  EXPECT_TRUE(first->hasKey(KeySpace::HgProxyHashFamily, "proxy"_sp));
+  EXPECT_FALSE(second->hasKey(KeySpace::HgProxyHashFamily, "proxy"_sp));
+
+  // Clearing the shared caches leaves the private data alone.
+  second->clearCaches();
+  EXPECT_TRUE(first->hasKey(KeySpace::HgProxyHashFamily, "proxy"_sp));
+}
+
+TEST_F(SharedLocalStoreTest, compaction_reaches_the_shared_store) {
+  auto first = openDaemonStore();
+  auto second = openDaemonStore();
+
+  first->put(KeySpace::BlobFamily, "blob"_sp, "contents"_sp);
+  first->put(KeySpace::HgProxyHashFamily, "proxy"_sp, "path and rev"_sp);
+  auto job = first->startCompaction(/*clearCaches=*/true);
+  job->wait();
+  EXPECT_TRUE(job->isDone());
+  EXPECT_FALSE(second->hasKey(KeySpace::BlobFamily, "blob"_sp));
+  EXPECT_TRUE(first->hasKey(KeySpace::HgProxyHashFamily, "proxy"_sp));
+}
+
+#ifndef _WIN32
+TEST_F(SharedLocalStoreTest, only_private_directories_are_shared) {
+  auto dir = canonicalPath(tmpDir.path().string());
+  ASSERT_EQ(0, chmod(dir.c_str(), 0700));
+  SharedLocalStore::checkSharedDirectory(dir);
+
+  ASSERT_EQ(0, chmod(dir.c_str(), 0777));
+  EXPECT_THROW(SharedLocalStore::checkSharedDirectory(dir), std::runtime_error);
+}
+#endif
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/SqliteLocalStore.h"
+
+#include <folly/portability/GTest.h>
+#include <folly/testing/TestUtil.h>
+
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/store/StoreResult.h"
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+
+namespace {
+
+struct SqliteLocalStoreTest : ::testing::Test {
+  AbsolutePath storePath() const {
+    return canonicalPath(tmpDir.path().string()) + "sqlite"_pc;
+  }
+
+  folly::test::TemporaryDirectory tmpDir;
+};
+
+} // namespace
+
+TEST_F(SqliteLocalStoreTest, write_batch_flushes_once_buffer_is_full) {
+  SqliteLocalStore store{storePath()};
+  auto batch = store.beginWrite(/*bufSize=*/32);
+
+  batch->put(KeySpace::BlobFamily, "small"_sp, "value"_sp);
+  EXPECT_FALSE(store.hasKey(KeySpace::BlobFamily, "small"_sp));
+
+  std::string large(64, 'x');
+  batch->put(KeySpace::TreeFamily, "large"_sp, folly::StringPiece{large});
+  EXPECT_EQ("value", store.get(KeySpace::BlobFamily, "small"_sp).piece());
+  EXPECT_EQ(large, store.get(KeySpace::TreeFamily, "large"_sp).piece());
+
+  batch->put(KeySpace::BlobFamily, "last"_sp, "value"_sp);
+  EXPECT_FALSE(store.hasKey(KeySpace::BlobFamily, "last"_sp));
+  batch->flush();
+  EXPECT_TRUE(store.hasKey(KeySpace::BlobFamily, "last"_sp));
+}
+
+TEST_F(SqliteLocalStoreTest, values_survive_reopening) {
+  {
+    SqliteLocalStore store{storePath()};
+    store.put(KeySpace::BlobFamily, "key"_sp, "value"_sp);
+    auto batch = store.beginWrite();
+    batch->put(KeySpace::TreeFamily, "tree"_sp, "tree data"_sp);
+    batch->flush();
+  }
+
+  SqliteLocalStore store{storePath()};
+  EXPECT_EQ("value", store.get(KeySpace::BlobFamily, "key"_sp).piece());
+  EXPECT_EQ("tree data", store.get(KeySpace::TreeFamily, "tree"_sp).piece());
+}
+
+TEST_F(SqliteLocalStoreTest, use_after_close_throws) {
+  SqliteLocalStore store{storePath()};
+  store.put(KeySpace::BlobFamily, "key"_sp, "value"_sp);
+  store.close();
+  EXPECT_THROW(store.get(KeySpace::BlobFamily, "key"_sp), std::logic_error);
+}
+
+TEST_F(SqliteLocalStoreTest, key_spaces_over_their_limit_are_cleared) {
+  SqliteLocalStore store{storePath()};
+  std::string blob(8192, 'x');
+  store.put(KeySpace::BlobFamily, "blob"_sp, folly::StringPiece{blob});
+  store.put(KeySpace::TreeFamily, "tree"_sp, "entries"_sp);
+
+  std::shared_ptr<EdenConfig> config{EdenConfig::createTestEdenConfig()};
+  config->localStoreBlobSizeLimit.setValue(4096, ConfigSource::Default, true);
+  store.periodicManagementTask(*config);
+  EXPECT_FALSE(store.hasKey(KeySpace::BlobFamily, "blob"_sp));
+  EXPECT_TRUE(store.hasKey(KeySpace::TreeFamily, "tree"_sp));
+}
@@ -7,6 +7,8 @@
 
 #include "folly/portability/GTest.h"
 
+#include <folly/compression/Compression.h>
+
 #include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/config/ReloadableConfig.h"
 #include "eden/fs/model/Tree.h"
@@ -180,3 +182,63 @@ TEST_F(TreeCacheTest, testSizeOverflowLargeInsert) {
   EXPECT_TRUE(cache->contains(tree4->getHash()));
   EXPECT_EQ(tree4, cache->get(tree4->getHash()));
 }
+
+struct TreeCacheCompressedTierTest : ::testing::Test {
+ protected:
+  std::shared_ptr<ReloadableConfig> edenConfig;
+  std::shared_ptr<TreeCache> cache;
+
+  void SetUp() override {
+    if (!folly::io::hasCodec(folly::io::CodecType::LZ4_VARINT_SIZE)) {
+      GTEST_SKIP() << "LZ4 is not available";
+    }
+
+    std::shared_ptr<EdenConfig> rawEdenConfig{
+        EdenConfig::createTestEdenConfig()};
+
+    rawEdenConfig->inMemoryTreeCacheSize.setValue(
+        cacheMaxSize, ConfigSource::Default, true);
+    rawEdenConfig->inMemoryTreeCacheMinElements.setValue(
+        cacheMinEntries, ConfigSource::Default, true);
+    rawEdenConfig->inMemoryTreeCompressedCacheSize.setValue(
+        1024 * 1024, ConfigSource::Default, true);
+
+    edenConfig = std::make_shared<ReloadableConfig>(
+        rawEdenConfig, ConfigReloadBehavior::NoReload);
+
+    cache = TreeCache::create(edenConfig);
+  }
+};
+
+TEST_F(
+    TreeCacheCompressedTierTest,
+    evicted_trees_are_served_from_compressed_tier) {
+  cache->insert(tree0);
+  cache->insert(tree1);
+  cache->insert(tree2);
+  cache->insert(tree3);
+
+  EXPECT_FALSE(cache->contains(tree0->getHash()));
+  EXPECT_TRUE(cache->compressedTierContains(tree0->getHash()));
+  EXPECT_EQ(1, cache->getCompressedTierStats().entryCount);
+
+  auto tree = cache->get(tree0->getHash());
+  ASSERT_NE(nullptr, tree);
+  EXPECT_EQ(*tree0, *tree);
+
+  // The inflated tree moved back to the primary tier, pushing out tree1.
+  EXPECT_TRUE(cache->contains(tree0->getHash()));
+  EXPECT_FALSE(cache->compressedTierContains(tree0->getHash()));
+  EXPECT_FALSE(cache->contains(tree1->getHash()));
+  EXPECT_TRUE(cache->compressedTierContains(tree1->getHash()));
+
+  auto stats = cache->getCompressedTierStats();
+  EXPECT_EQ(1, stats.hitCount);
+  EXPECT_EQ(1, stats.entryCount);
+}
+
+TEST_F(TreeCacheCompressedTierTest, missing_trees_miss_both_tiers) {
+  cache->insert(tree0);
+  EXPECT_EQ(nullptr, cache->get(tree1->getHash()));
+  EXPECT_EQ(1, cache->getCompressedTierStats().missCount);
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/TreeDiffCache.h"
+#include <folly/portability/GTest.h>
+#include <array>
+
+using namespace facebook::eden;
+
+namespace {
+ObjectId makeId(uint8_t n) {
+  std::array<uint8_t, 20> bytes{};
+  bytes[19] = n;
+  return ObjectId{folly::ByteRange{bytes.data(), bytes.size()}};
+}
+
+ScmStatus makeStatus(std::string path, ScmFileStatus fileStatus) {
+  ScmStatus status;
+  status.entries_ref()->emplace(std::move(path), fileStatus);
+  return status;
+}
+
+constexpr auto kSensitive = CaseSensitivity::Sensitive;
+constexpr auto kInsensitive = CaseSensitivity::Insensitive;
+} // namespace
+
+TEST(TreeDiffCache, get_returns_inserted_diffs) {
+  TreeDiffCache cache{1024 * 1024};
+  EXPECT_EQ(nullptr, cache.getTrees(makeId(1), makeId(2), kSensitive));
+
+  auto status = makeStatus("a.txt", ScmFileStatus::MODIFIED);
+  cache.insertTrees(makeId(1), makeId(2), kSensitive, status);
+  cache.insertRoots(
+      RootId{"1"},
+      RootId{"2"},
+      kSensitive,
+      makeStatus("b/a.txt", ScmFileStatus::ADDED));
+
+  auto cached = cache.getTrees(makeId(1), makeId(2), kSensitive);
+  ASSERT_NE(nullptr, cached);
+  EXPECT_EQ(status, *cached);
+  EXPECT_NE(nullptr, cache.getRoots(RootId{"1"}, RootId{"2"}, kSensitive));
+
+  // Diffs are directed, and depend on case sensitivity.
+  EXPECT_EQ(nullptr, cache.getTrees(makeId(2), makeId(1), kSensitive));
+  EXPECT_EQ(nullptr, cache.getTrees(makeId(1), makeId(2), kInsensitive));
+  EXPECT_EQ(nullptr, cache.getRoots(RootId{"2"}, RootId{"1"}, kSensitive));
+
+  cache.clear();
+  EXPECT_EQ(nullptr, cache.getTrees(makeId(1), makeId(2), kSensitive));
+  // Evicted diffs stay valid for as long as they are used.
+  EXPECT_EQ(status, *cached);
+}
+
+TEST(TreeDiffCache, pairs_of_ids_do_not_collide) {
+  TreeDiffCache cache{1024 * 1024};
+  cache.insertRoots(
+      RootId{"ab"},
+      RootId{"c"},
+      kSensitive,
+      makeStatus("x", ScmFileStatus::ADDED));
+  EXPECT_EQ(nullptr, cache.getRoots(RootId{"a"}, RootId{"bc"}, kSensitive));
+}
+
+TEST(TreeDiffCache, size_is_bounded) {
+  TreeDiffCache cache{64 * 1024};
+  for (uint8_t n = 0; n < 100; ++n) {
+    cache.insertTrees(
+        makeId(n),
+        makeId(n + 1),
+        kSensitive,
+        makeStatus(std::string(1024, 'x'), ScmFileStatus::ADDED));
+  }
+  EXPECT_EQ(nullptr, cache.getTrees(makeId(0), makeId(1), kSensitive));
+  EXPECT_NE(nullptr, cache.getTrees(makeId(99), makeId(100), kSensitive));
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/WriteBehindLocalStore.h"
+
+#include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
+#include <atomic>
+#include <thread>
+
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/StoreResult.h"
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+using namespace std::chrono_literals;
+
+namespace {
+
+/**
+ * A MemoryLocalStore whose writes wait until the test allows them.
+ */
+class BlockingLocalStore : public MemoryLocalStore {
+ public:
+  void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value)
+      override {
+    if (keySpace->isEphemeral()) {
+      unblock.wait();
+    }
+    MemoryLocalStore::put(keySpace, key, value);
+  }
+
+  folly::Baton<> unblock;
+};
+
+} // namespace
+
+TEST(WriteBehindLocalStoreTest, buffered_values_are_readable) {
+  auto backend = std::make_shared<BlockingLocalStore>();
+  WriteBehindLocalStore store{backend, /*capacityBytes=*/1024};
+
+  store.put(KeySpace::BlobFamily, "key"_sp, "value"_sp);
+  EXPECT_EQ("value", store.get(KeySpace::BlobFamily, "key"_sp).piece());
+  EXPECT_TRUE(store.hasKey(KeySpace::BlobFamily, "key"_sp));
+  EXPECT_FALSE(backend->hasKey(KeySpace::BlobFamily, "key"_sp));
+
+  auto results =
+      store.getBatch(KeySpace::BlobFamily, {"key"_sp, "missing"_sp}).get(10s);
+  EXPECT_EQ("value", results[0].piece());
+  EXPECT_FALSE(results[1].isValid());
+
+  backend->unblock.post();
+  store.flush();
+  EXPECT_EQ(0, store.getBufferedBytes());
+  EXPECT_EQ("value", backend->get(KeySpace::BlobFamily, "key"_sp).piece());
+}
+
+TEST(WriteBehindLocalStoreTest, persistent_key_spaces_are_written_through) {
+  auto backend = std::make_shared<BlockingLocalStore>();
+  WriteBehindLocalStore store{backend, /*capacityBytes=*/1024};
+
+  store.put(KeySpace::HgProxyHashFamily, "key"_sp, "proxy hash"_sp);
+  EXPECT_EQ(0, store.getBufferedBytes());
+  EXPECT_TRUE(backend->hasKey(KeySpace::HgProxyHashFamily, "key"_sp));
+  backend->unblock.post();
+}
+
+TEST(WriteBehindLocalStoreTest, put_blocks_while_buffer_is_full) {
+  auto backend = std::make_shared<BlockingLocalStore>();
+  WriteBehindLocalStore store{backend, /*capacityBytes=*/100};
+  std::string value(60, 'x');
+
+  store.put(KeySpace::BlobFamily, "first"_sp, folly::StringPiece{value});
+
+  std::atomic<bool> secondPutDone{false};
+  std::thread writer{[&] {
+    store.put(KeySpace::BlobFamily, "second"_sp, folly::StringPiece{value});
+    secondPutDone = true;
+  }};
+
+  /* sleep override */
+  std::this_thread::sleep_for(50ms);
+  EXPECT_FALSE(secondPutDone);
+  EXPECT_EQ(value, store.get(KeySpace::BlobFamily, "first"_sp).piece());
+
+  backend->unblock.post();
+  writer.join();
+  EXPECT_TRUE(secondPutDone);
+
+  store.close();
+  EXPECT_EQ(value, backend->get(KeySpace::BlobFamily, "second"_sp).piece());
+}
@@ -10,6 +10,7 @@
 #include "eden/fs/takeover/TakeoverClient.h"
 
 #include <folly/io/Cursor.h>
+#include <folly/io/IOBufQueue.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/logging/xlog.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
@@ -32,6 +33,30 @@ DEFINE_int32(
 namespace facebook {
 namespace eden {
 
+namespace {
+
+/**
+ * Receive the rest of the takeover data if msg is the first CHUNK of it, and
+ * return it as a single message.
+ */
+folly::Future<UnixSocket::Message> receiveChunks(
+    FutureUnixSocket& socket,
+    std::shared_ptr<folly::IOBufQueue> chunks,
+    UnixSocket::Message&& msg) {
+  if (!TakeoverData::isChunk(&msg.data)) {
+    TakeoverData::joinChunks(*chunks, msg);
+    return std::move(msg);
+  }
+  TakeoverData::appendChunk(*chunks, std::move(msg.data));
+  auto timeout = std::chrono::seconds(FLAGS_takeoverReceiveTimeout);
+  return socket.receive(timeout).thenValue(
+      [&socket, chunks](UnixSocket::Message&& next) {
+        return receiveChunks(socket, chunks, std::move(next));
+      });
+}
+
+} // namespace
+
 TakeoverData takeoverMounts(
     AbsolutePathPiece socketPath,
     bool shouldPing,
@@ -82,6 +107,10 @@ TakeoverData takeoverMounts(
           return folly::makeFuture<UnixSocket::Message>(std::move(msg));
         }
       })
+      .thenValue([&socket](UnixSocket::Message&& msg) {
+        return receiveChunks(
+            socket, std::make_shared<folly::IOBufQueue>(), std::move(msg));
+      })
       .thenValue([&expectedMessage](UnixSocket::Message&& msg) {
         expectedMessage = std::move(msg);
       })
@@ -16,6 +16,7 @@
 #include <folly/Format.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
+#include <folly/io/IOBufQueue.h>
 #include <folly/logging/xlog.h>
 
 #include <thrift/lib/cpp2/protocol/Serializer.h>
@@ -54,7 +55,8 @@ const std::set<int32_t> kSupportedTakeoverVersions{
     TakeoverData::kTakeoverProtocolVersionThree,
     TakeoverData::kTakeoverProtocolVersionFour,
     TakeoverData::kTakeoverProtocolVersionFive,
-    TakeoverData::kTakeoverProtocolVersionSix};
+    TakeoverData::kTakeoverProtocolVersionSix,
+    TakeoverData::kTakeoverProtocolVersionSeven};
 
 std::optional<int32_t> TakeoverData::computeCompatibleVersion(
     const std::set<int32_t>& versions,
@@ -103,6 +105,15 @@ uint64_t TakeoverData::versionToCapabilites(int32_t version) {
           TakeoverCapabilities::RESULT_TYPE_SERIALIZATION |
           TakeoverCapabilities::ORDERED_FDS |
           TakeoverCapabilities::OPTIONAL_MOUNTD;
+    case kTakeoverProtocolVersionSeven:
+      return TakeoverCapabilities::FUSE | TakeoverCapabilities::MOUNT_TYPES |
+          TakeoverCapabilities::PING |
+          TakeoverCapabilities::THRIFT_SERIALIZATION |
+          TakeoverCapabilities::NFS |
+          TakeoverCapabilities::RESULT_TYPE_SERIALIZATION |
+          TakeoverCapabilities::ORDERED_FDS |
+          TakeoverCapabilities::OPTIONAL_MOUNTD |
+          TakeoverCapabilities::CHUNKED_MESSAGE;
   }
   throw std::runtime_error(fmt::format("Unsupported version: {}", version));
 }
@@ -144,6 +155,17 @@ int32_t TakeoverData::capabilitesToVersion(uint64_t capabilities) {
     return kTakeoverProtocolVersionSix;
   }
 
+  if (capabilities ==
+      (TakeoverCapabilities::FUSE | TakeoverCapabilities::MOUNT_TYPES |
+       TakeoverCapabilities::PING | TakeoverCapabilities::THRIFT_SERIALIZATION |
+       TakeoverCapabilities::NFS |
+       TakeoverCapabilities::RESULT_TYPE_SERIALIZATION |
+       TakeoverCapabilities::ORDERED_FDS |
+       TakeoverCapabilities::OPTIONAL_MOUNTD |
+       TakeoverCapabilities::CHUNKED_MESSAGE)) {
+    return kTakeoverProtocolVersionSeven;
+  }
+
   throw std::runtime_error(
       fmt::format("Unsupported combination of capabilities: {}", capabilities));
 }
@@ -287,6 +309,65 @@ folly::IOBuf TakeoverData::serializePing() {
   return buf;
 }
 
+std::vector<UnixSocket::Message> TakeoverData::splitIntoChunks(
+    UnixSocket::Message&& msg,
+    size_t chunkSize) {
+  XCHECK_GT(chunkSize, 0u);
+  folly::IOBufQueue data{folly::IOBufQueue::cacheChainLength()};
+  data.append(std::move(msg.data));
+  // The protocol version stays at the start of the last message, which is
+  // the one the client deserializes.
+  auto version = data.split(sizeof(uint32_t));
+
+  std::vector<UnixSocket::Message> messages;
+  while (data.chainLength() > chunkSize) {
+    UnixSocket::Message chunk;
+    chunk.data = IOBuf(IOBuf::CREATE, kHeaderLength);
+    folly::io::Appender app(&chunk.data, 0);
+    app.writeBE<uint32_t>(MessageType::CHUNK);
+    chunk.data.prependChain(data.split(chunkSize));
+    messages.push_back(std::move(chunk));
+  }
+
+  if (!data.empty()) {
+    version->prependChain(data.move());
+  }
+  msg.data = std::move(*version);
+  messages.push_back(std::move(msg));
+  return messages;
+}
+
+bool TakeoverData::isChunk(const IOBuf* buf) {
+  if (buf->computeChainDataLength() >= kHeaderLength) {
+    folly::io::Cursor cursor(buf);
+    return cursor.readBE<uint32_t>() == MessageType::CHUNK;
+  }
+  return false;
+}
+
+void TakeoverData::appendChunk(folly::IOBufQueue& chunks, IOBuf&& buf) {
+  folly::IOBufQueue chunk;
+  chunk.append(std::move(buf));
+  chunk.trimStart(kHeaderLength);
+  chunks.append(chunk.move());
+}
+
+void TakeoverData::joinChunks(
+    folly::IOBufQueue& chunks,
+    UnixSocket::Message& msg) {
+  if (chunks.empty()) {
+    return;
+  }
+  folly::IOBufQueue data;
+  data.append(std::move(msg.data));
+  auto joined = data.split(sizeof(uint32_t));
+  joined->prependChain(chunks.move());
+  if (!data.empty()) {
+    joined->prependChain(data.move());
+  }
+  msg.data = std::move(*joined);
+}
+
 TakeoverData TakeoverData::deserialize(UnixSocket::Message& msg) {
   auto protocolVersion = TakeoverData::getProtocolVersion(&msg.data);
   auto capabilities = TakeoverData::versionToCapabilites(protocolVersion);
@@ -348,6 +429,7 @@ int32_t TakeoverData::getProtocolVersion(IOBuf* buf) {
     case kTakeoverProtocolVersionFour:
     case kTakeoverProtocolVersionFive:
     case kTakeoverProtocolVersionSix:
+    case kTakeoverProtocolVersionSeven:
       // Version 3 (there was no 2 because of how Version 1 used word values
       // 1 and 2) doesn't care about this version byte, so we skip past it
       // and let the underlying code decode the data
@@ -22,6 +22,7 @@
 
 namespace folly {
 class IOBuf;
+class IOBufQueue;
 class exception_wrapper;
 } // namespace folly
 
@@ -97,6 +98,11 @@ class TakeoverCapabilities {
     // does the mountd socket need to be sent.
     // Note this capability can not be used with out ORDERED_FDS.
     OPTIONAL_MOUNTD = 1 << 8,
+
+    // Indicates the takeover data may be split into several messages, each
+    // holding part of the serialized data, so that the InodeMaps of large
+    // mounts don't have to fit in a single message.
+    CHUNKED_MESSAGE = 1 << 9,
   };
 };
 
@@ -153,8 +159,11 @@ class TakeoverData {
 
     // This version introduced a more generic thrift struct for serialization
     // and allows us to only pass some of the file descriptors.
-    kTakeoverProtocolVersionSix = 6
-    // version 6 should be the last real version, we should bump to version 7
+    kTakeoverProtocolVersionSix = 6,
+
+    // This version allows the takeover data to be sent in several messages.
+    kTakeoverProtocolVersionSeven = 7
+    // version 7 should be the last real version, we should bump to version 8
     // and from then on only match capabilities
   };
 
@@ -276,6 +285,34 @@ class TakeoverData {
    */
   static bool isPing(const folly::IOBuf* buf);
 
+  /**
+   * Split a serialized message into messages holding at most chunkSize bytes
+   * of its data each. Every message but the last is a CHUNK. The last one
+   * starts like msg, holds the end of its data and all of its files.
+   *
+   * Only used with CHUNKED_MESSAGE.
+   */
+  static std::vector<UnixSocket::Message> splitIntoChunks(
+      UnixSocket::Message&& msg,
+      size_t chunkSize);
+
+  /**
+   * Checks to see if a message is of type CHUNK, in which case more messages
+   * follow it.
+   */
+  static bool isChunk(const folly::IOBuf* buf);
+
+  /**
+   * Append the data of a CHUNK message to chunks.
+   */
+  static void appendChunk(folly::IOBufQueue& chunks, folly::IOBuf&& buf);
+
+  /**
+   * Put the data of the CHUNK messages received before msg back in front of
+   * the end of the data held by msg, undoing splitIntoChunks().
+   */
+  static void joinChunks(folly::IOBufQueue& chunks, UnixSocket::Message& msg);
+
   /**
    * Determines if we should serialized NFS data given the protocol version
    * we are serializing with. i.e. should we send takeover data for NFS mount
@@ -399,6 +436,9 @@ class TakeoverData {
     ERROR = 1,
     MOUNTS = 2,
     PING = 3,
+    // 4 can't be mistaken for a protocol version: version 4 is advertised as
+    // version 3.
+    CHUNK = 4,
   };
 
   /**
@@ -39,6 +39,12 @@ DEFINE_int32(
     5,
     "Timeout for receiving ready ping from new process in seconds");
 
+DEFINE_uint64(
+    takeoverChunkSize,
+    64 * 1024 * 1024,
+    "Maximum number of bytes of takeover data sent in a single message, when "
+    "the new process supports receiving it in several messages");
+
 namespace facebook {
 namespace eden {
 
@@ -260,7 +266,24 @@ Future<Unit> TakeoverServer::ConnHandler::sendTakeoverData(
   XLOG(INFO) << "Sending takeover data to new process: "
              << msg.data.computeChainDataLength() << " bytes";
 
-  return socket_.send(std::move(msg))
+  std::vector<UnixSocket::Message> messages;
+  if (protocolCapabilities_ & TakeoverCapabilities::CHUNKED_MESSAGE) {
+    messages =
+        TakeoverData::splitIntoChunks(std::move(msg), FLAGS_takeoverChunkSize);
+  } else {
+    messages.push_back(std::move(msg));
+  }
+
+  // The socket sends queued messages in order, so they can all be queued
+  // at once.
+  std::vector<Future<Unit>> sends;
+  sends.reserve(messages.size());
+  for (auto& message : messages) {
+    sends.push_back(socket_.send(std::move(message)));
+  }
+  return folly::collect(sends)
+      .toUnsafeFuture()
+      .unit()
       .thenTry([promise = std::move(data.takeoverComplete)](
                    folly::Try<Unit>&& sendResult) mutable {
         if (sendResult.hasException()) {
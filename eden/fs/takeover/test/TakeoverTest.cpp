@@ -6,12 +6,16 @@
  */
 
 #include <folly/Exception.h>
+#include <folly/ScopeGuard.h>
 #include <folly/experimental/TestUtil.h>
 #include <folly/futures/Future.h>
 #include <folly/futures/Promise.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBufQueue.h>
 #include <folly/portability/GMock.h>
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
+#include <gflags/gflags.h>
 
 #include <eden/fs/takeover/gen-cpp2/takeover_types.h>
 #include "eden/fs/takeover/TakeoverClient.h"
@@ -30,6 +34,8 @@ using ::testing::ElementsAre;
 using ::testing::ElementsAreArray;
 using namespace std::chrono_literals;
 
+DECLARE_uint64(takeoverChunkSize);
+
 namespace {
 /**
  * A TakeoverHandler that returns the TakeoverData object passed to its
@@ -386,6 +392,87 @@ TEST(Takeover, manyMounts) {
   }
 }
 
+TEST(Takeover, chunkedMessage) {
+  TemporaryDirectory tmpDir("eden_takeover_test");
+  AbsolutePathPiece tmpDirPath{tmpDir.path().string()};
+
+  auto oldChunkSize = FLAGS_takeoverChunkSize;
+  FLAGS_takeoverChunkSize = 100;
+  SCOPE_EXIT {
+    FLAGS_takeoverChunkSize = oldChunkSize;
+  };
+
+  TakeoverData serverData;
+  auto lockFilePath = tmpDirPath + "lock"_pc;
+  serverData.lockFile =
+      folly::File{lockFilePath.stringPiece(), O_RDWR | O_CREAT};
+  auto thriftSocketPath = tmpDirPath + "thrift"_pc;
+  serverData.thriftSocket =
+      folly::File{thriftSocketPath.stringPiece(), O_RDWR | O_CREAT};
+
+  constexpr size_t numMounts = 100;
+  for (size_t n = 0; n < numMounts; ++n) {
+    auto fusePath =
+        tmpDirPath + PathComponentPiece{folly::to<string>("fuse", n)};
+    serverData.mountPoints.emplace_back(
+        tmpDirPath + PathComponentPiece{folly::to<string>("mount", n)},
+        tmpDirPath + PathComponentPiece{folly::to<string>("client", n)},
+        std::vector<AbsolutePath>{},
+        FuseChannelData{
+            folly::File{fusePath.stringPiece(), O_RDWR | O_CREAT},
+            fuse_init_out{}},
+        SerializedInodeMap{});
+  }
+
+  // The data is sent in many chunks of 100 bytes, and put back together.
+  auto serverSendFuture = serverData.takeoverComplete.getFuture();
+  TestHandler handler{std::move(serverData)};
+  auto result = runTakeover(tmpDir, &handler);
+  ASSERT_TRUE(serverSendFuture.hasValue());
+  ASSERT_TRUE(result.hasValue());
+  const auto& clientData = result.value();
+
+  checkExpectedFile(clientData.lockFile.fd(), lockFilePath);
+  checkExpectedFile(clientData.thriftSocket.fd(), thriftSocketPath);
+  ASSERT_EQ(numMounts, clientData.mountPoints.size());
+  for (size_t n = 0; n < numMounts; ++n) {
+    const auto& mountInfo = clientData.mountPoints[n];
+    EXPECT_EQ(
+        tmpDirPath + PathComponentPiece{folly::to<string>("mount", n)},
+        mountInfo.mountPath);
+    auto& fuseChannelData = std::get<FuseChannelData>(mountInfo.channelInfo);
+    checkExpectedFile(
+        fuseChannelData.fd.fd(),
+        tmpDirPath + PathComponentPiece{folly::to<string>("fuse", n)});
+  }
+}
+
+TEST(Takeover, splitAndJoinChunks) {
+  UnixSocket::Message msg;
+  msg.data = folly::IOBuf(folly::IOBuf::CREATE, 64);
+  folly::io::Appender app(&msg.data, 0);
+  app.writeBE<uint32_t>(TakeoverData::kTakeoverProtocolVersionSeven);
+  app.push(folly::StringPiece{"0123456789abcdefghij"});
+
+  auto messages = TakeoverData::splitIntoChunks(std::move(msg), 8);
+  ASSERT_EQ(3, messages.size());
+  EXPECT_TRUE(TakeoverData::isChunk(&messages[0].data));
+  EXPECT_TRUE(TakeoverData::isChunk(&messages[1].data));
+  EXPECT_FALSE(TakeoverData::isChunk(&messages[2].data));
+
+  folly::IOBufQueue chunks;
+  TakeoverData::appendChunk(chunks, std::move(messages[0].data));
+  TakeoverData::appendChunk(chunks, std::move(messages[1].data));
+  auto& last = messages[2];
+  TakeoverData::joinChunks(chunks, last);
+
+  folly::io::Cursor cursor(&last.data);
+  EXPECT_EQ(
+      TakeoverData::kTakeoverProtocolVersionSeven, cursor.readBE<uint32_t>());
+  EXPECT_EQ("0123456789abcdefghij", cursor.readFixedString(20));
+  EXPECT_TRUE(cursor.isAtEnd());
+}
+
 TEST(Takeover, error) {
   TemporaryDirectory tmpDir("eden_takeover_test");
   ErrorHandler handler;
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/ChromeTrace.h"
+
+#include <folly/Conv.h>
+#include <folly/container/F14Map.h>
+#include <folly/dynamic.h>
+#include <folly/json.h>
+
+namespace facebook::eden {
+
+namespace {
+
+/** Chrome traces are in microseconds, fractions allowed. */
+double toMicros(std::chrono::nanoseconds ns) {
+  return static_cast<double>(ns.count()) / 1000.0;
+}
+
+folly::dynamic asyncEvent(
+    folly::StringPiece phase,
+    folly::StringPiece category,
+    folly::StringPiece name,
+    uint64_t id,
+    std::chrono::nanoseconds timestamp) {
+  // Ids are strings since JSON numbers can't hold every 64-bit value.
+  return folly::dynamic::object("ph", phase)("cat", category)("name", name)(
+      "id", folly::to<std::string>(id))("ts", toMicros(timestamp))("pid", 0)(
+      "tid", 0);
+}
+
+} // namespace
+
+std::string renderChromeTrace(
+    const std::vector<CompactTracePoint>& points,
+    const std::vector<TraceSpan>& spans) {
+  auto events = folly::dynamic::array();
+
+  // The stop tracepoint has no name, so remember the started blocks.
+  folly::F14FastMap<uint64_t, const char*> started;
+  for (const auto& point : points) {
+    if (point.start) {
+      started.emplace(point.blockId, point.name);
+      auto event = asyncEvent(
+          "b", "trace", point.name, point.traceId, point.timestamp);
+      event["args"] = folly::dynamic::object(
+          "block", point.blockId)("parent", point.parentBlockId);
+      events.push_back(std::move(event));
+    } else if (point.stop) {
+      auto it = started.find(point.blockId);
+      if (it == started.end()) {
+        continue;
+      }
+      events.push_back(asyncEvent(
+          "e", "trace", it->second, point.traceId, point.timestamp));
+      started.erase(it);
+    }
+  }
+
+  for (const auto& span : spans) {
+    auto start = span.start.time_since_epoch();
+    events.push_back(
+        asyncEvent("b", span.category, span.name, span.id, start));
+    events.push_back(asyncEvent(
+        "e", span.category, span.name, span.id, start + span.duration));
+  }
+
+  return folly::toJson(
+      folly::dynamic::object("traceEvents", std::move(events))(
+          "displayTimeUnit", "ns"));
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "eden/fs/telemetry/Tracing.h"
+
+namespace facebook::eden {
+
+/**
+ * Render tracepoints and spans in the Chrome trace event JSON format, which
+ * chrome://tracing and the Perfetto UI both open.
+ *
+ * Every TraceBlock becomes an async slice grouped under its trace id, so that
+ * the blocks of one request stack together, and every span becomes an async
+ * slice under its category. Blocks whose start was overwritten in the rolling
+ * window are left out.
+ */
+std::string renderChromeTrace(
+    const std::vector<CompactTracePoint>& points,
+    const std::vector<TraceSpan>& spans);
+
+} // namespace facebook::eden
@@ -33,6 +33,14 @@ JournalThreadStats& EdenStats::getJournalStatsForCurrentThread() {
   return *threadLocalJournalStats_.get();
 }
 
+LockThreadStats& EdenStats::getLockStatsForCurrentThread() {
+  return *threadLocalLockStats_.get();
+}
+
+ExecutorThreadStats& EdenStats::getExecutorStatsForCurrentThread() {
+  return *threadLocalExecutorStats_.get();
+}
+
 void EdenStats::flush() {
   // This method is only really useful while testing to ensure that the service
   // data singleton instance has the latest stats. Since all our stats are now
@@ -54,7 +62,7 @@ EdenThreadStatsBase::Stat EdenThreadStatsBase::createStat(
   return Stat{
       name,
       fb303::ExportTypeConsts::kSumCountAvgRate,
-      fb303::QuantileConsts::kP1_P10_P50_P90_P99,
+      kStatQuantiles,
       fb303::SlidingWindowPeriodConsts::kOneMinTenMinHour,
   };
 }
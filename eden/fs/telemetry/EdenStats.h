@@ -17,11 +17,20 @@
 namespace facebook {
 namespace eden {
 
+/**
+ * The quantiles exported for every latency Stat. Quantile stats keep a
+ * digest per thread that is merged when exported, so the tail quantiles are
+ * as accurate as the median and cost nothing extra to record.
+ */
+constexpr double kStatQuantiles[] = {0.01, 0.1, 0.5, 0.9, 0.99, 0.999, 0.9999};
+
 class ChannelThreadStats;
 class ObjectStoreThreadStats;
 class HgBackingStoreThreadStats;
 class HgImporterThreadStats;
 class JournalThreadStats;
+class LockThreadStats;
+class ExecutorThreadStats;
 
 class EdenStats {
  public:
@@ -60,6 +69,20 @@ class EdenStats {
    */
   JournalThreadStats& getJournalStatsForCurrentThread();
 
+  /**
+   * This function can be called on any thread.
+   *
+   * The returned object can be used only on the current thread.
+   */
+  LockThreadStats& getLockStatsForCurrentThread();
+
+  /**
+   * This function can be called on any thread.
+   *
+   * The returned object can be used only on the current thread.
+   */
+  ExecutorThreadStats& getExecutorStatsForCurrentThread();
+
   /**
    * This function can be called on any thread.
    */
@@ -78,6 +101,10 @@ class EdenStats {
       threadLocalHgImporterStats_;
   folly::ThreadLocal<JournalThreadStats, ThreadLocalTag, void>
       threadLocalJournalStats_;
+  folly::ThreadLocal<LockThreadStats, ThreadLocalTag, void>
+      threadLocalLockStats_;
+  folly::ThreadLocal<ExecutorThreadStats, ThreadLocalTag, void>
+      threadLocalExecutorStats_;
 };
 
 std::shared_ptr<HgImporterThreadStats> getSharedHgImporterStatsForCurrentThread(
@@ -141,6 +168,10 @@ class ChannelThreadStats : public EdenThreadStatsBase {
   Stat poll{createStat("fuse.poll_us")};
   Stat forgetmulti{createStat("fuse.forgetmulti_us")};
   Stat fallocate{createStat("fuse.fallocate_us")};
+  // Time requests spend queued for the FUSE dispatch pool, per priority lane,
+  // before the per-opcode stats above start timing them.
+  Stat dispatchWaitMetadata{createStat("fuse.dispatch_wait_metadata_us")};
+  Stat dispatchWaitReadWrite{createStat("fuse.dispatch_wait_read_write_us")};
 
   Stat nfsNull{createStat("nfs.null_us")};
   Stat nfsGetattr{createStat("nfs.getattr_us")};
@@ -164,6 +195,10 @@ class ChannelThreadStats : public EdenThreadStatsBase {
   Stat nfsFsinfo{createStat("nfs.fsinfo_us")};
   Stat nfsPathconf{createStat("nfs.pathconf_us")};
   Stat nfsCommit{createStat("nfs.commit_us")};
+  // Time requests spend queued for the NFS thread pool, per priority lane,
+  // before the per-procedure stats above start timing them.
+  Stat nfsDispatchWaitMetadata{createStat("nfs.dispatch_wait_metadata_us")};
+  Stat nfsDispatchWaitData{createStat("nfs.dispatch_wait_data_us")};
 #else
   Stat outOfOrderCreate{createStat("prjfs.out_of_order_create")};
 
@@ -214,6 +249,15 @@ class ObjectStoreThreadStats : public EdenThreadStatsBase {
       createStat("object_store.get_blob_metadata.local_store")};
   Stat getBlobMetadataFromBackingStore{
       createStat("object_store.get_blob_metadata.backing_store")};
+  Stat getBlobMetadataFromBackingStoreAuxData{
+      createStat("object_store.get_blob_metadata.backing_store_aux_data")};
+  Stat getBlobMetadataCoalesced{
+      createStat("object_store.get_blob_metadata.coalesced")};
+
+  Stat getBlobRangeFromMemory{
+      createStat("object_store.get_blob_range.memory")};
+  Stat getBlobRangeFromBackingStore{
+      createStat("object_store.get_blob_range.backing_store")};
 
   Stat getBlobSizeFromLocalStore{
       createStat("object_store.get_blob_size.local_store")};
@@ -230,6 +274,15 @@ class HgBackingStoreThreadStats : public EdenThreadStatsBase {
   Stat hgBackingStoreImportBlob{createStat("store.hg.import_blob")};
   Stat hgBackingStoreGetTree{createStat("store.hg.get_tree")};
   Stat hgBackingStoreImportTree{createStat("store.hg.import_tree")};
+
+  // The stages of a queued import, in microseconds: waiting in the queue,
+  // reading from hgcache or EdenAPI, converting to a Blob or Tree, falling
+  // back to the hg importer, and writing the trees to the LocalStore.
+  Stat queueWait{createStat("store.hg.import.queue_wait_us")};
+  Stat datapackFetch{createStat("store.hg.import.datapack_fetch_us")};
+  Stat deserialize{createStat("store.hg.import.deserialize_us")};
+  Stat importerFetch{createStat("store.hg.import.importer_fetch_us")};
+  Stat localStoreWrite{createStat("store.hg.import.local_store_write_us")};
 };
 
 /**
@@ -252,5 +305,35 @@ class JournalThreadStats : public EdenThreadStatsBase {
   Stat filesAccumulated{createStat("journal.files_accumulated")};
 };
 
+/**
+ * @see LockProfiling.h
+ */
+class LockThreadStats : public EdenThreadStatsBase {
+ public:
+  // Time spent waiting for and then holding the locks most likely to be
+  // contended, in nanoseconds. Only recorded with telemetry:lock-profiling.
+  Stat inodeMapWait{createStat("lock.inode_map.wait_ns")};
+  Stat inodeMapHold{createStat("lock.inode_map.hold_ns")};
+  Stat treeInodeContentsWait{createStat("lock.tree_inode_contents.wait_ns")};
+  Stat treeInodeContentsHold{createStat("lock.tree_inode_contents.hold_ns")};
+  Stat objectCacheWait{createStat("lock.object_cache.wait_ns")};
+  Stat objectCacheHold{createStat("lock.object_cache.hold_ns")};
+  Stat hgImportQueueWait{createStat("lock.hg_import_queue.wait_ns")};
+  Stat hgImportQueueHold{createStat("lock.hg_import_queue.hold_ns")};
+  Stat renameWait{createStat("lock.rename.wait_ns")};
+  Stat renameHold{createStat("lock.rename.hold_ns")};
+
+  using StatPtr = Stat LockThreadStats::*;
+};
+
+class ExecutorThreadStats : public EdenThreadStatsBase {
+ public:
+  // Time tasks spent queued before a thread of the pool picked them up.
+  Stat serverQueueWait{createStat("executor.server.queue_wait_us")};
+  Stat bulkQueueWait{createStat("executor.bulk.queue_wait_us")};
+
+  using StatPtr = Stat ExecutorThreadStats::*;
+};
+
 } // namespace eden
 } // namespace facebook
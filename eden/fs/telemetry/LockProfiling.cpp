@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/LockProfiling.h"
+
+#include <folly/Indestructible.h>
+#include <folly/Synchronized.h>
+#include <vector>
+
+namespace facebook::eden {
+
+namespace detail {
+
+std::atomic<EdenStats*> lockProfilingStats{nullptr};
+
+void recordLockTime(
+    EdenStats& stats,
+    LockThreadStats::StatPtr stat,
+    std::chrono::steady_clock::duration duration) {
+  (stats.getLockStatsForCurrentThread().*stat)
+      .addValue(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(duration)
+              .count());
+}
+
+} // namespace detail
+
+void enableLockProfiling(std::shared_ptr<EdenStats> stats) {
+  // Never released: a lock acquired with the previous stats may still be
+  // recording into them.
+  static folly::Indestructible<
+      folly::Synchronized<std::vector<std::shared_ptr<EdenStats>>>>
+      keptAlive;
+  auto* rawStats = stats.get();
+  keptAlive->wlock()->push_back(std::move(stats));
+  detail::lockProfilingStats.store(rawStats, std::memory_order_relaxed);
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <utility>
+
+#include "eden/fs/telemetry/EdenStats.h"
+
+namespace facebook::eden {
+
+/**
+ * Start recording the wait and hold times of the profiled locks into the
+ * LockThreadStats of stats. Meant to be called once, at startup: profiling
+ * can't be turned off again, and stats is kept alive until the process
+ * exits since locks may be released at any time.
+ */
+void enableLockProfiling(std::shared_ptr<EdenStats> stats);
+
+namespace detail {
+
+extern std::atomic<EdenStats*> lockProfilingStats;
+
+inline EdenStats* getLockProfilingStats() {
+  return lockProfilingStats.load(std::memory_order_relaxed);
+}
+
+void recordLockTime(
+    EdenStats& stats,
+    LockThreadStats::StatPtr stat,
+    std::chrono::steady_clock::duration duration);
+
+} // namespace detail
+
+/**
+ * Times one acquisition of a lock that can't be wrapped in a ProfiledMutex:
+ * construct it right before acquiring the lock, call acquired() right after,
+ * and destroy it once the lock is released.
+ */
+template <LockThreadStats::StatPtr Wait, LockThreadStats::StatPtr Hold>
+class LockTimer {
+ public:
+  LockTimer() noexcept : stats_{detail::getLockProfilingStats()} {
+    if (stats_) {
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+
+  ~LockTimer() {
+    if (stats_) {
+      detail::recordLockTime(
+          *stats_, Hold, std::chrono::steady_clock::now() - start_);
+    }
+  }
+
+  LockTimer(const LockTimer&) = delete;
+  LockTimer& operator=(const LockTimer&) = delete;
+
+  void acquired() {
+    if (stats_) {
+      auto now = std::chrono::steady_clock::now();
+      detail::recordLockTime(*stats_, Wait, now - start_);
+      start_ = now;
+    }
+  }
+
+ private:
+  EdenStats* stats_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * A mutex recording, once lock profiling is enabled, how long each
+ * acquisition waited into the Wait stat and how long the mutex was then held
+ * into the Hold stat. Meant to be used as the mutex of a folly::Synchronized
+ * or with std::unique_lock.
+ *
+ * Until profiling is enabled, the only cost is an atomic load per lock.
+ */
+template <
+    typename Mutex,
+    LockThreadStats::StatPtr Wait,
+    LockThreadStats::StatPtr Hold>
+class ProfiledMutex {
+ public:
+  void lock() {
+    auto* stats = detail::getLockProfilingStats();
+    if (!stats) {
+      mutex_.lock();
+      return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    mutex_.lock();
+    lockedAt_ = std::chrono::steady_clock::now();
+    detail::recordLockTime(*stats, Wait, lockedAt_ - start);
+  }
+
+  bool try_lock() {
+    if (!mutex_.try_lock()) {
+      return false;
+    }
+    if (detail::getLockProfilingStats()) {
+      lockedAt_ = std::chrono::steady_clock::now();
+    }
+    return true;
+  }
+
+  void unlock() {
+    auto lockedAt = std::exchange(lockedAt_, {});
+    mutex_.unlock();
+    // lockedAt is only set once profiling is enabled, which is permanent.
+    if (lockedAt != std::chrono::steady_clock::time_point{}) {
+      detail::recordLockTime(
+          *detail::getLockProfilingStats(),
+          Hold,
+          std::chrono::steady_clock::now() - lockedAt);
+    }
+  }
+
+ protected:
+  Mutex mutex_;
+
+ private:
+  /** Set while held exclusively with profiling enabled. */
+  std::chrono::steady_clock::time_point lockedAt_;
+};
+
+/**
+ * A ProfiledMutex that can also be locked shared. Shared acquisitions only
+ * record their wait time: several readers may hold the mutex at once, and it
+ * doesn't know which of them is unlocking it.
+ */
+template <
+    typename Mutex,
+    LockThreadStats::StatPtr Wait,
+    LockThreadStats::StatPtr Hold>
+class ProfiledSharedMutex : public ProfiledMutex<Mutex, Wait, Hold> {
+ public:
+  void lock_shared() {
+    auto* stats = detail::getLockProfilingStats();
+    if (!stats) {
+      this->mutex_.lock_shared();
+      return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    this->mutex_.lock_shared();
+    detail::recordLockTime(
+        *stats, Wait, std::chrono::steady_clock::now() - start);
+  }
+
+  bool try_lock_shared() {
+    return this->mutex_.try_lock_shared();
+  }
+
+  void unlock_shared() {
+    this->mutex_.unlock_shared();
+  }
+};
+
+} // namespace facebook::eden
@@ -140,6 +140,15 @@ struct FinishedCheckout {
   bool success = false;
   int64_t fetchedTrees = 0;
   int64_t fetchedBlobs = 0;
+  // Time spent in each phase, in seconds, see CheckoutTimes.
+  double lookupTreesDuration = 0.0;
+  double diffDuration = 0.0;
+  double acquireRenameLockDuration = 0.0;
+  double checkoutDuration = 0.0;
+  double finishDuration = 0.0;
+  int64_t invalidatedDirectories = 0;
+  // Sum of the time each directory invalidation took, in seconds.
+  double directoryInvalidationDuration = 0.0;
 
   void populate(DynamicEvent& event) const {
     event.addString("mode", mode);
@@ -147,6 +156,14 @@ struct FinishedCheckout {
     event.addBool("success", success);
     event.addInt("fetched_trees", fetchedTrees);
     event.addInt("fetched_blobs", fetchedBlobs);
+    event.addDouble("lookup_trees_duration", lookupTreesDuration);
+    event.addDouble("diff_duration", diffDuration);
+    event.addDouble("acquire_rename_lock_duration", acquireRenameLockDuration);
+    event.addDouble("checkout_duration", checkoutDuration);
+    event.addDouble("finish_duration", finishDuration);
+    event.addInt("invalidated_directories", invalidatedDirectories);
+    event.addDouble(
+        "directory_invalidation_duration", directoryInvalidationDuration);
   }
 };
 
@@ -244,6 +261,41 @@ struct ServerDataFetch {
   }
 };
 
+struct SlowRequest {
+  static constexpr const char* type = "slow_request";
+
+  std::string mount;
+  /** The channel and name of the oldest slow request. */
+  std::string channel;
+  std::string request;
+  /** Seconds the oldest slow request has been outstanding. */
+  double age = 0.0;
+  /** Requests that became slow since the previous check. */
+  int64_t slow_requests = 0;
+  int64_t outstanding_requests = 0;
+  int64_t pending_imports = 0;
+  int64_t live_imports = 0;
+  int64_t blob_cache_bytes = 0;
+  double blob_cache_hit_rate = 0.0;
+  int64_t tree_cache_bytes = 0;
+  double tree_cache_hit_rate = 0.0;
+
+  void populate(DynamicEvent& event) const {
+    event.addString("mount", mount);
+    event.addString("channel", channel);
+    event.addString("request", request);
+    event.addDouble("age", age);
+    event.addInt("slow_requests", slow_requests);
+    event.addInt("outstanding_requests", outstanding_requests);
+    event.addInt("pending_imports", pending_imports);
+    event.addInt("live_imports", live_imports);
+    event.addInt("blob_cache_bytes", blob_cache_bytes);
+    event.addDouble("blob_cache_hit_rate", blob_cache_hit_rate);
+    event.addInt("tree_cache_bytes", tree_cache_bytes);
+    event.addDouble("tree_cache_hit_rate", tree_cache_hit_rate);
+  }
+};
+
 struct EdenApiMiss {
   enum MissType : bool {
     Blob = 0,
@@ -17,6 +17,12 @@ namespace {
  */
 constexpr size_t kQueueLimitBytes = 128 * 1024;
 
+/**
+ * Maximum number of iovecs passed to a single writev call. Each message takes
+ * two: its contents and a newline.
+ */
+constexpr size_t kMaxIovecs = 512;
+
 constexpr std::chrono::seconds kFlushTimeout{1};
 constexpr std::chrono::seconds kProcessExitTimeout{1};
 constexpr std::chrono::seconds kProcessTerminateTimeout{1};
@@ -25,6 +31,35 @@ constexpr std::chrono::seconds kProcessTerminateTimeout{1};
 namespace facebook {
 namespace eden {
 
+namespace {
+/** Write messages, each followed by a newline. Returns false on error. */
+bool writeMessages(
+    const FileDescriptor& fd,
+    const std::vector<std::string>& messages) {
+  static char newline = '\n';
+
+  std::array<iovec, kMaxIovecs> iov;
+  size_t iovCount = 0;
+  auto flush = [&] {
+    auto result = fd.writevFull(iov.data(), iovCount);
+    iovCount = 0;
+    return !result.hasException();
+  };
+
+  for (const auto& message : messages) {
+    iov[iovCount].iov_base = const_cast<char*>(message.data());
+    iov[iovCount].iov_len = message.size();
+    iov[iovCount + 1].iov_base = &newline;
+    iov[iovCount + 1].iov_len = sizeof(newline);
+    iovCount += 2;
+    if (iovCount == iov.size() && !flush()) {
+      return false;
+    }
+  }
+  return iovCount == 0 || flush();
+}
+} // namespace
+
 SubprocessScribeLogger::SubprocessScribeLogger(
     const char* executable,
     folly::StringPiece category)
@@ -90,6 +125,7 @@ void SubprocessScribeLogger::closeProcess() {
 
 void SubprocessScribeLogger::log(std::string message) {
   size_t messageSize = message.size();
+  uint64_t droppedMessages = 0;
 
   {
     auto state = state_.lock();
@@ -98,37 +134,42 @@ void SubprocessScribeLogger::log(std::string message) {
       return;
     }
     if (state->totalBytes + messageSize > kQueueLimitBytes) {
-      XLOG_EVERY_MS(DBG7, 10000) << "ScribeLogger queue full, dropping message";
       // queue full, dropping!
-      return;
+      droppedMessages = ++state->droppedMessages;
+    } else {
+      // This order is important in order to be atomic under std::bad_alloc.
+      state->messages.emplace_back(std::move(message));
+      state->totalBytes += messageSize;
     }
-
-    // This order is important in order to be atomic under std::bad_alloc.
-    state->messages.emplace_back(std::move(message));
-    state->totalBytes += messageSize;
+  }
+  if (droppedMessages) {
+    XLOG_EVERY_MS(WARN, 10000) << "ScribeLogger queue full, dropped "
+                               << droppedMessages << " messages so far";
+    return;
   }
   newMessageOrStop_.notify_one();
 }
 
+uint64_t SubprocessScribeLogger::getDroppedMessageCount() const {
+  return state_.lock()->droppedMessages;
+}
+
 void SubprocessScribeLogger::writerThread() {
   auto fd = process_.stdinFd();
+  std::vector<std::string> batch;
 
   for (;;) {
-    std::string message;
-
     {
       auto state = state_.lock();
       newMessageOrStop_.wait(state.as_lock(), [&] {
         return state->shouldStop || !state->messages.empty();
       });
       if (!state->messages.empty()) {
-        XCHECK_LE(state->messages.front().size(), state->totalBytes)
-            << "totalSize accounting fell out of sync!";
-
-        // The below statements are all noexcept.
-        std::swap(message, state->messages.front());
-        state->messages.pop_front();
-        state->totalBytes -= message.size();
+        // Take everything queued so far. The bytes stay accounted for until
+        // they are written, which bounds the memory held by the logger. The
+        // queue gets the previous batch's buffer back, so the steady state
+        // doesn't allocate.
+        batch.swap(state->messages);
       } else {
         // If the predicate succeeded but we have no messages, then we're
         // shutting down cleanly.
@@ -142,13 +183,12 @@ void SubprocessScribeLogger::writerThread() {
       }
     }
 
-    char newline = '\n';
-    std::array<iovec, 2> iov;
-    iov[0].iov_base = message.data();
-    iov[0].iov_len = message.size();
-    iov[1].iov_base = &newline;
-    iov[1].iov_len = sizeof(newline);
-    if (fd.writevFull(iov.data(), iov.size()).hasException()) {
+    size_t batchBytes = 0;
+    for (const auto& message : batch) {
+      batchBytes += message.size();
+    }
+
+    if (!writeMessages(fd, batch)) {
       // TODO: We could attempt to restart the process here.
       XLOG(ERR) << "Failed to writev to logger process stdin: "
                 << folly::errnoStr(errno) << ". Giving up!";
@@ -162,6 +202,14 @@ void SubprocessScribeLogger::writerThread() {
       allMessagesWritten_.notify_one();
       return;
     }
+    batch.clear();
+
+    {
+      auto state = state_.lock();
+      XCHECK_LE(batchBytes, state->totalBytes)
+          << "totalSize accounting fell out of sync!";
+      state->totalBytes -= batchBytes;
+    }
   }
 }
 
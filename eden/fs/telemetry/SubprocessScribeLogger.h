@@ -8,7 +8,7 @@
 #pragma once
 
 #include <folly/Synchronized.h>
-#include <list>
+#include <vector>
 #include "eden/fs/telemetry/ScribeLogger.h"
 #include "eden/fs/utils/SpawnedProcess.h"
 
@@ -18,6 +18,9 @@ namespace eden {
 /**
  * SubprocessScribeLogger manages an external unix process and asynchronously
  * forwards newline-delimited messages to its stdin.
+ *
+ * Messages are queued and a dedicated thread writes everything queued so far
+ * in as few writes as possible, so callers never block on the process.
  */
 class SubprocessScribeLogger : public ScribeLogger {
  public:
@@ -51,6 +54,9 @@ class SubprocessScribeLogger : public ScribeLogger {
   void log(std::string message) override;
   using ScribeLogger::log;
 
+  /** Number of messages dropped so far because the queue was full. */
+  uint64_t getDroppedMessageCount() const;
+
  private:
   void closeProcess();
   void writerThread();
@@ -59,16 +65,17 @@ class SubprocessScribeLogger : public ScribeLogger {
     bool shouldStop = false;
     bool didStop = false;
 
-    /// Sum of sizes of queued messages.
+    /// Sum of sizes of queued messages and of those being written.
     size_t totalBytes = 0;
     /// Invariant: empty if didStop is true
-    std::list<std::string> messages;
+    std::vector<std::string> messages;
+    uint64_t droppedMessages = 0;
   };
 
   SpawnedProcess process_;
   std::thread writerThread_;
 
-  folly::Synchronized<State, std::mutex> state_;
+  mutable folly::Synchronized<State, std::mutex> state_;
   std::condition_variable newMessageOrStop_;
   std::condition_variable allMessagesWritten_;
 };
@@ -7,27 +7,31 @@
 
 #include <folly/logging/xlog.h>
 #include <folly/system/ThreadName.h>
+#include <cinttypes>
 
 namespace facebook::eden {
 
 template <typename TraceEvent>
 std::shared_ptr<TraceBus<TraceEvent>> TraceBus<TraceEvent>::create(
     std::string name,
-    size_t bufferCapacity) {
+    size_t bufferCapacity,
+    OverflowPolicy overflowPolicy) {
   return std::make_shared<TraceBus<TraceEvent>>(
-      PrivateConstructorTag{}, std::move(name), bufferCapacity);
+      PrivateConstructorTag{}, std::move(name), bufferCapacity, overflowPolicy);
 }
 
 template <typename TraceEvent>
 TraceBus<TraceEvent>::TraceBus(
     PrivateConstructorTag,
     std::string name,
-    size_t bufferCapacity)
-    : name_{std::move(name)}, bufferCapacity_{bufferCapacity} {
+    size_t bufferCapacity,
+    OverflowPolicy overflowPolicy)
+    : name_{std::move(name)},
+      bufferCapacity_{bufferCapacity},
+      overflowPolicy_{overflowPolicy},
+      queue_{bufferCapacity} {
   XCHECK_GT(bufferCapacity_, 0u) << "Buffer capacity must not be zero";
 
-  state_.unsafeGetUnlocked().writeBuffer.reserve(bufferCapacity_);
-
   // Allocate the backbuffer here rather than in the thread so std::bad_alloc
   // can be caught.
   std::vector<TraceEvent> readBuffer;
@@ -45,8 +49,8 @@ TraceBus<TraceEvent>::TraceBus(
 
 template <typename TraceEvent>
 TraceBus<TraceEvent>::~TraceBus() {
-  state_.lock()->done = true;
-  emptyCV_.notify_one();
+  done_.store(true, std::memory_order_relaxed);
+  queue_.blockingWrite(std::nullopt);
   thread_.join();
 
   auto& state = state_.unsafeGetUnlocked();
@@ -67,27 +71,22 @@ void TraceBus<TraceEvent>::publish(const TraceEvent& event) noexcept {
 template <typename TraceEvent>
 void TraceBus<TraceEvent>::publish(TraceEvent&& event) noexcept {
   static_assert(std::is_nothrow_move_constructible_v<TraceEvent>);
-
-  bool wake;
-  {
-    auto state = state_.lock();
-    XCHECK(!state->done) << "Illegal to publish concurrently with destruction";
-    if (state->writeBuffer.size() == bufferCapacity_) {
-      // If the buffer is full then the capacity is potentially set too low. Log
-      // an appropriate warning and then block until we have room to append the
-      // current event.
-      logFullOnce();
-      fullCV_.wait(state.as_lock(), [&] {
-        return state->writeBuffer.size() < bufferCapacity_;
-      });
+  XDCHECK(!done_.load(std::memory_order_relaxed))
+      << "Illegal to publish concurrently with destruction";
+
+  // The event is only moved from if it fits.
+  if (!queue_.writeIfNotFull(std::move(event))) {
+    // If the buffer is full then the capacity is potentially set too low. Log
+    // an appropriate warning and then either drop the event or block until we
+    // have room to append it.
+    logFullOnce();
+    if (overflowPolicy_ == OverflowPolicy::Drop) {
+      droppedCount_.fetch_add(1, std::memory_order_relaxed);
+      return;
     }
-    wake = state->writeBuffer.empty();
-    state->writeBuffer.push_back(std::move(event));
-    state->sequenceNumber++;
-  }
-  if (wake) {
-    emptyCV_.notify_one();
+    queue_.blockingWrite(std::move(event));
   }
+  sequenceNumber_.fetch_add(1, std::memory_order_release);
 }
 
 template <typename TraceEvent>
@@ -108,7 +107,7 @@ void TraceBus<TraceEvent>::unsubscribe(void* subscription) noexcept {
 
   auto state = state_.lock();
   // Signal to threadLoop that `sub` should be deleted.
-  sub->unsubscribe = state->sequenceNumber;
+  sub->unsubscribe = sequenceNumber_.load(std::memory_order_acquire);
 
   // At this point, the memory referenced by `sub` must not be accessed as it
   // may be deleted at any moment.
@@ -117,16 +116,20 @@ void TraceBus<TraceEvent>::unsubscribe(void* subscription) noexcept {
 template <typename TraceEvent>
 void TraceBus<TraceEvent>::logFullOnce() noexcept {
   folly::call_once(logIfFullFlag_, [&]() noexcept {
+    const char* action = overflowPolicy_ == OverflowPolicy::Drop
+        ? "dropping events"
+        : "blocking";
     try {
-      XLOG(WARN) << "TraceBus(" << name_ << ") is full; blocking. Is capacity "
-                 << bufferCapacity_ << " sufficient?";
+      XLOG(WARN) << "TraceBus(" << name_ << ") is full; " << action
+                 << ". Is capacity " << bufferCapacity_ << " sufficient?";
     } catch (std::exception& e) {
       fprintf(
           stderr,
-          "TraceBus(%s) is full; blocking. Is capacity %" PRIu64
+          "TraceBus(%s) is full; %s. Is capacity %" PRIu64
           "sufficient?\n"
           "Logging failed with %s\n",
           name_.c_str(),
+          action,
           uint64_t{bufferCapacity_},
           e.what());
       fflush(stderr);
@@ -140,16 +143,28 @@ void TraceBus<TraceEvent>::threadLoop(
   // This function does no allocation and throws no exceptions.
 
   bool done = false;
-  uint64_t lastObservedSequenceNumber = 0;
+  // Like sequenceNumber_, 1 + the number of events observed so far.
+  uint64_t lastObservedSequenceNumber = 1;
   while (!done) {
     XCHECK(readBuffer.empty())
         << "Avoid waiting while holding references to things";
 
+    // Sleep until events are delivered or we are signaled to terminate, then
+    // take as many events as are available without waiting.
+    std::optional<TraceEvent> entry;
+    queue_.blockingRead(entry);
+    do {
+      if (!entry) {
+        done = true;
+        break;
+      }
+      readBuffer.push_back(std::move(*entry));
+    } while (readBuffer.size() < bufferCapacity_ && queue_.read(entry));
+
     Subscription* head;
     {
       auto state = state_.lock();
 
-      // Deallocate before we wait.
       // While the lock is held, delete all unsubscribed subscriptions.
       // plink is pointer to current node pointer.
       // nlink is pointer to next node pointer.
@@ -179,25 +194,10 @@ void TraceBus<TraceEvent>::threadLoop(
       // of events published after unsubscription.
       //
       // This probably isn't important.
-      lastObservedSequenceNumber = state->sequenceNumber;
-
-      // If no events are buffered, sleep until events are delivered or we are
-      // signaled to terminate.
-      emptyCV_.wait(state.as_lock(), [&] {
-        return state->done || !state->writeBuffer.empty();
-      });
-      std::swap(state->writeBuffer, readBuffer);
-      done = state->done;
 
       head = state->subscriptions;
     }
 
-    // If the publish buffer filled, it's possible a publisher is waiting for
-    // space, so wake them.
-    if (readBuffer.size() == bufferCapacity_) {
-      fullCV_.notify_all();
-    }
-
     for (auto* sub = head; sub; sub = sub->next) {
       if (sub->hasThrownException) {
         continue;
@@ -213,6 +213,7 @@ void TraceBus<TraceEvent>::threadLoop(
       }
     }
 
+    lastObservedSequenceNumber += readBuffer.size();
     readBuffer.clear();
   }
 }
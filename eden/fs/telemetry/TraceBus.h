@@ -7,11 +7,14 @@
 
 #pragma once
 
+#include <folly/MPMCQueue.h>
 #include <folly/Synchronized.h>
 #include <folly/synchronization/CallOnce.h>
 #include <stdint.h>
+#include <atomic>
 #include <chrono>
 #include <memory>
+#include <optional>
 #include <thread>
 #include <utility>
 
@@ -137,16 +140,20 @@ class TraceSubscriptionHandle {
 };
 
 /**
- * TraceBus is a reliable, fixed-capacity event trace that runs subscription
- * callbacks on a background thread. It is intended for lightweight telemetry
- * computation: if the subscriptions perform heavy computation and events are
- * submitted more frequently than they're processed, publish() will block.
+ * TraceBus is a fixed-capacity event trace that runs subscription callbacks on
+ * a background thread. It is intended for lightweight telemetry computation:
+ * if the subscriptions perform heavy computation and events are submitted more
+ * frequently than they're processed, publish() will either block or drop the
+ * event, depending on the bus's OverflowPolicy.
+ *
+ * Events are published into a lock-free ring, so publishers only contend on
+ * claiming a slot, never on a mutex shared with the background thread.
  *
  * The capacity should be selected based on the expected usage in context.
- * Memory usage will be capacity * sizeof(TraceEvent) * 2, but a capacity too
- * small will block publishers. The buffer is not intended to prevent all
- * publishers from blocking, but to absorb latency in the case that subscribers
- * briefly cannot keep up.
+ * Memory usage will be about capacity * sizeof(TraceEvent) * 2, but a capacity
+ * too small will block publishers or drop events. The buffer is not intended
+ * to prevent all publishers from blocking, but to absorb latency in the case
+ * that subscribers briefly cannot keep up.
  *
  * Ideally, capacity would be dynamically determined with algorithms similar to
  * network protocols, but a small fixed-size buffer should be sufficient.
@@ -159,6 +166,20 @@ class TraceBus : public std::enable_shared_from_this<TraceBus<TraceEvent>> {
   using Subscriber = TraceEventSubscriber<TraceEvent>;
   using SubscriptionHandle = TraceSubscriptionHandle<TraceEvent>;
 
+  /** What publish() does when the buffer is full. */
+  enum class OverflowPolicy {
+    /**
+     * Wait for the background thread to make room. Every event is observed,
+     * which subscribers pairing up events rely on.
+     */
+    Block,
+    /**
+     * Discard the event and count it in getDroppedCount(), so that tracing
+     * never slows down the code publishing events.
+     */
+    Drop,
+  };
+
   /**
    * Creates a TraceBus. Returns a shared_ptr because the implementation relies
    * on weak_ptr, but in reality the strong reference count will stay at one,
@@ -168,7 +189,8 @@ class TraceBus : public std::enable_shared_from_this<TraceBus<TraceEvent>> {
    */
   static std::shared_ptr<TraceBus> create(
       std::string name,
-      size_t bufferCapacity);
+      size_t bufferCapacity,
+      OverflowPolicy overflowPolicy = OverflowPolicy::Block);
 
   /**
    * Use `create` instead. TraceBus must be managed by shared_ptr.
@@ -176,7 +198,8 @@ class TraceBus : public std::enable_shared_from_this<TraceBus<TraceEvent>> {
   TraceBus(
       PrivateConstructorTag,
       std::string threadName,
-      size_t bufferCapacity);
+      size_t bufferCapacity,
+      OverflowPolicy overflowPolicy);
 
   /**
    * Blocks until all published events have been observed by all registered
@@ -196,6 +219,14 @@ class TraceBus : public std::enable_shared_from_this<TraceBus<TraceEvent>> {
    */
   void publish(TraceEvent&& event) noexcept;
 
+  /**
+   * Number of events discarded because the buffer was full. Always 0 with
+   * OverflowPolicy::Block.
+   */
+  uint64_t getDroppedCount() const noexcept {
+    return droppedCount_.load(std::memory_order_relaxed);
+  }
+
   /**
    * Subscribe to published events. If the subscriber throws, it will
    * automatically be unsubscribed.
@@ -248,8 +279,8 @@ class TraceBus : public std::enable_shared_from_this<TraceBus<TraceEvent>> {
     bool hasThrownException = false;
 
     // If nonzero, unsubscription has been requested after the corresponding
-    // sequenceNumber events have been observed. Only written or read while the
-    // lock is held.
+    // sequence number of events have been observed. Only written or read while
+    // the lock is held.
     uint64_t unsubscribe = 0;
 
     // Subscriptions form a linked list. Subscriptions insert to the head of the
@@ -261,21 +292,23 @@ class TraceBus : public std::enable_shared_from_this<TraceBus<TraceEvent>> {
   };
 
   struct State {
-    bool done = false;
     Subscription* subscriptions = nullptr;
-    std::vector<TraceEvent> writeBuffer;
-    // Incremented every publish()
-    uint64_t sequenceNumber = 1;
   };
 
   const std::string name_;
   const size_t bufferCapacity_;
+  const OverflowPolicy overflowPolicy_;
 
+  // Only guards the subscription list: publish() never takes it.
   folly::Synchronized<State, std::mutex> state_;
-  // Encodes the condition done || !writeBuffer.empty()
-  std::condition_variable emptyCV_;
-  // Encodes the condition writeBuffer.size() < bufferCapacity_
-  std::condition_variable fullCV_;
+  // Published events. The destructor pushes an empty optional to stop the
+  // background thread once every event before it has been observed.
+  folly::MPMCQueue<std::optional<TraceEvent>> queue_;
+  // 1 + the number of events published so far. Incremented once the event is
+  // in the queue.
+  std::atomic<uint64_t> sequenceNumber_{1};
+  std::atomic<uint64_t> droppedCount_{0};
+  std::atomic<bool> done_{false};
   folly::once_flag logIfFullFlag_;
   std::thread thread_;
 
@@ -23,6 +23,15 @@ void ThreadLocalTracePoints::flush() {
   state->currNum_ = 0;
 }
 
+void ThreadLocalTracePoints::copyTo(std::vector<CompactTracePoint>& points) {
+  auto state = state_.lock();
+  size_t npoints = std::min(kBufferPoints, state->currNum_);
+  points.insert(
+      points.end(),
+      state->tracePoints_.begin(),
+      state->tracePoints_.begin() + npoints);
+}
+
 folly::RequestToken tracingToken("eden_tracing");
 
 std::vector<CompactTracePoint> Tracer::getAllTracepoints() {
@@ -35,6 +44,56 @@ std::vector<CompactTracePoint> Tracer::getAllTracepoints() {
   });
   return std::move(*points);
 }
+
+std::vector<CompactTracePoint> Tracer::getRecentTracepoints() {
+  std::vector<CompactTracePoint> points = *tracepoints_.rlock();
+  for (auto& tltp : tltp_.accessAllThreads()) {
+    tltp.copyTo(points);
+  }
+  std::sort(points.begin(), points.end(), [](const auto& a, const auto& b) {
+    return a.timestamp < b.timestamp;
+  });
+  return points;
+}
+
+void Tracer::recordSpan(const TraceSpan& span) {
+  if (!shouldSample(span.id)) {
+    return;
+  }
+  {
+    auto spans = spans_.lock();
+    if (spans->spans.size() < kBufferSpans) {
+      spans->spans.push_back(span);
+    } else {
+      spans->spans[spans->currNum % kBufferSpans] = span;
+    }
+    ++spans->currNum;
+  }
+
+  std::function<void(const TraceSpan&)> handler;
+  {
+    auto slow = slowSpanHandler_.rlock();
+    if (slow->threshold.count() == 0 || span.duration < slow->threshold) {
+      return;
+    }
+    handler = slow->handler;
+  }
+  handler(span);
+}
+
+std::vector<TraceSpan> Tracer::getRecentSpans() {
+  std::vector<TraceSpan> spans = spans_.lock()->spans;
+  std::sort(spans.begin(), spans.end(), [](const auto& a, const auto& b) {
+    return a.start < b.start;
+  });
+  return spans;
+}
+
+void Tracer::setSlowSpanHandler(
+    std::chrono::nanoseconds threshold,
+    std::function<void(const TraceSpan&)> handler) {
+  *slowSpanHandler_.wlock() = SlowSpanHandler{threshold, std::move(handler)};
+}
 } // namespace detail
 } // namespace eden
 } // namespace facebook
@@ -7,11 +7,17 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <functional>
+#include <vector>
 
 #include <folly/ClockGettimeWrappers.h>
+#include <folly/Range.h>
 #include <folly/Singleton.h>
 #include <folly/SpinLock.h>
+#include <folly/Synchronized.h>
 #include <folly/ThreadLocal.h>
 #include <folly/Utility.h>
 #include <folly/io/async/Request.h>
@@ -47,6 +53,20 @@ struct CompactTracePoint {
 // It's nice for each tracepoint to fit inside a single cache line
 static_assert(sizeof(CompactTracePoint) <= 64);
 
+/**
+ * A finished request, such as a FUSE or NFS call, kept alongside the
+ * tracepoints so that traces show what was being served at the time.
+ */
+struct TraceSpan {
+  std::chrono::steady_clock::time_point start;
+  std::chrono::nanoseconds duration;
+  // Identifies the request within its category, e.g. the FUSE unique
+  uint64_t id;
+  // Both must point to statically allocated strings
+  folly::StringPiece category;
+  folly::StringPiece name;
+};
+
 namespace detail {
 class ThreadLocalTracePoints {
   // CompactTracePoints are currently 48 bytes each, so this is 768 KB
@@ -61,6 +81,9 @@ class ThreadLocalTracePoints {
 
   void flush();
 
+  /** Append the buffered tracepoints to points, leaving them in place. */
+  void copyTo(std::vector<CompactTracePoint>& points);
+
   FOLLY_ALWAYS_INLINE void trace(
       uint64_t traceId,
       uint64_t blockId,
@@ -97,6 +120,8 @@ class TraceRequestData : public folly::RequestData {
 
   uint64_t traceId{0};
   uint64_t blockId{0};
+  // Whether the TraceBlocks of this request are recorded, see setTraceSampling
+  bool sampled{false};
 };
 
 extern folly::RequestToken tracingToken;
@@ -121,6 +146,23 @@ class Tracer {
   }
 
   std::vector<CompactTracePoint> getAllTracepoints();
+  std::vector<CompactTracePoint> getRecentTracepoints();
+
+  void recordSpan(const TraceSpan& span);
+  std::vector<TraceSpan> getRecentSpans();
+
+  void setSampling(uint32_t denominator) noexcept {
+    sampleDenominator_.store(denominator, std::memory_order_relaxed);
+  }
+
+  bool shouldSample(uint64_t id) noexcept {
+    auto denominator = sampleDenominator_.load(std::memory_order_relaxed);
+    return denominator <= 1 || id % denominator == 0;
+  }
+
+  void setSlowSpanHandler(
+      std::chrono::nanoseconds threshold,
+      std::function<void(const TraceSpan&)> handler);
 
   bool isEnabled() noexcept {
     return enabled_->load(std::memory_order_acquire);
@@ -146,6 +188,22 @@ class Tracer {
   // empty. As long as threads aren't continuously being created and
   // destroyed while tracing is on, this shouldn't grow large
   folly::Synchronized<std::vector<CompactTracePoint>> tracepoints_;
+
+  // The most recent spans, overwritten in a circle like the tracepoints.
+  static constexpr size_t kBufferSpans = 16 * 1024;
+  struct SpanBuffer {
+    size_t currNum{0};
+    std::vector<TraceSpan> spans;
+  };
+  folly::Synchronized<SpanBuffer, folly::SpinLock> spans_;
+
+  std::atomic<uint32_t> sampleDenominator_{1};
+
+  struct SlowSpanHandler {
+    std::chrono::nanoseconds threshold{0};
+    std::function<void(const TraceSpan&)> handler;
+  };
+  folly::Synchronized<SlowSpanHandler> slowSpanHandler_;
 };
 
 extern Tracer globalTracer;
@@ -174,6 +232,49 @@ inline std::vector<CompactTracePoint> getAllTracepoints() {
   return detail::globalTracer.getAllTracepoints();
 }
 
+/*
+ * Like getAllTracepoints, but leaves the tracepoints in place, so that
+ * tracing can stay enabled and keep a rolling window of the most recent ones
+ * to look at after something went wrong.
+ */
+inline std::vector<CompactTracePoint> getRecentTracepoints() {
+  return detail::globalTracer.getRecentTracepoints();
+}
+
+/*
+ * Only record the TraceBlocks of one request in denominator, to keep the cost
+ * of leaving tracing enabled low. 0 and 1 record every request.
+ */
+inline void setTraceSampling(uint32_t denominator) {
+  detail::globalTracer.setSampling(denominator);
+}
+
+/*
+ * Record a finished request, if tracing is enabled and the request is
+ * sampled. The most recent spans are kept in a rolling window, returned by
+ * getRecentTraceSpans in start order.
+ */
+inline void recordTraceSpan(const TraceSpan& span) {
+  if (detail::globalTracer.isEnabled()) {
+    detail::globalTracer.recordSpan(span);
+  }
+}
+
+inline std::vector<TraceSpan> getRecentTraceSpans() {
+  return detail::globalTracer.getRecentSpans();
+}
+
+/*
+ * Call handler with every recorded span lasting at least threshold, on the
+ * thread recording it, so it should only schedule the real work. A zero
+ * threshold disables it.
+ */
+inline void setSlowTraceSpanHandler(
+    std::chrono::nanoseconds threshold,
+    std::function<void(const TraceSpan&)> handler) {
+  detail::globalTracer.setSlowSpanHandler(threshold, std::move(handler));
+}
+
 /*
  * TraceBlocks demark sections of eden's execution so we can analyze
  * the behavior of a request in a fine-grained fashion.
@@ -201,12 +302,16 @@ class TraceBlock {
   template <size_t size>
   explicit TraceBlock(const char (&name)[size]) {
     if (detail::globalTracer.isEnabled()) {
-      blockId_ = generateUniqueID();
       auto& reqData = detail::Tracer::getRequestData();
       if (!reqData.traceId) {
         reqData.traceId = generateUniqueID();
+        reqData.sampled = detail::globalTracer.shouldSample(reqData.traceId);
+      }
+      if (!reqData.sampled) {
+        return;
       }
 
+      blockId_ = generateUniqueID();
       parentBlockId_ = reqData.blockId;
       detail::globalTracer.getThreadLocalTracePoints().trace(
           reqData.traceId,
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/ChromeTrace.h"
+
+#include <folly/json.h>
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+CompactTracePoint
+makePoint(std::chrono::nanoseconds ts, uint64_t block, const char* name) {
+  CompactTracePoint point{};
+  point.timestamp = ts;
+  point.traceId = 7;
+  point.blockId = block;
+  point.name = name;
+  point.start = name != nullptr;
+  point.stop = name == nullptr;
+  return point;
+}
+} // namespace
+
+TEST(ChromeTrace, renders_blocks_and_spans) {
+  std::vector<CompactTracePoint> points{
+      // The start of block 1 was overwritten, so its stop is dropped.
+      makePoint(1000ns, 1, nullptr),
+      makePoint(2000ns, 2, "block"),
+      makePoint(5000ns, 2, nullptr),
+  };
+  std::chrono::steady_clock::time_point spanStart{3000ns};
+  std::vector<TraceSpan> spans{{spanStart, 1500ns, 9, "fuse", "read"}};
+
+  auto trace = folly::parseJson(renderChromeTrace(points, spans));
+  const auto& events = trace["traceEvents"];
+  ASSERT_EQ(4, events.size());
+
+  EXPECT_EQ("b", events[0]["ph"]);
+  EXPECT_EQ("block", events[0]["name"]);
+  EXPECT_EQ("7", events[0]["id"]);
+  EXPECT_EQ(2.0, events[0]["ts"].asDouble());
+  EXPECT_EQ("e", events[1]["ph"]);
+  EXPECT_EQ("block", events[1]["name"]);
+  EXPECT_EQ(5.0, events[1]["ts"].asDouble());
+
+  EXPECT_EQ("b", events[2]["ph"]);
+  EXPECT_EQ("fuse", events[2]["cat"]);
+  EXPECT_EQ("read", events[2]["name"]);
+  EXPECT_EQ("9", events[2]["id"]);
+  EXPECT_EQ(3.0, events[2]["ts"].asDouble());
+  EXPECT_EQ("e", events[3]["ph"]);
+  EXPECT_EQ(4.5, events[3]["ts"].asDouble());
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/LockProfiling.h"
+
+#include <fb303/ServiceData.h>
+#include <folly/Conv.h>
+#include <folly/SharedMutex.h>
+#include <folly/Synchronized.h>
+#include <folly/portability/GTest.h>
+#include <mutex>
+
+using namespace facebook::eden;
+
+namespace {
+
+int64_t getCount(EdenStats& stats, folly::StringPiece name) {
+  stats.flush();
+  // The stat is only exported once something was recorded into it.
+  return facebook::fb303::ServiceData::get()
+      ->getCounterIfExists(folly::to<std::string>(name, ".count"))
+      .value_or(0);
+}
+
+} // namespace
+
+TEST(LockProfiling, acquisitions_record_wait_and_hold_times) {
+  auto stats = std::make_shared<EdenStats>();
+  enableLockProfiling(stats);
+
+  auto waits = getCount(*stats, "lock.rename.wait_ns");
+  auto holds = getCount(*stats, "lock.rename.hold_ns");
+
+  folly::Synchronized<
+      int,
+      ProfiledSharedMutex<
+          folly::SharedMutex,
+          &LockThreadStats::renameWait,
+          &LockThreadStats::renameHold>>
+      value{0};
+  *value.wlock() += 1;
+  *value.wlock() += 1;
+  EXPECT_EQ(2, *value.rlock());
+
+  // Shared acquisitions only record their wait.
+  EXPECT_EQ(3, getCount(*stats, "lock.rename.wait_ns") - waits);
+  EXPECT_EQ(2, getCount(*stats, "lock.rename.hold_ns") - holds);
+}
+
+TEST(LockProfiling, lock_timer_records_one_acquisition) {
+  auto stats = std::make_shared<EdenStats>();
+  enableLockProfiling(stats);
+
+  auto waits = getCount(*stats, "lock.object_cache.wait_ns");
+  auto holds = getCount(*stats, "lock.object_cache.hold_ns");
+
+  std::mutex mutex;
+  {
+    LockTimer<
+        &LockThreadStats::objectCacheWait,
+        &LockThreadStats::objectCacheHold>
+        timer;
+    std::lock_guard<std::mutex> guard{mutex};
+    timer.acquired();
+  }
+
+  EXPECT_EQ(1, getCount(*stats, "lock.object_cache.wait_ns") - waits);
+  EXPECT_EQ(1, getCount(*stats, "lock.object_cache.hold_ns") - holds);
+}
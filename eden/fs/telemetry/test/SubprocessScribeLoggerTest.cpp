@@ -7,6 +7,7 @@
 
 #include "eden/fs/telemetry/SubprocessScribeLogger.h"
 
+#include <folly/Conv.h>
 #include <folly/FileUtil.h>
 #include <folly/experimental/TestUtil.h>
 #include <folly/portability/GTest.h>
@@ -31,3 +32,39 @@ TEST(ScribeLogger, log_messages_are_written_with_newlines) {
   folly::readFile(output.fd(), contents);
   EXPECT_EQ("foo\nbar\n", contents);
 }
+
+TEST(ScribeLogger, batched_messages_are_written_in_order) {
+  folly::test::TemporaryFile output;
+
+  constexpr size_t kCount = 2000;
+  std::string expected;
+  {
+    SubprocessScribeLogger logger{
+        std::vector<std::string>{"/bin/cat"},
+        FileDescriptor(
+            ::dup(output.fd()), "dup", FileDescriptor::FDType::Generic)};
+    for (size_t i = 0; i < kCount; ++i) {
+      auto message = folly::to<std::string>("message ", i);
+      expected += message;
+      expected += '\n';
+      logger.log(std::move(message));
+    }
+    EXPECT_EQ(0u, logger.getDroppedMessageCount());
+  }
+
+  folly::checkUnixError(lseek(output.fd(), 0, SEEK_SET));
+  std::string contents;
+  folly::readFile(output.fd(), contents);
+  EXPECT_EQ(expected, contents);
+}
+
+TEST(ScribeLogger, messages_are_dropped_and_counted_when_process_is_stuck) {
+  // The process never reads its stdin, so the pipe and then the queue fill.
+  SubprocessScribeLogger logger{
+      std::vector<std::string>{"/bin/sleep", "10"}};
+  std::string message(1024, 'x');
+  for (size_t i = 0; i < 1024; ++i) {
+    logger.log(message);
+  }
+  EXPECT_GT(logger.getDroppedMessageCount(), 0u);
+}
@@ -8,6 +8,7 @@
 #include "eden/fs/telemetry/TraceBus.h"
 #include <folly/futures/Promise.h>
 #include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
 
 using namespace std::literals;
 using namespace facebook::eden;
@@ -100,3 +101,32 @@ TEST(TraceBusTest, unsubscribe_before_publish) {
   // of events.
   XCHECK(1 == i || i == 3) << i << " must be 1 or 3";
 }
+
+TEST(TraceBusTest, drop_policy_discards_events_when_full) {
+  std::vector<int> values;
+  folly::Baton<> started;
+  folly::Baton<> resume;
+  {
+    auto bus = TraceBus<int>::create(
+        "bus", 1, TraceBus<int>::OverflowPolicy::Drop);
+    auto handle = bus->subscribeFunction("sub", [&](int v) {
+      if (values.empty()) {
+        started.post();
+        resume.wait();
+      }
+      values.push_back(v);
+    });
+
+    bus->publish(0);
+    started.wait();
+    // The background thread is busy with 0: 1 fills the buffer and the
+    // rest don't fit.
+    for (int i = 1; i <= 10; ++i) {
+      bus->publish(i);
+    }
+    EXPECT_EQ(9, bus->getDroppedCount());
+    resume.post();
+  }
+
+  EXPECT_EQ((std::vector<int>{0, 1}), values);
+}
@@ -6,9 +6,11 @@
  */
 
 #include <folly/portability/GTest.h>
+#include <limits>
 
 #include <folly/executors/ThreadedExecutor.h>
 #include <folly/futures/Future.h>
+#include <folly/io/async/Request.h>
 
 #include "eden/fs/telemetry/Tracing.h"
 
@@ -130,3 +132,56 @@ TEST(Tracing, does_not_record_if_disabled) {
   auto points = getAllTracepoints();
   ASSERT_EQ(0, points.size());
 }
+
+TEST(Tracing, recent_tracepoints_are_not_consumed) {
+  (void)getAllTracepoints();
+
+  enableTracing();
+  { TraceBlock block{"my_block"}; }
+  ensureValidTracePoints(getRecentTracepoints(), 2);
+  ensureValidBlock();
+}
+
+TEST(Tracing, unsampled_requests_are_not_recorded) {
+  (void)getAllTracepoints();
+
+  enableTracing();
+  setTraceSampling(std::numeric_limits<uint32_t>::max());
+  {
+    folly::RequestContextScopeGuard guard;
+    TraceBlock block{"my_block"};
+  }
+  setTraceSampling(1);
+  EXPECT_EQ(0, getAllTracepoints().size());
+
+  {
+    folly::RequestContextScopeGuard guard;
+    TraceBlock block{"my_block"};
+  }
+  ensureValidBlock();
+}
+
+TEST(Tracing, records_spans_and_reports_slow_ones) {
+  enableTracing();
+  std::vector<uint64_t> slow;
+  setSlowTraceSpanHandler(
+      std::chrono::milliseconds{10},
+      [&](const TraceSpan& span) { slow.push_back(span.id); });
+
+  auto now = std::chrono::steady_clock::now();
+  recordTraceSpan(
+      TraceSpan{now, std::chrono::milliseconds{1}, 1001, "test", "fast"});
+  recordTraceSpan(
+      TraceSpan{now, std::chrono::milliseconds{20}, 1002, "test", "slow"});
+  setSlowTraceSpanHandler(std::chrono::nanoseconds{0}, nullptr);
+
+  EXPECT_EQ(std::vector<uint64_t>{1002}, slow);
+  size_t found = 0;
+  for (const auto& span : getRecentTraceSpans()) {
+    if (span.id == 1001 || span.id == 1002) {
+      EXPECT_EQ("test", span.category);
+      ++found;
+    }
+  }
+  EXPECT_EQ(2, found);
+}
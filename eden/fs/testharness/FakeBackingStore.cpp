@@ -8,10 +8,14 @@
 #include "FakeBackingStore.h"
 
 #include <fmt/format.h>
+#include <folly/CancellationToken.h>
 #include <folly/MapUtil.h>
+#include <folly/Random.h>
 #include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
 #include <folly/ssl/OpenSSLHash.h>
+#include <algorithm>
+#include <ratio>
 
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/model/Hash.h"
@@ -110,15 +114,17 @@ SemiFuture<BackingStore::GetTreeRes> FakeBackingStore::getTree(
     throw std::domain_error(fmt::format("tree {} not found", id));
   }
 
-  return it->second->getFuture().thenValue([](std::unique_ptr<Tree> tree) {
-    return BackingStore::GetTreeRes{
-        std::move(tree), ObjectFetchContext::Origin::FromNetworkFetch};
-  });
+  return addDelay(
+      it->second->getFuture().thenValue([](std::unique_ptr<Tree> tree) {
+        return BackingStore::GetTreeRes{
+            std::move(tree), ObjectFetchContext::Origin::FromNetworkFetch};
+      }),
+      computeDelay(it->second->get().getSizeBytes()));
 }
 
 SemiFuture<BackingStore::GetBlobRes> FakeBackingStore::getBlob(
     const ObjectId& id,
-    ObjectFetchContext& /*context*/) {
+    ObjectFetchContext& context) {
   auto data = data_.wlock();
   ++data->accessCounts[id];
   auto it = data->blobs.find(id);
@@ -127,10 +133,59 @@ SemiFuture<BackingStore::GetBlobRes> FakeBackingStore::getBlob(
     throw std::domain_error(fmt::format("blob {} not found", id));
   }
 
-  return it->second->getFuture().thenValue([](std::unique_ptr<Blob> blob) {
-    return BackingStore::GetBlobRes{
-        std::move(blob), ObjectFetchContext::Origin::FromNetworkFetch};
-  });
+  return addDelay(
+      it->second->getFuture().thenValue(
+          [token = context.getCancellationToken()](std::unique_ptr<Blob> blob) {
+            if (token.isCancellationRequested()) {
+              throw folly::OperationCancelled{};
+            }
+            return BackingStore::GetBlobRes{
+                std::move(blob), ObjectFetchContext::Origin::FromNetworkFetch};
+          }),
+      computeDelay(it->second->get().getSize()));
+}
+
+void FakeBackingStore::setNetworkModel(const NetworkModel& model) {
+  auto network = network_.lock();
+  *network = Network{};
+  network->model = model;
+  hasNetworkModel_.store(
+      model.latency.count() != 0 || model.jitter.count() != 0 ||
+          model.bytesPerSecond != 0 || model.batchWindow.count() != 0,
+      std::memory_order_relaxed);
+}
+
+std::chrono::microseconds FakeBackingStore::computeDelay(size_t bytes) {
+  if (!hasNetworkModel_.load(std::memory_order_relaxed)) {
+    return std::chrono::microseconds{0};
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  auto network = network_.lock();
+  const auto& model = network->model;
+
+  // Join the batch being filled, unless it was already sent or is full.
+  if (now >= network->batchSentAt ||
+      (model.maxBatchSize != 0 && network->batchSize >= model.maxBatchSize)) {
+    auto jitter = model.jitter.count() > 0
+        ? std::chrono::microseconds{static_cast<int64_t>(
+              folly::Random::rand64(model.jitter.count() + 1))}
+        : std::chrono::microseconds{0};
+    network->batchSentAt = now + model.batchWindow;
+    network->batchArrivesAt = network->batchSentAt + model.latency + jitter;
+    network->batchSize = 0;
+  }
+  ++network->batchSize;
+
+  auto arrivesAt = network->batchArrivesAt;
+  if (model.bytesPerSecond != 0) {
+    auto transfer = std::chrono::microseconds{static_cast<int64_t>(
+        bytes * std::micro::den / model.bytesPerSecond)};
+    network->linkFreeAt = std::max(arrivesAt, network->linkFreeAt) + transfer;
+    arrivesAt = network->linkFreeAt;
+  }
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      arrivesAt - now);
 }
 
 Blob FakeBackingStore::makeBlob(folly::StringPiece contents) {
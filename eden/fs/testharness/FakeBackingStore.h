@@ -7,8 +7,11 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <initializer_list>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <vector>
 #include "eden/fs/model/Blob.h"
@@ -55,6 +58,11 @@ class FakeBackingStore final : public BackingStore {
   folly::SemiFuture<BackingStore::GetTreeRes> getTree(
       const ObjectId& id,
       ObjectFetchContext& context) override;
+  /**
+   * Like the queued hg backing store drops the imports nobody waits on
+   * anymore, a blob request whose context is cancelled by the time the blob
+   * is ready fails with folly::OperationCancelled.
+   */
   folly::SemiFuture<BackingStore::GetBlobRes> getBlob(
       const ObjectId& id,
       ObjectFetchContext& context) override;
@@ -152,6 +160,41 @@ class FakeBackingStore final : public BackingStore {
    */
   size_t getAccessCount(const ObjectId& hash) const;
 
+  /**
+   * How getTree() and getBlob() results are delayed once the object is
+   * ready, to simulate fetching it from a remote server. The default model
+   * returns ready objects immediately.
+   */
+  struct NetworkModel {
+    /** The round trip of every request. */
+    std::chrono::microseconds latency{0};
+    /** Up to this much is randomly added to the round trip of each batch. */
+    std::chrono::microseconds jitter{0};
+    /**
+     * The bandwidth of the link, which all objects are transferred over one
+     * after the other once their batch's round trip is over. Zero means
+     * unlimited.
+     */
+    uint64_t bytesPerSecond{0};
+    /**
+     * Requests made within batchWindow of the first request of a batch are
+     * sent along with it and share its round trip, like the importer batches
+     * requests to its server. Zero sends every request on its own.
+     */
+    std::chrono::microseconds batchWindow{0};
+    /** The most requests in a batch. Zero means unlimited. */
+    size_t maxBatchSize{0};
+  };
+
+  void setNetworkModel(const NetworkModel& model);
+
+  /** Set a network model with the given latency, and no other cost. */
+  void setLatency(std::chrono::microseconds latency) {
+    NetworkModel model;
+    model.latency = latency;
+    setNetworkModel(model);
+  }
+
  private:
   struct Data {
     std::unordered_map<RootId, std::unique_ptr<StoredHash>> commits;
@@ -173,7 +216,38 @@ class FakeBackingStore final : public BackingStore {
       ObjectId hash,
       std::vector<TreeEntry>&& sortedEntries);
 
+  struct Network {
+    NetworkModel model;
+    /** When the batch being filled is sent. */
+    std::chrono::steady_clock::time_point batchSentAt;
+    /** When the round trip of the batch being filled is over. */
+    std::chrono::steady_clock::time_point batchArrivesAt;
+    size_t batchSize{0};
+    /** When the link is done transferring the objects requested so far. */
+    std::chrono::steady_clock::time_point linkFreeAt;
+  };
+
+  /**
+   * Compute how long a request for an object of the given size made now
+   * takes under the network model, and account for it on the link.
+   */
+  std::chrono::microseconds computeDelay(size_t bytes);
+
+  /** Maybe delay future by the delay computed by computeDelay(). */
+  template <typename T>
+  static folly::SemiFuture<T> addDelay(
+      folly::Future<T> future,
+      std::chrono::microseconds delay) {
+    if (delay.count() <= 0) {
+      return std::move(future).semi();
+    }
+    return std::move(future).semi().delayed(delay);
+  }
+
   folly::Synchronized<Data> data_;
+  /** Set when the network model is not the default one. */
+  std::atomic<bool> hasNetworkModel_{false};
+  folly::Synchronized<Network, std::mutex> network_;
 };
 
 enum class FakeBlobType {
@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/testharness/FuseTraceReplayer.h"
+
+#include <fcntl.h>
+#include <fmt/format.h>
+#include <folly/logging/xlog.h>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+
+#include "eden/fs/testharness/FakeFuse.h"
+
+using namespace std::chrono_literals;
+
+namespace facebook {
+namespace eden {
+
+namespace {
+
+/** How often options.poll is called while waiting for a response. */
+constexpr std::chrono::milliseconds kPollInterval = 5ms;
+
+/** READDIR sizes aren't recorded, so read directories in pages. */
+constexpr uint32_t kReaddirSize = 4096;
+
+template <typename T>
+std::string toBytes(const T& arg) {
+  return std::string{reinterpret_cast<const char*>(&arg), sizeof(arg)};
+}
+
+/**
+ * Rebuild the argument of a request from its recorded arguments, as
+ * rendered by FuseChannel. Returns std::nullopt for requests that aren't
+ * replayed.
+ */
+std::optional<std::string> buildArgument(const FuseTraceRecord& record) {
+  const auto& arguments = record.arguments;
+  switch (record.opcode) {
+    case FUSE_LOOKUP:
+      if (arguments.empty()) {
+        return std::nullopt;
+      }
+      return arguments + '\0';
+    case FUSE_GETATTR:
+      return toBytes(fuse_getattr_in{});
+    case FUSE_READLINK:
+    case FUSE_STATFS:
+      return std::string{};
+    case FUSE_OPEN:
+    case FUSE_OPENDIR: {
+      fuse_open_in in{};
+      in.flags = O_RDONLY;
+      return toBytes(in);
+    }
+    case FUSE_READ: {
+      uint64_t offset;
+      uint32_t size;
+      if (sscanf(
+              arguments.c_str(),
+              "off=%" SCNu64 ", len=%" SCNu32,
+              &offset,
+              &size) != 2) {
+        return std::nullopt;
+      }
+      fuse_read_in in{};
+      in.offset = offset;
+      in.size = size;
+      return toBytes(in);
+    }
+    case FUSE_READDIR: {
+      uint64_t offset;
+      if (sscanf(arguments.c_str(), "offset=%" SCNu64, &offset) != 1) {
+        return std::nullopt;
+      }
+      fuse_read_in in{};
+      in.offset = offset;
+      in.size = kReaddirSize;
+      return toBytes(in);
+    }
+    case FUSE_ACCESS: {
+      uint32_t mask;
+      if (sscanf(arguments.c_str(), "mask=%" SCNu32, &mask) != 1) {
+        return std::nullopt;
+      }
+      fuse_access_in in{};
+      in.mask = mask;
+      return toBytes(in);
+    }
+    case FUSE_FLUSH:
+      return toBytes(fuse_flush_in{});
+    case FUSE_RELEASE:
+    case FUSE_RELEASEDIR:
+      return toBytes(fuse_release_in{});
+    default:
+      return std::nullopt;
+  }
+}
+
+/** Whether the result of a successful request is the inode it returned. */
+bool returnsInode(uint32_t opcode) {
+  return opcode == FUSE_LOOKUP;
+}
+
+} // namespace
+
+FuseTraceReplayer::FuseTraceReplayer(FakeFuse& fuse, Options options)
+    : fuse_{fuse}, options_{std::move(options)} {
+  if (options_.poll) {
+    fuse_.setTimeout(kPollInterval);
+  }
+}
+
+FuseTraceReplayer::Result FuseTraceReplayer::replay(
+    const std::vector<FuseTraceRecord>& records) {
+  struct Sent {
+    uint32_t requestId;
+    std::chrono::steady_clock::time_point sentAt;
+  };
+
+  Result result;
+  std::unordered_map<uint64_t, uint64_t> nodeids{{FUSE_ROOT_ID, FUSE_ROOT_ID}};
+  // Indexed by the unique ID of the recorded request.
+  std::unordered_map<uint64_t, Sent> inFlight;
+  // Responses received while waiting for another one.
+  std::unordered_map<uint64_t, FakeFuse::Response> responses;
+
+  auto waitForResponse = [&](uint32_t requestId) {
+    auto deadline = std::chrono::steady_clock::now() + options_.timeout;
+    while (true) {
+      auto it = responses.find(requestId);
+      if (it != responses.end()) {
+        auto response = std::move(it->second);
+        responses.erase(it);
+        return response;
+      }
+      try {
+        auto response = fuse_.recvResponse();
+        responses.emplace(response.header.unique, std::move(response));
+      } catch (const std::system_error& ex) {
+        if (ex.code().value() != EAGAIN) {
+          throw;
+        }
+      }
+      if (options_.poll) {
+        options_.poll();
+      }
+      if (std::chrono::steady_clock::now() > deadline) {
+        throw std::runtime_error(
+            fmt::format("no response to replayed request {}", requestId));
+      }
+    }
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  for (const auto& record : records) {
+    if (record.type == FuseTraceEvent::START) {
+      auto nodeid = nodeids.find(record.nodeid);
+      auto argument = buildArgument(record);
+      if (nodeid == nodeids.end() || !argument) {
+        ++result.skipped;
+        continue;
+      }
+      if (options_.speed > 0.0) {
+        std::this_thread::sleep_until(
+            start +
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                record.time / options_.speed));
+      }
+      auto requestId = fuse_.sendRequest(
+          record.opcode,
+          nodeid->second,
+          folly::ByteRange{folly::StringPiece{*argument}});
+      inFlight.emplace(
+          record.unique, Sent{requestId, std::chrono::steady_clock::now()});
+      continue;
+    }
+
+    auto sent = inFlight.find(record.unique);
+    if (sent == inFlight.end()) {
+      continue;
+    }
+    auto response = waitForResponse(sent->second.requestId);
+    result.latencies.push_back(
+        std::chrono::steady_clock::now() - sent->second.sentAt);
+    inFlight.erase(sent);
+    ++result.replayed;
+
+    bool recordedSuccess = !record.result || *record.result >= 0;
+    bool replayedSuccess = response.header.error == 0;
+    if (recordedSuccess != replayedSuccess) {
+      XLOG(DBG3) << "replayed request " << response.header.unique
+                 << " of opcode " << record.opcode << " returned "
+                 << response.header.error << " instead of "
+                 << record.result.value_or(0);
+      ++result.mismatched;
+    }
+    // Negative lookups succeed with an inode number of 0.
+    if (replayedSuccess && record.result.value_or(0) > 0 &&
+        returnsInode(record.opcode) &&
+        response.body.size() >= sizeof(fuse_entry_out)) {
+      fuse_entry_out entry;
+      memcpy(&entry, response.body.data(), sizeof(entry));
+      nodeids[*record.result] = entry.nodeid;
+    }
+  }
+
+  // Requests still running when the recording stopped.
+  for (const auto& [unique, sent] : inFlight) {
+    (void)unique;
+    waitForResponse(sent.requestId);
+    result.latencies.push_back(std::chrono::steady_clock::now() - sent.sentAt);
+    ++result.replayed;
+  }
+  return result;
+}
+
+} // namespace eden
+} // namespace facebook
+
+#endif
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <vector>
+
+#include "eden/fs/fuse/FuseTraceRecorder.h"
+
+namespace facebook {
+namespace eden {
+
+class FakeFuse;
+
+/**
+ * FuseTraceReplayer sends the requests of a FuseTraceRecorder recording on a
+ * FakeFuse connection, typically to the FuseChannel of a TestMount checked
+ * out at the commit the recording was made on, to reproduce the load of a
+ * production workload.
+ *
+ * Requests keep the concurrency they had when recorded: a request is sent
+ * once the requests that finished before it started were answered, without
+ * waiting for the others. Inode numbers are translated from the recording to
+ * the replayed mount using the results of the requests that returned them,
+ * such as LOOKUP.
+ *
+ * Only requests that don't modify the mount and whose arguments can be
+ * rebuilt from the recording are replayed, such as LOOKUP, GETATTR, READ and
+ * READDIR. The others, and the requests about inodes they returned, are
+ * skipped.
+ */
+class FuseTraceReplayer {
+ public:
+  struct Options {
+    /**
+     * 0 sends each request as soon as the requests it waits for were
+     * answered. Otherwise, requests are also not sent before the time they
+     * were recorded at, divided by speed: 1 replays at the recorded pace, 2
+     * twice as fast.
+     */
+    double speed{0.0};
+    /**
+     * Called while waiting for responses, for example to drain the
+     * ManualExecutor of a TestMount.
+     */
+    std::function<void()> poll;
+    /** How long to wait for a response before failing the replay. */
+    std::chrono::milliseconds timeout{std::chrono::seconds{10}};
+  };
+
+  struct Result {
+    size_t replayed{0};
+    size_t skipped{0};
+    /**
+     * Replayed requests that failed when their recording succeeded, or the
+     * opposite.
+     */
+    size_t mismatched{0};
+    /** The time each replayed request took to be answered. */
+    std::vector<std::chrono::steady_clock::duration> latencies;
+  };
+
+  /**
+   * fuse must already be initialized. If options.poll is set, the timeout of
+   * fuse is shortened so that it's called often while waiting.
+   */
+  FuseTraceReplayer(FakeFuse& fuse, Options options);
+
+  /**
+   * Replay records, in the order of the recording, and wait for all the
+   * replayed requests to be answered. Throws if a request isn't answered
+   * within options.timeout.
+   */
+  Result replay(const std::vector<FuseTraceRecord>& records);
+
+ private:
+  FakeFuse& fuse_;
+  Options options_;
+};
+
+} // namespace eden
+} // namespace facebook
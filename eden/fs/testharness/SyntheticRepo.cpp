@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/testharness/SyntheticRepo.h"
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <vector>
+
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/model/TreeEntry.h"
+#include "eden/fs/testharness/FakeBackingStore.h"
+
+namespace facebook {
+namespace eden {
+
+SyntheticRepo::SyntheticRepo(
+    FakeBackingStore& store,
+    SyntheticRepoOptions options)
+    : store_{store}, options_{options} {
+  auto fileCount = getFileCount();
+  changeStride_ = options_.changedFiles == 0
+      ? 1
+      : std::max<size_t>(1, fileCount / options_.changedFiles);
+}
+
+size_t SyntheticRepo::getDirectoryCount() const {
+  size_t count = 0;
+  size_t levelCount = 1;
+  for (size_t level = 0; level < options_.depth; ++level) {
+    levelCount *= options_.directoriesPerDirectory;
+    count += levelCount;
+  }
+  return count;
+}
+
+size_t SyntheticRepo::getFileCount() const {
+  return (getDirectoryCount() + 1) * options_.filesPerDirectory;
+}
+
+bool SyntheticRepo::isChanged(size_t fileIndex) const {
+  return fileIndex % changeStride_ == 0 &&
+      fileIndex / changeStride_ < options_.changedFiles;
+}
+
+ObjectId SyntheticRepo::putRootTree(bool modified) {
+  size_t nextFileIndex = 0;
+  return putTree(0, modified, nextFileIndex);
+}
+
+ObjectId SyntheticRepo::putTree(
+    size_t level,
+    bool modified,
+    size_t& nextFileIndex) {
+  std::vector<TreeEntry> entries;
+  auto numDirectories =
+      level < options_.depth ? options_.directoriesPerDirectory : 0;
+  entries.reserve(numDirectories + options_.filesPerDirectory);
+
+  for (size_t f = 0; f < options_.filesPerDirectory; ++f) {
+    auto fileIndex = nextFileIndex++;
+    auto changed = modified && isChanged(fileIndex);
+    auto [blob, inserted] = store_.maybePutBlob(
+        fmt::format("// file {}{}\n", fileIndex, changed ? " v2" : ""));
+    if (inserted) {
+      blob->setReady();
+    }
+    entries.emplace_back(
+        blob->get().getHash(),
+        PathComponent{fmt::format("file{}.h", f)},
+        TreeEntryType::REGULAR_FILE);
+  }
+
+  for (size_t d = 0; d < numDirectories; ++d) {
+    entries.emplace_back(
+        putTree(level + 1, modified, nextFileIndex),
+        PathComponent{fmt::format("dir{}", d)},
+        TreeEntryType::TREE);
+  }
+
+  auto [tree, inserted] = store_.maybePutTree(std::move(entries));
+  if (inserted) {
+    tree->setReady();
+  }
+  return tree->get().getHash();
+}
+
+} // namespace eden
+} // namespace facebook
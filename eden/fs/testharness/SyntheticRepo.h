@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include "eden/fs/model/ObjectId.h"
+
+namespace facebook {
+namespace eden {
+
+class FakeBackingStore;
+
+struct SyntheticRepoOptions {
+  /** Number of directory levels below the root. */
+  size_t depth{2};
+  /** Number of subdirectories of each directory above the last level. */
+  size_t directoriesPerDirectory{10};
+  /** Number of files in every directory, including the root. */
+  size_t filesPerDirectory{10};
+  /**
+   * Number of files whose contents differ between the original and the
+   * modified trees, spread evenly over the whole repository.
+   */
+  size_t changedFiles{0};
+};
+
+/**
+ * SyntheticRepo generates a large, regularly shaped repository straight into
+ * a FakeBackingStore, for benchmarks measuring how checkout, status and glob
+ * scale with the size of the repository.
+ *
+ * Unlike FakeTreeBuilder, it builds the Tree and Blob objects directly,
+ * without keeping a description of the whole repository in memory, so that
+ * it can generate millions of files.  Directories are named dir<N> and files
+ * file<N>.h, where N is the index of the entry within its parent.
+ */
+class SyntheticRepo {
+ public:
+  SyntheticRepo(FakeBackingStore& store, SyntheticRepoOptions options);
+
+  /**
+   * Store every tree and blob of the repository, all marked ready, and return
+   * the hash of its root tree.
+   *
+   * If modified is true, the options.changedFiles changed files have
+   * different contents, and so do all the trees containing them.
+   */
+  ObjectId putRootTree(bool modified);
+
+  /** The total number of files in the repository. */
+  size_t getFileCount() const;
+
+  /** The total number of directories in the repository, not counting root. */
+  size_t getDirectoryCount() const;
+
+ private:
+  ObjectId putTree(size_t level, bool modified, size_t& nextFileIndex);
+  bool isChanged(size_t fileIndex) const;
+
+  FakeBackingStore& store_;
+  const SyntheticRepoOptions options_;
+  size_t changeStride_;
+};
+
+} // namespace eden
+} // namespace facebook
@@ -107,10 +107,12 @@ TestMount::TestMount()
   treeCache_ = TreeCache::create(edenConfig);
 
   auto userInfo = UserInfo::lookup();
+  auto serverThreadPool = make_shared<UnboundedQueueExecutor>(serverExecutor_);
   serverState_ = {make_shared<ServerState>(
       userInfo,
       privHelper_,
-      make_shared<UnboundedQueueExecutor>(serverExecutor_),
+      serverThreadPool,
+      serverThreadPool,
       clock_,
       make_shared<ProcessNameCache>(),
       make_shared<NullStructuredLogger>(),
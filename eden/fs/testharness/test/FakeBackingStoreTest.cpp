@@ -300,3 +300,39 @@ TEST_F(FakeBackingStoreTest, maybePutTree) {
   EXPECT_FALSE(dir2.second);
   EXPECT_EQ(dir1.first, dir2.first);
 }
+
+TEST_F(FakeBackingStoreTest, networkModelDelaysReadyObjects) {
+  using namespace std::chrono_literals;
+  auto* blob1 = store_->putBlob(std::string(1000, 'a'));
+  auto* blob2 = store_->putBlob(std::string(1000, 'b'));
+  blob1->setReady();
+  blob2->setReady();
+
+  // Both blobs are transferred one after the other, at 100ms each, once the
+  // round trip is over.
+  FakeBackingStore::NetworkModel model;
+  model.latency = 10ms;
+  model.bytesPerSecond = 10000;
+  store_->setNetworkModel(model);
+
+  auto start = std::chrono::steady_clock::now();
+  auto future1 = store_->getBlob(
+      blob1->get().getHash(), ObjectFetchContext::getNullContext());
+  auto future2 = store_->getBlob(
+      blob2->get().getHash(), ObjectFetchContext::getNullContext());
+  EXPECT_FALSE(future1.isReady());
+  EXPECT_FALSE(future2.isReady());
+
+  EXPECT_EQ("aaa", blobContents(*std::move(future1).get().blob).substr(0, 3));
+  EXPECT_GE(std::chrono::steady_clock::now() - start, 110ms);
+  std::move(future2).get();
+  EXPECT_GE(std::chrono::steady_clock::now() - start, 210ms);
+
+  // The default model returns ready objects immediately again.
+  store_->setNetworkModel(FakeBackingStore::NetworkModel{});
+  EXPECT_TRUE(store_
+                  ->getBlob(
+                      blob1->get().getHash(),
+                      ObjectFetchContext::getNullContext())
+                  .isReady());
+}
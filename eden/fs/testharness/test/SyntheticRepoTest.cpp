@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/testharness/SyntheticRepo.h"
+
+#include <folly/portability/GTest.h>
+#include <map>
+
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/testharness/FakeBackingStore.h"
+
+using namespace facebook::eden;
+
+namespace {
+
+/** Map the path of every file below tree to the hash of its blob. */
+void collectFiles(
+    FakeBackingStore& store,
+    const ObjectId& tree,
+    const std::string& prefix,
+    std::map<std::string, ObjectId>& files) {
+  auto result =
+      store.getTree(tree, ObjectFetchContext::getNullContext()).get();
+  for (const auto& entry : result.tree->getTreeEntries()) {
+    auto path = prefix + entry.getName().stringPiece().str();
+    if (entry.isTree()) {
+      collectFiles(store, entry.getHash(), path + "/", files);
+    } else {
+      files.emplace(path, entry.getHash());
+    }
+  }
+}
+
+std::map<std::string, ObjectId> collectFiles(
+    FakeBackingStore& store,
+    const ObjectId& root) {
+  std::map<std::string, ObjectId> files;
+  collectFiles(store, root, "", files);
+  return files;
+}
+
+} // namespace
+
+TEST(SyntheticRepo, generates_the_requested_shape) {
+  FakeBackingStore store;
+  SyntheticRepoOptions options;
+  options.depth = 2;
+  options.directoriesPerDirectory = 3;
+  options.filesPerDirectory = 4;
+  SyntheticRepo repo{store, options};
+
+  // 3 + 9 directories, plus the root, with 4 files each.
+  EXPECT_EQ(12, repo.getDirectoryCount());
+  EXPECT_EQ(52, repo.getFileCount());
+
+  auto files = collectFiles(store, repo.putRootTree(/*modified=*/false));
+  EXPECT_EQ(52, files.size());
+  EXPECT_EQ(1, files.count("file0.h"));
+  EXPECT_EQ(1, files.count("dir2/dir1/file3.h"));
+}
+
+TEST(SyntheticRepo, modified_tree_changes_the_requested_files) {
+  FakeBackingStore store;
+  SyntheticRepoOptions options;
+  options.depth = 2;
+  options.directoriesPerDirectory = 3;
+  options.filesPerDirectory = 4;
+  options.changedFiles = 5;
+  SyntheticRepo repo{store, options};
+
+  auto original = repo.putRootTree(/*modified=*/false);
+  EXPECT_EQ(original, repo.putRootTree(/*modified=*/false));
+  auto modified = repo.putRootTree(/*modified=*/true);
+  EXPECT_NE(original, modified);
+
+  auto originalFiles = collectFiles(store, original);
+  auto modifiedFiles = collectFiles(store, modified);
+  ASSERT_EQ(originalFiles.size(), modifiedFiles.size());
+  size_t changed = 0;
+  for (const auto& [path, hash] : originalFiles) {
+    if (modifiedFiles.at(path) != hash) {
+      ++changed;
+    }
+  }
+  EXPECT_EQ(5, changed);
+}
+
+TEST(SyntheticRepo, no_changed_files_means_identical_trees) {
+  FakeBackingStore store;
+  SyntheticRepoOptions options;
+  options.depth = 1;
+  SyntheticRepo repo{store, options};
+  EXPECT_EQ(
+      repo.putRootTree(/*modified=*/false),
+      repo.putRootTree(/*modified=*/true));
+}
@@ -71,8 +71,12 @@ class BucketedLog {
   /**
    * For every bucket in other whose time lines up with a bucket in `this`, call
    * this_bucket.merge(other_bucket).
+   *
+   * The other log may use a different bucket type, as long as Bucket can merge
+   * it, e.g. to record into compact buckets and merge them into richer ones.
    */
-  void merge(const BucketedLog& other) {
+  template <typename OtherBucket>
+  void merge(const BucketedLog<OtherBucket, Size>& other) {
     // Merging brings us at least up to the other log's window.
     advanceWindow(other.windowStart_ + Size - 1);
     for (uint64_t i = windowStart_; i < windowStart_ + Size; ++i) {
@@ -92,6 +96,9 @@ class BucketedLog {
   }
 
  private:
+  template <typename, size_t>
+  friend class BucketedLog;
+
   void advanceWindow(uint64_t now) {
     if (now < windowStart_ + Size) {
       return;
@@ -7,19 +7,56 @@
 
 #include "eden/fs/utils/EdenTaskQueue.h"
 
+#include <algorithm>
+#include <folly/logging/xlog.h>
+
 namespace facebook::eden {
 
+EdenTaskQueue::EdenTaskQueue(
+    uint64_t maxInflightRequests,
+    uint8_t numPriorities) {
+  XCHECK_GT(numPriorities, 0);
+  for (uint8_t i = 0; i < numPriorities; i++) {
+    queues_.push_back(std::make_unique<Queue>(maxInflightRequests));
+  }
+}
+
+size_t EdenTaskQueue::getQueueIndex(int8_t priority) const {
+  int mid = static_cast<int>(queues_.size()) / 2;
+  int index = mid + priority;
+  return static_cast<size_t>(
+      std::clamp(index, 0, static_cast<int>(queues_.size()) - 1));
+}
+
 folly::BlockingQueueAddResult EdenTaskQueue::add(
     folly::CPUThreadPoolExecutor::CPUTask item) {
-  queue_.enqueue(std::move(item));
+  return addWithPriority(std::move(item), folly::Executor::MID_PRI);
+}
+
+folly::BlockingQueueAddResult EdenTaskQueue::addWithPriority(
+    folly::CPUThreadPoolExecutor::CPUTask item,
+    int8_t priority) {
+  queues_[getQueueIndex(priority)]->enqueue(std::move(item));
   return sem_.post();
 }
 
+folly::CPUThreadPoolExecutor::CPUTask EdenTaskQueue::dequeue() {
+  // The semaphore guarantees that a task was fully enqueued for us, but
+  // another thread may take it from under us in a higher priority queue and
+  // leave its own in a lower one, hence the retry.
+  folly::CPUThreadPoolExecutor::CPUTask res;
+  while (true) {
+    for (auto it = queues_.rbegin(); it != queues_.rend(); ++it) {
+      if ((*it)->try_dequeue(res)) {
+        return res;
+      }
+    }
+  }
+}
+
 folly::CPUThreadPoolExecutor::CPUTask EdenTaskQueue::take() {
   sem_.wait();
-  folly::CPUThreadPoolExecutor::CPUTask res;
-  queue_.dequeue(res);
-  return res;
+  return dequeue();
 }
 
 folly::Optional<folly::CPUThreadPoolExecutor::CPUTask>
@@ -27,13 +64,19 @@ EdenTaskQueue::try_take_for(std::chrono::milliseconds time) {
   if (!sem_.try_wait_for(time)) {
     return folly::none;
   }
-  folly::CPUThreadPoolExecutor::CPUTask res;
-  queue_.dequeue(res);
-  return res;
+  return dequeue();
 }
 
 size_t EdenTaskQueue::size() {
-  return queue_.size();
+  size_t size = 0;
+  for (auto& queue : queues_) {
+    size += queue->size();
+  }
+  return size;
+}
+
+size_t EdenTaskQueue::sizeOfPriority(int8_t priority) {
+  return queues_[getQueueIndex(priority)]->size();
 }
 
 } // namespace facebook::eden
@@ -7,24 +7,36 @@
 
 #include <folly/concurrency/DynamicBoundedQueue.h>
 #include <folly/executors/CPUThreadPoolExecutor.h>
+#include <memory>
+#include <vector>
 
 namespace facebook::eden {
 
 /**
  * Task queue that can be used to hold work needing to be processed.
  *
- * This is backed by a DMPMCQueue.
+ * This is backed by one DMPMCQueue per priority, each holding up to
+ * maxInflightRequests tasks. Tasks of higher priorities are taken first, and
+ * priorities are mapped to queues like folly's PriorityLifoSemMPMCQueue does.
  */
 class EdenTaskQueue
     : public folly::BlockingQueue<folly::CPUThreadPoolExecutor::CPUTask> {
  public:
-  explicit EdenTaskQueue(uint64_t maxInflightRequests)
-      : queue_(folly::DMPMCQueue<folly::CPUThreadPoolExecutor::CPUTask, true>{
-            maxInflightRequests}) {}
+  explicit EdenTaskQueue(
+      uint64_t maxInflightRequests,
+      uint8_t numPriorities = 1);
 
   folly::BlockingQueueAddResult add(
       folly::CPUThreadPoolExecutor::CPUTask item) override;
 
+  folly::BlockingQueueAddResult addWithPriority(
+      folly::CPUThreadPoolExecutor::CPUTask item,
+      int8_t priority) override;
+
+  uint8_t getNumPriorities() override {
+    return static_cast<uint8_t>(queues_.size());
+  }
+
   folly::CPUThreadPoolExecutor::CPUTask take() override;
 
   folly::Optional<folly::CPUThreadPoolExecutor::CPUTask> try_take_for(
@@ -32,9 +44,19 @@ class EdenTaskQueue
 
   size_t size() override;
 
+  /**
+   * Number of tasks waiting in the queue of the given priority.
+   */
+  size_t sizeOfPriority(int8_t priority);
+
  private:
+  using Queue = folly::DMPMCQueue<folly::CPUThreadPoolExecutor::CPUTask, true>;
+
+  size_t getQueueIndex(int8_t priority) const;
+  folly::CPUThreadPoolExecutor::CPUTask dequeue();
+
   folly::LifoSem sem_;
-  folly::DMPMCQueue<folly::CPUThreadPoolExecutor::CPUTask, true> queue_;
+  std::vector<std::unique_ptr<Queue>> queues_;
 };
 
 } // namespace facebook::eden
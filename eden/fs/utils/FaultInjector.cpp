@@ -8,8 +8,11 @@
 #include "eden/fs/utils/FaultInjector.h"
 
 #include <folly/Overload.h>
+#include <folly/Random.h>
 #include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
+#include <cmath>
+#include <random>
 
 using folly::SemiFuture;
 using folly::StringPiece;
@@ -18,6 +21,30 @@ using folly::Unit;
 namespace facebook {
 namespace eden {
 
+std::chrono::microseconds FaultInjector::LatencyProfile::sample() const {
+  switch (distribution) {
+    case Distribution::Constant:
+      return latency;
+    case Distribution::LogNormal: {
+      if (latency.count() <= 0 || sigma <= 0) {
+        return latency;
+      }
+      folly::ThreadLocalPRNG rng;
+      std::lognormal_distribution<double> dist{
+          std::log(static_cast<double>(latency.count())), sigma};
+      return std::chrono::microseconds{
+          static_cast<std::chrono::microseconds::rep>(dist(rng))};
+    }
+    case Distribution::TailSpikes:
+      if (spikeProbability > 0 &&
+          folly::Random::randDouble01() < spikeProbability) {
+        return spike;
+      }
+      return latency;
+  }
+  return latency;
+}
+
 FaultInjector::Fault::Fault(StringPiece regex, FaultBehavior&& b, size_t count)
     : keyValueRegex(regex.begin(), regex.end()),
       countRemaining(count),
@@ -56,6 +83,12 @@ SemiFuture<Unit> FaultInjector::checkAsyncImpl(
             }
             return folly::futures::sleep(delay.duration);
           },
+          [&](const FaultInjector::Latency& latency) -> SemiFuture<Unit> {
+            auto duration = latency.profile.sample();
+            XLOG(DBG1) << "latency fault hit: " << keyClass << ", " << keyValue
+                       << ", " << duration.count() << "us";
+            return folly::futures::sleep(duration);
+          },
           [&](const folly::exception_wrapper& error) {
             XLOG(DBG1) << "error fault hit: " << keyClass << ", " << keyValue;
             return folly::makeSemiFuture<Unit>(error);
@@ -79,6 +112,12 @@ void FaultInjector::checkImpl(StringPiece keyClass, StringPiece keyValue) {
               delay.error.value().throw_exception();
             }
           },
+          [&](const FaultInjector::Latency& latency) {
+            auto duration = latency.profile.sample();
+            XLOG(DBG1) << "latency fault hit: " << keyClass << ", " << keyValue
+                       << ", " << duration.count() << "us";
+            /* sleep override */ std::this_thread::sleep_for(duration);
+          },
           [&](const folly::exception_wrapper& error) {
             XLOG(DBG1) << "error fault hit: " << keyClass << ", " << keyValue;
             error.throw_exception();
@@ -127,6 +166,17 @@ void FaultInjector::injectDelayedError(
       keyClass, keyValueRegex, Delay{duration, std::move(error)}, count);
 }
 
+void FaultInjector::injectLatency(
+    StringPiece keyClass,
+    StringPiece keyValueRegex,
+    LatencyProfile profile,
+    size_t count) {
+  XLOG(INFO) << "injectLatency(" << keyClass << ", " << keyValueRegex
+             << ", latency=" << profile.latency.count()
+             << "us, count=" << count << ")";
+  injectFault(keyClass, keyValueRegex, Latency{profile}, count);
+}
+
 void FaultInjector::injectNoop(
     folly::StringPiece keyClass,
     folly::StringPiece keyValueRegex,
@@ -148,6 +198,7 @@ void FaultInjector::injectFault(
   auto state = state_.wlock();
   state->faults[keyClass].emplace_back(
       keyValueRegex, std::move(behavior), count);
+  numFaults_.fetch_add(1, std::memory_order_release);
 }
 
 bool FaultInjector::removeFault(
@@ -169,6 +220,7 @@ bool FaultInjector::removeFault(
     if (iter->keyValueRegex.str() == keyValueRegex) {
       XLOG(INFO) << "removeFault(" << keyClass << ", " << keyValueRegex << ")";
       faultVector.erase(iter);
+      numFaults_.fetch_sub(1, std::memory_order_release);
       if (faultVector.empty()) {
         state->faults.erase(classIter);
       }
@@ -248,6 +300,7 @@ FaultInjector::FaultBehavior FaultInjector::findFault(
         XLOG(DBG1) << "fault expired: " << keyClass << ", "
                    << iter->keyValueRegex.str();
         faultVector.erase(iter);
+        numFaults_.fetch_sub(1, std::memory_order_release);
       }
     }
     return behavior;
@@ -11,7 +11,9 @@
 #include <boost/variant.hpp>
 #include <folly/experimental/StringKeyedUnorderedMap.h>
 #include <folly/futures/Future.h>
+#include <atomic>
 #include <optional>
+#include "eden/fs/utils/ImmediateFuture.h"
 
 namespace facebook {
 namespace eden {
@@ -24,6 +26,34 @@ namespace eden {
  */
 class FaultInjector {
  public:
+  /**
+   * A distribution of artificial latencies, for modelling slow storage or a
+   * slow kernel during load tests rather than a single fixed delay.
+   */
+  struct LatencyProfile {
+    enum class Distribution {
+      // Every hit is delayed by latency.
+      Constant,
+      // Delays follow a log-normal distribution whose median is latency and
+      // whose shape is sigma.
+      LogNormal,
+      // Hits are delayed by latency, except that a fraction spikeProbability
+      // of them is delayed by spike instead.
+      TailSpikes,
+    };
+
+    Distribution distribution{Distribution::Constant};
+    std::chrono::microseconds latency{0};
+    double sigma{0.0};
+    double spikeProbability{0.0};
+    std::chrono::microseconds spike{0};
+
+    /**
+     * Pick the delay for one hit of the fault.
+     */
+    std::chrono::microseconds sample() const;
+  };
+
   explicit FaultInjector(bool enabled);
   ~FaultInjector();
 
@@ -47,12 +77,25 @@ class FaultInjector {
   FOLLY_NODISCARD folly::SemiFuture<folly::Unit> checkAsync(
       folly::StringPiece keyClass,
       folly::StringPiece keyValue) {
-    if (UNLIKELY(enabled_)) {
+    if (UNLIKELY(enabled_) && hasFaults()) {
       return checkAsyncImpl(keyClass, keyValue);
     }
     return folly::makeSemiFuture();
   }
 
+  /**
+   * Like checkAsync(), but without allocating anything when no fault matches,
+   * for the hot paths that already return an ImmediateFuture.
+   */
+  FOLLY_NODISCARD ImmediateFuture<folly::Unit> checkImmediate(
+      folly::StringPiece keyClass,
+      folly::StringPiece keyValue) {
+    if (UNLIKELY(enabled_) && hasFaults()) {
+      return checkAsyncImpl(keyClass, keyValue);
+    }
+    return folly::unit;
+  }
+
   /**
    * Check for an injected fault with the specified key.
    *
@@ -63,7 +106,7 @@ class FaultInjector {
    * code.
    */
   void check(folly::StringPiece keyClass, folly::StringPiece keyValue) {
-    if (UNLIKELY(enabled_)) {
+    if (UNLIKELY(enabled_) && hasFaults()) {
       return checkImpl(keyClass, keyValue);
     }
   }
@@ -110,6 +153,16 @@ class FaultInjector {
       folly::exception_wrapper error,
       size_t count = 0);
 
+  /**
+   * Inject a fault that delays each check call by a duration drawn from the
+   * given profile, and then continues normally.
+   */
+  void injectLatency(
+      folly::StringPiece keyClass,
+      folly::StringPiece keyValueRegex,
+      LatencyProfile profile,
+      size_t count = 0);
+
   /**
    * Inject a dummy fault that does not trigger any error.
    *
@@ -167,10 +220,17 @@ class FaultInjector {
     std::optional<folly::exception_wrapper> error;
   };
 
+  struct Latency {
+    explicit Latency(LatencyProfile p) : profile(p) {}
+
+    LatencyProfile profile;
+  };
+
   using FaultBehavior = boost::variant<
       folly::Unit, // no fault
       Block, // block until explicitly unblocked at a later point
       Delay, // delay for a specified amount of time
+      Latency, // delay for an amount of time drawn from a profile
       folly::exception_wrapper // throw an exception
       >;
   struct Fault {
@@ -198,6 +258,10 @@ class FaultInjector {
     folly::StringKeyedUnorderedMap<std::vector<BlockedCheck>> blockedChecks;
   };
 
+  bool hasFaults() const {
+    return numFaults_.load(std::memory_order_acquire) > 0;
+  }
+
   FOLLY_NODISCARD folly::SemiFuture<folly::Unit> checkAsyncImpl(
       folly::StringPiece keyClass,
       folly::StringPiece keyValue);
@@ -226,6 +290,11 @@ class FaultInjector {
    * enabled in the first place, and fall through
    */
   bool const enabled_{false};
+  /**
+   * The number of faults in state_, so that checks can skip the lock and the
+   * lookup entirely while none are defined.  Only updated with state_ locked.
+   */
+  std::atomic<size_t> numFaults_{0};
   folly::Synchronized<State> state_;
 };
 
@@ -7,6 +7,7 @@
 
 #include "eden/fs/utils/FileHash.h"
 #include <openssl/sha.h>
+#include <memory>
 #include "eden/fs/utils/WinError.h"
 
 namespace facebook::eden {
@@ -35,11 +36,11 @@ Hash20 getFileSha1(AbsolutePathPiece filePath) {
 
   SHA_CTX ctx;
   SHA1_Init(&ctx);
+  auto buf = std::make_unique<uint8_t[]>(kFileSha1ReadSize);
   while (true) {
-    uint8_t buf[8192];
-
     DWORD bytesRead;
-    if (!ReadFile(fileHandle, buf, sizeof(buf), &bytesRead, nullptr)) {
+    if (!ReadFile(
+            fileHandle, buf.get(), kFileSha1ReadSize, &bytesRead, nullptr)) {
       throw makeWin32ErrorExplicit(
           GetLastError(),
           fmt::format(
@@ -50,7 +51,7 @@ Hash20 getFileSha1(AbsolutePathPiece filePath) {
       break;
     }
 
-    SHA1_Update(&ctx, buf, bytesRead);
+    SHA1_Update(&ctx, buf.get(), bytesRead);
   }
 
   static_assert(Hash20::RAW_SIZE == SHA_DIGEST_LENGTH);
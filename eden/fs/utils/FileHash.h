@@ -12,6 +12,15 @@
 
 namespace facebook::eden {
 
+/**
+ * How much of a file is read at a time when computing its SHA-1.
+ *
+ * OpenSSL already uses the SHA-1 instructions of the CPU when it has them,
+ * at which point hashing runs at several GB/s and the cost of computing the
+ * SHA-1 of a file is dominated by the number of reads.
+ */
+constexpr size_t kFileSha1ReadSize = 64 * 1024;
+
 #ifdef _WIN32
 /** Compute the sha1 of the file */
 Hash20 getFileSha1(AbsolutePathPiece filePath);
@@ -155,16 +155,25 @@ ImmediateFuture<T>::thenTry(Func&& func) && {
             folly::exception_wrapper(std::current_exception(), ex));
       }
     case Kind::SemiFuture: {
+      if (semi_.isReady()) {
+        // The SemiFuture completed after this ImmediateFuture was built. Run
+        // func now instead of allocating a deferred continuation for it.
+        *this = ImmediateFuture<T>{std::move(semi_).getTry()};
+        return std::move(*this).thenTry(std::forward<Func>(func));
+      }
+
       // In the case where Func returns an ImmediateFuture, we need to
       // transform that return value into a SemiFuture so that the return
       // type is a SemiFuture<NewType> and not a
-      // SemiFuture<ImmediateFuture<NewType>>.
-      auto semiFut = std::move(semi_).defer(std::forward<Func>(func));
+      // SemiFuture<ImmediateFuture<NewType>>. Doing so in the same
+      // continuation, which SemiFuture unwraps, saves allocating a second one.
       if constexpr (detail::isImmediateFuture<FuncRetType>::value) {
-        return std::move(semiFut).deferValue(
-            [](auto&& immFut) { return std::move(immFut).semi(); });
+        return std::move(semi_).defer(
+            [func = std::forward<Func>(func)](folly::Try<T>&& try_) mutable {
+              return func(std::move(try_)).semi();
+            });
       } else {
-        return semiFut;
+        return std::move(semi_).defer(std::forward<Func>(func));
       }
     }
     case Kind::Nothing:
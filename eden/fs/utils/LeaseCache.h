@@ -6,13 +6,34 @@
  */
 
 #pragma once
+#include <folly/Synchronized.h>
 #include <folly/container/EvictingCacheMap.h>
 #include <folly/futures/Future.h>
 #include <folly/futures/SharedPromise.h>
+#include <folly/hash/Hash.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace facebook {
 namespace eden {
 
+/**
+ * An LRU cache of values that are loaded asynchronously by fetcher.
+ *
+ * Concurrent gets of a key that isn't cached share a single fetch. Failed
+ * fetches are not cached: the next get of the key fetches it again. If ttl
+ * is not zero, values are fetched again once they were loaded more than ttl
+ * ago.
+ *
+ * Keys are spread over numShards independently locked shards, each holding
+ * up to maxSize / numShards entries, so that gets of different keys rarely
+ * contend on the same lock.
+ */
 template <typename KEY, typename VAL, typename HASH = std::hash<KEY>>
 class LeaseCache {
  public:
@@ -20,59 +41,165 @@ class LeaseCache {
   using FutureType = folly::Future<ValuePtr>;
   using SharedPromiseType = std::shared_ptr<folly::SharedPromise<ValuePtr>>;
   using FetchFunc = std::function<FutureType(const KEY& key)>;
-
- private:
-  std::mutex lock_;
-  folly::EvictingCacheMap<KEY, SharedPromiseType, HASH> cache_;
-  FetchFunc fetcher_;
-
- public:
-  LeaseCache(size_t maxSize, FetchFunc fetcher, size_t clearSize = 1)
-      : cache_(maxSize, clearSize), fetcher_(fetcher) {}
+  using Clock = std::chrono::steady_clock;
+
+  struct Stats {
+    /** Gets answered by an already loaded value. */
+    uint64_t hits{0};
+    /** Gets that waited on the fetch started by an earlier get. */
+    uint64_t coalesced{0};
+    /** Gets that started a fetch. */
+    uint64_t misses{0};
+  };
+
+  LeaseCache(
+      size_t maxSize,
+      FetchFunc fetcher,
+      size_t clearSize = 1,
+      Clock::duration ttl = Clock::duration::zero(),
+      size_t numShards = 1)
+      : state_{std::make_shared<State>(maxSize, clearSize, ttl, numShards)},
+        fetcher_(std::move(fetcher)) {}
 
   void set(const KEY& key, ValuePtr val) {
-    std::lock_guard<std::mutex> g(lock_);
     auto entry = std::make_shared<typename SharedPromiseType::element_type>();
-    entry->setValue(val);
-    cache_.set(key, entry);
+    entry->setValue(std::move(val));
+    auto expiresAt = state_->computeExpiry();
+    state_->getShard(key).lock()->set(key, Entry{std::move(entry), expiresAt});
   }
 
   void erase(const KEY& key) {
-    std::lock_guard<std::mutex> g(lock_);
-    cache_.erase(key);
+    state_->getShard(key).lock()->erase(key);
   }
 
   void setMaxSize(size_t size) {
-    cache_.setMaxSize(size);
+    auto shardSize = state_->getShardSize(size);
+    for (auto& shard : state_->shards) {
+      shard->lock()->setMaxSize(shardSize);
+    }
   }
 
   FutureType get(const KEY& key) {
     SharedPromiseType entry;
 
     {
-      std::lock_guard<std::mutex> g(lock_);
-
-      auto it = cache_.find(key);
-      if (it != cache_.end()) {
-        entry = it->second;
-        return entry->getFuture();
+      auto cache = state_->getShard(key).lock();
+
+      auto it = cache->find(key);
+      if (it != cache->end() && !isExpired(it->second)) {
+        auto& counter = it->second.promise->isFulfilled() ? state_->hits
+                                                          : state_->coalesced;
+        counter.fetch_add(1, std::memory_order_relaxed);
+        return it->second.promise->getFuture();
       }
 
+      state_->misses.fetch_add(1, std::memory_order_relaxed);
       entry = std::make_shared<typename SharedPromiseType::element_type>();
-      cache_.set(key, entry);
+      cache->set(key, Entry{entry});
     }
 
     auto future = entry->getFuture();
 
+    // The fetch may outlive the cache, so only hold on to its state.
     fetcher_(key).thenTry(
-        [entry](folly::Try<ValuePtr>&& t) { entry->setTry(std::move(t)); });
+        [state = state_, key, entry](folly::Try<ValuePtr>&& t) {
+          state->fetchComplete(key, entry, t.hasException());
+          entry->setTry(std::move(t));
+        });
 
     return future;
   }
 
   bool exists(const KEY& key) {
-    return cache_.exists(key);
+    auto cache = state_->getShard(key).lock();
+    auto it = cache->findWithoutPromotion(key);
+    return it != cache->end() && !isExpired(it->second);
+  }
+
+  Stats getStats() const {
+    Stats stats;
+    stats.hits = state_->hits.load(std::memory_order_relaxed);
+    stats.coalesced = state_->coalesced.load(std::memory_order_relaxed);
+    stats.misses = state_->misses.load(std::memory_order_relaxed);
+    return stats;
   }
+
+ private:
+  struct Entry {
+    SharedPromiseType promise;
+    /** Only set once the value is loaded, and only if there is a ttl. */
+    Clock::time_point expiresAt{Clock::time_point::max()};
+  };
+
+  using Shard = folly::
+      Synchronized<folly::EvictingCacheMap<KEY, Entry, HASH>, std::mutex>;
+
+  struct State {
+    State(
+        size_t maxSize,
+        size_t clearSize,
+        Clock::duration ttl,
+        size_t numShards)
+        : ttl{ttl}, numShards{std::max<size_t>(numShards, 1)} {
+      shards.reserve(this->numShards);
+      for (size_t i = 0; i < this->numShards; ++i) {
+        shards.push_back(std::make_unique<Shard>(
+            folly::in_place, getShardSize(maxSize), clearSize));
+      }
+    }
+
+    size_t getShardSize(size_t maxSize) const {
+      return (maxSize + numShards - 1) / numShards;
+    }
+
+    Shard& getShard(const KEY& key) {
+      if (numShards == 1) {
+        return *shards[0];
+      }
+      // Mix the hash so that the keys of one shard don't all share the same
+      // low bits in its own hash table.
+      auto hash = folly::hash::twang_mix64(HASH{}(key));
+      return *shards[hash % numShards];
+    }
+
+    Clock::time_point computeExpiry() const {
+      return ttl == Clock::duration::zero() ? Clock::time_point::max()
+                                            : Clock::now() + ttl;
+    }
+
+    void fetchComplete(
+        const KEY& key,
+        const SharedPromiseType& promise,
+        bool failed) {
+      auto cache = getShard(key).lock();
+      auto it = cache->findWithoutPromotion(key);
+      // The entry may have been evicted, erased or replaced meanwhile.
+      if (it == cache->end() || it->second.promise != promise) {
+        return;
+      }
+      if (failed) {
+        cache->erase(it);
+      } else {
+        it->second.expiresAt = computeExpiry();
+      }
+    }
+
+    const Clock::duration ttl;
+    const size_t numShards;
+    std::vector<std::unique_ptr<Shard>> shards;
+
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> coalesced{0};
+    std::atomic<uint64_t> misses{0};
+  };
+
+  static bool isExpired(const Entry& entry) {
+    return entry.expiresAt != Clock::time_point::max() &&
+        Clock::now() >= entry.expiresAt;
+  }
+
+  std::shared_ptr<State> state_;
+  FetchFunc fetcher_;
 };
 
 } // namespace eden
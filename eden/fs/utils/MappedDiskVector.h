@@ -9,6 +9,7 @@
 
 #include <sys/mman.h>
 #include <unistd.h>
+#include <algorithm>
 #include <type_traits>
 
 #include <eden/fs/utils/Bug.h>
@@ -16,6 +17,7 @@
 #include <folly/File.h>
 #include <folly/FileUtil.h>
 #include <folly/Range.h>
+#include <folly/String.h>
 #include <folly/logging/xlog.h>
 
 namespace facebook {
@@ -244,6 +246,8 @@ class MappedDiskVector {
     end_ = other.end_;
     map_ = other.map_;
     mapSizeInBytes_ = other.mapSizeInBytes_;
+    hugePages_ = other.hugePages_;
+    hugePageAdviceCount_ = other.hugePageAdviceCount_;
 
     other.begin_ = nullptr;
     other.end_ = nullptr;
@@ -261,6 +265,8 @@ class MappedDiskVector {
     end_ = other.end_;
     map_ = other.map_;
     mapSizeInBytes_ = other.mapSizeInBytes_;
+    hugePages_ = other.hugePages_;
+    hugePageAdviceCount_ = other.hugePageAdviceCount_;
 
     other.begin_ = nullptr;
     other.end_ = nullptr;
@@ -283,6 +289,25 @@ class MappedDiskVector {
     return (mapSizeInBytes_ - sizeof(Header)) / sizeof(T);
   }
 
+  /**
+   * Ask the kernel to back the mapping, now and after it grows, with
+   * transparent huge pages, to take fewer TLB misses when walking a large
+   * vector. This is only a hint: most filesystems only support huge pages
+   * for shared memory mappings, and the kernel ignores it elsewhere.
+   */
+  void adviseHugePages() {
+    hugePages_ = true;
+    applyHugePages();
+  }
+
+  /**
+   * How many times the mapping was advised to use huge pages, counting the
+   * remappings done when growing. For tests.
+   */
+  size_t getHugePageAdviceCount() const {
+    return hugePageAdviceCount_;
+  }
+
   T& operator[](size_t index) {
     return begin_[index];
   }
@@ -299,8 +324,7 @@ class MappedDiskVector {
           "Growth must expand the file more than a single record");
 
       size_t oldSize = size();
-      size_t newFileSize =
-          mapSizeInBytes_ + GROWTH_IN_PAGES * detail::kPageSize;
+      size_t newFileSize = mapSizeInBytes_ + growthInBytes();
 
       // Always keep the file size a whole number of pages.
       XCHECK_EQ(0ul, newFileSize % detail::kPageSize);
@@ -336,6 +360,8 @@ class MappedDiskVector {
 
       begin_ = reinterpret_cast<T*>(static_cast<Header*>(newMap) + 1);
       end_ = begin_ + oldSize;
+
+      applyHugePages();
     }
 
     T* out = end_;
@@ -382,6 +408,21 @@ class MappedDiskVector {
       "header alignment is 16 bytes in case someone uses SSE values");
 
   static constexpr size_t GROWTH_IN_PAGES = 256;
+  static constexpr size_t MAX_GROWTH_IN_PAGES = 64 * 1024;
+
+  /**
+   * Growing the file means an ftruncate and an mremap, and the caller
+   * typically holds an exclusive lock meanwhile, so large files grow by half
+   * their current size rather than by a fixed amount. Growth stays a whole
+   * number of pages, between GROWTH_IN_PAGES and MAX_GROWTH_IN_PAGES.
+   */
+  size_t growthInBytes() const {
+    size_t pages = std::clamp(
+        mapSizeInBytes_ / 2 / detail::kPageSize,
+        GROWTH_IN_PAGES,
+        MAX_GROWTH_IN_PAGES);
+    return pages * detail::kPageSize;
+  }
 
   static MappedDiskVector initializeFromScratch(folly::File file) {
     // Start the file large enough to handle the header and a little under one
@@ -475,6 +516,19 @@ class MappedDiskVector {
         static_cast<char*>(map_) + mapSizeInBytes_);
   }
 
+  void applyHugePages() {
+    if (!hugePages_) {
+      return;
+    }
+    ++hugePageAdviceCount_;
+#ifdef MADV_HUGEPAGE
+    if (0 != madvise(map_, mapSizeInBytes_, MADV_HUGEPAGE)) {
+      XLOG(DBG2) << "madvise(MADV_HUGEPAGE) failed on MappedDiskVector: "
+                 << folly::errnoStr(errno);
+    }
+#endif
+  }
+
   bool hasRoom(size_t amount) const {
     // Technically, the expression (end_ + amount) is constructing a pointer
     // past the end of the "object" (mmap) and is thus UB.  But hopefully no
@@ -517,6 +571,8 @@ class MappedDiskVector {
 
   void* map_{nullptr};
   size_t mapSizeInBytes_{0}; // must be nonzero, multiple of page size
+  bool hugePages_{false};
+  size_t hugePageAdviceCount_{0};
 
   folly::File file_;
 
@@ -9,6 +9,13 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <vector>
+
+#include <folly/Conv.h>
+#include <folly/String.h>
+
+#include "eden/fs/utils/FileUtils.h"
+#include "eden/fs/utils/PathFuncs.h"
 
 namespace facebook::eden {
 
@@ -27,4 +34,87 @@ void assertZeroBits(const void* memory, size_t size) {
     abort();
   }
 }
+
+std::optional<double> parsePressureStallPercent(folly::StringPiece contents) {
+  // The file looks like:
+  //   some avg10=0.12 avg60=0.05 avg300=0.01 total=123456
+  //   full avg10=0.00 avg60=0.00 avg300=0.00 total=6789
+  std::vector<folly::StringPiece> lines;
+  folly::split('\n', contents, lines);
+  for (auto line : lines) {
+    if (!line.removePrefix("some ")) {
+      continue;
+    }
+    std::vector<folly::StringPiece> fields;
+    folly::split(' ', line, fields, /*ignoreEmpty=*/true);
+    for (auto field : fields) {
+      if (field.removePrefix("avg10=")) {
+        auto value = folly::tryTo<double>(field);
+        if (value.hasValue()) {
+          return value.value();
+        }
+        return std::nullopt;
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+std::optional<std::string> parseCgroup2Path(folly::StringPiece contents) {
+  // cgroup v2 is reported as hierarchy 0 with no controllers:
+  //   0::/user.slice/user-1000.slice/edenfs.service
+  std::vector<folly::StringPiece> lines;
+  folly::split('\n', contents, lines);
+  for (auto line : lines) {
+    if (line.removePrefix("0::")) {
+      return folly::trimWhitespace(line).str();
+    }
+  }
+  return std::nullopt;
+}
+
+std::optional<double> parseCgroupUsageRatio(
+    folly::StringPiece current,
+    folly::StringPiece max) {
+  auto maxBytes = folly::tryTo<uint64_t>(folly::trimWhitespace(max));
+  auto currentBytes = folly::tryTo<uint64_t>(folly::trimWhitespace(current));
+  // memory.max is "max" when the cgroup is unlimited.
+  if (!maxBytes.hasValue() || !currentBytes.hasValue() ||
+      maxBytes.value() == 0) {
+    return std::nullopt;
+  }
+  return static_cast<double>(currentBytes.value()) /
+      static_cast<double>(maxBytes.value());
+}
+
+MemoryPressure readMemoryPressure() {
+  MemoryPressure pressure;
+#ifdef __linux__
+  if (auto cgroupFile = readFile("/proc/self/cgroup"_abspath);
+      cgroupFile.hasValue()) {
+    if (auto cgroup = parseCgroup2Path(cgroupFile.value())) {
+      auto cgroupDir = canonicalPath(folly::to<std::string>(
+          "/sys/fs/cgroup", *cgroup == "/" ? "" : *cgroup));
+      auto current = readFile(cgroupDir + "memory.current"_pc);
+      auto max = readFile(cgroupDir + "memory.max"_pc);
+      if (current.hasValue() && max.hasValue()) {
+        pressure.cgroupUsageRatio =
+            parseCgroupUsageRatio(current.value(), max.value());
+      }
+      if (auto stall = readFile(cgroupDir + "memory.pressure"_pc);
+          stall.hasValue()) {
+        pressure.stallPercent = parsePressureStallPercent(stall.value());
+      }
+    }
+  }
+  if (!pressure.stallPercent) {
+    if (auto stall = readFile("/proc/pressure/memory"_abspath);
+        stall.hasValue()) {
+      pressure.stallPercent = parsePressureStallPercent(stall.value());
+    }
+  }
+#endif
+  return pressure;
+}
+
 } // namespace facebook::eden
@@ -7,6 +7,8 @@
 
 #pragma once
 #include <folly/FBString.h>
+#include <folly/Range.h>
+#include <optional>
 #include <string>
 
 namespace facebook::eden {
@@ -39,4 +41,48 @@ size_t estimateIndirectMemoryUsage(const StringType& s) {
   }
 }
 
+/**
+ * How close the cgroup EdenFS runs in, or the whole system, is to running out
+ * of memory. Each field is std::nullopt if the platform doesn't report it.
+ */
+struct MemoryPressure {
+  /**
+   * Percentage of the last 10 seconds during which at least one task was
+   * stalled waiting for memory, from Linux's pressure stall information.
+   */
+  std::optional<double> stallPercent;
+
+  /**
+   * memory.current / memory.max of our cgroup. Unset if it has no limit.
+   */
+  std::optional<double> cgroupUsageRatio;
+};
+
+/**
+ * Read the memory pressure of the current process' cgroup, falling back to
+ * the system-wide stall information. Only implemented on Linux, with cgroup
+ * v2; returns an empty MemoryPressure elsewhere.
+ */
+MemoryPressure readMemoryPressure();
+
+/**
+ * Parse the "some avg10" value of a memory.pressure or /proc/pressure/memory
+ * file.
+ */
+std::optional<double> parsePressureStallPercent(folly::StringPiece contents);
+
+/**
+ * Parse the cgroup v2 path, relative to the cgroup mount, out of the
+ * contents of /proc/<pid>/cgroup.
+ */
+std::optional<std::string> parseCgroup2Path(folly::StringPiece contents);
+
+/**
+ * Compute memory.current / memory.max from the contents of these cgroup
+ * files. Returns std::nullopt if the cgroup has no limit.
+ */
+std::optional<double> parseCgroupUsageRatio(
+    folly::StringPiece current,
+    folly::StringPiece max);
+
 } // namespace facebook::eden
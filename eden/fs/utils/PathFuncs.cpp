@@ -10,6 +10,7 @@
 #include <boost/filesystem/operations.hpp>
 
 #include <folly/Exception.h>
+#include <folly/lang/Bits.h>
 #include <folly/logging/xlog.h>
 #include <folly/portability/Stdlib.h>
 #include <optional>
@@ -378,6 +379,41 @@ AbsolutePath executablePath() {
 #endif
 }
 
+namespace {
+/**
+ * Load up to 8 bytes of data as a big endian word, padded with zeros, with
+ * its ASCII upper case letters folded to lower case.
+ *
+ * This folds all the bytes of the word at once: the high bit of each byte of
+ * upper is set when the byte is between 'A' and 'Z', which is then turned
+ * into the 0x20 bit that distinguishes the two cases.
+ */
+uint64_t loadCaseFolded(const char* data, size_t size) {
+  constexpr uint64_t kOnes = 0x0101010101010101;
+  constexpr uint64_t kHighBits = kOnes * 0x80;
+  uint64_t word = 0;
+  memcpy(&word, data, size);
+  auto low = word & ~kHighBits;
+  auto atLeastA = low + kOnes * (0x80 - 'A');
+  auto pastZ = low + kOnes * (0x80 - 'Z' - 1);
+  auto upper = atLeastA & ~pastZ & ~word & kHighBits;
+  return folly::Endian::big(word | (upper >> 2));
+}
+} // namespace
+
+bool caseInsensitiveLess(folly::StringPiece left, folly::StringPiece right) {
+  auto common = std::min(left.size(), right.size());
+  for (size_t offset = 0; offset < common; offset += sizeof(uint64_t)) {
+    auto size = std::min(common - offset, sizeof(uint64_t));
+    auto leftWord = loadCaseFolded(left.data() + offset, size);
+    auto rightWord = loadCaseFolded(right.data() + offset, size);
+    if (leftWord != rightWord) {
+      return leftWord < rightWord;
+    }
+  }
+  return left.size() < right.size();
+}
+
 CompareResult comparePathComponent(
     PathComponentPiece left,
     PathComponentPiece right,
@@ -1996,6 +1996,15 @@ CompareResult comparePathComponent(
     PathComponentPiece right,
     CaseSensitivity caseSensitivity);
 
+/**
+ * Orders the passed in strings as if their ASCII letters were lower case.
+ *
+ * Two strings are equivalent under this ordering exactly when they are equal
+ * according to folly::AsciiCaseInsensitive, which lets case insensitive
+ * lookups binary search an index sorted with it.
+ */
+bool caseInsensitiveLess(folly::StringPiece left, folly::StringPiece right);
+
 /**
  * Convenient literals for constructing path types.
  */
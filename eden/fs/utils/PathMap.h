@@ -12,6 +12,7 @@
 #include <functional>
 #include <iterator>
 #include <utility>
+#include <vector>
 #include "eden/fs/utils/CaseSensitivity.h"
 #include "eden/fs/utils/PathFuncs.h"
 
@@ -31,6 +32,9 @@ namespace eden {
  *   it is better to pre-sort the data to be inserted.
  * - Since insert and erase operations move the vector contents around,
  *   those operations invalidate iterators.
+ * - Case insensitive maps also keep the positions of their entries sorted by
+ *   caseInsensitiveLess, so that lookups which do not match the case of the
+ *   key are a binary search too.
  */
 template <typename Value, typename Key = PathComponent>
 class PathMap : private folly::fbvector<std::pair<Key, Value>> {
@@ -76,6 +80,56 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
   // occupy any space.
   Compare compare_;
   CaseSensitivity caseSensitive_{kPathMapDefaultCaseSensitive};
+  // Only maintained for case insensitive maps.
+  std::vector<size_t> caseFoldedIndex_;
+
+  folly::StringPiece keyAt(size_t index) const {
+    return Piece((cbegin() + index)->first).stringPiece();
+  }
+
+  /** Find the entry whose key matches key ignoring case, or end(). */
+  size_t findCaseInsensitive(Piece key) const {
+    auto iter = std::lower_bound(
+        caseFoldedIndex_.cbegin(),
+        caseFoldedIndex_.cend(),
+        key.stringPiece(),
+        [this](size_t index, folly::StringPiece piece) {
+          return caseInsensitiveLess(keyAt(index), piece);
+        });
+    if (iter == caseFoldedIndex_.cend() ||
+        caseInsensitiveLess(key.stringPiece(), keyAt(*iter))) {
+      return size();
+    }
+    return *iter;
+  }
+
+  /** Insert pair at pos, which must be its sorted position. */
+  template <typename P>
+  typename Vector::iterator insertAt(typename Vector::iterator pos, P&& pair) {
+    size_t index = pos - begin();
+    auto iter = Vector::insert(pos, std::forward<P>(pair));
+    if (caseSensitive_ == CaseSensitivity::Insensitive) {
+      // Appending, as when populating from sorted entries, shifts nothing.
+      if (index + 1 != size()) {
+        for (auto& position : caseFoldedIndex_) {
+          if (position >= index) {
+            ++position;
+          }
+        }
+      }
+      auto key = keyAt(index);
+      caseFoldedIndex_.insert(
+          std::lower_bound(
+              caseFoldedIndex_.begin(),
+              caseFoldedIndex_.end(),
+              key,
+              [this](size_t position, folly::StringPiece piece) {
+                return caseInsensitiveLess(keyAt(position), piece);
+              }),
+          index);
+    }
+    return iter;
+  }
 
  public:
   // Various type aliases to satisfy container concepts.
@@ -121,7 +175,9 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
 
   // Inherit the underlying vector copy/assignment.
   PathMap(const PathMap& other)
-      : Vector(other), caseSensitive_(other.caseSensitive_) {}
+      : Vector(other),
+        caseSensitive_(other.caseSensitive_),
+        caseFoldedIndex_(other.caseFoldedIndex_) {}
   PathMap& operator=(const PathMap& other) {
     PathMap(other).swap(*this);
     return *this;
@@ -129,7 +185,9 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
 
   // inherit Move construction.
   PathMap(PathMap&& other) noexcept
-      : Vector(std::move(other)), caseSensitive_(other.caseSensitive_) {}
+      : Vector(std::move(other)),
+        caseSensitive_(other.caseSensitive_),
+        caseFoldedIndex_(std::move(other.caseFoldedIndex_)) {}
   PathMap& operator=(PathMap&& other) {
     other.swap(*this);
     return *this;
@@ -139,12 +197,10 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
   using Vector::begin;
   using Vector::cbegin;
   using Vector::cend;
-  using Vector::clear;
   using Vector::crbegin;
   using Vector::crend;
   using Vector::empty;
   using Vector::end;
-  using Vector::erase;
   using Vector::max_size;
   using Vector::rbegin;
   using Vector::rend;
@@ -154,6 +210,46 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
   void swap(PathMap& other) noexcept {
     Vector::swap(other);
     std::swap(caseSensitive_, other.caseSensitive_);
+    caseFoldedIndex_.swap(other.caseFoldedIndex_);
+  }
+
+  // Allocate room for count entries up front, so that populating the map
+  // from a range of known size allocates its storage once.
+  void reserve(size_type count) {
+    Vector::reserve(count);
+    if (caseSensitive_ == CaseSensitivity::Insensitive) {
+      caseFoldedIndex_.reserve(count);
+    }
+  }
+
+  void clear() {
+    Vector::clear();
+    caseFoldedIndex_.clear();
+  }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    if (caseSensitive_ == CaseSensitivity::Insensitive) {
+      size_t begin = first - cbegin();
+      size_t end = last - cbegin();
+      caseFoldedIndex_.erase(
+          std::remove_if(
+              caseFoldedIndex_.begin(),
+              caseFoldedIndex_.end(),
+              [&](size_t position) {
+                return position >= begin && position < end;
+              }),
+          caseFoldedIndex_.end());
+      for (auto& position : caseFoldedIndex_) {
+        if (position >= end) {
+          position -= end - begin;
+        }
+      }
+    }
+    return Vector::erase(first, last);
+  }
+
+  iterator erase(const_iterator pos) {
+    return erase(pos, pos + 1);
   }
 
   // lower_bound performs the binary search for locating keys.
@@ -178,12 +274,7 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
       // When !caseSensitive_, for performance, we will do a case sensitive
       // search first which should cover most of the cases and if not found then
       // do a case insensitive search.
-      for (iter = begin(); iter != end(); ++iter) {
-        if (key.stringPiece().equals(
-                iter->first.stringPiece(), folly::AsciiCaseInsensitive())) {
-          return iter;
-        }
-      }
+      return begin() + findCaseInsensitive(key);
     }
     return end();
   }
@@ -198,12 +289,7 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
       return iter;
     }
     if (caseSensitive_ == CaseSensitivity::Insensitive) {
-      for (iter = begin(); iter != end(); ++iter) {
-        if (key.stringPiece().equals(
-                iter->first.stringPiece(), folly::AsciiCaseInsensitive())) {
-          return iter;
-        }
-      }
+      return cbegin() + findCaseInsensitive(key);
     }
     return end();
   }
@@ -221,17 +307,15 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
     }
 
     if (caseSensitive_ == CaseSensitivity::Insensitive) {
-      for (auto insens = begin(); insens != end(); ++insens) {
-        if (val.first.stringPiece().equals(
-                insens->first.stringPiece(), folly::AsciiCaseInsensitive())) {
-          // Found it; leave it alone
-          return std::make_pair(insens, false);
-        }
+      auto index = findCaseInsensitive(val.first);
+      if (index != size()) {
+        // Found it; leave it alone
+        return std::make_pair(begin() + index, false);
       }
     }
 
     // Otherwise, iter is the insertion point
-    return std::make_pair(Vector::insert(iter, val), true);
+    return std::make_pair(insertAt(iter, val), true);
   }
 
   /** Emplace a new key-value pair by constructing it in-place.
@@ -250,17 +334,15 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
     }
 
     if (caseSensitive_ == CaseSensitivity::Insensitive) {
-      for (auto insens = begin(); insens != end(); ++insens) {
-        if (key.stringPiece().equals(
-                insens->first.stringPiece(), folly::AsciiCaseInsensitive())) {
-          // Found it; leave it alone
-          return std::make_pair(insens, false);
-        }
+      auto index = findCaseInsensitive(key);
+      if (index != size()) {
+        // Found it; leave it alone
+        return std::make_pair(begin() + index, false);
       }
     }
 
     // Otherwise, iter is the insertion point
-    iter = Vector::emplace(
+    iter = insertAt(
         iter, std::make_pair(Key(key), Value(std::forward<Args>(args)...)));
     return std::make_pair(iter, true);
   }
@@ -277,17 +359,15 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
 
     if (caseSensitive_ == CaseSensitivity::Insensitive) {
       // Case insensitive lookup
-      for (auto insens = begin(); insens != end(); ++insens) {
-        if (key.stringPiece().equals(
-                insens->first.stringPiece(), folly::AsciiCaseInsensitive())) {
-          // Found it
-          return insens->second;
-        }
+      auto index = findCaseInsensitive(key);
+      if (index != size()) {
+        // Found it
+        return (begin() + index)->second;
       }
     }
 
     // Not yet present, make a new one at the insertion point
-    iter = Vector::insert(iter, std::make_pair(Key(key), mapped_type()));
+    iter = insertAt(iter, std::make_pair(Key(key), mapped_type()));
     return iter->second;
   }
 
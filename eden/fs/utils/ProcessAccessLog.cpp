@@ -46,11 +46,11 @@ struct ThreadLocalBucket {
   bool add(
       uint64_t secondsSinceStart,
       pid_t pid,
-      std::chrono::nanoseconds duration) {
+      const ProcessAccessLog::RequestCost& cost) {
     auto state = state_.lock();
 
     bool isNewPid = false;
-    state->buckets.add(secondsSinceStart, pid, isNewPid, duration);
+    state->buckets.add(secondsSinceStart, pid, isNewPid, cost);
     return isNewPid;
   }
 
@@ -86,7 +86,7 @@ struct ThreadLocalBucket {
    */
   struct State {
     explicit State(ProcessAccessLog* pal) : owner{pal} {}
-    ProcessAccessLog::Buckets buckets;
+    ProcessAccessLog::ThreadBuckets buckets;
     ProcessAccessLog* owner;
   };
 
@@ -98,6 +98,24 @@ struct BucketTag;
 folly::ThreadLocalPtr<ThreadLocalBucket, BucketTag> threadLocalBucketPtr;
 } // namespace
 
+void ProcessAccessLog::PerBucketAccessCounts::add(const RequestCost& cost) {
+  duration += cost.duration;
+  cpuTime += cost.cpuTime;
+  backingStoreBytes += cost.backingStoreBytes;
+}
+
+void ProcessAccessLog::PerBucketAccessCounts::merge(
+    const PerBucketAccessCounts& other) {
+  for (std::underlying_type_t<AccessType> type = 0;
+       type != folly::to_underlying(AccessType::Last);
+       type++) {
+    counts[type] += other.counts[type];
+  }
+  duration += other.duration;
+  cpuTime += other.cpuTime;
+  backingStoreBytes += other.backingStoreBytes;
+}
+
 void ProcessAccessLog::Bucket::clear() {
   accessCountsByPid.clear();
 }
@@ -114,21 +132,72 @@ void ProcessAccessLog::Bucket::add(
 void ProcessAccessLog::Bucket::add(
     pid_t pid,
     bool& isNewPid,
-    std::chrono::nanoseconds duration) {
+    const RequestCost& cost) {
   auto [it, contains] = accessCountsByPid.emplace(pid, PerBucketAccessCounts{});
-  it->second.duration += duration;
+  it->second.add(cost);
   isNewPid = contains;
 }
 
 void ProcessAccessLog::Bucket::merge(const Bucket& other) {
-  for (auto [pid, otherAccessCounts] : other.accessCountsByPid) {
-    for (std::underlying_type_t<AccessType> type = 0;
-         type != folly::to_underlying(AccessType::Last);
-         type++) {
-      accessCountsByPid[pid].counts[type] += otherAccessCounts.counts[type];
+  for (const auto& [pid, otherAccessCounts] : other.accessCountsByPid) {
+    accessCountsByPid[pid].merge(otherAccessCounts);
+  }
+}
+
+void ProcessAccessLog::Bucket::merge(const ThreadBucket& other) {
+  for (const auto& slot : other.slots) {
+    if (slot.used) {
+      accessCountsByPid[slot.pid].merge(slot.counts);
+    }
+  }
+  merge(other.overflow);
+}
+
+void ProcessAccessLog::ThreadBucket::clear() {
+  for (auto& slot : slots) {
+    slot.used = false;
+  }
+  overflow.clear();
+}
+
+ProcessAccessLog::PerBucketAccessCounts& ProcessAccessLog::ThreadBucket::find(
+    pid_t pid,
+    bool& isNewPid) {
+  // Fibonacci hashing spreads the mostly sequential pids over the slots.
+  auto index = (static_cast<uint32_t>(pid) * 2654435769u) >> 29;
+  static_assert(kSlots == 1 << (32 - 29));
+  for (size_t probe = 0; probe < kSlots; ++probe) {
+    auto& slot = slots[(index + probe) & (kSlots - 1)];
+    if (!slot.used) {
+      slot.pid = pid;
+      slot.used = true;
+      slot.counts = PerBucketAccessCounts{};
+      isNewPid = true;
+      return slot.counts;
+    }
+    if (slot.pid == pid) {
+      isNewPid = false;
+      return slot.counts;
     }
-    accessCountsByPid[pid].duration += otherAccessCounts.duration;
   }
+  auto [it, inserted] =
+      overflow.accessCountsByPid.emplace(pid, PerBucketAccessCounts{});
+  isNewPid = inserted;
+  return it->second;
+}
+
+void ProcessAccessLog::ThreadBucket::add(
+    pid_t pid,
+    bool& isNewPid,
+    AccessType type) {
+  find(pid, isNewPid)[type]++;
+}
+
+void ProcessAccessLog::ThreadBucket::add(
+    pid_t pid,
+    bool& isNewPid,
+    const RequestCost& cost) {
+  find(pid, isNewPid).add(cost);
 }
 
 ProcessAccessLog::ProcessAccessLog(
@@ -185,10 +254,8 @@ void ProcessAccessLog::recordAccess(
   }
 }
 
-void ProcessAccessLog::recordDuration(
-    pid_t pid,
-    std::chrono::nanoseconds duration) {
-  bool isNewPid = getTlb()->add(getSecondsSinceEpoch(), pid, duration);
+void ProcessAccessLog::recordCost(pid_t pid, const RequestCost& cost) {
+  bool isNewPid = getTlb()->add(getSecondsSinceEpoch(), pid, cost);
   if (pid != 0 && isNewPid) {
     processNameCache_->add(pid);
   }
@@ -237,6 +304,10 @@ std::unordered_map<pid_t, AccessCounts> ProcessAccessLog::getAccessCounts(
         accessCounts[AccessType::FsChannelBackingStoreImport];
     accessCountsByPid[pid].fsChannelDurationNs_ref() =
         accessCounts.duration.count();
+    accessCountsByPid[pid].fsChannelCpuTimeNs_ref() =
+        accessCounts.cpuTime.count();
+    accessCountsByPid[pid].fsChannelBackingStoreBytes_ref() =
+        accessCounts.backingStoreBytes;
   }
   return accessCountsByPid;
 }
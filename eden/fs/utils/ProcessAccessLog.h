@@ -8,6 +8,7 @@
 #pragma once
 
 #include <folly/Synchronized.h>
+#include <array>
 #include <type_traits>
 
 #include "eden/fs/service/gen-cpp2/eden_types.h"
@@ -41,6 +42,15 @@ class ProcessAccessLog {
     Last,
   };
 
+  /**
+   * What serving one filesystem request cost, see RequestContext.
+   */
+  struct RequestCost {
+    std::chrono::nanoseconds duration{0};
+    std::chrono::nanoseconds cpuTime{0};
+    uint64_t backingStoreBytes{0};
+  };
+
   explicit ProcessAccessLog(std::shared_ptr<ProcessNameCache> processNameCache);
   ~ProcessAccessLog();
 
@@ -53,7 +63,7 @@ class ProcessAccessLog {
    * ProcessNameCache.
    */
   void recordAccess(pid_t pid, AccessType type);
-  void recordDuration(pid_t pid, std::chrono::nanoseconds duration);
+  void recordCost(pid_t pid, const RequestCost& cost);
 
   /**
    * Returns the number of times each pid was passed to recordAccess() in
@@ -69,6 +79,8 @@ class ProcessAccessLog {
   struct PerBucketAccessCounts {
     size_t counts[enumValue(AccessType::Last)];
     std::chrono::nanoseconds duration;
+    std::chrono::nanoseconds cpuTime;
+    uint64_t backingStoreBytes;
 
     size_t& operator[](AccessType type) {
       static_assert(std::is_unsigned_v<std::underlying_type_t<AccessType>>);
@@ -76,22 +88,57 @@ class ProcessAccessLog {
       XCHECK_LT(idx, enumValue(AccessType::Last));
       return counts[idx];
     }
+
+    void add(const RequestCost& cost);
+    void merge(const PerBucketAccessCounts& other);
   };
 
+  struct ThreadBucket;
+
   // Data for one second.
   struct Bucket {
     void clear();
     void add(pid_t pid, bool& isNew, AccessType type);
-    void add(pid_t pid, bool& isNew, std::chrono::nanoseconds duration);
+    void add(pid_t pid, bool& isNew, const RequestCost& cost);
     void merge(const Bucket& other);
+    void merge(const ThreadBucket& other);
 
     std::unordered_map<pid_t, PerBucketAccessCounts> accessCountsByPid;
   };
 
+  /**
+   * The data for one second recorded by one thread, which rarely sees more
+   * than a handful of processes in a second. The first kSlots of them are
+   * kept in a fixed-size open-addressing table, so recording an access is a
+   * probe or two in memory the thread already owns rather than a hash map
+   * update that may allocate. Any further processes spill into overflow.
+   */
+  struct ThreadBucket {
+    static constexpr size_t kSlots = 8;
+    static_assert((kSlots & (kSlots - 1)) == 0, "kSlots must be a power of 2");
+
+    struct Slot {
+      pid_t pid;
+      bool used;
+      PerBucketAccessCounts counts;
+    };
+
+    void clear();
+    void add(pid_t pid, bool& isNew, AccessType type);
+    void add(pid_t pid, bool& isNew, const RequestCost& cost);
+
+    std::array<Slot, kSlots> slots{};
+    Bucket overflow;
+
+   private:
+    PerBucketAccessCounts& find(pid_t pid, bool& isNew);
+  };
+
   // Keep up to ten seconds of data, but use a power of two so BucketedLog
   // generates smaller, faster code.
   static constexpr uint64_t kBucketCount = 16;
   using Buckets = BucketedLog<Bucket, kBucketCount>;
+  using ThreadBuckets = BucketedLog<ThreadBucket, kBucketCount>;
 
   struct State {
     Buckets buckets;
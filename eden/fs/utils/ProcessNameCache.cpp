@@ -7,6 +7,7 @@
 
 #include "eden/fs/utils/ProcessNameCache.h"
 
+#include <algorithm>
 #include <optional>
 #include <vector>
 
@@ -218,8 +219,12 @@ std::string readPidName(pid_t pid) {
 namespace facebook {
 namespace eden {
 
-ProcessNameCache::ProcessNameCache(std::chrono::nanoseconds expiry)
-    : expiry_{expiry}, startPoint_{std::chrono::steady_clock::now()} {
+ProcessNameCache::ProcessNameCache(
+    std::chrono::nanoseconds expiry,
+    size_t maxProcesses)
+    : expiry_{expiry},
+      maxProcesses_{maxProcesses},
+      startPoint_{std::chrono::steady_clock::now()} {
   workerThread_ = std::thread{[this] {
     folly::setThreadName("ProcessNameCacheWorker");
     processActions();
@@ -301,6 +306,25 @@ std::map<pid_t, std::string> ProcessNameCache::getAllProcessNames() {
   return std::move(future).get();
 }
 
+const std::string* ProcessNameCache::internName(
+    State& state,
+    std::string name) {
+  auto [iter, inserted] = state.internedNames.try_emplace(std::move(name), 0);
+  ++iter->second;
+  return &iter->first;
+}
+
+void ProcessNameCache::eraseName(
+    State& state,
+    std::unordered_map<pid_t, ProcessName>::iterator iter) {
+  auto interned = state.internedNames.find(*iter->second.name);
+  XDCHECK(interned != state.internedNames.end());
+  if (--interned->second == 0) {
+    state.internedNames.erase(interned);
+  }
+  state.names.erase(iter);
+}
+
 void ProcessNameCache::clearExpired(
     std::chrono::steady_clock::duration now,
     State& state) {
@@ -311,12 +335,30 @@ void ProcessNameCache::clearExpired(
     auto next = std::next(iter);
     if (now - iter->second.lastAccess.load(std::memory_order_seq_cst) >=
         expiry_) {
-      state.names.erase(iter);
+      eraseName(state, iter);
     }
     iter = next;
   }
 }
 
+void ProcessNameCache::evictOldest(State& state) {
+  if (state.names.size() <= maxProcesses_) {
+    return;
+  }
+  // Make room for a while rather than evicting on every insertion.
+  auto keep = maxProcesses_ - maxProcesses_ / 4;
+  std::vector<std::pair<std::chrono::steady_clock::duration, pid_t>> byAccess;
+  byAccess.reserve(state.names.size());
+  for (const auto& [pid, name] : state.names) {
+    byAccess.emplace_back(name.lastAccess.load(std::memory_order_seq_cst), pid);
+  }
+  auto evictEnd = byAccess.end() - keep;
+  std::nth_element(byAccess.begin(), evictEnd, byAccess.end());
+  for (auto it = byAccess.begin(); it != evictEnd; ++it) {
+    eraseName(state, state.names.find(it->second));
+  }
+}
+
 void ProcessNameCache::processActions() {
   // Double-buffered work queues.
   folly::F14FastSet<pid_t> addQueue;
@@ -369,7 +411,10 @@ void ProcessNameCache::processActions() {
     if (!addedNames.empty()) {
       auto state = state_.wlock();
       for (auto& [pid, name] : addedNames) {
-        state->names.emplace(pid, ProcessName{std::move(name), now});
+        if (state->names.count(pid) == 0) {
+          state->names.emplace(
+              pid, ProcessName{internName(*state, std::move(name)), now});
+        }
       }
 
       // Bump the water level by two so that it's guaranteed to catch up.
@@ -382,6 +427,7 @@ void ProcessNameCache::processActions() {
         clearExpired(now, *state);
         state->waterLevel = 0;
       }
+      evictOldest(*state);
     }
 
     if (!getQueue.empty()) {
@@ -393,7 +439,7 @@ void ProcessNameCache::processActions() {
         auto state = state_.wlock();
         clearExpired(now, *state);
         for (const auto& [pid, name] : state->names) {
-          allProcessNames[pid] = name.name;
+          allProcessNames[pid] = *name.name;
         }
       }
 
@@ -407,7 +453,7 @@ void ProcessNameCache::processActions() {
 std::optional<std::string> ProcessNameCache::getProcessName(pid_t pid) {
   auto state = state_.rlock();
   if (auto* processName = folly::get_ptr(state->names, pid)) {
-    return processName->name;
+    return *processName->name;
   }
   return std::nullopt;
 }
@@ -415,10 +461,14 @@ std::optional<std::string> ProcessNameCache::getProcessName(pid_t pid) {
 std::optional<std::string> ProcessNameCache::getSpacedProcessName(pid_t pid) {
   auto state = state_.rlock();
   if (auto* processName = folly::get_ptr(state->names, pid)) {
-    return detail::getSpacedName(processName->name);
+    return detail::getSpacedName(*processName->name);
   }
   return std::nullopt;
 }
 
+size_t ProcessNameCache::getUniqueNameCount() {
+  return state_.rlock()->internedNames.size();
+}
+
 } // namespace eden
 } // namespace facebook
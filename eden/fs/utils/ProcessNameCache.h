@@ -8,6 +8,7 @@
 #pragma once
 
 #include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
 #include <folly/container/F14Set.h>
 #include <folly/futures/Promise.h>
 #include <folly/synchronization/LifoSem.h>
@@ -23,12 +24,20 @@ namespace eden {
 
 class ProcessNameCache {
  public:
+  /**
+   * Builds spawn many short-lived processes. Beyond this many, the processes
+   * referenced least recently are forgotten before they expire.
+   */
+  static constexpr size_t kDefaultMaxProcesses = 16 * 1024;
+
   /**
    * Create a cache that maintains process names until `expiry` has elapsed
-   * without them being referenced or observed.
+   * without them being referenced or observed, for at most `maxProcesses`
+   * processes at a time.
    */
   explicit ProcessNameCache(
-      std::chrono::nanoseconds expiry = std::chrono::minutes{5});
+      std::chrono::nanoseconds expiry = std::chrono::minutes{5},
+      size_t maxProcesses = kDefaultMaxProcesses);
 
   ~ProcessNameCache();
 
@@ -61,25 +70,36 @@ class ProcessNameCache {
    */
   std::optional<std::string> getSpacedProcessName(pid_t pid);
 
+  /**
+   * The number of distinct command lines held. Processes running the same
+   * command line, like the many invocations of a compiler during a build,
+   * share one copy of it.
+   */
+  size_t getUniqueNameCount();
+
  private:
   struct ProcessName {
-    ProcessName(std::string n, std::chrono::steady_clock::duration d)
-        : name{std::move(n)}, lastAccess{d} {}
+    ProcessName(const std::string* n, std::chrono::steady_clock::duration d)
+        : name{n}, lastAccess{d} {}
     ProcessName(ProcessName&& other) noexcept
-        : name{std::move(other.name)}, lastAccess{other.lastAccess.load()} {}
+        : name{other.name}, lastAccess{other.lastAccess.load()} {}
 
     ProcessName& operator=(ProcessName&& other) noexcept {
-      name = std::move(other.name);
+      name = other.name;
       lastAccess.store(other.lastAccess.load());
       return *this;
     }
 
-    std::string name;
+    // Points to a key of State::internedNames.
+    const std::string* name;
     mutable std::atomic<std::chrono::steady_clock::duration> lastAccess;
   };
 
   struct State {
     std::unordered_map<pid_t, ProcessName> names;
+    // Every distinct name in names, with the number of pids using it. A node
+    // map, so the keys don't move.
+    folly::F14NodeMap<std::string, size_t> internedNames;
 
     // Allows periodic flushing of the expired names without quadratic-time
     // insertion. waterLevel grows twice as fast as names.size() can, and when
@@ -91,10 +111,16 @@ class ProcessNameCache {
     std::vector<folly::Promise<std::map<pid_t, std::string>>> getQueue;
   };
 
+  static const std::string* internName(State& state, std::string name);
+  static void eraseName(
+      State& state,
+      std::unordered_map<pid_t, ProcessName>::iterator iter);
   void clearExpired(std::chrono::steady_clock::duration now, State& state);
+  void evictOldest(State& state);
   void processActions();
 
   const std::chrono::nanoseconds expiry_;
+  const size_t maxProcesses_;
   const std::chrono::steady_clock::time_point startPoint_;
   folly::Synchronized<State> state_;
   folly::LifoSem sem_;
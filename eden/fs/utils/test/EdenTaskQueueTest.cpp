@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/EdenTaskQueue.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+folly::CPUThreadPoolExecutor::CPUTask makeTask(std::vector<int>& ran, int n) {
+  return folly::CPUThreadPoolExecutor::CPUTask{
+      [&ran, n] { ran.push_back(n); }, 0ms, nullptr, 0};
+}
+} // namespace
+
+TEST(EdenTaskQueue, singlePriority) {
+  EdenTaskQueue queue{10};
+  EXPECT_EQ(1, queue.getNumPriorities());
+
+  std::vector<int> ran;
+  queue.add(makeTask(ran, 1));
+  queue.addWithPriority(makeTask(ran, 2), folly::Executor::LO_PRI);
+  EXPECT_EQ(2, queue.size());
+
+  queue.take().func_();
+  queue.take().func_();
+  EXPECT_EQ((std::vector<int>{1, 2}), ran);
+  EXPECT_FALSE(queue.try_take_for(0ms).has_value());
+}
+
+TEST(EdenTaskQueue, higherPrioritiesAreTakenFirst) {
+  EdenTaskQueue queue{10, 2};
+  EXPECT_EQ(2, queue.getNumPriorities());
+
+  std::vector<int> ran;
+  queue.addWithPriority(makeTask(ran, 1), folly::Executor::LO_PRI);
+  queue.addWithPriority(makeTask(ran, 2), folly::Executor::LO_PRI);
+  queue.add(makeTask(ran, 3));
+  queue.addWithPriority(makeTask(ran, 4), folly::Executor::HI_PRI);
+  EXPECT_EQ(2, queue.sizeOfPriority(folly::Executor::LO_PRI));
+  EXPECT_EQ(2, queue.sizeOfPriority(folly::Executor::MID_PRI));
+  EXPECT_EQ(4, queue.size());
+
+  for (int i = 0; i < 4; i++) {
+    queue.take().func_();
+  }
+  EXPECT_EQ((std::vector<int>{3, 4, 1, 2}), ran);
+}
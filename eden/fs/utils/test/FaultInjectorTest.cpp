@@ -151,3 +151,41 @@ TEST(FaultInjector, noop) {
   fi.check("mount", "/a/b/c");
   EXPECT_THROW_RE(fi.check("mount", "/test/test"), std::runtime_error, "fail");
 }
+
+TEST(FaultInjector, latency) {
+  FaultInjector fi(true);
+  FaultInjector::LatencyProfile constant;
+  constant.latency = 20ms;
+  fi.injectLatency("fetch", ".*", constant, 2);
+
+  folly::stop_watch<> sw;
+  fi.check("fetch", "/test");
+  EXPECT_GE(sw.elapsed(), 20ms);
+
+  sw.reset();
+  fi.checkImmediate("fetch", "/test").get();
+  EXPECT_GE(sw.elapsed(), 20ms);
+
+  // The fault expired, so checks are immediate again.
+  EXPECT_TRUE(fi.checkImmediate("fetch", "/test").isReady());
+
+  FaultInjector::LatencyProfile spikes;
+  spikes.distribution = FaultInjector::LatencyProfile::Distribution::TailSpikes;
+  spikes.latency = 1ms;
+  spikes.spike = 100ms;
+  spikes.spikeProbability = 0.0;
+  EXPECT_EQ(1ms, spikes.sample());
+  spikes.spikeProbability = 1.0;
+  EXPECT_EQ(100ms, spikes.sample());
+
+  FaultInjector::LatencyProfile logNormal;
+  logNormal.distribution =
+      FaultInjector::LatencyProfile::Distribution::LogNormal;
+  logNormal.latency = 1ms;
+  logNormal.sigma = 0.0;
+  EXPECT_EQ(1ms, logNormal.sample());
+  logNormal.sigma = 1.0;
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_GE(logNormal.sample().count(), 0);
+  }
+}
@@ -258,6 +258,34 @@ TEST(ImmediateFuture, ready_ImmediateFuture_thenValue_is_also_ready) {
   EXPECT_TRUE(then.isReady());
 }
 
+TEST(ImmediateFuture, thenValue_on_completed_SemiFuture_runs_immediately) {
+  auto [promise, semi] = folly::makePromiseContract<int>();
+  auto imm = ImmediateFuture<int>{std::move(semi)};
+  promise.setValue(10);
+
+  bool run = false;
+  auto then = std::move(imm).thenValue([&](int i) {
+    run = true;
+    return i + 1;
+  });
+  EXPECT_TRUE(run);
+  EXPECT_TRUE(then.isReady());
+  EXPECT_EQ(11, std::move(then).get());
+}
+
+TEST(ImmediateFuture, thenValue_returning_ImmediateFuture_on_pending_semi) {
+  auto [promise, semi] = folly::makePromiseContract<int>();
+  auto imm = ImmediateFuture<int>{std::move(semi)};
+  auto then = std::move(imm).thenValue(
+      [](int i) -> ImmediateFuture<int> { return i + 1; });
+  auto thenSemi = std::move(then).thenValue([](int i) -> ImmediateFuture<int> {
+    return folly::makeSemiFuture(i + 1);
+  });
+  EXPECT_FALSE(thenSemi.isReady());
+  promise.setValue(10);
+  EXPECT_EQ(12, std::move(thenSemi).get());
+}
+
 TEST(
     ImmediateFuture,
     ImmediateFuture_does_not_run_SemiFuture_callbacks_until_scheduled_on_executor) {
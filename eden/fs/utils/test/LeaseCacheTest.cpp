@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/LeaseCache.h"
+#include <folly/portability/GTest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+
+using Cache = LeaseCache<int, std::string>;
+
+/** A fetcher whose loads only complete when the test fulfills them. */
+struct ManualFetcher {
+  std::vector<std::pair<int, folly::Promise<Cache::ValuePtr>>> pending;
+
+  Cache::FetchFunc func() {
+    return [this](const int& key) {
+      pending.emplace_back(key, folly::Promise<Cache::ValuePtr>{});
+      return pending.back().second.getFuture();
+    };
+  }
+};
+
+Cache::FetchFunc immediateFetcher(int& fetches) {
+  return [&fetches](const int& key) {
+    ++fetches;
+    return folly::makeFuture(
+        std::make_shared<std::string>(std::to_string(key)));
+  };
+}
+
+} // namespace
+
+TEST(LeaseCache, concurrent_gets_share_one_fetch) {
+  ManualFetcher fetcher;
+  Cache cache{10, fetcher.func()};
+
+  auto first = cache.get(1);
+  auto second = cache.get(1);
+  ASSERT_EQ(1, fetcher.pending.size());
+  EXPECT_FALSE(first.isReady());
+
+  fetcher.pending[0].second.setValue(std::make_shared<std::string>("one"));
+  EXPECT_EQ("one", *std::move(first).get());
+  EXPECT_EQ("one", *std::move(second).get());
+  EXPECT_EQ("one", *cache.get(1).get());
+
+  auto stats = cache.getStats();
+  EXPECT_EQ(1, stats.misses);
+  EXPECT_EQ(1, stats.coalesced);
+  EXPECT_EQ(1, stats.hits);
+}
+
+TEST(LeaseCache, failed_fetches_are_retried) {
+  ManualFetcher fetcher;
+  Cache cache{10, fetcher.func()};
+
+  auto failed = cache.get(1);
+  fetcher.pending[0].second.setException(std::runtime_error("oops"));
+  EXPECT_THROW(std::move(failed).get(), std::runtime_error);
+  EXPECT_FALSE(cache.exists(1));
+
+  auto retried = cache.get(1);
+  ASSERT_EQ(2, fetcher.pending.size());
+  fetcher.pending[1].second.setValue(std::make_shared<std::string>("one"));
+  EXPECT_EQ("one", *std::move(retried).get());
+  EXPECT_TRUE(cache.exists(1));
+}
+
+TEST(LeaseCache, least_recently_used_entries_are_evicted) {
+  int fetches = 0;
+  Cache cache{2, immediateFetcher(fetches)};
+
+  cache.get(1).get();
+  cache.get(2).get();
+  cache.get(1).get();
+  cache.get(3).get();
+  EXPECT_EQ(3, fetches);
+  EXPECT_TRUE(cache.exists(1));
+  EXPECT_FALSE(cache.exists(2));
+  EXPECT_TRUE(cache.exists(3));
+
+  cache.set(4, std::make_shared<std::string>("four"));
+  EXPECT_EQ("four", *cache.get(4).get());
+  cache.erase(4);
+  EXPECT_FALSE(cache.exists(4));
+}
+
+TEST(LeaseCache, expired_entries_are_fetched_again) {
+  int fetches = 0;
+  Cache cache{10, immediateFetcher(fetches), 1, 1ms};
+
+  cache.get(1).get();
+  std::this_thread::sleep_for(10ms);
+  EXPECT_FALSE(cache.exists(1));
+  EXPECT_EQ("1", *cache.get(1).get());
+  EXPECT_EQ(2, fetches);
+
+  Cache longLived{10, immediateFetcher(fetches), 1, 1h};
+  longLived.get(1).get();
+  longLived.get(1).get();
+  EXPECT_EQ(3, fetches);
+}
+
+TEST(LeaseCache, sharded_cache_keeps_every_key) {
+  int fetches = 0;
+  Cache cache{64, immediateFetcher(fetches), 1, 0ms, 4};
+
+  for (int key = 0; key < 8; ++key) {
+    EXPECT_EQ(std::to_string(key), *cache.get(key).get());
+  }
+  for (int key = 0; key < 8; ++key) {
+    EXPECT_TRUE(cache.exists(key));
+  }
+  EXPECT_EQ(8, fetches);
+  EXPECT_EQ(8, cache.getStats().misses);
+}
+
+TEST(LeaseCache, fetch_may_outlive_the_cache) {
+  ManualFetcher fetcher;
+  auto future = Cache::FutureType::makeEmpty();
+  {
+    Cache cache{10, fetcher.func()};
+    future = cache.get(1);
+  }
+  fetcher.pending[0].second.setValue(std::make_shared<std::string>("one"));
+  EXPECT_EQ("one", *std::move(future).get());
+}
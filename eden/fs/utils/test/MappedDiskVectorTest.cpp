@@ -66,6 +66,44 @@ TEST_F(MappedDiskVectorTest, grows_file) {
   EXPECT_GT(new_size, old_size);
 }
 
+TEST_F(MappedDiskVectorTest, large_files_grow_proportionally) {
+  auto mdv = MappedDiskVector<U64>::open(mdvPath);
+
+  // Fill well past the initial capacity so growth is no longer the minimum.
+  for (uint64_t i = 0; i < 1000000; ++i) {
+    mdv.emplace_back(i);
+  }
+  while (mdv.size() < mdv.capacity()) {
+    mdv.emplace_back(0ull);
+  }
+  auto capacity = mdv.capacity();
+  mdv.emplace_back(0ull);
+  EXPECT_GE(mdv.capacity(), capacity + capacity / 2 - 4096);
+}
+
+TEST_F(MappedDiskVectorTest, huge_pages_advice_is_kept_when_growing) {
+  auto mdv = MappedDiskVector<U64>::open(mdvPath);
+  EXPECT_EQ(0, mdv.getHugePageAdviceCount());
+  mdv.adviseHugePages();
+  EXPECT_EQ(1, mdv.getHugePageAdviceCount());
+
+  // Growing remaps the file, and the new mapping is advised again.
+  auto capacity = mdv.capacity();
+  while (mdv.size() <= capacity) {
+    mdv.emplace_back(static_cast<uint64_t>(mdv.size()));
+  }
+  EXPECT_EQ(2, mdv.getHugePageAdviceCount());
+
+  constexpr uint64_t N = 1000000;
+  for (uint64_t i = mdv.size(); i < N; ++i) {
+    mdv.emplace_back(i);
+  }
+  ASSERT_EQ(N, mdv.size());
+  for (uint64_t i = 0; i < N; ++i) {
+    EXPECT_EQ(i, mdv[i]);
+  }
+}
+
 TEST_F(MappedDiskVectorTest, remembers_contents_on_reopen) {
   {
     auto mdv = MappedDiskVector<U64>::open(mdvPath);
@@ -46,3 +46,36 @@ TEST(Memory, FBStringMemoryUsage) {
   }
 }
 #endif
+
+TEST(Memory, parsePressureStallPercent) {
+  EXPECT_EQ(
+      12.5,
+      parsePressureStallPercent(
+          "some avg10=12.50 avg60=3.00 avg300=1.00 total=1234\n"
+          "full avg10=2.00 avg60=1.00 avg300=0.50 total=567\n"));
+  EXPECT_EQ(
+      0.0,
+      parsePressureStallPercent(
+          "some avg10=0.00 avg60=0.00 avg300=0.00 total=0\n"));
+  EXPECT_EQ(std::nullopt, parsePressureStallPercent(""));
+  EXPECT_EQ(
+      std::nullopt,
+      parsePressureStallPercent(
+          "full avg10=2.00 avg60=1.00 avg300=0.50 total=567\n"));
+}
+
+TEST(Memory, parseCgroup2Path) {
+  EXPECT_EQ(
+      "/user.slice/edenfs.service",
+      parseCgroup2Path("0::/user.slice/edenfs.service\n"));
+  EXPECT_EQ(
+      "/system.slice",
+      parseCgroup2Path("12:memory:/legacy\n0::/system.slice\n"));
+  EXPECT_EQ(std::nullopt, parseCgroup2Path("4:memory:/legacy\n"));
+}
+
+TEST(Memory, parseCgroupUsageRatio) {
+  EXPECT_EQ(0.5, parseCgroupUsageRatio("512\n", "1024\n"));
+  EXPECT_EQ(std::nullopt, parseCgroupUsageRatio("512\n", "max\n"));
+  EXPECT_EQ(std::nullopt, parseCgroupUsageRatio("", "1024\n"));
+}
@@ -106,6 +106,45 @@ TEST(PathMap, caseInSensitiveCopyMove) {
   EXPECT_TRUE(move_assign.at("Foo"_pc));
 }
 
+TEST(PathMap, caseInSensitiveIndexFollowsInsertAndErase) {
+  PathMap<int> map(CaseSensitivity::Insensitive);
+  std::vector<std::string> names{
+      "Zeta", "alpha", "Beta", "_under", "gamma", "DELTA", "beta2", "[x]"};
+  for (size_t i = 0; i < names.size(); ++i) {
+    EXPECT_TRUE(map.emplace(PathComponentPiece{names[i]}, i).second);
+  }
+  EXPECT_FALSE(map.emplace("ALPHA"_pc, 100).second);
+  EXPECT_FALSE(map.insert(std::make_pair(PathComponent("zeta"), 100)).second);
+  EXPECT_EQ(names.size(), map.size());
+
+  // "[x]" and "_under" sort between the upper and lower case letters.
+  EXPECT_EQ(7, map.at("[X]"_pc));
+  EXPECT_EQ(3, map.at("_UNDER"_pc));
+  EXPECT_EQ(map.find("bet"_pc), map.end());
+  EXPECT_EQ(map.find("beta22"_pc), map.end());
+
+  EXPECT_EQ(1, map.erase("bEtA"_pc));
+  // Erases "DELTA" and "Zeta".
+  map.erase(map.find("delta"_pc), map.find("[X]"_pc));
+  EXPECT_EQ(map.find("beta"_pc), map.end());
+  for (size_t i = 0; i < names.size(); ++i) {
+    std::string upper = names[i];
+    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+    auto iter = map.find(PathComponentPiece{upper});
+    if (names[i] == "Beta" || names[i] == "DELTA" || names[i] == "Zeta") {
+      EXPECT_EQ(iter, map.end()) << names[i];
+    } else {
+      ASSERT_NE(iter, map.end()) << names[i];
+      EXPECT_EQ(i, iter->second);
+    }
+  }
+
+  map.clear();
+  EXPECT_EQ(map.find("alpha"_pc), map.end());
+  map["ALPHA"_pc] = 1;
+  EXPECT_EQ(1, map.at("alpha"_pc));
+}
+
 TEST(PathMap, insert) {
   PathMap<bool> map(kPathMapDefaultCaseSensitive);
 
@@ -240,3 +279,20 @@ TEST(PathMap, swap) {
   EXPECT_EQ(0, b.size()) << "b now has 0 elements";
   EXPECT_EQ("foo", a.at("foo"_pc));
 }
+
+TEST(PathMap, caseInsensitiveAppendAndInsert) {
+  PathMap<int> map(CaseSensitivity::Insensitive);
+  map.reserve(4);
+
+  // Appended in sorted order, then one inserted before all of them.
+  map.emplace("Bar"_pc, 1);
+  map.emplace("baz"_pc, 2);
+  map.emplace("foo"_pc, 3);
+  map.emplace("Aaa"_pc, 0);
+
+  EXPECT_EQ(4, map.size());
+  EXPECT_EQ(0, map.at("aaa"_pc));
+  EXPECT_EQ(1, map.at("bar"_pc));
+  EXPECT_EQ(2, map.at("BAZ"_pc));
+  EXPECT_EQ(3, map.at("Foo"_pc));
+}
@@ -44,6 +44,39 @@ TEST(ProcessAccessLog, accessIncrementsAccessCount) {
   EXPECT_THAT(log.getAccessCounts(10s), Contains(std::pair{pid, ac}));
 }
 
+TEST(ProcessAccessLog, manyProcessesInOneSecondAreAllCounted) {
+  auto log = ProcessAccessLog{std::make_shared<ProcessNameCache>()};
+
+  // More processes than fit in a thread's compact table.
+  constexpr pid_t kProcessCount = 100;
+  for (int round = 0; round < 3; ++round) {
+    for (pid_t pid = 1; pid <= kProcessCount; ++pid) {
+      log.recordAccess(pid, ProcessAccessLog::AccessType::FsChannelRead);
+    }
+  }
+
+  auto counts = log.getAccessCounts(10s);
+  ASSERT_EQ(kProcessCount, counts.size());
+  for (pid_t pid = 1; pid <= kProcessCount; ++pid) {
+    EXPECT_EQ(3, *counts[pid].fsChannelReads_ref()) << "pid " << pid;
+  }
+}
+
+TEST(ProcessAccessLog, costsAreSummedPerProcess) {
+  auto pid = pid_t{42};
+  auto log = ProcessAccessLog{std::make_shared<ProcessNameCache>()};
+
+  log.recordCost(pid, {10ms, 2ms, 100});
+  log.recordCost(pid, {5ms, 1ms, 50});
+
+  auto ac = AccessCounts{};
+  ac.fsChannelDurationNs_ref() = std::chrono::nanoseconds{15ms}.count();
+  ac.fsChannelCpuTimeNs_ref() = std::chrono::nanoseconds{3ms}.count();
+  ac.fsChannelBackingStoreBytes_ref() = 150;
+
+  EXPECT_THAT(log.getAccessCounts(10s), Contains(std::pair{pid, ac}));
+}
+
 TEST(ProcessAccessLog, accessAddsProcessToProcessNameCache) {
   auto pid = pid_t{1};
   auto processNameCache = std::make_shared<ProcessNameCache>();
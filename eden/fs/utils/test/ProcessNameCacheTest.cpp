@@ -52,3 +52,33 @@ TEST(ProcessNameCache, addFromMultipleThreads) {
   }
   EXPECT_EQ(1, results.size());
 }
+
+namespace {
+// Far above any pid_max, so these pids never exist.
+constexpr pid_t kMissingPid = 1 << 30;
+} // namespace
+
+TEST(ProcessNameCache, identicalNamesAreStoredOnce) {
+  ProcessNameCache processNameCache;
+  for (pid_t i = 0; i < 10; ++i) {
+    processNameCache.add(kMissingPid + i);
+  }
+  auto results = processNameCache.getAllProcessNames();
+  ASSERT_EQ(10, results.size());
+  // They all failed to be read with the same error.
+  EXPECT_EQ(results[kMissingPid], results[kMissingPid + 9]);
+  EXPECT_EQ(1, processNameCache.getUniqueNameCount());
+}
+
+TEST(ProcessNameCache, processCountIsBounded) {
+  ProcessNameCache processNameCache{5min, 8};
+  for (pid_t i = 0; i < 100; ++i) {
+    processNameCache.add(kMissingPid + i);
+    // Wait for each batch, so that it is evicted as it would be over time.
+    (void)processNameCache.getAllProcessNames();
+  }
+  EXPECT_LE(processNameCache.getAllProcessNames().size(), 8);
+
+  // The most recently added process is kept.
+  EXPECT_TRUE(processNameCache.getProcessName(kMissingPid + 99));
+}
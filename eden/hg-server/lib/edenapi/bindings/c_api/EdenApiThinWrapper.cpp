@@ -7,6 +7,85 @@
 
 #include "eden/hg-server/lib/edenapi/bindings/c_api/EdenApiThinWrapper.h"
 
+#include <folly/ScopeGuard.h>
+#include <folly/io/IOBuf.h>
+#include <exception>
+#include <stdexcept>
+#include <string>
+
 namespace facebook {
-namespace eden {}
+namespace eden {
+
+namespace {
+
+struct FilesStream {
+  folly::FunctionRef<void(const RustApiKey&, std::unique_ptr<folly::IOBuf>)>
+      onFile;
+  std::exception_ptr error;
+};
+
+void freeFileContent(void* /* buf */, void* userData) noexcept {
+  rust_filecontent_free(static_cast<RustFileContent*>(userData));
+}
+
+void resolveFile(void* data, RustFileContent* file) noexcept {
+  auto* stream = static_cast<FilesStream*>(data);
+  const auto* key = rust_filecontent_get_key(file);
+  try {
+    // Frees the file if it throws.
+    auto content = folly::IOBuf::takeOwnership(
+        const_cast<uint8_t*>(rust_filecontent_get_data(file)),
+        rust_filecontent_get_len(file),
+        freeFileContent,
+        file);
+    // Rust can't be told to stop, so the files left are dropped.
+    if (!stream->error) {
+      stream->onFile(*key, std::move(content));
+    }
+  } catch (...) {
+    stream->error = std::current_exception();
+  }
+}
+
+std::string takeString(RustOwnedString string) {
+  SCOPE_EXIT {
+    rust_ownedstring_free(string);
+  };
+  return std::string{
+      reinterpret_cast<const char*>(rust_ownedstring_ptr(&string)),
+      rust_ownedstring_len(&string)};
+}
+
+} // namespace
+
+void edenApiFilesStream(
+    RustClient* client,
+    folly::StringPiece repo,
+    const std::vector<RustKey>& keys,
+    folly::FunctionRef<void(
+        const RustApiKey& key,
+        std::unique_ptr<folly::IOBuf> content)> onFile) {
+  FilesStream stream{onFile, nullptr};
+  auto result = rust_edenapi_files_stream(
+      client,
+      reinterpret_cast<const uint8_t*>(repo.data()),
+      repo.size(),
+      keys.data(),
+      keys.size(),
+      &stream,
+      resolveFile);
+  SCOPE_EXIT {
+    rust_filestream_free(result);
+  };
+
+  if (stream.error) {
+    std::rethrow_exception(stream.error);
+  }
+  if (rust_result_filestream_is_err(result.ptr)) {
+    throw std::runtime_error(
+        takeString(rust_result_filestream_err_display(result.ptr)));
+  }
+}
+
+} // namespace eden
 } // namespace facebook
@@ -7,8 +7,10 @@
 
 #pragma once
 
+#include <folly/Function.h>
 #include <folly/Range.h>
 #include <memory>
+#include <vector>
 
 #include "eden/hg-server/lib/edenapi/bindings/c_api/RustEdenApi.h"
 
@@ -27,5 +29,22 @@ class TreeEntryFetch {};
 
 class TreeChildRef {};
 
+/**
+ * Fetches files from EdenAPI, calling onFile with each of them, in no
+ * particular order, as soon as its response arrives. The IOBuf wraps the
+ * buffer Rust decoded the response into instead of a copy of it, and the key
+ * lives as long as the IOBuf. Files unknown to the server are skipped.
+ *
+ * Throws std::runtime_error when the fetch fails, once the files received
+ * before the failure were passed to onFile.
+ */
+void edenApiFilesStream(
+    RustClient* client,
+    folly::StringPiece repo,
+    const std::vector<RustKey>& keys,
+    folly::FunctionRef<void(
+        const RustApiKey& key,
+        std::unique_ptr<folly::IOBuf> content)> onFile);
+
 } // namespace eden
 } // namespace facebook
@@ -47,6 +47,11 @@ enum class RustFileType {
   Symlink,
 };
 
+/// The content of a file, handed over to C++ by `rust_edenapi_files_stream`.
+/// Its data is the buffer the response was decoded into, so C++ can use it in
+/// place until the file is freed.
+struct RustFileContent;
+
 template<typename T = void, typename E = void>
 struct RustResult;
 
@@ -63,6 +68,10 @@ struct RustTreeEntryFetch {
   RustResult<RustVec<RustResult<RustTreeEntry, RustEdenApiServerError>>, RustError> *ptr;
 };
 
+struct RustFileStream {
+  RustResult<void, RustError> *ptr;
+};
+
 struct RustKey {
   const uint8_t *path;
   size_t path_len;
@@ -131,6 +140,20 @@ RustTreeEntryFetch rust_edenapi_trees_blocking(RustClient *client,
                                                size_t keys_len,
                                                RustTreeAttributes attrs);
 
+/// Fetch files, calling `resolve` with each of them, in no particular order,
+/// as soon as its response arrives rather than once all have. The callee owns
+/// the `FileContent` it's given and frees it with `rust_filecontent_free`.
+///
+/// Files that aren't found on the server are never resolved. An error stops
+/// the stream, and is the returned result.
+RustFileStream rust_edenapi_files_stream(RustClient *client,
+                                         const uint8_t *repo,
+                                         size_t repo_len,
+                                         const RustKey *keys,
+                                         size_t keys_len,
+                                         void *data,
+                                         void (*resolve)(void*, RustFileContent*));
+
 /// Methods for ApiKey
 RustHgId rust_key_get_hgid(const RustApiKey *k);
 
@@ -194,10 +217,20 @@ RustSha1 rust_filemetadata_get_content_sha1(const RustFileMetadata *m);
 
 RustSha256 rust_filemetadata_get_content_sha256(const RustFileMetadata *m);
 
+const RustApiKey *rust_filecontent_get_key(const RustFileContent *f);
+
+const uint8_t *rust_filecontent_get_data(const RustFileContent *f);
+
+size_t rust_filecontent_get_len(const RustFileContent *f);
+
+void rust_filecontent_free(RustFileContent *f);
+
 void rust_edenapiclient_free(RustEdenApiClient v);
 
 void rust_treeentryfetch_free(RustTreeEntryFetch v);
 
+void rust_filestream_free(RustFileStream v);
+
 uintptr_t rust_ownedstring_len(const RustOwnedString *s);
 
 const uint8_t *rust_ownedstring_ptr(const RustOwnedString *s);
@@ -236,6 +269,12 @@ RustOwnedString rust_result_treechildentry_err_display(const RustResult<RustTree
 
 RustOwnedString rust_result_treechildentry_err_debug(const RustResult<RustTreeChildEntry, RustEdenApiServerError> *r);
 
+bool rust_result_filestream_is_err(const RustResult<void, RustError> *r);
+
+RustOwnedString rust_result_filestream_err_display(const RustResult<void, RustError> *r);
+
+RustOwnedString rust_result_filestream_err_debug(const RustResult<void, RustError> *r);
+
 size_t rust_vec_treeentry_len(const RustVec<RustResult<RustTreeEntry, RustEdenApiServerError>> *v);
 
 const RustResult<RustTreeEntry, RustEdenApiServerError> *rust_vec_treeentry_get(const RustVec<RustResult<RustTreeEntry, RustEdenApiServerError>> *v,
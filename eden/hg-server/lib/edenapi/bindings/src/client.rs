@@ -8,13 +8,17 @@
 use std::path::PathBuf;
 
 use anyhow::Error;
-use libc::size_t;
+use async_runtime::{block_on_exclusive as block_on_future, stream_to_iter};
+use libc::{c_void, size_t};
 
-use edenapi::{Builder, Client, EdenApiBlocking};
+use edenapi::{Builder, Client, EdenApi, EdenApiBlocking};
 use edenapi_types::{EdenApiServerError, TreeEntry};
 use types::Key as ApiKey;
 
-use crate::{ptr_len_to_slice, types::TreeAttributes, EdenApiClient, Key, TreeEntryFetch};
+use crate::{
+    ptr_len_to_slice, types::TreeAttributes, EdenApiClient, FileContent, FileStream, Key,
+    TreeEntryFetch,
+};
 
 fn edenapi_client_new(repository: *const u8, repository_len: size_t) -> Result<Client, Error> {
     let repository = unsafe { ptr_len_to_slice(repository, repository_len) }?;
@@ -70,3 +74,53 @@ pub extern "C" fn rust_edenapi_trees_blocking(
 ) -> TreeEntryFetch {
     edenapi_trees_blocking(client, repo, repo_len, keys, keys_len, attrs).into()
 }
+
+fn edenapi_files_stream(
+    client: *mut Client,
+    repo: *const u8,
+    repo_len: size_t,
+    keys: *const Key,
+    keys_len: size_t,
+    data: *mut c_void,
+    resolve: unsafe extern "C" fn(*mut c_void, *mut FileContent),
+) -> Result<(), Error> {
+    assert!(!client.is_null());
+    let client: &Client = unsafe { &*client };
+    let repo = unsafe { ptr_len_to_slice(repo, repo_len) }?;
+    let repo: &str = std::str::from_utf8(repo)?;
+    let keys: &[Key] = unsafe { std::slice::from_raw_parts(keys, keys_len) };
+    let repo = repo.to_string();
+    let keys: Vec<ApiKey> = keys
+        .iter()
+        .map(|k| k.try_into())
+        .collect::<Result<Vec<ApiKey>, _>>()?;
+
+    let fetch = block_on_future(client.files(repo, keys, None))?;
+    for entry in stream_to_iter(fetch.entries) {
+        let entry = entry?;
+        // Like Mercurial, accept the content of redacted files and LFS pointers.
+        let content = entry.data()?;
+        let file = Box::new(FileContent::new(entry.key, content));
+        unsafe { resolve(data, Box::into_raw(file)) };
+    }
+    Ok(())
+}
+
+/// Fetch files, calling `resolve` with each of them, in no particular order,
+/// as soon as its response arrives rather than once all have. The callee owns
+/// the `FileContent` it's given and frees it with `rust_filecontent_free`.
+///
+/// Files that aren't found on the server are never resolved. An error stops
+/// the stream, and is the returned result.
+#[no_mangle]
+pub extern "C" fn rust_edenapi_files_stream(
+    client: *mut Client,
+    repo: *const u8,
+    repo_len: size_t,
+    keys: *const Key,
+    keys_len: size_t,
+    data: *mut c_void,
+    resolve: unsafe extern "C" fn(*mut c_void, *mut FileContent),
+) -> FileStream {
+    edenapi_files_stream(client, repo, repo_len, keys, keys_len, data, resolve).into()
+}
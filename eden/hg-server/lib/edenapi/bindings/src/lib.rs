@@ -14,8 +14,11 @@ pub mod types;
 pub mod vecutil;
 
 pub use crate::{
-    opaque::{ApiKey, EdenApiError, EdenApiServerError, FileMetadata, TreeChildEntry, TreeEntry},
-    owned::{EdenApiClient, OwnedString, TreeEntryFetch},
+    opaque::{
+        ApiKey, EdenApiError, EdenApiServerError, FileContent, FileMetadata, TreeChildEntry,
+        TreeEntry,
+    },
+    owned::{EdenApiClient, FileStream, OwnedString, TreeEntryFetch},
     types::{ContentId, FileType, HgId, Key, Parents, Sha1, Sha256},
 };
 
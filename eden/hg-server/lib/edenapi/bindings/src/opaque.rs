@@ -11,6 +11,7 @@
 
 use std::ptr;
 
+use bytes::Bytes;
 use libc::size_t;
 
 use crate::{ContentId, FileType, HgId, Parents, Sha1, Sha256};
@@ -21,6 +22,20 @@ pub use edenapi::EdenApiError;
 pub use edenapi_types::{EdenApiServerError, FileMetadata, TreeChildEntry, TreeEntry};
 pub use types::Key as ApiKey;
 
+/// The content of a file, handed over to C++ by `rust_edenapi_files_stream`.
+/// Its data is the buffer the response was decoded into, so C++ can use it in
+/// place until the file is freed.
+pub struct FileContent {
+    key: ApiKey,
+    data: Bytes,
+}
+
+impl FileContent {
+    pub(crate) fn new(key: ApiKey, data: Bytes) -> Self {
+        Self { key, data }
+    }
+}
+
 /// Methods for ApiKey
 #[no_mangle]
 pub extern "C" fn rust_key_get_hgid(k: *const ApiKey) -> HgId {
@@ -268,3 +283,30 @@ pub extern "C" fn rust_filemetadata_get_content_sha256(m: *const FileMetadata) -
     let m = unsafe { &*m };
     m.content_sha256.unwrap().into()
 }
+
+#[no_mangle]
+pub extern "C" fn rust_filecontent_get_key(f: *const FileContent) -> *const ApiKey {
+    assert!(!f.is_null());
+    let f = unsafe { &*f };
+    &f.key
+}
+
+#[no_mangle]
+pub extern "C" fn rust_filecontent_get_data(f: *const FileContent) -> *const u8 {
+    assert!(!f.is_null());
+    let f = unsafe { &*f };
+    f.data.as_ptr()
+}
+
+#[no_mangle]
+pub extern "C" fn rust_filecontent_get_len(f: *const FileContent) -> size_t {
+    assert!(!f.is_null());
+    let f = unsafe { &*f };
+    f.data.len()
+}
+
+#[no_mangle]
+pub extern "C" fn rust_filecontent_free(f: *mut FileContent) {
+    assert!(!f.is_null());
+    drop(unsafe { Box::from_raw(f) });
+}
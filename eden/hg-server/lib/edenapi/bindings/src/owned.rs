@@ -66,6 +66,32 @@ pub extern "C" fn rust_treeentryfetch_free(v: TreeEntryFetch) {
     drop(v);
 }
 
+#[repr(C)]
+pub struct FileStream {
+    ptr: *mut Result<(), Error>,
+}
+
+impl From<Result<(), Error>> for FileStream {
+    fn from(v: Result<(), Error>) -> Self {
+        let boxed = Box::new(v);
+        Self {
+            ptr: Box::into_raw(boxed),
+        }
+    }
+}
+
+impl Drop for FileStream {
+    fn drop(&mut self) {
+        let boxed = unsafe { Box::from_raw(self.ptr) };
+        drop(boxed);
+    }
+}
+
+#[no_mangle]
+pub extern "C" fn rust_filestream_free(v: FileStream) {
+    drop(v);
+}
+
 /// A wrapper type for a Box<String>. When into_raw_parts is stabilized, the Box / extra allocation
 /// can be removed.
 #[repr(C)]
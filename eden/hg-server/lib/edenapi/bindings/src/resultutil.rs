@@ -167,3 +167,25 @@ pub extern "C" fn rust_result_treechildentry_err_debug(
     let r = unsafe { &*r };
     r.unwrap_err_debug().into()
 }
+
+// Monomorphization for Result<(), Error>
+#[no_mangle]
+pub extern "C" fn rust_result_filestream_is_err(r: *const Result<(), Error>) -> bool {
+    assert!(!r.is_null());
+    let r = unsafe { &*r };
+    r.is_err()
+}
+
+#[no_mangle]
+pub extern "C" fn rust_result_filestream_err_display(r: *const Result<(), Error>) -> OwnedString {
+    assert!(!r.is_null());
+    let r = unsafe { &*r };
+    r.unwrap_err_display().into()
+}
+
+#[no_mangle]
+pub extern "C" fn rust_result_filestream_err_debug(r: *const Result<(), Error>) -> OwnedString {
+    assert!(!r.is_null());
+    let r = unsafe { &*r };
+    r.unwrap_err_debug().into()
+}
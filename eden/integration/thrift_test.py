@@ -19,6 +19,8 @@ from facebook.eden.ttypes import (
     FileAttributeData,
     FileAttributeDataOrError,
     FileAttributes,
+    FileAttributesRequest,
+    GetAttributesFromFilesBatchParams,
     GetAttributesFromFilesParams,
     GetAttributesFromFilesResult,
     SyncBehavior,
@@ -253,6 +255,54 @@ class ThriftTest(testcase.EdenRepoTest):
             results, "i_do_not_exist: No such file or directory", 0
         )
 
+    def test_get_attributes_batch(self) -> None:
+        expected_hello_sha1, expected_hello_size = self.get_expected_file_attributes(
+            "hello"
+        )
+        expected_adir_size = self.get_expected_file_attributes("adir/file")[1]
+
+        def request(mount: bytes, path: bytes, req_attr: int) -> FileAttributesRequest:
+            return FileAttributesRequest(
+                mountPoint=mount, path=path, requestedAttributes=req_attr
+            )
+
+        with self.get_thrift_client() as client:
+            results = client.getAttributesFromFilesBatch(
+                GetAttributesFromFilesBatchParams(
+                    requests=[
+                        request(self.mount_path_bytes, b"hello", self.ALL_ATTRIBUTES),
+                        request(b"/not/a/mount", b"hello", self.ALL_ATTRIBUTES),
+                        request(
+                            self.mount_path_bytes,
+                            b"adir/file",
+                            FileAttributes.FILE_SIZE,
+                        ),
+                        request(
+                            self.mount_path_bytes,
+                            b"i_do_not_exist",
+                            self.ALL_ATTRIBUTES,
+                        ),
+                    ],
+                    sync=SyncBehavior(),
+                )
+            )
+
+        self.assertEqual(4, len(results.res))
+        self.assertEqual(
+            FileAttributeDataOrError(
+                FileAttributeData(expected_hello_sha1, expected_hello_size)
+            ),
+            results.res[0],
+        )
+        self.assertEqual(FileAttributeDataOrError.ERROR, results.res[1].getType())
+        self.assertEqual(
+            FileAttributeDataOrError(FileAttributeData(None, expected_adir_size)),
+            results.res[2],
+        )
+        self.assert_attribute_error(
+            results, "i_do_not_exist: No such file or directory", 3
+        )
+
     """
     def test_get_sha1_only(self) -> None:
         # expected sha1 result for file
@@ -60,14 +60,44 @@ typedef unsigned __int64 uint64_t;
 // approach, this is still faster for the mercurial use case
 // as it helps to eliminate creating N other objects to
 // represent the stat information in the hgwatchman extension
+//
+// When decoded lazily, the values start out as NULL slots in the tuple
+// and are decoded from the original buffer on first access.
+struct lazy_pdu;
+
 // clang-format off
 typedef struct {
   PyObject_HEAD
   PyObject *keys;   // tuple of field names
   PyObject *values; // tuple of values
+  struct lazy_pdu *lazy; // buffer of the values not decoded yet, or NULL
+  const char **spans;    // start of each encoded value, then the end
 } bserObject;
 // clang-format on
 
+static PyObject*
+lazy_decode(struct lazy_pdu* lazy, const char* start, const char* stop);
+static void lazy_release(struct lazy_pdu* lazy);
+
+static PyObject* bserobj_value(bserObject* obj, Py_ssize_t i) {
+  PyObject* ele;
+
+  if (i < 0 || i >= PyTuple_GET_SIZE(obj->values)) {
+    PyErr_SetString(PyExc_IndexError, "bserobject index out of range");
+    return NULL;
+  }
+  ele = PyTuple_GET_ITEM(obj->values, i);
+  if (ele == NULL) {
+    ele = lazy_decode(obj->lazy, obj->spans[i], obj->spans[i + 1]);
+    if (ele == NULL) {
+      return NULL;
+    }
+    PyTuple_SET_ITEM(obj->values, i, ele);
+  }
+  Py_INCREF(ele);
+  return ele;
+}
+
 static Py_ssize_t bserobj_tuple_length(PyObject* o) {
   bserObject* obj = (bserObject*)o;
 
@@ -77,7 +107,7 @@ static Py_ssize_t bserobj_tuple_length(PyObject* o) {
 static PyObject* bserobj_tuple_item(PyObject* o, Py_ssize_t i) {
   bserObject* obj = (bserObject*)o;
 
-  return PySequence_GetItem(obj->values, i);
+  return bserobj_value(obj, i);
 }
 
 // clang-format off
@@ -98,6 +128,8 @@ static void bserobj_dealloc(PyObject* o) {
 
   Py_CLEAR(obj->keys);
   Py_CLEAR(obj->values);
+  PyMem_Free(obj->spans);
+  lazy_release(obj->lazy);
   PyObject_Del(o);
 }
 
@@ -115,7 +147,10 @@ static PyObject* bserobj_getattrro(PyObject* o, PyObject* name) {
     if (i == -1 && PyErr_Occurred()) {
       goto bail;
     }
-    ret = PySequence_GetItem(obj->values, i);
+    if (i < 0) {
+      i += PyTuple_GET_SIZE(obj->values);
+    }
+    ret = bserobj_value(obj, i);
     goto bail;
   }
 
@@ -158,7 +193,7 @@ static PyObject* bserobj_getattrro(PyObject* o, PyObject* name) {
     }
 
     if (!strcmp(keystr, namestr)) {
-      ret = PySequence_GetItem(obj->values, i);
+      ret = bserobj_value(obj, i);
       goto bail;
     }
     Py_XDECREF(key_bytes);
@@ -619,7 +654,7 @@ static int bunser_bytestring(
     return 0;
   }
 
-  if (buf + *len > end) {
+  if (*len < 0 || *len > end - buf) {
     PyErr_Format(PyExc_ValueError, "invalid string length in bser data");
     return 0;
   }
@@ -694,6 +729,8 @@ bunser_object(const char** ptr, const char* end, const unser_ctx_t* ctx) {
     obj = PyObject_New(bserObject, &bserObjectType);
     obj->keys = PyTuple_New((Py_ssize_t)nitems);
     obj->values = PyTuple_New((Py_ssize_t)nitems);
+    obj->lazy = NULL;
+    obj->spans = NULL;
     res = (PyObject*)obj;
   }
 
@@ -820,6 +857,8 @@ bunser_template(const char** ptr, const char* end, const unser_ctx_t* ctx) {
         obj->keys = keys;
         Py_INCREF(obj->keys);
         obj->values = PyTuple_New(numkeys);
+        obj->lazy = NULL;
+        obj->spans = NULL;
       }
       dict = (PyObject*)obj;
     }
@@ -966,6 +1005,581 @@ static PyObject* bser_loads_recursive(
   return NULL;
 }
 
+// Lazy decoding.
+//
+// Instead of building the whole tree of a response up front, arrays and
+// objects are returned as proxies over the original buffer, and their
+// elements are decoded when they are first accessed. Finding where the
+// elements start takes a walk over the encoded data, which is cheap next to
+// allocating Python objects for data that is never looked at.
+
+// The buffer and the decoding options, shared by all of the proxies over
+// one PDU.
+typedef struct lazy_pdu {
+  Py_ssize_t refs;
+  PyObject* data; // owns the buffer
+  PyObject* encoding; // owns ctx.value_encoding, or NULL
+  PyObject* errors; // owns ctx.value_errors, or NULL
+  PyObject* lastkeys; // keys of the last OBJECT decoded, usually the next's
+  unser_ctx_t ctx;
+} lazy_pdu_t;
+
+static void lazy_release(lazy_pdu_t* lazy) {
+  if (lazy == NULL || --lazy->refs > 0) {
+    return;
+  }
+  Py_DECREF(lazy->data);
+  Py_XDECREF(lazy->encoding);
+  Py_XDECREF(lazy->errors);
+  Py_XDECREF(lazy->lastkeys);
+  PyMem_Free(lazy);
+}
+
+static int bser_truncated(void) {
+  PyErr_SetString(PyExc_ValueError, "bser data truncated");
+  return 0;
+}
+
+// Read an element count, which must leave room for at least one byte per
+// element of the given size.
+static int bunser_count(
+    const char** ptr,
+    const char* end,
+    Py_ssize_t elesize,
+    Py_ssize_t* count) {
+  int64_t n;
+
+  if (*ptr >= end) {
+    return bser_truncated();
+  }
+  if (!bunser_int(ptr, end, &n)) {
+    return 0;
+  }
+  if (n < 0 || (elesize > 0 && n > (end - *ptr) / elesize)) {
+    PyErr_SetString(PyExc_ValueError, "invalid item count in bser data");
+    return 0;
+  }
+  *count = (Py_ssize_t)n;
+  return 1;
+}
+
+// Move past one encoded value, checking it without decoding it.
+static int bser_skip(const char** ptr, const char* end) {
+  const char* buf = *ptr;
+  const char* start;
+  int64_t len;
+  Py_ssize_t i, j, n, nkeys;
+
+  if (buf >= end) {
+    return bser_truncated();
+  }
+  switch (buf[0]) {
+    case BSER_INT8:
+    case BSER_INT16:
+    case BSER_INT32:
+    case BSER_INT64:
+      return bunser_int(ptr, end, &len);
+
+    case BSER_REAL:
+      if (end - buf < 1 + (Py_ssize_t)sizeof(double)) {
+        return bser_truncated();
+      }
+      *ptr = buf + 1 + sizeof(double);
+      return 1;
+
+    case BSER_TRUE:
+    case BSER_FALSE:
+    case BSER_NULL:
+      *ptr = buf + 1;
+      return 1;
+
+    case BSER_BYTESTRING:
+    case BSER_UTF8STRING:
+      return bunser_bytestring(ptr, end, &start, &len);
+
+    case BSER_ARRAY:
+      *ptr = buf + 1;
+      if (!bunser_count(ptr, end, 1, &n)) {
+        return 0;
+      }
+      for (i = 0; i < n; i++) {
+        if (!bser_skip(ptr, end)) {
+          return 0;
+        }
+      }
+      return 1;
+
+    case BSER_OBJECT:
+      *ptr = buf + 1;
+      if (!bunser_count(ptr, end, 2, &n)) {
+        return 0;
+      }
+      for (i = 0; i < n; i++) {
+        if (*ptr >= end) {
+          return bser_truncated();
+        }
+        if (!bunser_bytestring(ptr, end, &start, &len) ||
+            !bser_skip(ptr, end)) {
+          return 0;
+        }
+      }
+      return 1;
+
+    case BSER_TEMPLATE:
+      if (end - buf < 2 || buf[1] != BSER_ARRAY) {
+        PyErr_Format(PyExc_ValueError, "Expect ARRAY to follow TEMPLATE");
+        return 0;
+      }
+      *ptr = buf + 2;
+      if (!bunser_count(ptr, end, 1, &nkeys)) {
+        return 0;
+      }
+      for (i = 0; i < nkeys; i++) {
+        if (!bser_skip(ptr, end)) {
+          return 0;
+        }
+      }
+      if (!bunser_count(ptr, end, nkeys, &n)) {
+        return 0;
+      }
+      for (i = 0; i < n; i++) {
+        for (j = 0; j < nkeys; j++) {
+          if (*ptr < end && **ptr == BSER_SKIP) {
+            *ptr = *ptr + 1;
+          } else if (!bser_skip(ptr, end)) {
+            return 0;
+          }
+        }
+      }
+      return 1;
+
+    default:
+      PyErr_Format(PyExc_ValueError, "unhandled bser opcode 0x%02x", buf[0]);
+      return 0;
+  }
+}
+
+// Make an immutable object whose values are encoded at ptr, one after the
+// other: keyed ones for an OBJECT, or the cells of a TEMPLATE row if keys is
+// given. Only the keys are decoded, and the keys tuple of the previous
+// OBJECT is reused when they are the same, as in lists of file entries.
+static PyObject* lazy_object(
+    lazy_pdu_t* lazy,
+    PyObject* keys,
+    const char** ptr,
+    const char* end) {
+  bserObject* obj;
+  PyObject* last = lazy->lastkeys;
+  Py_ssize_t i, n;
+  int keyed = keys == NULL;
+
+  if (keyed) {
+    if (!bunser_count(ptr, end, 2, &n)) {
+      return NULL;
+    }
+    if (last == NULL || PyTuple_GET_SIZE(last) != n) {
+      last = NULL;
+    }
+  } else {
+    n = PyTuple_GET_SIZE(keys);
+    Py_INCREF(keys);
+  }
+
+  obj = PyObject_New(bserObject, &bserObjectType);
+  if (obj == NULL) {
+    Py_XDECREF(keys);
+    return NULL;
+  }
+  // Until a key differs from the last ones, keys stays NULL.
+  obj->keys = keys;
+  obj->values = PyTuple_New(n);
+  obj->lazy = lazy;
+  lazy->refs++;
+  obj->spans = PyMem_Malloc((n + 1) * sizeof(*obj->spans));
+  if (obj->values == NULL || obj->spans == NULL) {
+    Py_DECREF(obj);
+    return PyErr_NoMemory();
+  }
+
+  for (i = 0; i < n; i++) {
+    if (keyed) {
+      const char* keystr;
+      int64_t keylen;
+      PyObject* key;
+
+      if (*ptr >= end) {
+        bser_truncated();
+        goto bail;
+      }
+      if (!bunser_bytestring(ptr, end, &keystr, &keylen)) {
+        goto bail;
+      }
+      if (last) {
+        key = PyTuple_GET_ITEM(last, i);
+        if (PyBytes_GET_SIZE(key) == keylen &&
+            !memcmp(PyBytes_AS_STRING(key), keystr, keylen)) {
+          goto skip;
+        }
+        obj->keys = PyTuple_GetSlice(last, 0, n);
+        if (obj->keys == NULL) {
+          goto bail;
+        }
+        last = NULL;
+      } else if (obj->keys == NULL) {
+        obj->keys = PyTuple_New(n);
+        if (obj->keys == NULL) {
+          goto bail;
+        }
+      }
+      key = PyBytes_FromStringAndSize(keystr, (Py_ssize_t)keylen);
+      if (key == NULL) {
+        goto bail;
+      }
+      // The slot may hold a key of the last object.
+      Py_XDECREF(PyTuple_GET_ITEM(obj->keys, i));
+      PyTuple_SET_ITEM(obj->keys, i, key);
+    skip:
+      obj->spans[i] = *ptr;
+      if (!bser_skip(ptr, end)) {
+        goto bail;
+      }
+    } else {
+      obj->spans[i] = *ptr;
+      if (*ptr < end && **ptr == BSER_SKIP) {
+        *ptr = *ptr + 1;
+      } else if (!bser_skip(ptr, end)) {
+        goto bail;
+      }
+    }
+  }
+  obj->spans[n] = *ptr;
+
+  if (keyed) {
+    if (last) {
+      obj->keys = last;
+      Py_INCREF(last);
+    } else if (obj->keys == NULL) {
+      // An empty object.
+      obj->keys = PyTuple_New(0);
+      if (obj->keys == NULL) {
+        goto bail;
+      }
+    }
+    Py_XDECREF(lazy->lastkeys);
+    lazy->lastkeys = obj->keys;
+    Py_INCREF(lazy->lastkeys);
+  }
+  return (PyObject*)obj;
+
+bail:
+  Py_DECREF(obj);
+  return NULL;
+}
+
+// An immutable ARRAY, or TEMPLATE of rows, decoded on access.
+// clang-format off
+typedef struct {
+  PyObject_HEAD
+  lazy_pdu_t *lazy;
+  PyObject *keys;     // template keys, or NULL for an ARRAY
+  const char *start;  // the first element
+  const char *end;    // the end of the last element
+  Py_ssize_t nitems;
+  const char **spans; // start of each element, then the end; on first access
+  PyObject **items;   // decoded elements, NULL until accessed
+} bserArray;
+// clang-format on
+
+static PyTypeObject bserArrayType;
+
+// Find where each element starts.
+static int bserarray_index(bserArray* arr) {
+  const char* ptr = arr->start;
+  Py_ssize_t i, j, width = arr->keys ? PyTuple_GET_SIZE(arr->keys) : 1;
+
+  if ((size_t)arr->nitems >= PY_SSIZE_T_MAX / sizeof(*arr->items)) {
+    PyErr_NoMemory();
+    return 0;
+  }
+  arr->spans = PyMem_Malloc((arr->nitems + 1) * sizeof(*arr->spans));
+  arr->items = PyMem_Malloc((arr->nitems + 1) * sizeof(*arr->items));
+  if (arr->spans == NULL || arr->items == NULL) {
+    goto bail;
+  }
+  memset(arr->items, 0, (arr->nitems + 1) * sizeof(*arr->items));
+
+  for (i = 0; i < arr->nitems; i++) {
+    arr->spans[i] = ptr;
+    if (arr->keys == NULL) {
+      if (!bser_skip(&ptr, arr->end)) {
+        goto bail;
+      }
+      continue;
+    }
+    for (j = 0; j < width; j++) {
+      if (ptr < arr->end && *ptr == BSER_SKIP) {
+        ptr++;
+      } else if (!bser_skip(&ptr, arr->end)) {
+        goto bail;
+      }
+    }
+  }
+  arr->spans[arr->nitems] = ptr;
+  return 1;
+
+bail:
+  if (!PyErr_Occurred()) {
+    PyErr_NoMemory();
+  }
+  PyMem_Free(arr->spans);
+  PyMem_Free(arr->items);
+  arr->spans = NULL;
+  arr->items = NULL;
+  return 0;
+}
+
+static Py_ssize_t bserarray_length(PyObject* o) {
+  return ((bserArray*)o)->nitems;
+}
+
+static PyObject* bserarray_item(PyObject* o, Py_ssize_t i) {
+  bserArray* arr = (bserArray*)o;
+  PyObject* ele;
+
+  if (i < 0 || i >= arr->nitems) {
+    PyErr_SetString(PyExc_IndexError, "bserarray index out of range");
+    return NULL;
+  }
+  if (arr->items == NULL && !bserarray_index(arr)) {
+    return NULL;
+  }
+  ele = arr->items[i];
+  if (ele == NULL) {
+    if (arr->keys) {
+      const char* ptr = arr->spans[i];
+      ele = lazy_object(arr->lazy, arr->keys, &ptr, arr->spans[i + 1]);
+    } else {
+      ele = lazy_decode(arr->lazy, arr->spans[i], arr->spans[i + 1]);
+    }
+    if (ele == NULL) {
+      return NULL;
+    }
+    arr->items[i] = ele;
+  }
+  Py_INCREF(ele);
+  return ele;
+}
+
+static PyObject* bserarray_subscript(PyObject* o, PyObject* key) {
+  bserArray* arr = (bserArray*)o;
+  Py_ssize_t i, start, stop, step, len;
+  PyObject* res;
+
+  if (PyIndex_Check(key)) {
+    i = PyNumber_AsSsize_t(key, PyExc_IndexError);
+    if (i == -1 && PyErr_Occurred()) {
+      return NULL;
+    }
+    if (i < 0) {
+      i += arr->nitems;
+    }
+    return bserarray_item(o, i);
+  }
+  if (!PySlice_Check(key)) {
+    PyErr_Format(
+        PyExc_TypeError,
+        "bserarray indices must be integers, not %.200s",
+        Py_TYPE(key)->tp_name);
+    return NULL;
+  }
+#if PY_MAJOR_VERSION >= 3
+  if (PySlice_GetIndicesEx(key, arr->nitems, &start, &stop, &step, &len)) {
+#else
+  if (PySlice_GetIndicesEx(
+          (PySliceObject*)key, arr->nitems, &start, &stop, &step, &len)) {
+#endif
+    return NULL;
+  }
+  res = PyTuple_New(len);
+  if (res == NULL) {
+    return NULL;
+  }
+  for (i = 0; i < len; i++) {
+    PyObject* ele = bserarray_item(o, start + i * step);
+    if (ele == NULL) {
+      Py_DECREF(res);
+      return NULL;
+    }
+    PyTuple_SET_ITEM(res, i, ele);
+  }
+  return res;
+}
+
+static void bserarray_dealloc(PyObject* o) {
+  bserArray* arr = (bserArray*)o;
+  Py_ssize_t i;
+
+  if (arr->items) {
+    for (i = 0; i < arr->nitems; i++) {
+      Py_XDECREF(arr->items[i]);
+    }
+  }
+  PyMem_Free(arr->items);
+  PyMem_Free(arr->spans);
+  Py_XDECREF(arr->keys);
+  lazy_release(arr->lazy);
+  PyObject_Del(o);
+}
+
+// clang-format off
+static PySequenceMethods bserarray_sq = {
+  bserarray_length,          /* sq_length */
+  0,                         /* sq_concat */
+  0,                         /* sq_repeat */
+  bserarray_item,            /* sq_item */
+  0,                         /* sq_ass_item */
+  0,                         /* sq_contains */
+  0,                         /* sq_inplace_concat */
+  0                          /* sq_inplace_repeat */
+};
+
+static PyMappingMethods bserarray_map = {
+  bserarray_length,          /* mp_length */
+  bserarray_subscript,       /* mp_subscript */
+  0                          /* mp_ass_subscript */
+};
+
+static PyTypeObject bserArrayType = {
+  PyVarObject_HEAD_INIT(NULL, 0)
+  "bserarray",               /* tp_name */
+  sizeof(bserArray),         /* tp_basicsize */
+  0,                         /* tp_itemsize */
+  bserarray_dealloc,         /* tp_dealloc */
+  0,                         /* tp_print */
+  0,                         /* tp_getattr */
+  0,                         /* tp_setattr */
+  0,                         /* tp_compare */
+  0,                         /* tp_repr */
+  0,                         /* tp_as_number */
+  &bserarray_sq,             /* tp_as_sequence */
+  &bserarray_map,            /* tp_as_mapping */
+  0,                         /* tp_hash  */
+  0,                         /* tp_call */
+  0,                         /* tp_str */
+  0,                         /* tp_getattro */
+  0,                         /* tp_setattro */
+  0,                         /* tp_as_buffer */
+  Py_TPFLAGS_DEFAULT,        /* tp_flags */
+  "lazily decoded bser array", /* tp_doc */
+};
+// clang-format on
+
+static PyObject* lazy_array(
+    lazy_pdu_t* lazy,
+    const char* start,
+    const char* end,
+    int template) {
+  const char* ptr = start + 1;
+  PyObject* keys = NULL;
+  Py_ssize_t nitems;
+  bserArray* arr;
+
+  if (template) {
+    unser_ctx_t keys_ctx = {0};
+
+    if (end - start < 2 || start[1] != BSER_ARRAY) {
+      PyErr_Format(PyExc_ValueError, "Expect ARRAY to follow TEMPLATE");
+      return NULL;
+    }
+    keys = bunser_array(&ptr, end, &keys_ctx);
+    if (keys == NULL) {
+      return NULL;
+    }
+  }
+  if (!bunser_count(
+          &ptr, end, keys ? PyTuple_GET_SIZE(keys) : 1, &nitems)) {
+    Py_XDECREF(keys);
+    return NULL;
+  }
+
+  arr = PyObject_New(bserArray, &bserArrayType);
+  if (arr == NULL) {
+    Py_XDECREF(keys);
+    return NULL;
+  }
+  arr->lazy = lazy;
+  lazy->refs++;
+  arr->keys = keys;
+  arr->start = ptr;
+  arr->end = end;
+  arr->nitems = nitems;
+  arr->spans = NULL;
+  arr->items = NULL;
+  return (PyObject*)arr;
+}
+
+// Decode the value encoded in [start, stop), leaving its elements encoded
+// if it is a container.
+static PyObject*
+lazy_decode(lazy_pdu_t* lazy, const char* start, const char* stop) {
+  if (start >= stop) {
+    bser_truncated();
+    return NULL;
+  }
+  switch (start[0]) {
+    case BSER_ARRAY:
+      return lazy_array(lazy, start, stop, 0);
+
+    case BSER_TEMPLATE:
+      return lazy_array(lazy, start, stop, 1);
+
+    case BSER_OBJECT:
+      start++;
+      return lazy_object(lazy, NULL, &start, stop);
+
+    case BSER_SKIP:
+      // Only ever found in the cells of a template row.
+      Py_INCREF(Py_None);
+      return Py_None;
+
+    default:
+      return bser_loads_recursive(&start, stop, &lazy->ctx);
+  }
+}
+
+static PyObject* bser_loads_lazy(
+    PyObject* data,
+    const char* start,
+    const char* end,
+    const unser_ctx_t* ctx) {
+  lazy_pdu_t* lazy;
+  PyObject* res;
+
+  lazy = PyMem_Malloc(sizeof(*lazy));
+  if (lazy == NULL) {
+    return PyErr_NoMemory();
+  }
+  lazy->refs = 1;
+  lazy->data = data;
+  Py_INCREF(data);
+  lazy->ctx = *ctx;
+  lazy->encoding = lazy->errors = lazy->lastkeys = NULL;
+  if (ctx->value_encoding) {
+    lazy->encoding = PyBytes_FromString(ctx->value_encoding);
+    lazy->errors = PyBytes_FromString(ctx->value_errors);
+    if (lazy->encoding == NULL || lazy->errors == NULL) {
+      lazy_release(lazy);
+      return NULL;
+    }
+    lazy->ctx.value_encoding = PyBytes_AS_STRING(lazy->encoding);
+    lazy->ctx.value_errors = PyBytes_AS_STRING(lazy->errors);
+  }
+
+  res = lazy_decode(lazy, start, end);
+  lazy_release(lazy);
+  return res;
+}
+
 static int _pdu_info_helper(
     const char* data,
     const char* end,
@@ -1082,29 +1696,39 @@ static PyObject* bser_loads(PyObject* self, PyObject* args, PyObject* kw) {
   PyObject* mutable_obj = NULL;
   const char* value_encoding = NULL;
   const char* value_errors = NULL;
+  PyObject* lazy_obj = NULL;
+  int lazy = 0;
   unser_ctx_t ctx = {1, 0};
 
   static char* kw_list[] = {
-      "buf", "mutable", "value_encoding", "value_errors", NULL};
+      "buf", "mutable", "value_encoding", "value_errors", "lazy", NULL};
 
   (void)self;
 
   if (!PyArg_ParseTupleAndKeywords(
           args,
           kw,
-          "s#|Ozz:loads",
+          "s#|OzzO:loads",
           kw_list,
           &start,
           &datalen,
           &mutable_obj,
           &value_encoding,
-          &value_errors)) {
+          &value_errors,
+          &lazy_obj)) {
     return NULL;
   }
 
   if (mutable_obj) {
     ctx.mutable = PyObject_IsTrue(mutable_obj) > 0 ? 1 : 0;
   }
+  if (lazy_obj) {
+    lazy = PyObject_IsTrue(lazy_obj) > 0 ? 1 : 0;
+  }
+  if (lazy && ctx.mutable) {
+    PyErr_SetString(PyExc_ValueError, "lazy decoding needs mutable=False");
+    return NULL;
+  }
   ctx.value_encoding = value_encoding;
   if (value_encoding == NULL) {
     ctx.value_errors = NULL;
@@ -1133,6 +1757,14 @@ static PyObject* bser_loads(PyObject* self, PyObject* args, PyObject* kw) {
     return NULL;
   }
 
+  if (lazy) {
+    // The proxies point into the buffer, so they keep the object it
+    // came from alive.
+    PyObject* buf = PyTuple_GET_SIZE(args) > 0
+        ? PyTuple_GET_ITEM(args, 0)
+        : PyDict_GetItemString(kw, "buf");
+    return bser_loads_lazy(buf, data, end, &ctx);
+  }
   return bser_loads_recursive(&data, end, &ctx);
 }
 
@@ -1202,7 +1834,8 @@ static PyObject* bser_load(PyObject* self, PyObject* args, PyObject* kw) {
 // clang-format off
 static PyMethodDef bser_methods[] = {
   {"loads", (PyCFunction)bser_loads, METH_VARARGS | METH_KEYWORDS,
-   "Deserialize string."},
+   "Deserialize string. With lazy=True (and mutable=False), arrays and\n"
+   "objects are decoded from the string as their elements are accessed."},
   {"load", (PyCFunction)bser_load, METH_VARARGS | METH_KEYWORDS,
    "Deserialize a file object"},
   {"pdu_info", (PyCFunction)bser_pdu_info, METH_VARARGS,
@@ -1229,6 +1862,7 @@ PyMODINIT_FUNC PyInit_bser(void) {
 
   mod = PyModule_Create(&bser_module);
   PyType_Ready(&bserObjectType);
+  PyType_Ready(&bserArrayType);
 
   return mod;
 }
@@ -1237,6 +1871,7 @@ PyMODINIT_FUNC PyInit_bser(void) {
 PyMODINIT_FUNC initbser(void) {
   (void)Py_InitModule("bser", bser_methods);
   PyType_Ready(&bserObjectType);
+  PyType_Ready(&bserArrayType);
 }
 #endif // PY_MAJOR_VERSION >= 3
 
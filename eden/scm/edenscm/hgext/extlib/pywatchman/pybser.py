@@ -475,7 +475,7 @@ def pdu_len(buf):
     return info[2] + info[3]
 
 
-def loads(buf, mutable=True, value_encoding=None, value_errors=None):
+def loads(buf, mutable=True, value_encoding=None, value_errors=None, lazy=False):
     """Deserialize a BSER-encoded blob.
 
     @param buf: The buffer to deserialize.
@@ -492,8 +492,16 @@ def loads(buf, mutable=True, value_encoding=None, value_errors=None):
                          The other most common argument is 'surrogateescape' on
                          Python 3. If value_encoding is None, this is ignored.
     @type value_errors: str
+
+    @param lazy: Whether to decode array and object elements only when they
+                 are accessed. Requires mutable=False. This implementation
+                 always decodes everything up front.
+    @type lazy: bool
     """
 
+    if lazy and mutable:
+        raise ValueError("lazy decoding needs mutable=False")
+
     info = _pdu_info_helper(buf)
     expected_len = info[2]
     pos = info[3]
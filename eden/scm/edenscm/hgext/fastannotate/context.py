@@ -505,10 +505,9 @@ class _annotatecontext(object):
 
             # both self.linelog and self.revmap is backed by filesystem. now
             # we want to modify them but do not want to write changes back to
-            # files. so we create in-memory objects and copy them. it's like
-            # a "fork".
-            linelog = linelogmod.linelog()
-            linelog.copyfrom(self.linelog)
+            # files. so we fork them into in-memory objects. the linelog fork
+            # only copies the parts it changes.
+            linelog = self.linelog.fork()
             linelog.annotate(linelog.maxrev)
             revmap = revmapmod.revmap()
             revmap.copyfrom(self.revmap)
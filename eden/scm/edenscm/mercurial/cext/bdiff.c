@@ -24,6 +24,7 @@
 
 #include "eden/scm/edenscm/mercurial/bdiff.h"
 #include "eden/scm/edenscm/mercurial/bitmanipulation.h"
+#include "eden/scm/edenscm/mercurial/cext/threadpool.h"
 #include "eden/scm/edenscm/mercurial/cext/util.h"
 
 static PyObject* blocks(PyObject* self, PyObject* args) {
@@ -64,14 +65,84 @@ nomem:
   return rl ? rl : PyErr_NoMemory();
 }
 
+/*
+ * Diff a against b, without using the Python API. Return the length of the
+ * binary patch that writepatch will build from the hunks in l, or -1 when
+ * out of memory. The lines in al and bl and the hunks are for the caller to
+ * free, even on failure.
+ */
+static Py_ssize_t diffpatch(
+    const char* sa,
+    Py_ssize_t la,
+    const char* sb,
+    Py_ssize_t lb,
+    struct bdiff_line** al,
+    struct bdiff_line** bl,
+    struct bdiff_hunk* l,
+    Py_ssize_t* lcommon) {
+  const char *ia, *ib;
+  struct bdiff_hunk* h;
+  int an, bn, count;
+  Py_ssize_t len = 0, li = 0, lmax;
+
+  *al = *bl = NULL;
+  *lcommon = 0;
+  lmax = la > lb ? lb : la;
+  for (ia = sa, ib = sb; li < lmax && *ia == *ib; ++li, ++ia, ++ib)
+    if (*ia == '\n')
+      *lcommon = li + 1;
+  /* we can almost add: if (li == lmax) lcommon = li; */
+
+  an = bdiff_splitlines(sa + *lcommon, la - *lcommon, al);
+  bn = bdiff_splitlines(sb + *lcommon, lb - *lcommon, bl);
+  if (!*al || !*bl)
+    return -1;
+
+  count = bdiff_diff(*al, an, *bl, bn, l);
+  if (count < 0)
+    return -1;
+
+  /* calculate length of output */
+  la = lb = 0;
+  for (h = l->next; h; h = h->next) {
+    if (h->a1 != la || h->b1 != lb)
+      len += 12 + (*bl)[h->b1].l - (*bl)[lb].l;
+    la = h->a2;
+    lb = h->b2;
+  }
+  return len;
+}
+
+/* Build the binary patch of the hunks found by diffpatch in rb. */
+static void writepatch(
+    char* rb,
+    struct bdiff_line* al,
+    struct bdiff_line* bl,
+    struct bdiff_hunk* l,
+    Py_ssize_t lcommon) {
+  struct bdiff_hunk* h;
+  Py_ssize_t la = 0, lb = 0, len;
+
+  for (h = l->next; h; h = h->next) {
+    if (h->a1 != la || h->b1 != lb) {
+      len = bl[h->b1].l - bl[lb].l;
+      putbe32((uint32_t)(al[la].l + lcommon - al->l), rb);
+      putbe32((uint32_t)(al[h->a1].l + lcommon - al->l), rb + 4);
+      putbe32((uint32_t)len, rb + 8);
+      memcpy(rb + 12, bl[lb].l, len);
+      rb += 12 + len;
+    }
+    la = h->a2;
+    lb = h->b2;
+  }
+}
+
 static PyObject* bdiff(PyObject* self, PyObject* args) {
-  char *sa, *sb, *rb, *ia, *ib;
   PyObject* result = NULL;
   Py_buffer ya, yb;
   struct bdiff_line *al, *bl;
-  struct bdiff_hunk l, *h;
-  int an, bn, count;
-  Py_ssize_t len = 0, la, lb, li = 0, lcommon = 0, lmax;
+  struct bdiff_hunk l;
+  Py_ssize_t len, lcommon;
   PyThreadState* _save;
 
   l.next = NULL;
@@ -83,43 +154,19 @@ static PyObject* bdiff(PyObject* self, PyObject* args) {
   if (!PyArg_ParseTuple(args, "s*s*:bdiff", &ya, &yb))
     return NULL;
 #endif
-  sa = ya.buf;
-  sb = yb.buf;
-  la = ya.len;
-  lb = yb.len;
 
-  if (la > UINT_MAX || lb > UINT_MAX) {
+  if (ya.len > UINT_MAX || yb.len > UINT_MAX) {
     PyErr_SetString(PyExc_ValueError, "bdiff inputs too large");
+    PyBuffer_Release(&ya);
+    PyBuffer_Release(&yb);
     return NULL;
   }
 
   _save = PyEval_SaveThread();
-
-  lmax = la > lb ? lb : la;
-  for (ia = sa, ib = sb; li < lmax && *ia == *ib; ++li, ++ia, ++ib)
-    if (*ia == '\n')
-      lcommon = li + 1;
-  /* we can almost add: if (li == lmax) lcommon = li; */
-
-  an = bdiff_splitlines(sa + lcommon, la - lcommon, &al);
-  bn = bdiff_splitlines(sb + lcommon, lb - lcommon, &bl);
-  if (!al || !bl)
-    goto nomem;
-
-  count = bdiff_diff(al, an, bl, bn, &l);
-  if (count < 0)
-    goto nomem;
-
-  /* calculate length of output */
-  la = lb = 0;
-  for (h = l.next; h; h = h->next) {
-    if (h->a1 != la || h->b1 != lb)
-      len += 12 + bl[h->b1].l - bl[lb].l;
-    la = h->a2;
-    lb = h->b2;
-  }
+  len = diffpatch(ya.buf, ya.len, yb.buf, yb.len, &al, &bl, &l, &lcommon);
   PyEval_RestoreThread(_save);
-  _save = NULL;
+  if (len < 0)
+    goto nomem;
 
   result = PyBytes_FromStringAndSize(NULL, len);
 
@@ -127,31 +174,119 @@ static PyObject* bdiff(PyObject* self, PyObject* args) {
     goto nomem;
 
   /* build binary patch */
-  rb = PyBytes_AsString(result);
-  la = lb = 0;
-
-  for (h = l.next; h; h = h->next) {
-    if (h->a1 != la || h->b1 != lb) {
-      len = bl[h->b1].l - bl[lb].l;
-      putbe32((uint32_t)(al[la].l + lcommon - al->l), rb);
-      putbe32((uint32_t)(al[h->a1].l + lcommon - al->l), rb + 4);
-      putbe32((uint32_t)len, rb + 8);
-      memcpy(rb + 12, bl[lb].l, len);
-      rb += 12 + len;
-    }
-    la = h->a2;
-    lb = h->b2;
-  }
+  writepatch(PyBytes_AsString(result), al, bl, &l, lcommon);
 
 nomem:
-  if (_save)
-    PyEval_RestoreThread(_save);
+  PyBuffer_Release(&ya);
+  PyBuffer_Release(&yb);
   free(al);
   free(bl);
   bdiff_freehunks(l.next);
   return result ? result : PyErr_NoMemory();
 }
 
+struct bdiffjob {
+  Py_buffer a, b;
+  char* patch; /* NULL when out of memory */
+  Py_ssize_t len;
+};
+
+static void runbdiffjob(void* ctx, Py_ssize_t i) {
+  struct bdiffjob* job = (struct bdiffjob*)ctx + i;
+  struct bdiff_line *al, *bl;
+  struct bdiff_hunk l;
+  Py_ssize_t lcommon;
+
+  l.next = NULL;
+  job->len = diffpatch(
+      job->a.buf, job->a.len, job->b.buf, job->b.len, &al, &bl, &l, &lcommon);
+  if (job->len >= 0 && (job->patch = malloc(job->len ? job->len : 1)))
+    writepatch(job->patch, al, bl, &l, lcommon);
+  free(al);
+  free(bl);
+  bdiff_freehunks(l.next);
+}
+
+/*
+ * Like bdiff for each of a sequence of (a, b) pairs, the pairs being diffed
+ * on up to the given number of threads without the GIL.
+ */
+static PyObject* bdiffs(PyObject* self, PyObject* args) {
+  PyObject *pairs, *seq, *result = NULL;
+  struct bdiffjob* jobs = NULL;
+  Py_ssize_t n, parsed = 0, i;
+  int threads = 1;
+  PyThreadState* _save;
+
+  if (!PyArg_ParseTuple(args, "O|i:bdiffs", &pairs, &threads))
+    return NULL;
+  seq = PySequence_Fast(pairs, "bdiffs expects a sequence of pairs");
+  if (!seq)
+    return NULL;
+  n = PySequence_Fast_GET_SIZE(seq);
+  jobs = calloc(n ? n : 1, sizeof(struct bdiffjob));
+  if (!jobs) {
+    PyErr_NoMemory();
+    goto cleanup;
+  }
+
+  for (; parsed < n; parsed++) {
+    struct bdiffjob* job = jobs + parsed;
+    PyObject* pair = PySequence_Fast_GET_ITEM(seq, parsed);
+    if (!PyTuple_Check(pair)) {
+      PyErr_SetString(PyExc_TypeError, "bdiffs expects (a, b) pairs");
+      goto cleanup;
+    }
+#ifdef IS_PY3K
+    if (!PyArg_ParseTuple(pair, "y*y*:bdiffs", &job->a, &job->b))
+      goto cleanup;
+#else
+    if (!PyArg_ParseTuple(pair, "s*s*:bdiffs", &job->a, &job->b))
+      goto cleanup;
+#endif
+    if (job->a.len > UINT_MAX || job->b.len > UINT_MAX) {
+      PyErr_SetString(PyExc_ValueError, "bdiff inputs too large");
+      parsed++;
+      goto cleanup;
+    }
+  }
+
+  _save = PyEval_SaveThread();
+  hg_run_jobs(runbdiffjob, jobs, n, threads);
+  PyEval_RestoreThread(_save);
+
+  result = PyList_New(n);
+  if (!result)
+    goto cleanup;
+  for (i = 0; i < n; i++) {
+    PyObject* patch;
+    if (!jobs[i].patch) {
+      Py_CLEAR(result);
+      PyErr_NoMemory();
+      goto cleanup;
+    }
+    patch = PyBytes_FromStringAndSize(jobs[i].patch, jobs[i].len);
+    if (!patch) {
+      Py_CLEAR(result);
+      goto cleanup;
+    }
+    PyList_SET_ITEM(result, i, patch);
+  }
+
+cleanup:
+  if (jobs) {
+    for (i = 0; i < parsed; i++) {
+      PyBuffer_Release(&jobs[i].a);
+      PyBuffer_Release(&jobs[i].b);
+    }
+    for (i = 0; i < n; i++)
+      free(jobs[i].patch);
+  }
+  free(jobs);
+  Py_DECREF(seq);
+  return result;
+}
+
 /*
  * If allws != 0, remove all whitespace (' ', \t and \r). Otherwise,
  * reduce whitespace sequences to a single space and trim remaining whitespace
@@ -196,6 +331,7 @@ static char mdiff_doc[] = "Efficient binary diff.";
 
 static PyMethodDef methods[] = {
     {"bdiff", bdiff, METH_VARARGS, "calculate a binary diff\n"},
+    {"bdiffs", bdiffs, METH_VARARGS, "calculate many binary diffs at once\n"},
     {"blocks", blocks, METH_VARARGS, "find a list of matching lines\n"},
     {"fixws", fixws, METH_VARARGS, "normalize diff whitespaces\n"},
     {NULL, NULL}};
@@ -3,8 +3,11 @@
 # This software may be used and distributed according to the terms of the
 # GNU General Public License version 2.
 
-from typing import List, Tuple, Union
+from typing import List, Sequence, Tuple, Union
 
 def blocks(a: str, b: str) -> List[Tuple[int, int, int, int]]: ...
 def fixws(s: str, allws: bool) -> bytes: ...
 def bdiff(a: Union[str, bytes], b: Union[str, bytes]) -> bytes: ...
+def bdiffs(
+    pairs: Sequence[Tuple[Union[str, bytes], Union[str, bytes]]], threads: int = ...
+) -> List[bytes]: ...
@@ -16,31 +16,121 @@
 
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
+#include <string.h>
 
 #include "eden/scm/edenscm/mercurial/cext/util.h"
 
-#ifdef IS_PY3K
-#define PYLONG_VALUE(o) ((PyLongObject*)o)->ob_digit[1]
-#else
-#define PYLONG_VALUE(o) PyInt_AS_LONG(o)
-#endif
-
 /*
  * This is a multiset of directory names, built from the files that
  * appear in a dirstate or manifest.
  *
  * A few implementation notes:
  *
- * We modify Python integers for refcounting, but those integers are
- * never visible to Python code.
+ * The directories are kept in an open addressing hash table, with
+ * linear probing. An entry doesn't copy its name: it points into the
+ * file path it was first seen in, and holds a reference to the object
+ * owning that path, a bytes path or a whole manifest text. Python
+ * strings are only built when iterating.
  *
- * We mutate strings in-place, but leave them immutable once they can
- * be seen by Python code.
+ * As with the dict based implementation this replaces, the root
+ * directory "" is never removed once added.
  */
 typedef struct {
-  PyObject_HEAD PyObject* dict;
+  const char* path; /* NULL for an empty slot */
+  Py_ssize_t len;
+  Py_ssize_t count; /* # files below */
+  PyObject* owner; /* holds path */
+  size_t hash;
+} direntry;
+
+typedef struct {
+  PyObject_HEAD direntry* table;
+  size_t capacity; /* a power of 2, or 0 */
+  size_t count; /* # entries in use */
 } dirsObject;
 
+static inline size_t _hashdir(const char* path, Py_ssize_t len) {
+  /* FNV-1a */
+  size_t h = (size_t)14695981039346656037ULL;
+  Py_ssize_t i;
+
+  for (i = 0; i < len; i++) {
+    h ^= (unsigned char)path[i];
+    h *= (size_t)1099511628211ULL;
+  }
+  return h;
+}
+
+/*
+ * Return the slot of the given directory, or the empty slot where it
+ * belongs. The table must have an empty slot.
+ */
+static inline direntry*
+_lookup(dirsObject* self, const char* path, Py_ssize_t len, size_t hash) {
+  size_t mask = self->capacity - 1;
+  size_t i = hash & mask;
+
+  for (;;) {
+    direntry* e = &self->table[i];
+    if (e->path == NULL ||
+        (e->hash == hash && e->len == len && !memcmp(e->path, path, len)))
+      return e;
+    i = (i + 1) & mask;
+  }
+}
+
+static int _resize(dirsObject* self, size_t capacity) {
+  direntry *old = self->table, *e;
+  size_t oldcapacity = self->capacity;
+
+  if (capacity > SIZE_MAX / sizeof(direntry)) {
+    PyErr_NoMemory();
+    return -1;
+  }
+  self->table = PyMem_Malloc(capacity * sizeof(direntry));
+  if (self->table == NULL) {
+    self->table = old;
+    PyErr_NoMemory();
+    return -1;
+  }
+  memset(self->table, 0, capacity * sizeof(direntry));
+  self->capacity = capacity;
+  for (e = old; e < old + oldcapacity; e++)
+    if (e->path)
+      *_lookup(self, e->path, e->len, e->hash) = *e;
+  PyMem_Free(old);
+  return 0;
+}
+
+/* Keep the table at most 3/4 full, including an entry about to be added. */
+static inline int _reserve(dirsObject* self) {
+  if ((self->count + 1) * 4 <= self->capacity * 3)
+    return 0;
+  return _resize(self, self->capacity ? self->capacity * 2 : 64);
+}
+
+static void _remove(dirsObject* self, direntry* e) {
+  size_t mask = self->capacity - 1;
+  size_t i = e - self->table, j = i;
+
+  Py_DECREF(e->owner);
+  /* shift back the entries that would be unreachable from their slot */
+  for (;;) {
+    size_t k;
+    j = (j + 1) & mask;
+    if (self->table[j].path == NULL)
+      break;
+    k = self->table[j].hash & mask;
+    if ((j > i && (k <= i || k > j)) || (j < i && k <= i && k > j)) {
+      self->table[i] = self->table[j];
+      i = j;
+    }
+  }
+  self->table[i].path = NULL;
+  self->table[i].owner = NULL;
+  self->count--;
+}
+
 static inline Py_ssize_t _finddir(const char* path, Py_ssize_t pos) {
   while (pos != -1) {
     if (path[pos] == '/')
@@ -54,107 +144,65 @@ static inline Py_ssize_t _finddir(const char* path, Py_ssize_t pos) {
   return pos;
 }
 
-static int _addpath(PyObject* dirs, PyObject* path) {
-  const char* cpath = PyBytes_AS_STRING(path);
-  Py_ssize_t pos = PyBytes_GET_SIZE(path);
-  PyObject* key = NULL;
-  int ret = -1;
-
-  /* This loop is super critical for performance. That's why we inline
-   * access to Python structs instead of going through a supported API.
-   * The implementation, therefore, is heavily dependent on CPython
-   * implementation details. We also commit violations of the Python
-   * "protocol" such as mutating immutable objects. But since we only
-   * mutate objects created in this function or in other well-defined
-   * locations, the references are known so these violations should go
-   * unnoticed. The code for adjusting the length of a PyBytesObject is
-   * essentially a minimal version of _PyBytes_Resize. */
-  while ((pos = _finddir(cpath, pos - 1)) != -1) {
-    PyObject* val;
-
-    /* It's likely that every prefix already has an entry
-       in our dict. Try to avoid allocating and
-       deallocating a string for each prefix we check. */
-    if (key != NULL)
-      ((PyBytesObject*)key)->ob_shash = -1;
-    else {
-      /* Force Python to not reuse a small shared string. */
-      key = PyBytes_FromStringAndSize(cpath, pos < 2 ? 2 : pos);
-      if (key == NULL)
-        goto bail;
-    }
-    /* Py_SIZE(o) refers to the ob_size member of the struct. Yes,
-     * assigning to what looks like a function seems wrong. */
-    Py_SIZE(key) = pos;
-    ((PyBytesObject*)key)->ob_sval[pos] = '\0';
-
-    val = PyDict_GetItem(dirs, key);
-    if (val != NULL) {
-      PYLONG_VALUE(val) += 1;
+/*
+ * Add the directories of the path of the given length, which owner
+ * keeps alive.
+ */
+static int
+_addpath(dirsObject* self, PyObject* owner, const char* path, Py_ssize_t len) {
+  Py_ssize_t pos = len;
+
+  /* The directories are added from the deepest one, stopping at the
+   * first one that was already there: it's likely that every prefix
+   * already has an entry. */
+  do {
+    direntry* e;
+    size_t hash;
+
+    pos = _finddir(path, pos - 1);
+    hash = _hashdir(path, pos);
+    if (_reserve(self) == -1)
+      return -1;
+    e = _lookup(self, path, pos, hash);
+    if (e->path) {
+      e->count += 1;
       break;
     }
+    e->path = path;
+    e->len = pos;
+    /* an extra count keeps the root */
+    e->count = pos ? 1 : 2;
+    e->owner = owner;
+    e->hash = hash;
+    Py_INCREF(owner);
+    self->count++;
+  } while (pos > 0);
 
-    /* Force Python to not reuse a small shared int. */
-#ifdef IS_PY3K
-    val = PyLong_FromLong(0x1eadbeef);
-#else
-    val = PyInt_FromLong(0x1eadbeef);
-#endif
-
-    if (val == NULL)
-      goto bail;
-
-    PYLONG_VALUE(val) = 1;
-    ret = PyDict_SetItem(dirs, key, val);
-    Py_DECREF(val);
-    if (ret == -1)
-      goto bail;
-    Py_CLEAR(key);
-  }
-  ret = 0;
-
-bail:
-  Py_XDECREF(key);
-
-  return ret;
+  return 0;
 }
 
-static int _delpath(PyObject* dirs, PyObject* path) {
-  char* cpath = PyBytes_AS_STRING(path);
-  Py_ssize_t pos = PyBytes_GET_SIZE(path);
-  PyObject* key = NULL;
-  int ret = -1;
-
-  while ((pos = _finddir(cpath, pos - 1)) != -1) {
-    PyObject* val;
+static int _delpath(dirsObject* self, const char* path, Py_ssize_t len) {
+  Py_ssize_t pos = len;
 
-    key = PyBytes_FromStringAndSize(cpath, pos);
+  do {
+    direntry* e = NULL;
 
-    if (key == NULL)
-      goto bail;
-
-    val = PyDict_GetItem(dirs, key);
-    if (val == NULL) {
+    pos = _finddir(path, pos - 1);
+    if (self->capacity)
+      e = _lookup(self, path, pos, _hashdir(path, pos));
+    if (e == NULL || e->path == NULL) {
       PyErr_SetString(PyExc_ValueError, "expected a value, found none");
-      goto bail;
+      return -1;
     }
-
-    if (--PYLONG_VALUE(val) <= 0) {
-      if (PyDict_DelItem(dirs, key) == -1)
-        goto bail;
-    } else
+    if (--e->count > 0)
       break;
-    Py_CLEAR(key);
-  }
-  ret = 0;
-
-bail:
-  Py_XDECREF(key);
+    _remove(self, e);
+  } while (pos > 0);
 
-  return ret;
+  return 0;
 }
 
-static int dirs_fromdict(PyObject* dirs, PyObject* source, char skipchar) {
+static int dirs_fromdict(dirsObject* dirs, PyObject* source, char skipchar) {
   PyObject *key, *value;
   Py_ssize_t pos = 0;
 
@@ -172,14 +220,15 @@ static int dirs_fromdict(PyObject* dirs, PyObject* source, char skipchar) {
         continue;
     }
 
-    if (_addpath(dirs, key) == -1)
+    if (_addpath(
+            dirs, key, PyBytes_AS_STRING(key), PyBytes_GET_SIZE(key)) == -1)
       return -1;
   }
 
   return 0;
 }
 
-static int dirs_fromiter(PyObject* dirs, PyObject* source) {
+static int dirs_fromiter(dirsObject* dirs, PyObject* source) {
   PyObject *iter, *item = NULL;
   int ret;
 
@@ -193,7 +242,9 @@ static int dirs_fromiter(PyObject* dirs, PyObject* source) {
       break;
     }
 
-    if (_addpath(dirs, item) == -1)
+    if (_addpath(
+            dirs, item, PyBytes_AS_STRING(item), PyBytes_GET_SIZE(item)) ==
+        -1)
       break;
     Py_CLEAR(item);
   }
@@ -204,41 +255,70 @@ static int dirs_fromiter(PyObject* dirs, PyObject* source) {
   return ret;
 }
 
+/*
+ * Add the files of a flat manifest text, of "path\0node flags\n" lines,
+ * without creating a Python string for any of them.
+ */
+static int dirs_fromtext(dirsObject* dirs, PyObject* text) {
+  const char* data = PyBytes_AS_STRING(text);
+  const char* end = data + PyBytes_GET_SIZE(text);
+
+  while (data < end) {
+    const char* nul = memchr(data, '\0', end - data);
+    const char* next = nul ? memchr(nul, '\n', end - nul) : NULL;
+
+    if (next == NULL) {
+      PyErr_SetString(PyExc_ValueError, "manifest lines must end with \\n");
+      return -1;
+    }
+    if (_addpath(dirs, text, data, nul - data) == -1)
+      return -1;
+    data = next + 1;
+  }
+
+  return 0;
+}
+
+static void dirs_clear(dirsObject* self) {
+  direntry* e;
+
+  for (e = self->table; e < self->table + self->capacity; e++)
+    Py_XDECREF(e->owner);
+  PyMem_Free(self->table);
+  self->table = NULL;
+  self->capacity = self->count = 0;
+}
+
 /*
  * Calculate a refcounted set of directory names for the files in a
- * dirstate.
+ * dirstate, an iterable of paths, or a flat manifest text.
  */
 static int dirs_init(dirsObject* self, PyObject* args) {
-  PyObject *dirs = NULL, *source = NULL;
+  PyObject* source = NULL;
   char skipchar = 0;
   int ret = -1;
 
-  self->dict = NULL;
+  dirs_clear(self);
 
   if (!PyArg_ParseTuple(args, "|Oc:__init__", &source, &skipchar))
     return -1;
 
-  dirs = PyDict_New();
-
-  if (dirs == NULL)
-    return -1;
-
   if (source == NULL)
     ret = 0;
   else if (PyDict_Check(source))
-    ret = dirs_fromdict(dirs, source, skipchar);
+    ret = dirs_fromdict(self, source, skipchar);
   else if (skipchar)
     PyErr_SetString(
         PyExc_ValueError,
         "skip character is only supported "
         "with a dict source");
+  else if (PyBytes_Check(source))
+    ret = dirs_fromtext(self, source);
   else
-    ret = dirs_fromiter(dirs, source);
+    ret = dirs_fromiter(self, source);
 
   if (ret == -1)
-    Py_XDECREF(dirs);
-  else
-    self->dict = dirs;
+    dirs_clear(self);
 
   return ret;
 }
@@ -249,7 +329,8 @@ PyObject* dirs_addpath(dirsObject* self, PyObject* args) {
   if (!PyArg_ParseTuple(args, "O!:addpath", &PyBytes_Type, &path))
     return NULL;
 
-  if (_addpath(self->dict, path) == -1)
+  if (_addpath(self, path, PyBytes_AS_STRING(path), PyBytes_GET_SIZE(path)) ==
+      -1)
     return NULL;
 
   Py_RETURN_NONE;
@@ -261,23 +342,50 @@ static PyObject* dirs_delpath(dirsObject* self, PyObject* args) {
   if (!PyArg_ParseTuple(args, "O!:delpath", &PyBytes_Type, &path))
     return NULL;
 
-  if (_delpath(self->dict, path) == -1)
+  if (_delpath(self, PyBytes_AS_STRING(path), PyBytes_GET_SIZE(path)) == -1)
     return NULL;
 
   Py_RETURN_NONE;
 }
 
 static int dirs_contains(dirsObject* self, PyObject* value) {
-  return PyBytes_Check(value) ? PyDict_Contains(self->dict, value) : 0;
+  const char* path;
+  Py_ssize_t len;
+
+  if (!PyBytes_Check(value) || self->count == 0)
+    return 0;
+  path = PyBytes_AS_STRING(value);
+  len = PyBytes_GET_SIZE(value);
+  return _lookup(self, path, len, _hashdir(path, len))->path != NULL;
 }
 
 static void dirs_dealloc(dirsObject* self) {
-  Py_XDECREF(self->dict);
+  dirs_clear(self);
   PyObject_Del(self);
 }
 
 static PyObject* dirs_iter(dirsObject* self) {
-  return PyObject_GetIter(self->dict);
+  PyObject *list, *iter;
+  direntry* e;
+  Py_ssize_t i = 0;
+
+  list = PyList_New(self->count);
+  if (list == NULL)
+    return NULL;
+  for (e = self->table; e < self->table + self->capacity; e++) {
+    PyObject* name;
+    if (e->path == NULL)
+      continue;
+    name = PyBytes_FromStringAndSize(e->path, e->len);
+    if (name == NULL) {
+      Py_DECREF(list);
+      return NULL;
+    }
+    PyList_SET_ITEM(list, i++, name);
+  }
+  iter = PyObject_GetIter(list);
+  Py_DECREF(list);
+  return iter;
 }
 
 static PySequenceMethods dirs_sequence_methods;
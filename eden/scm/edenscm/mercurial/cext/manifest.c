@@ -209,6 +209,7 @@ static void lazymanifest_dealloc(lazymanifest* self) {
 typedef struct {
   PyObject_HEAD lazymanifest* m;
   Py_ssize_t pos;
+  Py_ssize_t end; /* index of the line after the last one to iterate */
 } lmIter;
 
 static void lmiter_dealloc(PyObject* o) {
@@ -220,7 +221,7 @@ static void lmiter_dealloc(PyObject* o) {
 static line* lmiter_nextline(lmIter* self) {
   do {
     self->pos++;
-    if (self->pos >= self->m->numlines) {
+    if (self->pos >= self->end) {
       return NULL;
     }
     /* skip over deleted manifest entries */
@@ -351,18 +352,48 @@ static PyTypeObject lazymanifestKeysIterator = {
 };
 
 static lazymanifest* lazymanifest_copy(lazymanifest* self);
+static void prefixrange(
+    lazymanifest* self,
+    const char* prefix,
+    size_t plen,
+    int* lo,
+    int* hi);
 
-static PyObject* lazymanifest_getentriesiter(lazymanifest* self) {
+/*
+ * Iterate over the lines of a copy of self, or only over the ones under the
+ * directory dir if it isn't NULL.
+ */
+static PyObject* newiter(
+    lazymanifest* self,
+    PyTypeObject* type,
+    const char* dir,
+    Py_ssize_t dirlen) {
   lmIter* i = NULL;
   lazymanifest* t = lazymanifest_copy(self);
   if (!t) {
     PyErr_NoMemory();
     return NULL;
   }
-  i = PyObject_New(lmIter, &lazymanifestEntriesIterator);
+  i = PyObject_New(lmIter, type);
   if (i) {
     i->m = t;
     i->pos = -1;
+    i->end = t->numlines;
+    if (dir && dirlen > 0) {
+      int lo, hi;
+      char* prefix = malloc(dirlen + 2);
+      if (!prefix) {
+        Py_DECREF(i);
+        return PyErr_NoMemory();
+      }
+      memcpy(prefix, dir, dirlen);
+      prefix[dirlen] = '/';
+      prefix[dirlen + 1] = '\0';
+      prefixrange(t, prefix, dirlen + 1, &lo, &hi);
+      free(prefix);
+      i->pos = lo - 1;
+      i->end = hi;
+    }
   } else {
     Py_DECREF(t);
     PyErr_NoMemory();
@@ -370,22 +401,55 @@ static PyObject* lazymanifest_getentriesiter(lazymanifest* self) {
   return (PyObject*)i;
 }
 
-static PyObject* lazymanifest_getkeysiter(lazymanifest* self) {
-  lmIter* i = NULL;
-  lazymanifest* t = lazymanifest_copy(self);
-  if (!t) {
-    PyErr_NoMemory();
+/* Parse the optional directory argument of the iteration methods. */
+static int parsedir(PyObject* args, const char** dir, Py_ssize_t* dirlen) {
+  PyObject* pydir = NULL;
+  *dir = NULL;
+  *dirlen = 0;
+  if (!PyArg_ParseTuple(args, "|O", &pydir)) {
+    return -1;
+  }
+  if (!pydir || pydir == Py_None) {
+    return 0;
+  }
+#ifdef IS_PY3K
+  if (!PyUnicode_Check(pydir)) {
+    PyErr_Format(PyExc_TypeError, "directory must be a str.");
+    return -1;
+  }
+  *dir = PyUnicode_AsUTF8AndSize(pydir, dirlen);
+  return *dir ? 0 : -1;
+#else
+  if (!PyBytes_Check(pydir)) {
+    PyErr_Format(PyExc_TypeError, "directory must be a string.");
+    return -1;
+  }
+  return PyBytes_AsStringAndSize(pydir, (char**)dir, dirlen);
+#endif
+}
+
+static PyObject* lazymanifest_getentriesiter(
+    lazymanifest* self,
+    PyObject* args) {
+  const char* dir;
+  Py_ssize_t dirlen;
+  if (parsedir(args, &dir, &dirlen) != 0) {
     return NULL;
   }
-  i = PyObject_New(lmIter, &lazymanifestKeysIterator);
-  if (i) {
-    i->m = t;
-    i->pos = -1;
-  } else {
-    Py_DECREF(t);
-    PyErr_NoMemory();
+  return newiter(self, &lazymanifestEntriesIterator, dir, dirlen);
+}
+
+static PyObject* lazymanifest_getkeysiter(lazymanifest* self, PyObject* args) {
+  const char* dir;
+  Py_ssize_t dirlen;
+  if (parsedir(args, &dir, &dirlen) != 0) {
+    return NULL;
   }
-  return (PyObject*)i;
+  return newiter(self, &lazymanifestKeysIterator, dir, dirlen);
+}
+
+static PyObject* lazymanifest_iter(lazymanifest* self) {
+  return newiter(self, &lazymanifestKeysIterator, NULL, 0);
 }
 
 /* __getitem__ and __setitem__ support */
@@ -398,6 +462,38 @@ static int linecmp(const void* left, const void* right) {
   return strcmp(((const line*)left)->start, ((const line*)right)->start);
 }
 
+/*
+ * Find the lines whose path starts with prefix, deleted or not, as the
+ * half-open range [*lo, *hi) of self->lines: since lines are sorted, they are
+ * contiguous. Two binary searches, so that looking at a subtree never
+ * requires a scan of the whole manifest.
+ */
+static void prefixrange(
+    lazymanifest* self,
+    const char* prefix,
+    size_t plen,
+    int* lo,
+    int* hi) {
+  int start = 0, end = self->numlines;
+  while (start < end) {
+    int pos = start + (end - start) / 2;
+    if (strcmp(self->lines[pos].start, prefix) < 0)
+      start = pos + 1;
+    else
+      end = pos;
+  }
+  *lo = start;
+  end = self->numlines;
+  while (start < end) {
+    int pos = start + (end - start) / 2;
+    if (strncmp(self->lines[pos].start, prefix, plen) <= 0)
+      start = pos + 1;
+    else
+      end = pos;
+  }
+  *hi = start;
+}
+
 static PyObject* lazymanifest_getitem(lazymanifest* self, PyObject* key) {
   line needle;
   line* hit;
@@ -487,8 +583,9 @@ finish:
   return 0;
 }
 
-static int
-lazymanifest_setitem(lazymanifest* self, PyObject* key, PyObject* value) {
+/* Build the line of the manifest mapping key to value, a (node, flags)
+ * tuple, in a buffer owned by new. */
+static int makeline(PyObject* key, PyObject* value, line* new) {
   const char* path;
   Py_ssize_t plen;
   PyObject* pyhash;
@@ -500,7 +597,6 @@ lazymanifest_setitem(lazymanifest* self, PyObject* key, PyObject* value) {
   size_t dlen;
   char* dest;
   int i;
-  line new;
 #ifdef IS_PY3K
   if (!PyUnicode_Check(key)) {
     PyErr_Format(PyExc_TypeError, "setitem: manifest keys must be a str.");
@@ -512,9 +608,6 @@ lazymanifest_setitem(lazymanifest* self, PyObject* key, PyObject* value) {
     return -1;
   }
 #endif
-  if (!value) {
-    return lazymanifest_delitem(self, key);
-  }
   if (!PyTuple_Check(value) || PyTuple_Size(value) != 2) {
     PyErr_Format(
         PyExc_TypeError, "Manifest values must be a tuple of (node, flags).");
@@ -581,15 +674,28 @@ lazymanifest_setitem(lazymanifest* self, PyObject* key, PyObject* value) {
   }
   memcpy(dest + plen + 41, flags, flen);
   dest[plen + 41 + flen] = '\n';
-  new.start = dest;
-  new.len = dlen;
-  new.hash_suffix = '\0';
+  new->start = dest;
+  new->len = dlen;
+  new->hash_suffix = '\0';
   if (hlen > 20) {
-    new.hash_suffix = hash[20];
+    new->hash_suffix = hash[20];
+  }
+  new->from_malloc = true; /* is `start` a pointer we allocated? */
+  new->deleted = false; /* is this entry deleted? */
+  return 0;
+}
+
+static int
+lazymanifest_setitem(lazymanifest* self, PyObject* key, PyObject* value) {
+  line new;
+  if (!value) {
+    return lazymanifest_delitem(self, key);
+  }
+  if (makeline(key, value, &new) != 0) {
+    return -1;
   }
-  new.from_malloc = true; /* is `start` a pointer we allocated? */
-  new.deleted = false; /* is this entry deleted? */
   if (internalsetitem(self, &new)) {
+    free((void*)new.start);
     return -1;
   }
   return 0;
@@ -834,6 +940,14 @@ static PyObject* lazymanifest_diff(lazymanifest* self, PyObject* args) {
       result = 1;
     } else if (oneedle == other->numlines) {
       result = -1;
+    } else if (left->start == right->start) {
+      /* lines of a copy that weren't set since point to the same text */
+      if (!listclean && left->hash_suffix == right->hash_suffix) {
+        sneedle++;
+        oneedle++;
+        continue;
+      }
+      result = 0;
     } else {
       result = linecmp(left, right);
     }
@@ -874,9 +988,10 @@ static PyObject* lazymanifest_diff(lazymanifest* self, PyObject* args) {
       oneedle++;
     } else {
       /* file exists in both manifests */
-      if (left->len != right->len ||
-          memcmp(left->start, right->start, left->len) ||
-          left->hash_suffix != right->hash_suffix) {
+      if (left->hash_suffix != right->hash_suffix ||
+          (left->start != right->start &&
+           (left->len != right->len ||
+            memcmp(left->start, right->start, left->len)))) {
         PyObject* l = hashflags(left);
         PyObject* r;
         if (!l) {
@@ -912,19 +1027,331 @@ nomem:
   return NULL;
 }
 
+/* Return whether there's at least one file under the directory dir. */
+static PyObject* lazymanifest_hasdir(lazymanifest* self, PyObject* pydir) {
+  const char* dir;
+  Py_ssize_t dirlen;
+  char* prefix;
+  int lo, hi, i;
+#ifdef IS_PY3K
+  if (!PyUnicode_Check(pydir)) {
+    PyErr_Format(PyExc_TypeError, "hasdir: directory must be a str.");
+    return NULL;
+  }
+  dir = PyUnicode_AsUTF8AndSize(pydir, &dirlen);
+  if (!dir) {
+    return NULL;
+  }
+#else
+  if (!PyBytes_Check(pydir)) {
+    PyErr_Format(PyExc_TypeError, "hasdir: directory must be a string.");
+    return NULL;
+  }
+  if (PyBytes_AsStringAndSize(pydir, (char**)&dir, &dirlen) == -1) {
+    return NULL;
+  }
+#endif
+  /* the root directory has everything */
+  if (dirlen == 0) {
+    return PyBool_FromLong(self->livelines > 0);
+  }
+  prefix = malloc(dirlen + 2);
+  if (!prefix) {
+    return PyErr_NoMemory();
+  }
+  memcpy(prefix, dir, dirlen);
+  prefix[dirlen] = '/';
+  prefix[dirlen + 1] = '\0';
+  prefixrange(self, prefix, dirlen + 1, &lo, &hi);
+  free(prefix);
+  for (i = lo; i < hi; i++) {
+    if (!self->lines[i].deleted) {
+      Py_RETURN_TRUE;
+    }
+  }
+  Py_RETURN_FALSE;
+}
+
+typedef struct {
+  int lo;
+  int hi;
+} linerange;
+
+static int rangecmp(const void* left, const void* right) {
+  int l = ((const linerange*)left)->lo, r = ((const linerange*)right)->lo;
+  return l < r ? -1 : l > r;
+}
+
+/*
+ * Make a copy of this manifest with only the files in the given directories
+ * or named like them. This is filtercopy for a matcher of path prefixes,
+ * without calling back into Python for each of the files.
+ */
+static lazymanifest* lazymanifest_subtreecopy(
+    lazymanifest* self,
+    PyObject* dirs) {
+  lazymanifest* copy = NULL;
+  PyObject* seq = NULL;
+  linerange* ranges = NULL;
+  Py_ssize_t ndirs, i;
+  int nranges = 0, covered = 0, j;
+  seq = PySequence_Fast(dirs, "dirs must be a sequence");
+  if (!seq) {
+    return NULL;
+  }
+  /* as in filtercopy, the copy shares our lines, none from malloc */
+  if (compact(self) != 0) {
+    goto nomem;
+  }
+  ndirs = PySequence_Fast_GET_SIZE(seq);
+  ranges = malloc((2 * ndirs + 1) * sizeof(linerange));
+  if (!ranges) {
+    goto nomem;
+  }
+  for (i = 0; i < ndirs; i++) {
+    PyObject* pydir = PySequence_Fast_GET_ITEM(seq, i);
+    const char* dir;
+    Py_ssize_t dirlen;
+    char* prefix;
+    line needle;
+    line* hit;
+#ifdef IS_PY3K
+    if (!PyUnicode_Check(pydir)) {
+      PyErr_Format(PyExc_TypeError, "subtreecopy: dirs must be str.");
+      goto bail;
+    }
+    dir = PyUnicode_AsUTF8AndSize(pydir, &dirlen);
+    if (!dir) {
+      goto bail;
+    }
+#else
+    if (!PyBytes_Check(pydir)) {
+      PyErr_Format(PyExc_TypeError, "subtreecopy: dirs must be strings.");
+      goto bail;
+    }
+    if (PyBytes_AsStringAndSize(pydir, (char**)&dir, &dirlen) == -1) {
+      goto bail;
+    }
+#endif
+    if (dirlen == 0) {
+      free(ranges);
+      Py_DECREF(seq);
+      return lazymanifest_copy(self);
+    }
+    /* "dir" sorts before "dir-x", which sorts before "dir/x" */
+    needle.start = dir;
+    hit = bsearch(&needle, self->lines, self->numlines, sizeof(line), &linecmp);
+    if (hit) {
+      ranges[nranges].lo = hit - self->lines;
+      ranges[nranges].hi = ranges[nranges].lo + 1;
+      nranges++;
+    }
+    prefix = malloc(dirlen + 2);
+    if (!prefix) {
+      goto nomem;
+    }
+    memcpy(prefix, dir, dirlen);
+    prefix[dirlen] = '/';
+    prefix[dirlen + 1] = '\0';
+    prefixrange(
+        self, prefix, dirlen + 1, &ranges[nranges].lo, &ranges[nranges].hi);
+    free(prefix);
+    nranges++;
+  }
+  /* nested directories give nested ranges, copied once */
+  qsort(ranges, nranges, sizeof(linerange), &rangecmp);
+  copy = PyObject_New(lazymanifest, &lazymanifestType);
+  if (!copy) {
+    goto nomem;
+  }
+  copy->dirty = true;
+  copy->lines = malloc(self->maxlines * sizeof(line));
+  if (!copy->lines) {
+    goto nomem;
+  }
+  copy->maxlines = self->maxlines;
+  copy->numlines = 0;
+  copy->pydata = self->pydata;
+  Py_INCREF(self->pydata);
+  for (j = 0; j < nranges; j++) {
+    int l = ranges[j].lo > covered ? ranges[j].lo : covered;
+    if (l < ranges[j].hi) {
+      memcpy(
+          copy->lines + copy->numlines,
+          self->lines + l,
+          (ranges[j].hi - l) * sizeof(line));
+      copy->numlines += ranges[j].hi - l;
+      covered = ranges[j].hi;
+    }
+  }
+  copy->livelines = copy->numlines;
+  free(ranges);
+  Py_DECREF(seq);
+  return copy;
+nomem:
+  PyErr_NoMemory();
+bail:
+  free(ranges);
+  Py_XDECREF(seq);
+  Py_XDECREF(copy);
+  return NULL;
+}
+
+typedef struct {
+  line l;
+  Py_ssize_t seq; /* position in the batch, the last one wins */
+} pendingline;
+
+static int pendingcmp(const void* left, const void* right) {
+  const pendingline* l = left;
+  const pendingline* r = right;
+  int c = strcmp(l->l.start, r->l.start);
+  if (c) {
+    return c;
+  }
+  return l->seq < r->seq ? -1 : l->seq > r->seq;
+}
+
+/*
+ * Add the new lines of a batch, in no particular order, to self: sort them
+ * once, drop all but the last of each path, then merge them in from the end
+ * of the line array, moving each existing line at most once.
+ */
+static int mergepending(lazymanifest* self, pendingline* pending, int n) {
+  int i, j, k, kept = 0;
+  if (n == 0) {
+    return 0;
+  }
+  qsort(pending, n, sizeof(pendingline), &pendingcmp);
+  for (i = 0; i < n; i++) {
+    if (i + 1 < n && strcmp(pending[i].l.start, pending[i + 1].l.start) == 0) {
+      free((void*)pending[i].l.start);
+    } else {
+      pending[kept++] = pending[i];
+    }
+  }
+  if (self->numlines + kept > self->maxlines) {
+    int maxlines = self->maxlines * 2;
+    line* lines;
+    if (maxlines < self->numlines + kept) {
+      maxlines = self->numlines + kept;
+    }
+    lines = realloc(self->lines, maxlines * sizeof(line));
+    if (!lines) {
+      for (i = 0; i < kept; i++) {
+        free((void*)pending[i].l.start);
+      }
+      PyErr_NoMemory();
+      return -1;
+    }
+    self->lines = lines;
+    self->maxlines = maxlines;
+  }
+  i = self->numlines - 1;
+  j = kept - 1;
+  k = self->numlines + kept - 1;
+  while (j >= 0) {
+    if (i >= 0 && linecmp(self->lines + i, &pending[j].l) > 0) {
+      self->lines[k--] = self->lines[i--];
+    } else {
+      self->lines[k--] = pending[j--].l;
+    }
+  }
+  self->numlines += kept;
+  self->livelines += kept;
+  self->dirty = true;
+  return 0;
+}
+
+/*
+ * Set every (path, (node, flags)) pair of an iterable, as a loop over
+ * __setitem__ would, but with a single sort and a single pass over the lines
+ * for the paths that aren't in the manifest yet, instead of one memmove each.
+ */
+static PyObject* lazymanifest_setitems(lazymanifest* self, PyObject* items) {
+  PyObject *iter, *item;
+  pendingline* pending = NULL;
+  int npending = 0, maxpending = 0;
+  Py_ssize_t seq = 0;
+  bool failed = false;
+  iter = PyObject_GetIter(items);
+  if (!iter) {
+    return NULL;
+  }
+  while (!failed && (item = PyIter_Next(iter))) {
+    line new;
+    line* hit;
+    if (!PyTuple_Check(item) || PyTuple_Size(item) != 2) {
+      PyErr_Format(
+          PyExc_TypeError, "setitems: items must be (path, (node, flags)).");
+      failed = true;
+    } else if (
+        makeline(PyTuple_GET_ITEM(item, 0), PyTuple_GET_ITEM(item, 1), &new)) {
+      failed = true;
+    } else if (
+        (hit = bsearch(
+             &new, self->lines, self->numlines, sizeof(line), &linecmp))) {
+      /* replaced in place, nothing moves */
+      if (internalsetitem(self, &new)) {
+        free((void*)new.start);
+        failed = true;
+      }
+    } else {
+      if (npending == maxpending) {
+        pendingline* grown;
+        maxpending = maxpending ? maxpending * 2 : 64;
+        grown = realloc(pending, maxpending * sizeof(pendingline));
+        if (!grown) {
+          free((void*)new.start);
+          PyErr_NoMemory();
+          failed = true;
+          Py_DECREF(item);
+          break;
+        }
+        pending = grown;
+      }
+      pending[npending].l = new;
+      pending[npending].seq = seq;
+      npending++;
+    }
+    seq++;
+    Py_DECREF(item);
+  }
+  Py_DECREF(iter);
+  if (PyErr_Occurred()) {
+    failed = true;
+  }
+  /* what was set before an error stays set, as with __setitem__ */
+  if (failed) {
+    PyObject *type, *value, *traceback;
+    PyErr_Fetch(&type, &value, &traceback);
+    mergepending(self, pending, npending);
+    PyErr_Restore(type, value, traceback);
+    free(pending);
+    return NULL;
+  }
+  if (mergepending(self, pending, npending) != 0) {
+    free(pending);
+    return NULL;
+  }
+  free(pending);
+  Py_RETURN_NONE;
+}
+
 static PyMethodDef lazymanifest_methods[] = {
     {"keys",
      (PyCFunction)lazymanifest_getkeysiter,
-     METH_NOARGS,
-     "Iterate over file names in this lazymanifest."},
+     METH_VARARGS,
+     "Iterate over file names in this lazymanifest, or in a directory."},
     {"iterkeys",
      (PyCFunction)lazymanifest_getkeysiter,
-     METH_NOARGS,
-     "Iterate over file names in this lazymanifest."},
+     METH_VARARGS,
+     "Iterate over file names in this lazymanifest, or in a directory."},
     {"iterentries",
      (PyCFunction)lazymanifest_getentriesiter,
-     METH_NOARGS,
-     "Iterate over (path, nodeid, flags) tuples in this lazymanifest."},
+     METH_VARARGS,
+     "Iterate over (path, nodeid, flags) tuples in this lazymanifest, or in a "
+     "directory."},
     {"copy",
      (PyCFunction)lazymanifest_copy,
      METH_NOARGS,
@@ -933,6 +1360,18 @@ static PyMethodDef lazymanifest_methods[] = {
      (PyCFunction)lazymanifest_filtercopy,
      METH_O,
      "Make a copy of this manifest filtered by matchfn."},
+    {"subtreecopy",
+     (PyCFunction)lazymanifest_subtreecopy,
+     METH_O,
+     "Make a copy of this manifest with only the given directories."},
+    {"hasdir",
+     (PyCFunction)lazymanifest_hasdir,
+     METH_O,
+     "Return whether a directory has files in this lazymanifest."},
+    {"setitems",
+     (PyCFunction)lazymanifest_setitems,
+     METH_O,
+     "Set many (path, (node, flags)) items at once."},
     {"diff",
      (PyCFunction)lazymanifest_diff,
      METH_VARARGS,
@@ -976,7 +1415,7 @@ static PyTypeObject lazymanifestType = {
     0, /* tp_clear */
     0, /* tp_richcompare */
     0, /* tp_weaklistoffset */
-    (getiterfunc)lazymanifest_getkeysiter, /* tp_iter */
+    (getiterfunc)lazymanifest_iter, /* tp_iter */
     0, /* tp_iternext */
     lazymanifest_methods, /* tp_methods */
     0, /* tp_members */
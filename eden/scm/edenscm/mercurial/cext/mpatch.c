@@ -33,6 +33,7 @@
 #include <string.h>
 
 #include "eden/scm/edenscm/mercurial/bitmanipulation.h"
+#include "eden/scm/edenscm/mercurial/cext/threadpool.h"
 #include "eden/scm/edenscm/mercurial/cext/util.h"
 #include "eden/scm/edenscm/mercurial/compat.h"
 #include "eden/scm/edenscm/mercurial/mpatch.h"
@@ -124,6 +125,172 @@ cleanup:
   return result;
 }
 
+/* A text and the patches to apply to it, with references to all of them. */
+struct patchjob {
+  PyObject* text;
+  const char* in;
+  Py_ssize_t inlen;
+  PyObject** bins;
+  const char** bufs;
+  Py_ssize_t* lens;
+  Py_ssize_t nbins;
+  char* out;
+  Py_ssize_t outlen;
+  int err; /* an MPATCH_ERR_*, or 0 */
+};
+
+static struct mpatch_flist* cgetitem(void* ctx, ssize_t pos) {
+  struct patchjob* job = (struct patchjob*)ctx;
+  struct mpatch_flist* res;
+  int r;
+  if ((r = mpatch_decode(job->bufs[pos], job->lens[pos], &res)) < 0) {
+    job->err = r;
+    return NULL;
+  }
+  return res;
+}
+
+static void runpatchjob(void* ctx, Py_ssize_t i) {
+  struct patchjob* job = (struct patchjob*)ctx + i;
+  struct mpatch_flist* patch;
+  int r;
+
+  if (!job->nbins)
+    return;
+  patch = mpatch_fold(job, cgetitem, 0, job->nbins);
+  if (!patch) {
+    if (!job->err)
+      job->err = MPATCH_ERR_NO_MEM;
+    return;
+  }
+  job->outlen = mpatch_calcsize(job->inlen, patch);
+  if (job->outlen < 0) {
+    job->err = (int)job->outlen;
+  } else if (!(job->out = malloc(job->outlen ? job->outlen : 1))) {
+    job->err = MPATCH_ERR_NO_MEM;
+  } else if ((r = mpatch_apply(job->out, job->in, job->inlen, patch)) < 0) {
+    job->err = r;
+  }
+  mpatch_lfree(patch);
+}
+
+/* Take references to the text and patches of a (text, bins) chain. */
+static int loadpatchjob(struct patchjob* job, PyObject* chain) {
+  PyObject *bins, *seq;
+  Py_ssize_t i;
+
+  if (!PyTuple_Check(chain)) {
+    PyErr_SetString(PyExc_TypeError, "patchchains expects (text, bins) pairs");
+    return -1;
+  }
+  if (!PyArg_ParseTuple(chain, "OO:patchchains", &job->text, &bins))
+    return -1;
+  Py_INCREF(job->text);
+  if (PyObject_AsCharBuffer(job->text, &job->in, &job->inlen))
+    return -1;
+  seq = PySequence_Fast(bins, "patches must be a sequence");
+  if (!seq)
+    return -1;
+  job->nbins = PySequence_Fast_GET_SIZE(seq);
+  job->bins = calloc(job->nbins ? job->nbins : 1, sizeof(PyObject*));
+  job->bufs = malloc((job->nbins ? job->nbins : 1) * sizeof(const char*));
+  job->lens = malloc((job->nbins ? job->nbins : 1) * sizeof(Py_ssize_t));
+  if (!job->bins || !job->bufs || !job->lens) {
+    Py_DECREF(seq);
+    PyErr_NoMemory();
+    return -1;
+  }
+  for (i = 0; i < job->nbins; i++) {
+    job->bins[i] = PySequence_Fast_GET_ITEM(seq, i);
+    Py_INCREF(job->bins[i]);
+    if (PyObject_AsCharBuffer(job->bins[i], &job->bufs[i], &job->lens[i])) {
+      Py_DECREF(seq);
+      return -1;
+    }
+  }
+  Py_DECREF(seq);
+  return 0;
+}
+
+static void freepatchjob(struct patchjob* job) {
+  Py_ssize_t i;
+  Py_XDECREF(job->text);
+  if (job->bins) {
+    for (i = 0; i < job->nbins; i++)
+      Py_XDECREF(job->bins[i]);
+  }
+  free(job->bins);
+  free(job->bufs);
+  free(job->lens);
+  free(job->out);
+}
+
+/*
+ * Like patches for each of a sequence of (text, bins) chains, the chains
+ * being applied on up to the given number of threads without the GIL. The
+ * first chain that fails raises its error.
+ */
+static PyObject* patchchains(PyObject* self, PyObject* args) {
+  PyObject *chains, *seq, *result = NULL;
+  struct patchjob* jobs = NULL;
+  Py_ssize_t n, i;
+  int threads = 1;
+  PyThreadState* _save;
+
+  if (!PyArg_ParseTuple(args, "O|i:patchchains", &chains, &threads))
+    return NULL;
+  seq = PySequence_Fast(chains, "patchchains expects a sequence of chains");
+  if (!seq)
+    return NULL;
+  n = PySequence_Fast_GET_SIZE(seq);
+  jobs = calloc(n ? n : 1, sizeof(struct patchjob));
+  if (!jobs) {
+    PyErr_NoMemory();
+    goto cleanup;
+  }
+  for (i = 0; i < n; i++) {
+    if (loadpatchjob(jobs + i, PySequence_Fast_GET_ITEM(seq, i)) < 0)
+      goto cleanup;
+  }
+
+  _save = PyEval_SaveThread();
+  hg_run_jobs(runpatchjob, jobs, n, threads);
+  PyEval_RestoreThread(_save);
+
+  result = PyList_New(n);
+  if (!result)
+    goto cleanup;
+  for (i = 0; i < n; i++) {
+    PyObject* text;
+    if (jobs[i].err) {
+      Py_CLEAR(result);
+      setpyerr(jobs[i].err);
+      goto cleanup;
+    }
+    if (!jobs[i].nbins) {
+      /* nothing to do */
+      text = jobs[i].text;
+      Py_INCREF(text);
+    } else {
+      text = PyBytes_FromStringAndSize(jobs[i].out, jobs[i].outlen);
+      if (!text) {
+        Py_CLEAR(result);
+        goto cleanup;
+      }
+    }
+    PyList_SET_ITEM(result, i, text);
+  }
+
+cleanup:
+  if (jobs) {
+    for (i = 0; i < n; i++)
+      freepatchjob(jobs + i);
+  }
+  free(jobs);
+  Py_DECREF(seq);
+  return result;
+}
+
 /* calculate size of a patched file directly */
 static PyObject* patchedsize(PyObject* self, PyObject* args) {
   long orig, start, end, len, outlen = 0, last = 0, pos = 0;
@@ -157,6 +324,10 @@ static PyObject* patchedsize(PyObject* self, PyObject* args) {
 
 static PyMethodDef methods[] = {
     {"patches", patches, METH_VARARGS, "apply a series of patches\n"},
+    {"patchchains",
+     patchchains,
+     METH_VARARGS,
+     "apply many series of patches at once\n"},
     {"patchedsize", patchedsize, METH_VARARGS, "calculed patched size\n"},
     {NULL, NULL}};
 
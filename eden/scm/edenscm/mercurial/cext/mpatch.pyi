@@ -3,7 +3,10 @@
 # This software may be used and distributed according to the terms of the
 # GNU General Public License version 2.
 
-from typing import List
+from typing import List, Sequence, Tuple
 
 def patches(text: bytes, bins: List[bytes]) -> bytes: ...
+def patchchains(
+    chains: Sequence[Tuple[bytes, Sequence[bytes]]], threads: int = ...
+) -> List[bytes]: ...
 def patchedsize(orig: int, bin: bytes) -> int: ...
@@ -31,6 +31,14 @@
 
 #include "eden/scm/edenscm/mercurial/cext/util.h"
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define HAVE_SSE2 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
 /* state machine for the fast path */
 enum path_state {
   START, /* first byte of a path component */
@@ -78,12 +86,72 @@ static inline void memcopy(
     const void* src,
     Py_ssize_t len) {
   if (dest) {
-    assert(*destlen + len < destsize);
+    assert(*destlen + len <= destsize);
     memcpy((void*)&dest[*destlen], src, len);
   }
   *destlen += len;
 }
 
+#ifdef HAVE_SSE2
+static inline int lowestbit(int mask) {
+#ifdef _MSC_VER
+  unsigned long i;
+  _BitScanForward(&i, mask);
+  return (int)i;
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+/*
+ * Return the length of the run at the start of src of bytes that every
+ * encoding below copies through: printable ASCII, except uppercase
+ * letters and the bytes that are escaped or special in a path.
+ *
+ * This looks at 16 bytes at a time, and returns 0 for the last ones
+ * that don't fill a block, which the callers check a byte at a time.
+ */
+static inline Py_ssize_t saferun(const char* src, Py_ssize_t len) {
+  Py_ssize_t n = 0;
+#ifdef HAVE_SSE2
+  const __m128i first = _mm_set1_epi8('!'), last = _mm_set1_epi8('}');
+  const __m128i at = _mm_set1_epi8('@'), lbracket = _mm_set1_epi8('[');
+
+  for (; n + 16 <= len; n += 16) {
+    __m128i x = _mm_loadu_si128((const __m128i*)(src + n));
+    __m128i bad, c;
+    int mask;
+
+    /* bytes from 0x80 are negative, so below '!' */
+    bad = _mm_or_si128(_mm_cmplt_epi8(x, first), _mm_cmpgt_epi8(x, last));
+    c = _mm_and_si128(_mm_cmpgt_epi8(x, at), _mm_cmplt_epi8(x, lbracket));
+    bad = _mm_or_si128(bad, c);
+#define SPECIAL(ch) \
+  bad = _mm_or_si128(bad, _mm_cmpeq_epi8(x, _mm_set1_epi8(ch)))
+    SPECIAL('"');
+    SPECIAL('*');
+    SPECIAL('.');
+    SPECIAL('/');
+    SPECIAL(':');
+    SPECIAL('<');
+    SPECIAL('>');
+    SPECIAL('?');
+    SPECIAL('\\');
+    SPECIAL('_');
+    SPECIAL('|');
+#undef SPECIAL
+    mask = _mm_movemask_epi8(bad);
+    if (mask)
+      return n + lowestbit(mask);
+  }
+#else
+  (void)src;
+  (void)len;
+#endif
+  return n;
+}
+
 static inline void
 hexencode(char* dest, Py_ssize_t* destlen, size_t destsize, uint8_t c) {
   static const char hexdigit[] = "0123456789abcdef";
@@ -443,7 +511,14 @@ static Py_ssize_t _encode(
             break;
         }
         break;
-      case DEFAULT:
+      case DEFAULT: {
+        Py_ssize_t run = saferun(&src[i], len - i);
+        if (run) {
+          memcopy(dest, &destlen, destsize, &src[i], run);
+          i += run;
+          if (i == len)
+            goto done;
+        }
         while (inset(onebyte, src[i])) {
           charcopy(dest, &destlen, destsize, src[i++]);
           if (i == len)
@@ -477,6 +552,7 @@ static Py_ssize_t _encode(
             break;
         }
         break;
+      }
     }
   }
 done:
@@ -507,9 +583,16 @@ _lowerencode(char* dest, size_t destsize, const char* src, Py_ssize_t len) {
 
   static const uint32_t lower[8] = {0, 0, 0x7fffffe};
 
-  Py_ssize_t i, destlen = 0;
+  Py_ssize_t i, run, destlen = 0;
 
   for (i = 0; i < len; i++) {
+    run = saferun(&src[i], len - i);
+    if (run) {
+      memcopy(dest, &destlen, destsize, &src[i], run);
+      i += run;
+      if (i == len)
+        break;
+    }
     if (inset(onebyte, src[i]))
       charcopy(dest, &destlen, destsize, src[i]);
     else if (inset(lower, src[i]))
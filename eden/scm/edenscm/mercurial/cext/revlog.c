@@ -43,6 +43,11 @@
  * Positive value is index of the next node in the trie
  * Negative value is a leaf: -(rev + 1)
  * Zero is empty
+ *
+ * The trie can be saved to disk by appending the nodes returned by
+ * dumpnodetree to a file, and loaded back from it, usually mmapped, by
+ * loadnodetree. The loaded nodes are never written to: updating one copies
+ * it, and its ancestors, to the end of the trie.
  */
 typedef struct {
   int children[16];
@@ -77,6 +82,12 @@ typedef struct {
   int ntdepth; /* maximum depth of tree */
   int ntsplits; /* # splits performed */
   int ntrev; /* last rev scanned */
+  int ntroot; /* index of the root node */
+  size_t ntpersisted; /* # nodes in use from ntbuf */
+  Py_buffer ntbuf; /* nodes given to loadnodetree */
+  Py_ssize_t ntbufroot; /* root node in ntbuf */
+  Py_ssize_t ntbuftiprev; /* last rev mapped by ntbuf */
+  char ntbuftipnode[20]; /* node of ntbuftiprev */
   int ntlookups; /* # lookups */
   int ntmisses; /* # lookups that miss the cache */
   int inlined;
@@ -311,7 +322,7 @@ static PyObject* index_insert(indexObject* self, PyObject* args) {
   if (PyList_Append(self->added, obj) == -1)
     return NULL;
 
-  if (self->nt)
+  if (self->ntlength)
     nt_insert(self, node, index);
 
   Py_CLEAR(self->headrevs);
@@ -340,7 +351,7 @@ static void _index_clearcaches(indexObject* self) {
 
 static PyObject* index_clearcaches(indexObject* self) {
   _index_clearcaches(self);
-  self->ntlength = self->ntcapacity = 0;
+  self->ntlength = self->ntcapacity = self->ntpersisted = 0;
   self->ntdepth = self->ntsplits = 0;
   self->ntrev = -1;
   self->ntlookups = self->ntmisses = 0;
@@ -380,6 +391,7 @@ static PyObject* index_stats(indexObject* self) {
   istat(ntcapacity, "node trie capacity");
   istat(ntdepth, "node trie depth");
   istat(ntlength, "node trie count");
+  istat(ntpersisted, "node trie count loaded");
   istat(ntlookups, "node trie lookups");
   istat(ntmisses, "node trie misses");
   istat(ntrev, "node trie last rev scanned");
@@ -893,6 +905,12 @@ bail:
   return NULL;
 }
 
+static inline nodetree* nt_node(indexObject* self, size_t off) {
+  if (off < self->ntpersisted)
+    return (nodetree*)self->ntbuf.buf + off;
+  return &self->nt[off - self->ntpersisted];
+}
+
 static inline int nt_level(const char* node, Py_ssize_t level) {
   int v = node[level >> 1];
   if (!(level & 1))
@@ -915,7 +933,7 @@ nt_find(indexObject* self, const char* node, Py_ssize_t nodelen, int hex) {
   if (nodelen == 20 && node[0] == '\0' && memcmp(node, nullid, 20) == 0)
     return -1;
 
-  if (self->nt == NULL)
+  if (self->ntlength == 0)
     return -2;
 
   if (hex)
@@ -923,10 +941,9 @@ nt_find(indexObject* self, const char* node, Py_ssize_t nodelen, int hex) {
   else
     maxlevel = nodelen > 20 ? 40 : ((int)nodelen * 2);
 
-  for (level = off = 0; level < maxlevel; level++) {
+  for (level = 0, off = self->ntroot; level < maxlevel; level++) {
     int k = getnybble(node, level);
-    nodetree* n = &self->nt[off];
-    int v = n->children[k];
+    int v = nt_node(self, off)->children[k];
 
     if (v < 0) {
       const char* n;
@@ -941,7 +958,7 @@ nt_find(indexObject* self, const char* node, Py_ssize_t nodelen, int hex) {
           return -2;
       return v;
     }
-    if (v == 0)
+    if (v == 0 || (size_t)v >= self->ntlength)
       return -2;
     off = v;
   }
@@ -950,39 +967,66 @@ nt_find(indexObject* self, const char* node, Py_ssize_t nodelen, int hex) {
 }
 
 static int nt_new(indexObject* self) {
-  if (self->ntlength == self->ntcapacity) {
+  size_t used = self->ntlength - self->ntpersisted;
+
+  if (self->ntlength >= INT_MAX) {
+    PyErr_SetString(PyExc_MemoryError, "overflow in nt_new");
+    return -1;
+  }
+  if (used == self->ntcapacity) {
     if (self->ntcapacity >= SIZE_MAX / (sizeof(nodetree) * 2)) {
       PyErr_SetString(PyExc_MemoryError, "overflow in nt_new");
       return -1;
     }
-    self->ntcapacity *= 2;
+    self->ntcapacity = self->ntcapacity ? self->ntcapacity * 2 : 64;
     self->nt = realloc(self->nt, self->ntcapacity * sizeof(nodetree));
     if (self->nt == NULL) {
       PyErr_SetString(PyExc_MemoryError, "out of memory");
       return -1;
     }
     memset(
-        &self->nt[self->ntlength],
-        0,
-        sizeof(nodetree) * (self->ntcapacity - self->ntlength));
+        &self->nt[used], 0, sizeof(nodetree) * (self->ntcapacity - used));
   }
-  return self->ntlength++;
+  return (int)self->ntlength++;
+}
+
+/*
+ * Return the index of a node that can be written to in place of the node at
+ * off, which is child k of parent, or the root if parent is -1. Loaded nodes
+ * are copied, and the parent, which must be writable, is pointed to the copy.
+ */
+static int nt_writable(indexObject* self, int off, int parent, int k) {
+  int noff;
+
+  if ((size_t)off >= self->ntpersisted)
+    return off;
+  noff = nt_new(self);
+  if (noff == -1)
+    return -1;
+  *nt_node(self, noff) = *nt_node(self, off);
+  if (parent == -1)
+    self->ntroot = noff;
+  else
+    nt_node(self, parent)->children[k] = noff;
+  return noff;
 }
 
 static int nt_insert(indexObject* self, const char* node, int rev) {
   int level = 0;
-  int off = 0;
+  int off = self->ntroot;
+  int parent = -1, pk = 0;
 
   while (level < 40) {
     int k = nt_level(node, level);
-    nodetree* n;
     int v;
 
-    n = &self->nt[off];
-    v = n->children[k];
+    off = nt_writable(self, off, parent, pk);
+    if (off == -1)
+      return -1;
+    v = nt_node(self, off)->children[k];
 
     if (v == 0) {
-      n->children[k] = -rev - 1;
+      nt_node(self, off)->children[k] = -rev - 1;
       return 0;
     }
     if (v < 0) {
@@ -990,21 +1034,28 @@ static int nt_insert(indexObject* self, const char* node, int rev) {
       int noff;
 
       if (!oldnode || !memcmp(oldnode, node, 20)) {
-        n->children[k] = -rev - 1;
+        nt_node(self, off)->children[k] = -rev - 1;
         return 0;
       }
       noff = nt_new(self);
       if (noff == -1)
         return -1;
       /* self->nt may have been changed by realloc */
-      self->nt[off].children[k] = noff;
+      nt_node(self, off)->children[k] = noff;
+      parent = off;
+      pk = k;
       off = noff;
-      n = &self->nt[off];
-      n->children[nt_level(oldnode, ++level)] = v;
+      nt_node(self, off)->children[nt_level(oldnode, ++level)] = v;
       if (level > self->ntdepth)
         self->ntdepth = level;
       self->ntsplits += 1;
     } else {
+      if ((size_t)v >= self->ntlength) {
+        PyErr_SetString(PyExc_ValueError, "corrupt node trie");
+        return -1;
+      }
+      parent = off;
+      pk = k;
       level += 1;
       off = v;
     }
@@ -1013,8 +1064,51 @@ static int nt_insert(indexObject* self, const char* node, int rev) {
   return -1;
 }
 
+/*
+ * Start from the nodes given to loadnodetree, if they still map the revs of
+ * the index, and add the revs appended since.
+ *
+ * Return 1 if they don't, so that the trie is built from scratch.
+ */
+static int nt_load(indexObject* self) {
+  Py_ssize_t len = index_length(self) - 1;
+  Py_ssize_t rev;
+  const char* tip;
+
+  if (self->ntbuftiprev >= len)
+    return 1;
+  tip = index_node(self, self->ntbuftiprev);
+  if (tip == NULL || memcmp(tip, self->ntbuftipnode, 20))
+    return 1;
+
+  self->ntlength = self->ntpersisted = self->ntbuf.len / sizeof(nodetree);
+  self->ntroot = (int)self->ntbufroot;
+  self->ntlookups = 1;
+  self->ntmisses = 0;
+  for (rev = self->ntbuftiprev + 1; rev < len; rev++) {
+    const char* n = index_node(self, rev);
+    if (n == NULL || nt_insert(self, n, (int)rev) == -1) {
+      /* a corrupt trie is rebuilt, raising any lack of memory again */
+      PyErr_Clear();
+      self->ntlength = self->ntpersisted = 0;
+      free(self->nt);
+      self->nt = NULL;
+      self->ntcapacity = 0;
+      return 1;
+    }
+  }
+  self->ntrev = 0;
+  return 0;
+}
+
 static int nt_init(indexObject* self) {
-  if (self->nt == NULL) {
+  if (self->ntlength == 0) {
+    if (self->ntbuf.buf) {
+      int ret = nt_load(self);
+      if (ret != 1)
+        return ret;
+    }
+    self->ntroot = 0;
     if ((size_t)self->raw_length > SIZE_MAX / sizeof(nodetree)) {
       PyErr_SetString(PyExc_ValueError, "overflow in nt_init");
       return -1;
@@ -1027,6 +1121,7 @@ static int nt_init(indexObject* self) {
       return -1;
     }
     self->ntlength = 1;
+    self->ntpersisted = 0;
     self->ntrev = (int)index_length(self) - 1;
     self->ntlookups = 1;
     self->ntmisses = 0;
@@ -1047,14 +1142,15 @@ static int
 index_find_node(indexObject* self, const char* node, Py_ssize_t nodelen) {
   int rev;
 
+  /* before the first lookup, which may load a saved trie */
+  if (nt_init(self) == -1)
+    return -3;
+
   self->ntlookups++;
   rev = nt_find(self, node, nodelen, 0);
   if (rev >= -1)
     return rev;
 
-  if (nt_init(self) == -1)
-    return -3;
-
   /*
    * For the first handful of lookups, we scan the entire index,
    * and cache only the matching nodes. This optimizes for cases
@@ -1144,15 +1240,22 @@ static PyObject* index_getitem(indexObject* self, PyObject* value) {
   return NULL;
 }
 
-static int
-nt_partialmatch(indexObject* self, const char* node, Py_ssize_t nodelen) {
+/*
+ * Ensure that the radix tree is fully populated.
+ *
+ * Return values:
+ *
+ *   -3: error (exception set)
+ *   -2: missing node (no exception set)
+ *    0: success
+ */
+static int nt_populate(indexObject* self) {
   int rev;
 
   if (nt_init(self) == -1)
     return -3;
 
   if (self->ntrev > 0) {
-    /* ensure that the radix tree is fully populated */
     for (rev = self->ntrev - 1; rev >= 0; rev--) {
       const char* n = index_node(self, rev);
       if (n == NULL)
@@ -1162,7 +1265,14 @@ nt_partialmatch(indexObject* self, const char* node, Py_ssize_t nodelen) {
     }
     self->ntrev = rev;
   }
+  return 0;
+}
 
+static int
+nt_partialmatch(indexObject* self, const char* node, Py_ssize_t nodelen) {
+  int ret = nt_populate(self);
+  if (ret < 0)
+    return ret;
   return nt_find(self, node, nodelen, 1);
 }
 
@@ -1214,6 +1324,107 @@ static PyObject* index_partialmatch(indexObject* self, PyObject* args) {
   return PyBytes_FromStringAndSize(fullnode, 20);
 }
 
+/*
+ * Use the nodes of a trie returned by dumpnodetree, in the native byte
+ * order, instead of scanning the index. The trie maps the revs up to tiprev,
+ * whose node must be tipnode, or it is ignored.
+ *
+ * The data is only read, so it can be mmapped. It is used lazily, on the
+ * first lookup, from then on.
+ */
+static PyObject* index_loadnodetree(indexObject* self, PyObject* args) {
+  PyObject *data_obj, *tip_obj;
+  Py_ssize_t root, tiprev, tiplen;
+  Py_buffer buf;
+  char* tipnode;
+
+  if (!PyArg_ParseTuple(args, "OnnO", &data_obj, &root, &tiprev, &tip_obj))
+    return NULL;
+  if (node_check(tip_obj, &tipnode, &tiplen) == -1)
+    return NULL;
+  if (PyObject_GetBuffer(data_obj, &buf, PyBUF_SIMPLE) == -1)
+    return NULL;
+  if (buf.len == 0 || buf.len % sizeof(nodetree) ||
+      (size_t)buf.len / sizeof(nodetree) > INT_MAX ||
+      (uintptr_t)buf.buf % sizeof(int) || root < 0 ||
+      root >= buf.len / (Py_ssize_t)sizeof(nodetree) || tiprev < 0) {
+    PyBuffer_Release(&buf);
+    PyErr_SetString(PyExc_ValueError, "invalid node trie");
+    return NULL;
+  }
+
+  free(self->nt);
+  self->nt = NULL;
+  self->ntlength = self->ntcapacity = self->ntpersisted = 0;
+  self->ntrev = -1;
+  if (self->ntbuf.buf)
+    PyBuffer_Release(&self->ntbuf);
+  self->ntbuf = buf;
+  self->ntbufroot = root;
+  self->ntbuftiprev = tiprev;
+  memcpy(self->ntbuftipnode, tipnode, 20);
+  Py_RETURN_NONE;
+}
+
+/*
+ * Return (data, start, root, tiprev, tipnode) for the trie of all the revs,
+ * or None for an empty index. data holds the nodes from start on: the ones
+ * not loaded by loadnodetree, or all of them if full is true. Appending it
+ * to the data given to the last loadnodetree gives a trie that can be
+ * loaded with root, tiprev and tipnode.
+ */
+static PyObject* index_dumpnodetree(indexObject* self, PyObject* args) {
+  PyObject *full_obj = NULL, *data, *tip;
+  Py_ssize_t tiprev = index_length(self) - 2;
+  const char* tipnode;
+  size_t start, len;
+  char* out;
+  int ret;
+
+  if (!PyArg_ParseTuple(args, "|O", &full_obj))
+    return NULL;
+  if (tiprev < 0)
+    Py_RETURN_NONE;
+
+  ret = nt_populate(self);
+  if (ret == -3)
+    return NULL;
+  if (ret == -2) {
+    PyErr_Format(PyExc_IndexError, "could not access rev %d", self->ntrev);
+    return NULL;
+  }
+
+  start = full_obj && PyObject_IsTrue(full_obj) ? 0 : self->ntpersisted;
+  len = self->ntlength - start;
+  data = PyBytes_FromStringAndSize(NULL, len * sizeof(nodetree));
+  if (data == NULL)
+    return NULL;
+  out = PyBytes_AS_STRING(data);
+  if (start < self->ntpersisted) {
+    memcpy(
+        out,
+        self->ntbuf.buf,
+        (self->ntpersisted - start) * sizeof(nodetree));
+    out += (self->ntpersisted - start) * sizeof(nodetree);
+  }
+  if (self->nt)
+    memcpy(
+        out,
+        self->nt,
+        (self->ntlength - self->ntpersisted) * sizeof(nodetree));
+
+  tipnode = index_node(self, tiprev);
+  tip = tipnode ? PyBytes_FromStringAndSize(tipnode, 20) : NULL;
+  if (tip == NULL) {
+    if (!PyErr_Occurred())
+      PyErr_Format(PyExc_IndexError, "could not access rev %d", (int)tiprev);
+    Py_DECREF(data);
+    return NULL;
+  }
+  return Py_BuildValue(
+      "(NninN)", data, (Py_ssize_t)start, self->ntroot, tiprev, tip);
+}
+
 static PyObject* index_m_get(indexObject* self, PyObject* args) {
   Py_ssize_t nodelen;
   PyObject* val;
@@ -1672,7 +1883,7 @@ static int index_slice_del(indexObject* self, PyObject* item) {
   }
 
   if (start < self->length - 1) {
-    if (self->nt) {
+    if (self->ntlength) {
       Py_ssize_t i;
 
       for (i = start + 1; i < self->length - 1; i++) {
@@ -1698,7 +1909,7 @@ static int index_slice_del(indexObject* self, PyObject* item) {
     goto done;
   }
 
-  if (self->nt) {
+  if (self->ntlength) {
     nt_invalidate_added(self, start - self->length + 1);
     if (self->ntrev > start)
       self->ntrev = (int)start;
@@ -1734,7 +1945,7 @@ index_assign_subscript(indexObject* self, PyObject* item, PyObject* value) {
     return -1;
 
   if (value == NULL)
-    return self->nt ? nt_insert(self, node, -1) : 0;
+    return self->ntlength ? nt_insert(self, node, -1) : 0;
   rev = PyInt_AsLong(value);
   if (rev > INT_MAX || rev < 0) {
     if (!PyErr_Occurred())
@@ -1791,6 +2002,7 @@ static int index_init(indexObject* self, PyObject* args) {
   self->headrevs = NULL;
   Py_INCREF(Py_None);
   self->nt = NULL;
+  memset(&self->ntbuf, 0, sizeof(self->ntbuf));
   self->offsets = NULL;
 
   if (!PyArg_ParseTuple(args, "OO", &data_obj, &inlined_obj))
@@ -1807,10 +2019,11 @@ static int index_init(indexObject* self, PyObject* args) {
   self->inlined = inlined_obj && PyObject_IsTrue(inlined_obj);
   self->data = data_obj;
 
-  self->ntlength = self->ntcapacity = 0;
+  self->ntlength = self->ntcapacity = self->ntpersisted = 0;
   self->ntdepth = self->ntsplits = 0;
   self->ntlookups = self->ntmisses = 0;
   self->ntrev = -1;
+  self->ntroot = 0;
   Py_INCREF(self->data);
 
   if (self->inlined) {
@@ -1844,6 +2057,8 @@ static void index_dealloc(indexObject* self) {
     PyBuffer_Release(&self->buf);
     memset(&self->buf, 0, sizeof(self->buf));
   }
+  if (self->ntbuf.buf)
+    PyBuffer_Release(&self->ntbuf);
   Py_XDECREF(self->data);
   Py_XDECREF(self->added);
   PyObject_Del(self);
@@ -1904,6 +2119,14 @@ static PyMethodDef index_methods[] = {
      (PyCFunction)index_partialmatch,
      METH_VARARGS,
      "match a potentially ambiguous node ID"},
+    {"loadnodetree",
+     (PyCFunction)index_loadnodetree,
+     METH_VARARGS,
+     "use a node trie saved by dumpnodetree"},
+    {"dumpnodetree",
+     (PyCFunction)index_dumpnodetree,
+     METH_VARARGS,
+     "get the nodes of the node trie to save"},
     {"stats", (PyCFunction)index_stats, METH_NOARGS, "stats for the index"},
     {NULL} /* Sentinel */
 };
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+/*
+ threadpool.h - run independent C jobs on a few threads
+
+ The threads come from Python's portable thread API, so this works wherever
+ the interpreter has threads, but the jobs must not use the Python API: the
+ caller releases the GIL around hg_run_jobs.
+*/
+
+#ifndef _HG_THREADPOOL_H_
+#define _HG_THREADPOOL_H_
+
+#include <Python.h>
+#include <pythread.h>
+
+#ifdef PYTHREAD_INVALID_THREAD_ID
+#define HG_INVALID_THREAD PYTHREAD_INVALID_THREAD_ID
+#else
+#define HG_INVALID_THREAD -1
+#endif
+
+typedef void (*hg_job_func)(void* ctx, Py_ssize_t i);
+
+struct hg_jobs {
+  hg_job_func fn;
+  void* ctx;
+  Py_ssize_t njobs;
+  Py_ssize_t next; /* next job to take, under lock */
+  int running; /* threads still working, under lock */
+  PyThread_type_lock lock;
+  PyThread_type_lock done; /* released by the last thread to finish */
+};
+
+static void hg_jobs_work(void* arg) {
+  struct hg_jobs* jobs = (struct hg_jobs*)arg;
+  int last;
+  for (;;) {
+    Py_ssize_t i;
+    PyThread_acquire_lock(jobs->lock, WAIT_LOCK);
+    i = jobs->next++;
+    PyThread_release_lock(jobs->lock);
+    if (i >= jobs->njobs)
+      break;
+    jobs->fn(jobs->ctx, i);
+  }
+  PyThread_acquire_lock(jobs->lock, WAIT_LOCK);
+  last = --jobs->running == 0;
+  PyThread_release_lock(jobs->lock);
+  /* jobs may be gone as soon as done is released */
+  if (last)
+    PyThread_release_lock(jobs->done);
+}
+
+/*
+ * Call fn(ctx, i) for every i in [0, njobs), on up to nthreads threads
+ * counting the calling one, and return once all the calls returned.
+ *
+ * Jobs are handed out one at a time, so that a few large ones don't leave
+ * the other threads idle. When no thread can be started, the calling thread
+ * runs all of the jobs.
+ */
+static void
+hg_run_jobs(hg_job_func fn, void* ctx, Py_ssize_t njobs, int nthreads) {
+  struct hg_jobs jobs;
+  Py_ssize_t i;
+  int t;
+
+  if (nthreads > njobs)
+    nthreads = (int)njobs;
+  jobs.lock = jobs.done = NULL;
+  if (nthreads > 1) {
+    jobs.lock = PyThread_allocate_lock();
+    jobs.done = PyThread_allocate_lock();
+  }
+  if (!jobs.lock || !jobs.done) {
+    if (jobs.lock)
+      PyThread_free_lock(jobs.lock);
+    if (jobs.done)
+      PyThread_free_lock(jobs.done);
+    for (i = 0; i < njobs; i++)
+      fn(ctx, i);
+    return;
+  }
+
+  jobs.fn = fn;
+  jobs.ctx = ctx;
+  jobs.njobs = njobs;
+  jobs.next = 0;
+  jobs.running = 1; /* the calling thread */
+  PyThread_acquire_lock(jobs.done, WAIT_LOCK);
+  for (t = 1; t < nthreads; t++) {
+    PyThread_acquire_lock(jobs.lock, WAIT_LOCK);
+    jobs.running++;
+    PyThread_release_lock(jobs.lock);
+    if (PyThread_start_new_thread(hg_jobs_work, &jobs) == HG_INVALID_THREAD) {
+      PyThread_acquire_lock(jobs.lock, WAIT_LOCK);
+      jobs.running--;
+      PyThread_release_lock(jobs.lock);
+      break;
+    }
+  }
+  hg_jobs_work(&jobs);
+  PyThread_acquire_lock(jobs.done, WAIT_LOCK);
+  PyThread_release_lock(jobs.done);
+
+  PyThread_free_lock(jobs.lock);
+  PyThread_free_lock(jobs.done);
+}
+
+#endif
@@ -39,6 +39,10 @@ Config
   # how long (in seconds) should an idle chg server exit
   idletimeout = 3600
 
+  # how many forked workers to keep ready for the next connections, so
+  # that commands don't wait for the server to fork
+  idleworkers = 0
+
   # whether to skip config or env change checks
   skiphash = False
 """
@@ -319,6 +323,7 @@ class chgunixservicehandler(object):
     def __init__(self, ui):
         self.ui = ui
         self._idletimeout = ui.configint("chgserver", "idletimeout")
+        self.idleworkers = ui.configint("chgserver", "idleworkers")
         self._lastactive = time.time()
 
     def bindsocket(self, sock, address):
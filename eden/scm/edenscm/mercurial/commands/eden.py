@@ -118,6 +118,7 @@ CMD_CAT_FILE = 7
 CMD_GET_FILE_SIZE = 8
 CMD_CAT_TREE = 9
 CMD_FLUSH_STORE = 10
+CMD_MANIFEST_NODES_FOR_REVSET = 11
 
 #
 # Flag values.
@@ -605,6 +606,34 @@ class HgServer(object):
 
         self.send_chunk(request, node)
 
+    # pyre-fixme[56]: While applying decorator
+    #  `edenscm.mercurial.commands.eden.cmd(...)`: Expected `(Request) -> None` for 1st
+    #  param but got `(self: HgServer, request: Request) -> None`.
+    @cmd(CMD_MANIFEST_NODES_FOR_REVSET)
+    def cmd_manifest_nodes_for_revset(self, request: Request) -> None:
+        """
+        Handler for CMD_MANIFEST_NODES_FOR_REVSET requests.
+
+        Resolve the manifest nodes of all the commits of a revset at once,
+        which is much cheaper than one CMD_MANIFEST_NODE_FOR_COMMIT request
+        per commit.
+
+        Request body format:
+        - Revset (string)
+
+        Response body format:
+          For each commit of the revset, its 20-byte binary commit hash
+          followed by its 20-byte binary manifest node.
+        """
+        revset = pycompat.decodeutf8(request.body)
+        self.debug("resolving manifest nodes for revset %r", revset)
+        data = b"".join(
+            ctx.node() + ctx.manifestnode()
+            for ctx in self.repo.set(revset)
+            if ctx.manifestnode()
+        )
+        self.send_chunk(request, data)
+
     # pyre-fixme[56]: While applying decorator
     #  `edenscm.mercurial.commands.eden.cmd(...)`: Expected `(Request) -> None` for 1st
     #  param but got `(self: HgServer, request: Request) -> None`.
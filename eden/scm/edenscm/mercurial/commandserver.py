@@ -436,6 +436,10 @@ class unixservicehandler(object):
 
     pollinterval = None
 
+    # how many forked workers to keep waiting for connections, so a new
+    # connection doesn't wait for a fork
+    idleworkers = 0
+
     def __init__(self, ui):
         self.ui = ui
 
@@ -478,6 +482,13 @@ class unixforkingservice(object):
         self._sock = None
         self._oldsigchldhandler = None
         self._workerpids = set()  # updated by signal handler; do not iterate
+        # pre-forked workers yet to take a connection; also updated by signal
+        # handler
+        self._idleworkers = set()
+        # idle workers write their pid to busypipe when they take a
+        # connection, and exit when stoppipe is closed
+        self._busypipe = None
+        self._stoppipe = None
         self._socketunlinked = None
 
     def init(self):
@@ -506,6 +517,7 @@ class unixforkingservice(object):
 
     def _cleanup(self):
         util.signal(signal.SIGCHLD, self._oldsigchldhandler)
+        self._stopidleworkers()
         self._sock.close()
         self._unlinksocket()
         # don't kill child processes as they have active clients, just wait
@@ -522,6 +534,14 @@ class unixforkingservice(object):
         h = self._servicehandler
         selector = selectors2.DefaultSelector()
         selector.register(self._sock, selectors2.EVENT_READ)
+        listening = True
+        if h.idleworkers > 0:
+            # idle workers and this process can race for a connection, so
+            # whoever loses must not block in accept()
+            self._sock.setblocking(False)
+            self._busypipe = os.pipe()
+            self._stoppipe = os.pipe()
+            selector.register(self._busypipe[0], selectors2.EVENT_READ)
         while True:
             if not exiting and h.shouldexit():
                 # clients can no longer connect() to the domain socket, so
@@ -530,41 +550,111 @@ class unixforkingservice(object):
                 # accept()-ed), handle them before exit. otherwise, clients
                 # waiting for recv() will receive ECONNRESET.
                 self._unlinksocket()
+                self._stopidleworkers()
                 exiting = True
+            if self._stoppipe and not exiting:
+                while len(self._idleworkers) < h.idleworkers:
+                    self._forkworker(selector, None)
+            # leave connections to the idle workers while there are some
+            if listening != (exiting or not self._idleworkers):
+                listening = not listening
+                if listening:
+                    selector.register(self._sock, selectors2.EVENT_READ)
+                else:
+                    selector.unregister(self._sock)
             ready = selector.select(timeout=h.pollinterval)
             if not ready:
                 # only exit if we completed all queued requests
                 if exiting:
                     break
                 continue
+            if self._busypipe and any(
+                key.fd == self._busypipe[0] for key, _events in ready
+            ):
+                data = os.read(self._busypipe[0], 4096)
+                for i in range(0, len(data), 4):
+                    (pid,) = struct.unpack(">i", data[i : i + 4])
+                    self.ui.debug("worker process (pid=%d) got a connection\n" % pid)
+                    self._idleworkers.discard(pid)
+                    h.newconnection()
+                if len(ready) == 1:
+                    continue
             try:
                 conn, _addr = self._sock.accept()
             except socket.error as inst:
-                if inst.args[0] == errno.EINTR:
+                if inst.args[0] in (errno.EINTR, errno.EAGAIN, errno.EWOULDBLOCK):
                     continue
                 raise
 
-            pid = os.fork()
-            if pid:
-                try:
-                    self.ui.debug("forked worker process (pid=%d)\n" % pid)
-                    self._workerpids.add(pid)
-                    h.newconnection()
-                finally:
-                    conn.close()  # release handle in parent process
+            h.newconnection()
+            self._forkworker(selector, conn)
+        selector.close()
+
+    def _forkworker(self, selector, conn):
+        """Fork a worker serving conn, or waiting for a connection of its own
+        if conn is None"""
+        pid = os.fork()
+        if pid:
+            if conn:
+                self.ui.debug("forked worker process (pid=%d)\n" % pid)
+                conn.close()  # release handle in parent process
             else:
-                try:
-                    selector.close()
-                    self._sock.close()
-                    self._runworker(conn)
-                    conn.close()
+                self.ui.debug("forked idle worker process (pid=%d)\n" % pid)
+                self._idleworkers.add(pid)
+            self._workerpids.add(pid)
+            return
+        try:
+            selector.close()
+            if self._stoppipe:
+                os.close(self._busypipe[0])
+                if self._stoppipe[1] is not None:
+                    os.close(self._stoppipe[1])
+            if conn is None:
+                conn = self._waitconnection()
+                if conn is None:
                     os._exit(0)
-                except:  # never return, hence no re-raises
-                    try:
-                        self.ui.traceback(force=True)
-                    finally:
-                        os._exit(255)
-        selector.close()
+            if self._stoppipe:
+                os.close(self._busypipe[1])
+                os.close(self._stoppipe[0])
+            self._sock.close()
+            self._runworker(conn)
+            conn.close()
+            os._exit(0)
+        except:  # never return, hence no re-raises
+            try:
+                self.ui.traceback(force=True)
+            finally:
+                os._exit(255)
+
+    def _waitconnection(self):
+        """Accept a connection in an idle worker, and tell the main process it
+        needs a new idle worker. Return None if told to exit instead."""
+        selector = selectors2.DefaultSelector()
+        selector.register(self._sock, selectors2.EVENT_READ)
+        selector.register(self._stoppipe[0], selectors2.EVENT_READ)
+        try:
+            while True:
+                ready = selector.select()
+                if any(key.fd == self._stoppipe[0] for key, _events in ready):
+                    return None
+                try:
+                    conn, _addr = self._sock.accept()
+                except socket.error as inst:
+                    if inst.args[0] in (errno.EINTR, errno.EAGAIN, errno.EWOULDBLOCK):
+                        continue
+                    raise
+                conn.setblocking(True)
+                os.write(self._busypipe[1], struct.pack(">i", os.getpid()))
+                return conn
+        finally:
+            selector.close()
+
+    def _stopidleworkers(self):
+        if self._stoppipe and self._stoppipe[1] is not None:
+            # idle workers see the end of the pipe and exit
+            os.close(self._stoppipe[1])
+            self._stoppipe = (self._stoppipe[0], None)
+        self._idleworkers.clear()
 
     def _sigchldhandler(self, signal, frame):
         self._reapworkers(os.WNOHANG)
@@ -585,6 +675,7 @@ class unixforkingservice(object):
                 # no waitable child processes
                 return
             self._workerpids.discard(pid)
+            self._idleworkers.discard(pid)
 
     def _runworker(self, conn):
         util.signal(signal.SIGCHLD, self._oldsigchldhandler)
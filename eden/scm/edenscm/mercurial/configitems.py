@@ -149,6 +149,7 @@ coreconfigitem("bundle", "reorder", default="auto")
 coreconfigitem("censor", "policy", default="abort")
 coreconfigitem("checkout", "resumable", default=True)
 coreconfigitem("chgserver", "idletimeout", default=3600)
+coreconfigitem("chgserver", "idleworkers", default=0)
 coreconfigitem("chgserver", "skiphash", default=False)
 coreconfigitem("clone", "prefer-edenapi-clonedata", default=True)
 coreconfigitem("cmdserver", "log", default=None)
@@ -297,6 +298,7 @@ coreconfigitem("experimental", "mergedriver", default=None)
 coreconfigitem("experimental", "narrow-heads", default=True)
 coreconfigitem("experimental", "obsmarkers-exchange-debug", default=False)
 coreconfigitem("experimental", "pathhistory", default=False)
+coreconfigitem("experimental", "persistent-nodetree", default=False)
 coreconfigitem("experimental", "remotenames", default=False)
 # Map rev to safe f64 range for Javascript consumption.
 coreconfigitem("experimental", "revf64compat", default=True)
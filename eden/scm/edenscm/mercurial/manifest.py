@@ -141,7 +141,7 @@ class manifestdict(object):
         return self._dirs
 
     def hasdir(self, dir):
-        return dir in self._dirs
+        return self._lm.hasdir(dir)
 
     def _filesfastpath(self, match):
         """Checks whether we can correctly and quickly iterate over matcher
@@ -172,12 +172,18 @@ class manifestdict(object):
                 yield fn
             return
 
-        for fn in self:
-            if fn in fset:
-                # specified pattern is the exact name
-                fset.remove(fn)
-            if match(fn):
+        if match.prefix():
+            # only the lines under the matched directories are visited
+            for fn in self._lm.subtreecopy(match.files()):
+                fset.discard(fn)
                 yield fn
+        else:
+            for fn in self:
+                if fn in fset:
+                    # specified pattern is the exact name
+                    fset.remove(fn)
+                if match(fn):
+                    yield fn
 
         # for dirstate.walk, files=[''] means "walk the whole tree".
         # follow that here, too
@@ -195,13 +201,14 @@ class manifestdict(object):
         if self._filesfastpath(match):
             m = manifestdict()
             lm = self._lm
-            for fn in match.files():
-                if fn in lm:
-                    m._lm[fn] = lm[fn]
+            m._lm.setitems((fn, lm[fn]) for fn in match.files() if fn in lm)
             return m
 
         m = manifestdict()
-        m._lm = self._lm.filtercopy(match)
+        if match.prefix():
+            m._lm = self._lm.subtreecopy(match.files())
+        else:
+            m._lm = self._lm.filtercopy(match)
         return m
 
     def diff(self, m2, matcher=None):
@@ -452,6 +459,7 @@ class manifestrevlog(revlog.revlog):
             # only root indexfile is cached
             checkambig=not bool(dir),
             mmaplargeindex=True,
+            persistnodetree=not bool(dir),
         )
 
     @property
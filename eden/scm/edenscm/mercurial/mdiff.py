@@ -20,7 +20,7 @@ from typing import TYPE_CHECKING, Iterator, List, Optional, Tuple
 
 from edenscmnative import bdiff, mpatch, xdiff
 
-from . import error, util
+from . import error, util, worker
 from .i18n import _
 from .pycompat import encodeutf8, range
 
@@ -573,6 +573,22 @@ def patch(a, bin):
     return mpatch.patches(a, [bin])
 
 
+def textdiffs(pairs, threads=None):
+    """textdiff of every (a, b) of pairs, computed on up to threads threads,
+    one per CPU by default, without holding the GIL"""
+    if threads is None:
+        threads = worker.countcpus()
+    return bdiff.bdiffs(pairs, threads)
+
+
+def patchchains(chains, threads=None):
+    """patches(text, bins) of every (text, bins) of chains, applied on up to
+    threads threads, one per CPU by default, without holding the GIL"""
+    if threads is None:
+        threads = worker.countcpus()
+    return mpatch.patchchains(chains, threads)
+
+
 # similar to difflib.SequenceMatcher.get_matching_blocks
 def get_matching_blocks(a, b):
     return [(d[0], d[2], d[1] - d[0]) for d in blocks(a, b)]
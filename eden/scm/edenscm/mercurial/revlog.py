@@ -25,6 +25,7 @@ import hashlib
 import heapq
 import os
 import struct
+import sys
 import zlib
 from typing import IO, Any, List, Optional, Tuple, Union
 
@@ -276,6 +277,20 @@ versionformat_unpack = versionformat.unpack
 # signed integer)
 _maxentrysize = 0x7FFFFFFF
 
+# node trie docket, pointing to the file of trie nodes saved by the C index:
+#  4 bytes: magic
+#  1 byte: byte order of the nodes
+#  8 bytes: number of nodes
+#  8 bytes: root node
+#  8 bytes: last rev mapped
+# 20 bytes: node of that rev
+# 16 bytes: hex id of the nodes file
+nodetreedocket = struct.Struct(">4sc3xqqq20s16s")
+_nodetreemagic = b"HGNT"
+_nodetreeorder = sys.byteorder[0:1].encode("ascii")
+# size of a node of the C trie
+_nodetreenodesize = 64
+
 
 class revlogio(object):
     def __init__(self):
@@ -334,12 +349,17 @@ class revlog(object):
         checkambig=False,
         mmaplargeindex=False,
         index2=False,
+        persistnodetree=False,
     ):
         """
         create a revlog object
 
         opener is a function that abstracts the file opening operation
         and can be used to implement COW semantics or the like.
+
+        If persistnodetree is set, and enabled by the opener options, the
+        node to rev mapping is saved next to the index when a transaction
+        adds revisions, and mmapped on load rather than rebuilt.
         """
         self.indexfile = indexfile
         self.datafile = datafile or (indexfile[:-2] + ".d")
@@ -368,6 +388,9 @@ class revlog(object):
         self._withsparseread = False
         self._srdensitythreshold = 0.25
         self._srmingapsize = 262144
+        # Docket file of the saved node trie, and its content once loaded.
+        self._nodetreefile = None
+        self._nodetreedocket = None
 
         mmapindexthreshold = None
         v = REVLOG_DEFAULT_VERSION
@@ -394,6 +417,8 @@ class revlog(object):
                 self._srdensitythreshold = opts["sparse-read-density-threshold"]
             if "sparse-read-min-gap-size" in opts:
                 self._srmingapsize = opts["sparse-read-min-gap-size"]
+            if persistnodetree and not index2 and opts.get("persistent-nodetree"):
+                self._nodetreefile = indexfile[:-2] + ".nodetree"
 
         if self._chunkcachesize <= 0:
             raise RevlogError(
@@ -472,6 +497,10 @@ class revlog(object):
         self.index, nodemap, self._chunkcache = d
         if nodemap is not None:
             self.nodemap = self._nodecache = nodemap
+        if not util.safehasattr(self.index, "loadnodetree"):
+            self._nodetreefile = None
+        if self._nodetreefile is not None:
+            self._loadnodetree()
         if not self._chunkcache:
             self._chunkclear()
         # revnum -> (chain-length, sum-delta-length)
@@ -484,6 +513,114 @@ class revlog(object):
         # like visibleheads and bookmarks control the commit graph.
         self._bypasstransaction = bool(opts and opts.get("bypass-revlog-transaction"))
 
+    def _readnodetreedocket(self):
+        """Return (nodesfile, count, root, tiprev, tipnode) of the saved node
+        trie, or None if there is none usable."""
+        data = self.opener.tryread(self._nodetreefile)
+        if len(data) != nodetreedocket.size:
+            return None
+        magic, order, count, root, tiprev, tipnode, fileid = nodetreedocket.unpack(
+            data
+        )
+        if magic != _nodetreemagic or order != _nodetreeorder:
+            return None
+        nodesfile = "%s-%s" % (self._nodetreefile, pycompat.decodeutf8(fileid))
+        return nodesfile, count, root, tiprev, tipnode
+
+    def _loadnodetree(self):
+        """Map the saved node trie for the index to use.
+
+        The index checks that the trie still matches it on the first lookup,
+        and maps the revisions added since then itself.
+        """
+        self._nodetreedocket = None
+        docket = self._readnodetreedocket()
+        if docket is None:
+            return
+        nodesfile, count, root, tiprev, tipnode = docket
+        try:
+            with self.opener(nodesfile) as fp:
+                data = util.mmapread(fp)
+        except (IOError, OSError):
+            return
+        size = count * _nodetreenodesize
+        if len(data) < size:
+            return
+        try:
+            self.index.loadnodetree(util.buffer(data, 0, size), root, tiprev, tipnode)
+        except ValueError:
+            return
+        self._nodetreedocket = docket
+
+    def _writenodetree(self, tr):
+        """Save the node trie of the index, appending to the nodes file when
+        it is still the one loaded.
+
+        The nodes are written before the docket pointing to them, and the
+        nodes a docket points to are never changed, so that readers never
+        see a partial trie. Failing to save is not an error: the trie is
+        rebuilt when missing."""
+        dump = self.index.dumpnodetree()
+        if dump is None:
+            return
+        data, start, root, tiprev, tipnode = dump
+        old = self._readnodetreedocket()
+        nodesfile = None
+        if start and old is not None and old == self._nodetreedocket:
+            size = start * _nodetreenodesize
+            try:
+                if old[1] == start and self.opener.stat(old[0]).st_size == size:
+                    nodesfile = old[0]
+            except OSError:
+                pass
+
+        try:
+            if nodesfile is not None:
+                with self.opener(nodesfile, "ab") as fp:
+                    fp.write(data)
+                fileid = pycompat.encodeutf8(nodesfile[-16:])
+            else:
+                if start:
+                    data = self.index.dumpnodetree(True)[0]
+                    start = 0
+                fileid = binascii.hexlify(os.urandom(8))
+                nodesfile = "%s-%s" % (self._nodetreefile, pycompat.decodeutf8(fileid))
+                with self.opener(nodesfile, "wb", atomictemp=True) as fp:
+                    fp.write(data)
+            count = start + len(data) // _nodetreenodesize
+            with self.opener(self._nodetreefile, "wb", atomictemp=True) as fp:
+                fp.write(
+                    nodetreedocket.pack(
+                        _nodetreemagic,
+                        _nodetreeorder,
+                        count,
+                        root,
+                        tiprev,
+                        tipnode,
+                        fileid,
+                    )
+                )
+        except (IOError, OSError):
+            return
+        if old is not None and old[0] != nodesfile:
+            # Fails where mapped files can't be removed, as on Windows.
+            try:
+                self.opener.tryunlink(old[0])
+            except OSError:
+                pass
+        self._loadnodetree()
+
+    def _removenodetree(self):
+        """Forget the saved node trie, before revision numbers change."""
+        docket = self._readnodetreedocket()
+        self._nodetreedocket = None
+        try:
+            self.opener.tryunlink(self._nodetreefile)
+            if docket is not None:
+                self.opener.tryunlink(docket[0])
+        except OSError:
+            pass
+
     @util.propertycache
     def _compressor(self):
         return util.compengines[self._compengine].revlogcompressor()
@@ -2082,6 +2219,8 @@ class revlog(object):
         if index2 is not None:
             index2.insert(node, [p for p in (p1r, p2r) if p >= 0])
         self.nodemap[node] = curr
+        if self._nodetreefile is not None and not self._bypasstransaction:
+            transaction.addfinalize("nodetree-%s" % self.indexfile, self._writenodetree)
 
         entry = self._io.packentry(e, self.node, self.version, curr)
         self._writeentry(transaction, ifh, dfh, entry, data, link, offset)
@@ -2303,6 +2442,9 @@ class revlog(object):
             end += rev * self._io.size
 
         transaction.add(self.indexfile, end)
+        if self._nodetreefile is not None:
+            self._removenodetree()
+            transaction.addfinalize("nodetree-%s" % self.indexfile, self._writenodetree)
 
         # then reset internal state in memory to forget those revisions
         self._cache = None
@@ -143,7 +143,11 @@ cdef class _buffer: # thin wrapper around linelog_buf
             if result == LINELOG_RESULT_OK:
                 return
             elif result == LINELOG_RESULT_ENEEDRESIZE:
-                self.resize((self.buf.neededsize // unitsize + 1) * unitsize)
+                # grow by half at least, so that appending many revisions
+                # remaps a file a few times, not once per page
+                newsize = max(self.buf.neededsize,
+                              self.buf.size + self.buf.size // 2)
+                self.resize((newsize // unitsize + 1) * unitsize)
             else:
                 raise LinelogError(result)
 
@@ -248,6 +252,67 @@ IF UNAME_SYSNAME != "Windows":
             memset(&self.buf, 0, sizeof(linelog_buf))
             self.maplen = 0
 
+    cdef class _forkbuffer(_buffer): # linelog_buf mapping a file privately
+        # pages are copied when first written to, the others are read from
+        # the file. the mapping is followed by anonymous memory to append to.
+        cdef size_t maplen
+
+        def __cinit__(self, _filebuffer rhs):
+            self.maplen = 0
+            self._map(rhs.fd, rhs.buf.size)
+
+        def __dealloc__(self):
+            self.close()
+
+        cdef resize(self, size_t newsize):
+            if newsize <= self.maplen:
+                self.buf.size = newsize
+                return
+            # out of room to append, move to a larger anonymous mapping
+            cdef void *p = mman.mmap(NULL, newsize,
+                                     mman.PROT_READ | mman.PROT_WRITE,
+                                     mman.MAP_PRIVATE | mman.MAP_ANONYMOUS,
+                                     -1, 0)
+            if p == mman.MAP_FAILED:
+                raise _excwitherrno(OSError, b'mmap')
+            memcpy(p, <const void *>self.buf.data, self.buf.size)
+            self.close()
+            self.buf.data = <uint8_t *>p
+            self.buf.size = newsize
+            self.maplen = newsize
+
+        cdef close(self):
+            if self.buf.data == NULL:
+                return
+            r = mman.munmap(self.buf.data, self.maplen)
+            if r != 0:
+                raise _excwitherrno(OSError, b'munmap')
+            memset(&self.buf, 0, sizeof(linelog_buf))
+            self.maplen = 0
+
+        cdef _map(self, int fd, size_t filelen):
+            # as much room to append as the file already takes
+            cdef size_t filemaplen = (filelen + pagesize - 1) // pagesize \
+                * pagesize
+            self.maplen = filemaplen * 2 + pagesize
+            cdef void *p = mman.mmap(NULL, self.maplen,
+                                     mman.PROT_READ | mman.PROT_WRITE,
+                                     mman.MAP_PRIVATE | mman.MAP_ANONYMOUS,
+                                     -1, 0)
+            if p == mman.MAP_FAILED:
+                self.maplen = 0
+                raise _excwitherrno(OSError, b'mmap')
+            self.buf.data = <uint8_t *>p
+            self.buf.size = self.maplen
+            if filelen == 0:
+                return
+            p = mman.mmap(p, filelen, mman.PROT_READ | mman.PROT_WRITE,
+                          mman.MAP_PRIVATE | mman.MAP_FIXED, fd, 0)
+            if p == mman.MAP_FAILED:
+                exc = _excwitherrno(OSError, b'mmap')
+                self.close()
+                raise exc
+
 cdef _ar2list(const linelog_annotateresult *ar):
     result = []
     cdef linelog_linenum i
@@ -321,6 +386,23 @@ cdef class linelog:
         self._checkclosed()
         self.buf.copyfrom(rhs.buf)
 
+    def fork(self):
+        """L.fork() -> linelog
+
+        Return an in-memory linelog starting with the same content, to make
+        changes that shouldn't be written back. Unlike copyfrom, forking an
+        on-disk linelog maps its file copy-on-write instead of reading all of
+        it, so the file must not change while the fork is used.
+        """
+        self._checkclosed()
+        cdef linelog result = linelog()
+        IF UNAME_SYSNAME != "Windows":
+            if isinstance(self.buf, _filebuffer):
+                result.buf = _forkbuffer(self.buf)
+                return result
+        result.copyfrom(self)
+        return result
+
     @property
     def maxrev(self):
         """L.maxrev() -> int. Return the max revision number."""
@@ -85,6 +85,66 @@ void getTreeBatchCallback(
         (*static_cast<Fn*>(fn))(index, result);
       });
 }
+
+/**
+ * A helper function to make it easier to work with FFI function pointers. Only
+ * non-capturing lambdas can be used as FFI function pointers. To bypass this
+ * restriction, we pass in the pointer to the capturing function opaquely.
+ * Whenever we get called to process the result, we call that capturing
+ * function instead.
+ */
+template <typename Fn>
+void getFileAuxBatchCallback(
+    RustBackingStore* store,
+    RustRequest* request,
+    uintptr_t size,
+    bool local,
+    Fn&& fn) {
+  rust_backingstore_get_file_aux_batch(
+      store,
+      request,
+      size,
+      local,
+      // We need to take address of the function, not to forward it.
+      // @lint-ignore CLANGTIDY
+      &fn,
+      [](void* fn, size_t index, RustCFallibleBase result) {
+        (*static_cast<Fn*>(fn))(index, result);
+      });
+}
+
+/**
+ * What an asynchronous batch needs until Rust is done with it. It is owned by
+ * the Rust thread fetching the batch, and deleted by its call to `done`.
+ */
+struct AsyncBatch {
+  std::function<void(size_t, RustCFallibleBase)> resolve;
+  std::function<void()> done;
+};
+
+void asyncBatchResolve(void* batch, size_t index, RustCFallibleBase result) {
+  static_cast<AsyncBatch*>(batch)->resolve(index, result);
+}
+
+void asyncBatchDone(void* batch) {
+  std::unique_ptr<AsyncBatch> owned{static_cast<AsyncBatch*>(batch)};
+  owned->done();
+}
+
+std::vector<RustRequest> toRawRequests(
+    const std::vector<std::pair<folly::ByteRange, folly::ByteRange>>&
+        requests) {
+  std::vector<RustRequest> raw_requests;
+  raw_requests.reserve(requests.size());
+  for (auto& [name, node] : requests) {
+    raw_requests.emplace_back(RustRequest{
+        name.data(),
+        name.size(),
+        node.data(),
+    });
+  }
+  return raw_requests;
+}
 } // namespace
 
 HgNativeBackingStore::HgNativeBackingStore(
@@ -103,6 +163,23 @@ HgNativeBackingStore::HgNativeBackingStore(
   store_ = store.unwrap();
 }
 
+HgNativeBackingStore::~HgNativeBackingStore() {
+  std::unique_lock<std::mutex> lock{asyncBatchesMutex_};
+  asyncBatchesDone_.wait(lock, [this] { return asyncBatches_ == 0; });
+}
+
+void HgNativeBackingStore::beginAsyncBatch() {
+  std::lock_guard<std::mutex> lock{asyncBatchesMutex_};
+  ++asyncBatches_;
+}
+
+void HgNativeBackingStore::endAsyncBatch() {
+  std::lock_guard<std::mutex> lock{asyncBatchesMutex_};
+  if (--asyncBatches_ == 0) {
+    asyncBatchesDone_.notify_all();
+  }
+}
+
 std::unique_ptr<folly::IOBuf> HgNativeBackingStore::getBlob(
     folly::ByteRange name,
     folly::ByteRange node,
@@ -274,6 +351,140 @@ void HgNativeBackingStore::getTreeBatch(
       });
 }
 
+void HgNativeBackingStore::getBlobBatchAsync(
+    const std::vector<std::pair<folly::ByteRange, folly::ByteRange>>& requests,
+    bool local,
+    std::function<void(size_t, std::unique_ptr<folly::IOBuf>)>&& resolve,
+    std::function<void()>&& done) {
+  size_t count = requests.size();
+
+  XLOG(DBG7) << "Import blobs asynchronously with size:" << count;
+
+  auto raw_requests = toRawRequests(requests);
+  auto batch = std::make_unique<AsyncBatch>();
+  batch->resolve = [resolve = std::move(resolve), count](
+                       size_t index, RustCFallibleBase raw_result) {
+    RustCFallible<RustCBytes> result(std::move(raw_result), rust_cbytes_free);
+
+    if (result.isError()) {
+      XLOGF(
+          DBG6,
+          "Failed to import blob from EdenAPI (async batch {}/{}): {}",
+          index,
+          count,
+          result.getError());
+    } else {
+      resolve(index, bytesToIOBuf(result.unwrap().release()));
+    }
+  };
+  batch->done = [this, done = std::move(done)] {
+    done();
+    endAsyncBatch();
+  };
+
+  beginAsyncBatch();
+  rust_backingstore_get_blob_batch_async(
+      store_.get(),
+      raw_requests.data(),
+      count,
+      local,
+      batch.release(),
+      asyncBatchResolve,
+      asyncBatchDone);
+}
+
+void HgNativeBackingStore::getTreeBatchAsync(
+    const std::vector<std::pair<folly::ByteRange, folly::ByteRange>>& requests,
+    bool local,
+    std::function<void(size_t, std::shared_ptr<RustTree>)>&& resolve,
+    std::function<void()>&& done) {
+  size_t count = requests.size();
+
+  XLOG(DBG7) << "Import batch of trees asynchronously with size:" << count;
+
+  auto raw_requests = toRawRequests(requests);
+  auto batch = std::make_unique<AsyncBatch>();
+  batch->resolve = [resolve = std::move(resolve), count](
+                       size_t index, RustCFallibleBase raw_result) {
+    RustCFallible<RustTree> result(std::move(raw_result), rust_tree_free);
+
+    if (result.isError()) {
+      XLOGF(
+          DBG6,
+          "Failed to import tree from EdenAPI (async batch {}/{}): {}",
+          index,
+          count,
+          result.getError());
+    } else {
+      resolve(index, result.unwrap());
+    }
+  };
+  batch->done = [this, done = std::move(done)] {
+    done();
+    endAsyncBatch();
+  };
+
+  beginAsyncBatch();
+  rust_backingstore_get_tree_batch_async(
+      store_.get(),
+      raw_requests.data(),
+      count,
+      local,
+      batch.release(),
+      asyncBatchResolve,
+      asyncBatchDone);
+}
+
+void HgNativeBackingStore::getBlobMetadataBatch(
+    const std::vector<std::pair<folly::ByteRange, folly::ByteRange>>& requests,
+    bool local,
+    std::function<void(size_t, std::shared_ptr<RustFileAuxData>)>&& resolve) {
+  size_t count = requests.size();
+
+  XLOG(DBG7) << "Import blob metadatas with size:" << count;
+
+  std::vector<RustRequest> raw_requests;
+  raw_requests.reserve(count);
+
+  for (auto& [name, node] : requests) {
+    raw_requests.emplace_back(RustRequest{
+        name.data(),
+        name.size(),
+        node.data(),
+    });
+  }
+
+  getFileAuxBatchCallback(
+      store_.get(),
+      raw_requests.data(),
+      count,
+      local,
+      [resolve, requests, count](size_t index, RustCFallibleBase raw_result) {
+        RustCFallible<RustFileAuxData> result(
+            std::move(raw_result), rust_file_aux_free);
+
+        if (result.isError()) {
+          XLOGF(
+              DBG6,
+              "Failed to import metadata path=\"{}\" node={} from EdenAPI (batch {}/{}): {}",
+              folly::StringPiece{requests[index].first},
+              folly::hexlify(requests[index].second),
+              index,
+              count,
+              result.getError());
+        } else {
+          XLOGF(
+              DBG6,
+              "Imported metadata path=\"{}\" node={} from EdenAPI (batch: {}/{})",
+              folly::StringPiece{requests[index].first},
+              folly::hexlify(requests[index].second),
+              index,
+              count);
+          resolve(index, result.unwrap());
+        }
+      });
+}
+
 std::shared_ptr<RustTree> HgNativeBackingStore::getTree(
     folly::ByteRange node,
     bool local) {
@@ -8,7 +8,10 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <condition_variable>
+#include <functional>
 #include <memory>
+#include <mutex>
 
 #include "eden/scm/lib/backingstore/c_api/RustBackingStore.h"
 
@@ -25,6 +28,11 @@ class HgNativeBackingStore {
       bool useEdenApi,
       bool useAuxData);
 
+  /**
+   * Waits for the asynchronous batches still being fetched.
+   */
+  ~HgNativeBackingStore();
+
   std::unique_ptr<folly::IOBuf>
   getBlob(folly::ByteRange name, folly::ByteRange node, bool local);
 
@@ -55,13 +63,54 @@ class HgNativeBackingStore {
       bool local,
       std::function<void(size_t, std::shared_ptr<RustTree>)>&& resolve);
 
+  /**
+   * Like getBlobBatch(), but returns right away, without waiting for the
+   * batch to be fetched. `resolve` is called from another thread as soon as
+   * each file is read, and `done` once every file was either read or failed
+   * to be. `requests` is only used until this returns.
+   */
+  void getBlobBatchAsync(
+      const std::vector<std::pair<folly::ByteRange, folly::ByteRange>>&
+          requests,
+      bool local,
+      std::function<void(size_t, std::unique_ptr<folly::IOBuf>)>&& resolve,
+      std::function<void()>&& done);
+
+  /**
+   * The tree counterpart of getBlobBatchAsync().
+   */
+  void getTreeBatchAsync(
+      const std::vector<std::pair<folly::ByteRange, folly::ByteRange>>&
+          requests,
+      bool local,
+      std::function<void(size_t, std::shared_ptr<RustTree>)>&& resolve,
+      std::function<void()>&& done);
+
+  /**
+   * Imports the aux data, which holds the size and SHA-1, of a list of files
+   * without their content. See getBlobBatch() for the parameters.
+   */
+  void getBlobMetadataBatch(
+      const std::vector<std::pair<folly::ByteRange, folly::ByteRange>>&
+          requests,
+      bool local,
+      std::function<void(size_t, std::shared_ptr<RustFileAuxData>)>&&
+          resolve);
+
   std::shared_ptr<RustTree> getTree(folly::ByteRange node, bool local);
 
   void flush();
 
  private:
+  void beginAsyncBatch();
+  void endAsyncBatch();
+
   std::unique_ptr<RustBackingStore, std::function<void(RustBackingStore*)>>
       store_;
+
+  std::mutex asyncBatchesMutex_;
+  std::condition_variable asyncBatchesDone_;
+  size_t asyncBatches_{0};
 };
 
 } // namespace facebook::eden
@@ -154,6 +154,17 @@ void rust_backingstore_get_blob_batch(RustBackingStore *store,
                                       void *data,
                                       void (*resolve)(void*, uintptr_t, RustCFallibleBase));
 
+/// Like `rust_backingstore_get_blob_batch`, but returns right away: `resolve` is called from
+/// another thread as the blobs are fetched, and `done` after the last call to `resolve`. The
+/// requests can be freed once this returns, but `store` and `data` must outlive the call to `done`.
+void rust_backingstore_get_blob_batch_async(RustBackingStore *store,
+                                            const RustRequest *requests,
+                                            uintptr_t size,
+                                            bool local,
+                                            void *data,
+                                            void (*resolve)(void*, uintptr_t, RustCFallibleBase),
+                                            void (*done)(void*));
+
 RustCFallibleBase rust_backingstore_get_tree(RustBackingStore *store,
                                                        const uint8_t *node,
                                                        uintptr_t node_len,
@@ -166,6 +177,15 @@ void rust_backingstore_get_tree_batch(RustBackingStore *store,
                                       void *data,
                                       void (*resolve)(void*, uintptr_t, RustCFallibleBase));
 
+/// The tree counterpart of `rust_backingstore_get_blob_batch_async`.
+void rust_backingstore_get_tree_batch_async(RustBackingStore *store,
+                                            const RustRequest *requests,
+                                            uintptr_t size,
+                                            bool local,
+                                            void *data,
+                                            void (*resolve)(void*, uintptr_t, RustCFallibleBase),
+                                            void (*done)(void*));
+
 RustCFallibleBase rust_backingstore_get_file_aux(RustBackingStore *store,
                                                                   const uint8_t *node,
                                                                   uintptr_t node_len,
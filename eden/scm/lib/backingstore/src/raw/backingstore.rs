@@ -9,6 +9,7 @@
 
 use std::slice;
 use std::str;
+use std::thread;
 
 use anyhow::ensure;
 use anyhow::Error;
@@ -64,6 +65,51 @@ pub extern "C" fn rust_backingstore_free(store: *mut BackingStore) {
     drop(store);
 }
 
+/// A pointer handed over to the thread fetching an asynchronous batch. The C++ caller keeps what
+/// it points to alive until the batch is done, and accepts callbacks from any thread.
+struct SendPtr<T>(*mut T);
+
+unsafe impl<T> Send for SendPtr<T> {}
+
+impl<T> SendPtr<T> {
+    fn get(&self) -> *mut T {
+        self.0
+    }
+}
+
+/// Run `fetch` on a new thread, with a function forwarding each of its results to `resolve`, then
+/// call `done`. If no thread can be started, all of the `size` requests fail right away.
+fn spawn_batch<T, F>(
+    size: usize,
+    data: *mut c_void,
+    resolve: unsafe extern "C" fn(*mut c_void, usize, CFallible<T>),
+    done: unsafe extern "C" fn(*mut c_void),
+    fetch: F,
+) where
+    T: 'static,
+    F: FnOnce(&dyn Fn(usize, CFallible<T>)) + Send + 'static,
+{
+    let sendable = SendPtr(data);
+    let spawned = thread::Builder::new()
+        .name("backingstore-batch".to_string())
+        .spawn(move || {
+            let data = sendable.get();
+            fetch(&|idx, result| unsafe { resolve(data, idx, result) });
+            unsafe { done(data) };
+        });
+
+    if let Err(err) = spawned {
+        for idx in 0..size {
+            let result: Result<*mut T> = Err(Error::msg(format!(
+                "cannot start a fetching thread: {}",
+                err
+            )));
+            unsafe { resolve(data, idx, result.into()) };
+        }
+        unsafe { done(data) };
+    }
+}
+
 fn backingstore_get_blob(
     store: *mut BackingStore,
     name: *const u8,
@@ -96,6 +142,23 @@ pub extern "C" fn rust_backingstore_get_blob(
     backingstore_get_blob(store, name, name_len, node, node_len, local).into()
 }
 
+fn backingstore_get_blob_batch<F>(
+    store: &BackingStore,
+    keys: Vec<Result<Key>>,
+    local: bool,
+    resolve: F,
+) where
+    F: Fn(usize, CFallible<CBytes>),
+{
+    store.get_blob_batch(keys, local, |idx, result| {
+        let result = result
+            .and_then(|opt| opt.ok_or_else(|| Error::msg("no blob found")))
+            .map(CBytes::from_vec)
+            .map(|result| Box::into_raw(Box::new(result)));
+        resolve(idx, result.into());
+    });
+}
+
 #[no_mangle]
 pub extern "C" fn rust_backingstore_get_blob_batch(
     store: *mut BackingStore,
@@ -110,14 +173,32 @@ pub extern "C" fn rust_backingstore_get_blob_batch(
     let requests: &[Request] = unsafe { slice::from_raw_parts(requests, size) };
     let keys: Vec<Result<Key>> = requests.iter().map(|req| req.try_into_key()).collect();
 
-    store.get_blob_batch(keys, local, |idx, result| {
-        let result = result
-            .and_then(|opt| opt.ok_or_else(|| Error::msg("no blob found")))
-            .map(CBytes::from_vec)
-            .map(|result| Box::into_raw(Box::new(result)));
-        unsafe {
-            resolve(data, idx, result.into())
-        };
+    backingstore_get_blob_batch(store, keys, local, |idx, result| unsafe {
+        resolve(data, idx, result)
+    });
+}
+
+/// Like `rust_backingstore_get_blob_batch`, but returns right away: `resolve` is called from
+/// another thread as the blobs are fetched, and `done` after the last call to `resolve`. The
+/// requests can be freed once this returns, but `store` and `data` must outlive the call to `done`.
+#[no_mangle]
+pub extern "C" fn rust_backingstore_get_blob_batch_async(
+    store: *mut BackingStore,
+    requests: *const Request,
+    size: usize,
+    local: bool,
+    data: *mut c_void,
+    resolve: unsafe extern "C" fn(*mut c_void, usize, CFallible<CBytes>),
+    done: unsafe extern "C" fn(*mut c_void),
+) {
+    assert!(!store.is_null());
+    let requests: &[Request] = unsafe { slice::from_raw_parts(requests, size) };
+    let keys: Vec<Result<Key>> = requests.iter().map(|req| req.try_into_key()).collect();
+    let sendable = SendPtr(store);
+
+    spawn_batch(size, data, resolve, done, move |resolve| {
+        let store = unsafe { &*sendable.get() };
+        backingstore_get_blob_batch(store, keys, local, resolve);
     });
 }
 
@@ -148,6 +229,23 @@ pub extern "C" fn rust_backingstore_get_tree(
     backingstore_get_tree(store, node, node_len, local).into()
 }
 
+fn backingstore_get_tree_batch<F>(
+    store: &BackingStore,
+    keys: Vec<Result<Key>>,
+    local: bool,
+    resolve: F,
+) where
+    F: Fn(usize, CFallible<Tree>),
+{
+    store.get_tree_batch(keys, local, |idx, result| {
+        let result: Result<List> =
+            result.and_then(|opt| opt.ok_or_else(|| Error::msg("no tree found")));
+        let result: Result<Tree> = result.and_then(|list| list.try_into());
+        let result: Result<*mut Tree> = result.map(|result| Box::into_raw(Box::new(result)));
+        resolve(idx, result.into());
+    });
+}
+
 #[no_mangle]
 pub extern "C" fn rust_backingstore_get_tree_batch(
     store: *mut BackingStore,
@@ -162,14 +260,30 @@ pub extern "C" fn rust_backingstore_get_tree_batch(
     let requests: &[Request] = unsafe { slice::from_raw_parts(requests, size) };
     let keys: Vec<Result<Key>> = requests.iter().map(|req| req.try_into_key()).collect();
 
-    store.get_tree_batch(keys, local, |idx, result| {
-        let result: Result<List> =
-            result.and_then(|opt| opt.ok_or_else(|| Error::msg("no tree found")));
-        let result: Result<Tree> = result.and_then(|list| list.try_into());
-        let result: Result<*mut Tree> = result.map(|result| Box::into_raw(Box::new(result)));
-        unsafe {
-            resolve(data, idx, result.into())
-        };
+    backingstore_get_tree_batch(store, keys, local, |idx, result| unsafe {
+        resolve(data, idx, result)
+    });
+}
+
+/// The tree counterpart of `rust_backingstore_get_blob_batch_async`.
+#[no_mangle]
+pub extern "C" fn rust_backingstore_get_tree_batch_async(
+    store: *mut BackingStore,
+    requests: *const Request,
+    size: usize,
+    local: bool,
+    data: *mut c_void,
+    resolve: unsafe extern "C" fn(*mut c_void, usize, CFallible<Tree>),
+    done: unsafe extern "C" fn(*mut c_void),
+) {
+    assert!(!store.is_null());
+    let requests: &[Request] = unsafe { slice::from_raw_parts(requests, size) };
+    let keys: Vec<Result<Key>> = requests.iter().map(|req| req.try_into_key()).collect();
+    let sendable = SendPtr(store);
+
+    spawn_batch(size, data, resolve, done, move |resolve| {
+        let store = unsafe { &*sendable.get() };
+        backingstore_get_tree_batch(store, keys, local, resolve);
     });
 }
 
@@ -156,6 +156,17 @@ static int xdl_classify_record(unsigned int pass, xdlclassifier_t *cf, xrecord_t
 }
 
 
+/* Number of '\n' in the 8 bytes of w. */
+static int64_t xdl_word_newlines(uint64_t w) {
+	uint64_t x = w ^ 0x0a0a0a0a0a0a0a0aULL;
+	/* high bit of each byte set when that byte of x is zero */
+	uint64_t z = ~(((x & 0x7f7f7f7f7f7f7f7fULL) + 0x7f7f7f7f7f7f7f7fULL) | x) &
+		0x8080808080808080ULL;
+
+	return (int64_t) (((z >> 7) * 0x0101010101010101ULL) >> 56);
+}
+
+
 /*
  * Trim common prefix from files.
  *
@@ -185,13 +196,32 @@ static void xdl_trim_files(mmfile_t *mf1, mmfile_t *mf2, int64_t reserved,
 		memcpy(&mlarge, mf1, sizeof(mmfile_t));
 	}
 
+	/* Compare 8 bytes at a time, then find the differing byte. */
 	pp1 = msmall.ptr, pp2 = mlarge.ptr;
-	for (i = 0; i < msmall.size && *pp1 == *pp2; ++i) {
+	for (i = 0; msmall.size - i >= 8; i += 8) {
+		uint64_t w1, w2;
+		memcpy(&w1, pp1, 8);
+		memcpy(&w2, pp2, 8);
+		if (w1 != w2)
+			break;
+		plines += xdl_word_newlines(w1);
+		pp1 += 8, pp2 += 8;
+	}
+	for (; i < msmall.size && *pp1 == *pp2; ++i) {
 		plines += (*pp1 == '\n');
 		pp1++, pp2++;
 	}
 
 	ps1 = msmall.ptr + msmall.size - 1, ps2 = mlarge.ptr + mlarge.size - 1;
+	while (ps1 - pp1 >= 8) {
+		uint64_t w1, w2;
+		memcpy(&w1, ps1 - 7, 8);
+		memcpy(&w2, ps2 - 7, 8);
+		if (w1 != w2)
+			break;
+		slines += xdl_word_newlines(w1);
+		ps1 -= 8, ps2 -= 8;
+	}
 	while (ps1 > pp1 && *ps1 == *ps2) {
 		slines += (*ps1 == '\n');
 		ps1--, ps2--;
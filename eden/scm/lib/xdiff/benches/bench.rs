@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+//! Diffs of large generated files, where xdiff's time goes to the preparation
+//! of the inputs: trimming their common prefix and suffix, then hashing and
+//! classifying every remaining line. Run it on two revisions to compare them.
+
+use minibench::bench;
+use minibench::elapsed;
+use xdiff::diff_hunks;
+
+/// A generated source file of `lines` lines of up to `max_len` bytes.
+fn generated(lines: usize, max_len: usize) -> Vec<String> {
+    // A fixed LCG, for the same input on every run.
+    let mut state: u64 = 42;
+    (0..lines)
+        .map(|i| {
+            state = state
+                .wrapping_mul(6364136223846793005)
+                .wrapping_add(1442695040888963407);
+            let pad = (state >> 33) as usize % max_len.max(1);
+            format!("    value_{} = compute({}, \"{}\")", i, i, "y".repeat(pad))
+        })
+        .collect()
+}
+
+fn text(lines: &[String]) -> Vec<u8> {
+    let mut text = lines.join("\n");
+    text.push('\n');
+    text.into_bytes()
+}
+
+/// Diff `lines` against a copy where one line in every `every` was changed.
+fn bench_changes(name: &str, lines: &[String], every: usize) {
+    let old = text(lines);
+    let new: Vec<String> = lines
+        .iter()
+        .enumerate()
+        .map(|(i, l)| {
+            if i % every == every / 2 {
+                format!("{} // changed", l)
+            } else {
+                l.clone()
+            }
+        })
+        .collect();
+    let new = text(&new);
+    bench(name, || {
+        elapsed(|| {
+            diff_hunks(&old, &new);
+        })
+    });
+}
+
+fn main() {
+    let short = generated(1_000_000, 80);
+    bench_changes("1M short lines, 1 change", &short, short.len());
+    bench_changes("1M short lines, 1 change every 50k", &short, 50_000);
+    bench_changes("1M short lines, 1 change every 10", &short, 10);
+
+    let long = generated(100_000, 2000);
+    bench_changes("100k long lines, 1 change", &long, long.len());
+    bench_changes("100k long lines, 1 change every 10", &long, 10);
+}
@@ -1458,13 +1458,15 @@ extmodules = [
         "edenscmnative.bdiff",
         ["edenscm/mercurial/bdiff.c", "edenscm/mercurial/cext/bdiff.c"],
         include_dirs=include_dirs,
-        depends=common_depends + ["edenscm/mercurial/bdiff.h"],
+        depends=common_depends
+        + ["edenscm/mercurial/bdiff.h", "edenscm/mercurial/cext/threadpool.h"],
     ),
     Extension(
         "edenscmnative.mpatch",
         ["edenscm/mercurial/mpatch.c", "edenscm/mercurial/cext/mpatch.c"],
         include_dirs=include_dirs,
-        depends=common_depends + ["edenscm/mercurial/mpatch.h"],
+        depends=common_depends
+        + ["edenscm/mercurial/mpatch.h", "edenscm/mercurial/cext/threadpool.h"],
     ),
     Extension(
         "edenscmnative.parsers",
@@ -180,6 +180,32 @@ class BdiffTests(unittest.TestCase):
             ["a\n", diffreplace(2, 10, "a\na\na\na\n", "")],
         )
 
+    def test_textdiffs(self):
+        pairs = [
+            ("a\nb\nc\n", "a\nc\n"),
+            ("", ""),
+            ("", "adjfkjdjksdhfksj"),
+            ("a\n" * 1000, "b\n" + "a\n" * 999 + "c\n"),
+        ] * 10
+        for threads in (1, 4):
+            diffs = mdiff.textdiffs(pairs, threads)
+            self.assertEqual([mdiff.textdiff(a, b) for a, b in pairs], diffs)
+            self.assertEqual(
+                [b for a, b in pairs],
+                mdiff.patchchains([(a, [d]) for (a, b), d in zip(pairs, diffs)]),
+            )
+        self.assertEqual([], mdiff.textdiffs([]))
+
+    def test_patchchains(self):
+        texts = ["a\n", "a\nb\n", "c\nb\n", "c\nb\nd\n"]
+        bins = [mdiff.textdiff(a, b) for a, b in zip(texts, texts[1:])]
+        self.assertEqual(
+            ["c\nb\nd\n", "c\nb\n", "a\n"],
+            mdiff.patchchains([("a\n", bins), ("a\n", bins[:2]), ("a\n", [])], 2),
+        )
+        with self.assertRaises(mdiff.mpatch.mpatchError):
+            mdiff.patchchains([("a\n", bins), ("a\n", ["\0\0"])])
+
 
 if __name__ == "__main__":
     import silenttestrunner
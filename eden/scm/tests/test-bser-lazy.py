@@ -0,0 +1,98 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+#
+# This software may be used and distributed according to the terms of the
+# GNU General Public License version 2.
+
+from __future__ import absolute_import
+
+import random
+import struct
+import unittest
+
+import silenttestrunner
+from edenscmnative import bser
+
+
+def plain(value):
+    if type(value).__name__ == "bserobj_tuple":
+        return ("obj", tuple(plain(value[i]) for i in range(len(value))))
+    if isinstance(value, (list, tuple)) or type(value).__name__ == "bserarray":
+        return ("arr", tuple(plain(v) for v in value))
+    return value
+
+
+def randomvalue(rnd, depth=0):
+    kind = rnd.randrange(8 if depth < 4 else 5)
+    if kind == 0:
+        return rnd.randrange(-(2 ** 40), 2 ** 40)
+    if kind == 1:
+        return rnd.random()
+    if kind == 2:
+        return rnd.choice([True, False, None])
+    if kind == 3:
+        return bytes(bytearray(rnd.randrange(256) for _ in range(rnd.randrange(8))))
+    if kind == 4:
+        return u"u%d\xe9" % rnd.randrange(100)
+    if kind in (5, 6):
+        return [randomvalue(rnd, depth + 1) for _ in range(rnd.randrange(6))]
+    return {"k%d" % i: randomvalue(rnd, depth + 1) for i in range(rnd.randrange(5))}
+
+
+def string(s):
+    return b"\x02\x03" + struct.pack("b", len(s)) + s
+
+
+def int8(i):
+    return b"\x03" + struct.pack("b", i)
+
+
+class testlazy(unittest.TestCase):
+    def testSameAsEager(self):
+        rnd = random.Random(0)
+        for _ in range(500):
+            data = bser.dumps(randomvalue(rnd), version=2)
+            eager = bser.loads(data, False)
+            lazy = bser.loads(data, False, lazy=True)
+            self.assertEqual(plain(eager), plain(lazy))
+
+    def testAccess(self):
+        data = bser.dumps(
+            {"clock": "c:1", "files": [{"name": b"a", "size": 3}, {"name": b"b"}]}
+        )
+        res = bser.loads(data, False, value_encoding="utf-8", lazy=True)
+        del data
+        self.assertEqual(res.clock, "c:1")
+        self.assertEqual(res["clock"], "c:1")
+        files = res.files
+        self.assertEqual(len(files), 2)
+        self.assertEqual(files[0].st_size, 3)
+        self.assertEqual(files[-1].name, "b")
+        self.assertEqual([f.name for f in files[::-1]], ["b", "a"])
+        self.assertRaises(IndexError, lambda: files[2])
+        self.assertRaises(AttributeError, lambda: files[1].size)
+
+    def testTemplate(self):
+        body = b"\x0b\x00\x03\x02" + string(b"name") + string(b"size")
+        body += b"\x03\x02" + string(b"a") + int8(1) + b"\x0c" + int8(2)
+        data = b"\x00\x01\x05" + struct.pack("<i", len(body)) + body
+        rows = bser.loads(data, False, lazy=True)
+        self.assertEqual(len(rows), 2)
+        self.assertEqual((rows[0].name, rows[0].size), (b"a", 1))
+        self.assertEqual((rows[1].name, rows[1].size), (None, 2))
+
+    def testCorrupt(self):
+        rnd = random.Random(0)
+        for _ in range(2000):
+            data = bytearray(bser.dumps(randomvalue(rnd)))
+            data[rnd.randrange(7, len(data))] = rnd.randrange(256)
+            try:
+                plain(bser.loads(bytes(data), False, lazy=True))
+            except (ValueError, IndexError, MemoryError, UnicodeDecodeError):
+                pass
+
+    def testMutable(self):
+        self.assertRaises(ValueError, bser.loads, bser.dumps([1]), lazy=True)
+
+
+if __name__ == "__main__":
+    silenttestrunner.main(__name__)
@@ -0,0 +1,79 @@
+#!/usr/bin/env python
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+#
+# This software may be used and distributed according to the terms of the
+# GNU General Public License version 2.
+
+from __future__ import absolute_import
+
+import os
+import shutil
+import tempfile
+import unittest
+
+import silenttestrunner
+from edenscmnative import linelog
+
+
+def populate(log, revs):
+    for rev in range(1, revs + 1):
+        n = len(log.annotateresult)
+        # replace a line in the middle, and append some
+        log.replacelines(rev, n // 2, min(n, n // 2 + 1), 0, 3)
+
+
+class testfork(unittest.TestCase):
+    def setUp(self):
+        self.tmpdir = tempfile.mkdtemp()
+        self.path = os.path.join(self.tmpdir, "linelog").encode()
+
+    def tearDown(self):
+        shutil.rmtree(self.tmpdir)
+
+    def testForkDoesNotWriteBack(self):
+        log = linelog.linelog(self.path)
+        log.annotate(0)
+        populate(log, 500)
+        expected = log.annotateresult
+        log.flush()
+        size = os.path.getsize(self.path)
+
+        fork = log.fork()
+        fork.annotate(fork.maxrev)
+        self.assertEqual(fork.annotateresult, expected)
+        # enough to grow past the room reserved after the file
+        populate(fork, 2000)
+        self.assertEqual(fork.maxrev, 2500)
+        fork.annotate(500)
+        self.assertEqual(fork.annotateresult, expected)
+
+        log.annotate(log.maxrev)
+        self.assertEqual(log.maxrev, 500)
+        self.assertEqual(log.annotateresult, expected)
+        self.assertEqual(os.path.getsize(self.path), size)
+        fork.close()
+        log.close()
+
+    def testForkMatchesCopy(self):
+        log = linelog.linelog(self.path)
+        log.annotate(0)
+        populate(log, 50)
+        copy = linelog.linelog()
+        copy.copyfrom(log)
+        fork = log.fork()
+        for l in (copy, fork):
+            l.annotate(l.maxrev)
+            populate(l, 10)
+        self.assertEqual(fork.annotateresult, copy.annotateresult)
+        self.assertEqual(fork.getalllines(), copy.getalllines())
+
+    def testForkInMemory(self):
+        log = linelog.linelog()
+        populate(log, 10)
+        fork = log.fork()
+        fork.annotate(fork.maxrev)
+        self.assertEqual(fork.annotateresult, log.annotateresult)
+
+
+if __name__ == "__main__":
+    silenttestrunner.main(__name__)
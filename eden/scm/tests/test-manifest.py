@@ -420,11 +420,92 @@ class basemanifesttests(object):
 
         self.assertEqual(["a/b/c/bar.txt", "a/b/c/foo.txt", "a/b/d/ten.txt"], m2.keys())
 
+    def testMatchesNestedDirectories(self):
+        """Tests matches() on relpath matches on a directory, one of its
+        subdirectories, a file and a directory sharing a prefix with it."""
+        m = self.parsemanifest(A_DEEPER_MANIFEST)
+
+        match = matchmod.match(
+            "/", "", ["a/b/d", "a/b", "app.py", "a/c/l"], default="relpath"
+        )
+        m2 = m.matches(match)
+
+        self.assertEqual(
+            [
+                "a/b/c/bar.py",
+                "a/b/c/bar.txt",
+                "a/b/c/foo.py",
+                "a/b/c/foo.txt",
+                "a/b/d/baz.py",
+                "a/b/d/qux.py",
+                "a/b/d/ten.txt",
+                "a/b/dog.py",
+                "a/b/fish.py",
+                "app.py",
+            ],
+            m2.keys(),
+        )
+        self.assertEqual(m2.keys(), list(m.walk(match)))
+
+    def testHasDir(self):
+        m = self.parsemanifest(A_DEEPER_MANIFEST)
+        self.assertTrue(m.hasdir(""))
+        self.assertTrue(m.hasdir("a"))
+        self.assertTrue(m.hasdir("a/b/c"))
+        self.assertFalse(m.hasdir("a/b/c/bar.py"))
+        self.assertFalse(m.hasdir("a/b/c/bar"))
+        self.assertFalse(m.hasdir("ap"))
+        del m["a/c/london.py"]
+        del m["a/c/paper.txt"]
+        self.assertTrue(m.hasdir("a/c"))
+        del m["a/c/paris.py"]
+        self.assertFalse(m.hasdir("a/c"))
+        self.assertFalse(self.parsemanifest(EMTPY_MANIFEST).hasdir(""))
+
 
 class testmanifestdict(unittest.TestCase, basemanifesttests):
     def parsemanifest(self, text):
         return manifestmod.manifestdict(text)
 
+    def testIterDirectory(self):
+        m = self.parsemanifest(A_DEEPER_MANIFEST)
+        self.assertEqual(
+            ["a/b/d/baz.py", "a/b/d/qux.py", "a/b/d/ten.txt"],
+            list(m._lm.iterkeys("a/b/d")),
+        )
+        self.assertEqual(
+            [("a/d/apple.py", BIN_HASH_3, ""), ("a/d/pizza.py", BIN_HASH_3, "l")],
+            list(m._lm.iterentries("a/d")),
+        )
+        self.assertEqual([], list(m._lm.keys("a/b/d/baz.py")))
+        self.assertEqual(m.keys(), list(m._lm.keys("")))
+
+    def testSetItems(self):
+        m = self.parsemanifest(A_DEEPER_MANIFEST)
+        expected = m.copy()
+        items = [
+            ("zzz/new.py", (BIN_HASH_1, "")),
+            ("a/b/dog.py", (BIN_HASH_1, "x")),
+            ("a/b/e/new.py", (BIN_HASH_2, "l")),
+            ("a/b/e/new.py", (BIN_HASH_1, "")),
+            ("0.py", (BIN_HASH_2 + b"+", "")),
+        ]
+        for f, (n, fl) in items:
+            expected._lm[f] = n, fl
+        m._lm.setitems(items)
+        self.assertEqual(expected.text(), m.text())
+        self.assertEqual(BIN_HASH_2 + b"+", m["0.py"])
+        self.assertEqual({}, m.diff(expected))
+
+    def testSetItemsError(self):
+        m = self.parsemanifest(EMTPY_MANIFEST)
+        with self.assertRaises(TypeError):
+            m._lm.setitems(
+                [("b", (BIN_HASH_1, "")), ("c", BIN_HASH_1), ("a", (BIN_HASH_1, ""))]
+            )
+        # what came before the error was set
+        self.assertEqual(["b"], m.keys())
+
 
 if __name__ == "__main__":
     silenttestrunner.main(__name__)
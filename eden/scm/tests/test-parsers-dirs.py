@@ -0,0 +1,75 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+#
+# This software may be used and distributed according to the terms of the
+# GNU General Public License version 2.
+
+from __future__ import absolute_import
+
+import random
+import unittest
+
+import silenttestrunner
+from edenscm.mercurial import util
+from edenscmnative import parsers
+
+
+def randompath(rnd):
+    parts = [rnd.choice([b"a", b"b", b"cc", b"ddd"]) for _ in range(rnd.randint(0, 5))]
+    return b"/".join(parts + [b"f%d" % rnd.randrange(20)])
+
+
+def nonroot(dirs):
+    # the C implementation keeps the root once added
+    return set(dirs) - {b""}
+
+
+class testdirs(unittest.TestCase):
+    def testAddDel(self):
+        rnd = random.Random(0)
+        c = parsers.dirs()
+        p = util.puredirs([])
+        live = set()
+        for _ in range(2000):
+            if live and rnd.random() < 0.4:
+                path = rnd.choice(sorted(live))
+                live.discard(path)
+                c.delpath(path)
+                p.delpath(path)
+            else:
+                path = randompath(rnd)
+                if path in live:
+                    continue
+                live.add(path)
+                c.addpath(path)
+                p.addpath(path)
+            self.assertEqual(nonroot(c), nonroot(p))
+        for d in p:
+            self.assertIn(d, c)
+        self.assertNotIn(b"zzz", c)
+
+    def testRoot(self):
+        c = parsers.dirs([b"a/b"])
+        self.assertEqual(set(c), {b"", b"a"})
+        c.delpath(b"a/b")
+        self.assertEqual(set(c), {b""})
+        self.assertRaises(ValueError, c.delpath, b"x/y")
+
+    def testFromManifestText(self):
+        files = [b"a/b/c", b"a/d", b"e", b"f/g/h/i"]
+        text = b"".join(b"%s\0%s\n" % (f, b"1" * 40) for f in files)
+        self.assertEqual(set(parsers.dirs(text)), set(parsers.dirs(files)))
+        self.assertRaises(ValueError, parsers.dirs, b"a/b\0" + b"1" * 40)
+        self.assertRaises(ValueError, parsers.dirs, b"a/b\n")
+
+    def testFromDict(self):
+        dmap = {
+            b"a/b": parsers.dirstatetuple("n", 0, 0, 0),
+            b"c/d": parsers.dirstatetuple("r", 0, 0, 0),
+        }
+        self.assertEqual(set(parsers.dirs(dmap)), {b"", b"a", b"c"})
+        self.assertEqual(set(parsers.dirs(dmap, b"r")), {b"", b"a"})
+        self.assertRaises(TypeError, parsers.dirs, [u"a/b"])
+
+
+if __name__ == "__main__":
+    silenttestrunner.main(__name__)
@@ -0,0 +1,46 @@
+#chg-compatible
+
+  $ setconfig experimental.persistent-nodetree=true
+
+  $ hg init repo
+  $ cd repo
+  $ echo a > a
+  $ hg commit -qAm a
+  $ echo b > b
+  $ hg commit -qAm b
+
+The manifest node trie is saved once a transaction adds revisions:
+
+  $ ls .hg/store | grep nodetree
+  00manifest.nodetree
+  00manifest.nodetree-* (glob)
+  $ hg manifest -r 0
+  a
+  $ hg manifest -r 1
+  a
+  b
+
+Stripping replaces it, since revision numbers changed:
+
+  $ hg debugstrip -r 1 -q
+  $ ls .hg/store | grep nodetree
+  00manifest.nodetree
+  00manifest.nodetree-* (glob)
+  $ hg manifest -r 0
+  a
+  $ echo c > c
+  $ hg commit -qAm c
+  $ hg manifest -r 1
+  a
+  c
+
+An older trie is still used for the revisions it maps:
+
+  $ cp .hg/store/00manifest.nodetree nodetree
+  $ echo d > d
+  $ hg commit -qAm d
+  $ cp nodetree .hg/store/00manifest.nodetree
+  $ hg manifest -r 2
+  a
+  c
+  d